@@ -592,6 +592,10 @@ TFE_Executor* TFE_NewExecutor(bool is_async) {
   return new TFE_Executor(is_async);
 }
 
+TFE_Executor* TFE_NewPerDeviceExecutor() {
+  return new TFE_Executor(/*async=*/true, /*per_device_streams=*/true);
+}
+
 void TFE_DeleteExecutor(TFE_Executor* executor) { delete executor; }
 
 bool TFE_ExecutorIsAsync(TFE_Executor* executor) {
@@ -369,6 +369,12 @@ typedef struct TFE_Executor TFE_Executor;
 // nodes in parallel.
 TF_CAPI_EXPORT extern TFE_Executor* TFE_NewExecutor(bool is_async);
 
+// Creates a new async eager Executor that executes the nodes of each device in
+// sequence on a thread of its own, so that nodes on different devices (e.g.
+// host preprocessing ops and copies to an accelerator) execute in parallel. A
+// node waits for its inputs produced on other devices to be ready.
+TF_CAPI_EXPORT extern TFE_Executor* TFE_NewPerDeviceExecutor();
+
 // Deletes the eager Executor without waiting for enqueued nodes. Please call
 // TFE_ExecutorWaitForAllPendingNodes before calling this API if you want to
 // make sure all nodes are finished.
@@ -295,6 +295,53 @@ TEST(CAPI, CancellationManager) {
   TFE_DeleteCancellationManager(c_mgr);
 }
 
+TEST(CAPI, PerDeviceExecutor) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_Executor* old_executor = TFE_ContextGetExecutorForThread(ctx);
+  TFE_Executor* executor = TFE_NewPerDeviceExecutor();
+  EXPECT_TRUE(TFE_ExecutorIsAsync(executor));
+  TFE_ContextSetExecutorForThread(ctx, executor);
+
+  // A chain of ops, each of which consumes the output of the previous one.
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  std::vector<TFE_TensorHandle*> handles = {m};
+  for (int i = 0; i < 3; ++i) {
+    TFE_Op* matmul = MatMulOp(ctx, handles.back(), m);
+    TFE_TensorHandle* retval = nullptr;
+    int num_retvals = 1;
+    TFE_Execute(matmul, &retval, &num_retvals, status);
+    TFE_DeleteOp(matmul);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    handles.push_back(retval);
+  }
+
+  TF_Tensor* t = TFE_TensorHandleResolve(handles.back(), status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  float data[4] = {0};
+  memcpy(&data[0], TF_TensorData(t), TF_TensorByteSize(t));
+  TF_DeleteTensor(t);
+  EXPECT_EQ(199, data[0]);
+  EXPECT_EQ(290, data[1]);
+  EXPECT_EQ(435, data[2]);
+  EXPECT_EQ(634, data[3]);
+
+  TFE_ContextSetExecutorForThread(ctx, old_executor);
+  TFE_ExecutorWaitForAllPendingNodes(executor, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteExecutor(executor);
+  TFE_DeleteExecutor(old_executor);
+  for (TFE_TensorHandle* h : handles) {
+    TFE_DeleteTensorHandle(h);
+  }
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 TEST(CAPI, Function_ident_CPU) {
   // First create a simple identity function.
   TF_Graph* function_graph = TF_NewGraph();
@@ -310,8 +310,9 @@ struct TFE_CancellationManager {
 };
 
 struct TFE_Executor {
-  explicit TFE_Executor(bool async)
-      : owned_executor(new tensorflow::EagerExecutor(async)) {}
+  explicit TFE_Executor(bool async, bool per_device_streams = false)
+      : owned_executor(
+            new tensorflow::EagerExecutor(async, per_device_streams)) {}
 
   explicit TFE_Executor(tensorflow::EagerExecutor* executor)
       : owned_executor(nullptr), unowned_executor(executor) {}
@@ -65,6 +65,17 @@ uint64 GetLatencyMicroseconds(const uint64 start_microseconds) {
   return end_microseconds - start_microseconds;
 }
 
+// Marks the restore ops of "graph_def" to restore the variables memory-mapped,
+// so that the variables are only read from the checkpoint on first access.
+void MarkRestoreOpsToMemoryMap(GraphDef* graph_def) {
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (node.op() == "RestoreV2") {
+      // Read by the RestoreV2 kernel.
+      (*node.mutable_attr())["_memory_map"].set_b(true);
+    }
+  }
+}
+
 Status LoadMetaGraphIntoSession(const MetaGraphDef& meta_graph_def,
                                 const SessionOptions& session_options,
                                 std::unique_ptr<Session>* session) {
@@ -286,6 +297,9 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  if (session_options.config.experimental().lazy_load_variables()) {
+    MarkRestoreOpsToMemoryMap(bundle->meta_graph_def.mutable_graph_def());
+  }
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
 
@@ -91,6 +91,16 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile always refuses to compile the cluster, which means the
   // XLA clusters always run in the TF executor.  Defaults to false.
   bool tf_xla_always_defer_compilation;
+
+  // If not empty, the results of compiling clusters are also stored in this
+  // directory, and compilations in later processes load them from there
+  // instead of compiling the cluster again.
+  string tf_xla_persistent_cache_directory;
+
+  // If positive, _XlaCompile compiles clusters asynchronously on a pool of
+  // this many threads, and the clusters run in the TF executor until their
+  // compilation finishes.  Defaults to 0, i.e. compiling on the calling thread.
+  int32 tf_xla_async_compilation_threads;
 };
 
 // Flags for the build_xla_ops pass.
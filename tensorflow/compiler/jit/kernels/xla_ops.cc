@@ -338,10 +338,16 @@ static Status CompileToLocalExecutable(
   std::vector<XlaCompiler::Argument> args;
   TF_RETURN_IF_ERROR(XlaComputationLaunchContext::BuildXlaCompilerArguments(
       constant_args, *variables, ctx, &args));
+  XlaCompilationCache::CompileMode compile_mode =
+      XlaCompilationCache::CompileMode::kStrict;
+  if (lazy) {
+    compile_mode =
+        GetXlaOpsCommonFlags().tf_xla_async_compilation_threads > 0
+            ? XlaCompilationCache::CompileMode::kAsync
+            : XlaCompilationCache::CompileMode::kLazy;
+  }
   return cache->Compile(options, function, args, compile_options,
-                        lazy ? XlaCompilationCache::CompileMode::kLazy
-                             : XlaCompilationCache::CompileMode::kStrict,
-                        kernel, executable);
+                        compile_mode, kernel, executable);
 }
 
 void XlaLocalLaunchBase::Compute(OpKernelContext* ctx) {
@@ -20,8 +20,10 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/xla_activity.pb.h"
 #include "tensorflow/compiler/jit/xla_activity_listener.h"
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
@@ -36,7 +38,12 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
@@ -50,6 +57,13 @@ XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
     : client_(client), device_type_(std::move(device_type)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
+  // Wait for any background compilations, which refer to the cache entries.
+  std::unique_ptr<thread::ThreadPool> async_compile_pool;
+  {
+    mutex_lock lock(compile_cache_mu_);
+    async_compile_pool = std::move(async_compile_pool_);
+  }
+  async_compile_pool.reset();
   // Ensure any use of our programs have completed by waiting for all stream
   // executors to complete.
   for (auto* executor : client_->backend().stream_executors()) {
@@ -118,6 +132,178 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
   return h;
 }
 
+namespace {
+
+void CompilationResultToProto(const XlaCompiler::CompilationResult& result,
+                              XlaCompilationResultProto* proto) {
+  for (int index : result.input_mapping) {
+    proto->add_input_mapping(index);
+  }
+  for (const xla::Shape& shape : result.xla_input_shapes) {
+    *proto->add_xla_input_shapes() = shape.ToProto();
+  }
+  *proto->mutable_xla_output_shape() = result.xla_output_shape.ToProto();
+  for (const XlaCompiler::OutputDescription& output : result.outputs) {
+    auto* output_proto = proto->add_outputs();
+    output_proto->set_type(output.type);
+    output.shape.AsProto(output_proto->mutable_shape());
+    output_proto->set_is_constant(output.is_constant);
+    if (output.is_constant) {
+      output.constant_value.AsProtoTensorContent(
+          output_proto->mutable_constant_value());
+    }
+    output_proto->set_input_index(output.input_index);
+    output_proto->set_is_tensor_list(output.is_tensor_list);
+  }
+  *proto->mutable_host_compute_metadata() = result.host_compute_metadata;
+  for (const XlaCompiler::ResourceUpdate& update : result.resource_updates) {
+    auto* update_proto = proto->add_resource_updates();
+    update_proto->set_input_index(update.input_index);
+    update_proto->set_type(update.type);
+    update.shape.AsProto(update_proto->mutable_shape());
+    update_proto->set_modified(update.modified);
+    for (const string& gradient : update.tensor_array_gradients_accessed) {
+      update_proto->add_tensor_array_gradients_accessed(gradient);
+    }
+  }
+  if (result.computation != nullptr) {
+    *proto->mutable_computation() = result.computation->proto();
+  }
+}
+
+Status CompilationResultFromProto(const XlaCompilationResultProto& proto,
+                                  XlaCompiler::CompilationResult* result) {
+  result->input_mapping.assign(proto.input_mapping().begin(),
+                               proto.input_mapping().end());
+  for (const xla::ShapeProto& shape : proto.xla_input_shapes()) {
+    result->xla_input_shapes.emplace_back(shape);
+  }
+  result->xla_output_shape = xla::Shape(proto.xla_output_shape());
+  for (const auto& output_proto : proto.outputs()) {
+    XlaCompiler::OutputDescription output;
+    output.type = output_proto.type();
+    output.shape = TensorShape(output_proto.shape());
+    output.is_constant = output_proto.is_constant();
+    if (output.is_constant &&
+        !output.constant_value.FromProto(output_proto.constant_value())) {
+      return errors::DataLoss("Invalid constant output value");
+    }
+    output.input_index = output_proto.input_index();
+    output.is_tensor_list = output_proto.is_tensor_list();
+    result->outputs.push_back(std::move(output));
+  }
+  result->host_compute_metadata = proto.host_compute_metadata();
+  for (const auto& update_proto : proto.resource_updates()) {
+    XlaCompiler::ResourceUpdate update;
+    update.input_index = update_proto.input_index();
+    update.type = update_proto.type();
+    update.shape = TensorShape(update_proto.shape());
+    update.modified = update_proto.modified();
+    update.tensor_array_gradients_accessed.insert(
+        update_proto.tensor_array_gradients_accessed().begin(),
+        update_proto.tensor_array_gradients_accessed().end());
+    result->resource_updates.push_back(std::move(update));
+  }
+  result->computation =
+      std::make_shared<xla::XlaComputation>(proto.computation());
+  return Status::OK();
+}
+
+// Loads the compilation result persisted at `path` into `result`. Returns
+// false if there is no usable entry, leaving `result` empty.
+bool LoadCompilationResult(const string& path,
+                           XlaCompiler::CompilationResult* result) {
+  Env* env = Env::Default();
+  if (!env->FileExists(path).ok()) {
+    return false;
+  }
+  XlaCompilationResultProto proto;
+  Status s = ReadBinaryProto(env, path, &proto);
+  if (s.ok()) {
+    s = CompilationResultFromProto(proto, result);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Ignoring XLA compilation cache entry " << path << ": "
+                 << s.ToString();
+    *result = XlaCompiler::CompilationResult();
+    return false;
+  }
+  return true;
+}
+
+// Persists `result` at `path`. Failures are logged and otherwise ignored.
+void StoreCompilationResult(const string& path,
+                            const XlaCompiler::CompilationResult& result) {
+  Env* env = Env::Default();
+  XlaCompilationResultProto proto;
+  CompilationResultToProto(result, &proto);
+  // Write to a temporary file first, so that other processes never read a
+  // partial entry.
+  const string tmp_path = absl::StrCat(path, ".tmp", random::New64());
+  Status s = env->RecursivelyCreateDir(string(io::Dirname(path)));
+  if (s.ok()) {
+    s = WriteBinaryProto(env, tmp_path, proto);
+  }
+  if (s.ok()) {
+    s = env->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write XLA compilation cache entry " << path
+                 << ": " << s.ToString();
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
+
+}  // namespace
+
+string XlaCompilationCache::PersistentCachePath(
+    const string& cache_dir, const XlaCompiler::Options& options,
+    const NameAttrList& function,
+    absl::Span<const XlaCompiler::Argument> args,
+    const XlaCompiler::CompileOptions& compile_options) const {
+  // Cluster names are only unique within a graph, so the key covers the
+  // bodies of the function and of every function it calls.
+  string key = absl::StrCat(
+      Canonicalize(function.name(), AttrSlice(&function.attr())),
+      ";device_type=", device_type_.type_string(),
+      ";platform=", client_->platform()->Name(), ";version=", tf_git_version(),
+      ";use_tuple_arg=", compile_options.use_tuple_arg,
+      ";return_updated_values_for_all_resources=",
+      compile_options.return_updated_values_for_all_resources,
+      ";resolve_compile_time_constants=",
+      compile_options.resolve_compile_time_constants,
+      ";always_return_tuple=", compile_options.always_return_tuple,
+      ";is_entry_computation=", compile_options.is_entry_computation,
+      ";add_token_input_output=", compile_options.add_token_input_output,
+      ";alias_passthrough_params=", options.alias_passthrough_params);
+  const FunctionDef* fdef = options.flib_def->Find(function.name());
+  if (fdef != nullptr) {
+    std::vector<string> names =
+        options.flib_def->ReachableDefinitions(*fdef).ListFunctionNames();
+    names.push_back(function.name());
+    std::sort(names.begin(), names.end());
+    for (const string& name : names) {
+      string serialized;
+      SerializeToStringDeterministic(*options.flib_def->Find(name),
+                                     &serialized);
+      absl::StrAppend(&key, ";", name, "=", Fingerprint64(serialized));
+    }
+  }
+  for (const XlaCompiler::Argument& arg : args) {
+    absl::StrAppend(&key, ";", arg.HumanString());
+    if (arg.kind == XlaCompiler::Argument::kConstant) {
+      absl::StrAppend(&key, "=",
+                      Fingerprint64(arg.constant_value.tensor_data()));
+    }
+  }
+  const Fprint128 fingerprint = Fingerprint128(key);
+  return io::JoinPath(
+      cache_dir,
+      strings::StrCat(strings::Hex(fingerprint.high64, strings::kZeroPad16),
+                      strings::Hex(fingerprint.low64, strings::kZeroPad16),
+                      ".pb"));
+}
+
 xla::StatusOr<XlaCompilationCache::Signature>
 XlaCompilationCache::BuildSignature(
     const NameAttrList& function,
@@ -192,16 +378,224 @@ Status XlaCompilationCache::Compile(
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   absl::optional<int64> compile_threshold;
-  if (compile_mode == CompileMode::kLazy) {
+  if (compile_mode != CompileMode::kStrict) {
     compile_threshold = kDefaultCompilationThreshold;
   }
+  if (compile_mode == CompileMode::kAsync) {
+    return CompileAsync(options, function, args, compile_options,
+                        compile_threshold, out_compilation_result,
+                        out_executable);
+  }
   auto compile_fn = [&](XlaCompiler* compiler,
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
+  std::function<string()> persistent_cache_path_fn;
+  const string& cache_dir =
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_directory;
+  if (!cache_dir.empty() && options.flib_def != nullptr) {
+    persistent_cache_path_fn = [&]() {
+      return PersistentCachePath(cache_dir, options, function, args,
+                                 compile_options);
+    };
+  }
   return CompileImpl(options, function, args, compile_fn,
+                     persistent_cache_path_fn,
                      /*compile_threshold=*/compile_threshold,
-                     out_compilation_result, out_executable);
+                     /*async=*/false, out_compilation_result, out_executable);
+}
+
+Status XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    absl::Span<const XlaCompiler::Argument> args,
+    const XlaCompiler::CompileOptions& compile_options,
+    absl::optional<int64> compile_threshold,
+    const XlaCompiler::CompilationResult** out_compilation_result,
+    xla::LocalExecutable** out_executable) {
+  // The compilation may outlive the caller, so it works on copies of
+  // everything the caller owns. Copying the function library is cheap, since
+  // the copy shares the function definitions.
+  TF_RET_CHECK(options.flib_def != nullptr);
+  auto flib_def = std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  XlaCompiler::Options async_options = options;
+  async_options.flib_def = flib_def.get();
+  // The caller's allocator may not outlive the call, so the compiler uses the
+  // backend's allocator instead.
+  async_options.device_allocator = nullptr;
+  async_options.populate_resource_manager = nullptr;
+  auto async_args = std::make_shared<std::vector<XlaCompiler::Argument>>(
+      args.begin(), args.end());
+  auto compile_fn = [flib_def, function, async_args, compile_options](
+                        XlaCompiler* compiler,
+                        XlaCompiler::CompilationResult* result) {
+    return compiler->CompileFunction(compile_options, function, *async_args,
+                                     result);
+  };
+  std::function<string()> persistent_cache_path_fn;
+  const string& cache_dir =
+      GetXlaOpsCommonFlags().tf_xla_persistent_cache_directory;
+  if (!cache_dir.empty()) {
+    persistent_cache_path_fn = [this, cache_dir, async_options, function,
+                                async_args, compile_options, flib_def]() {
+      return PersistentCachePath(cache_dir, async_options, function,
+                                 *async_args, compile_options);
+    };
+  }
+  return CompileImpl(async_options, function, *async_args, compile_fn,
+                     persistent_cache_path_fn, compile_threshold,
+                     /*async=*/true, out_compilation_result, out_executable);
+}
+
+namespace {
+// Print something that users can search for to definitively ascertain that XLA
+// was used for their TF model.
+//
+// Prints only once to avoid spamming LOG(INFO).
+void LogOnceXlaCompiledFirstCluster() {
+  static absl::once_flag log_once;
+  absl::call_once(log_once, [] {
+    LOG(INFO) << "Compiled cluster using XLA!  This line is logged at most "
+                 "once for the lifetime of the process.";
+  });
+}
+
+// Returns true if a cluster that has been compiled `compile_count` times should
+// be reported as being recompiled excessively. Reports are made at powers of
+// ten, so a recompilation storm is visible without flooding the log.
+bool IsRecompilationWarningCount(int64 compile_count) {
+  constexpr int64 kFirstWarningCount = 10;
+  if (compile_count < kFirstWarningCount) {
+    return false;
+  }
+  while (compile_count % 10 == 0) {
+    compile_count /= 10;
+  }
+  return compile_count == 1;
+}
+}  // namespace
+
+Status XlaCompilationCache::CompileAndBuildExecutable(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    absl::Span<const XlaCompiler::Argument> args,
+    const std::function<Status(XlaCompiler* compiler,
+                               XlaCompiler::CompilationResult*)>& compile_fn,
+    const std::function<string()>& persistent_cache_path_fn,
+    XlaCompiler::CompilationResult* compilation_result,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const uint64 compile_start_us = env->NowMicros();
+
+  XlaCompiler compiler(options);
+
+  unsigned num_parameter_args = 0;
+  for (const XlaCompiler::Argument& arg : args) {
+    if (arg.kind == XlaCompiler::Argument::kParameter) {
+      num_parameter_args++;
+    }
+  }
+
+  unsigned num_variable_args = 0;
+  for (const XlaCompiler::Argument& arg : args) {
+    if (arg.kind == XlaCompiler::Argument::kResource) {
+      num_variable_args++;
+    }
+  }
+
+  const string persistent_cache_path =
+      persistent_cache_path_fn ? persistent_cache_path_fn() : "";
+  if (persistent_cache_path.empty() ||
+      !LoadCompilationResult(persistent_cache_path, compilation_result)) {
+    TF_RETURN_IF_ERROR(compile_fn(&compiler, compilation_result));
+    if (!persistent_cache_path.empty()) {
+      StoreCompilationResult(persistent_cache_path, *compilation_result);
+    }
+  } else {
+    VLOG(1) << "Loaded compilation of " << function.name() << " from "
+            << persistent_cache_path;
+  }
+  CHECK_EQ(executable->get(), nullptr);
+  Status build_status =
+      BuildExecutable(options, *compilation_result, num_parameter_args,
+                      num_variable_args, executable);
+
+  const uint64 compile_end_us = env->NowMicros();
+  const uint64 compile_time_us = compile_end_us - compile_start_us;
+  metrics::UpdateXlaCompilationTime(compile_time_us);
+  metrics::UpdateXlaClusterCompilationTime(function.name(), compile_time_us);
+  {
+    mutex_lock lock(cluster_compile_stats_mu_);
+    auto it = cluster_compile_stats_.find(function.name());
+    it->second.compile_count++;
+    it->second.cumulative_compile_time_us += compile_time_us;
+    LogOnceXlaCompiledFirstCluster();
+    if (IsRecompilationWarningCount(it->second.compile_count)) {
+      LOG(WARNING) << "XLA cluster " << function.name() << " has been "
+                   << "compiled " << it->second.compile_count
+                   << " times, spending "
+                   << tensorflow::strings::HumanReadableElapsedTime(
+                          it->second.cumulative_compile_time_us / 1.0e6)
+                   << " compiling. Each distinct input signature (e.g. "
+                   << "each distinct input shape) is compiled separately.";
+    }
+    VLOG(1) << "compiled " << function.name() << " "
+            << it->second.compile_count
+            << " times, compile time: " << compile_time_us
+            << " us, cumulative: " << it->second.cumulative_compile_time_us
+            << " us (" << tensorflow::strings::HumanReadableElapsedTime(
+                              compile_time_us / 1.0e6)
+            << " / " << tensorflow::strings::HumanReadableElapsedTime(
+                            it->second.cumulative_compile_time_us / 1.0e6)
+            << ")";
+
+    XlaJitCompilationActivity jit_compilation_activity;
+    jit_compilation_activity.set_cluster_name(function.name());
+    jit_compilation_activity.set_compile_count(it->second.compile_count);
+    jit_compilation_activity.set_compile_time_us(compile_time_us);
+    jit_compilation_activity.set_cumulative_compile_time_us(
+        it->second.cumulative_compile_time_us);
+
+    TF_RETURN_IF_ERROR(
+        BroadcastXlaActivity(std::move(jit_compilation_activity)));
+  }
+  return build_status;
+}
+
+void XlaCompilationCache::ScheduleAsyncCompilation(
+    Entry* entry, const XlaCompiler::Options& options,
+    const NameAttrList& function, absl::Span<const XlaCompiler::Argument> args,
+    const std::function<Status(XlaCompiler* compiler,
+                               XlaCompiler::CompilationResult*)>& compile_fn,
+    const std::function<string()>& persistent_cache_path_fn) {
+  thread::ThreadPool* pool;
+  {
+    mutex_lock lock(compile_cache_mu_);
+    if (async_compile_pool_ == nullptr) {
+      async_compile_pool_ = absl::make_unique<thread::ThreadPool>(
+          Env::Default(), "xla_async_compile",
+          std::max(1, GetXlaOpsCommonFlags().tf_xla_async_compilation_threads));
+    }
+    pool = async_compile_pool_.get();
+  }
+  // `args` must outlive the compilation, see CompileAsync.
+  pool->Schedule([this, entry, options, function, args, compile_fn,
+                  persistent_cache_path_fn]() {
+    XlaCompiler::CompilationResult compilation_result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    Status status = CompileAndBuildExecutable(
+        options, function, args, compile_fn, persistent_cache_path_fn,
+        &compilation_result, &executable);
+    VLOG(1) << "Finished compiling " << function.name()
+            << " asynchronously: " << status;
+    mutex_lock entry_lock(entry->mu);
+    entry->compiling = false;
+    // A strict compilation may have compiled the entry in the meantime.
+    if (!entry->compiled) {
+      entry->compiled = true;
+      entry->compilation_status = status;
+      entry->compilation_result = std::move(compilation_result);
+      entry->executable = std::move(executable);
+    }
+  });
 }
 
 static bool ShouldBeMegamorphic(int64 compile_count, int64 execution_count) {
@@ -239,30 +633,18 @@ Status XlaCompilationCache::CompileSingleOp(
                                      args, result_dtypes, result);
   };
   return CompileImpl(options, name, args, compile_op,
+                     /*persistent_cache_path_fn=*/nullptr,
                      /*compile_threshold=*/absl::nullopt,
-                     out_compilation_result, out_executable);
+                     /*async=*/false, out_compilation_result, out_executable);
 }
 
-namespace {
-// Print something that users can search for to definitively ascertain that XLA
-// was used for their TF model.
-//
-// Prints only once to avoid spamming LOG(INFO).
-void LogOnceXlaCompiledFirstCluster() {
-  static absl::once_flag log_once;
-  absl::call_once(log_once, [] {
-    LOG(INFO) << "Compiled cluster using XLA!  This line is logged at most "
-                 "once for the lifetime of the process.";
-  });
-}
-}  // namespace
-
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
     const std::function<Status(XlaCompiler* compiler,
                                XlaCompiler::CompilationResult*)>& compile_fn,
-    absl::optional<int64> compile_threshold,
+    const std::function<string()>& persistent_cache_path_fn,
+    absl::optional<int64> compile_threshold, bool async,
     const XlaCompiler::CompilationResult** out_compilation_result,
     xla::LocalExecutable** out_executable) {
   DCHECK_NE(out_executable, nullptr);
@@ -372,65 +754,23 @@ Status XlaCompilationCache::CompileImpl(
       return Status::OK();
     }
 
-    tensorflow::Env* env = tensorflow::Env::Default();
-    const uint64 compile_start_us = env->NowMicros();
-    // Do the actual JIT compilation without holding the lock (it can take
-    // a long time.)
-
-    XlaCompiler compiler(options);
-    entry->compiled = true;
-
-    unsigned num_parameter_args = 0;
-    for (const XlaCompiler::Argument& arg : args) {
-      if (arg.kind == XlaCompiler::Argument::kParameter) {
-        num_parameter_args++;
-      }
-    }
-
-    unsigned num_variable_args = 0;
-    for (const XlaCompiler::Argument& arg : args) {
-      if (arg.kind == XlaCompiler::Argument::kResource) {
-        num_variable_args++;
+    if (async) {
+      if (!entry->compiling) {
+        entry->compiling = true;
+        ScheduleAsyncCompilation(entry, options, function, args, compile_fn,
+                                 persistent_cache_path_fn);
       }
+      VLOG(2) << "Compiling asynchronously for signature: "
+              << signature.HumanString();
+      *out_compilation_result = nullptr;
+      *out_executable = nullptr;
+      return Status::OK();
     }
 
-    entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
-    TF_RETURN_IF_ERROR(entry->compilation_status);
-    CHECK_EQ(entry->executable.get(), nullptr);
-    entry->compilation_status =
-        BuildExecutable(options, entry->compilation_result,  num_parameter_args,
-                        num_variable_args, &entry->executable);
-
-    const uint64 compile_end_us = env->NowMicros();
-    const uint64 compile_time_us = compile_end_us - compile_start_us;
-    metrics::UpdateXlaCompilationTime(compile_time_us);
-    {
-      mutex_lock lock(cluster_compile_stats_mu_);
-      auto it = cluster_compile_stats_.find(function.name());
-      it->second.compile_count++;
-      it->second.cumulative_compile_time_us += compile_time_us;
-      LogOnceXlaCompiledFirstCluster();
-      VLOG(1) << "compiled " << function.name() << " "
-              << it->second.compile_count
-              << " times, compile time: " << compile_time_us
-              << " us, cumulative: " << it->second.cumulative_compile_time_us
-              << " us (" << tensorflow::strings::HumanReadableElapsedTime(
-                                compile_time_us / 1.0e6)
-              << " / " << tensorflow::strings::HumanReadableElapsedTime(
-                              it->second.cumulative_compile_time_us / 1.0e6)
-              << ")";
-
-      XlaJitCompilationActivity jit_compilation_activity;
-      jit_compilation_activity.set_cluster_name(function.name());
-      jit_compilation_activity.set_compile_count(it->second.compile_count);
-      jit_compilation_activity.set_compile_time_us(compile_time_us);
-      jit_compilation_activity.set_cumulative_compile_time_us(
-          it->second.cumulative_compile_time_us);
-
-      TF_RETURN_IF_ERROR(
-          BroadcastXlaActivity(std::move(jit_compilation_activity)));
-    }
+    entry->compiled = true;
+    entry->compilation_status = CompileAndBuildExecutable(
+        options, function, args, compile_fn, persistent_cache_path_fn,
+        &entry->compilation_result, &entry->executable);
   }
   TF_RETURN_IF_ERROR(entry->compilation_status);
   *out_compilation_result = &entry->compilation_result;
@@ -42,6 +42,13 @@ namespace tensorflow {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// If --tf_xla_persistent_cache_directory is set, the results of compiling
+// clusters are also stored on disk, keyed by a fingerprint of the cluster
+// function, its signature and the compilation options, so that later
+// processes skip the TensorFlow to XLA translation. Backends with their own
+// persistent executable caches (e.g. the Poplar executable cache) then also
+// find the executable built from the loaded computation.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
@@ -50,6 +57,7 @@ class XlaCompilationCache : public ResourceBase {
   enum class CompileMode {
     kLazy,
     kStrict,
+    kAsync,
   };
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -62,7 +70,11 @@ class XlaCompilationCache : public ResourceBase {
   // heuristics, the compilation cache may decide not to compile the cluster at
   // this time.  In this case it returns null into both `out_compilation_result`
   // and `out_executable`.  If `compile_mode` is `kStrict` then the compilation
-  // cache always attempts the compilation on a cache miss.
+  // cache always attempts the compilation on a cache miss.  If `compile_mode`
+  // is `kAsync` then the cache decides whether to compile as for `kLazy`, but
+  // compiles on a background thread pool and returns null until the
+  // compilation has finished, so that the caller can run the cluster some
+  // other way in the meantime.
   //
   // The result of compilation is written to `*out_compilation_result`, which
   // must be non-null. If `out_executable` is non-null, also builds an
@@ -122,15 +134,47 @@ class XlaCompilationCache : public ResourceBase {
 
  private:
   // Common implementation of Compile and CompileSingleOp.
+  // `persistent_cache_path_fn`, if set, returns the path at which the result
+  // of `compile_fn` is persisted.
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
       absl::Span<const XlaCompiler::Argument> args,
       const std::function<Status(XlaCompiler* compiler,
                                  XlaCompiler::CompilationResult*)>& compile_fn,
+      const std::function<string()>& persistent_cache_path_fn,
+      absl::optional<int64> compile_threshold, bool async,
+      const XlaCompiler::CompilationResult** out_compilation_result,
+      xla::LocalExecutable** out_executable);
+
+  // Implementation of Compile for CompileMode::kAsync.
+  Status CompileAsync(
+      const XlaCompiler::Options& options, const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      const XlaCompiler::CompileOptions& compile_options,
       absl::optional<int64> compile_threshold,
       const XlaCompiler::CompilationResult** out_compilation_result,
       xla::LocalExecutable** out_executable);
 
+  // Returns the path of the persistent cache entry for compiling `function`
+  // with `args` under `cache_dir`.
+  string PersistentCachePath(
+      const string& cache_dir, const XlaCompiler::Options& options,
+      const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      const XlaCompiler::CompileOptions& compile_options) const;
+
+  // Compiles `function` with `compile_fn` (or loads the result from the
+  // persistent cache), builds its executable and updates the compilation
+  // statistics.
+  Status CompileAndBuildExecutable(
+      const XlaCompiler::Options& options, const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      const std::function<Status(XlaCompiler* compiler,
+                                 XlaCompiler::CompilationResult*)>& compile_fn,
+      const std::function<string()>& persistent_cache_path_fn,
+      XlaCompiler::CompilationResult* compilation_result,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
   // Takes `result` which has been compiled from a Tensorflow subgraph to a
   // XLA computation already, and generates an XLA LocalExecutable `executable`.
   Status BuildExecutable(const XlaCompiler::Options& options,
@@ -149,6 +193,9 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is an asynchronous compilation of this entry in progress?
+    bool compiling = false;
+
     // The number of times a compilation with this signature has been requested.
     int64 request_count = 0;
 
@@ -163,10 +210,25 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
   };
 
+  // Compiles `entry` on async_compile_pool_.  The closures and `args` must
+  // own everything they refer to.
+  void ScheduleAsyncCompilation(
+      Entry* entry, const XlaCompiler::Options& options,
+      const NameAttrList& function,
+      absl::Span<const XlaCompiler::Argument> args,
+      const std::function<Status(XlaCompiler* compiler,
+                                 XlaCompiler::CompilationResult*)>& compile_fn,
+      const std::function<string()>& persistent_cache_path_fn);
+
   mutex compile_cache_mu_;
   absl::flat_hash_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(compile_cache_mu_);
 
+  // Runs asynchronous compilations.  Created on first use, with
+  // --tf_xla_async_compilation_threads threads.
+  std::unique_ptr<thread::ThreadPool> async_compile_pool_
+      GUARDED_BY(compile_cache_mu_);
+
   struct ClusterCompileStats {
     // Number of times the cluster has been (re-)compiled.
     int64 compile_count = 0;
@@ -208,6 +208,7 @@ XlaDevice::XlaDevice(const SessionOptions& session_options,
           session_options.config.intra_op_parallelism_threads()),
       use_multiple_streams_(options.use_multiple_streams),
       shape_representation_fn_(options.shape_representation_fn),
+      borrow_host_tensor_fn_(options.borrow_host_tensor_fn),
       allowed_devices_(options.allowed_devices) {
   VLOG(1) << "Created XLA device " << options.compilation_device_name << " "
           << this;
@@ -340,14 +341,15 @@ XlaDevice::GetDeviceContextLocked() {
   device_context_ = new XlaDeviceContext(
       stream_, host_to_device_stream, device_to_host_stream,
       device_to_device_streams, client, shape_representation_fn_,
-      thread_pool_.get(), false);
+      thread_pool_.get(), false, borrow_host_tensor_fn_);
   VLOG(1) << "XlaDevice " << this << " new XlaDeviceContext(fast_mem=false) "
           << device_context_;
 
   fast_mem_device_context_ = new XlaDeviceContext(
       stream_, std::move(host_to_device_stream),
       std::move(device_to_host_stream), std::move(device_to_device_streams),
-      client, shape_representation_fn_, thread_pool_.get(), true);
+      client, shape_representation_fn_, thread_pool_.get(), true,
+      borrow_host_tensor_fn_);
   VLOG(1) << "XlaDevice " << this << " new XlaDeviceContext(fast_mem=true) "
           << fast_mem_device_context_;
 
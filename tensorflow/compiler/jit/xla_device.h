@@ -130,6 +130,11 @@ class XlaDevice : public LocalDevice {
     // platform will have resources allocated. For GPUs this will be
     // filled from visible_gpu_devices list from session configuration.
     absl::optional<std::set<int>> allowed_devices;
+
+    // If set, the device buffers of the tensors copied from the host can be
+    // views of the host tensors rather than copies of them. See
+    // XlaDeviceContext::BorrowHostTensorFn.
+    XlaDeviceContext::BorrowHostTensorFn borrow_host_tensor_fn;
   };
 
   // Creates a new XLA Device.
@@ -240,6 +245,8 @@ class XlaDevice : public LocalDevice {
 
   const XlaCompiler::ShapeRepresentationFn shape_representation_fn_;
 
+  const XlaDeviceContext::BorrowHostTensorFn borrow_host_tensor_fn_;
+
   // The device context accessed by all users of the XlaDevice, set by calls to
   // EnsureDeviceContextOk. If gpu_device_info_ is non-null, this pointer is
   // also filled in to that struct. XlaDeviceContext is a ref-counted object.
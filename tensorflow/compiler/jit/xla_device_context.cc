@@ -78,7 +78,8 @@ XlaDeviceContext::XlaDeviceContext(
     std::vector<std::shared_ptr<se::Stream>> device_to_device_streams,
     xla::LocalClient* client,
     XlaCompiler::ShapeRepresentationFn shape_representation_fn,
-    thread::ThreadPool* thread_pool, bool use_fast_mem)
+    thread::ThreadPool* thread_pool, bool use_fast_mem,
+    BorrowHostTensorFn borrow_host_tensor_fn)
     : stream_(std::move(compute_stream)),
       host_to_device_stream_(std::move(host_to_device_stream)),
       device_to_host_stream_(std::move(device_to_host_stream)),
@@ -87,7 +88,8 @@ XlaDeviceContext::XlaDeviceContext(
       transfer_manager_(client->backend().transfer_manager()),
       shape_representation_fn_(std::move(shape_representation_fn)),
       thread_pool_(thread_pool),
-      use_fast_mem_(use_fast_mem) {
+      use_fast_mem_(use_fast_mem),
+      borrow_host_tensor_fn_(std::move(borrow_host_tensor_fn)) {
   CHECK(host_to_device_stream_ != nullptr);
   CHECK(stream_ != nullptr);
   if (!shape_representation_fn_) {
@@ -131,6 +133,7 @@ void XlaDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
   XlaTensor* xla_tensor = XlaTensor::FromTensor(device_tensor);
   CHECK(xla_tensor);
 
+  bool borrowed = false;
   Status status = [&]() -> Status {
     TF_ASSIGN_OR_RETURN(
         xla::Shape shape,
@@ -145,6 +148,20 @@ void XlaDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
         xla_tensor->AllocateShapedBuffer(device_tensor->dtype(), shape, client_,
                                          stream_->parent()->device_ordinal()));
 
+    // The device may read the data from the host tensor when it needs it, so
+    // that nothing is transferred until then.
+    if (borrow_host_tensor_fn_) {
+      TF_ASSIGN_OR_RETURN(
+          borrowed,
+          borrow_host_tensor_fn_(*cpu_tensor, host_to_device_stream_.get(),
+                                 &xla_tensor->shaped_buffer()));
+      if (borrowed) {
+        VLOG(2) << "Borrowed the host tensor as "
+                << xla_tensor->shaped_buffer().ToString();
+        return Status::OK();
+      }
+    }
+
     // The cpu_tensor and literal that we created here hold the data of host
     // tensor in descending layout. The layout could be different from layout in
     // device_tensor (but the logical shape has to be the same). The
@@ -178,7 +195,7 @@ void XlaDeviceContext::CopyCPUTensorToDevice(const Tensor* cpu_tensor,
 
     return Status::OK();
   }();
-  if (!status.ok()) {
+  if (!status.ok() || borrowed) {
     done(status);
     return;
   }
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_DEVICE_CONTEXT_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_DEVICE_CONTEXT_H_
 
+#include <functional>
 #include <memory>
 
 #include "absl/synchronization/mutex.h"
@@ -51,6 +52,17 @@ class XlaDeviceAllocator : public Allocator {
 // Helper class for managing data transfers between host and XLA devices.
 class XlaDeviceContext : public DeviceContext {
  public:
+  // A function that makes `device_buffer`, freshly allocated on the device of
+  // `stream`, a view of the data of `cpu_tensor` rather than a copy of it.
+  // Returns false if the device cannot do it for this buffer, in which case
+  // the data is transferred. Otherwise the device keeps a reference to
+  // `cpu_tensor` for as long as it reads from its data, and never writes to
+  // it.
+  typedef std::function<xla::StatusOr<bool>(const Tensor& cpu_tensor,
+                                             se::Stream* stream,
+                                             xla::ShapedBuffer* device_buffer)>
+      BorrowHostTensorFn;
+
   explicit XlaDeviceContext(
       std::shared_ptr<se::Stream> compute_stream,
       std::shared_ptr<se::Stream> host_to_device_stream,
@@ -58,7 +70,8 @@ class XlaDeviceContext : public DeviceContext {
       std::vector<std::shared_ptr<se::Stream>> device_to_device_streams,
       xla::LocalClient* client,
       XlaCompiler::ShapeRepresentationFn shape_representation_fn,
-      thread::ThreadPool* thread_pool, bool use_fast_mem = false);
+      thread::ThreadPool* thread_pool, bool use_fast_mem = false,
+      BorrowHostTensorFn borrow_host_tensor_fn = nullptr);
 
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
@@ -116,6 +129,9 @@ class XlaDeviceContext : public DeviceContext {
   // Whether uses TPU fast mem or not.
   bool use_fast_mem_;
 
+  // If set, host tensors are offered to it before being transferred.
+  BorrowHostTensorFn borrow_host_tensor_fn_;
+
   absl::Mutex mu_;
   int next_stream_ GUARDED_BY(mu_) = 0;
 };
@@ -81,6 +81,13 @@ struct HostEmbeddingInfo {
 
   // Only used with experimental remote buffer embedding
   HostEmbeddingSplittingStrategy strategy;
+
+  // Only used by lookups with a device side cache.
+  int64 cache_rows = 0;
+  // The maximum number of distinct rows transferred by lookups with a cache
+  // and by the lookups and updates which deduplicate their indices.
+  int64 cache_max_misses = 0;
+  bool deduplicate = false;
 };
 
 struct RemoteParameterInfo {
@@ -28,6 +28,10 @@ struct CompilerInformation {
 
   int64 max_reduce_scatter_buffer_size = 0;
 
+  int64 all_reduce_bucket_size = 0;
+
+  int64 reduce_scatter_bucket_size = 0;
+
   int64 max_inter_ipu_copies_buffer_size = 0;
 
   int64 max_send_recv_cluster_size = 0;
@@ -38,6 +42,8 @@ struct CompilerInformation {
 
   int64 minimum_remote_tensor_size = 128;
 
+  int64 remote_parameter_prefetch_size = 0;
+
   CompilerInformation& set_max_all_reduce_buffer_size(int64 val) {
     max_all_reduce_buffer_size = val;
     return *this;
@@ -48,6 +54,16 @@ struct CompilerInformation {
     return *this;
   }
 
+  CompilerInformation& set_all_reduce_bucket_size(int64 val) {
+    all_reduce_bucket_size = val;
+    return *this;
+  }
+
+  CompilerInformation& set_reduce_scatter_bucket_size(int64 val) {
+    reduce_scatter_bucket_size = val;
+    return *this;
+  }
+
   CompilerInformation& set_max_inter_ipu_copies_buffer_size(int64 val) {
     max_inter_ipu_copies_buffer_size = val;
     return *this;
@@ -72,6 +88,11 @@ struct CompilerInformation {
     minimum_remote_tensor_size = val;
     return *this;
   }
+
+  CompilerInformation& set_remote_parameter_prefetch_size(int64 val) {
+    remote_parameter_prefetch_size = val;
+    return *this;
+  }
 };
 
 }  // namespace poplarplugin
@@ -16,16 +16,19 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_COMPILER_RESOURCES_H_
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_COMPILER_RESOURCES_H_
 
+#include <map>
 #include <memory>
 #include <poplar/Graph.hpp>
 #include <poplar/OptionFlags.hpp>
 #include <poplin/Convolution.hpp>
 #include <poplin/MatMul.hpp>
 #include <popops/DynamicSlice.hpp>
+#include <popsparse/experimental/BlockSparseMatMul.hpp>
 #include <poprand/RandomGen.hpp>
 #include <poputil/GraphFunction.hpp>
 #include <stack>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_annotations.h"
@@ -36,6 +39,7 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/execution_counter_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/generic_graph_caching.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/mapping_helper.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/planning_caches.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/subcomputation_graph_caching.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/verified_streams_indices.h"
 #include "tensorflow/compiler/plugin/poplar/driver/visitors/deferred_visitor.h"
@@ -53,6 +57,10 @@ struct CompilerResources {
 
   std::vector<poplar::Graph> shard_graphs;
 
+  // The graphs of the IO tiles of each shard, empty if no IO tiles are
+  // reserved.
+  std::vector<poplar::Graph> shard_io_graphs;
+
   std::vector<unsigned> shard_to_ipu_id;
 
   absl::flat_hash_map<const HloInstruction*, const popops::SlicePlan*>
@@ -61,15 +69,34 @@ struct CompilerResources {
   std::list<popops::SlicePlan> slice_plans;
   absl::flat_hash_set<const popops::SlicePlan*> used_slice_plan;
 
+  // The block-sparse matmul plans of each block-sparse instruction, in the
+  // order its lowering uses them.
+  absl::flat_hash_map<
+      const HloInstruction*,
+      std::vector<const popsparse::experimental::BSMatMulParams*>>
+      block_sparse_plan_mappings;
+
+  std::list<popsparse::experimental::BSMatMulParams> block_sparse_plans;
+
+  // The tensors which set the layout of the dropout masks, shared by all the
+  // dropout instructions of a graph with the same shape. The backward pass
+  // regenerates the mask of the forward pass from its seed, which needs the
+  // same layout, and the references are not kept live once per instruction.
+  absl::flat_hash_map<std::pair<const poplar::Graph*, Shape>, poplar::Tensor>
+      dropout_references;
+
   CompilerAnnotations annotations;
 
   const CompilerInformation information;
 
-  poplin::PlanningCache convolution_cache;
+  // The planning caches can be shared with other compilations.
+  const std::shared_ptr<PlanningCaches> planning_caches;
+
+  poplin::PlanningCache& convolution_cache;
 
-  poplin::matmul::PlanningCache matmul_cache;
+  poplin::matmul::PlanningCache& matmul_cache;
 
-  poplin::matmul::PlanningCache dot_cache;
+  poplin::matmul::PlanningCache& dot_cache;
 
   const IpuOptions::FloatingPointBehaviour global_floating_point_behaviour;
 
@@ -142,12 +169,37 @@ struct CompilerResources {
 
   VerifiedStreamsIndices streams_indices;
 
-  bool enable_experimental_remote_buffer_embedding;
+  bool enable_remote_buffer_embedding;
 
   bool enable_fast_math;
 
+  IpuOptions::HostEmbeddingCacheOptions host_embedding_cache_options;
+
+  bool double_buffer_repeat_loop_feeds;
+
   absl::flat_hash_set<std::string> custom_codelets_in_graph;
 
+  // Whether the cycles of the pipeline ramp up, repeat block and ramp down are
+  // streamed to the host.
+  bool has_pipeline_cycle_counter = false;
+
+  // The total cycles of the executions of each instruction, by instruction
+  // name, when they are counted with the log_instruction_cycle_count flag.
+  std::map<std::string, poplar::Tensor> instruction_cycle_counters;
+
+  // The time spent lowering each instruction to Poplar, including the
+  // instructions of the computations it calls.
+  absl::flat_hash_map<const HloInstruction*, uint64> instruction_compile_nanos;
+
+  // The operands which were copied to a linear mapping because most of their
+  // elements were on a few tiles, and the bytes this saved on the busiest
+  // tiles of these operands.
+  struct TileImbalanceStats {
+    uint64 num_rebalanced_tensors = 0;
+    uint64 max_tile_bytes_saved = 0;
+  };
+  TileImbalanceStats tile_imbalance_stats;
+
   CompilerResources(
       HloModule* module, const CompilerInformation& information,
       const poplar::OptionFlags& conv_options,
@@ -162,9 +214,18 @@ struct CompilerResources {
       bool use_stable_norm_statistics, bool remote_memory_supported,
       const poplar::OptionFlags& gcl_options,
       int64 triangular_solve_expander_block_size,
-      bool enable_experimental_remote_buffer_embedding, bool enable_fast_math)
+      bool enable_remote_buffer_embedding, bool enable_fast_math,
+      const IpuOptions::HostEmbeddingCacheOptions&
+          host_embedding_cache_options,
+      bool double_buffer_repeat_loop_feeds,
+      std::shared_ptr<PlanningCaches> planning_caches =
+          std::make_shared<PlanningCaches>())
       : annotations(module),
         information(information),
+        planning_caches(std::move(planning_caches)),
+        convolution_cache(this->planning_caches->convolution_cache),
+        matmul_cache(this->planning_caches->matmul_cache),
+        dot_cache(this->planning_caches->dot_cache),
         global_floating_point_behaviour(floating_point_behaviour),
         default_conv_options(conv_options),
         default_matmul_options(matmul_options),
@@ -184,9 +245,10 @@ struct CompilerResources {
         gcl_options(gcl_options),
         triangular_solve_expander_block_size(
             triangular_solve_expander_block_size),
-        enable_experimental_remote_buffer_embedding(
-            enable_experimental_remote_buffer_embedding),
-        enable_fast_math(enable_fast_math) {}
+        enable_remote_buffer_embedding(enable_remote_buffer_embedding),
+        enable_fast_math(enable_fast_math),
+        host_embedding_cache_options(host_embedding_cache_options),
+        double_buffer_repeat_loop_feeds(double_buffer_repeat_loop_feeds) {}
 
   static std::unique_ptr<CompilerResources> CreateTestDefault(
       HloModule* module,
@@ -206,8 +268,11 @@ struct CompilerResources {
         /*remote_memory_supported=*/false,
         /*gcl_options=*/poplar::OptionFlags(),
         /*triangular_solve_expander_block_size=*/0,
-        /*enable_experimental_remote_buffer_embedding=*/false,
-        /*enable_fast_math=*/false);
+        /*enable_remote_buffer_embedding=*/false,
+        /*enable_fast_math=*/false,
+        /*host_embedding_cache_options=*/
+        IpuOptions::HostEmbeddingCacheOptions(),
+        /*double_buffer_repeat_loop_feeds=*/false);
   }
 };
 
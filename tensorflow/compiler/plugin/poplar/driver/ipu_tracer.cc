@@ -0,0 +1,155 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/ipu_activity_recorder.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/profiler/internal/profiler_interface.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using tensorflow::EnvTime;
+using tensorflow::NodeExecStats;
+using tensorflow::RunMetadata;
+using tensorflow::Status;
+using tensorflow::StepStatsCollector;
+using tensorflow::profiler::ProfilerInterface;
+
+// The device the activity is shown on in the trace. The compilation and the
+// transfers get their own lines so that they can be told apart from the
+// execution of the engine.
+std::string DeviceName(const IpuActivity& activity) {
+  const std::string device = absl::StrCat("/device:IPU:", activity.ordinal);
+  switch (activity.type) {
+    case IpuActivityType::kCompile:
+      return absl::StrCat(device, "/compile");
+    case IpuActivityType::kLoadEngine:
+    case IpuActivityType::kExecute:
+      return device;
+    case IpuActivityType::kHostToDevice:
+    case IpuActivityType::kDeviceToHost:
+      return absl::StrCat(device, "/memcpy");
+    case IpuActivityType::kStreamCallback:
+      return absl::StrCat(device, "/stream_callbacks");
+    case IpuActivityType::kInfeed:
+      return absl::StrCat(device, "/infeed");
+    case IpuActivityType::kOutfeed:
+      return absl::StrCat(device, "/outfeed");
+  }
+  return device;
+}
+
+// Controls IpuActivityRecorder and converts the IpuActivities into RunMetadata
+// messages, on the same timeline as the host TraceMe events.
+//
+// Thread-safety: This class is go/thread-compatible.
+class IpuTracer : public ProfilerInterface {
+ public:
+  IpuTracer() = default;
+  ~IpuTracer() override { Stop().IgnoreError(); }
+
+  // Starts recording IPU activities.
+  Status Start() override;
+
+  // Stops recording IPU activities.
+  Status Stop() override;
+
+  // Populates the IPU activities in response, with one device per IPU and
+  // category of activity.
+  Status CollectData(RunMetadata* run_metadata) override;
+
+  tensorflow::profiler::DeviceType GetDeviceType() override {
+    return tensorflow::profiler::DeviceType::kUnspecified;
+  }
+
+ private:
+  // True if currently recording.
+  bool recording_ = false;
+
+  std::vector<IpuActivity> activities_;
+};
+
+Status IpuTracer::Start() {
+  if (recording_) {
+    return tensorflow::errors::Internal("IpuActivityRecorder already started");
+  }
+  recording_ = IpuActivityRecorder::Start();
+  if (!recording_) {
+    return tensorflow::errors::Internal(
+        "Failed to start IpuActivityRecorder, another IPU tracer is running");
+  }
+  return Status::OK();
+}
+
+Status IpuTracer::Stop() {
+  if (!recording_) {
+    return tensorflow::errors::Internal("IpuActivityRecorder not started");
+  }
+  activities_ = IpuActivityRecorder::Stop();
+  recording_ = false;
+  return Status::OK();
+}
+
+Status IpuTracer::CollectData(RunMetadata* run_metadata) {
+  if (recording_) {
+    return tensorflow::errors::Internal("IpuActivityRecorder not stopped");
+  }
+  StepStatsCollector step_stats_collector(run_metadata->mutable_step_stats());
+  for (auto& activity : activities_) {
+    NodeExecStats* ns = new NodeExecStats;
+    ns->set_timeline_label(
+        absl::StrCat(IpuActivityTypeName(activity.type), " ", activity.name));
+    ns->set_node_name(std::move(activity.name));
+    ns->set_all_start_micros(activity.start_nanos / EnvTime::kMicrosToNanos);
+    ns->set_all_end_rel_micros((activity.end_nanos - activity.start_nanos) /
+                               EnvTime::kMicrosToNanos);
+    ns->set_thread_id(activity.thread_id);
+    step_stats_collector.Save(DeviceName(activity), ns);
+  }
+  activities_.clear();
+  step_stats_collector.Finalize();
+  return Status::OK();
+}
+
+}  // namespace
+
+// Not in anonymous namespace for testing purposes.
+std::unique_ptr<ProfilerInterface> CreateIpuTracer(
+    const tensorflow::profiler::ProfilerOptions& options) {
+  // The IPU is not one of the device types of the profiler options, so it is
+  // only traced when all the devices are.
+  if (options.device_type !=
+      tensorflow::profiler::DeviceType::kUnspecified) {
+    return nullptr;
+  }
+  return absl::make_unique<IpuTracer>();
+}
+
+auto register_ipu_tracer_factory = [] {
+  tensorflow::RegisterProfilerFactory(&CreateIpuTracer);
+  return 0;
+}();
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -18,6 +18,7 @@ limitations under the License.
 #include <gcl/Collectives.hpp>
 #include <popnn/Loss.hpp>
 #include <popops/Cast.hpp>
+#include <popops/DynamicSlice.hpp>
 #include <popops/ElementWise.hpp>
 #include <popops/Encoding.hpp>
 #include <popops/HostSliceTensor.hpp>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/compiler/plugin/poplar/driver/ops/custom_ops/poplar_ops.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/host_embedding_cache.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
@@ -37,10 +39,22 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/errors.h"
 
+namespace pe = popops::expr;
+
 namespace xla {
 namespace poplarplugin {
 namespace {
 
+// The maximum number of distinct rows transferred by a host embedding lookup
+// or update of `num_indices` indices with a cache or deduplication.
+int64 MaxTransferredRows(const CompilerResources& res, int64 num_indices) {
+  const int64 max_misses = res.host_embedding_cache_options.max_misses();
+  return std::min<int64>(
+      max_misses > 0 ? max_misses
+                     : tensorflow::MathUtil::CeilOfRatio<int64>(num_indices, 2),
+      num_indices);
+}
+
 StatusOr<poplar::RemoteBuffer> GetOrCreateRemoteBuffer(
     poplar::Graph& graph, CompilerResources& res, const HloInstruction* inst,
     const std::string& embedding_id, const xla::Shape& embedding_shape,
@@ -49,9 +63,9 @@ StatusOr<poplar::RemoteBuffer> GetOrCreateRemoteBuffer(
   if (!res.remote_memory_supported) {
     return FailedPrecondition(
         "Poplar remote buffers are not supported on this machine. They are "
-        "required to support experimental remote buffer embeddings. Consider "
-        "either configuring this machine to support remote buffers or "
-        "setting enable_experimental_remote_buffer_embedding to false.");
+        "required to support remote buffer embeddings. Consider either "
+        "configuring this machine to support remote buffers or setting "
+        "enable_remote_buffer_embedding to false.");
   }
 
   auto itr = res.remote_buffers.find(embedding_id);
@@ -143,6 +157,104 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
     return seq;
   }
 
+  // Host embedding using a poplar callback with a device side cache of the
+  // embedding rows. The host sends the location of each row in the cache and
+  // only the rows which are not in the cache. See HostEmbeddingCache for the
+  // layout of the slots. Without any cache rows this only deduplicates the
+  // rows sent by the host.
+  StatusOr<poplar::program::Program> CachedCallbackImpl(
+      poplar::Graph& graph, poplar::Tensor indices,
+      poplar::program::Sequence seq, CompilerResources& res,
+      const HloHostEmbeddingLookupInstruction* inst,
+      const xla::Shape& output_shape, TensorMap& tensor_map) {
+    TF_ASSIGN_OR_RETURN(poplar::Tensor output,
+                        AddTensor(graph, TensorLocation{inst, 0}, output_shape,
+                                  res, tensor_map));
+
+    const auto& cache_options = res.host_embedding_cache_options;
+    const int64 num_indices = indices.numElements();
+    const int64 cache_rows = std::min<int64>(
+        cache_options.cache_rows(), inst->EmbeddingShape().dimensions(0));
+    const int64 max_misses = MaxTransferredRows(res, num_indices);
+    const int64 num_slots =
+        HostEmbeddingCache::NumSlots(num_indices, max_misses);
+
+    HostEmbeddingInfo info(inst->name(), inst->EmbeddingId(),
+                           inst->operand(0)->shape(), output_shape,
+                           inst->SplittingStrategy());
+    info.cache_rows = cache_rows;
+    info.cache_max_misses = max_misses;
+    info.deduplicate = cache_options.deduplicate();
+    res.annotations.host_embedding_lookup_infos.push_back(info);
+
+    const std::string handle = inst->name() + inst->EmbeddingId();
+    const std::string debug_name = GetDebugName(inst);
+    const std::size_t width = output.dim(1);
+
+    // The cache rows, followed by the staging rows for the rows sent by the
+    // host and a junk row. The cache persists between the executions of the
+    // lookup.
+    poplar::Tensor cache = popops::createSliceableTensor(
+        graph, output.elementType(), {cache_rows + max_misses + 1, width}, {0},
+        {1}, popops::SlicePlan{}, {}, debug_name + "/cache");
+    poplar::Tensor misses = popops::createSliceTensor(
+        graph, output.elementType(), cache.shape(), {0}, {1}, max_misses,
+        popops::SlicePlan{}, {}, debug_name + "/misses");
+    misses = misses.reshape({max_misses, width});
+
+    poplar::Tensor slots = graph.addVariable(poplar::UNSIGNED_INT, {num_slots},
+                                             debug_name + "/slots");
+    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph, slots);
+
+    auto index_buffer = graph.addDeviceToHostFIFO(
+        handle + "_indices", indices.elementType(), indices.numElements());
+    auto slots_fifo = graph.addHostToDeviceFIFO(
+        handle + "_cache_slots", poplar::UNSIGNED_INT, num_slots);
+    auto misses_fifo = graph.addHostToDeviceFIFO(
+        handle + "_cache_misses", output.elementType(), misses.numElements());
+    auto activation_fifo = graph.addHostToDeviceFIFO(
+        handle + "_activations", output.elementType(), output.numElements());
+
+    // Send the indices to the host.
+    seq.add(poplar::program::Copy(indices, index_buffer));
+
+    // Sync to avoid any stream merging due to host-side data dependecy.
+    seq.add(poplar::program::Sync(poplar::SyncType::INTERNAL));
+
+    // Read where each row is from the host.
+    seq.add(poplar::program::Copy(slots_fifo, slots));
+
+    // When there were too many misses the host sends all the rows.
+    poplar::program::Sequence all_rows_seq;
+    all_rows_seq.add(poplar::program::Copy(activation_fifo, output));
+
+    // Otherwise the rows which are not in the cache are sent, and the lookup
+    // is performed from the cache.
+    poplar::program::Sequence cached_seq;
+    cached_seq.add(poplar::program::Copy(misses_fifo, misses));
+    cached_seq.add(poplar::program::Copy(
+        misses, cache.slice(cache_rows, cache_rows + max_misses)));
+    poplar::Tensor rows = popops::multiSlice(
+        graph, cache, slots.slice(0, num_indices).expand({1}), {0}, {1},
+        cached_seq, popops::SlicePlan{}, {}, debug_name + "/lookup");
+    cached_seq.add(poplar::program::Copy(rows.reshape(output.shape()), output));
+
+    // Insert the new rows into the cache.
+    if (cache_rows > 0) {
+      popops::multiUpdate(
+          graph, cache, misses.expand({1}),
+          slots.slice(num_indices, num_indices + max_misses).expand({1}), {0},
+          {1}, cached_seq, popops::SlicePlan{}, {}, debug_name + "/insert");
+    }
+
+    poplar::Tensor overflow = slots[num_slots - 1];
+    seq.add(poplar::program::If(overflow, all_rows_seq, cached_seq));
+
+    TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 0, output));
+
+    return seq;
+  }
+
   // Single replica remote buffer implementation.
   StatusOr<poplar::program::Program> RemoteBufferImpl(
       poplar::Graph& graph, poplar::RemoteBuffer& remote_buffer,
@@ -174,7 +286,9 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
   }
 
   // Replicated remote buffer embedding lookup using the token splitting
-  // strategy.
+  // strategy. Each replica reads the rows it owns for the indices of every
+  // replica, the rows are exchanged with an all-to-all, and each replica then
+  // slices the rows for its indices from the ones sent by their owners.
   StatusOr<poplar::program::Program> RemoteBufferSplitTokensImpl(
       poplar::Graph& graph, poplar::RemoteBuffer& remote_buffer,
       poplar::Tensor indices, poplar::program::Sequence seq,
@@ -184,6 +298,8 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
     TF_ASSIGN_OR_RETURN(poplar::Tensor output,
                         AddTensor(graph, TensorLocation{inst, 0}, output_shape,
                                   res, tensor_map));
+    const std::size_t num_indices = indices.numElements();
+    poplar::Tensor local_indices = indices.flatten();
 
     // All-Gather the indices from all replicas.
     indices =
@@ -199,7 +315,9 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
     // Divide the indices by the replication factor to transform the global
     // address space indices to the replica-local address space. Given we can
     // currently assume there is a power of two replication factor, this could
-    // be rewritten as bitshift right log_2(rep) bits.
+    // be rewritten as bitshift right log_2(rep) bits. The indices owned by
+    // other replicas map to a valid, but incorrect, row which is discarded
+    // below.
     poplar::Tensor ind = popops::div(graph, indices.flatten(), rep, seq,
                                      GetDebugName(inst) + "/shift_indices");
 
@@ -216,49 +334,41 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
     seq.add(poplar::program::Copy(remote_buffer, host_sliceable.tensor,
                                   host_sliceable.indices));
 
-    // The current replica index.
-    poplar::Tensor replica_id = graph.addReplicationIndexConstant();
-    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph,
-                                     replica_id);
-
-    // Take the modulus of the global indices with the replication factor.
-    // Given we can currently assume that the replication factor is a power of
-    // two, this could be rewritten as a bitwise-and with rep-1.
-    poplar::Tensor rem = popops::rem(graph, indices, rep, seq,
-                                     GetDebugName(inst) + "/mask_indices");
-
-    // Check whether (i mod r) is equal to this replica id. This tells us
-    // whether the element refered to by the global index is "owned" by this
-    // replca.
-    poplar::Tensor mask =
-        popops::eq(graph, rem.reinterpret(replica_id.elementType()), replica_id,
-                   seq, GetDebugName(inst) + "/mask");
-
-    // Create a constant zero fo masking.
-    poplar::Tensor zero =
-        graph.addConstant(host_sliceable.tensor.elementType(), {}, 0,
-                          GetDebugName(inst) + "/zero");
-    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph, zero);
-
-    // Use the computed mask, based on whether this replica "owns" the requested
-    // element, to zero the invalid elements of host_sliceable.tensor.
-    popops::selectInPlace(graph, host_sliceable.tensor, zero,
-                          mask.flatten().expand({1}), seq,
-                          GetDebugName(inst) + "/mask_output");
-    host_sliceable.tensor = host_sliceable.tensor.reshape(
-        {indices.dim(0), indices.dim(1), output.dim(1)});
-
-    // Given that invalid elements will be zero and valid elements will contain
-    // the correct value, we can replicatedReduceScatter sum to distribute the
-    // results to the correct replica.
-    host_sliceable.tensor = gcl::reduceScatter(
-        graph, host_sliceable.tensor.flatten(), popops::Operation::ADD, seq,
-        GetDebugName(inst) + "/reduce_scatter",
+    // Send the rows read for the indices of each replica to that replica. We
+    // receive the rows every replica read for our indices.
+    poplar::Tensor rows = gcl::allToAll(
+        graph,
+        host_sliceable.tensor.reshape(
+            {indices.dim(0), num_indices, output.dim(1)}),
+        seq, GetDebugName(inst) + "/exchange_rows",
         GetReplicatedCollectiveOptions(res));
 
+    // The i-th index is owned by replica (i mod r), so its row is at
+    // (i mod r) * n + i in the received rows, where n is the number of
+    // indices of each replica. Given that we can currently assume that the
+    // replication factor is a power of two, the modulus could be rewritten as
+    // a bitwise-and with rep-1.
+    poplar::Tensor owner = popops::rem(graph, local_indices, rep, seq,
+                                       GetDebugName(inst) + "/owner");
+    poplar::Tensor position =
+        graph.addVariable(poplar::UNSIGNED_INT, {num_indices},
+                          GetDebugName(inst) + "/position");
+    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph,
+                                     position);
+    popops::iota(graph, position, 0U, seq, GetDebugName(inst) + "/position");
+    poplar::Tensor offsets = popops::map(
+        graph,
+        pe::Add(pe::Mul(pe::_1, pe::Const(static_cast<unsigned>(num_indices))),
+                pe::_2),
+        {owner, position}, seq, GetDebugName(inst) + "/offsets");
+
+    // Slice the rows of our indices from the received rows.
+    rows = popops::multiSlice(graph, rows.flatten(0, 2), offsets.expand({1}),
+                              {0}, {1}, seq, popops::SlicePlan{}, {},
+                              GetDebugName(inst) + "/select_rows");
+
     // Copy the result to the output tensor.
-    seq.add(poplar::program::Copy(host_sliceable.tensor.reshape(output.shape()),
-                                  output));
+    seq.add(poplar::program::Copy(rows.reshape(output.shape()), output));
 
     TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 0, output));
     return seq;
@@ -335,14 +445,14 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
     const HloHostEmbeddingLookupInstruction* host_embedding_inst =
         Cast<HloHostEmbeddingLookupInstruction>(inst);
 
-    if (UseSyntheticData()) {
+    if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding)) {
       return SyntheticImpl(graph, indices[0].reinterpret(poplar::UNSIGNED_INT),
                            seq, res, host_embedding_inst, output_shape,
                            tensor_map);
     }
 
-    if (res.enable_experimental_remote_buffer_embedding) {
-      VLOG(1) << "Using experimental remote buffer embedding lookup";
+    if (res.enable_remote_buffer_embedding) {
+      VLOG(1) << "Using remote buffer embedding lookup";
 
       TF_ASSIGN_OR_RETURN(
           poplar::RemoteBuffer rbuffer,
@@ -372,6 +482,13 @@ class HostEmbeddingLookupOp : public PoplarOpDef {
           res, host_embedding_inst, output_shape, tensor_map);
     }
 
+    if (res.host_embedding_cache_options.cache_rows() > 0 ||
+        res.host_embedding_cache_options.deduplicate()) {
+      return CachedCallbackImpl(
+          graph, indices[0].reinterpret(poplar::UNSIGNED_INT), seq, res,
+          host_embedding_inst, output_shape, tensor_map);
+    }
+
     return CallbackImpl(graph, indices[0].reinterpret(poplar::UNSIGNED_INT),
                         seq, res, host_embedding_inst, output_shape,
                         tensor_map);
@@ -411,6 +528,79 @@ class HostEmbeddingUpdateOp : public PoplarOpDef {
     return seq;
   }
 
+  // Host embedding update using a poplar callback which only sends one
+  // gradient row for each distinct index. The host sends the position of each
+  // index in the distinct indices, see DeduplicateIndices for the layout of the
+  // slots, and the device sums the gradients of the repeated indices.
+  StatusOr<poplar::program::Program> DeduplicatedCallbackImpl(
+      poplar::Graph& graph, poplar::Tensor grads, poplar::Tensor indices,
+      poplar::program::Sequence seq, CompilerResources& res,
+      const HloHostEmbeddingUpdateInstruction* inst,
+      const xla::Shape& output_shape, TensorMap& tensor_map) {
+    const int64 num_indices = indices.numElements();
+    const int64 max_unique = MaxTransferredRows(res, num_indices);
+
+    HostEmbeddingInfo info(inst->name(), inst->EmbeddingId(),
+                           inst->operand(2)->shape(),
+                           inst->operand(1)->shape());
+    info.cache_max_misses = max_unique;
+    info.deduplicate = true;
+    res.annotations.host_embedding_update_infos.push_back(info);
+
+    const std::string handle = inst->name() + inst->EmbeddingId();
+    const std::string debug_name = GetDebugName(inst);
+    const std::size_t width = grads.dim(1);
+
+    poplar::Tensor slots = graph.addVariable(
+        poplar::UNSIGNED_INT, {num_indices + 1}, debug_name + "/slots");
+    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph, slots);
+
+    auto index_buffer = graph.addDeviceToHostFIFO(
+        handle + "_indices", indices.elementType(), indices.numElements());
+    auto slots_fifo = graph.addHostToDeviceFIFO(
+        handle + "_dedup_slots", poplar::UNSIGNED_INT, num_indices + 1);
+    auto unique_grads_fifo = graph.addDeviceToHostFIFO(
+        handle + "_dedup_grads", grads.elementType(), max_unique * width);
+    auto grad_fifo = graph.addDeviceToHostFIFO(
+        handle + "_grads", grads.elementType(), grads.numElements());
+
+    // Send the indices to the host.
+    seq.add(poplar::program::Copy(indices, index_buffer));
+
+    // Sync to avoid any stream merging due to host-side data dependecy.
+    seq.add(poplar::program::Sync(poplar::SyncType::INTERNAL));
+
+    // Read the position of each index in the distinct indices from the host.
+    seq.add(poplar::program::Copy(slots_fifo, slots));
+
+    // When there were too many distinct indices all the gradients are sent.
+    poplar::program::Sequence all_grads_seq;
+    all_grads_seq.add(poplar::program::Copy(grads, grad_fifo));
+
+    // Otherwise the gradients of each distinct index are summed and only the
+    // sums are sent.
+    poplar::program::Sequence unique_grads_seq;
+    poplar::Tensor unique_grads = popops::createSliceableTensor(
+        graph, grads.elementType(), {max_unique, width}, {0}, {1},
+        popops::SlicePlan{}, {}, debug_name + "/unique_grads");
+    popops::zero(graph, unique_grads, unique_grads_seq,
+                 debug_name + "/zero_unique_grads");
+    poplar::Tensor scale = graph.addConstant(grads.elementType(), {}, 1.0f,
+                                             debug_name + "/scale");
+    graph.setTileMapping(scale, 0);
+    popops::multiUpdateAdd(graph, unique_grads, grads.expand({1}),
+                           slots.slice(0, num_indices).expand({1}), scale, {0},
+                           {1}, unique_grads_seq, popops::SlicePlan{}, {},
+                           debug_name + "/sum_grads");
+    unique_grads_seq.add(
+        poplar::program::Copy(unique_grads, unique_grads_fifo));
+
+    poplar::Tensor overflow = slots[num_indices];
+    seq.add(poplar::program::If(overflow, all_grads_seq, unique_grads_seq));
+
+    return seq;
+  }
+
   // Single replica remote buffer implementation.
   StatusOr<poplar::program::Program> RemoteBufferImpl(
       poplar::Graph& graph, poplar::RemoteBuffer& remote_buffer,
@@ -608,10 +798,10 @@ class HostEmbeddingUpdateOp : public PoplarOpDef {
 
     const HloHostEmbeddingUpdateInstruction* host_embedding_inst =
         Cast<HloHostEmbeddingUpdateInstruction>(inst);
-    if (UseSyntheticData()) {
+    if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding)) {
       return SyntheticImpl(seq);
-    } else if (res.enable_experimental_remote_buffer_embedding) {
-      VLOG(1) << "Using experimental remote buffer embedding update";
+    } else if (res.enable_remote_buffer_embedding) {
+      VLOG(1) << "Using remote buffer embedding update";
 
       TF_ASSIGN_OR_RETURN(
           poplar::RemoteBuffer rbuffer,
@@ -642,6 +832,10 @@ class HostEmbeddingUpdateOp : public PoplarOpDef {
                               indices[0].reinterpret(poplar::UNSIGNED_INT), seq,
                               res, host_embedding_inst, output_shape,
                               tensor_map);
+    } else if (res.host_embedding_cache_options.deduplicate()) {
+      return DeduplicatedCallbackImpl(
+          graph, grads[0], indices[0].reinterpret(poplar::UNSIGNED_INT), seq,
+          res, host_embedding_inst, output_shape, tensor_map);
     } else {
       return CallbackImpl(graph, grads[0],
                           indices[0].reinterpret(poplar::UNSIGNED_INT), seq,
@@ -672,7 +866,8 @@ class HostEmbeddingNotifyOp : public PoplarOpDef {
 
     // For synthetic data or remote buffers, there's no communication with the
     // host.
-    if (UseSyntheticData() || res.enable_experimental_remote_buffer_embedding) {
+    if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding) ||
+        res.enable_remote_buffer_embedding) {
       return seq;
     }
 
@@ -0,0 +1,223 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/multi_head_attention.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <poplar/Graph.hpp>
+#include <poplar/Tensor.hpp>
+#include <poplin/MatMul.hpp>
+#include <popnn/NonLinearity.hpp>
+#include <popops/ElementWise.hpp>
+#include <popops/Expr.hpp>
+
+#include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
+#include "tensorflow/compiler/plugin/poplar/driver/ops/custom_ops/poplar_ops.h"
+#include "tensorflow/compiler/plugin/poplar/driver/ops/ops.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/mapping_helper.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace pe = popops::expr;
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// The value added to the scores of the masked keys, small enough for their
+// probabilities to be zero while still being representable in half precision.
+constexpr float kMaskedScore = -10000.0f;
+
+// Collapses a [batch, num_heads, sequence, head_size] tensor into
+// [batch * num_heads, sequence, head_size] groups.
+poplar::Tensor ToGroups(const poplar::Tensor& t) {
+  return t.reshape({t.dim(0) * t.dim(1), t.dim(2), t.dim(3)});
+}
+
+poplar::Tensor Transpose(const poplar::Tensor& t) {
+  return t.dimShuffle({0, 2, 1});
+}
+
+poplar::Tensor MatMul(poplar::Graph& graph, CompilerResources& res,
+                      const poplar::Tensor& lhs, const poplar::Tensor& rhs,
+                      poplar::program::Sequence& seq,
+                      const std::string& debug_name) {
+  return poplin::matMulGrouped(graph, lhs, rhs, seq, lhs.elementType(),
+                               debug_name, res.default_matmul_options,
+                               &res.dot_cache);
+}
+
+// Returns the queries multiplied by the reciprocal square root of the head
+// size, which scales the scores with fewer elements than scaling the scores
+// themselves.
+poplar::Tensor ScaleQueries(poplar::Graph& graph, const poplar::Tensor& query,
+                            poplar::program::Sequence& seq,
+                            const std::string& debug_name) {
+  const float scale = 1.0f / std::sqrt(static_cast<float>(query.dim(2)));
+  return popops::map(graph, pe::Mul(pe::_1, pe::Const(scale)), {query}, seq,
+                     debug_name + "/ScaleQueries");
+}
+
+// Computes the [groups, query sequence, key sequence] attention probabilities.
+poplar::Tensor AttentionProbabilities(poplar::Graph& graph,
+                                      CompilerResources& res,
+                                      const poplar::Tensor& scaled_query,
+                                      const poplar::Tensor& key, bool causal,
+                                      poplar::program::Sequence& seq,
+                                      const std::string& debug_name) {
+  poplar::Tensor scores = MatMul(graph, res, scaled_query, Transpose(key), seq,
+                                 debug_name + "/Scores");
+  const std::size_t groups = scores.dim(0);
+  const std::size_t query_len = scores.dim(1);
+  const std::size_t key_len = scores.dim(2);
+
+  if (causal) {
+    // Each query only attends to the keys up to its own position.
+    std::vector<float> mask_values(query_len * key_len, 0.0f);
+    for (std::size_t i = 0; i != query_len; ++i) {
+      for (std::size_t j = i + 1; j < key_len; ++j) {
+        mask_values[i * key_len + j] = kMaskedScore;
+      }
+    }
+    poplar::Tensor mask = graph.addConstant<float>(
+        scores.elementType(), {query_len, key_len}, mask_values,
+        debug_name + "/CausalMask");
+    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph, mask);
+    popops::addInPlace(graph, scores, mask.expand({0}).broadcast(groups, 0),
+                       seq, debug_name + "/ApplyMask");
+  }
+
+  // Softmax over the keys of each query.
+  poplar::Tensor probs =
+      popnn::nonLinearity(graph, popnn::NonLinearityType::SOFTMAX_STABLE,
+                          scores.reshape({groups * query_len, key_len}), seq,
+                          debug_name + "/Softmax");
+  return probs.reshape(scores.shape());
+}
+
+class MultiHeadAttentionOp : public PoplarOpDef {
+  StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
+                                             CompilerResources& res,
+                                             const HloInstruction* inst,
+                                             const xla::Shape& output_shape,
+                                             TensorMap& tensor_map) override {
+    poplar::program::Sequence seq;
+    const std::string debug_name = GetDebugName(inst);
+    const auto* attention_inst =
+        Cast<HloMultiHeadAttentionInstruction>(inst);
+
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor query,
+        FindInstructionInput(tensor_map, res, inst, 0, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor key,
+        FindInstructionInput(tensor_map, res, inst, 1, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor value,
+        FindInstructionInput(tensor_map, res, inst, 2, seq, false));
+    poplar::Tensor scaled_query =
+        ScaleQueries(graph, ToGroups(query), seq, debug_name);
+    poplar::Tensor probs = AttentionProbabilities(
+        graph, res, scaled_query, ToGroups(key), attention_inst->Causal(), seq,
+        debug_name);
+    poplar::Tensor output =
+        MatMul(graph, res, probs, ToGroups(value), seq, debug_name + "/Output");
+
+    output = output.reshape(PoplarShapeFromXlaShape(output_shape));
+    TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 0, output));
+    return seq;
+  }
+};
+REGISTER_POPLAR_OP(MultiHeadAttention, MultiHeadAttentionOp);
+
+class MultiHeadAttentionGradOp : public PoplarOpDef {
+  StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
+                                             CompilerResources& res,
+                                             const HloInstruction* inst,
+                                             const xla::Shape& output_shape,
+                                             TensorMap& tensor_map) override {
+    poplar::program::Sequence seq;
+    const std::string debug_name = GetDebugName(inst);
+    const auto* attention_inst =
+        Cast<HloMultiHeadAttentionGradInstruction>(inst);
+
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor query,
+        FindInstructionInput(tensor_map, res, inst, 0, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor key,
+        FindInstructionInput(tensor_map, res, inst, 1, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor value,
+        FindInstructionInput(tensor_map, res, inst, 2, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor grad,
+        FindInstructionInput(tensor_map, res, inst, 3, seq, false));
+    poplar::Tensor q = ToGroups(query);
+    poplar::Tensor k = ToGroups(key);
+    poplar::Tensor v = ToGroups(value);
+    poplar::Tensor grad_output = ToGroups(grad);
+
+    // Recompute the probabilities instead of keeping the [query sequence, key
+    // sequence] matrix of every group live between the forward and backward
+    // passes.
+    poplar::Tensor scaled_query = ScaleQueries(graph, q, seq, debug_name);
+    poplar::Tensor probs = AttentionProbabilities(
+        graph, res, scaled_query, k, attention_inst->Causal(), seq, debug_name);
+    const std::size_t groups = probs.dim(0);
+    const std::size_t query_len = probs.dim(1);
+    const std::size_t key_len = probs.dim(2);
+
+    poplar::Tensor grad_value = MatMul(graph, res, Transpose(probs),
+                                       grad_output, seq, debug_name + "/GradV");
+    poplar::Tensor grad_probs = MatMul(graph, res, grad_output, Transpose(v),
+                                       seq, debug_name + "/GradProbs");
+
+    // The masked probabilities are zero, so are their score gradients.
+    poplar::Tensor grad_scores = popnn::nonLinearityInputGradient(
+        graph, popnn::NonLinearityType::SOFTMAX_STABLE,
+        probs.reshape({groups * query_len, key_len}),
+        grad_probs.reshape({groups * query_len, key_len}), seq,
+        debug_name + "/GradSoftmax");
+    grad_scores = grad_scores.reshape(probs.shape());
+
+    poplar::Tensor grad_query = ScaleQueries(
+        graph, MatMul(graph, res, grad_scores, k, seq, debug_name + "/GradQ"),
+        seq, debug_name + "/GradQ");
+    poplar::Tensor grad_key = MatMul(graph, res, Transpose(grad_scores),
+                                     scaled_query, seq, debug_name + "/GradK");
+
+    TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 0,
+                                grad_query.reshape(query.shape())));
+    TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 1,
+                                grad_key.reshape(key.shape())));
+    TF_CHECK_OK(AddOutputTensor(tensor_map, inst, 2,
+                                grad_value.reshape(value.shape())));
+    return seq;
+  }
+};
+REGISTER_POPLAR_OP(MultiHeadAttentionGrad, MultiHeadAttentionGradOp);
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
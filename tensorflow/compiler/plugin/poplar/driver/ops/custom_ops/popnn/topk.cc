@@ -25,13 +25,112 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/errors.h"
 
+#include <algorithm>
 #include <popnn/Loss.hpp>
+#include <popops/DynamicSlice.hpp>
+#include <popops/ElementWise.hpp>
+#include <string>
+#include <vector>
 #include "absl/container/flat_hash_map.h"
 
 namespace xla {
 namespace poplarplugin {
 namespace {
 
+// Rows which are at least this long are split into chunks, and the top k of
+// each chunk is selected before the top k of the row is selected from them.
+// This is much faster than selecting from the whole row when k is small, as
+// the cost of the selection grows faster than the length of the row.
+constexpr std::size_t kMultiStageMinRowLength = 4096;
+constexpr std::size_t kMultiStageMinChunkLength = 1024;
+
+// Returns the top k values of each row of a 2D input, and sets `indices` to
+// their positions in the row.
+poplar::Tensor TopKRows(poplar::Graph& graph, const poplar::Tensor& input,
+                        poplar::Tensor& indices, std::size_t k, bool sorted,
+                        poplar::program::Sequence& seq,
+                        const std::string& debug_name) {
+  const std::size_t num_rows = input.dim(0);
+  const std::size_t row_length = input.dim(1);
+  const std::size_t chunk_length = std::max(kMultiStageMinChunkLength, 4 * k);
+  if (k == 0 || row_length < kMultiStageMinRowLength ||
+      row_length < 2 * chunk_length) {
+    return popnn::topK(graph, input, indices, k, sorted, seq, debug_name);
+  }
+  const std::size_t num_chunks = row_length / chunk_length;
+  const std::size_t chunked_length = num_chunks * chunk_length;
+
+  // Select the top k of every chunk, in any order.
+  poplar::Tensor chunk_indices;
+  poplar::Tensor chunk_values = popnn::topK(
+      graph,
+      input.slice(0, chunked_length, 1)
+          .reshape({num_rows * num_chunks, chunk_length}),
+      chunk_indices, k, false, seq, debug_name + "/Chunks");
+
+  // Make the indices relative to the start of the row.
+  std::vector<unsigned> offsets(num_chunks);
+  for (std::size_t i = 0; i != num_chunks; ++i) {
+    offsets[i] = i * chunk_length;
+  }
+  poplar::Tensor chunk_offsets =
+      graph.addConstant(poplar::UNSIGNED_INT, {1, num_chunks, 1}, offsets,
+                        debug_name + "/ChunkOffsets");
+  graph.setTileMapping(chunk_offsets, 0);
+  chunk_indices = chunk_indices.reshape({num_rows, num_chunks, k});
+  popops::addInPlace(graph, chunk_indices,
+                     chunk_offsets.broadcast(num_rows, 0).broadcast(k, 2), seq,
+                     debug_name + "/ChunkIndices");
+
+  std::vector<poplar::Tensor> candidate_values = {
+      chunk_values.reshape({num_rows, num_chunks * k})};
+  std::vector<poplar::Tensor> candidate_indices = {
+      chunk_indices.reshape({num_rows, num_chunks * k})};
+
+  // The end of the row which does not fill a chunk is a candidate as well.
+  const std::size_t remainder = row_length - chunked_length;
+  if (remainder) {
+    std::vector<unsigned> remainder_offsets(remainder);
+    for (std::size_t i = 0; i != remainder; ++i) {
+      remainder_offsets[i] = chunked_length + i;
+    }
+    poplar::Tensor remainder_indices =
+        graph.addConstant(poplar::UNSIGNED_INT, {1, remainder},
+                          remainder_offsets, debug_name + "/RemainderIndices");
+    graph.setTileMapping(remainder_indices, 0);
+    candidate_values.push_back(input.slice(chunked_length, row_length, 1));
+    candidate_indices.push_back(remainder_indices.broadcast(num_rows, 0));
+  }
+
+  // Select the top k of the candidates, which can take several stages again.
+  poplar::Tensor candidates = poplar::concat(candidate_values, 1);
+  const std::size_t num_candidates = candidates.dim(1);
+  poplar::Tensor selected;
+  poplar::Tensor values =
+      TopKRows(graph, candidates, selected, k, sorted, seq, debug_name);
+
+  // Gather the positions in the row of the selected candidates.
+  std::vector<unsigned> row_offsets(num_rows);
+  for (std::size_t i = 0; i != num_rows; ++i) {
+    row_offsets[i] = i * num_candidates;
+  }
+  poplar::Tensor row_offsets_tensor =
+      graph.addConstant(poplar::UNSIGNED_INT, {num_rows, 1}, row_offsets,
+                        debug_name + "/RowOffsets");
+  graph.setTileMapping(row_offsets_tensor, 0);
+  poplar::Tensor flat_selected =
+      popops::add(graph, selected, row_offsets_tensor.broadcast(k, 1), seq,
+                  debug_name + "/FlatIndices");
+  indices = popops::multiSlice(
+      graph,
+      poplar::concat(candidate_indices, 1)
+          .reshape({num_rows * num_candidates, 1}),
+      flat_selected.reshape({num_rows * k, 1}), {0}, {1}, seq,
+      popops::SlicePlan{}, {}, debug_name + "/Indices");
+  indices = indices.reshape({num_rows, k});
+  return values;
+}
+
 class TopKOp : public PoplarOpDef {
   StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
                                              CompilerResources& res,
@@ -65,7 +164,7 @@ class TopKOp : public PoplarOpDef {
     poplar::Tensor index_output;
 
     poplar::Tensor value_output =
-        popnn::topK(graph, input, index_output, num_k, sorted, seq, "TopK");
+        TopKRows(graph, input, index_output, num_k, sorted, seq, "TopK");
 
     // Reshape the input to be in the original form with the last dimension
     // replaced with K.
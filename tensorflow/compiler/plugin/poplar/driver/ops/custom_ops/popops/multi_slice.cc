@@ -19,15 +19,24 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/core/lib/core/errors.h"
 
+#include <numeric>
 #include <popops/DynamicSlice.hpp>
 #include <popops/ElementWise.hpp>
+#include <popops/Sort.hpp>
 #include <poputil/GraphFunction.hpp>
+#include <poputil/Util.hpp>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace pgf = poputil::graphfn;
+namespace pe = popops::expr;
 
 namespace xla {
 namespace poplarplugin {
@@ -119,6 +128,77 @@ class MultiSliceOp : public PoplarOpDef {
 };
 REGISTER_POPLAR_OP(MultiSlice, MultiSliceOp);
 
+// Sorts the updates by their indices and adds together the updates of each
+// index, so that each row of the operand is updated once rather than the
+// updates of the most frequent rows being serialised on the tiles which own
+// them. All but the first update of each index are given an out of range
+// index, which multiUpdateAdd ignores.
+std::pair<poplar::Tensor, poplar::Tensor> DeduplicateUpdates(
+    poplar::Graph& graph, const poplar::Tensor& indices,
+    const poplar::Tensor& updates, std::size_t num_rows,
+    poplar::program::Sequence& prog, const std::string& debug_prefix) {
+  const std::size_t num_updates = updates.dim(0);
+
+  poplar::Tensor keys = poputil::duplicate(
+      graph, indices.flatten().reinterpret(poplar::UNSIGNED_INT), prog,
+      debug_prefix + "/SortedIndices");
+  poplar::Tensor permutation =
+      graph.clone(keys, debug_prefix + "/Permutation");
+  std::vector<unsigned> iota(num_updates);
+  std::iota(iota.begin(), iota.end(), 0U);
+  poplar::Tensor iota_const = graph.addConstant<unsigned>(
+      poplar::UNSIGNED_INT, {num_updates}, iota, debug_prefix + "/Iota");
+  graph.setTileMapping(iota_const, graph.getTileMapping(permutation));
+  prog.add(poplar::program::Copy(iota_const, permutation));
+  popops::sortKeyValueInPlace(graph, keys, permutation, 0, prog,
+                              debug_prefix + "/Sort");
+
+  // Gather the updates in the order of their sorted indices.
+  const std::vector<std::size_t> flat_shape = {
+      num_updates, updates.numElements() / num_updates};
+  poplar::Tensor sorted =
+      popops::multiSlice(graph, updates.reshape(flat_shape),
+                         permutation.expand({1}), {0}, {1}, prog,
+                         popops::SlicePlan(), poplar::OptionFlags(),
+                         debug_prefix + "/SortedUpdates")
+          .reshape(flat_shape);
+
+  // Segmented suffix sum, after which the first update of each index is the
+  // sum of all the updates of that index. As the indices are sorted, the
+  // updates `shift` apart have the same index only if all the updates between
+  // them do.
+  for (std::size_t shift = 1; shift < num_updates; shift *= 2) {
+    const std::size_t n = num_updates - shift;
+    poplar::Tensor same =
+        popops::eq(graph, keys.slice(0, n), keys.slice(shift, num_updates),
+                   prog, debug_prefix + "/SameIndex");
+    same = same.expand({1}).broadcast(flat_shape[1], 1);
+    poplar::Tensor head = popops::map(
+        graph,
+        pe::Add(pe::_1,
+                pe::Mul(pe::_2, pe::Cast(pe::_3, sorted.elementType()))),
+        {sorted.slice(0, n), sorted.slice(shift, num_updates), same}, prog,
+        debug_prefix + "/SegmentSum");
+    sorted = poplar::concat(head, sorted.slice(n, num_updates));
+  }
+
+  // Only keep the first update of each index.
+  poplar::Tensor repeated =
+      popops::eq(graph, keys.slice(1, num_updates),
+                 keys.slice(0, num_updates - 1), prog,
+                 debug_prefix + "/RepeatedIndex");
+  poplar::Tensor repeated_indices = popops::map(
+      graph,
+      pe::Select(pe::Const(static_cast<unsigned>(num_rows)), pe::_1, pe::_2),
+      {keys.slice(1, num_updates), repeated}, prog,
+      debug_prefix + "/UniqueIndices");
+  poplar::Tensor unique_indices =
+      poplar::concat(keys.slice(0, 1), repeated_indices)
+          .reshape(indices.shape())
+          .reinterpret(indices.elementType());
+  return {unique_indices, sorted.reshape(updates.shape())};
+}
+
 enum class UpdateMode { Replace, Accumulate };
 Status MultiUpdateInternal(
     poplar::Graph& graph, const popops::SlicePlan& plan, poplar::Tensor operand,
@@ -138,6 +218,17 @@ Status MultiUpdateInternal(
   const std::string& debug_prefix = GetDebugName(multi_update);
 
   const std::size_t num_updates = updates.shape()[0];
+
+  poplar::Tensor indices_to_apply = indices;
+  poplar::Tensor updates_to_apply = updates;
+  const float deduplication_ratio =
+      PoplarXlaFlags::Get().multi_update_deduplication_ratio;
+  if (mode == UpdateMode::Accumulate && deduplication_ratio > 0.0f &&
+      num_updates > 1 && num_updates >= deduplication_ratio * operand.dim(0)) {
+    std::tie(indices_to_apply, updates_to_apply) =
+        DeduplicateUpdates(graph, indices, updates, operand.dim(0), prog,
+                           debug_prefix + "/Deduplicate");
+  }
   const uint32 serialization_factor = multi_update->GetSerializationFactor();
 
   if (serialization_factor == 0 || serialization_factor > num_updates) {
@@ -162,7 +253,7 @@ Status MultiUpdateInternal(
   };
 
   if (serialization_factor == 1) {
-    update_fn(indices, updates, prog);
+    update_fn(indices_to_apply, updates_to_apply, prog);
   } else {
     // Do the updates serially and reuse the code to do so.
     const std::size_t slice_size = num_updates / serialization_factor;
@@ -198,9 +289,9 @@ Status MultiUpdateInternal(
       // Slice the indices and updates.
       const std::size_t slice_begin = i * slice_size;
       poplar::Tensor slice_indices =
-          indices.slice(slice_begin, slice_begin + slice_size);
+          indices_to_apply.slice(slice_begin, slice_begin + slice_size);
       poplar::Tensor slice_updates =
-          updates.slice(slice_begin, slice_begin + slice_size);
+          updates_to_apply.slice(slice_begin, slice_begin + slice_size);
       // Reuse the multi update function.
       std::vector<poplar::Tensor> args = {slice_indices, slice_updates};
       f(args, prog);
@@ -208,8 +299,10 @@ Status MultiUpdateInternal(
     if (slice_size * serialization_factor != num_updates) {
       const std::size_t slice_begin = serialization_factor * slice_size;
       // Do the remainder.
-      poplar::Tensor slice_indices = indices.slice(slice_begin, num_updates);
-      poplar::Tensor slice_updates = updates.slice(slice_begin, num_updates);
+      poplar::Tensor slice_indices =
+          indices_to_apply.slice(slice_begin, num_updates);
+      poplar::Tensor slice_updates =
+          updates_to_apply.slice(slice_begin, num_updates);
       update_fn(slice_indices, slice_updates, prog);
     }
   }
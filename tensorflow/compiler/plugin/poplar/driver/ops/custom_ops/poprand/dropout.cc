@@ -15,6 +15,8 @@ limitations under the License.
 
 #include <poputil/Util.hpp>
 #include <random>
+#include <string>
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
@@ -36,6 +38,23 @@ namespace poplarplugin {
 namespace {
 namespace pe = popops::expr;
 
+// Get the tensor which sets the layout of the mask of a dropout with the given
+// shape, creating it the first time it is needed in `graph`.
+StatusOr<poplar::Tensor> GetReference(poplar::Graph& graph,
+                                      CompilerResources& res,
+                                      const std::string& debug_name,
+                                      const Shape& shape) {
+  auto key = std::make_pair(&graph, shape);
+  auto itr = res.dropout_references.find(key);
+  if (itr != res.dropout_references.end()) {
+    return itr->second;
+  }
+  TF_ASSIGN_OR_RETURN(poplar::Tensor reference,
+                      AddPlainTensor(graph, debug_name, shape, res, false));
+  res.dropout_references.emplace(key, reference);
+  return reference;
+}
+
 class DropoutOp : public PoplarOpDef {
   StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
                                              CompilerResources& res,
@@ -71,19 +90,19 @@ class DropoutOp : public PoplarOpDef {
       const Shape ns_ref_shape =
           ShapeUtil::MakeShape(inst->operand(0)->shape().element_type(),
                                dropout_instruction->NoiseShape());
-      TF_ASSIGN_OR_RETURN(poplar::Tensor reference,
-                          AddPlainTensor(graph, debug_name + "/ShapedReference",
-                                         ns_ref_shape, res, false));
+      TF_ASSIGN_OR_RETURN(
+          poplar::Tensor reference,
+          GetReference(graph, res, debug_name + "/ShapedReference",
+                       ns_ref_shape));
 
       output = poprand::shapedDropout(graph, &seed_unsigned, 1U, input,
                                       reference, rate, scale, seq, debug_name);
     } else {
-      // Create an empty tensor for the dropout. This is internal to the poprand
+      // Get an empty tensor for the dropout. This is internal to the poprand
       // implementation but is exposed anyway so we need to provide it.
-      TF_ASSIGN_OR_RETURN(
-          poplar::Tensor reference,
-          AddPlainTensor(graph, debug_name + "/Reference",
-                         inst->operand(0)->shape(), res, false));
+      TF_ASSIGN_OR_RETURN(poplar::Tensor reference,
+                          GetReference(graph, res, debug_name + "/Reference",
+                                       inst->operand(0)->shape()));
 
       // Perform the actual dropout by calling into the poprand function.
       output = poprand::dropout(graph, &seed_unsigned, 1U, input, reference,
@@ -0,0 +1,168 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/block_sparse_matmul.h"
+
+#include <string>
+#include <vector>
+
+#include <poplar/Graph.hpp>
+#include <poplar/Tensor.hpp>
+#include <popsparse/experimental/BlockSparseMatMul.hpp>
+
+#include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
+#include "tensorflow/compiler/plugin/poplar/driver/ops/custom_ops/poplar_ops.h"
+#include "tensorflow/compiler/plugin/poplar/driver/ops/ops.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+using popsparse::experimental::BSMatMulParams;
+
+class BlockSparseMatMulOp : public PoplarOpDef {
+  StatusOr<poplar::Tensor> Allocator(poplar::Graph& graph,
+                                     CompilerResources& res,
+                                     const std::string& name,
+                                     const TensorTarget& tensor_target,
+                                     const TensorMap& tensor_map) override {
+    const HloInstruction* inst = tensor_target.tgt;
+    const int64 input_index = tensor_target.input_index;
+    TF_ASSIGN_OR_RETURN(std::vector<const BSMatMulParams*> plans,
+                        GetBlockSparsePlans(res, inst));
+    const Shape& shape = inst->operand(input_index)->shape();
+    switch (input_index) {
+      case 0: {
+        poplar::Tensor lhs = popsparse::experimental::createBSMatMulInputLHS(
+            graph, *plans[0], GetDebugName(inst) + "/lhs");
+        return lhs.reshape(PoplarShapeFromXlaShape(shape));
+      }
+      case 1: {
+        poplar::Tensor rhs = popsparse::experimental::createBSMatMulInputRHS(
+            graph, *plans[0], GetDebugName(inst) + "/rhs");
+        return rhs.reshape(PoplarShapeFromXlaShape(shape));
+      }
+      default: {
+        return FailedPrecondition(
+            "Invalid allocation index %d for instruction ", input_index,
+            inst->ToString());
+      }
+    }
+  }
+
+  StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
+                                             CompilerResources& res,
+                                             const HloInstruction* inst,
+                                             const xla::Shape& output_shape,
+                                             TensorMap& tensor_map) override {
+    poplar::program::Sequence seq;
+    TF_ASSIGN_OR_RETURN(std::vector<const BSMatMulParams*> plans,
+                        GetBlockSparsePlans(res, inst));
+
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor lhs,
+        FindInstructionInput(tensor_map, res, inst, 0, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor rhs,
+        FindInstructionInput(tensor_map, res, inst, 1, seq, false));
+
+    poplar::Tensor output = popsparse::experimental::bsMatMul(
+        graph, *plans[0], seq, lhs, rhs, {}, GetDebugName(inst));
+
+    TF_CHECK_OK(AddOutputTensor(
+        tensor_map, inst, 0,
+        output.reshape(PoplarShapeFromXlaShape(output_shape))));
+    return seq;
+  }
+};
+REGISTER_POPLAR_OP(BlockSparseMatMul, BlockSparseMatMulOp);
+
+class BlockSparseMatMulGradOp : public PoplarOpDef {
+  StatusOr<poplar::Tensor> Allocator(poplar::Graph& graph,
+                                     CompilerResources& res,
+                                     const std::string& name,
+                                     const TensorTarget& tensor_target,
+                                     const TensorMap& tensor_map) override {
+    const HloInstruction* inst = tensor_target.tgt;
+    const int64 input_index = tensor_target.input_index;
+    TF_ASSIGN_OR_RETURN(std::vector<const BSMatMulParams*> plans,
+                        GetBlockSparsePlans(res, inst));
+    switch (input_index) {
+      case 2: {
+        // The gradient is the dense side of the left hand side gradient.
+        poplar::Tensor grad = popsparse::experimental::createBSMatMulInputLHS(
+            graph, *plans[0], GetDebugName(inst) + "/grad");
+        return grad.reshape(
+            PoplarShapeFromXlaShape(inst->operand(input_index)->shape()));
+      }
+      default: {
+        return FailedPrecondition(
+            "Invalid allocation index %d for instruction ", input_index,
+            inst->ToString());
+      }
+    }
+  }
+
+  StatusOr<poplar::program::Program> Creator(poplar::Graph& graph,
+                                             CompilerResources& res,
+                                             const HloInstruction* inst,
+                                             const xla::Shape& output_shape,
+                                             TensorMap& tensor_map) override {
+    poplar::program::Sequence seq;
+    const std::string debug_name = GetDebugName(inst);
+    TF_ASSIGN_OR_RETURN(std::vector<const BSMatMulParams*> plans,
+                        GetBlockSparsePlans(res, inst));
+
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor lhs,
+        FindInstructionInput(tensor_map, res, inst, 0, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor rhs,
+        FindInstructionInput(tensor_map, res, inst, 1, seq, false));
+    TF_ASSIGN_OR_RETURN(
+        poplar::Tensor grad,
+        FindInstructionInput(tensor_map, res, inst, 2, seq, false));
+
+    // The gradient of the left hand side is grad * rhs^T, with the sparse right
+    // hand side transposed by the plan.
+    poplar::Tensor grad_lhs = popsparse::experimental::bsMatMul(
+        graph, *plans[0], seq, grad, rhs, {}, debug_name + "/GradLhs");
+
+    // The gradient of the right hand side is lhs^T * grad, only computed for
+    // the non-zero blocks.
+    poplar::Tensor grad_rhs = popsparse::experimental::bsMatMul(
+        graph, *plans[1], seq, lhs.transpose(), grad, {},
+        debug_name + "/GradRhs");
+
+    TF_CHECK_OK(
+        AddOutputTensor(tensor_map, inst, 0, grad_lhs.reshape(lhs.shape())));
+    TF_CHECK_OK(
+        AddOutputTensor(tensor_map, inst, 1, grad_rhs.reshape(rhs.shape())));
+    return seq;
+  }
+};
+REGISTER_POPLAR_OP(BlockSparseMatMulGrad, BlockSparseMatMulGradOp);
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -63,7 +63,7 @@ class RemoteParameterLoadOp : public PoplarOpDef {
                           AddTensor(shard_graph, TensorLocation{inst, i}, shape,
                                     res, tensor_map));
 
-      if (!UseSyntheticData()) {
+      if (!UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
         TensorOrRemoteBufferVector inputs =
             FindInstructionInputs(tensor_map, res, inst, i, seq, true);
 
@@ -78,7 +78,7 @@ class RemoteParameterLoadOp : public PoplarOpDef {
         poplar::RemoteBuffer remote_buffer = inputs[0].AsRemoteBuffer();
 
         seq.add(poplar::program::Copy(remote_buffer, tensor));
-      } else if (UseSyntheticData() && UseSyntheticDataInitializer()) {
+      } else if (UseSyntheticDataInitializer()) {
         // Initialize the tensor to a constant value.
         auto& initializer = DataInitializer::GetSyntheticDataInitializer();
         TF_ASSIGN_OR_RETURN(auto literal, initializer.GetData(shape));
@@ -135,7 +135,7 @@ class RemoteParameterStoreOp : public PoplarOpDef {
 
       poplar::RemoteBuffer remote_buffer = outputs[i][0].AsRemoteBuffer();
 
-      if (!UseSyntheticData()) {
+      if (!UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
         TF_ASSIGN_OR_RETURN(poplar::Tensor tensor,
                             FindInstructionInput(tensor_map, res, inst,
                                                  outputs.size() + i, seq));
@@ -162,7 +162,7 @@ class BufferLoadSliceOp : public PoplarOpDef {
                         AddTensor(graph, TensorLocation{inst, 0}, output_shape,
                                   res, tensor_map));
 
-    if (!UseSyntheticData()) {
+    if (!UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
       // Get the remote buffer input.
       TensorOrRemoteBufferVector inputs =
           FindInstructionInputs(tensor_map, res, inst, 0, seq);
@@ -173,7 +173,7 @@ class BufferLoadSliceOp : public PoplarOpDef {
                           FindInstructionInput(tensor_map, res, inst, 1, seq));
 
       seq.add(poplar::program::Copy(input, tensor, offset));
-    } else if (UseSyntheticData() && UseSyntheticDataInitializer()) {
+    } else if (UseSyntheticDataInitializer()) {
       // Initialize the tensor to a constant value.
       auto& initializer = DataInitializer::GetSyntheticDataInitializer();
       TF_ASSIGN_OR_RETURN(auto literal, initializer.GetData(output_shape));
@@ -201,7 +201,7 @@ class BufferStoreSliceOp : public PoplarOpDef {
     CHECK_EQ(outputs[0].size(), 1);
     poplar::RemoteBuffer remote_buffer = outputs[0][0].AsRemoteBuffer();
 
-    if (!UseSyntheticData()) {
+    if (!UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
       TF_ASSIGN_OR_RETURN(poplar::Tensor value,
                           FindInstructionInput(tensor_map, res, inst, 1, seq));
       TF_ASSIGN_OR_RETURN(poplar::Tensor offset,
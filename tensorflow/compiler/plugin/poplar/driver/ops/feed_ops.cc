@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <poplar/Graph.hpp>
+#include <popops/Cast.hpp>
 #include <popops/DynamicSlice.hpp>
 #include <popops/ElementWise.hpp>
 
@@ -62,10 +63,12 @@ StatusOr<poplar::program::Program> CreateInfeed(CompilerResources& res,
 
   // A functor wrapper to either use synthetic data or copy from the host,
   // depending on the global synthetic flags.
+  const bool synthetic = UseSyntheticDataForFeed(SyntheticDataCategory::Infeed,
+                                                 infeed_config.feed_id());
   auto init_synthetic_or_copy = [&](poplar::program::Sequence& seq,
                                     const Shape& data_shape,
                                     poplar::Tensor& tensor_to_update) {
-    if (!UseSyntheticData()) {
+    if (!synthetic) {
       const std::string handle =
           GetInfeedCopyHandle(infeed->name(), tuple_index);
       TF_RETURN_IF_ERROR(res.streams_indices.InitializeFeedStream(
@@ -93,7 +96,7 @@ StatusOr<poplar::program::Program> CreateInfeed(CompilerResources& res,
       } else {
         seq.add(poplar::program::Copy(fifo, tensor_to_update, false));
       }
-    } else if (UseSyntheticData() && UseSyntheticDataInitializer()) {
+    } else if (UseSyntheticDataInitializer()) {
       // Initialize the tensor with a synthetic initalizer.
       auto& initializer = DataInitializer::GetSyntheticDataInitializer();
       TF_ASSIGN_OR_RETURN(auto literal, initializer.GetData(data_shape));
@@ -195,6 +198,34 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
                                                  const HloInstruction* inst,
                                                  TensorMap& tensor_map) {
   poplar::program::Sequence seq;
+  TensorVector input_tensors;
+  PoplarFeedConfig outfeed_config;
+  outfeed_config.ParseFromString(
+      Cast<HloOutfeedInstruction>(inst)->outfeed_config());
+  if (!UseSyntheticDataForFeed(SyntheticDataCategory::Outfeed,
+                               outfeed_config.feed_id())) {
+    const Shape& shape = inst->operand(0)->shape();
+    if (ShapeUtil::IsNestedTuple(shape)) {
+      return InvalidArgument(
+          "Nested tuple shapes are not supported for outfeed");
+    }
+
+    const bool expand_aliasing = true;
+    TF_ASSIGN_OR_RETURN(input_tensors,
+                        FindInstructionInputTensors(tensor_map, res, inst, 0,
+                                                    seq, expand_aliasing));
+  }
+
+  TF_ASSIGN_OR_RETURN(poplar::program::Program copies,
+                      CreateOutfeed(res, inst, input_tensors));
+  seq.add(copies);
+  return seq;
+}
+
+StatusOr<poplar::program::Program> CreateOutfeed(
+    CompilerResources& res, const HloInstruction* inst,
+    const TensorVector& input_tensors) {
+  poplar::program::Sequence seq;
   poplar::Graph& graph = GetGraph(res, inst);
 
   const HloOutfeedInstruction* outfeed = Cast<HloOutfeedInstruction>(inst);
@@ -224,44 +255,57 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
                 outfeed->operands()[0]->shape());
   res.annotations.outfeed_infos.push_back(info);
 
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataForFeed(SyntheticDataCategory::Outfeed,
+                              outfeed_config.feed_id())) {
     return seq;
   }
 
-  HloInstruction* operand = outfeed->operands()[0];
-  const Shape& shape = operand->shape();
-  if (ShapeUtil::IsNestedTuple(shape)) {
-    return InvalidArgument("Nested tuple shapes are not supported for outfeed");
-  }
-
-  const bool expand_aliasing = true;
-  TF_ASSIGN_OR_RETURN(TensorVector input_tensors,
-                      FindInstructionInputTensors(tensor_map, res, inst, 0, seq,
-                                                  expand_aliasing));
+  const PoplarFeedConfig::Reduction reduction = outfeed_config.reduction();
+  // Returns the tensor which is sent to the host, cast to fp16 if requested.
+  auto to_transfer = [&](poplar::program::Sequence& transfer_seq,
+                         const poplar::Tensor& tensor, unsigned index) {
+    if (outfeed_config.transfer_as_fp16() &&
+        tensor.elementType() == poplar::FLOAT) {
+      return popops::cast(
+          graph, tensor, poplar::HALF, transfer_seq,
+          GetDebugName(inst) + "/OutfeedCast/" + std::to_string(index));
+    }
+    return tensor;
+  };
 
   for (unsigned i = 0; i < input_tensors.size(); ++i) {
-    poplar::Tensor& in = input_tensors[i];
+    const poplar::Tensor& in = input_tensors[i];
+
+    if (reduction == PoplarFeedConfig::Mean &&
+        in.elementType() != poplar::FLOAT &&
+        in.elementType() != poplar::HALF) {
+      return InvalidArgument(
+          "The mean outfeed reduction is only supported for floating point "
+          "tensors, but tensor %d of %s is not.",
+          i, inst->name());
+    }
 
     if (io_batch_size == 1) {
       // Simply copy to the stream
       const std::string handle = GetOutfeedCopyHandle(inst->name(), i);
       TF_RETURN_IF_ERROR(res.streams_indices.InitializeFeedStream(
           info.config.feed_id(), i, handle, seq, inst));
+      poplar::Tensor out = to_transfer(seq, in, i);
       auto fifo = graph.addDeviceToHostFIFO(
-          GetOutfeedCopyHandle(inst->name(), i), in.elementType(),
-          in.numElements(), res.streams_indices.GraphFeedOptions(handle));
+          GetOutfeedCopyHandle(inst->name(), i), out.elementType(),
+          out.numElements(), res.streams_indices.GraphFeedOptions(handle));
       if (res.use_verified_transfers) {
         TF_ASSIGN_OR_RETURN(poplar::Tensor index,
                             res.streams_indices.IndexTensor(handle, inst, seq));
 
-        seq.add(poplar::program::Copy(in, fifo, index, false,
+        seq.add(poplar::program::Copy(out, fifo, index, false,
                                       res.streams_indices.CopyOptions()));
         // Increment the index by one.
         popops::mapInPlace(graph, pe::Add(pe::_1, pe::Const(1)),
                            {index.slice(0, 1)}, seq,
                            GetDebugName(inst) + "/OutfeedIndexInc");
       } else {
-        seq.add(poplar::program::Copy(in, fifo, false));
+        seq.add(poplar::program::Copy(out, fifo, false));
       }
     } else {
       // Batch multiple writes, and then write as a block.
@@ -278,25 +322,6 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
       std::vector<size_t> slice_shape =
           is_scalar ? std::vector<size_t>({1}) : in.shape();
 
-      std::vector<poplar::Tensor> cloned_tensors(io_batch_size);
-      for (size_t i = 0; i < io_batch_size; ++i) {
-        if (res.always_rearrange_copies_on_host) {
-          // When rearranging on the host it is better to have the slices of the
-          // buffer laid out in the same form as the 'in' tensor so that there
-          // is no cost of rearrangement.
-          cloned_tensors[i] = graph.clone(in).reshape(slice_shape);
-        } else {
-          // When the data is rearranged on the device, it is beter to have the
-          // slices arranged in the standard order of the host buffer, and then
-          // to have the rearragement done only once, during the dynamicUpdate.
-          cloned_tensors[i] =
-              graph.addVariable(in.elementType(), slice_shape,
-                                poplar::VariableMappingMethod::LINEAR);
-        }
-      }
-      poplar::Tensor batched =
-          poplar::concat(cloned_tensors).reshape(buffer_shape);
-
       //  A counter for counting slots
       poplar::Tensor counter = graph.addVariable(
           poplar::UNSIGNED_INT, {},
@@ -306,10 +331,56 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
                                        counter);
       AddZeroTensorToPreamble(res, counter);
 
-      // Use dynamic slice update to put the slices into the buffer
-      popops::dynamicUpdate(graph, batched, in.expand({0}),
-                            counter.reshape({1}), {0}, {1}, seq,
-                            GetDebugName(inst) + "/Slice" + std::to_string(i));
+      // The tensor which is copied to the host once the batch is complete.
+      poplar::Tensor batched;
+      if (reduction == PoplarFeedConfig::NoReduction) {
+        std::vector<poplar::Tensor> cloned_tensors(io_batch_size);
+        for (size_t i = 0; i < io_batch_size; ++i) {
+          if (res.always_rearrange_copies_on_host) {
+            // When rearranging on the host it is better to have the slices of
+            // the buffer laid out in the same form as the 'in' tensor so that
+            // there is no cost of rearrangement.
+            cloned_tensors[i] = graph.clone(in).reshape(slice_shape);
+          } else {
+            // When the data is rearranged on the device, it is beter to have
+            // the slices arranged in the standard order of the host buffer,
+            // and then to have the rearragement done only once, during the
+            // dynamicUpdate.
+            cloned_tensors[i] =
+                graph.addVariable(in.elementType(), slice_shape,
+                                  poplar::VariableMappingMethod::LINEAR);
+          }
+        }
+        batched = poplar::concat(cloned_tensors).reshape(buffer_shape);
+
+        // Use dynamic slice update to put the slices into the buffer
+        popops::dynamicUpdate(
+            graph, batched, in.expand({0}), counter.reshape({1}), {0}, {1},
+            seq, GetDebugName(inst) + "/Slice" + std::to_string(i));
+      } else {
+        // Reduce the elements of the batch into an accumulator. The first
+        // element of each batch is copied into it.
+        batched = graph.clone(
+            in, GetDebugName(inst) + "/OutfeedAcc/" + std::to_string(i));
+        poplar::Tensor first_element = popops::map(
+            graph, pe::Equal(pe::_1, pe::Const(0)), {counter}, seq,
+            GetDebugName(inst) + "/OutfeedCtrFirst/" + std::to_string(i));
+
+        poplar::program::Sequence first_body;
+        first_body.add(poplar::program::Copy(in, batched));
+
+        poplar::program::Sequence reduce_body;
+        const std::string reduce_name =
+            GetDebugName(inst) + "/OutfeedReduce/" + std::to_string(i);
+        if (reduction == PoplarFeedConfig::Max) {
+          popops::mapInPlace(graph, pe::Max(pe::_1, pe::_2), {batched, in},
+                             reduce_body, reduce_name);
+        } else {
+          popops::mapInPlace(graph, pe::Add(pe::_1, pe::_2), {batched, in},
+                             reduce_body, reduce_name);
+        }
+        seq.add(poplar::program::If(first_element, first_body, reduce_body));
+      }
 
       // Increment the counter by one.
       popops::mapInPlace(
@@ -321,11 +392,20 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
       // The body for copying to host and zeroing the counter.
       poplar::program::Sequence true_body;
 
+      if (reduction == PoplarFeedConfig::Mean) {
+        popops::mapInPlace(
+            graph,
+            pe::Divide(pe::_1, pe::Const(static_cast<float>(io_batch_size))),
+            {batched}, true_body,
+            GetDebugName(inst) + "/OutfeedMean/" + std::to_string(i));
+      }
+
       // Copy the data to the host
+      poplar::Tensor out = to_transfer(true_body, batched, i);
       auto fifo = graph.addDeviceToHostFIFO(
-          GetOutfeedCopyHandle(outfeed->name(), i), batched.elementType(),
-          batched.numElements());
-      true_body.add(poplar::program::Copy(batched, fifo, false));
+          GetOutfeedCopyHandle(outfeed->name(), i), out.elementType(),
+          out.numElements());
+      true_body.add(poplar::program::Copy(out, fifo, false));
 
       // The NOP body.
       poplar::program::Sequence false_body;
@@ -392,7 +392,8 @@ StatusOr<poplar::program::Program> CreateRepeatOp(CompilerResources& res,
 
   // Create the visitor.
   RepeatLoopVisitor visitor(res, inputs, HloInstructionDescription(inst),
-                            reallocate_input_info, GetDebugName(inst));
+                            reallocate_input_info, GetDebugName(inst),
+                            HasRuntimeRepeatCount(inst));
 
   // Evaluate the loop body in a order.
   TF_RETURN_IF_ERROR(loop_body->AcceptOrdered(&visitor, order));
@@ -301,6 +301,12 @@ StatusOr<poplar::program::Program> CreateOutfeed(CompilerResources& res,
                                                  const HloInstruction* inst,
                                                  TensorMap& tensor_map);
 
+// Create the outfeed copies of the given tensors, which are the flattened
+// operand of the outfeed.
+StatusOr<poplar::program::Program> CreateOutfeed(
+    CompilerResources& res, const HloInstruction* inst,
+    const TensorVector& input_tensors);
+
 StatusOr<poplar::program::Program> CreateInfeed(CompilerResources& res,
                                                 const HloInstruction* inst,
                                                 int64 tuple_index,
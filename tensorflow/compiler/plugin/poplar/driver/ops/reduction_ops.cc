@@ -893,6 +893,18 @@ StatusOr<poplar::program::Program> CreateReplicatedAllReduce(
   poplar::program::Sequence seq;
   poplar::Graph& graph = GetGraph(res, inst);
 
+  // The all-reduce is lowered to a collective across all the replicas, so a
+  // reduction within smaller groups of replicas cannot be lowered.
+  const auto& replica_groups = inst->replica_groups();
+  if (replica_groups.size() > 1 ||
+      (replica_groups.size() == 1 &&
+       replica_groups[0].replica_ids_size() != res.replication_factor)) {
+    return xla::UnimplementedStrCat(
+        "All-reduce ", inst->name(),
+        " reduces within groups of replicas, only a reduction across all ",
+        res.replication_factor, " replicas is supported.");
+  }
+
   TF_ASSIGN_OR_RETURN(auto tensors,
                       FindInplaceOutputTensors(tensor_map, res, inst, seq));
   CHECK_EQ(tensors.size(), inst->operand_count());
@@ -25,6 +25,8 @@ limitations under the License.
 #include "absl/types/optional.h"
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace xla {
 namespace poplarplugin {
@@ -75,6 +77,26 @@ std::vector<std::vector<HloInstruction*>> Partition(
 
   return result;
 }
+
+// Split the instructions, in the order they are scheduled, into buckets which
+// are at most `max_bytes` bytes. An instruction larger than `max_bytes` is in a
+// bucket on its own.
+std::vector<std::vector<HloInstruction*>> SplitIntoBuckets(
+    const std::vector<HloInstruction*>& insts,
+    const InstructionColocatorHelper* colocator, int64 max_bytes) {
+  std::vector<std::vector<HloInstruction*>> buckets;
+  int64 bucket_bytes = 0;
+  for (HloInstruction* inst : insts) {
+    const int64 bytes = colocator->ByteSizeOf(inst);
+    if (buckets.empty() || bucket_bytes + bytes > max_bytes) {
+      buckets.emplace_back();
+      bucket_bytes = 0;
+    }
+    buckets.back().push_back(inst);
+    bucket_bytes += bytes;
+  }
+  return buckets;
+}
 }  // namespace
 
 StatusOr<absl::optional<HloInstructionSequence>>
@@ -110,6 +132,23 @@ CombineInstructions::CombineInstructionsInComputation(
     auto subregions =
         Partition(region_begin, region_end, reachability_map.get());
 
+    // Bound the size of the combined instructions, so that the instructions
+    // which are ready first are not all combined with the ones which are
+    // ready last.
+    const auto colocator = GetInstructionColocatorHelper(*region_begin);
+    const int64 max_bytes =
+        (*colocator)->GetMaximumCombinedSize(information_);
+    if (max_bytes > 0) {
+      std::vector<std::vector<HloInstruction*>> buckets;
+      for (auto& subregion : subregions) {
+        auto subregion_buckets =
+            SplitIntoBuckets(subregion, *colocator, max_bytes);
+        buckets.insert(buckets.end(), subregion_buckets.begin(),
+                       subregion_buckets.end());
+      }
+      subregions = std::move(buckets);
+    }
+
     std::vector<HloInstruction*> replacements;
 
     // Create the combined instructions
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_COMBINE_INSTRUCTIONS_H_
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_COMBINE_INSTRUCTIONS_H_
 
+#include "tensorflow/compiler/plugin/poplar/driver/compiler_information.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 
 #include "absl/types/optional.h"
@@ -27,6 +28,12 @@ struct CompilerAnnotations;
 
 class CombineInstructions : public HloModulePass {
  public:
+  // The colocated instructions are combined into instructions of at most the
+  // maximum combined size given by the information, if any.
+  explicit CombineInstructions(
+      const CompilerInformation& information = CompilerInformation())
+      : information_(information) {}
+
   absl::string_view name() const override { return "combine-instructions"; };
 
   // Run the pass on the given HLO module.  Returns whether it modified the
@@ -38,6 +45,8 @@ class CombineInstructions : public HloModulePass {
   StatusOr<absl::optional<HloInstructionSequence>>
   CombineInstructionsInComputation(HloComputation* comp,
                                    const HloInstructionSequence& sequence);
+
+  const CompilerInformation information_;
 };
 
 }  // namespace poplarplugin
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/host_compute_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/recv_from_host.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/send_to_host.h"
@@ -104,6 +105,46 @@ StatusOr<bool> ScheduleSendRecvs(HloComputation* comp,
   return scheduled;
 }
 
+// Adds control dependencies so that the recvs of the host computation are
+// scheduled after all the instructions which do not depend on any of them.
+StatusOr<bool> ScheduleRecvsLate(HloComputation* comp,
+                                 const std::vector<HloInstruction*>& recvs) {
+  if (recvs.empty()) {
+    return false;
+  }
+
+  const auto reachability_map = HloReachabilityMap::Build(comp);
+  const auto is_independent = [&](const HloInstruction* inst) {
+    return inst->opcode() != HloOpcode::kParameter &&
+           absl::c_none_of(recvs, [&](const HloInstruction* recv) {
+             return reachability_map->IsReachable(recv, inst);
+           });
+  };
+
+  bool scheduled = false;
+  for (HloInstruction* inst : comp->MakeInstructionPostOrder()) {
+    if (!is_independent(inst)) {
+      continue;
+    }
+    // Only the last independent instructions need a dependency, the others
+    // are ordered before them already.
+    const bool is_last =
+        absl::c_none_of(inst->users(), is_independent) &&
+        absl::c_none_of(inst->control_successors(), is_independent);
+    if (!is_last) {
+      continue;
+    }
+    for (HloInstruction* recv : recvs) {
+      if (!reachability_map->IsReachable(inst, recv)) {
+        TF_RETURN_IF_ERROR(inst->AddControlDependencyTo(recv));
+        scheduled = true;
+      }
+    }
+  }
+
+  return scheduled;
+}
+
 }  // namespace
 
 StatusOr<bool> HostComputeScheduleOptimizer::Run(HloModule* module) {
@@ -119,6 +160,20 @@ StatusOr<bool> HostComputeScheduleOptimizer::Run(HloModule* module) {
     TF_ASSIGN_OR_RETURN(const bool scheduled,
                         ScheduleSendRecvs(comp, op_send_recvs));
     changed |= scheduled;
+
+    if (overlap_host_compute_) {
+      // Visit the host computations in a deterministic order, as the
+      // dependencies added for one of them constrain the next ones.
+      std::map<std::string, std::vector<HloInstruction*>> op_recvs;
+      for (const auto& op_send_recv : op_send_recvs) {
+        op_recvs[op_send_recv.first] = op_send_recv.second.recvs;
+      }
+      for (const auto& op_recv : op_recvs) {
+        TF_ASSIGN_OR_RETURN(const bool recvs_scheduled,
+                            ScheduleRecvsLate(comp, op_recv.second));
+        changed |= recvs_scheduled;
+      }
+    }
   }
 
   return changed;
@@ -28,14 +28,25 @@ namespace poplarplugin {
  * This pass makes sure that the sends and recvs are scheduled in the same
  * order with respect to the shards. This can allow for more overlap of the
  * operations on the host and the stream copies between the host and the IPUs.
+ *
+ * When `overlap_host_compute` is set, the recvs of each host computation are
+ * also scheduled after all the instructions which do not depend on them, so
+ * that the IPU computes while the host computation runs, instead of waiting
+ * for its results right after the sends.
  */
 class HostComputeScheduleOptimizer : public HloModulePass {
  public:
+  explicit HostComputeScheduleOptimizer(bool overlap_host_compute = false)
+      : overlap_host_compute_(overlap_host_compute) {}
+
   absl::string_view name() const override {
     return "host-compute-schedule-optimizer";
   }
 
   StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  const bool overlap_host_compute_;
 };
 
 }  // namespace poplarplugin
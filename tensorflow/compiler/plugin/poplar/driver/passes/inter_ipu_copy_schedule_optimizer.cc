@@ -0,0 +1,160 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/passes/inter_ipu_copy_schedule_optimizer.h"
+
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+// The shard all the operands of the copy are on, if there is one.
+absl::optional<int64> GetSourceShard(const HloInstruction* copy) {
+  absl::optional<int64> shard;
+  for (const HloInstruction* operand : copy->operands()) {
+    const auto operand_shard = operand->sharding_unique_device();
+    if (!operand_shard || (shard && *shard != *operand_shard)) {
+      return absl::nullopt;
+    }
+    shard = operand_shard;
+  }
+  return shard;
+}
+}  // namespace
+
+InterIpuCopyScheduleOptimizer::InterIpuCopyScheduleOptimizer(
+    PipelineStageCostModel cost_model)
+    : cost_model_(cost_model) {}
+
+StatusOr<bool> InterIpuCopyScheduleOptimizer::OptimizeComputation(
+    HloComputation* comp) const {
+  std::vector<HloInstruction*> copies;
+  absl::c_copy_if(comp->MakeInstructionPostOrder(), std::back_inserter(copies),
+                  IsPoplarInstruction(PoplarOp::IpuInterCopy));
+  if (copies.empty()) {
+    return false;
+  }
+
+  HloCostAnalysis cost_analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  TF_RETURN_IF_ERROR(comp->Accept(&cost_analysis));
+
+  auto reachability_map = HloReachabilityMap::Build(comp);
+  bool changed = false;
+  int64 overlapped_cycles = 0;
+
+  for (HloInstruction* copy : copies) {
+    const auto source_shard = GetSourceShard(copy);
+    if (!source_shard) {
+      continue;
+    }
+
+    // The instructions of the source shard which can be computed after the
+    // copy.
+    std::vector<HloInstruction*> independent;
+    for (HloInstruction* inst : comp->MakeInstructionPostOrder()) {
+      if (inst == copy || inst->operand_count() == 0 ||
+          IsPoplarInstruction(PoplarOp::IpuInterCopy)(inst) ||
+          inst->sharding_unique_device() != source_shard) {
+        continue;
+      }
+      if (!reachability_map->IsReachable(inst, copy) &&
+          !reachability_map->IsReachable(copy, inst)) {
+        independent.push_back(inst);
+      }
+    }
+    const absl::flat_hash_set<HloInstruction*> independent_set(
+        independent.begin(), independent.end());
+
+    int64 copy_overlapped_cycles = 0;
+    for (HloInstruction* inst : independent) {
+      copy_overlapped_cycles +=
+          EstimateInstructionCycles(inst, cost_analysis, cost_model_);
+
+      // Only the first independent instructions need a dependency, the others
+      // are their users.
+      if (absl::c_any_of(inst->operands(),
+                         [&independent_set](HloInstruction* operand) {
+                           return independent_set.contains(operand);
+                         })) {
+        continue;
+      }
+      TF_RETURN_IF_ERROR(copy->AddControlDependencyTo(inst));
+      reachability_map->UpdateReachabilityThroughInstruction(inst);
+      changed = true;
+    }
+
+    VLOG(2) << "Scheduled " << copy->name() << " before "
+            << independent.size() << " instructions of shard " << *source_shard
+            << " (" << copy_overlapped_cycles << " cycles).";
+    overlapped_cycles += copy_overlapped_cycles;
+  }
+
+  if (changed) {
+    VLOG(1) << "Scheduling the inter IPU copies of " << comp->name()
+            << " early overlaps an estimated " << overlapped_cycles
+            << " cycles of computation with the following shards.";
+  }
+  return changed;
+}
+
+StatusOr<bool> InterIpuCopyScheduleOptimizer::Run(HloModule* module) {
+  VLOG(2) << "Before InterIpuCopyScheduleOptimizer:";
+  XLA_VLOG_LINES(2, module->ToString());
+
+  // The computations of the pipelines are scheduled by stage, and the
+  // resource updates have their own schedule optimizer.
+  absl::flat_hash_set<const HloComputation*> skipped_comps;
+  for (HloComputation* comp : module->MakeComputationPostOrder()) {
+    for (HloInstruction* inst : comp->instructions()) {
+      if (IsPipelineOp(inst) || IsResourceUpdate(inst)) {
+        skipped_comps.insert(inst->to_apply());
+      }
+    }
+  }
+
+  bool changed = false;
+  for (HloComputation* comp : module->MakeComputationPostOrder()) {
+    if (IsPopOpsFusion(comp) || skipped_comps.contains(comp)) {
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(const bool comp_changed, OptimizeComputation(comp));
+    changed |= comp_changed;
+  }
+
+  if (changed) {
+    VLOG(2) << "After InterIpuCopyScheduleOptimizer:";
+    XLA_VLOG_LINES(2, module->ToString());
+  } else {
+    VLOG(2) << "No changes were made.";
+  }
+  return changed;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,64 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_INTER_IPU_COPY_SCHEDULE_OPTIMIZER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_INTER_IPU_COPY_SCHEDULE_OPTIMIZER_H_
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_balancer.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+
+class HloComputation;
+class HloModule;
+
+namespace poplarplugin {
+
+/**
+ * This pass schedules the inter IPU copies of a sharded model as soon as the
+ * tensors they copy are computed.
+ *
+ * The IPUs only synchronise with each other when copying between them, so once
+ * the copy to the next shard is done, the next IPU can start computing while
+ * the current IPU computes the instructions which do not depend on the copy.
+ * Each copy is given a control dependency to the instructions of its source
+ * shard which are independent of it. The copies are not constrained between
+ * each other so that they can still be combined.
+ *
+ * The estimated number of cycles the destination IPUs no longer wait for is
+ * reported in the log. The computations of pipelines are not changed, as their
+ * stages are already overlapped, and neither are those of resource updates.
+ */
+class InterIpuCopyScheduleOptimizer : public HloModulePass {
+ public:
+  explicit InterIpuCopyScheduleOptimizer(
+      PipelineStageCostModel cost_model = {});
+
+  absl::string_view name() const override {
+    return "inter-ipu-copy-schedule-optimizer";
+  }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  StatusOr<bool> OptimizeComputation(HloComputation* comp) const;
+
+ private:
+  const PipelineStageCostModel cost_model_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_INTER_IPU_COPY_SCHEDULE_OPTIMIZER_H_
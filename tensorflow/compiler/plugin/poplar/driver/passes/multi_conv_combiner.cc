@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/passes/multi_conv_combiner.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/multi_conv_fixer.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/conv_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+bool IsCombinableConvolution(const HloInstruction* inst) {
+  if (inst->opcode() != HloOpcode::kConvolution &&
+      !IsPopOpsFusion(inst, "conv_with_reverse") &&
+      !IsPopOpsFusion(inst, "depthwise_conv") &&
+      !IsPopOpsFusion(inst, "depthwise_filter")) {
+    return false;
+  }
+  // Control dependencies would have to be moved onto the multi-conv, which
+  // could serialise the other convolutions.
+  if (inst->control_predecessors().size() ||
+      inst->control_successors().size()) {
+    return false;
+  }
+  return inst->operand_count() == 2 && GetBatchGroupCount(inst) == 1;
+}
+
+int64 ConvolutionBytes(const HloInstruction* inst) {
+  int64 bytes = ShapeUtil::ByteSizeOf(inst->shape());
+  for (const HloInstruction* operand : inst->operands()) {
+    bytes += ShapeUtil::ByteSizeOf(operand->shape());
+  }
+  return bytes;
+}
+
+bool HaveSameSharding(const HloInstruction* a, const HloInstruction* b) {
+  if (a->has_sharding() != b->has_sharding()) {
+    return false;
+  }
+  return !a->has_sharding() || a->sharding() == b->sharding();
+}
+
+}  // namespace
+
+MultiConvCombiner::MultiConvCombiner(int64 max_combined_bytes)
+    : max_combined_bytes_(max_combined_bytes) {}
+
+StatusOr<bool> MultiConvCombiner::CombineConvolutions(HloComputation* comp) {
+  std::unique_ptr<HloReachabilityMap> reachability_map =
+      HloReachabilityMap::Build(comp);
+
+  // Split the convolutions into groups of consecutive independent
+  // convolutions. A group only depends on the groups before it in the post
+  // order, so combining the groups one after another cannot create a cycle.
+  std::vector<std::vector<HloInstruction*>> groups(1);
+  int64 group_bytes = 0;
+  for (HloInstruction* inst : comp->MakeInstructionPostOrder()) {
+    if (!IsCombinableConvolution(inst)) {
+      continue;
+    }
+    const int64 bytes = ConvolutionBytes(inst);
+    std::vector<HloInstruction*>& group = groups.back();
+    const bool can_join =
+        group.size() && group_bytes + bytes <= max_combined_bytes_ &&
+        HaveSameSharding(group[0], inst) &&
+        IsWeightUpdateConvolution(group[0]) ==
+            IsWeightUpdateConvolution(inst) &&
+        absl::c_none_of(group, [&](const HloInstruction* other) {
+          return reachability_map->IsReachable(other, inst);
+        });
+    if (!can_join && group.size()) {
+      groups.emplace_back();
+      group_bytes = 0;
+    }
+    groups.back().push_back(inst);
+    group_bytes += bytes;
+  }
+
+  bool changed = false;
+  for (const std::vector<HloInstruction*>& group : groups) {
+    if (group.size() < 2) {
+      continue;
+    }
+    VLOG(2) << "Combining " << group.size() << " convolutions starting with "
+            << group[0]->ToString() << " into a multi-conv.";
+    TF_RETURN_IF_ERROR(ReplaceConvsWithMultiConv(
+        comp, group, {}, IsWeightUpdateConvolution(group[0])));
+    changed = true;
+  }
+  return changed;
+}
+
+StatusOr<bool> MultiConvCombiner::Run(HloModule* module) {
+  VLOG(2) << "Before MultiConvCombiner:";
+  XLA_VLOG_LINES(2, module->ToString());
+
+  bool changed = false;
+  for (HloComputation* comp : module->MakeComputationPostOrder()) {
+    if (IsPopOpsFusion(comp)) {
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(bool comp_changed, CombineConvolutions(comp));
+    changed |= comp_changed;
+  }
+
+  if (changed) {
+    VLOG(2) << "After MultiConvCombiner:";
+    XLA_VLOG_LINES(2, module->ToString());
+  } else {
+    VLOG(2) << "No changes.";
+  }
+  return changed;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_MULTI_CONV_COMBINER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_MULTI_CONV_COMBINER_H_
+
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+
+class HloComputation;
+class HloModule;
+
+namespace poplarplugin {
+
+/**
+ * A pass which combines independent convolutions into multi-conv instructions,
+ * so that they are planned and executed together.
+ *
+ * The convolutions of each computation are visited in post order, and each
+ * one is added to the current group if it is independent of all the
+ * convolutions of the group, is on the same shard, is of the same kind
+ * (weight update or not) and the total size of the inputs and outputs of the
+ * group stays within `max_combined_bytes`. Otherwise the group is closed and a
+ * new one is started.
+ */
+class MultiConvCombiner : public HloModulePass {
+ public:
+  explicit MultiConvCombiner(int64 max_combined_bytes);
+
+  absl::string_view name() const override { return "multi-conv-combiner"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  StatusOr<bool> CombineConvolutions(HloComputation* comp);
+
+  const int64 max_combined_bytes_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_MULTI_CONV_COMBINER_H_
@@ -37,11 +37,39 @@ limitations under the License.
 
 namespace xla {
 namespace poplarplugin {
-namespace {
+
+bool IsWeightUpdateConvolution(const HloInstruction* inst) {
+  const auto attributes = inst->frontend_attributes();
+  auto itr = attributes.map().find(FrontendAttributeId_Name(ML_TYPE));
+  return itr != attributes.map().end() &&
+         itr->second == MLType_Name(MLType::TRAINING_WU);
+}
+
+StatusOr<HloMultiConvInstruction::ConvolutionSpec> GetMultiConvSpec(
+    const HloInstruction* conv) {
+  HloMultiConvInstruction::ConvolutionSpec convolution_spec;
+  if (conv->opcode() == HloOpcode::kConvolution) {
+    convolution_spec.type = ConvType::Conv;
+  } else if (IsPopOpsFusion(conv, "conv_with_reverse")) {
+    convolution_spec.type = ConvType::ConvWithReverse;
+  } else if (IsPopOpsFusion(conv, "depthwise_conv")) {
+    convolution_spec.type = ConvType::DepthwiseConv;
+  } else if (IsPopOpsFusion(conv, "depthwise_filter")) {
+    convolution_spec.type = ConvType::DepthwiseFilter;
+  } else {
+    return InternalErrorStrCat("Could not classify the ", conv->ToString(),
+                               " convolution for the MultiConv operation.");
+  }
+  convolution_spec.window = GetConvolutionWindow(conv);
+  convolution_spec.dims = GetConvolutionDims(conv);
+  convolution_spec.feature_group_count = GetFeatureGroupCount(conv);
+  return convolution_spec;
+}
+
 Status ReplaceConvsWithMultiConv(
-    HloComputation* comp, std::vector<HloInstruction*>& convs,
+    HloComputation* comp, const std::vector<HloInstruction*>& convs,
     const std::vector<HloMultiConvInstruction::OptionFlag>& option_flags,
-    CallInliner::InlinedInstructionMap& inline_map, bool is_wu) {
+    bool is_wu) {
   const int64 num_convs = convs.size();
   if (num_convs < 2) {
     return Status::OK();
@@ -52,49 +80,35 @@ Status ReplaceConvsWithMultiConv(
       num_convs);
 
   for (int64 i = 0; i != num_convs; ++i) {
-    HloInstruction* new_conv = inline_map[convs[i]];
-    CHECK_EQ(new_conv->operand_count(), 2);
-
-    output_shapes[i] = new_conv->shape();
-    operands[i] = new_conv->mutable_operand(0);
-    operands[num_convs + i] = new_conv->mutable_operand(1);
-
-    HloMultiConvInstruction::ConvolutionSpec convolution_spec;
-    if (new_conv->opcode() == HloOpcode::kConvolution) {
-      convolution_spec.type = ConvType::Conv;
-    } else if (IsPopOpsFusion(new_conv, "conv_with_reverse")) {
-      convolution_spec.type = ConvType::ConvWithReverse;
-    } else if (IsPopOpsFusion(new_conv, "depthwise_conv")) {
-      convolution_spec.type = ConvType::DepthwiseConv;
-    } else if (IsPopOpsFusion(new_conv, "depthwise_filter")) {
-      convolution_spec.type = ConvType::DepthwiseFilter;
-    } else {
-      return InternalErrorStrCat("Could not classify the ",
-                                 new_conv->ToString(),
-                                 " convolution for the MultiConv operation.");
-    }
-    convolution_spec.window = GetConvolutionWindow(new_conv);
-    convolution_spec.dims = GetConvolutionDims(new_conv);
-    convolution_spec.feature_group_count = GetFeatureGroupCount(new_conv);
-    convolution_specs[i] = convolution_spec;
+    HloInstruction* conv = convs[i];
+    CHECK_EQ(conv->operand_count(), 2);
+
+    output_shapes[i] = conv->shape();
+    operands[i] = conv->mutable_operand(0);
+    operands[num_convs + i] = conv->mutable_operand(1);
+    TF_ASSIGN_OR_RETURN(convolution_specs[i], GetMultiConvSpec(conv));
   }
 
   HloInstruction* multi_conv_inst = comp->AddInstruction(
       CreateMultiConv(ShapeUtil::MakeTupleShape(output_shapes), operands,
                       convolution_specs, option_flags, is_wu));
+  multi_conv_inst->set_metadata(convs[0]->metadata());
+  if (convs[0]->has_sharding()) {
+    multi_conv_inst->set_sharding(convs[0]->sharding());
+  }
 
   // Replace all the uses with the outputs from the multi conv.
   for (int64 i = 0; i != num_convs; ++i) {
     TF_ASSIGN_OR_RETURN(HloInstruction * gte,
                         MakeGetTupleElementHlo(multi_conv_inst, i));
-
-    HloInstruction* new_conv = inline_map[convs[i]];
-    TF_RETURN_IF_ERROR(comp->ReplaceInstruction(new_conv, gte));
+    if (convs[i]->has_sharding()) {
+      gte->set_sharding(convs[i]->sharding());
+    }
+    TF_RETURN_IF_ERROR(comp->ReplaceInstruction(convs[i], gte));
   }
 
   return Status::OK();
 }
-}  // namespace
 
 Status MultiConvFixer::FixMultiConv(HloInstruction* multi_conv_op) {
   HloComputation* parent_comp = multi_conv_op->parent();
@@ -122,14 +136,7 @@ Status MultiConvFixer::FixMultiConv(HloInstruction* multi_conv_op) {
       }
       all_convolution_ops.push_back(inst);
 
-      bool is_wu_conv = false;
-      const auto attributes = inst->frontend_attributes();
-      auto itr = attributes.map().find(FrontendAttributeId_Name(ML_TYPE));
-      if (itr != attributes.map().end()) {
-        is_wu_conv = itr->second == MLType_Name(MLType::TRAINING_WU);
-      }
-
-      if (is_wu_conv) {
+      if (IsWeightUpdateConvolution(inst)) {
         wu_convolution_ops.push_back(inst);
       } else {
         non_wu_convolution_ops.push_back(inst);
@@ -158,10 +165,17 @@ Status MultiConvFixer::FixMultiConv(HloInstruction* multi_conv_op) {
   TF_ASSIGN_OR_RETURN(CallInliner::InlinedInstructionMap map,
                       CallInliner::Inline(multi_conv_op));
 
+  auto inlined = [&map](const std::vector<HloInstruction*>& convs) {
+    std::vector<HloInstruction*> inlined_convs(convs.size());
+    absl::c_transform(convs, inlined_convs.begin(),
+                      [&map](HloInstruction* conv) { return map[conv]; });
+    return inlined_convs;
+  };
   TF_RETURN_IF_ERROR(ReplaceConvsWithMultiConv(
-      parent_comp, wu_convolution_ops, option_flags, map, /*is_wu*/ true));
-  TF_RETURN_IF_ERROR(ReplaceConvsWithMultiConv(
-      parent_comp, non_wu_convolution_ops, option_flags, map, /*is_wu*/ false));
+      parent_comp, inlined(wu_convolution_ops), option_flags, /*is_wu*/ true));
+  TF_RETURN_IF_ERROR(ReplaceConvsWithMultiConv(parent_comp,
+                                               inlined(non_wu_convolution_ops),
+                                               option_flags, /*is_wu*/ false));
   return Status::OK();
 }
 
@@ -16,15 +16,34 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_MULTI_CONV_FIXER_H_
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_MULTI_CONV_FIXER_H_
 
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/multi_conv.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 
 namespace xla {
 
+class HloComputation;
 class HloModule;
 
 namespace poplarplugin {
 
+// Returns whether the convolution was marked as part of the weight update.
+bool IsWeightUpdateConvolution(const HloInstruction* inst);
+
+// Returns the description of a convolution inside of a multi-conv, or an
+// error if the instruction is not a convolution a multi-conv can perform.
+StatusOr<HloMultiConvInstruction::ConvolutionSpec> GetMultiConvSpec(
+    const HloInstruction* conv);
+
+// Replaces the independent convolutions `convs` of `comp` with a single
+// multi-conv instruction. Does nothing if there are fewer than two.
+Status ReplaceConvsWithMultiConv(
+    HloComputation* comp, const std::vector<HloInstruction*>& convs,
+    const std::vector<HloMultiConvInstruction::OptionFlag>& option_flags,
+    bool is_wu);
+
 /**
  * A pass which converts all convolutions inside of a multi-conv scope into a
  * single convolutions instruction.
@@ -0,0 +1,400 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_balancer.h"
+
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/driver/backend_config.pb.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/fifo.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+int64 ArrayBytes(const Shape& shape) {
+  int64 bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&bytes](const Shape& subshape, const ShapeIndex&) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+// Instructions whose outputs are their operands.
+bool AliasesOperands(const HloInstruction* inst) {
+  switch (inst->opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kTuple:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsMatMulLike(const HloInstruction* inst) {
+  switch (inst->opcode()) {
+    case HloOpcode::kConvolution:
+    case HloOpcode::kDot:
+      return true;
+    case HloOpcode::kFusion:
+      return absl::c_any_of(
+          inst->fused_instructions_computation()->instructions(),
+          IsMatMulLike);
+    default:
+      return false;
+  }
+}
+
+// The position of the last instruction which uses the output of `inst`,
+// looking through the instructions which alias their operands.
+int64 LastUse(const HloInstruction* inst,
+              const absl::flat_hash_map<const HloInstruction*, int64>& position,
+              int64 num_instructions) {
+  if (inst == inst->parent()->root_instruction()) {
+    return num_instructions - 1;
+  }
+  int64 last_use = position.at(inst);
+  for (const HloInstruction* user : inst->users()) {
+    last_use = std::max(last_use, AliasesOperands(user)
+                                      ? LastUse(user, position,
+                                                num_instructions)
+                                      : position.at(user));
+  }
+  return last_use;
+}
+
+int64 MaxLiveBytes(const std::vector<HloInstruction*>& order) {
+  const int64 num_instructions = order.size();
+  absl::flat_hash_map<const HloInstruction*, int64> position;
+  for (int64 i = 0; i != num_instructions; ++i) {
+    position[order[i]] = i;
+  }
+
+  // The change in the number of live bytes at each position.
+  std::vector<int64> delta(num_instructions + 1, 0);
+  for (int64 i = 0; i != num_instructions; ++i) {
+    if (AliasesOperands(order[i])) {
+      continue;
+    }
+    const int64 bytes = ArrayBytes(order[i]->shape());
+    delta[i] += bytes;
+    delta[LastUse(order[i], position, num_instructions) + 1] -= bytes;
+  }
+
+  int64 live_bytes = 0;
+  int64 max_live_bytes = 0;
+  for (int64 i = 0; i != num_instructions; ++i) {
+    live_bytes += delta[i];
+    max_live_bytes = std::max(max_live_bytes, live_bytes);
+  }
+  return max_live_bytes;
+}
+
+struct StageCosts {
+  std::vector<HloInstruction*> order;
+  std::vector<int64> cycles;
+  int64 total_cycles = 0;
+  int64 max_live_bytes = 0;
+};
+
+StatusOr<StageCosts> GetStageCosts(const HloInstruction* stage,
+                                   const PipelineStageCostModel& cost_model) {
+  HloCostAnalysis cost_analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  HloComputation* comp = stage->to_apply();
+  TF_RETURN_IF_ERROR(comp->Accept(&cost_analysis));
+
+  StageCosts costs;
+  costs.order = comp->MakeInstructionPostOrder();
+  for (const HloInstruction* inst : costs.order) {
+    costs.cycles.push_back(
+        EstimateInstructionCycles(inst, cost_analysis, cost_model));
+    costs.total_cycles += costs.cycles.back();
+  }
+  costs.max_live_bytes = MaxLiveBytes(costs.order);
+  return costs;
+}
+
+// Suggests moving instructions from the start of the longest forward stage
+// into the previous stage or from its end into the next stage. The
+// instructions at the start of a stage only depend on its inputs, which are
+// the outputs of the previous stage, and the instructions at its end are only
+// used by its outputs, so either change keeps the stages in order.
+std::string SuggestBoundaryChange(
+    const std::vector<PipelineStageEstimate>& estimates,
+    const std::vector<StageCosts>& forward_costs) {
+  const int64 num_stages = estimates.size();
+  auto longest = absl::c_max_element(
+      estimates,
+      [](const PipelineStageEstimate& a, const PipelineStageEstimate& b) {
+        return a.cycles() < b.cycles();
+      });
+  const int64 stage = std::distance(estimates.begin(), longest);
+  const int64 longest_cycles = longest->cycles();
+
+  // The longest of the other stages, which is unchanged.
+  auto longest_excluding = [&](int64 a, int64 b) {
+    int64 cycles = 0;
+    for (int64 i = 0; i != num_stages; ++i) {
+      if (i != a && i != b) {
+        cycles = std::max(cycles, estimates[i].cycles());
+      }
+    }
+    return cycles;
+  };
+
+  const StageCosts& costs = forward_costs[stage];
+  const int64 num_instructions = costs.order.size();
+  int64 best_cycles = longest_cycles;
+  int64 best_neighbour = -1;
+  int64 best_count = 0;
+  const HloInstruction* best_boundary = nullptr;
+
+  auto is_movable = [](const HloInstruction* inst) {
+    return !AliasesOperands(inst) && inst->opcode() != HloOpcode::kParameter;
+  };
+
+  if (stage > 0) {
+    const int64 other = longest_excluding(stage, stage - 1);
+    int64 moved_cycles = 0;
+    int64 count = 0;
+    for (int64 i = 0; i != num_instructions; ++i) {
+      if (!is_movable(costs.order[i])) {
+        continue;
+      }
+      moved_cycles += costs.cycles[i];
+      count++;
+      const int64 cycles =
+          std::max({other, estimates[stage].cycles() - moved_cycles,
+                    estimates[stage - 1].cycles() + moved_cycles});
+      if (cycles < best_cycles) {
+        best_cycles = cycles;
+        best_neighbour = stage - 1;
+        best_count = count;
+        best_boundary = costs.order[i];
+      }
+    }
+  }
+
+  if (stage + 1 < num_stages) {
+    const int64 other = longest_excluding(stage, stage + 1);
+    int64 moved_cycles = 0;
+    int64 count = 0;
+    for (int64 i = num_instructions - 1; i >= 0; --i) {
+      if (!is_movable(costs.order[i])) {
+        continue;
+      }
+      moved_cycles += costs.cycles[i];
+      count++;
+      const int64 cycles =
+          std::max({other, estimates[stage].cycles() - moved_cycles,
+                    estimates[stage + 1].cycles() + moved_cycles});
+      if (cycles < best_cycles) {
+        best_cycles = cycles;
+        best_neighbour = stage + 1;
+        best_count = count;
+        best_boundary = costs.order[i];
+      }
+    }
+  }
+
+  if (best_neighbour < 0) {
+    return "";
+  }
+  const bool into_previous = best_neighbour < stage;
+  return absl::StrCat(
+      "Moving the ", best_count, " instruction(s) ",
+      into_previous ? "up to and including " : "from ", best_boundary->name(),
+      into_previous ? " at the start" : " to the end", " of pipeline stage ",
+      estimates[stage].stage_id, " into stage ",
+      estimates[best_neighbour].stage_id,
+      " would reduce the longest stage from ", longest_cycles, " to ",
+      best_cycles, " cycles.");
+}
+}  // namespace
+
+std::string PipelineBalanceReport::ToString() const {
+  std::string report;
+  for (const PipelineStageEstimate& stage : stages) {
+    absl::StrAppend(&report, "Pipeline stage ", stage.stage_id, ": ",
+                    stage.forward_cycles, " forward cycles, ",
+                    stage.backward_cycles, " backward cycles, ",
+                    stage.max_live_bytes, " bytes live, ", stage.stashed_bytes,
+                    " bytes of stashed activations.\n");
+  }
+  absl::StrAppend(&report, "Estimated bubble fraction: ",
+                  static_cast<int64>(bubble_fraction * 1000) / 10.0,
+                  "% with a gradient accumulation count of ",
+                  gradient_accumulation_count, ".\n");
+  if (!suggestion.empty()) {
+    absl::StrAppend(&report, suggestion, "\n");
+  }
+  return report;
+}
+
+int64 EstimateInstructionCycles(const HloInstruction* inst,
+                                const HloCostAnalysis& cost_analysis,
+                                const PipelineStageCostModel& cost_model) {
+  if (AliasesOperands(inst) || inst->opcode() == HloOpcode::kParameter ||
+      inst->opcode() == HloOpcode::kConstant) {
+    return 0;
+  }
+
+  // The cost analysis reports negative values for the instructions it does not
+  // know about, such as custom calls.
+  const double flops = std::max<int64>(cost_analysis.flop_count(*inst), 0);
+  const double transcendentals =
+      std::max<int64>(cost_analysis.transcendental_count(*inst), 0);
+  double bytes = cost_analysis.bytes_accessed(*inst);
+  if (bytes < 0) {
+    bytes = ArrayBytes(inst->shape());
+    for (const HloInstruction* operand : inst->operands()) {
+      bytes += ArrayBytes(operand->shape());
+    }
+  }
+
+  const double tiles = cost_model.tiles_per_ipu;
+  const double flops_per_cycle = IsMatMulLike(inst)
+                                     ? cost_model.matmul_flops_per_cycle
+                                     : cost_model.vector_flops_per_cycle;
+  const double compute_cycles =
+      flops / (tiles * flops_per_cycle) +
+      transcendentals / (tiles * cost_model.transcendentals_per_cycle);
+  const double memory_cycles = bytes / (tiles * cost_model.bytes_per_cycle);
+  return static_cast<int64>(
+      cost_model.calibration * (std::max(compute_cycles, memory_cycles) +
+                                cost_model.cycles_per_instruction));
+}
+
+PipelineStageBalancer::PipelineStageBalancer(PipelineStageCostModel cost_model)
+    : cost_model_(cost_model) {}
+
+StatusOr<PipelineBalanceReport> PipelineStageBalancer::Analyse(
+    HloInstruction* pipeline_op) const {
+  TF_ASSIGN_OR_RETURN(PipelineStages stages,
+                      GetPipelineStages(pipeline_op->to_apply(),
+                                        /*validate_stages=*/false));
+  TF_ASSIGN_OR_RETURN(const auto schedule, GetPipelineSchedule(pipeline_op));
+
+  PipelineBalanceReport report;
+  report.gradient_accumulation_count =
+      std::max<int64>(GetGradientAccumulationCount(pipeline_op), 1);
+
+  std::vector<StageCosts> forward_costs;
+  for (HloInstruction* stage : stages.forward) {
+    TF_ASSIGN_OR_RETURN(StageCosts costs, GetStageCosts(stage, cost_model_));
+    PipelineStageEstimate estimate;
+    estimate.stage_id = GetPipelineStageID(stage);
+    estimate.forward_cycles = costs.total_cycles;
+    estimate.max_live_bytes = costs.max_live_bytes;
+    report.stages.push_back(estimate);
+    forward_costs.push_back(std::move(costs));
+  }
+  if (report.stages.empty()) {
+    return FailedPrecondition("The pipeline has no stages.");
+  }
+
+  std::vector<HloInstruction*> backward_stages = stages.backward;
+  for (auto& pair : stages.recomputation) {
+    backward_stages.push_back(pair.second);
+  }
+  for (HloInstruction* stage : backward_stages) {
+    const int64 stage_id = GetPipelineStageID(stage);
+    auto itr = absl::c_find_if(report.stages,
+                               [stage_id](const PipelineStageEstimate& e) {
+                                 return e.stage_id == stage_id;
+                               });
+    if (itr == report.stages.end()) {
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(StageCosts costs, GetStageCosts(stage, cost_model_));
+    itr->backward_cycles += costs.total_cycles;
+    itr->max_live_bytes = std::max(itr->max_live_bytes, costs.max_live_bytes);
+    for (const HloInstruction* operand : stage->unique_operands()) {
+      if (IsPoplarInstruction(PoplarOp::Fifo)(operand)) {
+        itr->stashed_bytes += Cast<HloFifoInstruction>(operand)->depth() *
+                              ArrayBytes(operand->shape());
+      }
+    }
+  }
+
+  // Each IPU is busy for the duration of its stage for every batch, and the
+  // iteration for a batch takes as long as the longest stage. In a sequential
+  // pipeline only one stage executes at a time.
+  const double num_stages = report.stages.size();
+  const double num_batches = report.gradient_accumulation_count;
+  int64 total_cycles = 0;
+  int64 max_cycles = 0;
+  for (const PipelineStageEstimate& stage : report.stages) {
+    total_cycles += stage.cycles();
+    max_cycles = std::max(max_cycles, stage.cycles());
+  }
+  double elapsed_cycles;
+  if (schedule == PoplarBackendConfig::CallConfig::PipelineConfig::Sequential) {
+    elapsed_cycles = num_batches * total_cycles;
+  } else {
+    elapsed_cycles = (num_batches + num_stages - 1) * max_cycles;
+  }
+  report.bubble_fraction =
+      elapsed_cycles > 0
+          ? 1.0 - num_batches * total_cycles / (num_stages * elapsed_cycles)
+          : 0.0;
+
+  report.suggestion = SuggestBoundaryChange(report.stages, forward_costs);
+  return report;
+}
+
+StatusOr<bool> PipelineStageBalancer::Run(HloModule* module) {
+  TF_ASSIGN_OR_RETURN(std::vector<HloInstruction*> pipeline_ops,
+                      GetPipelines(module));
+  for (HloInstruction* pipeline_op : pipeline_ops) {
+    auto report_or = Analyse(pipeline_op);
+    if (!report_or.ok()) {
+      VLOG(1) << "Could not estimate the pipeline stage balance of "
+              << pipeline_op->ToString() << ": " << report_or.status();
+      continue;
+    }
+    const std::string report = report_or.ValueOrDie().ToString();
+    if (PoplarXlaFlags::Get().log_pipeline_stage_balance) {
+      LOG(INFO) << "Pipeline stage balance of " << pipeline_op->name() << ":\n"
+                << report;
+    } else {
+      VLOG(1) << "Pipeline stage balance of " << pipeline_op->name() << ":\n"
+              << report;
+    }
+  }
+  return false;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
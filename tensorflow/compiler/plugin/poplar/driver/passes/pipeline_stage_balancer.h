@@ -0,0 +1,108 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_PIPELINE_STAGE_BALANCER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_PIPELINE_STAGE_BALANCER_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+
+class HloCostAnalysis;
+class HloInstruction;
+class HloModule;
+
+namespace poplarplugin {
+
+// A rough model of the number of cycles an instruction takes on an IPU. The
+// throughputs are per tile and the instructions are assumed to be spread over
+// all the tiles of the IPU. The estimates are multiplied by the calibration,
+// which can be set to the ratio between a cycle count measured with the
+// `log_cycle_count` flag and the estimate for the same model.
+struct PipelineStageCostModel {
+  int64 tiles_per_ipu = 1216;
+  // Floating point operations per cycle for matmuls and convolutions.
+  double matmul_flops_per_cycle = 64.0;
+  // Floating point operations per cycle for all other operations.
+  double vector_flops_per_cycle = 4.0;
+  double transcendentals_per_cycle = 1.0;
+  double bytes_per_cycle = 8.0;
+  // Cycles spent synchronising and exchanging data for each instruction.
+  int64 cycles_per_instruction = 200;
+  double calibration = 1.0;
+};
+
+// The estimated number of cycles of `inst`. The instructions whose outputs are
+// their operands, parameters and constants take no cycles.
+int64 EstimateInstructionCycles(const HloInstruction* inst,
+                                const HloCostAnalysis& cost_analysis,
+                                const PipelineStageCostModel& cost_model);
+
+// The estimated cost of a pipeline stage and its backward stage.
+struct PipelineStageEstimate {
+  int64 stage_id;
+  int64 forward_cycles = 0;
+  // Includes the recomputation of the stage.
+  int64 backward_cycles = 0;
+  // The largest number of bytes live at any point in the stage.
+  int64 max_live_bytes = 0;
+  // The bytes of activations stored in FIFOs between the stage and its
+  // backward stage. This depends on the schedule - the Interleaved schedule
+  // stores half as many activations as the Grouped schedule.
+  int64 stashed_bytes = 0;
+
+  int64 cycles() const { return forward_cycles + backward_cycles; }
+};
+
+struct PipelineBalanceReport {
+  std::vector<PipelineStageEstimate> stages;
+  int64 gradient_accumulation_count;
+  // The fraction of time the IPUs are idle during each pipeline iteration.
+  double bubble_fraction;
+  // A suggested change of the stage boundaries, if one improves the balance.
+  std::string suggestion;
+
+  std::string ToString() const;
+};
+
+/**
+ * Pass which estimates the number of cycles each pipeline stage takes and the
+ * fraction of time the IPUs are idle because the stages are not balanced. When
+ * the longest stage can be shortened by moving instructions at its start or
+ * end into the neighbouring stage, this is suggested in the report.
+ *
+ * The report is logged, the module is not modified.
+ */
+class PipelineStageBalancer : public HloModulePass {
+ public:
+  explicit PipelineStageBalancer(PipelineStageCostModel cost_model = {});
+
+  absl::string_view name() const override { return "pipeline-stage-balancer"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  StatusOr<PipelineBalanceReport> Analyse(HloInstruction* pipeline_op) const;
+
+ private:
+  const PipelineStageCostModel cost_model_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_PIPELINE_STAGE_BALANCER_H_
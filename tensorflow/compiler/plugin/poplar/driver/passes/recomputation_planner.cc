@@ -0,0 +1,410 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/recomputation_planner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/recompute.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// The number of instructions live at the peak which are tried each time an
+// instruction is chosen, largest first.
+constexpr int64 kMaxCandidates = 16;
+// The largest number of instructions recomputed in a computation.
+constexpr int64 kMaxRecomputations = 256;
+
+int64 ArrayBytes(const Shape& shape) {
+  int64 bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&bytes](const Shape& subshape, const ShapeIndex&) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+// Instructions whose outputs are their operands.
+bool AliasesOperands(const HloInstruction* inst) {
+  switch (inst->opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kTuple:
+      return true;
+    default:
+      return IsPoplarInstruction(PoplarOp::BlockRecompute)(inst) ||
+             IsPoplarInstruction(PoplarOp::SuggestRecompute)(inst);
+  }
+}
+
+// Only instructions which can be cloned without changing the result are
+// recomputed, and the same instructions are blocked by AddBlockRecompute.
+bool IsRecomputable(const HloInstruction* inst) {
+  switch (inst->opcode()) {
+    case HloOpcode::kConstant:
+    case HloOpcode::kCustomCall:
+    case HloOpcode::kParameter:
+    case HloOpcode::kRng:
+      return false;
+    default:
+      return !AliasesOperands(inst) && !inst->HasSideEffect() &&
+             inst->called_computations().empty();
+  }
+}
+
+// The output of an instruction, which is live from its position until the
+// position of its last use.
+struct Value {
+  HloInstruction* inst;
+  int64 device;
+  int64 bytes;
+  int64 start;
+  int64 end;
+  // The positions of the users which use a clone of the instruction, where a
+  // copy of the output is live.
+  std::vector<int64> clones;
+};
+
+class LivenessModel {
+ public:
+  explicit LivenessModel(HloComputation* comp)
+      : order_(comp->MakeInstructionPostOrder()) {
+    const int64 num_instructions = order_.size();
+    for (int64 i = 0; i != num_instructions; ++i) {
+      position_[order_[i]] = i;
+    }
+    for (int64 i = 0; i != num_instructions; ++i) {
+      HloInstruction* inst = order_[i];
+      if (AliasesOperands(inst)) {
+        continue;
+      }
+      value_index_[inst] = values_.size();
+      max_device_ = std::max(max_device_, GetSingleShardingDeviceId(inst));
+      values_.push_back(Value{inst, GetSingleShardingDeviceId(inst),
+                              ArrayBytes(inst->shape()), i, LastUse(inst)});
+    }
+  }
+
+  const std::vector<Value>& values() const { return values_; }
+  int64 position(const HloInstruction* inst) const {
+    return position_.at(inst);
+  }
+
+  // The number of bytes live on `device` at each position.
+  std::vector<int64> LiveBytes(int64 device) const {
+    std::vector<int64> delta(order_.size() + 1, 0);
+    for (const Value& value : values_) {
+      if (value.device != device) {
+        continue;
+      }
+      delta[value.start] += value.bytes;
+      delta[value.end + 1] -= value.bytes;
+      for (int64 clone : value.clones) {
+        delta[clone] += value.bytes;
+        delta[clone + 1] -= value.bytes;
+      }
+    }
+    std::vector<int64> live(order_.size(), 0);
+    int64 bytes = 0;
+    for (size_t i = 0; i != order_.size(); ++i) {
+      bytes += delta[i];
+      live[i] = bytes;
+    }
+    return live;
+  }
+
+  // The device with the largest peak, its peak and the position of the peak.
+  void Peak(int64* device, int64* bytes, int64* position) const {
+    *bytes = -1;
+    for (int64 d = 0; d <= max_device_; ++d) {
+      const std::vector<int64> live = LiveBytes(d);
+      if (live.empty()) {
+        continue;
+      }
+      auto itr = absl::c_max_element(live);
+      if (*itr > *bytes) {
+        *device = d;
+        *bytes = *itr;
+        *position = std::distance(live.begin(), itr);
+      }
+    }
+  }
+
+  // The users of the value which is recomputed, in the order they are
+  // executed. Returns an empty list when the value cannot be recomputed for
+  // its users.
+  std::vector<int64> RecomputedUsers(const Value& value) const {
+    std::vector<int64> users;
+    const HloInstruction* inst = value.inst;
+    if (inst == inst->parent()->root_instruction()) {
+      return {};
+    }
+    for (const HloInstruction* user : inst->users()) {
+      // Recomputing for a tuple or a bitcast would not shorten the liveness of
+      // the output.
+      if (AliasesOperands(user)) {
+        return {};
+      }
+      users.push_back(position(user));
+    }
+    absl::c_sort(users);
+    users.erase(std::unique(users.begin(), users.end()), users.end());
+    return users;
+  }
+
+  // The values which are live while the output of `inst` is computed.
+  std::vector<int64> OperandValues(const HloInstruction* inst) const {
+    std::vector<int64> result;
+    std::vector<const HloInstruction*> to_visit(inst->operands().begin(),
+                                                inst->operands().end());
+    absl::flat_hash_set<const HloInstruction*> visited;
+    while (!to_visit.empty()) {
+      const HloInstruction* operand = to_visit.back();
+      to_visit.pop_back();
+      if (!visited.insert(operand).second) {
+        continue;
+      }
+      auto itr = value_index_.find(operand);
+      if (itr != value_index_.end()) {
+        result.push_back(itr->second);
+      } else {
+        to_visit.insert(to_visit.end(), operand->operands().begin(),
+                        operand->operands().end());
+      }
+    }
+    return result;
+  }
+
+  // Changes the liveness as if the value was recomputed for all but its first
+  // user, and its operands were kept live until its last user.
+  void Recompute(int64 index, const std::vector<int64>& users) {
+    Value& value = values_[index];
+    value.end = users.front();
+    value.clones.assign(users.begin() + 1, users.end());
+    for (int64 operand : OperandValues(value.inst)) {
+      values_[operand].end = std::max(values_[operand].end, users.back());
+    }
+  }
+
+ private:
+  // The position of the last instruction which uses the output of `inst`,
+  // looking through the instructions which alias their operands.
+  int64 LastUse(const HloInstruction* inst) const {
+    if (inst == inst->parent()->root_instruction()) {
+      return order_.size() - 1;
+    }
+    int64 last_use = position(inst);
+    for (const HloInstruction* user : inst->users()) {
+      last_use = std::max(last_use, AliasesOperands(user) ? LastUse(user)
+                                                          : position(user));
+    }
+    return last_use;
+  }
+
+  std::vector<HloInstruction*> order_;
+  absl::flat_hash_map<const HloInstruction*, int64> position_;
+  absl::flat_hash_map<const HloInstruction*, int64> value_index_;
+  std::vector<Value> values_;
+  int64 max_device_ = 0;
+};
+
+int64 MaxLiveBytes(const LivenessModel& model) {
+  int64 device, bytes, position;
+  model.Peak(&device, &bytes, &position);
+  return std::max<int64>(bytes, 0);
+}
+
+Status ApplyPlan(const RecomputationPlan& plan) {
+  for (HloInstruction* inst : plan.recomputed) {
+    HloComputation* comp = inst->parent();
+    // Only recompute the instruction itself.
+    for (HloInstruction* operand : inst->unique_operands()) {
+      HloInstruction* block =
+          comp->AddInstruction(CreateBlockRecompute(operand));
+      operand->SetupDerivedInstruction(block);
+      TF_RETURN_IF_ERROR(operand->ReplaceUseWith(inst, block));
+    }
+    HloInstruction* suggestion =
+        comp->AddInstruction(CreateSuggestRecompute(inst));
+    inst->SetupDerivedInstruction(suggestion);
+    TF_RETURN_IF_ERROR(inst->ReplaceAllUsesWith(suggestion));
+  }
+  return Status::OK();
+}
+}  // namespace
+
+RecomputationPlanner::RecomputationPlanner(int64 memory_target_bytes,
+                                           PipelineStageCostModel cost_model)
+    : memory_target_bytes_(memory_target_bytes), cost_model_(cost_model) {}
+
+StatusOr<RecomputationPlan> RecomputationPlanner::Plan(
+    HloComputation* comp) const {
+  HloCostAnalysis cost_analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  TF_RETURN_IF_ERROR(comp->Accept(&cost_analysis));
+
+  LivenessModel model(comp);
+  RecomputationPlan plan;
+  plan.max_live_bytes_before = MaxLiveBytes(model);
+
+  // The instructions which are recomputed, and their operands, are not
+  // candidates, so that each recomputation only changes the liveness of the
+  // values it was chosen for.
+  absl::flat_hash_set<int64> fixed;
+
+  while (static_cast<int64>(plan.recomputed.size()) < kMaxRecomputations) {
+    int64 device, peak_bytes, peak;
+    model.Peak(&device, &peak_bytes, &peak);
+    if (peak_bytes <= memory_target_bytes_) {
+      break;
+    }
+
+    // The largest values which are live across the peak.
+    std::vector<int64> candidates;
+    for (int64 i = 0; i != static_cast<int64>(model.values().size()); ++i) {
+      const Value& value = model.values()[i];
+      if (value.device == device && value.start < peak && value.end > peak &&
+          value.bytes > 0 && !fixed.contains(i) &&
+          IsRecomputable(value.inst)) {
+        candidates.push_back(i);
+      }
+    }
+    absl::c_stable_sort(candidates, [&model](int64 a, int64 b) {
+      return model.values()[a].bytes > model.values()[b].bytes;
+    });
+    if (static_cast<int64>(candidates.size()) > kMaxCandidates) {
+      candidates.resize(kMaxCandidates);
+    }
+
+    int64 best = -1;
+    double best_score = 0.0;
+    int64 best_cycles = 0;
+    std::vector<int64> best_users;
+    for (int64 candidate : candidates) {
+      const Value& value = model.values()[candidate];
+      std::vector<int64> users = model.RecomputedUsers(value);
+      if (users.size() < 2) {
+        continue;
+      }
+      const std::vector<int64> operands = model.OperandValues(value.inst);
+      if (absl::c_any_of(operands,
+                         [&fixed](int64 i) { return fixed.contains(i); })) {
+        continue;
+      }
+
+      LivenessModel trial = model;
+      trial.Recompute(candidate, users);
+      const std::vector<int64> live = trial.LiveBytes(device);
+      const int64 saved = peak_bytes - *absl::c_max_element(live);
+      if (saved <= 0) {
+        continue;
+      }
+      const int64 cycles =
+          EstimateInstructionCycles(value.inst, cost_analysis, cost_model_) *
+          (users.size() - 1);
+      const double score =
+          static_cast<double>(saved) / std::max<int64>(cycles, 1);
+      if (score > best_score) {
+        best = candidate;
+        best_score = score;
+        best_cycles = cycles;
+        best_users = std::move(users);
+      }
+    }
+
+    if (best < 0) {
+      VLOG(1) << "Cannot reduce the " << peak_bytes << " bytes live on IPU "
+              << device << " in " << comp->name()
+              << " below the recomputation memory target of "
+              << memory_target_bytes_ << " bytes.";
+      break;
+    }
+
+    HloInstruction* inst = model.values()[best].inst;
+    VLOG(2) << "Recomputing " << inst->name() << " for "
+            << best_users.size() - 1 << " users in " << best_cycles
+            << " cycles.";
+    fixed.insert(best);
+    for (int64 operand : model.OperandValues(inst)) {
+      fixed.insert(operand);
+    }
+    model.Recompute(best, best_users);
+    plan.recomputed.push_back(inst);
+    plan.recomputation_cycles += best_cycles;
+  }
+
+  plan.max_live_bytes_after = MaxLiveBytes(model);
+  return plan;
+}
+
+StatusOr<bool> RecomputationPlanner::Run(HloModule* module) {
+  if (memory_target_bytes_ <= 0) {
+    return false;
+  }
+
+  // Like SuggestRecompute, there is no recomputation in the resource update of
+  // pipelines.
+  absl::flat_hash_set<HloComputation*> no_recomputation_computations;
+  TF_ASSIGN_OR_RETURN(std::vector<HloInstruction*> pipeline_ops,
+                      GetPipelines(module));
+  for (HloInstruction* pipeline_op : pipeline_ops) {
+    TF_ASSIGN_OR_RETURN(PipelineStages stages,
+                        GetPipelineStages(pipeline_op->to_apply()));
+    if (stages.resource_update) {
+      no_recomputation_computations.insert(
+          (*stages.resource_update)->to_apply());
+    }
+  }
+
+  bool changed = false;
+  for (HloComputation* comp : module->MakeComputationPostOrder()) {
+    if (IsPopOpsFusion(comp) || comp->IsFusionComputation() ||
+        no_recomputation_computations.contains(comp)) {
+      continue;
+    }
+
+    TF_ASSIGN_OR_RETURN(RecomputationPlan plan, Plan(comp));
+    if (plan.recomputed.empty()) {
+      continue;
+    }
+    VLOG(1) << "Recomputing " << plan.recomputed.size() << " instructions in "
+            << comp->name() << " reduces the estimated peak from "
+            << plan.max_live_bytes_before << " to "
+            << plan.max_live_bytes_after << " bytes for "
+            << plan.recomputation_cycles << " cycles.";
+    TF_RETURN_IF_ERROR(ApplyPlan(plan));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
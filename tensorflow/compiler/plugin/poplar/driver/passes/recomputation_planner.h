@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_RECOMPUTATION_PLANNER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_RECOMPUTATION_PLANNER_H_
+
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_balancer.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+
+class HloComputation;
+class HloInstruction;
+class HloModule;
+
+namespace poplarplugin {
+
+struct RecomputationPlan {
+  // The instructions which are recomputed for each of their users after the
+  // first one, in the order they were chosen.
+  std::vector<HloInstruction*> recomputed;
+  // The largest number of bytes live on any IPU at any point of the
+  // computation, before and after the recomputation.
+  int64 max_live_bytes_before = 0;
+  int64 max_live_bytes_after = 0;
+  // The estimated number of cycles spent recomputing.
+  int64 recomputation_cycles = 0;
+};
+
+/**
+ * Pass which chooses the instructions to recompute so that the number of bytes
+ * live on each IPU stays below a memory target, while recomputing as few
+ * cycles as possible.
+ *
+ * The liveness of the outputs of the instructions is estimated from the post
+ * order of each computation. While an IPU is above the target, the
+ * instructions which are live at its peak are tried in turn, and the one which
+ * removes the most bytes from the peak for each estimated cycle of
+ * recomputation is chosen. Recomputing an instruction keeps its operands live
+ * until its last user.
+ *
+ * The chosen instructions are marked with a recomputation suggestion, and
+ * their operands with a recomputation block so that only the instruction
+ * itself is recomputed. The suggestions are applied by the existing
+ * recomputation passes.
+ */
+class RecomputationPlanner : public HloModulePass {
+ public:
+  explicit RecomputationPlanner(int64 memory_target_bytes,
+                                PipelineStageCostModel cost_model = {});
+
+  absl::string_view name() const override { return "recomputation-planner"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // Chooses the instructions of `comp` to recompute, without modifying it.
+  StatusOr<RecomputationPlan> Plan(HloComputation* comp) const;
+
+ private:
+  const int64 memory_target_bytes_;
+  const PipelineStageCostModel cost_model_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_RECOMPUTATION_PLANNER_H_
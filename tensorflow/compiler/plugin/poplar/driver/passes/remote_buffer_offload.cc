@@ -0,0 +1,199 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/remote_buffer_offload.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/remote_parameter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_creation_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+// Returns whether the value of the instruction is a tensor which can be
+// moved to remote memory. Parameters are left to the variable offloading, and
+// the outputs of some instructions are already remote buffers.
+bool IsOffloadable(const HloInstruction* inst) {
+  if (!inst->shape().IsArray() ||
+      ShapeUtil::IsZeroElementArray(inst->shape())) {
+    return false;
+  }
+  switch (inst->opcode()) {
+    case HloOpcode::kConstant:
+    case HloOpcode::kParameter: {
+      return false;
+    }
+    default: { break; }
+  }
+  return !(IsPoplarInstruction(PoplarOp::BufferStoreSlice)(inst) ||
+           IsPoplarInstruction(PoplarOp::CreateBuffer)(inst) ||
+           IsPoplarInstruction(PoplarOp::GradientAccumulatorCreate)(inst) ||
+           IsPoplarInstruction(PoplarOp::RemoteParameterStore)(inst));
+}
+
+struct OffloadCandidate {
+  HloInstruction* inst;
+  int64 size;
+  // The positions of the uses before and after the longest idle interval of
+  // the value.
+  int64 idle_start;
+  int64 idle_end;
+};
+
+Status Offload(HloComputation* comp, const OffloadCandidate& candidate,
+               const std::vector<HloInstruction*>& sequence,
+               const absl::flat_hash_map<HloInstruction*, int64>& positions) {
+  HloInstruction* inst = candidate.inst;
+  VLOG(2) << "Offloading " << inst->name() << " (" << candidate.size
+          << " bytes) between positions " << candidate.idle_start << " and "
+          << candidate.idle_end << ".";
+
+  // The remote buffers are sliceable on the outer dimension, store the value
+  // as its only slice.
+  const Shape slice_shape = ShapeUtil::PrependMajorDimension(1, inst->shape());
+  HloInstruction* buffer = comp->AddInstruction(
+      CreateHloCreateBuffer(slice_shape, /*is_remote=*/true));
+  HloInstruction* zero = MakeR0ConstantHlo<int32>(comp, 0);
+  TF_ASSIGN_OR_RETURN(HloInstruction * reshaped,
+                      MakeReshapeHlo(slice_shape, inst));
+  HloInstruction* store =
+      comp->AddInstruction(CreateBufferStoreSlice(buffer, reshaped, zero));
+  HloInstruction* load =
+      comp->AddInstruction(CreateBufferLoadSlice(slice_shape, store, zero));
+  TF_ASSIGN_OR_RETURN(HloInstruction * loaded,
+                      MakeReshapeHlo(inst->shape(), load));
+  for (HloInstruction* new_inst :
+       {buffer, zero, reshaped, store, load, loaded}) {
+    CopyShardingIfPresent(inst, new_inst);
+  }
+
+  // Use the loaded value after the idle interval.
+  const std::vector<HloInstruction*> users = inst->users();
+  for (HloInstruction* user : users) {
+    if (positions.at(user) >= candidate.idle_end) {
+      TF_RETURN_IF_ERROR(inst->ReplaceUseWith(user, loaded));
+    }
+  }
+
+  // Store the value before and load it after the idle interval. The edges go
+  // forward in the post order, so they cannot create a cycle.
+  TF_RETURN_IF_ERROR(
+      store->AddControlDependencyTo(sequence[candidate.idle_start + 1]));
+  TF_RETURN_IF_ERROR(
+      sequence[candidate.idle_end - 1]->AddControlDependencyTo(load));
+  return Status::OK();
+}
+}  // namespace
+
+RemoteBufferOffload::RemoteBufferOffload(bool remote_memory_supported,
+                                         int64 minimum_remote_tensor_size,
+                                         int64 minimum_idle_instructions)
+    : remote_memory_supported_(remote_memory_supported),
+      minimum_remote_tensor_size_(minimum_remote_tensor_size),
+      minimum_idle_instructions_(minimum_idle_instructions) {}
+
+StatusOr<bool> RemoteBufferOffload::Run(HloModule* module) {
+  if (!remote_memory_supported_ || minimum_idle_instructions_ <= 0) {
+    return false;
+  }
+
+  HloComputation* comp = module->entry_computation();
+  const std::vector<HloInstruction*> sequence =
+      comp->MakeInstructionPostOrder();
+  const int64 num_positions = sequence.size();
+  absl::flat_hash_map<HloInstruction*, int64> positions;
+  for (int64 i = 0; i != num_positions; ++i) {
+    positions[sequence[i]] = i;
+  }
+
+  // Estimate the number of bytes live at each position, and find the longest
+  // idle interval of each value which could be offloaded.
+  std::vector<int64> live_bytes(num_positions + 1, 0);
+  std::vector<OffloadCandidate> candidates;
+  for (int64 i = 0; i != num_positions; ++i) {
+    HloInstruction* inst = sequence[i];
+    if (!inst->shape().IsArray()) {
+      continue;
+    }
+    std::vector<int64> uses = {i};
+    for (const HloInstruction* user : inst->users()) {
+      uses.push_back(positions.at(user));
+    }
+    if (inst == comp->root_instruction()) {
+      uses.push_back(num_positions - 1);
+    }
+    std::sort(uses.begin(), uses.end());
+
+    const int64 size = ShapeUtil::ByteSizeOf(inst->shape());
+    live_bytes[i] += size;
+    live_bytes[uses.back() + 1] -= size;
+
+    if (size < minimum_remote_tensor_size_ || !IsOffloadable(inst) ||
+        inst == comp->root_instruction()) {
+      continue;
+    }
+    OffloadCandidate candidate = {inst, size, 0, 0};
+    for (int64 j = 1; j < static_cast<int64>(uses.size()); ++j) {
+      if (uses[j] - uses[j - 1] > candidate.idle_end - candidate.idle_start) {
+        candidate.idle_start = uses[j - 1];
+        candidate.idle_end = uses[j];
+      }
+    }
+    if (candidate.idle_end - candidate.idle_start - 1 >=
+        minimum_idle_instructions_) {
+      candidates.push_back(candidate);
+    }
+  }
+  for (int64 i = 1; i != num_positions; ++i) {
+    live_bytes[i] += live_bytes[i - 1];
+  }
+  live_bytes.pop_back();
+
+  // Offloading only saves memory if it lowers the peak, so offload the
+  // largest values first, and only those which are idle at the current peak.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const OffloadCandidate& a, const OffloadCandidate& b) {
+                     return a.size > b.size;
+                   });
+  bool changed = false;
+  for (const OffloadCandidate& candidate : candidates) {
+    const int64 peak = *std::max_element(live_bytes.begin(), live_bytes.end());
+    const auto idle_begin = live_bytes.begin() + candidate.idle_start + 1;
+    const auto idle_end = live_bytes.begin() + candidate.idle_end;
+    if (*std::max_element(idle_begin, idle_end) != peak) {
+      continue;
+    }
+    TF_RETURN_IF_ERROR(Offload(comp, candidate, sequence, positions));
+    std::for_each(idle_begin, idle_end,
+                  [&candidate](int64& bytes) { bytes -= candidate.size; });
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
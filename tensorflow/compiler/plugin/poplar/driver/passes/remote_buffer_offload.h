@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_REMOTE_BUFFER_OFFLOAD_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_REMOTE_BUFFER_OFFLOAD_H_
+
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+
+class HloModule;
+
+namespace poplarplugin {
+
+/**
+ * This pass moves large intermediate values of the entry computation into
+ * remote memory while they are not used, in the spirit of memory space
+ * assignment with the tile memory as the default memory and the remote
+ * memory as the alternate one.
+ *
+ * The cost analysis orders the entry computation in post order, and for each
+ * value finds the longest interval between two consecutive uses. A value is
+ * a candidate if it has at least `minimum_remote_tensor_size` bytes and is
+ * idle for at least `minimum_idle_instructions` instructions. Offloading a
+ * value costs two transfers over the exchange and only helps when it lowers
+ * the peak of the estimated live bytes, so the candidates are taken from the
+ * largest down, and each is only offloaded if its idle interval covers the
+ * current peak.
+ *
+ * For example given:
+ *
+ * entry {
+ *   a = f32[1024,1024] ...
+ *   b = f32[1024,1024] dot(a, ...)
+ *   ... <- a is idle
+ *   c = f32[1024,1024] add(a, ...)
+ * }
+ *
+ * Turn it into:
+ *
+ * entry {
+ *   a = f32[1024,1024] ...
+ *   b = f32[1024,1024] dot(a, ...)
+ *   buffer = f32[1,1024,1024] create-buffer(), is_remote=true
+ *   a_slice = f32[1,1024,1024] reshape(a)
+ *   store = f32[1,1024,1024] buffer-store-slice(buffer, a_slice, 0)
+ *   ... <- a is in remote memory
+ *   load = f32[1,1024,1024] buffer-load-slice(store, 0)
+ *   a_loaded = f32[1024,1024] reshape(load)
+ *   c = f32[1024,1024] add(a_loaded, ...)
+ * }
+ *
+ * Control dependencies keep the store before the idle interval and the load
+ * after it, so that the scheduler cannot undo the offloading.
+ */
+class RemoteBufferOffload : public HloModulePass {
+ public:
+  RemoteBufferOffload(bool remote_memory_supported,
+                      int64 minimum_remote_tensor_size,
+                      int64 minimum_idle_instructions);
+
+  absl::string_view name() const override { return "remote-buffer-offload"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  const bool remote_memory_supported_;
+  const int64 minimum_remote_tensor_size_;
+  const int64 minimum_idle_instructions_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_PASSES_REMOTE_BUFFER_OFFLOAD_H_
@@ -223,9 +223,11 @@ using DecreasingSizeQueue =
     std::priority_queue<HloInstruction*, std::vector<HloInstruction*>,
                         DecreasingSizeComparator>;
 
+// When `include_uncombined` is set, the instructions which could not be
+// combined with any other are returned as well.
 StatusOr<std::vector<HloInstruction*>> CombineFromDifferentShards(
     HloComputation* comp, std::map<int64, DecreasingSizeQueue> shard_queues,
-    TensorAllocationMap& allocation_map) {
+    TensorAllocationMap& allocation_map, bool include_uncombined) {
   std::vector<HloInstruction*> combined;
 
   while (true) {
@@ -241,6 +243,10 @@ StatusOr<std::vector<HloInstruction*>> CombineFromDifferentShards(
     }
 
     if (to_combine.size() < 2) {
+      if (include_uncombined && to_combine.size() == 1) {
+        combined.push_back(to_combine[0]);
+        continue;
+      }
       break;
     }
 
@@ -253,6 +259,9 @@ StatusOr<std::vector<HloInstruction*>> CombineFromDifferentShards(
     // not the case, we just bail out of this attempt and try the next.
     if (!IndependentlySchedulable(to_combine, *reachability_map)) {
       VLOG(2) << "Skipping combination because of dependencies";
+      if (include_uncombined) {
+        combined.insert(combined.end(), to_combine.begin(), to_combine.end());
+      }
       continue;
     }
 
@@ -285,9 +294,20 @@ Status ScheduleAllUsersBefore(HloInstruction* inst, HloInstruction* successor,
   return Status::OK();
 }
 
+int64 GetTotalByteSize(const Shape& shape) {
+  int64 size = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&size](const Shape& subshape, const ShapeIndex&) {
+        if (subshape.IsArray()) {
+          size += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return size;
+}
+
 Status AddSchedulingConstraints(
     HloComputation* comp, const std::vector<HloInstruction*>& combined_loads,
-    const std::vector<HloInstruction*>& combined_stores) {
+    const std::vector<HloInstruction*>& combined_stores, int64 prefetch_size) {
   if (combined_loads.size() != combined_stores.size()) {
     // They're not matching up, bail out.
     return Status::OK();
@@ -298,13 +318,28 @@ Status AddSchedulingConstraints(
   for (std::size_t i = 1; i < combined_loads.size(); ++i) {
     auto* load = combined_loads[i];
 
+    // A load which fits in the prefetch size is double buffered: it is
+    // scheduled before the users of the previous load, so that it is in flight
+    // while the previous weight update is computed, and only after the store
+    // of the load before that.
+    const bool prefetch =
+        prefetch_size > 0 && GetTotalByteSize(load->shape()) <= prefetch_size;
+    if (prefetch) {
+      for (auto* user : combined_loads[i - 1]->users()) {
+        if (!reachability_map->IsReachable(user, load)) {
+          TF_RETURN_IF_ERROR(load->AddControlDependencyTo(user));
+          reachability_map->UpdateReachabilityThroughInstruction(user);
+        }
+      }
+    }
+
     // To minimize liveness we aim towards having the least amount of overlap.
     // So first we try to schedule load[i] after store[i - 1], and if this is
     // not possible, we try to schedule it after store[i - 2] and so forth. A
     // typical reason why the first single-delay attempt might fail is when
     // using optimizers that require two offloaded parameters for each weight
     // update (like LAMB/ADAM that require both the first and second moments).
-    for (std::size_t delay = 1; delay <= i; ++delay) {
+    for (std::size_t delay = prefetch ? 2 : 1; delay <= i; ++delay) {
       auto* prev_load = combined_loads[i - delay];
 
       // To minimze liveness, we also try to schedule all users of the previous
@@ -346,17 +381,23 @@ StatusOr<bool> RemoteParameterParallelCombiner::RunOnComputation(
     }
   }
 
-  TF_ASSIGN_OR_RETURN(const auto combined_loads,
-                      CombineFromDifferentShards(comp, std::move(shard_loads),
-                                                 allocation_map_));
+  // When prefetching, the loads and stores which are not combined are also
+  // constrained, so that the loads of a single IPU are double buffered.
+  const bool include_uncombined = prefetch_size_ > 0;
+
+  TF_ASSIGN_OR_RETURN(
+      const auto combined_loads,
+      CombineFromDifferentShards(comp, std::move(shard_loads), allocation_map_,
+                                 include_uncombined));
 
-  TF_ASSIGN_OR_RETURN(const auto combined_stores,
-                      CombineFromDifferentShards(comp, std::move(shard_stores),
-                                                 allocation_map_));
+  TF_ASSIGN_OR_RETURN(
+      const auto combined_stores,
+      CombineFromDifferentShards(comp, std::move(shard_stores),
+                                 allocation_map_, include_uncombined));
 
   // Try to help the scheduler a bit by adding some constraints.
-  TF_RETURN_IF_ERROR(
-      AddSchedulingConstraints(comp, combined_loads, combined_stores));
+  TF_RETURN_IF_ERROR(AddSchedulingConstraints(comp, combined_loads,
+                                              combined_stores, prefetch_size_));
 
   return !combined_loads.empty() || !combined_stores.empty();
 }
@@ -28,11 +28,18 @@ namespace poplarplugin {
 /**
  * This pass tries to combine remote parameter loads and stores that can be
  * executed in parallel.
+ *
+ * The combined loads and stores are scheduled one after the other, from the
+ * smallest to the largest. When `prefetch_size` is not zero, the loads of at
+ * most `prefetch_size` bytes are double buffered: each one is scheduled before
+ * the weight update which uses the previous load, trading the memory of one
+ * more loaded parameter for hiding the latency of the remote memory.
  */
 class RemoteParameterParallelCombiner : public HloModulePass {
  public:
-  explicit RemoteParameterParallelCombiner(TensorAllocationMap& allocation_map)
-      : allocation_map_(allocation_map) {}
+  explicit RemoteParameterParallelCombiner(TensorAllocationMap& allocation_map,
+                                           int64 prefetch_size = 0)
+      : allocation_map_(allocation_map), prefetch_size_(prefetch_size) {}
 
   absl::string_view name() const override {
     return "remote-parameter-parallel-combiner";
@@ -44,6 +51,7 @@ class RemoteParameterParallelCombiner : public HloModulePass {
 
  private:
   TensorAllocationMap& allocation_map_;
+  const int64 prefetch_size_;
 };
 
 }  // namespace poplarplugin
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/all_gather.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/reduce_scatter.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/remote_parameter.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/replication_factor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/replication_index.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/math/math_util.h"
 
 namespace xla {
 namespace poplarplugin {
@@ -369,12 +371,45 @@ Status RewriteClusterInput(
     return Status::OK();
   }
 
+  // If it's an all-reduce which is only used by the cluster, each replica only
+  // needs its own shard of the sum, so replace it with a reduce-scatter. The
+  // reduce-scatter shards are only the same as the sliced shards when no extra
+  // alignment padding was added.
+  auto cluster_input_shape = cluster_input->shape();
+  if (IsSupportedAllReduce(cluster_input) &&
+      cluster_input->operand_count() == 1 &&
+      shard_size == tensorflow::MathUtil::CeilOfRatio<int64>(
+                        cluster_size, replication_factor) &&
+      !input_slices.contains(cluster_input) &&
+      absl::c_all_of(cluster_input->users(), [&cluster](HloInstruction* user) {
+        return cluster.In(user);
+      })) {
+    VLOG(2) << "Rewriting all-reduce cluster input "
+            << cluster_input->ToString();
+    Shape flat_shape = ShapeUtil::MakeShape(cluster_input_shape.element_type(),
+                                            {cluster_size});
+    HloInstruction* flat =
+        cluster_comp->AddInstruction(HloInstruction::CreateReshape(
+            flat_shape, cluster_input->mutable_operand(0)));
+    Shape scattered_shape = ShapeUtil::MakeShape(
+        cluster_input_shape.element_type(), {shard_size});
+    HloInstruction* reduce_scatter = cluster_comp->AddInstruction(
+        CreateReduceScatter({flat}, scattered_shape));
+    VLOG(2) << "Reduce scatter: " << reduce_scatter->ToString();
+    // The all-reduce is left without users and removed by DCE.
+    const std::vector<HloInstruction*> users = cluster_input->users();
+    for (auto user : users) {
+      TF_RETURN_IF_ERROR(
+          cluster_input->ReplaceUseWithDifferentShape(user, reduce_scatter));
+    }
+    return Status::OK();
+  }
+
   // All other inputs have to be sliced with dynamic-slice(input,
   // replication-index()) Reuse dynamic-slice for input in case of multiple
   // users
   VLOG(2) << "Rewriting cluster input " << cluster_input->ToString();
 
-  auto cluster_input_shape = cluster_input->shape();
   HloInstruction*& cluster_input_slice = input_slices[cluster_input];
   for (auto inst : cluster.insts) {
     if (inst->IsUserOf(cluster_input)) {
@@ -18,6 +18,7 @@ limitations under the License.
 #include <map>
 #include <vector>
 
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/backend_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_annotations.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
@@ -179,6 +180,79 @@ StatusOr<int64> ConvertWhileToRepeat(HloInstruction* while_inst) {
   return number_of_iterations;
 }
 
+// Returns the index of the element of the loop state which is the number of
+// iterations of a loop of the form "i = 0; while (i < n) { ...; i += 1; }",
+// where `n` is a scalar which the loop does not change. This is the form of
+// the loops with a `maximum_iterations` tensor.
+StatusOr<int64> GetRuntimeTripCountIndex(HloInstruction* while_inst) {
+  static const char* err_msg = "Unable to find the trip count of this loop";
+  HloComputation* while_condition = while_inst->while_condition();
+  HloComputation* while_body = while_inst->while_body();
+  if (while_condition->instruction_count() != 4) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  const HloInstruction* c_inst = while_condition->root_instruction();
+  if (c_inst->opcode() != HloOpcode::kCompare ||
+      c_inst->comparison_direction() != ComparisonDirection::kLt) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  const HloInstruction* counter = c_inst->operand(0);
+  const HloInstruction* limit = c_inst->operand(1);
+  if (!WhileLoopUtil::IsGTEFromParamIndex(counter, 0) ||
+      !WhileLoopUtil::IsGTEFromParamIndex(limit, 0) ||
+      !ShapeUtil::IsScalarWithElementType(counter->shape(), S32) ||
+      !ShapeUtil::IsScalarWithElementType(limit->shape(), S32)) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  const int64 counter_index = counter->tuple_index();
+  const int64 limit_index = limit->tuple_index();
+
+  // The counter starts at 0.
+  const HloInstruction* input_tuple = while_inst->operand(0);
+  if (input_tuple->opcode() != HloOpcode::kTuple) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  const HloInstruction* init_inst = input_tuple->operand(counter_index);
+  if (init_inst->opcode() != HloOpcode::kConstant ||
+      !init_inst->literal().IsZero({})) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  // The limit is passed through the body unchanged.
+  const HloInstruction* body_root = while_body->root_instruction();
+  if (body_root->opcode() != HloOpcode::kTuple) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  const HloInstruction* limit_output = body_root->operand(limit_index);
+  if (!WhileLoopUtil::IsGTEFromParamIndex(limit_output, 0) ||
+      limit_output->tuple_index() != limit_index) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  // The counter is incremented by 1.
+  const HloInstruction* body_GTE = nullptr;
+  for (const HloInstruction* user :
+       while_body->parameter_instruction(0)->users()) {
+    if (WhileLoopUtil::IsGTEFromParamIndex(user, 0) &&
+        user->tuple_index() == counter_index) {
+      if (body_GTE) {
+        return xla::FailedPrecondition("%s", err_msg);
+      }
+      body_GTE = user;
+    }
+  }
+  if (body_GTE == nullptr) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  auto matching_increments =
+      WhileLoopUtil::FindMatchingLoopDeltasInsideBody(body_GTE, while_body);
+  if (matching_increments.size() != 1 || matching_increments[0].second != 1) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  return limit_index;
+}
+
 template <typename NativeT>
 HloInstruction* GetFinalValue(HloInstruction* init_value_inst,
                               const int64 number_of_iterations,
@@ -191,8 +265,11 @@ HloInstruction* GetFinalValue(HloInstruction* init_value_inst,
       HloInstruction::CreateConstant(LiteralUtil::CreateR0(value)));
 }
 
-HloInstruction* ConvertToRepeat(HloInstruction* while_inst,
-                                const int64 number_of_iterations) {
+// If `runtime_count_index` is set, the number of iterations is the value of
+// that element of the loop state rather than `number_of_iterations`.
+HloInstruction* ConvertToRepeat(
+    HloInstruction* while_inst, const int64 number_of_iterations,
+    absl::optional<int64> runtime_count_index = absl::nullopt) {
   // We represent repeat as kCall and store the number of iterations in the
   // backend config field. We clone the repeat computation and use it as the
   // computation for the call.
@@ -204,7 +281,7 @@ HloInstruction* ConvertToRepeat(HloInstruction* while_inst,
   HloInstruction* input_tuple = while_inst->mutable_operand(0);
 
   // If the number of iterations is 0, don't create a loop.
-  if (number_of_iterations == 0) {
+  if (number_of_iterations == 0 && !runtime_count_index) {
     return input_tuple;
   }
 
@@ -227,8 +304,10 @@ HloInstruction* ConvertToRepeat(HloInstruction* while_inst,
   // * The input to the tuple is a constant
   // * The value is accessed from the input tuple at index x, modified by 1 (add
   // or subtract), stored in the output tuple at index x.
-  for (int64 tuple_index = 0; tuple_index < input_tuple->operand_count();
-       tuple_index++) {
+  // The final values are not known when the number of iterations is not.
+  const int64 num_known_values =
+      runtime_count_index ? 0 : input_tuple->operand_count();
+  for (int64 tuple_index = 0; tuple_index < num_known_values; tuple_index++) {
     HloInstruction* operand = input_tuple->mutable_operand(tuple_index);
     // Skip if it is not a integer scalar constant
     if (!WhileLoopUtil::Is32BitsOrLessIntegerConstant(operand)) {
@@ -396,6 +475,10 @@ HloInstruction* ConvertToRepeat(HloInstruction* while_inst,
   call_config->set_type(PoplarBackendConfig::CallConfig::RepeatLoop);
   auto* repeat_cfg = call_config->mutable_repeat_config();
   repeat_cfg->set_repeat_count(number_of_iterations);
+  if (runtime_count_index) {
+    repeat_cfg->set_runtime_repeat_count(true);
+    repeat_cfg->set_repeat_count_index(*runtime_count_index);
+  }
   repeat_call->set_backend_config(backend_config);
 
   // Copy sharding info from the while_inst to the repeat.
@@ -450,6 +533,7 @@ StatusOr<bool> WhileLoopToRepeatSimplify::Run(HloModule* module) {
         // into a repeat.
         auto statusor = ConvertWhileToRepeat(while_inst);
         int64 count = 0;
+        absl::optional<int64> runtime_count_index;
         bool simplified = false;
         if (statusor.ok()) {
           simplified = true;
@@ -457,21 +541,48 @@ StatusOr<bool> WhileLoopToRepeatSimplify::Run(HloModule* module) {
         } else {
           statusor.IgnoreError();
 
-          // Ignore the error and try the brute force method
-          auto op_count =
-              ComputeWhileLoopTripCount(while_inst, GetMaxLoopTripCount());
-          if (op_count) {
+          // Ignore the error and try to compute the trip count in closed form.
+          auto trip_count_statusor =
+              WhileLoopUtil::ComputeTripCount(while_inst);
+          if (trip_count_statusor.ok()) {
             simplified = true;
-            count = *op_count;
+            count = trip_count_statusor.ValueOrDie();
+          } else {
+            trip_count_statusor.IgnoreError();
+
+            // Fall back to the brute force method.
+            auto op_count =
+                ComputeWhileLoopTripCount(while_inst, GetMaxLoopTripCount());
+            if (op_count) {
+              simplified = true;
+              count = *op_count;
+            } else {
+              // The loop can still be a repeat if the number of iterations is
+              // an input of it, so that it can change between executions.
+              auto index_statusor = GetRuntimeTripCountIndex(while_inst);
+              if (index_statusor.ok()) {
+                simplified = true;
+                runtime_count_index = index_statusor.ValueOrDie();
+              } else {
+                index_statusor.IgnoreError();
+              }
+            }
           }
         }
 
         if (simplified) {
-          HloInstruction* repeat_call = ConvertToRepeat(while_inst, count);
+          HloInstruction* repeat_call =
+              ConvertToRepeat(while_inst, count, runtime_count_index);
           while_inst->ReplaceAllUsesWith(repeat_call);
 
-          VLOG(1) << "Simplified while loop " << while_inst->name()
-                  << " with a repeat of count " << count;
+          if (runtime_count_index) {
+            VLOG(1) << "Simplified while loop " << while_inst->name()
+                    << " with a repeat of the count in element "
+                    << *runtime_count_index << " of its inputs";
+          } else {
+            VLOG(1) << "Simplified while loop " << while_inst->name()
+                    << " with a repeat of count " << count;
+          }
 
           while_inst->parent()->RemoveInstructionAndUnusedOperands(while_inst);
           PruneComputations(module);
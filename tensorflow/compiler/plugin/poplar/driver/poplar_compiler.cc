@@ -31,6 +31,7 @@ limitations under the License.
 #include <poplar/replication_factor.hpp>
 #include <poplin/codelets.hpp>
 #include <popnn/codelets.hpp>
+#include <popops/Zero.hpp>
 #include <popops/codelets.hpp>
 #include <poprand/RandomGen.hpp>
 #include <poprand/codelets.hpp>
@@ -41,6 +42,7 @@ limitations under the License.
 
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
 #include "tensorflow/compiler/plugin/poplar/driver/ops/ops.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/add_block_recompute.h"
@@ -75,10 +77,12 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/passes/host_embedding_notification.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/inplace_finder.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/inter_ipu_copy_inserter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/inter_ipu_copy_schedule_optimizer.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/lift_recompute_suggestion.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/lower_frontend_attributes.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/matmul_combiner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/module_flatten.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/multi_conv_combiner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/multi_conv_fixer.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/multi_slice_combiner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/multi_update_apply.h"
@@ -99,12 +103,15 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_optimizer.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_recomputation.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_recomputation_stage_inserter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_balancer.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_merger.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_tuple_remover.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_verifier.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/poplar_algebraic_simplifier.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/post_serialize_gradient_accumulation.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/recomputation_planner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/recompute_instructions.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/remote_buffer_offload.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/remote_parameter_parallel_combiner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/remove_blocked_recompute_suggestions.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/remove_recompute_suggestions.h"
@@ -125,31 +132,41 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/passes/wide_const_finder.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executable.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/poplar_feed_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_platform_id.h"
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/clustering_scheduler.h"
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/ipu_scheduler.h"
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/liveness_look_ahead_scheduler.h"
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/shortest_path_scheduler.h"
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/sync_list_scheduler.h"
+#include "tensorflow/compiler/plugin/poplar/driver/schedulers/tile_memory_estimator.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/convolution_preplanning.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/data_initializer.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/block_sparse_preplanning.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/embedding_plans_preplanning.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/executable_cache.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_autotuner.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_hash.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/ipu_activity_recorder.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matmul_preplanning.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/visitors/entry_visitor.h"
 #include "tensorflow/compiler/xla/service/call_graph.h"
 #include "tensorflow/compiler/xla/service/cholesky_expander.h"
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/computation_placer.h"
+#include "tensorflow/compiler/xla/service/dump.h"
 #include "tensorflow/compiler/xla/service/dynamic_index_splitter.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
 #include "tensorflow/compiler/xla/service/hlo_cse.h"
 #include "tensorflow/compiler/xla/service/hlo_dce.h"
 #include "tensorflow/compiler/xla/service/hlo_get_dimension_size_rewriter.h"
 #include "tensorflow/compiler/xla/service/hlo_graph_dumper.h"
+#include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/map_inliner.h"
@@ -164,6 +181,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/stream_executor/lib/initialize.h"
 
@@ -403,12 +421,12 @@ StatusOr<poplar::program::Program> InitializeSeed(poplar::Graph& graph,
   graph.setTileMapping(seed, 0);
 
   poplar::program::Sequence seq;
-  if (!UseSyntheticData()) {
+  if (!UseSyntheticDataFor(SyntheticDataCategory::Seed)) {
     // Copy the seed from the data stream and set it.
     auto data_stream = graph.addHostToDeviceFIFO(
         GetRandomNumberSeedStream(), seed.elementType(), seed.numElements());
     seq.add(poplar::program::Copy(data_stream, seed));
-  } else if (UseSyntheticData() && UseSyntheticDataInitializer()) {
+  } else if (UseSyntheticDataInitializer()) {
     // Initialize the seed on the device.
     auto& initializer = DataInitializer::GetSyntheticDataInitializer();
     TF_ASSIGN_OR_RETURN(auto literal,
@@ -437,6 +455,31 @@ bool InitializeCycleCounter(poplar::Graph& graph,
   }
 }
 
+// Zeroes the cycle counters of the instructions in `zeroing` and streams them
+// to the host in `seq`, and returns the names of their instructions in the
+// order of the counters in the stream.
+std::vector<std::string> InitializeInstructionCycleCounters(
+    CompilerResources& res, poplar::program::Sequence& zeroing,
+    poplar::program::Sequence& seq) {
+  std::vector<std::string> names;
+  if (res.instruction_cycle_counters.empty()) {
+    return names;
+  }
+  std::vector<poplar::Tensor> counters;
+  for (const auto& pair : res.instruction_cycle_counters) {
+    names.push_back(pair.first);
+    counters.push_back(pair.second);
+  }
+  poplar::Graph& graph = GetMasterGraph(res);
+  poplar::Tensor all_counters = poplar::concat(counters);
+  popops::zero(graph, all_counters, zeroing, "ZeroInstructionCycleCounters");
+  poplar::DataStream fifo = graph.addDeviceToHostFIFO(
+      PoplarExecutor::GetInstructionCycleCounterStream(),
+      all_counters.elementType(), all_counters.numElements());
+  seq.add(poplar::program::Copy(all_counters, fifo));
+  return names;
+}
+
 void setFpBehaviour(poplar::Graph& graph,
                     const IpuOptions::FloatingPointBehaviour& fp_control,
                     poplar::program::Sequence& seq) {
@@ -475,6 +518,80 @@ StatusOr<int> GetNumIoTiles(const PoplarExecutor* poplar_executor) {
   return value;
 }
 
+template <typename Preplanning>
+Status RunPreplanning(const HloModule* module, CompilerResources& resources) {
+  try {
+    Preplanning preplanning;
+    return preplanning.Plan(module, resources);
+  } catch (const std::exception& e) {
+    return PoplarExceptionToTensorflowStatus("[Preplanning] ", e);
+  }
+}
+
+// The embedding, convolution and matmul preplanners only use their own parts
+// of the resources (the slice plans and the planning caches), so they are run
+// concurrently. The block-sparse plans are created after the embedding plans.
+Status PreplanOperations(const HloModule* module,
+                         CompilerResources& resources) {
+  Status convolution_status;
+  Status matmul_status;
+  Status embeddings_status;
+  Status block_sparse_status;
+  {
+    tensorflow::Env* env = tensorflow::Env::Default();
+    std::unique_ptr<tensorflow::Thread> convolution_thread(env->StartThread(
+        tensorflow::ThreadOptions(), "convolution_preplanning", [&]() {
+          convolution_status =
+              RunPreplanning<ConvolutionPreplanning>(module, resources);
+        }));
+    std::unique_ptr<tensorflow::Thread> matmul_thread(env->StartThread(
+        tensorflow::ThreadOptions(), "matmul_preplanning", [&]() {
+          matmul_status = RunPreplanning<MatMulPreplanning>(module, resources);
+        }));
+    embeddings_status =
+        RunPreplanning<EmbeddingPlansPreplanning>(module, resources);
+    block_sparse_status =
+        RunPreplanning<BlockSparsePreplanning>(module, resources);
+    // The threads are joined when they are destroyed.
+  }
+  TF_RETURN_IF_ERROR(embeddings_status);
+  TF_RETURN_IF_ERROR(block_sparse_status);
+  TF_RETURN_IF_ERROR(convolution_status);
+  return matmul_status;
+}
+
+Status AddTfCodelets(poplar::Graph& graph) {
+  // The codelets are compiled for all the targets when the plugin is built.
+  static const unsigned char codelets_object[] = {
+#include "tensorflow/compiler/plugin/poplar/tf_codelets.gpembed"
+  };
+  try {
+    std::stringstream codelets_stream(
+        std::string(reinterpret_cast<const char*>(codelets_object),
+                    sizeof(codelets_object)));
+    graph.addCodelets(codelets_stream, "", poplar::CodeletFileType::Object);
+    return Status::OK();
+  } catch (const poplar::poplar_error& e) {
+    // For example if the object does not contain code for this target.
+    VLOG(1) << "Could not load the precompiled Poplar TF codelets, compiling "
+               "them instead: "
+            << e.what();
+  }
+
+  std::stringstream codelets_src{
+#include "tensorflow/compiler/plugin/poplar/tf.cppembed"
+  };
+
+  std::stringstream compile_output;
+  try {
+    graph.addCodelets(codelets_src, "-DNDEBUG -O3", compile_output);
+  } catch (const poplar::graph_program_compilation_error) {
+    return xla::InternalError("Failed to compile Poplar TF codelets: %s",
+                              compile_output.str());
+  }
+  return Status::OK();
+}
+
 Status CreatePoplarGraphs(CompilerResources& resources, const HloModule* module,
                           PoplarExecutor* poplar_executor) {
   try {
@@ -502,6 +619,7 @@ Status CreatePoplarGraphs(CompilerResources& resources, const HloModule* module,
     auto tiles_per_ipu = target.getTilesPerIPU();
 
     absl::optional<std::vector<unsigned>> per_ipu_compute_tiles;
+    std::vector<unsigned> per_ipu_io_tiles;
     if (num_io_tiles > 0) {
       CHECK_LT(num_io_tiles, tiles_per_ipu);
       const int num_compute_tiles = tiles_per_ipu - num_io_tiles;
@@ -509,6 +627,17 @@ Status CreatePoplarGraphs(CompilerResources& resources, const HloModule* module,
           gcl::perIPUTiles(main_graph, num_io_tiles, num_compute_tiles);
       CHECK_EQ(per_ipu_compute_tiles->size(), num_compute_tiles);
 
+      // The IO tiles are the tiles which are not compute tiles.
+      std::vector<bool> is_compute_tile(tiles_per_ipu, false);
+      for (unsigned tile : *per_ipu_compute_tiles) {
+        is_compute_tile[tile] = true;
+      }
+      for (unsigned tile = 0; tile != tiles_per_ipu; ++tile) {
+        if (!is_compute_tile[tile]) {
+          per_ipu_io_tiles.push_back(tile);
+        }
+      }
+
       LOG(INFO) << "Reserving " << num_io_tiles
                 << " IO tiles for GCL collective operations on each IPU.";
     }
@@ -571,6 +700,8 @@ Status CreatePoplarGraphs(CompilerResources& resources, const HloModule* module,
       if (per_ipu_compute_tiles.has_value()) {
         resources.shard_graphs.emplace_back(
             ipu_graph.createVirtualGraph(*per_ipu_compute_tiles));
+        resources.shard_io_graphs.emplace_back(
+            ipu_graph.createVirtualGraph(per_ipu_io_tiles));
       } else {
         resources.shard_graphs.emplace_back(std::move(ipu_graph));
       }
@@ -592,17 +723,7 @@ Status CreatePoplarGraphs(CompilerResources& resources, const HloModule* module,
     }
   }
 
-  std::stringstream codelets_src{
-#include "tensorflow/compiler/plugin/poplar/tf.cppembed"
-  };
-
-  std::stringstream compile_output;
-  try {
-    main_graph.addCodelets(codelets_src, "-DNDEBUG -O3", compile_output);
-  } catch (const poplar::graph_program_compilation_error) {
-    return xla::InternalError("Failed to compile Poplar TF codelets: %s",
-                              compile_output.str());
-  }
+  TF_RETURN_IF_ERROR(AddTfCodelets(main_graph));
   poplin::addCodelets(main_graph);
   popnn::addCodelets(main_graph);
   popops::addCodelets(main_graph);
@@ -817,6 +938,45 @@ void AddPipelineOptimizerPass(HloPassPipeline& pipeline) {
   pass.AddPass<HloCSE>(true);
 }
 
+// Replaces the prefetch depths of the autotuned infeeds and the io batch sizes
+// of the autotuned outfeeds with the values chosen by the autotuner. This is
+// done before the module is hashed so that the cached executables of the
+// different values are kept apart.
+void ApplyFeedAutotuning(HloModule* module, const FeedAutotuner& autotuner) {
+  for (HloComputation* comp : module->computations()) {
+    for (HloInstruction* inst : comp->instructions()) {
+      PoplarFeedConfig config;
+      if (inst->opcode() == HloOpcode::kInfeed) {
+        auto* infeed = Cast<HloInfeedInstruction>(inst);
+        config.ParseFromString(infeed->infeed_config());
+        if (!FeedAutotuner::IsTunedInfeed(config)) {
+          continue;
+        }
+        const PoplarFeedConfig tuned = autotuner.TunedInfeedConfig(config);
+        if (tuned.prefetch_depth() != config.prefetch_depth()) {
+          VLOG(1) << "Using the autotuned prefetch depth "
+                  << tuned.prefetch_depth() << " for infeed "
+                  << config.feed_id();
+          infeed->set_infeed_config(tuned.SerializeAsString());
+        }
+      } else if (inst->opcode() == HloOpcode::kOutfeed) {
+        auto* outfeed = Cast<HloOutfeedInstruction>(inst);
+        config.ParseFromString(outfeed->outfeed_config());
+        if (!FeedAutotuner::IsTunedOutfeed(config)) {
+          continue;
+        }
+        const PoplarFeedConfig tuned = autotuner.TunedOutfeedConfig(config);
+        if (tuned.io_batch_size() != config.io_batch_size()) {
+          VLOG(1) << "Using the autotuned io batch size "
+                  << tuned.io_batch_size() << " for outfeed "
+                  << config.feed_id();
+          outfeed->set_outfeed_config(tuned.SerializeAsString());
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<HloModule>> PoplarCompiler::RunHloPasses(
@@ -864,9 +1024,17 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     opt_flags.set("autoReport.directory", module->name());
   }
 
+  ApplyFeedAutotuning(module.get(), poplar_executor->GetFeedAutotuner());
+
   const ModuleFilenames filenames =
       poplar_executor->GetModuleFilenames(*module);
+  absl::optional<ExecutableCache::ScopedCompilation> compilation;
   if (poplar_executor->HaveExecutableCache()) {
+    // If another thread is already compiling this module then wait for it and
+    // load the executable it added to the cache.
+    compilation.emplace(
+        ExecutableCache::Get().BeginCompilation(filenames.Name()));
+
     if (poplar_executor->HaveCachedExecutable(filenames)) {
       TF_ASSIGN_OR_RETURN(PoplarExecutable * poplar_executable,
                           PoplarExecutable::Deserialize(
@@ -879,8 +1047,11 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
         try {
           VLOG(1) << "Trying to deserialize cached file: "
                   << filenames.CachedExecutableFilename();
-          std::ifstream file(filenames.CachedExecutableFilename(),
-                             std::ios::binary);
+          TF_ASSIGN_OR_RETURN(std::unique_ptr<ExecutableFileContents> contents,
+                              ExecutableCache::Get().OpenExecutable(
+                                  filenames.CachedExecutableFilename()));
+          MemoryStreamBuf buffer(contents->data(), contents->size());
+          std::istream file(&buffer);
           auto poplar_binary = poplar::Executable::deserialize(file);
 
           TF_RETURN_IF_ERROR(PoplarExecutable::Export(
@@ -951,6 +1122,9 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
               poplar_executor->GetMaxAllReduceBufferSize())
           .set_max_reduce_scatter_buffer_size(
               poplar_executor->GetMaxReduceScatterBufferSize())
+          .set_all_reduce_bucket_size(poplar_executor->GetAllReduceBucketSize())
+          .set_reduce_scatter_bucket_size(
+              poplar_executor->GetReduceScatterBucketSize())
           .set_max_inter_ipu_copies_buffer_size(
               poplar_executor->GetMaxInterIpuCopyBufferSize())
           .set_max_send_recv_cluster_size(
@@ -960,7 +1134,9 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
           .set_max_scheduler_search_space_size(
               poplar_executor->GetMaxSchedulerSearchSpaceSize())
           .set_minimum_remote_tensor_size(
-              poplar_executor->GetMinimumRemoteTensorSize());
+              poplar_executor->GetMinimumRemoteTensorSize())
+          .set_remote_parameter_prefetch_size(
+              poplar_executor->GetRemoteParameterPrefetchSize());
 
   CompilerResources resources(
       module.get(), information, poplar_executor->GetConvolutionOptions(),
@@ -977,15 +1153,24 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
       poplar_executor->UseStableNormStatistics(),
       poplar_executor->SupportsRemoteBuffers(), poplar_executor->GclOptions(),
       poplar_executor->GetTriangularSolveExpanderBlockSize(),
-      poplar_executor->EnableExperimentalRemoteBufferEmbedding(),
-      poplar_executor->EnableFastMath());
+      poplar_executor->EnableRemoteBufferEmbedding(),
+      poplar_executor->EnableFastMath(),
+      poplar_executor->HostEmbeddingCacheOptions(),
+      poplar_executor->DoubleBufferRepeatLoopFeeds(),
+      PlanningCaches::ForTarget(poplar_executor->GetOrCreatePoplarTarget()));
 
   if (replication_factor > 1) {
     VLOG(1) << "Created " << replication_factor << " replica IPU graph.";
   }
 
   {
-    HloPassPipeline pipeline("IPU");
+    // Per-pass statistics are collected when they are dumped or logged.
+    const bool collect_pass_stats =
+        DumpingEnabledForHloModule(*module) || VLOG_IS_ON(1);
+    std::unique_ptr<CompilationStats> pass_stats =
+        collect_pass_stats ? CompilationStats::MakeStats()
+                           : CompilationStats::MakeNoopStats();
+    HloPassPipeline pipeline("IPU", pass_stats.get());
     pipeline.AddPass<FlattenCallGraph>();
     pipeline.AddPass<HloGetDimensionSizeRewriter>();
     pipeline.AddPass<CustomOpReplacer>();
@@ -1033,7 +1218,8 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     pipeline.AddPass<TupleSimplifier>(true);
     // pass.AddPass<ConditionalSimplifier>();
     pipeline.AddPass<F16ConstantFolding>();
-    pipeline.AddPass<HloConstantFolding>();
+    pipeline.AddPass<HloConstantFolding>(
+        PoplarXlaFlags::Get().constant_folding_max_elements);
     pipeline.AddPass<HloCSE>(true);
     pipeline.AddPass<WideConstFinder>();
     pipeline.AddPass<CommutativeInstructionReorderOperands>();
@@ -1083,6 +1269,10 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     pipeline.AddPass<SerializeGradientAccumulation>();
     pipeline.AddPass<SliceOptimizer>(resources.annotations);
     pipeline.AddPass<HloPassFix<FuseOpsLate>>(resources.annotations);
+    if (poplar_executor->GetMaxCombinedConvolutionsSize() > 0) {
+      pipeline.AddPass<MultiConvCombiner>(
+          poplar_executor->GetMaxCombinedConvolutionsSize());
+    }
     pipeline.AddPass<ElementwiseBroadcastConverter>();
     pipeline.AddPass<FuseWideConst>(resources.annotations);
     pipeline.AddPass<HloDCE>();
@@ -1117,10 +1307,24 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     pipeline.AddPass<HostEmbeddingNotification>();
 
     // Passes below this point need to respect control dependencies.
+    pipeline.AddPass<RemoteBufferOffload>(
+        resources.remote_memory_supported,
+        resources.information.minimum_remote_tensor_size,
+        PoplarXlaFlags::Get().remote_buffer_offload_idle_instructions);
     pipeline.AddPass<RecomputeInstructions>(
         poplar_executor->RecomputationEnabled());
+    PipelineStageCostModel cost_model;
+    cost_model.tiles_per_ipu = target.getTilesPerIPU();
+    cost_model.calibration =
+        PoplarXlaFlags::Get().pipeline_cost_model_calibration;
     if (poplar_executor->RecomputationEnabled()) {
-      pipeline.AddPass<SuggestRecompute>();
+      const int64 memory_target =
+          PoplarXlaFlags::Get().recomputation_memory_target;
+      if (memory_target > 0) {
+        pipeline.AddPass<RecomputationPlanner>(memory_target, cost_model);
+      } else {
+        pipeline.AddPass<SuggestRecompute>();
+      }
       pipeline.AddPass<AddBlockRecompute>();
       {
         auto& pass = pipeline.AddPass<HloPassFix<HloPassPipeline>>(
@@ -1136,7 +1340,8 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     pipeline.AddPass<DependencyReplacer>(true);
     pipeline.AddPass<HostComputeBarrierInserter>();
     pipeline.AddPass<ShardingPass>();
-    pipeline.AddPass<HostComputeScheduleOptimizer>();
+    pipeline.AddPass<HostComputeScheduleOptimizer>(
+        poplar_executor->OverlapHostCompute());
     pipeline.AddPass<InterIpuCopyInserter>();
     pipeline.AddPass<PostSerializeGradientAccumulation>();
     pipeline.AddPass<CopyInserter>();
@@ -1162,32 +1367,58 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     // }
 
     pipeline.AddPass<PipelineVerifier>(poplar_executor->RecomputationEnabled());
+    pipeline.AddPass<PipelineStageBalancer>(cost_model);
     pipeline.AddPass<GradientAccumulationVerifier>(
         resources.replication_factor);
     if (resources.information.max_all_reduce_buffer_size > 0 ||
+        resources.information.all_reduce_bucket_size > 0 ||
+        resources.information.reduce_scatter_bucket_size > 0 ||
         resources.information.max_inter_ipu_copies_buffer_size > 0 ||
         resources.information.max_send_recv_cluster_size > 0) {
       pipeline.AddPass<IpuScheduler>(
           SizeFunction, CreateClusteringMemoryScheduler(resources.information));
-      pipeline.AddPass<CombineInstructions>();
+      pipeline.AddPass<CombineInstructions>(resources.information);
       pipeline.AddPass<HloDescheduler>();
     }
     pipeline.AddPass<AllocationFinder>(
         resources.annotations, resources.always_rearrange_copies_on_host);
     pipeline.AddPass<HloPassFix<ForwardAllocation>>(resources.annotations);
     pipeline.AddPass<RemoteParameterParallelCombiner>(
-        resources.annotations.tensor_allocation_map);
+        resources.annotations.tensor_allocation_map,
+        resources.information.remote_parameter_prefetch_size);
+    if (poplar_executor->OverlapInterIpuCopies()) {
+      pipeline.AddPass<InterIpuCopyScheduleOptimizer>(cost_model);
+    }
 
     TF_ASSIGN_OR_RETURN(auto schedulers, GetSchedulerList(resources));
 
-    TF_ASSIGN_OR_RETURN(auto scheduler, BestIpuSchedule(schedulers));
+    LogicalBuffer::SizeFunction size_function = SizeFunction;
+    IpuScheduleMemoryEstimator memory_estimator =
+        CreateHeapSimulatorMemoryEstimator();
+    if (PoplarXlaFlags::Get().tile_memory_aware_scheduling) {
+      TileMemoryModel tile_memory_model;
+      tile_memory_model.tiles_per_ipu = target.getTilesPerIPU();
+      size_function = CreateTileMemorySizeFunction(tile_memory_model);
+      memory_estimator = CreateTileMemoryEstimator(tile_memory_model);
+    }
+
+    TF_ASSIGN_OR_RETURN(auto scheduler,
+                        BestIpuSchedule(schedulers, memory_estimator));
 
     pipeline.AddPass<ResourceUpdateScheduleOptimizer>();
-    pipeline.AddPass<IpuScheduler>(SizeFunction, scheduler);
+    pipeline.AddPass<IpuScheduler>(size_function, scheduler);
     pipeline.AddPass<ModuleFlatten>(resources.annotations);
     pipeline.AddPass<LowerFrontendAttributes>();
 
     TF_RETURN_IF_ERROR(pipeline.Run(module.get()).status());
+
+    if (collect_pass_stats) {
+      if (VLOG_IS_ON(1)) {
+        pass_stats->CompilationReport();
+      }
+      DumpToFileInDir(*module, "hlo_pass_stats.json",
+                      pass_stats->CompilationReportJson());
+    }
   }
 
   VLOG(1) << "End XLA compilation: " << module->name() << " (Hash: 0x"
@@ -1278,12 +1509,7 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     try {
       VLOG(1) << "Preplanning of Poplar operations.";
 
-      EmbeddingPlansPreplanning embeddings_preplanning;
-      TF_RETURN_IF_ERROR(embeddings_preplanning.Plan(module.get(), resources));
-      ConvolutionPreplanning convolution_preplanning;
-      TF_RETURN_IF_ERROR(convolution_preplanning.Plan(module.get(), resources));
-      MatMulPreplanning matmul_preplanning;
-      TF_RETURN_IF_ERROR(matmul_preplanning.Plan(module.get(), resources));
+      TF_RETURN_IF_ERROR(PreplanOperations(module.get(), resources));
       auto order = module->schedule().sequence(entry).instructions();
 
       TF_RETURN_IF_ERROR(resources.streams_indices.InitializeIndexTensors(
@@ -1313,12 +1539,21 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     // Add the preamble sequence.
     main_program.add(resources.preamble_sequence);
 
-    // Add the main program sequence.
+    // Add the main program sequence, between the zeroing and the copy of the
+    // instruction cycle counters if there are any.
+    poplar::program::Sequence instruction_cycle_counters_copy;
+    poplar_executor->SetInstructionCycleCounterNames(
+        InitializeInstructionCycleCounters(resources, main_program,
+                                           instruction_cycle_counters_copy));
     main_program.add(visitor.GetSequenceAndInitializeCounters());
+    main_program.add(instruction_cycle_counters_copy);
 
     if (InitializeCycleCounter(main_graph, main_program)) {
       poplar_executor->SetHasCycleCounter();
     }
+    if (resources.has_pipeline_cycle_counter) {
+      poplar_executor->SetHasPipelineCycleCounter();
+    }
 
     // =======================================================================
     // DO NOT CHANGE THE ORDER OF THESE WITHOUT UPDATING PoplarProgramType IN
@@ -1348,11 +1583,21 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
     }
 
     try {
-      VLOG(1) << "Begin compiling Poplar engine " << module->name();
+      VLOG(1) << "Begin compiling Poplar engine " << module->name()
+              << ", peak host memory " << GetPeakHostMemoryBytes()
+              << " bytes.";
 
       map_json = GetTensorMappingJson(module->name(), main_graph,
                                       resources.tensor_maps);
 
+      if (resources.tile_imbalance_stats.num_rebalanced_tensors) {
+        VLOG(1) << "Rebalanced "
+                << resources.tile_imbalance_stats.num_rebalanced_tensors
+                << " tensors which were mapped onto a few tiles, saving "
+                << resources.tile_imbalance_stats.max_tile_bytes_saved
+                << " bytes on their busiest tiles.";
+      }
+
       auto progress_logging = [](int progress, int total) {
         float progress_percent = std::floor(
             100.0f * static_cast<float>(progress) / static_cast<float>(total));
@@ -1365,6 +1610,9 @@ StatusOr<std::unique_ptr<Executable>> PoplarCompiler::RunBackend(
         opt_flags.set("target.syncReplicasIndependently", "true");
       }
 
+      IpuActivityScope compile_activity(poplar_executor->device_ordinal(),
+                                        IpuActivityType::kCompile,
+                                        module->name());
       poplar::Executable exec =
           poplar::compileGraph(main_graph, progs, opt_flags, progress_logging);
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executable.h"
 
 #include <fstream>
+#include <sstream>
 #include <utility>
 
 #include "ipu/poplar_executable_data.h"
@@ -23,9 +24,12 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executable.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_platform.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/executable_cache.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
+#include "tensorflow/core/lib/io/path.h"
 
 namespace xla {
 namespace poplarplugin {
@@ -109,6 +113,8 @@ StatusOr<ScopedShapedBuffer> PoplarExecutable::ExecuteAsyncOnStream(
   PoplarExecutor* poplarExecutor(
       static_cast<PoplarExecutor*>(executor->implementation()));
 
+  TF_RETURN_IF_ERROR(poplarExecutor->WaitForAsynchronousAttach());
+
   if (!poplarExecutor->PoplarDeviceIsAttached() &&
       poplar_engine_.get() != nullptr) {
     if (poplarExecutor->ConnectionType() == IpuDeviceConnectionType::NEVER) {
@@ -225,6 +231,9 @@ StatusOr<ScopedShapedBuffer> PoplarExecutable::ExecuteAsyncOnStream(
     lookups.emplace_back(lookup.stream_handle(), lookup.embedding_id(),
                          Shape(lookup.indices_shape()),
                          Shape(lookup.activations_shape()));
+    lookups.back().cache_rows = lookup.cache_rows();
+    lookups.back().cache_max_misses = lookup.cache_max_misses();
+    lookups.back().deduplicate = lookup.deduplicate();
   }
 
   HostEmbeddingInfos updates;
@@ -232,6 +241,8 @@ StatusOr<ScopedShapedBuffer> PoplarExecutable::ExecuteAsyncOnStream(
     updates.emplace_back(update.stream_handle(), update.embedding_id(),
                          Shape(update.indices_shape()),
                          Shape(update.activations_shape()));
+    updates.back().cache_max_misses = update.cache_max_misses();
+    updates.back().deduplicate = update.deduplicate();
   }
 
   HostEmbeddingInfos notifications;
@@ -267,18 +278,26 @@ StatusOr<ScopedShapedBuffer> PoplarExecutable::ExecuteAsyncOnStream(
   }
 
   // Load the executable
-  std::string poplar_executable_filename = proto.engine();
-  if (poplar_executable_filename != filenames.CachedExecutableFilename()) {
+  // The cache directory can be different on the host which compiled the
+  // executable, so only the names of the files are compared.
+  if (tensorflow::io::Basename(proto.engine()) !=
+      tensorflow::io::Basename(filenames.CachedExecutableFilename())) {
     return tensorflow::errors::InvalidArgument(
         "Filename mismatch between module expected filename '",
         filenames.CachedExecutableFilename(), "' and file stored in proto '",
-        poplar_executable_filename, "'");
+        proto.engine(), "'");
   }
+  const std::string poplar_executable_filename =
+      filenames.CachedExecutableFilename();
   std::unique_ptr<poplar::Engine> engine;
   try {
     VLOG(1) << "Trying to deserialize cached file: "
             << poplar_executable_filename;
-    std::ifstream file(poplar_executable_filename, std::ios::binary);
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<ExecutableFileContents> contents,
+        ExecutableCache::Get().OpenExecutable(poplar_executable_filename));
+    MemoryStreamBuf buffer(contents->data(), contents->size());
+    std::istream file(&buffer);
     auto poplar_executable = poplar::Executable::deserialize(file);
     engine.reset(new poplar::Engine(std::move(poplar_executable), opts));
   } catch (const std::exception& e) {
@@ -408,14 +427,34 @@ Status ExportInternal(
     const std::vector<string>& checkpoint_feeds_order) {
   PoplarExecutableProto proto;
 
-  // Write poplar executable to a file
+  // Write poplar executable to a file. Both files are written to temporary
+  // files first so that other processes sharing the cache never see them
+  // partially written, and the engine file is published last as it is the one
+  // which is checked for.
+  const std::string temporary_executable_filename =
+      ExecutableCache::TemporaryFilename(filenames.CachedExecutableFilename());
   try {
-    auto file =
-        std::ofstream(filenames.CachedExecutableFilename(), std::ios::binary);
-    executable.serialize(file);
+    auto file = std::ofstream(temporary_executable_filename, std::ios::binary);
+    if (PoplarXlaFlags::Get().executable_cache_compression) {
+      std::ostringstream stream;
+      executable.serialize(stream);
+      std::string compressed;
+      Status status = CompressExecutable(stream.str(), &compressed);
+      if (status.ok()) {
+        file.write(compressed.data(), compressed.size());
+      } else {
+        LOG(WARNING) << "Adding the executable to the cache uncompressed: "
+                     << status.error_message();
+        file << stream.str();
+      }
+    } else {
+      executable.serialize(file);
+    }
   } catch (const std::exception& e) {
     return PoplarExceptionToTensorflowStatus("[Serialize] ", e);
   }
+  TF_RETURN_IF_ERROR(ExecutableCache::Get().Publish(
+      temporary_executable_filename, filenames.CachedExecutableFilename()));
 
   proto.set_engine(filenames.CachedExecutableFilename());
 
@@ -466,6 +505,9 @@ Status ExportInternal(
     *lookup_proto->mutable_indices_shape() = lookup.indices_shape.ToProto();
     *lookup_proto->mutable_activations_shape() =
         lookup.activations_shape.ToProto();
+    lookup_proto->set_cache_rows(lookup.cache_rows);
+    lookup_proto->set_cache_max_misses(lookup.cache_max_misses);
+    lookup_proto->set_deduplicate(lookup.deduplicate);
   }
 
   for (const auto update : annotations.host_embedding_update_infos) {
@@ -475,6 +517,8 @@ Status ExportInternal(
     *update_proto->mutable_indices_shape() = update.indices_shape.ToProto();
     *update_proto->mutable_activations_shape() =
         update.activations_shape.ToProto();
+    update_proto->set_cache_max_misses(update.cache_max_misses);
+    update_proto->set_deduplicate(update.deduplicate);
   }
 
   for (const auto notification : annotations.host_embedding_notify_infos) {
@@ -501,8 +545,12 @@ Status ExportInternal(
     *proto_feed = feed;
   }
 
-  return WriteBinaryProto(tensorflow::Env::Default(),
-                          filenames.CachedEngineFilename(), proto);
+  const std::string temporary_engine_filename =
+      ExecutableCache::TemporaryFilename(filenames.CachedEngineFilename());
+  TF_RETURN_IF_ERROR(WriteBinaryProto(tensorflow::Env::Default(),
+                                      temporary_engine_filename, proto));
+  return ExecutableCache::Get().Publish(temporary_engine_filename,
+                                        filenames.CachedEngineFilename());
 }
 
 }  // namespace poplarplugin
@@ -18,8 +18,10 @@ limitations under the License.
 #include <string.h>
 
 #include <algorithm>
+#include <chrono>
 #include <deque>
 #include <fstream>
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -30,7 +32,10 @@ limitations under the License.
 #include <poplar/StreamCallback.hpp>
 #include <poplar/Tensor.hpp>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/util/message_differencer.h"
@@ -39,11 +44,15 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_platform.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_platform_id.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/conversions.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/executable_cache.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_hash.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_iterator.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_statistics.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/ipu_activity_recorder.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/send_recv_runtime_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_queue.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
@@ -55,10 +64,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/version.h"
 
 /*
@@ -107,11 +119,18 @@ limitations under the License.
  *       During the last execution, the buffer was an argument to the execution
  *       and was also one of the output parameters.  This typically indicates
  *       that it is a variable (weights/biases) that has been updated in place.
- *       If the next execution doesn't change the engine, and the data is not
- *       read back to the host in between executions, and the data remains as
- *       an argument to the same input number, then the data does not need to be
- *       copied back to the host.  This is the ideal situation when executing an
- *       engine repeatedly with the same set of weights/biases.
+ *       If the next execution doesn't change the engine, and the data remains
+ *       as an argument to the same input number, then the data does not need
+ *       to be copied back to the host.  This is the ideal situation when
+ *       executing an engine repeatedly with the same set of weights/biases.
+ *
+ *   When the host reads a tensor, only that tensor and the outputs which are
+ *   not also inputs are copied back from the device.  Their output_handle is
+ *   cleared, because the host buffers are now up to date, but a tensor with
+ *   an input_handle stays on the device.  So the other variables stay on the
+ *   device and are not copied back, and none of them have to be copied to the
+ *   device again for the next execution.  All the tensors are copied back
+ *   when the engine changes.
  *
  */
 namespace se = ::stream_executor;
@@ -154,6 +173,10 @@ void ResetXfeedManager(int device_ordinal) {
 }
 
 namespace {
+// The number of times an executable can be loaded onto the device before a
+// warning about switching between executables is logged.
+constexpr int64 kEngineReloadWarningCount = 10;
+
 Shape GetOutfeedShape(const Shape& output_shape,
                       const uint32 replication_factor) {
   if (replication_factor > 1) {
@@ -176,6 +199,69 @@ std::vector<Shape> GetOutfeedShapes(const std::vector<Shape>& output_shapes,
   return result;
 }
 
+// The number of elements of an outfeed which are sent to the host at once.
+int64 GetOutfeedElementsPerTransfer(const PoplarFeedConfig& config) {
+  // The elements of a batch are reduced on the device.
+  if (config.reduction() != PoplarFeedConfig::NoReduction) {
+    return 1;
+  }
+  return std::max<int64>(1, config.io_batch_size());
+}
+
+// The capacity of the host queues of a feed. Each slot of the queues holds a
+// transfer of `io_batch_size` elements. There are enough slots for about
+// `kFeedQueueElements` elements, and at least `kFeedQueueTransfersPerPrefetch`
+// transfers for each transfer Poplar can prefetch. 8 slots are added as a full
+// queue leaves them unused.
+std::size_t GetFeedQueueCapacity(const PoplarFeedConfig& config) {
+  constexpr int64 kFeedQueueElements = 256;
+  constexpr int64 kFeedQueueTransfersPerPrefetch = 4;
+  constexpr std::size_t kMaxFeedQueueCapacity = 1 << 16;
+  const int64 io_batch_size = std::max<int64>(1, config.io_batch_size());
+  const int64 prefetch_depth = std::max<int64>(1, config.prefetch_depth());
+  const int64 transfers =
+      std::max(kFeedQueueTransfersPerPrefetch * prefetch_depth,
+               tensorflow::MathUtil::CeilOfRatio(kFeedQueueElements,
+                                                 io_batch_size));
+  std::size_t capacity = 16;
+  while (capacity < static_cast<std::size_t>(transfers + 8) &&
+         capacity < kMaxFeedQueueCapacity) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+bool IsOutfeedTransferredAsFp16(const PoplarFeedConfig& config,
+                                const Shape& shape) {
+  return config.transfer_as_fp16() && shape.element_type() == F32;
+}
+
+// The number of bytes of an element of an outfeed tensor which are sent to
+// the host.
+int64 GetOutfeedTransferByteSize(const PoplarFeedConfig& config,
+                                 const Shape& shape) {
+  if (IsOutfeedTransferredAsFp16(config, shape)) {
+    return ShapeUtil::ElementsIn(shape) * sizeof(Eigen::half);
+  }
+  return ShapeUtil::ByteSizeOf(shape);
+}
+
+// Copies an element of an outfeed tensor received from the device into the
+// host tensor, converting it from fp16 if it was transferred as fp16.
+void CopyOutfeedElement(char* dest, const uint8_t* src, int64 bytes,
+                        bool from_fp16) {
+  if (from_fp16) {
+    const Eigen::half* src_half = reinterpret_cast<const Eigen::half*>(src);
+    float* dest_float = reinterpret_cast<float*>(dest);
+    const int64 num_elements = bytes / sizeof(float);
+    for (int64 i = 0; i != num_elements; ++i) {
+      dest_float[i] = static_cast<float>(src_half[i]);
+    }
+  } else {
+    std::memcpy(dest, src, bytes);
+  }
+}
+
 int64 GetConfigHash(const IpuOptions& to_hash) {
   IpuOptions hashable_config = to_hash;
 
@@ -266,7 +352,24 @@ PoplarExecutor::TensorControl::TensorControl(size_t size_) {
 }
 
 PoplarExecutor::TensorControl::~TensorControl() {
-  tensorflow::port::AlignedFree(data);
+  if (release_borrowed_data) {
+    release_borrowed_data();
+  } else {
+    tensorflow::port::AlignedFree(data);
+  }
+}
+
+void PoplarExecutor::TensorControl::OwnData(bool keep_data) {
+  if (!release_borrowed_data) {
+    return;
+  }
+  char* borrowed = data;
+  data = static_cast<char*>(tensorflow::port::AlignedMalloc(size, 64));
+  if (keep_data) {
+    std::memcpy(data, borrowed, size);
+  }
+  release_borrowed_data();
+  release_borrowed_data = nullptr;
 }
 
 PoplarExecutor::OutfeedContext::OutfeedContext(const FeedInfo& outfeed_info)
@@ -277,25 +380,51 @@ PoplarExecutor::OutfeedContext::OutfeedContext(const FeedInfo& outfeed_info)
       tf_shapes(shapes.size()),
       callback_to_io_thread_queues(shapes.size()) {
   CHECK_EQ(shapes.size(), tf_data_types.size());
-  int64 replication_factor = config.replication_factor();
   for (uint64 i = 0; i < shapes.size(); i++) {
     tf_data_types[i] = static_cast<tensorflow::DataType>(
         outfeed_info.config.tf_data_types()[i]);
     tensorflow::XLAShapeToTensorShape(shapes[i], &tf_shapes[i]);
+  }
+  CreateCallbackToIOThreadQueues();
 
+  tensor_ring = absl::make_unique<OutfeedTensorRing>(tf_data_types, tf_shapes);
+
+  if (!config.file_sink_prefix().empty()) {
+    file_sink = absl::make_unique<OutfeedFileSink>(
+        config.file_sink_prefix(),
+        config.file_sink_format() == PoplarFeedConfig::Raw
+            ? OutfeedFileSink::Format::kRaw
+            : OutfeedFileSink::Format::kTFRecord,
+        config.file_sink_elements_per_file());
+  }
+}
+
+void PoplarExecutor::OutfeedContext::CreateCallbackToIOThreadQueues() {
+  int64 replication_factor = config.replication_factor();
+  for (uint64 i = 0; i < shapes.size(); i++) {
     // Set up the queue per tensor per replica.
     int64 num_bytes_per_replica =
-        ShapeUtil::ByteSizeOf(shapes[i]) / replication_factor;
-    num_bytes_per_replica *= outfeed_info.config.io_batch_size();
+        GetOutfeedTransferByteSize(config, shapes[i]) / replication_factor;
+    num_bytes_per_replica *= GetOutfeedElementsPerTransfer(config);
+    const std::size_t queue_capacity = GetFeedQueueCapacity(config);
+    callback_to_io_thread_queues[i].clear();
     for (int64 replica_id = 0; replica_id < replication_factor; replica_id++) {
       void* ptr = tensorflow::port::AlignedMalloc(sizeof(OutfeedQueueType), 64);
       callback_to_io_thread_queues[i].emplace_back(
-          new (ptr) OutfeedQueueType(num_bytes_per_replica),
-          tensorflow::port::AlignedFree);
+          new (ptr) OutfeedQueueType(num_bytes_per_replica, queue_capacity),
+          [](void* ptr) {
+            static_cast<OutfeedQueueType*>(ptr)->~OutfeedQueueType();
+            tensorflow::port::AlignedFree(ptr);
+          });
     }
   }
 }
 
+void PoplarExecutor::OutfeedContext::SetIoBatchSize(int64 io_batch_size) {
+  config.set_io_batch_size(io_batch_size);
+  CreateCallbackToIOThreadQueues();
+}
+
 bool PoplarExecutor::OutfeedContext::Matches(const FeedInfo& outfeed_info) {
   auto s = GetOutfeedShapes(FlattenedXlaShape(outfeed_info.shape),
                             outfeed_info.config.replication_factor());
@@ -307,8 +436,14 @@ bool PoplarExecutor::OutfeedContext::Matches(const FeedInfo& outfeed_info) {
       return false;
     }
   }
-  return google::protobuf::util::MessageDifferencer::Equivalent(
-      config, outfeed_info.config);
+  // The io batch size of an autotuned outfeed changes when the graph is
+  // compiled with a tuned value.
+  PoplarFeedConfig other_config = outfeed_info.config;
+  if (FeedAutotuner::IsTunedOutfeed(config)) {
+    other_config.set_io_batch_size(config.io_batch_size());
+  }
+  return google::protobuf::util::MessageDifferencer::Equivalent(config,
+                                                                other_config);
 }
 
 PoplarExecutor::PoplarExecutor()
@@ -318,6 +453,7 @@ PoplarExecutor::PoplarExecutor()
       poplar_device_hash_(0),
       configured_(false),
       has_cycle_counter_(false),
+      has_pipeline_cycle_counter_(false),
       rendezvous_(tensorflow::NewLocalRendezvous()) {
   // TODO should this use the time/ms?
   static std::random_device rd;
@@ -440,6 +576,18 @@ Status PoplarExecutor::ConnectRecvCallbacksToRendezvous(
 }
 
 namespace {
+// Returns the feeds which do not use synthetic data.
+std::vector<FeedInfo> FeedsUsingTheHost(const std::vector<FeedInfo>& feeds,
+                                        SyntheticDataCategory category) {
+  std::vector<FeedInfo> result;
+  for (const FeedInfo& feed : feeds) {
+    if (!UseSyntheticDataForFeed(category, feed.config.feed_id())) {
+      result.push_back(feed);
+    }
+  }
+  return result;
+}
+
 uint64 DeviceIncarnation(int device_ordinal, int replica) {
   return (device_ordinal << 5) | replica;
 }
@@ -448,7 +596,7 @@ uint64 DeviceIncarnation(int device_ordinal, int replica) {
 Status PoplarExecutor::ConnectHostEmbeddingLookup(
     const HostEmbeddingInfo& lookup_info,
     HostEmbeddingInterface_* embedding_interface) {
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding)) {
     return Status::OK();
   }
 
@@ -457,7 +605,7 @@ Status PoplarExecutor::ConnectHostEmbeddingLookup(
   TF_RETURN_IF_ERROR(tensorflow::XLAShapeToTensorShape(
       lookup_info.indices_shape, &indices_shape));
 
-  if (EnableExperimentalRemoteBufferEmbedding()) {
+  if (EnableRemoteBufferEmbedding()) {
     TF_ASSIGN_OR_RETURN(int token_count, embedding_interface->GetTokenCount());
     TF_ASSIGN_OR_RETURN(int encoding_width,
                         embedding_interface->GetEncodingWidth());
@@ -510,6 +658,11 @@ Status PoplarExecutor::ConnectHostEmbeddingLookup(
     return xla::FailedPrecondition("Unknown host embedding splitting strategy");
   }
 
+  if (lookup_info.cache_rows > 0 || lookup_info.deduplicate) {
+    return ConnectCachedHostEmbeddingLookup(lookup_info, indices_shape,
+                                            embedding_interface);
+  }
+
   for (int replica = 0;
        replica < std::max<int64>(1, current_replication_factor_); ++replica) {
     // Connect the indices callback.
@@ -531,14 +684,95 @@ Status PoplarExecutor::ConnectHostEmbeddingLookup(
   return Status::OK();
 }
 
+std::vector<HostEmbeddingCache*> PoplarExecutor::GetHostEmbeddingCaches(
+    const std::string& embedding_id) {
+  std::vector<HostEmbeddingCache*> caches;
+  auto itr = host_embedding_caches_.find(embedding_id);
+  if (itr != host_embedding_caches_.end()) {
+    for (auto& context : itr->second) {
+      caches.push_back(&context->cache);
+    }
+  }
+  return caches;
+}
+
+Status PoplarExecutor::ConnectCachedHostEmbeddingLookup(
+    const HostEmbeddingInfo& lookup_info,
+    const tensorflow::TensorShape& indices_shape,
+    HostEmbeddingInterface_* embedding_interface) {
+  TF_ASSIGN_OR_RETURN(int encoding_width,
+                      embedding_interface->GetEncodingWidth());
+  TF_ASSIGN_OR_RETURN(int element_size, embedding_interface->GetElementSize());
+  const std::size_t row_bytes = encoding_width * element_size;
+
+  const int64 index_count = indices_shape.num_elements();
+  const int64 num_slots =
+      HostEmbeddingCache::NumSlots(index_count, lookup_info.cache_max_misses);
+  const HostEmbeddingCache::Policy policy =
+      HostEmbeddingCacheOptions().policy() == IpuHostEmbeddingCachePolicy::LFU
+          ? HostEmbeddingCache::Policy::kLFU
+          : HostEmbeddingCache::Policy::kLRU;
+
+  auto& caches = host_embedding_caches_[lookup_info.embedding_id];
+
+  const std::string handle =
+      lookup_info.stream_handle + lookup_info.embedding_id;
+  for (int replica = 0;
+       replica < std::max<int64>(1, current_replication_factor_); ++replica) {
+    caches.push_back(absl::make_unique<HostEmbeddingCacheContext>(
+        lookup_info.cache_rows, lookup_info.cache_max_misses, policy,
+        num_slots));
+    HostEmbeddingCacheContext* context = caches.back().get();
+
+    // Connect the indices callback, which also decides which rows are sent.
+    current_engine_->connectStreamToCallback(
+        handle + "_indices", replica,
+        [replica, index_count, context, embedding_interface](void* ptr) {
+          const int* indices = static_cast<int*>(ptr);
+          embedding_interface->EnqueueLookupIndices(replica, indices,
+                                                    index_count);
+          context->cache.Lookup(indices, index_count, context->slots.data());
+        });
+
+    // Connect the cache slots callback.
+    current_engine_->connectStreamToCallback(
+        handle + "_cache_slots", replica, [context](void* ptr) {
+          std::memcpy(ptr, context->slots.data(),
+                      context->slots.size() * sizeof(uint32));
+        });
+
+    // Connect the callback for the rows which are not in the cache.
+    current_engine_->connectStreamToCallback(
+        handle + "_cache_misses", replica,
+        [row_bytes, context, embedding_interface](void* ptr) {
+          char* dst = static_cast<char*>(ptr);
+          for (int index : context->cache.MissIndices()) {
+            std::memcpy(dst, embedding_interface->GetRow(index).ValueOrDie(),
+                        row_bytes);
+            dst += row_bytes;
+          }
+        });
+
+    // Connect the activations callback, which is only used when the lookup
+    // did not fit in the cache.
+    current_engine_->connectStreamToCallback(
+        handle + "_activations", replica,
+        [replica, embedding_interface](void* ptr) {
+          embedding_interface->DequeueLookupActivations(replica, ptr);
+        });
+  }
+
+  return Status::OK();
+}
+
 Status PoplarExecutor::ConnectHostEmbeddingUpdateToRendezvous(
     const HostEmbeddingInfo& update_info,
     HostEmbeddingInterface_* embedding_interface) {
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding)) {
     return Status::OK();
   }
 
-  if (EnableExperimentalRemoteBufferEmbedding()) {
+  if (EnableRemoteBufferEmbedding()) {
     return Status::OK();
   }
 
@@ -547,21 +781,117 @@ Status PoplarExecutor::ConnectHostEmbeddingUpdateToRendezvous(
   TF_RETURN_IF_ERROR(tensorflow::XLAShapeToTensorShape(
       update_info.indices_shape, &indices_shape));
 
-  for (int replica = 0;
-       replica < std::max<int64>(1, current_replication_factor_); ++replica) {
+  // The rows cached on the device have to be dropped when they are updated.
+  const std::vector<HostEmbeddingCache*> caches =
+      GetHostEmbeddingCaches(update_info.embedding_id);
+  if (update_info.deduplicate) {
+    return ConnectDeduplicatedHostEmbeddingUpdate(update_info, indices_shape,
+                                                  caches, embedding_interface);
+  }
+
+  const int64 num_replicas = std::max<int64>(1, current_replication_factor_);
+  auto update_indices =
+      std::make_shared<std::vector<std::vector<int>>>(num_replicas);
+
+  for (int replica = 0; replica < num_replicas; ++replica) {
     // Connect the indices callback.
     current_engine_->connectStreamToCallback(
         update_info.stream_handle + update_info.embedding_id + "_indices",
-        replica, [replica, indices_shape, embedding_interface](void* ptr) {
+        replica,
+        [replica, indices_shape, caches, update_indices,
+         embedding_interface](void* ptr) {
+          const int* indices = static_cast<int*>(ptr);
           embedding_interface->EnqueueUpdateIndices(
-              replica, static_cast<int*>(ptr), indices_shape.num_elements());
+              replica, indices, indices_shape.num_elements());
+          if (!caches.empty()) {
+            (*update_indices)[replica].assign(
+                indices, indices + indices_shape.num_elements());
+          }
         });
 
     // Connect the grads callback.
     current_engine_->connectStreamToCallback(
         update_info.stream_handle + update_info.embedding_id + "_grads",
-        replica, [replica, embedding_interface](void* ptr) {
+        replica,
+        [replica, caches, update_indices, embedding_interface](void* ptr) {
           embedding_interface->EnqueueUpdateGrads(replica, ptr);
+          const auto& indices = (*update_indices)[replica];
+          for (HostEmbeddingCache* cache : caches) {
+            cache->Invalidate(indices.data(), indices.size());
+          }
+        });
+  }
+
+  return Status::OK();
+}
+
+Status PoplarExecutor::ConnectDeduplicatedHostEmbeddingUpdate(
+    const HostEmbeddingInfo& update_info,
+    const tensorflow::TensorShape& indices_shape,
+    const std::vector<HostEmbeddingCache*>& caches,
+    HostEmbeddingInterface_* embedding_interface) {
+  const int64 index_count = indices_shape.num_elements();
+  const int64 max_unique = update_info.cache_max_misses;
+  const int64 num_replicas = std::max<int64>(1, current_replication_factor_);
+  const std::string handle =
+      update_info.stream_handle + update_info.embedding_id;
+
+  // The indices of the last update of each replica, with the slots and the
+  // distinct indices planned for them.
+  struct UpdateContext {
+    std::vector<int> indices;
+    std::vector<uint32> slots;
+    std::vector<int> unique;
+  };
+  auto contexts = std::make_shared<std::vector<UpdateContext>>(num_replicas);
+
+  // Applies the gradient rows for the given indices.
+  auto apply = [caches, embedding_interface](int replica,
+                                             const std::vector<int>& indices,
+                                             const void* grads) {
+    embedding_interface->EnqueueUpdateIndices(replica, indices.data(),
+                                              indices.size());
+    embedding_interface->EnqueueUpdateGrads(replica, grads);
+    for (HostEmbeddingCache* cache : caches) {
+      cache->Invalidate(indices.data(), indices.size());
+    }
+  };
+
+  for (int replica = 0; replica < num_replicas; ++replica) {
+    (*contexts)[replica].slots.resize(index_count + 1);
+
+    // Connect the indices callback, which also deduplicates the indices.
+    current_engine_->connectStreamToCallback(
+        handle + "_indices", replica,
+        [replica, index_count, max_unique, contexts](void* ptr) {
+          UpdateContext& context = (*contexts)[replica];
+          const int* indices = static_cast<int*>(ptr);
+          context.indices.assign(indices, indices + index_count);
+          DeduplicateIndices(indices, index_count, max_unique,
+                             context.slots.data(), &context.unique);
+        });
+
+    // Connect the callback sending the position of each index in the distinct
+    // indices.
+    current_engine_->connectStreamToCallback(
+        handle + "_dedup_slots", replica, [replica, contexts](void* ptr) {
+          const UpdateContext& context = (*contexts)[replica];
+          std::memcpy(ptr, context.slots.data(),
+                      context.slots.size() * sizeof(uint32));
+        });
+
+    // Connect the callback for the summed gradients of the distinct indices.
+    current_engine_->connectStreamToCallback(
+        handle + "_dedup_grads", replica,
+        [replica, contexts, apply](void* ptr) {
+          apply(replica, (*contexts)[replica].unique, ptr);
+        });
+
+    // Connect the callback for the gradients of all the indices, which is only
+    // used when there were too many distinct indices.
+    current_engine_->connectStreamToCallback(
+        handle + "_grads", replica, [replica, contexts, apply](void* ptr) {
+          apply(replica, (*contexts)[replica].indices, ptr);
         });
   }
 
@@ -571,21 +901,28 @@ Status PoplarExecutor::ConnectHostEmbeddingUpdateToRendezvous(
 Status PoplarExecutor::ConnectHostEmbeddingNotify(
     const HostEmbeddingInfo& notify_info,
     HostEmbeddingInterface_* embedding_interface) {
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::HostEmbedding)) {
     return Status::OK();
   }
 
-  if (EnableExperimentalRemoteBufferEmbedding()) {
+  if (EnableRemoteBufferEmbedding()) {
     return Status::OK();
   }
 
+  const std::vector<HostEmbeddingCache*> caches =
+      GetHostEmbeddingCaches(notify_info.embedding_id);
+
   for (int replica = 0;
        replica < std::max<int64>(1, current_replication_factor_); ++replica) {
     // Connect the notify callback.
     current_engine_->connectStreamToCallback(
         notify_info.stream_handle + notify_info.embedding_id + "_notify",
-        replica, [replica, embedding_interface](void* ptr) {
+        replica, [replica, caches, embedding_interface](void* ptr) {
           embedding_interface->Notify(replica);
+          // Any of the rows might have been updated.
+          for (HostEmbeddingCache* cache : caches) {
+            cache->InvalidateAll();
+          }
         });
   }
 
@@ -595,7 +932,7 @@ Status PoplarExecutor::ConnectHostEmbeddingNotify(
 Status PoplarExecutor::DisconnectHostEmbeddingLookup(
     const HostEmbeddingInfo& lookup_info,
     HostEmbeddingInterface_* embedding_interface) {
-  if (EnableExperimentalRemoteBufferEmbedding()) {
+  if (EnableRemoteBufferEmbedding()) {
     TF_ASSIGN_OR_RETURN(int token_count, embedding_interface->GetTokenCount());
     TF_ASSIGN_OR_RETURN(int encoding_width,
                         embedding_interface->GetEncodingWidth());
@@ -645,6 +982,12 @@ Status PoplarExecutor::DisconnectHostEmbeddingLookup(
     return xla::FailedPrecondition("Unknown host embedding splitting strategy");
   }
 
+  for (HostEmbeddingCache* cache :
+       GetHostEmbeddingCaches(lookup_info.embedding_id)) {
+    VLOG(1) << "Host embedding " << lookup_info.embedding_id
+            << " cache statistics: " << cache->StatsString();
+  }
+
   return Status::OK();
 }
 
@@ -663,30 +1006,50 @@ Status PoplarExecutor::DisconnectHostEmbeddingNotify(
 namespace {
 class InfeedPrefetchCallback : public poplar::StreamCallback {
  public:
-  InfeedPrefetchCallback(InfeedQueue* queue, uint64 num_bytes)
-      : queue_(queue), num_bytes_(num_bytes), look_ahead_(0) {}
+  InfeedPrefetchCallback(InfeedQueue* queue, uint64 num_bytes,
+                         InfeedStatistics* statistics,
+                         const ParallelCopier* copier, int ordinal)
+      : queue_(queue),
+        num_bytes_(num_bytes),
+        look_ahead_(0),
+        statistics_(statistics),
+        copier_(copier),
+        ordinal_(ordinal) {}
 
   poplar::StreamCallback::Result prefetch(void* dest) noexcept override {
+    IpuActivityScope activity(ordinal_, IpuActivityType::kInfeed,
+                              "infeed_prefetch");
+    const auto start = InfeedStatistics::Clock::now();
+    statistics_->RecordQueueOccupancy(queue_->Size());
     tensorflow::TensorBuffer* buffer;
     // Try to get a value from the queue.
     if (queue_->TryPop(buffer, look_ahead_)) {
-      std::memcpy(dest, buffer->data(), num_bytes_);
+      copier_->Copy(dest, buffer->data(), num_bytes_);
       look_ahead_++;
+      statistics_->RecordPrefetch(start, InfeedStatistics::Clock::now(),
+                                  num_bytes_, true);
       return poplar::StreamCallback::Result::Success;
     } else {
+      statistics_->RecordPrefetch(start, InfeedStatistics::Clock::now(), 0,
+                                  false);
       return poplar::StreamCallback::Result::NotAvailable;
     }
   }
 
   void fetch(void* dest) noexcept override {
+    IpuActivityScope activity(ordinal_, IpuActivityType::kInfeed,
+                              "infeed_fetch");
+    const auto start = InfeedStatistics::Clock::now();
+    statistics_->RecordQueueOccupancy(queue_->Size());
     tensorflow::TensorBuffer* buffer;
     if (!queue_->BlockPop(buffer, look_ahead_)) {
       LOG(FATAL) << "Infeed dataset iterator out of range. Are you trying to "
                  << "dequeue more elements than are in the dataset?";
     }
 
-    std::memcpy(dest, buffer->data(), num_bytes_);
+    copier_->Copy(dest, buffer->data(), num_bytes_);
     look_ahead_++;
+    statistics_->RecordFetch(start, InfeedStatistics::Clock::now(), num_bytes_);
   }
 
   void complete() noexcept override {
@@ -698,6 +1061,9 @@ class InfeedPrefetchCallback : public poplar::StreamCallback {
   InfeedQueue* queue_;
   const uint64 num_bytes_;
   std::size_t look_ahead_;
+  InfeedStatistics* statistics_;
+  const ParallelCopier* copier_;
+  const int ordinal_;
 };
 
 class NullPrefetchCallback : public poplar::StreamCallback {
@@ -738,9 +1104,10 @@ class NullPrefetchCallback : public poplar::StreamCallback {
 
 void PoplarExecutor::ConnectInfeedsToStreamCallback(
     const InfeedInfos& infeed_infos) {
-  // Don't connect any streams if using synthetic data
-  if (UseSyntheticData()) {
-    return;
+  // The copier is shared by the callbacks of all the infeeds.
+  if (!infeed_copier_) {
+    infeed_copier_ = absl::make_unique<ParallelCopier>(
+        PoplarXlaFlags::Get().infeed_copy_threads);
   }
 
   for (const auto& infeed_info : infeed_infos) {
@@ -766,7 +1133,9 @@ void PoplarExecutor::ConnectInfeedsToStreamCallback(
               GetInfeedAllocator(), bytes_per_replica);
         } else {
           infeed_callback = absl::make_unique<InfeedPrefetchCallback>(
-              replica_queues[j], bytes_per_replica);
+              replica_queues[j], bytes_per_replica,
+              &infeed_dataset_iterator->GetStatistics(), infeed_copier_.get(),
+              ordinal_);
         }
         current_engine_->connectStreamToCallback(
             GetInfeedCopyHandle(infeed_info.stream_prefix, j), replica_id,
@@ -778,11 +1147,6 @@ void PoplarExecutor::ConnectInfeedsToStreamCallback(
 
 void PoplarExecutor::ConnectOutfeedToStreamCallback(
     const OutfeedInfos& outfeed_infos) {
-  // Don't connect any streams if using synthetic data
-  if (UseSyntheticData()) {
-    return;
-  }
-
   for (const auto& outfeed_info : outfeed_infos) {
     const auto& outfeed_id = outfeed_info.config.feed_id();
     auto itr = outfeed_contexts_.find(outfeed_id);
@@ -794,28 +1158,63 @@ void PoplarExecutor::ConnectOutfeedToStreamCallback(
     auto* outfeed_context = itr->second.get();
     auto tensor_count = outfeed_context->shapes.size();
     for (unsigned j = 0; j < tensor_count; ++j) {
-      size_t length = ShapeUtil::ByteSizeOf(outfeed_context->shapes[j]);
+      size_t length = GetOutfeedTransferByteSize(outfeed_context->config,
+                                                 outfeed_context->shapes[j]);
       auto bytes_per_replica = length / current_replication_factor_;
-      bytes_per_replica *= outfeed_info.config.io_batch_size();
+      bytes_per_replica *=
+          GetOutfeedElementsPerTransfer(outfeed_context->config);
       for (auto replica_id = 0; replica_id < current_replication_factor_;
            ++replica_id) {
         auto& queue =
             outfeed_context->callback_to_io_thread_queues[j][replica_id];
+        auto& waiter = outfeed_context->waiter;
+        const int ordinal = ordinal_;
         current_engine_->connectStreamToCallback(
             GetOutfeedCopyHandle(outfeed_info.stream_prefix, j), replica_id,
-            [&queue, bytes_per_replica](void* src) {
+            [&queue, &waiter, bytes_per_replica, ordinal](void* src) {
+              IpuActivityScope activity(ordinal, IpuActivityType::kOutfeed,
+                                        "outfeed_callback");
               // The outfeed callback gets the buffer at the back of the
               // queue, writes to it, and then moves the write position of the
               // queue.
               void* dest = queue->BlockBack();
               std::memcpy(dest, src, bytes_per_replica);
               queue->FinishedBack();
+              // Wake up the IO thread if it is waiting for data.
+              waiter.Notify();
             });
       }
     }
   }
 }
 
+void PoplarExecutor::EnqueueReplicaSlices(
+    std::vector<tensorflow::Tensor>& outputs,
+    std::vector<std::vector<InfeedQueue*>>& infeed_queues,
+    int64 replication_factor, int64 replica_begin, int64 replica_end) {
+  for (size_t j = 0; j < outputs.size(); ++j) {
+    auto& tensor = outputs[j];
+    if (replication_factor > 1) {
+      CHECK_EQ(tensor.dim_size(0), replication_factor);
+    }
+
+    // Enqueue tensors to each replica.
+    for (int64 replica_id = replica_begin; replica_id < replica_end;
+         replica_id++) {
+      // For replicated graphs, slice the input tensor and enqueue it
+      // separately for each replica. Note that the tensor slice shares the
+      // data buffer with the tensor which works with ref counting.
+      tensorflow::Tensor tensor_slice =
+          replication_factor > 1 ? tensor.SubSlice(replica_id) : tensor;
+      auto& queue = infeed_queues[replica_id][j];
+      auto* tb = tensorflow::DMAHelper::buffer(&tensor_slice);
+      tb->Ref();
+      queue->BlockPush(tb);
+      queue->AdvanceWritePosition();
+    }
+  }
+}
+
 IOFunction PoplarExecutor::CreateInfeedIOThreadFunction(
     const FeedInfo& infeed_info) {
   // Find the iterator.
@@ -827,8 +1226,15 @@ IOFunction PoplarExecutor::CreateInfeedIOThreadFunction(
   }
   InfeedIterator* infeed_dataset_iterator = itr->second.get();
 
-  return [this, infeed_dataset_iterator](std::atomic<bool>& cancelled) {
+  const FeedWaitOptions wait_options = GetFeedWaitOptions();
+  return [this, infeed_dataset_iterator,
+          wait_options](std::atomic<bool>& cancelled) {
     auto& infeed_queues = infeed_dataset_iterator->GetInfeedQueues();
+    infeed_queues[0][0]->GetWaiter().ResetStats();
+    auto log_wait_stats = [&infeed_queues]() {
+      VLOG(1) << "Infeed IO thread waiting time - "
+              << infeed_queues[0][0]->GetWaiter().StatsString();
+    };
     while (!cancelled) {
       // We do not call GetNext if queues are full.
       // We make an assumption that all tensors from each queue for each
@@ -837,6 +1243,9 @@ IOFunction PoplarExecutor::CreateInfeedIOThreadFunction(
       // queues are full.
       if (infeed_queues[0][0]->IsFull()) {
         VLOG(2) << "Infeed queue is full.";
+        IpuActivityScope activity(ordinal_, IpuActivityType::kInfeed,
+                                  "infeed_wait");
+        infeed_queues[0][0]->WaitUntilNotFull(wait_options, cancelled);
         continue;
       }
 
@@ -846,8 +1255,12 @@ IOFunction PoplarExecutor::CreateInfeedIOThreadFunction(
 
       std::vector<tensorflow::Tensor> outputs;
       bool end_of_sequence = false;
-      TF_RETURN_IF_ERROR(
-          infeed_dataset_iterator->GetNext(&outputs, &end_of_sequence));
+      {
+        IpuActivityScope activity(ordinal_, IpuActivityType::kInfeed,
+                                  "infeed_get_next");
+        TF_RETURN_IF_ERROR(
+            infeed_dataset_iterator->GetNext(&outputs, &end_of_sequence));
+      }
 
       if (end_of_sequence) {
         VLOG(1) << "The dataset iterator has reached the end of the dataset.";
@@ -860,40 +1273,165 @@ IOFunction PoplarExecutor::CreateInfeedIOThreadFunction(
 
         // This is not considered an error. However, we will report an
         // error if the consumer tries to pop past the end of the queue.
+        log_wait_stats();
+        return Status::OK();
+      }
+
+      EnqueueReplicaSlices(outputs, infeed_queues, current_replication_factor_,
+                           0, current_replication_factor_);
+    }
+    log_wait_stats();
+    return Status::OK();
+  };
+}
+
+namespace {
+// Used to pass the elements of an infeed dataset from the thread calling
+// GetNext to the thread enqueuing them for a group of replicas.
+struct ReplicaGroupHandoff {
+  ReplicaGroupHandoff()
+      : queue(std::vector<tensorflow::Tensor>(),
+              [](std::vector<tensorflow::Tensor>& v) { v.clear(); }) {}
+
+  // An empty vector signals the end of the dataset.
+  SPSCQueue<std::vector<tensorflow::Tensor>, 64> queue;
+  // Signalled when the group thread has consumed an element.
+  FeedWaiter not_full;
+  // Signalled when a new element has been pushed.
+  FeedWaiter not_empty;
+};
+}  // namespace
+
+int64 PoplarExecutor::GetNumInfeedReplicaGroups() const {
+  int64 num_groups = PoplarXlaFlags::Get().infeed_replica_groups;
+  if (PoplarXlaFlags::Get().max_infeed_threads > 0) {
+    num_groups =
+        std::min<int64>(num_groups, PoplarXlaFlags::Get().max_infeed_threads);
+  }
+  return std::max<int64>(
+      1, std::min<int64>(num_groups, current_replication_factor_));
+}
+
+std::vector<std::unique_ptr<IOThread>>
+PoplarExecutor::CreateReplicaGroupInfeedIOThreads(const FeedInfo& infeed_info,
+                                                  int64 num_groups) {
+  auto itr = infeed_iterators_.find(infeed_info.config.feed_id());
+  if (itr == infeed_iterators_.end()) {
+    LOG(FATAL)
+        << "Trying to access an infeed context which has not been created."
+        << " Did you initialize the infeed_queue?";
+  }
+  InfeedIterator* infeed_dataset_iterator = itr->second.get();
+  const std::string& feed_id = infeed_info.config.feed_id();
+  const FeedWaitOptions wait_options = GetFeedWaitOptions();
+  const int64 replication_factor = current_replication_factor_;
+
+  // The handoffs are shared between the fetching and the group threads so
+  // that they outlive all of them.
+  auto handoffs =
+      std::make_shared<std::vector<std::unique_ptr<ReplicaGroupHandoff>>>();
+  for (int64 group = 0; group < num_groups; ++group) {
+    handoffs->emplace_back(absl::make_unique<ReplicaGroupHandoff>());
+  }
+
+  std::vector<std::unique_ptr<IOThread>> threads;
+
+  // The fetching thread which gets the elements from the dataset iterator and
+  // passes them to all the groups.
+  IOFunction fetch_fn = [infeed_dataset_iterator, handoffs,
+                         wait_options](std::atomic<bool>& cancelled) {
+    while (!cancelled) {
+      // Wait for all the groups to have space.
+      bool has_space = true;
+      for (auto& handoff : *handoffs) {
+        has_space &= handoff->not_full.Wait(
+            wait_options, cancelled,
+            [&handoff]() { return !handoff->queue.IsFull(); });
+      }
+      if (!has_space) {
+        continue;
+      }
+
+      std::vector<tensorflow::Tensor> outputs;
+      bool end_of_sequence = false;
+      TF_RETURN_IF_ERROR(
+          infeed_dataset_iterator->GetNext(&outputs, &end_of_sequence));
+
+      if (end_of_sequence) {
+        VLOG(1) << "The dataset iterator has reached the end of the dataset.";
+        outputs.clear();
+      }
+
+      for (auto& handoff : *handoffs) {
+        handoff->queue.Push(outputs);
+        handoff->queue.AdvanceWritePosition();
+        handoff->not_empty.Notify();
+      }
+
+      if (end_of_sequence) {
         return Status::OK();
       }
+    }
+    return Status::OK();
+  };
+  threads.emplace_back(
+      absl::make_unique<IOThread>(feed_id + "/fetch", std::move(fetch_fn)));
+
+  // The group threads which slice the elements and enqueue them for each
+  // replica in the group. When NUMA is enabled the groups are distributed
+  // across the NUMA nodes.
+  for (int64 group = 0; group < num_groups; ++group) {
+    const int64 replica_begin = group * replication_factor / num_groups;
+    const int64 replica_end = (group + 1) * replication_factor / num_groups;
+    ReplicaGroupHandoff* handoff = handoffs->at(group).get();
+
+    IOFunction group_fn = [infeed_dataset_iterator, handoffs, handoff,
+                           replica_begin, replica_end, replication_factor,
+                           wait_options](std::atomic<bool>& cancelled) {
+      auto& infeed_queues = infeed_dataset_iterator->GetInfeedQueues();
+      while (!cancelled) {
+        // Wait for the first queue of the group to have space - see
+        // CreateInfeedIOThreadFunction.
+        if (!infeed_queues[replica_begin][0]->WaitUntilNotFull(wait_options,
+                                                              cancelled)) {
+          continue;
+        }
+
+        std::vector<tensorflow::Tensor> outputs;
+        if (!handoff->not_empty.Wait(wait_options, cancelled, [handoff]() {
+              return !handoff->queue.IsEmpty();
+            })) {
+          continue;
+        }
+        handoff->queue.Pop(outputs);
+        handoff->queue.AdvanceReadPosition();
+        handoff->not_full.Notify();
 
-      for (size_t j = 0; j < outputs.size(); ++j) {
-        auto& tensor = outputs[j];
-        std::vector<tensorflow::Tensor> tensor_slices;
-        if (current_replication_factor_ > 1) {
-          // For replicated graphs, slice the input tensor and enqueue
-          // it separately for each replica.
-          CHECK_EQ(tensor.dim_size(0), current_replication_factor_);
-          tensor_slices.reserve(current_replication_factor_);
-          for (auto replica_id = 0; replica_id < current_replication_factor_;
+        if (outputs.empty()) {
+          for (int64 replica_id = replica_begin; replica_id < replica_end;
                ++replica_id) {
-            // Note that the tensor_slice shares the data buffer with the
-            // tensor which works with ref counting.
-            tensor_slices.push_back(tensor.SubSlice(replica_id));
+            for (auto& queue : infeed_queues[replica_id]) {
+              queue->SignalEndOfQueue();
+            }
           }
-        } else {
-          tensor_slices = {tensor};
+          return Status::OK();
         }
 
-        // Enqueue tensors to each replica.
-        for (size_t replica_id = 0; replica_id < tensor_slices.size();
-             replica_id++) {
-          auto& queue = infeed_queues[replica_id][j];
-          auto* tb = tensorflow::DMAHelper::buffer(&tensor_slices[replica_id]);
-          tb->Ref();
-          queue->BlockPush(tb);
-          queue->AdvanceWritePosition();
-        }
+        EnqueueReplicaSlices(outputs, infeed_queues, replication_factor,
+                             replica_begin, replica_end);
       }
+      return Status::OK();
+    };
+
+    tensorflow::ThreadOptions options;
+    if (tensorflow::port::NUMAEnabled()) {
+      options.numa_node = group % tensorflow::port::NUMANumNodes();
     }
-    return Status::OK();
-  };
+    threads.emplace_back(absl::make_unique<IOThread>(
+        absl::StrCat(feed_id, "/replica_group_", group), std::move(group_fn),
+        options));
+  }
+  return threads;
 }
 
 namespace {
@@ -920,9 +1458,11 @@ IOFunction PoplarExecutor::CreateOutfeedIOThreadFunction(
   }
   OutfeedContext* outfeed_context = itr->second.get();
 
-  return [this, outfeed_context](std::atomic<bool>& cancelled) {
+  const FeedWaitOptions wait_options = GetFeedWaitOptions();
+  return [this, outfeed_context, wait_options](std::atomic<bool>& cancelled) {
     int replicas = current_replication_factor_;
     replicas = std::max(replicas, 1);
+    outfeed_context->waiter.ResetStats();
 
     // Lock the outfeed queues if it is of the GetLast type so that the CPU
     // OP does not try to dequeue the outfeed during the execution.
@@ -932,85 +1472,129 @@ IOFunction PoplarExecutor::CreateOutfeedIOThreadFunction(
 
     // Continue while the thread has not been cancelled, and if it has been
     // cancelled allow for up to two extra runs.
-    uint32 all_queues_empty_for = 0;
-    while (!cancelled || all_queues_empty_for != 2) {
-      bool all_queues_empty = true;
-      int io_batch_size = outfeed_context->config.io_batch_size();
+    auto all_queues_empty = [outfeed_context]() {
       for (auto& tensor_queues :
            outfeed_context->callback_to_io_thread_queues) {
         for (auto& replica_queue : tensor_queues) {
-          all_queues_empty &= !replica_queue->HasItemsWaiting();
+          if (replica_queue->HasItemsWaiting()) {
+            return false;
+          }
         }
       }
+      return true;
+    };
 
-      // Track empty queues when we are trying to exit
-      if (all_queues_empty && cancelled) {
-        all_queues_empty_for++;
-      }
+    uint32 all_queues_empty_for = 0;
+    while (!cancelled || all_queues_empty_for != 2) {
+      const int64 io_batch_size =
+          GetOutfeedElementsPerTransfer(outfeed_context->config);
 
       // Continue if all the outfeed queues are empty.
-      if (all_queues_empty) {
+      if (all_queues_empty()) {
+        if (cancelled) {
+          // Track empty queues when we are trying to exit
+          all_queues_empty_for++;
+        } else {
+          // Wait for the stream callbacks to add items to any of the queues.
+          IpuActivityScope activity(ordinal_, IpuActivityType::kOutfeed,
+                                    "outfeed_wait");
+          outfeed_context->waiter.Wait(
+              wait_options, cancelled,
+              [&all_queues_empty]() { return !all_queues_empty(); });
+        }
         continue;
       }
 
+      // The elements which are written to the file sink.
+      std::vector<tensorflow::Tensor> file_sink_batch;
+
       // Lock the outfeed queue so that the CPU OP does not try to dequeue
       // whilst moving data off the device.
       {
         std::lock_guard<std::recursive_mutex> guard(outfeed_context->mutex);
-        // Allocate the tensors before dequeuing.
-        bool allocate_tensors = true;
-        if (outfeed_context->config.mode() == PoplarFeedConfig::GetLast) {
+        const bool get_all =
+            outfeed_context->config.mode() == PoplarFeedConfig::GetAll;
+        if (get_all) {
+          // Make space in the ring for the elements before dequeuing.
+          outfeed_context->tensor_ring->Reserve(io_batch_size);
+        } else if (outfeed_context->io_thread_output_queues.empty()) {
           // For the get last we only allocate tensors once.
-          allocate_tensors = outfeed_context->io_thread_output_queues.empty();
-        }
-
-        if (allocate_tensors) {
           AllocateTensors(outfeed_context->io_thread_output_queues,
                           outfeed_context->tf_data_types,
-                          outfeed_context->tf_shapes, io_batch_size);
+                          outfeed_context->tf_shapes, 1);
         }
 
         // We need to copy along 3 axis.  There are multiple queues from
         // the IPU, one  per tuple and per replica.  In each queue there
-        // is a block of data containing one or more tensors.  There is a
-        // single queue out of the executor, consisting of a vector of
-        // Tensors, one per tuple entry.  If there are multiple replicas
-        // then the outer dimension of the Tensors has the same value as the
-        // replica count, and the output from each replica is concatenated
-        // into that Tensor.
+        // is a block of data containing one or more tensors.  For the GetAll
+        // mode the data is written directly into the stacked tensors of the
+        // tensor ring (one per tuple entry, with an outer dimension for the
+        // element index), for the GetLast mode only the last element is
+        // written into a single vector of Tensors. If there are multiple
+        // replicas then the next dimension of the Tensors has the same value
+        // as the replica count, and the output from each replica is
+        // concatenated into that Tensor.
         //
         // We loop over each queue (by tuple  and replica), and dequeue the
-        // block of data. This is then inserted  into the output queue as
+        // block of data. This is then inserted into the output as
         // appropriate.
         for (size_t tuple_idx = 0; tuple_idx < outfeed_context->shapes.size();
              ++tuple_idx) {
+          const int64 bytes_per_replica =
+              outfeed_context->tf_shapes[tuple_idx].num_elements() *
+              tensorflow::DataTypeSize(
+                  outfeed_context->tf_data_types[tuple_idx]) /
+              replicas;
+          const bool from_fp16 = IsOutfeedTransferredAsFp16(
+              outfeed_context->config, outfeed_context->shapes[tuple_idx]);
+          const int64 transfer_bytes_per_replica =
+              GetOutfeedTransferByteSize(outfeed_context->config,
+                                         outfeed_context->shapes[tuple_idx]) /
+              replicas;
           // Dequeue tensors from each replica.
           for (int64 replica_id = 0; replica_id < replicas; replica_id++) {
             auto& queue =
                 outfeed_context
                     ->callback_to_io_thread_queues[tuple_idx][replica_id];
 
-            // Dequeue the data and insert into the correct output queue.
+            // Dequeue the data and insert into the correct output.
             uint8_t* src = reinterpret_cast<uint8_t*>(queue->BlockFront());
-            for (int b = 0; b < io_batch_size; b++) {
-              std::vector<tensorflow::Tensor>& tensors_to_write_to =
-                  outfeed_context->io_thread_output_queues.at(io_batch_size -
-                                                              b - 1);
-
-              auto& tensor = tensors_to_write_to[tuple_idx];
-
-              // When there are mutiple replicas, insert the data into a slice
-              // out of dinension 0.  Otherwise just use the whole tensor.
-              auto output_tensor =
-                  (replicas == 1 ? tensor : tensor.SubSlice(replica_id));
-              auto* tb = tensorflow::DMAHelper::buffer(&output_tensor);
-
-              std::memcpy(tb->data(), src, output_tensor.AllocatedBytes());
-              src += output_tensor.AllocatedBytes();
+            if (get_all) {
+              for (int b = 0; b < io_batch_size; b++) {
+                // When there are mutiple replicas, insert the data into a
+                // slice out of the replica dimension.
+                char* dest =
+                    outfeed_context->tensor_ring->ElementData(tuple_idx, b) +
+                    replica_id * bytes_per_replica;
+                CopyOutfeedElement(dest, src, bytes_per_replica, from_fp16);
+                src += transfer_bytes_per_replica;
+              }
+            } else {
+              // Only the last element of the batch is kept.
+              src += (io_batch_size - 1) * transfer_bytes_per_replica;
+              auto& tensor =
+                  outfeed_context->io_thread_output_queues.front()[tuple_idx];
+              char* dest =
+                  static_cast<char*>(tensorflow::DMAHelper::base(&tensor)) +
+                  replica_id * bytes_per_replica;
+              CopyOutfeedElement(dest, src, bytes_per_replica, from_fp16);
             }
             queue->FinishedFront();
           }
         }
+
+        if (get_all) {
+          outfeed_context->tensor_ring->Commit(io_batch_size);
+          if (outfeed_context->file_sink) {
+            file_sink_batch = outfeed_context->tensor_ring->TakeAll();
+          }
+        }
+      }
+
+      // Writing to the file sink blocks when the files are not written as
+      // fast as the elements arrive, so it is done without holding the lock.
+      if (!file_sink_batch.empty()) {
+        outfeed_context->file_sink->Write(std::move(file_sink_batch));
       }
     }
 
@@ -1018,6 +1602,13 @@ IOFunction PoplarExecutor::CreateOutfeedIOThreadFunction(
     if (outfeed_context->config.mode() == PoplarFeedConfig::GetLast) {
       outfeed_context->mutex.unlock();
     }
+    VLOG(1) << "Outfeed IO thread waiting time - "
+            << outfeed_context->waiter.StatsString();
+
+    // Make sure all the elements of the execution are in the files.
+    if (outfeed_context->file_sink) {
+      return outfeed_context->file_sink->Flush();
+    }
     return Status::OK();
   };
 }
@@ -1026,7 +1617,15 @@ void PoplarExecutor::LaunchIOThreads(const InfeedInfos& infeed_infos,
                                      const OutfeedInfos& outfeed_infos) {
   CHECK_EQ(io_threads_.size(), 0);
   // Start all the infeeds.
+  const int64 num_replica_groups = GetNumInfeedReplicaGroups();
   for (const FeedInfo& info : infeed_infos) {
+    if (num_replica_groups > 1) {
+      for (auto& thread :
+           CreateReplicaGroupInfeedIOThreads(info, num_replica_groups)) {
+        io_threads_.emplace_back(std::move(thread));
+      }
+      continue;
+    }
     IOFunction fn = CreateInfeedIOThreadFunction(info);
     io_threads_.emplace_back(
         absl::make_unique<IOThread>(info.config.feed_id(), std::move(fn)));
@@ -1038,11 +1637,18 @@ void PoplarExecutor::LaunchIOThreads(const InfeedInfos& infeed_infos,
     io_threads_.emplace_back(
         absl::make_unique<IOThread>(info.config.feed_id(), std::move(fn)));
   }
+
+  // Each IO thread spins on its queue before it sleeps, so it is counted as a
+  // whole core.
+  io_thread_reservation_ =
+      absl::make_unique<tensorflow::data::model::ResourceReservation>(
+          io_threads_.size(), /*ram_bytes=*/0);
 }
 
 void PoplarExecutor::StopIOThreads() {
   // Blocks the thread until all the threads have stopped and joined back.
   io_threads_.clear();
+  io_thread_reservation_.reset();
 }
 
 void PoplarExecutor::DeferredDeallocation() {
@@ -1078,6 +1684,10 @@ bool PoplarExecutor::Memcpy(se::Stream* stream, se::DeviceMemoryBase* pop_dst,
 Status PoplarExecutor::SynchronousMemcpy(se::DeviceMemoryBase* pop_dst,
                                          const void* host_src, uint64 size) {
   TensorControl* tc = reinterpret_cast<TensorControl*>(pop_dst->opaque());
+  {
+    std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
+    tc->OwnData(size < tc->size);
+  }
   memcpy(tc->data, host_src, size);
   {
     std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
@@ -1090,13 +1700,12 @@ Status PoplarExecutor::SynchronousMemcpy(se::DeviceMemoryBase* pop_dst,
 Status PoplarExecutor::SynchronousMemcpy(void* host_dst,
                                          const se::DeviceMemoryBase& pop_src,
                                          uint64 size) {
-  const TensorControl* tc =
-      reinterpret_cast<const TensorControl*>(pop_src.opaque());
+  // Reading the tensor back changes where its data is held.
+  TensorControl* tc = reinterpret_cast<TensorControl*>(
+      const_cast<void*>(pop_src.opaque()));
   {
     std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
-    if (tc->on_device == true && !tc->output_handle.empty()) {
-      TF_RETURN_IF_ERROR(MoveDeviceToHost());
-    }
+    TF_RETURN_IF_ERROR(MoveTensorsDeviceToHost({tc}));
   }
   memcpy(host_dst, tc->data, size);
   return Status::OK();
@@ -1105,13 +1714,12 @@ Status PoplarExecutor::SynchronousMemcpy(void* host_dst,
 Status PoplarExecutor::SynchronousMemcpyDeviceToDevice(
     se::DeviceMemoryBase* dst, const se::DeviceMemoryBase& src, uint64 size) {
   TensorControl* dst_tc = reinterpret_cast<TensorControl*>(dst->opaque());
-  const TensorControl* src_tc =
-      reinterpret_cast<const TensorControl*>(src.opaque());
+  TensorControl* src_tc =
+      reinterpret_cast<TensorControl*>(const_cast<void*>(src.opaque()));
   {
     std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
-    if (src_tc->on_device == true && !src_tc->output_handle.empty()) {
-      TF_RETURN_IF_ERROR(MoveDeviceToHost());
-    }
+    TF_RETURN_IF_ERROR(MoveTensorsDeviceToHost({src_tc}));
+    dst_tc->OwnData(size < dst_tc->size);
   }
   memcpy(dst_tc->data, src_tc->data, size);
   {
@@ -1122,6 +1730,28 @@ Status PoplarExecutor::SynchronousMemcpyDeviceToDevice(
   return Status::OK();
 }
 
+Status PoplarExecutor::BorrowHostBuffer(se::DeviceMemoryBase* pop_dst,
+                                        const void* host_src, uint64 size,
+                                        std::function<void()> release) {
+  TensorControl* tc = reinterpret_cast<TensorControl*>(pop_dst->opaque());
+  std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
+  if (size != tc->size) {
+    return tensorflow::errors::InvalidArgument(
+        "Cannot borrow a host buffer of ", size, " bytes for a buffer of ",
+        tc->size, " bytes.");
+  }
+  if (tc->release_borrowed_data) {
+    tc->release_borrowed_data();
+  } else {
+    tensorflow::port::AlignedFree(tc->data);
+  }
+  tc->data = static_cast<char*>(const_cast<void*>(host_src));
+  tc->release_borrowed_data = std::move(release);
+  tc->on_device = false;
+  tc->input_handle.clear();
+  return Status::OK();
+}
+
 bool PoplarExecutor::MemcpyDeviceToDevice(se::Stream* stream,
                                           se::DeviceMemoryBase* pop_dst,
                                           const se::DeviceMemoryBase& pop_src,
@@ -1361,6 +1991,56 @@ Status PoplarExecutor::AttachToPoplarDevice() {
   return Status::OK();
 }
 
+void PoplarExecutor::StartAsynchronousAttach() {
+  // The graphs are compiled while attaching, so they are compiled for the
+  // remote buffer support of the devices which can be attached to.
+  bool supports_remote_buffers = false;
+  try {
+    const poplar::Target& target = GetOrCreatePoplarTarget();
+    if (target.getTargetType() == poplar::TargetType::IPU) {
+      if (ipu_.DeviceConfigured()) {
+        supports_remote_buffers = ipu_.Device().supportsRemoteBuffers();
+      } else {
+        auto device_list = GetDeviceManager().getDevices(
+            target.getTargetType(), GetNumIpusInLocalProcess(target));
+        supports_remote_buffers = !device_list.empty() &&
+                                  device_list.front().supportsRemoteBuffers();
+      }
+    }
+  } catch (poplar::poplar_error e) {
+    LOG(WARNING) << "Unable to query the remote buffer support of the devices "
+                    "for ordinal "
+                 << ordinal_ << ": " << e.what();
+  }
+
+  VLOG(1) << "Attaching to the device for ordinal " << ordinal_
+          << " in the background.";
+  std::lock_guard<std::mutex> l(async_attach_mu_);
+  async_attach_supports_remote_buffers_ = supports_remote_buffers;
+  async_attach_status_ = Status::OK();
+  async_attach_ = std::async(std::launch::async,
+                             [this]() { return AttachToPoplarDevice(); });
+}
+
+Status PoplarExecutor::WaitForAsynchronousAttach() {
+  std::lock_guard<std::mutex> l(async_attach_mu_);
+  if (!async_attach_.valid()) {
+    return async_attach_status_;
+  }
+
+  async_attach_status_ = async_attach_.get();
+  if (async_attach_status_.ok() &&
+      ipu_.TargetOrDie().getTargetType() == poplar::TargetType::IPU &&
+      ipu_.Device().supportsRemoteBuffers() !=
+          async_attach_supports_remote_buffers_) {
+    async_attach_status_ = FailedPrecondition(
+        "The device attached to for ordinal %d does not have the remote "
+        "buffer support the graphs were compiled for.",
+        ordinal_);
+  }
+  return async_attach_status_;
+}
+
 Status PoplarExecutor::CreatePoplarTarget() {
   bool has_user_config = (current_config_.device_config_size() > 0);
 
@@ -1401,7 +2081,40 @@ Status PoplarExecutor::CreatePoplarTarget() {
       CHECK(HasIpuHardware());
       // A specific device was chosen.
       auto device_list = GetDeviceManager().getDevices();
+      if (*device_index < 0 ||
+          *device_index >= static_cast<int64>(device_list.size())) {
+        return InvalidArgument(
+            "Device configuration index %d for /device:IPU:%d is not one of "
+            "the %d available devices.",
+            *device_index, ordinal_, device_list.size());
+      }
       auto& device = device_list.at(*device_index);
+      // Several models can run side by side on the devices of the different
+      // ordinals only when they don't share any IPUs.
+      const auto ids = device.getDriverIDs();
+      for (int64 other = 0; other != current_config_.device_config_size();
+           ++other) {
+        const auto& other_config = current_config_.device_config(other);
+        const int64 other_index = other_config.cfg_index();
+        if (other == ordinal_ ||
+            other_config.selection_case() !=
+                IpuOptions::DeviceConfig::SelectionCase::kCfgIndex ||
+            other_index < 0 ||
+            other_index >= static_cast<int64>(device_list.size())) {
+          continue;
+        }
+        const auto other_ids = device_list.at(other_index).getDriverIDs();
+        const bool overlap = absl::c_any_of(ids, [&](unsigned id) {
+          return absl::c_linear_search(other_ids, id);
+        });
+        if (overlap) {
+          return InvalidArgument(
+              "The devices selected for /device:IPU:%d (index %d) and "
+              "/device:IPU:%d (index %d) share IPUs. Select devices made of "
+              "disjoint IPUs for each TensorFlow device.",
+              ordinal_, *device_index, other, other_index);
+        }
+      }
       if (HasMultiReplicaDistributionOptions()) {
         ipu_.SetTarget(CreateMultiReplicaDistributionTarget(
             device.getTarget(), GetMultiReplicaProcessCount()));
@@ -1426,7 +2139,8 @@ Status PoplarExecutor::CreatePoplarTarget() {
         // Deduce the IPU target given the configuration.
         switch (current_config_.device_connection_type()) {
           case IpuDeviceConnectionType::ALWAYS:
-          case IpuDeviceConnectionType::ON_DEMAND: {
+          case IpuDeviceConnectionType::ON_DEMAND:
+          case IpuDeviceConnectionType::ASYNCHRONOUS: {
             CHECK(HasIpuHardware());
             // Get target from the available devices.
             auto device_list = GetDeviceManager().getDevices(
@@ -1492,6 +2206,9 @@ Status PoplarExecutor::CreatePoplarTarget() {
 }
 
 Status PoplarExecutor::ConfigurePoplarDevice(const IpuOptions& cfg) {
+  // Let a background attach from a previous configuration finish first.
+  WaitForAsynchronousAttach().IgnoreError();
+
   bool has_user_config = (current_config_.device_config_size() > 0);
   if (!DeviceConfigurationsEqual(cfg, current_config_) && has_user_config) {
     XLA_VLOG_LINES(1, "Current config: " + current_config_.DebugString() +
@@ -1515,10 +2232,29 @@ Status PoplarExecutor::ConfigurePoplarDevice(const IpuOptions& cfg) {
   current_config_ = cfg;
   configured_ = true;
 
+  FeedAutotunerOptions autotuner_options;
+  const auto& autotuning = cfg.feed_autotuning_options();
+  if (autotuning.executions_per_trial() > 0) {
+    autotuner_options.executions_per_trial = autotuning.executions_per_trial();
+  }
+  if (autotuning.stall_threshold() > 0.0) {
+    autotuner_options.stall_threshold = autotuning.stall_threshold();
+  }
+  feed_autotuner_.SetOptions(autotuner_options);
+
+  if (HaveExecutableCache()) {
+    // Index (and optionally prefetch) the executable cache before anything is
+    // compiled.
+    ExecutableCache::Get();
+  }
+
   if (!device_attached_) {
     TF_RETURN_IF_ERROR(CreatePoplarTarget());
     if (cfg.device_connection_type() == IpuDeviceConnectionType::ALWAYS) {
       TF_RETURN_IF_ERROR(AttachToPoplarDevice());
+    } else if (cfg.device_connection_type() ==
+               IpuDeviceConnectionType::ASYNCHRONOUS) {
+      StartAsynchronousAttach();
     }
   }
 
@@ -1559,6 +2295,14 @@ Status PoplarExecutor::ConfigurePoplarDevice(const IpuOptions& cfg) {
     option_flags_.set("exchange.enablePrefetch", "true");
   }
 
+  if (PoplarXlaFlags::Get().use_ipu_model) {
+    option_flags_.set(
+        "debug.cpuMultiThreadExecution",
+        current_config_.ipu_model_config().single_threaded_execution()
+            ? "false"
+            : "true");
+  }
+
   for (const auto& opt : current_config_.compilation_options()) {
     option_flags_.set(opt.option(), opt.value());
   }
@@ -1712,12 +2456,20 @@ ModuleFilenames PoplarExecutor::GetModuleFilenames(
 
 bool PoplarExecutor::HaveCachedExecutable(
     const ModuleFilenames& filenames) const {
-  return tensorflow::Env::Default()
-      ->FileExists(filenames.CachedEngineFilename())
-      .ok();
+  // The executable is checked first so that it is fetched from the remote
+  // cache before the engine file which refers to it.
+  ExecutableCache& cache = ExecutableCache::Get();
+  return cache.Contains(filenames.CachedExecutableFilename()) &&
+         cache.Contains(filenames.CachedEngineFilename());
 }
 
 bool PoplarExecutor::SupportsRemoteBuffers() const {
+  {
+    std::lock_guard<std::mutex> l(async_attach_mu_);
+    if (async_attach_.valid()) {
+      return async_attach_supports_remote_buffers_;
+    }
+  }
   if (!PoplarDeviceIsAttached()) {
     return false;
   }
@@ -1728,6 +2480,20 @@ bool PoplarExecutor::SupportsRemoteBuffers() const {
   return ipu_.Device().supportsRemoteBuffers();
 }
 
+FeedWaitOptions PoplarExecutor::GetFeedWaitOptions() const {
+  const auto& io_options = current_config_.io_thread_options();
+  FeedWaitOptions options;
+  options.adaptive =
+      io_options.wait_strategy() == IpuIOThreadWaitStrategy::SPIN_YIELD_PARK;
+  if (io_options.spin_count() > 0) {
+    options.spin_count = io_options.spin_count();
+  }
+  if (io_options.yield_count() > 0) {
+    options.yield_count = io_options.yield_count();
+  }
+  return options;
+}
+
 tensorflow::IpuTraceEvent PoplarExecutor::NewTraceEvent() {
   uint64 now = tensorflow::Env::Default()->NowMicros();
   tensorflow::IpuTraceEvent evt;
@@ -1934,6 +2700,15 @@ void PoplarExecutor::AddExecuteEventRecord(const std::string& module_name,
   evt.set_type(tensorflow::IpuTraceEvent::EXECUTE);
   evt.mutable_execute()->set_module_name(std::move(module_name));
   evt.mutable_execute()->set_execution_report(std::move(rep));
+  evt.mutable_execute()->set_pipeline_cycle_counts(
+      std::move(pipeline_cycle_counts_));
+  pipeline_cycle_counts_.clear();
+  evt.mutable_execute()->set_instruction_cycle_counts(
+      std::move(instruction_cycle_counts_));
+  instruction_cycle_counts_.clear();
+  evt.mutable_execute()->set_feed_queue_stats(std::move(feed_queue_stats_));
+  feed_queue_stats_.clear();
+  evt.mutable_execute()->set_host_overhead_nanos(host_overhead_nanos_);
 
   reports_.push_back(evt);
 }
@@ -1946,135 +2721,176 @@ Status PoplarExecutor::GetCompilerEvents(
   return Status::OK();
 }
 
-void PoplarExecutor::FlattenedDeviceMemoryList(
-    InputPairList& list, const xla::Shape& shape, void* base,
-    const InputOutputAliasingMap::InputInfo& input_info,
-    bool is_remote_parameter, bool is_replica_partitioned) {
-  TensorControl* tc = static_cast<TensorControl*>(base);
+/* static */ void PoplarExecutor::FlattenedTensorBindings(
+    std::vector<TensorBinding>& list, const xla::Shape& shape,
+    const TensorBinding& parent) {
   if (shape.IsTuple()) {
-    void** ptrs = reinterpret_cast<void**>(tc->data);
-    for (unsigned int t = 0; t < xla::ShapeUtil::TupleElementCount(shape);
-         t++) {
-      void* ptr = ptrs[t];
-      FlattenedDeviceMemoryList(
-          list, xla::ShapeUtil::GetTupleElementShape(shape, t), ptr, input_info,
-          is_remote_parameter, is_replica_partitioned);
+    for (int64 t = 0; t < xla::ShapeUtil::TupleElementCount(shape); t++) {
+      TensorBinding element = parent;
+      element.tuple_path.push_back(t);
+      FlattenedTensorBindings(
+          list, xla::ShapeUtil::GetTupleElementShape(shape, t), element);
     }
   } else {
-    list.push_back(InputDef(tc, GetInputConversionFunction(shape),
-                            input_info.IsStreaming(), is_remote_parameter,
-                            is_replica_partitioned));
+    TensorBinding leaf = parent;
+    leaf.element_type = shape.element_type();
+    list.push_back(std::move(leaf));
   }
 }
 
-void PoplarExecutor::UpdateArgsHandleMap(
-    const Args& args, se::DeviceMemoryAllocator* allocator,
+/* static */ PoplarExecutor::TensorControl* PoplarExecutor::ResolveBinding(
+    void* base, const TensorBinding& binding) {
+  TensorControl* tc = static_cast<TensorControl*>(base);
+  for (int64 t : binding.tuple_path) {
+    tc = static_cast<TensorControl*>(reinterpret_cast<void**>(tc->data)[t]);
+  }
+  return tc;
+}
+
+/* static */ std::unique_ptr<PoplarExecutor::ExecutableBindings>
+PoplarExecutor::CreateExecutableBindings(
     const xla::poplarplugin::PoplarExecutable& executable) {
-  args_map_.clear();
+  auto bindings = absl::make_unique<ExecutableBindings>();
 
   const auto* comp = executable.module().entry_computation();
-  std::vector<xla::Shape> shapes(comp->num_parameters());
-  for (const auto& inst : comp->parameter_instructions()) {
-    shapes[inst->parameter_number()] = inst->shape();
-  }
-
   const auto& inputs_info =
       executable.GetInputOutputAliasingMap().GetEntryInputInfos();
-  CHECK_EQ(inputs_info.size(), args.size());
-  CHECK_EQ(shapes.size(), args.size());
-
-  // We require all the resource arguments which are modified to be
-  // not-aliasing with each other.
-  absl::flat_hash_set<const TensorControl*> modified_resources;
-
-  for (unsigned int a = 0; a < inputs_info.size(); a++) {
+  CHECK_EQ(inputs_info.size(), comp->num_parameters());
+  for (int64 a = 0; a < comp->num_parameters(); a++) {
     const auto& input_info = inputs_info[a];
-    InputPairList bufs;
-    const bool is_remote_parameter =
+    TensorBinding parameter;
+    parameter.index = a;
+    parameter.streamed = input_info.IsStreaming();
+    parameter.remote_parameter =
         IsRemoteParameter(a, executable.GeRemoteParameterInfos());
-    const bool is_replica_partitioned =
+    parameter.replica_partitioned =
         IsReplicaPartitioned(a, executable.GeRemoteParameterInfos());
-    FlattenedDeviceMemoryList(bufs, shapes[a],
-                              const_cast<void*>(args[a].opaque()), input_info,
-                              is_remote_parameter, is_replica_partitioned);
-    for (unsigned i = 0; i < bufs.size(); i++) {
-      InputDef input = bufs[i];
-      auto input_handle = input_info.Handles().at(i);
-      if (input_info.IsResource() && !input_info.IsResourceNotModified()) {
-        if (modified_resources.contains(input.tc)) {
-          // We found an alias - we add a copy.
-          VLOG(1) << "Found an alias for input handle " << input_handle
-                  << ", duplicating the buffer.";
-          se::DeviceMemoryBase allocated =
-              allocator->Allocate(ordinal_, input.tc->size, false)
-                  .ConsumeValueOrDie()
-                  .Release();
-          TensorControl* tc =
-              reinterpret_cast<TensorControl*>(allocated.opaque());
-          std::memcpy(tc->data, input.tc->data, input.tc->size);
-          input = InputDef(tc, input.fn, input.streamed, input.remote_parameter,
-                           input.replica_partitioned);
-        }
-        modified_resources.insert(input.tc);
-      }
-
-      input.tc->element_type = shapes[a].element_type();
-      args_map_[input_handle] = input;
+    parameter.modified_resource =
+        input_info.IsResource() && !input_info.IsResourceNotModified();
+
+    std::vector<TensorBinding> leaves;
+    FlattenedTensorBindings(leaves, comp->parameter_instruction(a)->shape(),
+                            parameter);
+    for (unsigned i = 0; i < leaves.size(); i++) {
+      TensorBinding& leaf = leaves[i];
+      leaf.handle = input_info.Handles().at(i);
+      leaf.fn = GetInputConversionFunction(
+          ShapeUtil::MakeShape(leaf.element_type, {}));
+      bindings->inputs.push_back(std::move(leaf));
     }
   }
-}
 
-void PoplarExecutor::FlattenedOutputDeviceMemoryList(
-    OutputPairList& list, const xla::Shape& shape, void* base,
-    const InputOutputAliasingMap::OutputInfo& output_info) {
-  TensorControl* tc = static_cast<TensorControl*>(base);
-  if (shape.IsTuple()) {
-    void** ptrs = reinterpret_cast<void**>(tc->data);
-    for (unsigned int t = 0; t < xla::ShapeUtil::TupleElementCount(shape);
-         t++) {
-      void* ptr = ptrs[t];
-      FlattenedOutputDeviceMemoryList(
-          list, xla::ShapeUtil::GetTupleElementShape(shape, t), ptr,
-          output_info);
+  const xla::Shape& shape = executable.result_shape();
+  const auto& outputs_info =
+      executable.GetInputOutputAliasingMap().GetEntryOutputInfos();
+  const int64 num_outputs =
+      shape.IsTuple() ? ShapeUtil::TupleElementCount(shape) : 1;
+  CHECK_EQ(outputs_info.size(), num_outputs);
+  for (int64 a = 0; a < num_outputs; a++) {
+    TensorBinding output;
+    output.index = a;
+    output.streamed = outputs_info[a].IsStreaming();
+    if (shape.IsTuple()) {
+      output.tuple_path.push_back(a);
     }
-  } else {
-    list.push_back(OutputDef(tc, output_info.IsStreaming()));
+    FlattenedTensorBindings(
+        bindings->outputs,
+        shape.IsTuple() ? ShapeUtil::GetTupleElementShape(shape, a) : shape,
+        output);
   }
+  return bindings;
 }
 
-void PoplarExecutor::UpdateOutputsHandleMap(
+PoplarExecutor::ExecutableBindings* PoplarExecutor::GetExecutableBindings(
     const xla::poplarplugin::PoplarExecutable& executable,
-    const xla::Shape& shape, se::DeviceMemoryBase retbuf) {
-  outputs_map_.clear();
+    std::unique_ptr<ExecutableBindings>& uncached) {
+  // Executables without an engine are not executed on the device, so their
+  // bindings are not kept.
+  if (executable.Engine() == nullptr) {
+    uncached = CreateExecutableBindings(executable);
+    return uncached.get();
+  }
+  auto& bindings = executable_bindings_[executable.Engine()];
+  if (!bindings) {
+    bindings = CreateExecutableBindings(executable);
+  }
+  return bindings.get();
+}
 
-  // Get all output pointers and their shapes
-  std::vector<void*> outputs;
-  std::vector<xla::Shape> shapes;
+void PoplarExecutor::UpdateArgsHandleMap(
+    const Args& args, se::DeviceMemoryAllocator* allocator,
+    const xla::poplarplugin::PoplarExecutable& executable) {
+  std::unique_ptr<ExecutableBindings> uncached;
+  ExecutableBindings* bindings = GetExecutableBindings(executable, uncached);
+  CHECK_EQ(executable.module().entry_computation()->num_parameters(),
+           args.size());
+
+  std::vector<TensorControl*> inputs(bindings->inputs.size());
+  for (unsigned i = 0; i < inputs.size(); i++) {
+    const TensorBinding& binding = bindings->inputs[i];
+    inputs[i] =
+        ResolveBinding(const_cast<void*>(args[binding.index].opaque()), binding);
+    inputs[i]->element_type = binding.element_type;
+  }
+
+  // When the same tensors are passed to the executable again, the map built
+  // by its last execution is still valid.
+  if (bindings == args_map_bindings_ && bindings->reusable &&
+      inputs == bindings->last_inputs) {
+    return;
+  }
 
-  if (shape.IsTuple()) {
-    TensorControl* tc = static_cast<TensorControl*>(retbuf.opaque());
-    void** ptrs = reinterpret_cast<void**>(tc->data);
-    for (int64 i = 0; i < ShapeUtil::TupleElementCount(shape); i++) {
-      shapes.push_back(ShapeUtil::GetTupleElementShape(shape, i));
-      outputs.push_back(ptrs[i]);
+  args_map_.clear();
+
+  // We require all the resource arguments which are modified to be
+  // not-aliasing with each other.
+  absl::flat_hash_set<const TensorControl*> modified_resources;
+  bool duplicated = false;
+
+  for (unsigned i = 0; i < inputs.size(); i++) {
+    const TensorBinding& binding = bindings->inputs[i];
+    InputDef input(inputs[i], binding.fn, binding.streamed,
+                   binding.remote_parameter, binding.replica_partitioned);
+    if (binding.modified_resource) {
+      if (modified_resources.contains(input.tc)) {
+        // We found an alias - we add a copy.
+        VLOG(1) << "Found an alias for input handle " << binding.handle
+                << ", duplicating the buffer.";
+        se::DeviceMemoryBase allocated =
+            allocator->Allocate(ordinal_, input.tc->size, false)
+                .ConsumeValueOrDie()
+                .Release();
+        TensorControl* tc =
+            reinterpret_cast<TensorControl*>(allocated.opaque());
+        std::memcpy(tc->data, input.tc->data, input.tc->size);
+        input = InputDef(tc, input.fn, input.streamed, input.remote_parameter,
+                         input.replica_partitioned);
+        duplicated = true;
+      }
+      modified_resources.insert(input.tc);
     }
-  } else {
-    shapes.push_back(shape);
-    outputs.push_back(retbuf.opaque());
+
+    input.tc->element_type = binding.element_type;
+    args_map_[binding.handle] = input;
   }
 
-  // For all outputs
-  const auto& outputs_info =
-      executable.GetInputOutputAliasingMap().GetEntryOutputInfos();
-  CHECK_EQ(outputs_info.size(), shapes.size());
-  CHECK_EQ(outputs.size(), shapes.size());
-  for (unsigned int a = 0; a < outputs_info.size(); a++) {
-    const auto& output_info = outputs_info[a];
-    OutputPairList bufs;
-    FlattenedOutputDeviceMemoryList(bufs, shapes[a], outputs[a], output_info);
-    for (unsigned i = 0; i < bufs.size(); i++) {
-      outputs_map_[bufs[i].tc->output_handle] = bufs[i];
-    }
+  // A duplicated buffer has to be copied again for every execution.
+  bindings->last_inputs = std::move(inputs);
+  bindings->reusable = !duplicated;
+  args_map_bindings_ = uncached ? nullptr : bindings;
+}
+
+void PoplarExecutor::UpdateOutputsHandleMap(
+    const xla::poplarplugin::PoplarExecutable& executable,
+    se::DeviceMemoryBase retbuf) {
+  outputs_map_.clear();
+
+  std::unique_ptr<ExecutableBindings> uncached;
+  const ExecutableBindings* bindings =
+      GetExecutableBindings(executable, uncached);
+  for (const TensorBinding& binding : bindings->outputs) {
+    TensorControl* tc = ResolveBinding(retbuf.opaque(), binding);
+    outputs_map_[tc->output_handle] = OutputDef(tc, binding.streamed);
   }
 }
 
@@ -2129,7 +2945,7 @@ se::DeviceMemoryBase PoplarExecutor::RemapOutputAllocation::GetAllocation(
             .Release();
     TensorControl* tc = reinterpret_cast<TensorControl*>(allocated.opaque());
     if (orig->on_device) {
-      auto status = executor_->MoveDeviceToHost();
+      auto status = executor_->MoveTensorsDeviceToHost({orig});
       if (!status.ok()) {
         LOG(FATAL) << status.ToString();
       }
@@ -2161,6 +2977,8 @@ se::DeviceMemoryBase PoplarExecutor::BufferOutputAllocation::GetAllocation(
       LOG(FATAL) << "Could not find matching input resource tensor.";
     }
     TensorControl* tc = it->second.tc;
+    // The engine writes the update to the buffer of the input.
+    tc->OwnData(/*keep_data=*/true);
     tc->size = size;
     tc->element_type = shape.element_type();
     tc->on_device = output_info.IsStreaming() ? false : true;
@@ -2261,25 +3079,63 @@ se::DeviceMemoryBase PoplarExecutor::GetOutputBuffer(
   }
 }
 
-// Takes a tensor and returns a pointer to a buffer with the data in the right
-// format
-void* PoplarExecutor::PreProcessBuffer(InputDef& id) {
-  TensorControl* tc = id.tc;
-  void* buf(static_cast<void*>(tc->data));
+ParallelConverter& PoplarExecutor::GetVariableConverter() {
+  if (!variable_converter_) {
+    variable_converter_ = absl::make_unique<ParallelConverter>(
+        PoplarXlaFlags::Get().variable_conversion_threads);
+  }
+  return *variable_converter_;
+}
+
+void PoplarExecutor::StartInputConversions(bool streamed) {
+  ParallelConverter& converter = GetVariableConverter();
+  // A tensor can be passed as more than one input, but is converted once.
+  absl::flat_hash_set<TensorControl*> converting;
+  for (auto& arg : args_map_) {
+    const InputDef& id = arg.second;
+    if (id.streamed != streamed || id.fn == nullptr ||
+        !converting.insert(id.tc).second) {
+      continue;
+    }
+    TensorControl* tc = id.tc;
+    const int64 host_element_size =
+        ShapeUtil::ByteSizeOfPrimitiveType(tc->element_type);
+    tc->converted_data.resize(
+        HostSizeToDeviceSize(tc->size, tc->element_type));
+    converter.Convert(id.fn, tc->data, host_element_size,
+                      tc->converted_data.data(),
+                      HostSizeToDeviceSize(host_element_size, tc->element_type),
+                      tc->size / host_element_size);
+  }
+}
+
+void* PoplarExecutor::GetInputBuffer(const InputDef& id) {
   if (id.fn != nullptr) {
-    tc->converted_data = id.fn(buf, tc->size, 0);
-    buf = tc->converted_data.data();
+    return id.tc->converted_data.data();
   }
-  return buf;
+  return id.tc->data;
 }
 
-// Convers the data into the right host format
-void PoplarExecutor::PostProcessBuffer(TensorControl* tc) {
-  if (tc->output_convertor) {
-    void* buf(static_cast<void*>(tc->data));
-    std::vector<char> converted = tc->output_convertor(buf, 0, tc->size);
-    memcpy(buf, converted.data(), converted.size());
+void PoplarExecutor::PostProcessBuffers(
+    const std::vector<TensorControl*>& tcs) {
+  ParallelConverter& converter = GetVariableConverter();
+  // The device format data is at the start of the host buffer, so it is
+  // copied out before the buffer is overwritten by the conversion.
+  std::list<std::vector<char>> device_data;
+  for (TensorControl* tc : tcs) {
+    if (!tc->output_convertor) {
+      continue;
+    }
+    const int64 host_element_size =
+        ShapeUtil::ByteSizeOfPrimitiveType(tc->element_type);
+    device_data.emplace_back(
+        tc->data, tc->data + HostSizeToDeviceSize(tc->size, tc->element_type));
+    converter.Convert(tc->output_convertor, device_data.back().data(),
+                      HostSizeToDeviceSize(host_element_size, tc->element_type),
+                      tc->data, host_element_size,
+                      tc->size / host_element_size);
   }
+  converter.Wait();
 }
 
 StatusOr<bool> PoplarExecutor::CheckMoveDeviceToHostRequired(
@@ -2301,17 +3157,12 @@ StatusOr<bool> PoplarExecutor::CheckMoveDeviceToHostRequired(
   return do_device_to_host;
 }
 
-// Check if there is tensor/arg of current executable on device.
-StatusOr<bool> PoplarExecutor::CheckAnyArgOnDevice(const Args& args) {
-  for (auto& device_buffer : args) {
-    const TensorControl* tc =
-        reinterpret_cast<const TensorControl*>(device_buffer.opaque());
-
-    if (tc->on_device && !tc->output_handle.empty()) {
-      return true;
-    }
+Status PoplarExecutor::MoveArgsDeviceToHost() {
+  std::vector<TensorControl*> tcs;
+  for (const auto& arg : args_map_) {
+    tcs.push_back(arg.second.tc);
   }
-  return false;
+  return MoveTensorsDeviceToHost(tcs);
 }
 
 StatusOr<bool> PoplarExecutor::CheckMoveHostToDeviceRequired(
@@ -2346,8 +3197,11 @@ void PoplarExecutor::ConnectReplicatedDeviceToHost(
 
   for (int64 replica_id = 0; replica_id < current_replication_factor_;
        ++replica_id) {
-    auto callback = [dest, size, replica_id](void* ptr) {
+    const int ordinal = ordinal_;
+    auto callback = [dest, size, replica_id, ordinal, stream_name](void* ptr) {
       if (replica_id == 0) {
+        IpuActivityScope activity(ordinal, IpuActivityType::kStreamCallback,
+                                  stream_name);
         std::memcpy(dest, ptr, size);
       }
     };
@@ -2356,62 +3210,67 @@ void PoplarExecutor::ConnectReplicatedDeviceToHost(
   }
 }
 
-Status PoplarExecutor::MoveDeviceToHost() {
-  if (UseSyntheticData()) {
-    return Status::OK();
+void PoplarExecutor::ConnectDiscardedDeviceToHost(
+    const std::string& stream_name) {
+  for (int64 replica_id = 0; replica_id < current_replication_factor_;
+       ++replica_id) {
+    current_engine_->connectStreamToCallback(stream_name, replica_id,
+                                             [](void*) {});
   }
+}
 
+Status PoplarExecutor::CopyDeviceToHost(
+    const std::vector<TensorControl*>& tcs) {
   Json::Value root;
   root["tensors"] = Json::Value(Json::arrayValue);
   uint64 total_size = 0;
   uint64 total_count = 0;
   try {
-    for (const auto& tc : allocations_) {
+    absl::flat_hash_set<const TensorControl*> copying;
+    for (TensorControl* tc : tcs) {
+      copying.insert(tc);
       // Set up streams
-      if (tc->on_device == true && !tc->output_handle.empty()) {
-        if (tc->in_remote_memory) {
-          // We currently only get one copy of the buffer.
-          // Note that only resource variables are on device, hence they must
-          // have the input handle set too.
-          CHECK(tc->input_handle.size());
-          if (tc->replica_partitioned) {
-            const std::size_t size =
-                HostSizeToDeviceSize(tc->size, tc->element_type);
-            // Pad the per-replica length up.
-            const std::size_t length =
-                4 * tensorflow::MathUtil::CeilOfRatio<int64>(
-                        tensorflow::MathUtil::CeilOfRatio<int64>(size, 4),
-                        current_replication_factor_);
-            std::unique_ptr<char[]> buffer = absl::make_unique<char[]>(length);
-            // This is a remote parameter - copy it to the remote buffer for
-            // each replica.
-            for (int replica_id = 0; replica_id < current_replication_factor_;
-                 ++replica_id) {
-              const std::size_t offset = replica_id * length;
-              const std::size_t replica_length =
-                  std::min(length, size - offset);
+      if (tc->in_remote_memory) {
+        // We currently only get one copy of the buffer.
+        // Note that only resource variables are on device, hence they must
+        // have the input handle set too.
+        CHECK(tc->input_handle.size());
+        if (tc->replica_partitioned) {
+          const std::size_t size =
+              HostSizeToDeviceSize(tc->size, tc->element_type);
+          // Pad the per-replica length up.
+          const std::size_t length =
+              4 * tensorflow::MathUtil::CeilOfRatio<int64>(
+                      tensorflow::MathUtil::CeilOfRatio<int64>(size, 4),
+                      current_replication_factor_);
+          std::unique_ptr<char[]> buffer = absl::make_unique<char[]>(length);
+          // This is a remote parameter - copy it to the remote buffer for
+          // each replica.
+          for (int replica_id = 0; replica_id < current_replication_factor_;
+               ++replica_id) {
+            const std::size_t offset = replica_id * length;
+            const std::size_t replica_length = std::min(length, size - offset);
 
-              current_engine_->copyFromRemoteBuffer(
-                  tc->input_handle, buffer.get(), 0, replica_id);
+            current_engine_->copyFromRemoteBuffer(
+                tc->input_handle, buffer.get(), 0, replica_id);
 
-              std::memcpy(tc->data + offset, buffer.get(), replica_length);
-            }
-          } else {
-            const unsigned replica_id = 0;
-            current_engine_->copyFromRemoteBuffer(tc->input_handle, tc->data, 0,
-                                                  replica_id);
+            std::memcpy(tc->data + offset, buffer.get(), replica_length);
           }
         } else {
-          ConnectReplicatedDeviceToHost(tc->output_handle, tc);
+          const unsigned replica_id = 0;
+          current_engine_->copyFromRemoteBuffer(tc->input_handle, tc->data, 0,
+                                                replica_id);
         }
-
-        Json::Value tensor;
-        tensor["name"] = Json::Value(tc->output_handle);
-        tensor["size"] = Json::Value::UInt64(tc->size);
-        root["tensors"].append(tensor);
-        total_size += tc->size;
-        total_count++;
+      } else {
+        ConnectReplicatedDeviceToHost(tc->output_handle, tc);
       }
+
+      Json::Value tensor;
+      tensor["name"] = Json::Value(tc->output_handle);
+      tensor["size"] = Json::Value::UInt64(tc->size);
+      root["tensors"].append(tensor);
+      total_size += tc->size;
+      total_count++;
     }
     root["total_size"] = Json::Value::UInt64(total_size);
     Json::StreamWriterBuilder json_builder;
@@ -2419,7 +3278,20 @@ Status PoplarExecutor::MoveDeviceToHost() {
 
     // perform device -> host read
     if (total_count > 0) {
+      // The program transfers all the outputs of the engine, so the ones which
+      // are not wanted are dropped rather than written over the host buffers,
+      // which might have been changed since they were last read.
+      for (auto& output : outputs_map_) {
+        TensorControl* tc = output.second.tc;
+        if (!output.second.streamed && !tc->in_remote_memory &&
+            !copying.contains(tc)) {
+          ConnectDiscardedDeviceToHost(output.first);
+        }
+      }
+
       current_engine_->disableExecutionProfiling();
+      IpuActivityScope activity(ordinal_, IpuActivityType::kDeviceToHost,
+                                "device_to_host");
       current_engine_->run(PoplarProgramType::DEVICE_TO_HOST);
     }
 
@@ -2429,28 +3301,91 @@ Status PoplarExecutor::MoveDeviceToHost() {
     }
 
     // Post process upload
-    for (const auto& tc : allocations_) {
-      if (tc->on_device == true && !tc->output_handle.empty()) {
-        PostProcessBuffer(tc);
-      }
+    PostProcessBuffers(tcs);
+  } catch (const std::exception& e) {
+    return PoplarExceptionToTensorflowStatus("[Device to host] ", e);
+  }
+  return Status::OK();
+}
+
+Status PoplarExecutor::MoveDeviceToHost() {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
+    return Status::OK();
+  }
+
+  std::vector<TensorControl*> tcs;
+  for (const auto& tc : allocations_) {
+    if (tc->on_device == true && !tc->output_handle.empty()) {
+      tcs.push_back(tc);
+    }
+  }
+  TF_RETURN_IF_ERROR(CopyDeviceToHost(tcs));
+
+  for (const auto& tc : allocations_) {
+    tc->in_remote_memory = false;
+    tc->replica_partitioned = false;
+    tc->on_device = false;
+    tc->output_handle.clear();
+    tc->input_handle.clear();
+  }
+  return Status::OK();
+}
+
+Status PoplarExecutor::MoveTensorsDeviceToHost(
+    const std::vector<TensorControl*>& tcs) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
+    return Status::OK();
+  }
+
+  absl::flat_hash_set<const TensorControl*> requested;
+  std::vector<TensorControl*> copied;
+  for (TensorControl* tc : tcs) {
+    if (tc->on_device && !tc->output_handle.empty() &&
+        requested.insert(tc).second) {
+      copied.push_back(tc);
+    }
+  }
+  if (copied.empty()) {
+    return Status::OK();
+  }
+
+  // The outputs which are not variables are usually all read after an
+  // execution, so they are copied back with the requested ones to avoid
+  // running the device to host program for each of them.
+  for (const auto& tc : allocations_) {
+    if (tc->on_device && !tc->output_handle.empty() &&
+        tc->input_handle.empty() && !requested.contains(tc)) {
+      copied.push_back(tc);
+    }
+  }
+  TF_RETURN_IF_ERROR(CopyDeviceToHost(copied));
 
+  // The host buffers now match the device, so the tensors which are inputs of
+  // the engine stay on the device and do not need to be copied to it for the
+  // next execution.
+  for (TensorControl* tc : copied) {
+    tc->output_handle.clear();
+    if (tc->input_handle.empty()) {
       tc->in_remote_memory = false;
       tc->replica_partitioned = false;
       tc->on_device = false;
-      tc->output_handle.clear();
-      tc->input_handle.clear();
     }
-  } catch (const std::exception& e) {
-    return PoplarExceptionToTensorflowStatus("[Device to host] ", e);
   }
   return Status::OK();
 }
 
-Status PoplarExecutor::MoveHostToDevice() {
-  if (UseSyntheticData()) {
+Status PoplarExecutor::MoveHostToDevice(bool inputs_converted) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
     return Status::OK();
   }
   try {
+    // The inputs are converted at the same time, and have to be converted
+    // before any of them are copied.
+    if (!inputs_converted) {
+      StartInputConversions(false);
+    }
+    GetVariableConverter().Wait();
+
     Json::Value root;
     root["tensors"] = Json::Value(Json::arrayValue);
     uint64 total_size = 0;
@@ -2460,7 +3395,7 @@ Status PoplarExecutor::MoveHostToDevice() {
       std::vector<std::pair<std::string, int64>> stream_list;
       void* buf(static_cast<void*>(tc->data));
       if (!arg.second.streamed) {
-        buf = PreProcessBuffer(arg.second);
+        buf = GetInputBuffer(arg.second);
 
         if (arg.second.remote_parameter) {
           tc->in_remote_memory = true;
@@ -2525,7 +3460,11 @@ Status PoplarExecutor::MoveHostToDevice() {
     std::string json_msg = Json::writeString(json_builder, root);
 
     current_engine_->disableExecutionProfiling();
-    current_engine_->run(PoplarProgramType::HOST_TO_DEVICE);
+    {
+      IpuActivityScope activity(ordinal_, IpuActivityType::kHostToDevice,
+                                "host_to_device");
+      current_engine_->run(PoplarProgramType::HOST_TO_DEVICE);
+    }
 
     if (current_config_.profiling().enable_ipu_trace_events() &&
         current_config_.profiling().enable_io_trace()) {
@@ -2555,21 +3494,23 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::GetTupleBufferByIndex(
 
 void PoplarExecutor::ConnectStreamedVariablesHostToDevice() {
   // Don't connect any streams if using synthetic data
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
     return;
   }
 
+  StartInputConversions(true);
+  GetVariableConverter().Wait();
+
   for (auto arg : args_map_) {
     if (arg.second.streamed) {
-      void* buf = PreProcessBuffer(arg.second);
-      current_engine_->connectStream(arg.first, buf);
+      current_engine_->connectStream(arg.first, GetInputBuffer(arg.second));
     }
   }
 }
 
 void PoplarExecutor::ConnectStreamedVariablesDeviceToHost() {
   // Don't connect any streams if using synthetic data
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Parameters)) {
     return;
   }
 
@@ -2582,16 +3523,25 @@ void PoplarExecutor::ConnectStreamedVariablesDeviceToHost() {
 }
 
 void PoplarExecutor::PostProcessStreamedVariablesDeviceToHost() {
+  std::vector<TensorControl*> streamed;
   for (auto output : outputs_map_) {
     if (output.second.streamed) {
-      PostProcessBuffer(output.second.tc);
+      streamed.push_back(output.second.tc);
     }
   }
+  PostProcessBuffers(streamed);
 }
 
 void PoplarExecutor::AboutToFreeEngine(poplar::Engine* engine) {
+  std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
+  auto bindings = executable_bindings_.find(engine);
+  if (bindings != executable_bindings_.end()) {
+    if (args_map_bindings_ == bindings->second.get()) {
+      args_map_bindings_ = nullptr;
+    }
+    executable_bindings_.erase(bindings);
+  }
   if (current_engine_ != nullptr) {
-    std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
     if (engine == current_engine_) {
       auto status = MoveDeviceToHost();
       if (!status.ok()) {
@@ -2623,9 +3573,12 @@ void PoplarExecutor::CreateInfeedIterator(
                   "IPUInfeedQueue. The Poplar backend requires all infeeds in "
                   "the same TensorFlow device to have unique names.";
   } else {
+    const std::size_t queue_capacity = GetFeedQueueCapacity(config);
+    VLOG(1) << "Creating the queues of infeed '" << feed_id
+            << "' with a capacity of " << queue_capacity << " elements.";
     infeed_iterators_[feed_id] = absl::make_unique<InfeedIterator>(
         flr, params, dataset, GetInfeedAllocator(), config.replication_factor(),
-        shapes, feed_id);
+        shapes, feed_id, queue_capacity);
   }
 }
 
@@ -2648,6 +3601,148 @@ Status PoplarExecutor::DeleteInfeedIterator(const std::string& feed_id) {
   return Status::OK();
 }
 
+StatusOr<std::string> PoplarExecutor::GetInfeedStatistics(
+    const std::string& feed_id) {
+  std::lock_guard<std::recursive_mutex> l(ipu_.Mutex());
+
+  auto itr = infeed_iterators_.find(feed_id);
+  if (itr == infeed_iterators_.end()) {
+    return xla::NotFound(
+        "Infeed with id='%s'. Make sure that you have run the initializer "
+        "for this infeed before getting its statistics.",
+        feed_id.c_str());
+  }
+  return itr->second->GetStatistics().ToJson(GetInfeedQueueStats(feed_id));
+}
+
+StatusOr<std::string> PoplarExecutor::GetOutfeedStatistics(
+    const std::string& feed_id) {
+  std::lock_guard<std::recursive_mutex> l(ipu_.Mutex());
+
+  if (!outfeed_contexts_.contains(feed_id)) {
+    return xla::NotFound(
+        "Outfeed with id='%s'. Make sure that you have executed the graph "
+        "containing this outfeed before getting its statistics.",
+        feed_id.c_str());
+  }
+  return FeedQueueStatsToJson(GetOutfeedQueueStats(feed_id));
+}
+
+SPSCQueueStats PoplarExecutor::GetInfeedQueueStats(
+    const std::string& feed_id) {
+  SPSCQueueStats stats;
+  auto itr = infeed_iterators_.find(feed_id);
+  if (itr != infeed_iterators_.end()) {
+    for (auto& replica_queues : itr->second->GetInfeedQueues()) {
+      for (auto* queue : replica_queues) {
+        stats += queue->GetStats();
+      }
+    }
+  }
+  return stats;
+}
+
+SPSCQueueStats PoplarExecutor::GetOutfeedQueueStats(
+    const std::string& feed_id) {
+  SPSCQueueStats stats;
+  auto itr = outfeed_contexts_.find(feed_id);
+  if (itr != outfeed_contexts_.end()) {
+    for (auto& tensor_queues : itr->second->callback_to_io_thread_queues) {
+      for (auto& queue : tensor_queues) {
+        stats += queue->GetStats();
+      }
+    }
+  }
+  return stats;
+}
+
+namespace {
+// The counters accumulated between the `start` and `end` snapshots. The high
+// water mark can't be split, so it is the largest since the queues were
+// created.
+SPSCQueueStats StatsSince(const SPSCQueueStats& start,
+                          const SPSCQueueStats& end) {
+  SPSCQueueStats stats = end;
+  stats.push_count -= start.push_count;
+  stats.pop_count -= start.pop_count;
+  stats.push_blocked_nanos -= start.push_blocked_nanos;
+  stats.pop_blocked_nanos -= start.pop_blocked_nanos;
+  return stats;
+}
+}  // namespace
+
+std::string PoplarExecutor::SummariseFeedQueueStats(
+    const InfeedInfos& infeed_infos,
+    const std::vector<SPSCQueueStats>& infeed_start,
+    const OutfeedInfos& outfeed_infos,
+    const std::vector<SPSCQueueStats>& outfeed_start) {
+  auto feeds_to_json = [](const std::vector<FeedInfo>& infos,
+                          const std::vector<SPSCQueueStats>& start,
+                          std::function<SPSCQueueStats(const std::string&)>
+                              get_stats) {
+    std::string json = "{";
+    for (size_t i = 0; i != infos.size(); ++i) {
+      const std::string& feed_id = infos[i].config.feed_id();
+      absl::StrAppend(
+          &json, i ? "," : "", "\"", feed_id, "\":",
+          FeedQueueStatsToJson(StatsSince(start[i], get_stats(feed_id))));
+    }
+    return absl::StrCat(json, "}");
+  };
+  return absl::StrCat(
+      "{\"infeeds\":",
+      feeds_to_json(infeed_infos, infeed_start,
+                    [this](const std::string& feed_id) {
+                      return GetInfeedQueueStats(feed_id);
+                    }),
+      ",\"outfeeds\":",
+      feeds_to_json(outfeed_infos, outfeed_start,
+                    [this](const std::string& feed_id) {
+                      return GetOutfeedQueueStats(feed_id);
+                    }),
+      ",\"autotuning\":", feed_autotuner_.ToJson(), "}");
+}
+
+void PoplarExecutor::RecordFeedAutotuningObservations(
+    const InfeedInfos& infeed_infos,
+    const std::vector<SPSCQueueStats>& infeed_start,
+    const OutfeedInfos& outfeed_infos,
+    const std::vector<SPSCQueueStats>& outfeed_start, uint64 execution_nanos) {
+  for (size_t i = 0; i != infeed_infos.size(); ++i) {
+    const PoplarFeedConfig& config = infeed_infos[i].config;
+    auto itr = infeed_iterators_.find(config.feed_id());
+    if (!FeedAutotuner::IsTunedInfeed(config) ||
+        itr == infeed_iterators_.end()) {
+      continue;
+    }
+    int64 num_queues = 0;
+    for (auto& replica_queues : itr->second->GetInfeedQueues()) {
+      num_queues += replica_queues.size();
+    }
+    feed_autotuner_.RecordInfeedExecution(
+        config,
+        StatsSince(infeed_start[i], GetInfeedQueueStats(config.feed_id())),
+        num_queues, execution_nanos);
+  }
+
+  for (size_t i = 0; i != outfeed_infos.size(); ++i) {
+    const PoplarFeedConfig& config = outfeed_infos[i].config;
+    auto itr = outfeed_contexts_.find(config.feed_id());
+    if (!FeedAutotuner::IsTunedOutfeed(config) ||
+        itr == outfeed_contexts_.end()) {
+      continue;
+    }
+    int64 num_queues = 0;
+    for (auto& tensor_queues : itr->second->callback_to_io_thread_queues) {
+      num_queues += tensor_queues.size();
+    }
+    feed_autotuner_.RecordOutfeedExecution(
+        config,
+        StatsSince(outfeed_start[i], GetOutfeedQueueStats(config.feed_id())),
+        num_queues, execution_nanos);
+  }
+}
+
 InfeedAllocator* PoplarExecutor::GetInfeedAllocator() {
   return &infeed_allocator;
 }
@@ -2669,13 +3764,8 @@ PoplarExecutor::GetTensorsFromOutfeed(const std::string& feed_id,
   std::lock_guard<std::recursive_mutex> guard(outfeed_context->mutex);
 
   if (mode == xla::poplarplugin::PoplarFeedConfig::GetAll) {
-    std::vector<std::vector<tensorflow::Tensor>> output(
-        outfeed_context->io_thread_output_queues.size());
-    for (size_t i = 0; i < output.size(); ++i) {
-      output[i] = outfeed_context->io_thread_output_queues.back();
-      outfeed_context->io_thread_output_queues.pop_back();
-    }
-    return output;
+    // The tensors are already stacked - hand out views of the ring storage.
+    return {outfeed_context->tensor_ring->TakeAll()};
   } else {
     std::vector<std::vector<tensorflow::Tensor>> output(1);
     output[0] = outfeed_context->io_thread_output_queues.front();
@@ -2697,6 +3787,14 @@ Status PoplarExecutor::RegisterOutfeeds(const OutfeedInfos& outfeed_infos) {
             "device to have unique names.",
             outfeed_id.c_str());
       }
+      if (existing_feed->second->config.io_batch_size() !=
+          outfeed_info.config.io_batch_size()) {
+        VLOG(1) << "Outfeed with id='" << outfeed_id
+                << "' now has an io batch size of "
+                << outfeed_info.config.io_batch_size();
+        existing_feed->second->SetIoBatchSize(
+            outfeed_info.config.io_batch_size());
+      }
     } else {
       outfeed_contexts_[outfeed_id] =
           absl::make_unique<OutfeedContext>(outfeed_info);
@@ -2759,7 +3857,7 @@ tensorflow::Rendezvous* PoplarExecutor::GetRendezvous() {
 
 void PoplarExecutor::ConnectSeedCallback() {
   // Don't connect any streams if using synthetic data
-  if (UseSyntheticData()) {
+  if (UseSyntheticDataFor(SyntheticDataCategory::Seed)) {
     return;
   }
 
@@ -2781,6 +3879,81 @@ std::string PoplarExecutor::GetCycleCounterStream() {
   return "__cycle_count_stream";
 }
 
+std::string PoplarExecutor::GetPipelineCycleCounterStream() {
+  return "__pipeline_cycle_count_stream";
+}
+
+std::string PoplarExecutor::GetInstructionCycleCounterStream() {
+  return "__instruction_cycle_count_stream";
+}
+
+namespace {
+// The pipeline cycle counter stream contains the 64 bit cycle counts of the
+// ramp up, the repeat block and the ramp down as pairs of 32 bit words,
+// followed by the number of steps in the pipeline and in the repeat block.
+std::string PipelineCycleCountsToJson(const void* p) {
+  uint32_t words[8];
+  std::memcpy(words, p, sizeof(words));
+  uint64_t cycles[3];
+  for (int i = 0; i != 3; ++i) {
+    cycles[i] = words[2 * i] | (static_cast<uint64_t>(words[2 * i + 1]) << 32);
+  }
+  const uint64_t steps = words[6];
+  const uint64_t repeat_block_steps = words[7];
+  const uint64_t total = cycles[0] + cycles[1] + cycles[2];
+
+  std::string json = absl::StrCat(
+      "{\"ramp_up\":", cycles[0], ",\"repeat_block\":", cycles[1],
+      ",\"ramp_down\":", cycles[2], ",\"steps\":", steps,
+      ",\"repeat_block_steps\":", repeat_block_steps);
+  // The time a step takes once the pipeline is full, compared to the time all
+  // the steps took.
+  if (repeat_block_steps > 0 && total > 0) {
+    const double cycles_per_step =
+        static_cast<double>(cycles[1]) / repeat_block_steps;
+    const double bubble_fraction =
+        std::max(0.0, 1.0 - steps * cycles_per_step / total);
+    absl::StrAppend(&json, ",\"bubble_fraction\":", bubble_fraction);
+  }
+  absl::StrAppend(&json, "}");
+  return json;
+}
+
+// The instruction cycle counter stream contains the 64 bit total cycles of each
+// instruction as pairs of 32 bit words, in the order of `names`.
+std::string InstructionCycleCountsToJson(const void* p,
+                                         const std::vector<std::string>& names,
+                                         int64 num_logged) {
+  std::vector<std::pair<uint64_t, const std::string*>> cycles(names.size());
+  std::string json = "{";
+  for (size_t i = 0; i != names.size(); ++i) {
+    uint32_t words[2];
+    std::memcpy(words, static_cast<const uint32_t*>(p) + 2 * i, sizeof(words));
+    cycles[i] = {words[0] | (static_cast<uint64_t>(words[1]) << 32),
+                 &names[i]};
+    absl::StrAppend(&json, i ? "," : "", "\"", names[i],
+                    "\":", cycles[i].first);
+  }
+  absl::StrAppend(&json, "}");
+
+  // Log the instructions which took the most cycles.
+  std::sort(cycles.begin(), cycles.end(),
+            [](const std::pair<uint64_t, const std::string*>& a,
+               const std::pair<uint64_t, const std::string*>& b) {
+              return a.first > b.first;
+            });
+  cycles.resize(std::min<size_t>(cycles.size(), num_logged));
+  LOG(INFO) << "Instructions with the most cycles: "
+            << absl::StrJoin(
+                   cycles, ", ",
+                   [](std::string* out,
+                      const std::pair<uint64_t, const std::string*>& c) {
+                     absl::StrAppend(out, *c.second, " ", c.first);
+                   });
+  return json;
+}
+}  // namespace
+
 void PoplarExecutor::ConnectCycleCounterCallback() {
   if (has_cycle_counter_) {
     for (int i = 0; i < current_replication_factor_; i++) {
@@ -2795,6 +3968,31 @@ void PoplarExecutor::ConnectCycleCounterCallback() {
           });
     }
   }
+  if (has_pipeline_cycle_counter_) {
+    for (int i = 0; i < current_replication_factor_; i++) {
+      current_engine_->connectStreamToCallback(
+          PoplarExecutor::GetPipelineCycleCounterStream(), i, [=](void* p) {
+            // Just log the cycle counts for replica 0
+            if (i == 0) {
+              pipeline_cycle_counts_ = PipelineCycleCountsToJson(p);
+              LOG(INFO) << "Pipeline cycle counts: " << pipeline_cycle_counts_;
+            }
+          });
+    }
+  }
+  if (!instruction_cycle_counter_names_.empty()) {
+    for (int i = 0; i < current_replication_factor_; i++) {
+      current_engine_->connectStreamToCallback(
+          PoplarExecutor::GetInstructionCycleCounterStream(), i,
+          [=](void* p) {
+            // Just log the cycle counts for replica 0
+            if (i == 0) {
+              instruction_cycle_counts_ = InstructionCycleCountsToJson(
+                  p, instruction_cycle_counter_names_, 10);
+            }
+          });
+    }
+  }
 }
 
 namespace {
@@ -2884,6 +4082,7 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
     xla::poplarplugin::PoplarExecutable& executable,
     se::DeviceMemoryAllocator* allocator, const Args& args) {
   std::lock_guard<std::recursive_mutex> g(ipu_.Mutex());
+  const auto execute_start = std::chrono::steady_clock::now();
   const auto& input_output_aliasing_map =
       executable.GetInputOutputAliasingMap();
   const auto& output_shape = executable.result_shape();
@@ -2919,16 +4118,17 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
                           ConstantOutputAllocation(executable.LiteralValue()),
                           output_shape, args, input_output_aliasing_map);
     } else if (executable.IsRemapGraph()) {
+      // The arguments are copied back from the device together, rather than
+      // one at a time as the outputs are read.
+      TF_RETURN_IF_ERROR(MoveArgsDeviceToHost());
+
       RemapOutputAllocation remap(this, executable.RemapMap(),
                                   input_output_aliasing_map);
       retbuf = GetOutputBuffer(executable, allocator, remap, output_shape, args,
                                input_output_aliasing_map);
     } else if (executable.IsScalarElementwiseGraph()) {
       // If some arg are on device, move them to host.
-      TF_ASSIGN_OR_RETURN(bool any_arg_on_device, CheckAnyArgOnDevice(args));
-      if (any_arg_on_device) {
-        TF_RETURN_IF_ERROR(MoveDeviceToHost());
-      }
+      TF_RETURN_IF_ERROR(MoveArgsDeviceToHost());
 
       std::vector<std::vector<Literal>> literal_evaluate_break_down;
       LiteralEvaluateForScalarElementwiseGraph(executable, args,
@@ -2955,9 +4155,25 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
       TF_RETURN_IF_ERROR(MoveDeviceToHost());
     }
 
+    // When the engine changes all the variables are moved to the device, so
+    // their conversions can overlap the loading of the engine.
+    const bool inputs_converted =
+        engine_changed &&
+        !UseSyntheticDataFor(SyntheticDataCategory::Parameters);
+    if (inputs_converted) {
+      StartInputConversions(false);
+    }
+    // The conversions have to finish before returning, even on an error.
+    auto wait_for_conversions = tensorflow::gtl::MakeCleanup(
+        [this]() { GetVariableConverter().Wait(); });
+
     if (engine_changed) {
       try {
-        engine->load(ipu_.Device());
+        {
+          IpuActivityScope activity(ordinal_, IpuActivityType::kLoadEngine,
+                                    executable.module().name());
+          engine->load(ipu_.Device());
+        }
 
         current_engine_ = engine;
         SetCurrentReplicationFactor(executable.GetReplicationFactor());
@@ -2970,6 +4186,24 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
           AddLoadEngineEventRecord(executable.module().name());
         }
 
+        // Only one engine is loaded onto the device at a time, so each switch
+        // between executables loads the engine and copies all the variables
+        // to the device again.
+        const int64 load_count =
+            ++engine_load_counts_[executable.module().name()];
+        VLOG(1) << "Loaded the engine of " << executable.module().name()
+                << " onto the device " << load_count << " time(s).";
+        if (load_count == kEngineReloadWarningCount) {
+          LOG(WARNING)
+              << "The executable " << executable.module().name()
+              << " has been loaded onto the IPU " << load_count
+              << " times. Only one executable is resident on an IPU at a "
+                 "time, so alternating between executables loads them and "
+                 "copies their variables to the device on every switch. Place "
+                 "the executables on different IPUs, or combine them into one "
+                 "executable, to avoid this.";
+        }
+
         executable.OnEngineLoaded();
       } catch (const std::exception& e) {
         return PoplarExceptionToTensorflowStatus("[Load engine] ", e);
@@ -2982,7 +4216,7 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
     TF_ASSIGN_OR_RETURN(const bool move_host_to_device,
                         CheckMoveHostToDeviceRequired(engine_changed));
     if (move_host_to_device) {
-      TF_RETURN_IF_ERROR(MoveHostToDevice());
+      TF_RETURN_IF_ERROR(MoveHostToDevice(inputs_converted));
     }
 
     // Outfeeds add empty tuples as output shape, no need to get an output
@@ -2993,7 +4227,7 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
       retbuf = GetOutputBuffer(executable, allocator, BufferOutputAllocation(),
                                output_shape, args, input_output_aliasing_map);
 
-      UpdateOutputsHandleMap(executable, output_shape, retbuf);
+      UpdateOutputsHandleMap(executable, retbuf);
     }
 
     VLOG(1) << "Executing on poplar stream ordinal " << ordinal_ << " of type "
@@ -3064,11 +4298,15 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
             ConnectRecvCallbacksToRendezvous(executable.GetRecvInfos()));
       }
 
-      const auto& infeed_infos = executable.GetInfeedInfos();
+      // Only the feeds which do not use synthetic data are connected to the
+      // host.
+      const InfeedInfos infeed_infos = FeedsUsingTheHost(
+          executable.GetInfeedInfos(), SyntheticDataCategory::Infeed);
       if (!infeed_infos.empty()) {
         ConnectInfeedsToStreamCallback(infeed_infos);
       }
 
+      host_embedding_caches_.clear();
       for (auto& host_embedding_lookup_info :
            executable.GetHostEmbeddingLookupInfos()) {
         TF_RETURN_IF_ERROR(ConnectHostEmbeddingLookup(
@@ -3093,7 +4331,8 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
                 .get()));
       }
 
-      const auto& outfeed_infos = executable.GetOutfeedInfos();
+      const OutfeedInfos outfeed_infos = FeedsUsingTheHost(
+          executable.GetOutfeedInfos(), SyntheticDataCategory::Outfeed);
       if (!outfeed_infos.empty()) {
         ConnectOutfeedToStreamCallback(outfeed_infos);
       }
@@ -3161,8 +4400,22 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
         }
       }
 
-      // Launch the IO threads when we are not using synthetic data.
-      if (!UseSyntheticData()) {
+      // Launch the IO threads of the feeds which are not using synthetic
+      // data.
+      std::vector<SPSCQueueStats> infeed_queue_stats;
+      std::vector<SPSCQueueStats> outfeed_queue_stats;
+      const bool use_io_threads = !UseSyntheticData() ||
+                                  !infeed_infos.empty() ||
+                                  !outfeed_infos.empty();
+      if (use_io_threads) {
+        for (const auto& infeed_info : infeed_infos) {
+          infeed_queue_stats.push_back(
+              GetInfeedQueueStats(infeed_info.config.feed_id()));
+        }
+        for (const auto& outfeed_info : outfeed_infos) {
+          outfeed_queue_stats.push_back(
+              GetOutfeedQueueStats(outfeed_info.config.feed_id()));
+        }
         LaunchIOThreads(infeed_infos, outfeed_infos);
       }
 
@@ -3172,11 +4425,33 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
 
       // Run the main engine
       current_engine_->enableExecutionProfiling();
-      current_engine_->run(PoplarProgramType::MAIN_SEQUENCE);
+      const auto run_start = std::chrono::steady_clock::now();
+      {
+        IpuActivityScope activity(ordinal_, IpuActivityType::kExecute,
+                                  executable.module().name());
+        current_engine_->run(PoplarProgramType::MAIN_SEQUENCE);
+      }
+      const uint64 execution_nanos =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - run_start)
+              .count();
 
-      // Stop the IO threads when we are not using synthetic data.
-      if (!UseSyntheticData()) {
+      // Stop the IO threads of the feeds which are not using synthetic data.
+      if (use_io_threads) {
         StopIOThreads();
+        RecordFeedAutotuningObservations(infeed_infos, infeed_queue_stats,
+                                         outfeed_infos, outfeed_queue_stats,
+                                         execution_nanos);
+        feed_queue_stats_ =
+            SummariseFeedQueueStats(infeed_infos, infeed_queue_stats,
+                                    outfeed_infos, outfeed_queue_stats);
+        VLOG(1) << "Feed queue statistics: " << feed_queue_stats_;
+
+        if (infeed_infos.size() &&
+            current_config_.profiling().enable_ipu_trace_events() &&
+            current_config_.profiling().enable_io_trace()) {
+          AddHostToDeviceEventRecord(GetInfeedAllocator()->StatsAsJson());
+        }
       }
 
       for (auto& host_embedding_lookup_info :
@@ -3206,6 +4481,15 @@ StatusOr<se::DeviceMemoryBase> PoplarExecutor::ExecuteEngine(
       // We need to call post process to make sure all the data is in the
       // right format on the host
       PostProcessStreamedVariablesDeviceToHost();
+
+      host_overhead_nanos_ =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - execute_start)
+              .count() -
+          execution_nanos;
+      VLOG(2) << "Host overhead of the execution of "
+              << executable.module().name() << ": " << host_overhead_nanos_
+              << "ns";
     } catch (const std::exception& e) {
       return PoplarExceptionToTensorflowStatus("[Execute engine] ", e);
     }
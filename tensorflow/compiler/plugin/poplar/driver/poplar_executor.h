@@ -20,6 +20,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_POPLAR_EXECUTOR_H_
 
 #include <condition_variable>
+#include <future>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -31,15 +32,23 @@ limitations under the License.
 #include <poplar/exceptions.hpp>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_annotations.h"
 #include "tensorflow/compiler/plugin/poplar/driver/config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_feed_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_transfer_manager.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_autotuner.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_waiter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/host_embedding_cache.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_allocator.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_iterator.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/input_output_aliasing_map.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/io_thread.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_file_sink.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_tensor_ring.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_conversion.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_copy.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/seed_generator.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_outfeed_queue.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_queue.h"
@@ -49,6 +58,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
@@ -94,7 +104,7 @@ using Args = tensorflow::gtl::ArraySlice<se::DeviceMemoryBase>;
 
 using ConversionList = std::vector<ConversionFn>;
 
-using OutfeedQueueType = SPSCOutfeedQueue<2048>;
+using OutfeedQueueType = SPSCOutfeedQueue<kDynamicCapacity>;
 
 class ModuleFilenames {
  public:
@@ -182,6 +192,13 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
                                          const se::DeviceMemoryBase&,
                                          uint64 size) override;
 
+  // Makes `pop_dst` a view of the host buffer `host_src` rather than a copy of
+  // it, so that the engine streams it from there when it is an input. The
+  // host buffer must stay alive until `release` is called, and is never
+  // written to: it is copied to a buffer of the executor first.
+  Status BorrowHostBuffer(se::DeviceMemoryBase* pop_dst, const void* host_src,
+                          uint64 size, std::function<void()> release);
+
   bool HostCallback(se::Stream* stream,
                     std::function<void()> callback) override;
   bool HostCallback(se::Stream* stream,
@@ -273,6 +290,10 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   Status ConfigurePoplarDevice(const IpuOptions&);
   Status AttachToPoplarDevice();
 
+  // Waits for the attach started by the `ASYNCHRONOUS` connection type, if
+  // there is one, and returns its status.
+  Status WaitForAsynchronousAttach();
+
   bool PoplarDeviceIsAttached() const;
   bool HasPoplarTarget() const;
 
@@ -421,8 +442,8 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   poplar::OptionFlags GclOptions() const { return gcl_options_; }
 
-  bool EnableExperimentalRemoteBufferEmbedding() const {
-    return current_config_.enable_experimental_remote_buffer_embedding();
+  bool EnableRemoteBufferEmbedding() const {
+    return current_config_.enable_remote_buffer_embedding();
   }
 
   int64 GetMaxAllReduceBufferSize() const {
@@ -433,6 +454,14 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
     return current_config_.max_reduce_scatter_buffer_size();
   }
 
+  int64 GetAllReduceBucketSize() const {
+    return current_config_.cross_replica_sum_bucket_size();
+  }
+
+  int64 GetReduceScatterBucketSize() const {
+    return current_config_.reduce_scatter_bucket_size();
+  }
+
   int64 GetMaxInterIpuCopyBufferSize() const {
     return current_config_.max_inter_ipu_copies_buffer_size();
   }
@@ -454,6 +483,22 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
     return current_config_.minimum_remote_tensor_size();
   }
 
+  int64 GetRemoteParameterPrefetchSize() const {
+    return current_config_.remote_parameter_prefetch_size();
+  }
+
+  bool OverlapInterIpuCopies() const {
+    return current_config_.overlap_inter_ipu_copies();
+  }
+
+  int64 GetMaxCombinedConvolutionsSize() const {
+    return current_config_.max_combined_convolutions_size();
+  }
+
+  bool OverlapHostCompute() const {
+    return current_config_.overlap_host_compute();
+  }
+
   int64 GetTriangularSolveExpanderBlockSize() const {
     // 128 is XLA default block size used in TriangularSolveExpander
     auto block_size = current_config_.triangular_solve_expander_block_size();
@@ -462,10 +507,25 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   bool EnableFastMath() const { return current_config_.enable_fast_math(); }
 
+  const IpuOptions::HostEmbeddingCacheOptions& HostEmbeddingCacheOptions()
+      const {
+    return current_config_.host_embedding_cache_options();
+  }
+
+  bool DoubleBufferRepeatLoopFeeds() const {
+    return current_config_.double_buffer_repeat_loop_feeds();
+  }
+
   IpuSelectionOrder GetSelectionOrder() const {
     return current_config_.selection_order();
   }
 
+  FeedWaitOptions GetFeedWaitOptions() const;
+
+  // The tuned values of the autotuned infeeds and outfeeds, which are applied
+  // to the modules by the compiler.
+  const FeedAutotuner& GetFeedAutotuner() const { return feed_autotuner_; }
+
   void AddCompileBeginEventRecord(const std::string& module_name);
 
   void AddCompileEndEventRecord(const std::string& module_name,
@@ -489,6 +549,29 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   void AddExecuteEventRecord(const std::string& module_name,
                              const std::string& report);
 
+  // The counters of all the queues of a feed, summed over the tensors and the
+  // replicas.
+  SPSCQueueStats GetInfeedQueueStats(const std::string& feed_id);
+  SPSCQueueStats GetOutfeedQueueStats(const std::string& feed_id);
+
+  // Returns a JSON summary of how the queue counters of the feeds changed
+  // since the `infeed_start` and `outfeed_start` snapshots were taken.
+  std::string SummariseFeedQueueStats(
+      const InfeedInfos& infeed_infos,
+      const std::vector<SPSCQueueStats>& infeed_start,
+      const OutfeedInfos& outfeed_infos,
+      const std::vector<SPSCQueueStats>& outfeed_start);
+
+  // Passes the stalls of the autotuned feeds during an execution, since the
+  // `infeed_start` and `outfeed_start` snapshots were taken, to the
+  // autotuner.
+  void RecordFeedAutotuningObservations(
+      const InfeedInfos& infeed_infos,
+      const std::vector<SPSCQueueStats>& infeed_start,
+      const OutfeedInfos& outfeed_infos,
+      const std::vector<SPSCQueueStats>& outfeed_start,
+      uint64 execution_nanos);
+
   Status GetCompilerEvents(std::list<tensorflow::IpuTraceEvent>& out);
 
   StatusOr<se::DeviceMemoryBase> ExecuteEngine(
@@ -522,10 +605,19 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   Status DeleteInfeedIterator(const std::string& feed_id);
 
+  // Returns the statistics of each stage of the infeed as a JSON string.
+  StatusOr<std::string> GetInfeedStatistics(const std::string& feed_id);
+
+  // Returns the counters of the queues of the outfeed as a JSON string.
+  StatusOr<std::string> GetOutfeedStatistics(const std::string& feed_id);
+
   InfeedAllocator* GetInfeedAllocator();
 
   // Lock the outfeed queue and dequeue all the tensors from a given feed.
   // Fails if the outfeed with the given name does not exist.
+  // In the GetAll mode a single vector is returned, with a tensor per tuple
+  // element which has an extra outer dimension for the number of elements.
+  // These tensors alias storage which is reused by the outfeed once released.
   std::vector<std::vector<tensorflow::Tensor>> GetTensorsFromOutfeed(
       const std::string& feed_id, const PoplarFeedConfig_Mode& mode);
 
@@ -583,6 +675,16 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   void SetHasCycleCounter() { has_cycle_counter_ = true; }
   static std::string GetCycleCounterStream();
 
+  void SetHasPipelineCycleCounter() { has_pipeline_cycle_counter_ = true; }
+  static std::string GetPipelineCycleCounterStream();
+
+  // Set the names of the instructions whose cycles are streamed to the host,
+  // in the order of their counters in the stream.
+  void SetInstructionCycleCounterNames(std::vector<std::string> names) {
+    instruction_cycle_counter_names_ = std::move(names);
+  }
+  static std::string GetInstructionCycleCounterStream();
+
   void SetCurrentReplicationFactor(int64 executable_replication_factor);
 
  private:
@@ -606,10 +708,17 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
     ConversionFn output_convertor;
     std::vector<char> converted_data;
     char* data;
+    // Set if `data` is borrowed from the host rather than allocated, in which
+    // case it releases the host buffer.
+    std::function<void()> release_borrowed_data;
 
     TensorControl(size_t size_);
     ~TensorControl();
 
+    // Replaces borrowed data with a buffer of its own before it is written to,
+    // copying the data into it if `keep_data` is true.
+    void OwnData(bool keep_data);
+
     TF_DISALLOW_COPY_AND_ASSIGN(TensorControl);
   };
 
@@ -651,21 +760,54 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   using OutputPairList = std::vector<OutputDef>;
   using OutputsHandleMap = std::map<std::string, OutputDef>;
 
-  static void FlattenedDeviceMemoryList(
-      InputPairList&, const xla::Shape&, void*,
-      const InputOutputAliasingMap::InputInfo&, bool is_remote_parameter,
-      bool is_replica_partitioned);
+  // Where a leaf buffer of an argument or of the result of an executable is
+  // found, and how it is transferred. These only depend on the executable, so
+  // they are computed once for each engine rather than on every execution.
+  struct TensorBinding {
+    // The parameter number or the index of the output.
+    int64 index = 0;
+    // The tuple indices of the leaf inside the parameter or the result.
+    std::vector<int64> tuple_path;
+    // The stream handle of an input.
+    std::string handle;
+    ConversionFn fn = nullptr;
+    PrimitiveType element_type = PRIMITIVE_TYPE_INVALID;
+    bool streamed = false;
+    bool remote_parameter = false;
+    bool replica_partitioned = false;
+    bool modified_resource = false;
+  };
+
+  struct ExecutableBindings {
+    std::vector<TensorBinding> inputs;
+    std::vector<TensorBinding> outputs;
+    // The input buffers of the last execution, and whether the args_map_ built
+    // for them can be used again when the same buffers are passed.
+    std::vector<TensorControl*> last_inputs;
+    bool reusable = false;
+  };
+
+  static void FlattenedTensorBindings(std::vector<TensorBinding>&,
+                                      const xla::Shape&,
+                                      const TensorBinding& parent);
 
-  static void FlattenedOutputDeviceMemoryList(
-      OutputPairList&, const xla::Shape&, void*,
-      const InputOutputAliasingMap::OutputInfo&);
+  static TensorControl* ResolveBinding(void* base, const TensorBinding&);
+
+  static std::unique_ptr<ExecutableBindings> CreateExecutableBindings(
+      const xla::poplarplugin::PoplarExecutable&);
+
+  // Returns the cached bindings of the executable. The bindings of an
+  // executable without an engine are returned in `uncached`.
+  ExecutableBindings* GetExecutableBindings(
+      const xla::poplarplugin::PoplarExecutable&,
+      std::unique_ptr<ExecutableBindings>& uncached);
 
   void UpdateArgsHandleMap(const Args&, se::DeviceMemoryAllocator*,
                            const xla::poplarplugin::PoplarExecutable&);
 
   void UpdateOutputsHandleMap(
       const xla::poplarplugin::PoplarExecutable& executable,
-      const xla::Shape& shape, se::DeviceMemoryBase retbuf);
+      se::DeviceMemoryBase retbuf);
 
   // These classes are used to pass around information for specific output
   // allocation type
@@ -742,9 +884,6 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   StatusOr<bool> CheckMoveDeviceToHostRequired(const bool engine_changed);
   StatusOr<bool> CheckMoveHostToDeviceRequired(const bool engine_changed);
 
-  // Check if there is tensor/arg of current executable on device.
-  StatusOr<bool> CheckAnyArgOnDevice(const Args& args);
-
   // Create a new trace event object
   tensorflow::IpuTraceEvent NewTraceEvent();
 
@@ -753,9 +892,24 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   void ConnectReplicatedDeviceToHost(const std::string& stream_name,
                                      TensorControl* tc);
 
+  // Connects a device to host stream to a callback which drops the data.
+  void ConnectDiscardedDeviceToHost(const std::string& stream_name);
+
+  // Copies the data of the tensors back from the device, without changing
+  // where they are held.
+  Status CopyDeviceToHost(const std::vector<TensorControl*>& tcs);
+
   // Functions which move the resource variables to/from the device
   Status MoveDeviceToHost();
-  Status MoveHostToDevice();
+  // Copies the tensors which have a newer value on the device back to the
+  // host, together with the outputs which are not inputs of the engine. The
+  // other variables stay on the device.
+  Status MoveTensorsDeviceToHost(const std::vector<TensorControl*>& tcs);
+  // Copies the arguments of the current executable back to the host.
+  Status MoveArgsDeviceToHost();
+  // When `inputs_converted` is set the conversions of the inputs were already
+  // started by StartInputConversions.
+  Status MoveHostToDevice(bool inputs_converted);
 
   // Functions which connect the streams to/from device
   void ConnectStreamedVariablesHostToDevice();
@@ -764,11 +918,17 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   // Sometimes post process streamed data into the right host format
   void PostProcessStreamedVariablesDeviceToHost();
 
-  // Takes a tensor and returns a pointer to a buffer with the data in the right
-  // format
-  static void* PreProcessBuffer(InputDef& id);
-  // Convers the data into the right host format
-  static void PostProcessBuffer(TensorControl* tc);
+  // Starts converting the streamed or the non-streamed inputs into the device
+  // format, without waiting for the conversions to finish.
+  void StartInputConversions(bool streamed);
+  // Returns a pointer to the buffer with the input data in the device format,
+  // once its conversion has finished.
+  static void* GetInputBuffer(const InputDef& id);
+  // Converts the data of the tensors into the right host format
+  void PostProcessBuffers(const std::vector<TensorControl*>& tcs);
+
+  // The converter which is shared by all the variable transfers.
+  ParallelConverter& GetVariableConverter();
 
   // Connect stream callbacks from Send/Recv operations in the engine
   // to the corresponding host graph operations using the rendezvous mechanism.
@@ -778,9 +938,18 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   Status ConnectHostEmbeddingLookup(
       const HostEmbeddingInfo& lookup_info,
       HostEmbeddingInterface_* embedding_interface);
+  Status ConnectCachedHostEmbeddingLookup(
+      const HostEmbeddingInfo& lookup_info,
+      const tensorflow::TensorShape& indices_shape,
+      HostEmbeddingInterface_* embedding_interface);
   Status ConnectHostEmbeddingUpdateToRendezvous(
       const HostEmbeddingInfo& update_info,
       HostEmbeddingInterface_* embedding_interface);
+  Status ConnectDeduplicatedHostEmbeddingUpdate(
+      const HostEmbeddingInfo& update_info,
+      const tensorflow::TensorShape& indices_shape,
+      const std::vector<HostEmbeddingCache*>& caches,
+      HostEmbeddingInterface_* embedding_interface);
   Status ConnectHostEmbeddingNotify(
       const HostEmbeddingInfo& notify_info,
       HostEmbeddingInterface_* embedding_interface);
@@ -806,6 +975,21 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   IOFunction CreateInfeedIOThreadFunction(const FeedInfo& infeed_info);
   IOFunction CreateOutfeedIOThreadFunction(const FeedInfo& outfeed_info);
 
+  // Number of groups of replicas which are fed by separate threads.
+  int64 GetNumInfeedReplicaGroups() const;
+
+  // Creates a thread which gets the elements from the dataset and a thread for
+  // each group of replicas which enqueues the slices for those replicas.
+  std::vector<std::unique_ptr<IOThread>> CreateReplicaGroupInfeedIOThreads(
+      const FeedInfo& infeed_info, int64 num_groups);
+
+  // Slices the dataset outputs and pushes the slices for the replicas in
+  // [replica_begin, replica_end) into their infeed queues.
+  static void EnqueueReplicaSlices(
+      std::vector<tensorflow::Tensor>& outputs,
+      std::vector<std::vector<InfeedQueue*>>& infeed_queues,
+      int64 replication_factor, int64 replica_begin, int64 replica_end);
+
   // Creates and launches the threads which send/receive data from the Poplar
   // stream callbacks.
   void LaunchIOThreads(const InfeedInfos& infeed_infos,
@@ -824,6 +1008,11 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   std::vector<std::unique_ptr<IOThread>> io_threads_;
 
+  // Keeps the cores of the IO threads out of the tf.data autotuning budget
+  // while they are running.
+  std::unique_ptr<tensorflow::data::model::ResourceReservation>
+      io_thread_reservation_;
+
   std::unique_ptr<tensorflow::CancellationManager> cm_;
 
   poplar::Engine* current_engine_;
@@ -835,6 +1024,17 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   bool device_attached_;
 
+  // Starts attaching to the device in the background.
+  void StartAsynchronousAttach();
+
+  // The attach running in the background, and whether the device it will
+  // attach to supports remote buffers, which the graphs are compiled for in
+  // the meantime.
+  mutable std::mutex async_attach_mu_;
+  std::future<Status> async_attach_;
+  Status async_attach_status_;
+  bool async_attach_supports_remote_buffers_ = false;
+
   class IPUConfig {
    public:
     bool DeviceConfigured() const;
@@ -876,6 +1076,13 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   ArgsHandleMap args_map_;
   OutputsHandleMap outputs_map_;
 
+  // The bindings of the executables which have an engine, and the bindings
+  // args_map_ was last built from.
+  absl::flat_hash_map<const poplar::Engine*,
+                      std::unique_ptr<ExecutableBindings>>
+      executable_bindings_;
+  const ExecutableBindings* args_map_bindings_ = nullptr;
+
   bool configured_;
   IpuOptions current_config_;
 
@@ -887,14 +1094,32 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
     bool Matches(const FeedInfo& outfeed_info);
 
-    const PoplarFeedConfig config;
+    // Changes the io batch size of an autotuned outfeed, which changes the
+    // size of the transfers from the device. The IO thread must not be
+    // running.
+    void SetIoBatchSize(int64 io_batch_size);
+
+    // Creates the queues for each tensor and replica, which hold the elements
+    // of a transfer.
+    void CreateCallbackToIOThreadQueues();
+
+    PoplarFeedConfig config;
     const std::vector<xla::Shape> shapes;
     std::vector<tensorflow::DataType> tf_data_types;
     std::vector<tensorflow::TensorShape> tf_shapes;
     using OutfeedQueueStorage =
         std::unique_ptr<OutfeedQueueType, void (*)(void*)>;
     std::vector<std::vector<OutfeedQueueStorage>> callback_to_io_thread_queues;
+    // Elements of the outfeed when using the GetAll mode.
+    std::unique_ptr<OutfeedTensorRing> tensor_ring;
+    // Writes the elements of the outfeed to files instead of the tensor ring
+    // when the GetAll mode is used with a file sink.
+    std::unique_ptr<OutfeedFileSink> file_sink;
+    // Last element of the outfeed when using the GetLast mode.
     std::deque<std::vector<tensorflow::Tensor>> io_thread_output_queues;
+    // Used by the IO thread to wait for the stream callbacks to fill the
+    // queues.
+    FeedWaiter waiter;
     // Mutex to prevent TF CPU op reading from the outfeed whilst we are
     // moving a tensor from the device.
     std::recursive_mutex mutex;
@@ -903,6 +1128,15 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
   // Allocator that should be used for infeeds.
   InfeedAllocator infeed_allocator;
 
+  // Copies the infeed elements into the Poplar stream buffers.
+  std::unique_ptr<ParallelCopier> infeed_copier_;
+
+  // Converts the variables which are moved between the host and the device.
+  std::unique_ptr<ParallelConverter> variable_converter_;
+
+  // The number of times the engine of each module has been loaded.
+  absl::flat_hash_map<std::string, int64> engine_load_counts_;
+
   absl::flat_hash_map<std::string, std::unique_ptr<InfeedIterator>>
       infeed_iterators_;
 
@@ -914,12 +1148,57 @@ class PoplarExecutor : public se::internal::StreamExecutorInterface {
 
   std::mutex host_embeddings_mutex_;
 
+  // The host side state of the device cache of a host embedding for a single
+  // replica.
+  struct HostEmbeddingCacheContext {
+    HostEmbeddingCacheContext(int64 num_rows, int64 max_misses,
+                              HostEmbeddingCache::Policy policy,
+                              int64 num_slots)
+        : cache(num_rows, max_misses, policy), slots(num_slots) {}
+
+    HostEmbeddingCache cache;
+    // The slots of the last lookup.
+    std::vector<uint32> slots;
+  };
+
+  // Returns the device caches of all the lookups of a host embedding.
+  std::vector<HostEmbeddingCache*> GetHostEmbeddingCaches(
+      const std::string& embedding_id);
+
+  // The device caches for each host embedding lookup, one per replica. The
+  // caches are reset for every execution as the embedding can be modified
+  // between executions.
+  absl::flat_hash_map<std::string,
+                      std::vector<std::unique_ptr<HostEmbeddingCacheContext>>>
+      host_embedding_caches_;
+
   SeedGenerator seed_generator_;
 
   std::string ReportFileExtension() const;
 
   bool has_cycle_counter_;
 
+  bool has_pipeline_cycle_counter_;
+
+  // JSON summary of the pipeline cycle counts of the last execution.
+  std::string pipeline_cycle_counts_;
+
+  std::vector<std::string> instruction_cycle_counter_names_;
+
+  // JSON summary of the total cycles of each instruction in the last
+  // execution.
+  std::string instruction_cycle_counts_;
+
+  // JSON summary of the infeed and outfeed queue counters of the last
+  // execution.
+  std::string feed_queue_stats_;
+
+  // The host time of the last execution which was not spent running the main
+  // program.
+  uint64 host_overhead_nanos_ = 0;
+
+  FeedAutotuner feed_autotuner_;
+
   tensorflow::core::RefCountPtr<tensorflow::Rendezvous> rendezvous_;
 };
 
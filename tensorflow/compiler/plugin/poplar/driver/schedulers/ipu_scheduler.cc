@@ -14,14 +14,19 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/compiler/plugin/poplar/driver/schedulers/ipu_scheduler.h"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <queue>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/xla/service/heap_simulator.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
@@ -32,9 +37,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace poplarplugin {
@@ -72,6 +81,21 @@ StatusOr<HloSchedule> IpuScheduleModule(
 }
 }  // namespace
 
+IpuScheduleMemoryEstimator CreateHeapSimulatorMemoryEstimator() {
+  return [](const HloComputation& computation,
+            const HloInstructionSequence& sequence,
+            const LogicalBuffer::SizeFunction& size_function,
+            const absl::flat_hash_map<const HloComputation*, int64>&
+                memory_by_computation) -> StatusOr<int64> {
+    // TODO(T9494): Replace the heap simulator
+    std::unique_ptr<HloAliasAnalysis> alias_analysis =
+        HloAliasAnalysis::NewEmptyAnalysis(computation.parent());
+    return HeapSimulator::MinimumMemoryForComputation(
+        computation, sequence, *alias_analysis, size_function,
+        &memory_by_computation);
+  };
+}
+
 IpuSchedulerAlgorithm MemorySchedulerAlgorithmToIPU(
     MemorySchedulerAlgorithm algorithm) {
   return [algorithm](HloComputation* computation,
@@ -179,7 +203,8 @@ StatusOr<IpuSchedulerAlgorithm> BestIpuSchedule(
 }
 
 StatusOr<IpuSchedulerAlgorithm> BestIpuSchedule(
-    const std::vector<IpuSchedulerAlgorithm>& algorithms) {
+    const std::vector<IpuSchedulerAlgorithm>& algorithms,
+    const IpuScheduleMemoryEstimator& estimator) {
   if (algorithms.empty()) {
     return xla::FailedPrecondition(
         "Cannot construct BestIpuSchedule when the input is empty");
@@ -189,19 +214,94 @@ StatusOr<IpuSchedulerAlgorithm> BestIpuSchedule(
     return static_cast<bool>(algo);
   };
 
+  if (!estimator) {
+    return xla::FailedPrecondition(
+        "Cannot construct BestIpuSchedule without a memory estimator");
+  }
+
   if (absl::c_none_of(algorithms, algo_predicate)) {
     return xla::FailedPrecondition(
         "Cannot construct BestIpuSchedule when none of the inputs are valid");
   }
 
-  // Iteratively apply the binary `BestIpuSchedule`.
-  // TODO(T9495) Consider building a balanced tree for parallel execution
-  IpuSchedulerAlgorithm result;
-  for (auto& algo : algorithms) {
-    TF_ASSIGN_OR_RETURN(result, BestIpuSchedule(result, algo));
+  std::vector<IpuSchedulerAlgorithm> valid_algorithms;
+  absl::c_copy_if(algorithms, std::back_inserter(valid_algorithms),
+                  algo_predicate);
+  if (valid_algorithms.size() == 1) {
+    return valid_algorithms[0];
   }
 
-  return result;
+  // The candidate schedules of each computation are computed concurrently.
+  const int64 max_threads = PoplarXlaFlags::Get().max_compilation_threads;
+  const int num_threads =
+      std::min<int64>(valid_algorithms.size(),
+                      max_threads > 0 ? max_threads
+                                      : tensorflow::port::MaxParallelism());
+  std::shared_ptr<tensorflow::thread::ThreadPool> thread_pool;
+  if (num_threads > 1) {
+    thread_pool = std::make_shared<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "ipu_scheduler", num_threads);
+  }
+
+  return IpuSchedulerAlgorithm{
+      [valid_algorithms, estimator, thread_pool](
+          HloComputation* computation,
+          const TuplePointsToAnalysis& tuple_points_to_analysis,
+          const LogicalBuffer::SizeFunction& size_function,
+          const absl::flat_hash_map<const HloComputation*, int64>&
+              memory_by_computation) -> StatusOr<HloInstructionSequence> {
+        const std::size_t num_algorithms = valid_algorithms.size();
+        std::vector<StatusOr<HloInstructionSequence>> schedules(
+            num_algorithms);
+        std::vector<int64> schedule_memory(num_algorithms);
+
+        // Each candidate is scheduled and then evaluated on its own thread.
+        auto schedule_candidate = [&](std::size_t i) {
+          schedules[i] =
+              valid_algorithms[i](computation, tuple_points_to_analysis,
+                                  size_function, memory_by_computation);
+          if (!schedules[i].ok()) {
+            return;
+          }
+          auto memory = estimator(*computation, schedules[i].ValueOrDie(),
+                                  size_function, memory_by_computation);
+          if (memory.ok()) {
+            schedule_memory[i] = memory.ValueOrDie();
+          } else {
+            schedules[i] = memory.status();
+          }
+        };
+
+        if (thread_pool) {
+          tensorflow::BlockingCounter counter(num_algorithms);
+          for (std::size_t i = 0; i != num_algorithms; ++i) {
+            thread_pool->Schedule([&, i]() {
+              schedule_candidate(i);
+              counter.DecrementCount();
+            });
+          }
+          counter.Wait();
+        } else {
+          for (std::size_t i = 0; i != num_algorithms; ++i) {
+            schedule_candidate(i);
+          }
+        }
+
+        // Pick the schedule which uses the least memory. As before, a later
+        // candidate wins a tie and the first failure is returned when no
+        // valid schedule could be produced.
+        int64 best = -1;
+        for (std::size_t i = 0; i != num_algorithms; ++i) {
+          if (schedules[i].ok() &&
+              (best < 0 || schedule_memory[i] <= schedule_memory[best])) {
+            best = i;
+          }
+        }
+        if (best < 0) {
+          return schedules[0].status();
+        }
+        return std::move(schedules[best]);
+      }};
 }
 
 IpuScheduler::IpuScheduler(const LogicalBuffer::SizeFunction& size_function,
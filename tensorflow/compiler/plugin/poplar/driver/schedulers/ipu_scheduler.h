@@ -37,6 +37,21 @@ using IpuSchedulerAlgorithm = std::function<StatusOr<HloInstructionSequence>(
     const LogicalBuffer::SizeFunction&,
     const absl::flat_hash_map<const HloComputation*, int64>&)>;
 
+/**
+ * Estimates the memory used by a schedule of a computation, which is used to
+ * choose between the schedules of several algorithms.
+ */
+using IpuScheduleMemoryEstimator = std::function<StatusOr<int64>(
+    const HloComputation&, const HloInstructionSequence&,
+    const LogicalBuffer::SizeFunction&,
+    const absl::flat_hash_map<const HloComputation*, int64>&)>;
+
+/**
+ * Create an estimator which returns the minimum memory of the schedule found
+ * by the heap simulator.
+ */
+IpuScheduleMemoryEstimator CreateHeapSimulatorMemoryEstimator();
+
 /**
  * Convert a tensorflow MemorySchedulerAlgorithm to a IpuSchedulerAlgorithm
  *
@@ -71,14 +86,18 @@ StatusOr<IpuSchedulerAlgorithm> BestIpuSchedule(
 
 /**
  * Given a set of scheduling algorithms, create a new schedule algorithm which
- * will return the best of the given scheduling algorithms.
+ * will return the best of the given scheduling algorithms. The algorithms are
+ * run concurrently, on up to `max_compilation_threads` threads.
  *
  * @param algorithms The set of algorithms
+ * @param estimator The estimate of memory used to compare the schedules
  *
  * @returns a valid IpuSchedulerAlgorithm
  */
 StatusOr<IpuSchedulerAlgorithm> BestIpuSchedule(
-    const std::vector<IpuSchedulerAlgorithm>& algorithms);
+    const std::vector<IpuSchedulerAlgorithm>& algorithms,
+    const IpuScheduleMemoryEstimator& estimator =
+        CreateHeapSimulatorMemoryEstimator());
 
 /**
  * An HLO module pass which applies the given scheduling algorithm to each
@@ -0,0 +1,109 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/schedulers/tile_memory_estimator.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/heap_simulator.h"
+#include "tensorflow/compiler/xla/service/hlo_alias_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// The IPU of the tensor defined by the buffer.
+int64 GetBufferDeviceId(const BufferValue& buffer) {
+  const HloInstruction* inst = buffer.instruction();
+  if (!inst->has_sharding()) {
+    return 0;
+  }
+  const std::vector<int64> ids = GetShardingDeviceIdVector(
+      inst->sharding().GetSubSharding(inst->shape(), buffer.index()));
+  return ids.empty() ? 0 : ids[0];
+}
+}  // namespace
+
+int64 EstimateTileMappedBytes(const Shape& shape,
+                              const TileMemoryModel& model) {
+  const int64 tiles_per_ipu = std::max<int64>(model.tiles_per_ipu, 1);
+  const int64 min_bytes_per_tile = std::max<int64>(model.min_bytes_per_tile, 1);
+  const int64 grain_bytes = std::max<int64>(model.grain_bytes, 1);
+  if (!shape.IsArray()) {
+    return 0;
+  }
+  const int64 bytes = ShapeUtil::ByteSizeOf(shape);
+  if (bytes == 0) {
+    return 0;
+  }
+  const int64 tiles =
+      std::min(tiles_per_ipu, std::max<int64>(bytes / min_bytes_per_tile, 1));
+  const int64 bytes_per_tile =
+      RoundUpToNearest(CeilOfRatio(bytes, tiles), grain_bytes);
+  return bytes_per_tile * tiles;
+}
+
+LogicalBuffer::SizeFunction CreateTileMemorySizeFunction(
+    const TileMemoryModel& model) {
+  return [model](const BufferValue& buffer) {
+    return EstimateTileMappedBytes(buffer.shape(), model);
+  };
+}
+
+IpuScheduleMemoryEstimator CreateTileMemoryEstimator(
+    const TileMemoryModel& model) {
+  return [model](const HloComputation& computation,
+                 const HloInstructionSequence& sequence,
+                 const LogicalBuffer::SizeFunction&,
+                 const absl::flat_hash_map<const HloComputation*, int64>&
+                     memory_by_computation) -> StatusOr<int64> {
+    std::set<int64> devices = {0};
+    for (const HloInstruction* inst : computation.instructions()) {
+      if (inst->has_sharding()) {
+        for (int64 id : GetShardingDeviceIdVector(inst->sharding())) {
+          devices.insert(id);
+        }
+      }
+    }
+
+    std::unique_ptr<HloAliasAnalysis> alias_analysis =
+        HloAliasAnalysis::NewEmptyAnalysis(computation.parent());
+    const LogicalBuffer::SizeFunction tile_size_function =
+        CreateTileMemorySizeFunction(model);
+    int64 max_bytes = 0;
+    for (int64 device : devices) {
+      // Only the buffers of this IPU use its tiles.
+      auto device_size_function = [&](const BufferValue& buffer) -> int64 {
+        return GetBufferDeviceId(buffer) == device
+                   ? tile_size_function(buffer)
+                   : 0;
+      };
+      TF_ASSIGN_OR_RETURN(const int64 bytes,
+                          HeapSimulator::MinimumMemoryForComputation(
+                              computation, sequence, *alias_analysis,
+                              device_size_function, &memory_by_computation));
+      max_bytes = std::max(max_bytes, bytes);
+    }
+    return CeilOfRatio(max_bytes, std::max<int64>(model.tiles_per_ipu, 1));
+  };
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
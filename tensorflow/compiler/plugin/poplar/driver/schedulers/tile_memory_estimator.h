@@ -0,0 +1,63 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_SCHEDULERS_TILE_MEMORY_ESTIMATOR_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_SCHEDULERS_TILE_MEMORY_ESTIMATOR_H_
+
+#include "tensorflow/compiler/plugin/poplar/driver/schedulers/ipu_scheduler.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// The expected mapping of tensors onto the tiles of an IPU. Tensors are
+// assumed to be mapped linearly, like the tensors which have no allocation
+// target, so that each tile holds at least `min_bytes_per_tile` bytes and a
+// whole number of grains.
+struct TileMemoryModel {
+  int64 tiles_per_ipu = 1;
+  int64 min_bytes_per_tile = 128;
+  int64 grain_bytes = 8;
+};
+
+/**
+ * Estimate the number of bytes used on all the tiles by a tensor of the given
+ * shape, including the padding of the part of the tensor on each tile.
+ *
+ * @param shape The shape of the tensor. Tuples use no tile memory.
+ * @param model The expected tile mapping.
+ *
+ * @returns The number of bytes used by the tensor.
+ */
+int64 EstimateTileMappedBytes(const Shape& shape, const TileMemoryModel& model);
+
+/**
+ * Create a size function which returns the number of bytes used on the tiles
+ * by each buffer rather than the number of bytes in its shape.
+ */
+LogicalBuffer::SizeFunction CreateTileMemorySizeFunction(
+    const TileMemoryModel& model);
+
+/**
+ * Create a schedule memory estimator which returns the largest number of bytes
+ * used on a single tile of any IPU. The liveness of the buffers of each IPU is
+ * simulated separately, and the bytes live on an IPU are assumed to be spread
+ * evenly over its tiles.
+ */
+IpuScheduleMemoryEstimator CreateTileMemoryEstimator(
+    const TileMemoryModel& model);
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_SCHEDULERS_TILE_MEMORY_ESTIMATOR_H_
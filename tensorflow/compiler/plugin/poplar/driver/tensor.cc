@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <limits>
 #include <numeric>
+#include <set>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -55,6 +56,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/util/bcast.h"
 #include "tensorflow/stream_executor/lib/status.h"
@@ -100,6 +102,20 @@ bool ShouldRebalanceTensor(poplar::Graph& graph, const poplar::Tensor& tensor) {
   return tensor.numElements() > graph.getTarget().getNumTiles();
 }
 
+// Returns whether the busiest tile of the tensor holds more than
+// `tile_imbalance_rebalance_ratio` times its share of the tensor.
+bool IsTensorImbalanced(poplar::Graph& graph, const poplar::Tensor& tensor,
+                        TileImbalance* imbalance) {
+  const float ratio = PoplarXlaFlags::Get().tile_imbalance_rebalance_ratio;
+  if (ratio <= 0.0f ||
+      tensor.numElements() <= graph.getTarget().getNumTiles()) {
+    return false;
+  }
+  *imbalance = GetTileImbalance(graph, tensor);
+  return imbalance->max_tile_elements >
+         ratio * imbalance->balanced_tile_elements;
+}
+
 poplar::Tensor RebalanceTensorIfRequired(poplar::Graph& graph,
                                          CompilerResources& res,
                                          poplar::program::Sequence& seq,
@@ -109,9 +125,32 @@ poplar::Tensor RebalanceTensorIfRequired(poplar::Graph& graph,
   bool rebalance =
       always_add_copy ? true : ShouldRebalanceTensor(graph, tensor);
 
+  TileImbalance imbalance;
   if (rebalance) {
     rebalanced_tensor = TensorCloneAndRebalanceAliasing(graph, res, tensor);
     seq.add(poplar::program::Copy(tensor, rebalanced_tensor));
+  } else if (IsTensorImbalanced(graph, tensor, &imbalance)) {
+    // Most of the tensor is on a few tiles, for example because no layout
+    // could be found for it, which makes the instructions using it slow and
+    // the busiest tiles run out of memory first.
+    rebalanced_tensor = graph.clone(tensor);
+    MappingHelper::MapTensorLinearly(res.linear_mapping_state, graph,
+                                     rebalanced_tensor);
+    seq.add(poplar::program::Copy(tensor, rebalanced_tensor));
+
+    const TileImbalance rebalanced = GetTileImbalance(graph, rebalanced_tensor);
+    const std::size_t type_size =
+        graph.getTarget().getTypeSize(tensor.elementType());
+    res.tile_imbalance_stats.num_rebalanced_tensors++;
+    if (rebalanced.max_tile_elements < imbalance.max_tile_elements) {
+      res.tile_imbalance_stats.max_tile_bytes_saved +=
+          (imbalance.max_tile_elements - rebalanced.max_tile_elements) *
+          type_size;
+    }
+    VLOG(2) << "Rebalanced a tensor of " << tensor.numElements()
+            << " elements with " << imbalance.max_tile_elements
+            << " elements on its busiest tile, instead of "
+            << imbalance.balanced_tile_elements << ".";
   }
   return rebalanced_tensor;
 }
@@ -152,8 +191,9 @@ StatusOr<poplar::Type> PoplarDataType(const xla::PrimitiveType& element_type) {
     case PRED:
       return poplar::BOOL;
     case S8:
-    case U8:
       return poplar::CHAR;
+    case U8:
+      return poplar::UNSIGNED_CHAR;
     case S16:
       return poplar::SHORT;
     case S32:
@@ -939,6 +979,33 @@ void Set64BitInitialTensorValueImpl(poplar::Graph& graph,
 }
 }  // namespace
 
+TileImbalance GetTileImbalance(const poplar::Graph& graph,
+                               const poplar::Tensor& tensor) {
+  const poplar::Target& target = graph.getTarget();
+  const std::size_t tiles_per_ipu =
+      std::min<std::size_t>(target.getTilesPerIPU(), target.getNumTiles());
+
+  TileImbalance imbalance;
+  std::set<std::size_t> ipus;
+  const auto mapping = graph.getTileMapping(tensor, false);
+  for (std::size_t tile = 0; tile != mapping.size(); ++tile) {
+    std::size_t tile_elements = 0;
+    for (const auto& interval : mapping[tile]) {
+      tile_elements += interval.size();
+    }
+    if (tile_elements) {
+      ipus.insert(tile / tiles_per_ipu);
+      imbalance.max_tile_elements =
+          std::max(imbalance.max_tile_elements, tile_elements);
+    }
+  }
+  const std::size_t num_tiles =
+      std::max<std::size_t>(ipus.size(), 1) * tiles_per_ipu;
+  imbalance.balanced_tile_elements =
+      tensorflow::MathUtil::CeilOfRatio(tensor.numElements(), num_tiles);
+  return imbalance;
+}
+
 poplar::Tensor TensorCloneAndRebalanceAliasing(poplar::Graph& graph,
                                                CompilerResources& res,
                                                const poplar::Tensor& tensor,
@@ -74,6 +74,18 @@ poplar::Tensor CreateTensorFromSlice(poplar::Graph& graph,
                                      CompilerResources& resources,
                                      const std::string& name = "");
 
+// How unevenly the elements of a tensor are spread over the tiles.
+struct TileImbalance {
+  // The number of elements on the busiest tile.
+  std::size_t max_tile_elements = 0;
+  // The number of elements on each tile if the tensor was spread evenly over
+  // all the tiles of the IPUs it is mapped to.
+  std::size_t balanced_tile_elements = 0;
+};
+
+TileImbalance GetTileImbalance(const poplar::Graph& graph,
+                               const poplar::Tensor& tensor);
+
 // Clone the tensor and rebalance any aliasing across the tiles.
 poplar::Tensor TensorCloneAndRebalanceAliasing(poplar::Graph& graph,
                                                CompilerResources& res,
@@ -0,0 +1,123 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/block_sparse_preplanning.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/block_sparse_matmul.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+
+#include <popsparse/experimental/BlockSparseMatMul.hpp>
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+using popsparse::experimental::BSMatMulParams;
+
+// The dimensions of a block-sparse matmul.
+struct BlockSparseDims {
+  int m;
+  int k;
+  int n;
+  int block_m;
+  int block_k;
+  int block_n;
+  std::vector<unsigned char> sparsity;
+};
+
+BlockSparseDims GetBlockSparseDims(const HloBlockSparseMatMulBase* inst) {
+  const Shape& lhs_shape = inst->operand(0)->shape();
+  const std::vector<int64>& block_size = inst->BlockSize();
+  BlockSparseDims dims;
+  dims.m = lhs_shape.dimensions(0);
+  dims.k = lhs_shape.dimensions(1);
+  dims.n = inst->SparsityShape()[1] * block_size[2];
+  dims.block_m = block_size[0];
+  dims.block_k = block_size[1];
+  dims.block_n = block_size[2];
+  dims.sparsity = {inst->Sparsity().begin(), inst->Sparsity().end()};
+  return dims;
+}
+
+// Plans the dense [M, K] by sparse [K, N] multiplication of the forward pass.
+StatusOr<std::vector<const BSMatMulParams*>> PlanForward(
+    const HloBlockSparseMatMulBase* inst, CompilerResources& res) {
+  const BlockSparseDims dims = GetBlockSparseDims(inst);
+  TF_ASSIGN_OR_RETURN(poplar::Type type,
+                      PoplarDataType(inst->operand(0)->shape()));
+  res.block_sparse_plans.emplace_back(
+      std::array<int, 3>{dims.m, dims.k, dims.n},
+      std::array<int, 3>{dims.block_m, dims.block_k, dims.block_n},
+      dims.sparsity, /*rhsNeedTranspose=*/false, type, type, poplar::FLOAT);
+  return std::vector<const BSMatMulParams*>{&res.block_sparse_plans.back()};
+}
+
+// Plans the gradient of the left hand side, the dense [M, N] by transposed
+// sparse [N, K] multiplication, and the gradient of the non-zero blocks of
+// the right hand side, the dense [K, M] by dense [M, N] multiplication with a
+// sparse result.
+StatusOr<std::vector<const BSMatMulParams*>> PlanGrad(
+    const HloBlockSparseMatMulBase* inst, CompilerResources& res) {
+  const BlockSparseDims dims = GetBlockSparseDims(inst);
+  TF_ASSIGN_OR_RETURN(poplar::Type type,
+                      PoplarDataType(inst->operand(0)->shape()));
+  res.block_sparse_plans.emplace_back(
+      std::array<int, 3>{dims.m, dims.n, dims.k},
+      std::array<int, 3>{dims.block_m, dims.block_n, dims.block_k},
+      dims.sparsity, /*rhsNeedTranspose=*/true, type, type, poplar::FLOAT);
+  const BSMatMulParams* grad_lhs_plan = &res.block_sparse_plans.back();
+
+  res.block_sparse_plans.emplace_back(
+      std::array<int, 3>{dims.k, dims.m, dims.n},
+      std::array<int, 3>{dims.block_k, dims.block_m, dims.block_n},
+      dims.sparsity, type, type, poplar::FLOAT);
+  const BSMatMulParams* grad_rhs_plan = &res.block_sparse_plans.back();
+
+  return std::vector<const BSMatMulParams*>{grad_lhs_plan, grad_rhs_plan};
+}
+}  // namespace
+
+Status BlockSparsePreplanning::Plan(const HloModule* module,
+                                    CompilerResources& res) {
+  HloComputation* entry_computation =
+      res.annotations.flattened_module->entry_computation();
+
+  for (const HloInstruction* inst :
+       entry_computation->MakeInstructionPostOrder()) {
+    std::vector<const BSMatMulParams*> plans;
+    if (IsPoplarInstruction(PoplarOp::BlockSparseMatMul)(inst)) {
+      TF_ASSIGN_OR_RETURN(
+          plans, PlanForward(Cast<HloBlockSparseMatMulBase>(inst), res));
+    } else if (IsPoplarInstruction(PoplarOp::BlockSparseMatMulGrad)(inst)) {
+      TF_ASSIGN_OR_RETURN(plans,
+                          PlanGrad(Cast<HloBlockSparseMatMulBase>(inst), res));
+    } else {
+      continue;
+    }
+    // Map the plans to the instruction in the original module.
+    const HloInstruction* original_inst =
+        res.annotations.flattened_inst_map_bwd.at(inst);
+    res.block_sparse_plan_mappings[original_inst] = std::move(plans);
+  }
+  return Status::OK();
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,154 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/block_sparse_matmul.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/ops.pb.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Both the dense and the sparse operands are allocated with the layout of the
+// block-sparse matmul plan.
+absl::flat_hash_set<int64> HloBlockSparseMatMulBase::AllocatingIndices() const {
+  return {0, 1};
+}
+
+absl::flat_hash_map<int64, int64> HloBlockSparseMatMulBase::LayoutDependencies()
+    const {
+  return {};
+}
+
+uint64 HloBlockSparseMatMulBase::NumberOfInplaceOperands() const { return 0; }
+
+bool HloBlockSparseMatMulBase::IsPopOpsElementwise() const { return false; }
+
+std::vector<std::string>
+HloBlockSparseMatMulBase::ExtraPoplarAttributesToStringImpl(
+    const HloPrintOptions& options) const {
+  std::vector<std::string> attributes;
+  attributes.push_back(
+      absl::StrCat("block_size=", absl::StrJoin(block_size_, ",")));
+  attributes.push_back(
+      absl::StrCat("sparsity_shape=", absl::StrJoin(sparsity_shape_, ",")));
+  attributes.push_back(
+      absl::StrCat("sparsity=", absl::StrJoin(sparsity_, "")));
+  return attributes;
+}
+
+HloBlockSparseMatMulInstruction::HloBlockSparseMatMulInstruction(
+    const Shape& shape, HloInstruction* const lhs, HloInstruction* const rhs,
+    const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity)
+    : HloBlockSparseMatMulBase(shape, {lhs, rhs}, PoplarOp::BlockSparseMatMul,
+                               block_size, sparsity_shape, sparsity) {}
+
+std::unique_ptr<HloInstruction>
+HloBlockSparseMatMulInstruction::CloneWithNewOperandsImpl(
+    const Shape& shape, absl::Span<HloInstruction* const> operands,
+    HloCloneContext*) const {
+  return CreateBlockSparseMatMul(shape, operands[0], operands[1], BlockSize(),
+                                 SparsityShape(), Sparsity());
+}
+
+HloBlockSparseMatMulGradInstruction::HloBlockSparseMatMulGradInstruction(
+    HloInstruction* const lhs, HloInstruction* const rhs,
+    HloInstruction* const grad, const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity)
+    : HloBlockSparseMatMulBase(
+          ShapeUtil::MakeTupleShape({lhs->shape(), rhs->shape()}),
+          {lhs, rhs, grad}, PoplarOp::BlockSparseMatMulGrad, block_size,
+          sparsity_shape, sparsity) {}
+
+// The gradient is allocated for the transposed matmul of the left hand side
+// gradient.
+absl::flat_hash_set<int64>
+HloBlockSparseMatMulGradInstruction::AllocatingIndices() const {
+  return {2};
+}
+
+std::unique_ptr<HloInstruction>
+HloBlockSparseMatMulGradInstruction::CloneWithNewOperandsImpl(
+    const Shape& shape, absl::Span<HloInstruction* const> operands,
+    HloCloneContext*) const {
+  return CreateBlockSparseMatMulGrad(operands[0], operands[1], operands[2],
+                                     BlockSize(), SparsityShape(), Sparsity());
+}
+
+std::unique_ptr<HloInstruction> CreateBlockSparseMatMul(
+    const Shape& shape, HloInstruction* const lhs, HloInstruction* const rhs,
+    const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity) {
+  return absl::make_unique<HloBlockSparseMatMulInstruction>(
+      shape, lhs, rhs, block_size, sparsity_shape, sparsity);
+}
+
+std::unique_ptr<HloInstruction> CreateBlockSparseMatMulGrad(
+    HloInstruction* const lhs, HloInstruction* const rhs,
+    HloInstruction* const grad, const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity) {
+  return absl::make_unique<HloBlockSparseMatMulGradInstruction>(
+      lhs, rhs, grad, block_size, sparsity_shape, sparsity);
+}
+
+namespace {
+
+static HloPoplarInstructionFactory block_sparse_matmul_factory(
+    PoplarOp::BlockSparseMatMul,
+    [](HloCustomCallInstruction* call)
+        -> StatusOr<std::unique_ptr<HloInstruction>> {
+      auto attribute_map = IPUCustomKernelsUtil::AttributeMap(call);
+      TF_ASSIGN_OR_RETURN(std::vector<int64> block_size,
+                          attribute_map.GetAttributeInt64Vector("block_size"));
+      TF_ASSIGN_OR_RETURN(
+          std::vector<int64> sparsity_shape,
+          attribute_map.GetAttributeInt64Vector("sparsity_shape"));
+      TF_ASSIGN_OR_RETURN(std::vector<int64> sparsity,
+                          attribute_map.GetAttributeInt64Vector("sparsity"));
+      return CreateBlockSparseMatMul(
+          call->shape(), call->mutable_operand(0), call->mutable_operand(1),
+          block_size, sparsity_shape, sparsity);
+    });
+
+static HloPoplarInstructionFactory block_sparse_matmul_grad_factory(
+    PoplarOp::BlockSparseMatMulGrad,
+    [](HloCustomCallInstruction* call)
+        -> StatusOr<std::unique_ptr<HloInstruction>> {
+      auto attribute_map = IPUCustomKernelsUtil::AttributeMap(call);
+      TF_ASSIGN_OR_RETURN(std::vector<int64> block_size,
+                          attribute_map.GetAttributeInt64Vector("block_size"));
+      TF_ASSIGN_OR_RETURN(
+          std::vector<int64> sparsity_shape,
+          attribute_map.GetAttributeInt64Vector("sparsity_shape"));
+      TF_ASSIGN_OR_RETURN(std::vector<int64> sparsity,
+                          attribute_map.GetAttributeInt64Vector("sparsity"));
+      return CreateBlockSparseMatMulGrad(
+          call->mutable_operand(0), call->mutable_operand(1),
+          call->mutable_operand(2), block_size, sparsity_shape, sparsity);
+    });
+
+}  // namespace
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_BLOCK_SPARSE_MATMUL_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_BLOCK_SPARSE_MATMUL_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/hlo_poplar_instruction.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Base class of the multiplications of a dense [M, K] left hand side by a
+// block-sparse [K, N] right hand side with a static sparsity pattern. The
+// right hand side is passed as its non-zero blocks, shaped
+// [num_non_zero_blocks, block_k * block_n] in row major order of the blocks.
+class HloBlockSparseMatMulBase : public HloPoplarInstruction {
+ public:
+  HloBlockSparseMatMulBase(const Shape& shape,
+                           absl::Span<HloInstruction* const> operands,
+                           PoplarOp op, const std::vector<int64>& block_size,
+                           const std::vector<int64>& sparsity_shape,
+                           const std::vector<int64>& sparsity)
+      : HloPoplarInstruction(shape, operands, op, block_size, sparsity_shape,
+                             sparsity),
+        block_size_(block_size),
+        sparsity_shape_(sparsity_shape),
+        sparsity_(sparsity) {}
+
+  absl::flat_hash_set<int64> AllocatingIndices() const override;
+
+  absl::flat_hash_map<int64, int64> LayoutDependencies() const override;
+
+  uint64 NumberOfInplaceOperands() const override;
+
+  bool IsPopOpsElementwise() const override;
+
+  // The {M, K, N} block size.
+  const std::vector<int64>& BlockSize() const { return block_size_; }
+  // The number of {K, N} blocks of the right hand side.
+  const std::vector<int64>& SparsityShape() const { return sparsity_shape_; }
+  // Whether each block of the right hand side is non-zero, in row major
+  // order.
+  const std::vector<int64>& Sparsity() const { return sparsity_; }
+
+ protected:
+  std::vector<std::string> ExtraPoplarAttributesToStringImpl(
+      const HloPrintOptions& options) const override;
+
+ private:
+  const std::vector<int64> block_size_;
+  const std::vector<int64> sparsity_shape_;
+  const std::vector<int64> sparsity_;
+};
+
+class HloBlockSparseMatMulInstruction : public HloBlockSparseMatMulBase {
+ public:
+  explicit HloBlockSparseMatMulInstruction(
+      const Shape& shape, HloInstruction* const lhs, HloInstruction* const rhs,
+      const std::vector<int64>& block_size,
+      const std::vector<int64>& sparsity_shape,
+      const std::vector<int64>& sparsity);
+
+ private:
+  std::unique_ptr<HloInstruction> CloneWithNewOperandsImpl(
+      const Shape& shape, absl::Span<HloInstruction* const>,
+      HloCloneContext*) const override;
+};
+
+// The gradients of the left hand side and of the non-zero blocks of the right
+// hand side of a block-sparse matmul.
+class HloBlockSparseMatMulGradInstruction : public HloBlockSparseMatMulBase {
+ public:
+  explicit HloBlockSparseMatMulGradInstruction(
+      HloInstruction* const lhs, HloInstruction* const rhs,
+      HloInstruction* const grad, const std::vector<int64>& block_size,
+      const std::vector<int64>& sparsity_shape,
+      const std::vector<int64>& sparsity);
+
+  absl::flat_hash_set<int64> AllocatingIndices() const override;
+
+ private:
+  std::unique_ptr<HloInstruction> CloneWithNewOperandsImpl(
+      const Shape& shape, absl::Span<HloInstruction* const>,
+      HloCloneContext*) const override;
+};
+
+std::unique_ptr<HloInstruction> CreateBlockSparseMatMul(
+    const Shape& shape, HloInstruction* const lhs, HloInstruction* const rhs,
+    const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity);
+
+std::unique_ptr<HloInstruction> CreateBlockSparseMatMulGrad(
+    HloInstruction* const lhs, HloInstruction* const rhs,
+    HloInstruction* const grad, const std::vector<int64>& block_size,
+    const std::vector<int64>& sparsity_shape,
+    const std::vector<int64>& sparsity);
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_BLOCK_SPARSE_MATMUL_H_
@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/multi_head_attention.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/ops.pb.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace xla {
+namespace poplarplugin {
+
+HloMultiHeadAttentionInstruction::HloMultiHeadAttentionInstruction(
+    const Shape& shape, HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, bool causal)
+    : HloPoplarInstruction(shape, {query, key, value},
+                           PoplarOp::MultiHeadAttention, causal),
+      causal_(causal) {}
+
+absl::flat_hash_set<int64> HloMultiHeadAttentionInstruction::AllocatingIndices()
+    const {
+  return {};
+}
+
+absl::flat_hash_map<int64, int64>
+HloMultiHeadAttentionInstruction::LayoutDependencies() const {
+  return {};
+}
+
+uint64 HloMultiHeadAttentionInstruction::NumberOfInplaceOperands() const {
+  return 0;
+}
+
+bool HloMultiHeadAttentionInstruction::IsPopOpsElementwise() const {
+  return false;
+}
+
+std::unique_ptr<HloInstruction>
+HloMultiHeadAttentionInstruction::CloneWithNewOperandsImpl(
+    const Shape& shape, absl::Span<HloInstruction* const> operands,
+    HloCloneContext*) const {
+  return CreateMultiHeadAttention(shape, operands[0], operands[1], operands[2],
+                                  Causal());
+}
+
+std::vector<std::string>
+HloMultiHeadAttentionInstruction::ExtraPoplarAttributesToStringImpl(
+    const HloPrintOptions& options) const {
+  return {absl::StrCat("causal=", causal_)};
+}
+
+HloMultiHeadAttentionGradInstruction::HloMultiHeadAttentionGradInstruction(
+    HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, HloInstruction* const grad, bool causal)
+    : HloPoplarInstruction(
+          ShapeUtil::MakeTupleShape(
+              {query->shape(), key->shape(), value->shape()}),
+          {query, key, value, grad}, PoplarOp::MultiHeadAttentionGrad, causal),
+      causal_(causal) {}
+
+absl::flat_hash_set<int64>
+HloMultiHeadAttentionGradInstruction::AllocatingIndices() const {
+  return {};
+}
+
+absl::flat_hash_map<int64, int64>
+HloMultiHeadAttentionGradInstruction::LayoutDependencies() const {
+  return {};
+}
+
+uint64 HloMultiHeadAttentionGradInstruction::NumberOfInplaceOperands() const {
+  return 0;
+}
+
+bool HloMultiHeadAttentionGradInstruction::IsPopOpsElementwise() const {
+  return false;
+}
+
+std::unique_ptr<HloInstruction>
+HloMultiHeadAttentionGradInstruction::CloneWithNewOperandsImpl(
+    const Shape& shape, absl::Span<HloInstruction* const> operands,
+    HloCloneContext*) const {
+  return CreateMultiHeadAttentionGrad(operands[0], operands[1], operands[2],
+                                      operands[3], Causal());
+}
+
+std::vector<std::string>
+HloMultiHeadAttentionGradInstruction::ExtraPoplarAttributesToStringImpl(
+    const HloPrintOptions& options) const {
+  return {absl::StrCat("causal=", causal_)};
+}
+
+std::unique_ptr<HloInstruction> CreateMultiHeadAttention(
+    const Shape& shape, HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, bool causal) {
+  return absl::make_unique<HloMultiHeadAttentionInstruction>(shape, query, key,
+                                                             value, causal);
+}
+
+std::unique_ptr<HloInstruction> CreateMultiHeadAttentionGrad(
+    HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, HloInstruction* const grad, bool causal) {
+  return absl::make_unique<HloMultiHeadAttentionGradInstruction>(
+      query, key, value, grad, causal);
+}
+
+namespace {
+
+static HloPoplarInstructionFactory multi_head_attention_factory(
+    PoplarOp::MultiHeadAttention,
+    [](HloCustomCallInstruction* call)
+        -> StatusOr<std::unique_ptr<HloInstruction>> {
+      auto attribute_map = IPUCustomKernelsUtil::AttributeMap(call);
+      TF_ASSIGN_OR_RETURN(bool causal,
+                          attribute_map.GetAttributeAsBool("causal"));
+      return CreateMultiHeadAttention(
+          call->shape(), call->mutable_operand(0), call->mutable_operand(1),
+          call->mutable_operand(2), causal);
+    });
+
+static HloPoplarInstructionFactory multi_head_attention_grad_factory(
+    PoplarOp::MultiHeadAttentionGrad,
+    [](HloCustomCallInstruction* call)
+        -> StatusOr<std::unique_ptr<HloInstruction>> {
+      auto attribute_map = IPUCustomKernelsUtil::AttributeMap(call);
+      TF_ASSIGN_OR_RETURN(bool causal,
+                          attribute_map.GetAttributeAsBool("causal"));
+      return CreateMultiHeadAttentionGrad(
+          call->mutable_operand(0), call->mutable_operand(1),
+          call->mutable_operand(2), call->mutable_operand(3), causal);
+    });
+
+}  // namespace
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,103 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_MULTI_HEAD_ATTENTION_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_MULTI_HEAD_ATTENTION_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/hlo_poplar_instruction.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Scaled dot product attention of queries, keys and values shaped
+// [batch, num_heads, sequence, head_size], optionally masked so that each
+// query only attends to the keys up to its own position.
+class HloMultiHeadAttentionInstruction : public HloPoplarInstruction {
+ public:
+  explicit HloMultiHeadAttentionInstruction(const Shape& shape,
+                                            HloInstruction* const query,
+                                            HloInstruction* const key,
+                                            HloInstruction* const value,
+                                            bool causal);
+
+  absl::flat_hash_set<int64> AllocatingIndices() const override;
+
+  absl::flat_hash_map<int64, int64> LayoutDependencies() const override;
+
+  uint64 NumberOfInplaceOperands() const override;
+
+  bool IsPopOpsElementwise() const override;
+
+  bool Causal() const { return causal_; }
+
+ protected:
+  std::vector<std::string> ExtraPoplarAttributesToStringImpl(
+      const HloPrintOptions& options) const override;
+
+ private:
+  std::unique_ptr<HloInstruction> CloneWithNewOperandsImpl(
+      const Shape& shape, absl::Span<HloInstruction* const>,
+      HloCloneContext*) const override;
+
+  const bool causal_;
+};
+
+// The gradients of the queries, keys and values of a multi-head attention.
+// The attention probabilities are recomputed from the queries and keys rather
+// than being kept live from the forward pass.
+class HloMultiHeadAttentionGradInstruction : public HloPoplarInstruction {
+ public:
+  explicit HloMultiHeadAttentionGradInstruction(
+      HloInstruction* const query, HloInstruction* const key,
+      HloInstruction* const value, HloInstruction* const grad, bool causal);
+
+  absl::flat_hash_set<int64> AllocatingIndices() const override;
+
+  absl::flat_hash_map<int64, int64> LayoutDependencies() const override;
+
+  uint64 NumberOfInplaceOperands() const override;
+
+  bool IsPopOpsElementwise() const override;
+
+  bool Causal() const { return causal_; }
+
+ protected:
+  std::vector<std::string> ExtraPoplarAttributesToStringImpl(
+      const HloPrintOptions& options) const override;
+
+ private:
+  std::unique_ptr<HloInstruction> CloneWithNewOperandsImpl(
+      const Shape& shape, absl::Span<HloInstruction* const>,
+      HloCloneContext*) const override;
+
+  const bool causal_;
+};
+
+std::unique_ptr<HloInstruction> CreateMultiHeadAttention(
+    const Shape& shape, HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, bool causal);
+
+std::unique_ptr<HloInstruction> CreateMultiHeadAttentionGrad(
+    HloInstruction* const query, HloInstruction* const key,
+    HloInstruction* const value, HloInstruction* const grad, bool causal);
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_CUSTOM_OPS_MULTI_HEAD_ATTENTION_H_
@@ -0,0 +1,588 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/executable_cache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/error.h"
+#include "tensorflow/core/platform/file_statistics.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace xla {
+namespace poplarplugin {
+
+/* static */ StatusOr<std::shared_ptr<const MappedFile>> MappedFile::Open(
+    const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return tensorflow::IOError(path, errno);
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int err = errno;
+    close(fd);
+    return tensorflow::IOError(path, err);
+  }
+  const std::size_t size = file_stat.st_size;
+
+  void* data = nullptr;
+  if (size > 0) {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const int err = errno;
+      close(fd);
+      return tensorflow::IOError(path, err);
+    }
+  }
+  close(fd);
+
+  return std::shared_ptr<const MappedFile>(new MappedFile(data, size));
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+void MappedFile::WillNeed() const {
+  if (data_) {
+    madvise(data_, size_, MADV_WILLNEED);
+  }
+}
+
+MemoryStreamBuf::MemoryStreamBuf(const char* data, std::size_t size) {
+  // The buffer is only ever read from.
+  char* begin = const_cast<char*>(data);
+  setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  char* base;
+  switch (dir) {
+    case std::ios_base::beg:
+      base = eback();
+      break;
+    case std::ios_base::cur:
+      base = gptr();
+      break;
+    default:
+      base = egptr();
+      break;
+  }
+  char* pos = base + off;
+  if (pos < eback() || pos > egptr()) {
+    return pos_type(off_type(-1));
+  }
+  setg(eback(), pos, egptr());
+  return pos_type(pos - eback());
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(
+    pos_type pos, std::ios_base::openmode which) {
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+namespace {
+constexpr char kCompressedExecutableMagic[] = "IPUEXEZ1";
+constexpr std::size_t kCompressedExecutableMagicSize =
+    sizeof(kCompressedExecutableMagic) - 1;
+
+// Calls `fn` for every index in [0, n) on a pool of threads.
+void ParallelFor(int64 n, const std::function<void(int64)>& fn) {
+  const int64 num_threads =
+      std::min<int64>(n, tensorflow::port::MaxParallelism());
+  if (num_threads <= 1) {
+    for (int64 i = 0; i != n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                      "executable_cache_compression",
+                                      num_threads);
+  tensorflow::BlockingCounter counter(n);
+  for (int64 i = 0; i != n; ++i) {
+    pool.Schedule([&fn, &counter, i]() {
+      fn(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+void AppendUint64(uint64 value, std::string* output) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint64 ReadUint64(const char* data) {
+  uint64 value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+}  // namespace
+
+// The compressed format is the magic string, the number of chunks, the
+// compressed and uncompressed size of every chunk and then the compressed
+// chunks.
+Status CompressExecutable(const std::string& data, std::string* output,
+                          std::size_t chunk_size) {
+  const int64 num_chunks = (data.size() + chunk_size - 1) / chunk_size;
+  std::vector<std::string> chunks(num_chunks);
+  std::atomic<bool> ok(true);
+  ParallelFor(num_chunks, [&](int64 i) {
+    const std::size_t offset = i * chunk_size;
+    const std::size_t size = std::min(chunk_size, data.size() - offset);
+    if (!tensorflow::port::Snappy_Compress(data.data() + offset, size,
+                                           &chunks[i])) {
+      ok = false;
+    }
+  });
+  if (!ok) {
+    return tensorflow::errors::Unavailable(
+        "Snappy compression is not available.");
+  }
+
+  output->clear();
+  output->append(kCompressedExecutableMagic, kCompressedExecutableMagicSize);
+  AppendUint64(num_chunks, output);
+  for (int64 i = 0; i != num_chunks; ++i) {
+    AppendUint64(chunks[i].size(), output);
+    AppendUint64(std::min(chunk_size, data.size() - i * chunk_size), output);
+  }
+  for (const std::string& chunk : chunks) {
+    output->append(chunk);
+  }
+  return Status::OK();
+}
+
+bool IsCompressedExecutable(const char* data, std::size_t size) {
+  return size >= kCompressedExecutableMagicSize &&
+         std::memcmp(data, kCompressedExecutableMagic,
+                     kCompressedExecutableMagicSize) == 0;
+}
+
+Status DecompressExecutable(const char* data, std::size_t size,
+                            std::string* output) {
+  auto corrupt = []() {
+    return tensorflow::errors::DataLoss(
+        "The compressed executable is corrupt.");
+  };
+  if (!IsCompressedExecutable(data, size)) {
+    return corrupt();
+  }
+  std::size_t offset = kCompressedExecutableMagicSize;
+  if (size - offset < sizeof(uint64)) {
+    return corrupt();
+  }
+  const uint64 num_chunks = ReadUint64(data + offset);
+  offset += sizeof(uint64);
+  if ((size - offset) / (2 * sizeof(uint64)) < num_chunks) {
+    return corrupt();
+  }
+
+  // Find where every chunk starts in the input and in the output.
+  std::vector<std::size_t> input_offsets(num_chunks);
+  std::vector<std::size_t> output_offsets(num_chunks);
+  std::vector<std::size_t> compressed_sizes(num_chunks);
+  std::size_t input_offset = offset + num_chunks * 2 * sizeof(uint64);
+  std::size_t output_size = 0;
+  for (uint64 i = 0; i != num_chunks; ++i) {
+    compressed_sizes[i] = ReadUint64(data + offset);
+    const uint64 uncompressed_size = ReadUint64(data + offset + sizeof(uint64));
+    offset += 2 * sizeof(uint64);
+    if (compressed_sizes[i] > size - input_offset) {
+      return corrupt();
+    }
+    input_offsets[i] = input_offset;
+    output_offsets[i] = output_size;
+    input_offset += compressed_sizes[i];
+    output_size += uncompressed_size;
+  }
+
+  // Decompress the chunks straight into their place in the output.
+  output->resize(output_size);
+  std::atomic<bool> ok(true);
+  ParallelFor(num_chunks, [&](int64 i) {
+    const char* input = data + input_offsets[i];
+    const std::size_t expected_size =
+        (i + 1 == num_chunks ? output_size : output_offsets[i + 1]) -
+        output_offsets[i];
+    std::size_t uncompressed_size;
+    if (!tensorflow::port::Snappy_GetUncompressedLength(
+            input, compressed_sizes[i], &uncompressed_size) ||
+        uncompressed_size != expected_size ||
+        !tensorflow::port::Snappy_Uncompress(input, compressed_sizes[i],
+                                             &(*output)[output_offsets[i]])) {
+      ok = false;
+    }
+  });
+  if (!ok) {
+    output->clear();
+    return corrupt();
+  }
+  return Status::OK();
+}
+
+namespace {
+bool IsCachedExecutable(const std::string& filename) {
+  return absl::EndsWith(filename, ".poplar_exec") ||
+         absl::EndsWith(filename, ".xla_engine");
+}
+
+// Copies `src` to `dst` through a temporary file next to `dst` so that `dst`
+// is never partially written.
+Status AtomicCopy(const std::string& src, const std::string& dst) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const std::string temporary = ExecutableCache::TemporaryFilename(dst);
+  Status status = env->CopyFile(src, temporary);
+  if (status.ok()) {
+    status = env->RenameFile(temporary, dst);
+  }
+  if (!status.ok()) {
+    env->DeleteFile(temporary).IgnoreError();
+  }
+  return status;
+}
+}  // namespace
+
+ExecutableCache::ExecutableCache(const std::string& path, bool prefetch,
+                                 int64 max_size,
+                                 const std::string& remote_path)
+    : path_(path), max_size_(max_size), remote_path_(remote_path) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::vector<std::string> children;
+  if (env->GetChildren(path_, &children).ok()) {
+    for (const std::string& child : children) {
+      if (!IsCachedExecutable(child)) {
+        continue;
+      }
+      const std::string filename = tensorflow::io::JoinPath(path_, child);
+      tensorflow::FileStatistics stat;
+      if (env->Stat(filename, &stat).ok()) {
+        const uint64 mtime_micros = stat.mtime_nsec / 1000;
+        files_[filename] = CachedFile{stat.length, mtime_micros};
+      }
+    }
+  }
+  VLOG(1) << "Indexed " << files_.size() << " files in the executable cache "
+          << path_;
+
+  if (prefetch && !files_.empty()) {
+    prefetch_thread_.reset(env->StartThread(
+        tensorflow::ThreadOptions(), "executable_cache_prefetch",
+        [this]() { PrefetchAll(); }));
+  }
+}
+
+ExecutableCache::~ExecutableCache() = default;
+
+/* static */ ExecutableCache& ExecutableCache::Get() {
+  const auto& flags = PoplarXlaFlags::Get();
+  static ExecutableCache* cache = new ExecutableCache(
+      flags.executable_cache_path, flags.executable_cache_prefetch,
+      flags.executable_cache_max_size, flags.executable_cache_remote_path);
+  return *cache;
+}
+
+void ExecutableCache::PrefetchAll() {
+  std::vector<std::string> files;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& file : files_) {
+      files.push_back(file.first);
+    }
+  }
+  for (const std::string& file : files) {
+    // Prefetching a file does not count as using it.
+    auto mapped = Map(file);
+    if (mapped.ok()) {
+      mapped.ValueOrDie()->WillNeed();
+    }
+  }
+}
+
+bool ExecutableCache::Contains(const std::string& filename) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (files_.contains(filename)) {
+      return true;
+    }
+  }
+  // The file might have been added by another process since the directory
+  // was indexed.
+  if (tensorflow::Env::Default()->FileExists(filename).ok()) {
+    Add(filename);
+    return true;
+  }
+  return FetchFromRemote(filename);
+}
+
+void ExecutableCache::Add(const std::string& filename) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  uint64 size = 0;
+  env->GetFileSize(filename, &size).IgnoreError();
+
+  std::lock_guard<std::mutex> lock(mu_);
+  files_[filename] = CachedFile{static_cast<int64>(size), env->NowMicros()};
+  // Make sure a stale mapping is not used if the file was replaced.
+  mapped_.erase(filename);
+}
+
+/* static */ std::string ExecutableCache::TemporaryFilename(
+    const std::string& filename) {
+  static std::atomic<uint64> counter(0);
+  return absl::StrCat(filename, ".tmp.", getpid(), ".", counter++);
+}
+
+Status ExecutableCache::Publish(const std::string& temporary_filename,
+                                const std::string& filename) {
+  TF_RETURN_IF_ERROR(
+      tensorflow::Env::Default()->RenameFile(temporary_filename, filename));
+  Add(filename);
+  AddToRemote(filename);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  EvictLocked(filename);
+  return Status::OK();
+}
+
+bool ExecutableCache::FetchFromRemote(const std::string& filename) {
+  if (remote_path_.empty()) {
+    return false;
+  }
+  const std::string remote_filename = tensorflow::io::JoinPath(
+      remote_path_, std::string(tensorflow::io::Basename(filename)));
+  if (!tensorflow::Env::Default()->FileExists(remote_filename).ok()) {
+    return false;
+  }
+
+  Status status = tensorflow::Env::Default()->RecursivelyCreateDir(path_);
+  if (status.ok()) {
+    status = AtomicCopy(remote_filename, filename);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not fetch " << remote_filename
+                 << " from the remote executable cache: "
+                 << status.error_message();
+    return false;
+  }
+  VLOG(1) << "Fetched " << remote_filename
+          << " from the remote executable cache";
+  Add(filename);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  EvictLocked(filename);
+  return true;
+}
+
+void ExecutableCache::AddToRemote(const std::string& filename) {
+  if (remote_path_.empty()) {
+    return;
+  }
+  const std::string remote_filename = tensorflow::io::JoinPath(
+      remote_path_, std::string(tensorflow::io::Basename(filename)));
+  Status status =
+      tensorflow::Env::Default()->RecursivelyCreateDir(remote_path_);
+  if (status.ok()) {
+    status = AtomicCopy(filename, remote_filename);
+  }
+  // The executable is still in the local cache, so this is not an error.
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not add " << filename
+                 << " to the remote executable cache: "
+                 << status.error_message();
+  }
+}
+
+void ExecutableCache::EvictLocked(const std::string& keep) {
+  if (max_size_ <= 0) {
+    return;
+  }
+
+  int64 total_size = 0;
+  std::vector<std::pair<uint64, std::string>> by_last_use;
+  for (const auto& file : files_) {
+    total_size += file.second.size;
+    // The executable of a module has the name of its engine file plus a
+    // suffix, so this keeps both files of the module which was just added.
+    if (!absl::StartsWith(file.first, keep)) {
+      by_last_use.emplace_back(file.second.last_used, file.first);
+    }
+  }
+  absl::c_sort(by_last_use);
+
+  for (const auto& file : by_last_use) {
+    if (total_size <= max_size_) {
+      break;
+    }
+    const std::string& filename = file.second;
+    VLOG(1) << "Removing " << filename << " from the executable cache";
+    // Processes which have the file mapped can still use it.
+    tensorflow::Env::Default()->DeleteFile(filename).IgnoreError();
+    total_size -= files_[filename].size;
+    files_.erase(filename);
+    mapped_.erase(filename);
+  }
+}
+
+StatusOr<std::shared_ptr<const MappedFile>> ExecutableCache::Open(
+    const std::string& filename) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto file = files_.find(filename);
+    if (file != files_.end()) {
+      file->second.last_used = tensorflow::Env::Default()->NowMicros();
+    }
+  }
+  // Update the modification time so that other processes, and this one when
+  // it is restarted, also see that the file was used recently.
+  utimes(filename.c_str(), nullptr);
+  return Map(filename);
+}
+
+StatusOr<std::unique_ptr<ExecutableFileContents>>
+ExecutableCache::OpenExecutable(const std::string& filename) {
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<const MappedFile> mapped,
+                      Open(filename));
+  if (!IsCompressedExecutable(mapped->data(), mapped->size())) {
+    return absl::make_unique<ExecutableFileContents>(std::move(mapped));
+  }
+  std::string decompressed;
+  Status status =
+      DecompressExecutable(mapped->data(), mapped->size(), &decompressed);
+  if (!status.ok()) {
+    return tensorflow::errors::DataLoss("Failed to read ", filename, ": ",
+                                        status.error_message());
+  }
+  return absl::make_unique<ExecutableFileContents>(std::move(decompressed));
+}
+
+StatusOr<std::shared_ptr<const MappedFile>> ExecutableCache::Map(
+    const std::string& filename) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto itr = mapped_.find(filename);
+    if (itr != mapped_.end()) {
+      return itr->second;
+    }
+  }
+
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<const MappedFile> mapped,
+                      MappedFile::Open(filename));
+
+  std::lock_guard<std::mutex> lock(mu_);
+  return mapped_.emplace(filename, std::move(mapped)).first->second;
+}
+
+ExecutableCache::ScopedCompilation::ScopedCompilation(
+    ScopedCompilation&& other)
+    : cache_(other.cache_),
+      name_(std::move(other.name_)),
+      lock_fd_(other.lock_fd_) {
+  other.cache_ = nullptr;
+  other.lock_fd_ = -1;
+}
+
+ExecutableCache::ScopedCompilation::~ScopedCompilation() {
+  if (cache_) {
+    cache_->EndCompilation(name_, lock_fd_);
+  }
+}
+
+ExecutableCache::ScopedCompilation ExecutableCache::BeginCompilation(
+    const std::string& name) {
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (compiling_.contains(name)) {
+      VLOG(1) << "Waiting for another thread to compile " << name;
+      compilation_done_.wait(lock, [&] { return !compiling_.contains(name); });
+    }
+    compiling_.insert(name);
+  }
+
+  // Other processes using the same cache directory wait on a lock file.
+  tensorflow::Env::Default()->RecursivelyCreateDir(path_).IgnoreError();
+  const std::string lock_filename =
+      tensorflow::io::JoinPath(path_, name + ".lock");
+  const int lock_fd = open(lock_filename.c_str(), O_RDWR | O_CREAT, 0644);
+  if (lock_fd < 0) {
+    LOG(WARNING) << "Could not open the executable cache lock file "
+                 << lock_filename << ": " << strerror(errno);
+  } else if (flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+    VLOG(1) << "Waiting for another process to compile " << name;
+    while (flock(lock_fd, LOCK_EX) != 0 && errno == EINTR) {
+    }
+  }
+  return ScopedCompilation(this, name, lock_fd);
+}
+
+void ExecutableCache::EndCompilation(const std::string& name, int lock_fd) {
+  if (lock_fd >= 0) {
+    // Closing the file releases the lock.
+    close(lock_fd);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    compiling_.erase(name);
+  }
+  compilation_done_.notify_all();
+}
+
+int64 ExecutableCache::NumIndexedFiles() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return files_.size();
+}
+
+int64 ExecutableCache::TotalSize() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  int64 total_size = 0;
+  for (const auto& file : files_) {
+    total_size += file.second.size;
+  }
+  return total_size;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
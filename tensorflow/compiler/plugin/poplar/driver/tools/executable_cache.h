@@ -0,0 +1,223 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_EXECUTABLE_CACHE_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_EXECUTABLE_CACHE_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// A read only memory mapping of a file.
+class MappedFile {
+ public:
+  static StatusOr<std::shared_ptr<const MappedFile>> Open(
+      const std::string& path);
+  ~MappedFile();
+
+  const char* data() const { return static_cast<const char*>(data_); }
+  std::size_t size() const { return size_; }
+
+  // Asks the kernel to start reading the whole file into the page cache.
+  void WillNeed() const;
+
+ private:
+  MappedFile(void* data, std::size_t size) : data_(data), size_(size) {}
+
+  void* data_;
+  std::size_t size_;
+};
+
+// A std::streambuf reading from memory, so that memory mapped files can be
+// passed to the APIs which read from a std::istream without copying them.
+class MemoryStreamBuf : public std::streambuf {
+ public:
+  MemoryStreamBuf(const char* data, std::size_t size);
+
+ protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+// The uncompressed contents of a cached executable. Uncompressed files are
+// read through their memory mapping, compressed files are decompressed into a
+// buffer owned by this object.
+class ExecutableFileContents {
+ public:
+  explicit ExecutableFileContents(std::shared_ptr<const MappedFile> mapped)
+      : mapped_(std::move(mapped)),
+        data_(mapped_->data()),
+        size_(mapped_->size()) {}
+  explicit ExecutableFileContents(std::string decompressed)
+      : decompressed_(std::move(decompressed)),
+        data_(decompressed_.data()),
+        size_(decompressed_.size()) {}
+
+  ExecutableFileContents(const ExecutableFileContents&) = delete;
+  ExecutableFileContents& operator=(const ExecutableFileContents&) = delete;
+
+  const char* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  std::shared_ptr<const MappedFile> mapped_;
+  std::string decompressed_;
+  const char* data_;
+  std::size_t size_;
+};
+
+// Executables can be stored compressed in the cache. They are split into
+// chunks which are compressed with Snappy, so that they are compressed and
+// decompressed by several threads at the same time.
+constexpr std::size_t kExecutableCompressionChunkSize = 16 << 20;
+
+// Compresses `data` into `output`. Fails if Snappy is not available.
+Status CompressExecutable(
+    const std::string& data, std::string* output,
+    std::size_t chunk_size = kExecutableCompressionChunkSize);
+
+// Returns true if the data was written by CompressExecutable.
+bool IsCompressedExecutable(const char* data, std::size_t size);
+
+// Decompresses the data written by CompressExecutable into `output`.
+Status DecompressExecutable(const char* data, std::size_t size,
+                            std::string* output);
+
+// Process wide index of the executable cache directory.
+//
+// The directory is listed once when the cache is first used, instead of
+// checking for the files of every module, and the cached executables are
+// memory mapped instead of being read through a stream. When prefetching is
+// enabled all the cached executables are mapped in a background thread and
+// read ahead into the page cache, so that loading a module only waits for the
+// parts of its file which have not been read yet.
+//
+// The file names are derived from the hash of the module, the device target
+// and the compilation options, so the cache can be shared between processes
+// and hosts:
+//  * Files are written to a temporary file and renamed into place, so a
+//    partially written executable is never read.
+//  * A module is only compiled once when several threads or processes compile
+//    it at the same time - the others wait for a lock file in the cache
+//    directory and then load it from the cache.
+//  * When a remote path (for example on NFS or GCS) is given, executables
+//    which are not in the local cache are fetched from it and compiled
+//    executables are added to it.
+//  * When a maximum size is given, the least recently used files are removed
+//    once the files known to this process grow larger than it.
+//
+// This class is thread safe.
+class ExecutableCache {
+ public:
+  ExecutableCache(const std::string& path, bool prefetch, int64 max_size = 0,
+                  const std::string& remote_path = "");
+  ~ExecutableCache();
+
+  // The cache for the executable_cache_* flags.
+  static ExecutableCache& Get();
+
+  // Returns true if the file is in the cache directory, fetching it from the
+  // remote cache if it is only there.
+  bool Contains(const std::string& filename);
+
+  // Records that a file has been added to the cache directory.
+  void Add(const std::string& filename);
+
+  // Returns a unique name for a temporary file which will be published as
+  // `filename`.
+  static std::string TemporaryFilename(const std::string& filename);
+
+  // Atomically moves `temporary_filename` to `filename` in the cache directory
+  // and adds it to the remote cache. Other files are removed from the cache if
+  // it is now larger than the maximum size.
+  Status Publish(const std::string& temporary_filename,
+                 const std::string& filename);
+
+  // Returns the mapping of a file in the cache directory.
+  StatusOr<std::shared_ptr<const MappedFile>> Open(const std::string& filename);
+
+  // Returns the uncompressed contents of an executable in the cache directory,
+  // which can have been written compressed or not.
+  StatusOr<std::unique_ptr<ExecutableFileContents>> OpenExecutable(
+      const std::string& filename);
+
+  // Marks the module as being compiled by the calling thread until the object
+  // is destroyed.
+  class ScopedCompilation {
+   public:
+    ScopedCompilation(ScopedCompilation&& other);
+    ~ScopedCompilation();
+
+   private:
+    friend class ExecutableCache;
+    ScopedCompilation(ExecutableCache* cache, const std::string& name,
+                      int lock_fd)
+        : cache_(cache), name_(name), lock_fd_(lock_fd) {}
+
+    ExecutableCache* cache_;
+    std::string name_;
+    int lock_fd_;
+  };
+
+  // Waits until no other thread or process is compiling the module with the
+  // given name and marks it as being compiled by the calling thread.
+  ScopedCompilation BeginCompilation(const std::string& name);
+
+  int64 NumIndexedFiles() const;
+  int64 TotalSize() const;
+
+ private:
+  struct CachedFile {
+    int64 size;
+    // Microseconds since the epoch.
+    uint64 last_used;
+  };
+
+  StatusOr<std::shared_ptr<const MappedFile>> Map(const std::string& filename);
+  void PrefetchAll();
+  void EndCompilation(const std::string& name, int lock_fd);
+  bool FetchFromRemote(const std::string& filename);
+  void AddToRemote(const std::string& filename);
+  void EvictLocked(const std::string& keep);
+
+  const std::string path_;
+  const int64 max_size_;
+  const std::string remote_path_;
+
+  mutable std::mutex mu_;
+  absl::flat_hash_map<std::string, CachedFile> files_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const MappedFile>> mapped_;
+  absl::flat_hash_set<std::string> compiling_;
+  std::condition_variable compilation_done_;
+
+  std::unique_ptr<tensorflow::Thread> prefetch_thread_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_EXECUTABLE_CACHE_H_
@@ -18,6 +18,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include <poplar/CycleCount.hpp>
 #include <poplar/Graph.hpp>
 #include <poplar/Program.hpp>
 #include <poplar/Tensor.hpp>
@@ -26,6 +27,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 
@@ -171,5 +173,33 @@ const std::vector<bool>& ExecutionCounters::GetLiveCounters() const {
 
 bool ExecutionCounters::Initialized() const { return initialized_; }
 
+Status AddInstructionCycleCounter(CompilerResources& resources,
+                                  const HloInstruction* inst, unsigned tile,
+                                  poplar::program::Sequence& sequence) {
+  poplar::Graph& graph = GetMasterGraph(resources);
+  const std::string name = absl::StrCat(inst->name(), "/InstructionCycles");
+  poplar::Tensor& total = resources.instruction_cycle_counters[inst->name()];
+  if (!total.valid()) {
+    total = graph.addVariable(poplar::UNSIGNED_INT, {2}, name + "/Total");
+    graph.setTileMapping(total, tile);
+  }
+
+  // The cycles are the low and high words of a 64 bit value.
+  poplar::Tensor cycles =
+      poplar::cycleCount(graph, sequence, tile, name + "/Count");
+
+  // Add the high words and the carry of the low words before updating the low
+  // word of the total.
+  namespace pe = popops::expr;
+  popops::mapInPlace(
+      graph,
+      pe::Add(pe::Add(pe::_1, pe::_2),
+              pe::Cast(pe::Lt(pe::Add(pe::_3, pe::_4), pe::_4),
+                       poplar::UNSIGNED_INT)),
+      {total[1], cycles[1], total[0], cycles[0]}, sequence, name + "/High");
+  popops::addInPlace(graph, total[0], cycles[0], sequence, name + "/Low");
+  return Status::OK();
+}
+
 }  // namespace poplarplugin
 }  // namespace xla
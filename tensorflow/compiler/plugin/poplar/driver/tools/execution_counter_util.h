@@ -143,6 +143,14 @@ Status CopyExecutionCountersFromScope(CompilerResources& resources,
                                       ExecutionCounters& counters,
                                       poplar::program::Sequence& sequence);
 
+// Count the cycles `sequence` takes on `tile` and add them to the cycle
+// counter of `inst` in `resources.instruction_cycle_counters`, which is
+// created on its first use. The counter is a 64 bit value stored as two 32 bit
+// words, which sums the cycles of all the executions of `inst`.
+Status AddInstructionCycleCounter(CompilerResources& resources,
+                                  const HloInstruction* inst, unsigned tile,
+                                  poplar::program::Sequence& sequence);
+
 }  // namespace poplarplugin
 }  // namespace xla
 
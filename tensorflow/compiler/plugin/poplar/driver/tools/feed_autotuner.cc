@@ -0,0 +1,190 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_autotuner.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include "include/json/json.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// An increase has to remove at least this fraction of the stalls to be kept.
+constexpr double kMinStallReduction = 0.1;
+}  // namespace
+
+FeedAutotuner::TunedValue::TunedValue(int64_t value, int64_t max_value)
+    : value_(value), max_value_(max_value) {}
+
+void FeedAutotuner::TunedValue::Observe(int64_t compiled_value,
+                                        uint64_t stalled_nanos,
+                                        uint64_t observed_nanos,
+                                        const FeedAutotunerOptions& options) {
+  // The graph has not been compiled with the current value yet.
+  if (converged_ || compiled_value != value_) {
+    return;
+  }
+
+  stalled_nanos_ += stalled_nanos;
+  observed_nanos_ += observed_nanos;
+  if (++executions_ < std::max<int64_t>(1, options.executions_per_trial)) {
+    return;
+  }
+
+  const double stall_fraction =
+      observed_nanos_ ? static_cast<double>(stalled_nanos_) / observed_nanos_
+                      : 0.0;
+  last_stall_fraction_ = stall_fraction;
+  executions_ = 0;
+  stalled_nanos_ = 0;
+  observed_nanos_ = 0;
+
+  if (previous_stall_fraction_ >= 0.0 &&
+      stall_fraction >
+          previous_stall_fraction_ * (1.0 - kMinStallReduction)) {
+    // The last increase did not help, so it is not worth its memory.
+    value_ = previous_value_;
+    converged_ = true;
+  } else if (stall_fraction <= options.stall_threshold ||
+             value_ >= max_value_) {
+    converged_ = true;
+  } else {
+    previous_value_ = value_;
+    previous_stall_fraction_ = stall_fraction;
+    value_ = std::min(2 * value_, max_value_);
+  }
+}
+
+void FeedAutotuner::SetOptions(const FeedAutotunerOptions& options) {
+  std::lock_guard<std::mutex> l(mutex_);
+  options_ = options;
+}
+
+/* static */ void FeedAutotuner::Record(
+    std::map<std::string, TunedValue>& values, const std::string& feed_id,
+    int64_t compiled_value, int64_t max_value, uint64_t blocked_nanos,
+    int64_t num_queues, uint64_t execution_nanos,
+    const FeedAutotunerOptions& options) {
+  auto itr = values.find(feed_id);
+  if (itr == values.end()) {
+    // The first execution of the feed was compiled with the user's value.
+    itr = values
+              .emplace(feed_id, TunedValue(compiled_value,
+                                           std::max(compiled_value, max_value)))
+              .first;
+  }
+  // The queues of the feed are used at the same time, so the stalls are
+  // averaged over them.
+  itr->second.Observe(compiled_value,
+                      blocked_nanos / std::max<int64_t>(1, num_queues),
+                      execution_nanos, options);
+}
+
+void FeedAutotuner::RecordInfeedExecution(const PoplarFeedConfig& config,
+                                          const SPSCQueueStats& stats,
+                                          int64_t num_queues,
+                                          uint64_t execution_nanos) {
+  if (!IsTunedInfeed(config)) {
+    return;
+  }
+  std::lock_guard<std::mutex> l(mutex_);
+  Record(prefetch_depths_, config.feed_id(),
+         std::max<int64_t>(1, config.prefetch_depth()),
+         config.max_prefetch_depth(), stats.pop_blocked_nanos, num_queues,
+         execution_nanos, options_);
+}
+
+void FeedAutotuner::RecordOutfeedExecution(const PoplarFeedConfig& config,
+                                           const SPSCQueueStats& stats,
+                                           int64_t num_queues,
+                                           uint64_t execution_nanos) {
+  if (!IsTunedOutfeed(config)) {
+    return;
+  }
+  std::lock_guard<std::mutex> l(mutex_);
+  Record(io_batch_sizes_, config.feed_id(),
+         std::max<int64_t>(1, config.io_batch_size()),
+         config.max_io_batch_size(), stats.push_blocked_nanos, num_queues,
+         execution_nanos, options_);
+}
+
+PoplarFeedConfig FeedAutotuner::TunedInfeedConfig(
+    const PoplarFeedConfig& config) const {
+  PoplarFeedConfig tuned = config;
+  std::lock_guard<std::mutex> l(mutex_);
+  auto itr = prefetch_depths_.find(config.feed_id());
+  if (IsTunedInfeed(config) && itr != prefetch_depths_.end()) {
+    tuned.set_prefetch_depth(itr->second.value());
+  }
+  return tuned;
+}
+
+PoplarFeedConfig FeedAutotuner::TunedOutfeedConfig(
+    const PoplarFeedConfig& config) const {
+  PoplarFeedConfig tuned = config;
+  std::lock_guard<std::mutex> l(mutex_);
+  auto itr = io_batch_sizes_.find(config.feed_id());
+  if (IsTunedOutfeed(config) && itr != io_batch_sizes_.end()) {
+    tuned.set_io_batch_size(itr->second.value());
+  }
+  return tuned;
+}
+
+/* static */ bool FeedAutotuner::IsTunedInfeed(const PoplarFeedConfig& config) {
+  return config.max_prefetch_depth() > 0;
+}
+
+/* static */ bool FeedAutotuner::IsTunedOutfeed(
+    const PoplarFeedConfig& config) {
+  // With a reduction the io batch size changes the values which are sent to
+  // the host, so it is never tuned.
+  return config.max_io_batch_size() > 0 &&
+         config.reduction() == PoplarFeedConfig::NoReduction;
+}
+
+std::string FeedAutotuner::ToJson() const {
+  auto to_json = [](const TunedValue& value) {
+    Json::Value json;
+    json["value"] = Json::Int64(value.value());
+    json["max_value"] = Json::Int64(value.max_value());
+    json["converged"] = value.converged();
+    if (value.last_stall_fraction() >= 0.0) {
+      json["stall_fraction"] = value.last_stall_fraction();
+    }
+    return json;
+  };
+
+  Json::Value root(Json::objectValue);
+  std::lock_guard<std::mutex> l(mutex_);
+  for (auto& pair : prefetch_depths_) {
+    root[pair.first]["prefetch_depth"] = to_json(pair.second);
+  }
+  for (auto& pair : io_batch_sizes_) {
+    root[pair.first]["io_batch_size"] = to_json(pair.second);
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  std::stringstream ss;
+  std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+  writer->write(root, &ss);
+  return ss.str();
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
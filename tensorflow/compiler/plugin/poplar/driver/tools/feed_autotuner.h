@@ -0,0 +1,126 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_AUTOTUNER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_AUTOTUNER_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "tensorflow/compiler/plugin/poplar/driver/poplar_feed_config.pb.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_queue.h"
+
+namespace xla {
+namespace poplarplugin {
+
+struct FeedAutotunerOptions {
+  // Number of executions which are observed before each adjustment.
+  int64_t executions_per_trial = 4;
+  // Fraction of the execution time the device can be stalled on the queues of
+  // a feed before its value is increased.
+  double stall_threshold = 0.05;
+};
+
+// Tunes the prefetch depth of the infeeds and the io batch size of the
+// outfeeds which have a `max_prefetch_depth` or a `max_io_batch_size` in their
+// config. The time the device is stalled on the host queues of a feed is
+// observed for a number of executions, and while it is above the threshold
+// the value is doubled, up to the maximum. When a doubling does not reduce the
+// stalls the previous value is restored and the feed is not tuned any further.
+//
+// Both values are compiled into the graph, so a tuned value is only used when
+// a graph with the feed is compiled again, and the executions of graphs which
+// were compiled with a different value are not observed.
+//
+// The executor records the observations and the compiler reads the tuned
+// values, possibly from different threads, so the methods are thread safe.
+class FeedAutotuner {
+ public:
+  FeedAutotuner() = default;
+
+  void SetOptions(const FeedAutotunerOptions& options);
+
+  // Records the queue counters of a feed during one execution which took
+  // `execution_nanos`. The counters are summed over the `num_queues` queues of
+  // the feed. For an infeed the device waits on an empty queue, for an outfeed
+  // it waits on a full queue.
+  void RecordInfeedExecution(const PoplarFeedConfig& config,
+                             const SPSCQueueStats& stats, int64_t num_queues,
+                             uint64_t execution_nanos);
+  void RecordOutfeedExecution(const PoplarFeedConfig& config,
+                              const SPSCQueueStats& stats, int64_t num_queues,
+                              uint64_t execution_nanos);
+
+  // Returns the config with the tuned prefetch depth or io batch size.
+  PoplarFeedConfig TunedInfeedConfig(const PoplarFeedConfig& config) const;
+  PoplarFeedConfig TunedOutfeedConfig(const PoplarFeedConfig& config) const;
+
+  // Whether a feed is tuned at all.
+  static bool IsTunedInfeed(const PoplarFeedConfig& config);
+  static bool IsTunedOutfeed(const PoplarFeedConfig& config);
+
+  // Returns the state of each tuned feed as a JSON object keyed by feed id.
+  std::string ToJson() const;
+
+ private:
+  class TunedValue {
+   public:
+    TunedValue(int64_t value, int64_t max_value);
+
+    // Observes an execution of a graph compiled with `compiled_value`.
+    void Observe(int64_t compiled_value, uint64_t stalled_nanos,
+                 uint64_t observed_nanos, const FeedAutotunerOptions& options);
+
+    int64_t value() const { return value_; }
+    int64_t max_value() const { return max_value_; }
+    bool converged() const { return converged_; }
+    double last_stall_fraction() const { return last_stall_fraction_; }
+
+   private:
+    int64_t value_;
+    const int64_t max_value_;
+    // The value and stall fraction before the last increase.
+    int64_t previous_value_ = 0;
+    double previous_stall_fraction_ = -1.0;
+    double last_stall_fraction_ = -1.0;
+    bool converged_ = false;
+
+    // The current trial.
+    int64_t executions_ = 0;
+    uint64_t stalled_nanos_ = 0;
+    uint64_t observed_nanos_ = 0;
+  };
+
+  static void Record(std::map<std::string, TunedValue>& values,
+                     const std::string& feed_id, int64_t compiled_value,
+                     int64_t max_value, uint64_t blocked_nanos,
+                     int64_t num_queues, uint64_t execution_nanos,
+                     const FeedAutotunerOptions& options);
+
+  mutable std::mutex mutex_;
+  FeedAutotunerOptions options_;
+  std::map<std::string, TunedValue> prefetch_depths_;
+  std::map<std::string, TunedValue> io_batch_sizes_;
+
+  FeedAutotuner(const FeedAutotuner&) = delete;
+  FeedAutotuner& operator=(const FeedAutotuner&) = delete;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_AUTOTUNER_H_
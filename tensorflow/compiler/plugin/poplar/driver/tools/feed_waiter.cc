@@ -0,0 +1,36 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_waiter.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace xla {
+namespace poplarplugin {
+
+void FeedWaiter::ResetStats() {
+  spin_nanos_ = 0;
+  yield_nanos_ = 0;
+  parked_nanos_ = 0;
+  park_count_ = 0;
+}
+
+std::string FeedWaiter::StatsString() const {
+  return absl::StrCat("spinning: ", SpinNanos() / 1000, "us, yielding: ",
+                      YieldNanos() / 1000, "us, parked: ", ParkedNanos() / 1000,
+                      "us (", ParkCount(), " times)");
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
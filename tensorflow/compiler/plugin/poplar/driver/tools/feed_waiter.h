@@ -0,0 +1,151 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_WAITER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_WAITER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace xla {
+namespace poplarplugin {
+
+// Options controlling how a FeedWaiter waits for a condition.
+struct FeedWaitOptions {
+  // When false, the waiter busy waits on the condition.
+  bool adaptive = false;
+  // Number of times the condition is polled before yielding the thread.
+  int64_t spin_count = 1000;
+  // Number of times the thread is yielded before it is parked.
+  int64_t yield_count = 100;
+  // How long a parked thread sleeps before re-checking for cancellation.
+  std::chrono::microseconds park_timeout = std::chrono::milliseconds(1);
+};
+
+// A helper used by the IO threads to wait for the infeed/outfeed queues to
+// make progress without burning a host core.
+// The waiting thread spins, then yields, and finally parks on a condition
+// variable. The thread which makes progress on the queue calls `Notify`, which
+// is a single atomic load when no thread is parked.
+class FeedWaiter {
+ public:
+  FeedWaiter() = default;
+
+  // Wake up any threads parked in `Wait`.
+  void Notify() {
+    if (num_parked_.load(std::memory_order_seq_cst)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  // Blocks until `ready()` returns true or `cancelled` is set. Returns the
+  // value of the last `ready()` call.
+  template <typename ReadyFn>
+  bool Wait(const FeedWaitOptions& options, const std::atomic<bool>& cancelled,
+            ReadyFn ready);
+
+  // Time (in nanoseconds) spent in each of the waiting phases.
+  uint64_t SpinNanos() const { return spin_nanos_; }
+  uint64_t YieldNanos() const { return yield_nanos_; }
+  uint64_t ParkedNanos() const { return parked_nanos_; }
+  // Number of times the waiting thread was parked.
+  uint64_t ParkCount() const { return park_count_; }
+
+  void ResetStats();
+
+  std::string StatsString() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  void AddTime(std::atomic<uint64_t>& counter, Clock::time_point start,
+               Clock::time_point end) {
+    counter += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                   .count();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<int64_t> num_parked_{0};
+
+  std::atomic<uint64_t> spin_nanos_{0};
+  std::atomic<uint64_t> yield_nanos_{0};
+  std::atomic<uint64_t> parked_nanos_{0};
+  std::atomic<uint64_t> park_count_{0};
+
+  FeedWaiter(const FeedWaiter&) = delete;
+  FeedWaiter& operator=(const FeedWaiter&) = delete;
+};
+
+template <typename ReadyFn>
+bool FeedWaiter::Wait(const FeedWaitOptions& options,
+                      const std::atomic<bool>& cancelled, ReadyFn ready) {
+  if (ready()) {
+    return true;
+  }
+
+  auto start = Clock::now();
+  // Spin phase - when not adaptive, keep spinning until ready or cancelled.
+  for (int64_t i = 0; !options.adaptive || i < options.spin_count; ++i) {
+    if (ready()) {
+      AddTime(spin_nanos_, start, Clock::now());
+      return true;
+    }
+    if (cancelled) {
+      AddTime(spin_nanos_, start, Clock::now());
+      return false;
+    }
+  }
+  auto now = Clock::now();
+  AddTime(spin_nanos_, start, now);
+  start = now;
+
+  // Yield phase.
+  for (int64_t i = 0; i < options.yield_count; ++i) {
+    std::this_thread::yield();
+    if (ready() || cancelled) {
+      AddTime(yield_nanos_, start, Clock::now());
+      return ready();
+    }
+  }
+  now = Clock::now();
+  AddTime(yield_nanos_, start, now);
+  start = now;
+
+  // Park phase - the number of parked threads is incremented before the
+  // condition is re-checked so that a concurrent `Notify` can't be missed.
+  park_count_++;
+  bool result;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    num_parked_.fetch_add(1, std::memory_order_seq_cst);
+    while (!(result = ready()) && !cancelled) {
+      cv_.wait_for(lock, options.park_timeout);
+    }
+    num_parked_.fetch_sub(1, std::memory_order_seq_cst);
+  }
+  AddTime(parked_nanos_, start, Clock::now());
+  return result;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_FEED_WAITER_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hash.h"
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/strip.h"
@@ -42,6 +43,14 @@ absl::flat_hash_map<std::string, std::string> GetFlagUsage() {
        "initialized directly on the IPU either randomly "
        "(synthetic_data_initializer=random, uniform, normal) or to a constant "
        "value X (synthetic_data_initializer=int)."},
+      {"synthetic_data_categories",
+       "If set when using synthetic data, only the data of the given kinds is "
+       "synthetic, the others are transferred between the host and the "
+       "IPU(s). A comma separated list of infeed, outfeed, parameters, seed "
+       "and hostembedding."},
+      {"synthetic_data_feeds",
+       "If set when using synthetic data, only the infeeds and outfeeds with "
+       "the given names are synthetic. A comma separated list of feed names."},
       {"use_ipu_model",
        "If enabled, this computation will be executed on the IPU model. "
        "(bool)"},
@@ -51,19 +60,84 @@ absl::flat_hash_map<std::string, std::string> GetFlagUsage() {
        "This may be used as an alternative to profiling for graphs with "
        "dynamic control flow. "
        "(int=-1)"},
+      {"log_pipeline_cycle_count",
+       "The tile to count the cycles of the ramp up, the repeat block and the "
+       "ramp down of pipelines on, from which the fraction of the pipeline "
+       "execution which is spent filling and draining the pipeline is logged. "
+       "No counting will be done if negative. (int=-1)"},
+      {"log_instruction_cycle_count",
+       "The tile to count the cycles of each instruction on, which are summed "
+       "over the executions of the instruction and logged after each "
+       "execution of the graph. The cycles of an instruction include those "
+       "of the computations it calls. No counting will be done if negative. "
+       "(int=-1)"},
+      {"log_pipeline_stage_balance",
+       "Log the estimated number of cycles of each pipeline stage, the "
+       "fraction of time the IPUs are idle because the stages are not "
+       "balanced and how to move the stage boundaries to balance them. "
+       "(bool)"},
+      {"pipeline_cost_model_calibration",
+       "Scale for the estimated number of cycles of the pipeline stages. It "
+       "can be set to the cycle count logged with log_cycle_count divided by "
+       "the estimated number of cycles for the same model. (float=1.0)"},
+      {"recomputation_memory_target",
+       "When recomputation is enabled, the number of bytes which can be live "
+       "on each IPU before instructions are recomputed. The instructions "
+       "which are recomputed are chosen to recompute the fewest estimated "
+       "cycles. 0 uses the default recomputation suggestions. (int=0)"},
+      {"remote_buffer_offload_idle_instructions",
+       "Store the intermediate values which are at least as large as the "
+       "minimum remote tensor size in remote memory while they are not used "
+       "for at least this many instructions, if that lowers the estimated "
+       "peak memory. 0 disables the offloading. (int=0)"},
+      {"multi_update_deduplication_ratio",
+       "Sort the indices of the multi-update-add instructions, such as the "
+       "embedding gradients, and add together the updates of the same index "
+       "on the device so that each row is updated once. It is used for the "
+       "instructions with at least this many updates for each row of the "
+       "updated tensor, where duplicated indices are likely. 0 disables the "
+       "deduplication. (float=0.0)"},
+      {"tile_imbalance_rebalance_ratio",
+       "Copy the operands of the instructions whose busiest tile holds more "
+       "than this many times the elements it would hold if the operand was "
+       "spread evenly over the tiles, for example when no layout could be "
+       "found for them, to a linear mapping before they are used. The "
+       "rebalanced tensors and the memory saved on their busiest tiles are "
+       "added to the compilation report. 0 disables the rebalancing. "
+       "(float=0.0)"},
+      {"tile_memory_aware_scheduling",
+       "Schedule for the estimated memory used on the busiest IPU tile, taking "
+       "the padding of the tensors mapped onto each tile into account, rather "
+       "than the number of bytes of the HLO buffers. (bool)"},
       {"while_loop_brute_force_max_trip_count",
        "When trying to convert a while loop to a repeat loop, we can try and "
        "use a brute force method to simulate the conditional part of the while "
        "and find the number of iterations. This flag sets how many iterations "
        "of the while loop we should try and brute force it for. (int=128)"},
+      {"constant_folding_max_elements",
+       "Don't constant fold the instructions for which the evaluator would "
+       "have to process more than this many elements, such as large dots. 0 "
+       "folds instructions of any size. (int=0)"},
       {"max_compilation_threads",
        "The maximum number of threads Poplar should use during compilation of "
        "the graph. Negative value allows Poplar to pick the number of threads "
        "automatically. (int=-1)"},
+      {"low_memory_compilation",
+       "Release the lowered sub-computations and their tensor maps once all "
+       "their callers have been lowered, to reduce the peak host memory used "
+       "by the compilation of large models. (bool)"},
       {"max_infeed_threads",
        "The maximum number of threads which each infeed queue is allowed to "
        "use when accessing data from datasets. Negative value allows the "
        "infeed to automatically pick the number of threads. (int=-1)"},
+      {"max_host_embedding_threads",
+       "The maximum number of threads which each host embedding is allowed "
+       "to use for the lookups and updates. Negative value uses all the "
+       "available cores. (int=-1)"},
+      {"infeed_replica_groups",
+       "The number of groups of replicas for which the infeed data is "
+       "enqueued by separate threads. It is limited by the replication factor "
+       "and by max_infeed_threads. (int=1)"},
       {"save_vertex_graph",
        "Path to a directory where the Poplar vertex graphs should be saved to. "
        "(path)"},
@@ -71,10 +145,38 @@ absl::flat_hash_map<std::string, std::string> GetFlagUsage() {
        "Path to a directory where the Poplar interval reports should be saved "
        "to. (path)"},
       {"executable_cache_path", "Path to the executable cache. (path)"},
+      {"executable_cache_prefetch",
+       "Read all the executables in the executable cache in the background "
+       "when the IPU system is configured. (bool)"},
+      {"executable_cache_max_size",
+       "Maximum size of the executable cache in bytes, the least recently "
+       "used executables are removed from it. 0 means no limit. (int=0)"},
+      {"executable_cache_remote_path",
+       "Path to a directory shared between hosts which executables are "
+       "fetched from and added to after they are compiled. (path)"},
+      {"executable_cache_compression",
+       "Compress the executables which are added to the executable cache. "
+       "(bool)"},
       {"dump_schedule_as_dot", "Dumps the scheduler graph as a dot file."},
       {"tensor_map_file_path", "Directory for tensor map dump files."},
       {"null_data_feed",
        "Don't provide data to an infeed, for performance measurement."},
+      {"infeed_allocator_max_cached_bytes",
+       "The maximum number of bytes the infeed allocator keeps for reuse by "
+       "subsequent allocations. (int=1073741824)"},
+      {"infeed_allocator_huge_pages",
+       "Request transparent huge pages for large infeed buffers. (bool)"},
+      {"infeed_allocator_lock_memory",
+       "Lock the infeed buffers into RAM so that they are never paged out. "
+       "(bool)"},
+      {"infeed_copy_threads",
+       "The number of threads, including the stream callback thread, which "
+       "copy infeed elements of at least 8MB into the buffers transferred to "
+       "the device. 1 copies them on the callback thread only. (int=4)"},
+      {"variable_conversion_threads",
+       "The number of threads which convert the variables moved between the "
+       "host and the device, for example from 64 to 32 bit integers. 1 "
+       "converts them on the executing thread only. (int=4)"},
       {"dump_text_reports_to_stdio",
        "If profiling is enabled, write a text copy of the profile to the "
        "standard output stream."},
@@ -104,20 +206,44 @@ PoplarXlaFlags::PoplarXlaFlags() {
       // clang-format off
     ADD_FLAG(help)
     ADD_FLAG(use_synthetic_data)
+    ADD_FLAG(synthetic_data_categories)
+    ADD_FLAG(synthetic_data_feeds)
     ADD_FLAG(synthetic_data_initializer)
     ADD_FLAG(use_ipu_model)
     ADD_FLAG(log_cycle_count)
+    ADD_FLAG(log_pipeline_cycle_count)
+    ADD_FLAG(log_instruction_cycle_count)
+    ADD_FLAG(log_pipeline_stage_balance)
+    ADD_FLAG(pipeline_cost_model_calibration)
+    ADD_FLAG(recomputation_memory_target)
+    ADD_FLAG(remote_buffer_offload_idle_instructions)
+    ADD_FLAG(multi_update_deduplication_ratio)
+    ADD_FLAG(tile_imbalance_rebalance_ratio)
+    ADD_FLAG(tile_memory_aware_scheduling)
     ADD_FLAG(while_loop_brute_force_max_trip_count)
+    ADD_FLAG(constant_folding_max_elements)
     ADD_FLAG(max_compilation_threads)
+    ADD_FLAG(low_memory_compilation)
     ADD_FLAG(max_infeed_threads)
+    ADD_FLAG(max_host_embedding_threads)
+    ADD_FLAG(infeed_replica_groups)
     ADD_FLAG(save_vertex_graph)
     ADD_FLAG(save_interval_report)
     ADD_FLAG(executable_cache_path)
+    ADD_FLAG(executable_cache_prefetch)
+    ADD_FLAG(executable_cache_max_size)
+    ADD_FLAG(executable_cache_remote_path)
+    ADD_FLAG(executable_cache_compression)
     ADD_FLAG(dump_schedule_as_dot)
     ADD_FLAG(tensor_map_file_path)
     ADD_FLAG(fallback_scheduler)
     ADD_FLAG(allow_nans)
     ADD_FLAG(null_data_feed)
+    ADD_FLAG(infeed_allocator_max_cached_bytes)
+    ADD_FLAG(infeed_allocator_huge_pages)
+    ADD_FLAG(infeed_allocator_lock_memory)
+    ADD_FLAG(infeed_copy_threads)
+    ADD_FLAG(variable_conversion_threads)
     ADD_FLAG(dump_text_reports_to_stdio)
 
     // Deprecated flags.
@@ -142,6 +268,24 @@ PoplarXlaFlags::PoplarXlaFlags() {
                   "in combination with \"use_synthetic_data\".";
   }
 
+  if (!use_synthetic_data &&
+      !(synthetic_data_categories.empty() && synthetic_data_feeds.empty())) {
+    LOG(FATAL) << "The flags \"synthetic_data_categories\" and "
+                  "\"synthetic_data_feeds\" can only be used in combination "
+                  "with \"use_synthetic_data\".";
+  }
+
+  const absl::flat_hash_set<absl::string_view> known_categories = {
+      "infeed", "outfeed", "parameters", "seed", "hostembedding"};
+  for (absl::string_view category :
+       absl::StrSplit(synthetic_data_categories, ',', absl::SkipEmpty())) {
+    if (!known_categories.contains(category)) {
+      LOG(FATAL) << "Unknown synthetic data category \"" << category
+                 << "\", expected one of infeed, outfeed, parameters, seed "
+                    "or hostembedding.";
+    }
+  }
+
   if (deprecated_flags.add_all_reduce_copies) {
     LOG(INFO)
         << "The TensorFlow Poplar flag \"add_all_reduce_copies\" is "
@@ -165,8 +309,14 @@ PoplarXlaFlags::PoplarXlaFlags() {
   // Hash all the flags which affect the graph generation and compilation only.
   hlo_hash =
       hash_util::hash(use_synthetic_data, synthetic_data_initializer,
+                      synthetic_data_categories, synthetic_data_feeds,
                       use_ipu_model, while_loop_brute_force_max_trip_count,
-                      fallback_scheduler, allow_nans, log_cycle_count);
+                      fallback_scheduler, allow_nans, log_cycle_count,
+                      log_pipeline_cycle_count, log_instruction_cycle_count,
+                      multi_update_deduplication_ratio,
+                      tile_imbalance_rebalance_ratio,
+                      remote_buffer_offload_idle_instructions,
+                      constant_folding_max_elements);
 }
 
 const PoplarXlaFlags& PoplarXlaFlags::Get() {
@@ -44,6 +44,16 @@ class PoplarXlaFlags {
   // initialized to the value passed on the IPU.
   std::string synthetic_data_initializer = "";
 
+  // When using synthetic data, a comma separated list of the kinds of data
+  // which are synthetic: infeed, outfeed, parameters, seed and hostembedding.
+  // All of them are synthetic when empty.
+  std::string synthetic_data_categories = "";
+
+  // When using synthetic data, a comma separated list of the names of the
+  // infeeds and outfeeds which are synthetic. All of them are synthetic when
+  // empty.
+  std::string synthetic_data_feeds = "";
+
   // If enabled, this computation will be executed on the IPU model.
   bool use_ipu_model = false;
 
@@ -51,20 +61,78 @@ class PoplarXlaFlags {
   // will be logged (on the specified tile).
   int log_cycle_count = -1;
 
+  // If set to non-negative, the cycle counts for the ramp up, the repeat block
+  // and the ramp down of pipelines will be logged (on the specified tile).
+  int log_pipeline_cycle_count = -1;
+
+  // If set to non-negative, the total cycles of the executions of each
+  // instruction will be counted (on the specified tile) and logged.
+  int log_instruction_cycle_count = -1;
+
+  // Log the estimated number of cycles of each pipeline stage and the fraction
+  // of time the IPUs are idle because the stages are not balanced.
+  bool log_pipeline_stage_balance = false;
+
+  // Scale for the pipeline stage cycle estimates, which can be set to the
+  // cycle count logged by log_cycle_count divided by the estimate.
+  float pipeline_cost_model_calibration = 1.0f;
+
+  // When recomputation is enabled, choose the instructions to recompute so
+  // that the estimated number of bytes live on each IPU stays below this
+  // target. 0 uses the default recomputation suggestions instead.
+  int64 recomputation_memory_target = 0;
+
+  // Move the large intermediate values of the entry computation into remote
+  // memory while they are not used for at least this many instructions, when
+  // that lowers the estimated peak memory. 0 disables the offloading.
+  int64 remote_buffer_offload_idle_instructions = 0;
+
+  // Sort and combine the updates of the multi-update-add instructions which
+  // have at least this many updates for each row of the updated tensor, so
+  // that each row is updated once. 0 disables the deduplication.
+  float multi_update_deduplication_ratio = 0.0f;
+
+  // Copy the operands whose busiest tile holds more than this many times the
+  // elements it would hold if they were spread over the tiles of their IPUs
+  // to a linear mapping before they are used. 0 disables the rebalancing.
+  float tile_imbalance_rebalance_ratio = 0.0f;
+
+  // Choose between the schedules of the scheduling algorithms by the estimated
+  // memory used on each tile, instead of the number of bytes of the HLO
+  // buffers.
+  bool tile_memory_aware_scheduling = false;
+
   // When trying to convert a while loop to a repeat loop, we can try and use a
   // brute force method to simulate the conditional part of the while and find
   // the number of iterations. This flag sets how many iterations of the while
   // loop we should try and brute force it for (default 128).
   int64 while_loop_brute_force_max_trip_count = 128;
 
+  // Don't constant fold the instructions which would take the evaluator more
+  // than this many elements to compute. 0 folds instructions of any size.
+  int64 constant_folding_max_elements = 0;
+
   // The maximum number of threads Poplar should use during compilation of the
   // graph.
   int64 max_compilation_threads = -1;
 
+  // Release the results of lowering the sub-computations as soon as all their
+  // callers have been lowered, instead of keeping them for the reports.
+  bool low_memory_compilation = false;
+
   // The maximum number of threads which each infeed queue is allowed to use
   // when accessing data from datasets.
   int64 max_infeed_threads = -1;
 
+  // The maximum number of threads which each host embedding is allowed to use
+  // for the lookups and updates.
+  int64 max_host_embedding_threads = -1;
+
+  // The number of groups of replicas for which the infeed data is enqueued by
+  // separate threads. When NUMA is available the threads of the groups are
+  // distributed across the NUMA nodes.
+  int64 infeed_replica_groups = 1;
+
   // Path to a directory where the Poplar vertex graph should be saved to.
   std::string save_vertex_graph = "";
 
@@ -74,6 +142,21 @@ class PoplarXlaFlags {
   // Path to the executable cache.
   std::string executable_cache_path = "";
 
+  // Map all the executables in the executable cache in a background thread
+  // when the cache is first used so that loading them is faster.
+  bool executable_cache_prefetch = false;
+
+  // Maximum size of the executable cache in bytes. The least recently used
+  // executables are removed when it grows larger. 0 means no limit.
+  int64 executable_cache_max_size = 0;
+
+  // Path to a directory shared between hosts (for example on NFS or GCS)
+  // which is used as a second tier of the executable cache.
+  std::string executable_cache_remote_path = "";
+
+  // Compress the executables which are added to the executable cache.
+  bool executable_cache_compression = false;
+
   // Path for the tensormap files
   std::string tensor_map_file_path = "";
 
@@ -90,6 +173,24 @@ class PoplarXlaFlags {
   // any real data
   bool null_data_feed = false;
 
+  // The maximum number of bytes the infeed allocator keeps in its free lists
+  // for reuse by subsequent allocations.
+  int64 infeed_allocator_max_cached_bytes = 1LL << 30;
+
+  // Request transparent huge pages for large infeed buffers.
+  bool infeed_allocator_huge_pages = false;
+
+  // Lock the infeed buffers into RAM so that they are never paged out.
+  bool infeed_allocator_lock_memory = false;
+
+  // The number of threads which copy large infeed elements into the Poplar
+  // stream buffers, including the callback thread.
+  int64 infeed_copy_threads = 4;
+
+  // The number of threads which convert the variables moved between the host
+  // and the device into the device or the host format.
+  int64 variable_conversion_threads = 4;
+
   // When set, and profiling is enabled, then a text summary of the profile will
   // be dumped into the standard output, in addition to the normal report
   // processing.
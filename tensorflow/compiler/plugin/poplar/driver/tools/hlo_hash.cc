@@ -14,20 +14,104 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_hash.h"
+#include "tensorflow/compiler/plugin/poplar/driver/backend_config.pb.h"
+#include "tensorflow/compiler/plugin/poplar/driver/pipeline_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hash.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
 
+#include "tensorflow/compiler/xla/service/call_graph.h"
 #include "tensorflow/compiler/xla/service/hlo.pb.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/human_readable_json.h"
 
 #include <map>
 #include <queue>
 
 namespace xla {
 namespace poplarplugin {
+namespace {
+// Clears the options of a pipeline stage which cannot be used by any of the
+// instructions in the stage. Custom calls and fusions are assumed to use both.
+Status ClearUnusedStageOptions(HloInstruction* stage, CallGraph* call_graph,
+                               PipelineStagePoplarConfig* stage_config) {
+  TF_ASSIGN_OR_RETURN(absl::flat_hash_set<HloComputation*> called_in_stage,
+                      GetAllComputationsCalledBy(stage, call_graph));
+  bool uses_convolution_options = false;
+  bool uses_matmul_options = false;
+  for (HloComputation* comp : called_in_stage) {
+    for (HloInstruction* inst : comp->instructions()) {
+      switch (inst->opcode()) {
+        case HloOpcode::kConvolution:
+          uses_convolution_options = true;
+          break;
+        case HloOpcode::kDot:
+          uses_matmul_options = true;
+          break;
+        case HloOpcode::kCustomCall:
+        case HloOpcode::kFusion:
+          uses_convolution_options = true;
+          uses_matmul_options = true;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  if (!uses_convolution_options) {
+    stage_config->clear_convolution_options();
+  }
+  if (!uses_matmul_options) {
+    stage_config->clear_matmul_options();
+  }
+  return Status::OK();
+}
+
+// Returns the PIPELINE_POPLAR_CONFIG attribute of a pipeline with the options
+// which are not used by a stage removed, so that changing them does not change
+// the hash of the module.
+StatusOr<std::string> GetCanonicalPipelinePoplarConfig(
+    HloInstruction* pipeline_op, const std::string& config_json) {
+  PipelinePoplarConfig config;
+  TF_RETURN_IF_ERROR(
+      tensorflow::HumanReadableJsonToProto(config_json, &config));
+
+  TF_ASSIGN_OR_RETURN(PipelineStages stages,
+                      GetPipelineStages(pipeline_op->to_apply(),
+                                        /*validate_stages=*/false));
+  if (static_cast<std::size_t>(config.forward_stages_size()) !=
+          stages.forward.size() ||
+      static_cast<std::size_t>(config.backward_stages_size()) !=
+          stages.backward.size()) {
+    return FailedPrecondition("Pipeline stages do not match the config.");
+  }
+
+  std::unique_ptr<CallGraph> call_graph =
+      CallGraph::Build(pipeline_op->parent()->parent());
+  for (std::size_t i = 0; i != stages.forward.size(); ++i) {
+    TF_RETURN_IF_ERROR(ClearUnusedStageOptions(
+        stages.forward[i], call_graph.get(), config.mutable_forward_stages(i)));
+  }
+  for (std::size_t i = 0; i != stages.backward.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        ClearUnusedStageOptions(stages.backward[i], call_graph.get(),
+                                config.mutable_backward_stages(i)));
+  }
+  if (stages.resource_update) {
+    TF_RETURN_IF_ERROR(ClearUnusedStageOptions(
+        *stages.resource_update, call_graph.get(),
+        config.mutable_resource_update()));
+  }
+
+  std::string canonical_json;
+  TF_RETURN_IF_ERROR(tensorflow::ProtoToHumanReadableJson(
+      config, &canonical_json, /*ignore_accuracy_loss=*/true));
+  return canonical_json;
+}
+}  // namespace
 
 uint64 HloHash::GetHash() {
   if (!performed_hash_) HashModule();
@@ -41,6 +125,7 @@ std::string HloHash::GetProtoStr() {
 
 void HloHash::HashModule() {
   HloModuleProto proto = module_->ToProto();
+  SanitizePipelinePoplarConfigs(&proto);
   SanitizeHloModuleProto(&proto, module_);
 
   tensorflow::SerializeToStringDeterministic(proto, &proto_str_);
@@ -52,6 +137,41 @@ void HloHash::HashModule() {
   performed_hash_ = true;
 }
 
+void HloHash::SanitizePipelinePoplarConfigs(HloModuleProto* proto) {
+  auto pipelines_or = GetPipelines(module_);
+  if (!pipelines_or.ok()) {
+    return;
+  }
+  const std::string attribute_name =
+      FrontendAttributeId_Name(PIPELINE_POPLAR_CONFIG);
+
+  absl::flat_hash_map<int64, std::string> canonical_configs;
+  for (HloInstruction* pipeline_op : pipelines_or.ValueOrDie()) {
+    const auto& attributes = pipeline_op->frontend_attributes().map();
+    auto itr = attributes.find(attribute_name);
+    if (itr == attributes.end()) {
+      continue;
+    }
+    // If the config cannot be made canonical then it is hashed as it is.
+    auto canonical_or =
+        GetCanonicalPipelinePoplarConfig(pipeline_op, itr->second);
+    if (canonical_or.ok()) {
+      canonical_configs[pipeline_op->unique_id()] =
+          canonical_or.ConsumeValueOrDie();
+    }
+  }
+
+  for (auto& computation : *proto->mutable_computations()) {
+    for (auto& instruction : *computation.mutable_instructions()) {
+      auto itr = canonical_configs.find(instruction.id());
+      if (itr != canonical_configs.end()) {
+        (*instruction.mutable_frontend_attributes()->mutable_map())
+            [attribute_name] = itr->second;
+      }
+    }
+  }
+}
+
 void HloHash::SanitizeHloModuleProto(HloModuleProto* proto,
                                      const HloModule* module) {
   // Always force the HloModule id to be 0 and set the name to "hlo_module"
@@ -45,6 +45,7 @@ class HloHash {
   bool performed_hash_ = false;
 
   void HashModule();
+  void SanitizePipelinePoplarConfigs(HloModuleProto*);
   void SanitizeHloModuleProto(HloModuleProto*, const HloModule*);
   uint64 SanitizeHloComputationProto(HloComputationProto*, uint64);
   uint64 SanitizeHloInstructionProto(HloInstructionProto*, uint64);
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_matcher.h"
 
+#include <algorithm>
 #include <queue>
 #include <set>
 #include <stack>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
@@ -296,6 +298,57 @@ bool MatchDAGIsomorphism(
   return false;
 }
 
+// Returns the instructions of the computation in the order they are first
+// visited by a depth first traversal of the operands from the root.
+std::vector<HloInstruction*> GetMatchOrder(HloComputation* computation) {
+  std::vector<HloInstruction*> order;
+  std::stack<HloInstruction*> to_visit;
+  absl::flat_hash_set<HloInstruction*> visited;
+
+  to_visit.push(computation->root_instruction());
+  while (!to_visit.empty()) {
+    HloInstruction* inst = to_visit.top();
+    to_visit.pop();
+    if (!visited.insert(inst).second) {
+      continue;
+    }
+    order.push_back(inst);
+    for (HloInstruction* operand : inst->operands()) {
+      if (!visited.contains(operand)) {
+        to_visit.push(operand);
+      }
+    }
+  }
+  return order;
+}
+
+// Adds the unique ids of the instructions which are at most `distance` operand
+// or user edges away from any of the `seeds` to `ids`.
+void AddNeighbourhoodIds(const std::vector<HloInstruction*>& seeds,
+                         int64 distance, absl::flat_hash_set<int>& ids) {
+  absl::flat_hash_set<HloInstruction*> visited(seeds.begin(), seeds.end());
+  std::vector<HloInstruction*> frontier(visited.begin(), visited.end());
+  for (int64 i = 0; i < distance && !frontier.empty(); i++) {
+    std::vector<HloInstruction*> next_frontier;
+    for (HloInstruction* inst : frontier) {
+      for (HloInstruction* operand : inst->operands()) {
+        if (visited.insert(operand).second) {
+          next_frontier.push_back(operand);
+        }
+      }
+      for (HloInstruction* user : inst->users()) {
+        if (visited.insert(user).second) {
+          next_frontier.push_back(user);
+        }
+      }
+    }
+    frontier = std::move(next_frontier);
+  }
+  for (HloInstruction* inst : visited) {
+    ids.insert(inst->unique_id());
+  }
+}
+
 }  // namespace
 
 // HloMatcherOpcodeTarget
@@ -807,7 +860,8 @@ bool HloMatcher::MatchPatternSingleOutput(HloInstruction* root,
 }
 
 bool HloMatcher::MatchPattern(HloInstruction* root,
-                              const unsigned pattern_idx) {
+                              const unsigned pattern_idx,
+                              absl::flat_hash_set<int>& changed_ids) {
   HloMatcherMatched match(root->parent(), pattern_idx);
   auto& pattern = patterns_[pattern_idx];
 
@@ -861,56 +915,110 @@ bool HloMatcher::MatchPattern(HloInstruction* root,
         return false;
       }
     }
-    return HandleMatch(match, sharding_device);
+
+    // The replacement can only change the matches of the instructions around
+    // the matched instructions, which might be removed by it.
+    std::vector<HloInstruction*> seeds;
+    for (auto pair : match.instruction_mapping) {
+      seeds.push_back(pair.second);
+    }
+    absl::flat_hash_set<int> ids;
+    AddNeighbourhoodIds(seeds, GetMatchDistance() + 1, ids);
+
+    if (HandleMatch(match, sharding_device)) {
+      changed_ids.insert(ids.begin(), ids.end());
+      return true;
+    }
+    return false;
   } else {
     return false;
   }
 }
 
+int64 HloMatcher::GetMatchDistance() const {
+  // A match only looks at instructions which are at most the size of the
+  // pattern away from its first output, plus the associative look through.
+  int64 max_pattern_size = 0;
+  for (const HloMatcherPattern& pattern : patterns_) {
+    max_pattern_size = std::max<int64>(max_pattern_size,
+                                       pattern.GetPatternNodes().size());
+  }
+  return max_pattern_size + look_through_max_depth_;
+}
+
 bool HloMatcher::MatchPatternStart(HloComputation* computation) {
   bool matched = false;
 
+  // The unique ids of the instructions which failed to start a match of each
+  // pattern. Only the failures around a replacement are retried after it.
+  std::vector<absl::flat_hash_set<int>> failed(patterns_.size());
+  // The unique ids of the instructions around the last replacement.
+  absl::flat_hash_set<int> changed_ids;
+  int max_unique_id = -1;
+
   // Non recursive depth first DAG traversal to match the patterns - note that
-  // we restart the search after every match.
+  // we restart the search after every match, so that the patterns are applied
+  // in priority order.
   bool start_from_root = true;
   while (start_from_root) {
     start_from_root = false;
 
-    for (unsigned i = 0; i < patterns_.size(); i++) {
-      auto pattern = patterns_[i];
-      std::stack<HloInstruction*> to_visit;
-      // The list of instructions visited while searching for each pattern
-      std::set<HloInstruction*> visited;
-
-      // Traverse from root
-      to_visit.push(computation->root_instruction());
-      while (!to_visit.empty()) {
-        HloInstruction* inst = to_visit.top();
-        to_visit.pop();
-        visited.insert(inst);
-        // A pattern can have multiple outputs. We start the pattern match when
-        // we find an instruction which matches the first output of the pattern.
-        auto output_0_node = pattern.GetPatternNodes()[pattern.GetOutputs()[0]];
-        if (output_0_node.Matches(inst)) {
-          // Try matching the whole pattern
-          if (MatchPattern(inst, i)) {
-            VLOG(1) << "Matched pattern type " << pattern.GetType() << ".";
-            matched = true;
-            // Restart the matcher
-            start_from_root = true;
-            break;
-          }
+    // Index the instructions by opcode, keeping the traversal order, so that
+    // each pattern only visits the instructions which can be its first output.
+    const std::vector<HloInstruction*> order = GetMatchOrder(computation);
+    absl::flat_hash_map<HloOpcode, std::vector<HloInstruction*>> opcode_order;
+    std::vector<HloInstruction*> added;
+    for (HloInstruction* inst : order) {
+      opcode_order[inst->opcode()].push_back(inst);
+      if (inst->unique_id() > max_unique_id) {
+        added.push_back(inst);
+      }
+    }
+
+    if (matched) {
+      // The instructions added by the replacement have new unique ids.
+      AddNeighbourhoodIds(added, GetMatchDistance() + 1, changed_ids);
+      for (auto& pattern_failed : failed) {
+        for (int id : changed_ids) {
+          pattern_failed.erase(id);
         }
-        for (HloInstruction* operand : inst->operands()) {
-          if (visited.count(operand) == 0) {
-            to_visit.push(operand);
-          }
+      }
+      changed_ids.clear();
+    }
+    for (HloInstruction* inst : added) {
+      max_unique_id = std::max(max_unique_id, inst->unique_id());
+    }
+
+    for (unsigned i = 0; i < patterns_.size() && !start_from_root; i++) {
+      const auto& pattern = patterns_[i];
+      // A pattern can have multiple outputs. We start the pattern match when
+      // we find an instruction which matches the first output of the pattern.
+      const auto& output_0_node =
+          pattern.GetPatternNodes()[pattern.GetOutputs()[0]];
+      const std::vector<HloInstruction*>* candidates = &order;
+      if (output_0_node.GetOpcodeTarget().IsHloOpcode()) {
+        auto itr =
+            opcode_order.find(output_0_node.GetOpcodeTarget().GetHloOpcode());
+        if (itr == opcode_order.end()) {
+          continue;
         }
+        candidates = &itr->second;
       }
 
-      // Restart the matcher
-      if (start_from_root) {
-        break;
+      for (HloInstruction* inst : *candidates) {
+        if (failed[i].contains(inst->unique_id())) {
+          continue;
+        }
+        // Try matching the whole pattern
+        if (output_0_node.Matches(inst) &&
+            MatchPattern(inst, i, changed_ids)) {
+          VLOG(1) << "Matched pattern type " << pattern.GetType() << ".";
+          matched = true;
+          // Restart the matcher
+          start_from_root = true;
+          break;
+        }
+        failed[i].insert(inst->unique_id());
       }
     }
   }
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/meta_graph.h"
@@ -238,7 +239,15 @@ class HloMatcher : public HloModulePass {
                            const absl::optional<int64> sharding_device) = 0;
 
   bool MatchPatternStart(HloComputation*);
-  bool MatchPattern(HloInstruction* inst, const unsigned pattern_idx);
+  // Tries to match and replace the pattern starting at `inst`. When the
+  // replacement is done, the unique ids of the instructions around the matched
+  // instructions are added to `changed_ids`.
+  bool MatchPattern(HloInstruction* inst, const unsigned pattern_idx,
+                    absl::flat_hash_set<int>& changed_ids);
+
+  // The maximum distance between the first output of a match and any of the
+  // instructions the match depends on.
+  int64 GetMatchDistance() const;
 
   std::set<HloInstruction*> GetAssociativeSet(HloInstruction*);
 
@@ -0,0 +1,204 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/host_embedding_cache.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+
+namespace xla {
+namespace poplarplugin {
+
+HostEmbeddingCache::HostEmbeddingCache(int64 num_rows, int64 max_misses,
+                                       Policy policy)
+    : num_rows_(num_rows),
+      max_misses_(max_misses),
+      policy_(policy),
+      slots_(num_rows) {
+  free_slots_.reserve(num_rows);
+  for (int64 slot = num_rows - 1; slot >= 0; --slot) {
+    free_slots_.push_back(slot);
+  }
+}
+
+HostEmbeddingCache::Key HostEmbeddingCache::EvictionKey(int64 slot) const {
+  const Slot& s = slots_[slot];
+  if (policy_ == Policy::kLFU) {
+    return Key{s.frequency, s.last_use, slot};
+  }
+  return Key{s.last_use, 0, slot};
+}
+
+void HostEmbeddingCache::Touch(int64 slot) {
+  eviction_order_.erase(EvictionKey(slot));
+  slots_[slot].frequency++;
+  slots_[slot].last_use = tick_;
+  eviction_order_.insert(EvictionKey(slot));
+}
+
+void HostEmbeddingCache::Remove(int64 slot) {
+  eviction_order_.erase(EvictionKey(slot));
+  row_to_slot_.erase(slots_[slot].row);
+  slots_[slot] = Slot();
+}
+
+int64 HostEmbeddingCache::FindVictim() {
+  if (!free_slots_.empty()) {
+    const int64 slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+  }
+
+  // Never evict a row which is used by the current lookup.
+  for (const Key& key : eviction_order_) {
+    const int64 slot = std::get<2>(key);
+    if (slots_[slot].last_use != tick_) {
+      Remove(slot);
+      return slot;
+    }
+  }
+  return -1;
+}
+
+bool HostEmbeddingCache::Lookup(const int* indices, int64 count,
+                                uint32* slots) {
+  tensorflow::mutex_lock lock(mu_);
+  tick_++;
+
+  const uint32 junk_row = num_rows_ + max_misses_;
+  uint32* insert_slots = slots + count;
+  uint32* overflow = insert_slots + max_misses_;
+
+  // Find the hits and the distinct misses.
+  absl::flat_hash_map<int, int64> miss_positions;
+  std::vector<int> misses;
+  for (int64 i = 0; i < count; ++i) {
+    auto itr = row_to_slot_.find(indices[i]);
+    if (itr != row_to_slot_.end()) {
+      hits_++;
+      Touch(itr->second);
+      slots[i] = itr->second;
+    } else {
+      misses_++;
+      auto inserted = miss_positions.emplace(indices[i], misses.size());
+      if (inserted.second) {
+        misses.push_back(indices[i]);
+      }
+      slots[i] = num_rows_ + inserted.first->second;
+    }
+  }
+
+  if (static_cast<int64>(misses.size()) > max_misses_) {
+    overflows_++;
+    std::fill(slots, overflow, 0);
+    *overflow = 1;
+    miss_indices_.clear();
+    return false;
+  }
+
+  // Insert the missed rows into the cache.
+  std::fill(insert_slots, overflow, junk_row);
+  for (std::size_t j = 0; j < misses.size(); ++j) {
+    const int64 slot = FindVictim();
+    if (slot < 0) {
+      continue;
+    }
+    slots_[slot].row = misses[j];
+    slots_[slot].frequency = 1;
+    slots_[slot].last_use = tick_;
+    eviction_order_.insert(EvictionKey(slot));
+    row_to_slot_[misses[j]] = slot;
+    insert_slots[j] = slot;
+  }
+  *overflow = 0;
+
+  miss_indices_ = std::move(misses);
+  return true;
+}
+
+std::vector<int> HostEmbeddingCache::MissIndices() const {
+  tensorflow::mutex_lock lock(mu_);
+  return miss_indices_;
+}
+
+void HostEmbeddingCache::Invalidate(const int* indices, int64 count) {
+  tensorflow::mutex_lock lock(mu_);
+  for (int64 i = 0; i < count; ++i) {
+    auto itr = row_to_slot_.find(indices[i]);
+    if (itr != row_to_slot_.end()) {
+      const int64 slot = itr->second;
+      Remove(slot);
+      free_slots_.push_back(slot);
+    }
+  }
+}
+
+void HostEmbeddingCache::InvalidateAll() {
+  tensorflow::mutex_lock lock(mu_);
+  for (int64 slot = 0; slot < num_rows_; ++slot) {
+    if (slots_[slot].row >= 0) {
+      Remove(slot);
+      free_slots_.push_back(slot);
+    }
+  }
+}
+
+int64 HostEmbeddingCache::Hits() const {
+  tensorflow::mutex_lock lock(mu_);
+  return hits_;
+}
+
+int64 HostEmbeddingCache::Misses() const {
+  tensorflow::mutex_lock lock(mu_);
+  return misses_;
+}
+
+int64 HostEmbeddingCache::Overflows() const {
+  tensorflow::mutex_lock lock(mu_);
+  return overflows_;
+}
+
+std::string HostEmbeddingCache::StatsString() const {
+  tensorflow::mutex_lock lock(mu_);
+  const int64 total = hits_ + misses_;
+  const double hit_rate = total ? 100.0 * hits_ / total : 0.0;
+  return absl::StrCat("hits: ", hits_, ", misses: ", misses_, " (hit rate ",
+                      hit_rate, "%), overflows: ", overflows_);
+}
+
+bool DeduplicateIndices(const int* indices, int64 count, int64 max_unique,
+                        uint32* slots, std::vector<int>* unique) {
+  unique->clear();
+  absl::flat_hash_map<int, uint32> positions;
+  for (int64 i = 0; i < count; ++i) {
+    auto inserted = positions.emplace(indices[i], unique->size());
+    if (inserted.second) {
+      unique->push_back(indices[i]);
+    }
+    slots[i] = inserted.first->second;
+  }
+
+  if (static_cast<int64>(unique->size()) > max_unique) {
+    std::fill(slots, slots + count, 0);
+    slots[count] = 1;
+    unique->clear();
+    return false;
+  }
+  slots[count] = 0;
+  return true;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
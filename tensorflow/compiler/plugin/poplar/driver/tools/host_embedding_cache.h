@@ -0,0 +1,131 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_HOST_EMBEDDING_CACHE_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_HOST_EMBEDDING_CACHE_H_
+
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Host side bookkeeping for a device resident cache of host embedding rows.
+//
+// The device holds a tensor with `num_rows` cache rows, followed by
+// `max_misses` staging rows for the rows sent by the host in this lookup,
+// followed by a single junk row. For each lookup the host decides which
+// indices hit the cache and which rows have to be sent, and produces the
+// "slots" the device uses to perform the lookup:
+//  * slots[i] for i < count is the row of the device tensor holding the
+//    embedding row for indices[i],
+//  * slots[count + j] for j < max_misses is the cache row the j-th sent row
+//    is written to after the lookup (the junk row if it is not cached),
+//  * slots[count + max_misses] is 1 if there were more distinct misses than
+//    `max_misses`, in which case the device ignores the cache and all the
+//    rows have to be sent by the host.
+//
+// This class is thread safe.
+class HostEmbeddingCache {
+ public:
+  enum class Policy { kLRU, kLFU };
+
+  HostEmbeddingCache(int64 num_rows, int64 max_misses, Policy policy);
+
+  // The number of elements in the slots buffer for a lookup of `count`
+  // indices.
+  static int64 NumSlots(int64 count, int64 max_misses) {
+    return count + max_misses + 1;
+  }
+
+  // Plans a lookup of the given indices and writes the slots for the device.
+  // Returns false when the lookup overflowed.
+  bool Lookup(const int* indices, int64 count, uint32* slots);
+
+  // The embedding rows which have to be sent to the device for the last
+  // lookup which did not overflow, in the order of the staging rows.
+  std::vector<int> MissIndices() const;
+
+  // Drops the given rows from the cache, for example because they have been
+  // updated on the host.
+  void Invalidate(const int* indices, int64 count);
+
+  // Drops all the rows from the cache.
+  void InvalidateAll();
+
+  int64 Hits() const;
+  int64 Misses() const;
+  int64 Overflows() const;
+
+  std::string StatsString() const;
+
+ private:
+  using Key = std::tuple<int64, int64, int64>;
+
+  struct Slot {
+    int row = -1;
+    int64 frequency = 0;
+    int64 last_use = 0;
+  };
+
+  // The eviction order key for a slot - the slot with the smallest key is
+  // evicted first.
+  Key EvictionKey(int64 slot) const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void Touch(int64 slot) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void Remove(int64 slot) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns a slot which can be used for a new row, or -1 if all the slots
+  // are used by the current lookup.
+  int64 FindVictim() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 num_rows_;
+  const int64 max_misses_;
+  const Policy policy_;
+
+  mutable tensorflow::mutex mu_;
+  std::vector<Slot> slots_ GUARDED_BY(mu_);
+  std::vector<int64> free_slots_ GUARDED_BY(mu_);
+  std::set<Key> eviction_order_ GUARDED_BY(mu_);
+  absl::flat_hash_map<int, int64> row_to_slot_ GUARDED_BY(mu_);
+  std::vector<int> miss_indices_ GUARDED_BY(mu_);
+  int64 tick_ GUARDED_BY(mu_) = 0;
+
+  int64 hits_ GUARDED_BY(mu_) = 0;
+  int64 misses_ GUARDED_BY(mu_) = 0;
+  int64 overflows_ GUARDED_BY(mu_) = 0;
+};
+
+// Plans the transfer of only the rows of the distinct values of `count`
+// indices, and writes the slots for the device:
+//  * slots[i] for i < count is the position of indices[i] in `unique`, which
+//    receives the distinct indices in the order of their first use,
+//  * slots[count] is 1 if there were more than `max_unique` distinct indices,
+//    in which case the other slots are zero, `unique` is empty and the rows of
+//    all the indices have to be transferred.
+// Returns false when there were too many distinct indices.
+bool DeduplicateIndices(const int* indices, int64 count, int64 max_unique,
+                        uint32* slots, std::vector<int>* unique);
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_HOST_EMBEDDING_CACHE_H_
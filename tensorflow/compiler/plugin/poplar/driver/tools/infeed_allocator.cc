@@ -15,20 +15,274 @@ limitations under the License.
 
 #include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_allocator.h"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 
 namespace xla {
 namespace poplarplugin {
+namespace {
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+int Log2Floor(size_t n) { return 63 - __builtin_clzll(n); }
+
+void UpdateMax(std::atomic<int64>& max, int64 value) {
+  int64 current = max.load();
+  while (current < value && !max.compare_exchange_weak(current, value)) {
+  }
+}
+}  // namespace
+
+// Header stored immediately before the memory returned to the user.
+struct InfeedAllocator::BlockHeader {
+  // The pointer returned by AlignedMalloc.
+  void* base;
+  // The total number of bytes allocated by AlignedMalloc.
+  size_t total_bytes;
+  // The number of bytes available to the user.
+  size_t block_bytes;
+  // The number of bytes requested by the user.
+  size_t requested_bytes;
+  // The size class of the block, or -1 if the block is not cached.
+  int size_class;
+  bool locked;
+
+  void* data() { return this + 1; }
+  static BlockHeader* FromData(const void* ptr) {
+    return const_cast<BlockHeader*>(static_cast<const BlockHeader*>(ptr)) - 1;
+  }
+};
+
+namespace {
+InfeedAllocator::Options OptionsFromFlags() {
+  InfeedAllocator::Options options;
+  const auto& flags = PoplarXlaFlags::Get();
+  options.max_cached_bytes = flags.infeed_allocator_max_cached_bytes;
+  options.use_huge_pages = flags.infeed_allocator_huge_pages;
+  options.lock_memory = flags.infeed_allocator_lock_memory;
+  return options;
+}
+}  // namespace
+
+InfeedAllocator::InfeedAllocator() : InfeedAllocator(OptionsFromFlags()) {}
+
+InfeedAllocator::InfeedAllocator(const Options& options) : options_(options) {}
+
+InfeedAllocator::~InfeedAllocator() { ReleaseCachedMemory(); }
+
 std::string InfeedAllocator::Name() { return "infeed-allocator"; }
 
+/* static */ int InfeedAllocator::SizeClass(size_t num_bytes) {
+  if (num_bytes <= kMinAlignment) {
+    return 0;
+  }
+  // Find the power of two such that 2^p < num_bytes <= 2^(p+1) and then the
+  // quarter step within that range.
+  const int p = Log2Floor(num_bytes - 1);
+  const size_t step = size_t{1} << (p - 2);
+  const size_t k = (num_bytes - (size_t{1} << p) + step - 1) / step;
+  const int size_class = 1 + (p - 6) * kClassesPerPowerOfTwo + (k - 1);
+  return size_class < kNumSizeClasses ? size_class : -1;
+}
+
+/* static */ size_t InfeedAllocator::SizeClassBytes(int size_class) {
+  if (size_class == 0) {
+    return kMinAlignment;
+  }
+  const int p = 6 + (size_class - 1) / kClassesPerPowerOfTwo;
+  const size_t k = (size_class - 1) % kClassesPerPowerOfTwo + 1;
+  return (size_t{1} << p) + k * (size_t{1} << (p - 2));
+}
+
+/* static */ size_t InfeedAllocator::RoundedSize(size_t num_bytes) {
+  const int size_class = SizeClass(num_bytes);
+  return size_class < 0 ? num_bytes : SizeClassBytes(size_class);
+}
+
+void* InfeedAllocator::NewBlock(size_t alignment, size_t num_bytes,
+                                int size_class) {
+  static_assert(sizeof(BlockHeader) <= kMinAlignment,
+                "The block header must fit in the minimum alignment.");
+  const size_t block_bytes =
+      size_class < 0 ? num_bytes : SizeClassBytes(size_class);
+  // The header is placed in the `alignment` bytes before the user data so
+  // that the user data is aligned.
+  const size_t total_bytes = alignment + block_bytes;
+
+  const bool use_huge_pages =
+      options_.use_huge_pages && total_bytes >= kHugePageSize;
+  const size_t base_alignment = use_huge_pages ? kHugePageSize : alignment;
+  void* base = tensorflow::port::AlignedMalloc(total_bytes, base_alignment);
+  if (!base) {
+    return nullptr;
+  }
+
+#ifdef __linux__
+  if (use_huge_pages) {
+    if (madvise(base, total_bytes, MADV_HUGEPAGE)) {
+      VLOG(1) << "Failed to request huge pages for an infeed buffer.";
+    }
+  }
+#endif
+
+  bool locked = false;
+#ifdef __linux__
+  if (options_.lock_memory) {
+    locked = mlock(base, total_bytes) == 0;
+    if (!locked) {
+      VLOG(1) << "Failed to lock an infeed buffer into memory.";
+    }
+  }
+#endif
+
+  BlockHeader* header = reinterpret_cast<BlockHeader*>(
+                            static_cast<uint8*>(base) + alignment) -
+                        1;
+  header->base = base;
+  header->total_bytes = total_bytes;
+  header->block_bytes = block_bytes;
+  header->size_class = size_class;
+  header->locked = locked;
+  return header->data();
+}
+
+void InfeedAllocator::FreeBlock(BlockHeader* header) {
+  void* base = header->base;
+#ifdef __linux__
+  if (header->locked) {
+    munlock(base, header->total_bytes);
+  }
+#endif
+  tensorflow::port::AlignedFree(base);
+}
+
 void* InfeedAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
-  const size_t min_alignment = 64;
-  alignment = alignment < min_alignment ? min_alignment : alignment;
-  return tensorflow::port::AlignedMalloc(num_bytes, min_alignment);
+  alignment = std::max(alignment, kMinAlignment);
+
+  // Only blocks with the default alignment are cached.
+  const int size_class =
+      alignment == kMinAlignment ? SizeClass(num_bytes) : -1;
+
+  void* ptr = nullptr;
+  if (size_class >= 0) {
+    FreeList& free_list = free_lists_[size_class];
+    tensorflow::mutex_lock lock(free_list.mu);
+    if (!free_list.blocks.empty()) {
+      BlockHeader* header = free_list.blocks.back();
+      free_list.blocks.pop_back();
+      bytes_cached_ -= header->block_bytes;
+      ptr = header->data();
+    }
+  }
+
+  if (ptr) {
+    cache_hits_++;
+  } else {
+    cache_misses_++;
+    ptr = NewBlock(alignment, num_bytes, size_class);
+    if (!ptr) {
+      LOG(WARNING) << "Infeed allocator failed to allocate " << num_bytes
+                   << " bytes.";
+      return nullptr;
+    }
+  }
+
+  BlockHeader* header = BlockHeader::FromData(ptr);
+  header->requested_bytes = num_bytes;
+
+  num_allocs_++;
+  const int64 in_use = bytes_in_use_ += header->block_bytes;
+  UpdateMax(peak_bytes_in_use_, in_use);
+  UpdateMax(largest_alloc_size_, num_bytes);
+  return ptr;
 }
 
 void InfeedAllocator::DeallocateRaw(void* ptr) {
-  tensorflow::port::AlignedFree(ptr);
+  if (!ptr) {
+    return;
+  }
+  BlockHeader* header = BlockHeader::FromData(ptr);
+  bytes_in_use_ -= header->block_bytes;
+
+  if (header->size_class >= 0) {
+    const int64 block_bytes = header->block_bytes;
+    // Only cache the block if it does not go over the limit.
+    if ((bytes_cached_ += block_bytes) <= options_.max_cached_bytes) {
+      FreeList& free_list = free_lists_[header->size_class];
+      tensorflow::mutex_lock lock(free_list.mu);
+      free_list.blocks.push_back(header);
+      return;
+    }
+    bytes_cached_ -= block_bytes;
+  }
+  FreeBlock(header);
+}
+
+size_t InfeedAllocator::RequestedSize(const void* ptr) const {
+  return BlockHeader::FromData(ptr)->requested_bytes;
+}
+
+size_t InfeedAllocator::AllocatedSize(const void* ptr) const {
+  return BlockHeader::FromData(ptr)->block_bytes;
+}
+
+absl::optional<tensorflow::AllocatorStats> InfeedAllocator::GetStats() {
+  tensorflow::AllocatorStats stats;
+  stats.num_allocs = num_allocs_;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.peak_bytes_in_use = peak_bytes_in_use_;
+  stats.largest_alloc_size = largest_alloc_size_;
+  return stats;
+}
+
+void InfeedAllocator::ClearStats() {
+  num_allocs_ = 0;
+  peak_bytes_in_use_ = bytes_in_use_.load();
+  largest_alloc_size_ = 0;
+  cache_hits_ = 0;
+  cache_misses_ = 0;
+}
+
+InfeedAllocator::CacheStats InfeedAllocator::GetCacheStats() const {
+  CacheStats stats;
+  stats.hits = cache_hits_;
+  stats.misses = cache_misses_;
+  stats.bytes_cached = bytes_cached_;
+  return stats;
+}
+
+void InfeedAllocator::ReleaseCachedMemory() {
+  for (FreeList& free_list : free_lists_) {
+    std::vector<BlockHeader*> blocks;
+    {
+      tensorflow::mutex_lock lock(free_list.mu);
+      std::swap(blocks, free_list.blocks);
+    }
+    for (BlockHeader* header : blocks) {
+      bytes_cached_ -= header->block_bytes;
+      FreeBlock(header);
+    }
+  }
+}
+
+std::string InfeedAllocator::StatsAsJson() {
+  const auto stats = *GetStats();
+  const auto cache_stats = GetCacheStats();
+  return absl::StrCat(
+      "{\"infeed_allocator\":{\"num_allocs\":", stats.num_allocs,
+      ",\"bytes_in_use\":", stats.bytes_in_use,
+      ",\"peak_bytes_in_use\":", stats.peak_bytes_in_use,
+      ",\"largest_alloc_size\":", stats.largest_alloc_size,
+      ",\"cache_hits\":", cache_stats.hits,
+      ",\"cache_misses\":", cache_stats.misses,
+      ",\"bytes_cached\":", cache_stats.bytes_cached, "}}");
 }
 
 }  // namespace poplarplugin
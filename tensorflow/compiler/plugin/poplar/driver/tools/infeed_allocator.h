@@ -16,14 +16,40 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_INFEED_ALLOCATOR_H_
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_INFEED_ALLOCATOR_H_
 
+#include <array>
+#include <atomic>
 #include <string>
+#include <vector>
 
+#include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace xla {
 namespace poplarplugin {
+
+// An allocator used for the tensors produced by the infeed datasets.
+// Freed blocks are kept in per size class free lists and reused by subsequent
+// allocations, which means that once the infeeds reach a steady state no more
+// heap allocations are performed.
 class InfeedAllocator : public tensorflow::Allocator {
  public:
+  struct Options {
+    // The maximum number of bytes which can be held in the free lists. Blocks
+    // which would exceed this limit are returned to the system.
+    int64 max_cached_bytes = 1LL << 30;
+    // Request transparent huge pages for large blocks.
+    bool use_huge_pages = false;
+    // Lock the blocks into RAM so that they can not be paged out.
+    bool lock_memory = false;
+  };
+
+  // Creates an allocator configured from the TF_POPLAR_FLAGS.
+  InfeedAllocator();
+  explicit InfeedAllocator(const Options& options);
+  ~InfeedAllocator() override;
+
   // Returns a string identifying this allocator
   std::string Name() override;
 
@@ -36,6 +62,68 @@ class InfeedAllocator : public tensorflow::Allocator {
   // Deallocate a block of memory pointer to by "ptr"
   // REQUIRES: "ptr" was previously returned by a call to AllocateRaw
   void DeallocateRaw(void* ptr) override;
+
+  bool TracksAllocationSizes() const override { return true; }
+
+  size_t RequestedSize(const void* ptr) const override;
+
+  size_t AllocatedSize(const void* ptr) const override;
+
+  absl::optional<tensorflow::AllocatorStats> GetStats() override;
+
+  void ClearStats() override;
+
+  struct CacheStats {
+    // Number of allocations served from the free lists.
+    int64 hits = 0;
+    // Number of allocations which required a new block.
+    int64 misses = 0;
+    // Number of bytes currently held in the free lists.
+    int64 bytes_cached = 0;
+  };
+  CacheStats GetCacheStats() const;
+
+  // Returns all the blocks held in the free lists to the system.
+  void ReleaseCachedMemory();
+
+  // Returns a JSON string with the allocator and cache statistics.
+  std::string StatsAsJson();
+
+  // Returns the number of bytes which will be allocated for an allocation of
+  // `num_bytes` bytes.
+  static size_t RoundedSize(size_t num_bytes);
+
+ private:
+  struct BlockHeader;
+
+  static constexpr size_t kMinAlignment = 64;
+  // Size classes are spaced 4 per power of two between 64B and 4GB.
+  static constexpr int kClassesPerPowerOfTwo = 4;
+  static constexpr int kNumSizeClasses = 1 + 26 * kClassesPerPowerOfTwo;
+
+  static int SizeClass(size_t num_bytes);
+  static size_t SizeClassBytes(int size_class);
+
+  void* NewBlock(size_t alignment, size_t num_bytes, int size_class);
+  void FreeBlock(BlockHeader* header);
+
+  const Options options_;
+
+  struct FreeList {
+    tensorflow::mutex mu;
+    std::vector<BlockHeader*> blocks GUARDED_BY(mu);
+  };
+  std::array<FreeList, kNumSizeClasses> free_lists_;
+
+  std::atomic<int64> num_allocs_{0};
+  std::atomic<int64> bytes_in_use_{0};
+  std::atomic<int64> peak_bytes_in_use_{0};
+  std::atomic<int64> largest_alloc_size_{0};
+  std::atomic<int64> cache_hits_{0};
+  std::atomic<int64> cache_misses_{0};
+  std::atomic<int64> bytes_cached_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InfeedAllocator);
 };
 
 }  // namespace poplarplugin
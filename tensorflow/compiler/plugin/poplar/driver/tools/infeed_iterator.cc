@@ -95,13 +95,17 @@ Status RegisterCancellationCallback(
 }  // namespace
 
 /* static */ constexpr InfeedQueue::T InfeedQueue::kEndOfQueueSentinel;
-InfeedQueue::InfeedQueue()
-    : queue_(nullptr, [](tensorflow::TensorBuffer*& buffer) {
-        if (buffer) {
-          buffer->Unref();
-          buffer = nullptr;
-        }
-      }) {}
+/* static */ constexpr std::size_t InfeedQueue::kDefaultCapacity;
+
+InfeedQueue::InfeedQueue(std::size_t capacity)
+    : queue_(nullptr,
+             [](tensorflow::TensorBuffer*& buffer) {
+               if (buffer) {
+                 buffer->Unref();
+                 buffer = nullptr;
+               }
+             },
+             capacity) {}
 
 InfeedIterator::InfeedIterator(tensorflow::FunctionLibraryRuntime* flr,
                                tensorflow::data::IteratorContext::Params params,
@@ -109,7 +113,8 @@ InfeedIterator::InfeedIterator(tensorflow::FunctionLibraryRuntime* flr,
                                InfeedAllocator* infeed_allocator,
                                int64 replication_factor,
                                const std::vector<xla::Shape>& shapes,
-                               const std::string& feed_id)
+                               const std::string& feed_id,
+                               std::size_t queue_capacity)
     : replication_factor_(replication_factor),
       shapes_(shapes),
       infeed_allocator_(infeed_allocator),
@@ -222,8 +227,11 @@ InfeedIterator::InfeedIterator(tensorflow::FunctionLibraryRuntime* flr,
   for (int64 replica_id = 0; replica_id < replication_factor; replica_id++) {
     for (uint64 i = 0; i < shapes.size(); i++) {
       void* ptr = tensorflow::port::AlignedMalloc(sizeof(InfeedQueue), 64);
-      infeed_queues_[replica_id].emplace_back(new (ptr) InfeedQueue(),
-                                              tensorflow::port::AlignedFree);
+      infeed_queues_[replica_id].emplace_back(
+          new (ptr) InfeedQueue(queue_capacity), [](void* ptr) {
+            static_cast<InfeedQueue*>(ptr)->~InfeedQueue();
+            tensorflow::port::AlignedFree(ptr);
+          });
       infeed_queues_ptrs_[replica_id].emplace_back(
           infeed_queues_[replica_id].back().get());
     }
@@ -246,8 +254,12 @@ Status InfeedIterator::GetNext(std::vector<tensorflow::Tensor>* outputs,
   if (cancellation_manager_.IsCancelled()) {
     *end_of_sequence = true;
   } else {
+    const auto start = InfeedStatistics::Clock::now();
     TF_RETURN_IF_ERROR(
         iterator_->GetNext(iterator_ctx_.get(), outputs, end_of_sequence));
+    if (!*end_of_sequence) {
+      statistics_.RecordProducedElement(start, InfeedStatistics::Clock::now());
+    }
   }
   return Status::OK();
 }
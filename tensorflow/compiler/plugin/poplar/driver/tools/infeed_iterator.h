@@ -23,6 +23,8 @@ limitations under the License.
 #include "absl/synchronization/notification.h"
 
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_feed_config.pb.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_waiter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_statistics.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_queue.h"
 
 #include "tensorflow/compiler/xla/shape.h"
@@ -60,15 +62,23 @@ class InfeedAllocator;
 // inlining the wrapped calls directly at the call site.
 class InfeedQueue {
  public:
-  InfeedQueue();
+  // The capacity used when a feed doesn't choose one.
+  static constexpr std::size_t kDefaultCapacity = 2048;
+
+  explicit InfeedQueue(std::size_t capacity = kDefaultCapacity);
 
   using T = tensorflow::TensorBuffer*;
 
   // Functions delegating directly to the underlying queue.
-  void AdvanceReadPosition() { queue_.AdvanceReadPosition(); }
+  void AdvanceReadPosition() {
+    queue_.AdvanceReadPosition();
+    waiter_.Notify();
+  }
   void AdvanceWritePosition() { queue_.AdvanceWritePosition(); }
   bool IsFull() const { return queue_.IsFull(); }
   bool IsEmpty() const { return queue_.IsEmpty(); }
+  std::size_t Size() const { return queue_.Size(); }
+  std::size_t GetCapacity() const { return queue_.GetCapacity(); }
 
   // Pushing with sanity checking against the sentinel.
   void Push(const T& item) {
@@ -84,6 +94,24 @@ class InfeedQueue {
     return queue_.TryPush(item);
   }
 
+  // Wait until there is space in the queue or `cancelled` is set. Returns
+  // whether there is space in the queue.
+  bool WaitUntilNotFull(const FeedWaitOptions& options,
+                        const std::atomic<bool>& cancelled) {
+    if (!IsFull()) {
+      return true;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool result =
+        waiter_.Wait(options, cancelled, [this] { return !IsFull(); });
+    queue_.RecordPushBlocked(start);
+    return result;
+  }
+
+  SPSCQueueStats GetStats() const { return queue_.GetStats(); }
+
+  FeedWaiter& GetWaiter() { return waiter_; }
+
   // Pushing the sentinel.
   void SignalEndOfQueue() {
     queue_.BlockPush(kEndOfQueueSentinel);
@@ -110,7 +138,8 @@ class InfeedQueue {
   }
 
  private:
-  SPSCQueue<T, 2048> queue_;
+  SPSCQueue<T> queue_;
+  FeedWaiter waiter_;
   static constexpr T kEndOfQueueSentinel{nullptr};
   TF_DISALLOW_COPY_AND_ASSIGN(InfeedQueue);
 };
@@ -122,7 +151,8 @@ class InfeedIterator {
                  tensorflow::data::DatasetBase* dataset,
                  InfeedAllocator* infeed_allocator_, int64 replication_factor,
                  const std::vector<xla::Shape>& shapes,
-                 const std::string& feed_id);
+                 const std::string& feed_id,
+                 std::size_t queue_capacity = InfeedQueue::kDefaultCapacity);
 
   ~InfeedIterator();
 
@@ -133,9 +163,14 @@ class InfeedIterator {
 
   std::vector<std::vector<InfeedQueue*>>& GetInfeedQueues();
 
+  // Statistics of the dataset iterator, the queues and the stream callbacks
+  // of this infeed.
+  InfeedStatistics& GetStatistics() { return statistics_; }
+
  private:
   const int64 replication_factor_;
   std::vector<Shape> shapes_;
+  InfeedStatistics statistics_;
 
   // Not owned.
   // Allocator that should be used for allocating buffers for infeeds.
@@ -0,0 +1,198 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_statistics.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include "include/json/json.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+double PerSecond(uint64_t value, uint64_t nanos) {
+  return nanos ? static_cast<double>(value) * 1e9 / nanos : 0.0;
+}
+
+double Average(uint64_t total, uint64_t count) {
+  return count ? static_cast<double>(total) / count : 0.0;
+}
+
+std::string ToString(const Json::Value& value) {
+  Json::StreamWriterBuilder builder;
+  std::stringstream ss;
+  std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+  writer->write(value, &ss);
+  return ss.str();
+}
+
+Json::Value FeedQueueStatsToJsonValue(const SPSCQueueStats& stats) {
+  Json::Value value;
+  value["push_count"] = Json::UInt64(stats.push_count);
+  value["pop_count"] = Json::UInt64(stats.pop_count);
+  value["push_blocked_us"] = stats.push_blocked_nanos / 1e3;
+  value["pop_blocked_us"] = stats.pop_blocked_nanos / 1e3;
+  value["high_water_mark"] = Json::UInt64(stats.high_water_mark);
+  return value;
+}
+}  // namespace
+
+std::string FeedQueueStatsToJson(const SPSCQueueStats& stats) {
+  return ToString(FeedQueueStatsToJsonValue(stats));
+}
+
+InfeedStatistics::InfeedStatistics() { Reset(); }
+
+void InfeedStatistics::UpdateMax(std::atomic<uint64_t>& value,
+                                 uint64_t candidate) {
+  uint64_t current = value.load();
+  while (current < candidate &&
+         !value.compare_exchange_weak(current, candidate)) {
+  }
+}
+
+void InfeedStatistics::RecordProducedElement(Clock::time_point start,
+                                             Clock::time_point end) {
+  elements_produced_++;
+  producer_nanos_ += ToNanos(start, end);
+  uint64_t unset = 0;
+  first_produced_nanos_.compare_exchange_strong(unset, NanosSinceEpoch(start));
+  UpdateMax(last_produced_nanos_, NanosSinceEpoch(end));
+}
+
+void InfeedStatistics::RecordQueueOccupancy(std::size_t num_elements) {
+  std::size_t bucket = 0;
+  while (num_elements) {
+    num_elements >>= 1;
+    bucket++;
+  }
+  occupancy_[std::min(bucket, kNumOccupancyBuckets - 1)]++;
+}
+
+void InfeedStatistics::RecordTransfer(Clock::time_point start,
+                                      Clock::time_point end,
+                                      std::size_t num_bytes) {
+  bytes_transferred_ += num_bytes;
+  uint64_t unset = 0;
+  first_transfer_nanos_.compare_exchange_strong(unset, NanosSinceEpoch(start));
+  UpdateMax(last_transfer_nanos_, NanosSinceEpoch(end));
+}
+
+void InfeedStatistics::RecordPrefetch(Clock::time_point start,
+                                      Clock::time_point end,
+                                      std::size_t num_bytes, bool available) {
+  const uint64_t nanos = ToNanos(start, end);
+  prefetch_count_++;
+  prefetch_nanos_ += nanos;
+  UpdateMax(max_prefetch_nanos_, nanos);
+  if (available) {
+    RecordTransfer(start, end, num_bytes);
+  } else {
+    prefetch_not_available_count_++;
+  }
+}
+
+void InfeedStatistics::RecordFetch(Clock::time_point start,
+                                   Clock::time_point end,
+                                   std::size_t num_bytes) {
+  const uint64_t nanos = ToNanos(start, end);
+  fetch_count_++;
+  fetch_nanos_ += nanos;
+  UpdateMax(max_fetch_nanos_, nanos);
+  RecordTransfer(start, end, num_bytes);
+}
+
+void InfeedStatistics::Reset() {
+  elements_produced_ = 0;
+  producer_nanos_ = 0;
+  first_produced_nanos_ = 0;
+  last_produced_nanos_ = 0;
+  for (auto& bucket : occupancy_) {
+    bucket = 0;
+  }
+  prefetch_count_ = 0;
+  prefetch_not_available_count_ = 0;
+  prefetch_nanos_ = 0;
+  max_prefetch_nanos_ = 0;
+  fetch_count_ = 0;
+  fetch_nanos_ = 0;
+  max_fetch_nanos_ = 0;
+  bytes_transferred_ = 0;
+  first_transfer_nanos_ = 0;
+  last_transfer_nanos_ = 0;
+}
+
+std::string InfeedStatistics::ToJson(const SPSCQueueStats& queue_stats) const {
+  Json::Value producer;
+  const uint64_t elements_produced = elements_produced_;
+  const uint64_t producer_window =
+      last_produced_nanos_ - std::min<uint64_t>(first_produced_nanos_,
+                                                last_produced_nanos_);
+  producer["elements_produced"] = Json::UInt64(elements_produced);
+  producer["time_in_iterator"] = producer_nanos_ / 1e9;
+  // How fast the dataset could produce elements if it was never stalled by
+  // full queues, and how fast it actually produced them.
+  producer["elements_per_second_in_iterator"] =
+      PerSecond(elements_produced, producer_nanos_);
+  producer["elements_per_second"] =
+      PerSecond(elements_produced, producer_window);
+
+  Json::Value queue = FeedQueueStatsToJsonValue(queue_stats);
+  Json::Value histogram(Json::arrayValue);
+  for (std::size_t i = 0; i != kNumOccupancyBuckets; ++i) {
+    Json::Value bucket;
+    bucket["min_elements"] = Json::UInt64(i ? (1ULL << (i - 1)) : 0);
+    bucket["samples"] = Json::UInt64(occupancy_[i].load());
+    histogram.append(bucket);
+  }
+  queue["occupancy_histogram"] = histogram;
+
+  Json::Value callbacks;
+  const uint64_t prefetch_count = prefetch_count_;
+  const uint64_t fetch_count = fetch_count_;
+  callbacks["prefetch_count"] = Json::UInt64(prefetch_count);
+  callbacks["prefetch_not_available_count"] =
+      Json::UInt64(prefetch_not_available_count_.load());
+  callbacks["average_prefetch_latency_us"] =
+      Average(prefetch_nanos_, prefetch_count) / 1e3;
+  callbacks["max_prefetch_latency_us"] = max_prefetch_nanos_ / 1e3;
+  // Fetches happen when the prefetches could not keep up with the device, and
+  // block until the element has been produced.
+  callbacks["fetch_count"] = Json::UInt64(fetch_count);
+  callbacks["average_fetch_latency_us"] =
+      Average(fetch_nanos_, fetch_count) / 1e3;
+  callbacks["max_fetch_latency_us"] = max_fetch_nanos_ / 1e3;
+
+  Json::Value transfer;
+  const uint64_t bytes_transferred = bytes_transferred_;
+  const uint64_t transfer_window =
+      last_transfer_nanos_ - std::min<uint64_t>(first_transfer_nanos_,
+                                                last_transfer_nanos_);
+  transfer["bytes_transferred"] = Json::UInt64(bytes_transferred);
+  transfer["time_elapsed"] = transfer_window / 1e9;
+  transfer["bandwidth"] = PerSecond(bytes_transferred, transfer_window) / 1e9;
+
+  Json::Value stats;
+  stats["producer"] = producer;
+  stats["queue"] = queue;
+  stats["callbacks"] = callbacks;
+  stats["transfer"] = transfer;
+  return ToString(stats);
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
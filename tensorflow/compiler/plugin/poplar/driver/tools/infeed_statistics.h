@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_INFEED_STATISTICS_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_INFEED_STATISTICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/spsc_queue.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Counters for each stage of an infeed, from the dataset iterator producing
+// elements, through the infeed queues, to the stream callbacks which copy the
+// elements into the buffers transferred to the device. They are updated by
+// the IO thread and the Poplar callback threads, so all of them are atomic.
+class InfeedStatistics {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // The queue occupancy is recorded in buckets of powers of two - bucket `i`
+  // counts the samples with an occupancy in [2^(i-1), 2^i), bucket 0 counts
+  // the samples where the queue was empty.
+  static constexpr std::size_t kNumOccupancyBuckets = 13;
+
+  InfeedStatistics();
+
+  // Records a call to the dataset iterator which took from `start` to `end`.
+  void RecordProducedElement(Clock::time_point start, Clock::time_point end);
+
+  // Records the number of elements in an infeed queue when a callback ran.
+  void RecordQueueOccupancy(std::size_t num_elements);
+
+  // Records a prefetch callback. When the element was not available yet no
+  // bytes were copied.
+  void RecordPrefetch(Clock::time_point start, Clock::time_point end,
+                      std::size_t num_bytes, bool available);
+
+  // Records a fetch callback, which blocks until the element is available.
+  void RecordFetch(Clock::time_point start, Clock::time_point end,
+                   std::size_t num_bytes);
+
+  void Reset();
+
+  // Returns the statistics of each stage as a JSON string. The counters of the
+  // infeed queues are added to the queue stage.
+  std::string ToJson(const SPSCQueueStats& queue_stats) const;
+
+ private:
+  static uint64_t ToNanos(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+        .count();
+  }
+  static uint64_t NanosSinceEpoch(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               t.time_since_epoch())
+        .count();
+  }
+
+  void RecordTransfer(Clock::time_point start, Clock::time_point end,
+                      std::size_t num_bytes);
+  static void UpdateMax(std::atomic<uint64_t>& value, uint64_t candidate);
+
+  // Producer.
+  std::atomic<uint64_t> elements_produced_;
+  std::atomic<uint64_t> producer_nanos_;
+  std::atomic<uint64_t> first_produced_nanos_;
+  std::atomic<uint64_t> last_produced_nanos_;
+
+  // Queues.
+  std::array<std::atomic<uint64_t>, kNumOccupancyBuckets> occupancy_;
+
+  // Callbacks.
+  std::atomic<uint64_t> prefetch_count_;
+  std::atomic<uint64_t> prefetch_not_available_count_;
+  std::atomic<uint64_t> prefetch_nanos_;
+  std::atomic<uint64_t> max_prefetch_nanos_;
+  std::atomic<uint64_t> fetch_count_;
+  std::atomic<uint64_t> fetch_nanos_;
+  std::atomic<uint64_t> max_fetch_nanos_;
+
+  // Host to device transfers.
+  std::atomic<uint64_t> bytes_transferred_;
+  std::atomic<uint64_t> first_transfer_nanos_;
+  std::atomic<uint64_t> last_transfer_nanos_;
+
+  InfeedStatistics(const InfeedStatistics&) = delete;
+  InfeedStatistics& operator=(const InfeedStatistics&) = delete;
+};
+
+// Returns the counters of the queues of a feed as a JSON string.
+std::string FeedQueueStatsToJson(const SPSCQueueStats& stats);
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_INFEED_STATISTICS_H_
@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_information.h"
@@ -63,6 +64,11 @@ int64 InstructionColocatorHelper::ByteSizeOf(const HloInstruction* inst) const {
   return ByteSizeOfIncludingTuple(inst->shape());
 }
 
+int64 InstructionColocatorHelper::GetMaximumCombinedSize(
+    const CompilerInformation& information) const {
+  return 0;
+}
+
 bool InstructionColocatorHelper::CanColocateExtra(
     const HloInstruction* a, const HloInstruction* b) const {
   return true;
@@ -224,16 +230,31 @@ class AllReduceColocatorHelper : public InstructionColocatorHelper {
     return inst->opcode() == HloOpcode::kAllReduce;
   }
 
+  // Without a buffer size, the all-reduces are scheduled as soon as a bucket
+  // of gradients is ready.
   int64 GetColocateBufferSize(
       const CompilerInformation& information) const override {
-    return information.max_all_reduce_buffer_size;
+    return information.max_all_reduce_buffer_size > 0
+               ? information.max_all_reduce_buffer_size
+               : information.all_reduce_bucket_size;
+  }
+
+  int64 GetMaximumCombinedSize(
+      const CompilerInformation& information) const override {
+    return information.all_reduce_bucket_size;
   }
 
  protected:
   bool CanColocateExtra(const HloInstruction* a,
                         const HloInstruction* b) const override {
-    // Make sure the same to_apply() computation is used.
-    return *a->to_apply() == *b->to_apply();
+    // Make sure the same to_apply() computation and the same groups of
+    // replicas are used.
+    return *a->to_apply() == *b->to_apply() &&
+           absl::c_equal(a->replica_groups(), b->replica_groups(),
+                         [](const ReplicaGroup& x, const ReplicaGroup& y) {
+                           return absl::c_equal(x.replica_ids(),
+                                                y.replica_ids());
+                         });
   }
 };
 
@@ -262,7 +283,14 @@ class ReduceScatterColocatorHelper : public InstructionColocatorHelper {
 
   int64 GetColocateBufferSize(
       const CompilerInformation& information) const override {
-    return information.max_reduce_scatter_buffer_size;
+    return information.max_reduce_scatter_buffer_size > 0
+               ? information.max_reduce_scatter_buffer_size
+               : information.reduce_scatter_bucket_size;
+  }
+
+  int64 GetMaximumCombinedSize(
+      const CompilerInformation& information) const override {
+    return information.reduce_scatter_bucket_size;
   }
 };
 
@@ -443,7 +471,14 @@ class StatefulGradientAccumulationAllReduceColocatorHelper
 
   int64 GetColocateBufferSize(
       const CompilerInformation& information) const override {
-    return information.max_all_reduce_buffer_size;
+    return information.max_all_reduce_buffer_size > 0
+               ? information.max_all_reduce_buffer_size
+               : information.all_reduce_bucket_size;
+  }
+
+  int64 GetMaximumCombinedSize(
+      const CompilerInformation& information) const override {
+    return information.all_reduce_bucket_size;
   }
 
  protected:
@@ -473,7 +508,14 @@ class StatefulGradientAccumulateWithMomentumAndAllReduceWithNormColocatorHelper
 
   int64 GetColocateBufferSize(
       const CompilerInformation& information) const override {
-    return information.max_all_reduce_buffer_size;
+    return information.max_all_reduce_buffer_size > 0
+               ? information.max_all_reduce_buffer_size
+               : information.all_reduce_bucket_size;
+  }
+
+  int64 GetMaximumCombinedSize(
+      const CompilerInformation& information) const override {
+    return information.all_reduce_bucket_size;
   }
 
   StatusOr<std::vector<HloInstruction*>> CombineAndReplaceColocatedInstructions(
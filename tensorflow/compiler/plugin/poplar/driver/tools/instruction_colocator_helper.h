@@ -43,6 +43,10 @@ class InstructionColocatorHelper {
   // Returns how many bytes to colocate.
   virtual int64 GetColocateBufferSize(
       const CompilerInformation& information) const = 0;
+  // Returns the maximum number of bytes of a combined instruction, 0 when
+  // there is no maximum.
+  virtual int64 GetMaximumCombinedSize(
+      const CompilerInformation& information) const;
 
   int64 GetID() const;
 
@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/ipu_activity_recorder.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+struct ActivityBuffer {
+  tensorflow::mutex mu;
+  std::vector<IpuActivity> activities GUARDED_BY(mu);
+  size_t num_dropped GUARDED_BY(mu) = 0;
+};
+
+ActivityBuffer& GetActivityBuffer() {
+  static ActivityBuffer* buffer = new ActivityBuffer;
+  return *buffer;
+}
+
+}  // namespace
+
+constexpr size_t IpuActivityRecorder::kMaxActivities;
+
+std::atomic<bool> IpuActivityRecorder::active_{false};
+
+const char* IpuActivityTypeName(IpuActivityType type) {
+  switch (type) {
+    case IpuActivityType::kCompile:
+      return "Compile";
+    case IpuActivityType::kLoadEngine:
+      return "LoadEngine";
+    case IpuActivityType::kExecute:
+      return "Execute";
+    case IpuActivityType::kHostToDevice:
+      return "HostToDevice";
+    case IpuActivityType::kDeviceToHost:
+      return "DeviceToHost";
+    case IpuActivityType::kStreamCallback:
+      return "StreamCallback";
+    case IpuActivityType::kInfeed:
+      return "Infeed";
+    case IpuActivityType::kOutfeed:
+      return "Outfeed";
+  }
+  return "Unknown";
+}
+
+bool IpuActivityRecorder::Start() {
+  ActivityBuffer& buffer = GetActivityBuffer();
+  tensorflow::mutex_lock lock(buffer.mu);
+  if (active_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  buffer.activities.clear();
+  buffer.num_dropped = 0;
+  active_.store(true, std::memory_order_release);
+  return true;
+}
+
+std::vector<IpuActivity> IpuActivityRecorder::Stop() {
+  ActivityBuffer& buffer = GetActivityBuffer();
+  tensorflow::mutex_lock lock(buffer.mu);
+  active_.store(false, std::memory_order_release);
+  if (buffer.num_dropped) {
+    LOG(WARNING) << "Dropped " << buffer.num_dropped
+                 << " IPU activities after recording " << kMaxActivities
+                 << " of them.";
+  }
+  std::vector<IpuActivity> activities;
+  std::swap(activities, buffer.activities);
+  return activities;
+}
+
+void IpuActivityRecorder::Record(IpuActivity activity) {
+  ActivityBuffer& buffer = GetActivityBuffer();
+  tensorflow::mutex_lock lock(buffer.mu);
+  // The recorder may have been stopped while the activity was running.
+  if (!active_.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (buffer.activities.size() >= kMaxActivities) {
+    buffer.num_dropped++;
+    return;
+  }
+  buffer.activities.push_back(std::move(activity));
+}
+
+IpuActivityScope::IpuActivityScope(int ordinal, IpuActivityType type,
+                                   absl::string_view name)
+    : active_(IpuActivityRecorder::Active()) {
+  if (active_) {
+    activity_.ordinal = ordinal;
+    activity_.type = type;
+    activity_.name = std::string(name);
+    activity_.thread_id = tensorflow::Env::Default()->GetCurrentThreadId();
+    activity_.start_nanos = tensorflow::EnvTime::Default()->NowNanos();
+  }
+}
+
+IpuActivityScope::~IpuActivityScope() {
+  if (active_) {
+    activity_.end_nanos = tensorflow::EnvTime::Default()->NowNanos();
+    IpuActivityRecorder::Record(std::move(activity_));
+  }
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_IPU_ACTIVITY_RECORDER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_IPU_ACTIVITY_RECORDER_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace xla {
+namespace poplarplugin {
+
+enum class IpuActivityType {
+  kCompile,
+  kLoadEngine,
+  kExecute,
+  kHostToDevice,
+  kDeviceToHost,
+  kStreamCallback,
+  kInfeed,
+  kOutfeed,
+};
+
+// Returns a readable name for the activity type, for example "Execute".
+const char* IpuActivityTypeName(IpuActivityType type);
+
+// An interval of time spent by the executor of one IPU device, on the clock of
+// `tensorflow::EnvTime::Default()->NowNanos()`, which is also used by the host
+// TraceMe events.
+struct IpuActivity {
+  int ordinal;
+  IpuActivityType type;
+  std::string name;
+  tensorflow::uint64 start_nanos;
+  tensorflow::uint64 end_nanos;
+  tensorflow::int32 thread_id;
+};
+
+// Process wide recorder of the IPU activities, which is only active while the
+// IPU tracer of the TensorFlow profiler is running. When it is not active,
+// recording an activity costs a single atomic load.
+class IpuActivityRecorder {
+ public:
+  // The activities recorded past this number are dropped.
+  static constexpr size_t kMaxActivities = 1 << 20;
+
+  // Starts recording. Returns false if the recorder is already active.
+  static bool Start();
+
+  // Stops recording and returns the recorded activities, in the order in which
+  // they ended.
+  static std::vector<IpuActivity> Stop();
+
+  static bool Active() { return active_.load(std::memory_order_acquire); }
+
+  static void Record(IpuActivity activity);
+
+ private:
+  static std::atomic<bool> active_;
+};
+
+// Records the lifetime of the scope as an activity of the IPU `ordinal`, if
+// the recorder is active when the scope is created.
+class IpuActivityScope {
+ public:
+  IpuActivityScope(int ordinal, IpuActivityType type, absl::string_view name);
+  ~IpuActivityScope();
+
+ private:
+  bool active_;
+  IpuActivity activity_;
+
+  IpuActivityScope(const IpuActivityScope&) = delete;
+  IpuActivityScope& operator=(const IpuActivityScope&) = delete;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_IPU_ACTIVITY_RECORDER_H_
@@ -0,0 +1,259 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/mapped_embedding_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/error.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// Writes all of `data`, retrying on short writes.
+Status WriteAll(int fd, const void* data, std::size_t num_bytes,
+                const std::string& path) {
+  const char* src = static_cast<const char*>(data);
+  while (num_bytes > 0) {
+    const ssize_t written = write(fd, src, num_bytes);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return tensorflow::IOError(path, errno);
+    }
+    src += written;
+    num_bytes -= written;
+  }
+  return Status::OK();
+}
+
+// Reads up to `num_bytes`, returning the number of bytes read which is only
+// less than `num_bytes` at the end of the file.
+StatusOr<std::size_t> ReadAll(int fd, void* data, std::size_t num_bytes,
+                              const std::string& path) {
+  char* dst = static_cast<char*>(data);
+  std::size_t total = 0;
+  while (total < num_bytes) {
+    const ssize_t num_read = read(fd, dst + total, num_bytes - total);
+    if (num_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return tensorflow::IOError(path, errno);
+    }
+    if (num_read == 0) {
+      break;
+    }
+    total += num_read;
+  }
+  return total;
+}
+}  // namespace
+
+constexpr char MappedEmbeddingTable::kMagic[8];
+constexpr uint32 MappedEmbeddingTable::kVersion;
+constexpr int64 MappedEmbeddingTable::kHeaderBytes;
+
+/* static */ Status MappedEmbeddingTable::Create(const std::string& path,
+                                                 tensorflow::DataType dtype,
+                                                 int64 num_rows,
+                                                 int64 encoding_width,
+                                                 const void* data) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return tensorflow::IOError(path, errno);
+  }
+
+  char header_bytes[kHeaderBytes] = {};
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.dtype = dtype;
+  header.num_rows = num_rows;
+  header.encoding_width = encoding_width;
+  std::memcpy(header_bytes, &header, sizeof(header));
+
+  Status status = WriteAll(fd, header_bytes, kHeaderBytes, path);
+  if (status.ok()) {
+    status = WriteAll(fd, data,
+                      num_rows * encoding_width *
+                          tensorflow::DataTypeSize(dtype),
+                      path);
+  }
+  close(fd);
+  return status;
+}
+
+/* static */ StatusOr<std::unique_ptr<MappedEmbeddingTable>>
+MappedEmbeddingTable::Open(const std::string& path,
+                           const std::string& log_path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return tensorflow::IOError(path, errno);
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int err = errno;
+    close(fd);
+    return tensorflow::IOError(path, err);
+  }
+  const std::size_t file_bytes = file_stat.st_size;
+
+  Header header;
+  if (file_bytes < kHeaderBytes ||
+      pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    close(fd);
+    return InvalidArgument("%s is not a host embedding table file.", path);
+  }
+  if (header.version != kVersion) {
+    close(fd);
+    return InvalidArgument(
+        "Host embedding table file %s has version %u, expected %u.", path,
+        header.version, kVersion);
+  }
+
+  auto table = absl::WrapUnique(new MappedEmbeddingTable());
+  table->dtype_ = static_cast<tensorflow::DataType>(header.dtype);
+  table->num_rows_ = header.num_rows;
+  table->encoding_width_ = header.encoding_width;
+  table->row_bytes_ =
+      header.encoding_width * tensorflow::DataTypeSize(table->dtype_);
+
+  const std::size_t expected_bytes =
+      kHeaderBytes + table->num_rows_ * table->row_bytes_;
+  if (table->row_bytes_ <= 0 || file_bytes != expected_bytes) {
+    close(fd);
+    return InvalidArgument(
+        "Host embedding table file %s has %u bytes, expected %u bytes for a "
+        "[%d, %d] %s table.",
+        path, file_bytes, expected_bytes, table->num_rows_,
+        table->encoding_width_, tensorflow::DataTypeString(table->dtype_));
+  }
+
+  // Map the file copy-on-write; updates are never written back to the file.
+  void* mapping = mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_NORESERVE, fd, 0);
+  const int err = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return tensorflow::IOError(path, err);
+  }
+  // The lookups are typically spread over the whole table.
+  madvise(mapping, file_bytes, MADV_RANDOM);
+
+  table->mapping_ = mapping;
+  table->mapping_bytes_ = file_bytes;
+  table->data_ = static_cast<char*>(mapping) + kHeaderBytes;
+  table->log_path_ = log_path;
+
+  if (!log_path.empty()) {
+    TF_RETURN_IF_ERROR(table->ReplayLog());
+  }
+
+  return table;
+}
+
+MappedEmbeddingTable::~MappedEmbeddingTable() {
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+  if (mapping_) {
+    munmap(mapping_, mapping_bytes_);
+  }
+}
+
+Status MappedEmbeddingTable::ReplayLog() {
+  const int fd = open(log_path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    // No updates have been logged yet.
+    return errno == ENOENT ? Status::OK()
+                           : tensorflow::IOError(log_path_, errno);
+  }
+
+  Status status = Status::OK();
+  int32 index;
+  std::vector<char> row(row_bytes_);
+  while (true) {
+    auto num_read = ReadAll(fd, &index, sizeof(index), log_path_);
+    if (!num_read.ok()) {
+      status = num_read.status();
+      break;
+    }
+    if (num_read.ValueOrDie() != sizeof(index)) {
+      // A record which was not completely written is ignored.
+      break;
+    }
+    if (index < 0 || index >= num_rows_) {
+      status = InvalidArgument(
+          "Host embedding update log %s contains row %d but the table only "
+          "has %d rows.",
+          log_path_, index, num_rows_);
+      break;
+    }
+    num_read = ReadAll(fd, row.data(), row_bytes_, log_path_);
+    if (!num_read.ok()) {
+      status = num_read.status();
+      break;
+    }
+    if (num_read.ValueOrDie() != static_cast<std::size_t>(row_bytes_)) {
+      break;
+    }
+    std::memcpy(Row(index), row.data(), row_bytes_);
+    num_replayed_records_++;
+  }
+  close(fd);
+  return status;
+}
+
+Status MappedEmbeddingTable::LogRows(const int* indices, int64 count) {
+  if (log_path_.empty() || count == 0) {
+    return Status::OK();
+  }
+
+  tensorflow::mutex_lock lock(log_mu_);
+  if (log_fd_ < 0) {
+    log_fd_ = open(log_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log_fd_ < 0) {
+      return tensorflow::IOError(log_path_, errno);
+    }
+  }
+
+  // Append all the records together so that only the last record can be
+  // incomplete if the process stops while logging.
+  const std::size_t record_bytes = sizeof(int32) + row_bytes_;
+  std::vector<char> records(count * record_bytes);
+  for (int64 i = 0; i < count; ++i) {
+    const int32 index = indices[i];
+    char* record = records.data() + i * record_bytes;
+    std::memcpy(record, &index, sizeof(index));
+    std::memcpy(record + sizeof(index), Row(index), row_bytes_);
+  }
+  return WriteAll(log_fd_, records.data(), records.size(), log_path_);
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
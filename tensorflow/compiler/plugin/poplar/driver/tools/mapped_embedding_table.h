@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_MAPPED_EMBEDDING_TABLE_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_MAPPED_EMBEDDING_TABLE_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// An embedding table stored in a file which is memory mapped instead of being
+// read into memory.
+//
+// The file starts with a kHeaderBytes header (see Header) followed by the rows
+// of the table. The file itself is never modified, it is mapped copy-on-write
+// so that the unmodified pages are shared with the page cache (and any other
+// process using the same table) and only the pages which are updated use
+// private memory.
+//
+// When an update log is used, the rows which have been updated are appended
+// to the log file as (row index, row data) records and the log is replayed
+// when the table is opened again.
+//
+// Rows can be read and written concurrently by different threads as long as
+// they are distinct rows. LogRows is thread safe.
+class MappedEmbeddingTable {
+ public:
+  struct Header {
+    char magic[8];
+    uint32 version;
+    uint32 dtype;
+    int64 num_rows;
+    int64 encoding_width;
+  };
+  static constexpr char kMagic[8] = {'I', 'P', 'U', 'E', 'M', 'B', 'E', 'D'};
+  static constexpr uint32 kVersion = 1;
+  static constexpr int64 kHeaderBytes = 64;
+
+  // Writes a new table file containing `data`, which must have
+  // num_rows * encoding_width elements of type `dtype`.
+  static Status Create(const std::string& path, tensorflow::DataType dtype,
+                       int64 num_rows, int64 encoding_width, const void* data);
+
+  // Maps the table in `path`. If `log_path` is not empty the updates recorded
+  // in it are applied and future updates can be logged with LogRows.
+  static StatusOr<std::unique_ptr<MappedEmbeddingTable>> Open(
+      const std::string& path, const std::string& log_path);
+
+  ~MappedEmbeddingTable();
+
+  tensorflow::DataType dtype() const { return dtype_; }
+  int64 NumRows() const { return num_rows_; }
+  int64 EncodingWidth() const { return encoding_width_; }
+  int64 RowBytes() const { return row_bytes_; }
+
+  // Returns the mapped memory of a row. Writing to it only modifies this
+  // process' view of the table.
+  void* Row(int64 index) const {
+    return data_ + static_cast<std::size_t>(index) * row_bytes_;
+  }
+
+  // Appends the current value of the given rows to the update log. Does
+  // nothing when there is no log.
+  Status LogRows(const int* indices, int64 count);
+
+  // The number of log records which were applied when the table was opened.
+  int64 NumReplayedRecords() const { return num_replayed_records_; }
+
+ private:
+  MappedEmbeddingTable() = default;
+
+  Status ReplayLog();
+
+  tensorflow::DataType dtype_ = tensorflow::DT_INVALID;
+  int64 num_rows_ = 0;
+  int64 encoding_width_ = 0;
+  int64 row_bytes_ = 0;
+
+  void* mapping_ = nullptr;
+  std::size_t mapping_bytes_ = 0;
+  char* data_ = nullptr;
+
+  std::string log_path_;
+  tensorflow::mutex log_mu_;
+  int log_fd_ GUARDED_BY(log_mu_) = -1;
+  int64 num_replayed_records_ = 0;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_MAPPED_EMBEDDING_TABLE_H_
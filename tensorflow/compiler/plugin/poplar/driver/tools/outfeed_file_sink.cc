@@ -0,0 +1,170 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_file_sink.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace poplarplugin {
+
+OutfeedFileSink::OutfeedFileSink(const std::string& prefix, Format format,
+                                 int64 elements_per_file,
+                                 int64 max_pending_batches)
+    : prefix_(prefix),
+      format_(format),
+      elements_per_file_(elements_per_file),
+      max_pending_batches_(std::max<int64>(max_pending_batches, 1)) {
+  thread_.reset(tensorflow::Env::Default()->StartThread(
+      tensorflow::ThreadOptions(), "outfeed_file_sink",
+      [this]() { WriterLoop(); }));
+}
+
+OutfeedFileSink::~OutfeedFileSink() {
+  {
+    tensorflow::mutex_lock l(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  // Joins the writer thread once it has written the pending batches.
+  thread_.reset();
+  tensorflow::mutex_lock l(mu_);
+  if (!status_.ok()) {
+    LOG(ERROR) << "Failed to write the outfeed to " << prefix_ << ": "
+               << status_;
+  }
+}
+
+void OutfeedFileSink::Write(std::vector<tensorflow::Tensor> batch) {
+  tensorflow::mutex_lock l(mu_);
+  // Waiting here applies back pressure to the outfeed when the files are not
+  // written as fast as the device produces the elements.
+  while (static_cast<int64>(pending_.size()) >= max_pending_batches_) {
+    cv_.wait(l);
+  }
+  pending_.push_back(std::move(batch));
+  cv_.notify_all();
+}
+
+Status OutfeedFileSink::Flush() {
+  tensorflow::mutex_lock l(mu_);
+  while (!pending_.empty() || writing_) {
+    cv_.wait(l);
+  }
+  return status_;
+}
+
+std::string OutfeedFileSink::FileName(const std::string& prefix,
+                                      Format format, int64 index) {
+  return absl::StrFormat("%s-%05d.%s", prefix, index,
+                         format == Format::kTFRecord ? "tfrecord" : "bin");
+}
+
+void OutfeedFileSink::WriterLoop() {
+  while (true) {
+    std::vector<tensorflow::Tensor> batch;
+    {
+      tensorflow::mutex_lock l(mu_);
+      while (pending_.empty() && !stopping_) {
+        cv_.wait(l);
+      }
+      if (pending_.empty()) {
+        break;
+      }
+      batch = std::move(pending_.front());
+      pending_.pop_front();
+      writing_ = true;
+      cv_.notify_all();
+    }
+
+    Status status = WriteBatch(batch);
+    // Release the tensors so that the outfeed can reuse their storage.
+    batch.clear();
+
+    tensorflow::mutex_lock l(mu_);
+    // Flush the file once the queue is drained, so that the elements can be
+    // read as soon as Flush returns.
+    if (status.ok() && pending_.empty() && file_) {
+      status = record_writer_ ? record_writer_->Flush() : file_->Flush();
+    }
+    status_.Update(status);
+    writing_ = false;
+    cv_.notify_all();
+  }
+
+  Status status = CloseFile();
+  tensorflow::mutex_lock l(mu_);
+  status_.Update(status);
+}
+
+Status OutfeedFileSink::WriteBatch(
+    const std::vector<tensorflow::Tensor>& batch) {
+  const int64 num_elements = batch.empty() ? 0 : batch[0].dim_size(0);
+  for (int64 element = 0; element != num_elements; ++element) {
+    if (!file_ ||
+        (elements_per_file_ > 0 && elements_in_file_ == elements_per_file_)) {
+      TF_RETURN_IF_ERROR(OpenNextFile());
+    }
+    for (const tensorflow::Tensor& tensor : batch) {
+      const tensorflow::Tensor slice = tensor.SubSlice(element);
+      if (format_ == Format::kTFRecord) {
+        tensorflow::TensorProto proto;
+        slice.AsProtoTensorContent(&proto);
+        TF_RETURN_IF_ERROR(
+            record_writer_->WriteRecord(proto.SerializeAsString()));
+      } else {
+        TF_RETURN_IF_ERROR(file_->Append(slice.tensor_data()));
+      }
+    }
+    ++elements_in_file_;
+  }
+  return Status::OK();
+}
+
+Status OutfeedFileSink::OpenNextFile() {
+  TF_RETURN_IF_ERROR(CloseFile());
+  const std::string file_name = FileName(prefix_, format_, file_index_++);
+  VLOG(1) << "Writing the outfeed to " << file_name;
+  TF_RETURN_IF_ERROR(
+      tensorflow::Env::Default()->NewWritableFile(file_name, &file_));
+  if (format_ == Format::kTFRecord) {
+    record_writer_ = absl::make_unique<tensorflow::io::RecordWriter>(
+        file_.get(), tensorflow::io::RecordWriterOptions());
+  }
+  elements_in_file_ = 0;
+  return Status::OK();
+}
+
+Status OutfeedFileSink::CloseFile() {
+  if (!file_) {
+    return Status::OK();
+  }
+  Status status;
+  if (record_writer_) {
+    status.Update(record_writer_->Close());
+    record_writer_.reset();
+  }
+  status.Update(file_->Close());
+  file_.reset();
+  return status;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,100 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_FILE_SINK_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_FILE_SINK_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Writes the elements of an outfeed in the GetAll mode to a sequence of files
+// on a background thread, instead of them being dequeued by TensorFlow.
+//
+// Each element is written as one record per tuple element of the outfeed, in
+// the order of the tuple elements. In the TFRecord format each record is a
+// serialized TensorProto, and in the raw format each record is the bytes of
+// the tensor. A new file named <prefix>-<index>.<extension> is started every
+// `elements_per_file` elements, or only one file is written if it is zero.
+class OutfeedFileSink {
+ public:
+  enum class Format { kTFRecord, kRaw };
+
+  OutfeedFileSink(const std::string& prefix, Format format,
+                  int64 elements_per_file, int64 max_pending_batches = 8);
+
+  // Writes the pending batches and closes the current file.
+  ~OutfeedFileSink();
+
+  // Queues a batch of elements to be written, with one tensor per tuple
+  // element and the elements in the outer dimension, as returned by
+  // OutfeedTensorRing::TakeAll. Blocks while `max_pending_batches` batches are
+  // waiting to be written.
+  void Write(std::vector<tensorflow::Tensor> batch);
+
+  // Blocks until all the queued batches have been written and flushed to the
+  // files, and returns the first error which occurred while writing them.
+  Status Flush();
+
+  static std::string FileName(const std::string& prefix, Format format,
+                              int64 index);
+
+ private:
+  void WriterLoop();
+
+  Status WriteBatch(const std::vector<tensorflow::Tensor>& batch);
+
+  Status OpenNextFile();
+
+  Status CloseFile();
+
+  const std::string prefix_;
+  const Format format_;
+  const int64 elements_per_file_;
+  const int64 max_pending_batches_;
+
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable cv_;
+  std::deque<std::vector<tensorflow::Tensor>> pending_ GUARDED_BY(mu_);
+  // Whether the writer thread is writing a batch taken from `pending_`.
+  bool writing_ GUARDED_BY(mu_) = false;
+  bool stopping_ GUARDED_BY(mu_) = false;
+  Status status_ GUARDED_BY(mu_);
+
+  // Only used by the writer thread.
+  std::unique_ptr<tensorflow::WritableFile> file_;
+  std::unique_ptr<tensorflow::io::RecordWriter> record_writer_;
+  int64 file_index_ = 0;
+  int64 elements_in_file_ = 0;
+
+  std::unique_ptr<tensorflow::Thread> thread_;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_FILE_SINK_H_
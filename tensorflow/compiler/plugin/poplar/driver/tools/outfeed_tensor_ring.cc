@@ -0,0 +1,139 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_tensor_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/algorithm/container.h"
+
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace poplarplugin {
+
+/* static */ constexpr size_t OutfeedTensorRing::kMaxReleased;
+
+OutfeedTensorRing::OutfeedTensorRing(
+    const std::vector<tensorflow::DataType>& types,
+    const std::vector<tensorflow::TensorShape>& shapes)
+    : types_(types), shapes_(shapes), element_bytes_(shapes.size()) {
+  CHECK_EQ(types_.size(), shapes_.size());
+  for (size_t i = 0; i != shapes_.size(); ++i) {
+    element_bytes_[i] =
+        shapes_[i].num_elements() * tensorflow::DataTypeSize(types_[i]);
+  }
+}
+
+/* static */ bool OutfeedTensorRing::IsFree(const Storage& storage) {
+  return absl::c_all_of(storage, [](const tensorflow::Tensor& t) {
+    const tensorflow::TensorBuffer* buffer = tensorflow::DMAHelper::buffer(&t);
+    return buffer == nullptr || buffer->RefCountIsOne();
+  });
+}
+
+void OutfeedTensorRing::Release(Storage&& storage) {
+  released_.push_back(std::move(storage));
+  if (released_.size() > kMaxReleased) {
+    released_.erase(released_.begin());
+  }
+}
+
+OutfeedTensorRing::Storage OutfeedTensorRing::Allocate(int64 capacity) {
+  Storage storage(types_.size());
+  for (size_t i = 0; i != types_.size(); ++i) {
+    tensorflow::TensorShape shape = shapes_[i];
+    shape.InsertDim(0, capacity);
+    storage[i] = tensorflow::Tensor(types_[i], shape);
+  }
+  num_allocations_++;
+  return storage;
+}
+
+void OutfeedTensorRing::Reserve(int64 count) {
+  const int64 required = num_elements_ + count;
+  if (current_.size() && required <= capacity_) {
+    return;
+  }
+
+  // Find a released storage which is large enough and no longer used.
+  Storage storage;
+  for (auto itr = released_.begin(); itr != released_.end(); ++itr) {
+    const int64 capacity = itr->empty() ? 0 : itr->at(0).dim_size(0);
+    if (capacity >= required && IsFree(*itr)) {
+      storage = std::move(*itr);
+      released_.erase(itr);
+      break;
+    }
+  }
+
+  if (storage.empty()) {
+    // Grow geometrically so that the number of reallocations is logarithmic.
+    storage = Allocate(std::max(required, 2 * capacity_));
+  }
+
+  // Move the elements which have already been written.
+  for (size_t i = 0; i != storage.size() && num_elements_; ++i) {
+    std::memcpy(tensorflow::DMAHelper::base(&storage[i]),
+                tensorflow::DMAHelper::base(&current_[i]),
+                num_elements_ * element_bytes_[i]);
+  }
+
+  if (current_.size()) {
+    Release(std::move(current_));
+  }
+  current_ = std::move(storage);
+  capacity_ = current_.empty() ? 0 : current_[0].dim_size(0);
+}
+
+char* OutfeedTensorRing::ElementData(int64 tuple_index, int64 index) {
+  DCHECK_LT(num_elements_ + index, capacity_);
+  char* base =
+      static_cast<char*>(tensorflow::DMAHelper::base(&current_[tuple_index]));
+  return base + (num_elements_ + index) * element_bytes_[tuple_index];
+}
+
+void OutfeedTensorRing::Commit(int64 count) {
+  CHECK_LE(num_elements_ + count, capacity_);
+  num_elements_ += count;
+}
+
+std::vector<tensorflow::Tensor> OutfeedTensorRing::TakeAll() {
+  std::vector<tensorflow::Tensor> outputs(types_.size());
+  if (num_elements_ == 0) {
+    for (size_t i = 0; i != types_.size(); ++i) {
+      tensorflow::TensorShape shape = shapes_[i];
+      shape.InsertDim(0, 0);
+      outputs[i] = tensorflow::Tensor(types_[i], shape);
+    }
+    return outputs;
+  }
+
+  for (size_t i = 0; i != types_.size(); ++i) {
+    outputs[i] = current_[i].Slice(0, num_elements_);
+  }
+
+  // The storage can be reused once the consumer has released the outputs.
+  Release(std::move(current_));
+  current_.clear();
+  capacity_ = 0;
+  num_elements_ = 0;
+  return outputs;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
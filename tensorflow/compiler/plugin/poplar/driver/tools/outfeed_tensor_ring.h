@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_TENSOR_RING_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_TENSOR_RING_H_
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Storage for the elements of an outfeed in the GetAll mode.
+// The elements are written directly into "stacked" tensors (one per tuple
+// element of the outfeed) with an extra outer dimension for the element index.
+// When the elements are taken, views of the stacked tensors are returned
+// without copying and the underlying storage is reused for subsequent elements
+// once all the views have been released by the consumer.
+// This class is not thread safe.
+class OutfeedTensorRing {
+ public:
+  OutfeedTensorRing(const std::vector<tensorflow::DataType>& types,
+                    const std::vector<tensorflow::TensorShape>& shapes);
+
+  // Makes sure there is space for `count` more elements.
+  void Reserve(int64 count);
+
+  // Returns a pointer to the data of the tuple element `tuple_index` of the
+  // element `index` positions after the last committed element.
+  // REQUIRES: Reserve was called with count > index.
+  char* ElementData(int64 tuple_index, int64 index);
+
+  // Marks the next `count` elements as written.
+  void Commit(int64 count);
+
+  // Number of elements which have been committed and not yet taken.
+  int64 NumElements() const { return num_elements_; }
+
+  // Returns one tensor per tuple element with shape [NumElements(), ...]
+  // containing all the committed elements, and resets the number of elements.
+  // The returned tensors alias the ring storage.
+  std::vector<tensorflow::Tensor> TakeAll();
+
+  // Number of storage buffers which have been allocated so far.
+  int64 NumAllocations() const { return num_allocations_; }
+
+ private:
+  using Storage = std::vector<tensorflow::Tensor>;
+
+  // Returns true if nobody outside of the ring references the storage.
+  static bool IsFree(const Storage& storage);
+
+  Storage Allocate(int64 capacity);
+
+  // Keeps the storage for reuse, dropping the oldest one if there are too many.
+  void Release(Storage&& storage);
+
+  const std::vector<tensorflow::DataType> types_;
+  const std::vector<tensorflow::TensorShape> shapes_;
+  std::vector<int64> element_bytes_;
+
+  // The storage currently being written to.
+  Storage current_;
+  int64 capacity_ = 0;
+  int64 num_elements_ = 0;
+
+  // Storage which has been handed out to consumers and can be reused once
+  // they have released it.
+  std::vector<Storage> released_;
+  static constexpr size_t kMaxReleased = 4;
+
+  int64 num_allocations_ = 0;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_OUTFEED_TENSOR_RING_H_
@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_conversion.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// Converts the elements [begin, end) of the buffers.
+void ConvertChunk(ParallelConverter::ConversionFn fn, const char* src,
+                  int64 src_element_size, char* dst, int64 dst_element_size,
+                  int64 begin, int64 end) {
+  const int64 count = end - begin;
+  if (count == 0) {
+    return;
+  }
+  std::vector<char> converted =
+      fn(src + begin * src_element_size, count * src_element_size,
+         count * dst_element_size);
+  std::memcpy(dst + begin * dst_element_size, converted.data(),
+              converted.size());
+}
+}  // namespace
+
+/* static */ constexpr int64 ParallelConverter::kDefaultMinChunkElements;
+
+ParallelConverter::ParallelConverter(int64 num_threads,
+                                     int64 min_chunk_elements)
+    : num_threads_(std::max<int64>(1, num_threads)),
+      min_chunk_elements_(std::max<int64>(1, min_chunk_elements)) {
+  if (num_threads_ > 1) {
+    thread_pool_ = absl::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "parallel_conversion", num_threads_);
+  }
+}
+
+ParallelConverter::~ParallelConverter() {
+  Wait();
+  thread_pool_.reset();
+}
+
+int64 ParallelConverter::NumChunks(int64 num_elements) const {
+  return std::max<int64>(
+      1, std::min<int64>(num_threads_, num_elements / min_chunk_elements_));
+}
+
+void ParallelConverter::Convert(ConversionFn fn, const void* src,
+                                int64 src_element_size, void* dst,
+                                int64 dst_element_size, int64 num_elements) {
+  const char* src_bytes = static_cast<const char*>(src);
+  char* dst_bytes = static_cast<char*>(dst);
+  if (!thread_pool_) {
+    ConvertChunk(fn, src_bytes, src_element_size, dst_bytes, dst_element_size,
+                 0, num_elements);
+    return;
+  }
+
+  const int64 num_chunks = NumChunks(num_elements);
+  const int64 chunk_elements = (num_elements + num_chunks - 1) / num_chunks;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    pending_chunks_ += num_chunks;
+  }
+  for (int64 chunk = 0; chunk != num_chunks; ++chunk) {
+    const int64 begin = chunk * chunk_elements;
+    const int64 end = std::min(num_elements, begin + chunk_elements);
+    thread_pool_->Schedule([=]() {
+      ConvertChunk(fn, src_bytes, src_element_size, dst_bytes,
+                   dst_element_size, begin, std::max(begin, end));
+      std::lock_guard<std::mutex> l(mutex_);
+      if (--pending_chunks_ == 0) {
+        done_.notify_all();
+      }
+    });
+  }
+}
+
+void ParallelConverter::Wait() {
+  std::unique_lock<std::mutex> l(mutex_);
+  done_.wait(l, [this]() { return pending_chunks_ == 0; });
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
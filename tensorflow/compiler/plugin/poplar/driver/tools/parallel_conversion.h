@@ -0,0 +1,77 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_CONVERSION_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_CONVERSION_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Converts the variables which are moved between the host and the device, for
+// example from 64 bit to 32 bit integers, with a pool of threads. The
+// conversions of different variables run at the same time, and large variables
+// are split into chunks of elements which are converted at the same time.
+//
+// Convert does not block, so the conversions can overlap other work on the
+// calling thread. Wait blocks until all the conversions which were started
+// have finished.
+class ParallelConverter {
+ public:
+  // The same signature as the ConversionFn of the executor.
+  using ConversionFn = std::vector<char> (*)(const void*, int64, int64);
+
+  static constexpr int64 kDefaultMinChunkElements = 1 << 20;
+
+  // With `num_threads` of 1 or less the conversions are done by the thread
+  // which calls Convert.
+  explicit ParallelConverter(
+      int64 num_threads, int64 min_chunk_elements = kDefaultMinChunkElements);
+  ~ParallelConverter();
+
+  // Converts `num_elements` elements of `src_element_size` bytes into `dst`
+  // with `fn`. Both buffers must stay valid until Wait returns.
+  void Convert(ConversionFn fn, const void* src, int64 src_element_size,
+               void* dst, int64 dst_element_size, int64 num_elements);
+
+  void Wait();
+
+  // The number of chunks a conversion of `num_elements` is split into.
+  int64 NumChunks(int64 num_elements) const;
+
+ private:
+  const int64 num_threads_;
+  const int64 min_chunk_elements_;
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  int64 pending_chunks_ = 0;
+
+  ParallelConverter(const ParallelConverter&) = delete;
+  ParallelConverter& operator=(const ParallelConverter&) = delete;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_CONVERSION_H_
@@ -0,0 +1,82 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_copy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+// The chunks start on cache line boundaries of the destination.
+constexpr std::size_t kChunkAlignment = 64;
+}  // namespace
+
+/* static */ constexpr std::size_t ParallelCopier::kDefaultMinChunkBytes;
+
+ParallelCopier::ParallelCopier(int64 num_threads, std::size_t min_chunk_bytes)
+    : num_threads_(std::max<int64>(1, num_threads)),
+      min_chunk_bytes_(std::max(kChunkAlignment, min_chunk_bytes)) {
+  if (num_threads_ > 1) {
+    thread_pool_ = absl::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "parallel_copy", num_threads_ - 1);
+  }
+}
+
+int64 ParallelCopier::NumChunks(std::size_t num_bytes) const {
+  return std::max<int64>(
+      1, std::min<int64>(num_threads_, num_bytes / min_chunk_bytes_));
+}
+
+void ParallelCopier::Copy(void* dest, const void* src,
+                          std::size_t num_bytes) const {
+  const int64 num_chunks = NumChunks(num_bytes);
+  if (num_chunks == 1) {
+    std::memcpy(dest, src, num_bytes);
+    return;
+  }
+
+  char* dest_bytes = static_cast<char*>(dest);
+  const char* src_bytes = static_cast<const char*>(src);
+  std::size_t chunk_bytes = (num_bytes + num_chunks - 1) / num_chunks;
+  chunk_bytes += kChunkAlignment - 1;
+  chunk_bytes -= chunk_bytes % kChunkAlignment;
+
+  auto copy_chunk = [=](int64 chunk) {
+    const std::size_t begin = chunk * chunk_bytes;
+    const std::size_t end = std::min(num_bytes, begin + chunk_bytes);
+    if (begin < end) {
+      std::memcpy(dest_bytes + begin, src_bytes + begin, end - begin);
+    }
+  };
+
+  tensorflow::BlockingCounter counter(num_chunks - 1);
+  for (int64 chunk = 1; chunk != num_chunks; ++chunk) {
+    thread_pool_->Schedule([&counter, &copy_chunk, chunk]() {
+      copy_chunk(chunk);
+      counter.DecrementCount();
+    });
+  }
+  copy_chunk(0);
+  counter.Wait();
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,59 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_COPY_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_COPY_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace poplarplugin {
+
+// Copies large buffers with several threads, as a single thread usually can
+// not use all of the memory bandwidth of the host. Buffers which are smaller
+// than two chunks are copied by the calling thread. The calling thread copies
+// one of the chunks itself and waits for the others, so Copy can be called by
+// several threads at the same time.
+class ParallelCopier {
+ public:
+  static constexpr std::size_t kDefaultMinChunkBytes = 4 << 20;
+
+  // `num_threads` includes the calling thread, so with 1 or less all the
+  // copies are done by the calling thread.
+  explicit ParallelCopier(int64 num_threads,
+                          std::size_t min_chunk_bytes = kDefaultMinChunkBytes);
+
+  void Copy(void* dest, const void* src, std::size_t num_bytes) const;
+
+  // The number of chunks a copy of `num_bytes` is split into.
+  int64 NumChunks(std::size_t num_bytes) const;
+
+ private:
+  const int64 num_threads_;
+  const std::size_t min_chunk_bytes_;
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool_;
+
+  ParallelCopier(const ParallelCopier&) = delete;
+  ParallelCopier& operator=(const ParallelCopier&) = delete;
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PARALLEL_COPY_H_
@@ -0,0 +1,47 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/tools/planning_caches.h"
+
+#include <mutex>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/hash.h"
+
+namespace xla {
+namespace poplarplugin {
+
+/* static */ std::shared_ptr<PlanningCaches> PlanningCaches::ForTarget(
+    const poplar::Target& target) {
+  // The poplibs caches are not keyed by the target, so a separate set of
+  // caches is kept for each target.
+  const std::size_t key = hash_util::hash(
+      target.getNumTiles(), target.getDataPathWidth(), target.getBytesPerTile(),
+      target.getNumWorkerContexts(), target.getTilesPerIPU(),
+      target.getNumIPUs(), static_cast<unsigned>(target.getTargetType()));
+
+  static std::mutex mu;
+  static auto* caches =
+      new absl::flat_hash_map<std::size_t, std::shared_ptr<PlanningCaches>>();
+
+  std::lock_guard<std::mutex> lock(mu);
+  auto& target_caches = (*caches)[key];
+  if (!target_caches) {
+    target_caches = std::make_shared<PlanningCaches>();
+  }
+  return target_caches;
+}
+
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,50 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PLANNING_CACHES_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PLANNING_CACHES_H_
+
+#include <memory>
+
+#include <poplar/Target.hpp>
+#include <poplin/Convolution.hpp>
+#include <poplin/MatMul.hpp>
+
+namespace xla {
+namespace poplarplugin {
+
+// The poplibs convolution and matrix multiplication planning caches.
+//
+// The plans only depend on the parameters, the options and the target, so the
+// caches are shared by all the compilations for the same target in the
+// process. Recompiling a module, or compiling a variant of it, then does not
+// plan the same operations again. The poplibs caches are not thread safe - they
+// must only be used while holding the compiler lock.
+struct PlanningCaches {
+  poplin::PlanningCache convolution_cache;
+
+  poplin::matmul::PlanningCache matmul_cache;
+
+  poplin::matmul::PlanningCache dot_cache;
+
+  // Returns the caches shared by all the compilations for targets with the
+  // same properties as `target`.
+  static std::shared_ptr<PlanningCaches> ForTarget(
+      const poplar::Target& target);
+};
+
+}  // namespace poplarplugin
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_PLANNING_CACHES_H_
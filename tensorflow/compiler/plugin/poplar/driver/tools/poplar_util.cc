@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 
+#include <sys/resource.h>
+
 #include <algorithm>
 #include <fstream>
 #include <limits>
@@ -22,7 +24,9 @@ limitations under the License.
 #include <popops/Zero.hpp>
 #include <poputil/TileMapping.hpp>
 #include <regex>
+#include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
@@ -86,6 +90,23 @@ poplar::Graph& GetGraphWithOutputIndex(CompilerResources& res,
   return GetMasterGraph(res);
 }
 
+poplar::Graph* GetIoGraphWithOutputIndex(CompilerResources& res,
+                                         const HloInstruction* inst,
+                                         int flattened_output_tuple_index) {
+  if (res.shard_io_graphs.empty() || !inst->has_sharding()) {
+    return nullptr;
+  }
+
+  const uint64 device_id =
+      GetShardForOutputIndex(inst, flattened_output_tuple_index);
+  if (device_id >= res.shard_io_graphs.size()) {
+    LOG(FATAL) << "Graph index " << device_id << " out of range on "
+               << inst->ToString();
+  }
+
+  return &res.shard_io_graphs[device_id];
+}
+
 poplar::Graph& GetGraph(CompilerResources& res, const HloInstruction* inst) {
   return GetGraphWithOutputIndex(res, inst, 0);
 }
@@ -340,6 +361,15 @@ bool IsInPipeline(const HloInstruction* inst, CompilerResources& res) {
   return call_sites.size() == 1 && IsPipelineOp(call_sites[0].instruction());
 }
 
+uint64 GetPeakHostMemoryBytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // The maximum resident set size is in kilobytes.
+  return static_cast<uint64>(usage.ru_maxrss) * 1024;
+}
+
 StatusOr<std::string> GetInstructionCompilationInfo(
     const std::unique_ptr<xla::HloModule>& module, CompilerResources& res) {
   TF_ASSIGN_OR_RETURN(auto ml_type_map, GetAllNotNoneMlTypes(module.get()));
@@ -349,8 +379,93 @@ StatusOr<std::string> GetInstructionCompilationInfo(
     ml_types[GetDebugName(t.first)] = Json::Value::UInt64(t.second);
   }
 
+  // The output bytes of each instruction, in total, on its busiest tile, and
+  // on each tile if the outputs were spread evenly over the tiles.
+  struct OutputBytes {
+    uint64 total = 0;
+    uint64 max_tile = 0;
+    uint64 balanced_tile = 0;
+  };
+  absl::flat_hash_map<const HloInstruction*, OutputBytes> output_bytes;
+  if (res.main_graph) {
+    const poplar::Graph& graph = *res.main_graph;
+    for (const auto& tm : res.tensor_maps) {
+      for (const auto& tensor : tm.tensor_map) {
+        if (!tensor.tensor.IsTensor()) {
+          continue;
+        }
+        const poplar::Tensor t = tensor.tensor.AsTensor();
+        const uint64 type_size = graph.getTarget().getTypeSize(t.elementType());
+        const TileImbalance imbalance = GetTileImbalance(graph, t);
+        auto& bytes = output_bytes[tensor.location.instruction];
+        bytes.total += t.numElements() * type_size;
+        bytes.max_tile = std::max<uint64>(
+            bytes.max_tile, imbalance.max_tile_elements * type_size);
+        bytes.balanced_tile = std::max<uint64>(
+            bytes.balanced_tile, imbalance.balanced_tile_elements * type_size);
+      }
+    }
+  }
+
+  // The compile time and output bytes of each instruction, and their totals
+  // for each TensorFlow op, which are used to find the layers of a model which
+  // take the longest to compile or use the most memory.
+  Json::Value instructions(Json::objectValue);
+  Json::Value ops(Json::objectValue);
+  for (auto* comp : module->computations()) {
+    for (auto* inst : comp->instructions()) {
+      auto compile_itr = res.instruction_compile_nanos.find(inst);
+      auto bytes_itr = output_bytes.find(inst);
+      if (compile_itr == res.instruction_compile_nanos.end() &&
+          bytes_itr == output_bytes.end()) {
+        continue;
+      }
+      const uint64 compile_nanos =
+          compile_itr == res.instruction_compile_nanos.end()
+              ? 0
+              : compile_itr->second;
+      const OutputBytes bytes =
+          bytes_itr == output_bytes.end() ? OutputBytes() : bytes_itr->second;
+
+      Json::Value info;
+      info["op_type"] = inst->metadata().op_type();
+      info["op_name"] = inst->metadata().op_name();
+      info["compile_nanos"] = Json::Value::UInt64(compile_nanos);
+      info["output_bytes"] = Json::Value::UInt64(bytes.total);
+      info["max_tile_output_bytes"] = Json::Value::UInt64(bytes.max_tile);
+      info["balanced_tile_output_bytes"] =
+          Json::Value::UInt64(bytes.balanced_tile);
+      instructions[inst->name()] = info;
+
+      // The time of the instructions which call computations includes the
+      // time of the instructions they call, which are counted separately.
+      const bool calls_computations =
+          inst->opcode() == HloOpcode::kCall ||
+          inst->opcode() == HloOpcode::kWhile ||
+          inst->opcode() == HloOpcode::kConditional;
+      if (!inst->metadata().op_name().empty() && !calls_computations) {
+        Json::Value& op = ops[inst->metadata().op_name()];
+        op["op_type"] = inst->metadata().op_type();
+        op["compile_nanos"] =
+            Json::Value::UInt64(op["compile_nanos"].asUInt64() + compile_nanos);
+        op["output_bytes"] =
+            Json::Value::UInt64(op["output_bytes"].asUInt64() + bytes.total);
+      }
+    }
+  }
+
   Json::Value root;
   root["ml_types"] = ml_types;
+  root["instructions"] = instructions;
+  root["ops"] = ops;
+  Json::Value tile_imbalance;
+  tile_imbalance["rebalanced_tensors"] =
+      Json::Value::UInt64(res.tile_imbalance_stats.num_rebalanced_tensors);
+  tile_imbalance["max_tile_bytes_saved"] =
+      Json::Value::UInt64(res.tile_imbalance_stats.max_tile_bytes_saved);
+  root["tile_imbalance"] = tile_imbalance;
+  root["peak_host_memory_bytes"] =
+      Json::Value::UInt64(GetPeakHostMemoryBytes());
 
   Json::StreamWriterBuilder json_builder;
   json_builder["indentation"] = "";
@@ -684,6 +799,17 @@ StatusOr<const popops::SlicePlan*> GetSlicePlan(CompilerResources& res,
   return plan->second;
 }
 
+StatusOr<std::vector<const popsparse::experimental::BSMatMulParams*>>
+GetBlockSparsePlans(CompilerResources& res, const HloInstruction* inst) {
+  auto plans = res.block_sparse_plan_mappings.find(inst);
+  if (plans == res.block_sparse_plan_mappings.end()) {
+    return xla::FailedPrecondition(
+        "Could not find a block-sparse matmul plan for %s.",
+        inst->ToString().c_str());
+  }
+  return plans->second;
+}
+
 DeferredArgVectors ConvertInputsToDeferredInputs(TensorVectors& inputs) {
   DeferredArgVectors deferred_inputs(inputs.size());
   for (uint64 i = 0; i != inputs.size(); ++i) {
@@ -51,6 +51,12 @@ namespace popops {
 class SlicePlan;
 }  // namespace popops
 
+namespace popsparse {
+namespace experimental {
+class BSMatMulParams;
+}  // namespace experimental
+}  // namespace popsparse
+
 namespace xla {
 class HloModule;
 class HloInstruction;
@@ -83,6 +89,12 @@ poplar::Graph& GetGraphWithOutputIndex(CompilerResources&,
                                        const HloInstruction*,
                                        int flattened_output_tuple_index);
 
+// Get the graph of the IO tiles of the IPU a particular output of an operation
+// is on, or nullptr if no IO tiles are reserved.
+poplar::Graph* GetIoGraphWithOutputIndex(CompilerResources&,
+                                         const HloInstruction*,
+                                         int flattened_output_tuple_index);
+
 // Convert a poplar/poplibs exception to a Tensorflow error Status
 Status PoplarExceptionToTensorflowStatus(const std::string& origin,
                                          const std::exception& e);
@@ -128,6 +140,9 @@ bool IsReplicaPartitioned(HloInstruction* inst, const CompilerResources& res);
 
 bool IsInPipeline(const HloInstruction* inst, CompilerResources& res);
 
+// Returns the largest amount of host memory the process has used so far.
+uint64 GetPeakHostMemoryBytes();
+
 StatusOr<std::string> GetInstructionCompilationInfo(
     const std::unique_ptr<xla::HloModule>& module, CompilerResources& res);
 
@@ -150,6 +165,10 @@ bool SlicePlanHasAllocation(CompilerResources& res,
 StatusOr<const popops::SlicePlan*> GetSlicePlan(CompilerResources& res,
                                                 const HloInstruction* inst);
 
+// Get the block-sparse matmul plans for an instruction.
+StatusOr<std::vector<const popsparse::experimental::BSMatMulParams*>>
+GetBlockSparsePlans(CompilerResources& res, const HloInstruction* inst);
+
 // A helper function to convert inputs into deferred inputs.
 using DeferredArgVectors =
     std::vector<std::vector<absl::optional<poplar::Tensor>>>;
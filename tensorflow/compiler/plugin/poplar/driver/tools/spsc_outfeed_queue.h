@@ -33,26 +33,30 @@ namespace poplarplugin {
  * We also keep track of the threads which are blocked and currently waiting to
  * write.
  *
- * \tparam Capacity The capacity of the queue.
+ * \tparam Capacity The capacity of the queue, or `kDynamicCapacity` when it is
+ *         passed to the constructor.
  */
-template <std::size_t Capacity>
+template <std::size_t Capacity = kDynamicCapacity>
 class SPSCOutfeedQueue : SPSCQueue<void*, Capacity> {
  public:
   /**
    * Construct the SPSCOutfeedQueue.
    *
    * \param element_size The size of each buffer in the queue.
+   * \param capacity The capacity of the queue.
    */
-  explicit SPSCOutfeedQueue(std::size_t element_size)
+  explicit SPSCOutfeedQueue(std::size_t element_size,
+                            std::size_t capacity = Capacity)
       : SPSCQueue<void*, Capacity>(nullptr,
                                    [](void*& ptr) {
                                      if (ptr) {
                                        tensorflow::port::AlignedFree(ptr);
                                        ptr = nullptr;
                                      }
-                                   }),
+                                   },
+                                   capacity),
         items_waiting_(0) {
-    for (std::size_t i = 0; i != Capacity; ++i) {
+    for (std::size_t i = 0; i != GetCapacity(); ++i) {
       buffer_[i] = tensorflow::port::AlignedMalloc(element_size, 64);
     }
   }
@@ -66,7 +70,11 @@ class SPSCOutfeedQueue : SPSCQueue<void*, Capacity> {
    */
   inline void*& BlockBack() {
     std::atomic_fetch_add(&items_waiting_, std::size_t{1});
-    while (SPSCQueue<void*, Capacity>::IsFull()) {
+    if (SPSCQueue<void*, Capacity>::IsFull()) {
+      const auto start = std::chrono::steady_clock::now();
+      while (SPSCQueue<void*, Capacity>::IsFull()) {
+      }
+      SPSCQueue<void*, Capacity>::RecordPushBlocked(start);
     }
 
     return buffer_[write_position_];
@@ -88,7 +96,11 @@ class SPSCOutfeedQueue : SPSCQueue<void*, Capacity> {
    * \param item The element to push.
    */
   inline void*& BlockFront() {
-    while (SPSCQueue<void*, Capacity>::IsEmpty()) {
+    if (SPSCQueue<void*, Capacity>::IsEmpty()) {
+      const auto start = std::chrono::steady_clock::now();
+      while (SPSCQueue<void*, Capacity>::IsEmpty()) {
+      }
+      SPSCQueue<void*, Capacity>::RecordPopBlocked(start);
     }
 
     return buffer_[read_position_];
@@ -114,6 +126,9 @@ class SPSCOutfeedQueue : SPSCQueue<void*, Capacity> {
     return std::atomic_load(&items_waiting_);
   }
 
+  using SPSCQueue<void*, Capacity>::GetCapacity;
+  using SPSCQueue<void*, Capacity>::GetStats;
+
   using SPSCQueue<void*, Capacity>::buffer_;
   using SPSCQueue<void*, Capacity>::write_position_;
   using SPSCQueue<void*, Capacity>::read_position_;
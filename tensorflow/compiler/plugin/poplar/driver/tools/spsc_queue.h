@@ -16,11 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_SPSC_QUEUE_H_
 #define TENSORFLOW_COMPILER_PLUGIN_POPLAR_DRIVER_TOOLS_SPSC_QUEUE_H_
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace xla {
@@ -30,8 +35,35 @@ namespace {
 constexpr bool is_powerof2(std::size_t v) { return v && ((v & (v - 1)) == 0); }
 }  // namespace
 
+// When used as the `Capacity` of a SPSCQueue, the capacity is instead passed to
+// the constructor.
+constexpr std::size_t kDynamicCapacity = 0;
+
 /**
- * Statically bounded single-producer/single-consumer lock-free queue.
+ * Counters of the operations on a SPSCQueue, which are always collected.
+ */
+struct SPSCQueueStats {
+  std::uint64_t push_count = 0;
+  std::uint64_t pop_count = 0;
+  // Time the producer was blocked because the queue was full.
+  std::uint64_t push_blocked_nanos = 0;
+  // Time the consumer was blocked because the queue was empty.
+  std::uint64_t pop_blocked_nanos = 0;
+  // The largest number of elements which were in the queue at once.
+  std::size_t high_water_mark = 0;
+
+  SPSCQueueStats& operator+=(const SPSCQueueStats& other) {
+    push_count += other.push_count;
+    pop_count += other.pop_count;
+    push_blocked_nanos += other.push_blocked_nanos;
+    pop_blocked_nanos += other.pop_blocked_nanos;
+    high_water_mark = std::max(high_water_mark, other.high_water_mark);
+    return *this;
+  }
+};
+
+/**
+ * Bounded single-producer/single-consumer lock-free queue.
  *
  * This can be used for buffered unidirectional communication between two
  * threads. https://en.wikipedia.org/wiki/Producer–consumer_problem
@@ -40,14 +72,20 @@ constexpr bool is_powerof2(std::size_t v) { return v && ((v & (v - 1)) == 0); }
  * This is achieved through the `post_apply` function, which can be used for
  * resource management purely on the "Push" thread.
  *
+ * The capacity is either fixed at compile time, or chosen when the queue is
+ * constructed when `Capacity` is `kDynamicCapacity`, in which case the buffer
+ * is allocated on the heap. Either way it must be a power of 2.
+ *
  * \tparam T The element type to store in the queue.
  * \tparam Capacity The capacity of the queue.
  */
-template <typename T, std::size_t Capacity>
+template <typename T, std::size_t Capacity = kDynamicCapacity>
 class SPSCQueue {
-  static_assert(is_powerof2(Capacity),
+  static constexpr bool kIsDynamic = Capacity == kDynamicCapacity;
+  static_assert(kIsDynamic || is_powerof2(Capacity),
                 "SPSCQueue requires a power of 2 capacity");
-  static_assert(Capacity > 8, "SPSCQueue requires a capacity greater than 8");
+  static_assert(kIsDynamic || Capacity > 8,
+                "SPSCQueue requires a capacity greater than 8");
 
  public:
   /**
@@ -56,16 +94,23 @@ class SPSCQueue {
    * \param init The initial value to fill the queue.
    * \param post_apply The function that is called on each element after it has
    *        been popped.
+   * \param capacity The capacity of the queue, which must be `Capacity` unless
+   *        it is `kDynamicCapacity`.
    *
    * \note post_apply must be resistant to multiple applications on the same
    *       element.
    */
-  explicit SPSCQueue(T init, std::function<void(T&)> post_apply)
+  explicit SPSCQueue(T init, std::function<void(T&)> post_apply,
+                     std::size_t capacity = Capacity)
       : size_(0),
         write_position_(0),
         read_position_(0),
-        post_apply_(post_apply) {
+        post_apply_(post_apply),
+        capacity_(capacity) {
     assert(post_apply);
+    assert(is_powerof2(capacity_) && capacity_ > 8);
+    assert(kIsDynamic || capacity_ == Capacity);
+    Resize(buffer_, capacity_);
     std::fill(buffer_.begin(), buffer_.end(), init);
   }
 
@@ -82,8 +127,12 @@ class SPSCQueue {
    *
    */
   inline void AdvanceWritePosition() {
-    write_position_ = (write_position_ + 1) % Capacity;
-    std::atomic_fetch_add(&size_, std::size_t{1});
+    write_position_ = (write_position_ + 1) & (GetCapacity() - 1);
+    const std::size_t size = std::atomic_fetch_add(&size_, std::size_t{1}) + 1;
+    Increment(push_count_, 1);
+    if (size > high_water_mark_.load(std::memory_order_relaxed)) {
+      high_water_mark_.store(size, std::memory_order_relaxed);
+    }
   }
 
   /**
@@ -107,7 +156,11 @@ class SPSCQueue {
    * \param item The element to push.
    */
   inline void BlockPush(const T& item) {
-    while (IsFull()) {
+    if (IsFull()) {
+      const auto start = std::chrono::steady_clock::now();
+      while (IsFull()) {
+      }
+      RecordPushBlocked(start);
     }
 
     Push(item);
@@ -136,8 +189,9 @@ class SPSCQueue {
    *
    */
   inline void AdvanceReadPosition() {
-    read_position_ = (read_position_ + 1) % Capacity;
+    read_position_ = (read_position_ + 1) & (GetCapacity() - 1);
     std::atomic_fetch_sub(&size_, std::size_t{1});
+    Increment(pop_count_, 1);
   }
 
   /**
@@ -153,7 +207,7 @@ class SPSCQueue {
     assert(!IsEmpty());
     assert(std::atomic_load(&size_) > look_ahead);
 
-    item = buffer_[(read_position_ + look_ahead) % Capacity];
+    item = buffer_[(read_position_ + look_ahead) & (GetCapacity() - 1)];
   }
 
   /**
@@ -162,7 +216,11 @@ class SPSCQueue {
    * \param item The element to pop into.
    */
   inline void BlockPop(T& item, std::size_t look_ahead = 0) {
-    while (std::atomic_load(&size_) <= look_ahead) {
+    if (std::atomic_load(&size_) <= look_ahead) {
+      const auto start = std::chrono::steady_clock::now();
+      while (std::atomic_load(&size_) <= look_ahead) {
+      }
+      RecordPopBlocked(start);
     }
 
     Pop(item, look_ahead);
@@ -185,13 +243,29 @@ class SPSCQueue {
     return true;
   }
 
+  /**
+   * The number of elements in the queue.
+   *
+   * \return The number of elements which have been pushed but not popped.
+   */
+  inline std::size_t Size() const { return std::atomic_load(&size_); }
+
   /**
    * Test whether the queue is full.
    *
    * \return True if the queue is full, otherwise false.
    */
   inline bool IsFull() const {
-    return std::atomic_load(&size_) >= Capacity - 8;
+    return std::atomic_load(&size_) >= GetCapacity() - 8;
+  }
+
+  /**
+   * The capacity of the queue.
+   *
+   * \return The number of slots in the queue.
+   */
+  inline std::size_t GetCapacity() const {
+    return kIsDynamic ? capacity_ : Capacity;
   }
 
   /**
@@ -201,14 +275,83 @@ class SPSCQueue {
    */
   inline bool IsEmpty() const { return std::atomic_load(&size_) == 0; }
 
+  /**
+   * Record time the producer spent waiting for space in the queue, outside of
+   * `BlockPush`. This is only safe to call on the thread which pushes to the
+   * queue.
+   *
+   * \param start When the producer started waiting.
+   */
+  inline void RecordPushBlocked(std::chrono::steady_clock::time_point start) {
+    Increment(push_blocked_nanos_, NanosSince(start));
+  }
+
+  /**
+   * Record time the consumer spent waiting for an element, outside of
+   * `BlockPop`. This is only safe to call on the thread which pops from the
+   * queue.
+   *
+   * \param start When the consumer started waiting.
+   */
+  inline void RecordPopBlocked(std::chrono::steady_clock::time_point start) {
+    Increment(pop_blocked_nanos_, NanosSince(start));
+  }
+
+  /**
+   * Get the counters of the queue. They can be read from any thread.
+   *
+   * \return The counters since the queue was created.
+   */
+  SPSCQueueStats GetStats() const {
+    SPSCQueueStats stats;
+    stats.push_count = push_count_.load(std::memory_order_relaxed);
+    stats.pop_count = pop_count_.load(std::memory_order_relaxed);
+    stats.push_blocked_nanos =
+        push_blocked_nanos_.load(std::memory_order_relaxed);
+    stats.pop_blocked_nanos = pop_blocked_nanos_.load(std::memory_order_relaxed);
+    stats.high_water_mark = high_water_mark_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
  protected:
-  std::array<T, Capacity> buffer_;
+  // Each counter is only written by one thread, so a relaxed load and store is
+  // enough and avoids a read-modify-write.
+  static inline void Increment(std::atomic<std::uint64_t>& counter,
+                               std::uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  static inline std::uint64_t NanosSince(
+      std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  using Storage = typename std::conditional<kIsDynamic, std::vector<T>,
+                                            std::array<T, Capacity>>::type;
+  static void Resize(std::array<T, Capacity>&, std::size_t) {}
+  static void Resize(std::vector<T>& buffer, std::size_t size) {
+    buffer.resize(size);
+  }
+
+  Storage buffer_;
 
   alignas(64) std::atomic<std::size_t> size_;
   alignas(64) std::size_t write_position_;
   alignas(64) std::size_t read_position_;
 
   std::function<void(T&)> post_apply_;
+  const std::size_t capacity_;
+
+  // Counters written by the producer.
+  alignas(64) std::atomic<std::uint64_t> push_count_{0};
+  std::atomic<std::uint64_t> push_blocked_nanos_{0};
+  std::atomic<std::size_t> high_water_mark_{0};
+  // Counters written by the consumer.
+  alignas(64) std::atomic<std::uint64_t> pop_count_{0};
+  std::atomic<std::uint64_t> pop_blocked_nanos_{0};
 };
 }  // namespace poplarplugin
 }  // namespace xla
@@ -16,9 +16,11 @@ limitations under the License.
 
 #include <utility>
 
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
 
 namespace xla {
 namespace poplarplugin {
@@ -52,7 +54,34 @@ SubcomputationGraphCache::GetOrCompileSubcomputation(
     VLOG(1) << "Computation " << computation->name()
             << " has already been compiled, reusing the code.";
   }
-  return itr->second;
+
+  std::shared_ptr<DeferredVisitor> result = itr->second;
+  if (PoplarXlaFlags::Get().low_memory_compilation &&
+      --RemainingCallers(computation) <= 0) {
+    // The callers own the visitor for as long as they need it.
+    VLOG(2) << "Releasing sub-computation " << computation->name();
+    table_.erase(itr);
+  }
+  return result;
+}
+
+int64& SubcomputationGraphCache::RemainingCallers(
+    const HloComputation* computation) {
+  const HloModule* module = computation->parent();
+  if (module != counted_module_) {
+    // Counting every caller, and not only the ones which use the cache, can
+    // only keep an entry for longer than needed.
+    remaining_callers_.clear();
+    for (const HloComputation* comp : module->computations()) {
+      for (const HloInstruction* inst : comp->instructions()) {
+        for (const HloComputation* called : inst->called_computations()) {
+          remaining_callers_[called]++;
+        }
+      }
+    }
+    counted_module_ = module;
+  }
+  return remaining_callers_[computation];
 }
 }  // namespace subcomputation_graph_caching
 }  // namespace poplarplugin
@@ -41,9 +41,20 @@ class SubcomputationGraphCache {
       const HloComputation* computation);
 
  private:
+  // Returns the number of callers of the computation, and of the computations
+  // equal to it, which have not got it from the cache yet.
+  int64& RemainingCallers(const HloComputation* computation);
+
   std::unordered_map<const HloComputation*, std::shared_ptr<DeferredVisitor>,
                      HloComputationHash, HloComputationEquals>
       table_;
+
+  // Only used with --low_memory_compilation, so that the entries can be
+  // removed once all their callers have been lowered.
+  std::unordered_map<const HloComputation*, int64, HloComputationHash,
+                     HloComputationEquals>
+      remaining_callers_;
+  const HloModule* counted_module_ = nullptr;
 };
 
 }  // namespace subcomputation_graph_caching
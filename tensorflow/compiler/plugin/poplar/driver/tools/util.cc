@@ -15,7 +15,10 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_split.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/backend_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/ipu_inter_copy.h"
@@ -361,6 +364,16 @@ int64 GetRepeatLoopCount(const HloInstruction* inst) {
   return cfg.call_config().repeat_config().repeat_count();
 }
 
+bool HasRuntimeRepeatCount(const HloInstruction* inst) {
+  PoplarBackendConfig cfg = ParsePoplarBackendConfig(inst);
+  return cfg.call_config().repeat_config().runtime_repeat_count();
+}
+
+int64 GetRuntimeRepeatCountIndex(const HloInstruction* inst) {
+  PoplarBackendConfig cfg = ParsePoplarBackendConfig(inst);
+  return cfg.call_config().repeat_config().repeat_count_index();
+}
+
 bool GetRepeatLoopAllowFinerAliasAnalysis(const HloInstruction* inst) {
   PoplarBackendConfig cfg = ParsePoplarBackendConfig(inst);
   return cfg.call_config().repeat_config().allow_finer_alias_analysis();
@@ -469,6 +482,48 @@ const HloInstruction* GetOperandLookThroughInterIpuCopy(
 
 bool UseSyntheticData() { return PoplarXlaFlags::Get().use_synthetic_data; }
 
+bool UseSyntheticDataFor(SyntheticDataCategory category) {
+  const PoplarXlaFlags& flags = PoplarXlaFlags::Get();
+  if (!flags.use_synthetic_data) {
+    return false;
+  }
+  static const absl::flat_hash_set<std::string> categories = [&flags]() {
+    std::vector<std::string> names = absl::StrSplit(
+        flags.synthetic_data_categories, ',', absl::SkipEmpty());
+    return absl::flat_hash_set<std::string>(names.begin(), names.end());
+  }();
+  if (categories.empty()) {
+    return true;
+  }
+  switch (category) {
+    case SyntheticDataCategory::Infeed:
+      return categories.contains("infeed");
+    case SyntheticDataCategory::Outfeed:
+      return categories.contains("outfeed");
+    case SyntheticDataCategory::Parameters:
+      return categories.contains("parameters");
+    case SyntheticDataCategory::Seed:
+      return categories.contains("seed");
+    case SyntheticDataCategory::HostEmbedding:
+      return categories.contains("hostembedding");
+  }
+  return true;
+}
+
+bool UseSyntheticDataForFeed(SyntheticDataCategory category,
+                             const std::string& feed_id) {
+  if (!UseSyntheticDataFor(category)) {
+    return false;
+  }
+  static const absl::flat_hash_set<std::string> feeds = []() {
+    std::vector<std::string> names =
+        absl::StrSplit(PoplarXlaFlags::Get().synthetic_data_feeds, ',',
+                       absl::SkipEmpty());
+    return absl::flat_hash_set<std::string>(names.begin(), names.end());
+  }();
+  return feeds.empty() || feeds.contains(feed_id);
+}
+
 bool UseSyntheticDataInitializer() {
   return !PoplarXlaFlags::Get().synthetic_data_initializer.empty();
 }
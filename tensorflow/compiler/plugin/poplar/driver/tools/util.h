@@ -132,6 +132,8 @@ bool IsArithmeticExpressionFusion(const HloComputation*);
 bool IsArithmeticExpressionFusion(const HloInstruction*);
 bool IsRepeatLoop(const HloInstruction*);
 int64 GetRepeatLoopCount(const HloInstruction*);
+bool HasRuntimeRepeatCount(const HloInstruction*);
+int64 GetRuntimeRepeatCountIndex(const HloInstruction*);
 bool GetRepeatLoopAllowFinerAliasAnalysis(const HloInstruction*);
 bool IsPipelineStage(const HloInstruction*);
 bool IsPipelineStageBackward(const HloInstruction*);
@@ -161,10 +163,28 @@ const HloInstruction* GetOperandLookThroughInterIpuCopy(
     const HloInstruction* inst, const int64 operand_idx);
 
 // This function returns true if the environment variable flag
-// "use_synthetic_data" has been set. Using synthetic data means that *no data*
-// ill be copied to/from the device.
+// "use_synthetic_data" has been set. Using synthetic data means that no data
+// will be copied to/from the device, or only some of it when
+// "synthetic_data_categories" or "synthetic_data_feeds" are set.
 bool UseSyntheticData();
 
+// The kinds of data which can be synthetic, see "synthetic_data_categories".
+enum class SyntheticDataCategory {
+  Infeed,
+  Outfeed,
+  Parameters,
+  Seed,
+  HostEmbedding,
+};
+
+// Returns true if synthetic data is used for the given kind of data.
+bool UseSyntheticDataFor(SyntheticDataCategory category);
+
+// Returns true if synthetic data is used for the infeed or outfeed with the
+// given name, see "synthetic_data_feeds".
+bool UseSyntheticDataForFeed(SyntheticDataCategory category,
+                             const std::string& feed_id);
+
 // This function returns true if the environment variable flag
 // "synthetic_data_initializer" has been set. Using this flag means that all the
 // inputs to the graph will be initialized to some constant, meaning that all
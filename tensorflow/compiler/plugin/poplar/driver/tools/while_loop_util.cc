@@ -17,10 +17,14 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 
+#include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_evaluator.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/while_loop_analysis.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
 
 #include <map>
 #include <set>
@@ -77,6 +81,98 @@ absl::optional<int64> GetLoopCounter(const HloInstruction* loop_counter) {
   }
   return absl::nullopt;
 }
+
+bool IsInductionVariable(const HloInstruction* inst, int64 tuple_index) {
+  return WhileLoopUtil::IsGTEFromParamIndex(inst, 0) &&
+         inst->tuple_index() == tuple_index;
+}
+
+// Returns the direction which gives the same result when the operands of the
+// comparison are swapped.
+ComparisonDirection SwapComparisonDirection(ComparisonDirection direction) {
+  switch (direction) {
+    case ComparisonDirection::kLt:
+      return ComparisonDirection::kGt;
+    case ComparisonDirection::kLe:
+      return ComparisonDirection::kGe;
+    case ComparisonDirection::kGt:
+      return ComparisonDirection::kLt;
+    case ComparisonDirection::kGe:
+      return ComparisonDirection::kLe;
+    default:
+      return direction;
+  }
+}
+
+// Returns the number of values of the sequence init, init + step, ... for which
+// "value direction bound" holds before it first fails, or nullopt if it never
+// fails.
+absl::optional<int64> ClosedFormTripCount(ComparisonDirection direction,
+                                          int64 init, int64 bound,
+                                          int64 step) {
+  bool initially_true;
+  switch (direction) {
+    case ComparisonDirection::kEq:
+      initially_true = init == bound;
+      break;
+    case ComparisonDirection::kNe:
+      initially_true = init != bound;
+      break;
+    case ComparisonDirection::kLt:
+      initially_true = init < bound;
+      break;
+    case ComparisonDirection::kLe:
+      initially_true = init <= bound;
+      break;
+    case ComparisonDirection::kGt:
+      initially_true = init > bound;
+      break;
+    case ComparisonDirection::kGe:
+    default:
+      initially_true = init >= bound;
+      break;
+  }
+
+  if (!initially_true) {
+    return 0;
+  }
+
+  if (step == 0) {
+    return absl::nullopt;
+  }
+
+  switch (direction) {
+    case ComparisonDirection::kEq:
+      return 1;
+    case ComparisonDirection::kNe:
+      if ((bound - init) % step == 0 && (bound - init) / step > 0) {
+        return (bound - init) / step;
+      }
+      break;
+    case ComparisonDirection::kLt:
+      if (step > 0) {
+        return CeilOfRatio(bound - init, step);
+      }
+      break;
+    case ComparisonDirection::kLe:
+      if (step > 0) {
+        return (bound - init) / step + 1;
+      }
+      break;
+    case ComparisonDirection::kGt:
+      if (step < 0) {
+        return CeilOfRatio(init - bound, -step);
+      }
+      break;
+    case ComparisonDirection::kGe:
+    default:
+      if (step < 0) {
+        return (init - bound) / -step + 1;
+      }
+      break;
+  }
+  return absl::nullopt;
+}
 }  // namespace
 
 bool WhileLoopUtil::IsGTEFromParamIndex(const HloInstruction* inst,
@@ -129,5 +225,109 @@ WhileLoopUtil::FindMatchingLoopDeltasInsideBody(
   return ret;
 }
 
+StatusOr<int64> WhileLoopUtil::ComputeTripCount(HloInstruction* while_inst) {
+  static const char* err_msg = "Unable to compute the trip count";
+  const HloComputation* while_condition = while_inst->while_condition();
+  const HloComputation* while_body = while_inst->while_body();
+
+  // Any side effecting instructions in the condition would not be executed
+  // once the loop has been converted.
+  if (absl::c_any_of(while_condition->instructions(),
+                     [](const HloInstruction* inst) {
+                       return inst->HasSideEffect();
+                     })) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  absl::optional<int64> optional_tuple_index =
+      GetLoopInductionVarTupleIdx(while_inst);
+  if (!optional_tuple_index) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  const int64 tuple_index = *optional_tuple_index;
+
+  // The condition has to be of the form "i COMP N" or "N COMP i" where N is an
+  // integer constant.
+  const HloInstruction* compare = while_condition->root_instruction();
+  if (compare->opcode() != HloOpcode::kCompare) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  ComparisonDirection direction = compare->comparison_direction();
+  const HloInstruction* bound;
+  if (IsInductionVariable(compare->operand(0), tuple_index)) {
+    bound = compare->operand(1);
+  } else if (IsInductionVariable(compare->operand(1), tuple_index)) {
+    bound = compare->operand(0);
+    direction = SwapComparisonDirection(direction);
+  } else {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  if (!Is32BitsOrLessIntegerConstant(bound)) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  // The body has to update the induction variable with "i + S", "S + i" or
+  // "i - S" where S is an integer constant.
+  const HloInstruction* update =
+      while_body->root_instruction()->operand(tuple_index);
+  const HloInstruction* step_inst;
+  bool negate_step = false;
+  if (update->opcode() == HloOpcode::kAdd &&
+      IsInductionVariable(update->operand(0), tuple_index)) {
+    step_inst = update->operand(1);
+  } else if (update->opcode() == HloOpcode::kAdd &&
+             IsInductionVariable(update->operand(1), tuple_index)) {
+    step_inst = update->operand(0);
+  } else if (update->opcode() == HloOpcode::kSubtract &&
+             IsInductionVariable(update->operand(0), tuple_index)) {
+    step_inst = update->operand(1);
+    negate_step = true;
+  } else {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+  if (!Is32BitsOrLessIntegerConstant(step_inst)) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  // The initial value does not have to be a constant, as long as it can be
+  // evaluated at compile time.
+  HloInstruction* init_inst =
+      while_inst->mutable_operand(0)->mutable_operand(tuple_index);
+  HloEvaluator evaluator(/*max_loop_iterations=*/0);
+  TF_ASSIGN_OR_RETURN(Literal init_literal, evaluator.Evaluate(init_inst));
+
+  TF_ASSIGN_OR_RETURN(int64 init,
+                      LiteralScalarToNativeType<int64>(init_literal));
+  TF_ASSIGN_OR_RETURN(int64 bound_value,
+                      LiteralScalarToNativeType<int64>(bound->literal()));
+  TF_ASSIGN_OR_RETURN(int64 step,
+                      LiteralScalarToNativeType<int64>(step_inst->literal()));
+  if (negate_step) {
+    step = -step;
+  }
+
+  absl::optional<int64> trip_count =
+      ClosedFormTripCount(direction, init, bound_value, step);
+  if (!trip_count) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  // Make sure the induction variable never wraps around, otherwise the closed
+  // form does not hold. All the values are at most 32 bits wide, so none of
+  // this can overflow an int64.
+  const PrimitiveType type = bound->shape().element_type();
+  const int64 bits = primitive_util::BitWidth(type);
+  const bool is_signed = primitive_util::IsSignedIntegralType(type);
+  const int64 min_value = is_signed ? -(int64{1} << (bits - 1)) : 0;
+  const int64 max_value =
+      is_signed ? (int64{1} << (bits - 1)) - 1 : (int64{1} << bits) - 1;
+  const int64 final_value = init + *trip_count * step;
+  if (final_value < min_value || final_value > max_value) {
+    return xla::FailedPrecondition("%s", err_msg);
+  }
+
+  return *trip_count;
+}
+
 }  // namespace poplarplugin
 }  // namespace xla
\ No newline at end of file
@@ -47,6 +47,14 @@ class WhileLoopUtil {
   FindMatchingLoopDeltasInsideBody(const HloInstruction* inst,
                                    const HloComputation* while_body);
 
+  // Computes the number of iterations of a while loop whose condition compares
+  // the loop induction variable against a constant and whose body adds a
+  // constant step to it. Unlike the brute force evaluation, the trip count is
+  // derived in closed form, so it works for loops of any length. Returns an
+  // error if the trip count cannot be proven, for example because the
+  // induction variable would wrap around.
+  static StatusOr<int64> ComputeTripCount(HloInstruction* while_inst);
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(WhileLoopUtil);
 };
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/remote_parameter.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/stateful_gradient_accumulate.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/data_initializer.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/inplace_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
@@ -934,8 +935,14 @@ Status DeferredVisitor::FinishScopedVisit(HloInstruction* inst) {
   outputs_ = FindInstructionOutputs(tensor_map, resources_, inst);
   // Delegate.
   TF_RETURN_IF_ERROR(FinishDeferedAllocationVisit(inst));
-  resources_.tensor_maps.AddTensorMapForComputation(inst->parent()->name(),
-                                                    std::move(tensor_map));
+  // The tensor maps are only used for the reports, so only the one of the
+  // entry computation is kept when compiling with low memory.
+  const HloComputation* comp = inst->parent();
+  if (!PoplarXlaFlags::Get().low_memory_compilation ||
+      comp == comp->parent()->entry_computation()) {
+    resources_.tensor_maps.AddTensorMapForComputation(comp->name(),
+                                                      std::move(tensor_map));
+  }
   resources_.deferred_allocation_scopes.pop();
   return Status::OK();
 }
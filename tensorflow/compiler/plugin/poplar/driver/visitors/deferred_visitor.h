@@ -336,7 +336,7 @@ class DeferredVisitor : public FullVisitor {
                                                   const Shape& shape);
 
   // Called by AllocateInput when allocating an input for an infeed.
-  StatusOr<poplar::Tensor> PostProcessInfeedAllocation(
+  virtual StatusOr<poplar::Tensor> PostProcessInfeedAllocation(
       TensorLocation location, const Shape& shape,
       poplar::program::Sequence& sequence, poplar::Tensor tensor);
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <poplar/Engine.hpp>
+#include <poplar/CycleCount.hpp>
 #include <poplar/GraphElements.hpp>
 #include <poplar/Tensor.hpp>
 #include <poplar/exceptions.hpp>
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/hlo_poplar_instruction.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/inplace_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
@@ -1091,6 +1093,9 @@ PipelineVisitor::PipelineVisitor(
       inst_stage_mapping_(inst_stage_mapping),
       stages_with_recomputation_(stages_with_recomputation),
       num_backward_stages_(num_backward_stages) {
+  // The programs of the stages are not added to the sequence of the visitor,
+  // so the cycles of the whole pipeline are counted by its caller instead.
+  count_instruction_cycles_ = false;
   // Push a new vector for the zeroing sequences onto the stack.
   res.gradient_accumulation_zeroing_sequences.push({});
   // Push a new vector for the write undef sequences onto the stack.
@@ -1148,9 +1153,50 @@ StatusOr<poplar::program::Sequence> PipelineVisitor::GetPipelineSequence(
   program.add(pipeline_execution_counters_initialize_sequence_);
   program.add(pipeline_tensors_zeroing_sequence_);
   program.add(pipeline_write_undef_sequence_);
-  program.add(ramp_up);
-  program.add(repeat_block);
-  program.add(ramp_down);
+
+  poplar::Graph& graph = GetMasterGraph(resources_);
+  const int tile = PoplarXlaFlags::Get().log_pipeline_cycle_count;
+  if (tile >= 0 && !resources_.has_pipeline_cycle_counter &&
+      graph.getTarget().getTargetType() == poplar::TargetType::IPU) {
+    // Measure each part of the pipeline separately so that the cycles spent
+    // filling and draining the pipeline can be compared to the cycles of the
+    // steps in the repeat block.
+    std::vector<poplar::Tensor> cycle_counts;
+    for (auto& part : {std::make_pair(&ramp_up, "RampUp"),
+                       std::make_pair(&repeat_block, "RepeatBlock"),
+                       std::make_pair(&ramp_down, "RampDown")}) {
+      poplar::program::Sequence seq;
+      seq.add(*part.first);
+      cycle_counts.push_back(poplar::cycleCount(
+          graph, seq, tile, absl::StrCat(part.second, "/CycleCount")));
+      program.add(seq);
+    }
+
+    // The number of steps in the whole pipeline and in the repeat block.
+    const int64 repeat_block_steps =
+        schedule_ == PoplarBackendConfig::CallConfig::PipelineConfig::Sequential
+            ? iterations
+            : std::max<int64>(iterations / overlap_length - 1, 0) *
+                  overlap_length;
+    poplar::Tensor steps = graph.addConstant<unsigned>(
+        poplar::UNSIGNED_INT, {2},
+        {static_cast<unsigned>(iterations),
+         static_cast<unsigned>(repeat_block_steps)},
+        "PipelineSteps");
+    graph.setTileMapping(steps, tile);
+    cycle_counts.push_back(steps);
+
+    poplar::Tensor counters = poplar::concat(cycle_counts);
+    poplar::DataStream fifo = graph.addDeviceToHostFIFO(
+        PoplarExecutor::GetPipelineCycleCounterStream(),
+        counters.elementType(), counters.numElements());
+    program.add(poplar::program::Copy(counters, fifo));
+    resources_.has_pipeline_cycle_counter = true;
+  } else {
+    program.add(ramp_up);
+    program.add(repeat_block);
+    program.add(ramp_down);
+  }
 
   // Add the resource update sequence.
   program.add(resource_update_);
@@ -19,14 +19,26 @@ limitations under the License.
 #include <vector>
 
 #include <poplar/Tensor.hpp>
+#include <popops/ElementWise.hpp>
+#include <popops/Zero.hpp>
+#include <poputil/TileMapping.hpp>
 #include <poputil/Util.hpp>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_resources.h"
 #include "tensorflow/compiler/plugin/poplar/driver/ops/ops.h"
+#include "tensorflow/compiler/plugin/poplar/driver/poplar_feed_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/inplace_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/mapping_helper.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_instructions.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+
+namespace pe = popops::expr;
 
 namespace xla {
 namespace poplarplugin {
@@ -34,9 +46,11 @@ namespace poplarplugin {
 RepeatLoopVisitor::RepeatLoopVisitor(
     CompilerResources& res, const DeferredArgRBVectors& inputs,
     const HloInstructionDescription& description,
-    const ReallocateInputsInfo& reallocate_inputs_info, const std::string& name)
+    const ReallocateInputsInfo& reallocate_inputs_info, const std::string& name,
+    bool runtime_repeat_count)
     : InplaceDeferredVisitor(res, inputs, description, name, {},
-                             reallocate_inputs_info) {
+                             reallocate_inputs_info),
+      runtime_repeat_count_(runtime_repeat_count) {
   // Push a new vector for the zeroing sequences onto the stack.
   res.gradient_accumulation_zeroing_sequences.push({});
 }
@@ -111,6 +125,121 @@ poplar::program::Sequence& RepeatLoopVisitor::GetSequenceForAliasingCopy() {
   return has_resource_update_ ? resource_update_sequence_ : sequence;
 }
 
+bool RepeatLoopVisitor::DoubleBufferFeed(
+    const std::string& feed_config, SyntheticDataCategory category) const {
+  // The first infeed copy and the last outfeed copy of a double buffered loop
+  // are outside of it, so it has to execute at least once.
+  if (!resources_.double_buffer_repeat_loop_feeds ||
+      resources_.use_verified_transfers || runtime_repeat_count_) {
+    return false;
+  }
+  PoplarFeedConfig config;
+  config.ParseFromString(feed_config);
+  if (UseSyntheticDataForFeed(category, config.feed_id())) {
+    return false;
+  }
+  // Batched feeds already only copy to or from the host every
+  // `io_batch_size` iterations.
+  return config.io_batch_size() <= 1;
+}
+
+poplar::Tensor RepeatLoopVisitor::CreateFeedBuffer(
+    const HloInstruction* inst, int64 flattened_output_tuple_index,
+    const poplar::Tensor& tensor, const std::string& name) {
+  poplar::Graph* io_graph = GetIoGraphWithOutputIndex(
+      resources_, inst, flattened_output_tuple_index);
+  if (io_graph) {
+    poplar::Tensor buffer =
+        io_graph->addVariable(tensor.elementType(), tensor.shape(), name);
+    poputil::mapTensorLinearly(*io_graph, buffer);
+    return buffer;
+  }
+  poplar::Graph& graph =
+      GetGraphWithOutputIndex(resources_, inst, flattened_output_tuple_index);
+  return graph.clone(tensor, name);
+}
+
+poplar::Tensor RepeatLoopVisitor::GetNotLastIterationPredicate(
+    const HloInstruction* inst) {
+  if (!not_last_iteration_) {
+    // The values are set at the start of each iteration in
+    // GetRepeatLoopSequence.
+    feed_counter_graph_ = &GetGraph(resources_, inst);
+    iteration_counter_ = feed_counter_graph_->addVariable(
+        poplar::UNSIGNED_INT, {}, name_ + "/IterationCounter");
+    not_last_iteration_ = feed_counter_graph_->addVariable(
+        poplar::BOOL, {}, name_ + "/NotLastIteration");
+    MappingHelper::MapTensorLinearly(resources_.linear_mapping_state,
+                                     *feed_counter_graph_, *iteration_counter_);
+    MappingHelper::MapTensorLinearly(resources_.linear_mapping_state,
+                                     *feed_counter_graph_,
+                                     *not_last_iteration_);
+  }
+  return *not_last_iteration_;
+}
+
+StatusOr<poplar::Tensor> RepeatLoopVisitor::PostProcessInfeedAllocation(
+    TensorLocation location, const Shape& shape,
+    poplar::program::Sequence& sequence, poplar::Tensor tensor) {
+  const HloInfeedInstruction* infeed =
+      Cast<HloInfeedInstruction>(location.instruction);
+  if (!DoubleBufferFeed(infeed->infeed_config(),
+                        SyntheticDataCategory::Infeed)) {
+    return InplaceDeferredVisitor::PostProcessInfeedAllocation(
+        location, shape, sequence, tensor);
+  }
+
+  // The next element is copied from the host into the buffer while this
+  // iteration is executing. The first element is copied before the loop.
+  const int64 tuple_index = location.flattened_output_tuple_index;
+  poplar::Tensor buffer =
+      CreateFeedBuffer(infeed, tuple_index, tensor,
+                       absl::StrCat(GetDebugName(infeed), "/InfeedBuffer/",
+                                    tuple_index));
+  TF_ASSIGN_OR_RETURN(
+      poplar::program::Program prefetch,
+      CreateInfeed(resources_, infeed, tuple_index, shape, buffer));
+  infeed_prefetch_sequence_.add(prefetch);
+
+  sequence.add(poplar::program::Copy(buffer, tensor));
+  poplar::program::Sequence next_prefetch;
+  next_prefetch.add(prefetch);
+  sequence.add(poplar::program::If(GetNotLastIterationPredicate(infeed),
+                                   next_prefetch, poplar::program::Sequence()));
+  return tensor;
+}
+
+Status RepeatLoopVisitor::HandleOutfeed(HloInstruction* inst) {
+  const HloOutfeedInstruction* outfeed = Cast<HloOutfeedInstruction>(inst);
+  if (!DoubleBufferFeed(outfeed->outfeed_config(),
+                        SyntheticDataCategory::Outfeed) ||
+      ShapeUtil::IsNestedTuple(inst->operand(0)->shape())) {
+    return InplaceDeferredVisitor::HandleOutfeed(inst);
+  }
+  VLOG(1) << "Processing " << inst->name();
+
+  // The tensors are copied into buffers, which are copied to the host while
+  // the next iteration is executing. The buffers of the last iteration are
+  // copied after the loop.
+  TF_ASSIGN_OR_RETURN(
+      TensorVector input_tensors,
+      FindInstructionInputTensors(tensor_map, resources_, inst, 0, sequence,
+                                  /*expand_aliasing=*/true));
+  TensorVector buffers(input_tensors.size());
+  for (size_t i = 0; i != input_tensors.size(); ++i) {
+    buffers[i] = CreateFeedBuffer(
+        inst, 0, input_tensors[i],
+        absl::StrCat(GetDebugName(inst), "/OutfeedBuffer/", i));
+    sequence.add(poplar::program::Copy(input_tensors[i], buffers[i]));
+  }
+  TF_ASSIGN_OR_RETURN(poplar::program::Program flush,
+                      CreateOutfeed(resources_, inst, buffers));
+  outfeed_flush_sequence_.add(flush);
+  // The iteration counter is used to skip the copy in the first iteration.
+  GetNotLastIterationPredicate(inst);
+  return Status::OK();
+}
+
 poplar::program::Sequence RepeatLoopVisitor::GetRepeatLoopSequence(
     const HloInstruction* inst) {
   const int64 repeat_count = GetRepeatLoopCount(inst);
@@ -118,16 +247,44 @@ poplar::program::Sequence RepeatLoopVisitor::GetRepeatLoopSequence(
   poplar::program::Sequence seq;
   seq.add(pre_loop_sequence_);
 
+  const bool double_buffered = iteration_counter_.has_value();
+  if (double_buffered) {
+    popops::zero(*feed_counter_graph_, *iteration_counter_, seq,
+                 name_ + "/ZeroIterationCounter");
+    seq.add(infeed_prefetch_sequence_);
+  }
+
   poplar::program::Sequence repeat_seq;
+  if (double_buffered) {
+    poplar::Graph& graph = *feed_counter_graph_;
+    const unsigned last_iteration = repeat_count - 1;
+    popops::mapInPlace(graph, pe::NotEqual(pe::_2, pe::Const(last_iteration)),
+                       {*not_last_iteration_, *iteration_counter_}, repeat_seq,
+                       name_ + "/NotLastIteration");
+    // Copy the outfeeds of the previous iteration to the host.
+    poplar::Tensor not_first_iteration =
+        popops::map(graph, pe::NotEqual(pe::_1, pe::Const(0u)),
+                    {*iteration_counter_}, repeat_seq,
+                    name_ + "/NotFirstIteration");
+    repeat_seq.add(poplar::program::If(not_first_iteration,
+                                       outfeed_flush_sequence_,
+                                       poplar::program::Sequence()));
+  }
   {
     repeat_seq.add(GetSequence(/*copy_execution_counters*/ false));
     // Increase the local execution counters at the end of each iteration.
     repeat_seq.add(execution_counters_.IncrementLiveCounters());
   }
+  if (double_buffered) {
+    popops::mapInPlace(*feed_counter_graph_, pe::Add(pe::_1, pe::Const(1u)),
+                       {*iteration_counter_}, repeat_seq,
+                       name_ + "/IncrementIterationCounter");
+  }
 
+  poplar::program::Sequence body = repeat_seq;
+  int64 iterations_per_body = 1;
   if (has_resource_update_) {
     CHECK_GT(num_mini_batches_to_accumulate_, 0);
-    CHECK_EQ(repeat_count % num_mini_batches_to_accumulate_, 0);
     // Create a double loop - the inner loop executes for
     // `num_mini_batches_to_accumulate_` iterations and then performs the
     // resource update.
@@ -137,13 +294,61 @@ poplar::program::Sequence RepeatLoopVisitor::GetRepeatLoopSequence(
     inner_seq.add(
         poplar::program::Repeat(num_mini_batches_to_accumulate_, repeat_seq));
     inner_seq.add(resource_update_sequence_);
+    body = inner_seq;
+    iterations_per_body = num_mini_batches_to_accumulate_;
+  }
 
-    // Repeat the inner loop.
-    seq.add(poplar::program::Repeat(
-        repeat_count / num_mini_batches_to_accumulate_, inner_seq));
+  // Repeat the body.
+  if (runtime_repeat_count_) {
+    seq.add(GetRuntimeRepeat(inst, iterations_per_body, body));
   } else {
-    seq.add(poplar::program::Repeat(repeat_count, repeat_seq));
+    CHECK_EQ(repeat_count % iterations_per_body, 0);
+    seq.add(poplar::program::Repeat(repeat_count / iterations_per_body, body));
+  }
+
+  if (double_buffered) {
+    // Copy the outfeeds of the last iteration to the host.
+    seq.add(outfeed_flush_sequence_);
+  }
+  return seq;
+}
+
+poplar::program::Sequence RepeatLoopVisitor::GetRuntimeRepeat(
+    const HloInstruction* inst, int64 iterations_per_body,
+    const poplar::program::Program& body) {
+  poplar::Graph& graph = GetGraph(resources_, inst);
+  poplar::program::Sequence seq;
+
+  // The count is passed through the loop unchanged, so it is read from the
+  // loop state before the loop is executed.
+  const int64 count_index =
+      InsertIntoTuple(inst->shape(), GetRuntimeRepeatCountIndex(inst), 0);
+  poplar::Tensor num_bodies = loop_state_[count_index].AsTensor();
+  if (iterations_per_body != 1) {
+    // Any iterations which do not fill a whole body are not executed.
+    num_bodies = popops::map(
+        graph,
+        pe::Divide(pe::_1, pe::Const(static_cast<int>(iterations_per_body))),
+        {num_bodies}, seq, name_ + "/NumBodies");
   }
+
+  poplar::Tensor counter =
+      graph.addVariable(poplar::INT, {}, name_ + "/RuntimeRepeatCounter");
+  MappingHelper::MapTensorLinearly(resources_.linear_mapping_state, graph,
+                                   counter);
+  popops::zero(graph, counter, seq, name_ + "/ZeroRuntimeRepeatCounter");
+
+  poplar::program::Sequence cond_seq;
+  poplar::Tensor predicate =
+      popops::map(graph, pe::Lt(pe::_1, pe::_2), {counter, num_bodies},
+                  cond_seq, name_ + "/RuntimeRepeatPredicate");
+
+  poplar::program::Sequence body_seq;
+  body_seq.add(body);
+  popops::mapInPlace(graph, pe::Add(pe::_1, pe::Const(1)), {counter}, body_seq,
+                     name_ + "/IncrementRuntimeRepeatCounter");
+
+  seq.add(poplar::program::RepeatWhileTrue(cond_seq, predicate, body_seq));
   return seq;
 }
 
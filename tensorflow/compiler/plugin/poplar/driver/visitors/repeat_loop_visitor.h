@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <string>
 
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/visitors/deferred_visitor.h"
 
 namespace xla {
@@ -30,12 +32,14 @@ class RepeatLoopVisitor : public InplaceDeferredVisitor {
   RepeatLoopVisitor(CompilerResources& res, const DeferredArgRBVectors& inputs,
                     const HloInstructionDescription& description,
                     const ReallocateInputsInfo& reallocate_inputs_info,
-                    const std::string& name);
+                    const std::string& name, bool runtime_repeat_count);
 
   Status HandleDeferredAllocationCall(HloInstruction* inst) override;
 
   Status FinishDeferedAllocationVisit(HloInstruction* inst) override;
 
+  Status HandleOutfeed(HloInstruction* inst) override;
+
   poplar::program::Sequence GetRepeatLoopSequence(const HloInstruction* inst);
 
   const TensorOrRemoteBufferVector& GetLoopState() const;
@@ -46,7 +50,36 @@ class RepeatLoopVisitor : public InplaceDeferredVisitor {
 
   poplar::program::Sequence& GetSequenceForAliasingCopy() override;
 
+  StatusOr<poplar::Tensor> PostProcessInfeedAllocation(
+      TensorLocation location, const Shape& shape,
+      poplar::program::Sequence& sequence, poplar::Tensor tensor) override;
+
  private:
+  // Returns whether the copies of an infeed or outfeed with the given config
+  // are double buffered.
+  bool DoubleBufferFeed(const std::string& feed_config,
+                        SyntheticDataCategory category) const;
+
+  // Creates a buffer like `tensor` for the data which is being copied to or
+  // from the host, on the IO tiles if there are any.
+  poplar::Tensor CreateFeedBuffer(const HloInstruction* inst,
+                                  int64 flattened_output_tuple_index,
+                                  const poplar::Tensor& tensor,
+                                  const std::string& name);
+
+  // Returns a predicate which is true in all but the last iteration of the
+  // loop.
+  poplar::Tensor GetNotLastIterationPredicate(const HloInstruction* inst);
+
+  // Returns a loop which executes `body` as many times as the count in the
+  // loop state divided by `iterations_per_body`.
+  poplar::program::Sequence GetRuntimeRepeat(
+      const HloInstruction* inst, int64 iterations_per_body,
+      const poplar::program::Program& body);
+
+  // Whether the number of iterations is only known when the loop is executed.
+  const bool runtime_repeat_count_;
+
   // Sequence which is executed once before the loop starts executing.
   poplar::program::Sequence pre_loop_sequence_;
 
@@ -59,6 +92,17 @@ class RepeatLoopVisitor : public InplaceDeferredVisitor {
   int64 num_mini_batches_to_accumulate_ = -1;
   poplar::program::Sequence tensors_zeroing_sequence_;
   poplar::program::Sequence resource_update_sequence_;
+
+  // Information used for double buffering the feeds. The infeed copies of the
+  // next iteration and the outfeed copies of the previous iteration are
+  // executed with the current iteration.
+  poplar::Graph* feed_counter_graph_ = nullptr;
+  absl::optional<poplar::Tensor> iteration_counter_;
+  absl::optional<poplar::Tensor> not_last_iteration_;
+  // Copies the next element of the infeeds into their buffers.
+  poplar::program::Sequence infeed_prefetch_sequence_;
+  // Copies the outfeed buffers to the host.
+  poplar::program::Sequence outfeed_flush_sequence_;
 };
 }  // namespace poplarplugin
 }  // namespace xla
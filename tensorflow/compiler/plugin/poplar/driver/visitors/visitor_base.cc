@@ -48,6 +48,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/stream_executor/lib/initialize.h"
 
 using tensorflow::str_util::StartsWith;
@@ -59,6 +60,7 @@ typedef StatusOr<poplar::program::Program> (*CustomCallFn)(
     CompilerResources&, const HloInstruction*, const xla::Shape&, TensorMap&);
 
 Status BaseVisitor::Preprocess(HloInstruction* inst) {
+  preprocess_nanos_ = tensorflow::Env::Default()->NowNanos();
   TF_ASSIGN_OR_RETURN(auto poplar_backend_config,
                       inst->backend_config<PoplarBackendConfig>());
   bool new_stochastic_rounding_enabled;
@@ -86,6 +88,12 @@ Status BaseVisitor::Preprocess(HloInstruction* inst) {
   return Status::OK();
 }
 
+Status BaseVisitor::Postprocess(HloInstruction* inst) {
+  resources_.instruction_compile_nanos[inst] +=
+      tensorflow::Env::Default()->NowNanos() - preprocess_nanos_;
+  return Status::OK();
+}
+
 BaseVisitor::BaseVisitor(CompilerResources& resources, const std::string& name)
     : resources_(resources), name_(name), execution_counters_(resources, name) {
   stochastic_rounding_enabled_ =
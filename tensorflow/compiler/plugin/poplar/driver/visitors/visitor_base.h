@@ -145,6 +145,8 @@ class BaseVisitor : public DfsHloVisitor {
 
   Status Preprocess(HloInstruction* hlo) override;
 
+  Status Postprocess(HloInstruction* hlo) override;
+
   // Get the sequence generated by this visitor. If `copy_execution_counters` is
   // set to true, then prepend the sequence with copies for populating the
   // execution counters with the values from the outer scope.
@@ -169,6 +171,9 @@ class BaseVisitor : public DfsHloVisitor {
   bool has_infeed_ = false;
   bool stochastic_rounding_enabled_;
 
+  // When the instruction being visited was preprocessed.
+  uint64 preprocess_nanos_ = 0;
+
   const std::string name_;
 
   // Scope execution counters.
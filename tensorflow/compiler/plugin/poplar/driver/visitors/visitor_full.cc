@@ -35,7 +35,10 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tensor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/rnn.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/execution_counter_util.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/poplar_util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal_util.h"
@@ -291,7 +294,47 @@ Status FullVisitor::HandleOutfeed(HloInstruction* inst) {
   return Status::OK();
 }
 
+namespace {
+// Instructions which only forward or create tensors do not add any programs
+// to count the cycles of.
+bool HasCycles(const HloInstruction* inst) {
+  switch (inst->opcode()) {
+    case HloOpcode::kAfterAll:
+    case HloOpcode::kBitcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kParameter:
+    case HloOpcode::kTuple:
+      return false;
+    default:
+      return true;
+  }
+}
+}  // namespace
+
+Status FullVisitor::Preprocess(HloInstruction* inst) {
+  TF_RETURN_IF_ERROR(BaseVisitor::Preprocess(inst));
+  if (count_instruction_cycles_ &&
+      PoplarXlaFlags::Get().log_instruction_cycle_count >= 0 &&
+      HasCycles(inst) &&
+      GetMasterGraph(resources_).getTarget().getTargetType() ==
+          poplar::TargetType::IPU) {
+    outer_sequence_ = sequence;
+    sequence = poplar::program::Sequence();
+  }
+  return Status::OK();
+}
+
 Status FullVisitor::Postprocess(HloInstruction* inst) {
+  TF_RETURN_IF_ERROR(BaseVisitor::Postprocess(inst));
+  if (outer_sequence_) {
+    TF_RETURN_IF_ERROR(AddInstructionCycleCounter(
+        resources_, inst, PoplarXlaFlags::Get().log_instruction_cycle_count,
+        sequence));
+    outer_sequence_->add(sequence);
+    sequence = *outer_sequence_;
+    outer_sequence_.reset();
+  }
   std::size_t next_tuple_index = 0;
   for (auto indexed_shape : ShapeUtil::GetLeafShapes(inst->shape())) {
     const std::size_t tuple_index = next_tuple_index++;
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <string>
 
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/plugin/poplar/driver/ops/ops.h"
 #include "tensorflow/compiler/plugin/poplar/driver/visitors/visitor_base.h"
 
@@ -69,6 +70,8 @@ class FullVisitor : public BaseVisitor {
 
   Status HandleSort(HloInstruction* inst) override;
 
+  Status Preprocess(HloInstruction* inst) override;
+
   Status Postprocess(HloInstruction* inst) override;
 
   Status HandleOutfeed(HloInstruction* inst) override;
@@ -82,6 +85,17 @@ class FullVisitor : public BaseVisitor {
   HANDLE_AS_HLO_OP(HandleBatchNormGrad)
   HANDLE_AS_HLO_OP(HandleGather)
   HANDLE_AS_HLO_OP(HandleScatter)
+
+ protected:
+  // Whether the cycles of the instructions are counted when the
+  // log_instruction_cycle_count flag is set.
+  bool count_instruction_cycles_ = true;
+
+ private:
+  // The sequence of the instructions before the one being visited, when the
+  // sequence of the instruction being visited is built on its own to count its
+  // cycles.
+  absl::optional<poplar::program::Sequence> outer_sequence_;
 };
 
 }  // namespace poplarplugin
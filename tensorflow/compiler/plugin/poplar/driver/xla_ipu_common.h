@@ -30,10 +30,11 @@ static std::vector<DataType> GetIPUSupportedTypes() {
 
   // Lambda which will get all the supported types given the flags.
   auto get_types = [] {
+    // 8 bit integers are always supported so that quantized weights can be
+    // stored on the device and dequantized on the fly.
     std::vector<DataType> supported = {DT_INT32, DT_INT64, DT_FLOAT, DT_HALF,
-                                       DT_BOOL};
+                                       DT_BOOL,  DT_INT8,  DT_UINT8};
     if (getenv("TF_POPLAR_GFLOAT") != nullptr) {
-      supported.push_back(DT_INT8);
       supported.push_back(DT_INT16);
     }
     return supported;
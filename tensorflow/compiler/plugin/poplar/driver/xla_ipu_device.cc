@@ -23,8 +23,12 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/kernels/index_ops.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/kernel_def.pb.h"
+#include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/kernels/no_op.h"
 
 namespace xp = ::xla::poplarplugin;
@@ -41,6 +45,42 @@ class IpuDevice : public XlaDevice {
   virtual ~IpuDevice() {}
 };
 
+namespace {
+
+// The executor reads the inputs of the engines from host buffers, so a host
+// tensor which already has the layout of the device buffer is used in place
+// until it is needed on the device, or overwritten. It has to be aligned like
+// the buffers the executor allocates.
+xla::StatusOr<bool> BorrowHostTensor(const Tensor& cpu_tensor,
+                                     se::Stream* stream,
+                                     xla::ShapedBuffer* device_buffer) {
+  const xla::Shape& shape = device_buffer->on_device_shape();
+  if (!shape.IsArray() || !DMAHelper::CanUseDMA(&cpu_tensor)) {
+    return false;
+  }
+  const void* data = DMAHelper::base(&cpu_tensor);
+  if (data == nullptr ||
+      !xla::LayoutUtil::IsMonotonicWithDim0Major(shape.layout()) ||
+      xla::ShapeUtil::ByteSizeOf(shape) != cpu_tensor.TotalBytes() ||
+      reinterpret_cast<uintptr_t>(data) % 64 != 0) {
+    return false;
+  }
+  auto* executor = static_cast<xp::PoplarExecutor*>(
+      stream->parent()->implementation());
+  TensorReference ref(cpu_tensor);
+  se::DeviceMemoryBase buffer = device_buffer->root_buffer();
+  Status status = executor->BorrowHostBuffer(&buffer, data,
+                                             cpu_tensor.TotalBytes(),
+                                             [ref]() { ref.Unref(); });
+  if (!status.ok()) {
+    ref.Unref();
+    return status;
+  }
+  return true;
+}
+
+}  // namespace
+
 class XlaIpuDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
@@ -86,6 +126,7 @@ Status XlaIpuDeviceFactory::CreateDevices(
   devopts.device_name_prefix = name_prefix;
   devopts.compilation_device_name = DEVICE_IPU_XLA_JIT;
   devopts.device_name = DEVICE_XLA_IPU;
+  devopts.borrow_host_tensor_fn = BorrowHostTensor;
 
   int num_devices = p->VisibleDeviceCount();
 
@@ -0,0 +1,294 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/mapped_cache.h"
+
+#include <utility>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+constexpr uint64 kMagic = 0x495055434143484bULL;
+constexpr uint64 kVersion = 1;
+// The alignment of the elements in a column. The column files are mapped at a
+// page boundary, so every tensor of the cache is aligned to it.
+constexpr uint64 kAlignment = 64;
+
+uint64 Stride(DataType dtype, const TensorShape& shape) {
+  const uint64 bytes = DataTypeSize(dtype) * shape.num_elements();
+  return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::string ColumnFilename(const std::string& prefix, const std::string& id,
+                           size_t component) {
+  return strings::StrCat(prefix, ".", id, ".column", component);
+}
+
+void PutString(std::string* dst, const std::string& value) {
+  core::PutVarint64(dst, value.size());
+  dst->append(value);
+}
+
+bool GetString(StringPiece* input, std::string* value) {
+  uint64 size;
+  if (!core::GetVarint64(input, &size) || input->size() < size) {
+    return false;
+  }
+  value->assign(input->data(), size);
+  input->remove_prefix(size);
+  return true;
+}
+}  // namespace
+
+class MappedCache::ColumnTensorBuffer : public TensorBuffer {
+ public:
+  ColumnTensorBuffer(const void* data, size_t size,
+                     std::shared_ptr<const MappedCache> cache)
+      : TensorBuffer(const_cast<void*>(data)),
+        size_(size),
+        cache_(std::move(cache)) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mapped_cache");
+  }
+
+  // The memory is mapped read only, so it must never be forwarded to the
+  // output of an op which writes into its input.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+  // Keeps the columns mapped while the tensor is alive.
+  std::shared_ptr<const MappedCache> cache_;
+};
+
+Status MappedCacheWriter::Create(Env* env, const std::string& prefix,
+                                 const DataTypeVector& dtypes,
+                                 const std::vector<TensorShape>& shapes,
+                                 std::unique_ptr<MappedCacheWriter>* output) {
+  if (dtypes.size() != shapes.size()) {
+    return errors::InvalidArgument(
+        "The number of types and shapes of a cache must match.");
+  }
+  for (DataType dtype : dtypes) {
+    if (!DataTypeCanUseMemcpy(dtype)) {
+      return errors::InvalidArgument("Tensors of type ", DataTypeString(dtype),
+                                     " can not be stored in a mapped cache.");
+    }
+  }
+  const std::string id = strings::StrCat(
+      strings::Hex(env->NowMicros()), "_", strings::Hex(random::New64()));
+  std::unique_ptr<MappedCacheWriter> writer(
+      new MappedCacheWriter(env, prefix, id, dtypes, shapes));
+  for (size_t i = 0; i != dtypes.size(); ++i) {
+    std::unique_ptr<WritableFile> file;
+    writer->filenames_.push_back(ColumnFilename(prefix, id, i));
+    TF_RETURN_IF_ERROR(env->NewWritableFile(writer->filenames_.back(), &file));
+    writer->files_.push_back(std::move(file));
+  }
+  *output = std::move(writer);
+  return Status::OK();
+}
+
+MappedCacheWriter::MappedCacheWriter(Env* env, const std::string& prefix,
+                                     const std::string& id,
+                                     const DataTypeVector& dtypes,
+                                     const std::vector<TensorShape>& shapes)
+    : env_(env), prefix_(prefix), id_(id), dtypes_(dtypes), shapes_(shapes) {}
+
+MappedCacheWriter::~MappedCacheWriter() {
+  if (finished_) {
+    return;
+  }
+  files_.clear();
+  for (const std::string& filename : filenames_) {
+    env_->DeleteFile(filename).IgnoreError();
+  }
+}
+
+Status MappedCacheWriter::Write(const std::vector<Tensor>& element) {
+  if (finished_) {
+    return errors::FailedPrecondition("The mapped cache ", prefix_,
+                                      " has already been finished.");
+  }
+  if (element.size() != dtypes_.size()) {
+    return errors::InvalidArgument("An element of the mapped cache ", prefix_,
+                                   " must have ", dtypes_.size(),
+                                   " components, but it has ", element.size(),
+                                   ".");
+  }
+  for (size_t i = 0; i != element.size(); ++i) {
+    if (element[i].dtype() != dtypes_[i] || element[i].shape() != shapes_[i]) {
+      return errors::InvalidArgument(
+          "Component ", i, " of an element of the mapped cache ", prefix_,
+          " must be a ", DataTypeString(dtypes_[i]), " tensor of shape ",
+          shapes_[i].DebugString(), ", but it is a ",
+          DataTypeString(element[i].dtype()), " tensor of shape ",
+          element[i].shape().DebugString(), ".");
+    }
+  }
+  for (size_t i = 0; i != element.size(); ++i) {
+    const StringPiece data = element[i].tensor_data();
+    TF_RETURN_IF_ERROR(files_[i]->Append(data));
+    const std::string padding(Stride(dtypes_[i], shapes_[i]) - data.size(),
+                              '\0');
+    TF_RETURN_IF_ERROR(files_[i]->Append(padding));
+  }
+  ++num_elements_;
+  return Status::OK();
+}
+
+Status MappedCacheWriter::Finish() {
+  if (finished_) {
+    return errors::FailedPrecondition("The mapped cache ", prefix_,
+                                      " has already been finished.");
+  }
+  for (auto& file : files_) {
+    TF_RETURN_IF_ERROR(file->Close());
+  }
+
+  std::string index;
+  core::PutVarint64(&index, kMagic);
+  core::PutVarint64(&index, kVersion);
+  core::PutVarint64(&index, num_elements_);
+  PutString(&index, id_);
+  core::PutVarint64(&index, dtypes_.size());
+  for (size_t i = 0; i != dtypes_.size(); ++i) {
+    core::PutVarint64(&index, dtypes_[i]);
+    core::PutVarint64(&index, shapes_[i].dims());
+    for (int64 dim : shapes_[i].dim_sizes()) {
+      core::PutVarint64(&index, dim);
+    }
+  }
+
+  const std::string index_filename = MappedCache::IndexFilename(prefix_);
+  const std::string tmp_filename =
+      strings::StrCat(index_filename, ".tmp-", id_);
+  TF_RETURN_IF_ERROR(WriteStringToFile(env_, tmp_filename, index));
+  if (env_->FileExists(index_filename).ok()) {
+    // Another writer got there first. Keep its cache, as it may already be
+    // being read, and let the destructor remove the columns of this one.
+    TF_RETURN_IF_ERROR(env_->DeleteFile(tmp_filename));
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(env_->RenameFile(tmp_filename, index_filename));
+  finished_ = true;
+  return Status::OK();
+}
+
+std::string MappedCache::IndexFilename(const std::string& prefix) {
+  return strings::StrCat(prefix, ".index");
+}
+
+Status MappedCache::Open(Env* env, const std::string& prefix,
+                         std::shared_ptr<MappedCache>* output) {
+  const std::string index_filename = IndexFilename(prefix);
+  std::string index;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, index_filename, &index));
+
+  StringPiece input(index);
+  uint64 magic, version, num_elements, num_components;
+  std::string id;
+  if (!core::GetVarint64(&input, &magic) || magic != kMagic ||
+      !core::GetVarint64(&input, &version)) {
+    return errors::DataLoss(index_filename, " is not a mapped cache index.");
+  }
+  if (version != kVersion) {
+    return errors::FailedPrecondition("The mapped cache ", prefix,
+                                      " has version ", version,
+                                      ", but only version ", kVersion,
+                                      " is supported.");
+  }
+  if (!core::GetVarint64(&input, &num_elements) || !GetString(&input, &id) ||
+      !core::GetVarint64(&input, &num_components)) {
+    return errors::DataLoss("The mapped cache index ", index_filename,
+                            " is truncated.");
+  }
+
+  std::shared_ptr<MappedCache> cache(new MappedCache());
+  cache->num_elements_ = num_elements;
+  for (uint64 i = 0; i != num_components; ++i) {
+    uint64 dtype, dims;
+    if (!core::GetVarint64(&input, &dtype) ||
+        !core::GetVarint64(&input, &dims)) {
+      return errors::DataLoss("The mapped cache index ", index_filename,
+                              " is truncated.");
+    }
+    TensorShape shape;
+    for (uint64 dim = 0; dim != dims; ++dim) {
+      uint64 dim_size;
+      if (!core::GetVarint64(&input, &dim_size)) {
+        return errors::DataLoss("The mapped cache index ", index_filename,
+                                " is truncated.");
+      }
+      shape.AddDim(dim_size);
+    }
+    cache->dtypes_.push_back(static_cast<DataType>(dtype));
+    cache->shapes_.push_back(shape);
+    cache->strides_.push_back(Stride(cache->dtypes_.back(), shape));
+
+    std::unique_ptr<ReadOnlyMemoryRegion> column;
+    const uint64 column_bytes = num_elements * cache->strides_.back();
+    if (column_bytes != 0) {
+      const std::string column_filename = ColumnFilename(prefix, id, i);
+      TF_RETURN_IF_ERROR(
+          env->NewReadOnlyMemoryRegionFromFile(column_filename, &column));
+      if (column->length() < column_bytes) {
+        return errors::DataLoss("The mapped cache column ", column_filename,
+                                " has ", column->length(), " bytes, but ",
+                                column_bytes, " were expected.");
+      }
+    }
+    cache->columns_.push_back(std::move(column));
+  }
+  *output = std::move(cache);
+  return Status::OK();
+}
+
+Status MappedCache::GetElement(int64 index,
+                               std::vector<Tensor>* element) const {
+  if (index < 0 || index >= num_elements_) {
+    return errors::OutOfRange("Element ", index, " is not in a cache of ",
+                              num_elements_, " elements.");
+  }
+  element->clear();
+  element->reserve(dtypes_.size());
+  for (size_t i = 0; i != dtypes_.size(); ++i) {
+    if (!columns_[i]) {
+      element->emplace_back(dtypes_[i], shapes_[i]);
+      continue;
+    }
+    const char* data =
+        static_cast<const char*>(columns_[i]->data()) + index * strides_[i];
+    const size_t bytes = DataTypeSize(dtypes_[i]) * shapes_[i].num_elements();
+    auto* buffer = new ColumnTensorBuffer(data, bytes, shared_from_this());
+    element->emplace_back(dtypes_[i], shapes_[i], buffer);
+    buffer->Unref();
+  }
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
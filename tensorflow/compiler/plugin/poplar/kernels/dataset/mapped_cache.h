@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_MAPPED_CACHE_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_MAPPED_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace data {
+
+// An on disk cache of the elements of a dataset with static shapes.
+//
+// Each component is stored in its own column file, in which the element `i`
+// starts at `i` times a fixed stride. A cache with the prefix `prefix` has an
+// index file `prefix.index`, which describes the components and names the
+// column files. The index is written last and renamed into place, so a cache
+// is either complete or not visible at all, and several processes can write
+// the same cache without clobbering each other.
+//
+// The column files are memory mapped when the cache is read, so the tensors of
+// an element point straight into the page cache of the host, which is shared
+// between all the processes reading the cache.
+
+// Writes the elements of a dataset into a new cache.
+class MappedCacheWriter {
+ public:
+  static Status Create(Env* env, const std::string& prefix,
+                       const DataTypeVector& dtypes,
+                       const std::vector<TensorShape>& shapes,
+                       std::unique_ptr<MappedCacheWriter>* output);
+
+  // Removes the column files if the cache was not finished.
+  ~MappedCacheWriter();
+
+  Status Write(const std::vector<Tensor>& element);
+
+  // Writes the index, which makes the cache visible to readers. If another
+  // writer finished the same cache first, its cache is kept instead.
+  Status Finish();
+
+ private:
+  MappedCacheWriter(Env* env, const std::string& prefix,
+                    const std::string& id, const DataTypeVector& dtypes,
+                    const std::vector<TensorShape>& shapes);
+
+  Env* const env_;
+  const std::string prefix_;
+  // Tells the column files of this writer apart from those of others.
+  const std::string id_;
+  const DataTypeVector dtypes_;
+  const std::vector<TensorShape> shapes_;
+  std::vector<std::string> filenames_;
+  std::vector<std::unique_ptr<WritableFile>> files_;
+  int64 num_elements_ = 0;
+  bool finished_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedCacheWriter);
+};
+
+// Reads the elements of a complete cache, in any order.
+class MappedCache : public std::enable_shared_from_this<MappedCache> {
+ public:
+  // Returns NotFound if there is no complete cache with this prefix.
+  static Status Open(Env* env, const std::string& prefix,
+                     std::shared_ptr<MappedCache>* output);
+
+  int64 num_elements() const { return num_elements_; }
+  const DataTypeVector& dtypes() const { return dtypes_; }
+  const std::vector<TensorShape>& shapes() const { return shapes_; }
+
+  // Returns the tensors of element `index`, which keep the cache mapped for
+  // as long as they are alive.
+  Status GetElement(int64 index, std::vector<Tensor>* element) const;
+
+  // The name of the index file of the cache with this prefix.
+  static std::string IndexFilename(const std::string& prefix);
+
+ private:
+  class ColumnTensorBuffer;
+
+  MappedCache() = default;
+
+  int64 num_elements_ = 0;
+  DataTypeVector dtypes_;
+  std::vector<TensorShape> shapes_;
+  std::vector<uint64> strides_;
+  // Null for a column without any bytes, which can not be mapped.
+  std::vector<std::unique_ptr<ReadOnlyMemoryRegion>> columns_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedCache);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_MAPPED_CACHE_H_
@@ -0,0 +1,275 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/mapped_cache_dataset_op.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/mapped_cache.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr const char* const MappedCacheDatasetOp::kDatasetType;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kInputDataset;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kFileName;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kShuffle;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kSeed;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kSeed2;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const MappedCacheDatasetOp::kOutputShapes;
+
+constexpr char kEpoch[] = "epoch";
+constexpr char kNextIndex[] = "next_index";
+
+class MappedCacheDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          const tstring& filename, bool shuffle, int64 seed, int64 seed2)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        filename_(filename),
+        shuffle_(shuffle),
+        seed_(seed),
+        seed2_(seed2) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64 Cardinality() const override { return input_->Cardinality(); }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* filename = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename));
+    AttrValue shuffle;
+    b->BuildAttrValue(shuffle_, &shuffle);
+    AttrValue seed;
+    b->BuildAttrValue(seed_, &seed);
+    AttrValue seed2;
+    b->BuildAttrValue(seed2_, &seed2);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, filename},
+        {{kShuffle, shuffle}, {kSeed, seed}, {kSeed2, seed2}}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      Status status = MappedCache::Open(ctx->env(), dataset()->filename_,
+                                        &cache_);
+      if (status.ok()) {
+        epoch_ = dataset()->num_epochs_read_++;
+        return ShuffleOrder();
+      }
+      if (!errors::IsNotFound(status)) {
+        return status;
+      }
+
+      // There is no cache yet, so this iteration writes it. The shapes were
+      // checked to be static when the dataset was made.
+      std::vector<TensorShape> shapes(dataset()->output_shapes().size());
+      for (size_t i = 0; i != shapes.size(); ++i) {
+        dataset()->output_shapes()[i].AsTensorShape(&shapes[i]);
+      }
+      TF_RETURN_IF_ERROR(MappedCacheWriter::Create(
+          ctx->env(), dataset()->filename_, dataset()->output_dtypes(), shapes,
+          &writer_));
+      return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (*end_of_sequence) {
+          input_impl_.reset();
+          std::unique_ptr<MappedCacheWriter> writer = std::move(writer_);
+          return writer ? writer->Finish() : Status::OK();
+        }
+        if (writer_) {
+          Status status = writer_->Write(*out_tensors);
+          if (!status.ok()) {
+            // Drop the partial cache.
+            writer_.reset();
+            return status;
+          }
+        }
+        return Status::OK();
+      }
+
+      if (!cache_ || next_index_ >= cache_->num_elements()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      const int64 index = order_.empty() ? next_index_ : order_[next_index_];
+      ++next_index_;
+      *end_of_sequence = false;
+      return cache_->GetElement(index, out_tensors);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+    }
+
+    Status SaveInternal(IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        return errors::Unimplemented(
+            "A mapped cache can not be saved while it is being written.");
+      }
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kEpoch), epoch_));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kNextIndex), next_index_));
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (!cache_) {
+        return errors::FailedPrecondition(
+            "The mapped cache ", dataset()->filename_,
+            " was not complete when the iterator was restored.");
+      }
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kEpoch), &epoch_));
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name(kNextIndex), &next_index_));
+      return ShuffleOrder();
+    }
+
+   private:
+    // Draws the order in which the cache is read in this epoch.
+    Status ShuffleOrder() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      order_.clear();
+      if (!dataset()->shuffle_) {
+        return Status::OK();
+      }
+      uint64 seed;
+      if (dataset()->seed_ == 0 && dataset()->seed2_ == 0) {
+        seed = random::New64();
+      } else {
+        seed = Hash64Combine(Hash64Combine(dataset()->seed_, dataset()->seed2_),
+                             epoch_);
+      }
+      order_.resize(cache_->num_elements());
+      std::iota(order_.begin(), order_.end(), 0);
+      std::mt19937_64 rng(seed);
+      std::shuffle(order_.begin(), order_.end(), rng);
+      return Status::OK();
+    }
+
+    mutex mu_;
+    // Set while the cache is being written.
+    std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    std::unique_ptr<MappedCacheWriter> writer_ GUARDED_BY(mu_);
+    // Set while the cache is being read.
+    std::shared_ptr<MappedCache> cache_ GUARDED_BY(mu_);
+    int64 epoch_ GUARDED_BY(mu_) = 0;
+    int64 next_index_ GUARDED_BY(mu_) = 0;
+    std::vector<int64> order_ GUARDED_BY(mu_);
+  };
+
+  const DatasetBase* const input_;
+  const tstring filename_;
+  const bool shuffle_;
+  const int64 seed_;
+  const int64 seed2_;
+  // The number of iterators which have read the cache, which picks a new
+  // order for each of them.
+  mutable std::atomic<int64> num_epochs_read_{0};
+};
+
+MappedCacheDatasetOp::MappedCacheDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kShuffle, &shuffle_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kSeed, &seed_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kSeed2, &seed2_));
+}
+
+void MappedCacheDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                       DatasetBase* input,
+                                       DatasetBase** output) {
+  tstring filename;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kFileName, &filename));
+  OP_REQUIRES(ctx, !filename.empty(),
+              errors::InvalidArgument("The filename of a mapped cache can not "
+                                      "be empty."));
+  for (const PartialTensorShape& shape : input->output_shapes()) {
+    OP_REQUIRES(ctx, shape.IsFullyDefined(),
+                errors::InvalidArgument(
+                    "A mapped cache needs elements with static shapes, but "
+                    "the input has an element of shape ",
+                    shape.DebugString(), "."));
+  }
+  *output = new Dataset(ctx, input, filename, shuffle_, seed_, seed2_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("IPUMappedCacheDataset").Device(DEVICE_CPU),
+                        MappedCacheDatasetOp);
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/mapped_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::string CachePrefix(const std::string& test) {
+  return io::JoinPath(testing::TmpDir(), "mapped_cache_test_" + test);
+}
+
+Tensor Values(float value) {
+  return test::AsTensor<float>({value, 2.f, 3.f}, TensorShape({3}));
+}
+
+TEST(MappedCacheTest, RoundTrip) {
+  const std::string prefix = CachePrefix("round_trip");
+  std::unique_ptr<MappedCacheWriter> writer;
+  TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix,
+                                         {DT_FLOAT, DT_INT32},
+                                         {TensorShape({3}), TensorShape({})},
+                                         &writer));
+  for (int32 i = 0; i != 4; ++i) {
+    TF_ASSERT_OK(writer->Write({Values(i), test::AsScalar<int32>(i)}));
+  }
+  TF_ASSERT_OK(writer->Finish());
+
+  std::shared_ptr<MappedCache> cache;
+  TF_ASSERT_OK(MappedCache::Open(Env::Default(), prefix, &cache));
+  ASSERT_EQ(cache->num_elements(), 4);
+
+  // The elements can be read in any order.
+  for (int32 i = 3; i >= 0; --i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(cache->GetElement(i, &element));
+    ASSERT_EQ(element.size(), 2);
+    test::ExpectTensorEqual<float>(element[0], Values(i));
+    test::ExpectTensorEqual<int32>(element[1], test::AsScalar<int32>(i));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(element[1].tensor_data().data()) %
+                  EIGEN_MAX_ALIGN_BYTES,
+              0);
+  }
+
+  std::vector<Tensor> element;
+  EXPECT_EQ(cache->GetElement(4, &element).code(), error::OUT_OF_RANGE);
+}
+
+TEST(MappedCacheTest, TensorsOutliveCache) {
+  const std::string prefix = CachePrefix("outlive");
+  std::unique_ptr<MappedCacheWriter> writer;
+  TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix, {DT_FLOAT},
+                                         {TensorShape({3})}, &writer));
+  TF_ASSERT_OK(writer->Write({Values(7)}));
+  TF_ASSERT_OK(writer->Finish());
+
+  std::vector<Tensor> element;
+  {
+    std::shared_ptr<MappedCache> cache;
+    TF_ASSERT_OK(MappedCache::Open(Env::Default(), prefix, &cache));
+    TF_ASSERT_OK(cache->GetElement(0, &element));
+  }
+  test::ExpectTensorEqual<float>(element[0], Values(7));
+}
+
+TEST(MappedCacheTest, UnfinishedCacheIsRemoved) {
+  const std::string prefix = CachePrefix("unfinished");
+  {
+    std::unique_ptr<MappedCacheWriter> writer;
+    TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix, {DT_FLOAT},
+                                           {TensorShape({3})}, &writer));
+    TF_ASSERT_OK(writer->Write({Values(1)}));
+  }
+
+  std::shared_ptr<MappedCache> cache;
+  EXPECT_EQ(MappedCache::Open(Env::Default(), prefix, &cache).code(),
+            error::NOT_FOUND);
+  std::vector<std::string> files;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(prefix + ".*", &files));
+  EXPECT_TRUE(files.empty());
+}
+
+TEST(MappedCacheTest, FirstFinishedWriterWins) {
+  const std::string prefix = CachePrefix("two_writers");
+  std::unique_ptr<MappedCacheWriter> first, second;
+  TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix, {DT_FLOAT},
+                                         {TensorShape({3})}, &first));
+  TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix, {DT_FLOAT},
+                                         {TensorShape({3})}, &second));
+  TF_ASSERT_OK(first->Write({Values(1)}));
+  TF_ASSERT_OK(second->Write({Values(2)}));
+  TF_ASSERT_OK(first->Finish());
+  TF_ASSERT_OK(second->Finish());
+  second.reset();
+
+  std::shared_ptr<MappedCache> cache;
+  TF_ASSERT_OK(MappedCache::Open(Env::Default(), prefix, &cache));
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(cache->GetElement(0, &element));
+  test::ExpectTensorEqual<float>(element[0], Values(1));
+}
+
+TEST(MappedCacheTest, InvalidElements) {
+  const std::string prefix = CachePrefix("invalid");
+  std::unique_ptr<MappedCacheWriter> writer;
+  EXPECT_EQ(MappedCacheWriter::Create(Env::Default(), prefix, {DT_STRING},
+                                      {TensorShape({})}, &writer)
+                .code(),
+            error::INVALID_ARGUMENT);
+
+  TF_ASSERT_OK(MappedCacheWriter::Create(Env::Default(), prefix, {DT_FLOAT},
+                                         {TensorShape({3})}, &writer));
+  EXPECT_EQ(writer->Write({test::AsScalar<float>(1.f)}).code(),
+            error::INVALID_ARGUMENT);
+  EXPECT_EQ(writer->Write({Values(1), Values(2)}).code(),
+            error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
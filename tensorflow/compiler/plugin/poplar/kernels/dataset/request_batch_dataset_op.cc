@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/request_batch_dataset_op.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/request_batcher.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr const char* const RequestBatchDatasetOp::kDatasetType;
+/* static */ constexpr const char* const RequestBatchDatasetOp::kBatcherName;
+/* static */ constexpr const char* const RequestBatchDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const RequestBatchDatasetOp::kOutputShapes;
+
+class RequestBatchDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const std::string& batcher_name,
+          const DataTypeVector& output_types,
+          const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        batcher_name_(batcher_name),
+        output_types_(output_types),
+        output_shapes_(output_shapes) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_types_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(batcher_name_);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  // The batches are produced until the batcher is closed.
+  int64 Cardinality() const override { return kUnknownCardinality; }
+
+  Status CheckExternalState() const override {
+    return errors::FailedPrecondition(
+        DebugString(), " depends on the requests of a serving front end.");
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    AttrValue batcher_name;
+    b->BuildAttrValue(batcher_name_, &batcher_name);
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {}, {{kBatcherName, batcher_name}}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      batcher_ = LookupRequestBatcher(dataset()->batcher_name_);
+      if (!batcher_) {
+        return errors::NotFound("No request batcher named ",
+                                dataset()->batcher_name_,
+                                " has been registered.");
+      }
+      if (batcher_->batch_dtypes() != dataset()->output_types_) {
+        return errors::InvalidArgument(
+            "The types of the request batcher ", dataset()->batcher_name_,
+            " do not match the types of the dataset.");
+      }
+      for (size_t i = 0; i != dataset()->output_shapes_.size(); ++i) {
+        if (!dataset()->output_shapes_[i].IsCompatibleWith(
+                batcher_->batch_shapes()[i])) {
+          return errors::InvalidArgument(
+              "The batch shape ", batcher_->batch_shapes()[i].DebugString(),
+              " of the request batcher ", dataset()->batcher_name_,
+              " is not compatible with the shape ",
+              dataset()->output_shapes_[i].DebugString(), " of the dataset.");
+        }
+      }
+      return Status::OK();
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      return batcher_->GetNextBatch(out_tensors, end_of_sequence);
+    }
+
+   private:
+    std::shared_ptr<RequestBatcher> batcher_;
+  };
+
+  const std::string batcher_name_;
+  const DataTypeVector output_types_;
+  const std::vector<PartialTensorShape> output_shapes_;
+};
+
+RequestBatchDatasetOp::RequestBatchDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kBatcherName, &batcher_name_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+  OP_REQUIRES(ctx, output_types_.size() == output_shapes_.size(),
+              errors::InvalidArgument(
+                  "The number of output types and shapes must match."));
+}
+
+void RequestBatchDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                        DatasetBase** output) {
+  *output = new Dataset(ctx, batcher_name_, output_types_, output_shapes_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("IPURequestBatchDataset").Device(DEVICE_CPU),
+                        RequestBatchDatasetOp);
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
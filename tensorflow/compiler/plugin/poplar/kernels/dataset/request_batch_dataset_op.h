@@ -0,0 +1,50 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCH_DATASET_OP_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCH_DATASET_OP_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+
+// A dataset of the batches of the RequestBatcher registered with the name
+// `batcher_name`.
+class RequestBatchDatasetOp : public DatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "RequestBatch";
+  static constexpr const char* const kBatcherName = "batcher_name";
+  static constexpr const char* const kOutputTypes = "output_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+
+  explicit RequestBatchDatasetOp(OpKernelConstruction* ctx);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override;
+
+ private:
+  class Dataset;
+  std::string batcher_name_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCH_DATASET_OP_H_
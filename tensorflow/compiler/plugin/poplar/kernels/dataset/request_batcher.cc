@@ -0,0 +1,391 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/request_batcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <utility>
+
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+mutex registry_mu(LINKER_INITIALIZED);
+
+std::map<std::string, std::shared_ptr<RequestBatcher>>& Registry() {
+  static auto* registry =
+      new std::map<std::string, std::shared_ptr<RequestBatcher>>();
+  return *registry;
+}
+}  // namespace
+
+/* static */ Status RequestBatcher::Create(
+    const RequestBatcherOptions& options, const DataTypeVector& dtypes,
+    const std::vector<TensorShape>& element_shapes,
+    std::unique_ptr<RequestBatcher>* batcher) {
+  if (options.batch_size < 1) {
+    return errors::InvalidArgument(
+        "The batch size of a request batcher must be at least 1, got ",
+        options.batch_size, ".");
+  }
+  if (dtypes.empty() || dtypes.size() != element_shapes.size()) {
+    return errors::InvalidArgument(
+        "A request batcher needs the same non-zero number of types and "
+        "shapes, got ",
+        dtypes.size(), " types and ", element_shapes.size(), " shapes.");
+  }
+  const auto& allowed = options.allowed_batch_sizes;
+  if (!allowed.empty() &&
+      (allowed.front() < 1 || allowed.back() != options.batch_size ||
+       std::adjacent_find(allowed.begin(), allowed.end(),
+                          std::greater_equal<int64>()) != allowed.end())) {
+    return errors::InvalidArgument(
+        "The allowed batch sizes of a request batcher must be strictly "
+        "increasing, positive and end with the batch size ",
+        options.batch_size, ".");
+  }
+  for (DataType dtype : dtypes) {
+    if (!DataTypeCanUseMemcpy(dtype)) {
+      return errors::InvalidArgument("Requests of type ",
+                                     DataTypeString(dtype),
+                                     " cannot be batched.");
+    }
+  }
+  batcher->reset(new RequestBatcher(options, dtypes, element_shapes));
+  return Status::OK();
+}
+
+RequestBatcher::RequestBatcher(const RequestBatcherOptions& options,
+                               const DataTypeVector& dtypes,
+                               const std::vector<TensorShape>& element_shapes)
+    : options_(options),
+      dtypes_(dtypes),
+      element_shapes_(element_shapes),
+      batch_dtypes_(dtypes) {
+  for (const TensorShape& shape : element_shapes_) {
+    TensorShape batch_shape({options_.batch_size});
+    batch_shape.AppendShape(shape);
+    batch_shapes_.push_back(batch_shape);
+  }
+  if (!options_.allowed_batch_sizes.empty()) {
+    batch_dtypes_.push_back(DT_INT32);
+    batch_shapes_.push_back(TensorShape({}));
+  }
+}
+
+RequestBatcher::~RequestBatcher() {
+  std::deque<Request> pending;
+  std::deque<Batch> in_flight;
+  {
+    mutex_lock l(mu_);
+    closed_ = true;
+    end_of_sequence_ = true;
+    pending.swap(pending_);
+    in_flight.swap(in_flight_);
+    pending_examples_ = 0;
+  }
+  pending_cv_.notify_all();
+  in_flight_cv_.notify_all();
+  // Joins the routing thread.
+  routing_thread_.reset();
+
+  const Status cancelled =
+      errors::Cancelled("The request batcher was destroyed.");
+  Batch unbatched;
+  unbatched.requests.assign(std::make_move_iterator(pending.begin()),
+                            std::make_move_iterator(pending.end()));
+  FailBatch(unbatched, cancelled);
+  for (Batch& batch : in_flight) {
+    FailBatch(batch, cancelled);
+  }
+}
+
+Status RequestBatcher::Submit(std::vector<Tensor> inputs, DoneCallback done) {
+  if (inputs.size() != dtypes_.size()) {
+    return errors::InvalidArgument("Expected a request with ", dtypes_.size(),
+                                   " inputs, got ", inputs.size(), ".");
+  }
+  int64 num_examples = -1;
+  for (size_t i = 0; i != inputs.size(); ++i) {
+    const Tensor& input = inputs[i];
+    if (input.dtype() != dtypes_[i]) {
+      return errors::InvalidArgument(
+          "Expected input ", i, " of the request to be ",
+          DataTypeString(dtypes_[i]), ", got ", DataTypeString(input.dtype()),
+          ".");
+    }
+    TensorShape element_shape = input.shape();
+    if (element_shape.dims() > 0) {
+      element_shape.RemoveDim(0);
+    }
+    if (input.dims() == 0 || element_shape != element_shapes_[i]) {
+      return errors::InvalidArgument(
+          "Expected input ", i, " of the request to have the shape [n, ",
+          element_shapes_[i].DebugString(), "], got ",
+          input.shape().DebugString(), ".");
+    }
+    if (num_examples >= 0 && input.dim_size(0) != num_examples) {
+      return errors::InvalidArgument(
+          "All the inputs of a request must have the same number of "
+          "examples.");
+    }
+    num_examples = input.dim_size(0);
+  }
+  if (num_examples < 1 || num_examples > options_.batch_size) {
+    return errors::InvalidArgument("A request must contain between 1 and ",
+                                   options_.batch_size, " examples, got ",
+                                   num_examples, ".");
+  }
+
+  {
+    mutex_lock l(mu_);
+    if (closed_) {
+      return errors::Cancelled("The request batcher is closed.");
+    }
+    if (options_.max_pending_requests > 0 &&
+        static_cast<int64>(pending_.size()) >= options_.max_pending_requests) {
+      return errors::ResourceExhausted(
+          "Too many requests are waiting to be batched.");
+    }
+    pending_.push_back(Request{std::move(inputs), num_examples,
+                               Env::Default()->NowMicros(), std::move(done)});
+    pending_examples_ += num_examples;
+  }
+  pending_cv_.notify_all();
+  return Status::OK();
+}
+
+Status RequestBatcher::Submit(std::vector<Tensor> inputs,
+                              std::future<Result>* result) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  *result = promise->get_future();
+  return Submit(std::move(inputs),
+                [promise](Result r) { promise->set_value(std::move(r)); });
+}
+
+bool RequestBatcher::BatchReady(uint64 now_micros) const {
+  if (pending_.empty()) {
+    return false;
+  }
+  return closed_ || pending_examples_ >= options_.batch_size ||
+         now_micros - pending_.front().enqueue_micros >=
+             static_cast<uint64>(options_.max_latency_micros);
+}
+
+Status RequestBatcher::GetNextBatch(std::vector<Tensor>* batch,
+                                    bool* end_of_sequence) {
+  std::vector<std::vector<Tensor>> inputs;
+  std::vector<int64> num_examples;
+  {
+    mutex_lock l(mu_);
+    while (true) {
+      if (pending_.empty() && closed_) {
+        end_of_sequence_ = true;
+        *end_of_sequence = true;
+        in_flight_cv_.notify_all();
+        return Status::OK();
+      }
+      const uint64 now = Env::Default()->NowMicros();
+      if (BatchReady(now)) {
+        break;
+      }
+      if (pending_.empty()) {
+        pending_cv_.wait(l);
+      } else {
+        const uint64 deadline =
+            pending_.front().enqueue_micros + options_.max_latency_micros;
+        pending_cv_.wait_for(l, std::chrono::microseconds(deadline - now));
+      }
+    }
+
+    // Take the requests which fit, in the order they were submitted.
+    Batch in_flight;
+    int64 batched_examples = 0;
+    while (!pending_.empty() &&
+           batched_examples + pending_.front().num_examples <=
+               options_.batch_size) {
+      Request& request = pending_.front();
+      batched_examples += request.num_examples;
+      pending_examples_ -= request.num_examples;
+      inputs.push_back(request.inputs);
+      num_examples.push_back(request.num_examples);
+      in_flight.requests.push_back(std::move(request));
+      pending_.pop_front();
+    }
+    in_flight_.push_back(std::move(in_flight));
+  }
+  in_flight_cv_.notify_all();
+
+  batch->clear();
+  for (size_t i = 0; i != dtypes_.size(); ++i) {
+    Tensor packed(dtypes_[i], batch_shapes_[i]);
+    const size_t example_bytes =
+        element_shapes_[i].num_elements() * DataTypeSize(dtypes_[i]);
+    char* dst = const_cast<char*>(packed.tensor_data().data());
+    size_t offset = 0;
+    for (size_t r = 0; r != inputs.size(); ++r) {
+      const size_t bytes = num_examples[r] * example_bytes;
+      std::memcpy(dst + offset, inputs[r][i].tensor_data().data(), bytes);
+      offset += bytes;
+    }
+    // Pad the examples which were not filled.
+    std::memset(dst + offset, 0, packed.TotalBytes() - offset);
+    batch->push_back(std::move(packed));
+  }
+
+  const auto& allowed = options_.allowed_batch_sizes;
+  if (!allowed.empty()) {
+    const int64 batched_examples =
+        std::accumulate(num_examples.begin(), num_examples.end(), int64{0});
+    Tensor variant(DT_INT32, TensorShape({}));
+    variant.scalar<int32>()() = std::distance(
+        allowed.begin(),
+        std::lower_bound(allowed.begin(), allowed.end(), batched_examples));
+    batch->push_back(std::move(variant));
+  }
+  *end_of_sequence = false;
+  return Status::OK();
+}
+
+Status RequestBatcher::RouteResults(const std::vector<Tensor>& outputs) {
+  Batch batch;
+  {
+    mutex_lock l(mu_);
+    if (in_flight_.empty()) {
+      return errors::FailedPrecondition(
+          "Received results but no batch was sent to the device.");
+    }
+    batch = std::move(in_flight_.front());
+    in_flight_.pop_front();
+  }
+
+  for (const Tensor& output : outputs) {
+    if (output.dims() == 0 || output.dim_size(0) != options_.batch_size) {
+      const Status status = errors::InvalidArgument(
+          "Expected the results of a batch to have ", options_.batch_size,
+          " examples, got a tensor with the shape ",
+          output.shape().DebugString(), ".");
+      FailBatch(batch, status);
+      return status;
+    }
+  }
+
+  int64 offset = 0;
+  for (Request& request : batch.requests) {
+    Result result;
+    for (const Tensor& output : outputs) {
+      // The outputs can alias buffers which are reused by the outfeed.
+      result.outputs.push_back(tensor::DeepCopy(
+          output.Slice(offset, offset + request.num_examples)));
+    }
+    offset += request.num_examples;
+    request.done(std::move(result));
+  }
+  return Status::OK();
+}
+
+void RequestBatcher::FailBatch(Batch& batch, const Status& status) {
+  for (Request& request : batch.requests) {
+    Result result;
+    result.status = status;
+    request.done(std::move(result));
+  }
+}
+
+Status RequestBatcher::StartRouting(ResultsFn next_results) {
+  if (routing_thread_) {
+    return errors::FailedPrecondition(
+        "The results of the request batcher are already being routed.");
+  }
+  routing_thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "request_batcher_routing",
+      [this, next_results]() { RoutingLoop(next_results); }));
+  return Status::OK();
+}
+
+void RequestBatcher::RoutingLoop(ResultsFn next_results) {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (in_flight_.empty() && !end_of_sequence_) {
+        in_flight_cv_.wait(l);
+      }
+      if (in_flight_.empty()) {
+        return;
+      }
+    }
+
+    std::vector<Tensor> outputs;
+    Status status = next_results(&outputs);
+    if (status.ok()) {
+      status = RouteResults(outputs);
+      if (!status.ok()) {
+        LOG(ERROR) << "Failed to route the results of a batch: " << status;
+      }
+      continue;
+    }
+
+    // The device loop stopped, so the batches in flight will not complete.
+    std::deque<Batch> in_flight;
+    {
+      mutex_lock l(mu_);
+      in_flight.swap(in_flight_);
+    }
+    for (Batch& batch : in_flight) {
+      FailBatch(batch, status);
+    }
+    if (errors::IsOutOfRange(status)) {
+      return;
+    }
+  }
+}
+
+void RequestBatcher::Close() {
+  {
+    mutex_lock l(mu_);
+    closed_ = true;
+  }
+  pending_cv_.notify_all();
+}
+
+Status RegisterRequestBatcher(const std::string& name,
+                              std::shared_ptr<RequestBatcher> batcher) {
+  mutex_lock l(registry_mu);
+  if (!Registry().emplace(name, std::move(batcher)).second) {
+    return errors::AlreadyExists("A request batcher named ", name,
+                                 " is already registered.");
+  }
+  return Status::OK();
+}
+
+std::shared_ptr<RequestBatcher> LookupRequestBatcher(const std::string& name) {
+  mutex_lock l(registry_mu);
+  auto itr = Registry().find(name);
+  return itr == Registry().end() ? nullptr : itr->second;
+}
+
+void UnregisterRequestBatcher(const std::string& name) {
+  mutex_lock l(registry_mu);
+  Registry().erase(name);
+}
+
+}  // namespace data
+}  // namespace tensorflow
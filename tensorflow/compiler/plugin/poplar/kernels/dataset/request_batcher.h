@@ -0,0 +1,163 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCHER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCHER_H_
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+struct RequestBatcherOptions {
+  // The batch size the IPU program was compiled with.
+  int64 batch_size = 1;
+  // How long the first request of a batch waits for more requests before the
+  // batch is padded and sent to the device.
+  int64 max_latency_micros = 1000;
+  // The number of requests which can wait for a batch, after which Submit
+  // fails with ResourceExhausted. Zero means there is no limit.
+  int64 max_pending_requests = 0;
+  // The batch sizes of the variants of the IPU program, in increasing order,
+  // the last of which is `batch_size`. When set, each batch is followed by a
+  // scalar int32 tensor with the index of the smallest variant which holds all
+  // of its examples, so that the program only computes that many. The outputs
+  // of each batch still have `batch_size` examples.
+  std::vector<int64> allowed_batch_sizes;
+};
+
+// Packs requests of a serving front end into batches of the size an IPU
+// program was compiled with, and routes the results of each batch back to the
+// requests it contains.
+//
+// The batches are read by an IPURequestBatchDataset, which feeds a long
+// running IPU loop through an infeed, so the device program does not have to
+// exit between requests. The results are pushed to an outfeed by the loop, and
+// are passed back to RouteResults in the same order, either by the caller or
+// by the thread started with StartRouting.
+//
+// Each request contains between 1 and batch_size examples along its first
+// dimension. A request is never split between batches. A batch which is sent
+// before it is full, because its deadline passed, is padded with zeros.
+class RequestBatcher {
+ public:
+  struct Result {
+    Status status;
+    std::vector<Tensor> outputs;
+  };
+  using DoneCallback = std::function<void(Result)>;
+  // Fetches the outputs of the next batch from the device, for example by
+  // dequeuing an outfeed. Returning OutOfRange stops the routing.
+  using ResultsFn = std::function<Status(std::vector<Tensor>*)>;
+
+  // `element_shapes` are the shapes of a single example of each input.
+  static Status Create(const RequestBatcherOptions& options,
+                       const DataTypeVector& dtypes,
+                       const std::vector<TensorShape>& element_shapes,
+                       std::unique_ptr<RequestBatcher>* batcher);
+  ~RequestBatcher();
+
+  // Queues a request. `done` is called from the routing thread once the
+  // outputs of the request, sliced out of the outputs of its batch, are
+  // available, or when the request fails.
+  Status Submit(std::vector<Tensor> inputs, DoneCallback done);
+  Status Submit(std::vector<Tensor> inputs, std::future<Result>* result);
+
+  // Blocks until a batch is ready. `end_of_sequence` is set once the batcher
+  // has been closed and all the pending requests have been batched.
+  Status GetNextBatch(std::vector<Tensor>* batch, bool* end_of_sequence);
+
+  // Completes the requests in the oldest batch which has not been completed.
+  Status RouteResults(const std::vector<Tensor>& outputs);
+
+  // Starts a thread which calls `next_results` and routes the results, for as
+  // long as batches are sent to the device. `next_results` must return once
+  // the device loop has stopped, as the thread is joined when the batcher is
+  // destroyed.
+  Status StartRouting(ResultsFn next_results);
+
+  // Stops accepting requests. The pending requests are still batched.
+  void Close();
+
+  const DataTypeVector& dtypes() const { return dtypes_; }
+  // The types and shapes of the tensors of each batch, with the batch size as
+  // the first dimension, followed by the variant index when there are allowed
+  // batch sizes.
+  const DataTypeVector& batch_dtypes() const { return batch_dtypes_; }
+  const std::vector<TensorShape>& batch_shapes() const { return batch_shapes_; }
+  int64 batch_size() const { return options_.batch_size; }
+
+ private:
+  struct Request {
+    std::vector<Tensor> inputs;
+    int64 num_examples;
+    uint64 enqueue_micros;
+    DoneCallback done;
+  };
+  struct Batch {
+    std::vector<Request> requests;
+  };
+
+  RequestBatcher(const RequestBatcherOptions& options,
+                 const DataTypeVector& dtypes,
+                 const std::vector<TensorShape>& element_shapes);
+
+  // Whether the pending requests can be sent as a batch at `now_micros`.
+  bool BatchReady(uint64 now_micros) const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void FailBatch(Batch& batch, const Status& status);
+  void RoutingLoop(ResultsFn next_results);
+
+  const RequestBatcherOptions options_;
+  const DataTypeVector dtypes_;
+  std::vector<TensorShape> element_shapes_;
+  DataTypeVector batch_dtypes_;
+  std::vector<TensorShape> batch_shapes_;
+
+  mutex mu_;
+  condition_variable pending_cv_;
+  condition_variable in_flight_cv_;
+  std::deque<Request> pending_ GUARDED_BY(mu_);
+  int64 pending_examples_ GUARDED_BY(mu_) = 0;
+  // The batches which were sent to the device, oldest first.
+  std::deque<Batch> in_flight_ GUARDED_BY(mu_);
+  bool closed_ GUARDED_BY(mu_) = false;
+  bool end_of_sequence_ GUARDED_BY(mu_) = false;
+
+  std::unique_ptr<Thread> routing_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RequestBatcher);
+};
+
+// Batchers are found by name by the IPURequestBatchDataset which reads them.
+Status RegisterRequestBatcher(const std::string& name,
+                              std::shared_ptr<RequestBatcher> batcher);
+std::shared_ptr<RequestBatcher> LookupRequestBatcher(const std::string& name);
+void UnregisterRequestBatcher(const std::string& name);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_REQUEST_BATCHER_H_
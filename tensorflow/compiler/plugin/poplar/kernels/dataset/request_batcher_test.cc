@@ -0,0 +1,225 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/request_batcher.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::unique_ptr<RequestBatcher> CreateBatcher(int64 batch_size,
+                                              int64 max_latency_micros) {
+  RequestBatcherOptions options;
+  options.batch_size = batch_size;
+  options.max_latency_micros = max_latency_micros;
+  std::unique_ptr<RequestBatcher> batcher;
+  TF_CHECK_OK(
+      RequestBatcher::Create(options, {DT_FLOAT}, {TensorShape({2})}, &batcher));
+  return batcher;
+}
+
+// A request of `num_examples` examples which all have the value `value`.
+std::vector<Tensor> MakeRequest(int64 num_examples, float value) {
+  Tensor t(DT_FLOAT, TensorShape({num_examples, 2}));
+  t.flat<float>().setConstant(value);
+  return {t};
+}
+
+TEST(RequestBatcherTest, FullBatchesArePacked) {
+  auto batcher = CreateBatcher(4, 60 * 1000 * 1000);
+  std::future<RequestBatcher::Result> first, second;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 1.0f), &first));
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(3, 2.0f), &second));
+
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_FALSE(end_of_sequence);
+  ASSERT_EQ(batch.size(), 1);
+  test::ExpectTensorEqual<float>(
+      batch[0], test::AsTensor<float>({1, 1, 2, 2, 2, 2, 2, 2},
+                                      TensorShape({4, 2})));
+
+  // The device doubles the inputs.
+  Tensor outputs(DT_FLOAT, TensorShape({4, 2}));
+  outputs.flat<float>() = batch[0].flat<float>() * 2.0f;
+  TF_ASSERT_OK(batcher->RouteResults({outputs}));
+
+  RequestBatcher::Result result = first.get();
+  TF_ASSERT_OK(result.status);
+  test::ExpectTensorEqual<float>(
+      result.outputs[0], test::AsTensor<float>({2, 2}, TensorShape({1, 2})));
+  result = second.get();
+  TF_ASSERT_OK(result.status);
+  test::ExpectTensorEqual<float>(
+      result.outputs[0],
+      test::AsTensor<float>({4, 4, 4, 4, 4, 4}, TensorShape({3, 2})));
+}
+
+TEST(RequestBatcherTest, BatchesArePaddedAfterTheDeadline) {
+  auto batcher = CreateBatcher(4, 1000);
+  std::future<RequestBatcher::Result> result;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 3.0f), &result));
+
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_FALSE(end_of_sequence);
+  test::ExpectTensorEqual<float>(
+      batch[0], test::AsTensor<float>({3, 3, 0, 0, 0, 0, 0, 0},
+                                      TensorShape({4, 2})));
+}
+
+TEST(RequestBatcherTest, RequestsAreNotSplitBetweenBatches) {
+  auto batcher = CreateBatcher(4, 1000);
+  std::future<RequestBatcher::Result> first, second;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(3, 1.0f), &first));
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(2, 2.0f), &second));
+
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  test::ExpectTensorEqual<float>(
+      batch[0], test::AsTensor<float>({1, 1, 1, 1, 1, 1, 0, 0},
+                                      TensorShape({4, 2})));
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  test::ExpectTensorEqual<float>(
+      batch[0], test::AsTensor<float>({2, 2, 2, 2, 0, 0, 0, 0},
+                                      TensorShape({4, 2})));
+}
+
+TEST(RequestBatcherTest, InvalidRequestsAreRejected) {
+  auto batcher = CreateBatcher(4, 1000);
+  std::future<RequestBatcher::Result> result;
+  EXPECT_FALSE(batcher->Submit(MakeRequest(5, 1.0f), &result).ok());
+  EXPECT_FALSE(
+      batcher->Submit({Tensor(DT_FLOAT, TensorShape({1, 3}))}, &result).ok());
+  EXPECT_FALSE(
+      batcher->Submit({Tensor(DT_INT32, TensorShape({1, 2}))}, &result).ok());
+  // No batch was sent, so there is nothing to route.
+  EXPECT_FALSE(batcher->RouteResults({}).ok());
+}
+
+TEST(RequestBatcherTest, AllowedBatchSizesSelectTheVariant) {
+  RequestBatcherOptions options;
+  options.batch_size = 16;
+  options.max_latency_micros = 1000;
+  options.allowed_batch_sizes = {1, 4, 16};
+  std::unique_ptr<RequestBatcher> batcher;
+  TF_ASSERT_OK(RequestBatcher::Create(options, {DT_FLOAT}, {TensorShape({2})},
+                                      &batcher));
+  EXPECT_EQ(batcher->batch_dtypes(), DataTypeVector({DT_FLOAT, DT_INT32}));
+  ASSERT_EQ(batcher->batch_shapes().size(), 2);
+  EXPECT_EQ(batcher->batch_shapes()[1], TensorShape({}));
+
+  std::future<RequestBatcher::Result> first, second, third;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 1.0f), &first));
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  ASSERT_EQ(batch.size(), 2);
+  EXPECT_EQ(batch[0].shape(), TensorShape({16, 2}));
+  EXPECT_EQ(batch[1].scalar<int32>()(), 0);
+
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(3, 2.0f), &second));
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(2, 2.0f), &third));
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_EQ(batch[1].scalar<int32>()(), 2);
+
+  // The batch sizes must increase up to the batch size.
+  options.allowed_batch_sizes = {4, 1, 16};
+  EXPECT_FALSE(RequestBatcher::Create(options, {DT_FLOAT}, {TensorShape({2})},
+                                      &batcher)
+                   .ok());
+  options.allowed_batch_sizes = {1, 4};
+  EXPECT_FALSE(RequestBatcher::Create(options, {DT_FLOAT}, {TensorShape({2})},
+                                      &batcher)
+                   .ok());
+}
+
+TEST(RequestBatcherTest, ClosingEndsTheSequence) {
+  auto batcher = CreateBatcher(4, 60 * 1000 * 1000);
+  std::future<RequestBatcher::Result> result;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 1.0f), &result));
+  batcher->Close();
+  EXPECT_TRUE(
+      errors::IsCancelled(batcher->Submit(MakeRequest(1, 1.0f), &result)));
+
+  // The pending request is still batched, without waiting for the deadline.
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_FALSE(end_of_sequence);
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST(RequestBatcherTest, RoutingThreadCompletesTheRequests) {
+  auto batcher = CreateBatcher(2, 1000);
+  TF_ASSERT_OK(batcher->StartRouting([](std::vector<Tensor>* outputs) {
+    Tensor t(DT_FLOAT, TensorShape({2, 2}));
+    t.flat<float>().setConstant(5.0f);
+    *outputs = {t};
+    return Status::OK();
+  }));
+
+  std::vector<std::future<RequestBatcher::Result>> results(4);
+  for (auto& result : results) {
+    TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 1.0f), &result));
+  }
+  std::vector<Tensor> batch;
+  bool end_of_sequence = true;
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  for (auto& result : results) {
+    RequestBatcher::Result r = result.get();
+    TF_ASSERT_OK(r.status);
+    test::ExpectTensorEqual<float>(
+        r.outputs[0], test::AsTensor<float>({5, 5}, TensorShape({1, 2})));
+  }
+
+  batcher->Close();
+  TF_ASSERT_OK(batcher->GetNextBatch(&batch, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST(RequestBatcherTest, DestroyingTheBatcherCancelsTheRequests) {
+  auto batcher = CreateBatcher(4, 60 * 1000 * 1000);
+  std::future<RequestBatcher::Result> result;
+  TF_ASSERT_OK(batcher->Submit(MakeRequest(1, 1.0f), &result));
+  batcher.reset();
+  EXPECT_TRUE(errors::IsCancelled(result.get().status));
+}
+
+TEST(RequestBatcherTest, Registry) {
+  std::shared_ptr<RequestBatcher> batcher = CreateBatcher(4, 1000);
+  TF_ASSERT_OK(RegisterRequestBatcher("serving", batcher));
+  EXPECT_TRUE(errors::IsAlreadyExists(
+      RegisterRequestBatcher("serving", CreateBatcher(4, 1000))));
+  EXPECT_EQ(LookupRequestBatcher("serving"), batcher);
+  UnregisterRequestBatcher("serving");
+  EXPECT_EQ(LookupRequestBatcher("serving"), nullptr);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,470 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/sequence_packing_dataset_op.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr const char* const SequencePackingDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    SequencePackingDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    SequencePackingDatasetOp::kMaxSequenceLength;
+/* static */ constexpr const char* const
+    SequencePackingDatasetOp::kMaxSequencesPerPack;
+/* static */ constexpr const char* const SequencePackingDatasetOp::kWindowSize;
+/* static */ constexpr const char* const SequencePackingDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    SequencePackingDatasetOp::kOutputShapes;
+
+constexpr char kInputImplEmpty[] = "input_impl_empty";
+constexpr char kPack[] = ".pack";
+constexpr char kNumPacks[] = ".num_packs";
+
+namespace {
+// The indices of the sequences of the window which are packed into one output
+// element, and their total length.
+struct Pack {
+  int64 length = 0;
+  std::vector<size_t> sequences;
+};
+}  // namespace
+
+class SequencePackingDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, int64 max_sequence_length,
+          int64 max_sequences_per_pack, int64 window_size,
+          const DatasetBase* input)
+      : DatasetBase(DatasetContext(ctx)),
+        max_sequence_length_(max_sequence_length),
+        max_sequences_per_pack_(max_sequences_per_pack),
+        window_size_(window_size),
+        input_(input) {
+    input_->Ref();
+
+    output_dtypes_ = input_->output_dtypes();
+    output_dtypes_.push_back(DT_INT32);
+    output_dtypes_.push_back(DT_INT32);
+
+    for (const PartialTensorShape& shape : input_->output_shapes()) {
+      PartialTensorShape output_shape({max_sequence_length_});
+      for (int64 dim = 1; dim != shape.dims(); ++dim) {
+        output_shape.AddDim(shape.dim_size(dim));
+      }
+      output_shapes_.push_back(output_shape);
+    }
+    // The segment ids and the position ids.
+    output_shapes_.emplace_back(PartialTensorShape({max_sequence_length_}));
+    output_shapes_.emplace_back(PartialTensorShape({max_sequence_length_}));
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_dtypes_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(max_sequence_length_, max_sequences_per_pack_,
+                    window_size_);
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  // The number of packs depends on the lengths of the sequences.
+  int64 Cardinality() const override {
+    int64 n = input_->Cardinality();
+    if (n == kInfiniteCardinality) {
+      return n;
+    }
+    return kUnknownCardinality;
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* max_sequence_length = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(max_sequence_length_, &max_sequence_length));
+    Node* max_sequences_per_pack = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(max_sequences_per_pack_, &max_sequences_per_pack));
+    Node* window_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(window_size_, &window_size));
+    TF_RETURN_IF_ERROR(b->AddDataset(this,
+                                     {input_graph_node, max_sequence_length,
+                                      max_sequences_per_pack, window_size},
+                                     {}, output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+    }
+
+    string BuildTraceMeName() override {
+      return strings::StrCat(
+          prefix(), "#max_sequence_length=", dataset()->max_sequence_length_,
+          ",window_size=", dataset()->window_size_, "#");
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      // Keep reading windows until one of them produces a pack, as a window
+      // may only contain empty sequences.
+      while (packs_.empty() && input_impl_) {
+        TF_RETURN_IF_ERROR(PackWindow(ctx));
+      }
+      if (packs_.empty()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *out_tensors = std::move(packs_.front());
+      packs_.pop_front();
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (!input_impl_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kInputImplEmpty), ""));
+      } else {
+        TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
+      }
+      // Save the packs of the current window which have not been read yet.
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(kNumPacks), static_cast<int64>(packs_.size())));
+      for (size_t i = 0; i != packs_.size(); ++i) {
+        for (size_t j = 0; j != packs_[i].size(); ++j) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              full_name(strings::StrCat(kPack, "[", i, "][", j, "]")),
+              packs_[i][j]));
+        }
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (!reader->Contains(full_name(kInputImplEmpty))) {
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      } else {
+        input_impl_.reset();
+      }
+      int64 num_packs;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNumPacks), &num_packs));
+      const size_t num_components = dataset()->output_dtypes_.size();
+      packs_.clear();
+      packs_.resize(num_packs);
+      for (int64 i = 0; i != num_packs; ++i) {
+        packs_[i].resize(num_components);
+        for (size_t j = 0; j != num_components; ++j) {
+          TF_RETURN_IF_ERROR(reader->ReadTensor(
+              full_name(strings::StrCat(kPack, "[", i, "][", j, "]")),
+              &packs_[i][j]));
+        }
+      }
+      return Status::OK();
+    }
+
+   private:
+    // Reads up to `window_size` sequences from the input, distributes them
+    // between packs with a first fit decreasing heuristic and builds the
+    // tensors of the packs in parallel.
+    Status PackWindow(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<std::vector<Tensor>> sequences;
+      std::vector<int64> lengths;
+      sequences.reserve(dataset()->window_size_);
+      lengths.reserve(dataset()->window_size_);
+      for (int64 i = 0; i != dataset()->window_size_; ++i) {
+        std::vector<Tensor> sequence;
+        bool end_of_sequence = false;
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, &sequence, &end_of_sequence));
+        if (end_of_sequence) {
+          input_impl_.reset();
+          break;
+        }
+        int64 length;
+        TF_RETURN_IF_ERROR(SequenceLength(sequence, &length));
+        // Empty sequences do not need a segment.
+        if (length == 0) {
+          continue;
+        }
+        sequences.push_back(std::move(sequence));
+        lengths.push_back(length);
+      }
+
+      std::vector<size_t> order(sequences.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(
+          order.begin(), order.end(),
+          [&lengths](size_t a, size_t b) { return lengths[a] > lengths[b]; });
+      std::vector<Pack> packs;
+      for (size_t sequence : order) {
+        auto itr = std::find_if(
+            packs.begin(), packs.end(), [&](const Pack& pack) {
+              return pack.length + lengths[sequence] <=
+                         dataset()->max_sequence_length_ &&
+                     static_cast<int64>(pack.sequences.size()) <
+                         dataset()->max_sequences_per_pack_;
+            });
+        if (itr == packs.end()) {
+          packs.emplace_back();
+          itr = std::prev(packs.end());
+        }
+        itr->length += lengths[sequence];
+        itr->sequences.push_back(sequence);
+      }
+
+      std::vector<std::vector<Tensor>> outputs(packs.size());
+      BlockingCounter counter(packs.size());
+      Status status;
+      mutex status_mu;
+      for (size_t i = 0; i != packs.size(); ++i) {
+        (*ctx->runner())([&, i]() {
+          Status s = BuildPack(ctx, sequences, lengths, &packs[i], &outputs[i]);
+          {
+            mutex_lock l(status_mu);
+            status.Update(s);
+          }
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+      TF_RETURN_IF_ERROR(status);
+
+      for (auto& output : outputs) {
+        packs_.push_back(std::move(output));
+      }
+      return Status::OK();
+    }
+
+    // Checks that all the components of `sequence` have the same length and
+    // that it fits in a pack.
+    Status SequenceLength(const std::vector<Tensor>& sequence,
+                          int64* length) const {
+      const auto& output_shapes = dataset()->output_shapes_;
+      for (size_t i = 0; i != sequence.size(); ++i) {
+        const TensorShape& shape = sequence[i].shape();
+        if (shape.dims() < 1) {
+          return errors::InvalidArgument(
+              "Component ", i, " of a sequence has shape ",
+              shape.DebugString(), ", which has no sequence dimension.");
+        }
+        TensorShape packed_shape = shape;
+        packed_shape.set_dim(0, dataset()->max_sequence_length_);
+        if (!output_shapes[i].IsCompatibleWith(packed_shape)) {
+          return errors::InvalidArgument(
+              "Component ", i, " of a sequence has shape ",
+              shape.DebugString(), ", which cannot be packed into shape ",
+              output_shapes[i].DebugString(), ".");
+        }
+        if (i != 0 && shape.dim_size(0) != *length) {
+          return errors::InvalidArgument(
+              "The components of a sequence must have the same length, but "
+              "component 0 has length ",
+              *length, " and component ", i, " has length ",
+              shape.dim_size(0), ".");
+        }
+        *length = shape.dim_size(0);
+      }
+      if (*length > dataset()->max_sequence_length_) {
+        return errors::InvalidArgument(
+            "A sequence of length ", *length,
+            " is longer than the maximum sequence length ",
+            dataset()->max_sequence_length_, ".");
+      }
+      return Status::OK();
+    }
+
+    // Copies the sequences of `pack` into zero padded tensors and generates
+    // its segment ids (starting at one, with zero for the padding) and its
+    // position ids.
+    Status BuildPack(IteratorContext* ctx,
+                     const std::vector<std::vector<Tensor>>& sequences,
+                     const std::vector<int64>& lengths, Pack* pack,
+                     std::vector<Tensor>* output) const {
+      const auto& output_dtypes = dataset()->output_dtypes_;
+      // Keep the order of the input inside the pack.
+      std::sort(pack->sequences.begin(), pack->sequences.end());
+
+      const size_t num_components = output_dtypes.size() - 2;
+      for (size_t i = 0; i != output_dtypes.size(); ++i) {
+        TensorShape shape({dataset()->max_sequence_length_});
+        if (i < num_components) {
+          shape = sequences[pack->sequences[0]][i].shape();
+          shape.set_dim(0, dataset()->max_sequence_length_);
+        }
+        output->emplace_back(ctx->allocator({}), output_dtypes[i], shape);
+        if (!output->back().IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate memory for the pack of component ", i);
+        }
+      }
+
+      for (size_t i = 0; i != num_components; ++i) {
+        Tensor& packed = (*output)[i];
+        char* data = const_cast<char*>(packed.tensor_data().data());
+        size_t offset = 0;
+        for (size_t sequence : pack->sequences) {
+          StringPiece src = sequences[sequence][i].tensor_data();
+          std::memcpy(data + offset, src.data(), src.size());
+          offset += src.size();
+        }
+        std::memset(data + offset, 0, packed.tensor_data().size() - offset);
+      }
+
+      auto segment_ids = (*output)[num_components].vec<int32>();
+      auto position_ids = (*output)[num_components + 1].vec<int32>();
+      segment_ids.setZero();
+      position_ids.setZero();
+      int64 offset = 0;
+      for (size_t i = 0; i != pack->sequences.size(); ++i) {
+        const int64 length = lengths[pack->sequences[i]];
+        for (int64 j = 0; j != length; ++j) {
+          segment_ids(offset + j) = i + 1;
+          position_ids(offset + j) = j;
+        }
+        offset += length;
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    // The packs of the current window which have not been returned yet.
+    std::deque<std::vector<Tensor>> packs_ GUARDED_BY(mu_);
+  };
+
+  const int64 max_sequence_length_;
+  const int64 max_sequences_per_pack_;
+  const int64 window_size_;
+  const DatasetBase* const input_;
+  DataTypeVector output_dtypes_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+SequencePackingDatasetOp::SequencePackingDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {}
+
+void SequencePackingDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase* input,
+                                           DatasetBase** output) {
+  int64 max_sequence_length = 0;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kMaxSequenceLength,
+                                                 &max_sequence_length));
+  OP_REQUIRES(ctx, max_sequence_length > 0,
+              errors::InvalidArgument(
+                  "Maximum sequence length must be greater than zero."));
+
+  int64 max_sequences_per_pack = 0;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kMaxSequencesPerPack,
+                                                 &max_sequences_per_pack));
+  OP_REQUIRES(ctx, max_sequences_per_pack > 0,
+              errors::InvalidArgument(
+                  "Maximum sequences per pack must be greater than zero."));
+
+  int64 window_size = 0;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kWindowSize, &window_size));
+  OP_REQUIRES(
+      ctx, window_size > 0,
+      errors::InvalidArgument("Window size must be greater than zero."));
+
+  // The sequences are copied into the packs as raw bytes, and the packs must
+  // have a static shape to be fed to the device.
+  for (size_t i = 0; i != input->output_dtypes().size(); ++i) {
+    OP_REQUIRES(ctx, DataTypeCanUseMemcpy(input->output_dtypes()[i]),
+                errors::InvalidArgument(
+                    "Cannot pack sequences of type ",
+                    DataTypeString(input->output_dtypes()[i]), "."));
+    const PartialTensorShape& shape = input->output_shapes()[i];
+    OP_REQUIRES(
+        ctx, shape.dims() >= 1,
+        errors::InvalidArgument("Component ", i, " of the input has shape ",
+                                shape.DebugString(),
+                                ", which has no sequence dimension."));
+    for (int64 dim = 1; dim != shape.dims(); ++dim) {
+      OP_REQUIRES(ctx, shape.dim_size(dim) >= 0,
+                  errors::InvalidArgument(
+                      "Component ", i, " of the input has shape ",
+                      shape.DebugString(),
+                      ", which is only allowed an unknown sequence "
+                      "dimension."));
+    }
+  }
+
+  *output = new Dataset(ctx, max_sequence_length, max_sequences_per_pack,
+                        window_size, input);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("IPUSequencePackingDataset").Device(DEVICE_CPU),
+                        SequencePackingDatasetOp);
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
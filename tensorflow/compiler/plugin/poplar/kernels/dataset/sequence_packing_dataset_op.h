@@ -0,0 +1,52 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SEQUENCE_PACKING_DATASET_OP_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SEQUENCE_PACKING_DATASET_OP_H_
+
+#include "tensorflow/core/framework/dataset.h"
+
+namespace tensorflow {
+namespace data {
+
+// A dataset which packs the variable length sequences of its input into
+// samples of `max_sequence_length`, so that they can be fed to a program with
+// fixed shapes without padding every sequence. Each output element has the
+// packed components of the input, followed by the segment ids and the position
+// ids of the pack.
+class SequencePackingDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "SequencePacking";
+  static constexpr const char* const kInputDataset = "input_dataset";
+  static constexpr const char* const kMaxSequenceLength = "max_sequence_length";
+  static constexpr const char* const kMaxSequencesPerPack =
+      "max_sequences_per_pack";
+  static constexpr const char* const kWindowSize = "window_size";
+  static constexpr const char* const kOutputTypes = "output_types";
+  static constexpr const char* const kOutputShapes = "output_shapes";
+
+  explicit SequencePackingDatasetOp(OpKernelConstruction* ctx);
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override;
+
+ private:
+  class Dataset;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SEQUENCE_PACKING_DATASET_OP_H_
@@ -0,0 +1,275 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/shared_memory_dataset_op.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/shared_memory_ring_buffer.h"
+#include "tensorflow/core/framework/function_handle_cache.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace data {
+
+/* static */ constexpr const char* const SharedMemoryDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    SharedMemoryDatasetOp::kRingBufferNames;
+/* static */ constexpr const char* const
+    SharedMemoryDatasetOp::kStartupTimeoutSeconds;
+/* static */ constexpr const char* const SharedMemoryDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const SharedMemoryDatasetOp::kOutputShapes;
+
+class SharedMemoryDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx,
+          const std::vector<std::string>& ring_buffer_names,
+          float startup_timeout_seconds, const DataTypeVector& output_types,
+          const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        ring_buffer_names_(ring_buffer_names),
+        startup_timeout_seconds_(startup_timeout_seconds),
+        output_types_(output_types),
+        output_shapes_(output_shapes) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_types_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.set_args(ring_buffer_names_.size());
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64 Cardinality() const override { return kUnknownCardinality; }
+
+  Status CheckExternalState() const override {
+    return errors::FailedPrecondition(
+        DebugString(), " depends on the elements of worker processes.");
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    AttrValue ring_buffer_names;
+    b->BuildAttrValue(ring_buffer_names_, &ring_buffer_names);
+    AttrValue startup_timeout_seconds;
+    b->BuildAttrValue(startup_timeout_seconds_, &startup_timeout_seconds);
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {},
+        {{kRingBufferNames, ring_buffer_names},
+         {kStartupTimeoutSeconds, startup_timeout_seconds}},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      const int64 timeout_us = dataset()->startup_timeout_seconds_ * 1e6;
+      for (const std::string& name : dataset()->ring_buffer_names_) {
+        std::shared_ptr<SharedMemoryRingBuffer> ring;
+        TF_RETURN_IF_ERROR(
+            SharedMemoryRingBuffer::Open(name, timeout_us, &ring));
+        rings_.push_back(std::move(ring));
+      }
+      return Status::OK();
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      while (!rings_.empty()) {
+        next_ring_ %= rings_.size();
+        bool ring_ended = false;
+        TF_RETURN_IF_ERROR(rings_[next_ring_]->Read(out_tensors, &ring_ended));
+        if (ring_ended) {
+          rings_.erase(rings_.begin() + next_ring_);
+          continue;
+        }
+        TF_RETURN_IF_ERROR(CheckElement(*out_tensors));
+        ++next_ring_;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+      *end_of_sequence = true;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+   private:
+    Status CheckElement(const std::vector<Tensor>& element) const {
+      const auto& output_types = dataset()->output_types_;
+      const auto& output_shapes = dataset()->output_shapes_;
+      if (element.size() != output_types.size()) {
+        return errors::InvalidArgument(
+            "A worker produced an element with ", element.size(),
+            " components, but the dataset has ", output_types.size(), ".");
+      }
+      for (size_t i = 0; i != element.size(); ++i) {
+        if (element[i].dtype() != output_types[i] ||
+            !output_shapes[i].IsCompatibleWith(element[i].shape())) {
+          return errors::InvalidArgument(
+              "Component ", i, " of an element produced by a worker is a ",
+              DataTypeString(element[i].dtype()), " tensor of shape ",
+              element[i].shape().DebugString(), ", but the dataset expects a ",
+              DataTypeString(output_types[i]), " tensor of shape ",
+              output_shapes[i].DebugString(), ".");
+        }
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    // The ring buffers of the workers which have not ended yet.
+    std::vector<std::shared_ptr<SharedMemoryRingBuffer>> rings_
+        GUARDED_BY(mu_);
+    size_t next_ring_ GUARDED_BY(mu_) = 0;
+  };
+
+  const std::vector<std::string> ring_buffer_names_;
+  const float startup_timeout_seconds_;
+  const DataTypeVector output_types_;
+  const std::vector<PartialTensorShape> output_shapes_;
+};
+
+SharedMemoryDatasetOp::SharedMemoryDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kRingBufferNames, &ring_buffer_names_));
+  OP_REQUIRES_OK(
+      ctx, ctx->GetAttr(kStartupTimeoutSeconds, &startup_timeout_seconds_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+  OP_REQUIRES(ctx, output_types_.size() == output_shapes_.size(),
+              errors::InvalidArgument(
+                  "The number of output types and shapes must match."));
+}
+
+void SharedMemoryDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                        DatasetBase** output) {
+  *output = new Dataset(ctx, ring_buffer_names_, startup_timeout_seconds_,
+                        output_types_, output_shapes_);
+}
+
+namespace {
+// Runs in a worker process: iterates over its input dataset and writes every
+// element into a new shared memory ring buffer, which is read by an
+// IPUSharedMemoryDataset in the process `consumer_pid`.
+class SharedMemoryDatasetWriterOp : public AsyncOpKernel {
+ public:
+  explicit SharedMemoryDatasetWriterOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx),
+        background_worker_(ctx->env(), "ipu_shared_memory_dataset_writer") {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ring_buffer_name", &ring_buffer_name_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_slots", &num_slots_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("slot_size", &slot_size_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("consumer_pid", &consumer_pid_));
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    // Getting the next element may block on an inter-op thread, so the
+    // elements are written from a background thread.
+    background_worker_.Schedule([this, ctx, done]() {
+      ctx->SetStatus(WriteDataset(ctx));
+      done();
+    });
+  }
+
+ private:
+  Status WriteDataset(OpKernelContext* ctx) {
+    DatasetBase* dataset;
+    TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(ctx->input(0), &dataset));
+    std::shared_ptr<SharedMemoryRingBuffer> ring;
+    TF_RETURN_IF_ERROR(SharedMemoryRingBuffer::Create(
+        ring_buffer_name_, num_slots_, slot_size_, consumer_pid_, &ring));
+
+    // Errors are passed on to the consumer, which returns them from GetNext.
+    Status status = WriteElements(ctx, dataset, ring.get());
+    ring->Finish(status);
+    return status;
+  }
+
+  Status WriteElements(OpKernelContext* ctx, DatasetBase* dataset,
+                       SharedMemoryRingBuffer* ring) {
+    IteratorContext::Params params(ctx);
+    FunctionHandleCache function_handle_cache(params.flr);
+    params.function_handle_cache = &function_handle_cache;
+    ResourceMgr resource_mgr;
+    params.resource_mgr = &resource_mgr;
+    CancellationManager cancellation_manager;
+    params.cancellation_manager = &cancellation_manager;
+    IteratorContext iter_ctx(std::move(params));
+
+    std::unique_ptr<IteratorBase> iterator;
+    TF_RETURN_IF_ERROR(dataset->MakeIterator(
+        &iter_ctx, "SharedMemoryDatasetWriter", &iterator));
+
+    std::vector<Tensor> element;
+    bool end_of_sequence = false;
+    while (true) {
+      TF_RETURN_IF_ERROR(
+          iterator->GetNext(&iter_ctx, &element, &end_of_sequence));
+      if (end_of_sequence) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(ring->Write(element));
+      element.clear();
+    }
+  }
+
+  BackgroundWorker background_worker_;
+  std::string ring_buffer_name_;
+  int64 num_slots_;
+  int64 slot_size_;
+  int64 consumer_pid_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("IPUSharedMemoryDataset").Device(DEVICE_CPU),
+                        SharedMemoryDatasetOp);
+REGISTER_KERNEL_BUILDER(
+    Name("IPUSharedMemoryDatasetWriter").Device(DEVICE_CPU),
+    SharedMemoryDatasetWriterOp);
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
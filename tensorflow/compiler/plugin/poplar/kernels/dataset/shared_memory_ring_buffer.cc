@@ -0,0 +1,394 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/shared_memory_ring_buffer.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <new>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+constexpr uint64 kMagic = 0x49505553484d5242ULL;
+// The alignment of the slots and of the tensors inside them.
+constexpr size_t kAlignment = 64;
+// How often a waiting side checks that the other process is still alive.
+constexpr int64 kPeerCheckIntervalUs = 100000;
+constexpr int64 kMaxSleepUs = 1000;
+constexpr int64 kNumSpins = 1000;
+
+enum SlotState : uint32 { kFree = 0, kFull = 1, kInUse = 2 };
+
+// The start of each slot, followed by a ComponentHeader and the dimensions of
+// each component at kAlignment, followed by the aligned data of each
+// component.
+struct SlotHeader {
+  std::atomic<uint32> state;
+  uint32 num_components;
+};
+
+struct ComponentHeader {
+  int32 dtype;
+  int32 dims;
+  uint64 bytes;
+  uint64 data_offset;
+};
+
+size_t RoundUp(size_t value) {
+  return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+size_t MetadataSize(const std::vector<Tensor>& element) {
+  size_t size = kAlignment;
+  for (const Tensor& tensor : element) {
+    size += sizeof(ComponentHeader) + tensor.dims() * sizeof(int64);
+  }
+  return size;
+}
+
+bool ProcessIsAlive(int64 pid) {
+  return pid <= 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+// Polls `ready` until it returns true, spinning for a short while before
+// backing off to sleeping. Fails once the process `peer_pid` has exited.
+Status WaitUntil(const std::function<bool()>& ready, int64 peer_pid,
+                 const char* peer) {
+  int64 sleep_us = 0;
+  int64 waited_us = 0;
+  int64 next_check_us = kPeerCheckIntervalUs;
+  for (int64 spins = 0; !ready(); ++spins) {
+    if (spins < kNumSpins) {
+      continue;
+    }
+    sleep_us = std::min(std::max<int64>(2 * sleep_us, 1), kMaxSleepUs);
+    Env::Default()->SleepForMicroseconds(sleep_us);
+    waited_us += sleep_us;
+    if (waited_us >= next_check_us) {
+      next_check_us += kPeerCheckIntervalUs;
+      // Check once more in case the other side made progress before exiting.
+      if (!ProcessIsAlive(peer_pid) && !ready()) {
+        return errors::Aborted("The ", peer, " process (", peer_pid,
+                               ") of the shared memory ring buffer exited.");
+      }
+    }
+  }
+  return Status::OK();
+}
+}  // namespace
+
+// The start of the shared memory object. The slots start at the next multiple
+// of kAlignment.
+struct SharedMemoryRingBuffer::Header {
+  std::atomic<uint64> magic;
+  uint64 num_slots;
+  uint64 slot_size;
+  int64 producer_pid;
+  int64 consumer_pid;
+  std::atomic<uint32> finished;
+  int32 error_code;
+  char error_message[1024];
+};
+
+// Gives a slot back to the producer once all the tensors pointing into it have
+// been released.
+class SharedMemoryRingBuffer::SlotLease {
+ public:
+  SlotLease(std::shared_ptr<SharedMemoryRingBuffer> ring,
+            std::atomic<uint32>* state)
+      : ring_(std::move(ring)), state_(state) {}
+
+  ~SlotLease() { state_->store(kFree, std::memory_order_release); }
+
+ private:
+  // Keeps the memory mapped while the slot is in use.
+  std::shared_ptr<SharedMemoryRingBuffer> ring_;
+  std::atomic<uint32>* state_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SlotLease);
+};
+
+class SharedMemoryRingBuffer::SlotTensorBuffer : public TensorBuffer {
+ public:
+  SlotTensorBuffer(void* data, size_t size, std::shared_ptr<SlotLease> lease)
+      : TensorBuffer(data), size_(size), lease_(std::move(lease)) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("shared_memory_ring_buffer");
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+  std::shared_ptr<SlotLease> lease_;
+};
+
+Status SharedMemoryRingBuffer::Create(
+    const std::string& name, int64 num_slots, int64 slot_size,
+    int64 consumer_pid, std::shared_ptr<SharedMemoryRingBuffer>* output) {
+  if (num_slots < 1 || slot_size < 1) {
+    return errors::InvalidArgument(
+        "A shared memory ring buffer needs at least one slot of at least one "
+        "byte.");
+  }
+  const size_t rounded_slot_size = RoundUp(slot_size);
+  const size_t mapped_size =
+      RoundUp(sizeof(Header)) + num_slots * rounded_slot_size;
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return errors::Internal("Failed to create the shared memory object ", name,
+                            ": ", std::strerror(errno));
+  }
+  if (ftruncate(fd, mapped_size) != 0) {
+    const int error = errno;
+    close(fd);
+    shm_unlink(name.c_str());
+    return errors::ResourceExhausted("Failed to allocate ", mapped_size,
+                                     " bytes of shared memory for ", name,
+                                     ": ", std::strerror(error));
+  }
+  void* base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  const int error = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return errors::Internal("Failed to map the shared memory object ", name,
+                            ": ", std::strerror(error));
+  }
+
+  // The memory is zero filled, so every slot starts in the free state. The
+  // magic number is written last, so that the consumer only opens a fully
+  // initialized ring buffer.
+  Header* header = new (base) Header();
+  header->num_slots = num_slots;
+  header->slot_size = rounded_slot_size;
+  header->producer_pid = getpid();
+  header->consumer_pid = consumer_pid;
+  header->magic.store(kMagic, std::memory_order_release);
+
+  output->reset(
+      new SharedMemoryRingBuffer(static_cast<char*>(base), mapped_size));
+  return Status::OK();
+}
+
+Status SharedMemoryRingBuffer::Open(
+    const std::string& name, int64 timeout_us,
+    std::shared_ptr<SharedMemoryRingBuffer>* output) {
+  Env* env = Env::Default();
+  const uint64 start_us = env->NowMicros();
+  while (true) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd >= 0) {
+      struct stat file_stat;
+      if (fstat(fd, &file_stat) == 0 &&
+          static_cast<size_t>(file_stat.st_size) >= RoundUp(sizeof(Header))) {
+        const size_t mapped_size = file_stat.st_size;
+        void* base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        const int error = errno;
+        close(fd);
+        if (base == MAP_FAILED) {
+          return errors::Internal("Failed to map the shared memory object ",
+                                  name, ": ", std::strerror(error));
+        }
+        Header* header = static_cast<Header*>(base);
+        if (header->magic.load(std::memory_order_acquire) == kMagic) {
+          shm_unlink(name.c_str());
+          if (mapped_size !=
+              RoundUp(sizeof(Header)) + header->num_slots * header->slot_size) {
+            munmap(base, mapped_size);
+            return errors::Internal("The shared memory object ", name,
+                                    " has an unexpected size.");
+          }
+          output->reset(new SharedMemoryRingBuffer(static_cast<char*>(base),
+                                                   mapped_size));
+          return Status::OK();
+        }
+        munmap(base, mapped_size);
+      } else {
+        close(fd);
+      }
+    } else if (errno != ENOENT) {
+      return errors::Internal("Failed to open the shared memory object ", name,
+                              ": ", std::strerror(errno));
+    }
+
+    if (static_cast<int64>(env->NowMicros() - start_us) > timeout_us) {
+      return errors::DeadlineExceeded(
+          "Timed out waiting for the shared memory object ", name,
+          " to be created.");
+    }
+    env->SleepForMicroseconds(kMaxSleepUs);
+  }
+}
+
+SharedMemoryRingBuffer::SharedMemoryRingBuffer(char* base, size_t mapped_size)
+    : base_(base),
+      mapped_size_(mapped_size),
+      header_(reinterpret_cast<Header*>(base)) {}
+
+SharedMemoryRingBuffer::~SharedMemoryRingBuffer() {
+  munmap(base_, mapped_size_);
+}
+
+char* SharedMemoryRingBuffer::Slot(uint64 index) const {
+  return base_ + RoundUp(sizeof(Header)) +
+         (index % header_->num_slots) * header_->slot_size;
+}
+
+int64 SharedMemoryRingBuffer::RequiredSlotSize(
+    const std::vector<Tensor>& element) {
+  size_t size = RoundUp(MetadataSize(element));
+  for (const Tensor& tensor : element) {
+    size = RoundUp(size + tensor.tensor_data().size());
+  }
+  return size;
+}
+
+Status SharedMemoryRingBuffer::Write(const std::vector<Tensor>& element) {
+  for (const Tensor& tensor : element) {
+    if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+      return errors::InvalidArgument(
+          "Tensors of type ", DataTypeString(tensor.dtype()),
+          " cannot be passed through a shared memory ring buffer.");
+    }
+  }
+  const uint64 required_size = RequiredSlotSize(element);
+  if (required_size > header_->slot_size) {
+    return errors::ResourceExhausted(
+        "An element needs ", required_size, " bytes, which is more than the ",
+        header_->slot_size, " bytes of a slot of the shared memory ring "
+        "buffer.");
+  }
+
+  char* slot = Slot(next_index_);
+  SlotHeader* slot_header = reinterpret_cast<SlotHeader*>(slot);
+  TF_RETURN_IF_ERROR(WaitUntil(
+      [slot_header] {
+        return slot_header->state.load(std::memory_order_acquire) == kFree;
+      },
+      header_->consumer_pid, "consumer"));
+
+  slot_header->num_components = element.size();
+  char* record = slot + kAlignment;
+  size_t data_offset = RoundUp(MetadataSize(element));
+  for (const Tensor& tensor : element) {
+    const StringPiece data = tensor.tensor_data();
+    ComponentHeader* component = reinterpret_cast<ComponentHeader*>(record);
+    component->dtype = tensor.dtype();
+    component->dims = tensor.dims();
+    component->bytes = data.size();
+    component->data_offset = data_offset;
+    int64* dim_sizes =
+        reinterpret_cast<int64*>(record + sizeof(ComponentHeader));
+    for (int dim = 0; dim != tensor.dims(); ++dim) {
+      dim_sizes[dim] = tensor.dim_size(dim);
+    }
+    std::memcpy(slot + data_offset, data.data(), data.size());
+
+    record += sizeof(ComponentHeader) + tensor.dims() * sizeof(int64);
+    data_offset = RoundUp(data_offset + data.size());
+  }
+
+  slot_header->state.store(kFull, std::memory_order_release);
+  ++next_index_;
+  return Status::OK();
+}
+
+void SharedMemoryRingBuffer::Finish(const Status& status) {
+  header_->error_code = status.code();
+  if (!status.ok()) {
+    std::strncpy(header_->error_message, status.error_message().c_str(),
+                 sizeof(header_->error_message) - 1);
+  }
+  header_->finished.store(1, std::memory_order_release);
+}
+
+Status SharedMemoryRingBuffer::Read(std::vector<Tensor>* element,
+                                    bool* end_of_sequence) {
+  char* slot = Slot(next_index_);
+  SlotHeader* slot_header = reinterpret_cast<SlotHeader*>(slot);
+  TF_RETURN_IF_ERROR(WaitUntil(
+      [this, slot_header] {
+        return slot_header->state.load(std::memory_order_acquire) == kFull ||
+               header_->finished.load(std::memory_order_acquire);
+      },
+      header_->producer_pid, "producer"));
+
+  // Everything the producer wrote before it finished is visible, so the slot
+  // is only empty when there are no more elements.
+  if (slot_header->state.load(std::memory_order_acquire) != kFull) {
+    if (header_->error_code != error::OK) {
+      return Status(static_cast<error::Code>(header_->error_code),
+                    header_->error_message);
+    }
+    *end_of_sequence = true;
+    return Status::OK();
+  }
+
+  slot_header->state.store(kInUse, std::memory_order_relaxed);
+  auto lease =
+      std::make_shared<SlotLease>(shared_from_this(), &slot_header->state);
+
+  element->clear();
+  const char* record = slot + kAlignment;
+  for (uint32 i = 0; i != slot_header->num_components; ++i) {
+    const ComponentHeader* component =
+        reinterpret_cast<const ComponentHeader*>(record);
+    const int64* dim_sizes =
+        reinterpret_cast<const int64*>(record + sizeof(ComponentHeader));
+    TensorShape shape;
+    for (int dim = 0; dim != component->dims; ++dim) {
+      shape.AddDim(dim_sizes[dim]);
+    }
+    auto* buffer = new SlotTensorBuffer(slot + component->data_offset,
+                                        component->bytes, lease);
+    element->emplace_back(static_cast<DataType>(component->dtype), shape,
+                          buffer);
+    buffer->Unref();
+
+    record += sizeof(ComponentHeader) + component->dims * sizeof(int64);
+  }
+
+  ++next_index_;
+  *end_of_sequence = false;
+  return Status::OK();
+}
+
+}  // namespace data
+}  // namespace tensorflow
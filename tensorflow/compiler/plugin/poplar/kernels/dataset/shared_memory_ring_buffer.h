@@ -0,0 +1,92 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SHARED_MEMORY_RING_BUFFER_H_
+#define TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SHARED_MEMORY_RING_BUFFER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// A ring buffer of dataset elements in a POSIX shared memory object, which is
+// written by a single producer process and read by a single consumer process.
+//
+// Each element is written into one slot of the ring. The tensors returned by
+// Read point straight into the shared memory, so reading an element does not
+// copy it, and its slot is only given back to the producer once all of these
+// tensors have been released. Only types which can be memcpy'd are supported.
+//
+// The two sides poll the state of the slots, so neither needs a lock shared
+// between the processes. Each side gives up when the other process exits.
+class SharedMemoryRingBuffer
+    : public std::enable_shared_from_this<SharedMemoryRingBuffer> {
+ public:
+  // Creates the shared memory object `name` with `num_slots` slots of
+  // `slot_size` bytes each, which will be read by the process `consumer_pid`.
+  static Status Create(const std::string& name, int64 num_slots,
+                       int64 slot_size, int64 consumer_pid,
+                       std::shared_ptr<SharedMemoryRingBuffer>* output);
+
+  // Opens the shared memory object `name`, waiting for up to `timeout_us`
+  // microseconds for the producer to create it. The name is unlinked once it
+  // has been opened, so the memory is freed when both sides have closed it.
+  static Status Open(const std::string& name, int64 timeout_us,
+                     std::shared_ptr<SharedMemoryRingBuffer>* output);
+
+  ~SharedMemoryRingBuffer();
+
+  // Producer side. Copies `element` into the next slot, waiting for the
+  // consumer to release it first.
+  Status Write(const std::vector<Tensor>& element);
+  // Producer side. Marks the end of the elements. A non-OK `status` is
+  // returned by the Read which would have returned the next element.
+  void Finish(const Status& status);
+
+  // Consumer side. Reads the next element without copying it.
+  Status Read(std::vector<Tensor>* element, bool* end_of_sequence);
+
+  // The number of bytes of a slot needed to hold `element`.
+  static int64 RequiredSlotSize(const std::vector<Tensor>& element);
+
+ private:
+  struct Header;
+  class SlotLease;
+  class SlotTensorBuffer;
+
+  SharedMemoryRingBuffer(char* base, size_t mapped_size);
+
+  char* Slot(uint64 index) const;
+
+  char* const base_;
+  const size_t mapped_size_;
+  Header* const header_;
+  // The index of the next slot written by the producer or read by the
+  // consumer, depending on the side this object is used on.
+  uint64 next_index_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedMemoryRingBuffer);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_PLUGIN_POPLAR_KERNELS_DATASET_SHARED_MEMORY_RING_BUFFER_H_
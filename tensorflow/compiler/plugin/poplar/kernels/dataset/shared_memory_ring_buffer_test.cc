@@ -0,0 +1,143 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/kernels/dataset/shared_memory_ring_buffer.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::string RingBufferName(const std::string& test) {
+  return strings::StrCat("/ipu_ring_buffer_test_", getpid(), "_", test);
+}
+
+// Creates a ring buffer and opens it from the same process.
+void CreateAndOpen(const std::string& name, int64 num_slots, int64 slot_size,
+                   std::shared_ptr<SharedMemoryRingBuffer>* producer,
+                   std::shared_ptr<SharedMemoryRingBuffer>* consumer) {
+  TF_ASSERT_OK(SharedMemoryRingBuffer::Create(name, num_slots, slot_size,
+                                              getpid(), producer));
+  TF_ASSERT_OK(SharedMemoryRingBuffer::Open(name, 1000000, consumer));
+}
+
+TEST(SharedMemoryRingBufferTest, RoundTrip) {
+  std::shared_ptr<SharedMemoryRingBuffer> producer, consumer;
+  CreateAndOpen(RingBufferName("round_trip"), 2, 1024, &producer, &consumer);
+
+  for (int32 i = 0; i != 5; ++i) {
+    Tensor values = test::AsTensor<float>({1.f * i, 2.f, 3.f, 4.f, 5.f, 6.f},
+                                          TensorShape({2, 3}));
+    Tensor index = test::AsScalar<int32>(i);
+    TF_ASSERT_OK(producer->Write({values, index}));
+
+    std::vector<Tensor> element;
+    bool end_of_sequence = true;
+    TF_ASSERT_OK(consumer->Read(&element, &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    ASSERT_EQ(element.size(), 2);
+    test::ExpectTensorEqual<float>(element[0], values);
+    test::ExpectTensorEqual<int32>(element[1], index);
+    // The tensors point into the shared memory, at aligned addresses.
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(element[0].tensor_data().data()) %
+                  EIGEN_MAX_ALIGN_BYTES,
+              0);
+  }
+
+  producer->Finish(Status::OK());
+  std::vector<Tensor> element;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(consumer->Read(&element, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST(SharedMemoryRingBufferTest, SlotIsReusedAfterRelease) {
+  std::shared_ptr<SharedMemoryRingBuffer> producer, consumer;
+  CreateAndOpen(RingBufferName("reuse"), 1, 256, &producer, &consumer);
+
+  TF_ASSERT_OK(producer->Write({test::AsScalar<int32>(1)}));
+  std::vector<Tensor> first;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(consumer->Read(&first, &end_of_sequence));
+
+  // The only slot is still used by `first`, so the next write has to wait.
+  std::atomic<bool> written(false);
+  std::thread writer([&] {
+    TF_EXPECT_OK(producer->Write({test::AsScalar<int32>(2)}));
+    written = true;
+  });
+  Env::Default()->SleepForMicroseconds(100000);
+  EXPECT_FALSE(written);
+  test::ExpectTensorEqual<int32>(first[0], test::AsScalar<int32>(1));
+
+  first.clear();
+  writer.join();
+  EXPECT_TRUE(written);
+
+  std::vector<Tensor> second;
+  TF_ASSERT_OK(consumer->Read(&second, &end_of_sequence));
+  test::ExpectTensorEqual<int32>(second[0], test::AsScalar<int32>(2));
+}
+
+TEST(SharedMemoryRingBufferTest, ErrorIsPassedToConsumer) {
+  std::shared_ptr<SharedMemoryRingBuffer> producer, consumer;
+  CreateAndOpen(RingBufferName("error"), 2, 256, &producer, &consumer);
+
+  TF_ASSERT_OK(producer->Write({test::AsScalar<int32>(1)}));
+  producer->Finish(errors::InvalidArgument("Failed to decode an image."));
+
+  std::vector<Tensor> element;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(consumer->Read(&element, &end_of_sequence));
+  EXPECT_FALSE(end_of_sequence);
+
+  Status status = consumer->Read(&element, &end_of_sequence);
+  EXPECT_EQ(status.code(), error::INVALID_ARGUMENT);
+  EXPECT_EQ(status.error_message(), "Failed to decode an image.");
+}
+
+TEST(SharedMemoryRingBufferTest, ElementTooLarge) {
+  std::shared_ptr<SharedMemoryRingBuffer> producer, consumer;
+  CreateAndOpen(RingBufferName("too_large"), 2, 256, &producer, &consumer);
+
+  Tensor large(DT_FLOAT, TensorShape({1024}));
+  large.flat<float>().setZero();
+  EXPECT_EQ(producer->Write({large}).code(), error::RESOURCE_EXHAUSTED);
+  EXPECT_EQ(producer->Write({test::AsScalar<tstring>("a")}).code(),
+            error::INVALID_ARGUMENT);
+}
+
+TEST(SharedMemoryRingBufferTest, OpenTimesOut) {
+  std::shared_ptr<SharedMemoryRingBuffer> consumer;
+  Status status =
+      SharedMemoryRingBuffer::Open(RingBufferName("missing"), 10000, &consumer);
+  EXPECT_EQ(status.code(), error::DEADLINE_EXCEEDED);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -32,7 +32,6 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/env.h"
-#include "tensorflow/core/util/batch_util.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
 #include "tensorflow/compiler/tf2xla/shape_util.h"
@@ -53,6 +52,9 @@ const std::set<DataType> ok_types = {
     DataType::DT_FLOAT,
     DataType::DT_HALF,
     DataType::DT_BOOL,
+    // 8 bit integers, e.g. image pixels, which are normalized on the device.
+    DataType::DT_INT8,
+    DataType::DT_UINT8,
 };
 
 struct TypeToStringFormatter {
@@ -133,6 +135,75 @@ void GetOutfeedMode(OpKernelConstruction* ctx,
                                 ", supported values are 'all' and 'get_last'"));
   }
 }
+
+void GetOutfeedReduction(OpKernelConstruction* ctx,
+                         xla::poplarplugin::PoplarFeedConfig& config) {
+  std::string reduction_str;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("reduction", &reduction_str));
+  if (reduction_str == "none") {
+    config.set_reduction(xla::poplarplugin::PoplarFeedConfig::NoReduction);
+  } else if (reduction_str == "sum") {
+    config.set_reduction(xla::poplarplugin::PoplarFeedConfig::Sum);
+  } else if (reduction_str == "mean") {
+    config.set_reduction(xla::poplarplugin::PoplarFeedConfig::Mean);
+  } else if (reduction_str == "max") {
+    config.set_reduction(xla::poplarplugin::PoplarFeedConfig::Max);
+  } else {
+    OP_REQUIRES(ctx, false,
+                errors::InvalidArgument(
+                    "Unknown reduction : ", reduction_str,
+                    ", supported values are 'none', 'sum', 'mean' and 'max'"));
+  }
+
+  bool transfer_as_fp16;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("transfer_as_fp16", &transfer_as_fp16));
+  config.set_transfer_as_fp16(transfer_as_fp16);
+}
+
+void GetOutfeedFileSink(OpKernelConstruction* ctx,
+                        xla::poplarplugin::PoplarFeedConfig& config) {
+  std::string prefix;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("file_sink_prefix", &prefix));
+  if (prefix.empty()) {
+    return;
+  }
+  OP_REQUIRES(ctx, config.mode() == xla::poplarplugin::PoplarFeedConfig::GetAll,
+              errors::InvalidArgument(
+                  "A file sink requires the 'all' outfeed_mode."));
+  config.set_file_sink_prefix(prefix);
+
+  std::string format_str;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("file_sink_format", &format_str));
+  if (format_str == "tfrecord") {
+    config.set_file_sink_format(xla::poplarplugin::PoplarFeedConfig::TFRecord);
+  } else if (format_str == "raw") {
+    config.set_file_sink_format(xla::poplarplugin::PoplarFeedConfig::Raw);
+  } else {
+    OP_REQUIRES(ctx, false,
+                errors::InvalidArgument(
+                    "Unknown file_sink_format : ", format_str,
+                    ", supported values are 'tfrecord' and 'raw'"));
+  }
+
+  int64 elements_per_file;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("file_sink_elements_per_file",
+                                   &elements_per_file));
+  OP_REQUIRES(ctx, elements_per_file >= 0,
+              errors::InvalidArgument(
+                  "Need file_sink_elements_per_file >= 0, got ",
+                  elements_per_file));
+  config.set_file_sink_elements_per_file(elements_per_file);
+}
+
+// Reads the bound of an autotuned feed value, which is zero when the value is
+// not autotuned.
+void GetAutotuningBound(OpKernelConstruction* ctx, const std::string& attr,
+                        int64 value, int64* bound) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(attr, bound));
+  OP_REQUIRES(ctx, *bound == 0 || value <= *bound,
+              errors::InvalidArgument("Need 0 or at least ", value, " for ",
+                                      attr, ", got ", *bound));
+}
 }  // namespace
 
 class PopDatastreamInfeedDequeueOp : public XlaOpKernel {
@@ -141,6 +212,13 @@ class PopDatastreamInfeedDequeueOp : public XlaOpKernel {
       : XlaOpKernel(ctx) {
     GetFeedConfig(ctx, config_);
     XlaShapesFromAttr(ctx, xla_shapes_);
+    int64 max_prefetch_depth;
+    GetAutotuningBound(ctx, "max_prefetch_depth", config_.prefetch_depth(),
+                       &max_prefetch_depth);
+    OP_REQUIRES(ctx, max_prefetch_depth < 256,
+                errors::InvalidArgument("Need max_prefetch_depth < 256, got ",
+                                        max_prefetch_depth));
+    config_.set_max_prefetch_depth(max_prefetch_depth);
   }
 
   ~PopDatastreamInfeedDequeueOp() override{};
@@ -248,12 +326,58 @@ class IPUDeleteDatasetIteratorOp : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("IPUDeleteDatasetIterator").Device(DEVICE_CPU),
                         IPUDeleteDatasetIteratorOp);
 
+class IPUInfeedStatisticsOp : public OpKernel {
+ public:
+  explicit IPUInfeedStatisticsOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), device_ordinal_(0) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("feed_id", &feed_id_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("device_ordinal", &device_ordinal_));
+    OP_REQUIRES(ctx, device_ordinal_ >= 0,
+                errors::InvalidArgument("Need device_ordinal >= 0, got ",
+                                        device_ordinal_));
+  }
+
+  ~IPUInfeedStatisticsOp() override {}
+
+  void Compute(OpKernelContext* ctx) override {
+    auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
+    OP_REQUIRES(ctx, platform.ok(), platform.status());
+    auto* p =
+        static_cast<xla::poplarplugin::PoplarPlatform*>(platform.ValueOrDie());
+    auto stream_executor = p->ExecutorForDevice(device_ordinal_).ValueOrDie();
+    auto* poplar_executor = static_cast<xla::poplarplugin::PoplarExecutor*>(
+        stream_executor->implementation());
+
+    auto statistics = poplar_executor->GetInfeedStatistics(feed_id_);
+    OP_REQUIRES_OK(ctx, statistics.status());
+
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output("statistics", TensorShape({}),
+                                             &output_tensor));
+    output_tensor->scalar<string>()() = statistics.ValueOrDie();
+  }
+
+ private:
+  int device_ordinal_;
+  std::string feed_id_;
+  TF_DISALLOW_COPY_AND_ASSIGN(IPUInfeedStatisticsOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("IPUInfeedStatistics").Device(DEVICE_CPU),
+                        IPUInfeedStatisticsOp);
+
 class PopDatastreamOutfeedEnqueueOp : public XlaOpKernel {
  public:
   explicit PopDatastreamOutfeedEnqueueOp(OpKernelConstruction* ctx)
       : XlaOpKernel(ctx) {
     GetFeedConfig(ctx, config_);
     GetOutfeedMode(ctx, config_);
+    GetOutfeedReduction(ctx, config_);
+    GetOutfeedFileSink(ctx, config_);
+    int64 max_io_batch_size;
+    GetAutotuningBound(ctx, "max_io_batch_size", config_.io_batch_size(),
+                       &max_io_batch_size);
+    config_.set_max_io_batch_size(max_io_batch_size);
   }
 
   ~PopDatastreamOutfeedEnqueueOp() override{};
@@ -343,31 +467,24 @@ class PopDatastreamOutfeedDequeueOp : public OpKernel {
     auto outfeed_tensors = poplar_executor->GetTensorsFromOutfeed(
         config_.feed_id(), config_.mode());
     if (config_.mode() == xla::poplarplugin::PoplarFeedConfig::GetAll) {
-      // Allocate all the output buffers with the extra dimension for the number
-      // of executions.
-      std::vector<Tensor*> output_tensors;
-      for (size_t i = 0; i < num_outputs_; ++i) {
-        // Insert an extra dimension to the shape to represent the number of
-        // iterations.
-        TensorShape tensor_shape = tensor_shapes_[i];
-        tensor_shape.InsertDim(0, outfeed_tensors.size());
-        Tensor* output_tensor = nullptr;
-        OP_REQUIRES_OK(ctx,
-                       ctx->allocate_output(i, tensor_shape, &output_tensor));
-        output_tensors.push_back(output_tensor);
-      }
-      // Copy the data into the output tensors.
-      // Go through all the iterations, and copy the tensors into the right
-      // output slices.
-      for (size_t iteration = 0; iteration < outfeed_tensors.size();
-           ++iteration) {
-        auto& tensors_for_iteration = outfeed_tensors[iteration];
-        CHECK_EQ(tensors_for_iteration.size(), num_outputs_);
-        for (size_t j = 0; j < num_outputs_; ++j) {
-          OP_REQUIRES_OK(
-              ctx, batch_util::CopyElementToSlice(
-                       tensors_for_iteration[j], output_tensors[j], iteration));
+      if (outfeed_tensors.empty()) {
+        // The outfeed has not executed yet - return empty outputs.
+        for (size_t i = 0; i < num_outputs_; ++i) {
+          TensorShape tensor_shape = tensor_shapes_[i];
+          tensor_shape.InsertDim(0, 0);
+          Tensor* output_tensor = nullptr;
+          OP_REQUIRES_OK(ctx,
+                         ctx->allocate_output(i, tensor_shape, &output_tensor));
         }
+        return;
+      }
+      // The outfeed returns the tensors already stacked with the extra
+      // dimension for the number of executions, so they can be used as the
+      // outputs without copying.
+      CHECK_EQ(outfeed_tensors.size(), 1);
+      CHECK_EQ(outfeed_tensors[0].size(), num_outputs_);
+      for (size_t j = 0; j < num_outputs_; ++j) {
+        ctx->set_output(j, outfeed_tensors[0][j]);
       }
     } else {
       // Just set the output data if we are getting the last element.
@@ -401,6 +518,46 @@ class PopDatastreamOutfeedDequeueOp : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("PopDatastreamOutfeedDequeue").Device(DEVICE_CPU),
                         PopDatastreamOutfeedDequeueOp);
 
+class IPUOutfeedStatisticsOp : public OpKernel {
+ public:
+  explicit IPUOutfeedStatisticsOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), device_ordinal_(0) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("feed_id", &feed_id_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("device_ordinal", &device_ordinal_));
+    OP_REQUIRES(ctx, device_ordinal_ >= 0,
+                errors::InvalidArgument("Need device_ordinal >= 0, got ",
+                                        device_ordinal_));
+  }
+
+  ~IPUOutfeedStatisticsOp() override {}
+
+  void Compute(OpKernelContext* ctx) override {
+    auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
+    OP_REQUIRES(ctx, platform.ok(), platform.status());
+    auto* p =
+        static_cast<xla::poplarplugin::PoplarPlatform*>(platform.ValueOrDie());
+    auto stream_executor = p->ExecutorForDevice(device_ordinal_).ValueOrDie();
+    auto* poplar_executor = static_cast<xla::poplarplugin::PoplarExecutor*>(
+        stream_executor->implementation());
+
+    auto statistics = poplar_executor->GetOutfeedStatistics(feed_id_);
+    OP_REQUIRES_OK(ctx, statistics.status());
+
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output("statistics", TensorShape({}),
+                                             &output_tensor));
+    output_tensor->scalar<string>()() = statistics.ValueOrDie();
+  }
+
+ private:
+  int device_ordinal_;
+  std::string feed_id_;
+  TF_DISALLOW_COPY_AND_ASSIGN(IPUOutfeedStatisticsOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("IPUOutfeedStatistics").Device(DEVICE_CPU),
+                        IPUOutfeedStatisticsOp);
+
 class IPUDeleteOutfeedOp : public OpKernel {
  public:
   explicit IPUDeleteOutfeedOp(OpKernelConstruction* ctx)
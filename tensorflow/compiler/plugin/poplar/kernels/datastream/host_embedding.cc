@@ -13,12 +13,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <condition_variable>
 #include <mutex>
+#include <numeric>
 
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_executor.h"
 #include "tensorflow/compiler/plugin/poplar/driver/poplar_platform.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/flags.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/mapped_embedding_table.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
 #include "tensorflow/compiler/plugin/poplar/driver/trace.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
@@ -35,7 +40,9 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/batch_util.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
@@ -49,14 +56,56 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 
 #include "absl/container/flat_hash_set.h"
+#include "third_party/eigen3/Eigen/Core"
 
 namespace tensorflow {
 
 namespace {
 
 using PoplarExecutor = xla::poplarplugin::PoplarExecutor;
+using MappedEmbeddingTable = xla::poplarplugin::MappedEmbeddingTable;
 constexpr int max_replication_factor = 16;
 
+int GetNumHostEmbeddingThreads() {
+  const int64 max_threads =
+      xla::poplarplugin::PoplarXlaFlags::Get().max_host_embedding_threads;
+  return max_threads > 0 ? max_threads : port::MaxParallelism();
+}
+
+template <typename T>
+using RowMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+template <typename T>
+using ConstRowMap = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+// Adds the rows of `grads` at the given positions to the row `dst`.
+template <typename T>
+void AccumulateRows(T* dst, const T* grads, const int* positions, int count,
+                    int width, std::vector<float>& scratch) {
+  RowMap<T> row(dst, width);
+  for (int i = 0; i < count; ++i) {
+    row += ConstRowMap<T>(
+        grads + static_cast<std::size_t>(positions[i]) * width, width);
+  }
+}
+
+// For half precision the gradients are accumulated in single precision and
+// the row is only converted back once.
+template <>
+void AccumulateRows<Eigen::half>(Eigen::half* dst, const Eigen::half* grads,
+                                 const int* positions, int count, int width,
+                                 std::vector<float>& scratch) {
+  scratch.resize(width);
+  RowMap<float> acc(scratch.data(), width);
+  RowMap<Eigen::half> row(dst, width);
+  acc = row.template cast<float>();
+  for (int i = 0; i < count; ++i) {
+    acc += ConstRowMap<Eigen::half>(
+               grads + static_cast<std::size_t>(positions[i]) * width, width)
+               .template cast<float>();
+  }
+  row = acc.template cast<Eigen::half>();
+}
+
 template <typename T>
 class HostEmbeddingSGD
     : public xla::poplarplugin::PoplarExecutor::HostEmbeddingInterface<T> {
@@ -65,7 +114,10 @@ class HostEmbeddingSGD
       : encoding_width_(embedding.dim_size(1)),
         embedding_(std::move(embedding)),
         lookup_indices_(max_replication_factor),
-        update_indices_(max_replication_factor) {
+        update_indices_(max_replication_factor),
+        thread_pool_(absl::make_unique<thread::ThreadPool>(
+            Env::Default(), ThreadOptions(), "host_embedding",
+            GetNumHostEmbeddingThreads())) {
     embedding_rows_.reserve(embedding_.dim_size(0));
 
     for (std::size_t i = 0; i < embedding_.dim_size(0); ++i) {
@@ -76,6 +128,23 @@ class HostEmbeddingSGD
     }
   }
 
+  // Uses the rows of a memory mapped table instead of a tensor. The updated
+  // rows are appended to the update log of the table.
+  explicit HostEmbeddingSGD(std::unique_ptr<MappedEmbeddingTable> table)
+      : encoding_width_(table->EncodingWidth()),
+        lookup_indices_(max_replication_factor),
+        update_indices_(max_replication_factor),
+        thread_pool_(absl::make_unique<thread::ThreadPool>(
+            Env::Default(), ThreadOptions(), "host_embedding",
+            GetNumHostEmbeddingThreads())),
+        mapped_table_(std::move(table)) {
+    embedding_rows_.reserve(mapped_table_->NumRows());
+
+    for (int64 i = 0; i < mapped_table_->NumRows(); ++i) {
+      embedding_rows_.push_back(static_cast<T*>(mapped_table_->Row(i)));
+    }
+  }
+
   virtual ~HostEmbeddingSGD() = default;
 
   Status EnqueueLookupIndices(int replica, const int* indices,
@@ -89,11 +158,16 @@ class HostEmbeddingSGD
   }
 
   Status DequeueLookupActivations(int replica, T* destination) final {
-    for (std::size_t i = 0; i < lookup_indices_[replica].size(); ++i) {
-      std::memcpy(destination + i * encoding_width_,
-                  embedding_rows_[lookup_indices_[replica][i]],
-                  encoding_width_ * sizeof(T));
-    }
+    const std::vector<int>& indices = lookup_indices_[replica];
+    const std::size_t row_bytes = encoding_width_ * sizeof(T);
+
+    thread_pool_->ParallelFor(
+        indices.size(), row_bytes, [&](int64 begin, int64 end) {
+          for (int64 i = begin; i < end; ++i) {
+            std::memcpy(destination + i * encoding_width_,
+                        embedding_rows_[indices[i]], row_bytes);
+          }
+        });
 
     return Status::OK();
   }
@@ -109,18 +183,8 @@ class HostEmbeddingSGD
   }
 
   Status EnqueueUpdateGrads(int replica, const T* grads) override {
-    std::size_t index_count = update_indices_[replica].size();
-
-    for (std::size_t i = 0; i < index_count; ++i) {
-      const T* src_ptr = grads + (encoding_width_ * i);
-
-      std::transform(src_ptr, src_ptr + encoding_width_,
-                     embedding_rows_[update_indices_[replica][i]],
-                     embedding_rows_[update_indices_[replica][i]],
-                     std::plus<T>{});
-    }
-
-    return Status::OK();
+    return ApplyUpdates(update_indices_[replica].data(), grads,
+                        update_indices_[replica].size());
   }
 
   xla::StatusOr<void*> GetRow(int index) const final {
@@ -138,12 +202,76 @@ class HostEmbeddingSGD
   Status Notify(int) override { return Status::OK(); }
 
  protected:
+  // Adds the `count` gradient rows to the embedding rows given by `indices`.
+  // The gradients are grouped by row so that repeated rows are updated once
+  // and the rows can be updated in parallel without races.
+  Status ApplyUpdates(const int* indices, const T* grads, std::size_t count) {
+    if (count == 0) {
+      return Status::OK();
+    }
+    BeginUpdate();
+
+    // Sort the positions by row, keeping the original order for repeated rows.
+    std::vector<int> positions(count);
+    std::iota(positions.begin(), positions.end(), 0);
+    std::stable_sort(
+        positions.begin(), positions.end(),
+        [indices](int a, int b) { return indices[a] < indices[b]; });
+
+    // The start of each group of positions with the same row.
+    std::vector<int> group_starts;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (i == 0 || indices[positions[i]] != indices[positions[i - 1]]) {
+        group_starts.push_back(i);
+      }
+    }
+    group_starts.push_back(count);
+
+    const int64 cost = encoding_width_ * sizeof(T) * count /
+                       (group_starts.size() - 1);
+    thread_pool_->ParallelFor(
+        group_starts.size() - 1, cost, [&](int64 begin, int64 end) {
+          std::vector<float> scratch;
+          for (int64 g = begin; g < end; ++g) {
+            const int* group = positions.data() + group_starts[g];
+            UpdateRow(indices[*group], grads, group,
+                      group_starts[g + 1] - group_starts[g], scratch);
+          }
+        });
+
+    if (mapped_table_) {
+      std::vector<int> rows;
+      rows.reserve(group_starts.size() - 1);
+      for (std::size_t g = 0; g + 1 < group_starts.size(); ++g) {
+        rows.push_back(indices[positions[group_starts[g]]]);
+      }
+      return mapped_table_->LogRows(rows.data(), rows.size());
+    }
+
+    return Status::OK();
+  }
+
+  // Called once before the rows of each update are updated.
+  virtual void BeginUpdate() {}
+
+  // Updates the embedding row `row` with the gradient rows of `grads` at the
+  // given positions. Only one thread updates any given row at a time.
+  virtual void UpdateRow(int row, const T* grads, const int* positions,
+                         int count, std::vector<float>& scratch) {
+    AccumulateRows(embedding_rows_[row], grads, positions, count,
+                   encoding_width_, scratch);
+  }
+
   int encoding_width_;
 
   Tensor embedding_;
   std::vector<T*> embedding_rows_;
   std::vector<std::vector<int>> lookup_indices_;
   std::vector<std::vector<int>> update_indices_;
+
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  std::unique_ptr<MappedEmbeddingTable> mapped_table_;
 };
 
 template <typename T>
@@ -152,6 +280,10 @@ class HostEmbeddingSGDAcc : public HostEmbeddingSGD<T> {
   explicit HostEmbeddingSGDAcc(Tensor embedding)
       : HostEmbeddingSGD<T>(embedding), updates_(max_replication_factor) {}
 
+  explicit HostEmbeddingSGDAcc(std::unique_ptr<MappedEmbeddingTable> table)
+      : HostEmbeddingSGD<T>(std::move(table)),
+        updates_(max_replication_factor) {}
+
   virtual ~HostEmbeddingSGDAcc() = default;
 
   Status EnqueueUpdateIndices(int replica, const int* indices,
@@ -173,18 +305,9 @@ class HostEmbeddingSGDAcc : public HostEmbeddingSGD<T> {
   }
 
   Status Notify(int replica) final {
-    std::size_t index_count = update_indices_[replica].size();
-
-    const T* base_ptr = updates_[replica].data();
-    const int* idx_ptr = update_indices_[replica].data();
-
-    for (std::size_t i = 0; i < index_count; ++i) {
-      const T* src_ptr = base_ptr + (encoding_width_ * i);
-      const int* idx = idx_ptr + i;
-
-      std::transform(src_ptr, src_ptr + encoding_width_, embedding_rows_[*idx],
-                     embedding_rows_[*idx], std::plus<T>{});
-    }
+    TF_RETURN_IF_ERROR(this->ApplyUpdates(update_indices_[replica].data(),
+                                          updates_[replica].data(),
+                                          update_indices_[replica].size()));
 
     update_indices_[replica].clear();
     updates_[replica].clear();
@@ -199,6 +322,117 @@ class HostEmbeddingSGDAcc : public HostEmbeddingSGD<T> {
 
   std::vector<std::vector<T>> updates_;
 };
+
+struct HostEmbeddingOptimizerParams {
+  std::string optimizer;
+  float learning_rate;
+  float momentum;
+  bool use_nesterov;
+  float beta1;
+  float beta2;
+  float epsilon;
+};
+
+// Host embedding optimizers which keep per row state in slot tensors of the
+// same shape as the embedding (stored as type S). The gradients sent by the
+// device are not scaled by the learning rate. Only the rows which are
+// updated have their slots updated, the slots of the other rows are left
+// untouched ("lazy" updates).
+template <typename T, typename S>
+class HostEmbeddingSlotOptimizer : public HostEmbeddingSGD<T> {
+ public:
+  HostEmbeddingSlotOptimizer(Tensor embedding, std::vector<Tensor> slots,
+                             const HostEmbeddingOptimizerParams& params)
+      : HostEmbeddingSGD<T>(embedding),
+        slots_(std::move(slots)),
+        params_(params) {
+    for (auto& slot : slots_) {
+      slot_bases_.push_back(slot.flat<S>().data());
+    }
+  }
+
+  virtual ~HostEmbeddingSlotOptimizer() = default;
+
+  // The number of slots required by each optimizer.
+  static int NumSlots(const std::string& optimizer) {
+    return optimizer == "Adam" ? 2 : 1;
+  }
+
+ private:
+  using HostEmbeddingSGD<T>::encoding_width_;
+  using HostEmbeddingSGD<T>::embedding_rows_;
+
+  void BeginUpdate() override {
+    if (params_.optimizer == "Adam") {
+      step_++;
+      adam_learning_rate_ = params_.learning_rate *
+                            std::sqrt(1.0 - std::pow(params_.beta2, step_)) /
+                            (1.0 - std::pow(params_.beta1, step_));
+    }
+  }
+
+  void UpdateRow(int row, const T* grads, const int* positions, int count,
+                 std::vector<float>& scratch) override {
+    const int width = encoding_width_;
+    scratch.resize(3 * width);
+
+    // Combine the gradients for the row in single precision.
+    RowMap<float> grad(scratch.data(), width);
+    grad.setZero();
+    for (int i = 0; i < count; ++i) {
+      grad += ConstRowMap<T>(
+                  grads + static_cast<std::size_t>(positions[i]) * width, width)
+                  .template cast<float>();
+    }
+
+    RowMap<T> var(embedding_rows_[row], width);
+    RowMap<float> new_slot0(scratch.data() + width, width);
+    RowMap<S> slot0(SlotRow(0, row), width);
+
+    if (params_.optimizer == "Adagrad") {
+      new_slot0 = slot0.template cast<float>() + grad.square();
+      slot0 = new_slot0.template cast<S>();
+      var = (var.template cast<float>() -
+             params_.learning_rate * grad / new_slot0.sqrt())
+                .template cast<T>();
+    } else if (params_.optimizer == "Momentum") {
+      new_slot0 = slot0.template cast<float>() * params_.momentum + grad;
+      slot0 = new_slot0.template cast<S>();
+      if (params_.use_nesterov) {
+        var = (var.template cast<float>() -
+               params_.learning_rate * (grad + params_.momentum * new_slot0))
+                  .template cast<T>();
+      } else {
+        var = (var.template cast<float>() - params_.learning_rate * new_slot0)
+                  .template cast<T>();
+      }
+    } else {
+      RowMap<float> new_slot1(scratch.data() + 2 * width, width);
+      RowMap<S> slot1(SlotRow(1, row), width);
+      new_slot0 = params_.beta1 * slot0.template cast<float>() +
+                  (1.0f - params_.beta1) * grad;
+      new_slot1 = params_.beta2 * slot1.template cast<float>() +
+                  (1.0f - params_.beta2) * grad.square();
+      slot0 = new_slot0.template cast<S>();
+      slot1 = new_slot1.template cast<S>();
+      var = (var.template cast<float>() -
+             adam_learning_rate_ * new_slot0 /
+                 (new_slot1.sqrt() + params_.epsilon))
+                .template cast<T>();
+    }
+  }
+
+  S* SlotRow(int slot, int row) {
+    return slot_bases_[slot] + static_cast<std::size_t>(row) * encoding_width_;
+  }
+
+  std::vector<Tensor> slots_;
+  std::vector<S*> slot_bases_;
+  const HostEmbeddingOptimizerParams params_;
+
+  int64 step_ = 0;
+  float adam_learning_rate_ = 0.0f;
+};
 }  // namespace
 
 template <typename T>
@@ -215,7 +449,8 @@ class IpuHostEmbeddingRegisterOp : public OpKernel {
     context->forward_ref_input_to_ref_output(0, 0);
 
     // If we are using synthetic data, immediately complete the op.
-    if (!xla::poplarplugin::UseSyntheticData()) {
+    if (!xla::poplarplugin::UseSyntheticDataFor(
+            xla::poplarplugin::SyntheticDataCategory::HostEmbedding)) {
       auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
       OP_REQUIRES(context, platform.ok(), platform.status());
       auto* p = static_cast<xla::poplarplugin::PoplarPlatform*>(
@@ -259,18 +494,187 @@ TF_CALL_float(REGISTER_HOST_EMBEDDING_REGISTER_KERNEL);
 TF_CALL_int32(REGISTER_HOST_EMBEDDING_REGISTER_KERNEL);
 TF_CALL_uint32(REGISTER_HOST_EMBEDDING_REGISTER_KERNEL);
 
-class IpuHostEmbeddingDeregisterOp : public OpKernel {
+template <typename T, typename S>
+class IpuHostEmbeddingRegisterWithSlotsOp : public OpKernel {
  public:
-  explicit IpuHostEmbeddingDeregisterOp(OpKernelConstruction* ctx)
+  explicit IpuHostEmbeddingRegisterWithSlotsOp(OpKernelConstruction* ctx)
       : OpKernel(ctx), device_ordinal_(0) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("device_ordinal", &device_ordinal_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("embedding_id", &embedding_id_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("optimizer", &params_.optimizer));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("learning_rate", &params_.learning_rate));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("momentum", &params_.momentum));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &params_.use_nesterov));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("beta1", &params_.beta1));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("beta2", &params_.beta2));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("epsilon", &params_.epsilon));
   }
 
   void Compute(OpKernelContext* context) override {
     context->forward_ref_input_to_ref_output(0, 0);
 
-    if (!xla::poplarplugin::UseSyntheticData()) {
+    // If we are using synthetic data, immediately complete the op.
+    if (!xla::poplarplugin::UseSyntheticDataFor(
+            xla::poplarplugin::SyntheticDataCategory::HostEmbedding)) {
+      auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
+      OP_REQUIRES(context, platform.ok(), platform.status());
+      auto* p = static_cast<xla::poplarplugin::PoplarPlatform*>(
+          platform.ValueOrDie());
+      auto stream_executor = p->ExecutorForDevice(device_ordinal_).ValueOrDie();
+      auto* poplar_executor = static_cast<xla::poplarplugin::PoplarExecutor*>(
+          stream_executor->implementation());
+
+      Tensor inp = context->mutable_input(0, true);
+
+      OpMutableInputList slot_list;
+      OP_REQUIRES_OK(context, context->mutable_input_list("slots", &slot_list));
+      const int num_slots =
+          HostEmbeddingSlotOptimizer<T, S>::NumSlots(params_.optimizer);
+      OP_REQUIRES(context, slot_list.size() == num_slots,
+                  errors::InvalidArgument(
+                      "The ", params_.optimizer, " host embedding optimizer "
+                      "requires ", num_slots, " slots, but ", slot_list.size(),
+                      " were provided."));
+
+      std::vector<Tensor> slots;
+      for (int i = 0; i < slot_list.size(); ++i) {
+        Tensor slot = slot_list.at(i, true);
+        OP_REQUIRES(context, slot.shape() == inp.shape(),
+                    errors::InvalidArgument(
+                        "Host embedding slot ", i, " has shape ",
+                        slot.shape().DebugString(), " but the embedding has ",
+                        "shape ", inp.shape().DebugString(), "."));
+        slots.push_back(slot);
+      }
+
+      auto embedding_interface =
+          absl::make_unique<HostEmbeddingSlotOptimizer<T, S>>(
+              inp, std::move(slots), params_);
+
+      Status status = poplar_executor->RegisterHostEmbedding(
+          embedding_id_, std::move(embedding_interface));
+      OP_REQUIRES(context, status.ok(), status);
+    }
+  }
+
+ private:
+  int device_ordinal_;
+  std::string embedding_id_;
+  HostEmbeddingOptimizerParams params_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IpuHostEmbeddingRegisterWithSlotsOp);
+};
+
+#define REGISTER_HOST_EMBEDDING_REGISTER_WITH_SLOTS_KERNEL(T, S)     \
+  REGISTER_KERNEL_BUILDER(Name("IpuHostEmbeddingRegisterWithSlots") \
+                              .Device(DEVICE_CPU)                   \
+                              .TypeConstraint<T>("T")               \
+                              .TypeConstraint<S>("S"),              \
+                          IpuHostEmbeddingRegisterWithSlotsOp<T, S>);
+
+REGISTER_HOST_EMBEDDING_REGISTER_WITH_SLOTS_KERNEL(Eigen::half, Eigen::half);
+REGISTER_HOST_EMBEDDING_REGISTER_WITH_SLOTS_KERNEL(Eigen::half, float);
+REGISTER_HOST_EMBEDDING_REGISTER_WITH_SLOTS_KERNEL(float, Eigen::half);
+REGISTER_HOST_EMBEDDING_REGISTER_WITH_SLOTS_KERNEL(float, float);
+
+template <typename T>
+class IpuHostEmbeddingRegisterMappedOp : public OpKernel {
+ public:
+  explicit IpuHostEmbeddingRegisterMappedOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), device_ordinal_(0) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("device_ordinal", &device_ordinal_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("embedding_id", &embedding_id_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("optimizer", &optimizer_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("path", &path_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("update_log_path", &update_log_path_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("embedding_shape", &embedding_shape_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // If we are using synthetic data, immediately complete the op.
+    if (!xla::poplarplugin::UseSyntheticDataFor(
+            xla::poplarplugin::SyntheticDataCategory::HostEmbedding)) {
+      auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
+      OP_REQUIRES(context, platform.ok(), platform.status());
+      auto* p = static_cast<xla::poplarplugin::PoplarPlatform*>(
+          platform.ValueOrDie());
+      auto stream_executor = p->ExecutorForDevice(device_ordinal_).ValueOrDie();
+      auto* poplar_executor = static_cast<xla::poplarplugin::PoplarExecutor*>(
+          stream_executor->implementation());
+
+      auto table_or = MappedEmbeddingTable::Open(path_, update_log_path_);
+      OP_REQUIRES(context, table_or.ok(), table_or.status());
+      std::unique_ptr<MappedEmbeddingTable> table =
+          table_or.ConsumeValueOrDie();
+
+      const TensorShape table_shape(
+          {table->NumRows(), table->EncodingWidth()});
+      OP_REQUIRES(
+          context,
+          table->dtype() == DataTypeToEnum<T>::v() &&
+              table_shape == embedding_shape_,
+          errors::InvalidArgument(
+              "Host embedding table ", path_, " is a ",
+              table_shape.DebugString(), " ", DataTypeString(table->dtype()),
+              " table, but a ", embedding_shape_.DebugString(), " ",
+              DataTypeString(DataTypeToEnum<T>::v()), " table was expected."));
+      VLOG(1) << "Mapped host embedding " << embedding_id_ << " from " << path_
+              << ", replayed " << table->NumReplayedRecords()
+              << " logged updates.";
+
+      std::unique_ptr<PoplarExecutor::HostEmbeddingInterface<T>>
+          embedding_interface;
+      if (optimizer_ == "SGD") {
+        embedding_interface =
+            absl::make_unique<HostEmbeddingSGD<T>>(std::move(table));
+      } else if (optimizer_ == "SGD+GA") {
+        embedding_interface =
+            absl::make_unique<HostEmbeddingSGDAcc<T>>(std::move(table));
+      }
+
+      Status status = poplar_executor->RegisterHostEmbedding(
+          embedding_id_, std::move(embedding_interface));
+      OP_REQUIRES(context, status.ok(), status);
+    }
+  }
+
+ private:
+  int device_ordinal_;
+  std::string embedding_id_;
+  std::string optimizer_;
+  std::string path_;
+  std::string update_log_path_;
+  TensorShape embedding_shape_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IpuHostEmbeddingRegisterMappedOp);
+};
+
+#define REGISTER_HOST_EMBEDDING_REGISTER_MAPPED_KERNEL(T)        \
+  REGISTER_KERNEL_BUILDER(Name("IpuHostEmbeddingRegisterMapped") \
+                              .Device(DEVICE_CPU)                \
+                              .TypeConstraint<T>("T"),           \
+                          IpuHostEmbeddingRegisterMappedOp<T>);
+
+TF_CALL_half(REGISTER_HOST_EMBEDDING_REGISTER_MAPPED_KERNEL);
+TF_CALL_float(REGISTER_HOST_EMBEDDING_REGISTER_MAPPED_KERNEL);
+TF_CALL_int32(REGISTER_HOST_EMBEDDING_REGISTER_MAPPED_KERNEL);
+TF_CALL_uint32(REGISTER_HOST_EMBEDDING_REGISTER_MAPPED_KERNEL);
+
+class IpuHostEmbeddingDeregisterOp : public OpKernel {
+ public:
+  explicit IpuHostEmbeddingDeregisterOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), device_ordinal_(0), forward_ref_(ctx->num_inputs() > 0) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("device_ordinal", &device_ordinal_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("embedding_id", &embedding_id_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    if (forward_ref_) {
+      context->forward_ref_input_to_ref_output(0, 0);
+    }
+
+    if (!xla::poplarplugin::UseSyntheticDataFor(
+            xla::poplarplugin::SyntheticDataCategory::HostEmbedding)) {
       auto platform = se::MultiPlatformManager::PlatformWithName("Poplar");
       OP_REQUIRES(context, platform.ok(), platform.status());
       auto* p = static_cast<xla::poplarplugin::PoplarPlatform*>(
@@ -287,12 +691,17 @@ class IpuHostEmbeddingDeregisterOp : public OpKernel {
  private:
   int device_ordinal_;
   std::string embedding_id_;
+  // Mapped embeddings have no tensor to forward.
+  bool forward_ref_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(IpuHostEmbeddingDeregisterOp);
 };
 
 REGISTER_KERNEL_BUILDER(Name("IpuHostEmbeddingDeregister").Device(DEVICE_CPU),
                         IpuHostEmbeddingDeregisterOp);
+REGISTER_KERNEL_BUILDER(
+    Name("IpuHostEmbeddingDeregisterMapped").Device(DEVICE_CPU),
+    IpuHostEmbeddingDeregisterOp);
 
 template <int IndicesPosition>
 class IpuDeviceEmbeddingLookupOp : public XlaOpKernel, IpuOpKernel {
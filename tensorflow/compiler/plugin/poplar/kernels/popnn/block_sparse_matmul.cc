@@ -0,0 +1,166 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/poplar_platform.h"
+#include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/ipu_kernels_common.h"
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/type_util.h"
+#include "tensorflow/compiler/tf2xla/xla_helpers.h"
+#include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+using namespace xla::poplarplugin;
+
+namespace tensorflow {
+namespace {
+// The attributes of a block-sparse matmul of a dense [M, K] left hand side by
+// the non-zero blocks of a [K, N] right hand side.
+class BlockSparseAttributes {
+ public:
+  explicit BlockSparseAttributes(OpKernelConstruction* ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("block_size", &block_size_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparsity_shape", &sparsity_shape_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparsity", &sparsity_));
+    OP_REQUIRES(ctx, block_size_.size() == 3,
+                errors::InvalidArgument(
+                    "The block size must be the {M, K, N} block dimensions."));
+    OP_REQUIRES(ctx, sparsity_shape_.size() == 2,
+                errors::InvalidArgument(
+                    "The sparsity shape must be the number of {K, N} blocks."));
+    OP_REQUIRES(ctx,
+                sparsity_.size() == sparsity_shape_[0] * sparsity_shape_[1],
+                errors::InvalidArgument(
+                    "The sparsity must have one element per block, got ",
+                    sparsity_.size(), " for ", sparsity_shape_[0], "x",
+                    sparsity_shape_[1], " blocks."));
+    for (int64 block : sparsity_) {
+      num_non_zero_blocks_ += block != 0;
+    }
+  }
+
+  // Checks the shapes of the left hand side and of the non-zero blocks.
+  Status CheckShapes(const TensorShape& lhs, const TensorShape& rhs) const {
+    if (lhs.dims() != 2 || lhs.dim_size(0) % block_size_[0] != 0 ||
+        lhs.dim_size(1) != sparsity_shape_[0] * block_size_[1]) {
+      return errors::InvalidArgument(
+          "The left hand side ", lhs.DebugString(),
+          " must have a multiple of ", block_size_[0], " rows and ",
+          sparsity_shape_[0] * block_size_[1], " columns.");
+    }
+    if (rhs.dims() != 2 || rhs.dim_size(0) != num_non_zero_blocks_ ||
+        rhs.dim_size(1) != block_size_[1] * block_size_[2]) {
+      return errors::InvalidArgument(
+          "The right hand side ", rhs.DebugString(), " must have ",
+          num_non_zero_blocks_, " blocks of ",
+          block_size_[1] * block_size_[2], " elements.");
+    }
+    return Status::OK();
+  }
+
+  void AddTo(IPUCustomKernelsUtil::AttributeMap& attribute_map) const {
+    attribute_map.AddAttribute("block_size", block_size_);
+    attribute_map.AddAttribute("sparsity_shape", sparsity_shape_);
+    attribute_map.AddAttribute("sparsity", sparsity_);
+  }
+
+  int64 NumColumns() const { return sparsity_shape_[1] * block_size_[2]; }
+
+ private:
+  std::vector<int64> block_size_;
+  std::vector<int64> sparsity_shape_;
+  std::vector<int64> sparsity_;
+  int64 num_non_zero_blocks_ = 0;
+};
+}  // namespace
+
+class BlockSparseMatMulOp : public XlaOpKernel, IpuOpKernel {
+ public:
+  explicit BlockSparseMatMulOp(OpKernelConstruction* ctx)
+      : XlaOpKernel(ctx), IpuOpKernel(), attributes_(ctx) {
+    attributes_.AddTo(attribute_map_);
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    const TensorShape lhs_shape = ctx->InputShape(0);
+    OP_REQUIRES_OK(ctx, attributes_.CheckShapes(lhs_shape, ctx->InputShape(1)));
+
+    xla::Shape xla_shape;
+    OP_REQUIRES_OK(
+        ctx, TensorShapeToXLAShape(
+                 input_type(0),
+                 TensorShape({lhs_shape.dim_size(0), attributes_.NumColumns()}),
+                 &xla_shape));
+
+    xla::XlaOp output = xla::CustomCall(
+        ctx->builder(), PoplarOp_Name(PoplarOp::BlockSparseMatMul),
+        {ctx->Input(0), ctx->Input(1)}, xla_shape, attribute_map_.Serialise());
+
+    ctx->SetOutput(0, output);
+  }
+
+ private:
+  const BlockSparseAttributes attributes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockSparseMatMulOp);
+};
+REGISTER_IPU_OP("IpuBlockSparseMatMul", BlockSparseMatMulOp);
+
+class BlockSparseMatMulGradOp : public XlaOpKernel, IpuOpKernel {
+ public:
+  explicit BlockSparseMatMulGradOp(OpKernelConstruction* ctx)
+      : XlaOpKernel(ctx), IpuOpKernel(), attributes_(ctx) {
+    attributes_.AddTo(attribute_map_);
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, attributes_.CheckShapes(ctx->InputShape(0),
+                                                ctx->InputShape(1)));
+
+    // The gradients have the shapes of the left and right hand sides.
+    const DataType dtype = input_type(0);
+    std::vector<xla::Shape> xla_shapes(2);
+    for (int i = 0; i != 2; ++i) {
+      OP_REQUIRES_OK(ctx, TensorShapeToXLAShape(dtype, ctx->InputShape(i),
+                                                &xla_shapes[i]));
+    }
+
+    xla::XlaOp output_tuple = xla::CustomCall(
+        ctx->builder(), PoplarOp_Name(PoplarOp::BlockSparseMatMulGrad),
+        {ctx->Input(0), ctx->Input(1), ctx->Input(2)},
+        xla::ShapeUtil::MakeTupleShape(xla_shapes),
+        attribute_map_.Serialise());
+
+    for (int i = 0; i != 2; ++i) {
+      ctx->SetOutput(i, xla::GetTupleElement(output_tuple, i));
+    }
+  }
+
+ private:
+  const BlockSparseAttributes attributes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockSparseMatMulGradOp);
+};
+REGISTER_IPU_OP("IpuBlockSparseMatMulGrad", BlockSparseMatMulGradOp);
+
+}  // namespace tensorflow
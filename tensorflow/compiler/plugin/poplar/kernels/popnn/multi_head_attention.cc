@@ -0,0 +1,144 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/poplar_platform.h"
+#include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/custom_kernels_util.h"
+#include "tensorflow/compiler/plugin/poplar/kernels/ipu_kernels_common.h"
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/tf2xla/type_util.h"
+#include "tensorflow/compiler/tf2xla/xla_helpers.h"
+#include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+using namespace xla::poplarplugin;
+
+namespace tensorflow {
+namespace {
+// Checks that the queries, keys and values are shaped
+// [batch, num_heads, sequence, head_size] with consistent dimensions.
+Status CheckAttentionShapes(const TensorShape& query, const TensorShape& key,
+                            const TensorShape& value) {
+  if (query.dims() != 4 || key.dims() != 4 || value.dims() != 4) {
+    return errors::InvalidArgument(
+        "The query, key and value must have rank 4, got ", query.DebugString(),
+        ", ", key.DebugString(), " and ", value.DebugString(), ".");
+  }
+  for (int64 dim = 0; dim != 2; ++dim) {
+    if (query.dim_size(dim) != key.dim_size(dim) ||
+        query.dim_size(dim) != value.dim_size(dim)) {
+      return errors::InvalidArgument(
+          "The query, key and value must have the same batch size and number "
+          "of heads, got ",
+          query.DebugString(), ", ", key.DebugString(), " and ",
+          value.DebugString(), ".");
+    }
+  }
+  if (query.dim_size(3) != key.dim_size(3)) {
+    return errors::InvalidArgument(
+        "The query and key must have the same head size, got ",
+        query.DebugString(), " and ", key.DebugString(), ".");
+  }
+  if (key.dim_size(2) != value.dim_size(2)) {
+    return errors::InvalidArgument(
+        "The key and value must have the same sequence length, got ",
+        key.DebugString(), " and ", value.DebugString(), ".");
+  }
+  return Status::OK();
+}
+}  // namespace
+
+class MultiHeadAttentionOp : public XlaOpKernel, IpuOpKernel {
+ public:
+  explicit MultiHeadAttentionOp(OpKernelConstruction* ctx)
+      : XlaOpKernel(ctx), IpuOpKernel() {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("causal", &causal_));
+    attribute_map_.AddAttribute("causal", causal_);
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    const TensorShape query_shape = ctx->InputShape(0);
+    const TensorShape key_shape = ctx->InputShape(1);
+    const TensorShape value_shape = ctx->InputShape(2);
+    OP_REQUIRES_OK(ctx,
+                   CheckAttentionShapes(query_shape, key_shape, value_shape));
+
+    TensorShape output_shape = query_shape;
+    output_shape.set_dim(3, value_shape.dim_size(3));
+
+    xla::Shape xla_shape;
+    OP_REQUIRES_OK(
+        ctx, TensorShapeToXLAShape(input_type(0), output_shape, &xla_shape));
+
+    xla::XlaOp output = xla::CustomCall(
+        ctx->builder(), PoplarOp_Name(PoplarOp::MultiHeadAttention),
+        {ctx->Input(0), ctx->Input(1), ctx->Input(2)}, xla_shape,
+        attribute_map_.Serialise());
+
+    ctx->SetOutput(0, output);
+  }
+
+ private:
+  bool causal_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MultiHeadAttentionOp);
+};
+REGISTER_IPU_OP("IpuMultiHeadAttention", MultiHeadAttentionOp);
+
+class MultiHeadAttentionGradOp : public XlaOpKernel, IpuOpKernel {
+ public:
+  explicit MultiHeadAttentionGradOp(OpKernelConstruction* ctx)
+      : XlaOpKernel(ctx), IpuOpKernel() {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("causal", &causal_));
+    attribute_map_.AddAttribute("causal", causal_);
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    OP_REQUIRES_OK(ctx, CheckAttentionShapes(ctx->InputShape(0),
+                                             ctx->InputShape(1),
+                                             ctx->InputShape(2)));
+
+    // The gradients have the shapes of the query, key and value.
+    const DataType dtype = input_type(0);
+    std::vector<xla::Shape> xla_shapes(3);
+    for (int i = 0; i != 3; ++i) {
+      OP_REQUIRES_OK(ctx, TensorShapeToXLAShape(dtype, ctx->InputShape(i),
+                                                &xla_shapes[i]));
+    }
+
+    xla::XlaOp output_tuple = xla::CustomCall(
+        ctx->builder(), PoplarOp_Name(PoplarOp::MultiHeadAttentionGrad),
+        {ctx->Input(0), ctx->Input(1), ctx->Input(2), ctx->Input(3)},
+        xla::ShapeUtil::MakeTupleShape(xla_shapes),
+        attribute_map_.Serialise());
+
+    for (int i = 0; i != 3; ++i) {
+      ctx->SetOutput(i, xla::GetTupleElement(output_tuple, i));
+    }
+  }
+
+ private:
+  bool causal_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MultiHeadAttentionGradOp);
+};
+REGISTER_IPU_OP("IpuMultiHeadAttentionGrad", MultiHeadAttentionGradOp);
+
+}  // namespace tensorflow
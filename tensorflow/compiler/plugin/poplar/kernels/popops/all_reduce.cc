@@ -16,7 +16,10 @@ limitations under the License.
 #include "tensorflow/compiler/plugin/poplar/driver/xla_ipu_common.h"
 #include "tensorflow/compiler/plugin/poplar/kernels/ipu_kernels_common.h"
 
+#include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
+#include "tensorflow/compiler/xla/client/lib/arithmetic.h"
+#include "tensorflow/compiler/xla/client/lib/constants.h"
 
 namespace tensorflow {
 
@@ -35,4 +38,76 @@ class PopopsCrossReplicaSumOp : public XlaOpKernel {
 REGISTER_XLA_OP(Name("IpuCrossReplicaSum").Device(DEVICE_IPU_XLA_JIT),
                 PopopsCrossReplicaSumOp);
 
+class PopopsCompressedCrossReplicaSumOp : public XlaOpKernel {
+ public:
+  explicit PopopsCompressedCrossReplicaSumOp(OpKernelConstruction* ctx)
+      : XlaOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dtype", &dtype_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    OP_REQUIRES(ctx, !(compression_ == "fp16" && dtype_ == DT_HALF),
+                errors::InvalidArgument(
+                    "A float16 tensor cannot be compressed to fp16."));
+  }
+
+  void Compile(XlaOpKernelContext* ctx) override {
+    xla::XlaBuilder* b = ctx->builder();
+
+    xla::XlaOp residual;
+    TensorShape residual_shape;
+    OP_REQUIRES_OK(
+        ctx, ctx->ReadVariableInput(0, dtype_, &residual_shape, &residual));
+    OP_REQUIRES(ctx, residual_shape == ctx->InputShape(1),
+                errors::InvalidArgument(
+                    "The residual and the input do not have the same shape ",
+                    residual_shape.DebugString(), " ",
+                    ctx->InputShape(1).DebugString()));
+
+    xla::PrimitiveType type;
+    OP_REQUIRES_OK(ctx, DataTypeToPrimitiveType(dtype_, &type));
+
+    // Add the compression error of the previous step before compressing, so
+    // that the error does not accumulate over the steps.
+    xla::XlaOp input = xla::Add(ctx->Input(1), residual);
+    xla::XlaOp sum;
+    xla::XlaOp local;
+    if (compression_ == "fp16") {
+      xla::XlaOp compressed = xla::ConvertElementType(input, xla::F16);
+      sum = xla::ConvertElementType(xla::CrossReplicaSum(compressed), type);
+      local = xla::ConvertElementType(compressed, type);
+    } else {
+      // The sum of the largest magnitudes of all the replicas bounds every
+      // element of the sum, so scaling by it means the int8 sum cannot
+      // overflow. Converting rounds towards zero, which keeps the quantized
+      // values within the bound.
+      xla::XlaOp max_abs = xla::ReduceAll(
+          xla::Abs(input), xla::Zero(b, type),
+          xla::CreateScalarMaxComputation(type, b));
+      xla::XlaOp bound = xla::CrossReplicaSum(max_abs);
+      xla::XlaOp scale = xla::Select(
+          xla::Gt(bound, xla::Zero(b, type)),
+          xla::Div(xla::ScalarLike(bound, 127), bound), xla::One(b, type));
+      xla::XlaOp compressed =
+          xla::ConvertElementType(xla::Mul(input, scale), xla::S8);
+      sum = xla::Div(
+          xla::ConvertElementType(xla::CrossReplicaSum(compressed), type),
+          scale);
+      local = xla::Div(xla::ConvertElementType(compressed, type), scale);
+    }
+
+    ctx->SetOutput(0, sum);
+    OP_REQUIRES_OK(ctx,
+                   ctx->AssignVariable(0, dtype_, xla::Sub(input, local)));
+  }
+
+ private:
+  DataType dtype_;
+  std::string compression_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PopopsCompressedCrossReplicaSumOp);
+};
+
+REGISTER_XLA_OP(
+    Name("IpuCompressedCrossReplicaSum").Device(DEVICE_IPU_XLA_JIT),
+    PopopsCompressedCrossReplicaSumOp);
+
 }  // namespace tensorflow
@@ -32,4 +32,64 @@ REGISTER_OP("BufferDataset")
       return shape_inference::ScalarShape(c);
     });
 
+REGISTER_OP("IPUMappedCacheDataset")
+    .Input("input_dataset: variant")
+    .Input("filename: string")
+    .Output("handle: variant")
+    .Attr("shuffle: bool = false")
+    .Attr("seed: int = 0")
+    .Attr("seed2: int = 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // filename should be a scalar.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    });
+
+REGISTER_OP("IPURequestBatchDataset")
+    .Output("handle: variant")
+    .Attr("batcher_name: string")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_OP("IPUSequencePackingDataset")
+    .Input("input_dataset: variant")
+    .Input("max_sequence_length: int64")
+    .Input("max_sequences_per_pack: int64")
+    .Input("window_size: int64")
+    .Output("handle: variant")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // max_sequence_length, max_sequences_per_pack and window_size should be
+      // scalars.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    });
+
+REGISTER_OP("IPUSharedMemoryDataset")
+    .Output("handle: variant")
+    .Attr("ring_buffer_names: list(string) >= 1")
+    .Attr("startup_timeout_seconds: float = 600")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_OP("IPUSharedMemoryDatasetWriter")
+    .Input("input_dataset: variant")
+    .Attr("ring_buffer_name: string")
+    .Attr("num_slots: int >= 1")
+    .Attr("slot_size: int >= 1")
+    .Attr("consumer_pid: int")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
 }  // namespace tensorflow
@@ -28,6 +28,7 @@ REGISTER_OP("PopDatastreamInfeedDequeue")
     .Attr("output_shapes: list(shape) >= 1")
     .Attr("io_batch_size: int = 1")
     .Attr("prefetch_depth: int = 1")
+    .Attr("max_prefetch_depth: int = 0")
     .SetIsStateful()
     .SetShapeFn(shape_inference::poplarplugin::ShapeFromOutputShapeAttribute)
     .Doc(R"doc(
@@ -51,6 +52,8 @@ prefetch_depth: the number of elements poplar will prefetch.
   of multiple entries, increasing the probability there will be a valid
   entry in the buffer for the device to read before falling back to
   synchronously fetching the next entry.
+max_prefetch_depth: when larger than zero the prefetch depth is autotuned from
+  the time the device waits for the infeed, up to this value.
 )doc");
 
 REGISTER_OP("IPUCreateDatasetIterator")
@@ -71,6 +74,21 @@ REGISTER_OP("IPUDeleteDatasetIterator")
     .SetIsStateful()
     .SetShapeFn(shape_inference::NoOutputs);
 
+REGISTER_OP("IPUInfeedStatistics")
+    .Output("statistics: string")
+    .Attr("device_ordinal: int = 0")
+    .Attr("feed_id: string")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Returns the statistics of an infeed as a JSON string.
+
+statistics: For each stage of the infeed - the dataset iterator, the infeed
+  queues, the stream callbacks and the host to device transfers - the number of
+  elements processed, the time taken and the achieved rate.
+feed_id: The id of the iterator used by the infeed.
+)doc");
+
 REGISTER_OP("PopDatastreamOutfeedEnqueue")
     .Input("inputs: output_types")
     .Attr("output_types: list(type) >= 1")
@@ -80,6 +98,12 @@ REGISTER_OP("PopDatastreamOutfeedEnqueue")
     .Attr("replication_factor: int")
     .Attr("io_batch_size: int")
     .Attr("prefetch_depth: int = 1")
+    .Attr("reduction: string='none'")
+    .Attr("transfer_as_fp16: bool = false")
+    .Attr("max_io_batch_size: int = 0")
+    .Attr("file_sink_prefix: string = ''")
+    .Attr("file_sink_format: string = 'tfrecord'")
+    .Attr("file_sink_elements_per_file: int = 0")
     .SetIsStateful()
     .SetShapeFn(shape_inference::NoOutputs)
     .Doc(R"doc(
@@ -96,6 +120,37 @@ replication_factor: the number of replica graphs that this operation will
 io_batch_size: the number of tensors which should be fetched from the host
   in one go.  This reduces the host->device IO, at the cost of memory on the
   device.
+reduction: 'none', 'sum', 'mean' or 'max', default is 'none'. When not 'none'
+  the `io_batch_size` values of each batch are reduced on the device and a
+  single value is sent to the host.
+transfer_as_fp16: whether float32 values are sent to the host as float16
+  values. They are converted back to float32 on the host.
+max_io_batch_size: when larger than zero the io batch size is autotuned from
+  the time the device waits for the host to read the outfeed, up to this value.
+  Outfeeds with a reduction are not autotuned.
+file_sink_prefix: when not empty, the elements are written to files with this
+  prefix on the host instead of being dequeued. Only supported with the 'all'
+  outfeed_mode.
+file_sink_format: 'tfrecord' or 'raw', the format of the files. In 'tfrecord'
+  format each tensor of an element is a serialized TensorProto record, in
+  'raw' format the bytes of the tensors are concatenated.
+file_sink_elements_per_file: the number of elements in each file, or 0 to
+  write a single file.
+)doc");
+
+REGISTER_OP("IPUOutfeedStatistics")
+    .Output("statistics: string")
+    .Attr("device_ordinal: int = 0")
+    .Attr("feed_id: string")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Returns the counters of the queues of an outfeed as a JSON string.
+
+statistics: The number of elements pushed to and popped from the queues, the
+  time spent blocked on full and empty queues, and the largest number of
+  elements in the queues.
+feed_id: The id of the outfeed.
 )doc");
 
 REGISTER_OP("PopDatastreamOutfeedDequeue")
@@ -39,6 +39,51 @@ REGISTER_OP("IpuHostEmbeddingRegister")
       return shape_inference::UnchangedShape(c);
     });
 
+REGISTER_OP("IpuHostEmbeddingRegisterWithSlots")
+    .Input("ref: Ref(T)")
+    .Input("slots: Ref(N * S)")
+    .Output("output_ref: Ref(T)")
+    .Attr("device_ordinal: int = 0")
+    .Attr("embedding_id: string")
+    .Attr("optimizer: {'Adagrad', 'Adam', 'Momentum'}")
+    .Attr("learning_rate: float")
+    .Attr("momentum: float = 0.0")
+    .Attr("use_nesterov: bool = false")
+    .Attr("beta1: float = 0.9")
+    .Attr("beta2: float = 0.999")
+    .Attr("epsilon: float = 1e-8")
+    .Attr("T: {half, float}")
+    .Attr("S: {half, float}")
+    .Attr("N: int >= 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle embedding_shape = c->input(0);
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->WithRank(embedding_shape, 2, &out));
+      for (int i = 1; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(c->Merge(embedding_shape, c->input(i), &out));
+      }
+
+      return shape_inference::UnchangedShape(c);
+    });
+
+REGISTER_OP("IpuHostEmbeddingRegisterMapped")
+    .Attr("device_ordinal: int = 0")
+    .Attr("embedding_id: string")
+    .Attr("optimizer: {'SGD', 'SGD+GA'} = 'SGD'")
+    .Attr("path: string")
+    .Attr("update_log_path: string = ''")
+    .Attr("embedding_shape: shape")
+    .Attr("T: {half, float, int32, uint32}")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
+REGISTER_OP("IpuHostEmbeddingDeregisterMapped")
+    .Attr("device_ordinal: int = 0")
+    .Attr("embedding_id: string")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
 REGISTER_OP("IpuHostEmbeddingDeregister")
     .Input("ref: Ref(T)")
     .Output("output_ref: Ref(T)")
@@ -94,7 +139,7 @@ REGISTER_OP("IpuDeviceEmbeddingLookupTrainable")
     .Attr("partition_strategy: {'ENCODING', 'TOKEN'} = 'ENCODING'")
     .Attr("dtype: type")
     .Attr("T: {int32}")
-    .Attr("optimizer: {'SGD', 'SGD+GA'}")
+    .Attr("optimizer: {'SGD', 'SGD+GA', 'Adagrad', 'Adam', 'Momentum'}")
     .Attr("learning_rate: float")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
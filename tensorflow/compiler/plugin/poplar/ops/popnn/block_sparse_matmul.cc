@@ -0,0 +1,71 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+
+REGISTER_OP("IpuBlockSparseMatMul")
+    .Input("lhs: dtype")
+    .Input("rhs: dtype")
+    .Output("output: dtype")
+    .Attr("block_size: list(int)")
+    .Attr("sparsity_shape: list(int)")
+    .Attr("sparsity: list(int)")
+    .Attr("dtype: {float16, float32}")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle lhs, rhs;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &lhs));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &rhs));
+      std::vector<int64> block_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("block_size", &block_size));
+      std::vector<int64> sparsity_shape;
+      TF_RETURN_IF_ERROR(c->GetAttr("sparsity_shape", &sparsity_shape));
+      if (block_size.size() != 3 || sparsity_shape.size() != 2) {
+        return errors::InvalidArgument(
+            "The block size must have 3 elements and the sparsity shape 2.");
+      }
+      c->set_output(0, c->Matrix(c->Dim(lhs, 0),
+                                 sparsity_shape[1] * block_size[2]));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Internal implementation of BlockSparseMatMul.
+)doc");
+
+REGISTER_OP("IpuBlockSparseMatMulGrad")
+    .Input("lhs: dtype")
+    .Input("rhs: dtype")
+    .Input("gradients: dtype")
+    .Output("lhs_backprop: dtype")
+    .Output("rhs_backprop: dtype")
+    .Attr("block_size: list(int)")
+    .Attr("sparsity_shape: list(int)")
+    .Attr("sparsity: list(int)")
+    .Attr("dtype: {float16, float32}")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Internal implementation of BlockSparseMatMulGrad.
+)doc");
+
+}  // namespace tensorflow
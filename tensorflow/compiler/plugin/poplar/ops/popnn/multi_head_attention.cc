@@ -0,0 +1,62 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+
+REGISTER_OP("IpuMultiHeadAttention")
+    .Input("query: dtype")
+    .Input("key: dtype")
+    .Input("value: dtype")
+    .Output("output: dtype")
+    .Attr("causal: bool = false")
+    .Attr("dtype: {float16, float32}")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle query, key, value, output;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &query));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 4, &key));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 4, &value));
+      TF_RETURN_IF_ERROR(c->ReplaceDim(query, 3, c->Dim(value, 3), &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Internal implementation of MultiHeadAttention.
+)doc");
+
+REGISTER_OP("IpuMultiHeadAttentionGrad")
+    .Input("query: dtype")
+    .Input("key: dtype")
+    .Input("value: dtype")
+    .Input("gradients: dtype")
+    .Output("query_backprop: dtype")
+    .Output("key_backprop: dtype")
+    .Output("value_backprop: dtype")
+    .Attr("causal: bool = false")
+    .Attr("dtype: {float16, float32}")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      c->set_output(0, c->input(0));
+      c->set_output(1, c->input(1));
+      c->set_output(2, c->input(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Internal implementation of MultiHeadAttentionGrad.
+)doc");
+
+}  // namespace tensorflow
@@ -24,4 +24,12 @@ REGISTER_OP("IpuCrossReplicaSum")
     .Attr("dtype: {float16, float32, int32}")
     .SetShapeFn(shape_inference::UnchangedShape);
 
+REGISTER_OP("IpuCompressedCrossReplicaSum")
+    .Input("residual: resource")
+    .Input("input: dtype")
+    .Output("output: dtype")
+    .Attr("dtype: {float16, float32}")
+    .Attr("compression: {'fp16', 'int8'}")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
 }  // namespace tensorflow
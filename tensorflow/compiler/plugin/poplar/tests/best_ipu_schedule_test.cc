@@ -0,0 +1,205 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/schedulers/ipu_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+
+#include "tensorflow/compiler/xla/service/heap_simulator.h"
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using BestIpuScheduleTest = HloTestBase;
+
+int64 SizeFunction(const BufferValue& buffer) {
+  return ShapeUtil::ByteSizeOf(buffer.shape(), 1);
+}
+
+const char* kHloString = R"(
+HloModule top
+
+ENTRY cluster_1 {
+  arg0 = f32[1024] parameter(0)
+  arg1 = f32[1024] parameter(1)
+  a0 = f32[1024] sine(arg0)
+  b0 = f32[1024] cosine(arg1)
+  a1 = f32[1024] multiply(a0, arg1)
+  b1 = f32[1024] multiply(b0, arg0)
+  ROOT tuple = (f32[1024], f32[1024]) tuple(a1, b1)
+}
+)";
+
+TEST_F(BestIpuScheduleTest, PicksTheScheduleUsingTheLeastMemory) {
+  auto module = ParseAndReturnVerifiedModule(kHloString).ValueOrDie();
+
+  std::atomic<int> num_calls(0);
+  auto counted = [&num_calls](IpuSchedulerAlgorithm algorithm) {
+    return IpuSchedulerAlgorithm(
+        [&num_calls, algorithm](
+            HloComputation* computation,
+            const TuplePointsToAnalysis& points_to_analysis,
+            const LogicalBuffer::SizeFunction& size_function,
+            const absl::flat_hash_map<const HloComputation*, int64>&
+                memory_by_computation) {
+          num_calls++;
+          return algorithm(computation, points_to_analysis, size_function,
+                           memory_by_computation);
+        });
+  };
+
+  IpuSchedulerAlgorithm failing =
+      [](HloComputation*, const TuplePointsToAnalysis&,
+         const LogicalBuffer::SizeFunction&,
+         const absl::flat_hash_map<const HloComputation*, int64>&)
+      -> StatusOr<HloInstructionSequence> {
+    return xla::InternalError("Failed to schedule");
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto best,
+      BestIpuSchedule(
+          {counted(failing), IpuSchedulerAlgorithm(),
+           counted(MemorySchedulerAlgorithmToIPU(DefaultMemoryScheduler)),
+           counted(MemorySchedulerAlgorithmToIPU(PostOrderMemoryScheduler))}));
+
+  IpuScheduler scheduler(SizeFunction, best);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, scheduler.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  // All the valid candidates were run and the chosen schedule uses no more
+  // memory than any of them.
+  EXPECT_EQ(num_calls, 3);
+  auto* entry = module->entry_computation();
+  auto points_to_analysis =
+      TuplePointsToAnalysis::Run(module.get()).ConsumeValueOrDie();
+  absl::flat_hash_map<const HloComputation*, int64> memory_by_computation;
+  auto memory_of = [&](const HloInstructionSequence& sequence) {
+    std::unique_ptr<HloAliasAnalysis> alias_analysis =
+        HloAliasAnalysis::NewEmptyAnalysis(module.get());
+    return HeapSimulator::MinimumMemoryForComputation(
+               *entry, sequence, *alias_analysis, SizeFunction,
+               &memory_by_computation)
+        .ValueOrDie();
+  };
+  auto candidate_memory = [&](MemorySchedulerAlgorithm algorithm) {
+    return memory_of(MemorySchedulerAlgorithmToIPU(algorithm)(
+                         entry, *points_to_analysis, SizeFunction,
+                         memory_by_computation)
+                         .ValueOrDie());
+  };
+  const int64 chosen = memory_of(module->schedule().sequence(entry));
+  EXPECT_LE(chosen, candidate_memory(DefaultMemoryScheduler));
+  EXPECT_LE(chosen, candidate_memory(PostOrderMemoryScheduler));
+}
+
+TEST_F(BestIpuScheduleTest, UsesTheMemoryEstimator) {
+  auto module = ParseAndReturnVerifiedModule(kHloString).ValueOrDie();
+  auto* entry = module->entry_computation();
+
+  // The estimator prefers the schedule starting with the cosine.
+  std::atomic<int> num_estimates(0);
+  IpuScheduleMemoryEstimator estimator =
+      [&num_estimates](const HloComputation&,
+                       const HloInstructionSequence& sequence,
+                       const LogicalBuffer::SizeFunction&,
+                       const absl::flat_hash_map<const HloComputation*, int64>&)
+      -> StatusOr<int64> {
+    num_estimates++;
+    for (const HloInstruction* inst : sequence.instructions()) {
+      if (inst->opcode() == HloOpcode::kSin) {
+        return 1;
+      }
+      if (inst->opcode() == HloOpcode::kCos) {
+        return 0;
+      }
+    }
+    return 2;
+  };
+  auto ordered = [](HloOpcode first) {
+    return IpuSchedulerAlgorithm(
+        [first](HloComputation* computation, const TuplePointsToAnalysis&,
+                const LogicalBuffer::SizeFunction&,
+                const absl::flat_hash_map<const HloComputation*, int64>&)
+            -> StatusOr<HloInstructionSequence> {
+          std::vector<HloInstruction*> order =
+              computation->MakeInstructionPostOrder();
+          std::stable_partition(order.begin(), order.end(),
+                                [first](const HloInstruction* inst) {
+                                  return inst->opcode() ==
+                                             HloOpcode::kParameter ||
+                                         inst->opcode() == first;
+                                });
+          return HloInstructionSequence(order);
+        });
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto best, BestIpuSchedule({ordered(HloOpcode::kCos),
+                                  ordered(HloOpcode::kSin)},
+                                 estimator));
+  IpuScheduler scheduler(SizeFunction, best);
+  TF_ASSERT_OK(scheduler.Run(module.get()).status());
+  EXPECT_EQ(num_estimates, 2);
+
+  const auto& sequence = module->schedule().sequence(entry).instructions();
+  auto position = [&sequence](HloOpcode opcode) {
+    auto itr = absl::c_find_if(sequence, [opcode](const HloInstruction* inst) {
+      return inst->opcode() == opcode;
+    });
+    return std::distance(sequence.begin(), itr);
+  };
+  EXPECT_LT(position(HloOpcode::kCos), position(HloOpcode::kSin));
+}
+
+TEST_F(BestIpuScheduleTest, AllCandidatesFail) {
+  auto module = ParseAndReturnVerifiedModule(kHloString).ValueOrDie();
+
+  auto failing = [](const std::string& message) {
+    return IpuSchedulerAlgorithm(
+        [message](HloComputation*, const TuplePointsToAnalysis&,
+                  const LogicalBuffer::SizeFunction&,
+                  const absl::flat_hash_map<const HloComputation*, int64>&)
+            -> StatusOr<HloInstructionSequence> {
+          return xla::InternalError("%s", message);
+        });
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto best, BestIpuSchedule({failing("first"), failing("second")}));
+  IpuScheduler scheduler(SizeFunction, best);
+  auto status = scheduler.Run(module.get()).status();
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(status.error_message(), "first");
+}
+
+TEST_F(BestIpuScheduleTest, NoValidCandidates) {
+  EXPECT_FALSE(BestIpuSchedule(std::vector<IpuSchedulerAlgorithm>{}).ok());
+  EXPECT_FALSE(BestIpuSchedule({IpuSchedulerAlgorithm()}).ok());
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
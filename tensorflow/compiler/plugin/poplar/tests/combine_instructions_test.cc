@@ -1075,6 +1075,108 @@ add {
   ASSERT_EQ(absl::c_count_if(seq, pred), 2);
 }
 
+TEST_F(CombineInstructionsTest, TestAllReduceBuckets) {
+  std::string hlo_string = R"(
+HloModule top
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  add = f32[] add(x, y)
+}
+
+%cluster_1  {
+  %arg0 = f32[256] parameter(0)
+  %arg1 = f32[256] parameter(1)
+  %arg2 = f32[256] parameter(2)
+  %arg3 = f32[256] parameter(3)
+  %a1 = f32[256] all-reduce(arg0), to_apply=add
+  %a2 = f32[256] all-reduce(arg1), to_apply=add
+  %a3 = f32[256] all-reduce(arg2), to_apply=add
+  %a4 = f32[256] all-reduce(arg3), to_apply=add
+  ROOT %tuple = (f32[256], f32[256], f32[256], f32[256]) tuple(%a1, %a2, %a3, %a4)
+}
+  )";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+
+  // Each bucket holds two of the all-reduces.
+  const auto information = CompilerInformation().set_all_reduce_bucket_size(
+      2 * 256 * sizeof(float));
+  HloMemoryScheduler scheduler(
+      [](const BufferValue& buffer) {
+        return ShapeUtil::ByteSizeOf(buffer.shape(), 1);
+      },
+      ComputationSchedulerToModuleScheduler(IpuToMemorySchedulerAlgorithm(
+          CreateClusteringMemoryScheduler(information))));
+  EXPECT_TRUE(scheduler.Run(module).ValueOrDie());
+  CombineInstructions combine_instructions(information);
+  EXPECT_TRUE(combine_instructions.Run(module).ValueOrDie());
+
+  auto s = module->schedule().sequence(module->entry_computation());
+  auto seq = s.instructions();
+
+  // 4 Arguments + 2 all reduces + 2*2 GTE + 1 output tuple = 11 instructions.
+  ASSERT_EQ(seq.size(), 11);
+
+  auto pred = [](const HloInstruction* inst) {
+    return inst->opcode() == HloOpcode::kAllReduce;
+  };
+  ASSERT_EQ(absl::c_count_if(seq, pred), 2);
+  for (const HloInstruction* inst : seq) {
+    if (pred(inst)) {
+      EXPECT_EQ(inst->operand_count(), 2);
+    }
+  }
+}
+
+TEST_F(CombineInstructionsTest, TestAllReduceDifferentReplicaGroups) {
+  std::string hlo_string = R"(
+HloModule top
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  add = f32[] add(x, y)
+}
+
+%cluster_1  {
+  %arg0 = f32[4] parameter(0)
+  %arg1 = f32[4] parameter(1)
+  %a1 = f32[4] all-reduce(arg0), replica_groups={{0,1},{2,3}}, to_apply=add
+  %a2 = f32[4] all-reduce(arg1), replica_groups={{0,1,2,3}}, to_apply=add
+  ROOT %tuple = (f32[4], f32[4]) tuple(%a1, %a2)
+}
+  )";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+
+  HloMemoryScheduler scheduler(
+      [](const BufferValue& buffer) {
+        return ShapeUtil::ByteSizeOf(buffer.shape(), 1);
+      },
+      ComputationSchedulerToModuleScheduler(
+          IpuToMemorySchedulerAlgorithm(CreateClusteringMemoryScheduler(
+              CompilerInformation().set_max_all_reduce_buffer_size(64 *
+                                                                   1024)))));
+  EXPECT_TRUE(scheduler.Run(module).ValueOrDie());
+  // The all-reduces reduce within different groups of replicas.
+  CombineInstructions combine_instructions;
+  EXPECT_FALSE(combine_instructions.Run(module).ValueOrDie());
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
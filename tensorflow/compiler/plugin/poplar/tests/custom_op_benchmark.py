@@ -0,0 +1,247 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Benchmarks of individual Poplar custom operations.
+
+Each benchmark compiles a graph containing a single custom operation for each
+of a set of shapes, types and options, runs it once on the configured device
+(the IPU Model simulates the cycles), and reports the cycles, the tile memory
+and the compilation time of every configuration.
+
+Run the benchmarks with `--benchmarks=.`, or a regular expression matching the
+names of the benchmarks to run. When the `TF_POPLAR_OP_BENCHMARK_JSON`
+environment variable is set, a JSON object is appended for each configuration
+to the file it names, one per line, so that the results of different SDK
+releases can be compared.
+"""
+
+import json
+import os
+
+import numpy as np
+
+from tensorflow.compiler.tests import xla_test
+from tensorflow.python import ipu
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import googletest
+from tensorflow.python.platform import test
+
+import test_utils as tu
+
+_JSON_OUTPUT_ENV = "TF_POPLAR_OP_BENCHMARK_JSON"
+
+
+def _group_norm(shape, groups, strided_channel_grouping=True):
+  def fn(x):
+    return ipu.normalization_ops.group_norm(
+        x,
+        groups=groups,
+        training=False,
+        strided_channel_grouping=strided_channel_grouping)
+
+  return fn, [shape]
+
+
+def _lstm(timesteps, batch_size, input_size, num_units, partials_dtype=None):
+  def fn(x):
+    lstm = ipu.rnn_ops.PopnnLSTM(
+        num_units,
+        dtype=x.dtype,
+        partials_dtype=dtypes.as_dtype(partials_dtype or x.dtype),
+        weights_initializer=init_ops.constant_initializer(0.01),
+        bias_initializer=init_ops.constant_initializer(0.1))
+    outputs, _ = lstm(x, training=False)
+    return outputs
+
+  return fn, [[timesteps, batch_size, input_size]]
+
+
+def _multi_slice(vocab_size, embedding_size, num_ids, serialization_factor=1):
+  def fn(params, ids):
+    return ipu.embedding_ops.embedding_lookup(
+        params, ids, serialization_factor=serialization_factor)
+
+  return fn, [[vocab_size, embedding_size], ([num_ids], np.int32)]
+
+
+def _topk(shape, k):
+  def fn(x):
+    return nn_ops.top_k(x, k=k)
+
+  return fn, [shape]
+
+
+def _multi_conv(input_shapes, filter_shapes, options=None):
+  @ipu.nn_ops.multi_conv(options=options)
+  def convs(*args):
+    inputs = args[:len(input_shapes)]
+    filters = args[len(input_shapes):]
+    return [
+        nn_ops.conv2d(x, f, strides=[1, 1, 1, 1], padding="SAME")
+        for x, f in zip(inputs, filters)
+    ]
+
+  return convs, list(input_shapes) + list(filter_shapes)
+
+
+def _inputs(input_specs, dtype):
+  """The random values of the inputs described by `input_specs`, which are
+  either shapes of inputs of type `dtype`, or (shape, type) pairs."""
+  inputs = []
+  for spec in input_specs:
+    shape, input_dtype = spec if isinstance(spec, tuple) else (spec, dtype)
+    if np.issubdtype(input_dtype, np.integer):
+      inputs.append(np.random.randint(0, 2, size=shape).astype(input_dtype))
+    else:
+      inputs.append(np.random.rand(*shape).astype(input_dtype))
+  return inputs
+
+
+def measure_custom_op(test_case, fn, input_specs, dtype):
+  """Compiles and runs `fn` on the IPU once, and returns a dictionary of the
+  measurements taken from the compilation and execution reports."""
+  np.random.seed(1)
+  inputs = _inputs(input_specs, dtype)
+  with ops.Graph().as_default():
+    with ops.device('cpu'):
+      placeholders = [
+          array_ops.placeholder(x.dtype, shape=x.shape) for x in inputs
+      ]
+    with ipu.scopes.ipu_scope('/device:IPU:0'):
+      r = ipu.ipu_compiler.compile(fn, inputs=placeholders)
+    tu.move_variable_initialization_to_cpu()
+
+    with session_lib.Session() as sess:
+      report = tu.ReportJSON(test_case, sess, compile_ipu_code=True)
+      sess.run(variables.global_variables_initializer())
+      report.reset()
+
+      sess.run(r, dict(zip(placeholders, inputs)))
+
+      events = report.get_event_trace()
+      report.parse_events(events)
+      _, trace = report.get_events_from_log(events)
+
+  compile_micros = sum(evt.compile_end.duration for evt in trace
+                       if evt.type == tu.IpuTraceEvent.COMPILE_END)
+  execution = report.get_execution_reports()[-1]
+  return {
+      "cycles": execution.get("simulation", {}).get("cycles"),
+      "max_tile_memory": report.get_max_tile_memory(),
+      "total_tile_memory": report.get_total_tile_memory(),
+      "always_live_memory": report.get_always_live_memory(),
+      "compile_time_s": compile_micros / 1e6,
+  }
+
+
+# The configurations of each operation which are benchmarked, as (name,
+# builder, dtype) tuples. Each builder returns the function to compile and the
+# specifications of its inputs.
+_GROUP_NORM_CONFIGS = [
+    ("n4_h8_w8_c32_g4", _group_norm([4, 8, 8, 32], 4), np.float32),
+    ("n4_h8_w8_c32_g4", _group_norm([4, 8, 8, 32], 4), np.float16),
+    ("n4_h8_w8_c32_g4_not_strided",
+     _group_norm([4, 8, 8, 32], 4, strided_channel_grouping=False), np.float32),
+    ("n8_h16_w16_c64_g8", _group_norm([8, 16, 16, 64], 8), np.float16),
+]
+
+_LSTM_CONFIGS = [
+    ("t8_b4_i16_u32", _lstm(8, 4, 16, 32), np.float32),
+    ("t8_b4_i16_u32", _lstm(8, 4, 16, 32), np.float16),
+    ("t8_b4_i16_u32_f32_partials",
+     _lstm(8, 4, 16, 32, partials_dtype=np.float32), np.float16),
+    ("t32_b16_i64_u128", _lstm(32, 16, 64, 128), np.float16),
+]
+
+_MULTI_SLICE_CONFIGS = [
+    ("v1024_d64_n128", _multi_slice(1024, 64, 128), np.float32),
+    ("v1024_d64_n128", _multi_slice(1024, 64, 128), np.float16),
+    ("v1024_d64_n128_serialized_4",
+     _multi_slice(1024, 64, 128, serialization_factor=4), np.float16),
+    ("v16384_d128_n512", _multi_slice(16384, 128, 512), np.float16),
+]
+
+_TOPK_CONFIGS = [
+    ("b4_n256_k8", _topk([4, 256], 8), np.float32),
+    ("b4_n256_k8", _topk([4, 256], 8), np.float16),
+    ("b16_n4096_k64", _topk([16, 4096], 64), np.float32),
+]
+
+_MULTI_CONV_CONFIGS = [
+    ("two_3x3", _multi_conv([[1, 16, 16, 8]] * 2, [[3, 3, 8, 16]] * 2),
+     np.float32),
+    ("two_3x3", _multi_conv([[1, 16, 16, 8]] * 2, [[3, 3, 8, 16]] * 2),
+     np.float16),
+    ("two_3x3_reserved_tiles",
+     _multi_conv([[1, 16, 16, 8]] * 2, [[3, 3, 8, 16]] * 2,
+                 options={"perConvReservedTiles": "50"}), np.float16),
+    ("3x3_and_1x1", _multi_conv([[4, 32, 32, 16]] * 2,
+                                [[3, 3, 16, 32], [1, 1, 16, 32]]), np.float16),
+]
+
+
+class CustomOpBenchmark(test.Benchmark):
+  def _benchmark_op(self, op_name, configs):
+    for config_name, (fn, input_specs), dtype in configs:
+      result = measure_custom_op(self, fn, input_specs, dtype)
+      name = "%s_%s_%s" % (op_name, config_name, np.dtype(dtype).name)
+      self.report_benchmark(name=name,
+                            iters=1,
+                            wall_time=result["compile_time_s"],
+                            extras=result)
+
+      json_output = os.environ.get(_JSON_OUTPUT_ENV)
+      if json_output:
+        record = dict(result,
+                      op=op_name,
+                      config=config_name,
+                      dtype=np.dtype(dtype).name)
+        with open(json_output, "a") as f:
+          f.write(json.dumps(record, sort_keys=True) + "\n")
+
+  def benchmarkGroupNorm(self):
+    self._benchmark_op("group_norm", _GROUP_NORM_CONFIGS)
+
+  def benchmarkLSTM(self):
+    self._benchmark_op("lstm", _LSTM_CONFIGS)
+
+  def benchmarkMultiSlice(self):
+    self._benchmark_op("multi_slice", _MULTI_SLICE_CONFIGS)
+
+  def benchmarkTopK(self):
+    self._benchmark_op("topk", _TOPK_CONFIGS)
+
+  def benchmarkMultiConv(self):
+    self._benchmark_op("multi_conv", _MULTI_CONV_CONFIGS)
+
+
+class CustomOpBenchmarkTest(xla_test.XLATestCase):
+  def testMeasureCustomOp(self):
+    fn, input_specs = _topk([4, 256], 8)
+    result = measure_custom_op(self, fn, input_specs, np.float32)
+    self.assertGreater(result["cycles"], 0)
+    self.assertGreater(result["max_tile_memory"], 0)
+    self.assertGreaterEqual(result["total_tile_memory"],
+                            result["max_tile_memory"])
+    self.assertGreater(result["compile_time_s"], 0)
+
+
+if __name__ == "__main__":
+  googletest.main()
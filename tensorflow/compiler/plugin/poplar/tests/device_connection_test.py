@@ -169,6 +169,40 @@ class TestDeviceConnection(xla_test.XLATestCase):  # pylint: disable=abstract-me
     self.assertEqual(exit_code0, 0)
     self.assertEqual(exit_code1, 0)
 
+  @test_util.deprecated_graph_mode_only
+  def testAsynchronousCompilation(self):
+    if ipu.utils.running_on_ipu_model():
+      self.skipTest(
+          "There is no device contention with the model: nothing to test.")
+
+    def BuildAndRunModelAsynchronous(first):
+      connection_type = DeviceConnectionType.ASYNCHRONOUS
+      with session.Session() as sess:
+        train, loss, inp, bias = _MyNet()
+        if first:
+          _ConfigureSystem(connection_type)
+          train = ipu.ipu_compiler.compile(lambda: (loss, train), [])
+          sess.run(variables.global_variables_initializer())
+          fd = {
+              inp: np.random.random_sample([1] + [24] * ndims + [M * K]),
+              bias: np.random.random_sample([N * K])
+          }
+          sess.run(train, fd)
+        else:
+          time.sleep(1)  # Make sure the first process goes first.
+          # The attach failure is only reported when running.
+          _ConfigureSystem(connection_type)
+          train = ipu.ipu_compiler.compile(lambda: (loss, train), [])
+          with self.assertRaisesRegex(Exception, "Could not attach"):
+            sess.run(variables.global_variables_initializer())
+
+    p0 = Process(BuildAndRunModelAsynchronous, True)
+    p1 = Process(BuildAndRunModelAsynchronous, False)
+    exit_code0 = p0.Join()
+    exit_code1 = p1.Join()
+    self.assertEqual(exit_code0, 0)
+    self.assertEqual(exit_code1, 0)
+
 
 if __name__ == "__main__":
   googletest.main()
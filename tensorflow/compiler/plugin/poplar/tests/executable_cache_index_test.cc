@@ -0,0 +1,242 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/executable_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+std::string MakeCacheDir(const std::string& name) {
+  const std::string path =
+      tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+  TF_CHECK_OK(tensorflow::Env::Default()->RecursivelyCreateDir(path));
+  return path;
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+TEST(ExecutableCacheIndexTest, MemoryStreamBuf) {
+  const std::string data = "0123456789";
+  MemoryStreamBuf buffer(data.data(), data.size());
+  std::istream stream(&buffer);
+
+  std::string word(4, '\0');
+  stream.read(&word[0], 4);
+  EXPECT_EQ(word, "0123");
+
+  stream.seekg(2, std::ios_base::cur);
+  EXPECT_EQ(stream.tellg(), 6);
+  stream.read(&word[0], 4);
+  EXPECT_EQ(word, "6789");
+
+  stream.seekg(-3, std::ios_base::end);
+  EXPECT_EQ(stream.get(), '7');
+
+  stream.seekg(1);
+  EXPECT_EQ(stream.get(), '1');
+
+  // Reading past the end fails.
+  stream.seekg(8);
+  stream.read(&word[0], 4);
+  EXPECT_FALSE(stream);
+  EXPECT_EQ(stream.gcount(), 2);
+}
+
+TEST(ExecutableCacheIndexTest, IndexAndOpen) {
+  const std::string dir = MakeCacheDir("index_and_open");
+  const std::string engine = tensorflow::io::JoinPath(dir, "a.xla_engine");
+  const std::string exec = tensorflow::io::JoinPath(dir, "a.poplar_exec");
+  WriteFile(engine, "engine");
+  WriteFile(exec, "executable");
+
+  ExecutableCache cache(dir, /*prefetch=*/true);
+  EXPECT_EQ(cache.NumIndexedFiles(), 2);
+  EXPECT_TRUE(cache.Contains(engine));
+  EXPECT_FALSE(cache.Contains(tensorflow::io::JoinPath(dir, "b.xla_engine")));
+
+  auto mapped = cache.Open(exec);
+  TF_ASSERT_OK(mapped.status());
+  EXPECT_EQ(std::string(mapped.ValueOrDie()->data(),
+                        mapped.ValueOrDie()->size()),
+            "executable");
+
+  EXPECT_FALSE(cache.Open(tensorflow::io::JoinPath(dir, "missing")).ok());
+}
+
+TEST(ExecutableCacheIndexTest, FilesAddedAfterIndexing) {
+  const std::string dir = MakeCacheDir("files_added_after_indexing");
+  ExecutableCache cache(dir, /*prefetch=*/false);
+  EXPECT_EQ(cache.NumIndexedFiles(), 0);
+
+  // Added by another process.
+  const std::string engine = tensorflow::io::JoinPath(dir, "c.xla_engine");
+  EXPECT_FALSE(cache.Contains(engine));
+  WriteFile(engine, "engine");
+  EXPECT_TRUE(cache.Contains(engine));
+  EXPECT_EQ(cache.NumIndexedFiles(), 1);
+
+  // Added by this process.
+  cache.Add(tensorflow::io::JoinPath(dir, "d.xla_engine"));
+  EXPECT_EQ(cache.NumIndexedFiles(), 2);
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+TEST(ExecutableCacheIndexTest, PublishAndFetchFromRemote) {
+  const std::string dir = MakeCacheDir("publish_local");
+  const std::string other_dir = MakeCacheDir("publish_other_host");
+  const std::string remote_dir = MakeCacheDir("publish_remote");
+  ExecutableCache cache(dir, /*prefetch=*/false, /*max_size=*/0, remote_dir);
+  ExecutableCache other_cache(other_dir, /*prefetch=*/false, /*max_size=*/0,
+                              remote_dir);
+
+  const std::string engine = tensorflow::io::JoinPath(dir, "e.xla_engine");
+  const std::string temporary = ExecutableCache::TemporaryFilename(engine);
+  EXPECT_NE(temporary, ExecutableCache::TemporaryFilename(engine));
+  WriteFile(temporary, "engine");
+  TF_ASSERT_OK(cache.Publish(temporary, engine));
+  EXPECT_TRUE(cache.Contains(engine));
+  EXPECT_FALSE(tensorflow::Env::Default()->FileExists(temporary).ok());
+  EXPECT_EQ(ReadFile(tensorflow::io::JoinPath(remote_dir, "e.xla_engine")),
+            "engine");
+
+  // Another host fetches it from the remote cache.
+  const std::string other_engine =
+      tensorflow::io::JoinPath(other_dir, "e.xla_engine");
+  EXPECT_TRUE(other_cache.Contains(other_engine));
+  EXPECT_EQ(ReadFile(other_engine), "engine");
+  EXPECT_FALSE(
+      other_cache.Contains(tensorflow::io::JoinPath(other_dir, "f.xla_engine")));
+}
+
+TEST(ExecutableCacheIndexTest, LeastRecentlyUsedFilesAreRemoved) {
+  const std::string dir = MakeCacheDir("eviction");
+  ExecutableCache cache(dir, /*prefetch=*/false, /*max_size=*/20);
+
+  auto publish = [&](const std::string& name) {
+    const std::string filename = tensorflow::io::JoinPath(dir, name);
+    const std::string temporary = ExecutableCache::TemporaryFilename(filename);
+    WriteFile(temporary, "0123456789");
+    TF_EXPECT_OK(cache.Publish(temporary, filename));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    return filename;
+  };
+
+  const std::string a = publish("a.xla_engine");
+  const std::string b = publish("b.xla_engine");
+  // Use `a` so that `b` is the least recently used.
+  TF_EXPECT_OK(cache.Open(a).status());
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+  // Both files of the module which is being added are kept.
+  const std::string c = publish("c.xla_engine.poplar_exec");
+  const std::string c_engine = publish("c.xla_engine");
+  EXPECT_EQ(cache.TotalSize(), 20);
+  EXPECT_FALSE(tensorflow::Env::Default()->FileExists(a).ok());
+  EXPECT_FALSE(tensorflow::Env::Default()->FileExists(b).ok());
+  EXPECT_TRUE(cache.Contains(c));
+  EXPECT_TRUE(cache.Contains(c_engine));
+}
+
+TEST(ExecutableCacheIndexTest, CompilationsOfTheSameModuleAreSerialised) {
+  const std::string dir = MakeCacheDir("compilations");
+  ExecutableCache cache(dir, /*prefetch=*/false);
+
+  std::atomic<bool> first_done(false);
+  std::atomic<bool> second_started(false);
+  std::thread second;
+  {
+    auto compilation = cache.BeginCompilation("module");
+
+    // A different module can be compiled at the same time.
+    { auto other = cache.BeginCompilation("other_module"); }
+
+    second = std::thread([&] {
+      auto compilation = cache.BeginCompilation("module");
+      EXPECT_TRUE(first_done);
+      second_started = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(second_started);
+    first_done = true;
+  }
+  second.join();
+  EXPECT_TRUE(second_started);
+}
+
+TEST(ExecutableCacheIndexTest, CompressedExecutables) {
+  std::string data;
+  for (int i = 0; i != 10000; ++i) {
+    data += std::to_string(i % 97);
+  }
+
+  // Use small chunks so that the data is split into several of them.
+  std::string compressed;
+  TF_ASSERT_OK(CompressExecutable(data, &compressed, /*chunk_size=*/1000));
+  EXPECT_TRUE(IsCompressedExecutable(compressed.data(), compressed.size()));
+  EXPECT_FALSE(IsCompressedExecutable(data.data(), data.size()));
+  EXPECT_LT(compressed.size(), data.size());
+
+  std::string decompressed;
+  TF_ASSERT_OK(DecompressExecutable(compressed.data(), compressed.size(),
+                                    &decompressed));
+  EXPECT_EQ(decompressed, data);
+
+  // Truncated files are detected.
+  EXPECT_FALSE(DecompressExecutable(compressed.data(), compressed.size() / 2,
+                                    &decompressed)
+                   .ok());
+
+  // Both compressed and uncompressed executables can be opened.
+  const std::string dir = MakeCacheDir("compressed_executables");
+  const std::string compressed_exec =
+      tensorflow::io::JoinPath(dir, "f.poplar_exec");
+  const std::string exec = tensorflow::io::JoinPath(dir, "g.poplar_exec");
+  WriteFile(compressed_exec, compressed);
+  WriteFile(exec, data);
+  ExecutableCache cache(dir, /*prefetch=*/false);
+  for (const std::string& filename : {compressed_exec, exec}) {
+    auto contents = cache.OpenExecutable(filename);
+    TF_ASSERT_OK(contents.status());
+    EXPECT_EQ(std::string(contents.ValueOrDie()->data(),
+                          contents.ValueOrDie()->size()),
+              data);
+  }
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
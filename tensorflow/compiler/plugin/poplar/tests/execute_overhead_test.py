@@ -0,0 +1,111 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+import numpy as np
+
+from tensorflow.compiler.plugin.poplar.ops import gen_ipu_ops
+from tensorflow.compiler.tests import xla_test
+from tensorflow.python import ipu
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import variable_scope
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import googletest
+from tensorflow.python.platform import test
+from tensorflow.python.training import gradient_descent
+
+import test_utils as tu
+
+
+def _build_train_step():
+  x = array_ops.placeholder(np.float32, shape=[1, 4])
+  with ops.device("/device:IPU:0"):
+    with variable_scope.variable_scope("vs", use_resource=True):
+      w = variable_scope.get_variable(
+          "w",
+          shape=[4, 2],
+          dtype=np.float32,
+          initializer=init_ops.constant_initializer(1.0))
+      b = variable_scope.get_variable(
+          "b",
+          shape=[2],
+          dtype=np.float32,
+          initializer=init_ops.constant_initializer(2.0))
+    loss = math_ops.reduce_sum(math_ops.matmul(x, w) + b)
+    train = gradient_descent.GradientDescentOptimizer(0.1).minimize(loss)
+  return x, train
+
+
+class ExecuteOverheadTest(xla_test.XLATestCase):
+  def testHostOverheadIsReported(self):
+    with self.session() as sess:
+      x, train = _build_train_step()
+
+      report = tu.ReportJSON(self, sess)
+      sess.run(variables.global_variables_initializer())
+      report.reset()
+
+      for _ in range(3):
+        sess.run(train, {x: np.ones([1, 4], np.float32)})
+
+      overheads = ipu.utils.extract_execute_host_overheads(
+          report.get_event_trace())
+      self.assertEqual(len(overheads), 3)
+      for _, nanos in overheads:
+        self.assertGreater(nanos, 0)
+
+
+class ExecuteOverheadBenchmark(test.Benchmark):
+  def benchmarkRepeatedExecutionHostOverhead(self):
+    """The host time of each call of an executable which is already loaded on
+    the device, with the same variables passed every time."""
+    num_calls = 100
+    with ops.Graph().as_default():
+      x, train = _build_train_step()
+      with ops.device('cpu'):
+        report = gen_ipu_ops.ipu_event_trace()
+
+      cfg = ipu.utils.create_ipu_config(profiling=True)
+      cfg = ipu.utils.auto_select_ipus(cfg, 1)
+      ipu.utils.configure_ipu_system(cfg)
+
+      with session_lib.Session() as sess:
+        sess.run(variables.global_variables_initializer())
+        feed = {x: np.ones([1, 4], np.float32)}
+        # The first call loads the executable.
+        sess.run(train, feed)
+        sess.run(report)
+
+        for _ in range(num_calls):
+          sess.run(train, feed)
+
+        overheads = [
+            nanos for _, nanos in ipu.utils.extract_execute_host_overheads(
+                sess.run(report))
+        ]
+
+    self.report_benchmark(iters=len(overheads),
+                          wall_time=np.median(overheads) / 1e9,
+                          extras={
+                              "min_host_overhead_us": np.min(overheads) / 1e3,
+                              "max_host_overhead_us": np.max(overheads) / 1e3,
+                          })
+
+
+if __name__ == "__main__":
+  googletest.main()
@@ -0,0 +1,169 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/feed_autotuner.h"
+
+#include <string>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+constexpr uint64_t kExecutionNanos = 1000000;
+
+PoplarFeedConfig InfeedConfig(int64_t prefetch_depth,
+                              int64_t max_prefetch_depth) {
+  PoplarFeedConfig config;
+  config.set_feed_id("infeed");
+  config.set_prefetch_depth(prefetch_depth);
+  config.set_max_prefetch_depth(max_prefetch_depth);
+  return config;
+}
+
+PoplarFeedConfig OutfeedConfig(int64_t io_batch_size,
+                               int64_t max_io_batch_size) {
+  PoplarFeedConfig config;
+  config.set_feed_id("outfeed");
+  config.set_io_batch_size(io_batch_size);
+  config.set_max_io_batch_size(max_io_batch_size);
+  return config;
+}
+
+// Counters where the device waited on the queues for `fraction` of the
+// execution.
+SPSCQueueStats Stalled(double fraction) {
+  SPSCQueueStats stats;
+  stats.pop_blocked_nanos = static_cast<uint64_t>(fraction * kExecutionNanos);
+  stats.push_blocked_nanos = stats.pop_blocked_nanos;
+  return stats;
+}
+
+class FeedAutotunerTest : public ::testing::Test {
+ protected:
+  FeedAutotunerTest() {
+    FeedAutotunerOptions options;
+    options.executions_per_trial = 2;
+    options.stall_threshold = 0.05;
+    autotuner_.SetOptions(options);
+  }
+
+  // Runs a trial of a graph compiled with the current tuned config.
+  void RunInfeedTrial(const PoplarFeedConfig& config, double stall_fraction) {
+    const PoplarFeedConfig compiled = autotuner_.TunedInfeedConfig(config);
+    for (int i = 0; i != 2; ++i) {
+      autotuner_.RecordInfeedExecution(compiled, Stalled(stall_fraction), 1,
+                                       kExecutionNanos);
+    }
+  }
+
+  FeedAutotuner autotuner_;
+};
+
+TEST_F(FeedAutotunerTest, FeedsWithoutABoundAreNotTuned) {
+  const PoplarFeedConfig config = InfeedConfig(1, 0);
+  RunInfeedTrial(config, 0.5);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 1);
+  EXPECT_EQ(autotuner_.ToJson(), "{}");
+}
+
+TEST_F(FeedAutotunerTest, PrefetchDepthIsDoubledUpToTheBound) {
+  const PoplarFeedConfig config = InfeedConfig(1, 6);
+
+  // The value changes once a whole trial has been observed.
+  autotuner_.RecordInfeedExecution(config, Stalled(0.5), 1, kExecutionNanos);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 1);
+  autotuner_.RecordInfeedExecution(config, Stalled(0.5), 1, kExecutionNanos);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 2);
+
+  RunInfeedTrial(config, 0.3);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 4);
+  RunInfeedTrial(config, 0.2);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 6);
+  RunInfeedTrial(config, 0.1);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 6);
+  EXPECT_NE(autotuner_.ToJson().find("\"converged\":true"), std::string::npos);
+}
+
+TEST_F(FeedAutotunerTest, StopsWhenTheStallsAreBelowTheThreshold) {
+  const PoplarFeedConfig config = InfeedConfig(2, 64);
+  RunInfeedTrial(config, 0.5);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 4);
+  RunInfeedTrial(config, 0.01);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 4);
+
+  // Converged, so further stalls don't change it.
+  RunInfeedTrial(config, 0.5);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 4);
+}
+
+TEST_F(FeedAutotunerTest, IncreasesWhichDoNotHelpAreReverted) {
+  const PoplarFeedConfig config = InfeedConfig(1, 64);
+  RunInfeedTrial(config, 0.5);
+  RunInfeedTrial(config, 0.3);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 4);
+  RunInfeedTrial(config, 0.29);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 2);
+}
+
+TEST_F(FeedAutotunerTest, ExecutionsOfStaleGraphsAreIgnored) {
+  const PoplarFeedConfig config = InfeedConfig(1, 64);
+  RunInfeedTrial(config, 0.5);
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 2);
+
+  // The graph compiled with the user's value keeps running.
+  for (int i = 0; i != 10; ++i) {
+    autotuner_.RecordInfeedExecution(config, Stalled(0.01), 1,
+                                     kExecutionNanos);
+  }
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 2);
+}
+
+TEST_F(FeedAutotunerTest, StallsAreAveragedOverTheQueues) {
+  const PoplarFeedConfig config = InfeedConfig(1, 64);
+  // Four queues which were each stalled for 2% of the execution.
+  for (int i = 0; i != 2; ++i) {
+    autotuner_.RecordInfeedExecution(config, Stalled(0.08), 4,
+                                     kExecutionNanos);
+  }
+  EXPECT_EQ(autotuner_.TunedInfeedConfig(config).prefetch_depth(), 1);
+}
+
+TEST_F(FeedAutotunerTest, OutfeedIoBatchSize) {
+  const PoplarFeedConfig config = OutfeedConfig(1, 8);
+  for (int i = 0; i != 2; ++i) {
+    autotuner_.RecordOutfeedExecution(config, Stalled(0.5), 1,
+                                      kExecutionNanos);
+  }
+  EXPECT_EQ(autotuner_.TunedOutfeedConfig(config).io_batch_size(), 2);
+  EXPECT_NE(autotuner_.ToJson().find("io_batch_size"), std::string::npos);
+
+  // The io batch size of outfeeds with a reduction is never tuned.
+  PoplarFeedConfig reduced = OutfeedConfig(1, 8);
+  reduced.set_feed_id("reduced");
+  reduced.set_reduction(PoplarFeedConfig::Mean);
+  EXPECT_FALSE(FeedAutotuner::IsTunedOutfeed(reduced));
+  for (int i = 0; i != 2; ++i) {
+    autotuner_.RecordOutfeedExecution(reduced, Stalled(0.5), 1,
+                                      kExecutionNanos);
+  }
+  EXPECT_EQ(autotuner_.TunedOutfeedConfig(reduced).io_batch_size(), 1);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_hash.h"
+#include "tensorflow/compiler/plugin/poplar/driver/backend_config.pb.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/custom_op_replacer.h"
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -931,6 +933,88 @@ ENTRY c1 {
   EXPECT_EQ(hash0.GetProtoStr(), hash1.GetProtoStr());
 }
 
+std::string PipelineWithMatMulStage() {
+  return R"(
+HloModule top
+
+stage_0 {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  d = f32[2,2] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  ROOT t = (f32[2,2]) tuple(d)
+}
+
+stage_1 {
+  p0 = f32[2,2] parameter(0)
+  a = f32[2,2] add(p0, p0)
+  ROOT t = (f32[2,2]) tuple(a)
+}
+
+pipeline {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  s0 = (f32[2,2]) call(p0, p1), to_apply=stage_0, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"0\"}}}"
+  s0_0 = f32[2,2] get-tuple-element(s0), index=0
+  s1 = (f32[2,2]) call(s0_0), to_apply=stage_1, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"1\"}}}"
+  s1_0 = f32[2,2] get-tuple-element(s1), index=0
+  ROOT t = (f32[2,2]) tuple(s1_0)
+}
+
+ENTRY e {
+  p0 = f32[2,2] parameter(0)
+  p1 = f32[2,2] parameter(1)
+  ROOT c = (f32[2,2]) call(p0, p1), to_apply=pipeline, backend_config="{\"callConfig\":{\"type\":\"Pipeline\",\"pipelineConfig\":{\"schedule\":1}}}"
+}
+)";
+}
+
+// Sets the PIPELINE_POPLAR_CONFIG of the pipeline with the given
+// availableMemoryProportion for the matmuls of each stage.
+void SetPipelineMatMulOptions(HloModule* module,
+                              const std::vector<std::string>& proportions) {
+  std::string config = "{\"forwardStages\":[";
+  for (std::size_t i = 0; i != proportions.size(); ++i) {
+    absl::StrAppend(&config, i ? "," : "",
+                    "{\"matmulOptions\":[{\"option\":"
+                    "\"availableMemoryProportion\",\"value\":\"",
+                    proportions[i], "\"}]}");
+  }
+  absl::StrAppend(&config, "]}");
+
+  HloInstruction* pipeline = module->entry_computation()->root_instruction();
+  FrontendAttributes attributes;
+  (*attributes.mutable_map())[FrontendAttributeId_Name(
+      PIPELINE_POPLAR_CONFIG)] = config;
+  pipeline->set_frontend_attributes(attributes);
+}
+
+TEST_F(HloHashTest, UnusedPipelineStageOptionsIgnored) {
+  auto module0 =
+      ParseAndReturnVerifiedModule(PipelineWithMatMulStage()).ValueOrDie();
+  auto module1 =
+      ParseAndReturnVerifiedModule(PipelineWithMatMulStage()).ValueOrDie();
+  // Only the options of the stage without a matmul are different.
+  SetPipelineMatMulOptions(module0.get(), {"0.6", "0.6"});
+  SetPipelineMatMulOptions(module1.get(), {"0.6", "0.2"});
+
+  HloHash hash0(module0.get());
+  HloHash hash1(module1.get());
+  EXPECT_EQ(hash0.GetHash(), hash1.GetHash());
+}
+
+TEST_F(HloHashTest, UsedPipelineStageOptionsDifferent) {
+  auto module0 =
+      ParseAndReturnVerifiedModule(PipelineWithMatMulStage()).ValueOrDie();
+  auto module1 =
+      ParseAndReturnVerifiedModule(PipelineWithMatMulStage()).ValueOrDie();
+  SetPipelineMatMulOptions(module0.get(), {"0.6", "0.6"});
+  SetPipelineMatMulOptions(module1.get(), {"0.2", "0.6"});
+
+  HloHash hash0(module0.get());
+  HloHash hash1(module1.get());
+  EXPECT_NE(hash0.GetHash(), hash1.GetHash());
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
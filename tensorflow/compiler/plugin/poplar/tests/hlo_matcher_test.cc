@@ -14,6 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/compiler/plugin/poplar/driver/tools/hlo_matcher.h"
+
+#include <chrono>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/plugin/poplar/driver/compiler_annotations.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
 
@@ -2039,6 +2044,81 @@ ENTRY c1 {
   EXPECT_EQ(3, hlo_module->entry_computation()->instruction_count());
 }
 
+// Also measures the time the matcher takes on a large module, where the
+// first pattern never matches.
+TEST_F(HloMatcherTest, MatchTestLargeModule) {
+  const int64 num_adds = 2000;
+  std::string hlo = R"(
+HloModule top
+
+ENTRY c1 {
+  p0 = f32[10] parameter(0)
+  p1 = f32[10] parameter(1)
+)";
+  std::vector<std::string> negates;
+  for (int64 i = 0; i != num_adds; ++i) {
+    absl::StrAppend(&hlo, "  add", i, " = f32[10] add(p0, p1)\n");
+    absl::StrAppend(&hlo, "  neg", i, " = f32[10] negate(add", i, ")\n");
+    negates.push_back(absl::StrCat("neg", i));
+  }
+  absl::StrAppend(&hlo, "  ROOT root = (",
+                  absl::StrJoin(std::vector<std::string>(num_adds, "f32[10]"),
+                                ", "),
+                  ") tuple(", absl::StrJoin(negates, ", "), ")\n}\n");
+
+  auto config = GetModuleConfigForTest();
+  auto module = ParseAndReturnVerifiedModule(hlo, config);
+  EXPECT_TRUE(module.ok());
+  auto* hlo_module = module.ValueOrDie().get();
+
+  // clang-format off
+  std::vector<HloMatcherPattern> patterns = {
+    HloMatcherPattern(
+      PatternType("test_multiply"),
+      PatternMetaTarget(0),
+      PatternInputs({1, 2}),
+      PatternOutputs({0}),
+      Pattern({
+        {HloOpcode::kMultiply, NodeOperands({1, 2})},
+        {HloMatcherOpcode::kAnyOpcode, NodeOperands({})},
+        {HloMatcherOpcode::kAnyOpcode, NodeOperands({})}
+      })
+    ),
+    HloMatcherPattern(
+      PatternType("test_add"),
+      PatternMetaTarget(0),
+      PatternInputs({1, 2}),
+      PatternOutputs({0}),
+      Pattern({
+        {HloOpcode::kAdd, NodeOperands({1, 2})},
+        {HloMatcherOpcode::kAnyOpcode, NodeOperands({})},
+        {HloMatcherOpcode::kAnyOpcode, NodeOperands({})}
+      })
+    )
+  };
+  // clang-format on
+
+  CompilerAnnotations annotations(hlo_module);
+  TestMatcher matcher(patterns, annotations, false);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(matcher.Run(hlo_module).ValueOrDie());
+  const auto end = std::chrono::steady_clock::now();
+  LOG(INFO) << "Matched " << matcher.replace_count << " patterns in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end -
+                                                                     start)
+                   .count()
+            << "ms.";
+
+  ASSERT_EQ(num_adds, matcher.replace_count);
+  EXPECT_EQ(2 * num_adds + 3,
+            hlo_module->entry_computation()->instruction_count());
+  for (const HloInstruction* inst :
+       hlo_module->entry_computation()->instructions()) {
+    EXPECT_NE(inst->opcode(), HloOpcode::kAdd);
+  }
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/plugin/poplar/driver/passes/host_compute_schedule_optimizer.h"
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/plugin/poplar/driver/passes/custom_op_replacer.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/recv_from_host.h"
 #include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
@@ -226,6 +227,47 @@ ENTRY %top (arg1: f32[], arg2: f32[], arg3: f32[], arg4: f32[]) -> () {
               ::testing::StartsWith("Unexpected dependency would cause cycle"));
 }
 
+TEST_F(HostComputeScheduleOptimizerTest, TestOverlapHostCompute) {
+  std::string hlo_string = R"(
+HloModule top
+
+ENTRY %top (arg: f32[]) -> f32[] {
+  %arg = f32[] parameter(0), parameter_replication={false}, metadata={op_name="XLA_Args"}
+  %send = () custom-call(f32[] %arg), custom_call_target="SendToHost", backend_config="{\"rendezvous_key\":\"send_key\"}", custom_call_has_side_effect=true, metadata={op_type="XlaHostCompute" op_name="host_compute"}, sharding={maximal device=0}
+  %recv = f32[] custom-call(), custom_call_target="RecvFromHost", backend_config="{\"rendezvous_key\":\"recv_key\"}", metadata={op_type="XlaHostCompute" op_name="host_compute"}, sharding={maximal device=0}
+  %sine = f32[] sine(f32[] %arg), sharding={maximal device=0}
+  %cosine = f32[] cosine(f32[] %sine), sharding={maximal device=0}
+  ROOT %add = f32[] add(f32[] %recv, f32[] %cosine), sharding={maximal device=0}
+}
+)";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+  auto* comp = module->entry_computation();
+
+  ASSERT_TRUE(CustomOpReplacer().Run(module).ValueOrDie());
+
+  // Nothing to do for a single shard without overlapping.
+  ASSERT_FALSE(HostComputeScheduleOptimizer().Run(module).ValueOrDie());
+
+  ASSERT_TRUE(HostComputeScheduleOptimizer(true).Run(module).ValueOrDie());
+
+  HloInstruction* recv = comp->root_instruction()->mutable_operand(0);
+  ASSERT_TRUE(IsPoplarInstruction(RecvFromHost)(recv));
+
+  // The recv is scheduled after the send and the independent computation.
+  HloInstruction* cosine = comp->GetInstructionWithName("cosine");
+  EXPECT_EQ(recv->control_predecessors().size(), 2);
+  EXPECT_TRUE(absl::c_linear_search(recv->control_predecessors(), cosine));
+  EXPECT_TRUE(absl::c_any_of(recv->control_predecessors(),
+                             IsPoplarInstruction(SendToHost)));
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
@@ -0,0 +1,141 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/host_embedding_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr int64 kNumRows = 2;
+constexpr int64 kMaxMisses = 2;
+constexpr uint32 kJunkRow = kNumRows + kMaxMisses;
+
+std::vector<uint32> Lookup(HostEmbeddingCache& cache,
+                           const std::vector<int>& indices) {
+  std::vector<uint32> slots(
+      HostEmbeddingCache::NumSlots(indices.size(), kMaxMisses));
+  cache.Lookup(indices.data(), indices.size(), slots.data());
+  return slots;
+}
+
+TEST(HostEmbeddingCacheTest, MissesThenHits) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLRU);
+
+  // Both rows miss, the repeated row is only sent once.
+  EXPECT_THAT(Lookup(cache, {5, 7, 5}), ElementsAre(2, 3, 2, 0, 1, 0));
+  EXPECT_THAT(cache.MissIndices(), ElementsAre(5, 7));
+
+  // Both rows are now in the cache.
+  EXPECT_THAT(Lookup(cache, {7, 5, 7}),
+              ElementsAre(1, 0, 1, kJunkRow, kJunkRow, 0));
+  EXPECT_TRUE(cache.MissIndices().empty());
+
+  EXPECT_EQ(cache.Hits(), 3);
+  EXPECT_EQ(cache.Misses(), 3);
+  EXPECT_EQ(cache.Overflows(), 0);
+}
+
+TEST(HostEmbeddingCacheTest, Overflow) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLRU);
+
+  EXPECT_THAT(Lookup(cache, {1, 2, 3}), ElementsAre(0, 0, 0, 0, 0, 1));
+  EXPECT_EQ(cache.Overflows(), 1);
+
+  // Nothing was inserted.
+  EXPECT_THAT(Lookup(cache, {1}), ElementsAre(2, 0, kJunkRow, 0));
+}
+
+TEST(HostEmbeddingCacheTest, LRUEviction) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLRU);
+
+  Lookup(cache, {1, 2});
+  Lookup(cache, {1});
+  // Row 2 is the least recently used.
+  EXPECT_THAT(Lookup(cache, {3}), ElementsAre(2, 1, kJunkRow, 0));
+  EXPECT_THAT(Lookup(cache, {1, 3}),
+              ElementsAre(0, 1, kJunkRow, kJunkRow, 0));
+}
+
+TEST(HostEmbeddingCacheTest, LFUEviction) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLFU);
+
+  Lookup(cache, {1, 2});
+  Lookup(cache, {2});
+  Lookup(cache, {2});
+  // Row 1 is the least frequently used even though it was used more recently
+  // than row 2.
+  Lookup(cache, {1});
+  EXPECT_THAT(Lookup(cache, {3}), ElementsAre(2, 0, kJunkRow, 0));
+}
+
+TEST(HostEmbeddingCacheTest, RowsUsedByTheLookupAreNotEvicted) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLRU);
+
+  Lookup(cache, {1, 2});
+  // Both cached rows are hits so the misses can't be cached.
+  EXPECT_THAT(Lookup(cache, {1, 2, 3, 4}),
+              ElementsAre(0, 1, 2, 3, kJunkRow, kJunkRow, 0));
+  EXPECT_THAT(cache.MissIndices(), ElementsAre(3, 4));
+}
+
+TEST(HostEmbeddingCacheTest, Invalidate) {
+  HostEmbeddingCache cache(kNumRows, kMaxMisses,
+                           HostEmbeddingCache::Policy::kLRU);
+
+  Lookup(cache, {1, 2});
+  const std::vector<int> updated = {2};
+  cache.Invalidate(updated.data(), updated.size());
+  EXPECT_THAT(Lookup(cache, {1, 2}), ElementsAre(0, 2, 1, kJunkRow, 0));
+  EXPECT_THAT(cache.MissIndices(), ElementsAre(2));
+
+  cache.InvalidateAll();
+  EXPECT_THAT(Lookup(cache, {1, 2}), ElementsAre(2, 3, 1, 0, 0));
+}
+
+TEST(DeduplicateIndicesTest, RepeatedIndices) {
+  std::vector<int> indices = {5, 7, 5, 5, 2, 7};
+  std::vector<uint32> slots(indices.size() + 1);
+  std::vector<int> unique;
+  EXPECT_TRUE(DeduplicateIndices(indices.data(), indices.size(), 3,
+                                 slots.data(), &unique));
+  EXPECT_THAT(slots, ElementsAre(0, 1, 0, 0, 2, 1, 0));
+  EXPECT_THAT(unique, ElementsAre(5, 7, 2));
+}
+
+TEST(DeduplicateIndicesTest, TooManyDistinctIndices) {
+  std::vector<int> indices = {5, 7, 5, 2};
+  std::vector<uint32> slots(indices.size() + 1);
+  std::vector<int> unique = {1};
+  EXPECT_FALSE(DeduplicateIndices(indices.data(), indices.size(), 2,
+                                  slots.data(), &unique));
+  EXPECT_THAT(slots, ElementsAre(0, 0, 0, 0, 1));
+  EXPECT_TRUE(unique.empty());
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_allocator.h"
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+TEST(InfeedAllocatorTest, RoundedSize) {
+  EXPECT_EQ(InfeedAllocator::RoundedSize(1), 64);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(64), 64);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(65), 80);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(128), 128);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(129), 160);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(1000), 1024);
+  EXPECT_EQ(InfeedAllocator::RoundedSize(1025), 1280);
+}
+
+TEST(InfeedAllocatorTest, ReuseBlocks) {
+  InfeedAllocator allocator{InfeedAllocator::Options()};
+
+  void* a = allocator.AllocateRaw(64, 1000);
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0);
+  EXPECT_EQ(allocator.RequestedSize(a), 1000);
+  EXPECT_EQ(allocator.AllocatedSize(a), 1024);
+  allocator.DeallocateRaw(a);
+  EXPECT_EQ(allocator.GetCacheStats().bytes_cached, 1024);
+
+  // An allocation from the same size class reuses the block.
+  void* b = allocator.AllocateRaw(64, 1010);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(allocator.RequestedSize(b), 1010);
+  allocator.DeallocateRaw(b);
+
+  auto cache_stats = allocator.GetCacheStats();
+  EXPECT_EQ(cache_stats.hits, 1);
+  EXPECT_EQ(cache_stats.misses, 1);
+
+  auto stats = *allocator.GetStats();
+  EXPECT_EQ(stats.num_allocs, 2);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.peak_bytes_in_use, 1024);
+  EXPECT_EQ(stats.largest_alloc_size, 1010);
+
+  allocator.ReleaseCachedMemory();
+  EXPECT_EQ(allocator.GetCacheStats().bytes_cached, 0);
+}
+
+TEST(InfeedAllocatorTest, RespectAlignment) {
+  InfeedAllocator allocator{InfeedAllocator::Options()};
+  void* a = allocator.AllocateRaw(4096, 100);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 4096, 0);
+  allocator.DeallocateRaw(a);
+  // Blocks with non default alignment are not cached.
+  EXPECT_EQ(allocator.GetCacheStats().bytes_cached, 0);
+}
+
+TEST(InfeedAllocatorTest, CacheLimit) {
+  InfeedAllocator::Options options;
+  options.max_cached_bytes = 1024;
+  InfeedAllocator allocator(options);
+
+  void* a = allocator.AllocateRaw(64, 1024);
+  void* b = allocator.AllocateRaw(64, 1024);
+  allocator.DeallocateRaw(a);
+  allocator.DeallocateRaw(b);
+  EXPECT_EQ(allocator.GetCacheStats().bytes_cached, 1024);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <thread>
+
 #include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_iterator.h"
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -56,6 +58,44 @@ TEST(InfeedQueueTest, EndOfQueue) {
   ASSERT_FALSE(q.BlockPop(outbuf));
 }
 
+TEST(InfeedQueueTest, WaitUntilNotFull) {
+  InfeedQueue q;
+  std::atomic<bool> cancelled(false);
+
+  FeedWaitOptions options;
+  options.adaptive = true;
+  options.spin_count = 1;
+  options.yield_count = 1;
+
+  // Fill the queue.
+  tensorflow::Tensor in(1.0f);
+  tensorflow::TensorBuffer* inbuf = tensorflow::DMAHelper::buffer(&in);
+  while (!q.IsFull()) {
+    inbuf->Ref();
+    q.Push(inbuf);
+    q.AdvanceWritePosition();
+  }
+
+  // Consume a single element from another thread - this should wake up the
+  // parked producer.
+  std::thread consumer([&q]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    q.AdvanceReadPosition();
+  });
+  ASSERT_TRUE(q.WaitUntilNotFull(options, cancelled));
+  consumer.join();
+  ASSERT_FALSE(q.IsFull());
+  ASSERT_EQ(q.GetWaiter().ParkCount(), 1);
+
+  // Fill the queue again and make sure cancellation stops the wait.
+  inbuf->Ref();
+  q.Push(inbuf);
+  q.AdvanceWritePosition();
+  ASSERT_TRUE(q.IsFull());
+  cancelled = true;
+  ASSERT_FALSE(q.WaitUntilNotFull(options, cancelled));
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
@@ -0,0 +1,65 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+import numpy as np
+
+from tensorflow.compiler.tests import xla_test
+from tensorflow.python import ipu
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import googletest
+
+import test_utils as tu
+
+
+class InstructionCompileInfoTest(xla_test.XLATestCase):
+  def testCompileTimeAndMemoryAreAttributedToOps(self):
+    with self.session() as sess:
+      with ops.device("/device:IPU:0"):
+        x = array_ops.placeholder(np.float32, shape=[32, 32])
+        y = math_ops.matmul(x, x, name="my_matmul")
+        z = math_ops.add(y, x, name="my_add")
+
+      report = tu.ReportJSON(self, sess)
+      report.reset()
+
+      sess.run(z, {x: np.ones([32, 32], np.float32)})
+
+      infos = ipu.utils.extract_instruction_compile_info(
+          report.get_event_trace())
+      self.assertEqual(len(infos), 1)
+      _, info = infos[0]
+
+      self.assertIn("my_matmul", info['ops'])
+      self.assertIn("my_add", info['ops'])
+      add = info['ops']['my_add']
+      self.assertEqual(add['op_type'], "AddV2")
+      self.assertGreater(add['compile_nanos'], 0)
+      self.assertEqual(add['output_bytes'], 32 * 32 * 4)
+
+      for inst in info['instructions'].values():
+        self.assertLessEqual(inst['max_tile_output_bytes'],
+                             inst['output_bytes'])
+        self.assertLessEqual(inst['balanced_tile_output_bytes'],
+                             inst['max_tile_output_bytes'])
+
+      # Nothing is rebalanced unless the flag is set.
+      self.assertEqual(info['tile_imbalance']['rebalanced_tensors'], 0)
+      self.assertEqual(info['tile_imbalance']['max_tile_bytes_saved'], 0)
+
+
+if __name__ == "__main__":
+  googletest.main()
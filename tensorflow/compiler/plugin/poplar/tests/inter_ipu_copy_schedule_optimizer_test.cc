@@ -0,0 +1,97 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/passes/inter_ipu_copy_schedule_optimizer.h"
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/inter_ipu_copy_inserter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using InterIpuCopyScheduleOptimizerTest = HloTestBase;
+
+TEST_F(InterIpuCopyScheduleOptimizerTest, TestCopyBeforeIndependent) {
+  std::string hlo_string = R"(
+HloModule top
+
+cluster_1  {
+  arg0 = f16[4] parameter(0), sharding={maximal device=0}
+  arg1 = f16[4] parameter(1), sharding={maximal device=0}
+  arg2 = f16[4] parameter(2), sharding={maximal device=1}
+  sin0 = f16[4] sine(arg0), sharding={maximal device=0}
+  cos0 = f16[4] cosine(arg1), sharding={maximal device=0}
+  exp0 = f16[4] exponential(cos0), sharding={maximal device=0}
+  mul0 = f16[4] multiply(sin0, arg2), sharding={maximal device=1}
+  ROOT tuple = (f16[4], f16[4]) tuple(mul0, exp0),
+      sharding={{maximal device=1}, {maximal device=0}}
+}
+  )";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+  EXPECT_TRUE(InterIpuCopyInserter().Run(module).ValueOrDie());
+  EXPECT_TRUE(InterIpuCopyScheduleOptimizer().Run(module).ValueOrDie());
+
+  const auto* mul0 = FindInstruction(module, "mul0");
+  const auto* copy = mul0->operand(0);
+  ASSERT_TRUE(IsPoplarInstruction(PoplarOp::IpuInterCopy)(copy));
+
+  // The copy is scheduled before the computation of shard 0 which does not
+  // depend on it, but only needs a dependency on the first instruction of it.
+  const auto* cos0 = FindInstruction(module, "cos0");
+  ASSERT_EQ(copy->control_successors().size(), 1);
+  EXPECT_EQ(copy->control_successors()[0], cos0);
+
+  // Running it again does not change anything.
+  EXPECT_FALSE(InterIpuCopyScheduleOptimizer().Run(module).ValueOrDie());
+}
+
+TEST_F(InterIpuCopyScheduleOptimizerTest, TestNoIndependentInstructions) {
+  std::string hlo_string = R"(
+HloModule top
+
+cluster_1  {
+  arg0 = f16[4] parameter(0), sharding={maximal device=0}
+  arg1 = f16[4] parameter(1), sharding={maximal device=1}
+  sin0 = f16[4] sine(arg0), sharding={maximal device=0}
+  mul0 = f16[4] multiply(sin0, arg1), sharding={maximal device=1}
+  ROOT tuple = (f16[4]) tuple(mul0), sharding={{maximal device=1}}
+}
+  )";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+  EXPECT_TRUE(InterIpuCopyInserter().Run(module).ValueOrDie());
+  EXPECT_FALSE(InterIpuCopyScheduleOptimizer().Run(module).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,107 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/ipu_activity_recorder.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/internal/profiler_interface.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace xla {
+namespace poplarplugin {
+
+std::unique_ptr<tensorflow::profiler::ProfilerInterface> CreateIpuTracer(
+    const tensorflow::profiler::ProfilerOptions& options);
+
+namespace {
+
+// Returns the names of the nodes of each device in the step stats.
+std::map<std::string, std::vector<std::string>> NodesByDevice(
+    const tensorflow::RunMetadata& run_metadata) {
+  std::map<std::string, std::vector<std::string>> nodes;
+  for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      nodes[dev_stats.device()].push_back(node_stats.node_name());
+    }
+  }
+  return nodes;
+}
+
+TEST(IpuTracerTest, CollectsActivitiesPerDevice) {
+  {
+    // Not recorded, the tracer is not running.
+    IpuActivityScope activity(0, IpuActivityType::kExecute, "before");
+  }
+
+  auto tracer = CreateIpuTracer(tensorflow::profiler::ProfilerOptions());
+  ASSERT_NE(tracer, nullptr);
+  TF_ASSERT_OK(tracer->Start());
+  {
+    IpuActivityScope execute(0, IpuActivityType::kExecute, "cluster_1");
+    IpuActivityScope callback(0, IpuActivityType::kStreamCallback, "out_0");
+  }
+  {
+    IpuActivityScope transfer(1, IpuActivityType::kHostToDevice,
+                              "host_to_device");
+  }
+  TF_ASSERT_OK(tracer->Stop());
+  {
+    // Not recorded, the tracer has stopped.
+    IpuActivityScope activity(0, IpuActivityType::kExecute, "after");
+  }
+
+  tensorflow::RunMetadata run_metadata;
+  TF_ASSERT_OK(tracer->CollectData(&run_metadata));
+  const auto nodes = NodesByDevice(run_metadata);
+  EXPECT_EQ(nodes.size(), 3);
+  EXPECT_THAT(nodes.at("/device:IPU:0"), ::testing::ElementsAre("cluster_1"));
+  EXPECT_THAT(nodes.at("/device:IPU:0/stream_callbacks"),
+              ::testing::ElementsAre("out_0"));
+  EXPECT_THAT(nodes.at("/device:IPU:1/memcpy"),
+              ::testing::ElementsAre("host_to_device"));
+
+  for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      EXPECT_GT(node_stats.all_start_micros(), 0);
+      if (node_stats.node_name() == "cluster_1") {
+        EXPECT_EQ(node_stats.timeline_label(), "Execute cluster_1");
+      }
+    }
+  }
+}
+
+TEST(IpuTracerTest, OnlyOneTracerRecords) {
+  auto tracer = CreateIpuTracer(tensorflow::profiler::ProfilerOptions());
+  auto other_tracer = CreateIpuTracer(tensorflow::profiler::ProfilerOptions());
+  TF_ASSERT_OK(tracer->Start());
+  EXPECT_FALSE(other_tracer->Start().ok());
+  TF_ASSERT_OK(tracer->Stop());
+}
+
+TEST(IpuTracerTest, NotCreatedForOtherDeviceTypes) {
+  tensorflow::profiler::ProfilerOptions options;
+  options.device_type = tensorflow::profiler::DeviceType::kGpu;
+  EXPECT_EQ(CreateIpuTracer(options), nullptr);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
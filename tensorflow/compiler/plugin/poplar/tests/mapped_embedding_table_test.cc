@@ -0,0 +1,144 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/mapped_embedding_table.h"
+
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+constexpr int64 kNumRows = 8;
+constexpr int64 kWidth = 4;
+
+std::string TablePath(const std::string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+std::vector<float> MakeTable() {
+  std::vector<float> data(kNumRows * kWidth);
+  std::iota(data.begin(), data.end(), 0.0f);
+  return data;
+}
+
+std::vector<float> ReadRow(const MappedEmbeddingTable& table, int64 row) {
+  const float* values = static_cast<const float*>(table.Row(row));
+  return std::vector<float>(values, values + kWidth);
+}
+
+TEST(MappedEmbeddingTableTest, CreateAndOpen) {
+  const std::string path = TablePath("create_and_open.emb");
+  const auto data = MakeTable();
+  TF_ASSERT_OK(MappedEmbeddingTable::Create(path, tensorflow::DT_FLOAT,
+                                            kNumRows, kWidth, data.data()));
+
+  auto table_or = MappedEmbeddingTable::Open(path, "");
+  TF_ASSERT_OK(table_or.status());
+  auto table = table_or.ConsumeValueOrDie();
+
+  EXPECT_EQ(table->dtype(), tensorflow::DT_FLOAT);
+  EXPECT_EQ(table->NumRows(), kNumRows);
+  EXPECT_EQ(table->EncodingWidth(), kWidth);
+  EXPECT_EQ(table->RowBytes(), kWidth * sizeof(float));
+  EXPECT_THAT(ReadRow(*table, 2), ::testing::ElementsAre(8, 9, 10, 11));
+}
+
+TEST(MappedEmbeddingTableTest, UpdatesDoNotModifyTheFile) {
+  const std::string path = TablePath("updates_do_not_modify.emb");
+  const auto data = MakeTable();
+  TF_ASSERT_OK(MappedEmbeddingTable::Create(path, tensorflow::DT_FLOAT,
+                                            kNumRows, kWidth, data.data()));
+
+  {
+    auto table = MappedEmbeddingTable::Open(path, "").ConsumeValueOrDie();
+    static_cast<float*>(table->Row(1))[0] = 100.0f;
+    EXPECT_THAT(ReadRow(*table, 1), ::testing::ElementsAre(100, 5, 6, 7));
+  }
+
+  auto table = MappedEmbeddingTable::Open(path, "").ConsumeValueOrDie();
+  EXPECT_THAT(ReadRow(*table, 1), ::testing::ElementsAre(4, 5, 6, 7));
+}
+
+TEST(MappedEmbeddingTableTest, ReplayLog) {
+  const std::string path = TablePath("replay_log.emb");
+  const std::string log_path = path + ".log";
+  const auto data = MakeTable();
+  TF_ASSERT_OK(MappedEmbeddingTable::Create(path, tensorflow::DT_FLOAT,
+                                            kNumRows, kWidth, data.data()));
+
+  {
+    auto table = MappedEmbeddingTable::Open(path, log_path).ConsumeValueOrDie();
+    EXPECT_EQ(table->NumReplayedRecords(), 0);
+    static_cast<float*>(table->Row(1))[0] = 100.0f;
+    static_cast<float*>(table->Row(3))[3] = 200.0f;
+    const std::vector<int> updated = {1, 3};
+    TF_ASSERT_OK(table->LogRows(updated.data(), updated.size()));
+
+    // The last update of a row wins.
+    static_cast<float*>(table->Row(1))[0] = 300.0f;
+    const std::vector<int> updated_again = {1};
+    TF_ASSERT_OK(table->LogRows(updated_again.data(), updated_again.size()));
+  }
+
+  // A partially written record is ignored.
+  {
+    std::ofstream log(log_path, std::ios::binary | std::ios::app);
+    const int32 index = 5;
+    log.write(reinterpret_cast<const char*>(&index), sizeof(index));
+    log.write("\0\0", 2);
+  }
+
+  auto table = MappedEmbeddingTable::Open(path, log_path).ConsumeValueOrDie();
+  EXPECT_EQ(table->NumReplayedRecords(), 3);
+  EXPECT_THAT(ReadRow(*table, 1), ::testing::ElementsAre(300, 5, 6, 7));
+  EXPECT_THAT(ReadRow(*table, 3), ::testing::ElementsAre(12, 13, 14, 200));
+  EXPECT_THAT(ReadRow(*table, 5), ::testing::ElementsAre(20, 21, 22, 23));
+}
+
+TEST(MappedEmbeddingTableTest, InvalidFile) {
+  const std::string path = TablePath("invalid.emb");
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "not an embedding table";
+  }
+  EXPECT_FALSE(MappedEmbeddingTable::Open(path, "").ok());
+  EXPECT_FALSE(MappedEmbeddingTable::Open(TablePath("missing.emb"), "").ok());
+}
+
+TEST(MappedEmbeddingTableTest, TruncatedFile) {
+  const std::string path = TablePath("truncated.emb");
+  const auto data = MakeTable();
+  TF_ASSERT_OK(MappedEmbeddingTable::Create(path, tensorflow::DT_FLOAT,
+                                            kNumRows - 1, kWidth, data.data()));
+  {
+    // Claim there are more rows than there are in the file.
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const int64 num_rows = kNumRows;
+    file.seekp(offsetof(MappedEmbeddingTable::Header, num_rows));
+    file.write(reinterpret_cast<const char*>(&num_rows), sizeof(num_rows));
+  }
+  EXPECT_FALSE(MappedEmbeddingTable::Open(path, "").ok());
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/plugin/poplar/driver/passes/multi_conv_combiner.h"
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/multi_conv.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+using MultiConvCombinerTest = HloTestBase;
+
+// conv1 and conv2 are independent, conv3 uses the output of conv1. Each
+// convolution has 3216 bytes of inputs and outputs.
+const char* const kHlo = R"(
+HloModule top
+
+ENTRY e {
+  p0 = f16[1,16,16,2] parameter(0)
+  p1 = f16[3,3,2,4] parameter(1)
+  p2 = f16[1,16,16,2] parameter(2)
+  p3 = f16[3,3,2,4] parameter(3)
+  p4 = f16[3,3,4,2] parameter(4)
+  conv2 = f16[1,16,16,4] convolution(p2, p3), window={size=3x3 pad=1_1x1_1}, dim_labels=b01f_01io->b01f
+  conv1 = f16[1,16,16,4] convolution(p0, p1), window={size=3x3 pad=1_1x1_1}, dim_labels=b01f_01io->b01f
+  conv3 = f16[1,16,16,2] convolution(conv1, p4), window={size=3x3 pad=1_1x1_1}, dim_labels=b01f_01io->b01f
+  ROOT t = (f16[1,16,16,4], f16[1,16,16,2]) tuple(conv2, conv3)
+}
+)";
+
+TEST_F(MultiConvCombinerTest, CombineIndependentConvolutions) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          MultiConvCombiner(1024 * 1024).Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  const HloInstruction* conv2 = root->operand(0);
+  const HloInstruction* conv3 = root->operand(1);
+  EXPECT_EQ(conv2->opcode(), HloOpcode::kGetTupleElement);
+  EXPECT_EQ(conv3->opcode(), HloOpcode::kConvolution);
+
+  // conv1 and conv2 are in the same multi-conv, which conv3 depends on.
+  const HloInstruction* multi_conv = conv2->operand(0);
+  ASSERT_TRUE(IsPoplarInstruction(PoplarOp::MultiConv, multi_conv));
+  EXPECT_EQ(conv3->operand(0)->opcode(), HloOpcode::kGetTupleElement);
+  EXPECT_EQ(conv3->operand(0)->operand(0), multi_conv);
+  EXPECT_EQ(
+      Cast<HloMultiConvInstruction>(multi_conv)->GetConvolutionSpecs().size(),
+      2);
+  EXPECT_FALSE(Cast<HloMultiConvInstruction>(multi_conv)->IsWeightUpdate());
+}
+
+TEST_F(MultiConvCombinerTest, MemoryCap) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          MultiConvCombiner(5000).Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(MultiConvCombinerTest, DifferentShards) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  HloComputation* entry = module->entry_computation();
+  entry->GetInstructionWithName("conv1")->set_device_sharding(0);
+  entry->GetInstructionWithName("conv2")->set_device_sharding(1);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          MultiConvCombiner(1024 * 1024).Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
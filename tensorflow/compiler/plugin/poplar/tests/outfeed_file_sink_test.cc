@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_file_sink.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+// A batch of `count` elements with a float tensor of shape [2] and an int
+// scalar.
+std::vector<tensorflow::Tensor> MakeBatch(int64 count, float start) {
+  tensorflow::Tensor floats(tensorflow::DT_FLOAT,
+                            tensorflow::TensorShape({count, 2}));
+  tensorflow::Tensor ints(tensorflow::DT_INT32,
+                          tensorflow::TensorShape({count}));
+  for (int64 i = 0; i != count; ++i) {
+    floats.matrix<float>()(i, 0) = start + i;
+    floats.matrix<float>()(i, 1) = -(start + i);
+    ints.vec<int32>()(i) = static_cast<int32>(start + i);
+  }
+  return {floats, ints};
+}
+
+std::string TestPrefix(const std::string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(OutfeedFileSinkTest, TFRecord) {
+  const std::string prefix = TestPrefix("tfrecord");
+  {
+    OutfeedFileSink sink(prefix, OutfeedFileSink::Format::kTFRecord,
+                         /*elements_per_file=*/3);
+    sink.Write(MakeBatch(2, 0.f));
+    sink.Write(MakeBatch(2, 2.f));
+    TF_ASSERT_OK(sink.Flush());
+  }
+
+  // The 4 elements are split into files of 3 and 1 elements, with one record
+  // per tensor of each element.
+  int64 element = 0;
+  for (int64 file_index = 0; file_index != 2; ++file_index) {
+    std::unique_ptr<tensorflow::RandomAccessFile> file;
+    TF_ASSERT_OK(tensorflow::Env::Default()->NewRandomAccessFile(
+        OutfeedFileSink::FileName(prefix, OutfeedFileSink::Format::kTFRecord,
+                                  file_index),
+        &file));
+    tensorflow::io::SequentialRecordReader reader(file.get());
+    tensorflow::tstring record;
+    while (reader.ReadRecord(&record).ok()) {
+      tensorflow::TensorProto proto;
+      ASSERT_TRUE(proto.ParseFromString(record));
+      tensorflow::Tensor floats;
+      ASSERT_TRUE(floats.FromProto(proto));
+      tensorflow::test::ExpectTensorEqual<float>(
+          floats, tensorflow::test::AsTensor<float>(
+                      {static_cast<float>(element),
+                       -static_cast<float>(element)}));
+
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+      ASSERT_TRUE(proto.ParseFromString(record));
+      tensorflow::Tensor ints;
+      ASSERT_TRUE(ints.FromProto(proto));
+      EXPECT_EQ(ints.dims(), 0);
+      EXPECT_EQ(ints.scalar<int32>()(), element);
+      ++element;
+    }
+    EXPECT_EQ(element, file_index == 0 ? 3 : 4);
+  }
+}
+
+TEST(OutfeedFileSinkTest, Raw) {
+  const std::string prefix = TestPrefix("raw");
+  {
+    OutfeedFileSink sink(prefix, OutfeedFileSink::Format::kRaw,
+                         /*elements_per_file=*/0, /*max_pending_batches=*/1);
+    for (int64 i = 0; i != 4; ++i) {
+      sink.Write(MakeBatch(2, 2.f * i));
+    }
+  }
+
+  // All the elements are in a single file, with the bytes of the tensors of
+  // each element concatenated.
+  std::string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(
+      tensorflow::Env::Default(),
+      OutfeedFileSink::FileName(prefix, OutfeedFileSink::Format::kRaw, 0),
+      &contents));
+  struct Element {
+    float floats[2];
+    int32 i;
+  };
+  ASSERT_EQ(contents.size(), 8 * sizeof(Element));
+  for (int64 i = 0; i != 8; ++i) {
+    Element element;
+    std::memcpy(&element, contents.data() + i * sizeof(Element),
+                sizeof(Element));
+    EXPECT_EQ(element.floats[0], i);
+    EXPECT_EQ(element.floats[1], -i);
+    EXPECT_EQ(element.i, i);
+  }
+  EXPECT_FALSE(tensorflow::Env::Default()
+                   ->FileExists(OutfeedFileSink::FileName(
+                       prefix, OutfeedFileSink::Format::kRaw, 1))
+                   .ok());
+}
+
+TEST(OutfeedFileSinkTest, FlushReturnsWriteErrors) {
+  OutfeedFileSink sink("/non/existent/directory/outfeed",
+                       OutfeedFileSink::Format::kRaw, 0);
+  sink.Write(MakeBatch(1, 0.f));
+  EXPECT_FALSE(sink.Flush().ok());
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
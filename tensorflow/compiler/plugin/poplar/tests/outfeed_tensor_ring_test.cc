@@ -0,0 +1,81 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/outfeed_tensor_ring.h"
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+void WriteElements(OutfeedTensorRing& ring, int64 count, float start) {
+  ring.Reserve(count);
+  for (int64 i = 0; i != count; ++i) {
+    float* data = reinterpret_cast<float*>(ring.ElementData(0, i));
+    data[0] = start + i;
+    data[1] = -(start + i);
+  }
+  ring.Commit(count);
+}
+
+TEST(OutfeedTensorRingTest, TakeAll) {
+  OutfeedTensorRing ring({tensorflow::DT_FLOAT},
+                         {tensorflow::TensorShape({2})});
+  EXPECT_EQ(ring.NumElements(), 0);
+
+  auto empty = ring.TakeAll();
+  ASSERT_EQ(empty.size(), 1);
+  EXPECT_EQ(empty[0].shape(), tensorflow::TensorShape({0, 2}));
+
+  // Grow the storage over multiple writes.
+  WriteElements(ring, 2, 0.f);
+  WriteElements(ring, 3, 2.f);
+  EXPECT_EQ(ring.NumElements(), 5);
+
+  auto outputs = ring.TakeAll();
+  EXPECT_EQ(ring.NumElements(), 0);
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[0].shape(), tensorflow::TensorShape({5, 2}));
+  auto values = outputs[0].matrix<float>();
+  for (int64 i = 0; i != 5; ++i) {
+    EXPECT_EQ(values(i, 0), i);
+    EXPECT_EQ(values(i, 1), -i);
+  }
+}
+
+TEST(OutfeedTensorRingTest, ReuseReleasedStorage) {
+  OutfeedTensorRing ring({tensorflow::DT_FLOAT},
+                         {tensorflow::TensorShape({2})});
+  WriteElements(ring, 4, 0.f);
+  auto outputs = ring.TakeAll();
+  const int64 allocations = ring.NumAllocations();
+
+  // The first outputs are still alive, so new storage is required.
+  WriteElements(ring, 4, 10.f);
+  EXPECT_EQ(ring.NumAllocations(), allocations + 1);
+  EXPECT_EQ(outputs[0].matrix<float>()(0, 0), 0.f);
+
+  // Once released the storage is reused.
+  outputs.clear();
+  ring.TakeAll();
+  WriteElements(ring, 4, 20.f);
+  EXPECT_EQ(ring.NumAllocations(), allocations + 1);
+  outputs = ring.TakeAll();
+  EXPECT_EQ(outputs[0].matrix<float>()(3, 0), 23.f);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
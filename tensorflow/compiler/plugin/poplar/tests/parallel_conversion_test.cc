@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_conversion.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/conversions.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+std::vector<int64> MakeSource(int64 num_elements) {
+  std::vector<int64> source(num_elements);
+  for (int64 i = 0; i != num_elements; ++i) {
+    source[i] = (i % 2 ? -1 : 1) * i * 3;
+  }
+  return source;
+}
+
+TEST(ParallelConversionTest, NumChunks) {
+  ParallelConverter converter(4, 100);
+  EXPECT_EQ(converter.NumChunks(0), 1);
+  EXPECT_EQ(converter.NumChunks(199), 1);
+  EXPECT_EQ(converter.NumChunks(200), 2);
+  EXPECT_EQ(converter.NumChunks(100000), 4);
+
+  ParallelConverter single_thread(1, 100);
+  EXPECT_EQ(single_thread.NumChunks(100000), 1);
+}
+
+TEST(ParallelConversionTest, ConvertsToAndFromTheDeviceFormat) {
+  for (int64 num_threads : {1, 3}) {
+    ParallelConverter converter(num_threads, 100);
+    // Sizes which don't divide into whole chunks.
+    for (int64 num_elements : {0, 1, 250, 1001}) {
+      const std::vector<int64> source = MakeSource(num_elements);
+      std::vector<int32> device(num_elements + 1, 7);
+      converter.Convert(ConvInt64ToInt32, source.data(), sizeof(int64),
+                        device.data(), sizeof(int32), num_elements);
+      converter.Wait();
+      for (int64 i = 0; i != num_elements; ++i) {
+        EXPECT_EQ(device[i], source[i]);
+      }
+      // Nothing is written past the end.
+      EXPECT_EQ(device[num_elements], 7);
+
+      std::vector<int64> host(num_elements);
+      converter.Convert(ConvInt32ToInt64, device.data(), sizeof(int32),
+                        host.data(), sizeof(int64), num_elements);
+      converter.Wait();
+      EXPECT_EQ(host, source);
+    }
+  }
+}
+
+TEST(ParallelConversionTest, WaitsForAllTheConversions) {
+  ParallelConverter converter(3, 100);
+  const int64 num_elements = 10000;
+  const std::vector<int64> source = MakeSource(num_elements);
+  std::vector<std::vector<int32>> dests(8, std::vector<int32>(num_elements));
+  for (auto& dest : dests) {
+    converter.Convert(ConvInt64ToInt32, source.data(), sizeof(int64),
+                      dest.data(), sizeof(int32), num_elements);
+  }
+  converter.Wait();
+  for (auto& dest : dests) {
+    EXPECT_EQ(std::vector<int64>(dest.begin(), dest.end()), source);
+  }
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,86 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_copy.h"
+
+#include <thread>
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+std::vector<char> MakeSource(std::size_t num_bytes) {
+  std::vector<char> source(num_bytes);
+  for (std::size_t i = 0; i != num_bytes; ++i) {
+    source[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  return source;
+}
+
+TEST(ParallelCopyTest, NumChunks) {
+  ParallelCopier copier(4, 1024);
+  EXPECT_EQ(copier.NumChunks(0), 1);
+  EXPECT_EQ(copier.NumChunks(1024), 1);
+  EXPECT_EQ(copier.NumChunks(2048), 2);
+  EXPECT_EQ(copier.NumChunks(3 * 1024 + 1), 3);
+  EXPECT_EQ(copier.NumChunks(1 << 20), 4);
+
+  ParallelCopier single_thread(1, 1024);
+  EXPECT_EQ(single_thread.NumChunks(1 << 20), 1);
+}
+
+TEST(ParallelCopyTest, CopiesAllTheBytes) {
+  ParallelCopier copier(4, 1024);
+  // Sizes which don't divide into whole cache lines or chunks.
+  for (std::size_t num_bytes : {0, 100, 2048, 4097, 10000, 65601}) {
+    const std::vector<char> source = MakeSource(num_bytes);
+    std::vector<char> dest(num_bytes + 1, 'x');
+    copier.Copy(dest.data(), source.data(), num_bytes);
+    EXPECT_TRUE(std::equal(source.begin(), source.end(), dest.begin()))
+        << num_bytes;
+    // Nothing is written past the end.
+    EXPECT_EQ(dest[num_bytes], 'x');
+  }
+}
+
+TEST(ParallelCopyTest, ConcurrentCopies) {
+  ParallelCopier copier(3, 1024);
+  const std::size_t num_bytes = 100000;
+  const std::vector<char> source = MakeSource(num_bytes);
+  std::vector<std::vector<char>> dests(4, std::vector<char>(num_bytes));
+
+  std::vector<std::thread> threads;
+  for (auto& dest : dests) {
+    threads.emplace_back([&copier, &source, &dest, num_bytes]() {
+      for (int i = 0; i != 10; ++i) {
+        copier.Copy(dest.data(), source.data(), num_bytes);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& dest : dests) {
+    EXPECT_EQ(dest, source);
+  }
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,207 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/pipeline_stage_balancer.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/plugin/poplar/driver/passes/custom_op_replacer.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/pipeline_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using PipelineStageBalancerTest = HloTestBase;
+
+std::string GetUnbalancedPipeline(const std::string& schedule) {
+  return absl::StrCat(R"(
+HloModule top
+
+stage_0 {
+  p0 = f32[16,16] parameter(0)
+  p1 = f32[16,16] parameter(1)
+  d = f32[16,16] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  a0 = f32[16,16] add(d, d)
+  a1 = f32[16,16] multiply(a0, a0)
+  a2 = f32[16,16] add(a1, a1)
+  ROOT t = (f32[16,16]) tuple(a2)
+}
+
+stage_1 {
+  p0 = f32[16,16] parameter(0)
+  a = f32[16,16] add(p0, p0)
+  ROOT t = (f32[16,16]) tuple(a)
+}
+
+pipeline {
+  p0 = f32[16,16] parameter(0)
+  p1 = f32[16,16] parameter(1)
+  s0 = (f32[16,16]) call(p0, p1), to_apply=stage_0, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"0\"}}}"
+  s0_0 = f32[16,16] get-tuple-element(s0), index=0
+  s1 = (f32[16,16]) call(s0_0), to_apply=stage_1, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"1\"}}}"
+  s1_0 = f32[16,16] get-tuple-element(s1), index=0
+  ROOT t = (f32[16,16]) tuple(s1_0)
+}
+
+ENTRY e {
+  p0 = f32[16,16] parameter(0)
+  p1 = f32[16,16] parameter(1)
+  ROOT c = (f32[16,16]) call(p0, p1), to_apply=pipeline, backend_config="{\"callConfig\":{\"type\":\"Pipeline\",\"pipelineConfig\":{\"schedule\":\")",
+                      schedule, R"(\",\"gradientAccumulationCount\":\"4\"}}}"
+}
+)");
+}
+
+PipelineStageCostModel GetCostModel() {
+  PipelineStageCostModel cost_model;
+  cost_model.tiles_per_ipu = 1;
+  cost_model.cycles_per_instruction = 100;
+  return cost_model;
+}
+
+TEST_F(PipelineStageBalancerTest, UnbalancedStages) {
+  auto module =
+      ParseAndReturnVerifiedModule(GetUnbalancedPipeline("Grouped"))
+          .ConsumeValueOrDie();
+  TF_ASSERT_OK_AND_ASSIGN(auto pipelines, GetPipelines(module.get()));
+  ASSERT_EQ(pipelines.size(), 1);
+
+  PipelineStageBalancer balancer(GetCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(PipelineBalanceReport report,
+                          balancer.Analyse(pipelines[0]));
+  ASSERT_EQ(report.stages.size(), 2);
+  EXPECT_EQ(report.gradient_accumulation_count, 4);
+
+  const PipelineStageEstimate& stage_0 = report.stages[0];
+  const PipelineStageEstimate& stage_1 = report.stages[1];
+  EXPECT_EQ(stage_0.stage_id, 0);
+  EXPECT_EQ(stage_1.stage_id, 1);
+  EXPECT_GT(stage_0.cycles(), stage_1.cycles());
+  EXPECT_EQ(stage_0.backward_cycles, 0);
+
+  // Both parameters and the result of the dot.
+  EXPECT_EQ(stage_0.max_live_bytes, 3 * 16 * 16 * 4);
+  EXPECT_EQ(stage_1.max_live_bytes, 2 * 16 * 16 * 4);
+
+  // The 4 batches take 5 iterations of the longest stage.
+  const double expected_bubble_fraction =
+      1.0 - 4.0 * (stage_0.cycles() + stage_1.cycles()) /
+                (2.0 * 5.0 * stage_0.cycles());
+  EXPECT_NEAR(report.bubble_fraction, expected_bubble_fraction, 1e-6);
+
+  EXPECT_THAT(report.suggestion,
+              ::testing::HasSubstr("from a2 to the end of pipeline stage 0 "
+                                   "into stage 1"));
+  EXPECT_THAT(report.ToString(),
+              ::testing::HasSubstr("Estimated bubble fraction"));
+
+  // The module is not modified.
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, balancer.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(PipelineStageBalancerTest, SequentialSchedule) {
+  auto module =
+      ParseAndReturnVerifiedModule(GetUnbalancedPipeline("Sequential"))
+          .ConsumeValueOrDie();
+  TF_ASSERT_OK_AND_ASSIGN(auto pipelines, GetPipelines(module.get()));
+  ASSERT_EQ(pipelines.size(), 1);
+
+  PipelineStageBalancer balancer(GetCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(PipelineBalanceReport report,
+                          balancer.Analyse(pipelines[0]));
+  // Only one of the two IPUs is used at a time.
+  EXPECT_NEAR(report.bubble_fraction, 0.5, 1e-6);
+}
+
+TEST_F(PipelineStageBalancerTest, StashedActivations) {
+  const std::string hlo = R"(
+HloModule top
+
+stage_0 {
+  p0 = f32[16] parameter(0)
+  a = f32[16] add(p0, p0)
+  ROOT t = (f32[16], f32[16]) tuple(a, p0)
+}
+
+stage_1 {
+  p0 = f32[16] parameter(0)
+  m = f32[16] multiply(p0, p0)
+  ROOT t = (f32[16]) tuple(m)
+}
+
+stage_1_bwd {
+  p0 = f32[16] parameter(0)
+  n = f32[16] negate(p0)
+  ROOT t = (f32[16]) tuple(n)
+}
+
+stage_0_bwd {
+  p0 = f32[16] parameter(0)
+  p1 = f32[16] parameter(1)
+  s = f32[16] subtract(p0, p1)
+  ROOT t = (f32[16]) tuple(s)
+}
+
+resource_update {
+  p0 = f32[16] parameter(0)
+  ROOT t = (f32[16]) tuple(p0)
+}
+
+pipeline {
+  p0 = f32[16] parameter(0)
+  s0 = (f32[16], f32[16]) call(p0), to_apply=stage_0, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"0\"}}}"
+  s0_0 = f32[16] get-tuple-element(s0), index=0
+  s0_1 = f32[16] get-tuple-element(s0), index=1
+  fifo = f32[16] custom-call(s0_1), custom_call_target="Fifo", backend_config="{\"depth\":1}"
+  s1 = (f32[16]) call(s0_0), to_apply=stage_1, backend_config="{\"callConfig\":{\"type\":\"PipelineStage\",\"pipelineStageConfig\":{\"stageId\":\"1\"}}}"
+  s1_0 = f32[16] get-tuple-element(s1), index=0
+  b1 = (f32[16]) call(s1_0), to_apply=stage_1_bwd, backend_config="{\"callConfig\":{\"type\":\"PipelineStageBackward\",\"pipelineStageConfig\":{\"stageId\":\"1\"}}}"
+  b1_0 = f32[16] get-tuple-element(b1), index=0
+  b0 = (f32[16]) call(b1_0, fifo), to_apply=stage_0_bwd, backend_config="{\"callConfig\":{\"type\":\"PipelineStageBackward\",\"pipelineStageConfig\":{\"stageId\":\"0\"}}}"
+  b0_0 = f32[16] get-tuple-element(b0), index=0
+  ru = (f32[16]) call(b0_0), to_apply=resource_update, frontend_attributes={CALL_CONFIG_TYPE=ResourceUpdate}, backend_config="{\"callConfig\":{\"type\":\"ResourceUpdate\"}}"
+  ru_0 = f32[16] get-tuple-element(ru), index=0
+  ROOT t = (f32[16]) tuple(ru_0)
+}
+
+ENTRY e {
+  p0 = f32[16] parameter(0)
+  ROOT c = (f32[16]) call(p0), to_apply=pipeline, backend_config="{\"callConfig\":{\"type\":\"Pipeline\",\"pipelineConfig\":{\"schedule\":\"Interleaved\"}}}"
+}
+)";
+  auto module = ParseAndReturnVerifiedModule(hlo).ConsumeValueOrDie();
+  CustomOpReplacer replacer;
+  TF_ASSERT_OK(replacer.Run(module.get()).status());
+  TF_ASSERT_OK_AND_ASSIGN(auto pipelines, GetPipelines(module.get()));
+  ASSERT_EQ(pipelines.size(), 1);
+
+  PipelineStageBalancer balancer(GetCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(PipelineBalanceReport report,
+                          balancer.Analyse(pipelines[0]));
+  ASSERT_EQ(report.stages.size(), 2);
+  EXPECT_GT(report.stages[0].backward_cycles, 0);
+  EXPECT_GT(report.stages[1].backward_cycles, 0);
+  // The input of stage 0 is stored until its backward stage executes.
+  EXPECT_EQ(report.stages[0].stashed_bytes, 16 * 4);
+  EXPECT_EQ(report.stages[1].stashed_bytes, 0);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
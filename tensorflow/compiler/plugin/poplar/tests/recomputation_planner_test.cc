@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/recomputation_planner.h"
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using RecomputationPlannerTest = HloTestBase;
+
+// The broadcast is cheap to recompute and is live while the concatenate, which
+// is the peak, is live.
+const char* const kLongLivedValue = R"(
+HloModule top
+
+ENTRY e {
+  p0 = f32[] parameter(0)
+  e = f32[1024] broadcast(p0), dimensions={}
+  a = f32[1024] add(e, e)
+  b = f32[4096] concatenate(a, a, a, a), dimensions={0}
+  c = f32[1024] slice(b), slice={[0:1024]}
+  ROOT late = f32[1024] add(c, e)
+}
+)";
+
+PipelineStageCostModel GetCostModel() {
+  PipelineStageCostModel cost_model;
+  cost_model.tiles_per_ipu = 1;
+  return cost_model;
+}
+
+TEST_F(RecomputationPlannerTest, PlanReducesThePeak) {
+  auto module =
+      ParseAndReturnVerifiedModule(kLongLivedValue).ConsumeValueOrDie();
+  HloComputation* entry = module->entry_computation();
+
+  RecomputationPlanner planner(21000, GetCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(RecomputationPlan plan, planner.Plan(entry));
+  ASSERT_EQ(plan.recomputed.size(), 1);
+  EXPECT_EQ(plan.recomputed[0]->name(), "e");
+  // The broadcast, the add and the concatenate are live at the peak. Once the
+  // broadcast is recomputed, its parameter is live instead.
+  EXPECT_EQ(plan.max_live_bytes_before, 4096 + 4096 + 4 * 4096);
+  EXPECT_EQ(plan.max_live_bytes_after, 4 + 4096 + 4 * 4096);
+  EXPECT_GT(plan.recomputation_cycles, 0);
+}
+
+TEST_F(RecomputationPlannerTest, SuggestionsAreInserted) {
+  auto module =
+      ParseAndReturnVerifiedModule(kLongLivedValue).ConsumeValueOrDie();
+  HloComputation* entry = module->entry_computation();
+  HloInstruction* e = entry->GetInstructionWithName("e");
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RecomputationPlanner(21000, GetCostModel())
+                              .Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  // Only the broadcast is recomputed.
+  ASSERT_EQ(e->user_count(), 1);
+  EXPECT_TRUE(IsPoplarInstruction(PoplarOp::SuggestRecompute)(e->users()[0]));
+  EXPECT_TRUE(IsPoplarInstruction(PoplarOp::BlockRecompute)(e->operand(0)));
+  EXPECT_EQ(e->operand(0)->operand(0)->name(), "p0");
+  for (const char* name : {"a", "late"}) {
+    EXPECT_TRUE(IsPoplarInstruction(PoplarOp::SuggestRecompute)(
+        entry->GetInstructionWithName(name)->operand(1)));
+  }
+}
+
+TEST_F(RecomputationPlannerTest, TargetAlreadyMet) {
+  auto module =
+      ParseAndReturnVerifiedModule(kLongLivedValue).ConsumeValueOrDie();
+
+  RecomputationPlanner planner(1 << 20, GetCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(RecomputationPlan plan,
+                          planner.Plan(module->entry_computation()));
+  EXPECT_TRUE(plan.recomputed.empty());
+  EXPECT_EQ(plan.max_live_bytes_before, plan.max_live_bytes_after);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, planner.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(RecomputationPlannerTest, Disabled) {
+  auto module =
+      ParseAndReturnVerifiedModule(kLongLivedValue).ConsumeValueOrDie();
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RecomputationPlanner(0).Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -0,0 +1,132 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/passes/remote_buffer_offload.h"
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/custom_ops/remote_parameter.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/matcher_predicates.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/util.h"
+#include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using RemoteBufferOffloadTest = HloTestBase;
+
+// The post order is p0, a, x, y1, y2, y3, r, so `a` is idle while y1, y2 and
+// y3 are computed, which is where the most bytes are live.
+const char* const kIdleValueHlo = R"(
+HloModule top
+
+ENTRY top {
+  p0 = f32[1024] parameter(0)
+  a = f32[1024] log(p0)
+  x = f32[1024] exponential(a)
+  y1 = f32[1024] sine(x)
+  y2 = f32[1024] cosine(y1)
+  y3 = f32[1024] tanh(y2)
+  ROOT r = f32[1024] add(y3, a)
+}
+)";
+
+TEST_F(RemoteBufferOffloadTest, OffloadIdleValue) {
+  auto module = ParseAndReturnVerifiedModule(kIdleValueHlo).ValueOrDie();
+  HloComputation* comp = module->entry_computation();
+
+  RemoteBufferOffload offload(/*remote_memory_supported=*/true,
+                              /*minimum_remote_tensor_size=*/1024,
+                              /*minimum_idle_instructions=*/3);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, offload.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  HloInstruction* a = FindInstruction(module.get(), "a");
+  HloInstruction* x = FindInstruction(module.get(), "x");
+  HloInstruction* y1 = FindInstruction(module.get(), "y1");
+  HloInstruction* y3 = FindInstruction(module.get(), "y3");
+
+  // The use before the idle interval is unchanged.
+  EXPECT_EQ(x->operand(0), a);
+
+  // The use after the idle interval loads the value from remote memory.
+  const HloInstruction* loaded = comp->root_instruction()->operand(1);
+  EXPECT_EQ(loaded->opcode(), HloOpcode::kReshape);
+  const HloInstruction* load = loaded->operand(0);
+  EXPECT_TRUE(IsPoplarInstruction(PoplarOp::BufferLoadSlice)(load));
+  const HloInstruction* store = load->operand(0);
+  EXPECT_TRUE(IsPoplarInstruction(PoplarOp::BufferStoreSlice)(store));
+  const HloInstruction* buffer = store->operand(0);
+  EXPECT_TRUE(IsPoplarInstruction(PoplarOp::CreateBuffer)(buffer));
+  EXPECT_TRUE(Cast<HloCreateBuffer>(buffer)->IsRemoteBuffer());
+  EXPECT_EQ(store->operand(1)->operand(0), a);
+
+  // The store happens before and the load after the idle interval.
+  EXPECT_THAT(store->control_successors(), ::testing::ElementsAre(y1));
+  EXPECT_THAT(load->control_predecessors(), ::testing::ElementsAre(y3));
+}
+
+TEST_F(RemoteBufferOffloadTest, ShortIdleInterval) {
+  auto module = ParseAndReturnVerifiedModule(kIdleValueHlo).ValueOrDie();
+
+  RemoteBufferOffload offload(/*remote_memory_supported=*/true,
+                              /*minimum_remote_tensor_size=*/1024,
+                              /*minimum_idle_instructions=*/4);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, offload.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(RemoteBufferOffloadTest, SmallValue) {
+  auto module = ParseAndReturnVerifiedModule(kIdleValueHlo).ValueOrDie();
+
+  RemoteBufferOffload offload(/*remote_memory_supported=*/true,
+                              /*minimum_remote_tensor_size=*/8192,
+                              /*minimum_idle_instructions=*/3);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, offload.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(RemoteBufferOffloadTest, NotIdleAtPeak) {
+  // `a` is idle while y1 and y2 are computed, but the most bytes are live
+  // when z is computed.
+  const char* const hlo = R"(
+HloModule top
+
+ENTRY top {
+  p0 = f32[1024] parameter(0)
+  a = f32[1024] log(p0)
+  x = f32[1024] exponential(a)
+  y1 = f32[1024] sine(x)
+  y2 = f32[1024] cosine(y1)
+  b = f32[1024] add(y2, a)
+  z = f32[8,1024] broadcast(b), dimensions={1}
+  ROOT r = f32[8,1024] tanh(z)
+}
+)";
+  auto module = ParseAndReturnVerifiedModule(hlo).ValueOrDie();
+
+  RemoteBufferOffload offload(/*remote_memory_supported=*/true,
+                              /*minimum_remote_tensor_size=*/1024,
+                              /*minimum_idle_instructions=*/2);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, offload.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -623,6 +623,77 @@ ENTRY top {
   module->VerifyOrAddFailure("module should be valid after pass");
 }
 
+TEST_F(RemoteParameterParallelCombinerTest, TestPrefetch) {
+  const auto hlo_string = R"(
+HloModule top
+
+ENTRY top {
+  arg1 = f32[1] parameter(0)
+  arg2 = f32[2] parameter(1)
+  arg3 = f32[3] parameter(2)
+
+  const1 = f32[1] constant({1})
+  const2 = f32[2] constant({1, 1})
+  const3 = f32[3] constant({1, 1, 1})
+
+  load1 = f32[1] custom-call(arg1), custom_call_target="RemoteParameterLoad", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+  load2 = f32[2] custom-call(arg2), custom_call_target="RemoteParameterLoad", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+  load3 = f32[3] custom-call(arg3), custom_call_target="RemoteParameterLoad", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+
+  add1 = f32[1] add(load1, const1), sharding={maximal device=0}
+  add2 = f32[2] add(load2, const2), sharding={maximal device=0}
+  add3 = f32[3] add(load3, const3), sharding={maximal device=0}
+
+  store1 = f32[1] custom-call(arg1, add1), custom_call_target="RemoteParameterStore", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+  store2 = f32[2] custom-call(arg2, add2), custom_call_target="RemoteParameterStore", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+  store3 = f32[3] custom-call(arg3, add3), custom_call_target="RemoteParameterStore", backend_config="{\"replication_factor\":1}\n", sharding={maximal device=0}
+
+  ROOT %tuple = (f32[1], f32[2], f32[3]) tuple(store1, store2, store3)
+}
+  )";
+
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsForTest());
+
+  auto module_or_status = ParseAndReturnVerifiedModule(hlo_string, config);
+  EXPECT_TRUE(module_or_status.ok());
+
+  auto* module = module_or_status.ValueOrDie().get();
+
+  CustomOpReplacer custom_op_replacer;
+  EXPECT_TRUE(custom_op_replacer.Run(module).ValueOrDie());
+  EXPECT_TRUE(InplaceFinder().Run(module).ValueOrDie());
+
+  // Only the second load fits in the prefetch size.
+  TensorAllocationMap allocation_map;
+  ASSERT_TRUE(RemoteParameterParallelCombiner(allocation_map, 8)
+                  .RunOnComputation(module->entry_computation())
+                  .ValueOrDie());
+
+  auto* comp = module->entry_computation();
+  const auto* add1 = FindInstruction(module, "add1");
+  const auto* add2 = FindInstruction(module, "add2");
+  const auto* load2 = FindInstruction(module, "load2");
+  const auto* load3 = FindInstruction(module, "load3");
+  const auto* store1 = FindInstruction(module, "store1");
+  const auto* store2 = FindInstruction(module, "store2");
+
+  // The second load is scheduled before the first weight update, and after
+  // nothing else.
+  EXPECT_TRUE(absl::c_linear_search(add1->control_predecessors(), load2));
+  EXPECT_TRUE(load2->control_predecessors().empty());
+
+  // The third load is not prefetched, so it waits for the second store.
+  EXPECT_FALSE(absl::c_linear_search(add2->control_predecessors(), load3));
+  EXPECT_TRUE(absl::c_linear_search(load3->control_predecessors(), store2));
+  EXPECT_FALSE(absl::c_linear_search(load3->control_predecessors(), store1));
+
+  // All the loads, stores and weight updates are still in the computation.
+  EXPECT_EQ(absl::c_count_if(comp->instructions(), is_load), 3);
+  EXPECT_EQ(absl::c_count_if(comp->instructions(), is_store), 3);
+  module->VerifyOrAddFailure("module should be valid after pass");
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
@@ -269,6 +269,8 @@ struct ResourceUpdateElementwiseClusteringTestSpec {
   int expected_all_gathers;
   // These are all-gathers which are not arguments to the root instruction.
   int expected_non_root_all_gathers;
+  // These are all-reduces which are only used by a cluster.
+  int expected_reduce_scatters = 0;
 };
 
 std::ostream& operator<<(
@@ -277,6 +279,7 @@ std::ostream& operator<<(
             << ", offloads: " << spec.expected_offloads
             << ", all-gathers: " << spec.expected_all_gathers
             << ", non-root-all-gathers: " << spec.expected_non_root_all_gathers
+            << ", reduce-scatters: " << spec.expected_reduce_scatters
             << "}";
 }
 
@@ -292,13 +295,13 @@ INSTANTIATE_TEST_SUITE_P(
                         ResourceUpdateElementwiseClusteringTestSpec>{
         // Simple HLO with all types of the inputs
         {GetSimpleHloString(20, 100), "simple", false, 2, 2, 2},
-        {GetSimpleHloString(20, 100), "simple", true, 2, 0, 0},
+        {GetSimpleHloString(20, 100), "simple", true, 2, 0, 0, 2},
         // Edge case
         {GetSimpleHloString(1, 1), "1x1", false, 2, 2, 2},
-        {GetSimpleHloString(1, 1), "1x1", true, 2, 0, 0},
+        {GetSimpleHloString(1, 1), "1x1", true, 2, 0, 0, 2},
         // Check padded offloading:
         {GetSimpleHloString(11, 13), "simple-padded", false, 2, 2, 2},
-        {GetSimpleHloString(11, 13), "simple-padded", true, 2, 0, 0},
+        {GetSimpleHloString(11, 13), "simple-padded", true, 2, 0, 0, 2},
         // Two cluster share the same inputs
         {GetTwoClustersShareInputHloString(20, 100), "2-clusters", false, 2, 2,
          2},
@@ -308,13 +311,14 @@ INSTANTIATE_TEST_SUITE_P(
         {GetAdamLikeHloString(20, 100), "adam", false, 2, 2, 2},
         // We still have to do all-gathers, but they all are operands to root
         // instruction
-        {GetAdamLikeHloString(20, 100), "adam", true, 2, 2, 0},
+        {GetAdamLikeHloString(20, 100), "adam", true, 2, 2, 0, 1},
         // Momentum-like resource update
         {GetMomentumLikeHloString(1000, 20), "momentum", false, 2, 2, 2},
-        {GetMomentumLikeHloString(1000, 20), "momentum", true, 2, 2, 0},
+        {GetMomentumLikeHloString(1000, 20), "momentum", true, 2, 2, 0,
+         1},
         // SGD-like resource update
         {GetSGDHloString(1000, 20), "sgd", false, 2, 2, 2},
-        {GetSGDHloString(1000, 20), "sgd", true, 2, 0, 0},
+        {GetSGDHloString(1000, 20), "sgd", true, 2, 0, 0, 2},
         // Test with one of the arguments be non-replicated remote buffer.
         {GetFullRemoteLoadHloString(100, 20), "full-remote-load", false, 4, 2,
          2},
@@ -389,6 +393,9 @@ TEST_P(ResourceUpdateElementwiseClusteringTest, DoTest) {
   };
   EXPECT_EQ(absl::c_count_if(insts, IsNonRootAllGather),
             param.expected_non_root_all_gathers);
+  EXPECT_EQ(
+      absl::c_count_if(insts, IsPoplarInstruction(PoplarOp::ReduceScatter)),
+      param.expected_reduce_scatters);
 }
 
 }  // namespace
@@ -0,0 +1,146 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import numpy as np
+
+from tensorflow.compiler.tests import xla_test
+from tensorflow.compiler.plugin.poplar.tests.test_utils import ReportJSON
+from tensorflow.python import ipu
+from tensorflow.python.platform import googletest
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import variables
+
+dataType = np.float32
+
+batch_size = 4
+num_input = 16
+timesteps = 32
+num_hidden = 64
+time_step_buckets = [8, 16, 32]
+
+# The sequence length distributions of the batches which are benchmarked.
+short_lengths = [2, 5, 8, 3]
+mixed_lengths = [2, 5, 16, 3]
+long_lengths = [32, 5, 8, 3]
+
+
+def _initializers():
+  return dict(weights_initializer=init_ops.constant_initializer(
+      0.01, dtype=dataType),
+              bias_initializer=init_ops.constant_initializer(0.1,
+                                                             dtype=dataType))
+
+
+def _PopnnLSTM(x, seq_len):
+  lstm = ipu.ops.rnn_ops.PopnnLSTM(num_hidden,
+                                   dtype=dataType,
+                                   **_initializers())
+  outputs, state = lstm(x,
+                        training=False,
+                        seq_len=seq_len,
+                        time_step_buckets=time_step_buckets)
+  return outputs, state.h
+
+
+def _PopnnGRU(x, seq_len):
+  gru = ipu.ops.rnn_ops.PopnnGRU(num_hidden, dtype=dataType, **_initializers())
+  return gru(x,
+             training=False,
+             seq_len=seq_len,
+             time_step_buckets=time_step_buckets)
+
+
+def _PopnnLSTMPerExample(x):
+  lstm = ipu.ops.rnn_ops.PopnnLSTM(num_hidden,
+                                   dtype=dataType,
+                                   **_initializers())
+  outputs, state = lstm(x, training=False)
+  return outputs, state.h
+
+
+def _PopnnGRUPerExample(x):
+  gru = ipu.ops.rnn_ops.PopnnGRU(num_hidden, dtype=dataType, **_initializers())
+  return gru(x, training=False)
+
+
+class RnnSeqLenSpeedTest(xla_test.XLATestCase):
+  def RunLayer(self, layer_func, x, seq_len):
+    with self.session() as sess:
+      with ops.device('cpu'):
+        px = array_ops.placeholder(dataType, shape=x.shape)
+        pl = array_ops.placeholder(np.int32, shape=[batch_size])
+      with ipu.scopes.ipu_scope("/device:IPU:0"):
+        r = ipu.ipu_compiler.compile(layer_func, inputs=[px, pl])
+
+      report = ReportJSON(self, sess)
+
+      sess.run(variables.global_variables_initializer())
+      report.reset()
+      result = sess.run(r, {px: x, pl: seq_len})
+      report.parse_log()
+      # The simulated cycles of the IPU model execution.
+      cycles = report.get_execution_reports()[-1]["simulation"]["cycles"]
+    return (cycles, result)
+
+  def RunReference(self, layer_func, x, seq_len):
+    # Each example on its own, with the padding removed.
+    outputs = np.zeros([timesteps, batch_size, num_hidden], dtype=dataType)
+    states = np.zeros([batch_size, num_hidden], dtype=dataType)
+    for b, length in enumerate(seq_len):
+      with self.session() as sess:
+        with ops.device('cpu'):
+          px = array_ops.placeholder(dataType, shape=[length, 1, num_input])
+        with ipu.scopes.ipu_scope("/device:IPU:0"):
+          r = ipu.ipu_compiler.compile(layer_func, inputs=[px])
+        sess.run(variables.global_variables_initializer())
+        output, state = sess.run(r, {px: x[:length, b:b + 1]})
+        outputs[:length, b] = output[:, 0]
+        states[b] = state[0]
+    return outputs, states
+
+  def BenchmarkLayer(self, layer_func, reference_func):
+    np.random.seed(42)
+    x = np.random.rand(timesteps, batch_size, num_input).astype(dataType)
+
+    cycles = []
+    for seq_len in [short_lengths, mixed_lengths, long_lengths]:
+      c, result = self.RunLayer(layer_func, x, seq_len)
+      outputs, states = self.RunReference(reference_func, x, seq_len)
+      self.assertAllClose(result[0], outputs)
+      self.assertAllClose(result[1], states)
+      print("Sequence lengths %s: %d cycles" % (seq_len, c))
+      cycles.append(c)
+
+    # Batches with shorter sequences skip more of the time steps.
+    self.assertLess(cycles[0], cycles[1])
+    self.assertLess(cycles[1], cycles[2])
+
+  def testLSTMSkipsPaddedTimeSteps(self):
+    self.BenchmarkLayer(_PopnnLSTM, _PopnnLSTMPerExample)
+
+  def testGRUSkipsPaddedTimeSteps(self):
+    self.BenchmarkLayer(_PopnnGRU, _PopnnGRUPerExample)
+
+
+if __name__ == "__main__":
+  os.environ['TF_XLA_FLAGS'] = ('--tf_xla_min_cluster_size=1 ' +
+                                os.environ.get('TF_XLA_FLAGS', ''))
+  googletest.main()
@@ -125,6 +125,63 @@ class SyntheticDataWithOutfeeds(xla_test.XLATestCase):
         result = sess.run(dequeue_outfeed)
         self.assertAllEqual(len(result['d1']), 0)
 
+  def testSyntheticDataForSomeFeeds(self):
+    poplar_flags = os.environ.get("TF_POPLAR_FLAGS", "")
+    poplar_flags += " --use_ipu_model"
+    poplar_flags += " --use_synthetic_data"
+    poplar_flags += " --synthetic_data_categories=outfeed"
+    poplar_flags += " --synthetic_data_feeds=outfeed3a"
+
+    with test.mock.patch.dict("os.environ", {"TF_POPLAR_FLAGS": poplar_flags}):
+
+      # The device side main
+      def body(x1, x2):
+        d1 = x1 + x2
+        d2 = x1 - x2
+        outfeed_a = outfeed_queue_a.enqueue({'d1': d1})
+        outfeed_b = outfeed_queue_b.enqueue({'d2': d2, 'd1': d1})
+        return outfeed_a, outfeed_b
+
+      def my_net():
+        r = loops.repeat(5, body, [], infeed_queue)
+        return r
+
+      with ops.device('cpu'):
+        # The dataset for feeding the graphs
+        ds = tf.data.Dataset.from_tensors(tf.constant(1.0, shape=[10]))
+        ds = ds.map(lambda x: [x, x])
+        ds = ds.repeat()
+
+        # The host side queues
+        infeed_queue = ipu_infeed_queue.IPUInfeedQueue(ds, feed_name="infeed3")
+        outfeed_queue_a = ipu_outfeed_queue.IPUOutfeedQueue(
+            feed_name="outfeed3a")
+        outfeed_queue_b = ipu_outfeed_queue.IPUOutfeedQueue(
+            feed_name="outfeed3b")
+
+      with scopes.ipu_scope('/device:IPU:0'):
+        run_loop = ipu_compiler.compile(my_net, inputs=[])
+
+      # The outfeed dequeue has to happen after the outfeed enqueue
+      dequeue_outfeed_a = outfeed_queue_a.dequeue()
+      dequeue_outfeed_b = outfeed_queue_b.dequeue()
+
+      # Configure the hardware
+      config = utils.create_ipu_config()
+      config = utils.auto_select_ipus(config, 1)
+      utils.configure_ipu_system(config)
+
+      with tf.Session() as sess:
+        sess.run(infeed_queue.initializer)
+        sess.run(run_loop)
+        # Only the first outfeed uses synthetic data, the infeed and the
+        # second outfeed are transferred.
+        result_a = sess.run(dequeue_outfeed_a)
+        self.assertAllEqual(len(result_a['d1']), 0)
+        result_b = sess.run(dequeue_outfeed_b)
+        self.assertAllEqual(len(result_b['d1']), 5)
+        self.assertAllEqual(np.full([10], 2.0), result_b['d1'][0])
+
 
 if __name__ == "__main__":
   os.environ['TF_XLA_FLAGS'] = ('--tf_xla_min_cluster_size=1' +
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/plugin/poplar/driver/schedulers/tile_memory_estimator.h"
+
+#include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace poplarplugin {
+namespace {
+
+using TileMemoryEstimatorTest = HloTestBase;
+
+TileMemoryModel GetModel(int64 tiles_per_ipu) {
+  TileMemoryModel model;
+  model.tiles_per_ipu = tiles_per_ipu;
+  return model;
+}
+
+TEST_F(TileMemoryEstimatorTest, TileMappedBytes) {
+  const TileMemoryModel model = GetModel(1216);
+  // Small tensors are padded to a grain on a single tile.
+  EXPECT_EQ(EstimateTileMappedBytes(ShapeUtil::MakeShape(F32, {}), model), 8);
+  EXPECT_EQ(EstimateTileMappedBytes(ShapeUtil::MakeShape(F32, {3}), model),
+            16);
+  // Medium tensors are spread over as many tiles as fit the minimum size.
+  EXPECT_EQ(EstimateTileMappedBytes(ShapeUtil::MakeShape(F32, {1024}), model),
+            4096);
+  // Large tensors are spread over all the tiles.
+  EXPECT_EQ(
+      EstimateTileMappedBytes(ShapeUtil::MakeShape(F32, {1216 * 64}), model),
+      1216 * 256);
+  EXPECT_EQ(EstimateTileMappedBytes(
+                ShapeUtil::MakeShape(F16, {1216 * 64 + 1}), model),
+            1216 * 136);
+  // The elements of a tuple are separate buffers.
+  EXPECT_EQ(EstimateTileMappedBytes(
+                ShapeUtil::MakeTupleShape({ShapeUtil::MakeShape(F32, {1024})}),
+                model),
+            0);
+}
+
+TEST_F(TileMemoryEstimatorTest, BusiestIpu) {
+  const char* const hlo = R"(
+HloModule top
+
+ENTRY e {
+  p0 = f32[64] parameter(0), sharding={maximal device=0}
+  p1 = f32[1024] parameter(1), sharding={maximal device=1}
+  a = f32[64] sine(p0), sharding={maximal device=0}
+  b = f32[1024] cosine(p1), sharding={maximal device=1}
+  ROOT t = (f32[64], f32[1024]) tuple(a, b), sharding={{maximal device=0}, {maximal device=1}}
+}
+)";
+  auto module = ParseAndReturnVerifiedModule(hlo).ConsumeValueOrDie();
+  HloComputation* entry = module->entry_computation();
+  const HloInstructionSequence sequence(entry->MakeInstructionPostOrder());
+
+  const TileMemoryModel model = GetModel(4);
+  absl::flat_hash_map<const HloComputation*, int64> memory_by_computation;
+  TF_ASSERT_OK_AND_ASSIGN(
+      int64 bytes, CreateTileMemoryEstimator(model)(
+                       *entry, sequence, CreateTileMemorySizeFunction(model),
+                       memory_by_computation));
+  // The parameter and the output of the second IPU are spread over its 4
+  // tiles.
+  EXPECT_EQ(bytes, 2 * 4096 / 4);
+}
+
+}  // namespace
+}  // namespace poplarplugin
+}  // namespace xla
@@ -133,6 +133,39 @@ class ArgTopK(xla_test.XLATestCase, parameterized.TestCase):
 
     self.assertAllClose(cpu_result, ipu_result)
 
+  @parameterized.named_parameters(
+      {"testcase_name": "float32", "dtype": np.float32},
+      {"testcase_name": "int32", "dtype": np.int32})
+  def testTopKLongRows(self, dtype):
+    # The rows are long enough to be split into chunks, and the candidates
+    # selected from the chunks are split again.
+    def model(a):
+      return nn.top_k(a, k=100, sorted=True)
+
+    with ops.device('cpu'):
+      pa = array_ops.placeholder(dtype, [3, 100003])
+
+    with ops.device("/device:IPU:0"):
+      out = model(pa)
+
+    tu.configure_ipu_system()
+
+    # Unique values, so that the indices do not depend on how ties are broken.
+    input = np.stack(
+        [np.random.permutation(100003).astype(dtype) for _ in range(3)])
+    with self.session() as sess:
+      fd = {pa: input}
+      ipu_result = sess.run(out, fd)
+
+    with ops.device("/device:CPU:0"):
+      out = model(pa)
+
+    with self.session() as sess:
+      fd = {pa: input}
+      cpu_result = sess.run(out, fd)
+
+    self.assertAllClose(cpu_result, ipu_result)
+
 
 if __name__ == "__main__":
   os.environ['TF_XLA_FLAGS'] = ('--tf_xla_min_cluster_size=1 ' +
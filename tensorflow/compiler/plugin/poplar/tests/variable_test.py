@@ -646,11 +646,23 @@ class IpuXlaVariableTest(xla_test.XLATestCase):
       report.assert_host_to_device_event_names(
           [], "Weights/biases/inputs should not be downloaded at all")
 
-      # Note all weights are fetched as a group
+      # Only the fetched weights are copied back, w2 stays on the device
       report.assert_device_to_host_event_names(
-          [w1_ul, w2_ul],
+          [w1_ul],
           "Weights/biases should be uploaded once (explicitly fetched)")
 
+      # The weights are still on the device, so they are not downloaded again
+      sess.run([train, loss], {x: np.array([[1, 2, 3, 4]], dtype=np.float32)})
+      sess.run(w2)
+
+      report.parse_log()
+
+      report.assert_host_to_device_event_names(
+          [], "Weights/biases should stay on the device after a fetch")
+
+      report.assert_device_to_host_event_names(
+          [w2_ul], "Only the fetched weights should be uploaded")
+
   def testTuplesOfTuplesAreStreamed(self):
     with self.session() as sess:
       with ops.device("/device:IPU:0"):
@@ -723,6 +735,31 @@ class IpuXlaVariableTest(xla_test.XLATestCase):
           [], "w should be copied to device once and "
           "that should be the only io event")
 
+  def testUpdateOfFedValueDoesNotChangeTheFeed(self):
+    # The fed host tensor is used in place of a copy on the device, until the
+    # variable which is assigned it is updated.
+    with self.session() as sess:
+      with ops.device("/device:IPU:0"):
+        with variable_scope.variable_scope("vs", use_resource=True):
+          v = variable_scope.get_variable(
+              "v",
+              shape=[4],
+              dtype=np.float32,
+              initializer=init_ops.constant_initializer(0))
+        px = array_ops.placeholder(np.float32, shape=[4])
+        assign = state_ops.assign(v, px)
+        update = state_ops.assign_add(v, [1, 1, 1, 1])
+
+      sess.run(variables.global_variables_initializer())
+
+      x = np.array([1, 2, 3, 4], dtype=np.float32)
+      sess.run(assign, {px: x})
+      self.assertAllClose(sess.run(v), [1, 2, 3, 4])
+      for _ in range(2):
+        sess.run(update)
+      self.assertAllClose(sess.run(v), [3, 4, 5, 6])
+      self.assertAllClose(x, [1, 2, 3, 4])
+
 
 if __name__ == "__main__":
   os.environ['TF_XLA_FLAGS'] = ('--tf_xla_min_cluster_size=1 ' +
@@ -660,6 +660,127 @@ ENTRY entry {
   EXPECT_EQ(result, 251);
 }
 
+TEST_F(WhileLoopToRepeatSimplifyTest, LargeTripCountWithStep) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithWhile
+
+body {
+  p_body = (s32[],s32[]) parameter(0)
+  p_body.0 = s32[] get-tuple-element(p_body), index=0
+  const = s32[] constant(3)
+  add = s32[] add(const, p_body.0)
+  p_body.1 = s32[] get-tuple-element(p_body), index=1
+  ROOT root = (s32[],s32[]) tuple(add, p_body.1)
+}
+
+condition {
+  p_cond = (s32[],s32[]) parameter(0)
+  p_cond.0 = s32[] get-tuple-element(p_cond), index=0
+  const = s32[] constant(100000)
+  ROOT result = pred[] compare(p_cond.0, const), direction=LT
+}
+
+ENTRY entry {
+  const_0 = s32[] constant(0)
+  const_1 = s32[] parameter(0)
+  repeat_init = (s32[],s32[]) tuple(const_0, const_1)
+  ROOT while = (s32[],s32[]) while(repeat_init), condition=condition, body=body
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloPassFix<WhileLoopToRepeatSimplify> wltrs;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, wltrs.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  auto* root = module.get()->entry_computation()->root_instruction();
+  TF_ASSERT_OK_AND_ASSIGN(PoplarBackendConfig cfg,
+                          root->backend_config<PoplarBackendConfig>());
+  ASSERT_EQ(cfg.call_config().type(),
+            PoplarBackendConfig::CallConfig::RepeatLoop);
+  ASSERT_EQ(cfg.call_config().repeat_config().repeat_count(), 33334);
+}
+
+TEST_F(WhileLoopToRepeatSimplifyTest, DecrementWithEvaluatedInit) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithWhile
+
+body {
+  p_body = (s32[],s32[]) parameter(0)
+  p_body.0 = s32[] get-tuple-element(p_body), index=0
+  const = s32[] constant(5)
+  sub = s32[] subtract(p_body.0, const)
+  p_body.1 = s32[] get-tuple-element(p_body), index=1
+  ROOT root = (s32[],s32[]) tuple(sub, p_body.1)
+}
+
+condition {
+  p_cond = (s32[],s32[]) parameter(0)
+  p_cond.0 = s32[] get-tuple-element(p_cond), index=0
+  const = s32[] constant(10)
+  ROOT result = pred[] compare(const, p_cond.0), direction=LT
+}
+
+ENTRY entry {
+  const_a = s32[] constant(1000)
+  const_b = s32[] constant(500)
+  init = s32[] add(const_a, const_b)
+  const_1 = s32[] parameter(0)
+  repeat_init = (s32[],s32[]) tuple(init, const_1)
+  ROOT while = (s32[],s32[]) while(repeat_init), condition=condition, body=body
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloPassFix<WhileLoopToRepeatSimplify> wltrs;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, wltrs.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  auto* root = module.get()->entry_computation()->root_instruction();
+  TF_ASSERT_OK_AND_ASSIGN(PoplarBackendConfig cfg,
+                          root->backend_config<PoplarBackendConfig>());
+  ASSERT_EQ(cfg.call_config().type(),
+            PoplarBackendConfig::CallConfig::RepeatLoop);
+  ASSERT_EQ(cfg.call_config().repeat_config().repeat_count(), 298);
+}
+
+TEST_F(WhileLoopToRepeatSimplifyTest, InductionVariableWrapsAround) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithWhile
+
+body {
+  p_body = (s8[],s32[]) parameter(0)
+  p_body.0 = s8[] get-tuple-element(p_body), index=0
+  const = s8[] constant(2)
+  add = s8[] add(p_body.0, const)
+  p_body.1 = s32[] get-tuple-element(p_body), index=1
+  ROOT root = (s8[],s32[]) tuple(add, p_body.1)
+}
+
+condition {
+  p_cond = (s8[],s32[]) parameter(0)
+  p_cond.0 = s8[] get-tuple-element(p_cond), index=0
+  const = s8[] constant(127)
+  ROOT result = pred[] compare(p_cond.0, const), direction=LT
+}
+
+ENTRY entry {
+  const_0 = s8[] constant(0)
+  const_1 = s32[] parameter(0)
+  repeat_init = (s8[],s32[]) tuple(const_0, const_1)
+  ROOT while = (s8[],s32[]) while(repeat_init), condition=condition, body=body
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloPassFix<WhileLoopToRepeatSimplify> wltrs;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, wltrs.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
 TEST_F(WhileLoopToRepeatSimplifyTest, MultipleLoops) {
   const char* const hlo_string = R"(
 HloModule ModuleWithWhile
@@ -837,6 +958,90 @@ ENTRY entry {
   EXPECT_EQ(module->computation_count(), 3);
 }
 
+TEST_F(WhileLoopToRepeatSimplifyTest, RuntimeCount) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithWhile
+
+body {
+  p_body = (s32[],s32[],f32[]) parameter(0)
+  p_body.0 = s32[] get-tuple-element(p_body), index=0
+  const = s32[] constant(1)
+  add = s32[] add(p_body.0, const)
+  p_body.1 = s32[] get-tuple-element(p_body), index=1
+  p_body.2 = f32[] get-tuple-element(p_body), index=2
+  neg = f32[] negate(p_body.2)
+  ROOT root = (s32[],s32[],f32[]) tuple(add, p_body.1, neg)
+}
+
+condition {
+  p_cond = (s32[],s32[],f32[]) parameter(0)
+  p_cond.0 = s32[] get-tuple-element(p_cond), index=0
+  p_cond.1 = s32[] get-tuple-element(p_cond), index=1
+  ROOT result = pred[] compare(p_cond.0, p_cond.1), direction=LT
+}
+
+ENTRY entry {
+  const_0 = s32[] constant(0)
+  count = s32[] parameter(0)
+  x = f32[] parameter(1)
+  repeat_init = (s32[],s32[],f32[]) tuple(const_0, count, x)
+  ROOT while = (s32[],s32[],f32[]) while(repeat_init), condition=condition, body=body
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloPassFix<WhileLoopToRepeatSimplify> wltrs;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, wltrs.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  // The count is an input of the loop.
+  auto* root = module->entry_computation()->root_instruction();
+  ASSERT_TRUE(IsRepeatLoop(root));
+  EXPECT_TRUE(HasRuntimeRepeatCount(root));
+  EXPECT_EQ(GetRuntimeRepeatCountIndex(root), 1);
+  EXPECT_EQ(root->operand(1)->opcode(), HloOpcode::kParameter);
+  // The counter is still incremented, as its final value is not known.
+  EXPECT_EQ(root->to_apply()->root_instruction()->operand(0)->opcode(),
+            HloOpcode::kAdd);
+}
+
+TEST_F(WhileLoopToRepeatSimplifyTest, RuntimeCountChangedByTheLoop) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithWhile
+
+body {
+  p_body = (s32[],s32[]) parameter(0)
+  p_body.0 = s32[] get-tuple-element(p_body), index=0
+  const = s32[] constant(1)
+  add = s32[] add(p_body.0, const)
+  p_body.1 = s32[] get-tuple-element(p_body), index=1
+  sub = s32[] subtract(p_body.1, const)
+  ROOT root = (s32[],s32[]) tuple(add, sub)
+}
+
+condition {
+  p_cond = (s32[],s32[]) parameter(0)
+  p_cond.0 = s32[] get-tuple-element(p_cond), index=0
+  p_cond.1 = s32[] get-tuple-element(p_cond), index=1
+  ROOT result = pred[] compare(p_cond.0, p_cond.1), direction=LT
+}
+
+ENTRY entry {
+  const_0 = s32[] constant(0)
+  count = s32[] parameter(0)
+  repeat_init = (s32[],s32[]) tuple(const_0, count)
+  ROOT while = (s32[],s32[]) while(repeat_init), condition=condition, body=body
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  HloPassFix<WhileLoopToRepeatSimplify> wltrs;
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, wltrs.Run(module.get()));
+  EXPECT_FALSE(changed);
+}
+
 }  // namespace
 }  // namespace poplarplugin
 }  // namespace xla
@@ -12,14 +12,25 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
+#include "absl/memory/memory.h"
+
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_iterator.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/infeed_statistics.h"
+#include "tensorflow/compiler/plugin/poplar/driver/tools/parallel_copy.h"
+
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/util/command_line_flags.h"
 
 #include "tensorflow/core/common_runtime/data/standalone.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function_handle_cache.h"
@@ -29,6 +40,9 @@ limitations under the License.
 tensorflow::string FLAGS_graphdef;
 tensorflow::string FLAGS_ret_val_input_name;
 int FLAGS_count = 1000;
+bool FLAGS_infeed = false;
+int FLAGS_infeed_elements = 10000;
+int FLAGS_infeed_copy_threads = 4;
 
 namespace tensorflow {
 namespace data {
@@ -47,6 +61,115 @@ static void BuildRetvalNode(GraphDef& graph_def) {
   AddNodeAttr("index", 0, ret_def);
 }
 
+// Pushes the elements of the dataset through infeed queues, the same way the
+// infeed IO thread of the Poplar executor does, and consumes them the same
+// way the infeed stream callbacks do: a prefetch is attempted and when the
+// element is not available yet the consumer blocks in a fetch. There is no
+// device, so the copies go into host buffers.
+static void RunInfeedPipeline(Iterator* iterator) {
+  using xla::poplarplugin::InfeedQueue;
+  using xla::poplarplugin::InfeedStatistics;
+  InfeedStatistics statistics;
+
+  bool end_of_input = false;
+  std::vector<Tensor> outputs;
+  Status s = iterator->GetNext(&outputs, &end_of_input);
+  if (!s.ok() || end_of_input) {
+    std::cerr << "Error fetching the first element: " << s.ToString()
+              << std::endl;
+    return;
+  }
+
+  std::vector<std::unique_ptr<InfeedQueue>> queues(outputs.size());
+  std::vector<std::vector<char>> buffers(outputs.size());
+  for (size_t i = 0; i != outputs.size(); ++i) {
+    queues[i] = absl::make_unique<InfeedQueue>();
+    buffers[i].resize(outputs[i].TotalBytes());
+  }
+
+  std::atomic<bool> cancelled(false);
+  auto push = [&queues](std::vector<Tensor>& element) {
+    for (size_t i = 0; i != element.size(); ++i) {
+      TensorBuffer* tb = DMAHelper::buffer(&element[i]);
+      tb->Ref();
+      queues[i]->BlockPush(tb);
+      queues[i]->AdvanceWritePosition();
+    }
+  };
+  push(outputs);
+
+  std::thread producer([&]() {
+    const xla::poplarplugin::FeedWaitOptions wait_options;
+    while (!cancelled) {
+      if (queues[0]->IsFull()) {
+        queues[0]->WaitUntilNotFull(wait_options, cancelled);
+        continue;
+      }
+      std::vector<Tensor> element;
+      bool end_of_sequence = false;
+      const auto start = InfeedStatistics::Clock::now();
+      Status status = iterator->GetNext(&element, &end_of_sequence);
+      if (!status.ok() || end_of_sequence) {
+        if (!status.ok()) {
+          std::cerr << "Error fetching data: " << status.ToString()
+                    << std::endl;
+        }
+        for (auto& queue : queues) {
+          queue->SignalEndOfQueue();
+        }
+        return;
+      }
+      statistics.RecordProducedElement(start, InfeedStatistics::Clock::now());
+      push(element);
+    }
+  });
+
+  const xla::poplarplugin::ParallelCopier copier(FLAGS_infeed_copy_threads);
+  int num_consumed = 0;
+  for (; num_consumed != FLAGS_infeed_elements; ++num_consumed) {
+    bool end_of_queue = false;
+    for (size_t i = 0; i != queues.size(); ++i) {
+      auto& queue = queues[i];
+      const size_t num_bytes = buffers[i].size();
+      TensorBuffer* tb;
+      statistics.RecordQueueOccupancy(queue->Size());
+      auto start = InfeedStatistics::Clock::now();
+      if (queue->TryPop(tb)) {
+        copier.Copy(buffers[i].data(), tb->data(), num_bytes);
+        statistics.RecordPrefetch(start, InfeedStatistics::Clock::now(),
+                                  num_bytes, true);
+      } else {
+        statistics.RecordPrefetch(start, InfeedStatistics::Clock::now(), 0,
+                                  false);
+        statistics.RecordQueueOccupancy(queue->Size());
+        start = InfeedStatistics::Clock::now();
+        if (!queue->BlockPop(tb)) {
+          end_of_queue = true;
+          break;
+        }
+        copier.Copy(buffers[i].data(), tb->data(), num_bytes);
+        statistics.RecordFetch(start, InfeedStatistics::Clock::now(),
+                               num_bytes);
+      }
+      queue->AdvanceReadPosition();
+    }
+    if (end_of_queue) {
+      break;
+    }
+  }
+
+  cancelled = true;
+  producer.join();
+
+  std::cout << "Consumed " << num_consumed << " elements through the infeed "
+            << "queues." << std::endl;
+  xla::poplarplugin::SPSCQueueStats queue_stats;
+  for (auto& queue : queues) {
+    queue_stats += queue->GetStats();
+  }
+  std::cout << statistics.ToJson(queue_stats) << std::endl;
+}
+
 static void RunInputPipeline(const std::string& graph_as_string) {
   GraphDef graph_def;
   protobuf::TextFormat::ParseFromString(graph_as_string, &graph_def);
@@ -65,6 +188,11 @@ static void RunInputPipeline(const std::string& graph_as_string) {
   std::unique_ptr<Iterator> iterator;
   s = dataset->MakeIterator(&iterator);
 
+  if (FLAGS_infeed) {
+    RunInfeedPipeline(iterator.get());
+    return;
+  }
+
   bool end_of_input = false;
 
   std::chrono::steady_clock::time_point start =
@@ -109,6 +237,16 @@ int main(int argc, char** argv) {
       tensorflow::Flag("output_node", &FLAGS_ret_val_input_name,
                        "Name of the last operation in the input pipeline, to "
                        "be added as input to a _Retval operation"),
+      tensorflow::Flag("infeed", &FLAGS_infeed,
+                       "Push the elements through infeed queues and consume "
+                       "them like the infeed stream callbacks, then print the "
+                       "statistics of each stage"),
+      tensorflow::Flag("infeed_elements", &FLAGS_infeed_elements,
+                       "Number of elements consumed from the infeed queues"),
+      tensorflow::Flag("infeed_copy_threads", &FLAGS_infeed_copy_threads,
+                       "Number of threads copying large elements out of the "
+                       "infeed queues, as the --infeed_copy_threads "
+                       "TF_POPLAR_FLAGS option"),
   };
 
   // Parse the command line for the flags.
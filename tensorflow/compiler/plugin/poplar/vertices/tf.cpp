@@ -19,39 +19,122 @@ limitations under the License.
 #include <poplar/HalfFloat.hpp>
 #include <poplar/Vertex.hpp>
 
+#ifdef __IPU__
+#include <ipu_vector_math>
+#endif
+
 using namespace poplar;
 
 // Simple reductions
 
-#define REDUCTION_ELEMENTWISE(NAME, INIT, EXP)  \
-  template <typename T>                         \
-  class NAME : public Vertex {                  \
-   public:                                      \
-    Input<Vector<T>> a;                         \
-    Output<Vector<T>> out;                      \
-                                                \
-    bool compute() {                            \
-      T v = (INIT);                             \
-                                                \
-      for (unsigned i = 0; i < a.size(); ++i) { \
-        v = (EXP);                              \
-      }                                         \
-                                                \
-      out[0] = v;                               \
-      return true;                              \
-    }                                           \
-  };                                            \
-                                                \
-  template class NAME<float>;                   \
-  template class NAME<half>;                    \
+// The binary operators of the reductions. They are applied to scalars and, on
+// the IPU, to the float2 and half4 vectors.
+struct AddOp {
+  template <typename V>
+  static V apply(V a, V b) {
+    return a + b;
+  }
+};
+
+struct MulOp {
+  template <typename V>
+  static V apply(V a, V b) {
+    return a * b;
+  }
+};
+
+struct MaxOp {
+  template <typename V>
+  static V apply(V a, V b) {
+    return (b > a) ? b : a;
+  }
+#ifdef __IPU__
+  static float2 apply(float2 a, float2 b) { return ipu::fmax(a, b); }
+  static half4 apply(half4 a, half4 b) { return ipu::fmax(a, b); }
+#endif
+};
+
+struct MinOp {
+  template <typename V>
+  static V apply(V a, V b) {
+    return (b < a) ? b : a;
+  }
+#ifdef __IPU__
+  static float2 apply(float2 a, float2 b) { return ipu::fmin(a, b); }
+  static half4 apply(half4 a, half4 b) { return ipu::fmin(a, b); }
+#endif
+};
+
+// The vector type used to reduce each type, with the number of elements in
+// it. Types without one are reduced one element at a time.
+template <typename T>
+struct ReductionVector {
+  using type = T;
+  static constexpr unsigned width = 1;
+};
+
+#ifdef __IPU__
+template <>
+struct ReductionVector<float> {
+  using type = float2;
+  static constexpr unsigned width = 2;
+};
+
+template <>
+struct ReductionVector<half> {
+  using type = half4;
+  static constexpr unsigned width = 4;
+};
+#endif
+
+// The inputs of the reductions are aligned to 8 bytes so that they can be
+// read one vector at a time.
+template <typename T, typename Op>
+T Reduce(const T* a, unsigned size, T init) {
+  using V = typename ReductionVector<T>::type;
+  constexpr unsigned width = ReductionVector<T>::width;
+
+  T v = init;
+  unsigned i = 0;
+  if (width > 1 && size >= width) {
+    const V* a_v = reinterpret_cast<const V*>(a);
+    V acc = a_v[0];
+    for (i = 1; i < size / width; ++i) {
+      acc = Op::apply(acc, a_v[i]);
+    }
+    for (unsigned j = 0; j < width; ++j) {
+      v = Op::apply(v, acc[j]);
+    }
+    i *= width;
+  }
+
+  for (; i < size; ++i) {
+    v = Op::apply(v, a[i]);
+  }
+  return v;
+}
+
+#define REDUCTION_ELEMENTWISE(NAME, INIT, OP)          \
+  template <typename T>                                \
+  class NAME : public Vertex {                         \
+   public:                                             \
+    Input<Vector<T, VectorLayout::SPAN, 8>> a;         \
+    Output<Vector<T>> out;                             \
+                                                       \
+    bool compute() {                                   \
+      out[0] = Reduce<T, OP>(&a[0], a.size(), (INIT)); \
+      return true;                                     \
+    }                                                  \
+  };                                                   \
+                                                       \
+  template class NAME<float>;                          \
+  template class NAME<half>;                           \
   template class NAME<int>;
 
-REDUCTION_ELEMENTWISE(ReductionMax, std::numeric_limits<T>::lowest(),
-                      ((a[i] > v) ? a[i] : v))
-REDUCTION_ELEMENTWISE(ReductionMin, std::numeric_limits<T>::max(),
-                      ((a[i] < v) ? a[i] : v))
-REDUCTION_ELEMENTWISE(ReductionAdd, 0.0, v + a[i])
-REDUCTION_ELEMENTWISE(ReductionMul, 1.0, v* a[i])
+REDUCTION_ELEMENTWISE(ReductionMax, std::numeric_limits<T>::lowest(), MaxOp)
+REDUCTION_ELEMENTWISE(ReductionMin, std::numeric_limits<T>::max(), MinOp)
+REDUCTION_ELEMENTWISE(ReductionAdd, T(0.0), AddOp)
+REDUCTION_ELEMENTWISE(ReductionMul, T(1.0), MulOp)
 
 #define LOGICAL_REDUCTION_ELEMENTWISE(NAME, INIT, EXP) \
   template <typename T>                                \
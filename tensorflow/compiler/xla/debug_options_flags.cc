@@ -512,6 +512,13 @@ static void AllocateFlags() {
                        flag_values->xla_gpu_algorithm_blacklist_path(),
                        "An AlgorithmBlacklist text proto file as a blacklist "
                        "of convolutions to avoid to use."),
+      tensorflow::Flag(
+          "xla_cpu_object_cache_dir",
+          string_setter_for(&DebugOptions::set_xla_cpu_object_cache_dir),
+          flag_values->xla_cpu_object_cache_dir(),
+          "If non-empty, caches the object files JIT compiled by the CPU "
+          "backend in this directory, so that compiling the same module "
+          "again skips the LLVM optimizations and code generation."),
   });
   ParseFlagsFromEnvAndDieIfUnknown("XLA_FLAGS", *flag_objects);
 }
@@ -22,6 +22,7 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/casts.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -629,6 +630,54 @@ StatusOr<Literal> LiteralBase::Broadcast(
   const int64 primitive_size =
       ShapeUtil::ByteSizeOfPrimitiveType(shape().element_type());
 
+  // When the operand dimensions are consecutive dimensions of the result and
+  // both are stored in row-major order, the result is the operand with each
+  // element repeated `inner` times, repeated `outer` times. Copy it in
+  // contiguous runs instead of computing the indices of every element.
+  const bool consecutive_dimensions =
+      dimensions.empty() ||
+      dimensions.back() - dimensions.front() + 1 ==
+          static_cast<int64>(dimensions.size());
+  if (consecutive_dimensions && absl::c_is_sorted(dimensions) &&
+      ShapeUtil::ElementsIn(result_shape) > 0 &&
+      LayoutUtil::IsMonotonicWithDim0Major(shape().layout()) &&
+      LayoutUtil::IsMonotonicWithDim0Major(result_shape.layout())) {
+    const int64 first_dimension = dimensions.empty() ? 0 : dimensions.front();
+    int64 outer = 1;
+    for (int64 i = 0; i < first_dimension; ++i) {
+      outer *= result_shape.dimensions(i);
+    }
+    int64 inner = 1;
+    for (int64 i = first_dimension + dimensions.size();
+         i < result_shape.rank(); ++i) {
+      inner *= result_shape.dimensions(i);
+    }
+    const int64 source_elements = ShapeUtil::ElementsIn(shape());
+    const int64 source_bytes = source_elements * primitive_size;
+    char* dest = dest_data;
+    if (inner == 1) {
+      for (int64 i = 0; i < outer; ++i, dest += source_bytes) {
+        memcpy(dest, source_data, source_bytes);
+      }
+    } else {
+      // Write the first copy, and then double the copied run each time.
+      for (int64 j = 0; j < source_elements; ++j) {
+        char* run = dest + j * inner * primitive_size;
+        memcpy(run, source_data + j * primitive_size, primitive_size);
+        for (int64 copied = 1; copied < inner;) {
+          const int64 count = std::min(copied, inner - copied);
+          memcpy(run + copied * primitive_size, run, count * primitive_size);
+          copied += count;
+        }
+      }
+      const int64 block_bytes = source_bytes * inner;
+      for (int64 i = 1; i < outer; ++i) {
+        memcpy(dest + i * block_bytes, dest, block_bytes);
+      }
+    }
+    return std::move(result);
+  }
+
   ShapeUtil::ForEachIndex(
       result_shape, [&](absl::Span<const int64> output_index) {
         for (int64 i = 0; i < dimensions.size(); ++i) {
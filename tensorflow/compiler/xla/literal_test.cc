@@ -2021,6 +2021,31 @@ TEST_F(LiteralUtilTest, BroadcastScalarToMatrix) {
             LiteralUtil::CreateR2<int32>({{9, 9}, {9, 9}}));
 }
 
+TEST_F(LiteralUtilTest, BroadcastMatrixToInnerDimensions) {
+  Literal literal = LiteralUtil::CreateR2<int32>({{1, 2, 3}, {4, 5, 6}});
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal broadcasted_literal,
+      literal.Broadcast(
+          /*result_shape=*/ShapeUtil::MakeShape(S32, {2, 2, 3, 2}),
+          /*dimensions=*/{1, 2}));
+  Array4D<int32> expected(2, 2, 3, 2);
+  expected.Each([](absl::Span<const int64> indices, int32* value) {
+    *value = 3 * indices[1] + indices[2] + 1;
+  });
+  EXPECT_EQ(broadcasted_literal, LiteralUtil::CreateR4FromArray4D(expected));
+}
+
+TEST_F(LiteralUtilTest, BroadcastToColumnMajor) {
+  Literal literal = LiteralUtil::CreateR1<int64>({1, 2});
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal broadcasted_literal,
+      literal.Broadcast(/*result_shape=*/ShapeUtil::MakeShapeWithLayout(
+                            S64, {2, 3}, {0, 1}),
+                        /*dimensions=*/{0}));
+  EXPECT_EQ(broadcasted_literal,
+            LiteralUtil::CreateR2<int64>({{1, 1, 1}, {2, 2, 2}}));
+}
+
 TEST_F(LiteralUtilTest, GetAsComplex128) {
   complex128 value = {1, 0};
   Literal c1 = LiteralUtil::CreateR0<complex128>(value);
@@ -21,7 +21,10 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/env.h"
 
@@ -31,40 +34,56 @@ class NoopStats : public CompilationStats {
  public:
   NoopStats() = default;
 
-  void StartPass(absl::string_view pass_name) override {}
+  void StartPass(absl::string_view pass_name,
+                 int64 instruction_count) override {}
 
-  void EndPass(absl::string_view pass_name) override {}
+  void EndPass(absl::string_view pass_name, int64 instruction_count,
+               int64 iteration_count) override {}
 
   void CompilationReport() override {}
+
+  std::string CompilationReportJson() override { return "{}"; }
 };
 
 class Stats : public CompilationStats {
  public:
   Stats() = default;
 
-  void StartPass(absl::string_view pass_name) override;
+  void StartPass(absl::string_view pass_name, int64 instruction_count) override;
 
-  void EndPass(absl::string_view pass_name) override;
+  void EndPass(absl::string_view pass_name, int64 instruction_count,
+               int64 iteration_count) override;
 
   void CompilationReport() override;
 
+  std::string CompilationReportJson() override;
+
  private:
   struct PassInfo {
     PassInfo(absl::string_view name, double duration)
         : name(name), duration_ms(duration) {}
 
-    absl::string_view name;
+    std::string name;
     int num_runs = 1;
+    int64 num_iterations = 0;
     double duration_ms;
+    // Instruction counts before the first and after the last run.
+    int64 instruction_count_before = 0;
+    int64 instruction_count_after = 0;
   };
 
+  // Returns the passes run so far, merged by name and sorted by decreasing
+  // duration. Also returns their total duration in `total_duration`.
+  std::vector<PassInfo> Summarize(double* total_duration);
+
   // Info about the passes that have been run so far.
   std::vector<PassInfo> passes_;
   // Used to avoid nested calls to StartPass.
   bool pass_running_ = false;
-  absl::string_view current_pass_;
-  // The start time of the currently running pass.
+  std::string current_pass_;
+  // The start time and instruction count of the currently running pass.
   uint64 start_micros_;
+  int64 start_instruction_count_;
 };
 
 /* static */
@@ -77,37 +96,45 @@ std::unique_ptr<CompilationStats> CompilationStats::MakeStats() {
   return absl::make_unique<Stats>();
 }
 
-void Stats::StartPass(absl::string_view pass_name) {
+void Stats::StartPass(absl::string_view pass_name, int64 instruction_count) {
   CHECK(!pass_running_) << "Can't start " << pass_name << " while running "
                         << current_pass_;
   pass_running_ = true;
-  current_pass_ = pass_name;
+  current_pass_ = std::string(pass_name);
+  start_instruction_count_ = instruction_count;
   start_micros_ = tensorflow::Env::Default()->NowMicros();
 }
 
-void Stats::EndPass(absl::string_view pass_name) {
+void Stats::EndPass(absl::string_view pass_name, int64 instruction_count,
+                    int64 iteration_count) {
   CHECK(pass_running_);
   CHECK_EQ(current_pass_, pass_name);
   pass_running_ = false;
   uint64 end_micros = tensorflow::Env::Default()->NowMicros();
   double duration_ms = (end_micros - start_micros_) / 1000.0;
-  passes_.push_back(PassInfo(current_pass_, duration_ms));
+  PassInfo info(current_pass_, duration_ms);
+  info.num_iterations = iteration_count;
+  info.instruction_count_before = start_instruction_count_;
+  info.instruction_count_after = instruction_count;
+  passes_.push_back(std::move(info));
 }
 
-void Stats::CompilationReport() {
+std::vector<Stats::PassInfo> Stats::Summarize(double* total_duration) {
   CHECK(!pass_running_) << "EndPass never called for " << current_pass_;
   absl::flat_hash_map<absl::string_view, PassInfo> summary;
-  double total_duration = 0;
+  *total_duration = 0;
 
   for (auto& pass_run : passes_) {
-    auto pass_name = pass_run.name;
-    total_duration += pass_run.duration_ms;
+    absl::string_view pass_name = pass_run.name;
+    *total_duration += pass_run.duration_ms;
     auto it = summary.find(pass_name);
     if (it == summary.end()) {
       summary.insert(std::make_pair(pass_name, pass_run));
     } else {
-      ++summary.at(pass_name).num_runs;
-      summary.at(pass_name).duration_ms += pass_run.duration_ms;
+      ++it->second.num_runs;
+      it->second.num_iterations += pass_run.num_iterations;
+      it->second.duration_ms += pass_run.duration_ms;
+      it->second.instruction_count_after = pass_run.instruction_count_after;
     }
   }
 
@@ -121,12 +148,42 @@ void Stats::CompilationReport() {
     return std::make_pair(b.duration_ms, a.name) <
            std::make_pair(a.duration_ms, b.name);
   });
+  return sorted_summary;
+}
+
+void Stats::CompilationReport() {
+  double total_duration;
+  std::vector<PassInfo> sorted_summary = Summarize(&total_duration);
   LOG(INFO) << "Total runtime (ms) of HLO passes: " << total_duration;
-  LOG(INFO) << "Pass name, num runs, time (ms)";
+  LOG(INFO) << "Pass name, num runs, num iterations, time (ms), "
+               "instructions before, instructions after";
   for (auto& pass_info : sorted_summary) {
     LOG(INFO) << pass_info.name << ", " << pass_info.num_runs << ", "
-              << pass_info.duration_ms;
+              << pass_info.num_iterations << ", " << pass_info.duration_ms
+              << ", " << pass_info.instruction_count_before << ", "
+              << pass_info.instruction_count_after;
+  }
+}
+
+std::string Stats::CompilationReportJson() {
+  double total_duration;
+  std::vector<PassInfo> sorted_summary = Summarize(&total_duration);
+  std::vector<std::string> passes;
+  passes.reserve(sorted_summary.size());
+  for (auto& pass_info : sorted_summary) {
+    passes.push_back(absl::StrFormat(
+        "    {\"name\": \"%s\", \"num_runs\": %d, \"num_iterations\": %d, "
+        "\"duration_ms\": %.3f, \"instruction_count_before\": %d, "
+        "\"instruction_count_after\": %d}",
+        absl::CEscape(pass_info.name), pass_info.num_runs,
+        pass_info.num_iterations, pass_info.duration_ms,
+        pass_info.instruction_count_before,
+        pass_info.instruction_count_after));
   }
+  return absl::StrCat("{\n  \"total_duration_ms\": ",
+                      absl::StrFormat("%.3f", total_duration),
+                      ",\n  \"passes\": [\n", absl::StrJoin(passes, ",\n"),
+                      "\n  ]\n}\n");
 }
 
 }  // namespace xla
@@ -20,14 +20,16 @@ limitations under the License.
 #include <string>
 
 #include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
 
 // This class is used to collect information about HLO passes and print some
 // statistics at the end of compilation. From HloPassPipeline, we call StartPass
-// before the execution of a pass, and EndPass after. Currently, we only collect
-// timing information and how many times each pass was run. In the future, we
-// can add more things, such as the size of the HLO graph after each pass.
+// before the execution of a pass, and EndPass after. For each pass we collect
+// timing information, how many times it was run, how many iterations it took
+// (for passes run to a fixed point by HloPassFix), and the number of HLO
+// instructions before and after it ran.
 class CompilationStats {
  public:
   virtual ~CompilationStats() = default;
@@ -36,11 +38,21 @@ class CompilationStats {
 
   static std::unique_ptr<CompilationStats> MakeStats();
 
-  virtual void StartPass(absl::string_view pass_name) = 0;
+  // `instruction_count` is the number of HLO instructions before the pass.
+  virtual void StartPass(absl::string_view pass_name,
+                         int64 instruction_count) = 0;
 
-  virtual void EndPass(absl::string_view pass_name) = 0;
+  // `instruction_count` is the number of HLO instructions after the pass, and
+  // `iteration_count` is the number of times the pass applied its
+  // transformation.
+  virtual void EndPass(absl::string_view pass_name, int64 instruction_count,
+                       int64 iteration_count) = 0;
 
+  // Logs a summary of the statistics, slowest pass first.
   virtual void CompilationReport() = 0;
+
+  // Returns the summary as a JSON object, slowest pass first.
+  virtual std::string CompilationReportJson() = 0;
 };
 
 }  // namespace xla
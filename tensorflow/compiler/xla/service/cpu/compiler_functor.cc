@@ -23,6 +23,8 @@ limitations under the License.
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
@@ -30,6 +32,8 @@ limitations under the License.
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -42,7 +46,13 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/public/version.h"
 
 namespace xla {
 namespace cpu {
@@ -78,13 +88,70 @@ class FilteredPassManager : public llvm::legacy::PassManager {
  private:
   bool disable_expensive_passes_;
 };
+
+// Returns whether 'memory_buffer' holds a valid object file.
+bool IsObjectFile(const llvm::MemoryBuffer& memory_buffer) {
+  llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
+      llvm::object::ObjectFile::createObjectFile(memory_buffer);
+  if (!obj_file) {
+    llvm::consumeError(obj_file.takeError());
+    return false;
+  }
+  return true;
+}
+
+// Loads the object file cached at 'path', or returns nullptr if there is no
+// valid one.
+std::unique_ptr<llvm::MemoryBuffer> LoadCachedObject(const string& path) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->FileExists(path).ok()) {
+    return nullptr;
+  }
+  string object;
+  tensorflow::Status status = tensorflow::ReadFileToString(env, path, &object);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read cached object file " << path << ": "
+                 << status.ToString();
+    return nullptr;
+  }
+  std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+      llvm::MemoryBuffer::getMemBufferCopy(object);
+  if (!IsObjectFile(*memory_buffer)) {
+    LOG(WARNING) << "Ignoring invalid cached object file " << path;
+    return nullptr;
+  }
+  return memory_buffer;
+}
+
+// Stores 'memory_buffer' at 'path'. Failures are logged and otherwise ignored.
+void StoreCachedObject(const string& path,
+                       const llvm::MemoryBuffer& memory_buffer) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  // Write to a temporary file first, so that other processes never read a
+  // partial object file.
+  const string tmp_path =
+      absl::StrCat(path, ".tmp", tensorflow::random::New64());
+  tensorflow::Status status =
+      env->RecursivelyCreateDir(string(tensorflow::io::Dirname(path)));
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(
+        env, tmp_path,
+        absl::string_view(memory_buffer.getBufferStart(),
+                          memory_buffer.getBufferSize()));
+  }
+  if (status.ok()) {
+    status = env->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write cached object file " << path << ": "
+                 << status.ToString();
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
 }  // anonymous namespace
 
 std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
     llvm::Module& module) const {
-  FilteredPassManager module_passes(disable_expensive_passes_);
-  llvm::legacy::FunctionPassManager function_passes(&module);
-
   VLOG(2) << "IR before optimizations";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
 
@@ -92,6 +159,66 @@ std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
     pre_optimization_hook_(module);
   }
 
+  std::unique_ptr<llvm::MemoryBuffer> memory_buffer;
+  string cache_path;
+  if (!object_cache_dir_.empty()) {
+    cache_path = ObjectCachePath(module);
+    memory_buffer = LoadCachedObject(cache_path);
+    if (memory_buffer) {
+      VLOG(1) << "Loaded object file from " << cache_path;
+    }
+  }
+  if (!memory_buffer) {
+    memory_buffer = Compile(module);
+    if (!cache_path.empty()) {
+      StoreCachedObject(cache_path, *memory_buffer);
+    }
+  }
+
+  if (post_codegen_hook_) {
+    llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
+        llvm::object::ObjectFile::createObjectFile(*memory_buffer);
+    if (obj_file) {
+      post_codegen_hook_(*obj_file.get());
+    } else {
+      LOG(WARNING) << "Could convert memory buffer to object file!";
+    }
+  }
+
+  return memory_buffer;
+}
+
+string CompilerFunctor::ObjectCachePath(const llvm::Module& module) const {
+  // The module is generated from the HLO module, so it covers the HLO and
+  // the options used to emit it.
+  const string key = absl::StrCat(
+      "version=", tf_git_version(),
+      ";triple=", target_machine_->getTargetTriple().str(),
+      ";cpu=", target_machine_->getTargetCPU().str(),
+      ";features=", target_machine_->getTargetFeatureString().str(),
+      ";opt_level=", opt_level_, ";optimize_for_size=", optimize_for_size_,
+      ";disable_expensive_passes=", disable_expensive_passes_,
+      ";fast_math_flags=", fast_math_flags_.allowReassoc(),
+      fast_math_flags_.noNaNs(), fast_math_flags_.noInfs(),
+      fast_math_flags_.noSignedZeros(), fast_math_flags_.allowReciprocal(),
+      fast_math_flags_.allowContract(), fast_math_flags_.approxFunc(),
+      ";module=", llvm_ir::DumpModuleToString(module));
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      object_cache_dir_,
+      absl::StrCat(
+          tensorflow::strings::Hex(fingerprint.high64,
+                                   tensorflow::strings::kZeroPad16),
+          tensorflow::strings::Hex(fingerprint.low64,
+                                   tensorflow::strings::kZeroPad16),
+          ".o"));
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::Compile(
+    llvm::Module& module) const {
+  FilteredPassManager module_passes(disable_expensive_passes_);
+  llvm::legacy::FunctionPassManager function_passes(&module);
+
   // Add the appropriate TargetLibraryInfo and TargetTransformInfo.
   AddTargetInfoPasses(&module_passes);
 
@@ -142,20 +269,8 @@ std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::operator()(
   target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
-  std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
+  return std::unique_ptr<llvm::MemoryBuffer>(
       new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer)));
-
-  if (post_codegen_hook_) {
-    llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
-        llvm::object::ObjectFile::createObjectFile(*memory_buffer);
-    if (obj_file) {
-      post_codegen_hook_(*obj_file.get());
-    } else {
-      LOG(WARNING) << "Could convert memory buffer to object file!";
-    }
-  }
-
-  return memory_buffer;
 }
 
 static std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl() {
@@ -22,6 +22,7 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
+#include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -38,7 +39,8 @@ class CompilerFunctor {
       LLVMCompiler::ModuleHook pre_optimization_hook = nullptr,
       LLVMCompiler::ModuleHook post_optimization_hook = nullptr,
       std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook =
-          nullptr)
+          nullptr,
+      string object_cache_dir = "")
       : target_machine_(target_machine),
         opt_level_(opt_level),
         optimize_for_size_(optimize_for_size),
@@ -46,9 +48,14 @@ class CompilerFunctor {
         fast_math_flags_(fast_math_flags),
         pre_optimization_hook_(std::move(pre_optimization_hook)),
         post_optimization_hook_(std::move(post_optimization_hook)),
-        post_codegen_hook_(std::move(post_codegen_hook)) {}
+        post_codegen_hook_(std::move(post_codegen_hook)),
+        object_cache_dir_(std::move(object_cache_dir)) {}
 
   // Compile a Module to an ObjectFile.
+  //
+  // If 'object_cache_dir' is non-empty, object files are cached in it, keyed
+  // by the unoptimized module and the options which affect code generation.
+  // The post optimization hook is not invoked for modules found in the cache.
   std::unique_ptr<llvm::MemoryBuffer> operator()(
       llvm::Module& module) const;  // NOLINT
 
@@ -62,6 +69,12 @@ class CompilerFunctor {
                              llvm::legacy::FunctionPassManager* function_passes,
                              unsigned opt_level, unsigned size_level) const;
 
+  // Returns the path of the object file for 'module' in the object cache.
+  string ObjectCachePath(const llvm::Module& module) const;
+
+  // Runs the optimizations and code generation on 'module'.
+  std::unique_ptr<llvm::MemoryBuffer> Compile(llvm::Module& module) const;
+
   llvm::TargetMachine* target_machine_;
   const unsigned opt_level_;
   const bool optimize_for_size_;
@@ -70,6 +83,7 @@ class CompilerFunctor {
   LLVMCompiler::ModuleHook pre_optimization_hook_;
   LLVMCompiler::ModuleHook post_optimization_hook_;
   std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook_;
+  const string object_cache_dir_;
 };
 
 }  // namespace cpu
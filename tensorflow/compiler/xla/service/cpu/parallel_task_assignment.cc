@@ -82,8 +82,10 @@ class DefaultCostModel : public ParallelCostModel {
       instruction_cost = shape_size_(instruction->shape());
       min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
     } else {
-      // Use max parallelism for compute bound instructions.
-      max_parallelism = max_parallelism_;
+      // Over-decompose compute bound instructions, so that the runtime can
+      // balance the partitions between threads which progress at different
+      // rates.
+      max_parallelism = max_parallelism_ * kMaxTasksPerThread;
       // Calculate the instruction cost in cycles.
       // TODO(b/29630486) Improve on this linear cost model.
       // Consider making 'min_cost_per_thread' be a function of the target
@@ -95,12 +97,17 @@ class DefaultCostModel : public ParallelCostModel {
       // Minimum per-thread cost is 100us of work on a 2GHz core.
       min_cost_per_thread = 100000;
     }
-    // Return target parallel task count in [1, max_parallelism_].
+    // Return target parallel task count in [1, max_parallelism].
     return std::min(max_parallelism,
                     std::max(int64{1}, instruction_cost / min_cost_per_thread));
   }
 
  private:
+  // The number of tasks per thread a compute bound instruction can be split
+  // into. The runtime hands out the tasks dynamically, so smaller tasks even
+  // out imbalances between threads at the cost of more dispatches.
+  static constexpr int64 kMaxTasksPerThread = 4;
+
   const int64 max_parallelism_;
   const HloCostAnalysis::ShapeSizeFunction shape_size_;
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
@@ -112,10 +119,28 @@ ParallelTaskAssignment::ParallelTaskAssignment(
     const TargetMachineFeatures* target_machine_features)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
+  // Run cost analysis on 'module'. Instructions in the bodies of while loops
+  // and calls are parallelized too, so they need costs as well.
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
-  HloComputation* computation = module->entry_computation();
-  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  HloComputation* entry = module->entry_computation();
+  Status status = entry->root_instruction()->Accept(cost_analysis.get());
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    if (!status.ok()) {
+      break;
+    }
+    if (computation == entry) {
+      continue;
+    }
+    Status computation_status =
+        computation->root_instruction()->Accept(cost_analysis.get());
+    if (!computation_status.ok()) {
+      // The instructions of 'computation' without a cost are treated as I/O
+      // bound by DefaultCostModel.
+      VLOG(1) << "ParallelTaskAssignment cost analysis of "
+              << computation->name()
+              << " failed: " << computation_status.ToString();
+    }
+  }
   if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
     cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
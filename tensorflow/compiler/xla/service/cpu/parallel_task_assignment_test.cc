@@ -170,5 +170,48 @@ TEST_F(ParallelTaskAssignmentTest, InPlaceDynamicUpdateSliceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest,
+       ComputeBoundOperationInWhileBodyOverDecomposed) {
+  // A 3D convolution is not implemented with Eigen, and is compute bound.
+  const string hlo_string = R"(
+  HloModule test
+
+  body {
+    loop_carry = (s32[], f32[1,16,16,16,32], f32[3,3,3,32,32]) parameter(0)
+    i = s32[] get-tuple-element(loop_carry), index=0
+    one = s32[] constant(1)
+    new_i = s32[] add(i, one)
+    input = f32[1,16,16,16,32] get-tuple-element(loop_carry), index=1
+    kernel = f32[3,3,3,32,32] get-tuple-element(loop_carry), index=2
+    conv = f32[1,16,16,16,32] convolution(input, kernel), window={size=3x3x3 pad=1_1x1_1x1_1}, dim_labels=b012f_012io->b012f
+    ROOT tuple = (s32[], f32[1,16,16,16,32], f32[3,3,3,32,32]) tuple(new_i, conv, kernel)
+  }
+
+  cond {
+    loop_carry = (s32[], f32[1,16,16,16,32], f32[3,3,3,32,32]) parameter(0)
+    two = s32[] constant(2)
+    i = s32[] get-tuple-element(loop_carry), index=0
+    ROOT less-than = pred[] compare(i, two), direction=LT
+  }
+
+  ENTRY test {
+    initial_i = s32[] parameter(0)
+    input = f32[1,16,16,16,32] parameter(1)
+    kernel = f32[3,3,3,32,32] parameter(2)
+    tuple = (s32[], f32[1,16,16,16,32], f32[3,3,3,32,32]) tuple(initial_i, input, kernel)
+    ROOT while = (s32[], f32[1,16,16,16,32], f32[3,3,3,32,32]) while(tuple), condition=cond, body=body
+  }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  cpu::ParallelTaskAssignment assignment(max_parallelism_, shape_size_func_,
+                                         m.get(), &target_machine_features_);
+  HloInstruction* conv = FindInstruction(m.get(), "conv");
+  ASSERT_NE(conv, nullptr);
+  // The convolution has enough work for several tasks per thread.
+  EXPECT_GT(assignment.GetTargetParallelTaskCount(conv), max_parallelism_);
+}
+
 }  // namespace
 }  // namespace xla
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
@@ -31,8 +34,12 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
+// Calls 'function_ptr' for each of the 'num_partitions' partitions in
+// parallel. The partitions are claimed dynamically: the calling thread and up
+// to one worker per thread of the intra-op thread pool repeatedly take the
+// next unprocessed partition, so that threads which finish early take over
+// partitions that would otherwise wait for a slower thread. The parallel task
+// assignment may create more partitions than threads to allow for this.
 // Uses blocking counter to synchonize threads after parallel calls complete.
 //
 // The 'partitions' array has a total number of elements equal to
@@ -81,24 +88,31 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
+  // Runs partitions until there are none left.
+  std::atomic<int32> next_partition(0);
+  auto run_partitions = [&]() {
+    for (int32 i = next_partition.fetch_add(1); i < num_partitions;
+         i = next_partition.fetch_add(1)) {
+      function(result_ptr, run_options_ptr, i == 0 ? params : nullptr,
+               buffer_table, &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+    }
+  };
+
+  // Dispatch 'num_workers - 1' workers to run in parallel.
+  const int32 num_workers = std::min<int32>(
+      num_partitions, run_options->intra_op_thread_pool()->numThreads() + 1);
+  tensorflow::BlockingCounter bc(num_workers - 1);
+  for (int32 i = 1; i < num_workers; ++i) {
     run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &partitions[offset], prof_counters);
+        [&run_partitions, &bc]() {
+          run_partitions();
           bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
         });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  // Run partitions inline too.
+  run_partitions();
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
@@ -88,7 +88,8 @@ SimpleOrcJIT::SimpleOrcJIT(
     bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
     LLVMCompiler::ModuleHook pre_optimization_hook,
     LLVMCompiler::ModuleHook post_optimization_hook,
-    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook)
+    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+    const string& object_cache_dir)
     : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
       data_layout_(target_machine_->createDataLayout()),
       symbol_resolver_(llvm::orc::createLegacyLookupResolver(
@@ -125,7 +126,7 @@ SimpleOrcJIT::SimpleOrcJIT(
                           disable_expensive_passes, fast_math_flags,
                           std::move(pre_optimization_hook),
                           std::move(post_optimization_hook),
-                          std::move(post_codegen_hook))),
+                          std::move(post_codegen_hook), object_cache_dir)),
       gdb_jit_event_listener_(
           llvm::JITEventListener::createGDBRegistrationListener()) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
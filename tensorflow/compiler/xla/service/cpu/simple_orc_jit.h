@@ -54,13 +54,17 @@ class SimpleOrcJIT {
   // {pre,post}_optimization_hook is invoked on the module before/after all
   // LLVM IR-level optimizations.  post_codegen_hook is invoked after
   // compiling to machine code.
+  //
+  // If 'object_cache_dir' is non-empty, the compiled object files are cached
+  // in it and reused instead of compiling equivalent modules again.
   SimpleOrcJIT(
       const llvm::TargetOptions& target_options,
       llvm::CodeGenOpt::Level opt_level, bool optimize_for_size,
       bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
       LLVMCompiler::ModuleHook pre_optimization_hook,
       LLVMCompiler::ModuleHook post_optimization_hook,
-      std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook);
+      std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+      const string& object_cache_dir);
 
   const llvm::DataLayout& data_layout() const { return data_layout_; }
 
@@ -0,0 +1,86 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuObjectCacheTest : public HloTestBase {
+ protected:
+  CpuObjectCacheTest()
+      : cache_dir_(tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                            "cpu_object_cache_test")) {}
+
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_object_cache_dir(cache_dir_);
+    return debug_options;
+  }
+
+  std::vector<string> CachedObjects() {
+    std::vector<string> objects;
+    TF_CHECK_OK(tensorflow::Env::Default()->GetMatchingPaths(
+        tensorflow::io::JoinPath(cache_dir_, "*.o"), &objects));
+    return objects;
+  }
+
+  const string cache_dir_;
+};
+
+TEST_F(CpuObjectCacheTest, ReusesCachedObject) {
+  const char* const hlo_string = R"(
+HloModule test
+
+ENTRY test {
+  p0 = f32[4] parameter(0)
+  p1 = f32[4] parameter(1)
+  add = f32[4] add(p0, p1)
+  ROOT mul = f32[4] multiply(add, p1)
+}
+)";
+  Literal arg0 = LiteralUtil::CreateR1<float>({1, 2, 3, 4});
+  Literal arg1 = LiteralUtil::CreateR1<float>({2, 2, 2, 2});
+  Literal expected = LiteralUtil::CreateR1<float>({6, 8, 10, 12});
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  Literal result = ExecuteAndTransfer(std::move(module), {&arg0, &arg1});
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+  const std::vector<string> objects = CachedObjects();
+  EXPECT_EQ(objects.size(), 1);
+
+  // Compiling the same module again loads the cached object.
+  TF_ASSERT_OK_AND_ASSIGN(module, ParseAndReturnVerifiedModule(hlo_string));
+  result = ExecuteAndTransfer(std::move(module), {&arg0, &arg1});
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+  EXPECT_EQ(CachedObjects(), objects);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
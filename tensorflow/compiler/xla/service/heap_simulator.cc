@@ -593,42 +593,98 @@ using Chunk = HeapSimulator::Chunk;
 
 void GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::Add(
     int64 start, int64 end, const Chunk& chunk) {
-  node_storage_.emplace_back(
-      BufferIntervalTreeNode{start, end, end, chunk, nullptr, nullptr});
+  node_storage_.push_back(BufferIntervalTreeNode{start, end, end, chunk,
+                                                 nullptr, nullptr, 1});
+  root_ = Insert(root_, &node_storage_.back());
+}
 
-  if (node_storage_.size() == 1) {
-    // This is root.
-    return;
+/*static*/ GlobalDecreasingSizeBestFitHeap::BufferIntervalTreeNode*
+GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::Insert(
+    BufferIntervalTreeNode* root, BufferIntervalTreeNode* node) {
+  if (root == nullptr) {
+    return node;
   }
+  if (root->start > node->start) {
+    root->left = Insert(root->left, node);
+  } else {
+    root->right = Insert(root->right, node);
+  }
+  return Rebalance(root);
+}
 
-  BufferIntervalTreeNode* parent = &node_storage_.front();
-  while (true) {
-    parent->subtree_end = std::max(parent->subtree_end, end);
-    if (parent->start > start) {
-      if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        return;
-      }
-      parent = parent->left;
-    } else {
-      if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        return;
-      }
-      parent = parent->right;
+namespace {
+
+template <typename Node>
+int64 NodeHeight(const Node* node) {
+  return node == nullptr ? 0 : node->height;
+}
+
+}  // namespace
+
+/*static*/ void GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::Update(
+    BufferIntervalTreeNode* node) {
+  node->height =
+      1 + std::max(NodeHeight(node->left), NodeHeight(node->right));
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+}
+
+/*static*/ GlobalDecreasingSizeBestFitHeap::BufferIntervalTreeNode*
+GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::RotateLeft(
+    BufferIntervalTreeNode* node) {
+  BufferIntervalTreeNode* new_root = node->right;
+  node->right = new_root->left;
+  new_root->left = node;
+  Update(node);
+  Update(new_root);
+  return new_root;
+}
+
+/*static*/ GlobalDecreasingSizeBestFitHeap::BufferIntervalTreeNode*
+GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::RotateRight(
+    BufferIntervalTreeNode* node) {
+  BufferIntervalTreeNode* new_root = node->left;
+  node->left = new_root->right;
+  new_root->right = node;
+  Update(node);
+  Update(new_root);
+  return new_root;
+}
+
+/*static*/ GlobalDecreasingSizeBestFitHeap::BufferIntervalTreeNode*
+GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::Rebalance(
+    BufferIntervalTreeNode* node) {
+  Update(node);
+  const int64 balance = NodeHeight(node->left) - NodeHeight(node->right);
+  if (balance > 1) {
+    if (NodeHeight(node->left->left) < NodeHeight(node->left->right)) {
+      node->left = RotateLeft(node->left);
+    }
+    return RotateRight(node);
+  }
+  if (balance < -1) {
+    if (NodeHeight(node->right->right) < NodeHeight(node->right->left)) {
+      node->right = RotateRight(node->right);
     }
+    return RotateLeft(node);
   }
+  return node;
 }
 
 std::vector<Chunk>
 GlobalDecreasingSizeBestFitHeap::BufferIntervalTree::ChunksOverlappingInTime(
     int64 start, int64 end) const {
   std::vector<Chunk> result;
-  if (node_storage_.empty()) {
+  if (root_ == nullptr) {
     return result;
   }
   std::vector<const BufferIntervalTreeNode*> visiting_stack;
-  visiting_stack.push_back(&node_storage_.front());
+  visiting_stack.push_back(root_);
   while (!visiting_stack.empty()) {
     const BufferIntervalTreeNode* top = visiting_stack.back();
     visiting_stack.pop_back();
@@ -710,7 +766,8 @@ GlobalDecreasingSizeBestFitHeap::FindChunkCandidate(
   //   |+-a-+  +-------b-------+  +---c---+
   //   ----------------------------------------> time
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
-    auto colocation_interval = buffer_intervals_.at(colocation);
+    const BufferInterval& colocation_interval =
+        buffer_intervals_.at(colocation);
     auto colocation_overlapping = interval_tree_.ChunksOverlappingInTime(
         colocation_interval.start, colocation_interval.end);
     VLOG(1) << "  Alias size " << colocation_interval.size << ", start "
@@ -781,7 +838,8 @@ void GlobalDecreasingSizeBestFitHeap::CommitChunk(
                      chunk_candidate.chunk);
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
     AddToChunkMap(colocation, chunk_candidate.chunk);
-    auto colocation_interval = buffer_intervals_[colocation];
+    const BufferInterval& colocation_interval =
+        buffer_intervals_.at(colocation);
     interval_tree_.Add(colocation_interval.start, colocation_interval.end,
                        chunk_candidate.chunk);
   }
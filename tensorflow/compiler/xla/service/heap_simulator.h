@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_HEAP_SIMULATOR_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HEAP_SIMULATOR_H_
 
+#include <deque>
 #include <memory>
 #include <set>
 #include <utility>
@@ -350,9 +351,14 @@ class GlobalDecreasingSizeBestFitHeap : public HeapAlgorithm {
     BufferIntervalTreeNode* left;
     // Right child.
     BufferIntervalTreeNode* right;
+    // Height of the subtree where this node is the root.
+    int64 height;
   };
 
-  // An interval tree that can query buffers overlapping in time.
+  // An interval tree that can query buffers overlapping in time. The tree is
+  // kept balanced (as an AVL tree ordered by alloc time), so that adding a
+  // buffer takes O(log n) time and a query takes O(log n + k) time for k
+  // overlapping buffers, regardless of the order in which buffers are added.
   class BufferIntervalTree {
    public:
     // Adds a buffer to the interval tree, with the time interval and allocated
@@ -364,7 +370,20 @@ class GlobalDecreasingSizeBestFitHeap : public HeapAlgorithm {
     std::vector<Chunk> ChunksOverlappingInTime(int64 start, int64 end) const;
 
    private:
-    std::list<BufferIntervalTreeNode> node_storage_;
+    // Inserts `node` into the subtree rooted at `root`, and returns the new
+    // root of the subtree.
+    static BufferIntervalTreeNode* Insert(BufferIntervalTreeNode* root,
+                                          BufferIntervalTreeNode* node);
+    // Restores the balance of the subtree rooted at `node`, whose children
+    // are balanced, and returns the new root of the subtree.
+    static BufferIntervalTreeNode* Rebalance(BufferIntervalTreeNode* node);
+    static BufferIntervalTreeNode* RotateLeft(BufferIntervalTreeNode* node);
+    static BufferIntervalTreeNode* RotateRight(BufferIntervalTreeNode* node);
+    // Recomputes the height and subtree_end of `node` from its children.
+    static void Update(BufferIntervalTreeNode* node);
+
+    BufferIntervalTreeNode* root_ = nullptr;
+    std::deque<BufferIntervalTreeNode> node_storage_;
   };
 
   // The candidate contains a chunk and the resultant heap size if this
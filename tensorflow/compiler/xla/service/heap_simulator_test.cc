@@ -32,6 +32,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -1226,5 +1229,118 @@ TEST_F(GlobalDecreasingSizeBestFitHeapTest, ColocatedIII) {
   EXPECT_EQ(30, result.chunk_map.at(buffer_c_).offset);
 }
 
+// A synthetic sequence of allocations and frees of many buffers of random
+// sizes and lifetimes.
+class SyntheticHeapSequence {
+ public:
+  explicit SyntheticHeapSequence(int num_buffers)
+      : builder_("synthetic_heap_sequence") {
+    tensorflow::random::PhiloxRandom philox(7, 42);
+    tensorflow::random::SimplePhilox random(&philox);
+    std::vector<int> live;
+    for (int i = 0; i < num_buffers; ++i) {
+      auto constant = builder_.AddInstruction(
+          HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+      buffers_.push_back(
+          absl::make_unique<HloValue>(i, constant, ShapeIndex{}));
+      sizes_.push_back(1 + random.Uniform(1024));
+      events_.push_back({/*alloc=*/true, i});
+      live.push_back(i);
+      // Free a random live buffer about every other step, so that about half
+      // of the buffers are live at any time.
+      if (random.OneIn(2) && !live.empty()) {
+        const int index = random.Uniform(live.size());
+        events_.push_back({/*alloc=*/false, live[index]});
+        live[index] = live.back();
+        live.pop_back();
+      }
+    }
+    for (int buffer : live) {
+      events_.push_back({/*alloc=*/false, buffer});
+    }
+  }
+
+  // Replays the sequence on `heap`.
+  void Run(HeapAlgorithm* heap) const {
+    for (const Event& event : events_) {
+      if (event.alloc) {
+        heap->Alloc(buffer(event.buffer), sizes_[event.buffer]);
+      } else {
+        heap->Free(buffer(event.buffer), sizes_[event.buffer]);
+      }
+    }
+  }
+
+  // Returns the [alloc, free] times of `buffer` in the sequence.
+  std::pair<int64, int64> LiveRange(int buffer) const {
+    std::pair<int64, int64> range;
+    for (int64 time = 0; time < events_.size(); ++time) {
+      if (events_[time].buffer == buffer) {
+        (events_[time].alloc ? range.first : range.second) = time;
+      }
+    }
+    return range;
+  }
+
+  const HloValue* buffer(int i) const { return buffers_[i].get(); }
+  int num_buffers() const { return buffers_.size(); }
+
+ private:
+  struct Event {
+    bool alloc;
+    int buffer;
+  };
+
+  HloComputation::Builder builder_;
+  std::vector<std::unique_ptr<HloValue>> buffers_;
+  std::vector<int64> sizes_;
+  std::vector<Event> events_;
+};
+
+TEST(GlobalDecreasingSizeBestFitHeapSyntheticTest, NoOverlaps) {
+  // Buffers which are live at the same time must not overlap in memory.
+  SyntheticHeapSequence sequence(/*num_buffers=*/500);
+  GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/8);
+  sequence.Run(&heap);
+  const HeapSimulator::Result result = heap.Finish();
+
+  std::vector<std::pair<int64, int64>> live_ranges;
+  for (int i = 0; i < sequence.num_buffers(); ++i) {
+    live_ranges.push_back(sequence.LiveRange(i));
+  }
+  for (int i = 0; i < sequence.num_buffers(); ++i) {
+    const HeapSimulator::Chunk& a = result.chunk_map.at(sequence.buffer(i));
+    EXPECT_EQ(a.offset % 8, 0);
+    EXPECT_LE(a.chunk_end(), result.heap_size);
+    for (int j = i + 1; j < sequence.num_buffers(); ++j) {
+      const bool overlap_in_time =
+          live_ranges[i].first < live_ranges[j].second &&
+          live_ranges[j].first < live_ranges[i].second;
+      if (!overlap_in_time) {
+        continue;
+      }
+      const HeapSimulator::Chunk& b = result.chunk_map.at(sequence.buffer(j));
+      EXPECT_TRUE(a.chunk_end() <= b.offset || b.chunk_end() <= a.offset)
+          << "buffers " << i << " and " << j << " overlap";
+    }
+  }
+}
+
+void BM_GlobalDecreasingSizeBestFitHeap(int num_iters, int num_buffers) {
+  tensorflow::testing::StopTiming();
+  SyntheticHeapSequence sequence(num_buffers);
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/64);
+    sequence.Run(&heap);
+    heap.Finish();
+  }
+}
+
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000);
+
 }  // namespace
 }  // namespace xla
@@ -63,11 +63,39 @@ static bool IsOrContainsIllegalInstr(const HloInstruction* instr) {
   return false;
 }
 
+// Estimates the number of elements the evaluator processes to fold instr: it
+// reads every operand element and computes every output element, which for a
+// dot takes a pass over the contracted dimensions.
+static int64 EvaluatedElements(const HloInstruction* instr) {
+  int64 output_elements = 0;
+  ShapeUtil::ForEachSubshape(
+      instr->shape(), [&](const Shape& subshape, const ShapeIndex&) {
+        if (subshape.IsArray()) {
+          output_elements += ShapeUtil::ElementsIn(subshape);
+        }
+      });
+  if (instr->opcode() == HloOpcode::kDot) {
+    const auto& dnums = instr->dot_dimension_numbers();
+    for (int64 dim : dnums.lhs_contracting_dimensions()) {
+      output_elements *= instr->operand(0)->shape().dimensions(dim);
+    }
+  }
+  int64 operand_elements = 0;
+  for (const HloInstruction* operand : instr->operands()) {
+    if (operand->shape().IsArray()) {
+      operand_elements += ShapeUtil::ElementsIn(operand->shape());
+    }
+  }
+  return output_elements + operand_elements;
+}
+
 StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
   // Limit the constant folding to 0 iterations to skip folding loops. This
   // retains the behavior from before while loop support in HloEvaluator and may
   // be revised.
   auto evaluator = absl::make_unique<HloEvaluator>(/*max_loop_iterations=*/0);
+  evaluator->set_use_fast_path(
+      module->config().debug_options().xla_hlo_evaluator_use_fast_path());
 
   XLA_VLOG_LINES(2,
                  "HloConstantFolding::Run(), before:\n" + module->ToString());
@@ -137,6 +165,13 @@ StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
         }
       }
 
+      if (max_evaluated_elements_ > 0 &&
+          EvaluatedElements(instruction) > max_evaluated_elements_) {
+        VLOG(2) << "Not constant folding the large instruction: "
+                << instruction->ToString();
+        continue;
+      }
+
       Literal result;
       // Currently we skip unimplemented operations.
       // TODO(b/35975797): Fold constant computations for more operations.
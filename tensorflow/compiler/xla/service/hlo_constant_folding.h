@@ -25,11 +25,21 @@ namespace xla {
 // computation on constants.
 class HloConstantFolding : public HloModulePass {
  public:
+  // Instructions for which the evaluator would have to process more than
+  // `max_evaluated_elements` elements are not folded, as evaluating them can
+  // take longer than running them. A non-positive value folds instructions of
+  // any size.
+  explicit HloConstantFolding(int64 max_evaluated_elements = 0)
+      : max_evaluated_elements_(max_evaluated_elements) {}
+
   absl::string_view name() const override { return "constant_folding"; }
 
   // Run constant folding operations on the given module. Returns whether the
   // module was changed (constant expressions folded).
   StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  const int64 max_evaluated_elements_;
 };
 
 }  // namespace xla
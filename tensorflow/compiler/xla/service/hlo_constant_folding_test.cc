@@ -268,6 +268,33 @@ TEST_F(HloConstantFoldingTest, DoesNotFoldLargePad) {
               GmockMatch(m::Pad(m::Constant(), m::Constant())));
 }
 
+TEST_F(HloConstantFoldingTest, DoesNotFoldInstructionAboveEvaluationLimit) {
+  const char* const kModuleStr = R"(
+  HloModule test
+
+  ENTRY entry {
+    a = f32[64,64] constant({...})
+    b = f32[64,64] constant({...})
+    ROOT dot = f32[64,64] dot(a, b), lhs_contracting_dims={1},
+                                     rhs_contracting_dims={0}
+  })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kModuleStr));
+  // The dot reads 2 * 64 * 64 elements and does 64 * 64 * 64 steps.
+  HloConstantFolding constant_folding(/*max_evaluated_elements=*/64 * 64 * 64);
+  TF_ASSERT_OK_AND_ASSIGN(bool result,
+                          RunHloPass(&constant_folding, module.get()));
+  EXPECT_FALSE(result);
+
+  HloConstantFolding larger_constant_folding(
+      /*max_evaluated_elements=*/64 * 64 * 66);
+  TF_ASSERT_OK_AND_ASSIGN(result,
+                          RunHloPass(&larger_constant_folding, module.get()));
+  EXPECT_TRUE(result);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              GmockMatch(m::Constant()));
+}
+
 TEST_F(HloConstantFoldingTest, DontFoldSubcomputationContainingAfterAll) {
   const char* const kModuleStr = R"(
   HloModule test
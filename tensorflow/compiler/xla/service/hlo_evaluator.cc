@@ -2224,6 +2224,18 @@ static bool IsScalarAdd(HloComputation* computation) {
   return false;
 }
 
+// Returns whether the computation applies `opcode` to its accumulator and
+// element parameters, in that order.
+static bool IsScalarBinaryOp(HloComputation* computation, HloOpcode opcode) {
+  HloInstruction* instruction = computation->root_instruction();
+  return instruction->opcode() == opcode &&
+         computation->num_parameters() == 2 &&
+         instruction->operand(0) == computation->parameter_instruction(0) &&
+         instruction->operand(1) == computation->parameter_instruction(1) &&
+         ShapeUtil::IsScalar(instruction->operand(0)->shape()) &&
+         ShapeUtil::IsScalar(instruction->operand(1)->shape());
+}
+
 // Run a single step of an inner loop while running reduction, which applies
 // the user-provided computation on the accumulator and the output element
 // (until the reduction is completed, the output element is also used as
@@ -2294,8 +2306,14 @@ static StatusOr<bool> GenerateReduceOutputElement(
     absl::Span<const int64> arg_dim_counts,
     absl::Span<const int64> result_to_arg_index) {
   bool is_tuple = results.size() > 1;
-  bool use_fast_add = ShapeUtil::ElementIsFloating(init_values[0]->shape()) &&
-                      IsScalarAdd(function) && !is_tuple;
+  bool is_floating = ShapeUtil::ElementIsFloating(init_values[0]->shape());
+  bool use_fast_add = is_floating && IsScalarAdd(function) && !is_tuple;
+  // The floating point types are exactly representable as doubles, so the
+  // maximum and minimum can be computed without the embedded evaluator too.
+  bool use_fast_max = is_floating && !is_tuple &&
+                      IsScalarBinaryOp(function, HloOpcode::kMaximum);
+  bool use_fast_min = is_floating && !is_tuple &&
+                      IsScalarBinaryOp(function, HloOpcode::kMinimum);
 
   const Shape& arg_shape = input_args[0]->shape();
   absl::Span<const int64> arg_dimensions = AsInt64Slice(arg_shape.dimensions());
@@ -2323,6 +2341,25 @@ static StatusOr<bool> GenerateReduceOutputElement(
     return true;
   }
 
+  if (use_fast_max || use_fast_min) {
+    // Matches the NaN propagation of the evaluator's maximum and minimum.
+    double computed_result = *init_values[0]->GetAsDouble({});
+    auto reduction_step =
+        [&](absl::Span<const int64> input_index) -> StatusOr<bool> {
+      double argument = *input_args[0]->GetAsDouble(input_index);
+      bool keep = use_fast_max ? computed_result >= argument
+                               : computed_result <= argument;
+      if (!(keep || std::isnan(computed_result))) {
+        computed_result = argument;
+      }
+      return true;
+    };
+    TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
+        arg_shape, base, arg_dim_counts, arg_dim_steps, reduction_step));
+    TF_RETURN_IF_ERROR(results[0].SetFromDouble(output_index, computed_result));
+    return true;
+  }
+
   // Iterates only over reduced shape, as counts and steps are set to zero
   // for all non-reduced dimensions.
   TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexWithStatus(
@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/dynamic_dimension_inference.h"
@@ -322,6 +323,14 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (HasSameLayout(result.shape(), operand_literal)) {
+      absl::Span<const NativeT> operand_data = operand_literal.data<NativeT>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = unary_op(operand_data[i]);
+      }
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
@@ -329,6 +338,16 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
     return std::move(result);
   }
 
+  // Returns whether the elements of `literal` are stored in the same order as
+  // those of a literal of `shape`, in which case the elementwise operations
+  // can walk both with a linear index instead of a multi-dimensional one.
+  static bool HasSameLayout(const Shape& shape, const Literal& literal) {
+    return LayoutUtil::IsDenseArray(shape) &&
+           LayoutUtil::IsDenseArray(literal.shape()) &&
+           Layout::Equal().MinorToMajorOnly()(shape.layout(),
+                                              literal.shape().layout());
+  }
+
   // Map from a primitive type to its associated (templated) DfsHloVisitor.
   std::unique_ptr<DfsHloVisitor> typed_visitors_[PrimitiveType_ARRAYSIZE];
 
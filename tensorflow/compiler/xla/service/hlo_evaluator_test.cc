@@ -14,7 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/compiler/xla/service/hlo_evaluator.h"
 
+#include <cmath>
 #include <initializer_list>
+#include <limits>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -4426,5 +4428,64 @@ TEST_F(HloEvaluatorTest, ZeroSizedIotaWithHugeDimension) {
   EXPECT_TRUE(actual_literal.data<float>().empty());
 }
 
+TEST_F(HloEvaluatorTest, ReduceMaxMinPropagateNaN) {
+  constexpr absl::string_view hlo_text = R"(
+  HloModule test
+
+  max {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT max = f32[] maximum(lhs, rhs)
+  }
+
+  min {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT min = f32[] minimum(lhs, rhs)
+  }
+
+  ENTRY t {
+    c = f32[3,3] constant({{1, 5, -2}, {nan, 3, 4}, {-inf, 0, 2}})
+    init_max = f32[] constant(-inf)
+    init_min = f32[] constant(inf)
+    reduce_max = f32[3] reduce(c, init_max), dimensions={1}, to_apply=max
+    reduce_min = f32[3] reduce(c, init_min), dimensions={1}, to_apply=min
+    ROOT t = (f32[3], f32[3]) tuple(reduce_max, reduce_min)
+  })";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal actual_literal,
+      HloEvaluator().Evaluate(*m_->entry_computation(), {}));
+  std::vector<Literal> results = actual_literal.DecomposeTuple();
+  absl::Span<const float> max = results[0].data<float>();
+  EXPECT_EQ(max[0], 5);
+  EXPECT_TRUE(std::isnan(max[1]));
+  EXPECT_EQ(max[2], 2);
+  absl::Span<const float> min = results[1].data<float>();
+  EXPECT_EQ(min[0], -2);
+  EXPECT_TRUE(std::isnan(min[1]));
+  EXPECT_EQ(min[2], -std::numeric_limits<float>::infinity());
+}
+
+// Check that the elementwise operations give the same results when the layout
+// of an operand differs from the layout of the result.
+TEST_F(HloEvaluatorTest, ElementwiseWithDifferentLayouts) {
+  constexpr absl::string_view hlo_text = R"(
+  HloModule test
+  ENTRY t {
+    a = f32[2,3]{1,0} constant({{1, 2, 3}, {4, 5, 6}})
+    b = f32[2,3]{0,1} constant({{10, 20, 30}, {40, 50, 60}})
+    add = f32[2,3]{1,0} add(a, b)
+    ROOT neg = f32[2,3]{1,0} negate(add)
+  })";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal actual_literal,
+      HloEvaluator().Evaluate(*m_->entry_computation(), {}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{-11, -22, -33}, {-44, -55, -66}}),
+      actual_literal));
+}
+
 }  // namespace
 }  // namespace xla
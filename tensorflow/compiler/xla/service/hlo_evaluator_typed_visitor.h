@@ -1237,8 +1237,11 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if<std::is_same<
-                                  NativeT, float>::value>::type* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if<
+                std::is_same<NativeT, float>::value ||
+                std::is_same<NativeT, double>::value ||
+                std::is_same<NativeT, Eigen::half>::value>::type* = nullptr>
   Status HandleDot(HloInstruction* dot) {
     const HloInstruction* lhs = dot->operand(0);
     const HloInstruction* rhs = dot->operand(1);
@@ -1294,8 +1297,11 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if<!std::is_same<
-                                  NativeT, float>::value>::type* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if<
+                !std::is_same<NativeT, float>::value &&
+                !std::is_same<NativeT, double>::value &&
+                !std::is_same<NativeT, Eigen::half>::value>::type* = nullptr>
   Status HandleDot(HloInstruction* dot) {
     return HandleDotSlowPath(dot);
   }
@@ -2839,6 +2845,18 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (HloEvaluator::HasSameLayout(result.shape(), lhs_literal) &&
+        HloEvaluator::HasSameLayout(result.shape(), rhs_literal)) {
+      const auto converted_op = ConvertBinaryFunction(binary_op);
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = converted_op(lhs_data[i], rhs_data[i]);
+      }
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ConvertBinaryFunction(binary_op)(
@@ -2866,6 +2884,19 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (HloEvaluator::HasSameLayout(result.shape(), lhs_literal) &&
+        HloEvaluator::HasSameLayout(result.shape(), rhs_literal) &&
+        HloEvaluator::HasSameLayout(result.shape(), ehs_literal)) {
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+      }
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(
         result.Populate<ReturnT>([&](absl::Span<const int64> multi_index) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
@@ -46,6 +46,7 @@ class HloPassFix : public Pass {
       changed |= changed_this_iteration;
       VLOG(3) << "changed_this_iteration: " << changed_this_iteration;
       ++iteration_count;
+      last_run_iteration_count_ = iteration_count;
       if (iteration_count == limit) {
         LOG(ERROR)
             << "Unexpectedly high number of iterations in HLO passes ("
@@ -71,6 +72,7 @@ class HloPassFix : public Pass {
       changed |= changed_this_iteration;
       VLOG(3) << "changed_this_iteration: " << changed_this_iteration;
       ++iteration_count;
+      last_run_iteration_count_ = iteration_count;
       if (iteration_count == limit) {
         LOG(ERROR)
             << "Unexpectedly high number of iterations in HLO passes ("
@@ -80,6 +82,13 @@ class HloPassFix : public Pass {
     }
     return changed;
   }
+
+  int64 last_run_iteration_count() const override {
+    return last_run_iteration_count_;
+  }
+
+ private:
+  int64 last_run_iteration_count_ = 0;
 };
 
 }  // namespace xla
@@ -43,6 +43,11 @@ class HloPassInterface {
   virtual StatusOr<bool> RunOnModuleGroup(HloModuleGroup* module_group) = 0;
 
   virtual bool IsPassPipeline() { return false; }
+
+  // Returns how many times the last run of the pass applied its
+  // transformation, e.g. the number of iterations an HloPassFix took to reach
+  // its fixed point.
+  virtual int64 last_run_iteration_count() const { return 1; }
 };
 
 // Base class for passes which are module-scoped.
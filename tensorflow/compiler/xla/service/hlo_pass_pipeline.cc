@@ -27,9 +27,25 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
+namespace {
+
+int64 InstructionCount(const HloModule& module) {
+  return module.instruction_count();
+}
+
+int64 InstructionCount(const HloModuleGroup& module_group) {
+  int64 count = 0;
+  for (const HloModule* module : module_group.modules()) {
+    count += module->instruction_count();
+  }
+  return count;
+}
+
+}  // namespace
 
 template <typename HloT>
 Status HloPassPipeline::RunInvariantCheckers(
@@ -63,15 +79,32 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     MaybeDumpHlo(*hlo,
                  /*after_pass_name=*/last_pass_name,
                  /*before_pass_name=*/pass_name);
-    if (!pass->IsPassPipeline()) {
-      compilation_stats_->StartPass(pass_name);
+    // Nested pipelines record their passes in our statistics, unless they
+    // were given their own.
+    HloPassPipeline* nested_pipeline = nullptr;
+    CompilationStats* nested_compilation_stats = nullptr;
+    if (pass->IsPassPipeline()) {
+      nested_pipeline = static_cast<HloPassPipeline*>(pass);
+      nested_compilation_stats = nested_pipeline->compilation_stats_;
+      if (nested_compilation_stats ==
+          nested_pipeline->empty_compilation_stats_.get()) {
+        nested_pipeline->compilation_stats_ = compilation_stats_;
+      }
+    } else {
+      compilation_stats_->StartPass(pass_name, InstructionCount(*hlo));
     }
+    auto restore_nested_compilation_stats = tensorflow::gtl::MakeCleanup([&] {
+      if (nested_pipeline != nullptr) {
+        nested_pipeline->compilation_stats_ = nested_compilation_stats;
+      }
+    });
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
     changed |= pass_changed;
     TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
     last_pass_name = string(pass_name);
     if (!pass->IsPassPipeline()) {
-      compilation_stats_->EndPass(pass_name);
+      compilation_stats_->EndPass(pass_name, InstructionCount(*hlo),
+                                  pass->last_run_iteration_count());
     }
   }
   MaybeDumpHlo(*hlo,
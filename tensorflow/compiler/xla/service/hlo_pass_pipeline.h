@@ -32,7 +32,9 @@ limitations under the License.
 
 namespace xla {
 
-// Pipeline of HLO passes.
+// Pipeline of HLO passes. If `compilation_stats` is given, the pipeline records
+// the passes it runs in it, including those run by nested pipelines which were
+// not given statistics of their own.
 class HloPassPipeline : public HloPassInterface {
  public:
   explicit HloPassPipeline(const string& name,
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_fix.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -42,6 +44,7 @@ class HloPassPipelineTest : public HloTestBase {
 
 // A module pass which renames instructions named 'foo' to 'bar'.
 class FooToBarModulePass : public HloModulePass {
+ public:
   absl::string_view name() const override { return "foo2bar"; }
 
   StatusOr<bool> Run(HloModule* module) override {
@@ -255,5 +258,37 @@ ENTRY main {
       ::testing::HasSubstr("Module group pass cannot be run on a module"));
 }
 
+TEST_F(HloPassPipelineTest, CompilationStats) {
+  // Passes of nested pipelines are recorded in the outer pipeline's stats,
+  // along with the iterations of passes run to a fixed point.
+  const string module_str = R"(
+HloModule CompilationStats
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT foo = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  std::unique_ptr<CompilationStats> stats = CompilationStats::MakeStats();
+  HloPassPipeline pipeline(TestName(), stats.get());
+  pipeline.AddPass<HloPassFix<FooToBarModulePass>>();
+  auto& nested = pipeline.AddPass<HloPassFix<HloPassPipeline>>("nested");
+  nested.AddPass<FooToBarModulePass>();
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  const string json = stats->CompilationReportJson();
+  // The fixed point pass changes the module once, and then finds nothing to
+  // change. The nested pipeline runs once, since its pass changes nothing.
+  EXPECT_THAT(json, ::testing::HasSubstr(
+                        "\"name\": \"foo2bar\", \"num_runs\": 2, "
+                        "\"num_iterations\": 3"));
+  EXPECT_THAT(json, ::testing::HasSubstr("\"instruction_count_before\": 3, "
+                                         "\"instruction_count_after\": 3"));
+}
+
 }  // namespace
 }  // namespace xla
@@ -29,7 +29,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace xla {
 
@@ -1619,19 +1623,6 @@ class InstructionVerifier : public DfsHloVisitorWithDefault {
     return Status::OK();
   }
 
-  Status Preprocess(HloInstruction* instruction) override {
-    auto previous = instructions_by_name_.find(instruction->name());
-    TF_RET_CHECK(previous == instructions_by_name_.end())
-        << "HLO has name that is not unique within module:\n"
-        << instruction->ToString()
-        << " in computation: " << instruction->parent()->name()
-        << "\nPrevious HLO with same name:\n"
-        << previous->second->ToString()
-        << " in computation: " << previous->second->parent()->name();
-    instructions_by_name_[instruction->name()] = instruction;
-    return Status::OK();
-  }
-
   Status Postprocess(HloInstruction* instruction) override {
     if (instruction_can_change_layout_func_ &&
         LayoutUtil::IsDenseArray(instruction->shape()) &&
@@ -1655,14 +1646,93 @@ class InstructionVerifier : public DfsHloVisitorWithDefault {
   }
 
  private:
-  absl::flat_hash_map<string, const HloInstruction*> instructions_by_name_;
   // Determines whether an instruction can change layouts.
   std::function<bool(const HloInstruction*)>
       instruction_can_change_layout_func_;
 };
 
+// Checks that the names of the instructions are unique within the module.
+Status VerifyUniqueInstructionNames(const HloModule& module) {
+  absl::flat_hash_map<absl::string_view, const HloInstruction*>
+      instructions_by_name;
+  for (const HloComputation* computation : module.computations()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      auto emplace_result =
+          instructions_by_name.emplace(instruction->name(), instruction);
+      const HloInstruction* previous = emplace_result.first->second;
+      TF_RET_CHECK(emplace_result.second)
+          << "HLO has name that is not unique within module:\n"
+          << instruction->ToString()
+          << " in computation: " << instruction->parent()->name()
+          << "\nPrevious HLO with same name:\n"
+          << previous->ToString()
+          << " in computation: " << previous->parent()->name();
+    }
+  }
+  return Status::OK();
+}
+
+// Modules with fewer instructions than this are verified on the calling
+// thread, since for them the verification is cheaper than distributing it.
+constexpr int64 kMinInstructionsForParallelVerification = 8192;
+
+tensorflow::thread::ThreadPool* GetVerificationThreadPool() {
+  static tensorflow::thread::ThreadPool* pool =
+      new tensorflow::thread::ThreadPool(
+          tensorflow::Env::Default(), "hlo_verifier",
+          std::max(1, tensorflow::port::MaxParallelism()));
+  return pool;
+}
+
 }  // namespace
 
+Status HloVerifier::VerifyComputations(HloModule* module) {
+  // Each computation is checked by its own verifiers, since the verifiers are
+  // stateful. The checks of one computation do not depend on those of
+  // another, so large modules are checked in parallel.
+  const std::vector<HloComputation*> computations(
+      module->computations().begin(), module->computations().end());
+  std::vector<Status> statuses(computations.size());
+  std::vector<std::unique_ptr<ShapeVerifier>> shape_verifiers;
+  shape_verifiers.reserve(computations.size());
+  for (int64 i = 0; i < computations.size(); ++i) {
+    shape_verifiers.push_back(target_metadata_->GetVerifier());
+  }
+  auto verify_computation = [&](int64 i) {
+    InstructionVerifier instruction_verifier(
+        instruction_can_change_layout_func_);
+    statuses[i] = computations[i]->Accept(shape_verifiers[i].get());
+    if (statuses[i].ok()) {
+      statuses[i] = computations[i]->Accept(&instruction_verifier);
+    }
+  };
+
+  if (computations.size() > 1 &&
+      module->instruction_count() >= kMinInstructionsForParallelVerification) {
+    tensorflow::thread::ThreadPool* pool = GetVerificationThreadPool();
+    tensorflow::BlockingCounter counter(computations.size());
+    for (int64 i = 0; i < computations.size(); ++i) {
+      pool->Schedule([&, i]() {
+        verify_computation(i);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    for (int64 i = 0; i < computations.size(); ++i) {
+      verify_computation(i);
+      TF_RETURN_IF_ERROR(statuses[i]);
+    }
+  }
+
+  // Report the error of the first failing computation, as a sequential
+  // verification would.
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 StatusOr<bool> HloVerifier::Run(HloModule* module) {
   TF_RET_CHECK(!module->name().empty());
 
@@ -1675,14 +1745,11 @@ StatusOr<bool> HloVerifier::Run(HloModule* module) {
   TF_RETURN_IF_ERROR(VerifyAsynchronousCopies(*module));
   TF_RETURN_IF_ERROR(VerifySendsAndRecvs(*module));
 
+  TF_RETURN_IF_ERROR(VerifyUniqueInstructionNames(*module));
+  TF_RETURN_IF_ERROR(VerifyComputations(module));
+
   std::unique_ptr<ShapeVerifier> shape_verifier =
       target_metadata_->GetVerifier();
-  InstructionVerifier instruction_verifier(instruction_can_change_layout_func_);
-  for (auto* computation : module->computations()) {
-    TF_RETURN_IF_ERROR(computation->Accept(shape_verifier.get()));
-    TF_RETURN_IF_ERROR(computation->Accept(&instruction_verifier));
-  }
-
   TF_RETURN_IF_ERROR(shape_verifier->VerifyEntryComputationLayout(*module));
   TF_RETURN_IF_ERROR(VerifyEntryAndExitShapes(*module));
 
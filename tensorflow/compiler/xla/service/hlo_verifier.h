@@ -272,6 +272,10 @@ class HloVerifier : public HloModulePass {
   StatusOr<bool> Run(HloModule* module) override;
 
  private:
+  // Checks the shapes and invariants of the instructions of every computation
+  // in `module`. Computations of large modules are checked in parallel.
+  Status VerifyComputations(HloModule* module);
+
   std::unique_ptr<TargetVerifierMetadata> target_metadata_;
 
   // Determines whether an instruction can change layouts.
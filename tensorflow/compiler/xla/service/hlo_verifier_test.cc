@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -128,6 +129,52 @@ TEST_F(HloVerifierTest, DifferentOperandParents) {
               HasSubstr("is in a different computation"));
 }
 
+// Builds a module with enough computations and instructions to be verified in
+// parallel. If `bad_computation` is non-negative, the result of that
+// computation has the wrong shape.
+std::unique_ptr<HloModule> CreateLargeModule(int bad_computation) {
+  auto module = CreateUnverifiedModule();
+  const Shape scalar_shape = ShapeUtil::MakeShape(F32, {});
+  const int kNumComputations = 16;
+  const int kNumInstructionsPerComputation = 1024;
+  HloComputation::Builder entry_builder("entry");
+  HloInstruction* entry_param = entry_builder.AddInstruction(
+      HloInstruction::CreateParameter(0, scalar_shape, "entry_param"));
+  std::vector<HloInstruction*> calls;
+  for (int c = 0; c < kNumComputations; ++c) {
+    HloComputation::Builder builder(absl::StrCat("computation", c));
+    HloInstruction* value = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, scalar_shape, "param"));
+    for (int i = 0; i < kNumInstructionsPerComputation; ++i) {
+      const Shape& shape =
+          c == bad_computation && i == kNumInstructionsPerComputation - 1
+              ? ShapeUtil::MakeShape(S32, {})
+              : scalar_shape;
+      value = builder.AddInstruction(
+          HloInstruction::CreateUnary(shape, HloOpcode::kNegate, value));
+    }
+    HloComputation* computation =
+        module->AddEmbeddedComputation(builder.Build());
+    calls.push_back(entry_builder.AddInstruction(HloInstruction::CreateCall(
+        computation->root_instruction()->shape(), {entry_param},
+        computation)));
+  }
+  entry_builder.AddInstruction(HloInstruction::CreateTuple(calls));
+  module->AddEntryComputation(entry_builder.Build());
+  return module;
+}
+
+TEST_F(HloVerifierTest, LargeModule) {
+  TF_ASSERT_OK(verifier().Run(CreateLargeModule(-1).get()).status());
+}
+
+TEST_F(HloVerifierTest, LargeModuleWithBadComputation) {
+  auto status = verifier().Run(CreateLargeModule(7).get()).status();
+  ASSERT_FALSE(status.ok());
+  EXPECT_THAT(status.error_message(),
+              HasSubstr("Expected instruction to have shape equal to f32[]"));
+}
+
 TEST_F(HloVerifierTest, ResetsShapeVerifierState) {
   HloComputation::Builder builder(TestName());
   Shape s1 = ShapeUtil::MakeShape(F32, {1});
@@ -215,6 +215,7 @@ BaseCollectiveExecutor::~BaseCollectiveExecutor() {}
 
 void BaseCollectiveExecutor::StartAbort(const Status& s) {
   LOG(WARNING) << "BaseCollectiveExecutor::StartAbort " << s;
+  if (fusion_ != nullptr) fusion_->StartAbort(s);
   remote_access_->StartAbort(s);
 }
 
@@ -239,6 +240,10 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
     done(s);
   };
 
+  if (fusion_ != nullptr &&
+      fusion_->MaybeEnqueue(ctx, col_params, exec_key, done_safe)) {
+    return;
+  }
   Tensor* output = ctx->mutable_output(0);
   const Tensor* input = (col_params.instance.type == REDUCTION_COLLECTIVE ||
                          col_params.instance.type == GATHER_COLLECTIVE ||
@@ -246,10 +251,18 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                           col_params.is_source))
                             ? &ctx->input(0)
                             : nullptr;
+  Launch(ctx, col_params, exec_key, input, output, done_safe);
+}
+
+void BaseCollectiveExecutor::Launch(OpKernelContext* ctx,
+                                    const CollectiveParams& col_params,
+                                    const string& exec_key,
+                                    const Tensor* input, Tensor* output,
+                                    const StatusCallback& done) {
   CollectiveImplementationInterface* col_impl = nullptr;
   Status status = CreateCollective(col_params, &col_impl);
   if (!status.ok()) {
-    done_safe(status);
+    done(status);
     DCHECK_EQ(nullptr, col_impl);
     return;
   }
@@ -258,14 +271,14 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                             exec_key, step_id_, input, output);
   status = col_impl->InitializeCollectiveContext(col_ctx);
   if (!status.ok()) {
-    done_safe(status);
+    done(status);
     delete col_ctx;
     delete col_impl;
     return;
   }
   // Run on an unbounded work queue that can handle blocking work so as to not
   // starve executor threads.
-  remote_access_->RunClosure([col_impl, col_ctx, done_safe, ctx]() {
+  remote_access_->RunClosure([col_impl, col_ctx, done, ctx]() {
     profiler::TraceMe activity(
         [&] {
           return strings::StrCat(ctx->op_kernel().name(), ":",
@@ -273,8 +286,8 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                                  "#id=", ctx->step_id(), "#");
         },
         profiler::TraceMeLevel::kInfo);
-    col_impl->Run([col_impl, col_ctx, done_safe](const Status& s) {
-      done_safe(s);
+    col_impl->Run([col_impl, col_ctx, done](const Status& s) {
+      done(s);
       delete col_ctx;
       delete col_impl;
     });
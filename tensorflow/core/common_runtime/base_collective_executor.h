@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
+#include "tensorflow/core/common_runtime/collective_fusion.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 
@@ -102,7 +103,15 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
         step_id_(step_id),
         dev_mgr_(dev_mgr),
         remote_access_(remote_access),
-        gpu_ring_order_(gpu_ring_order) {}
+        gpu_ring_order_(gpu_ring_order) {
+    fusion_ = CollectiveFusion::MaybeCreate(
+        this, dev_mgr,
+        [this](OpKernelContext* ctx, const CollectiveParams& col_params,
+               const string& exec_key, const Tensor* input, Tensor* output,
+               const StatusCallback& done) {
+          Launch(ctx, col_params, exec_key, input, output, done);
+        });
+  }
 
   ~BaseCollectiveExecutor() override;
 
@@ -166,8 +175,14 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // collective instance key -> number of local devices for which NCCL ops have
   // been launched.
   std::unordered_map<int32, int32> launched_ GUARDED_BY(launch_mu_);
+  // Null unless the fusion of small all-reduces is enabled.
+  std::unique_ptr<CollectiveFusion> fusion_;
 
  private:
+  // Runs the collective `col_params` from `input` into `output`.
+  void Launch(OpKernelContext* ctx, const CollectiveParams& col_params,
+              const string& exec_key, const Tensor* input, Tensor* output,
+              const StatusCallback& done);
   Status CreateCollective(const CollectiveParams& col_params,
                           CollectiveImplementationInterface** col_impl);
   // Check if all ops on which this collective depends on have launched.
@@ -29,13 +29,15 @@ limitations under the License.
 #include "tensorflow/core/platform/stacktrace.h"
 #endif
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool small_object_cache)
     : garbage_collection_(garbage_collection),
       sub_allocator_(sub_allocator),
       name_(name),
@@ -71,6 +73,24 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (small_object_cache) {
+    static_assert(kMaxSmallObjectBytes ==
+                      kNumSmallObjectSizeClasses * kMinAllocationSize,
+                  "one size class per kMinAllocationSize bytes");
+    small_object_cache_.reset(
+        new SmallObjectCacheShard[kNumSmallObjectCacheShards]);
+    VLOG(1) << "Enabling small-object cache for allocations of up to "
+            << strings::HumanReadableNumBytes(kMaxSmallObjectBytes);
+  }
+
+  int64 memory_timeline_size = 0;
+  Status status = ReadInt64FromEnvVar("TF_BFC_MEMORY_TIMELINE_SIZE", 0,
+                                      &memory_timeline_size);
+  if (!status.ok()) {
+    LOG(ERROR) << "BFCAllocator: " << status.error_message();
+  }
+  SetMemoryTimelineCapacity(memory_timeline_size);
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -225,6 +245,28 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (UseSmallObjectCache(num_bytes, allocation_attr)) {
+    const int size_class = RoundedBytes(num_bytes) / kMinAllocationSize - 1;
+    void* ptr = AllocateFromSmallObjectCache(size_class);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    // Carve a chunk of exactly the size class so that it can be recycled for
+    // any request of that class.
+    ptr = AllocateRawFromBins(unused_alignment,
+                              (size_class + 1) * kMinAllocationSize,
+                              allocation_attr);
+    if (ptr != nullptr) {
+      RegisterSmallObject(ptr, size_class);
+    }
+    return ptr;
+  }
+  return AllocateRawFromBins(unused_alignment, num_bytes, allocation_attr);
+}
+
+void* BFCAllocator::AllocateRawFromBins(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -391,6 +433,15 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Give the chunks parked in the small-object cache back to the bins before
+  // resorting to anything more expensive.
+  if (FlushSmallObjectCache()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   if ((freed_before == 0) && (!timestamped_chunks_.empty())) {
     // We're unable to satisfy an allocation request without a specific
     // timestamp requirement.  Rather than fail, try merging any held-out
@@ -476,6 +527,7 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
             std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        MaybeRecordMemoryEvent(true, *chunk);
 
 #ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
@@ -548,6 +600,10 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (ptr != nullptr && small_object_cache_ != nullptr &&
+      DeallocateToSmallObjectCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -558,12 +614,16 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     return;
   }
   mutex_lock l(lock_);
+  DeallocateRawInternalLocked(ptr);
+}
 
+void BFCAllocator::DeallocateRawInternalLocked(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
 
   MarkFree(h);
+  MaybeRecordMemoryEvent(false, *ChunkFromHandle(h));
 
   // Consider coalescing it.
   if (timing_counter_) {
@@ -578,6 +638,111 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   }
 }
 
+bool BFCAllocator::UseSmallObjectCache(
+    size_t num_bytes, const AllocationAttributes& allocation_attr) const {
+  // Chunks with timestamp requirements must go through the bins.
+  return small_object_cache_ != nullptr && num_bytes > 0 &&
+         num_bytes <= kMaxSmallObjectBytes &&
+         allocation_attr.freed_by_func == nullptr && timing_counter_ == nullptr;
+}
+
+BFCAllocator::SmallObjectCacheShard* BFCAllocator::ShardForThread() const {
+  // Threads are spread round-robin over the shards, so that a thread keeps
+  // recycling its own chunks without contending with most other threads.
+  static std::atomic<int> next_shard{0};
+  thread_local const int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) %
+      kNumSmallObjectCacheShards;
+  return &small_object_cache_[shard];
+}
+
+BFCAllocator::SmallObjectCacheShard* BFCAllocator::ShardForPtr(
+    const void* ptr) const {
+  const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr);
+  return &small_object_cache_[(p >> kMinAllocationBits) %
+                              kNumSmallObjectCacheShards];
+}
+
+void* BFCAllocator::AllocateFromSmallObjectCache(int size_class) {
+  SmallObjectCacheShard* shard = ShardForThread();
+  mutex_lock l(shard->mu);
+  std::vector<void*>& free_ptrs = shard->free_ptrs[size_class];
+  if (free_ptrs.empty()) {
+    return nullptr;
+  }
+  void* ptr = free_ptrs.back();
+  free_ptrs.pop_back();
+  num_small_object_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  return ptr;
+}
+
+void BFCAllocator::RegisterSmallObject(const void* ptr, int size_class) {
+  SmallObjectCacheShard* shard = ShardForPtr(ptr);
+  mutex_lock l(shard->mu);
+  shard->size_classes[ptr] = size_class;
+}
+
+bool BFCAllocator::DeallocateToSmallObjectCache(void* ptr) {
+  int size_class;
+  {
+    SmallObjectCacheShard* shard = ShardForPtr(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->size_classes.find(ptr);
+    if (it == shard->size_classes.end()) {
+      return false;
+    }
+    size_class = it->second;
+    if (timing_counter_ != nullptr) {
+      shard->size_classes.erase(it);
+      return false;
+    }
+  }
+  {
+    SmallObjectCacheShard* shard = ShardForThread();
+    mutex_lock l(shard->mu);
+    std::vector<void*>& free_ptrs = shard->free_ptrs[size_class];
+    if (free_ptrs.size() < kMaxCachedChunksPerSizeClass) {
+      free_ptrs.push_back(ptr);
+      return true;
+    }
+  }
+  // The free list is full: the chunk goes back to the bins, and must not be
+  // mistaken for a cached chunk if its memory is handed out again.
+  SmallObjectCacheShard* shard = ShardForPtr(ptr);
+  mutex_lock l(shard->mu);
+  shard->size_classes.erase(ptr);
+  return false;
+}
+
+bool BFCAllocator::FlushSmallObjectCache() {
+  if (small_object_cache_ == nullptr) {
+    return false;
+  }
+  std::vector<void*> ptrs;
+  for (int i = 0; i < kNumSmallObjectCacheShards; ++i) {
+    SmallObjectCacheShard* shard = &small_object_cache_[i];
+    mutex_lock l(shard->mu);
+    for (std::vector<void*>& free_ptrs : shard->free_ptrs) {
+      ptrs.insert(ptrs.end(), free_ptrs.begin(), free_ptrs.end());
+      free_ptrs.clear();
+    }
+  }
+  for (void* ptr : ptrs) {
+    {
+      SmallObjectCacheShard* shard = ShardForPtr(ptr);
+      mutex_lock l(shard->mu);
+      shard->size_classes.erase(ptr);
+    }
+    DeallocateRawInternalLocked(ptr);
+  }
+  if (ptrs.empty()) {
+    return false;
+  }
+  VLOG(1) << "Returned " << ptrs.size() << " chunks from the small-object cache"
+          << " of " << Name() << " to the bins";
+  return true;
+}
+
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
 // We merge Chunk(h2) into Chunk(h1).
 void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
@@ -788,6 +953,47 @@ bool BFCAllocator::MergeTimestampedChunks(size_t required_bytes) {
   return satisfied;
 }
 
+void BFCAllocator::SetMemoryTimelineCapacity(int64 capacity) {
+  mutex_lock l(lock_);
+  memory_timeline_.clear();
+  memory_timeline_.resize(std::max<int64>(capacity, 0));
+  num_memory_events_ = 0;
+}
+
+void BFCAllocator::MaybeRecordMemoryEvent(bool allocation, const Chunk& c) {
+  if (memory_timeline_.empty()) {
+    return;
+  }
+  MemoryEvent& event =
+      memory_timeline_[num_memory_events_++ % memory_timeline_.size()];
+  event.timestamp_us = Env::Default()->NowMicros();
+  event.allocation = allocation;
+  event.address = c.ptr;
+  event.size = c.size;
+  event.requested_size = c.requested_size;
+  event.bytes_in_use = stats_.bytes_in_use;
+  // A deallocation may run on any thread, so only allocations are attributed.
+  const char* op_name =
+      allocation ? ScopedMemoryDebugAnnotation::CurrentOpName() : nullptr;
+  if (op_name != nullptr) {
+    event.op_name.assign(op_name);
+    event.step_id = ScopedMemoryDebugAnnotation::CurrentStepId();
+  } else {
+    event.op_name.clear();
+    event.step_id = 0;
+  }
+  profiler::TraceMe trace_me(
+      [this, &event] {
+        return strings::StrCat(
+            event.allocation ? "MemoryAllocation" : "MemoryDeallocation",
+            "#allocator_name=", name_, ",bytes_in_use=", event.bytes_in_use,
+            ",size=", event.size, ",requested_size=", event.requested_size,
+            ",addr=", reinterpret_cast<uint64>(event.address),
+            ",tf_op=", event.op_name, ",step_id=", event.step_id, "#");
+      },
+      profiler::TraceMeLevel::kInfo);
+}
+
 bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
@@ -1070,16 +1276,36 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   }
 #endif
 
+  // Record the memory timeline, oldest event first.
+  const int64 timeline_capacity = memory_timeline_.size();
+  for (int64 i = std::max<int64>(num_memory_events_ - timeline_capacity, 0);
+       i < num_memory_events_; ++i) {
+    const MemoryEvent& event = memory_timeline_[i % timeline_capacity];
+    MemEvent* me = md.add_event();
+    me->set_timestamp_us(event.timestamp_us);
+    me->set_allocation(event.allocation);
+    me->set_address(reinterpret_cast<uint64>(event.address));
+    me->set_size(event.size);
+    me->set_requested_size(event.requested_size);
+    me->set_bytes_in_use(event.bytes_in_use);
+    me->set_op_name(event.op_name);
+    me->set_step_id(event.step_id);
+  }
+
   return md;
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  stats.num_allocs +=
+      num_small_object_cache_hits_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  num_small_object_cache_hits_.store(0, std::memory_order_relaxed);
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
@@ -23,6 +23,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -46,12 +47,21 @@ class MemoryDump;
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'small_object_cache' is true, freed chunks of at most
+// kMaxSmallObjectBytes are parked in sharded per-size-class free lists
+// instead of being returned to the bins, and later allocations of the same
+// size class are served from there without taking the allocator-wide lock.
+// Cached chunks remain in use from the point of view of the bins (and of
+// the stats), and are returned to the bins when an allocation would
+// otherwise fail.  Larger allocations are unaffected.
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false,
+               bool small_object_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -85,6 +95,14 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // Keeps the last 'capacity' allocation and deallocation events of the bins
+  // in a ring buffer (0, the default, records nothing).  The events are
+  // included in RecordMemoryMap() and in the memory dump written on OOM, and
+  // are emitted as TraceMe events while the profiler is active.  The op
+  // making an allocation is taken from ScopedMemoryDebugAnnotation.  Also set
+  // by the TF_BFC_MEMORY_TIMELINE_SIZE environment variable.
+  void SetMemoryTimelineCapacity(int64 capacity);
+
  private:
   struct Bin;
 
@@ -97,6 +115,50 @@ class BFCAllocator : public Allocator {
       const AllocationAttributes& allocation_attr);
 
   void DeallocateRawInternal(void* ptr);
+  void DeallocateRawInternalLocked(void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Small-object cache.  Allocations of at most kMaxSmallObjectBytes are
+  // rounded up to a multiple of kMinAllocationSize, which gives
+  // kNumSmallObjectSizeClasses size classes.
+  static const size_t kMaxSmallObjectBytes = 4096;
+  static const int kNumSmallObjectSizeClasses = 16;
+  static const int kNumSmallObjectCacheShards = 16;
+  // Upper bound on the free chunks of one size class held by one shard.
+  static const size_t kMaxCachedChunksPerSizeClass = 16;
+
+  struct SmallObjectCacheShard {
+    mutex mu;
+    // Free chunks parked by the threads mapped to this shard, indexed by
+    // size class.
+    std::vector<void*> free_ptrs[kNumSmallObjectSizeClasses] GUARDED_BY(mu);
+    // Size class of every chunk owned by the cache (whether currently
+    // handed out or parked in any shard) whose address maps to this shard.
+    absl::flat_hash_map<const void*, int> size_classes GUARDED_BY(mu);
+  };
+
+  bool UseSmallObjectCache(size_t num_bytes,
+                           const AllocationAttributes& allocation_attr) const;
+
+  // Returns a parked chunk of the given size class, or nullptr.
+  void* AllocateFromSmallObjectCache(int size_class);
+
+  // Records that 'ptr' is a chunk of the given size class owned by the cache.
+  void RegisterSmallObject(const void* ptr, int size_class);
+
+  // Parks 'ptr' if it is owned by the cache and there is room for it.
+  // Returns false if 'ptr' must be returned to the bins instead, in which
+  // case it is no longer owned by the cache.
+  bool DeallocateToSmallObjectCache(void* ptr);
+
+  // Returns every parked chunk to the bins.  Returns true if any chunk was
+  // returned.
+  bool FlushSmallObjectCache() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  SmallObjectCacheShard* ShardForThread() const;
+  SmallObjectCacheShard* ShardForPtr(const void* ptr) const;
+
+  void* AllocateRawFromBins(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
 
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
@@ -442,6 +504,21 @@ class BFCAllocator : public Allocator {
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  struct MemoryEvent {
+    uint64 timestamp_us = 0;
+    bool allocation = false;
+    const void* address = nullptr;
+    int64 size = 0;
+    int64 requested_size = 0;
+    int64 bytes_in_use = 0;
+    string op_name;
+    int64 step_id = 0;
+  };
+
+  // Appends an event for chunk 'c' to the memory timeline, if it is enabled.
+  void MaybeRecordMemoryEvent(bool allocation, const Chunk& c)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Information about a Bin that is useful for debugging.
   struct BinDebugInfo {
     size_t total_bytes_in_use = 0;
@@ -519,6 +596,12 @@ class BFCAllocator : public Allocator {
 
   std::atomic<uint64> safe_frontier_ = {0};
 
+  // Null unless the small-object cache is enabled.
+  std::unique_ptr<SmallObjectCacheShard[]> small_object_cache_;
+  // Allocations served by the small-object cache since the last ClearStats;
+  // added to stats_.num_allocs by GetStats.
+  std::atomic<int64> num_small_object_cache_hits_ = {0};
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ GUARDED_BY(lock_);
@@ -534,6 +617,11 @@ class BFCAllocator : public Allocator {
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
+
+  // Ring buffer of the memory timeline, and the number of events recorded
+  // into it.
+  std::vector<MemoryEvent> memory_timeline_ GUARDED_BY(lock_);
+  int64 num_memory_events_ GUARDED_BY(lock_) = 0;
 #ifdef TENSORFLOW_MEM_DEBUG
   int64 action_counter_ GUARDED_BY(lock_);
 #define MEM_DEBUG_SIZE_HISTORY_SIZE 4096
@@ -0,0 +1,455 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_fusion.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+// Longer execution keys are not fused, so that a batch holds at least a few
+// collectives.
+constexpr int64 kMaxExecKeyBytes = 1024;
+
+}  // namespace
+
+constexpr int64 CollectiveFusion::kMaxCompositionBytes;
+
+struct CollectiveFusion::Batch {
+  ~Batch() {
+    // The ops are owned by the params of the first collective.
+    col_params.merge_op.release();
+    col_params.final_op.release();
+  }
+
+  string fusion_key;
+  int64 seq = 0;
+  std::vector<Entry> entries;
+  string exec_key;
+  CollectiveParams col_params;
+  Tensor value;
+};
+
+/*static*/
+std::unique_ptr<CollectiveFusion> CollectiveFusion::MaybeCreate(
+    CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr, LaunchFn launch) {
+  int64 window_micros;
+  Status s = ReadInt64FromEnvVar("TF_COLLECTIVE_FUSION_WINDOW_USECS", 0,
+                                 &window_micros);
+  if (!s.ok()) {
+    LOG(ERROR) << "Collective fusion disabled: " << s;
+    return nullptr;
+  }
+  if (window_micros <= 0) return nullptr;
+  int64 max_tensor_bytes;
+  s = ReadInt64FromEnvVar("TF_COLLECTIVE_FUSION_MAX_TENSOR_BYTES", 256 << 10,
+                          &max_tensor_bytes);
+  if (!s.ok()) {
+    LOG(ERROR) << "Collective fusion disabled: " << s;
+    return nullptr;
+  }
+  return std::unique_ptr<CollectiveFusion>(
+      new CollectiveFusion(col_exec, dev_mgr, window_micros, max_tensor_bytes,
+                           std::move(launch)));
+}
+
+CollectiveFusion::CollectiveFusion(CollectiveExecutor* col_exec,
+                                   const DeviceMgr* dev_mgr,
+                                   int64 window_micros, int64 max_tensor_bytes,
+                                   LaunchFn launch)
+    : col_exec_(col_exec),
+      dev_mgr_(dev_mgr),
+      window_micros_(window_micros),
+      max_tensor_bytes_(max_tensor_bytes),
+      launch_(std::move(launch)) {}
+
+/*static*/
+bool CollectiveFusion::IsFusible(const CollectiveParams& col_params,
+                                 const Tensor& input, int64 max_tensor_bytes) {
+  return col_params.instance.type == REDUCTION_COLLECTIVE &&
+         col_params.group.device_type == DEVICE_CPU &&
+         col_params.group.group_size > 1 &&
+         col_params.instance.impl_details.dependencies.empty() &&
+         DataTypeCanUseMemcpy(input.dtype()) &&
+         input.TotalBytes() <= max_tensor_bytes;
+}
+
+/*static*/
+string CollectiveFusion::FusionKey(const CollectiveParams& col_params) {
+  return strings::StrCat(
+      col_params.group.group_key, ":",
+      col_params.instance.impl_details.collective_name, ":",
+      DataTypeString(col_params.instance.data_type), ":",
+      col_params.merge_op ? col_params.merge_op->type_string() : "", ":",
+      col_params.final_op ? col_params.final_op->type_string() : "");
+}
+
+/*static*/
+Status CollectiveFusion::EncodeComposition(const std::vector<string>& exec_keys,
+                                           Tensor* tensor) {
+  const string joined = str_util::Join(exec_keys, "\n");
+  if (exec_keys.empty() || joined.size() > kMaxCompositionBytes) {
+    return errors::InvalidArgument("Cannot encode a batch of ",
+                                   exec_keys.size(), " collectives in ",
+                                   joined.size(), " bytes");
+  }
+  *tensor = Tensor(DT_UINT8, TensorShape({kMaxCompositionBytes}));
+  char* data = const_cast<char*>(tensor->tensor_data().data());
+  memset(data, 0, kMaxCompositionBytes);
+  memcpy(data, joined.data(), joined.size());
+  return Status::OK();
+}
+
+/*static*/
+Status CollectiveFusion::DecodeComposition(const Tensor& tensor,
+                                           std::vector<string>* exec_keys) {
+  if (tensor.dtype() != DT_UINT8 ||
+      tensor.NumElements() != kMaxCompositionBytes) {
+    return errors::Internal("Invalid collective batch ",
+                            tensor.DebugString());
+  }
+  StringPiece data = tensor.tensor_data();
+  const size_t end = data.find('\0');
+  if (end != StringPiece::npos) data = data.substr(0, end);
+  *exec_keys = str_util::Split(data, '\n', str_util::SkipEmpty());
+  if (exec_keys->empty()) {
+    return errors::Internal("Empty collective batch");
+  }
+  return Status::OK();
+}
+
+bool CollectiveFusion::MaybeEnqueue(OpKernelContext* ctx,
+                                    const CollectiveParams& col_params,
+                                    const string& exec_key,
+                                    const StatusCallback& done) {
+  if (exec_key.size() > kMaxExecKeyBytes ||
+      !IsFusible(col_params, ctx->input(0), max_tensor_bytes_)) {
+    return false;
+  }
+  const string fusion_key = FusionKey(col_params);
+  const int rank = col_params.default_rank;
+  const string queue_key = strings::StrCat(fusion_key, "@", rank);
+  std::unique_ptr<Batch> flushed;
+  std::vector<std::unique_ptr<Batch>> ready;
+  bool schedule = false;
+  bool receive = false;
+  {
+    mutex_lock l(mu_);
+    if (!abort_status_.ok()) return false;
+    Queue& queue = queues_[queue_key];
+    queue.fusion_key = fusion_key;
+    queue.rank = rank;
+    queue.col_params = &col_params;
+    queue.pending[exec_key] = Entry{ctx, &col_params, exec_key, done};
+    if (rank == 0) {
+      queue.composition_bytes += exec_key.size() + 1;
+      if (queue.composition_bytes + kMaxExecKeyBytes > kMaxCompositionBytes) {
+        flushed = FlushLocked(&queue);
+      } else if (!queue.flush_scheduled) {
+        queue.flush_scheduled = true;
+        schedule = true;
+      }
+    } else {
+      receive = TakeReadyLocked(&queue, &ready);
+    }
+  }
+  if (schedule) {
+    CollectiveExecutor* col_exec = col_exec_;
+    col_exec->Ref();
+    SchedNonBlockingClosureAfter(window_micros_, [this, col_exec, queue_key] {
+      OnWindowExpired(queue_key);
+      col_exec->Unref();
+    });
+  }
+  if (flushed != nullptr) {
+    SendComposition(*flushed);
+    RunBatch(std::move(flushed));
+  }
+  for (auto& batch : ready) {
+    RunBatch(std::move(batch));
+  }
+  if (receive) ReceiveComposition(queue_key);
+  return true;
+}
+
+void CollectiveFusion::StartAbort(const Status& s) {
+  std::vector<Entry> entries;
+  {
+    mutex_lock l(mu_);
+    if (abort_status_.ok()) abort_status_ = s;
+    for (auto& it : queues_) {
+      for (auto& p : it.second.pending) {
+        entries.push_back(std::move(p.second));
+      }
+    }
+    queues_.clear();
+  }
+  for (Entry& entry : entries) {
+    entry.done(s);
+  }
+}
+
+std::unique_ptr<CollectiveFusion::Batch> CollectiveFusion::FlushLocked(
+    Queue* queue) {
+  std::vector<Entry> entries;
+  for (auto& p : queue->pending) {
+    entries.push_back(std::move(p.second));
+  }
+  queue->pending.clear();
+  queue->composition_bytes = 0;
+  return MakeBatchLocked(queue, std::move(entries));
+}
+
+bool CollectiveFusion::TakeReadyLocked(
+    Queue* queue, std::vector<std::unique_ptr<Batch>>* ready) {
+  while (!queue->compositions.empty()) {
+    const std::vector<string>& exec_keys = queue->compositions.front();
+    for (const string& exec_key : exec_keys) {
+      if (queue->pending.count(exec_key) == 0) return false;
+    }
+    std::vector<Entry> entries;
+    for (const string& exec_key : exec_keys) {
+      auto it = queue->pending.find(exec_key);
+      entries.push_back(std::move(it->second));
+      queue->pending.erase(it);
+      queue->covered.erase(exec_key);
+    }
+    queue->compositions.pop_front();
+    ready->push_back(MakeBatchLocked(queue, std::move(entries)));
+  }
+  if (queue->receiving) return false;
+  // The collectives not in a received batch are in the next one.
+  for (const auto& p : queue->pending) {
+    if (queue->covered.count(p.first) == 0) {
+      queue->receiving = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<CollectiveFusion::Batch> CollectiveFusion::MakeBatchLocked(
+    Queue* queue, std::vector<Entry> entries) {
+  std::unique_ptr<Batch> batch(new Batch);
+  batch->fusion_key = queue->fusion_key;
+  batch->seq = queue->next_seq++;
+  batch->exec_key = strings::StrCat("fused:", queue->fusion_key, ":",
+                                    batch->seq, ":", entries[0].exec_key);
+  batch->entries = std::move(entries);
+  return batch;
+}
+
+void CollectiveFusion::OnWindowExpired(const string& queue_key) {
+  std::unique_ptr<Batch> batch;
+  {
+    mutex_lock l(mu_);
+    auto it = queues_.find(queue_key);
+    if (it == queues_.end()) return;
+    it->second.flush_scheduled = false;
+    if (it->second.pending.empty()) return;
+    batch = FlushLocked(&it->second);
+  }
+  SendComposition(*batch);
+  RunBatch(std::move(batch));
+}
+
+void CollectiveFusion::SendComposition(const Batch& batch) {
+  const CollectiveParams& col_params = *batch.entries[0].col_params;
+  std::vector<string> exec_keys;
+  for (const Entry& entry : batch.entries) {
+    exec_keys.push_back(entry.exec_key);
+  }
+  Device* device = nullptr;
+  DeviceLocality locality;
+  Status s = collective_util::InitializeDeviceAndLocality(
+      dev_mgr_, col_params.instance.device_names[col_params.default_rank],
+      &device, &locality);
+  for (int rank = 1; s.ok() && rank < col_params.group.group_size; ++rank) {
+    Tensor* tensor = new Tensor;
+    s = EncodeComposition(exec_keys, tensor);
+    if (!s.ok()) {
+      delete tensor;
+      break;
+    }
+    col_exec_->PostToPeer(
+        col_params.instance.device_names[rank],
+        col_params.instance.task_names[rank],
+        strings::StrCat("fusion:", batch.fusion_key, ":", batch.seq, ":",
+                        rank),
+        device, nullptr /*from_device_ctx*/, AllocatorAttributes(), tensor,
+        locality, [tensor](const Status& s) {
+          if (!s.ok()) {
+            LOG(WARNING) << "Failed to send collective batch: " << s;
+          }
+          delete tensor;
+        });
+  }
+  if (!s.ok()) col_exec_->StartAbort(s);
+}
+
+void CollectiveFusion::ReceiveComposition(const string& queue_key) {
+  string fusion_key;
+  int rank;
+  int64 seq;
+  const CollectiveParams* col_params;
+  {
+    mutex_lock l(mu_);
+    auto it = queues_.find(queue_key);
+    if (it == queues_.end()) return;
+    fusion_key = it->second.fusion_key;
+    rank = it->second.rank;
+    seq = it->second.num_received;
+    col_params = it->second.col_params;
+  }
+  Device* device = nullptr;
+  DeviceLocality locality;
+  Status s = collective_util::InitializeDeviceAndLocality(
+      dev_mgr_, col_params->instance.device_names[rank], &device, &locality);
+  if (!s.ok()) {
+    FailQueue(queue_key, s);
+    return;
+  }
+  Tensor* tensor = new Tensor(DT_UINT8, TensorShape({kMaxCompositionBytes}));
+  CollectiveExecutor* col_exec = col_exec_;
+  col_exec->Ref();
+  col_exec->RecvFromPeer(
+      col_params->instance.device_names[0], col_params->instance.task_names[0],
+      col_params->task.is_local[0],
+      strings::StrCat("fusion:", fusion_key, ":", seq, ":", rank), device,
+      nullptr /*to_device_ctx*/, AllocatorAttributes(), tensor, locality,
+      0 /*stream_index*/,
+      [this, col_exec, queue_key, tensor](const Status& s) {
+        OnCompositionReceived(queue_key, *tensor, s);
+        delete tensor;
+        col_exec->Unref();
+      });
+}
+
+void CollectiveFusion::OnCompositionReceived(const string& queue_key,
+                                             const Tensor& tensor,
+                                             const Status& s) {
+  std::vector<string> exec_keys;
+  Status status = s;
+  if (status.ok()) status = DecodeComposition(tensor, &exec_keys);
+  if (!status.ok()) {
+    FailQueue(queue_key, status);
+    return;
+  }
+  std::vector<std::unique_ptr<Batch>> ready;
+  bool receive = false;
+  {
+    mutex_lock l(mu_);
+    auto it = queues_.find(queue_key);
+    if (it == queues_.end()) return;
+    Queue& queue = it->second;
+    queue.receiving = false;
+    ++queue.num_received;
+    queue.covered.insert(exec_keys.begin(), exec_keys.end());
+    queue.compositions.push_back(std::move(exec_keys));
+    receive = TakeReadyLocked(&queue, &ready);
+  }
+  for (auto& batch : ready) {
+    RunBatch(std::move(batch));
+  }
+  if (receive) ReceiveComposition(queue_key);
+}
+
+void CollectiveFusion::RunBatch(std::unique_ptr<Batch> batch) {
+  const Entry& first = batch->entries[0];
+  const CollectiveParams& first_params = *first.col_params;
+  int64 num_elements = 0;
+  for (const Entry& entry : batch->entries) {
+    num_elements += entry.ctx->input(0).NumElements();
+  }
+  Status s = first.ctx->allocate_temp(first_params.instance.data_type,
+                                      TensorShape({num_elements}),
+                                      &batch->value);
+  if (!s.ok()) {
+    for (Entry& entry : batch->entries) {
+      entry.done(s);
+    }
+    return;
+  }
+  char* data = const_cast<char*>(batch->value.tensor_data().data());
+  for (const Entry& entry : batch->entries) {
+    StringPiece input = entry.ctx->input(0).tensor_data();
+    memcpy(data, input.data(), input.size());
+    data += input.size();
+  }
+
+  CollectiveParams* col_params = &batch->col_params;
+  col_params->group = first_params.group;
+  col_params->instance = first_params.instance;
+  col_params->instance.shape = batch->value.shape();
+  col_params->task = first_params.task;
+  col_params->name = first_params.name;
+  col_params->default_rank = first_params.default_rank;
+  col_params->subdiv_rank = first_params.subdiv_rank;
+  col_params->merge_op.reset(first_params.merge_op.get());
+  col_params->final_op.reset(first_params.final_op.get());
+  VLOG(1) << "Fusing " << batch->entries.size() << " collectives of "
+          << num_elements << " elements as " << batch->exec_key;
+
+  Batch* b = batch.release();
+  launch_(first.ctx, b->col_params, b->exec_key, &b->value, &b->value,
+          [b](const Status& s) {
+            if (s.ok()) {
+              const char* data = b->value.tensor_data().data();
+              for (const Entry& entry : b->entries) {
+                Tensor* output = entry.ctx->mutable_output(0);
+                StringPiece out = output->tensor_data();
+                memcpy(const_cast<char*>(out.data()), data, out.size());
+                data += out.size();
+              }
+            }
+            for (Entry& entry : b->entries) {
+              entry.done(s);
+            }
+            delete b;
+          });
+}
+
+void CollectiveFusion::FailQueue(const string& queue_key, const Status& s) {
+  std::vector<Entry> entries;
+  {
+    mutex_lock l(mu_);
+    auto it = queues_.find(queue_key);
+    if (it == queues_.end()) return;
+    for (auto& p : it->second.pending) {
+      entries.push_back(std::move(p.second));
+    }
+    queues_.erase(it);
+  }
+  for (Entry& entry : entries) {
+    entry.done(s);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,159 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_FUSION_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_FUSION_H_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+class DeviceMgr;
+class OpKernelContext;
+
+// Fuses the small all-reduces which a step issues concurrently on the CPU
+// devices of a group into one all-reduce of the concatenation of their
+// inputs, which pays the latency of the collective once for the batch.
+//
+// The all-reduces with the same group, data type, ops and implementation are
+// buffered for a short window. Every device of the group must run the same
+// batches in the same order, so the device of rank 0 decides them: when its
+// window expires, it runs the all-reduces it has buffered as a batch, and
+// sends their execution keys to the other devices, which run the same batch
+// once all of its all-reduces have been issued locally.
+//
+// Fusion is enabled by setting TF_COLLECTIVE_FUSION_WINDOW_USECS to the
+// length of the window, with the same value on all the workers. Only
+// all-reduces of at most TF_COLLECTIVE_FUSION_MAX_TENSOR_BYTES (default:
+// 256KB) are fused.
+class CollectiveFusion {
+ public:
+  // Launches the collective `col_params` of the op of `ctx` with key
+  // `exec_key`, from `input` into `output`.
+  typedef std::function<void(
+      OpKernelContext* ctx, const CollectiveParams& col_params,
+      const string& exec_key, const Tensor* input, Tensor* output,
+      const StatusCallback& done)>
+      LaunchFn;
+
+  // The size of the message which describes a batch.
+  static constexpr int64 kMaxCompositionBytes = 16384;
+
+  // Returns null if fusion is not enabled.
+  static std::unique_ptr<CollectiveFusion> MaybeCreate(
+      CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+      LaunchFn launch);
+
+  CollectiveFusion(CollectiveExecutor* col_exec, const DeviceMgr* dev_mgr,
+                   int64 window_micros, int64 max_tensor_bytes,
+                   LaunchFn launch);
+
+  // Buffers the collective of the op of `ctx` and returns true if it can be
+  // fused, in which case `done` is called when the batch completes. Returns
+  // false otherwise.
+  bool MaybeEnqueue(OpKernelContext* ctx, const CollectiveParams& col_params,
+                    const string& exec_key, const StatusCallback& done);
+
+  // Fails the buffered collectives.
+  void StartAbort(const Status& s);
+
+  // Returns true if an all-reduce of `input` described by `col_params` can be
+  // fused.
+  static bool IsFusible(const CollectiveParams& col_params,
+                        const Tensor& input, int64 max_tensor_bytes);
+  // Returns the key of the collectives which can be fused with `col_params`,
+  // the same on all the devices of the group.
+  static string FusionKey(const CollectiveParams& col_params);
+  // Writes the execution keys of a batch to a tensor of
+  // kMaxCompositionBytes bytes, and reads them back.
+  static Status EncodeComposition(const std::vector<string>& exec_keys,
+                                  Tensor* tensor);
+  static Status DecodeComposition(const Tensor& tensor,
+                                  std::vector<string>* exec_keys);
+
+ private:
+  struct Entry {
+    OpKernelContext* ctx;
+    const CollectiveParams* col_params;
+    string exec_key;
+    StatusCallback done;
+  };
+  struct Batch;
+  // The collectives of one device with the same fusion key.
+  struct Queue {
+    string fusion_key;
+    int rank = 0;
+    // The params of the last buffered collective, to reach the group.
+    const CollectiveParams* col_params = nullptr;
+    std::map<string, Entry> pending;
+    int64 composition_bytes = 0;
+    bool flush_scheduled = false;
+    int64 next_seq = 0;
+    // Followers only: the batches received from the leader and not yet run,
+    // and the execution keys they contain.
+    std::deque<std::vector<string>> compositions;
+    std::unordered_set<string> covered;
+    int64 num_received = 0;
+    bool receiving = false;
+  };
+
+  // Turns the pending collectives of the leader `queue` into a batch.
+  std::unique_ptr<Batch> FlushLocked(Queue* queue)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Turns the pending collectives of the follower `queue` which complete
+  // received compositions into batches, and returns true if the next
+  // composition should be received.
+  bool TakeReadyLocked(Queue* queue, std::vector<std::unique_ptr<Batch>>* ready)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  std::unique_ptr<Batch> MakeBatchLocked(Queue* queue,
+                                         std::vector<Entry> entries)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void OnWindowExpired(const string& queue_key);
+  void SendComposition(const Batch& batch);
+  void ReceiveComposition(const string& queue_key);
+  void OnCompositionReceived(const string& queue_key, const Tensor& tensor,
+                             const Status& s);
+  void RunBatch(std::unique_ptr<Batch> batch);
+  void FailQueue(const string& queue_key, const Status& s);
+
+  CollectiveExecutor* const col_exec_;  // Not owned.
+  const DeviceMgr* const dev_mgr_;      // Not owned.
+  const int64 window_micros_;
+  const int64 max_tensor_bytes_;
+  const LaunchFn launch_;
+
+  mutex mu_;
+  Status abort_status_ GUARDED_BY(mu_);
+  // By fusion key and rank.
+  std::unordered_map<string, Queue> queues_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CollectiveFusion);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_FUSION_H_
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+CollectiveParams ReductionParams() {
+  CollectiveParams cp;
+  cp.group.group_key = 5;
+  cp.group.group_size = 4;
+  cp.group.device_type = DeviceType(DEVICE_CPU);
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.impl_details.collective_name = "RingReduce";
+  return cp;
+}
+
+TEST(CollectiveFusionTest, IsFusible) {
+  CollectiveParams cp = ReductionParams();
+  Tensor input(DT_FLOAT, TensorShape({16}));
+  EXPECT_TRUE(CollectiveFusion::IsFusible(cp, input, 1024));
+  EXPECT_FALSE(CollectiveFusion::IsFusible(cp, input, 32));
+
+  cp.instance.impl_details.dependencies = {3};
+  EXPECT_FALSE(CollectiveFusion::IsFusible(cp, input, 1024));
+  cp.instance.impl_details.dependencies.clear();
+
+  cp.group.device_type = DeviceType(DEVICE_GPU);
+  EXPECT_FALSE(CollectiveFusion::IsFusible(cp, input, 1024));
+  cp.group.device_type = DeviceType(DEVICE_CPU);
+
+  cp.group.group_size = 1;
+  EXPECT_FALSE(CollectiveFusion::IsFusible(cp, input, 1024));
+  cp.group.group_size = 4;
+
+  cp.instance.type = BROADCAST_COLLECTIVE;
+  EXPECT_FALSE(CollectiveFusion::IsFusible(cp, input, 1024));
+}
+
+TEST(CollectiveFusionTest, FusionKey) {
+  CollectiveParams cp = ReductionParams();
+  const string key = CollectiveFusion::FusionKey(cp);
+  cp.instance.instance_key = 17;
+  cp.default_rank = 2;
+  EXPECT_EQ(CollectiveFusion::FusionKey(cp), key);
+
+  cp.instance.data_type = DT_DOUBLE;
+  EXPECT_NE(CollectiveFusion::FusionKey(cp), key);
+  cp.instance.data_type = DT_FLOAT;
+  cp.instance.impl_details.collective_name = "HalvingDoublingReduce";
+  EXPECT_NE(CollectiveFusion::FusionKey(cp), key);
+  cp.instance.impl_details.collective_name = "RingReduce";
+  cp.group.group_key = 6;
+  EXPECT_NE(CollectiveFusion::FusionKey(cp), key);
+}
+
+TEST(CollectiveFusionTest, Composition) {
+  const std::vector<string> exec_keys = {"1:0:0", "2:0:0", "frame:10:3"};
+  Tensor tensor;
+  TF_ASSERT_OK(CollectiveFusion::EncodeComposition(exec_keys, &tensor));
+  EXPECT_EQ(tensor.NumElements(), CollectiveFusion::kMaxCompositionBytes);
+  std::vector<string> decoded;
+  TF_ASSERT_OK(CollectiveFusion::DecodeComposition(tensor, &decoded));
+  EXPECT_EQ(decoded, exec_keys);
+
+  EXPECT_FALSE(CollectiveFusion::EncodeComposition({}, &tensor).ok());
+  const string long_key(CollectiveFusion::kMaxCompositionBytes, 'k');
+  EXPECT_FALSE(
+      CollectiveFusion::EncodeComposition({long_key, "1:0:0"}, &tensor).ok());
+  EXPECT_FALSE(CollectiveFusion::DecodeComposition(Tensor(DT_UINT8, {8}),
+                                                   &decoded)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
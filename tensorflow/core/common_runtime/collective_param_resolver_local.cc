@@ -57,13 +57,38 @@ void CollectiveParamResolverLocal::CompleteGroupAsync(
 }
 
 namespace {
+// All-reduces of at most this many bytes are bound by latency.
+constexpr int64 kSmallReductionBytes = 1 << 20;
+// The smallest groups which use the halving-doubling all-reduce for small
+// tensors, and the torus all-reduce for large tensors, instead of the ring.
+constexpr int kMinHalvingDoublingGroupSize = 8;
+constexpr int kMinTorusGroupSize = 32;
+
+// Picks the all-reduce algorithm from the communication hint, or for CPU
+// devices from the size of the tensor and of the group.
+const char* GetReductionName(const CollectiveParams* cp) {
+  const string& hint = cp->instance.impl_details.communication_hint;
+  if (hint == "ring") return "RingReduce";
+  if (hint == "halving_doubling") return "HalvingDoublingReduce";
+  if (hint == "torus") return "TorusReduce";
+  if (cp->group.device_type != "CPU") return "RingReduce";
+  const int64 num_bytes = cp->instance.shape.num_elements() *
+                          DataTypeSize(cp->instance.data_type);
+  if (cp->group.group_size >= kMinHalvingDoublingGroupSize &&
+      num_bytes <= kSmallReductionBytes) {
+    return "HalvingDoublingReduce";
+  }
+  if (cp->group.group_size >= kMinTorusGroupSize) return "TorusReduce";
+  return "RingReduce";
+}
+
 const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
   switch (cp->instance.type) {
     case BROADCAST_COLLECTIVE:
       return "HierarchicalTreeBroadcast";
 
     case REDUCTION_COLLECTIVE:
-      return nccl ? "NcclReduce" : "RingReduce";
+      return nccl ? "NcclReduce" : GetReductionName(cp);
 
     case GATHER_COLLECTIVE:
       return "RingGather";
@@ -53,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/refcount.h"
@@ -660,7 +661,9 @@ Status DirectSession::RunInternal(
   if (ShouldUseRunHandlerPool(run_options) &&
       run_options.experimental().use_run_handler_pool()) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get(step_id);
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        step_id, run_options.timeout_in_ms(),
+        run_options.experimental().run_handler_pool_options());
   }
   auto* handler_ptr = handler.get();
 
@@ -1297,6 +1300,15 @@ Status DirectSession::CreateExecutors(
       nullptr, nullptr, session_metadata));
 
   GraphOptimizer optimizer(optimizer_opts);
+  const DebugOptions& debug_options =
+      options.callable_options.run_options().debug_options();
+  auto executor_type = options_.config.experimental().executor_type();
+  // Optimizing a partition and creating its executor are independent of the
+  // other partitions, so they run on the inter-op thread pool once the
+  // partitions have been set up below.
+  std::vector<std::function<Status()>> partition_fns;
+  partition_fns.reserve(graphs.size());
+  mutex debug_mu;
   for (auto iter = graphs.begin(); iter != graphs.end(); ++iter) {
     const string& partition_name = iter->first;
     std::unique_ptr<Graph>& partition_graph = iter->second;
@@ -1316,6 +1328,12 @@ Status DirectSession::CreateExecutors(
     params.device = device;
     params.session_metadata = session_metadata;
     params.function_library = lib;
+    for (const string& device_type :
+         options_.config.experimental().temp_arena_device_types()) {
+      if (device_type == device->device_type()) {
+        params.use_temp_arena = true;
+      }
+    }
     auto opseg = device->op_segment();
     params.create_kernel = [this, lib, opseg](const NodeDef& ndef,
                                               OpKernel** kernel) {
@@ -1345,31 +1363,58 @@ Status DirectSession::CreateExecutors(
       return Status::OK();
     };
 
-    optimizer.Optimize(lib, options_.env, device, &partition_graph,
-                       /*shape_map=*/nullptr);
+    item->executor = nullptr;
+    item->device = device;
+    partition_fns.push_back([this, &optimizer, &debug_options, &executor_type,
+                             &debug_mu, lib, device, params, item,
+                             &partition_graph]() -> Status {
+      optimizer.Optimize(lib, options_.env, device, &partition_graph,
+                         /*shape_map=*/nullptr);
+
+      // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
+      if (!debug_options.debug_tensor_watch_opts().empty()) {
+        mutex_lock l(debug_mu);
+        TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
+            debug_options, partition_graph.get(), params.device));
+      }
 
-    // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
-    const DebugOptions& debug_options =
-        options.callable_options.run_options().debug_options();
-    if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, partition_graph.get(), params.device));
-    }
+      TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device->device_type()),
+                                           device->name(),
+                                           partition_graph.get()));
 
-    TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device->device_type()),
-                                         device->name(),
-                                         partition_graph.get()));
+      TF_RETURN_IF_ERROR(NewExecutor(executor_type, params, *partition_graph,
+                                     &item->executor));
+      if (!options_.config.experimental().disable_output_partition_graphs() ||
+          options_.config.graph_options().build_cost_model() > 0) {
+        item->graph = std::move(partition_graph);
+      }
+      return Status::OK();
+    });
+  }
 
-    item->executor = nullptr;
-    item->device = device;
-    auto executor_type = options_.config.experimental().executor_type();
-    TF_RETURN_IF_ERROR(
-        NewExecutor(executor_type, params, *partition_graph, &item->executor));
-    if (!options_.config.experimental().disable_output_partition_graphs() ||
-        options_.config.graph_options().build_cost_model() > 0) {
-      item->graph = std::move(partition_graph);
+  // The calling thread handles the last partition itself, so a single
+  // partition never pays for a thread switch. A caller that is already
+  // running on the pool (e.g. from inside a step) handles every partition,
+  // since blocking it on the pool could deadlock.
+  thread::ThreadPool* pool = thread_pools_[0].first;
+  const bool run_inline = pool->CurrentThreadId() >= 0;
+  std::vector<Status> partition_status(partition_fns.size());
+  BlockingCounter counter(static_cast<int>(partition_fns.size()));
+  for (size_t i = 0; i < partition_fns.size(); ++i) {
+    auto fn = [&partition_fns, &partition_status, &counter, i]() {
+      partition_status[i] = partition_fns[i]();
+      counter.DecrementCount();
+    };
+    if (!run_inline && i + 1 < partition_fns.size()) {
+      pool->Schedule(std::move(fn));
+    } else {
+      fn();
     }
   }
+  counter.Wait();
+  for (const Status& s : partition_status) {
+    TF_RETURN_IF_ERROR(s);
+  }
 
   // Cache the mapping from input/output names to graph elements to
   // avoid recomputing it every time.
@@ -1815,11 +1860,13 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   RunCallableCallFrame(DirectSession* session,
                        ExecutorsAndKeys* executors_and_keys,
                        const std::vector<Tensor>* feed_tensors,
-                       std::vector<Tensor>* fetch_tensors)
+                       std::vector<Tensor>* fetch_tensors,
+                       const std::vector<Tensor>* bound_fetch_tensors)
       : session_(session),
         executors_and_keys_(executors_and_keys),
         feed_tensors_(feed_tensors),
-        fetch_tensors_(fetch_tensors) {}
+        fetch_tensors_(fetch_tensors),
+        bound_fetch_tensors_(bound_fetch_tensors) {}
 
   size_t num_args() const override {
     return executors_and_keys_->input_types.size();
@@ -1848,11 +1895,28 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     return Status::OK();
   }
 
+  bool GetRetvalBuffer(int index, DataType dtype, const TensorShape& shape,
+                       Tensor* buffer) override {
+    if (bound_fetch_tensors_ == nullptr ||
+        index >= bound_fetch_tensors_->size()) {
+      return false;
+    }
+    const Tensor& bound = (*bound_fetch_tensors_)[index];
+    if (!bound.IsInitialized() || bound.dtype() != dtype ||
+        bound.shape() != shape || !DataTypeCanUseMemcpy(dtype)) {
+      return false;
+    }
+    *buffer = bound;
+    return true;
+  }
+
  private:
   DirectSession* const session_;                   // Not owned.
   ExecutorsAndKeys* const executors_and_keys_;     // Not owned.
   const std::vector<Tensor>* const feed_tensors_;  // Not owned.
   std::vector<Tensor>* const fetch_tensors_;       // Not owned.
+  // Null if no fetches are bound.
+  const std::vector<Tensor>* const bound_fetch_tensors_;  // Not owned.
 };
 
 ::tensorflow::Status DirectSession::RunCallable(
@@ -1872,6 +1936,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
 
   // Check if we already have an executor for these arguments.
   std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
+  std::shared_ptr<const CallableBindings> bindings;
   const int64 step_id = step_id_counter_.fetch_add(1);
 
   {
@@ -1879,7 +1944,9 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     if (handle >= next_callable_handle_) {
       return errors::InvalidArgument("No such callable handle: ", handle);
     }
-    executors_and_keys = callables_[handle].executors_and_keys;
+    const Callable& callable = callables_[handle];
+    executors_and_keys = callable.executors_and_keys;
+    bindings = callable.bindings;
   }
 
   if (!executors_and_keys) {
@@ -1894,10 +1961,15 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
 
   // Configure a call frame for the step, which we use to feed and
   // fetch values to and from the executors.
-  if (feed_tensors.size() != executors_and_keys->input_types.size()) {
+  const std::vector<Tensor>* feeds = &feed_tensors;
+  if (feed_tensors.empty() && bindings != nullptr &&
+      !bindings->feed_tensors.empty()) {
+    feeds = &bindings->feed_tensors;
+  }
+  if (feeds->size() != executors_and_keys->input_types.size()) {
     return errors::InvalidArgument(
         "Expected ", executors_and_keys->input_types.size(),
-        " feed tensors, but got ", feed_tensors.size());
+        " feed tensors, but got ", feeds->size());
   }
   if (fetch_tensors != nullptr) {
     fetch_tensors->resize(executors_and_keys->output_types.size());
@@ -1908,7 +1980,7 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   }
 
   size_t input_size = 0;
-  for (auto& tensor : feed_tensors) {
+  for (auto& tensor : *feeds) {
     input_size += tensor.AllocatedBytes();
   }
   metrics::RecordGraphInputTensors(input_size);
@@ -1916,8 +1988,11 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   // A specialized CallFrame implementation that takes advantage of the
   // optimized RunCallable interface.
 
-  RunCallableCallFrame call_frame(this, executors_and_keys.get(), &feed_tensors,
-                                  fetch_tensors);
+  RunCallableCallFrame call_frame(
+      this, executors_and_keys.get(), feeds, fetch_tensors,
+      bindings != nullptr && !bindings->fetch_tensors.empty()
+          ? &bindings->fetch_tensors
+          : nullptr);
 
   if (LogMemory::IsEnabled()) {
     LogMemory::RecordStep(step_id, run_state_args.handle);
@@ -1938,6 +2013,57 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
   return Status::OK();
 }
 
+::tensorflow::Status DirectSession::BindCallable(
+    CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+    const std::vector<Tensor>& fetch_tensors) {
+  mutex_lock l(callables_lock_);
+  if (handle >= next_callable_handle_) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  auto it = callables_.find(handle);
+  if (it == callables_.end()) {
+    return errors::InvalidArgument(
+        "Attempted to bind callable after handle was released: ", handle);
+  }
+  const ExecutorsAndKeys& ek = *it->second.executors_and_keys;
+  if (!feed_tensors.empty()) {
+    if (feed_tensors.size() != ek.input_types.size()) {
+      return errors::InvalidArgument("Expected ", ek.input_types.size(),
+                                     " feed tensors, but got ",
+                                     feed_tensors.size());
+    }
+    for (size_t i = 0; i < feed_tensors.size(); ++i) {
+      if (feed_tensors[i].dtype() != ek.input_types[i]) {
+        return errors::InvalidArgument(
+            "Feed tensor ", i, " has type ",
+            DataTypeString(feed_tensors[i].dtype()), " but the callable expects ",
+            DataTypeString(ek.input_types[i]));
+      }
+    }
+  }
+  if (!fetch_tensors.empty()) {
+    if (fetch_tensors.size() != ek.output_types.size()) {
+      return errors::InvalidArgument("Expected ", ek.output_types.size(),
+                                     " fetch tensors, but got ",
+                                     fetch_tensors.size());
+    }
+    for (size_t i = 0; i < fetch_tensors.size(); ++i) {
+      if (fetch_tensors[i].IsInitialized() &&
+          fetch_tensors[i].dtype() != ek.output_types[i]) {
+        return errors::InvalidArgument(
+            "Fetch tensor ", i, " has type ",
+            DataTypeString(fetch_tensors[i].dtype()),
+            " but the callable produces ", DataTypeString(ek.output_types[i]));
+      }
+    }
+  }
+  auto bindings = std::make_shared<CallableBindings>();
+  bindings->feed_tensors = feed_tensors;
+  bindings->fetch_tensors = fetch_tensors;
+  it->second.bindings = std::move(bindings);
+  return Status::OK();
+}
+
 ::tensorflow::Status DirectSession::ReleaseCallable(CallableHandle handle) {
   mutex_lock l(callables_lock_);
   if (handle >= next_callable_handle_) {
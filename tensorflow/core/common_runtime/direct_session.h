@@ -123,6 +123,10 @@ class DirectSession : public Session {
       std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
       const thread::ThreadPoolOptions& threadpool_options) override;
 
+  ::tensorflow::Status BindCallable(
+      CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+      const std::vector<Tensor>& fetch_tensors) override;
+
   ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
 
   ::tensorflow::Status Finalize() override;
@@ -354,9 +358,15 @@ class DirectSession : public Session {
       GUARDED_BY(executor_lock_);
 
   class RunCallableCallFrame;
+  // Tensors bound to a callable by BindCallable().
+  struct CallableBindings {
+    std::vector<Tensor> feed_tensors;
+    std::vector<Tensor> fetch_tensors;
+  };
   struct Callable {
     std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
     std::shared_ptr<FunctionInfo> function_info;
+    std::shared_ptr<const CallableBindings> bindings;
     ~Callable();
   };
   mutex callables_lock_;
@@ -548,6 +548,61 @@ TEST_F(DirectSessionMinusAXTest, TestFeed_Callable) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, TestBindCallable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(MakeCallableOptions({x_}, {y_ + ":0"}, {}),
+                                     &handle));
+  Tensor x(DT_FLOAT, TensorShape({2, 1}));
+  Tensor y(DT_FLOAT, TensorShape({2, 1}));
+  TF_ASSERT_OK(session->BindCallable(handle, {x}, {y}));
+
+  for (float i = 0; i < 3; ++i) {
+    // Update the bound feed in place.
+    x.matrix<float>()(0, 0) = 5 + i;
+    x.matrix<float>()(1, 0) = 6;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+
+    ASSERT_EQ(1, outputs.size());
+    // The MatMul kernel writes its output into the bound fetch tensor.
+    EXPECT_EQ(y.tensor_data().data(), outputs[0].tensor_data().data());
+    auto mat = y.matrix<float>();
+    EXPECT_FLOAT_EQ(1 * (5 + i) + 2 * 6, mat(0, 0));
+    EXPECT_FLOAT_EQ(3 * (5 + i) + 4 * 6, mat(1, 0));
+  }
+
+  // Explicit feeds take precedence over the bound feeds.
+  Tensor t(DT_FLOAT, TensorShape({2, 1}));
+  test::FillValues<float>(&t, {1, 1});
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({3, 7}, {2, 1}),
+                                 outputs[0]);
+
+  // A fetch tensor with a different shape is left unused.
+  Tensor wrong_shape(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(session->BindCallable(handle, {x}, {wrong_shape}));
+  TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_NE(wrong_shape.tensor_data().data(), outputs[0].tensor_data().data());
+  EXPECT_EQ(TensorShape({2, 1}), outputs[0].shape());
+
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->BindCallable(handle, {x, x}, {})));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->BindCallable(handle, {Tensor(DT_INT32, TensorShape({2, 1}))},
+                            {})));
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  EXPECT_TRUE(errors::IsInvalidArgument(session->BindCallable(handle, {}, {})));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -2613,6 +2668,43 @@ void BM_FeedFetchCallable(int iters, int num_feeds) {
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 BENCHMARK(BM_FeedFetchCallable)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
+// Measures the first-run latency of a graph split across `num_devices`
+// partitions, which is dominated by partitioning, optimization and executor
+// creation.
+void BM_SessionStartup(int iters, int num_devices) {
+  testing::StopTiming();
+  const int kNodesPerDevice = 200;
+  Graph g(OpRegistry::Global());
+  std::vector<string> outputs;
+  for (int d = 0; d < num_devices; ++d) {
+    const string device = strings::StrCat("/cpu:", d);
+    Node* n = test::graph::Constant(&g, test::AsScalar<float>(1.0));
+    n->set_assigned_device_name(
+        strings::StrCat("/job:localhost/replica:0/task:0", device));
+    for (int i = 0; i < kNodesPerDevice; ++i) {
+      TF_CHECK_OK(NodeBuilder(g.NewName("Neg"), "Neg")
+                      .Input(n)
+                      .Device(device)
+                      .Finalize(&g, &n));
+    }
+    outputs.push_back(n->name() + ":0");
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  (*opts.config.mutable_device_count())["CPU"] = num_devices;
+  for (int i = 0; i < iters; ++i) {
+    std::unique_ptr<Session> session(NewSession(opts));
+    TF_CHECK_OK(session->Create(gd));
+    std::vector<Tensor> output_values;
+    testing::StartTiming();
+    TF_CHECK_OK(session->Run({}, outputs, {}, &output_values));
+    testing::StopTiming();
+  }
+}
+
+BENCHMARK(BM_SessionStartup)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
 }  // namespace
 
 class DirectSessionCollectiveTest : public ::testing::Test {
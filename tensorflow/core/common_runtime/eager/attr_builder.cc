@@ -203,11 +203,6 @@ void AttrBuilder::FillAttrValueMapWithoutDefaults(AttrValueMap* m) const {
   }
 }
 
-void AttrBuilder::AddAttrIfNotPresent(StringPiece attr_name,
-                                      const AttrValue& value) {
-  encoded_attrs_.emplace(string(attr_name), value.SerializeAsString());
-}
-
 const NodeDef& AttrBuilder::BuildNodeDef() {
   if (node_def_finalized_) return node_def_;
   if (!node_def_initialized_) {
@@ -262,23 +257,35 @@ inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
 
 }  // namespace
 
+void AttrBuilder::AddAttrIfNotPresent(StringPiece attr_name,
+                                      const AttrValue& value) {
+  auto inserted =
+      encoded_attrs_.emplace(string(attr_name), value.SerializeAsString());
+  if (!inserted.second) return;
+  CombineUnordered(
+      CacheKeyHelper(attr_name,
+                     tensorflow::Fingerprint128(inserted.first->second)),
+      &attrs_fingerprint_);
+  cached_cache_key_ = absl::nullopt;
+}
+
 tensorflow::Fprint128 AttrBuilder::CacheKey(const StringPiece device) {
-  if (!cached_cache_key_ || device != device_for_cached_cache_key_) {
-    cached_cache_key_ = BuildCacheKeyForDevice(device);
+  if (device != device_for_cached_cache_key_) {
     device_for_cached_cache_key_ = string(device);
+    device_fingerprint_ = tensorflow::Fingerprint128(device);
+    cached_cache_key_ = absl::nullopt;
+  }
+  if (!cached_cache_key_) {
+    cached_cache_key_ = BuildCacheKey();
   }
 
   return *cached_cache_key_;
 }
 
-tensorflow::Fprint128 AttrBuilder::BuildCacheKeyForDevice(
-    const StringPiece device) const {
-  tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name());
-  f = tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
-  for (const auto& p : encoded_attrs_) {
-    CombineUnordered(
-        CacheKeyHelper(p.first, tensorflow::Fingerprint128(p.second)), &f);
-  }
+tensorflow::Fprint128 AttrBuilder::BuildCacheKey() const {
+  tensorflow::Fprint128 f =
+      tensorflow::FingerprintCat128(op_name_fingerprint_, device_fingerprint_);
+  CombineUnordered(attrs_fingerprint_, &f);
   return f;
 }
 
@@ -79,22 +79,36 @@ Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
 // BuildNodeDef. Also, calls to NumInputs or Set between multiple invocations
 // to CacheKey may cause different values to be returned by CacheKey.
 //
+// The cache key is maintained incrementally: each attribute is fingerprinted
+// once when it is set, and the fingerprints of the op name and of the device
+// are kept across Reset, so that an AttrBuilder reused for every op (e.g. the
+// one of the thread-local EagerOperation of the Python fast path) computes the
+// cache key without rehashing what did not change.
+//
 // For performance reasons, the class internally delays the actual construction
 // of the NodeDef till BuildNodeDef is called, or Set is called with certain
 // uncommon types (see template specializations of Set to see which types
 // trigger a NodeDef creation).
 class AttrBuilder {
  public:
-  explicit AttrBuilder(const char* op) { Reset(op); }
+  explicit AttrBuilder(const char* op)
+      : op_name_(op),
+        op_name_fingerprint_(tensorflow::Fingerprint128(op_name_)),
+        device_fingerprint_(tensorflow::Fingerprint128("")) {
+    Reset(op);
+  }
 
   void Reset(const char* op) {
-    op_name_ = op;
+    if (op_name_ != op) {
+      op_name_ = op;
+      op_name_fingerprint_ = tensorflow::Fingerprint128(op_name_);
+    }
     num_inputs_ = 0;
     encoded_attrs_.clear();
+    attrs_fingerprint_ = {0, 0};
     node_def_initialized_ = false;
     node_def_finalized_ = false;
     cached_cache_key_ = absl::nullopt;
-    device_for_cached_cache_key_.clear();
   }
 
   const string& op_name() const { return op_name_; }
@@ -106,7 +120,6 @@ class AttrBuilder {
   AttrBuilder& Set(StringPiece attr_name, T&& value) {
     SetAttrValue(value, &attr_tmp_);
     AddAttrIfNotPresent(attr_name, attr_tmp_);
-    cached_cache_key_ = absl::nullopt;
     return *this;
   }
 
@@ -142,7 +155,7 @@ class AttrBuilder {
   const NodeDef& BuildNodeDef();
 
  private:
-  tensorflow::Fprint128 BuildCacheKeyForDevice(const StringPiece device) const;
+  tensorflow::Fprint128 BuildCacheKey() const;
 
   // Initialize the node_def_ object.
   // REQUIRES: node_def_initialized_ = false
@@ -160,19 +173,28 @@ class AttrBuilder {
     }
   }
 
+  // Adds the attr and its fingerprint, unless the attr is already set.
   void AddAttrIfNotPresent(StringPiece attr_name, const AttrValue& value);
 
   gtl::FlatMap<string, string> encoded_attrs_;
   mutable AttrValue attr_tmp_;  // For encoding
 
   string op_name_;  // Conceptually const, but can't be because of Reset(...)
+  tensorflow::Fprint128 op_name_fingerprint_;
   int num_inputs_;
   NodeDef node_def_;
   bool node_def_initialized_;
   bool node_def_finalized_;
 
+  // The sum of the fingerprints of the attrs in encoded_attrs_, which does
+  // not depend on their order.
+  tensorflow::Fprint128 attrs_fingerprint_;
+
   absl::optional<tensorflow::Fprint128> cached_cache_key_;
+  // The device of the last call to CacheKey, and its fingerprint. Kept across
+  // Reset, as consecutive ops usually run on the same device.
   string device_for_cached_cache_key_;
+  tensorflow::Fprint128 device_fingerprint_;
 };
 
 template <>
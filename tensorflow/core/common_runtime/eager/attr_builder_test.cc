@@ -83,6 +83,28 @@ TEST(AttrTypeMap, CacheKey) {
   ASSERT_FALSE(cache_key == a.CacheKey("cpu:0"));
 }
 
+TEST(AttrTypeMap, CacheKeyAfterReset) {
+  AttrBuilder a("op_name");
+  a.Set("T", TF_FLOAT);
+  a.Set("x", 1.0);
+  tensorflow::Fprint128 cache_key = a.CacheKey("cpu:0");
+
+  // Reusing the builder for another op and device gives the key of a new one.
+  a.Reset("other_op");
+  a.Set("T", TF_INT32);
+  AttrBuilder b("other_op");
+  b.Set("T", TF_INT32);
+  ASSERT_TRUE(a.CacheKey("cpu:1") == b.CacheKey("cpu:1"));
+
+  // The key does not depend on the order of the attrs, and an attr that is
+  // already set keeps its first value.
+  a.Reset("op_name");
+  a.Set("x", 1.0);
+  a.Set("T", TF_FLOAT);
+  a.Set("T", TF_INT32);
+  ASSERT_TRUE(cache_key == a.CacheKey("cpu:0"));
+}
+
 string ToString(const AttrValueMap& m) {
   std::vector<string> strs;
   for (const auto& e : m) {
@@ -48,6 +48,8 @@ class CopyToDeviceNode : public EagerNode {
 
   void Abort(Status status) override { dst_->Poison(status); }
 
+  Device* device() const override { return dstd_; }
+
   string DebugString() const override {
     string out = "[CopyToDeviceNode]";
     strings::StrAppend(&out, " src_tensor: ", src_->DebugString());
@@ -21,19 +21,40 @@ limitations under the License.
 namespace tensorflow {
 
 EagerExecutor::EagerExecutor(bool async)
+    : EagerExecutor(async, /*per_device_streams=*/false) {}
+
+EagerExecutor::EagerExecutor(bool async, bool per_device_streams)
     : next_node_id_(0),
-      thread_(async ? tensorflow::Env::Default()->StartThread(
-                          tensorflow::ThreadOptions(), "eager_async_executor",
-                          std::bind(&EagerExecutor::Run, this))
-                    : nullptr) {}
+      per_device_streams_(per_device_streams),
+      thread_(async && !per_device_streams
+                  ? tensorflow::Env::Default()->StartThread(
+                        tensorflow::ThreadOptions(), "eager_async_executor",
+                        std::bind(&EagerExecutor::Run, this))
+                  : nullptr) {}
 
 EagerExecutor::~EagerExecutor() {
+  // A stream that is destroyed stops without running its pending nodes, which
+  // the nodes of the other streams may be waiting for.
+  for (EagerExecutor* stream : Streams()) {
+    stream->ShutDown().IgnoreError();
+  }
   tensorflow::mutex_lock l(node_queue_mutex_);
   state_ = ExecutorState::kShutDown;
   nodes_pending_.notify_all();
 }
 
 Status EagerExecutor::ShutDown() {
+  if (per_device_streams_) {
+    {
+      tensorflow::mutex_lock l(node_queue_mutex_);
+      state_ = ExecutorState::kShutDown;
+    }
+    Status status;
+    for (EagerExecutor* stream : Streams()) {
+      status.Update(stream->ShutDown());
+    }
+    return status;
+  }
   {
     std::vector<core::RefCountPtr<NodeItem>> items_to_destroy;
     bool has_thread;
@@ -82,6 +103,7 @@ const char* EagerExecutor::StateStringLocked() {
 }
 
 Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
+  if (per_device_streams_) return AddToStream(std::move(node));
   Status status;
   core::RefCountPtr<NodeItem> item(new NodeItem);
   item->id = next_node_id_++;
@@ -133,7 +155,52 @@ Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
   return status;
 }
 
+Status EagerExecutor::AddToStream(std::unique_ptr<EagerNode> node) {
+  EagerExecutor* stream = nullptr;
+  Status status;
+  {
+    tensorflow::mutex_lock l(node_queue_mutex_);
+    if (state_ != ExecutorState::kActive) {
+      status = errors::FailedPrecondition(
+          "EagerExecutor accepts new EagerNodes to run only in Active state. "
+          "Current state is '",
+          StateStringLocked(), "'");
+    } else {
+      std::unique_ptr<EagerExecutor>& s = streams_[node->device()];
+      if (s == nullptr) {
+        s.reset(new EagerExecutor(/*async=*/true));
+      }
+      stream = s.get();
+    }
+  }
+  // As with a single queue, an error on any stream cancels the nodes that are
+  // added after it.
+  if (status.ok()) status = this->status();
+  if (!status.ok()) {
+    node->Abort(status);
+    return status;
+  }
+  return stream->AddOrExecute(std::move(node));
+}
+
+std::vector<EagerExecutor*> EagerExecutor::Streams() const {
+  std::vector<EagerExecutor*> streams;
+  tf_shared_lock l(node_queue_mutex_);
+  streams.reserve(streams_.size());
+  for (const auto& stream : streams_) {
+    streams.push_back(stream.second.get());
+  }
+  return streams;
+}
+
 tensorflow::Status EagerExecutor::WaitForAllPendingNodes() {
+  if (per_device_streams_) {
+    Status status;
+    for (EagerExecutor* stream : Streams()) {
+      status.Update(stream->WaitForAllPendingNodes());
+    }
+    return status;
+  }
   tensorflow::mutex_lock l(node_queue_mutex_);
   return WaitForAllPendingNodesLocked(&l);
 }
@@ -157,6 +224,9 @@ tensorflow::Status EagerExecutor::WaitForAllPendingNodesLocked(
 }
 
 void EagerExecutor::ClearError() {
+  for (EagerExecutor* stream : Streams()) {
+    stream->ClearError();
+  }
   tensorflow::mutex_lock l(node_queue_mutex_);
   // TODO(iga): Check state_ and return an error if it is not kActive.
   if (status_.ok()) return;
@@ -169,6 +239,12 @@ void EagerExecutor::ClearError() {
 }
 
 tensorflow::Status EagerExecutor::status() const {
+  if (per_device_streams_) {
+    for (EagerExecutor* stream : Streams()) {
+      Status status = stream->status();
+      if (!status.ok()) return status;
+    }
+  }
   tf_shared_lock l(node_queue_mutex_);
   return status_;
 }
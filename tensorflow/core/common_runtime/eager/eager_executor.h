@@ -66,6 +66,11 @@ class EagerNode {
   // Returns nullptr iff this Eager node is synchronous.
   virtual AsyncEagerNode* AsAsync() { return nullptr; }
 
+  // Returns the device this node runs on, or nullptr if it is not known. An
+  // EagerExecutor with per-device streams runs the nodes of each device on a
+  // stream of their own.
+  virtual Device* device() const { return nullptr; }
+
   virtual string DebugString() const = 0;
 };
 
@@ -89,12 +94,23 @@ class AsyncEagerNode : public EagerNode {
 // device of the input handle. Fix that.
 // TODO(agarwal): Implement support for control dependencies.
 // TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
+// EagerNode of a device in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async);
 
+  // If `per_device_streams` is true, the executor is async and runs the nodes
+  // of each device (see EagerNode::device) in order on a stream of their own,
+  // an async EagerExecutor with its own thread. Independent nodes on different
+  // devices, e.g. host preprocessing ops and copies to an accelerator, then
+  // overlap. A node that consumes a tensor handle produced on another stream
+  // waits until the handle is ready, or fails if it was poisoned. Nodes on
+  // different devices are not ordered otherwise.
+  // Destroying such an executor waits for its pending nodes, as the nodes of
+  // one stream may wait for the outputs of the nodes of another.
+  EagerExecutor(bool async, bool per_device_streams);
+
   ~EagerExecutor();
 
   // Puts this in a shutdown state. In this state, AddOrExecute() will return an
@@ -174,8 +190,16 @@ class EagerExecutor {
 
   Status WaitImpl(bool wait_all, uint64 node_id);
 
+  // Adds `node` to the stream of its device, creating the stream on first use.
+  Status AddToStream(std::unique_ptr<EagerNode> node);
+
+  // Returns the streams created so far.
+  std::vector<EagerExecutor*> Streams() const;
+
   std::atomic<uint64> next_node_id_;
 
+  const bool per_device_streams_;
+
   mutable mutex node_queue_mutex_;
 
   // Used to signal that some EagerNodes are pending execution.
@@ -208,12 +232,20 @@ class EagerExecutor {
   // current EagerNode.
   ExecutorState state_ GUARDED_BY(node_queue_mutex_) = ExecutorState::kActive;
 
+  // The per-device streams, which run all the nodes if per_device_streams_ is
+  // true. The nodes that have no device run on the stream of nullptr.
+  std::map<Device*, std::unique_ptr<EagerExecutor>> streams_
+      GUARDED_BY(node_queue_mutex_);
+
   // Thread object that calls the `Run` method in async mode.This thread runs
-  // until state_ is set to kShuttingDown. It is `nullptr` in sync mode.
+  // until state_ is set to kShuttingDown. It is `nullptr` in sync mode, and
+  // with per-device streams.
   const std::unique_ptr<Thread> thread_;
 };
 
-inline bool EagerExecutor::Async() const { return thread_ != nullptr; }
+inline bool EagerExecutor::Async() const {
+  return thread_ != nullptr || per_device_streams_;
+}
 
 }  // namespace tensorflow
 
@@ -489,8 +489,9 @@ Status EagerLocalExecute(EagerOperation* op, TensorHandle** retvals,
   Fprint128 cache_key = op->MutableAttrs()->CacheKey(
       DeviceNameOrUnspecified(op->GetDeviceName()));
 
+  // Primitive ops skip the lookup in the function library, which takes a lock.
   bool is_multi_device_function =
-      IsMultiDevice(ctx->FindFunctionDef(op->Name()));
+      op->is_function() && IsMultiDevice(ctx->FindFunctionDef(op->Name()));
 
   std::vector<Device*> input_dev_ptrs;
   std::unordered_map<int, DtypeAndPartialTensorShape>
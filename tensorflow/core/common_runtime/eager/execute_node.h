@@ -138,6 +138,8 @@ class ExecuteNode : public EagerNode {
     }
   }
 
+  Device* device() const override { return kernel_->device(); }
+
   string DebugString() const override {
     string out = "[ExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
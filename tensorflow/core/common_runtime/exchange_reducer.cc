@@ -0,0 +1,427 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/exchange_reducer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+namespace {
+// Key to be used for BufRendezvous by the exchange algorithms.
+string ExchangeBufKey(const string& name, const string& exec_key, int step,
+                      int src_rank, int dst_rank) {
+  return strings::StrCat(name, ":", exec_key, ":", step, ":", src_rank, ":",
+                         dst_rank);
+}
+
+// Returns `a` modulo `n`, in [0, n).
+int Mod(int a, int n) { return ((a % n) + n) % n; }
+}  // namespace
+
+Status ExchangeReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE ||
+      col_params->instance.impl_details.collective_name != name_) {
+    return errors::Internal("Unexpected collective ",
+                            col_params->instance.impl_details.collective_name,
+                            " for ", name_);
+  }
+  return Status::OK();
+}
+
+Status ExchangeReducer::InitializeCollectiveContext(
+    CollectiveContext* col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void ExchangeReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // The exchanges don't require non-overlapping collectives, unblock any
+  // collective that is blocked on this instance.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  Status status;
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    // We are running in a blockable thread and the callback can't block so
+    // just wait here on the copy.
+    Notification note;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+  }
+  if (status.ok()) {
+    status =
+        RunSchedule(BuildSchedule(*col_params_, col_params_->default_rank));
+  }
+  done(status);
+}
+
+Status ExchangeReducer::RunSchedule(const Schedule& schedule) {
+  VLOG(1) << name_ << "::Run for device " << col_ctx_->device_name
+          << " default_rank " << col_params_->default_rank << " with "
+          << schedule.steps.size() << " steps";
+  allocator_ =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0));
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, schedule.num_chunks,
+                                  allocator_));
+  const Tensor& value = ca_->Value();
+  chunk_elts_ = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(value.dtype()), value.NumElements(), schedule.num_chunks);
+  if (col_params_->final_op) {
+    TF_RETURN_IF_ERROR(MakeGroupSizeTensor());
+  }
+
+  for (int i = 0; i < schedule.steps.size(); ++i) {
+    const Step& step = schedule.steps[i];
+    Tensor send = RangeAlias(step.send_begin, step.send_end);
+    Tensor chunks = RangeAlias(step.recv_begin, step.recv_end);
+    Tensor recv = step.reduce
+                      ? Tensor(allocator_, chunks.dtype(), chunks.shape())
+                      : chunks;
+    TF_RETURN_IF_ERROR(Exchange(i, step, &send, &recv));
+    if (step.reduce && step.recv_from >= 0 && chunks.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op.get(), &chunks, &recv));
+    }
+    Tensor reduced = RangeAlias(step.final_begin, step.final_end);
+    if (col_params_->final_op && reduced.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->final_op.get(), &reduced, &group_size_tensor_));
+    }
+  }
+  ca_->ConsumeFinalValue(col_ctx_->output);
+  return Status::OK();
+}
+
+Status ExchangeReducer::MakeGroupSizeTensor() {
+  Tensor group_size_val = ca_->Scalar(col_params_->group.group_size);
+  if (col_params_->group.device_type == "CPU") {
+    group_size_tensor_ = group_size_val;
+    return Status::OK();
+  }
+  group_size_tensor_ = ca_->Scalar(
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+      AllocationAttributes());
+  Notification note;
+  Status status;
+  col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+      &group_size_val, col_ctx_->device, &group_size_tensor_,
+      [&note, &status](const Status& s) {
+        status = s;
+        note.Notify();
+      });
+  note.WaitForNotification();
+  return status;
+}
+
+Tensor ExchangeReducer::RangeAlias(int begin, int end) const {
+  const Tensor& value = ca_->Value();
+  const int64 begin_elt = std::min(value.NumElements(), begin * chunk_elts_);
+  const int64 end_elt = std::min(value.NumElements(), end * chunk_elts_);
+  // Take empty ranges from the front of the tensor, like
+  // CollectiveAdapter::ChunkAlias.
+  return (end_elt > begin_elt) ? value.Slice(begin_elt, end_elt)
+                               : value.Slice(0, 0);
+}
+
+Status ExchangeReducer::Exchange(int step_idx, const Step& step, Tensor* send,
+                                 Tensor* recv) {
+  // Both sides of an exchange agree on the size of the chunks, so empty
+  // ranges are neither sent nor received.
+  const bool do_send = step.send_to >= 0 && send->NumElements() > 0;
+  const bool do_recv = step.recv_from >= 0 && recv->NumElements() > 0;
+  if (!do_send && !do_recv) {
+    return Status::OK();
+  }
+  const int rank = col_params_->default_rank;
+  const auto& device_names = col_params_->instance.device_names;
+  const auto& task_names = col_params_->instance.task_names;
+  mutex mu;
+  Status status;
+  BlockingCounter pending(do_send + do_recv);
+  auto callback = [&mu, &status, &pending](const Status& s) {
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    pending.DecrementCount();
+  };
+  if (do_send) {
+    col_ctx_->col_exec->PostToPeer(
+        device_names[step.send_to], task_names[step.send_to],
+        ExchangeBufKey(name_, col_ctx_->exec_key, step_idx, rank, step.send_to),
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), send,
+        col_ctx_->device_locality, callback);
+  }
+  if (do_recv) {
+    col_ctx_->col_exec->RecvFromPeer(
+        device_names[step.recv_from], task_names[step.recv_from],
+        col_params_->task.is_local[step.recv_from],
+        ExchangeBufKey(name_, col_ctx_->exec_key, step_idx, step.recv_from,
+                       rank),
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), recv,
+        col_ctx_->device_locality, 0 /*stream_index*/, callback);
+  }
+  pending.Wait();
+  mutex_lock l(mu);
+  if (!status.ok()) {
+    LOG(ERROR) << "Aborting " << name_ << " with " << status;
+    // Cancel the outstanding exchanges of the other devices.
+    col_ctx_->col_exec->StartAbort(status);
+  }
+  return status;
+}
+
+/* static */
+ExchangeReducer::Schedule HalvingDoublingReducer::MakeSchedule(int group_size,
+                                                               int rank) {
+  Schedule schedule;
+  // The halving-doubling runs between the largest power of two of the devices.
+  int num_devices = 1;
+  while (num_devices * 2 <= group_size) num_devices *= 2;
+  const int num_extra = group_size - num_devices;
+  schedule.num_chunks = num_devices;
+  // The first 2 * num_extra devices are paired, and the odd one of each pair
+  // takes part in the halving-doubling on behalf of the even one.
+  const bool paired = rank < 2 * num_extra;
+  int hd_rank = -1;
+  if (!paired) {
+    hd_rank = rank - num_extra;
+  } else if (rank % 2 == 1) {
+    hd_rank = rank / 2;
+  }
+  auto group_rank = [num_extra](int r) {
+    return r < num_extra ? 2 * r + 1 : r + num_extra;
+  };
+  std::vector<Step>& steps = schedule.steps;
+
+  if (num_extra > 0) {
+    Step step;
+    if (paired && hd_rank < 0) {
+      step.send_to = rank + 1;
+      step.send_end = num_devices;
+    } else if (paired) {
+      step.recv_from = rank - 1;
+      step.recv_end = num_devices;
+      step.reduce = true;
+    }
+    steps.push_back(step);
+  }
+
+  // Reduce-scatter: keep the half of the chunks selected by a bit of the rank,
+  // from the most significant.
+  int begin = 0;
+  int end = num_devices;
+  for (int distance = num_devices / 2; distance >= 1; distance /= 2) {
+    Step step;
+    if (hd_rank >= 0) {
+      step.send_to = step.recv_from = group_rank(hd_rank ^ distance);
+      step.reduce = true;
+      const int mid = (begin + end) / 2;
+      if ((hd_rank & distance) == 0) {
+        step.send_begin = mid;
+        step.send_end = end;
+        end = mid;
+      } else {
+        step.send_begin = begin;
+        step.send_end = mid;
+        begin = mid;
+      }
+      step.recv_begin = begin;
+      step.recv_end = end;
+    }
+    steps.push_back(step);
+  }
+  if (hd_rank >= 0) {
+    if (steps.empty()) steps.emplace_back();
+    steps.back().final_begin = begin;
+    steps.back().final_end = end;
+  }
+
+  // All-gather: exchange the reduced chunks in the reverse order.
+  for (int distance = 1; distance < num_devices; distance *= 2) {
+    Step step;
+    if (hd_rank >= 0) {
+      step.send_to = step.recv_from = group_rank(hd_rank ^ distance);
+      step.send_begin = begin;
+      step.send_end = end;
+      const int size = end - begin;
+      if ((hd_rank & distance) == 0) {
+        step.recv_begin = end;
+        end += size;
+        step.recv_end = end;
+      } else {
+        step.recv_end = begin;
+        begin -= size;
+        step.recv_begin = begin;
+      }
+    }
+    steps.push_back(step);
+  }
+
+  if (num_extra > 0) {
+    Step step;
+    if (paired && hd_rank < 0) {
+      step.recv_from = rank + 1;
+      step.recv_end = num_devices;
+    } else if (paired) {
+      step.send_to = rank - 1;
+      step.send_end = num_devices;
+    }
+    steps.push_back(step);
+  }
+  return schedule;
+}
+
+ExchangeReducer::Schedule HalvingDoublingReducer::BuildSchedule(
+    const CollectiveParams& col_params, int rank) const {
+  return MakeSchedule(col_params.group.group_size, rank);
+}
+
+/* static */
+int TorusReducer::RowSize(const CollectiveParams& col_params) {
+  const int group_size = col_params.group.group_size;
+  // Use the tasks as rows when they all have the same number of devices.
+  // Precondition: device_names must be sorted so that all devices in the same
+  // task are adjacent.
+  const int num_tasks = col_params.group.num_tasks;
+  if (num_tasks > 1 && group_size > num_tasks &&
+      group_size % num_tasks == 0) {
+    const int dev_per_task = group_size / num_tasks;
+    const auto& task_names = col_params.instance.task_names;
+    bool uniform = true;
+    for (int i = 0; i < group_size && uniform; ++i) {
+      uniform = task_names[i] == task_names[i - i % dev_per_task];
+    }
+    if (uniform) return dev_per_task;
+  }
+  // Otherwise use the largest row size which doesn't exceed the number of
+  // rows.
+  int row_size = 1;
+  for (int i = 1; i * i <= group_size; ++i) {
+    if (group_size % i == 0) row_size = i;
+  }
+  return row_size;
+}
+
+/* static */
+ExchangeReducer::Schedule TorusReducer::MakeSchedule(int num_rows, int row_size,
+                                                     int rank) {
+  Schedule schedule;
+  // The tensor is split into one segment per column, and each segment into
+  // one chunk per row.
+  schedule.num_chunks = num_rows * row_size;
+  const int row = rank / row_size;
+  const int col = rank % row_size;
+  std::vector<Step>& steps = schedule.steps;
+
+  // Exchanges segments with the next and previous devices of the row.
+  auto segment_step = [&](int send_segment, int recv_segment, bool reduce) {
+    Step step;
+    step.send_to = row * row_size + Mod(col + 1, row_size);
+    step.send_begin = send_segment * num_rows;
+    step.send_end = step.send_begin + num_rows;
+    step.recv_from = row * row_size + Mod(col - 1, row_size);
+    step.recv_begin = recv_segment * num_rows;
+    step.recv_end = step.recv_begin + num_rows;
+    step.reduce = reduce;
+    steps.push_back(step);
+  };
+  // Exchanges chunks of `segment` with the next and previous devices of the
+  // column.
+  const int segment = Mod(col + 1, row_size);
+  auto chunk_step = [&](int send_chunk, int recv_chunk, bool reduce) {
+    Step step;
+    step.send_to = Mod(row + 1, num_rows) * row_size + col;
+    step.send_begin = segment * num_rows + send_chunk;
+    step.send_end = step.send_begin + 1;
+    step.recv_from = Mod(row - 1, num_rows) * row_size + col;
+    step.recv_begin = segment * num_rows + recv_chunk;
+    step.recv_end = step.recv_begin + 1;
+    step.reduce = reduce;
+    steps.push_back(step);
+  };
+
+  // Ring reduce-scatter in the row, after which the device holds `segment`
+  // reduced over the row.
+  for (int t = 0; t < row_size - 1; ++t) {
+    segment_step(Mod(col - t, row_size), Mod(col - t - 1, row_size), true);
+  }
+  // Ring reduce-scatter of `segment` in the column, after which the device
+  // holds a chunk reduced over the group.
+  for (int t = 0; t < num_rows - 1; ++t) {
+    chunk_step(Mod(row - t, num_rows), Mod(row - t - 1, num_rows), true);
+  }
+  if (steps.empty()) steps.emplace_back();
+  steps.back().final_begin = segment * num_rows + Mod(row + 1, num_rows);
+  steps.back().final_end = steps.back().final_begin + 1;
+  // Ring all-gathers in the column, then in the row.
+  for (int t = 0; t < num_rows - 1; ++t) {
+    chunk_step(Mod(row + 1 - t, num_rows), Mod(row - t, num_rows), false);
+  }
+  for (int t = 0; t < row_size - 1; ++t) {
+    segment_step(Mod(col + 1 - t, row_size), Mod(col - t, row_size), false);
+  }
+  return schedule;
+}
+
+ExchangeReducer::Schedule TorusReducer::BuildSchedule(
+    const CollectiveParams& col_params, int rank) const {
+  const int row_size = RowSize(col_params);
+  return MakeSchedule(col_params.group.group_size / row_size, row_size, rank);
+}
+
+REGISTER_COLLECTIVE(HalvingDoublingReduce, HalvingDoublingReducer);
+REGISTER_COLLECTIVE(TorusReduce, TorusReducer);
+
+}  // namespace tensorflow
@@ -0,0 +1,139 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EXCHANGE_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EXCHANGE_REDUCER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+class Device;
+
+// Implementation of collective all-reduce as a fixed schedule of pairwise
+// exchanges of chunks of the tensor, specialized by the algorithms below.
+// Every device runs the steps of its schedule in order, waiting for each
+// exchange to complete before starting the next one.
+class ExchangeReducer : public CollectiveImplementationInterface {
+ public:
+  // One step of the schedule of a device. Sends the chunks
+  // [send_begin, send_end) to the device of rank `send_to`, and receives the
+  // chunks [recv_begin, recv_end) from the device of rank `recv_from`, merging
+  // them into its value if `reduce` is true or replacing it otherwise. A rank
+  // of -1 means there is nothing to send or receive. Then applies the final op
+  // to the chunks [final_begin, final_end), which are fully reduced.
+  struct Step {
+    int send_to = -1;
+    int send_begin = 0;
+    int send_end = 0;
+    int recv_from = -1;
+    int recv_begin = 0;
+    int recv_end = 0;
+    bool reduce = false;
+    int final_begin = 0;
+    int final_end = 0;
+  };
+
+  // The steps of a device, in which the tensor is split in `num_chunks`
+  // chunks. Step i of a device exchanges with step i of its peers.
+  struct Schedule {
+    int num_chunks = 1;
+    std::vector<Step> steps;
+  };
+
+  explicit ExchangeReducer(const string& name) : name_(name) {}
+  ~ExchangeReducer() override = default;
+
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(CollectiveContext* col_ctx) override;
+
+  // No-op for exchange algorithms.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins async execution of the all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ protected:
+  // Returns the schedule of the device of rank `rank`.
+  virtual Schedule BuildSchedule(const CollectiveParams& col_params,
+                                 int rank) const = 0;
+
+ private:
+  Status RunSchedule(const Schedule& schedule);
+  Status MakeGroupSizeTensor();
+  // Returns the tensor which aliases the chunks [begin, end) of the value.
+  Tensor RangeAlias(int begin, int end) const;
+  // Sends `send` and receives `recv` as described by step `step_idx`, and
+  // waits for both to complete.
+  Status Exchange(int step_idx, const Step& step, Tensor* send, Tensor* recv);
+
+  const string name_;
+  CollectiveContext* col_ctx_ = nullptr;          // Not owned
+  const CollectiveParams* col_params_ = nullptr;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  Allocator* allocator_ = nullptr;
+  int64 chunk_elts_ = 0;
+  Tensor group_size_tensor_;
+};
+
+// Recursive halving-doubling all-reduce: a reduce-scatter in log2(n) steps,
+// exchanging half of the remaining chunks with the device at distance n/2,
+// n/4, ..., then an all-gather in the reverse order. When the group size is
+// not a power of two, the extra devices first merge their value into a
+// neighbor and receive the result at the end. The latency grows with the
+// logarithm of the group size, instead of linearly as with the ring.
+class HalvingDoublingReducer : public ExchangeReducer {
+ public:
+  HalvingDoublingReducer() : ExchangeReducer("HalvingDoublingReduce") {}
+
+  static Schedule MakeSchedule(int group_size, int rank);
+
+ protected:
+  Schedule BuildSchedule(const CollectiveParams& col_params,
+                         int rank) const override;
+};
+
+// 2D torus all-reduce: the devices are arranged in rows of consecutive
+// ranks, by task when all tasks have the same number of devices. A ring
+// reduce-scatter in the rows leaves each device with a segment of the tensor,
+// which is all-reduced with rings in the columns, before a ring all-gather in
+// the rows. The latency grows with the sum of the dimensions of the torus
+// instead of their product.
+class TorusReducer : public ExchangeReducer {
+ public:
+  TorusReducer() : ExchangeReducer("TorusReduce") {}
+
+  // Returns the number of devices in a row of the torus.
+  static int RowSize(const CollectiveParams& col_params);
+
+  static Schedule MakeSchedule(int num_rows, int row_size, int rank);
+
+ protected:
+  Schedule BuildSchedule(const CollectiveParams& col_params,
+                         int rank) const override;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EXCHANGE_REDUCER_H_
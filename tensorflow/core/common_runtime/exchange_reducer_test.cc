@@ -0,0 +1,131 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/exchange_reducer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using Schedule = ExchangeReducer::Schedule;
+using Step = ExchangeReducer::Step;
+
+// Runs the schedules of all the devices of a group on chunks of one value,
+// with a final op which negates the value, and checks that every device ends
+// with the negated sum over the group.
+void CheckAllReduce(const std::vector<Schedule>& schedules) {
+  const int group_size = schedules.size();
+  const int num_chunks = schedules[0].num_chunks;
+  const int num_steps = schedules[0].steps.size();
+  std::vector<std::vector<int64>> values(group_size);
+  std::vector<int64> expected(num_chunks, 0);
+  for (int r = 0; r < group_size; ++r) {
+    ASSERT_EQ(schedules[r].num_chunks, num_chunks);
+    ASSERT_EQ(schedules[r].steps.size(), num_steps);
+    for (int c = 0; c < num_chunks; ++c) {
+      values[r].push_back((r + 1) * 1000 + c);
+      expected[c] -= values[r][c];
+    }
+  }
+
+  for (int i = 0; i < num_steps; ++i) {
+    const std::vector<std::vector<int64>> sent = values;
+    for (int r = 0; r < group_size; ++r) {
+      const Step& step = schedules[r].steps[i];
+      if (step.send_to >= 0) {
+        EXPECT_EQ(schedules[step.send_to].steps[i].recv_from, r);
+      }
+      if (step.recv_from >= 0) {
+        const Step& peer = schedules[step.recv_from].steps[i];
+        ASSERT_EQ(peer.send_to, r);
+        ASSERT_EQ(peer.send_begin, step.recv_begin);
+        ASSERT_EQ(peer.send_end, step.recv_end);
+        // Chunks are only replaced when they are not sent at the same time.
+        if (!step.reduce && step.send_to >= 0) {
+          EXPECT_TRUE(step.send_end <= step.recv_begin ||
+                      step.recv_end <= step.send_begin);
+        }
+        for (int c = step.recv_begin; c < step.recv_end; ++c) {
+          values[r][c] = step.reduce ? values[r][c] + sent[step.recv_from][c]
+                                     : sent[step.recv_from][c];
+        }
+      }
+      for (int c = step.final_begin; c < step.final_end; ++c) {
+        values[r][c] = -values[r][c];
+      }
+    }
+  }
+  for (int r = 0; r < group_size; ++r) {
+    EXPECT_EQ(values[r], expected) << "rank " << r;
+  }
+}
+
+TEST(HalvingDoublingReducerTest, AllReduce) {
+  for (int group_size = 1; group_size <= 20; ++group_size) {
+    std::vector<Schedule> schedules;
+    for (int rank = 0; rank < group_size; ++rank) {
+      schedules.push_back(
+          HalvingDoublingReducer::MakeSchedule(group_size, rank));
+    }
+    CheckAllReduce(schedules);
+  }
+}
+
+TEST(HalvingDoublingReducerTest, NumSteps) {
+  EXPECT_EQ(HalvingDoublingReducer::MakeSchedule(128, 5).steps.size(), 14);
+  // The extra devices add a step at each end.
+  EXPECT_EQ(HalvingDoublingReducer::MakeSchedule(130, 5).steps.size(), 16);
+}
+
+TEST(TorusReducerTest, AllReduce) {
+  const std::vector<std::pair<int, int>> shapes = {
+      {1, 1}, {1, 4}, {4, 1}, {2, 2}, {3, 4}, {4, 3}, {16, 8}};
+  for (const auto& shape : shapes) {
+    std::vector<Schedule> schedules;
+    for (int rank = 0; rank < shape.first * shape.second; ++rank) {
+      schedules.push_back(
+          TorusReducer::MakeSchedule(shape.first, shape.second, rank));
+    }
+    CheckAllReduce(schedules);
+  }
+}
+
+TEST(TorusReducerTest, RowSize) {
+  CollectiveParams cp;
+  cp.group.group_size = 8;
+  cp.group.num_tasks = 2;
+  cp.instance.task_names = {"/job:worker/task:0", "/job:worker/task:0",
+                            "/job:worker/task:0", "/job:worker/task:0",
+                            "/job:worker/task:1", "/job:worker/task:1",
+                            "/job:worker/task:1", "/job:worker/task:1"};
+  EXPECT_EQ(TorusReducer::RowSize(cp), 4);
+
+  // Tasks with different numbers of devices.
+  cp.instance.task_names[4] = "/job:worker/task:0";
+  EXPECT_EQ(TorusReducer::RowSize(cp), 2);
+
+  cp.group.group_size = 128;
+  cp.group.num_tasks = 128;
+  EXPECT_EQ(TorusReducer::RowSize(cp), 8);
+  cp.group.group_size = 7;
+  cp.group.num_tasks = 7;
+  EXPECT_EQ(TorusReducer::RowSize(cp), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
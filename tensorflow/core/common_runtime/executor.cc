@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -26,9 +27,11 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/op_latency_sampler.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/temp_arena_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -42,6 +45,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -67,6 +72,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -172,6 +178,9 @@ struct NodeItem {
   bool is_initialization_op : 1;  // True iff IsInitializationOp(node)
   bool is_recv_or_switch : 1;     // True iff IsRecv(node) || IsSwitch(node)
   bool is_next_iteration : 1;     // True iff IsNextIteration(node)
+  // True iff an output is fetched as a call frame return value, and the
+  // executor runs on the host (see ExecutorImpl::output_retval_indices_).
+  bool has_retval_output : 1;
 
   // The kernel for this node.
   OpKernel* kernel = nullptr;
@@ -187,6 +196,10 @@ struct NodeItem {
 
   PendingCounts::Handle pending_id;
 
+  // The length of the longest path from this node to the end of its graph,
+  // including the node itself. Only computed for critical path scheduling.
+  int64 critical_path_length = 0;
+
   // Number of output edges.
   size_t num_output_edges;
 
@@ -327,6 +340,9 @@ class ExecutorImpl : public Executor {
     for (auto fiter : frame_info_) {
       delete fiter.second;
     }
+    for (TempArenaAllocator* arena : free_temp_arenas_) {
+      arena->Release();
+    }
   }
 
   Status Initialize(const Graph& graph);
@@ -346,12 +362,18 @@ class ExecutorImpl : public Executor {
     std::vector<string> frame_names;
   };
 
+  // The finished iteration states of a frame, reused by later iterations and
+  // steps so that steady-state runs do not allocate them. Defined after
+  // ExecutorState.
+  struct IterationStatePool;
+
   struct FrameInfo {
     FrameInfo()
         : input_count(0),
           total_inputs(0),
           pending_counts(nullptr),
-          nodes(nullptr) {}
+          nodes(nullptr),
+          iteration_pool(nullptr) {}
 
     // The total number of inputs to a frame.
     int input_count;
@@ -370,15 +392,15 @@ class ExecutorImpl : public Executor {
     // The nodes in a frame. Used only for debugging.
     std::vector<const NodeItem*>* nodes;  // Owned
 
-    ~FrameInfo() {
-      delete pending_counts;
-      delete nodes;
-    }
+    IterationStatePool* iteration_pool;  // Owned
+
+    ~FrameInfo();
   };
 
   static Status BuildControlFlowInfo(const Graph* graph,
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
+  void InitializeCriticalPathLengths(const Graph& graph);
 
   FrameInfo* EnsureFrameInfo(const string& fname) {
     auto slot = &frame_info_[fname];
@@ -395,6 +417,24 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // Whether ready nodes are ordered by NodeItem::critical_path_length.
+  bool critical_path_scheduling_ = false;
+
+  // For each node with NodeItem::has_retval_output set, the
+  // OpKernelContext::Params::output_retval_indices array of the node.
+  gtl::FlatMap<int, std::vector<int>> output_retval_indices_;
+  Status InitializeOutputRetvalIndices(const Graph& graph);
+
+  // Returns an arena for the temporaries of the synchronous kernels run by
+  // one ExecutorState::Process call, or nullptr if params_.use_temp_arena is
+  // not set.
+  TempArenaAllocator* AcquireTempArena() const;
+  void ReleaseTempArena(TempArenaAllocator* arena) const;
+
+  mutable mutex temp_arenas_mu_;
+  mutable std::vector<TempArenaAllocator*> free_temp_arenas_
+      GUARDED_BY(temp_arenas_mu_);
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const NodeItem*> root_nodes_;
 
@@ -676,6 +716,7 @@ Status ExecutorImpl::Initialize(const Graph& graph) {
     item->is_initialization_op = IsInitializationOp(n);
     item->is_recv_or_switch = IsRecv(n) || IsSwitch(n);
     item->is_next_iteration = IsNextIteration(n);
+    item->has_retval_output = false;
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -704,9 +745,68 @@ Status ExecutorImpl::Initialize(const Graph& graph) {
   // all nodes.
   InitializePending(&graph, cf_info);
 
+  // Outputs fetched as return values may be written into buffers bound by
+  // the caller, which live in host memory.
+  if (params_.device->device_type() == DEVICE_CPU) {
+    TF_RETURN_IF_ERROR(InitializeOutputRetvalIndices(graph));
+  }
+
+  critical_path_scheduling_ = params_.critical_path_scheduling;
+  if (!critical_path_scheduling_) {
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_CRITICAL_PATH_SCHEDULING",
+                                          false, &critical_path_scheduling_));
+  }
+  if (critical_path_scheduling_) {
+    InitializeCriticalPathLengths(graph);
+  }
+
   return gview_.SetAllocAttrs(&graph, params_.device);
 }
 
+Status ExecutorImpl::InitializeOutputRetvalIndices(const Graph& graph) {
+  for (const Node* n : graph.op_nodes()) {
+    if (!n->IsRetval()) continue;
+    const Edge* edge;
+    TF_RETURN_IF_ERROR(n->input_edge(0, &edge));
+    const Node* src = edge->src();
+    int index;
+    TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &index));
+    std::vector<int>& indices = output_retval_indices_[src->id()];
+    indices.resize(src->num_outputs(), -1);
+    // A value fetched more than once is written into the first buffer only.
+    if (indices[edge->src_output()] < 0) {
+      indices[edge->src_output()] = index;
+    }
+    gview_.node(src->id())->has_retval_output = true;
+  }
+  return Status::OK();
+}
+
+void ExecutorImpl::InitializeCriticalPathLengths(const Graph& graph) {
+  // The back edges of loops are ignored, so that the graph is acyclic and the
+  // post order visits every node after all of its successors.
+  const EdgeFilter forward_edges = [](const Edge& e) {
+    return !e.src()->IsNextIteration();
+  };
+  std::vector<Node*> order;
+  GetPostOrder(graph, &order, NodeComparatorName(), forward_edges);
+  for (const Node* n : order) {
+    int64 longest_successor = 0;
+    for (const Edge* e : n->out_edges()) {
+      if (forward_edges(*e)) {
+        longest_successor =
+            std::max(longest_successor,
+                     gview_.node(e->dst()->id())->critical_path_length);
+      }
+    }
+    int64 cost = 1;
+    if (params_.cost_model != nullptr && n->IsOp()) {
+      cost = params_.cost_model->TimeEstimate(n).value();
+    }
+    gview_.node(n->id())->critical_path_length = cost + longest_successor;
+  }
+}
+
 // If a Node has been marked to use a ScopedAllocator x for output i, then
 // sc_attr will contain the subsequence (i, x) at an even offset.  This function
 // extracts and transfers that ScopedAllocator id to alloc_attr.  For now, we
@@ -884,6 +984,8 @@ class ExecutorState {
   void RunAsync(Executor::DoneCallback done);
 
  private:
+  friend struct ExecutorImpl::IterationStatePool;
+
   // Either a tensor pointer (pass-by-reference) or a tensor (pass-by-value).
   // TODO(yuanbyu): A better way to do "has_value"?
   struct Entry {
@@ -1015,6 +1117,17 @@ class ExecutorState {
                                    dead_result);
     }
 
+    // Prepares a finished iteration state for reuse: drops any tensors it
+    // still holds and restores the initial pending counts.
+    void Reset(const PendingCounts* pending_counts, int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts.CopyFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -1117,6 +1230,7 @@ class ExecutorState {
     // Static information specific to this frame.
     PendingCounts* pending_counts = nullptr;
     int total_input_tensors = 0;
+    ExecutorImpl::IterationStatePool* iteration_pool = nullptr;
     std::vector<const NodeItem*>* nodes = nullptr;
 
     // Lock ordering: ExecutorState.mu_ < mu;
@@ -1131,8 +1245,16 @@ class ExecutorState {
       total_input_tensors = finfo->total_inputs;
       num_pending_inputs = finfo->input_count;
       nodes = finfo->nodes;
+      iteration_pool = finfo->iteration_pool;
     }
 
+    // Returns a new iteration state for this frame, reusing a finished one
+    // when there is one.
+    IterationState* NewIteration();
+
+    // Returns a finished iteration state to the pool of this frame.
+    void ReleaseIteration(IterationState* state);
+
     inline IterationState* GetIteration(int64 iter)
         EXCLUSIVE_LOCKS_REQUIRED(mu) {
       if (TF_PREDICT_TRUE(iter == 0)) {
@@ -1222,8 +1344,10 @@ class ExecutorState {
 
     ~FrameState() {
       for (size_t i = 0; i < iterations.size(); ++i) {
-        delete iterations[i];
-        iterations[i] = nullptr;
+        if (iterations[i] != nullptr) {
+          ReleaseIteration(iterations[i]);
+          iterations[i] = nullptr;
+        }
       }
     }
   };
@@ -1420,6 +1544,64 @@ class ExecutorState {
   }
 };
 
+struct ExecutorImpl::IterationStatePool {
+  // Bounds the states kept by a frame after a burst of concurrent steps.
+  static constexpr size_t kMaxFreeStates = 64;
+
+  mutex mu;
+  std::vector<ExecutorState::IterationState*> free_states GUARDED_BY(mu);
+
+  ~IterationStatePool() {
+    for (ExecutorState::IterationState* state : free_states) {
+      delete state;
+    }
+  }
+};
+
+// Temporaries of at most half a block are served by the arena.
+static constexpr size_t kTempArenaBlockBytes = 256 << 10;
+// Bounds the arenas (and the device memory they hold) kept by an idle
+// executor.
+static constexpr size_t kMaxFreeTempArenas = 32;
+
+TempArenaAllocator* ExecutorImpl::AcquireTempArena() const {
+  if (!params_.use_temp_arena) {
+    return nullptr;
+  }
+  {
+    mutex_lock l(temp_arenas_mu_);
+    if (!free_temp_arenas_.empty()) {
+      TempArenaAllocator* arena = free_temp_arenas_.back();
+      free_temp_arenas_.pop_back();
+      return arena;
+    }
+  }
+  return new TempArenaAllocator(
+      params_.device->GetAllocator(AllocatorAttributes()),
+      kTempArenaBlockBytes);
+}
+
+void ExecutorImpl::ReleaseTempArena(TempArenaAllocator* arena) const {
+  if (arena == nullptr) {
+    return;
+  }
+  arena->Reset();
+  {
+    mutex_lock l(temp_arenas_mu_);
+    if (free_temp_arenas_.size() < kMaxFreeTempArenas) {
+      free_temp_arenas_.push_back(arena);
+      return;
+    }
+  }
+  arena->Release();
+}
+
+ExecutorImpl::FrameInfo::~FrameInfo() {
+  delete pending_counts;
+  delete nodes;
+  delete iteration_pool;
+}
+
 ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
@@ -1432,7 +1614,9 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       session_metadata_(impl->params_.session_metadata),
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
-      stats_collector_(args.stats_collector),
+      stats_collector_(args.stats_collector != nullptr
+                           ? args.stats_collector
+                           : OpLatencySampler::Global()->MaybeSampleStep()),
       event_collector_(
           tracing::GetEventCollector(tracing::EventCategory::kCompute)),
       context_(ContextKind::kThread),
@@ -1457,9 +1641,7 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
   root_frame_->InitializeFrameInfo(root_frame_->frame_name);
 
   // Initialize iteration 0.
-  root_frame_->SetIteration(
-      0, new IterationState(root_frame_->pending_counts,
-                            root_frame_->total_input_tensors));
+  root_frame_->SetIteration(0, root_frame_->NewIteration());
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
 }
@@ -1544,6 +1726,7 @@ void ExecutorImpl::InitializePending(const Graph* graph,
     PendingCounts* counts = new PendingCounts(finfo->pending_counts_layout);
     DCHECK_EQ(finfo->pending_counts, nullptr);
     finfo->pending_counts = counts;
+    finfo->iteration_pool = new IterationStatePool;
   }
   for (const Node* n : graph->nodes()) {
     const int id = n->id();
@@ -1723,6 +1906,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   Status s;
   NodeExecStatsInterface* stats = nullptr;
 
+  // Serves the temporaries of the synchronous kernels below, and is rewound
+  // after each of them.
+  TempArenaAllocator* temp_arena = impl_->AcquireTempArena();
+
   EntryVector outputs;
   bool completed = false;
   inline_ready.push_back(tagged_node);
@@ -1794,6 +1981,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       params.frame_iter = FrameAndIter(input_frame->frame_id, input_iter);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      params.output_retval_indices =
+          item.has_retval_output
+              ? impl_->output_retval_indices_.at(id).data()
+              : nullptr;
       params.forward_from_array = item.forward_from();
 
       if (item.kernel_is_async) {
@@ -1801,6 +1992,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
         AsyncOpKernel* async = item.kernel->AsAsync();
         DCHECK(async != nullptr);
         launched_asynchronously = true;
+        // The kernel may allocate after this thread has moved on.
+        params.temp_allocator = nullptr;
         AsyncState* state =
             new AsyncState(params, tagged_node, &item, first_input, stats);
 
@@ -1864,6 +2057,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
         }
       } else {
         // Synchronous computes.
+        params.temp_allocator = temp_arena;
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
 
@@ -1934,11 +2128,16 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       if (stats) {
         scheduled_nsec = nodestats::NowInNsec();
       }
+      if (temp_arena != nullptr) {
+        temp_arena->Reset();
+      }
       // Postprocess.
       completed = NodeDone(s, ready, stats, &inline_ready);
     }
   }  // while !inline_ready.empty()
 
+  impl_->ReleaseTempArena(temp_arena);
+
   // This thread of computation is done if completed = true.
   if (completed) ScheduleFinish();
 }
@@ -2311,16 +2510,30 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     scheduled_nsec = nodestats::NowInNsec();
   }
 
+  // With critical path scheduling, the nodes on the longest remaining paths
+  // are dispatched and inlined first.
+  const TaggedNodeSeq* ordered_ready = &ready;
+  TaggedNodeSeq sorted_ready;
+  if (impl_->critical_path_scheduling_ && ready.size() > 1) {
+    sorted_ready = ready;
+    std::stable_sort(sorted_ready.begin(), sorted_ready.end(),
+                     [](const TaggedNode& a, const TaggedNode& b) {
+                       return a.node_item->critical_path_length >
+                              b.node_item->critical_path_length;
+                     });
+    ordered_ready = &sorted_ready;
+  }
+
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
-    for (auto& tagged_node : ready) {
+    for (auto& tagged_node : *ordered_ready) {
       runner_([=]() { Process(tagged_node, scheduled_nsec); });
     }
     return;
   }
 
   const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
+  for (auto& tagged_node : *ordered_ready) {
     const NodeItem& item = *tagged_node.node_item;
     if (tagged_node.is_dead || !item.kernel->IsExpensive()) {
       // Inline this inexpensive node.
@@ -2621,8 +2834,7 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
   // Initialize iteration 0.
   {
     mutex_lock l(temp->mu);
-    temp->SetIteration(
-        0, new IterationState(temp->pending_counts, temp->total_input_tensors));
+    temp->SetIteration(0, temp->NewIteration());
   }
 
   {
@@ -2877,8 +3089,7 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
+  IterationState* iter_state = NewIteration();
   SetIteration(next_iter, iter_state);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -2895,8 +3106,8 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Release the iteration curr_iter.
+    ReleaseIteration(GetIteration(curr_iter));
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2910,6 +3121,31 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
   return IsFrameDone();
 }
 
+ExecutorState::IterationState* ExecutorState::FrameState::NewIteration() {
+  {
+    mutex_lock l(iteration_pool->mu);
+    if (!iteration_pool->free_states.empty()) {
+      IterationState* state = iteration_pool->free_states.back();
+      iteration_pool->free_states.pop_back();
+      return state;
+    }
+  }
+  return new IterationState(pending_counts, total_input_tensors);
+}
+
+void ExecutorState::FrameState::ReleaseIteration(IterationState* state) {
+  state->Reset(pending_counts, total_input_tensors);
+  {
+    mutex_lock l(iteration_pool->mu);
+    if (iteration_pool->free_states.size() <
+        ExecutorImpl::IterationStatePool::kMaxFreeStates) {
+      iteration_pool->free_states.push_back(state);
+      return;
+    }
+  }
+  delete state;
+}
+
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   (new ExecutorState(args, this))->RunAsync(std::move(done));
 }
@@ -31,6 +31,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class CostModel;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -145,6 +146,22 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::RendezvousFactory rendezvous_factory;
+
+  // If true, ready nodes are scheduled in order of the length of the longest
+  // path from them to the end of the graph, so that long dependency chains
+  // start first. Also enabled by the TF_EXECUTOR_CRITICAL_PATH_SCHEDULING
+  // environment variable.
+  bool critical_path_scheduling = false;
+
+  // If set, the path lengths for `critical_path_scheduling` are weighted by
+  // the time estimates of this cost model instead of counting nodes. Not
+  // owned; only used while the executor is created.
+  const CostModel* cost_model = nullptr;
+
+  // If true, the temporaries that synchronous kernels allocate with default
+  // allocator attributes are carved out of per-thread arenas that are
+  // rewound after each kernel, instead of going to the device allocator.
+  bool use_temp_arena = false;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph& graph, Executor** executor);
@@ -217,6 +217,79 @@ TEST(GPUBFCAllocatorTest, AllocatedVsRequested) {
   a.DeallocateRaw(t1);
 }
 
+TEST(GPUBFCAllocatorTest, SmallObjectCache) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  BFCAllocator a(sub_allocator, 1 << 20, false /*allow_growth*/, "GPU_0_bfc",
+                 false /*garbage_collection*/, true /*small_object_cache*/);
+
+  // A freed small chunk is recycled for the next request of its size class.
+  void* p1 = a.AllocateRaw(1, 100);
+  EXPECT_EQ(256, a.RequestedSize(p1));
+  a.DeallocateRaw(p1);
+  void* p2 = a.AllocateRaw(1, 200);
+  EXPECT_EQ(p1, p2);
+  CheckStats(&a, 2, 256, 256, 256);
+  a.DeallocateRaw(p2);
+
+  // Large allocations are not cached.
+  void* large = a.AllocateRaw(1, 8192);
+  EXPECT_EQ(8192, a.RequestedSize(large));
+  a.DeallocateRaw(large);
+
+  // Parked chunks are returned to the bins when memory runs out.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 4096));
+  }
+  for (void* ptr : ptrs) {
+    a.DeallocateRaw(ptr);
+  }
+  EXPECT_GT(a.GetStats()->bytes_in_use, 0);
+  void* all = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(nullptr, all);
+  EXPECT_EQ(1 << 20, a.GetStats()->bytes_in_use);
+  a.DeallocateRaw(all);
+}
+
+TEST(GPUBFCAllocatorTest, MemoryTimeline) {
+  PlatformGpuId platform_gpu_id(0);
+  GPUMemAllocator* sub_allocator = new GPUMemAllocator(
+      GpuIdUtil::ExecutorForPlatformGpuId(platform_gpu_id).ValueOrDie(),
+      platform_gpu_id, false /*use_unified_memory*/, {}, {});
+  GPUBFCAllocator a(sub_allocator, 1 << 30, "GPU_0_bfc");
+  EXPECT_EQ(0, a.RecordMemoryMap().event_size());
+
+  a.SetMemoryTimelineCapacity(3);
+  void* p1 = a.AllocateRaw(1, 1000);
+  void* p2;
+  {
+    ScopedMemoryDebugAnnotation annotation("my_op", 7);
+    p2 = a.AllocateRaw(1, 2000);
+  }
+  a.DeallocateRaw(p1);
+  a.DeallocateRaw(p2);
+
+  // Only the last three events are kept, oldest first.
+  MemoryDump md = a.RecordMemoryMap();
+  ASSERT_EQ(3, md.event_size());
+  EXPECT_TRUE(md.event(0).allocation());
+  EXPECT_EQ(reinterpret_cast<uint64>(p2), md.event(0).address());
+  EXPECT_EQ(2048, md.event(0).size());
+  EXPECT_EQ(2000, md.event(0).requested_size());
+  EXPECT_EQ(1024 + 2048, md.event(0).bytes_in_use());
+  EXPECT_EQ("my_op", md.event(0).op_name());
+  EXPECT_EQ(7, md.event(0).step_id());
+  EXPECT_FALSE(md.event(1).allocation());
+  EXPECT_EQ(reinterpret_cast<uint64>(p1), md.event(1).address());
+  EXPECT_EQ(2048, md.event(1).bytes_in_use());
+  EXPECT_FALSE(md.event(2).allocation());
+  EXPECT_EQ(0, md.event(2).bytes_in_use());
+  EXPECT_LE(md.event(0).timestamp_us(), md.event(2).timestamp_us());
+}
+
 TEST(GPUBFCAllocatorTest, TestCustomMemoryLimit) {
   PlatformGpuId platform_gpu_id(0);
   GPUMemAllocator* sub_allocator = new GPUMemAllocator(
@@ -42,6 +42,28 @@ auto* graph_run_time_usecs_histogram = monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 20 (> 17 minutes)
     {monitoring::Buckets::Exponential(1000, 2, 20)});
 
+auto* worker_run_graph_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/worker_run_graph_time_usecs",
+     "The wall-clock time of the RunGraph calls of each worker, as seen by "
+     "the master, in microseconds.",
+     "worker"},
+    // Power of 2 with bucket count 20 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1000, 2, 20)});
+
+auto* worker_exec_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/worker_exec_time_usecs",
+     "The time spent by each worker executing its partitions of the steps in "
+     "microseconds.",
+     "worker"},
+    // Power of 2 with bucket count 20 (> 17 minutes)
+    {monitoring::Buckets::Exponential(1000, 2, 20)});
+
+auto* worker_recv_wait_time_usecs = monitoring::Counter<2>::New(
+    "/tensorflow/core/worker_recv_wait_time_usecs",
+    "The total time which the partitions of each worker waited for the "
+    "tensors they received from each remote device in microseconds.",
+    "worker", "src_device");
+
 auto* graph_run_input_tensor_bytes = monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -82,6 +104,16 @@ auto* parse_ragged_feature_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/ragged_feature",
     "The number of ragged features parsed by ops for parsing tf.Example.");
 
+auto* mutable_hash_table_lock_contention_counter = monitoring::Counter<0>::New(
+    "/tensorflow/core/mutable_hash_table/lock_contentions",
+    "The number of locks of the shards of the mutable hash tables that waited "
+    "for another thread.");
+
+auto* mutable_hash_table_size_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/mutable_hash_table/size",
+     "The number of entries of the mutable hash tables after the inserts."},
+    {monitoring::Buckets::Exponential(1, 4, 16)});
+
 auto* build_graph_calls = monitoring::Counter<0>::New(
     "/tensorflow/core/graph_build_calls",
     "The number of times TensorFlow has created a new client graph. "
@@ -108,6 +140,30 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_cluster_compilations = monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_cluster_compilations",
+    "The number of XLA compilations of each cluster. A cluster is compiled "
+    "once for every distinct input signature, so a count that keeps growing "
+    "indicates a cluster that is recompiled for changing input shapes.",
+    "cluster");
+
+auto* xla_cluster_compilation_time_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_cluster_compilation_time_usecs",
+    "The total time spent on compiling each XLA cluster in microseconds.",
+    "cluster");
+
+auto* op_compute_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/op_compute_time_usecs",
+     "The compute time of the ops of the steps sampled by the op latency "
+     "sampler in microseconds, by op type.",
+     "op_type"},
+    // Power of 2 with bucket count 25 (> 16 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 25)});
+
+auto* op_latency_sampled_steps = monitoring::Counter<0>::New(
+    "/tensorflow/core/op_latency_sampled_steps",
+    "The number of steps sampled by the op latency sampler.");
+
 auto* mlir_import_failure_count = monitoring::Counter<0>::New(
     "/tensorflow/mlir/import_failure_count",
     "The number of jobs that failed during mlir import or verification.");
@@ -146,6 +202,14 @@ void RecordParseRaggedFeature(int64 num_features) {
   parse_ragged_feature_counter->GetCell()->IncrementBy(num_features);
 }
 
+void RecordMutableHashTableLockContention() {
+  mutable_hash_table_lock_contention_counter->GetCell()->IncrementBy(1);
+}
+
+void RecordMutableHashTableSize(int64 size) {
+  mutable_hash_table_size_histogram->GetCell()->Add(size);
+}
+
 void RecordGraphInputTensors(const size_t size) {
   graph_run_input_tensor_bytes->GetCell()->Add(size);
 }
@@ -162,6 +226,28 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+void UpdateWorkerRunGraphTime(const string& worker,
+                              const uint64 running_time_usecs) {
+  if (running_time_usecs > 0) {
+    worker_run_graph_time_usecs->GetCell(worker)->Add(running_time_usecs);
+  }
+}
+
+void UpdateWorkerExecTime(const string& worker,
+                          const uint64 running_time_usecs) {
+  if (running_time_usecs > 0) {
+    worker_exec_time_usecs->GetCell(worker)->Add(running_time_usecs);
+  }
+}
+
+void UpdateWorkerRecvWaitTime(const string& worker, const string& src_device,
+                              const uint64 wait_time_usecs) {
+  if (wait_time_usecs > 0) {
+    worker_recv_wait_time_usecs->GetCell(worker, src_device)
+        ->IncrementBy(wait_time_usecs);
+  }
+}
+
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
@@ -192,6 +278,22 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void UpdateXlaClusterCompilationTime(const string& cluster_name,
+                                     const uint64 compilation_time_usecs) {
+  xla_cluster_compilations->GetCell(cluster_name)->IncrementBy(1);
+  xla_cluster_compilation_time_usecs->GetCell(cluster_name)
+      ->IncrementBy(compilation_time_usecs);
+}
+
+void UpdateOpComputeTime(const string& op_type,
+                         const uint64 compute_time_usecs) {
+  op_compute_time_usecs->GetCell(op_type)->Add(compute_time_usecs);
+}
+
+void RecordOpLatencySampledStep() {
+  op_latency_sampled_steps->GetCell()->IncrementBy(1);
+}
+
 void IncrementMLIRImportFailureCount() {
   mlir_import_failure_count->GetCell()->IncrementBy(1);
 }
@@ -59,6 +59,13 @@ void RecordParseSparseFeature(int64 num_features);
 // Records parsing of ragged tensor features.
 void RecordParseRaggedFeature(int64 num_features);
 
+// Records a lock of a shard of a mutable hash table that waited for another
+// thread.
+void RecordMutableHashTableLockContention();
+
+// Records the number of entries of a mutable hash table after an insert.
+void RecordMutableHashTableSize(int64 size);
+
 // Records the size of input/output tensors in bytes.
 void RecordGraphInputTensors(const size_t size);
 void RecordGraphOutputTensors(const size_t size);
@@ -80,6 +87,19 @@ void UpdateGraphExecTime(const uint64 running_time_usecs);
 // TODO(jtkeeling): Should we record building/optimizing tf.functions?
 void UpdateGraphBuildTime(const uint64 running_time_usecs);
 
+// Updates the metrics stored about the time spent by `worker` on its
+// partitions of the distributed steps: the wall time of the RunGraph calls
+// as seen by the master, and the time spent executing the partitions.
+void UpdateWorkerRunGraphTime(const string& worker,
+                              const uint64 running_time_usecs);
+void UpdateWorkerExecTime(const string& worker,
+                          const uint64 running_time_usecs);
+
+// Updates the time which the partitions of `worker` waited for the tensors
+// they received from `src_device`.
+void UpdateWorkerRecvWaitTime(const string& worker, const string& src_device,
+                              const uint64 wait_time_usecs);
+
 // Updates the metrics stored about graph optimizations.
 void UpdateGraphOptimizationPassTime(const string& pass_name,
                                      const uint64 running_time_usecs);
@@ -89,6 +109,18 @@ void UpdateGrapplerPassTime(const string& pass_name,
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Updates the per-cluster XLA compilation count and time for `cluster_name`.
+void UpdateXlaClusterCompilationTime(const string& cluster_name,
+                                     const uint64 compilation_time_usecs);
+
+// Updates the compute time of an op of type `op_type`, in a step sampled by
+// the OpLatencySampler.
+void UpdateOpComputeTime(const string& op_type,
+                         const uint64 compute_time_usecs);
+
+// Records that a step was sampled by the OpLatencySampler.
+void RecordOpLatencySampledStep();
+
 // Increment the number of jobs that failed during import to mlir.
 void IncrementMLIRImportFailureCount();
 
@@ -0,0 +1,107 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/op_latency_sampler.h"
+
+#include "tensorflow/core/common_runtime/metrics.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+// Only records the compute time of the node, which is reported in Done.
+class OpLatencyNodeExecStats : public NodeExecStatsInterface {
+ public:
+  explicit OpLatencyNodeExecStats(const NodeDef* node) : node_(node) {}
+
+  void Done(const string& device) override {
+    // The nodes which failed before their kernel ran have no compute time.
+    if (compute_start_nanos_ != 0 &&
+        compute_end_nanos_ >= compute_start_nanos_) {
+      metrics::UpdateOpComputeTime(node_->op(),
+                                   (compute_end_nanos_ - compute_start_nanos_) /
+                                       EnvTime::kMicrosToNanos);
+    }
+    delete this;
+  }
+
+  void RecordExecutorStarted() override {}
+
+  void RecordComputeStarted() override {
+    compute_start_nanos_ = Env::Default()->NowNanos();
+  }
+
+  void RecordComputeEnded() override {
+    compute_end_nanos_ = Env::Default()->NowNanos();
+  }
+
+  void RecordExecutorEnded() override {}
+
+  bool TrackAllocations() const override { return false; }
+
+  void SetMemory(OpKernelContext* ctx) override {}
+
+  void SetOutput(int slot, const Tensor* tensor) override {}
+
+  void SetReferencedTensors(const TensorReferenceVector& tensors) override {}
+
+  void SetScheduled(int64 nanos) override {}
+
+ private:
+  const NodeDef* const node_;  // Not owned.
+  uint64 compute_start_nanos_ = 0;
+  uint64 compute_end_nanos_ = 0;
+};
+
+}  // namespace
+
+OpLatencySampler::OpLatencySampler(int64 sample_steps)
+    : sample_steps_(sample_steps) {}
+
+/*static*/ OpLatencySampler* OpLatencySampler::Global() {
+  static OpLatencySampler* sampler = [] {
+    int64 sample_steps;
+    Status s =
+        ReadInt64FromEnvVar("TF_OP_LATENCY_SAMPLE_STEPS", 0, &sample_steps);
+    if (!s.ok()) {
+      LOG(ERROR) << "Op latency sampling disabled: " << s;
+      sample_steps = 0;
+    }
+    return new OpLatencySampler(sample_steps);
+  }();
+  return sampler;
+}
+
+bool OpLatencySampler::SampleStep() {
+  const uint64 step = num_steps_.fetch_add(1, std::memory_order_relaxed);
+  if (step % sample_steps_ != 0) return false;
+  metrics::RecordOpLatencySampledStep();
+  return true;
+}
+
+NodeExecStatsInterface* OpLatencySampler::CreateNodeExecStats(
+    const NodeDef* node) {
+  return new OpLatencyNodeExecStats(node);
+}
+
+string OpLatencySampler::ReportAllocsOnResourceExhausted(const string& err) {
+  return "\nHint: If you want to see a list of allocated tensors when OOM "
+         "happens, add report_tensor_allocations_upon_oom to RunOptions for "
+         "current allocation info.\n";
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,67 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_OP_LATENCY_SAMPLER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_OP_LATENCY_SAMPLER_H_
+
+#include <atomic>
+
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Collects the compute time of the ops of a sample of the steps into the
+// "/tensorflow/core/op_compute_time_usecs" metric, by op type, so that the
+// latency of the ops can be attributed continuously in production, unlike
+// with RunOptions.trace_level which records every node of a step.
+//
+// The executors use the global sampler for the steps which have no other
+// stats collector. The steps of the nested functions are sampled with their
+// caller.
+class OpLatencySampler : public StepStatsCollectorInterface {
+ public:
+  // Samples one in `sample_steps` steps, or none if `sample_steps` <= 0.
+  explicit OpLatencySampler(int64 sample_steps);
+
+  // Returns the sampler of the executors, which samples one in
+  // TF_OP_LATENCY_SAMPLE_STEPS steps. Sampling is disabled by default.
+  static OpLatencySampler* Global();
+
+  // Called when a step starts. Returns this sampler if the step is sampled,
+  // or null.
+  StepStatsCollectorInterface* MaybeSampleStep() {
+    if (TF_PREDICT_TRUE(sample_steps_ <= 0)) return nullptr;
+    return SampleStep() ? this : nullptr;
+  }
+
+  NodeExecStatsInterface* CreateNodeExecStats(const NodeDef* node) override;
+
+  // The allocations are not tracked, so returns the same hint as the executor
+  // gives without a stats collector.
+  string ReportAllocsOnResourceExhausted(const string& err) override;
+
+ private:
+  bool SampleStep();
+
+  const int64 sample_steps_;
+  std::atomic<uint64> num_steps_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OpLatencySampler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_OP_LATENCY_SAMPLER_H_
@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/op_latency_sampler.h"
+
+#include <memory>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the number of samples of the op compute time metric for `op_type`.
+double NumSamples(const string& op_type) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  auto it =
+      metrics->point_set_map.find("/tensorflow/core/op_compute_time_usecs");
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == op_type) {
+      return point->histogram_value.num();
+    }
+  }
+  return 0;
+}
+
+TEST(OpLatencySamplerTest, SamplesOneInNSteps) {
+  OpLatencySampler sampler(/*sample_steps=*/3);
+  EXPECT_EQ(sampler.MaybeSampleStep(), &sampler);
+  EXPECT_EQ(sampler.MaybeSampleStep(), nullptr);
+  EXPECT_EQ(sampler.MaybeSampleStep(), nullptr);
+  EXPECT_EQ(sampler.MaybeSampleStep(), &sampler);
+
+  OpLatencySampler disabled(/*sample_steps=*/0);
+  EXPECT_EQ(disabled.MaybeSampleStep(), nullptr);
+}
+
+TEST(OpLatencySamplerTest, RecordsComputeTimeByOpType) {
+  OpLatencySampler sampler(/*sample_steps=*/1);
+  NodeDef node;
+  node.set_name("matmul");
+  node.set_op("OpLatencySamplerTestOp");
+  const double num_samples = NumSamples(node.op());
+
+  NodeExecStatsInterface* stats = sampler.CreateNodeExecStats(&node);
+  EXPECT_FALSE(stats->TrackAllocations());
+  stats->RecordExecutorStarted();
+  stats->RecordComputeStarted();
+  stats->RecordComputeEnded();
+  stats->RecordExecutorEnded();
+  stats->Done("/device:CPU:0");
+  EXPECT_EQ(NumSamples(node.op()), num_samples + 1);
+
+  // A node which failed before its kernel ran is not recorded.
+  stats = sampler.CreateNodeExecStats(&node);
+  stats->RecordExecutorStarted();
+  stats->RecordExecutorEnded();
+  stats->Done("/device:CPU:0");
+  EXPECT_EQ(NumSamples(node.op()), num_samples + 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
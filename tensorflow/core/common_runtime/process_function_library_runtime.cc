@@ -41,10 +41,16 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/reffed_status_callback.h"
 
@@ -92,6 +98,8 @@ ProcessFunctionLibraryRuntime::ProcessFunctionLibraryRuntime(
                                       std::unique_ptr<FunctionLibraryRuntime>>),
       next_handle_(0),
       session_metadata_(session_metadata) {
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_FUNCTION_GRAPH_CACHE_DIR", "",
+                                   &function_graph_cache_dir_));
   if (device_mgr == nullptr) {
     (*flr_map_)[nullptr] = NewFunctionLibraryRuntime(
         nullptr, env, config_ ? &(*config_) : nullptr, nullptr,
@@ -571,6 +579,107 @@ Status GetGraphAndArgRets(
   return Status::OK();
 }
 
+// Returns the path of the file in `cache_dir` holding the optimized graph of
+// a multi-device function instantiation. The file name fingerprints what the
+// optimized graph depends on: the function and its attrs, the instantiation
+// options (including the ConfigProto, and so the rewriter config), the
+// reachable function library, the devices and the TensorFlow build.
+string FunctionGraphCachePath(
+    const string& cache_dir, const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    const FunctionLibraryDefinition& lib_def, const DeviceSet& device_set) {
+  // The function key names the library and the state by address, neither of
+  // which is stable across processes.
+  FunctionLibraryRuntime::InstantiateOptions stable_options = options;
+  stable_options.lib_def = nullptr;
+  stable_options.state_handle.clear();
+  string key = strings::StrCat(
+      Canonicalize(function_name, attrs, stable_options), ";version=",
+      tf_git_version(), ";graph_def_version=", TF_GRAPH_DEF_VERSION,
+      ";optimize_graph_fn=", options.optimize_graph_fn != nullptr);
+  std::vector<string> function_names = lib_def.ListFunctionNames();
+  std::sort(function_names.begin(), function_names.end());
+  for (const string& name : function_names) {
+    string serialized;
+    SerializeToStringDeterministic(*lib_def.Find(name), &serialized);
+    strings::StrAppend(&key, ";", name, "=", Fingerprint64(serialized),
+                       ";grad=", lib_def.FindGradient(name));
+  }
+  std::vector<string> devices;
+  for (const Device* device : device_set.devices()) {
+    devices.push_back(
+        strings::StrCat(device->name(), "=", device->device_type()));
+  }
+  std::sort(devices.begin(), devices.end());
+  strings::StrAppend(&key, ";", absl::StrJoin(devices, ","));
+  const Fprint128 fingerprint = Fingerprint128(key);
+  return io::JoinPath(
+      cache_dir, strings::StrCat(strings::Hex(fingerprint.high64,
+                                              strings::kZeroPad16),
+                                 strings::Hex(fingerprint.low64,
+                                              strings::kZeroPad16),
+                                 ".pb"));
+}
+
+// Loads the optimized, placed graph cached at `path` into `graph`, adding the
+// functions it calls to `lib_def`. Returns false if there is no usable entry.
+bool LoadCachedFunctionGraph(Env* env, const string& path,
+                             FunctionLibraryDefinition* lib_def,
+                             std::unique_ptr<Graph>* graph) {
+  if (!env->FileExists(path).ok()) {
+    return false;
+  }
+  GraphDef def;
+  Status s = ReadBinaryProto(env, path, &def);
+  if (s.ok()) {
+    s = lib_def->AddLibrary(def.library());
+  }
+  if (s.ok()) {
+    def.clear_library();
+    auto cached = absl::make_unique<Graph>(lib_def);
+    GraphConstructorOptions opts;
+    opts.allow_internal_ops = true;
+    opts.expect_device_spec = true;
+    s = ConvertGraphDefToGraph(opts, std::move(def), cached.get());
+    if (s.ok()) {
+      // ToGraphDef() wrote the assigned devices out as requested devices.
+      for (Node* n : cached->op_nodes()) {
+        n->set_assigned_device_name(n->requested_device());
+      }
+      *graph = std::move(cached);
+      return true;
+    }
+  }
+  LOG(WARNING) << "Ignoring function graph cache entry " << path << ": "
+               << s.ToString();
+  return false;
+}
+
+// Writes `graph` and the functions in `lib_def` to `path`. Failures are
+// logged and otherwise ignored.
+void StoreCachedFunctionGraph(Env* env, const string& path,
+                              const FunctionLibraryDefinition& lib_def,
+                              const Graph& graph) {
+  GraphDef def;
+  graph.ToGraphDef(&def);
+  *def.mutable_library() = lib_def.ToProto();
+  // Write to a temporary file first, so that concurrent instantiations in
+  // other processes never read a partial entry.
+  const string tmp_path = strings::StrCat(path, ".tmp", random::New64());
+  Status s = env->RecursivelyCreateDir(string(io::Dirname(path)));
+  if (s.ok()) {
+    s = WriteBinaryProto(env, tmp_path, def);
+  }
+  if (s.ok()) {
+    s = env->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write function graph cache entry " << path
+                 << ": " << s.ToString();
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+}
+
 }  // anonymous namespace
 
 Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
@@ -668,42 +777,58 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   optimization_options.flib_def = &data->lib_def_;
   optimization_options.device_set = &device_set_;
 
-  DumpGraph("Before running PRE_PLACEMENT passes", graph.get());
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
-
-  // TODO(b/124993244): Smartly merge options in nested defuns, and raise
-  // exceptions/warnings in case where nested function call options are ignored.
-  DumpGraph("Before calling Placer", graph.get());
-  Placer placer(graph.get(), function_name, optimization_options.flib_def,
-                &device_set_, default_device,
-                options.config_proto.allow_soft_placement(),
-                options.config_proto.log_device_placement());
-  TF_RETURN_IF_ERROR(placer.Run());
-
-  DumpGraph("Before running POST_PLACEMENT passes", graph.get());
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_PLACEMENT, optimization_options));
+  const string cache_path =
+      function_graph_cache_dir_.empty()
+          ? ""
+          : FunctionGraphCachePath(function_graph_cache_dir_, function_name,
+                                   attrs, options, data->lib_def_, device_set_);
+  if (!cache_path.empty() &&
+      LoadCachedFunctionGraph(env_, cache_path, &data->lib_def_, &graph)) {
+    VLOG(1) << "Loaded optimized graph of \"" << function_name << "\" from "
+            << cache_path;
+  } else {
+    DumpGraph("Before running PRE_PLACEMENT passes", graph.get());
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::PRE_PLACEMENT, optimization_options));
+
+    // TODO(b/124993244): Smartly merge options in nested defuns, and raise
+    // exceptions/warnings in case where nested function call options are
+    // ignored.
+    DumpGraph("Before calling Placer", graph.get());
+    Placer placer(graph.get(), function_name, optimization_options.flib_def,
+                  &device_set_, default_device,
+                  options.config_proto.allow_soft_placement(),
+                  options.config_proto.log_device_placement());
+    TF_RETURN_IF_ERROR(placer.Run());
+
+    DumpGraph("Before running POST_PLACEMENT passes", graph.get());
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_PLACEMENT, optimization_options));
+
+    Device* cpu_device;
+    TF_RETURN_IF_ERROR(device_mgr_->LookupDevice("CPU:0", &cpu_device));
+
+    if (options.optimize_graph_fn) {
+      DumpGraph("Before running graph optimization fn", graph.get());
+      Status status = options.optimize_graph_fn(
+          std::move(ret_node_names), std::move(control_ret_node_names),
+          &data->lib_def_, device_set_, cpu_device, &graph);
+      if (!status.ok()) {
+        LOG(WARNING) << "Ignoring multi-device function optimization failure: "
+                     << status.ToString();
+      }
+      DumpGraph("After optimization", graph.get());
+    }
 
-  Device* cpu_device;
-  TF_RETURN_IF_ERROR(device_mgr_->LookupDevice("CPU:0", &cpu_device));
+    DumpGraph("Before running POST_REWRITE_FOR_EXEC passes", graph.get());
+    TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, optimization_options));
 
-  if (options.optimize_graph_fn) {
-    DumpGraph("Before running graph optimization fn", graph.get());
-    Status status = options.optimize_graph_fn(
-        std::move(ret_node_names), std::move(control_ret_node_names),
-        &data->lib_def_, device_set_, cpu_device, &graph);
-    if (!status.ok()) {
-      LOG(WARNING) << "Ignoring multi-device function optimization failure: "
-                   << status.ToString();
+    if (!cache_path.empty()) {
+      StoreCachedFunctionGraph(env_, cache_path, data->lib_def_, *graph);
     }
-    DumpGraph("After optimization", graph.get());
   }
 
-  DumpGraph("Before running POST_REWRITE_FOR_EXEC passes", graph.get());
-  TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
-      OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, optimization_options));
-
   if (options.graph_collector != nullptr) {
     GraphDef def;
     graph->ToGraphDef(&def);
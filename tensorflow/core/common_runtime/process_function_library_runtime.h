@@ -459,6 +459,11 @@ class ProcessFunctionLibraryRuntime {
       flr_map_;
   int next_handle_ GUARDED_BY(mu_);
   const SessionMetadata* const session_metadata_;
+
+  // If set (via TF_FUNCTION_GRAPH_CACHE_DIR), the optimized graphs of
+  // multi-device functions are cached in this directory and reused by later
+  // instantiations, including those in other processes.
+  string function_graph_cache_dir_;
 };
 
 }  // namespace tensorflow
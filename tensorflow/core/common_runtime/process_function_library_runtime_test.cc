@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -672,6 +673,57 @@ TEST_F(ProcessFunctionLibraryRuntimeTest,
       this, MakeOptions("CPU:0", {"CPU:0", "GPU:0"}, {"CPU:0", "GPU:0"}));
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_FunctionGraphCache) {
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "function_graph_cache");
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  setenv("TF_FUNCTION_GRAPH_CACHE_DIR", cache_dir.c_str(), 1);
+
+  int num_optimizations = 0;
+  auto inst_opts = MakeOptions("CPU:0", {"CPU:0", "CPU:1"}, {"CPU:0", "CPU:1"});
+  inst_opts.optimize_graph_fn =
+      [&num_optimizations](std::vector<string>, std::vector<string>,
+                           FunctionLibraryDefinition*, const DeviceSet&,
+                           Device*, std::unique_ptr<Graph>*) {
+        ++num_optimizations;
+        return Status::OK();
+      };
+
+  // Each Init() creates a new runtime, as a restarted process would. Only
+  // the first one optimizes the function graph.
+  for (int i = 0; i < 2; ++i) {
+    Init({test::function::TwoDeviceInputOutput()});
+    FunctionLibraryRuntime::Options opts;
+    opts.rendezvous = rendezvous_;
+    Tensor y1;
+    Tensor y2;
+    TF_CHECK_OK(Run("TwoDeviceInputOutput", opts, {{"T", DT_FLOAT}}, inst_opts,
+                    {test::AsTensor<float>({1, 2}),
+                     test::AsTensor<float>({10, 20})},
+                    {&y1, &y2}));
+    test::ExpectTensorEqual<float>(y1, test::AsTensor<float>({2, 4}));
+    test::ExpectTensorEqual<float>(y2, test::AsTensor<float>({30, 60}));
+    EXPECT_EQ(1, num_optimizations);
+  }
+
+  // A different device assignment is cached separately.
+  Init({test::function::TwoDeviceInputOutput()});
+  FunctionLibraryRuntime::Handle handle;
+  auto flipped_opts = inst_opts;
+  flipped_opts.input_devices = CompleteDevices({"CPU:1", "CPU:0"});
+  TF_CHECK_OK(Instantiate("TwoDeviceInputOutput", {{"T", DT_FLOAT}},
+                          flipped_opts, &handle));
+  EXPECT_EQ(2, num_optimizations);
+
+  std::vector<string> entries;
+  TF_CHECK_OK(Env::Default()->GetChildren(cache_dir, &entries));
+  EXPECT_EQ(2, entries.size());
+  unsetenv("TF_FUNCTION_GRAPH_CACHE_DIR");
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_FlipInputs) {
   TestTwoDeviceInputOutput(
       this, MakeOptions("CPU:0", {"GPU:0", "CPU:0"}, {"CPU:0", "GPU:0"}));
@@ -90,10 +90,17 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      bool small_object_cache = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_SMALL_OBJECT_CACHE", false,
+                                  &small_object_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       DCHECK(sub_allocator);
       allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
-                           "bfc_cpu_allocator_for_gpu" /*name*/);
+                           "bfc_cpu_allocator_for_gpu" /*name*/,
+                           false /*garbage_collection*/, small_object_cache);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
@@ -138,6 +145,11 @@ void ProcessState::AddCPUFreeVisitor(SubAllocator::Visitor visitor) {
   cpu_free_visitors_.push_back(std::move(visitor));
 }
 
+bool ProcessState::HasCPUAllocators() {
+  mutex_lock lock(mu_);
+  return !cpu_allocators_.empty();
+}
+
 void ProcessState::TestOnlyReset() {
   mutex_lock lock(mu_);
   // Don't delete this value because it's static.
@@ -75,6 +75,10 @@ class ProcessState : public ProcessStateInterface {
   // REQUIRES: must be called before GetCPUAllocator.
   void AddCPUFreeVisitor(SubAllocator::Visitor v);
 
+  // Returns true once GetCPUAllocator has been called, after which no visitor
+  // can be registered.
+  bool HasCPUAllocators();
+
   typedef std::unordered_map<const void*, MemDesc> MDMap;
 
  protected:
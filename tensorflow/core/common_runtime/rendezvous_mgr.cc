@@ -41,10 +41,6 @@ Status IntraProcessRendezvous::Send(const ParsedKey& parsed,
                                     const Rendezvous::Args& args,
                                     const Tensor& val, const bool is_dead) {
   VLOG(1) << "IntraProcessRendezvous Send " << this << " " << parsed.FullKey();
-  {
-    mutex_lock l(mu_);
-    if (!status_.ok()) return status_;
-  }
 
   // Buffers "val" and "device_context" in local_.
   return local_->Send(parsed, args, val, is_dead);
@@ -52,10 +48,6 @@ Status IntraProcessRendezvous::Send(const ParsedKey& parsed,
 
 Status IntraProcessRendezvous::ParseKey(const string& key, bool is_src,
                                         Rendezvous::ParsedKey* parsed) {
-  {
-    mutex_lock l(mu_);
-    if (!status_.ok()) return status_;
-  }
   TF_RETURN_IF_ERROR(Rendezvous::ParseKey(key, parsed));
   return Status::OK();
 }
@@ -57,12 +57,8 @@ class IntraProcessRendezvous : public Rendezvous {
 
  private:
   const DeviceMgr* device_mgr_;
-  Rendezvous* local_;  // Owns a Ref on this object.
-
-  mutable mutex mu_;
-
-  // Status given by StartAbort() if any.
-  Status status_ GUARDED_BY(mu_);
+  // Owns a Ref on this object. Aborts and their status are tracked by local_.
+  Rendezvous* local_;
 
   ~IntraProcessRendezvous() override;
 
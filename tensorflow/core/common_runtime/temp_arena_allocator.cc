@@ -0,0 +1,146 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/temp_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+TempArenaAllocator::TempArenaAllocator(Allocator* base, size_t block_size)
+    : base_(base), block_size_(block_size) {}
+
+TempArenaAllocator::~TempArenaAllocator() {
+  DCHECK(retired_.empty());
+  if (current_.base != nullptr) {
+    base_->DeallocateRaw(current_.base);
+  }
+}
+
+string TempArenaAllocator::Name() {
+  return strings::StrCat(base_->Name(), "_temp_arena");
+}
+
+void* TempArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes > block_size_ / 2) {
+    void* ptr = base_->AllocateRaw(alignment, num_bytes);
+    if (ptr != nullptr) {
+      mutex_lock l(mu_);
+      ++num_live_forwarded_;
+    }
+    return ptr;
+  }
+  alignment = std::max<size_t>(alignment, Allocator::kAllocatorAlignment);
+  auto aligned_offset = [alignment](const Block& block) {
+    const std::uintptr_t start =
+        reinterpret_cast<std::uintptr_t>(block.base) + block.offset;
+    const std::uintptr_t aligned =
+        (start + alignment - 1) / alignment * alignment;
+    return block.offset + (aligned - start);
+  };
+
+  mutex_lock l(mu_);
+  DCHECK(!released_) << "TempArenaAllocator used after Release()";
+  size_t offset = 0;
+  if (current_.base != nullptr) {
+    offset = aligned_offset(current_);
+    if (offset + num_bytes > current_.size && current_.num_live == 0) {
+      current_.offset = 0;
+      offset = aligned_offset(current_);
+    }
+  }
+  if (current_.base == nullptr || offset + num_bytes > current_.size) {
+    if (current_.base != nullptr) {
+      retired_.push_back(current_);
+    }
+    current_ = Block();
+    void* base = base_->AllocateRaw(alignment, block_size_);
+    if (base == nullptr) {
+      return nullptr;
+    }
+    current_.base = static_cast<char*>(base);
+    current_.size = block_size_;
+    offset = 0;
+  }
+  current_.offset = offset + num_bytes;
+  ++current_.num_live;
+  return current_.base + offset;
+}
+
+void TempArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  void* forwarded = nullptr;
+  void* retired_block = nullptr;
+  bool should_delete;
+  {
+    mutex_lock l(mu_);
+    if (current_.Contains(ptr)) {
+      --current_.num_live;
+    } else {
+      auto it = std::find_if(
+          retired_.begin(), retired_.end(),
+          [ptr](const Block& block) { return block.Contains(ptr); });
+      if (it != retired_.end()) {
+        if (--it->num_live == 0) {
+          retired_block = it->base;
+          retired_.erase(it);
+        }
+      } else {
+        forwarded = ptr;
+        --num_live_forwarded_;
+      }
+    }
+    should_delete = ShouldDeleteLocked();
+  }
+  if (forwarded != nullptr) {
+    base_->DeallocateRaw(forwarded);
+  }
+  if (retired_block != nullptr) {
+    base_->DeallocateRaw(retired_block);
+  }
+  if (should_delete) {
+    delete this;
+  }
+}
+
+void TempArenaAllocator::Reset() {
+  mutex_lock l(mu_);
+  if (current_.num_live == 0) {
+    current_.offset = 0;
+  }
+}
+
+void TempArenaAllocator::Release() {
+  bool should_delete;
+  {
+    mutex_lock l(mu_);
+    released_ = true;
+    should_delete = ShouldDeleteLocked();
+  }
+  if (should_delete) {
+    delete this;
+  }
+}
+
+bool TempArenaAllocator::ShouldDeleteLocked() {
+  return released_ && current_.num_live == 0 && retired_.empty() &&
+         num_live_forwarded_ == 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_TEMP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_TEMP_ARENA_ALLOCATOR_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// TempArenaAllocator serves the short-lived temporaries of a sequence of
+// kernel invocations by bumping a pointer through blocks obtained from a
+// backing allocator, so that most temporaries never reach the backing
+// allocator.  Like a ScopedAllocator it carves many tensors out of one
+// backing buffer, but the tensors need not be known in advance.
+//
+// The owner calls Reset() after each kernel invocation, which rewinds the
+// current block if none of its allocations are still live.  A temporary may
+// outlive the invocation (e.g. when a kernel passes it to set_output); its
+// block is then retired and returned to the backing allocator once the last
+// of its allocations is deallocated.  Requests larger than half a block are
+// forwarded to the backing allocator.
+//
+// The allocator cannot be deleted while allocations are live.  The owner
+// calls Release() instead of deleting it, and the allocator deletes itself
+// once it has been released and the last allocation has been deallocated.
+class TempArenaAllocator : public Allocator {
+ public:
+  // 'base' is not owned and must outlive this allocator.
+  TempArenaAllocator(Allocator* base, size_t block_size);
+
+  string Name() override;
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Rewinds the current block if none of its allocations are live.
+  void Reset();
+
+  // Gives up the caller's ownership.  No allocations may be made afterwards.
+  void Release();
+
+ private:
+  ~TempArenaAllocator() override;
+
+  struct Block {
+    char* base = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    int64 num_live = 0;
+
+    bool Contains(const void* ptr) const {
+      const char* p = static_cast<const char*>(ptr);
+      return p >= base && p < base + size;
+    }
+  };
+
+  // Returns true if the allocator has been released and owns no memory.
+  bool ShouldDeleteLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;
+  const size_t block_size_;
+
+  mutex mu_;
+  // The block allocations are carved from.  Its base is nullptr until the
+  // first allocation that fits in a block.
+  Block current_ GUARDED_BY(mu_);
+  // Former current blocks that still hold live allocations.
+  std::vector<Block> retired_ GUARDED_BY(mu_);
+  // Number of live allocations forwarded to base_.
+  int64 num_live_forwarded_ GUARDED_BY(mu_) = 0;
+  bool released_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TempArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_TEMP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,92 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/temp_arena_allocator.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+bool IsAligned(void* ptr) {
+  return reinterpret_cast<std::uintptr_t>(ptr) %
+             Allocator::kAllocatorAlignment ==
+         0;
+}
+
+TEST(TempArenaAllocatorTest, RewindsAfterReset) {
+  TempArenaAllocator* arena = new TempArenaAllocator(cpu_allocator(), 4096);
+  void* p1 = arena->AllocateRaw(1, 100);
+  void* p2 = arena->AllocateRaw(1, 100);
+  EXPECT_TRUE(IsAligned(p1));
+  EXPECT_TRUE(IsAligned(p2));
+  EXPECT_NE(p1, p2);
+  arena->DeallocateRaw(p1);
+  arena->DeallocateRaw(p2);
+  arena->Reset();
+  EXPECT_EQ(p1, arena->AllocateRaw(1, 100));
+  arena->DeallocateRaw(p1);
+  arena->Release();
+}
+
+TEST(TempArenaAllocatorTest, LiveAllocationsAreNotReused) {
+  TempArenaAllocator* arena = new TempArenaAllocator(cpu_allocator(), 4096);
+  void* p1 = arena->AllocateRaw(1, 1024);
+  memset(p1, 1, 1024);
+  arena->Reset();
+  // p1 is still live, so its block is neither rewound nor reused.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 8; ++i) {
+    void* p = arena->AllocateRaw(1, 1024);
+    EXPECT_TRUE(static_cast<char*>(p) + 1024 <= static_cast<char*>(p1) ||
+                static_cast<char*>(p1) + 1024 <= static_cast<char*>(p));
+    memset(p, 2, 1024);
+    ptrs.push_back(p);
+  }
+  EXPECT_EQ(1, static_cast<char*>(p1)[1023]);
+  for (void* p : ptrs) {
+    arena->DeallocateRaw(p);
+  }
+  arena->DeallocateRaw(p1);
+  arena->Release();
+}
+
+TEST(TempArenaAllocatorTest, ForwardsLargeAllocations) {
+  TempArenaAllocator* arena = new TempArenaAllocator(cpu_allocator(), 4096);
+  void* large = arena->AllocateRaw(1, 1 << 20);
+  memset(large, 0, 1 << 20);
+  void* small = arena->AllocateRaw(1, 16);
+  arena->DeallocateRaw(large);
+  arena->DeallocateRaw(small);
+  arena->Release();
+}
+
+TEST(TempArenaAllocatorTest, OutlivesRelease) {
+  TempArenaAllocator* arena = new TempArenaAllocator(cpu_allocator(), 4096);
+  void* p1 = arena->AllocateRaw(1, 100);
+  void* p2 = arena->AllocateRaw(1, 1 << 20);
+  arena->Release();
+  // The allocator deletes itself on the last deallocation.
+  memset(p1, 0, 100);
+  arena->DeallocateRaw(p1);
+  memset(p2, 0, 1 << 20);
+  arena->DeallocateRaw(p2);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -352,10 +352,43 @@ void BaseRemoteRendezvous::RecvAsync(const ParsedKey& parsed,
         });
     return;
   } else {
+    bool record_wait;
+    {
+      mutex_lock l(recv_waits_mu_);
+      record_wait = record_recv_waits_;
+    }
+    if (record_wait) {
+      const uint64 start_micros = env_->env->NowMicros();
+      done = [this, start_micros, src_device = string(parsed.src_device),
+              done = std::move(done)](
+                 const Status& s, const Rendezvous::Args& send_args,
+                 const Rendezvous::Args& recv_args, const Tensor& val,
+                 bool is_dead) {
+        const int64 wait_micros = env_->env->NowMicros() - start_micros;
+        {
+          mutex_lock l(recv_waits_mu_);
+          recv_wait_micros_[src_device] += wait_micros;
+        }
+        done(s, send_args, recv_args, val, is_dead);
+      };
+    }
     RecvFromRemoteAsync(parsed, recv_args, std::move(done));
   }
 }
 
+void BaseRemoteRendezvous::RecordRecvWaits() {
+  mutex_lock l(recv_waits_mu_);
+  record_recv_waits_ = true;
+}
+
+void BaseRemoteRendezvous::GetRecvWaits(
+    std::unordered_map<string, int64>* recv_wait_micros) {
+  mutex_lock l(recv_waits_mu_);
+  for (const auto& p : recv_wait_micros_) {
+    (*recv_wait_micros)[p.first] += p.second;
+  }
+}
+
 void BaseRemoteRendezvous::RecvLocalAsync(const ParsedKey& parsed,
                                           DoneCallback done) {
   // Test whether the rendezvous is initialized using a shared lock, to avoid
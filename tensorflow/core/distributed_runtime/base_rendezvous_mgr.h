@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_BASE_RENDEZVOUS_MGR_H_
 
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
@@ -149,6 +150,10 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   // REQUIRES: "parsed" is one that will be Saved into the local rendezvous.
   void RecvLocalAsync(const ParsedKey& parsed, DoneCallback done);
 
+  void RecordRecvWaits() override;
+  void GetRecvWaits(
+      std::unordered_map<string, int64>* recv_wait_micros) override;
+
  protected:
   virtual void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
                                    const Rendezvous::Args& args,
@@ -202,6 +207,12 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   std::unordered_map<BaseRecvTensorCall*, InactiveCallback> active_
       GUARDED_BY(active_mu_);
 
+  // The time which remote receives waited, by source device, if requested.
+  mutex recv_waits_mu_;
+  bool record_recv_waits_ GUARDED_BY(recv_waits_mu_) = false;
+  std::unordered_map<string, int64> recv_wait_micros_
+      GUARDED_BY(recv_waits_mu_);
+
   bool is_initialized_locked() SHARED_LOCKS_REQUIRED(init_mu_) {
     return session_ != nullptr;
   }
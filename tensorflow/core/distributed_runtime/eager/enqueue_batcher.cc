@@ -0,0 +1,164 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace eager {
+
+EnqueueBatcher::EnqueueBatcher(Env* env, uint64 context_id,
+                               int64 max_batch_items, int64 window_micros,
+                               SendFn send)
+    : env_(env),
+      context_id_(context_id),
+      max_batch_items_(max_batch_items),
+      window_micros_(window_micros),
+      send_(std::move(send)),
+      timer_target_(std::make_shared<TimerTarget>()) {
+  mutex_lock l(timer_target_->mu);
+  timer_target_->batcher = this;
+}
+
+EnqueueBatcher::~EnqueueBatcher() {
+  {
+    // Waits for a running timer.
+    mutex_lock l(timer_target_->mu);
+    timer_target_->batcher = nullptr;
+  }
+  Flush();
+  mutex_lock l(mu_);
+  while (sending_) {
+    cv_.wait(l);
+  }
+}
+
+void EnqueueBatcher::EnqueueAsync(const EnqueueRequest* request,
+                                  EnqueueResponse* response,
+                                  StatusCallback done) {
+  bool send;
+  {
+    mutex_lock l(mu_);
+    if (batch_ == nullptr) {
+      batch_.reset(new Batch);
+      batch_->seq = next_seq_++;
+      batch_->request.set_context_id(context_id_);
+      if (window_micros_ > 0) {
+        const int64 seq = batch_->seq;
+        std::shared_ptr<TimerTarget> target = timer_target_;
+        env_->SchedClosureAfter(window_micros_, [target, seq]() {
+          mutex_lock l(target->mu);
+          if (target->batcher != nullptr) {
+            target->batcher->OnWindowExpired(seq);
+          }
+        });
+      }
+    }
+    for (const QueueItem& item : request->queue()) {
+      *batch_->request.add_queue() = item;
+    }
+    batch_->callers.push_back({request->queue_size(), response,
+                               std::move(done)});
+    send = window_micros_ <= 0 ||
+           batch_->request.queue_size() >= max_batch_items_;
+    if (send) {
+      CloseBatchLocked();
+    }
+  }
+  if (send) {
+    SendReady();
+  }
+}
+
+void EnqueueBatcher::OnWindowExpired(int64 seq) {
+  {
+    mutex_lock l(mu_);
+    // The batch may already have been sent.
+    if (batch_ == nullptr || batch_->seq != seq) return;
+    CloseBatchLocked();
+  }
+  SendReady();
+}
+
+void EnqueueBatcher::Flush() {
+  {
+    mutex_lock l(mu_);
+    if (batch_ == nullptr) return;
+    CloseBatchLocked();
+  }
+  SendReady();
+}
+
+void EnqueueBatcher::CloseBatchLocked() {
+  ready_.push_back(std::move(batch_));
+}
+
+void EnqueueBatcher::SendReady() {
+  {
+    mutex_lock l(mu_);
+    // The sending thread also sends the batches closed in the meantime, which
+    // keeps them in order.
+    if (sending_) return;
+    sending_ = true;
+  }
+  while (true) {
+    Batch* batch;
+    {
+      mutex_lock l(mu_);
+      if (ready_.empty()) {
+        sending_ = false;
+        cv_.notify_all();
+        return;
+      }
+      batch = ready_.front().release();
+      ready_.pop_front();
+    }
+    VLOG(3) << "Sending a batch of " << batch->callers.size()
+            << " enqueue requests with " << batch->request.queue_size()
+            << " items";
+    send_(&batch->request, &batch->response,
+          [batch](const Status& s) { BatchDone(batch, s); });
+  }
+}
+
+void EnqueueBatcher::BatchDone(Batch* batch, const Status& s) {
+  Status status = s;
+  if (status.ok() && batch->response.queue_response_size() !=
+                         batch->request.queue_size()) {
+    status = errors::Internal("Expected ", batch->request.queue_size(),
+                              " queue responses for a batch of enqueue "
+                              "requests, got ",
+                              batch->response.queue_response_size());
+  }
+  int offset = 0;
+  for (Caller& caller : batch->callers) {
+    if (status.ok()) {
+      for (int i = 0; i < caller.num_items; ++i) {
+        caller.response->add_queue_response()->Swap(
+            batch->response.mutable_queue_response(offset + i));
+      }
+    }
+    offset += caller.num_items;
+    caller.done(status);
+  }
+  delete batch;
+}
+
+}  // namespace eager
+}  // namespace tensorflow
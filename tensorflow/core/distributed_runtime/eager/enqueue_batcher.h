@@ -0,0 +1,112 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
+
+namespace tensorflow {
+namespace eager {
+
+// Batches the EnqueueRequests streamed to one remote eager context, so that a
+// loop of small remote ops sends one request per batch instead of one per op.
+//
+// The items of the requests are appended to the current batch, which is sent
+// once it holds `max_batch_items` items, `window_micros` after its first
+// item, or when Flush() is called. The batches are sent in order, and the
+// response of a batch is split back into the responses of its requests, in
+// the same way as if they had been sent one by one. A caller which blocks on
+// the result of a request waits at most `window_micros` longer.
+class EnqueueBatcher {
+ public:
+  // Sends a batch. `done` may be called before SendFn returns.
+  typedef std::function<void(const EnqueueRequest* request,
+                             EnqueueResponse* response, StatusCallback done)>
+      SendFn;
+
+  EnqueueBatcher(Env* env, uint64 context_id, int64 max_batch_items,
+                 int64 window_micros, SendFn send);
+
+  // Sends the current batch and waits until no batch is being sent.
+  ~EnqueueBatcher();
+
+  // Adds the items of `request` to the current batch. When the batch
+  // completes, fills `response` with the responses of these items and calls
+  // `done`. `request` can be deleted as soon as EnqueueAsync returns.
+  void EnqueueAsync(const EnqueueRequest* request, EnqueueResponse* response,
+                    StatusCallback done);
+
+  // Sends the current batch.
+  void Flush();
+
+ private:
+  struct Caller {
+    int num_items;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+  // Lets the timers of the windows find out whether the batcher is alive.
+  struct TimerTarget {
+    mutex mu;
+    EnqueueBatcher* batcher GUARDED_BY(mu);
+  };
+  struct Batch {
+    int64 seq;
+    EnqueueRequest request;
+    EnqueueResponse response;
+    std::vector<Caller> callers;
+  };
+
+  void OnWindowExpired(int64 seq);
+  // Moves the current batch to the batches to send.
+  void CloseBatchLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Sends the batches to send, unless another thread is already sending
+  // them.
+  void SendReady();
+  static void BatchDone(Batch* batch, const Status& s);
+
+  Env* const env_;
+  const uint64 context_id_;
+  const int64 max_batch_items_;
+  const int64 window_micros_;
+  const SendFn send_;
+  const std::shared_ptr<TimerTarget> timer_target_;
+
+  mutex mu_;
+  condition_variable cv_;
+  std::unique_ptr<Batch> batch_ GUARDED_BY(mu_);
+  int64 next_seq_ GUARDED_BY(mu_) = 0;
+  std::deque<std::unique_ptr<Batch>> ready_ GUARDED_BY(mu_);
+  bool sending_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EnqueueBatcher);
+};
+
+}  // namespace eager
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_EAGER_ENQUEUE_BATCHER_H_
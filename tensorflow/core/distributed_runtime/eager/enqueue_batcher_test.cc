@@ -0,0 +1,247 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace eager {
+namespace {
+
+constexpr uint64 kContextId = 7;
+
+// Answers each item of the requests it receives with a shape of one
+// dimension, which is the op_id of the item.
+class FakeStream {
+ public:
+  // Each request takes `request_micros` to answer, one at a time.
+  explicit FakeStream(int64 request_micros = 0)
+      : request_micros_(request_micros),
+        thread_(Env::Default(), "fake_stream", 1) {}
+
+  void Send(const EnqueueRequest* request, EnqueueResponse* response,
+            StatusCallback done) {
+    {
+      mutex_lock l(mu_);
+      requests_.push_back(*request);
+    }
+    auto answer = [this, request, response, done]() {
+      if (request_micros_ > 0) {
+        Env::Default()->SleepForMicroseconds(request_micros_);
+      }
+      for (const QueueItem& item : request->queue()) {
+        response->add_queue_response()->add_shape()->add_dim()->set_size(
+            item.operation().id());
+      }
+      done(status_);
+    };
+    if (request_micros_ > 0) {
+      thread_.Schedule(std::move(answer));
+    } else {
+      answer();
+    }
+  }
+
+  EnqueueBatcher::SendFn SendFn() {
+    return [this](const EnqueueRequest* request, EnqueueResponse* response,
+                  StatusCallback done) {
+      Send(request, response, std::move(done));
+    };
+  }
+
+  std::vector<EnqueueRequest> requests() {
+    mutex_lock l(mu_);
+    return requests_;
+  }
+
+  Status status_;
+
+ private:
+  const int64 request_micros_;
+  thread::ThreadPool thread_;
+  mutex mu_;
+  std::vector<EnqueueRequest> requests_ GUARDED_BY(mu_);
+};
+
+EnqueueRequest OpRequest(std::initializer_list<int64> op_ids) {
+  EnqueueRequest request;
+  request.set_context_id(kContextId);
+  for (int64 op_id : op_ids) {
+    request.add_queue()->mutable_operation()->set_id(op_id);
+  }
+  return request;
+}
+
+void ExpectResponse(const EnqueueResponse& response,
+                    std::initializer_list<int64> op_ids) {
+  ASSERT_EQ(response.queue_response_size(), op_ids.size());
+  int i = 0;
+  for (int64 op_id : op_ids) {
+    EXPECT_EQ(response.queue_response(i++).shape(0).dim(0).size(), op_id);
+  }
+}
+
+TEST(EnqueueBatcherTest, SendsFullBatches) {
+  FakeStream stream;
+  EnqueueBatcher batcher(Env::Default(), kContextId, /*max_batch_items=*/3,
+                         /*window_micros=*/60 * 1000 * 1000, stream.SendFn());
+  const EnqueueRequest requests[3] = {OpRequest({1}), OpRequest({2}),
+                                      OpRequest({3, 4})};
+  EnqueueResponse responses[3];
+  Status statuses[3];
+  batcher.EnqueueAsync(&requests[0], &responses[0],
+                       [&](const Status& s) { statuses[0] = s; });
+  batcher.EnqueueAsync(&requests[1], &responses[1],
+                       [&](const Status& s) { statuses[1] = s; });
+  EXPECT_TRUE(stream.requests().empty());
+  batcher.EnqueueAsync(&requests[2], &responses[2],
+                       [&](const Status& s) { statuses[2] = s; });
+
+  ASSERT_EQ(stream.requests().size(), 1);
+  EXPECT_EQ(stream.requests()[0].context_id(), kContextId);
+  EXPECT_EQ(stream.requests()[0].queue_size(), 4);
+  for (const Status& s : statuses) {
+    TF_EXPECT_OK(s);
+  }
+  ExpectResponse(responses[0], {1});
+  ExpectResponse(responses[1], {2});
+  ExpectResponse(responses[2], {3, 4});
+}
+
+TEST(EnqueueBatcherTest, Flush) {
+  FakeStream stream;
+  EnqueueBatcher batcher(Env::Default(), kContextId, /*max_batch_items=*/100,
+                         /*window_micros=*/60 * 1000 * 1000, stream.SendFn());
+  batcher.Flush();
+  EXPECT_TRUE(stream.requests().empty());
+
+  const EnqueueRequest request = OpRequest({5, 6});
+  EnqueueResponse response;
+  Notification done;
+  batcher.EnqueueAsync(&request, &response,
+                       [&done](const Status& s) {
+                         TF_EXPECT_OK(s);
+                         done.Notify();
+                       });
+  EXPECT_FALSE(done.HasBeenNotified());
+  batcher.Flush();
+  EXPECT_TRUE(done.HasBeenNotified());
+  ExpectResponse(response, {5, 6});
+  EXPECT_EQ(stream.requests().size(), 1);
+}
+
+TEST(EnqueueBatcherTest, SendsAfterWindow) {
+  FakeStream stream;
+  EnqueueBatcher batcher(Env::Default(), kContextId, /*max_batch_items=*/100,
+                         /*window_micros=*/1000, stream.SendFn());
+  const EnqueueRequest request = OpRequest({8});
+  EnqueueResponse response;
+  Notification done;
+  batcher.EnqueueAsync(&request, &response, [&done](const Status& s) {
+    TF_EXPECT_OK(s);
+    done.Notify();
+  });
+  done.WaitForNotification();
+  ExpectResponse(response, {8});
+}
+
+TEST(EnqueueBatcherTest, FailsAllRequestsOfBatch) {
+  FakeStream stream;
+  stream.status_ = errors::Unavailable("stream broken");
+  EnqueueBatcher batcher(Env::Default(), kContextId, /*max_batch_items=*/2,
+                         /*window_micros=*/60 * 1000 * 1000, stream.SendFn());
+  const EnqueueRequest requests[2] = {OpRequest({1}), OpRequest({2})};
+  EnqueueResponse responses[2];
+  int num_failed = 0;
+  for (int i = 0; i < 2; ++i) {
+    batcher.EnqueueAsync(&requests[i], &responses[i],
+                         [&num_failed](const Status& s) {
+                           EXPECT_TRUE(errors::IsUnavailable(s));
+                           ++num_failed;
+                         });
+  }
+  EXPECT_EQ(num_failed, 2);
+  EXPECT_EQ(responses[0].queue_response_size(), 0);
+}
+
+TEST(EnqueueBatcherTest, PreservesOrderWhenEnqueuingFromCallback) {
+  FakeStream stream;
+  EnqueueBatcher batcher(Env::Default(), kContextId, /*max_batch_items=*/1,
+                         /*window_micros=*/60 * 1000 * 1000, stream.SendFn());
+  const EnqueueRequest requests[2] = {OpRequest({1}), OpRequest({2})};
+  EnqueueResponse responses[2];
+  batcher.EnqueueAsync(&requests[0], &responses[0], [&](const Status& s) {
+    batcher.EnqueueAsync(&requests[1], &responses[1],
+                         [](const Status& s) { TF_EXPECT_OK(s); });
+  });
+  ASSERT_EQ(stream.requests().size(), 2);
+  EXPECT_EQ(stream.requests()[0].queue(0).operation().id(), 1);
+  EXPECT_EQ(stream.requests()[1].queue(0).operation().id(), 2);
+  ExpectResponse(responses[1], {2});
+}
+
+// Enqueues ops of one item each to a stream which answers a request in
+// `request_micros`, and waits for all of them.
+static void BM_EnqueueBatcher(int iters, int max_batch_items,
+                              int request_micros) {
+  testing::StopTiming();
+  constexpr int kNumOps = 1000;
+  FakeStream stream(request_micros);
+  EnqueueBatcher batcher(Env::Default(), kContextId, max_batch_items,
+                         /*window_micros=*/max_batch_items > 1 ? 100 : 0,
+                         stream.SendFn());
+  const EnqueueRequest request = OpRequest({1});
+  std::vector<EnqueueResponse> responses(kNumOps);
+  testing::SetLabel(strings::StrCat(kNumOps, " ops; batch size ",
+                                    max_batch_items, "; request micros ",
+                                    request_micros));
+
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    BlockingCounter pending(kNumOps);
+    for (int j = 0; j < kNumOps; ++j) {
+      responses[j].Clear();
+      batcher.EnqueueAsync(&request, &responses[j],
+                           [&pending](const Status& s) {
+                             TF_CHECK_OK(s);
+                             pending.DecrementCount();
+                           });
+    }
+    batcher.Flush();
+    pending.Wait();
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_EnqueueBatcher)
+    ->ArgPair(1, 10)
+    ->ArgPair(8, 10)
+    ->ArgPair(64, 10)
+    ->ArgPair(1, 100)
+    ->ArgPair(8, 100)
+    ->ArgPair(64, 100);
+
+}  // namespace
+}  // namespace eager
+}  // namespace tensorflow
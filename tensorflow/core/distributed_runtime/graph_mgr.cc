@@ -64,10 +64,16 @@ GraphMgr::GraphMgr(const WorkerEnv* worker_env, DeviceMgr* device_mgr)
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  status = ReadInt64FromEnvVar("TF_GRAPH_MGR_MAX_IDLE_CACHED_GRAPHS", 16,
+                               &max_idle_cached_graphs_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
 }
 
 GraphMgr::~GraphMgr() {
   for (auto p : table_) p.second->Unref();
+  for (auto p : cache_) p.second->Unref();
 }
 
 GraphMgr::Item::~Item() {
@@ -302,15 +308,65 @@ Status GraphMgr::Register(
   // Inserts one item into table_.
   {
     mutex_lock l(mu_);
-    *graph_handle = strings::Printf("%016llx", ++next_id_);
-    item->handle = *graph_handle;
-    CHECK(table_.insert({*graph_handle, item}).second);
+    AddHandleLocked(item, graph_handle);
+  }
+  return Status::OK();
+}
+
+Status GraphMgr::RegisterAndCache(
+    uint64 fingerprint, const string& handle, const GraphDef& gdef,
+    WorkerSession* session, const GraphOptions& graph_options,
+    const DebugOptions& debug_options, const ConfigProto& config_proto,
+    int64 collective_graph_key, DistributedFunctionLibraryRuntime* cluster_flr,
+    string* graph_handle) {
+  if (RegisterCached(fingerprint, graph_handle)) {
+    return Status::OK();
+  }
+  Item* item = new Item;
+  Status s = InitItem(handle, gdef, session, graph_options, debug_options,
+                      config_proto, collective_graph_key, cluster_flr, item);
+  if (!s.ok()) {
+    item->Unref();
+    return s;
   }
+
+  mutex_lock l(mu_);
+  // The same graph may have been registered concurrently, in which case this
+  // one is not cached.
+  if (cache_.insert({fingerprint, item}).second) {
+    item->fingerprint = fingerprint;
+    item->Ref();
+  }
+  AddHandleLocked(item, graph_handle);
   return Status::OK();
 }
 
+bool GraphMgr::RegisterCached(uint64 fingerprint, string* graph_handle) {
+  mutex_lock l(mu_);
+  auto iter = cache_.find(fingerprint);
+  if (iter == cache_.end()) {
+    return false;
+  }
+  Item* item = iter->second;
+  item->Ref();
+  AddHandleLocked(item, graph_handle);
+  VLOG(1) << "Registered cached graph " << fingerprint << " as "
+          << *graph_handle;
+  return true;
+}
+
+void GraphMgr::AddHandleLocked(Item* item, string* graph_handle) {
+  *graph_handle = strings::Printf("%016llx", ++next_id_);
+  if (item->handle.empty()) {
+    item->handle = *graph_handle;
+  }
+  ++item->num_handles;
+  CHECK(table_.insert({*graph_handle, item}).second);
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
+  std::vector<Item*> evicted;
   // Removes one item from table_.
   {
     mutex_lock l(mu_);
@@ -321,8 +377,22 @@ Status GraphMgr::Deregister(const string& handle) {
     }
     item = iter->second;
     table_.erase(iter);
+    if (--item->num_handles == 0 && item->fingerprint != 0) {
+      idle_.push_back(item->fingerprint);
+      while (static_cast<int64>(idle_.size()) > max_idle_cached_graphs_) {
+        auto cached = cache_.find(idle_.front());
+        idle_.pop_front();
+        if (cached != cache_.end() && cached->second->num_handles == 0) {
+          evicted.push_back(cached->second);
+          cache_.erase(cached);
+        }
+      }
+    }
   }
   item->Unref();
+  for (Item* cached : evicted) {
+    cached->Unref();
+  }
   return Status::OK();
 }
 
@@ -335,6 +405,11 @@ Status GraphMgr::DeregisterAll() {
       items.push_back(entry.second);
     }
     table_.clear();
+    for (const auto& entry : cache_) {
+      items.push_back(entry.second);
+    }
+    cache_.clear();
+    idle_.clear();
   }
   for (auto item : items) {
     item->Unref();
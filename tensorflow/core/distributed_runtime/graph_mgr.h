@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <deque>
 #include <unordered_map>
 #include <vector>
 
@@ -81,6 +82,24 @@ class GraphMgr {
                   DistributedFunctionLibraryRuntime* cluster_flr,
                   string* graph_handle);
 
+  // Like Register(), and keeps the registered graph under "fingerprint",
+  // which identifies all the arguments, so that the same graph can be
+  // registered again with RegisterCached() without rebuilding its
+  // executors. The graphs cached with no handle are kept up to the limit
+  // set by TF_GRAPH_MGR_MAX_IDLE_CACHED_GRAPHS (default: 16).
+  Status RegisterAndCache(uint64 fingerprint, const string& handle,
+                          const GraphDef& gdef, WorkerSession* session,
+                          const GraphOptions& graph_options,
+                          const DebugOptions& debug_options,
+                          const ConfigProto& config_proto,
+                          int64 collective_graph_key,
+                          DistributedFunctionLibraryRuntime* cluster_flr,
+                          string* graph_handle);
+
+  // Registers the graph cached under "fingerprint" with a new handle, fills
+  // in "graph_handle" and returns true, or returns false if there is none.
+  bool RegisterCached(uint64 fingerprint, string* graph_handle);
+
   // Executes one step of a registered graph "handle".
   //
   // If "out" is not nullptr, "out" specifies all keys the execution
@@ -142,6 +161,11 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64 collective_graph_key;
+
+    // The key of the item in cache_, or 0 if it is not cached.
+    uint64 fingerprint = 0;
+    // The number of handles of the item in table_. Guarded by mu_.
+    int num_handles = 0;
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -163,6 +187,17 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Registered graphs by fingerprint, each holding a reference.
+  std::unordered_map<uint64, Item*> cache_ GUARDED_BY(mu_);
+  // The fingerprints of the cached graphs with no handle, least recently
+  // deregistered first. May contain graphs registered again since.
+  std::deque<uint64> idle_ GUARDED_BY(mu_);
+  int64 max_idle_cached_graphs_ = 16;
+
+  // Adds a handle for "item" to table_, which takes over a reference.
+  void AddHandleLocked(Item* item, string* graph_handle)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               CollectiveExecutor::Handle* ce_handle,
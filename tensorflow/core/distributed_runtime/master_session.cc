@@ -20,6 +20,7 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/profile_handler.h"
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
@@ -47,10 +48,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -59,6 +62,53 @@ limitations under the License.
 
 namespace tensorflow {
 
+// The partitions registered with the workers and cached by them, by worker
+// name and fingerprint of the registration.
+class MasterSession::RegisteredGraphs {
+ public:
+  bool Contains(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu_);
+    return keys_.count(Key(worker, fingerprint)) > 0;
+  }
+
+  void Insert(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu_);
+    keys_.insert(Key(worker, fingerprint));
+  }
+
+  void Erase(const string& worker, uint64 fingerprint) {
+    mutex_lock l(mu_);
+    keys_.erase(Key(worker, fingerprint));
+  }
+
+ private:
+  static string Key(const string& worker, uint64 fingerprint) {
+    return strings::StrCat(worker, "#", fingerprint);
+  }
+
+  mutex mu_;
+  std::unordered_set<string> keys_ GUARDED_BY(mu_);
+};
+
+namespace {
+
+// The RunGraph requests of fewer partitions are built and issued serially.
+constexpr int kMinPartitionsForParallelRun = 16;
+// The estimated number of cycles to build and issue a RunGraph request.
+constexpr int64 kPartitionRequestCost = 50000;
+// The number of RunGraph requests kept for reuse by partition.
+constexpr size_t kMaxFreeRunGraphRequests = 4;
+
+// Returns the fingerprint of a registration, which is never 0.
+uint64 RegistrationFingerprint(const RegisterGraphRequest& req) {
+  string serialized;
+  SerializeToStringDeterministic(req, &serialized);
+  const uint64 fingerprint = Fingerprint64(serialized);
+  return fingerprint == 0 ? 1 : fingerprint;
+}
+
+}  // namespace
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -71,7 +121,8 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
                     const SessionOptions& session_opts,
                     const StatsPublisherFactory& stats_publisher_factory,
                     bool is_partial, WorkerCacheInterface* worker_cache,
-                    bool should_deregister)
+                    bool should_deregister,
+                    std::shared_ptr<RegisteredGraphs> registered_graphs)
       : session_handle_(handle),
         bg_opts_(bopts),
         client_graph_before_register_(std::move(client_graph)),
@@ -80,6 +131,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         callable_opts_(bopts.callable_options),
         worker_cache_(worker_cache),
         should_deregister_(should_deregister),
+        registered_graphs_(std::move(registered_graphs)),
         collective_graph_key_(
             client_graph_before_register_->collective_graph_key) {
     VLOG(1) << "Created ReffedClientGraph for node with "
@@ -244,6 +296,7 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   std::unordered_map<string, NodeDetails> name_to_node_details_;
 
   const bool should_deregister_;
+  const std::shared_ptr<RegisteredGraphs> registered_graphs_;
   const int64 collective_graph_key_;
   std::atomic<int64> execution_count_ = {0};
 
@@ -285,6 +338,11 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
 
   std::unique_ptr<StatsPublisherInterface> stats_publisher_;
 
+  // The RunGraph requests of the previous steps, by partition.
+  mutex requests_mu_;
+  std::vector<std::vector<std::unique_ptr<MutableRunGraphRequestWrapper>>>
+      free_requests_ GUARDED_BY(requests_mu_);
+
   string DetailText(const NodeDetails& details, const NodeExecStats& stats) {
     int64 tot = 0;
     for (auto& no : stats.output()) {
@@ -327,6 +385,16 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // destructor and does not wait for the rpc completion.
   void DeregisterPartitions();
 
+  // Runs `fn` for the index of every partition, in parallel on the compute
+  // pool when there are many partitions.
+  void ForEachPartition(const std::function<void(int)>& fn);
+
+  // Returns a RunGraph request for the i-th partition without feeds, reused
+  // from a previous step if possible, and takes it back after the step.
+  std::unique_ptr<MutableRunGraphRequestWrapper> AcquireRunGraphRequest(int i);
+  void ReleaseRunGraphRequest(
+      int i, std::unique_ptr<MutableRunGraphRequestWrapper> request);
+
   TF_DISALLOW_COPY_AND_ASSIGN(ReffedClientGraph);
 };
 
@@ -461,11 +529,26 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
   struct Call {
     RegisterGraphRequest req;
     RegisterGraphResponse resp;
+    // The graph left out of the request because the worker keeps it.
+    GraphDef omitted_graph_def;
     Status status;
   };
   const int num = partitions_.size();
   gtl::InlinedVector<Call, 4> calls(num);
-  BlockingCounter done(num);
+  auto register_graphs = [this, &calls](const std::vector<int>& indices) {
+    BlockingCounter done(indices.size());
+    for (int i : indices) {
+      Call* c = &calls[i];
+      VLOG(2) << "Register " << c->req.graph_def().DebugString();
+      auto cb = [c, &done](const Status& s) {
+        c->status = s;
+        done.DecrementCount();
+      };
+      partitions_[i].worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+    }
+    done.Wait();
+  };
+  std::vector<int> indices;
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     Call* c = &calls[i];
@@ -477,18 +560,35 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     *c->req.mutable_debug_options() =
         callable_opts_.run_options().debug_options();
     c->req.set_collective_graph_key(collective_graph_key_);
-    VLOG(2) << "Register " << c->req.graph_def().DebugString();
-    auto cb = [c, &done](const Status& s) {
-      c->status = s;
-      done.DecrementCount();
-    };
-    part.worker->RegisterGraphAsync(&c->req, &c->resp, cb);
+    c->req.set_graph_fingerprint(RegistrationFingerprint(c->req));
+    if (registered_graphs_->Contains(part.name, c->req.graph_fingerprint())) {
+      c->omitted_graph_def.Swap(c->req.mutable_graph_def());
+      c->req.clear_graph_def();
+    }
+    indices.push_back(i);
   }
-  done.Wait();
+  register_graphs(indices);
+  // Sends the graphs which the workers no longer keep.
+  indices.clear();
+  for (int i = 0; i < num; ++i) {
+    Call* c = &calls[i];
+    if (c->status.ok() && c->resp.graph_def_required()) {
+      registered_graphs_->Erase(partitions_[i].name,
+                                c->req.graph_fingerprint());
+      c->req.mutable_graph_def()->Swap(&c->omitted_graph_def);
+      c->resp.Clear();
+      indices.push_back(i);
+    }
+  }
+  if (!indices.empty()) register_graphs(indices);
   for (int i = 0; i < num; ++i) {
     Call* c = &calls[i];
     s.Update(c->status);
     partitions_[i].graph_handle = c->resp.graph_handle();
+    if (c->status.ok() && c->resp.graph_cached()) {
+      registered_graphs_->Insert(partitions_[i].name,
+                                 c->req.graph_fingerprint());
+    }
   }
   return s;
 }
@@ -506,6 +606,9 @@ class RunManyGraphs {
     CallOptions opts;
     const string* worker_name;
     std::atomic<bool> done{false};
+    // The wall time of the RunGraph call.
+    uint64 start_micros = 0;
+    uint64 end_micros = 0;
     std::unique_ptr<MutableRunGraphRequestWrapper> req;
     std::unique_ptr<MutableRunGraphResponseWrapper> resp;
   };
@@ -515,6 +618,7 @@ class RunManyGraphs {
   void WhenDone(int index, const Status& s) {
     TRACEPRINTF("Partition %d %s", index, s.ToString().c_str());
     Call* call = get(index);
+    call->end_micros = Env::Default()->NowMicros();
     call->done = true;
     auto resp = call->resp.get();
     if (resp->status_code() != error::Code::OK) {
@@ -658,6 +762,9 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   if (pss->collect_partition_graphs) {
     exec_opts.set_record_partition_graphs(true);
   }
+  if (pss->collect_worker_step_timings) {
+    exec_opts.set_record_step_timings(true);
+  }
   if (pss->collect_costs || pss->collect_timeline) {
     pss->step_stats.resize(partitions_.size());
   }
@@ -665,22 +772,18 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   const int num = partitions_.size();
   RunManyGraphs calls(num);
 
-  for (int i = 0; i < num; ++i) {
+  // Builds the request of a partition, which converts its feeds.
+  auto build_request = [&](int i) -> Status {
     const Part& part = partitions_[i];
     RunManyGraphs::Call* c = calls.get(i);
     c->worker_name = &part.name;
-    c->req.reset(part.worker->CreateRunGraphRequest());
+    c->req = AcquireRunGraphRequest(i);
     c->resp.reset(part.worker->CreateRunGraphResponse());
     if (is_partial_) {
-      c->req->set_is_partial(is_partial_);
       c->req->set_is_last_partial_run(is_last_partial_run);
     }
-    c->req->set_session_handle(session_handle_);
-    c->req->set_create_worker_session_called(!should_deregister_);
-    c->req->set_graph_handle(part.graph_handle);
     c->req->set_step_id(step_id);
     *c->req->mutable_exec_opts() = exec_opts;
-    c->req->set_store_errors_in_response_body(true);
     c->req->set_request_id(GetUniqueRequestId());
     // If any feeds are provided, send the feed values together
     // in the RunGraph request.
@@ -710,6 +813,7 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
         }
       }
     } else {
+      // The recv keys are added when the request is created.
       for (const auto& feed_key : part.feed_key) {
         const string& feed = feed_key.first;
         const string& key = feed_key.second;
@@ -721,22 +825,25 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
         TF_RETURN_IF_ERROR(
             AddSendFromClientRequest(req, c->req.get(), feed_index, key));
       }
-      for (const auto& key_fetch : part.key_fetch) {
-        const string& key = key_fetch.first;
-        c->req->add_recv_key(key);
-      }
     }
+    return Status::OK();
+  };
+  std::vector<Status> build_status(num);
+  ForEachPartition([&](int i) { build_status[i] = build_request(i); });
+  for (const Status& s : build_status) {
+    TF_RETURN_IF_ERROR(s);
   }
 
-  // Issues RunGraph calls.
-  for (int i = 0; i < num; ++i) {
+  // Issues RunGraph calls, which serializes the requests.
+  ForEachPartition([&](int i) {
     const Part& part = partitions_[i];
     RunManyGraphs::Call* call = calls.get(i);
     TRACEPRINTF("Partition %d %s", i, part.name.c_str());
+    call->start_micros = Env::Default()->NowMicros();
     part.worker->RunGraphAsync(
         &call->opts, call->req.get(), call->resp.get(),
         std::bind(&RunManyGraphs::WhenDone, &calls, i, std::placeholders::_1));
-  }
+  });
 
   // Waits for the RunGraph calls.
   call_opts->SetCancelCallback([&calls]() {
@@ -751,6 +858,11 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
     calls.StartCancel();
   }
   calls.Wait();
+  auto release_requests = gtl::MakeCleanup([this, &calls, num]() {
+    for (int i = 0; i < num; ++i) {
+      ReleaseRunGraphRequest(i, std::move(calls.get(i)->req));
+    }
+  });
   call_opts->ClearCancelCallback();
   if (success) {
     cm->DeregisterCallback(token);
@@ -763,7 +875,8 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
   Status status;
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
-    MutableRunGraphResponseWrapper* run_graph_resp = calls.get(i)->resp.get();
+    RunManyGraphs::Call* call = calls.get(i);
+    MutableRunGraphResponseWrapper* run_graph_resp = call->resp.get();
     for (size_t j = 0; j < run_graph_resp->num_recvs(); ++j) {
       auto iter = part.key_fetch.find(run_graph_resp->recv_key(j));
       if (iter == part.key_fetch.end()) {
@@ -796,10 +909,82 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
             run_graph_resp->mutable_partition_graph(i));
       }
     }
+    const uint64 run_graph_micros = call->end_micros - call->start_micros;
+    metrics::UpdateWorkerRunGraphTime(part.name, run_graph_micros);
+    if (pss->collect_worker_step_timings) {
+      WorkerStepTimings* timings = run_graph_resp->mutable_step_timings();
+      metrics::UpdateWorkerExecTime(part.name, timings->exec_micros());
+      for (const auto& src_wait : timings->recv_wait_micros()) {
+        metrics::UpdateWorkerRecvWaitTime(part.name, src_wait.first,
+                                          src_wait.second);
+      }
+      timings->set_worker(part.name);
+      timings->set_run_graph_micros(run_graph_micros);
+      resp->mutable_metadata()->add_worker_step_timings()->Swap(timings);
+    }
   }
   return status;
 }
 
+void MasterSession::ReffedClientGraph::ForEachPartition(
+    const std::function<void(int)>& fn) {
+  const int num = partitions_.size();
+  if (num < kMinPartitionsForParallelRun) {
+    for (int i = 0; i < num; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  ComputePool(session_opts_)
+      ->ParallelFor(num, kPartitionRequestCost, [&fn](int64 begin, int64 end) {
+        for (int64 i = begin; i < end; ++i) {
+          fn(i);
+        }
+      });
+}
+
+std::unique_ptr<MutableRunGraphRequestWrapper>
+MasterSession::ReffedClientGraph::AcquireRunGraphRequest(int i) {
+  // The recv keys of partial runs depend on the step.
+  if (!is_partial_) {
+    mutex_lock l(requests_mu_);
+    if (!free_requests_.empty() && !free_requests_[i].empty()) {
+      std::unique_ptr<MutableRunGraphRequestWrapper> request =
+          std::move(free_requests_[i].back());
+      free_requests_[i].pop_back();
+      request->clear_sends();
+      return request;
+    }
+  }
+  const Part& part = partitions_[i];
+  std::unique_ptr<MutableRunGraphRequestWrapper> request(
+      part.worker->CreateRunGraphRequest());
+  if (is_partial_) {
+    request->set_is_partial(is_partial_);
+  }
+  request->set_session_handle(session_handle_);
+  request->set_create_worker_session_called(!should_deregister_);
+  request->set_graph_handle(part.graph_handle);
+  request->set_store_errors_in_response_body(true);
+  if (!is_partial_) {
+    for (const auto& key_fetch : part.key_fetch) {
+      request->add_recv_key(key_fetch.first);
+    }
+  }
+  return request;
+}
+
+void MasterSession::ReffedClientGraph::ReleaseRunGraphRequest(
+    int i, std::unique_ptr<MutableRunGraphRequestWrapper> request) {
+  if (is_partial_ || request == nullptr) return;
+  mutex_lock l(requests_mu_);
+  free_requests_.resize(partitions_.size());
+  // Keeps enough requests for a few concurrent steps.
+  if (free_requests_[i].size() < kMaxFreeRunGraphRequests) {
+    free_requests_[i].push_back(std::move(request));
+  }
+}
+
 Status MasterSession::ReffedClientGraph::RunPartitions(
     const MasterEnv* env, int64 step_id, int64 execution_count,
     PerStepState* pss, CallOptions* call_opts, const RunStepRequestWrapper& req,
@@ -1237,7 +1422,8 @@ MasterSession::MasterSession(
       stats_publisher_factory_(std::move(stats_publisher_factory)),
       graph_version_(0),
       run_graphs_(5),
-      partial_run_graphs_(5) {
+      partial_run_graphs_(5),
+      registered_graphs_(std::make_shared<RegisteredGraphs>()) {
   UpdateLastAccessTime();
   CHECK(devices_) << "device_set was null!";
 
@@ -1518,7 +1704,7 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
       auto entry = new ReffedClientGraph(
           handle_, opts, std::move(client_graph), session_opts_,
           stats_publisher_factory_, is_partial, worker_cache,
-          !should_delete_worker_sessions_);
+          !should_delete_worker_sessions_, registered_graphs_);
       iter = m->insert({hash, entry}).first;
       VLOG(1) << "Preparing to execute new graph";
     }
@@ -1731,6 +1917,8 @@ Status MasterSession::DoPartialRun(CallOptions* opts,
         build_cost_model_every > 0 &&
         ((count + 1 - build_cost_model_after) % build_cost_model_every == 0);
     pss.collect_partition_graphs = req.options().output_partition_graphs();
+    pss.collect_worker_step_timings =
+        req.options().experimental().report_worker_step_timings();
 
     std::unique_ptr<ProfileHandler> ph = run_state->rcg->GetProfileHandler(
         run_state->step_id, count, req.options());
@@ -1866,6 +2054,8 @@ void MasterSession::FillPerStepState(MasterSession::ReffedClientGraph* rcg,
       build_cost_model_every > 0 &&
       ((count + 1 - build_cost_model_after) % build_cost_model_every == 0);
   out_pss->collect_partition_graphs = run_options.output_partition_graphs();
+  out_pss->collect_worker_step_timings =
+      run_options.experimental().report_worker_step_timings();
 
   *out_ph = rcg->GetProfileHandler(step_id, count, run_options);
   if (*out_ph) {
@@ -1987,7 +2177,8 @@ Status MasterSession::MakeCallable(const MakeCallableRequest& req,
     callable = new ReffedClientGraph(handle_, opts, std::move(client_graph),
                                      session_opts_, stats_publisher_factory_,
                                      false /* is_partial */, get_worker_cache(),
-                                     !should_delete_worker_sessions_);
+                                     !should_delete_worker_sessions_,
+                                     registered_graphs_);
   }
 
   Status s = BuildAndRegisterPartitions(callable);
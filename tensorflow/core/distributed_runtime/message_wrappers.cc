@@ -360,6 +360,11 @@ Status InMemoryRunGraphRequest::AddSendFromRunCallableRequest(
   return Status::OK();
 }
 
+void InMemoryRunGraphRequest::clear_sends() {
+  sends_.clear();
+  proto_version_.reset();
+}
+
 size_t InMemoryRunGraphRequest::num_recvs() const { return recvs_.size(); }
 
 const string& InMemoryRunGraphRequest::recv_key(size_t i) const {
@@ -505,6 +510,8 @@ Status MutableProtoRunGraphRequest::AddSendFromRunCallableRequest(
   return Status::OK();
 }
 
+void MutableProtoRunGraphRequest::clear_sends() { request_.clear_send(); }
+
 size_t MutableProtoRunGraphRequest::num_recvs() const {
   return request_.recv_key_size();
 }
@@ -644,6 +651,10 @@ CostGraphDef* InMemoryRunGraphResponse::mutable_cost_graph() {
   return &cost_graph_;
 }
 
+WorkerStepTimings* InMemoryRunGraphResponse::mutable_step_timings() {
+  return &step_timings_;
+}
+
 errors::Code InMemoryRunGraphResponse::status_code() const {
   return status_.code();
 }
@@ -712,6 +723,10 @@ CostGraphDef* OwnedProtoRunGraphResponse::mutable_cost_graph() {
   return response_.mutable_cost_graph();
 }
 
+WorkerStepTimings* OwnedProtoRunGraphResponse::mutable_step_timings() {
+  return response_.mutable_step_timings();
+}
+
 errors::Code OwnedProtoRunGraphResponse::status_code() const {
   return response_.status_code();
 }
@@ -783,6 +798,10 @@ CostGraphDef* NonOwnedProtoRunGraphResponse::mutable_cost_graph() {
   return response_->mutable_cost_graph();
 }
 
+WorkerStepTimings* NonOwnedProtoRunGraphResponse::mutable_step_timings() {
+  return response_->mutable_step_timings();
+}
+
 errors::Code NonOwnedProtoRunGraphResponse::status_code() const {
   return response_->status_code();
 }
@@ -320,6 +320,8 @@ class MutableRunGraphRequestWrapper : public RunGraphRequestWrapper {
   virtual Status AddSendFromRunCallableRequest(
       const RunCallableRequest& run_callable_request, size_t i,
       const string& send_key) = 0;
+  // Removes the feed values, so that the request can be reused.
+  virtual void clear_sends() = 0;
 
   virtual void add_recv_key(const string& recv_key) = 0;
   virtual void set_is_partial(bool is_partial) = 0;
@@ -359,6 +361,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   Status AddSendFromRunCallableRequest(
       const RunCallableRequest& run_callable_request, size_t i,
       const string& send_key) override;
+  void clear_sends() override;
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
@@ -419,6 +422,7 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   Status AddSendFromRunCallableRequest(
       const RunCallableRequest& run_callable_request, size_t i,
       const string& send_key) override;
+  void clear_sends() override;
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
@@ -493,6 +497,7 @@ class MutableRunGraphResponseWrapper {
   virtual size_t num_partition_graphs() const = 0;
   virtual GraphDef* mutable_partition_graph(size_t i) = 0;
   virtual void AddPartitionGraph(const GraphDef& partition_graph) = 0;
+  virtual WorkerStepTimings* mutable_step_timings() = 0;
 
   // Returned status if requested.
   virtual errors::Code status_code() const = 0;
@@ -528,6 +533,7 @@ class InMemoryRunGraphResponse : public MutableRunGraphResponseWrapper {
   size_t num_partition_graphs() const override;
   GraphDef* mutable_partition_graph(size_t i) override;
   void AddPartitionGraph(const GraphDef& partition_graph) override;
+  WorkerStepTimings* mutable_step_timings() override;
   errors::Code status_code() const override;
   const string& status_error_message() const override;
   void set_status(const Status& status) override;
@@ -542,6 +548,7 @@ class InMemoryRunGraphResponse : public MutableRunGraphResponseWrapper {
   StepStats step_stats_;
   CostGraphDef cost_graph_;
   std::vector<GraphDef> partition_graphs_;
+  WorkerStepTimings step_timings_;
   // Store the code and message separately so that they can be updated
   // independently by setters.
   Status status_;
@@ -561,6 +568,7 @@ class OwnedProtoRunGraphResponse : public MutableRunGraphResponseWrapper {
   size_t num_partition_graphs() const override;
   GraphDef* mutable_partition_graph(size_t i) override;
   void AddPartitionGraph(const GraphDef& partition_graph) override;
+  WorkerStepTimings* mutable_step_timings() override;
   errors::Code status_code() const override;
   const string& status_error_message() const override;
   void set_status(const Status& status) override;
@@ -588,6 +596,7 @@ class NonOwnedProtoRunGraphResponse : public MutableRunGraphResponseWrapper {
   size_t num_partition_graphs() const override;
   GraphDef* mutable_partition_graph(size_t i) override;
   void AddPartitionGraph(const GraphDef& partition_graph) override;
+  WorkerStepTimings* mutable_step_timings() override;
   errors::Code status_code() const override;
   const string& status_error_message() const override;
   void set_status(const Status& status) override;
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -109,6 +111,9 @@ void BuildRunGraphResponse(MutableRunGraphResponseWrapper* run_graph_response) {
   graph_def.mutable_versions()->set_producer(1234);
   graph_def.mutable_versions()->set_min_consumer(1234);
   run_graph_response->AddPartitionGraph(graph_def);
+  WorkerStepTimings* timings = run_graph_response->mutable_step_timings();
+  timings->set_exec_micros(5678);
+  (*timings->mutable_recv_wait_micros())["/job:worker/task:1/cpu:0"] = 42;
 }
 
 void CheckRunGraphResponse(MutableRunGraphResponseWrapper* response) {
@@ -128,6 +133,10 @@ void CheckRunGraphResponse(MutableRunGraphResponseWrapper* response) {
   EXPECT_EQ(1234, response->mutable_partition_graph(0)->versions().producer());
   EXPECT_EQ(1234,
             response->mutable_partition_graph(0)->versions().min_consumer());
+  EXPECT_EQ(5678, response->mutable_step_timings()->exec_micros());
+  ASSERT_EQ(1, response->mutable_step_timings()->recv_wait_micros_size());
+  EXPECT_EQ(42, response->mutable_step_timings()->recv_wait_micros().at(
+                    "/job:worker/task:1/cpu:0"));
 }
 
 void BuildRunStepResponse(MutableRunGraphResponseWrapper* run_graph_response,
@@ -236,6 +245,32 @@ TEST(MessageWrappers, RunGraphRequest_Basic) {
   }
 }
 
+TEST(MessageWrappers, RunGraphRequest_ClearSends) {
+  InMemoryRunStepRequest run_step_request;
+  BuildRunStepRequest(&run_step_request);
+
+  InMemoryRunGraphRequest in_memory_request;
+  MutableProtoRunGraphRequest mutable_proto_request;
+  for (MutableRunGraphRequestWrapper* request :
+       std::vector<MutableRunGraphRequestWrapper*>{&in_memory_request,
+                                                   &mutable_proto_request}) {
+    BuildRunGraphRequest(run_step_request, request);
+    CheckRunGraphRequest(ProtoRunGraphRequest(&request->ToProto()));
+
+    // The request can be reused once its feeds are removed.
+    request->clear_sends();
+    EXPECT_EQ(0, request->num_sends());
+    EXPECT_EQ(0, request->ToProto().send_size());
+    EXPECT_EQ(2, request->num_recvs());
+    TF_EXPECT_OK(
+        request->AddSendFromRunStepRequest(run_step_request, 0, "send_0"));
+    TF_EXPECT_OK(
+        request->AddSendFromRunStepRequest(run_step_request, 1, "send_1"));
+    CheckRunGraphRequest(*request);
+    CheckRunGraphRequest(ProtoRunGraphRequest(&request->ToProto()));
+  }
+}
+
 TEST(MessageWrappers, RunGraphResponse_Basic) {
   InMemoryRunGraphResponse in_memory_response;
   BuildRunGraphResponse(&in_memory_response);
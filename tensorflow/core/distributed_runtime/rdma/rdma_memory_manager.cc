@@ -0,0 +1,802 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+
+#include <fcntl.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of work requests posted at once on a queue pair, in each
+// direction.
+constexpr int kQueueDepth = 128;
+constexpr int kCompletionQueueSize = 4096;
+constexpr int kMaxReadsInFlight = 16;
+// RDMA reads are limited to 2^31 bytes, larger tensors go over gRPC.
+constexpr int64 kMaxTensorBytes = 1LL << 30;
+constexpr int kPollTimeoutMillis = 100;
+constexpr int kMaxCompletionsPerPoll = 32;
+
+Status RdmaError(const char* function, int error) {
+  return errors::Unavailable(function, " failed: ", strerror(error));
+}
+
+const char* EndOf(const ibv_mr* mr) {
+  return static_cast<const char*>(mr->addr) + mr->length;
+}
+
+string EndpointKey(const RdmaEndpoint& endpoint) {
+  return strings::StrCat(endpoint.gid(), ":", endpoint.lid(), ":",
+                         endpoint.qpn());
+}
+
+}  // namespace
+
+void RdmaMemoryRegionMap::Insert(ibv_mr* mr) {
+  mutex_lock l(mu_);
+  auto it = std::upper_bound(regions_.begin(), regions_.end(), EndOf(mr),
+                             [](const char* addr, const ibv_mr* other) {
+                               return addr < EndOf(other);
+                             });
+  regions_.insert(it, mr);
+}
+
+ibv_mr* RdmaMemoryRegionMap::Erase(const void* addr) {
+  mutex_lock l(mu_);
+  auto it = std::find_if(regions_.begin(), regions_.end(),
+                         [addr](const ibv_mr* mr) { return mr->addr == addr; });
+  if (it == regions_.end()) {
+    return nullptr;
+  }
+  ibv_mr* mr = *it;
+  regions_.erase(it);
+  return mr;
+}
+
+ibv_mr* RdmaMemoryRegionMap::Find(const void* addr, size_t size) const {
+  const char* begin = static_cast<const char*>(addr);
+  mutex_lock l(mu_);
+  // The regions don't overlap, so only the first region which ends after
+  // `addr` can contain it.
+  auto it = std::upper_bound(
+      regions_.begin(), regions_.end(), begin,
+      [](const char* addr, const ibv_mr* mr) { return addr < EndOf(mr); });
+  if (it == regions_.end() || begin < static_cast<const char*>((*it)->addr) ||
+      begin + size > EndOf(*it)) {
+    return nullptr;
+  }
+  return *it;
+}
+
+std::vector<ibv_mr*> RdmaMemoryRegionMap::Clear() {
+  mutex_lock l(mu_);
+  std::vector<ibv_mr*> regions;
+  regions.swap(regions_);
+  return regions;
+}
+
+struct RdmaMemoryManager::WorkRequest {
+  enum Kind { kRead, kRelease, kReceive };
+  Kind kind;
+  Connection* connection = nullptr;
+  // Whether the request is on the send queue.
+  bool posted = false;
+  // Why the request could not be posted.
+  Status status;
+
+  // The local and remote buffers of a read.
+  uint64 local_addr = 0;
+  uint32 lkey = 0;
+  uint64 remote_addr = 0;
+  uint32 rkey = 0;
+  uint32 size = 0;
+  ibv_mr* owned_mr = nullptr;
+  StatusCallback done;
+
+  // The buffer to release once a read is done, sent in the release message.
+  uint64 buffer_key = 0;
+  // Where a release message is received.
+  uint64* release_slot = nullptr;
+};
+
+struct RdmaMemoryManager::Connection {
+  ~Connection() {
+    if (qp != nullptr) {
+      ibv_destroy_qp(qp);
+    }
+    if (release_mr != nullptr) {
+      ibv_dereg_mr(release_mr);
+    }
+    for (WorkRequest* request : pending_sends) {
+      delete request;
+    }
+  }
+
+  ibv_qp* qp = nullptr;
+  RdmaEndpoint local;
+  RdmaEndpoint remote;
+  bool connected = false;
+  bool retired = false;
+  int outstanding_sends = 0;
+  // The requests waiting for room on the send queue.
+  std::deque<WorkRequest*> pending_sends;
+  // The connections to the receivers receive their release messages.
+  std::vector<uint64> release_slots;
+  ibv_mr* release_mr = nullptr;
+  std::vector<std::unique_ptr<WorkRequest>> receives;
+};
+
+Status RdmaMemoryManager::Create(bool register_cpu_allocators,
+                                 std::unique_ptr<RdmaMemoryManager>* manager) {
+  std::unique_ptr<RdmaMemoryManager> result(new RdmaMemoryManager);
+  TF_RETURN_IF_ERROR(result->Init(register_cpu_allocators));
+  *manager = std::move(result);
+  return Status::OK();
+}
+
+Status RdmaMemoryManager::Init(bool register_cpu_allocators) {
+  string device_name;
+  int64 port;
+  int64 gid_index;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar("TF_RDMA_DEVICE", "", &device_name));
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RDMA_PORT", 1, &port));
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RDMA_GID_INDEX", 0, &gid_index));
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RDMA_MIN_TENSOR_BYTES", 64 << 10,
+                                         &min_tensor_bytes_));
+  port_ = port;
+  gid_index_ = gid_index;
+
+  int num_devices = 0;
+  ibv_device** devices = ibv_get_device_list(&num_devices);
+  if (devices == nullptr) {
+    return RdmaError("ibv_get_device_list", errno);
+  }
+  auto free_devices =
+      gtl::MakeCleanup([devices] { ibv_free_device_list(devices); });
+  ibv_device* device = nullptr;
+  for (int i = 0; i < num_devices && device == nullptr; ++i) {
+    if (device_name.empty() || device_name == ibv_get_device_name(devices[i])) {
+      device = devices[i];
+    }
+  }
+  if (device == nullptr) {
+    return errors::NotFound("No RDMA device ", device_name, " found");
+  }
+  device_name = ibv_get_device_name(device);
+
+  context_ = ibv_open_device(device);
+  if (context_ == nullptr) {
+    return RdmaError("ibv_open_device", errno);
+  }
+  ibv_device_attr device_attr;
+  int err = ibv_query_device(context_, &device_attr);
+  if (err != 0) {
+    return RdmaError("ibv_query_device", err);
+  }
+  max_reads_in_flight_ =
+      std::max(1, std::min(kMaxReadsInFlight, device_attr.max_qp_rd_atom));
+  err = ibv_query_port(context_, port_, &port_attr_);
+  if (err != 0) {
+    return RdmaError("ibv_query_port", err);
+  }
+  if (port_attr_.state != IBV_PORT_ACTIVE) {
+    return errors::Unavailable("Port ", port_, " of RDMA device ", device_name,
+                               " is not active");
+  }
+  err = ibv_query_gid(context_, port_, gid_index_, &gid_);
+  if (err != 0) {
+    return RdmaError("ibv_query_gid", err);
+  }
+
+  pd_ = ibv_alloc_pd(context_);
+  if (pd_ == nullptr) {
+    return RdmaError("ibv_alloc_pd", errno);
+  }
+  channel_ = ibv_create_comp_channel(context_);
+  if (channel_ == nullptr) {
+    return RdmaError("ibv_create_comp_channel", errno);
+  }
+  // The channel is polled with a timeout, so that the polling thread notices
+  // when the manager stops.
+  const int flags = fcntl(channel_->fd, F_GETFL);
+  if (flags < 0 || fcntl(channel_->fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    return RdmaError("fcntl", errno);
+  }
+  cq_ = ibv_create_cq(context_,
+                      std::min(kCompletionQueueSize, device_attr.max_cqe),
+                      nullptr, channel_, 0);
+  if (cq_ == nullptr) {
+    return RdmaError("ibv_create_cq", errno);
+  }
+  err = ibv_req_notify_cq(cq_, 0);
+  if (err != 0) {
+    return RdmaError("ibv_req_notify_cq", err);
+  }
+
+  if (register_cpu_allocators) {
+    // The CPU allocators live for the whole process, so the manager must too.
+    ProcessState::singleton()->AddCPUAllocVisitor(
+        [this](void* ptr, int numa_node, size_t num_bytes) {
+          ibv_mr* mr =
+              ibv_reg_mr(pd_, ptr, num_bytes,
+                         IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ);
+          if (mr == nullptr) {
+            LOG(WARNING) << "Failed to register " << num_bytes
+                         << " bytes of CPU memory for RDMA: "
+                         << strerror(errno);
+            return;
+          }
+          regions_.Insert(mr);
+        });
+    ProcessState::singleton()->AddCPUFreeVisitor(
+        [this](void* ptr, int numa_node, size_t num_bytes) {
+          ibv_mr* mr = regions_.Erase(ptr);
+          if (mr != nullptr) {
+            ibv_dereg_mr(mr);
+          }
+        });
+  }
+
+  poll_thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "rdma_poll_completions", [this] { PollCompletions(); }));
+  VLOG(1) << "Using port " << port_ << " of RDMA device " << device_name;
+  return Status::OK();
+}
+
+RdmaMemoryManager::~RdmaMemoryManager() {
+  {
+    mutex_lock l(mu_);
+    stopped_ = true;
+  }
+  // Joins the polling thread.
+  poll_thread_.reset();
+
+  // The callbacks of the requests still in flight are never called.
+  senders_.clear();
+  receivers_.clear();
+  retired_connections_.clear();
+  for (auto& key_and_buffer : pinned_buffers_) {
+    if (key_and_buffer.second.mr != nullptr) {
+      ibv_dereg_mr(key_and_buffer.second.mr);
+    }
+  }
+  pinned_buffers_.clear();
+  for (ibv_mr* mr : regions_.Clear()) {
+    ibv_dereg_mr(mr);
+  }
+  if (cq_ != nullptr) {
+    ibv_destroy_cq(cq_);
+  }
+  if (channel_ != nullptr) {
+    ibv_destroy_comp_channel(channel_);
+  }
+  if (pd_ != nullptr) {
+    ibv_dealloc_pd(pd_);
+  }
+  if (context_ != nullptr) {
+    ibv_close_device(context_);
+  }
+}
+
+bool RdmaMemoryManager::ShouldTransfer(const Tensor& tensor) const {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+    return false;
+  }
+  const int64 num_bytes = tensor.tensor_data().size();
+  return num_bytes >= min_tensor_bytes_ && num_bytes <= kMaxTensorBytes;
+}
+
+Status RdmaMemoryManager::GetEndpoint(const string& remote_worker,
+                                      RdmaEndpoint* endpoint) {
+  mutex_lock l(mu_);
+  std::unique_ptr<Connection>& connection = senders_[remote_worker];
+  if (connection == nullptr) {
+    Status s = CreateConnection(/*accepts_releases=*/false, &connection);
+    if (!s.ok()) {
+      senders_.erase(remote_worker);
+      return s;
+    }
+  }
+  *endpoint = connection->local;
+  return Status::OK();
+}
+
+Status RdmaMemoryManager::ExportTensor(const RdmaEndpoint& receiver,
+                                       const Tensor& tensor,
+                                       RdmaTensorBuffer* buffer) {
+  const StringPiece data = tensor.tensor_data();
+  ibv_mr* mr;
+  ibv_mr* owned_mr;
+  TF_RETURN_IF_ERROR(
+      FindOrRegister(data, IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ,
+                     &mr, &owned_mr));
+
+  mutex_lock l(mu_);
+  const string receiver_key = EndpointKey(receiver);
+  Connection* connection = receivers_[receiver_key].get();
+  if (connection == nullptr) {
+    std::unique_ptr<Connection> new_connection;
+    Status s = CreateConnection(/*accepts_releases=*/true, &new_connection);
+    if (s.ok()) {
+      s = ConnectQueuePair(new_connection.get(), receiver);
+    }
+    if (!s.ok()) {
+      receivers_.erase(receiver_key);
+      if (owned_mr != nullptr) {
+        ibv_dereg_mr(owned_mr);
+      }
+      return s;
+    }
+    connection = new_connection.get();
+    receivers_[receiver_key] = std::move(new_connection);
+  }
+
+  const uint64 buffer_key = next_buffer_key_++;
+  pinned_buffers_.emplace(buffer_key,
+                          PinnedBuffer{tensor, connection, owned_mr});
+  *buffer->mutable_endpoint() = connection->local;
+  buffer->set_addr(reinterpret_cast<uint64>(data.data()));
+  buffer->set_rkey(mr->rkey);
+  buffer->set_size(data.size());
+  buffer->set_buffer_key(buffer_key);
+  return Status::OK();
+}
+
+void RdmaMemoryManager::ImportTensor(const string& remote_worker,
+                                     const RdmaTensorBuffer& buffer,
+                                     const Tensor& tensor,
+                                     StatusCallback done) {
+  const StringPiece data = tensor.tensor_data();
+  if (data.size() != buffer.size()) {
+    done(errors::Internal("Expected ", data.size(), " bytes from ",
+                          remote_worker, ", got ", buffer.size()));
+    return;
+  }
+  ibv_mr* mr;
+  ibv_mr* owned_mr;
+  Status s = FindOrRegister(data, IBV_ACCESS_LOCAL_WRITE, &mr, &owned_mr);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  WorkRequest* request = new WorkRequest;
+  request->kind = WorkRequest::kRead;
+  request->local_addr = reinterpret_cast<uint64>(data.data());
+  request->lkey = mr->lkey;
+  request->remote_addr = buffer.addr();
+  request->rkey = buffer.rkey();
+  request->size = buffer.size();
+  request->owned_mr = owned_mr;
+  request->buffer_key = buffer.buffer_key();
+  request->done = std::move(done);
+
+  std::vector<WorkRequest*> failed;
+  {
+    mutex_lock l(mu_);
+    auto it = senders_.find(remote_worker);
+    if (it == senders_.end()) {
+      request->status =
+          errors::Internal("No RDMA connection to ", remote_worker);
+      failed.push_back(request);
+    } else {
+      Connection* connection = it->second.get();
+      if (!connection->connected) {
+        request->status = ConnectQueuePair(connection, buffer.endpoint());
+      } else if (EndpointKey(connection->remote) !=
+                 EndpointKey(buffer.endpoint())) {
+        // The remote worker restarted, the next request gets a new queue pair.
+        request->status = errors::Unavailable("The RDMA connection to ",
+                                              remote_worker, " was reset");
+      }
+      if (request->status.ok()) {
+        request->connection = connection;
+        PostSendLocked(request, &failed);
+      } else {
+        RetireConnectionLocked(connection, &failed);
+        failed.push_back(request);
+      }
+    }
+  }
+  for (WorkRequest* failed_request : failed) {
+    FinishSend(failed_request, failed_request->status);
+  }
+}
+
+Status RdmaMemoryManager::CreateConnection(
+    bool accepts_releases, std::unique_ptr<Connection>* connection) {
+  std::unique_ptr<Connection> result(new Connection);
+  ibv_qp_init_attr init_attr;
+  memset(&init_attr, 0, sizeof(init_attr));
+  init_attr.send_cq = cq_;
+  init_attr.recv_cq = cq_;
+  init_attr.qp_type = IBV_QPT_RC;
+  init_attr.cap.max_send_wr = kQueueDepth;
+  init_attr.cap.max_recv_wr = accepts_releases ? kQueueDepth : 1;
+  init_attr.cap.max_send_sge = 1;
+  init_attr.cap.max_recv_sge = 1;
+  init_attr.cap.max_inline_data = sizeof(uint64);
+  result->qp = ibv_create_qp(pd_, &init_attr);
+  if (result->qp == nullptr) {
+    return RdmaError("ibv_create_qp", errno);
+  }
+
+  ibv_qp_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.qp_state = IBV_QPS_INIT;
+  attr.pkey_index = 0;
+  attr.port_num = port_;
+  attr.qp_access_flags = IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ;
+  const int err = ibv_modify_qp(
+      result->qp, &attr,
+      IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT | IBV_QP_ACCESS_FLAGS);
+  if (err != 0) {
+    return RdmaError("ibv_modify_qp", err);
+  }
+
+  result->local.set_lid(port_attr_.lid);
+  result->local.set_qpn(result->qp->qp_num);
+  result->local.set_psn(random::New64() & 0xffffff);
+  result->local.set_gid(gid_.raw, sizeof(gid_.raw));
+  result->local.set_mtu(port_attr_.active_mtu);
+
+  if (accepts_releases) {
+    result->release_slots.resize(kQueueDepth);
+    result->release_mr = ibv_reg_mr(pd_, result->release_slots.data(),
+                                    kQueueDepth * sizeof(uint64),
+                                    IBV_ACCESS_LOCAL_WRITE);
+    if (result->release_mr == nullptr) {
+      return RdmaError("ibv_reg_mr", errno);
+    }
+    for (int i = 0; i < kQueueDepth; ++i) {
+      WorkRequest* request = new WorkRequest;
+      request->kind = WorkRequest::kReceive;
+      request->connection = result.get();
+      request->release_slot = &result->release_slots[i];
+      result->receives.emplace_back(request);
+      TF_RETURN_IF_ERROR(PostReceive(request));
+    }
+  }
+  *connection = std::move(result);
+  return Status::OK();
+}
+
+Status RdmaMemoryManager::ConnectQueuePair(Connection* connection,
+                                           const RdmaEndpoint& remote) {
+  ibv_qp_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.qp_state = IBV_QPS_RTR;
+  attr.path_mtu = static_cast<ibv_mtu>(
+      std::min<uint32>(port_attr_.active_mtu, remote.mtu()));
+  attr.dest_qp_num = remote.qpn();
+  attr.rq_psn = remote.psn();
+  attr.max_dest_rd_atomic = max_reads_in_flight_;
+  attr.min_rnr_timer = 12;
+  attr.ah_attr.dlid = remote.lid();
+  attr.ah_attr.sl = 0;
+  attr.ah_attr.src_path_bits = 0;
+  attr.ah_attr.port_num = port_;
+  if (remote.gid().size() == sizeof(attr.ah_attr.grh.dgid.raw)) {
+    ibv_gid remote_gid;
+    memcpy(remote_gid.raw, remote.gid().data(), sizeof(remote_gid.raw));
+    // RoCE has no local identifiers, and routes on the global ones.
+    if (remote_gid.global.interface_id != 0) {
+      attr.ah_attr.is_global = 1;
+      attr.ah_attr.grh.dgid = remote_gid;
+      attr.ah_attr.grh.sgid_index = gid_index_;
+      attr.ah_attr.grh.hop_limit = 64;
+    }
+  }
+  int err = ibv_modify_qp(connection->qp, &attr,
+                          IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU |
+                              IBV_QP_DEST_QPN | IBV_QP_RQ_PSN |
+                              IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER);
+  if (err != 0) {
+    return RdmaError("ibv_modify_qp", err);
+  }
+
+  memset(&attr, 0, sizeof(attr));
+  attr.qp_state = IBV_QPS_RTS;
+  attr.sq_psn = connection->local.psn();
+  attr.timeout = 14;
+  attr.retry_cnt = 7;
+  attr.rnr_retry = 7;
+  attr.max_rd_atomic = max_reads_in_flight_;
+  err = ibv_modify_qp(connection->qp, &attr,
+                      IBV_QP_STATE | IBV_QP_SQ_PSN | IBV_QP_TIMEOUT |
+                          IBV_QP_RETRY_CNT | IBV_QP_RNR_RETRY |
+                          IBV_QP_MAX_QP_RD_ATOMIC);
+  if (err != 0) {
+    return RdmaError("ibv_modify_qp", err);
+  }
+  connection->remote = remote;
+  connection->connected = true;
+  return Status::OK();
+}
+
+void RdmaMemoryManager::RetireConnectionLocked(
+    Connection* connection, std::vector<WorkRequest*>* failed) {
+  if (connection->retired) {
+    return;
+  }
+  connection->retired = true;
+  for (WorkRequest* request : connection->pending_sends) {
+    request->status = errors::Unavailable("The RDMA connection failed");
+    failed->push_back(request);
+  }
+  connection->pending_sends.clear();
+  // Keep the connection alive, the completions of its requests still refer to
+  // it.
+  for (auto* connections : {&senders_, &receivers_}) {
+    for (auto it = connections->begin(); it != connections->end(); ++it) {
+      if (it->second.get() == connection) {
+        retired_connections_.push_back(std::move(it->second));
+        connections->erase(it);
+        return;
+      }
+    }
+  }
+}
+
+Status RdmaMemoryManager::PostReceive(WorkRequest* request) {
+  ibv_sge sge;
+  sge.addr = reinterpret_cast<uint64>(request->release_slot);
+  sge.length = sizeof(uint64);
+  sge.lkey = request->connection->release_mr->lkey;
+  ibv_recv_wr wr;
+  memset(&wr, 0, sizeof(wr));
+  wr.wr_id = reinterpret_cast<uint64>(request);
+  wr.sg_list = &sge;
+  wr.num_sge = 1;
+  ibv_recv_wr* bad_wr = nullptr;
+  const int err = ibv_post_recv(request->connection->qp, &wr, &bad_wr);
+  if (err != 0) {
+    return RdmaError("ibv_post_recv", err);
+  }
+  return Status::OK();
+}
+
+void RdmaMemoryManager::PostSendLocked(WorkRequest* request,
+                                       std::vector<WorkRequest*>* failed) {
+  Connection* connection = request->connection;
+  if (connection->retired) {
+    request->status = errors::Unavailable("The RDMA connection failed");
+    failed->push_back(request);
+    return;
+  }
+  if (connection->outstanding_sends >= kQueueDepth) {
+    connection->pending_sends.push_back(request);
+    return;
+  }
+
+  ibv_sge sge;
+  ibv_send_wr wr;
+  memset(&wr, 0, sizeof(wr));
+  wr.wr_id = reinterpret_cast<uint64>(request);
+  wr.sg_list = &sge;
+  wr.num_sge = 1;
+  wr.send_flags = IBV_SEND_SIGNALED;
+  if (request->kind == WorkRequest::kRead) {
+    sge.addr = request->local_addr;
+    sge.length = request->size;
+    sge.lkey = request->lkey;
+    wr.opcode = IBV_WR_RDMA_READ;
+    wr.wr.rdma.remote_addr = request->remote_addr;
+    wr.wr.rdma.rkey = request->rkey;
+  } else {
+    // The release message is inlined, so its buffer needs no registration.
+    sge.addr = reinterpret_cast<uint64>(&request->buffer_key);
+    sge.length = sizeof(uint64);
+    sge.lkey = 0;
+    wr.opcode = IBV_WR_SEND;
+    wr.send_flags |= IBV_SEND_INLINE;
+  }
+  ibv_send_wr* bad_wr = nullptr;
+  const int err = ibv_post_send(connection->qp, &wr, &bad_wr);
+  if (err != 0) {
+    request->status = RdmaError("ibv_post_send", err);
+    failed->push_back(request);
+    return;
+  }
+  request->posted = true;
+  ++connection->outstanding_sends;
+}
+
+void RdmaMemoryManager::FinishSend(WorkRequest* request,
+                                   const Status& status) {
+  std::vector<WorkRequest*> failed;
+  Connection* connection = request->connection;
+  if (connection != nullptr) {
+    mutex_lock l(mu_);
+    if (request->posted) {
+      --connection->outstanding_sends;
+    }
+    if (!status.ok()) {
+      RetireConnectionLocked(connection, &failed);
+    }
+    while (!connection->pending_sends.empty() &&
+           connection->outstanding_sends < kQueueDepth) {
+      WorkRequest* next = connection->pending_sends.front();
+      connection->pending_sends.pop_front();
+      PostSendLocked(next, &failed);
+    }
+    if (request->kind == WorkRequest::kRead && status.ok()) {
+      WorkRequest* release = new WorkRequest;
+      release->kind = WorkRequest::kRelease;
+      release->connection = connection;
+      release->buffer_key = request->buffer_key;
+      PostSendLocked(release, &failed);
+    }
+  }
+
+  if (request->owned_mr != nullptr) {
+    ibv_dereg_mr(request->owned_mr);
+  }
+  if (request->kind == WorkRequest::kRead) {
+    request->done(status);
+  } else if (!status.ok()) {
+    LOG(WARNING) << "Failed to release a remote RDMA buffer: " << status;
+  }
+  delete request;
+  for (WorkRequest* failed_request : failed) {
+    FinishSend(failed_request, failed_request->status);
+  }
+}
+
+void RdmaMemoryManager::HandleReceiverFailure(Connection* connection) {
+  std::vector<std::pair<Tensor, ibv_mr*>> released;
+  std::vector<WorkRequest*> failed;
+  {
+    mutex_lock l(mu_);
+    for (auto it = pinned_buffers_.begin(); it != pinned_buffers_.end();) {
+      if (it->second.connection == connection) {
+        released.emplace_back(std::move(it->second.tensor), it->second.mr);
+        it = pinned_buffers_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    RetireConnectionLocked(connection, &failed);
+  }
+  // Deregister the buffers before their tensors are freed.
+  for (auto& tensor_and_mr : released) {
+    if (tensor_and_mr.second != nullptr) {
+      ibv_dereg_mr(tensor_and_mr.second);
+    }
+  }
+  for (WorkRequest* failed_request : failed) {
+    FinishSend(failed_request, failed_request->status);
+  }
+}
+
+void RdmaMemoryManager::PollCompletions() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      if (stopped_) {
+        return;
+      }
+    }
+    pollfd fd;
+    fd.fd = channel_->fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    const int ready = poll(&fd, 1, kPollTimeoutMillis);
+    if (ready < 0 && errno != EINTR) {
+      LOG(ERROR) << "Failed to poll the RDMA completion channel: "
+                 << strerror(errno);
+      return;
+    }
+    if (ready <= 0) {
+      continue;
+    }
+    ibv_cq* cq;
+    void* cq_context;
+    if (ibv_get_cq_event(channel_, &cq, &cq_context) != 0) {
+      continue;
+    }
+    ibv_ack_cq_events(cq, 1);
+    // Re-arm the notification before polling, so that no completion is
+    // missed.
+    const int err = ibv_req_notify_cq(cq, 0);
+    if (err != 0) {
+      LOG(ERROR) << "ibv_req_notify_cq failed: " << strerror(err);
+      return;
+    }
+    ibv_wc completions[kMaxCompletionsPerPoll];
+    int num_completions;
+    while ((num_completions =
+                ibv_poll_cq(cq, kMaxCompletionsPerPoll, completions)) > 0) {
+      for (int i = 0; i < num_completions; ++i) {
+        HandleCompletion(completions[i]);
+      }
+    }
+  }
+}
+
+void RdmaMemoryManager::HandleCompletion(const ibv_wc& wc) {
+  WorkRequest* request = reinterpret_cast<WorkRequest*>(wc.wr_id);
+  Status status;
+  if (wc.status != IBV_WC_SUCCESS) {
+    status = errors::Unavailable("RDMA work request failed: ",
+                                 ibv_wc_status_str(wc.status));
+  }
+  if (request->kind != WorkRequest::kReceive) {
+    FinishSend(request, status);
+    return;
+  }
+  if (status.ok()) {
+    ReleaseBuffer(*request->release_slot);
+    status = PostReceive(request);
+  }
+  if (!status.ok()) {
+    VLOG(1) << "Lost the RDMA connection to a receiver: " << status;
+    HandleReceiverFailure(request->connection);
+  }
+}
+
+Status RdmaMemoryManager::FindOrRegister(StringPiece data, int access,
+                                         ibv_mr** mr, ibv_mr** owned_mr) {
+  *owned_mr = nullptr;
+  *mr = regions_.Find(data.data(), data.size());
+  if (*mr != nullptr) {
+    return Status::OK();
+  }
+  *owned_mr = ibv_reg_mr(pd_, const_cast<char*>(data.data()), data.size(),
+                         access);
+  if (*owned_mr == nullptr) {
+    return RdmaError("ibv_reg_mr", errno);
+  }
+  *mr = *owned_mr;
+  return Status::OK();
+}
+
+void RdmaMemoryManager::ReleaseBuffer(uint64 buffer_key) {
+  Tensor tensor;
+  ibv_mr* mr;
+  {
+    mutex_lock l(mu_);
+    auto it = pinned_buffers_.find(buffer_key);
+    if (it == pinned_buffers_.end()) {
+      LOG(WARNING) << "Unknown RDMA buffer released: " << buffer_key;
+      return;
+    }
+    tensor = std::move(it->second.tensor);
+    mr = it->second.mr;
+    pinned_buffers_.erase(it);
+  }
+  // Deregister the buffer before the tensor is freed.
+  if (mr != nullptr) {
+    ibv_dereg_mr(mr);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,175 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
+
+#include <infiniband/verbs.h>
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The memory regions registered with an RDMA device, sorted by address.
+class RdmaMemoryRegionMap {
+ public:
+  void Insert(ibv_mr* mr);
+  // Removes and returns the region which starts at `addr`, or null if there
+  // is none.
+  ibv_mr* Erase(const void* addr);
+  // Returns the region which contains the `size` bytes at `addr`, or null if
+  // there is none.
+  ibv_mr* Find(const void* addr, size_t size) const;
+  // Removes and returns all the regions.
+  std::vector<ibv_mr*> Clear();
+
+ private:
+  mutable mutex mu_;
+  // Sorted by the end address of the regions.
+  std::vector<ibv_mr*> regions_ GUARDED_BY(mu_);
+};
+
+// Transfers tensors between workers with one-sided RDMA reads, over
+// InfiniBand or RoCE. gRPC carries the control messages:
+//
+// 1. The receiver sends the endpoint of its queue pair for the sender in the
+//    transport options of the RecvTensor request.
+// 2. The sender connects a queue pair to it, pins the tensor in registered
+//    memory, and sends the address of the tensor and its own endpoint in the
+//    transport options of the RecvTensor response instead of the tensor.
+// 3. The receiver connects its queue pair if needed, reads the tensor, and
+//    sends a release message over the queue pair so that the sender unpins it.
+//
+// Tensors in the memory of the CPU allocators are transferred from and to the
+// regions registered when the allocators grow, other tensors are registered
+// for each transfer.
+//
+// The device is chosen with the TF_RDMA_DEVICE (default: the first device),
+// TF_RDMA_PORT (default: 1) and TF_RDMA_GID_INDEX (default: 0) environment
+// variables. Tensors smaller than TF_RDMA_MIN_TENSOR_BYTES (default: 64KB)
+// are still sent over gRPC.
+class RdmaMemoryManager {
+ public:
+  // Opens the RDMA device and starts polling its completions. If
+  // `register_cpu_allocators` is true, the memory of the CPU allocators is
+  // registered, which requires that no CPU allocator has been created yet.
+  static Status Create(bool register_cpu_allocators,
+                       std::unique_ptr<RdmaMemoryManager>* manager);
+  ~RdmaMemoryManager();
+
+  // Returns true if `tensor` is better sent with RDMA than over gRPC.
+  bool ShouldTransfer(const Tensor& tensor) const;
+
+  // Returns the endpoint of the queue pair used to read tensors from
+  // `remote_worker`, creating the queue pair if needed.
+  Status GetEndpoint(const string& remote_worker, RdmaEndpoint* endpoint);
+
+  // Pins `tensor` until the receiver with queue pair `receiver` releases it,
+  // and describes it in `buffer`.
+  Status ExportTensor(const RdmaEndpoint& receiver, const Tensor& tensor,
+                      RdmaTensorBuffer* buffer);
+
+  // Reads the remote `buffer` exported by `remote_worker` into `tensor`, which
+  // must have the same size, then releases the remote buffer.
+  void ImportTensor(const string& remote_worker, const RdmaTensorBuffer& buffer,
+                    const Tensor& tensor, StatusCallback done);
+
+ private:
+  struct Connection;
+  struct WorkRequest;
+  struct PinnedBuffer {
+    Tensor tensor;
+    Connection* connection;
+    // Registered for this transfer only, null if the tensor is in a
+    // registered region.
+    ibv_mr* mr;
+  };
+
+  RdmaMemoryManager() = default;
+
+  Status Init(bool register_cpu_allocators);
+  void PollCompletions();
+  void HandleCompletion(const ibv_wc& wc);
+
+  Status CreateConnection(bool accepts_releases,
+                          std::unique_ptr<Connection>* connection);
+  Status ConnectQueuePair(Connection* connection, const RdmaEndpoint& remote);
+  // Stops using a connection after an error, its queue pair is destroyed with
+  // the manager. Adds the requests waiting to be posted to `failed`.
+  void RetireConnectionLocked(Connection* connection,
+                              std::vector<WorkRequest*>* failed)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Status PostReceive(WorkRequest* request);
+  // Posts `request` to the send queue of its connection, or queues it if the
+  // send queue is full. Adds it to `failed` if it can't be posted.
+  void PostSendLocked(WorkRequest* request,
+                      std::vector<WorkRequest*>* failed)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Completes a read or release request, and deletes it.
+  void FinishSend(WorkRequest* request, const Status& status);
+  // Unpins the buffers exported to a receiver which went away.
+  void HandleReceiverFailure(Connection* connection);
+
+  // Returns a memory region which covers `data`, registering it if needed
+  // in `*owned_mr`.
+  Status FindOrRegister(StringPiece data, int access, ibv_mr** mr,
+                        ibv_mr** owned_mr);
+  void ReleaseBuffer(uint64 buffer_key);
+
+  int port_ = 1;
+  int gid_index_ = 0;
+  int64 min_tensor_bytes_ = 0;
+  int max_reads_in_flight_ = 1;
+  ibv_context* context_ = nullptr;
+  ibv_pd* pd_ = nullptr;
+  ibv_comp_channel* channel_ = nullptr;
+  ibv_cq* cq_ = nullptr;
+  ibv_port_attr port_attr_;
+  ibv_gid gid_;
+
+  RdmaMemoryRegionMap regions_;
+  std::unique_ptr<Thread> poll_thread_;
+
+  mutex mu_;
+  bool stopped_ GUARDED_BY(mu_) = false;
+  // The connections to the senders, by worker name.
+  std::unordered_map<string, std::unique_ptr<Connection>> senders_
+      GUARDED_BY(mu_);
+  // The connections to the receivers, by queue pair endpoint.
+  std::unordered_map<string, std::unique_ptr<Connection>> receivers_
+      GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<Connection>> retired_connections_
+      GUARDED_BY(mu_);
+  std::unordered_map<uint64, PinnedBuffer> pinned_buffers_ GUARDED_BY(mu_);
+  uint64 next_buffer_key_ GUARDED_BY(mu_) = 1;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaMemoryManager);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_MEMORY_MANAGER_H_
@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+ibv_mr MakeRegion(char* addr, size_t length) {
+  ibv_mr mr = {};
+  mr.addr = addr;
+  mr.length = length;
+  return mr;
+}
+
+TEST(RdmaMemoryRegionMapTest, FindContainingRegion) {
+  char memory[1024];
+  ibv_mr first = MakeRegion(memory, 256);
+  ibv_mr second = MakeRegion(memory + 512, 256);
+  RdmaMemoryRegionMap regions;
+  regions.Insert(&second);
+  regions.Insert(&first);
+
+  EXPECT_EQ(&first, regions.Find(memory, 256));
+  EXPECT_EQ(&first, regions.Find(memory + 100, 100));
+  EXPECT_EQ(&second, regions.Find(memory + 512, 1));
+  EXPECT_EQ(&second, regions.Find(memory + 700, 68));
+
+  // Between, across and past the regions.
+  EXPECT_EQ(nullptr, regions.Find(memory + 256, 16));
+  EXPECT_EQ(nullptr, regions.Find(memory + 200, 100));
+  EXPECT_EQ(nullptr, regions.Find(memory + 700, 100));
+  EXPECT_EQ(nullptr, regions.Find(memory + 800, 16));
+}
+
+TEST(RdmaMemoryRegionMapTest, EraseAndClear) {
+  char memory[1024];
+  ibv_mr first = MakeRegion(memory, 256);
+  ibv_mr second = MakeRegion(memory + 512, 256);
+  RdmaMemoryRegionMap regions;
+  regions.Insert(&first);
+  regions.Insert(&second);
+
+  EXPECT_EQ(nullptr, regions.Erase(memory + 16));
+  EXPECT_EQ(&first, regions.Erase(memory));
+  EXPECT_EQ(nullptr, regions.Find(memory, 16));
+  EXPECT_EQ(&second, regions.Find(memory + 512, 16));
+
+  std::vector<ibv_mr*> cleared = regions.Clear();
+  ASSERT_EQ(1, cleared.size());
+  EXPECT_EQ(&second, cleared[0]);
+  EXPECT_EQ(nullptr, regions.Find(memory + 512, 16));
+}
+
+}  // namespace
+}  // namespace tensorflow
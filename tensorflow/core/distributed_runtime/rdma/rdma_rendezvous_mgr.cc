@@ -0,0 +1,245 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_rendezvous_mgr.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/request_id.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+class RdmaRemoteRendezvous : public BaseRemoteRendezvous {
+ public:
+  RdmaRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                       RdmaMemoryManager* memory_manager)
+      : BaseRemoteRendezvous(env, step_id), memory_manager_(memory_manager) {}
+
+ protected:
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args,
+                           DoneCallback done) override;
+
+ private:
+  ~RdmaRemoteRendezvous() override {}
+
+  RdmaMemoryManager* const memory_manager_;  // Not owned.
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaRemoteRendezvous);
+};
+
+// Receives a tensor from a remote worker with a RecvTensor call, then reads
+// its content with RDMA if the response describes a remote buffer.
+class RdmaRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  RdmaRecvTensorCall(const WorkerEnv* env, RdmaMemoryManager* memory_manager,
+                     WorkerInterface* wi, const string& src_worker,
+                     int64 step_id, StringPiece key,
+                     AllocatorAttributes alloc_attrs, Device* dst_device,
+                     const Rendezvous::Args& recv_args,
+                     Rendezvous::DoneCallback done)
+      : env_(env),
+        memory_manager_(memory_manager),
+        wi_(wi),
+        src_worker_(src_worker),
+        alloc_attrs_(alloc_attrs),
+        dst_device_(dst_device),
+        recv_args_(recv_args),
+        done_(std::move(done)) {
+    req_.set_step_id(step_id);
+    req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_request_id(GetUniqueRequestId());
+  }
+
+  ~RdmaRecvTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RdmaRecvTensorCall destructor.";
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    resp_.InitAlloc(dst_device_, alloc_attrs_);
+    // Only the tensors received in host memory can be read with RDMA.
+    if (alloc_attrs_.on_host() ||
+        dst_device_->attributes().device_type() == "CPU") {
+      RdmaEndpoint endpoint;
+      Status s = memory_manager_->GetEndpoint(src_worker_, &endpoint);
+      if (s.ok()) {
+        req_.set_dma_ok(true);
+        req_.mutable_transport_options()->PackFrom(endpoint);
+      } else {
+        VLOG(1) << "Receiving from " << src_worker_
+                << " over gRPC, RDMA failed: " << s;
+      }
+    }
+    wi_->RecvTensorAsync(
+        &opts_, &req_, &resp_,
+        [this, recv_done = std::move(recv_done)](const Status& s) {
+          RdmaTensorBuffer buffer;
+          if (!s.ok() ||
+              !resp_.metadata().transport_options().UnpackTo(&buffer)) {
+            Finish(s, recv_done);
+            return;
+          }
+          memory_manager_->ImportTensor(
+              src_worker_, buffer, resp_.tensor(),
+              [this, recv_done](const Status& s) {
+                // Don't run the receiver on the RDMA polling thread.
+                env_->compute_pool->Schedule(
+                    [this, s, recv_done] { Finish(s, recv_done); });
+              });
+        });
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  void ReleaseWorker(WorkerCacheInterface* worker_cache) {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "RdmaRecvTensorCall::ReleaseWorker() called twice.";
+    worker_cache->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  const Tensor& tensor() const { return resp_.tensor(); }
+  bool is_dead() const { return resp_.metadata().is_dead(); }
+  const Rendezvous::Args& recv_args() const { return recv_args_; }
+  const Rendezvous::DoneCallback& done() const { return done_; }
+
+ private:
+  void Finish(const Status& s, const std::function<void()>& recv_done) {
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    recv_done();
+  }
+
+  const WorkerEnv* const env_;
+  RdmaMemoryManager* const memory_manager_;  // Not owned.
+  WorkerInterface* wi_;                      // Not owned.
+  const string src_worker_;
+  const AllocatorAttributes alloc_attrs_;
+  Device* const dst_device_;
+  CallOptions opts_;
+  RecvTensorRequest req_;
+  TensorResponse resp_;
+  const Rendezvous::Args recv_args_;
+  const Rendezvous::DoneCallback done_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaRecvTensorCall);
+};
+
+void RdmaRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  CHECK(is_initialized());
+  Status s;
+
+  // key.src_device identifies a remote device.
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    s = errors::Internal(parsed.src_device,
+                         " is invalid remote source device.");
+  }
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache()->GetOrCreateWorker(src_worker);
+  if (s.ok() && rwi == nullptr) {
+    s = errors::Internal("No worker known as ", src_worker);
+  }
+
+  Device* dst_device;
+  if (s.ok()) {
+    s = sess->device_mgr()->LookupDevice(parsed.dst_device, &dst_device);
+  }
+  if (!s.ok()) {
+    if (rwi != nullptr) {
+      sess->worker_cache()->ReleaseWorker(src_worker, rwi);
+    }
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  RdmaRecvTensorCall* call = new RdmaRecvTensorCall(
+      env_, memory_manager_, rwi, src_worker, step_id_, parsed.FullKey(),
+      recv_args.alloc_attrs, dst_device, recv_args, std::move(done));
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call, recv_args);
+
+  // RendezvousMgr already aborted, shouldn't send RPC call any more
+  if (!call->status().ok()) {
+    // NOTE: `*sess` can potentially be deleted before we return from
+    // `call->done()(...)`, so we must release the worker before calling the
+    // callback.
+    call->ReleaseWorker(sess->worker_cache());
+    call->done()(call->status(), Args(), Args(), Tensor(), false);
+    delete call;
+    return;
+  }
+
+  // Start "call".
+  Ref();
+  call->Start([this, call]() {
+    // Removes "call" from active_. Prevent StartAbort().
+    DeregisterCall(call);
+    // If StartAbort was called prior to DeregisterCall, then the
+    // current status should be bad.
+    Status s = call->status();
+    // NOTE: `*session()` can potentially be deleted before we return from
+    // `call->done()(...)`, so we must release the worker before calling the
+    // callback.
+    call->ReleaseWorker(session()->worker_cache());
+    call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+    delete call;
+    Unref();
+  });
+}
+
+}  // namespace
+
+RdmaRendezvousMgr::RdmaRendezvousMgr(const WorkerEnv* env,
+                                     RdmaMemoryManager* memory_manager)
+    : BaseRendezvousMgr(env), memory_manager_(memory_manager) {}
+
+BaseRemoteRendezvous* RdmaRendezvousMgr::Create(int64 step_id,
+                                                const WorkerEnv* worker_env) {
+  return new RdmaRemoteRendezvous(worker_env, step_id, memory_manager_);
+}
+
+}  // end namespace tensorflow
@@ -0,0 +1,108 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_server_lib.h"
+
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/distributed_runtime/rdma/rdma_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/rdma/rdma_worker.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The memory manager registers the memory of the CPU allocators, which live
+// for the whole process, so it is created once and never deleted.
+Status GetMemoryManager(RdmaMemoryManager** memory_manager) {
+  static mutex* mu = new mutex;
+  static RdmaMemoryManager* shared_memory_manager = nullptr;
+  mutex_lock l(*mu);
+  if (shared_memory_manager == nullptr) {
+    const bool register_cpu_allocators =
+        !ProcessState::singleton()->HasCPUAllocators();
+    if (!register_cpu_allocators) {
+      LOG(WARNING) << "The CPU allocators were created before the RDMA "
+                      "server, tensors will be registered for each transfer.";
+    }
+    std::unique_ptr<RdmaMemoryManager> created;
+    TF_RETURN_IF_ERROR(
+        RdmaMemoryManager::Create(register_cpu_allocators, &created));
+    shared_memory_manager = created.release();
+  }
+  *memory_manager = shared_memory_manager;
+  return Status::OK();
+}
+
+}  // namespace
+
+RdmaServer::RdmaServer(const ServerDef& server_def, Env* env)
+    : GrpcServer(server_def, env) {}
+
+Status RdmaServer::Init() {
+  // The CPU allocators are created with the devices, so the memory manager
+  // must exist first.
+  TF_RETURN_IF_ERROR(GetMemoryManager(&memory_manager_));
+  GrpcServerOptions options;
+  options.rendezvous_mgr_func = [this](const WorkerEnv* env) {
+    return new RdmaRendezvousMgr(env, memory_manager_);
+  };
+  options.worker_func = [this](WorkerEnv* env, const ConfigProto& config) {
+    return NewRdmaWorker(env, config, memory_manager_);
+  };
+  return GrpcServer::Init(options);
+}
+
+/* static */
+Status RdmaServer::Create(const ServerDef& server_def, Env* env,
+                          std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<RdmaServer> ret(
+      new RdmaServer(server_def, env == nullptr ? Env::Default() : env));
+  Status s = ret->Init();
+  if (!s.ok()) {
+    LOG(ERROR) << s;
+    return s;
+  }
+  *out_server = std::move(ret);
+  return Status::OK();
+}
+
+namespace {
+
+class RdmaServerFactory : public ServerFactory {
+ public:
+  bool AcceptsOptions(const ServerDef& server_def) override {
+    return server_def.protocol() == "grpc+verbs";
+  }
+
+  Status NewServer(const ServerDef& server_def,
+                   std::unique_ptr<ServerInterface>* out_server) override {
+    return RdmaServer::Create(server_def, Env::Default(), out_server);
+  }
+};
+
+// Registers a `ServerFactory` for `RdmaServer` instances.
+class RdmaServerRegistrar {
+ public:
+  RdmaServerRegistrar() {
+    ServerFactory::Register("RDMA_SERVER", new RdmaServerFactory());
+  }
+};
+static RdmaServerRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
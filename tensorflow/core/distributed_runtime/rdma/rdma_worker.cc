@@ -0,0 +1,70 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_worker.h"
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+RdmaWorker::RdmaWorker(WorkerEnv* env, const ConfigProto& config,
+                       RdmaMemoryManager* memory_manager)
+    : GrpcWorker(env, config), memory_manager_(memory_manager) {}
+
+void RdmaWorker::EncodeRecvTensorResponse(const RecvTensorRequest& request,
+                                          const Tensor& tensor, bool is_dead,
+                                          bool cache_enabled,
+                                          ::grpc::ByteBuffer* response) {
+  // The cached responses are sent again on retries, so they must contain the
+  // tensor itself.
+  RdmaEndpoint receiver;
+  if (!request.dma_ok() || cache_enabled || is_dead ||
+      !request.transport_options().UnpackTo(&receiver) ||
+      !memory_manager_->ShouldTransfer(tensor)) {
+    GrpcWorker::EncodeRecvTensorResponse(request, tensor, is_dead,
+                                         cache_enabled, response);
+    return;
+  }
+
+  RdmaTensorBuffer buffer;
+  Status s = memory_manager_->ExportTensor(receiver, tensor, &buffer);
+  if (!s.ok()) {
+    VLOG(1) << "Sending " << request.rendezvous_key()
+            << " over gRPC, RDMA failed: " << s;
+    GrpcWorker::EncodeRecvTensorResponse(request, tensor, is_dead,
+                                         cache_enabled, response);
+    return;
+  }
+
+  // The receiver allocates the tensor from its dtype and shape, and reads its
+  // content.
+  RecvTensorResponse proto;
+  proto.mutable_tensor()->set_dtype(tensor.dtype());
+  tensor.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+  proto.set_send_start_micros(Env::Default()->NowMicros());
+  proto.mutable_transport_options()->PackFrom(buffer);
+  grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+}
+
+std::unique_ptr<GrpcWorker> NewRdmaWorker(WorkerEnv* env,
+                                          const ConfigProto& config,
+                                          RdmaMemoryManager* memory_manager) {
+  return std::unique_ptr<GrpcWorker>(
+      new RdmaWorker(env, config, memory_manager));
+}
+
+}  // namespace tensorflow
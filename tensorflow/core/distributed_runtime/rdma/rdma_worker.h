@@ -0,0 +1,49 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
+
+#include <memory>
+
+#include "tensorflow/core/distributed_runtime/rdma/rdma_memory_manager.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+namespace tensorflow {
+
+// A worker which sends large tensors with RDMA to the workers which asked for
+// it in their RecvTensor requests, and the other tensors over gRPC.
+class RdmaWorker : public GrpcWorker {
+ public:
+  RdmaWorker(WorkerEnv* env, const ConfigProto& config,
+             RdmaMemoryManager* memory_manager);
+
+ protected:
+  void EncodeRecvTensorResponse(const RecvTensorRequest& request,
+                                const Tensor& tensor, bool is_dead,
+                                bool cache_enabled,
+                                ::grpc::ByteBuffer* response) override;
+
+ private:
+  RdmaMemoryManager* const memory_manager_;  // Not owned.
+};
+
+std::unique_ptr<GrpcWorker> NewRdmaWorker(WorkerEnv* env,
+                                          const ConfigProto& config,
+                                          RdmaMemoryManager* memory_manager);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RDMA_RDMA_WORKER_H_
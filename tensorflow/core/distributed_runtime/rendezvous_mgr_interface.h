@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RENDEZVOUS_MGR_INTERFACE_H_
 
 #include <string>
+#include <unordered_map>
 
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/rendezvous.h"
@@ -41,6 +42,14 @@ class RemoteRendezvous : public Rendezvous {
   // Fully construct the RemoteRendezvous.
   virtual Status Initialize(WorkerSession* session) = 0;
 
+  // Starts accumulating, by source device, the time which receives from other
+  // workers wait for their tensors. Does nothing by default.
+  virtual void RecordRecvWaits() {}
+
+  // Adds the accumulated wait times in microseconds to `recv_wait_micros`.
+  virtual void GetRecvWaits(
+      std::unordered_map<string, int64>* recv_wait_micros) {}
+
  protected:
   bool is_cross_process() override { return true; }
 };
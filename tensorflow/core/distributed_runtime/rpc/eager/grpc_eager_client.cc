@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
 #include "grpcpp/generic/generic_stub.h"
+#include "tensorflow/core/distributed_runtime/eager/enqueue_batcher.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_state.h"
@@ -61,11 +62,29 @@ bool EnableStreaming() {
   return result;
 }
 
+/*
+ * Setting environment variable "TF_EAGER_CLIENT_ENQUEUE_BATCH_SIZE" to more
+ * than 1 batches the streamed enqueue requests of a remote context: their
+ * items are sent together once the batch holds that many items, or after
+ * "TF_EAGER_CLIENT_ENQUEUE_BATCH_WINDOW_USECS" (default: 200), or before an
+ * Enqueue, WaitQueueDone or CloseContext call to the same context. This
+ * amortizes the per-request cost of the stream for loops of small remote ops
+ * executed asynchronously.
+ */
+void ReadEnqueueBatchOptions(int64* max_batch_items, int64* window_micros) {
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_CLIENT_ENQUEUE_BATCH_SIZE", 1,
+                                  max_batch_items));
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_CLIENT_ENQUEUE_BATCH_WINDOW_USECS",
+                                  200, window_micros));
+}
+
 class GrpcEagerClient : public EagerClient {
  public:
   GrpcEagerClient(const tensorflow::SharedGrpcChannelPtr& channel,
                   ::grpc::CompletionQueue* cq)
-      : stub_(channel), cq_(cq) {}
+      : stub_(channel), cq_(cq) {
+    ReadEnqueueBatchOptions(&max_batch_items_, &batch_window_micros_);
+  }
   ~GrpcEagerClient() override {}
 
 #define CLIENT_METHOD(method)                                             \
@@ -79,15 +98,43 @@ class GrpcEagerClient : public EagerClient {
 
   CLIENT_METHOD(CreateContext);
   CLIENT_METHOD(UpdateContext);
-  CLIENT_METHOD(Enqueue);
-  CLIENT_METHOD(WaitQueueDone);
   CLIENT_METHOD(KeepAlive);
 
 #undef CLIENT_METHOD
 
+  void EnqueueAsync(const EnqueueRequest* request, EnqueueResponse* response,
+                    StatusCallback done) override {
+    FlushEnqueueBatch(request->context_id());
+    new RPCState<protobuf::Message>(
+        &stub_, cq_, "/tensorflow.eager.EagerService/Enqueue", *request,
+        response, std::move(done), nullptr, nullptr, /*max_retries=*/0);
+  }
+
+  void WaitQueueDoneAsync(const WaitQueueDoneRequest* request,
+                          WaitQueueDoneResponse* response,
+                          StatusCallback done) override {
+    FlushEnqueueBatch(request->context_id());
+    new RPCState<protobuf::Message>(
+        &stub_, cq_, "/tensorflow.eager.EagerService/WaitQueueDone", *request,
+        response, std::move(done), nullptr, nullptr, /*max_retries=*/0);
+  }
+
   void CloseContextAsync(const CloseContextRequest* request,
                          CloseContextResponse* response,
                          StatusCallback done) override {
+    // Sends the pending batch and waits until it is sent, before the stream
+    // is cancelled below.
+    std::unique_ptr<EnqueueBatcher> batcher;
+    {
+      mutex_lock l(mu_);
+      auto it = enqueue_batchers_.find(request->context_id());
+      if (it != enqueue_batchers_.end()) {
+        batcher = std::move(it->second);
+        enqueue_batchers_.erase(it);
+      }
+    }
+    batcher.reset();
+
     new RPCState<protobuf::Message>(
         &stub_, cq_, "/tensorflow.eager.EagerService/CloseContext", *request,
         response, std::move(done), nullptr, nullptr);
@@ -109,6 +156,32 @@ class GrpcEagerClient : public EagerClient {
   void StreamingEnqueueAsync(const EnqueueRequest* request,
                              EnqueueResponse* response,
                              StatusCallback done) override {
+    if (max_batch_items_ > 1 && EnableStreaming()) {
+      EnqueueBatcher* batcher;
+      {
+        mutex_lock l(mu_);
+        std::unique_ptr<EnqueueBatcher>& entry =
+            enqueue_batchers_[request->context_id()];
+        if (entry == nullptr) {
+          entry.reset(new EnqueueBatcher(
+              Env::Default(), request->context_id(), max_batch_items_,
+              batch_window_micros_,
+              [this](const EnqueueRequest* request, EnqueueResponse* response,
+                     StatusCallback done) {
+                SendStreamingEnqueue(request, response, std::move(done));
+              }));
+        }
+        batcher = entry.get();
+      }
+      batcher->EnqueueAsync(request, response, std::move(done));
+    } else {
+      SendStreamingEnqueue(request, response, std::move(done));
+    }
+  }
+
+ private:
+  void SendStreamingEnqueue(const EnqueueRequest* request,
+                            EnqueueResponse* response, StatusCallback done) {
     if (EnableStreaming()) {
       tf_shared_lock l(mu_);
       auto it = enqueue_dispatchers_.find(request->context_id());
@@ -135,14 +208,35 @@ class GrpcEagerClient : public EagerClient {
     }
   }
 
- private:
+  // Sends the pending enqueue requests of the context `context_id`.
+  void FlushEnqueueBatch(uint64 context_id) {
+    EnqueueBatcher* batcher = nullptr;
+    {
+      tf_shared_lock l(mu_);
+      auto it = enqueue_batchers_.find(context_id);
+      if (it != enqueue_batchers_.end()) {
+        batcher = it->second.get();
+      }
+    }
+    if (batcher != nullptr) {
+      batcher->Flush();
+    }
+  }
+
   ::grpc::GenericStub stub_;
   ::grpc::CompletionQueue* cq_;
+  int64 max_batch_items_;
+  int64 batch_window_micros_;
 
   mutable mutex mu_;
 
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ GUARDED_BY(mu_);
+
+  // Destroyed first, since they send their pending batches to the
+  // dispatchers.
+  std::unordered_map<uint64, std::unique_ptr<EnqueueBatcher>>
+      enqueue_batchers_ GUARDED_BY(mu_);
 };
 
 class GrpcEagerClientCache : public EagerClientCache {
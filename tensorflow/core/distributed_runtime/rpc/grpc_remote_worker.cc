@@ -36,11 +36,70 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 const int kMaxWorkerRpcRetries = 10;
 
+namespace {
+
+// The content of the tensors received in host memory is fetched in chunks of
+// at most TF_GRPC_RECV_TENSOR_CHUNK_BYTES (default: 64MB) when they are
+// larger, with TF_GRPC_RECV_TENSOR_CHUNKS_IN_FLIGHT (default: 4) chunks in
+// flight. A non-positive chunk size sends all tensors in one message.
+int64 RecvTensorChunkBytes() {
+  static const int64 chunk_bytes = [] {
+    int64 value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRPC_RECV_TENSOR_CHUNK_BYTES",
+                                    64 << 20, &value));
+    return value;
+  }();
+  return chunk_bytes;
+}
+
+int64 RecvTensorChunksInFlight() {
+  static const int64 chunks_in_flight = [] {
+    int64 value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRPC_RECV_TENSOR_CHUNKS_IN_FLIGHT", 4,
+                                    &value));
+    return std::max<int64>(value, 1);
+  }();
+  return chunks_in_flight;
+}
+
+// The content of the tensors of at least
+// TF_GRPC_RECV_TENSOR_COMPRESSION_MIN_BYTES (default: 1MB) received in host
+// memory is compressed with the codec named by TF_GRPC_RECV_TENSOR_COMPRESSION
+// ("bfloat16" or "snappy", default: none) when it applies to the tensor.
+RecvTensorCompression RecvTensorCompressionCodec() {
+  static const RecvTensorCompression compression = [] {
+    string value;
+    TF_CHECK_OK(
+        ReadStringFromEnvVar("TF_GRPC_RECV_TENSOR_COMPRESSION", "", &value));
+    if (value == "bfloat16") return RECV_TENSOR_COMPRESSION_BFLOAT16;
+    if (value == "snappy") return RECV_TENSOR_COMPRESSION_SNAPPY;
+    if (!value.empty() && value != "none") {
+      LOG(WARNING) << "Ignoring unknown TF_GRPC_RECV_TENSOR_COMPRESSION "
+                   << value;
+    }
+    return RECV_TENSOR_COMPRESSION_NONE;
+  }();
+  return compression;
+}
+
+int64 RecvTensorCompressionMinBytes() {
+  static const int64 min_bytes = [] {
+    int64 value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRPC_RECV_TENSOR_COMPRESSION_MIN_BYTES",
+                                    1 << 20, &value));
+    return value;
+  }();
+  return min_bytes;
+}
+
+}  // namespace
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
@@ -67,6 +126,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensorchunk_(Method(GrpcWorkerMethod::kRecvTensorChunk)),
         logger_(logger) {}
 
   ~GrpcRemoteWorker() override {}
@@ -200,6 +260,25 @@ class GrpcRemoteWorker : public WorkerInterface {
     // Type-specialized logging for this method.
     bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
 
+    // The content of large tensors received in host memory is written
+    // directly into the tensor, one chunk at a time, or compressed.
+    const bool chunked =
+        RecvTensorChunkBytes() > 0 && request->request_id() != 0;
+    const bool compressed =
+        RecvTensorCompressionCodec() != RECV_TENSOR_COMPRESSION_NONE;
+    RecvTensorRequest* host_request = nullptr;
+    if (response->on_host() && (chunked || compressed)) {
+      host_request = new RecvTensorRequest(*request);
+      if (chunked) {
+        host_request->set_max_chunk_bytes(RecvTensorChunkBytes());
+      }
+      if (compressed) {
+        host_request->set_compression(RecvTensorCompressionCodec());
+        host_request->set_compression_min_bytes(
+            RecvTensorCompressionMinBytes());
+      }
+    }
+
     auto callback = [this, request, response, done, start_usec,
                      logging_active](Status s) {
       if (logging_active) {
@@ -251,7 +330,28 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    if (host_request == nullptr) {
+      IssueRequest(request, response, recvtensor_, callback, call_opts);
+      return;
+    }
+    IssueRequest(
+        host_request, response, recvtensor_,
+        [this, host_request, response, callback](const Status& s) {
+          const int64 request_id = host_request->request_id();
+          delete host_request;
+          if (!s.ok() || !response->metadata().chunked()) {
+            callback(s);
+            return;
+          }
+          ChunkFetch* fetch = new ChunkFetch;
+          fetch->request_id = request_id;
+          StringPiece tdata = response->tensor().tensor_data();
+          fetch->data = const_cast<char*>(tdata.data());
+          fetch->num_bytes = tdata.size();
+          fetch->done = callback;
+          ContinueChunkFetch(fetch, Status::OK(), /*chunk_done=*/false);
+        },
+        call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -284,6 +384,72 @@ class GrpcRemoteWorker : public WorkerInterface {
                                  callback_threadpool_);
   }
 
+  // The state of the fetch of the content of a tensor sent in chunks.
+  struct ChunkFetch {
+    int64 request_id;
+    char* data;
+    int64 num_bytes;
+    StatusCallback done;
+
+    mutex mu;
+    int64 next_offset GUARDED_BY(mu) = 0;
+    int64 in_flight GUARDED_BY(mu) = 0;
+    Status status GUARDED_BY(mu);
+  };
+
+  // Requests the next chunks of `fetch`, up to the limit of chunks in flight,
+  // after a chunk is done if `chunk_done`. Calls `fetch->done` and deletes
+  // `fetch` once all chunks are done, or after an error once the chunks in
+  // flight are done.
+  void ContinueChunkFetch(ChunkFetch* fetch, const Status& s, bool chunk_done) {
+    std::vector<std::pair<int64, int64>> chunks;
+    bool finished;
+    {
+      mutex_lock l(fetch->mu);
+      if (chunk_done) {
+        --fetch->in_flight;
+        fetch->status.Update(s);
+      }
+      while (fetch->status.ok() && fetch->next_offset < fetch->num_bytes &&
+             fetch->in_flight < RecvTensorChunksInFlight()) {
+        const int64 size = std::min(RecvTensorChunkBytes(),
+                                    fetch->num_bytes - fetch->next_offset);
+        chunks.emplace_back(fetch->next_offset, size);
+        fetch->next_offset += size;
+        ++fetch->in_flight;
+      }
+      finished = fetch->in_flight == 0;
+    }
+    if (finished) {
+      Status status;
+      {
+        mutex_lock l(fetch->mu);
+        status = fetch->status;
+      }
+      StatusCallback done = std::move(fetch->done);
+      delete fetch;
+      done(status);
+      return;
+    }
+    for (const auto& chunk : chunks) {
+      RecvTensorChunkRequest request;
+      request.set_request_id(fetch->request_id);
+      request.set_offset(chunk.first);
+      request.set_size(chunk.second);
+      // The bytes are written directly into the tensor.
+      GrpcByteRange* range = new GrpcByteRange;
+      range->data = fetch->data + chunk.first;
+      range->size = chunk.second;
+      new RPCState<GrpcByteRange>(
+          &stub_, cq_, recvtensorchunk_, request, range,
+          [this, fetch, range](const Status& s) {
+            delete range;
+            ContinueChunkFetch(fetch, s, /*chunk_done=*/true);
+          },
+          /*call_opts=*/nullptr, callback_threadpool_);
+    }
+  }
+
   void IssueMarkRecvFinishedRequest(int64 request_id) {
     VLOG(2) << "Send MarkRecvFinishedRequest for request " << request_id;
     MarkRecvFinishedRequest request;
@@ -318,6 +484,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensorchunk_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
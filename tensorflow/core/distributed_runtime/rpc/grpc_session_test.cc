@@ -163,6 +163,49 @@ TEST(GrpcSessionTest, BasicCallable) {
   }
 }
 
+TEST(GrpcSessionTest, RepeatedCallable) {
+  GraphDef graph;
+  string node_names[3];
+  // c = a * b
+  CreateGraphDef(&graph, node_names);
+
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, &cluster));
+
+  std::unique_ptr<Session> session(
+      NewRemote(Options(cluster->targets()[0], 1)));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(graph));
+
+  // After the first one, the same partitions are registered with the
+  // workers by fingerprint only.
+  CallableOptions opts;
+  opts.add_fetch(node_names[2] + ":0");
+  std::vector<Session::CallableHandle> handles;
+  for (int iters = 0; iters < 3; ++iters) {
+    Session::CallableHandle handle;
+    TF_CHECK_OK(session->MakeCallable(opts, &handle));
+    handles.push_back(handle);
+    for (Session::CallableHandle h : handles) {
+      std::vector<Tensor> outputs;
+      TF_CHECK_OK(session->RunCallable(h, {}, &outputs, nullptr));
+      ASSERT_EQ(1, outputs.size());
+      IsSingleFloatValue(outputs[0], 4.0);
+    }
+  }
+  for (Session::CallableHandle handle : handles) {
+    TF_CHECK_OK(session->ReleaseCallable(handle));
+  }
+  // The partitions are still kept by the workers once released.
+  Session::CallableHandle handle;
+  TF_CHECK_OK(session->MakeCallable(opts, &handle));
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  IsSingleFloatValue(outputs[0], 4.0);
+  TF_CHECK_OK(session->ReleaseCallable(handle));
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, CallableWithOnDeviceFeedsAndFetches) {
   // Specifying feeds/fetch devices for remote sessions is not yet defined.
   // Ensure that the error is graceful.
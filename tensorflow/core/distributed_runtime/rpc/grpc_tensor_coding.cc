@@ -247,5 +247,19 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset, int64 size,
+                                   ::grpc::ByteBuffer* result) {
+  StringPiece tdata = val.tensor_data();
+  DCHECK_LE(offset + size, tdata.size());
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  buf->Ref();
+  ::grpc::Slice slice(
+      const_cast<char*>(tdata.data()) + offset, size,
+      [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+      const_cast<TensorBuffer*>(buf));
+  ::grpc::ByteBuffer tmp(&slice, 1);
+  result->Swap(&tmp);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
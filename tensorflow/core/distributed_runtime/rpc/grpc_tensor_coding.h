@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +50,15 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// Encode the `size` bytes at `offset` in the content of "val" into "*result",
+// as the raw bytes of a RecvTensorChunk response. The bytes are shared with
+// "val" rather than copied.
+//
+// REQUIRES: DataTypeCanUseMemcpy(val.dtype()), and the range is in the
+// content of "val".
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset, int64 size,
+                                   ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -100,4 +100,23 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, Chunk) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  for (int i = 0; i < 1000; ++i) {
+    t.flat<float>()(i) = i;
+  }
+  const StringPiece data = t.tensor_data();
+  for (int64 offset : {0, 100, 3996}) {
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorChunkToByteBuffer(t, offset, 4, &buf);
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+    EXPECT_EQ(string(data.substr(offset, 4)), tmp);
+  }
+}
+
 }  // namespace tensorflow
@@ -130,4 +130,21 @@ bool GrpcMaybeParseProto(grpc::ByteBuffer* src, tstring* dst) {
 }
 #endif  // USE_TSTRING
 
+// GrpcMaybeParseProto copies the bytes into the preallocated range.
+bool GrpcMaybeParseProto(grpc::ByteBuffer* src, GrpcByteRange* dst) {
+  if (src->Length() != dst->size) {
+    return false;
+  }
+  std::vector<::grpc::Slice> slices;
+  if (!src->Dump(&slices).ok()) {
+    return false;
+  }
+  char* head = dst->data;
+  for (const ::grpc::Slice& s : slices) {
+    memcpy(head, s.begin(), s.size());
+    head += s.size();
+  }
+  return true;
+}
+
 }  // namespace tensorflow
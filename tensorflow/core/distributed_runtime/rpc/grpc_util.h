@@ -134,6 +134,16 @@ bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, string* dst);
 // Copy grpc buffer src to tstring *dst.
 bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, tstring* dst);
 
+// A preallocated buffer which receives raw bytes, e.g. a range of the content
+// of a tensor.
+struct GrpcByteRange {
+  char* data = nullptr;
+  size_t size = 0;
+};
+
+// Copy grpc buffer src into *dst, which must have the same size.
+bool GrpcMaybeParseProto(::grpc::ByteBuffer* src, GrpcByteRange* dst);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_UTIL_H_
@@ -134,6 +134,22 @@ TEST(GrpcProto, ParseFromString) {
   }
 }
 
+TEST(GrpcProto, ParseByteRange) {
+  const string str = "0123456789";
+  for (int num_slices = 1; num_slices <= 3; num_slices++) {
+    grpc::ByteBuffer buf = MakeBuffer(str, num_slices);
+    string out(str.size(), 'x');
+    GrpcByteRange range;
+    range.data = &out[0];
+    range.size = out.size();
+    EXPECT_TRUE(GrpcMaybeParseProto(&buf, &range));
+    EXPECT_EQ(str, out);
+
+    range.size = out.size() - 1;
+    EXPECT_FALSE(GrpcMaybeParseProto(&buf, &range));
+  }
+}
+
 static void BM_UnparseGrpc(int iters, int size) {
   testing::StopTiming();
   auto proto = MakeProto(size);
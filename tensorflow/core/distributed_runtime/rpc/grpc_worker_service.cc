@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -157,6 +158,13 @@ class GrpcWorkerServiceThread {
          ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0; i < gtl::FindWithDefault(
+                        queue_depth_,
+                        static_cast<int>(GrpcWorkerMethod::kRecvTensorChunk),
+                        100);
+         ++i) {
+      EnqueueRecvTensorChunkRequestRaw();
+    }
 
     void* tag;
     bool ok;
@@ -283,6 +291,18 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  // The chunks share the memory of the tensor, so they are encoded on the
+  // polling thread.
+  void RecvTensorChunkHandlerRaw(
+      WorkerCall<RecvTensorChunkRequest, ::grpc::ByteBuffer>* call) {
+    Status s = worker_->RecvTensorChunk(&call->request, &call->response);
+    if (!s.ok()) {
+      VLOG(1) << "Bad response from RecvTensorChunk:" << s;
+    }
+    call->SendResponse(ToGrpcStatus(s));
+    EnqueueRecvTensorChunkRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -352,6 +372,19 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueRecvTensorChunkRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           RecvTensorChunkRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensorChunk),
+              &GrpcWorkerServiceThread::RecvTensorChunkHandlerRaw,
+              false /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
   std::unique_ptr<Thread> thread_;
@@ -447,11 +480,12 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  auto do_response = [this, request, response, done, cache_enabled](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      EncodeRecvTensorResponse(*request, tensor, is_dead, cache_enabled,
+                               response);
     }
     done(status);
   };
@@ -555,6 +589,75 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::EncodeRecvTensorResponse(const RecvTensorRequest& request,
+                                          const Tensor& tensor, bool is_dead,
+                                          bool cache_enabled,
+                                          ::grpc::ByteBuffer* response) {
+  // The cached responses are sent again on retries, so they must contain the
+  // tensor itself.
+  const int64 num_bytes = tensor.TotalBytes();
+  if (request.compression() != RECV_TENSOR_COMPRESSION_NONE && !is_dead &&
+      num_bytes >= request.compression_min_bytes()) {
+    RecvTensorResponse proto;
+    if (CompressTensorContent(tensor, request.compression(),
+                              proto.mutable_compressed_content())) {
+      proto.mutable_tensor()->set_dtype(tensor.dtype());
+      tensor.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+      proto.set_compression(request.compression());
+      proto.set_require_ack(cache_enabled);
+      proto.set_send_start_micros(Env::Default()->NowMicros());
+      grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+      return;
+    }
+  }
+  if (request.max_chunk_bytes() <= 0 ||
+      num_bytes <= request.max_chunk_bytes() || request.request_id() == 0 ||
+      cache_enabled || is_dead || !DataTypeCanUseMemcpy(tensor.dtype())) {
+    grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+    return;
+  }
+
+  {
+    mutex_lock l(chunked_tensors_mu_);
+    chunked_tensors_[request.request_id()] = {request.step_id(), tensor,
+                                              num_bytes};
+  }
+  RecvTensorResponse proto;
+  proto.mutable_tensor()->set_dtype(tensor.dtype());
+  tensor.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+  proto.set_send_start_micros(Env::Default()->NowMicros());
+  proto.set_chunked(true);
+  grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+}
+
+Status GrpcWorker::RecvTensorChunk(const RecvTensorChunkRequest* request,
+                                   ::grpc::ByteBuffer* response) {
+  Tensor tensor;
+  {
+    mutex_lock l(chunked_tensors_mu_);
+    auto it = chunked_tensors_.find(request->request_id());
+    if (it == chunked_tensors_.end()) {
+      return errors::NotFound("No tensor sent in chunks for request ",
+                              request->request_id());
+    }
+    ChunkedTensor& chunked = it->second;
+    if (request->offset() < 0 || request->size() <= 0 ||
+        request->offset() + request->size() > chunked.tensor.TotalBytes()) {
+      return errors::InvalidArgument("Invalid chunk of ", request->size(),
+                                     " bytes at offset ", request->offset(),
+                                     " for request ", request->request_id());
+    }
+    tensor = chunked.tensor;
+    chunked.remaining_bytes -= request->size();
+    if (chunked.remaining_bytes <= 0) {
+      chunked_tensors_.erase(it);
+    }
+  }
+  grpc::EncodeTensorChunkToByteBuffer(tensor, request->offset(),
+                                      request->size(), response);
+  return Status::OK();
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -731,6 +834,18 @@ void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
     // a worker crashes before acking a request.
     response_cache_->CleanEntriesForStep(request->step_id());
   }
+  {
+    // Release the tensors whose receivers failed before fetching all their
+    // chunks.
+    mutex_lock l(chunked_tensors_mu_);
+    for (auto it = chunked_tensors_.begin(); it != chunked_tensors_.end();) {
+      if (it->second.step_id == request->step_id()) {
+        it = chunked_tensors_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
   Worker::CleanupGraphAsync(request, response, done);
 }
 
@@ -56,15 +56,39 @@ class GrpcWorker : public Worker {
                          CleanupGraphResponse* response,
                          StatusCallback done) override;
 
+  // Encodes a range of the content of a tensor sent in chunks.
+  Status RecvTensorChunk(const RecvTensorChunkRequest* request,
+                         ::grpc::ByteBuffer* response);
+
   WorkerEnv* env();
 
   void EnableResponseCache();
 
   void RemoveCacheEntryForId(int64 request_id);
 
+ protected:
+  // Encodes the response to `request` for `tensor`, which is in host memory.
+  // Subclasses can override it to send the tensor by other means.
+  virtual void EncodeRecvTensorResponse(const RecvTensorRequest& request,
+                                        const Tensor& tensor, bool is_dead,
+                                        bool cache_enabled,
+                                        ::grpc::ByteBuffer* response);
+
  private:
+  // A tensor sent in chunks, until all of its content has been fetched.
+  struct ChunkedTensor {
+    int64 step_id;
+    Tensor tensor;
+    int64 remaining_bytes;
+  };
+
   std::unique_ptr<GrpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
+
+  mutex chunked_tensors_mu_;
+  // Keyed by the request_id of the RecvTensor requests.
+  std::unordered_map<int64, ChunkedTensor> chunked_tensors_
+      GUARDED_BY(chunked_tensors_mu_);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
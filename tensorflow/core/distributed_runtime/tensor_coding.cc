@@ -18,11 +18,67 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 
+bool CompressTensorContent(const Tensor& tensor,
+                           RecvTensorCompression compression, string* out) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) return false;
+  const StringPiece data = tensor.tensor_data();
+  switch (compression) {
+    case RECV_TENSOR_COMPRESSION_BFLOAT16: {
+      if (tensor.dtype() != DT_FLOAT) return false;
+      auto src = tensor.flat<float>();
+      out->resize(src.size() * sizeof(bfloat16));
+      bfloat16* dst = reinterpret_cast<bfloat16*>(&(*out)[0]);
+      for (int64 i = 0; i < src.size(); ++i) {
+        dst[i] = bfloat16::round_to_bfloat16(src(i));
+      }
+      return true;
+    }
+    case RECV_TENSOR_COMPRESSION_SNAPPY:
+      return port::Snappy_Compress(data.data(), data.size(), out) &&
+             out->size() < data.size();
+    default:
+      return false;
+  }
+}
+
+Status UncompressTensorContent(RecvTensorCompression compression,
+                               StringPiece data, Tensor* tensor) {
+  switch (compression) {
+    case RECV_TENSOR_COMPRESSION_BFLOAT16: {
+      if (tensor->dtype() != DT_FLOAT ||
+          data.size() != tensor->NumElements() * sizeof(bfloat16)) {
+        return errors::InvalidArgument("Bad bfloat16 tensor content");
+      }
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(data.data()),
+                      tensor->flat<float>().data(), tensor->NumElements());
+      return Status::OK();
+    }
+    case RECV_TENSOR_COMPRESSION_SNAPPY: {
+      StringPiece dst = tensor->tensor_data();
+      size_t size;
+      if (!DataTypeCanUseMemcpy(tensor->dtype()) ||
+          !port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                              &size) ||
+          size != dst.size() ||
+          !port::Snappy_Uncompress(data.data(), data.size(),
+                                   const_cast<char*>(dst.data()))) {
+        return errors::InvalidArgument("Bad Snappy tensor content");
+      }
+      return Status::OK();
+    }
+    default:
+      return errors::InvalidArgument("Unknown tensor compression ",
+                                     static_cast<int>(compression));
+  }
+}
+
 TensorResponse::Source::~Source() {}
 
 void TensorResponse::Clear() {
@@ -88,6 +144,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (meta_.compression() != RECV_TENSOR_COMPRESSION_NONE) {
+      return errors::Unimplemented(
+          "Compressed tensors can only be received in host memory");
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -219,12 +279,18 @@ bool TensorResponse::ParseTensorSubmessage(
 bool TensorResponse::ParseFast(Source* source) {
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+  string compressed_content;
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
-      return (tag == 0);
+      if (tag != 0) return false;
+      // The tensor without content was allocated, decode the content into it.
+      return meta_.compression() == RECV_TENSOR_COMPRESSION_NONE ||
+             UncompressTensorContent(meta_.compression(), compressed_content,
+                                     &tensor_)
+                 .ok();
     }
     switch (tag) {
       case RecvTensorResponse::kTensorFieldNumber: {
@@ -267,6 +333,26 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kChunkedFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_chunked(v != 0);
+        break;
+      }
+      case RecvTensorResponse::kCompressionFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_compression(static_cast<RecvTensorCompression>(v));
+        break;
+      }
+      case RecvTensorResponse::kCompressedContentFieldNumber: {
+        int length;
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadVarintSizeAsInt(&input, &length) ||
+            !input.ReadString(&compressed_content, length))
+          return false;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -287,6 +373,14 @@ bool TensorResponse::ParseSlow(Source* source) {
     return false;
   }
   tensor_ = std::move(parsed);
+  if (meta_.compression() != RECV_TENSOR_COMPRESSION_NONE) {
+    if (!UncompressTensorContent(meta_.compression(),
+                                 meta_.compressed_content(), &tensor_)
+             .ok()) {
+      return false;
+    }
+    meta_.clear_compressed_content();
+  }
 
   // Reduce memory usage for big tensors.
   {
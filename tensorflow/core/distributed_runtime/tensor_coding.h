@@ -29,6 +29,18 @@ class Allocator;
 class DeviceBase;
 class TensorProto;
 
+// Encodes the content of "tensor" with "compression" into "*out". Returns
+// false if the codec does not apply to the tensor, is not available, or does
+// not make the content smaller, in which case the content should be sent
+// uncompressed.
+bool CompressTensorContent(const Tensor& tensor,
+                           RecvTensorCompression compression, string* out);
+
+// Decodes "data", encoded with "compression", into the content of "*tensor",
+// which must have the dtype and shape of the encoded tensor.
+Status UncompressTensorContent(RecvTensorCompression compression,
+                               StringPiece data, Tensor* tensor);
+
 // TensorResponse can be used as the destination of an RPC that returns
 // a RecvTensorResponse.  It efficiently decodes the incoming data
 // into Tensor contents as well as associated metadata.
@@ -91,6 +103,9 @@ class TensorResponse {
   // Return pointer to the device hosting the tensor.
   DeviceBase* device() const { return device_; }
 
+  // Returns true if the tensor is allocated in host memory.
+  bool on_host() const { return on_host_; }
+
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
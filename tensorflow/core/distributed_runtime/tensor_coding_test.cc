@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -156,6 +157,46 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, CompressedContent) {
+  // The values are exact in bfloat16.
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  for (int i = 0; i < 1000; i++) {
+    src.flat<float>()(i) = (i % 16) * 0.25f;
+  }
+  for (RecvTensorCompression compression :
+       {RECV_TENSOR_COMPRESSION_BFLOAT16, RECV_TENSOR_COMPRESSION_SNAPPY}) {
+    RecvTensorResponse proto;
+    if (!CompressTensorContent(src, compression,
+                               proto.mutable_compressed_content())) {
+      // Snappy is not available in all builds.
+      EXPECT_EQ(compression, RECV_TENSOR_COMPRESSION_SNAPPY);
+      continue;
+    }
+    EXPECT_LT(proto.compressed_content().size(), src.TotalBytes());
+    proto.set_compression(compression);
+    proto.mutable_tensor()->set_dtype(src.dtype());
+    src.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+    string encoded;
+    proto.AppendToString(&encoded);
+
+    StringSource source(&encoded, 1024);
+    TensorResponse response;
+    DummyDevice cpu_device(Env::Default());
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+}
+
+TEST_F(TensorResponseTest, CompressionDoesNotApply) {
+  Tensor src(DT_INT32, TensorShape({100}));
+  src.flat<int32>().setZero();
+  string out;
+  EXPECT_FALSE(
+      CompressTensorContent(src, RECV_TENSOR_COMPRESSION_BFLOAT16, &out));
+  EXPECT_FALSE(CompressTensorContent(src, RECV_TENSOR_COMPRESSION_NONE, &out));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
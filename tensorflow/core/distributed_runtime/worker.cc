@@ -76,7 +76,25 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
   } else {
     session = env_->session_mgr->LegacySession();
   }
-  if (s.ok()) {
+  if (s.ok() && request->graph_fingerprint() != 0) {
+    GraphMgr* graph_mgr = session->graph_mgr();
+    if (!request->has_graph_def()) {
+      if (!graph_mgr->RegisterCached(request->graph_fingerprint(),
+                                     response->mutable_graph_handle())) {
+        response->set_graph_def_required(true);
+        done(s);
+        return;
+      }
+    } else {
+      s = graph_mgr->RegisterAndCache(
+          request->graph_fingerprint(), request->session_handle(),
+          request->graph_def(), session.get(), request->graph_options(),
+          request->debug_options(), request->config_proto(),
+          request->collective_graph_key(), session->cluster_flr(),
+          response->mutable_graph_handle());
+    }
+    response->set_graph_cached(s.ok());
+  } else if (s.ok()) {
     s = session->graph_mgr()->Register(
         request->session_handle(), request->graph_def(), session.get(),
         request->graph_options(), request->debug_options(),
@@ -218,16 +236,35 @@ void Worker::DoRunGraph(CallOptions* opts, RunGraphRequestWrapper* request,
     done(errors::Aborted("Call was aborted"));
     return;
   }
+  // Holds a reference on the rendezvous of the step, to read the time which
+  // its receives waited.
+  RemoteRendezvous* rendezvous = nullptr;
+  if (request->exec_opts().record_step_timings()) {
+    rendezvous = env_->rendezvous_mgr->Find(step_id);
+    rendezvous->RecordRecvWaits();
+  }
+  const uint64 start_micros = env_->env->NowMicros();
   session->graph_mgr()->ExecuteAsync(
       request->graph_handle(), step_id, session.get(), request->exec_opts(),
       collector, response, cm, in,
       [this, step_id, response, session, cm, out, token, collector,
-       profiler_session, opts, done](const Status& status) {
+       profiler_session, rendezvous, start_micros, opts,
+       done](const Status& status) {
         Status s = status;
         if (s.ok()) {
           s = session->graph_mgr()->RecvOutputs(step_id, out);
         }
 
+        if (rendezvous) {
+          WorkerStepTimings* timings = response->mutable_step_timings();
+          timings->set_exec_micros(env_->env->NowMicros() - start_micros);
+          std::unordered_map<string, int64> recv_waits;
+          rendezvous->GetRecvWaits(&recv_waits);
+          rendezvous->Unref();
+          timings->mutable_recv_wait_micros()->insert(recv_waits.begin(),
+                                                      recv_waits.end());
+        }
+
         opts->ClearCancelCallback();
         cancellation_manager_.DeregisterCallback(token);
         delete cm;
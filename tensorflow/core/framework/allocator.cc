@@ -32,6 +32,10 @@ thread_local const char* pending_op_name = nullptr;
 thread_local uint64 pending_step_id = 0;
 #endif
 
+thread_local const char* ScopedMemoryDebugAnnotation::pending_op_name_ =
+    nullptr;
+thread_local int64 ScopedMemoryDebugAnnotation::pending_step_id_ = 0;
+
 string AllocatorStats::DebugString() const {
   return strings::Printf(
       "Limit:        %20lld\n"
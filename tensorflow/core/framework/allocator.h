@@ -86,6 +86,39 @@ extern thread_local uint64 pending_step_id;
 #define MEMDEBUG_CACHE_VAL nullptr
 #endif
 
+// Annotates the allocations made by the current thread while it is in scope
+// with the op and step making them, for allocators that record a memory
+// timeline (see BFCAllocator::SetMemoryTimelineCapacity).  Annotations nest;
+// the innermost one wins.  'op_name' is not copied and must outlive the
+// annotation.
+class ScopedMemoryDebugAnnotation {
+ public:
+  ScopedMemoryDebugAnnotation(const char* op_name, int64 step_id)
+      : last_op_name_(pending_op_name_), last_step_id_(pending_step_id_) {
+    pending_op_name_ = op_name;
+    pending_step_id_ = step_id;
+  }
+
+  ~ScopedMemoryDebugAnnotation() {
+    pending_op_name_ = last_op_name_;
+    pending_step_id_ = last_step_id_;
+  }
+
+  // Returns the annotation of the current thread, or nullptr and 0 if there
+  // is none.
+  static const char* CurrentOpName() { return pending_op_name_; }
+  static int64 CurrentStepId() { return pending_step_id_; }
+
+ private:
+  static thread_local const char* pending_op_name_;
+  static thread_local int64 pending_step_id_;
+
+  const char* const last_op_name_;
+  const int64 last_step_id_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedMemoryDebugAnnotation);
+};
+
 // Runtime statistics collected by an allocator. Exactly the same as
 // stream_executor::AllocatorStats, but independently defined to preserve the
 // mutual independence of StreamExecutor and TensorFlow.
@@ -275,6 +275,14 @@ class CallFrameInterface {
 
   virtual Status GetArg(int index, Tensor* val) const = 0;
   virtual Status SetRetval(int index, const Tensor& val) = 0;
+
+  // Returns true and sets `*buffer` if the caller provided a host buffer of
+  // the given dtype and shape for the `index`-th return value, into which the
+  // kernel producing that value may write it directly.
+  virtual bool GetRetvalBuffer(int index, DataType dtype,
+                               const TensorShape& shape, Tensor* buffer) {
+    return false;
+  }
 };
 
 // Represents a function call frame. I.e., the data structure used to
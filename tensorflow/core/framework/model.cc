@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <atomic>
 #include <memory>
 
 #include "absl/time/clock.h"
@@ -626,8 +627,30 @@ class Unknown : public Node {
   }
 };
 
+std::atomic<int64> reserved_cpus(0);
+std::atomic<int64> reserved_ram(0);
+
 }  // namespace
 
+ResourceReservation::ResourceReservation(int64 cpus, int64 ram_bytes)
+    : cpus_(cpus), ram_bytes_(ram_bytes) {
+  reserved_cpus += cpus_;
+  reserved_ram += ram_bytes_;
+}
+
+ResourceReservation::~ResourceReservation() {
+  reserved_cpus -= cpus_;
+  reserved_ram -= ram_bytes_;
+}
+
+/* static */ int64 ResourceReservation::ReservedCpus() {
+  return reserved_cpus.load();
+}
+
+/* static */ int64 ResourceReservation::ReservedRam() {
+  return reserved_ram.load();
+}
+
 std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
                                          double min, double max) {
@@ -712,13 +735,13 @@ void Model::AddProcessingTime(const string& name, int64 delta) {
 }
 
 void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
-                     int64 ram_budget) {
+                     int64 ram_budget, double target_output_time) {
   switch (algorithm) {
     case AutotuneAlgorithm::HILL_CLIMB:
-      OptimizeHillClimb(cpu_budget, ram_budget);
+      OptimizeHillClimb(cpu_budget, ram_budget, target_output_time);
       break;
     case AutotuneAlgorithm::GRADIENT_DESCENT:
-      OptimizeGradientDescent(cpu_budget, ram_budget);
+      OptimizeGradientDescent(cpu_budget, ram_budget, target_output_time);
       break;
   }
 }
@@ -731,6 +754,19 @@ void Model::RecordElement(const string& name) {
   }
 }
 
+std::vector<NodeReport> Model::Report() {
+  std::shared_ptr<Node> output;
+  {
+    tf_shared_lock l(mu_);
+    output = output_;
+  }
+  std::vector<NodeReport> reports;
+  if (output) {
+    output->CollectReports(&reports);
+  }
+  return reports;
+}
+
 int64 Model::NumElements(const string& name) {
   tf_shared_lock l(mu_);
   auto node = gtl::FindOrNull(lookup_table_, name);
@@ -807,7 +843,8 @@ std::map<string, std::shared_ptr<Parameter>> Model::CollectEssentialParallelism(
   return essential_parameters;
 }
 
-void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget) {
+void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
+                                    double target_output_time) {
   std::shared_ptr<Node> snapshot;
   {
     tf_shared_lock lock(mu_);
@@ -844,9 +881,11 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget) {
     }
     // We terminate once the improvement of the output latency is too small or
     // the essential transformations' parallelism reaches the CPU budget or the
-    // worst-case total buffer size exceeds the memory budget.
+    // worst-case total buffer size exceeds the memory budget or the output
+    // latency reaches its target.
     if (std::abs(output_time - new_output_time) < kOptimizationPrecision ||
         model_parallelism > cpu_budget ||
+        (target_output_time > 0 && new_output_time <= target_output_time) ||
         TotalMaximumBufferedBytes(snapshot) > ram_budget) {
       break;
     }
@@ -883,7 +922,8 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget) {
   }
 }
 
-void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget) {
+void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
+                              double target_output_time) {
   std::shared_ptr<Node> snapshot;
   {
     tf_shared_lock lock(mu_);
@@ -911,7 +951,9 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget) {
         break;
       }
     }
-    if (output_time < processing_time / cpu_budget || all_max ||
+    if (output_time < processing_time / cpu_budget ||
+        (target_output_time > 0 && output_time <= target_output_time) ||
+        all_max ||
         TotalMaximumBufferedBytes(snapshot) > ram_budget) {
       break;
     }
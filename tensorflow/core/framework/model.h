@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
 namespace data {
@@ -45,6 +46,47 @@ enum class AutotuneAlgorithm {
   GRADIENT_DESCENT = 1,
 };
 
+// Keeps `cpus` CPU cores and `ram_bytes` bytes of memory out of the default
+// budgets of autotuning for as long as it is alive. Other runtimes of the
+// process, such as the threads feeding an accelerator, use it to keep the
+// resources they need from being taken by input pipelines.
+class ResourceReservation {
+ public:
+  ResourceReservation(int64 cpus, int64 ram_bytes);
+  ~ResourceReservation();
+
+  // The totals of all the reservations which are alive.
+  static int64 ReservedCpus();
+  static int64 ReservedRam();
+
+ private:
+  const int64 cpus_;
+  const int64 ram_bytes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ResourceReservation);
+};
+
+// A summary of the work of a node since it was created, used to find the
+// bottleneck of an input pipeline.
+struct NodeReport {
+  // The long name of the node.
+  string name;
+  int64 num_elements = 0;
+  // The processing time of the node itself, without its inputs, in
+  // nanoseconds.
+  int64 processing_time = 0;
+  // The distribution of the processing time per element, in nanoseconds.
+  double mean_element_time = 0;
+  double p50_element_time = 0;
+  double p90_element_time = 0;
+  double p99_element_time = 0;
+  int64 buffered_elements = 0;
+  // The values chosen for the parameters of the node, or -1 if the node does
+  // not have the parameter.
+  double buffer_size = -1;
+  double parallelism = -1;
+};
+
 // Represents thread-safe state that can be shared between an input pipeline and
 // the performance model.
 struct SharedState {
@@ -209,6 +251,8 @@ class Node {
   void record_element() LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
     num_elements_++;
+    element_times_.Add(processing_time_ - processing_time_at_last_element_);
+    processing_time_at_last_element_ = processing_time_;
   }
 
   // Records that a node thread has started executing.
@@ -261,6 +305,32 @@ class Node {
     }
   }
 
+  // Collects the reports of the nodes in the subtree rooted in this node, this
+  // node first.
+  void CollectReports(std::vector<NodeReport>* reports) const
+      LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    NodeReport report;
+    report.name = long_name();
+    report.num_elements = num_elements_;
+    report.processing_time = processing_time_;
+    report.mean_element_time = element_times_.Average();
+    report.p50_element_time = element_times_.Percentile(50);
+    report.p90_element_time = element_times_.Percentile(90);
+    report.p99_element_time = element_times_.Percentile(99);
+    report.buffered_elements = buffered_elements_;
+    if (auto* parameter = gtl::FindOrNull(parameters_, kBufferSize)) {
+      report.buffer_size = (*parameter)->value;
+    }
+    if (auto* parameter = gtl::FindOrNull(parameters_, kParallelism)) {
+      report.parallelism = (*parameter)->value;
+    }
+    reports->push_back(std::move(report));
+    for (auto& input : inputs_) {
+      input->CollectReports(reports);
+    }
+  }
+
   // Returns a human-readable representation of this node.
   string DebugString() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
@@ -501,6 +571,9 @@ class Node {
   int64 num_elements_ GUARDED_BY(mu_) = 0;
   std::map<std::thread::id, int64> work_start_ GUARDED_BY(mu_);
   std::map<string, std::shared_ptr<Parameter>> parameters_ GUARDED_BY(mu_);
+  // The processing time recorded between each element and the one before it.
+  histogram::Histogram element_times_ GUARDED_BY(mu_);
+  int64 processing_time_at_last_element_ GUARDED_BY(mu_) = 0;
 
   // Statistic of inputs processing time history.
   double input_processing_time_sum_ = 0.0L;
@@ -584,13 +657,19 @@ class Model {
   // Increments the processing time for the given node..
   void AddProcessingTime(const string& name, int64 delta) LOCKS_EXCLUDED(mu_);
 
-  // Uses the given algorithm to perform the autotuning optimization.
-  void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget)
-      LOCKS_EXCLUDED(mu_);
+  // Uses the given algorithm to perform the autotuning optimization. When
+  // `target_output_time` is positive, the optimization stops as soon as the
+  // projected output time in nanoseconds reaches it, rather than trying to
+  // reach the maximum throughput.
+  void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
+                double target_output_time = 0) LOCKS_EXCLUDED(mu_);
 
   // Records that a node has produced an element.
   void RecordElement(const string& name) LOCKS_EXCLUDED(mu_);
 
+  // Returns the reports of all the nodes, starting with the output node.
+  std::vector<NodeReport> Report() LOCKS_EXCLUDED(mu_);
+
   // Returns the number of elements that the input pipeline has produced.
   int64 NumElements(const string& name) LOCKS_EXCLUDED(mu_);
 
@@ -624,8 +703,10 @@ class Model {
   // parameter whose increase in parallelism decreases the output time the most.
   // This process is repeated until all parameters reach their maximum values or
   // the projected output time is less than or equal to the processing time
-  // needed to produce an element divided by CPU budget.
-  void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget);
+  // needed to produce an element divided by CPU budget, or to the target output
+  // time.
+  void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
+                         double target_output_time);
 
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then improves current parameters by
@@ -633,8 +714,9 @@ class Model {
   // projecting resulting values on the feasible intervals. Improvement step is
   // repeated until either the output time improvement is smaller than threshold
   // value or the output time is less than the processing time needed to produce
-  // an element divided by CPU budget.
-  void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget);
+  // an element divided by CPU budget, or the target output time is reached.
+  void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
+                               double target_output_time);
 
   // Collects the output time and if `gradient` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
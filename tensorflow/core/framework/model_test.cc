@@ -727,6 +727,59 @@ TEST(UnknownGradientTest, Model) {
               (new_output_time - output_time) / kParameterStep,
               kComparisonPrecision);
 }
+
+TEST(CollectReportsTest, Node) {
+  std::shared_ptr<Node> async_known_one = model::MakeAsyncKnownRatioNode(
+      {0, "async_known_one", nullptr}, 1,
+      {model::MakeParameter(
+          "parallelism", std::make_shared<SharedState>(4, nullptr, nullptr), 1,
+          4)});
+  std::shared_ptr<Node> source =
+      model::MakeSourceNode({1, "source", async_known_one});
+  async_known_one->add_input(source);
+  auto cleanup = gtl::MakeCleanup([async_known_one, source]() {
+    async_known_one->remove_input(source);
+  });
+  for (int i = 1; i <= 100; ++i) {
+    source->add_processing_time(i);
+    source->record_element();
+  }
+  async_known_one->add_processing_time(50);
+  async_known_one->record_element();
+  async_known_one->record_buffer_event(40, 2);
+
+  std::vector<NodeReport> reports;
+  async_known_one->CollectReports(&reports);
+  ASSERT_EQ(reports.size(), 2);
+  EXPECT_EQ(reports[0].name, async_known_one->long_name());
+  EXPECT_EQ(reports[0].num_elements, 1);
+  EXPECT_EQ(reports[0].processing_time, 50);
+  EXPECT_EQ(reports[0].mean_element_time, 50);
+  EXPECT_EQ(reports[0].buffered_elements, 2);
+  EXPECT_EQ(reports[0].parallelism, 4);
+  EXPECT_EQ(reports[0].buffer_size, -1);
+  EXPECT_EQ(reports[1].name, source->long_name());
+  EXPECT_EQ(reports[1].num_elements, 100);
+  EXPECT_EQ(reports[1].processing_time, 5050);
+  EXPECT_DOUBLE_EQ(reports[1].mean_element_time, 50.5);
+  EXPECT_LE(reports[1].p50_element_time, reports[1].p90_element_time);
+  EXPECT_LE(reports[1].p90_element_time, reports[1].p99_element_time);
+  EXPECT_LE(reports[1].p99_element_time, 100);
+  EXPECT_EQ(reports[1].parallelism, -1);
+}
+
+TEST(ResourceReservationTest, ReservationsAreReleased) {
+  const int64 cpus = ResourceReservation::ReservedCpus();
+  const int64 ram = ResourceReservation::ReservedRam();
+  {
+    ResourceReservation first(2, 1024);
+    ResourceReservation second(1, 0);
+    EXPECT_EQ(ResourceReservation::ReservedCpus(), cpus + 3);
+    EXPECT_EQ(ResourceReservation::ReservedRam(), ram + 1024);
+  }
+  EXPECT_EQ(ResourceReservation::ReservedCpus(), cpus);
+  EXPECT_EQ(ResourceReservation::ReservedRam(), ram);
+}
 }  // namespace
 }  // namespace model
 }  // namespace data
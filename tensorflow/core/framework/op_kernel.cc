@@ -709,9 +709,17 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   MEMDEBUG_CACHE_OP(op_kernel().name().c_str());
   MEMDEBUG_CACHE_STEPID(step_id());
+  ScopedMemoryDebugAnnotation op_annotation(op_kernel().name().c_str(),
+                                            step_id());
   Tensor new_tensor(a, type, shape,
                     AllocationAttributes(allocation_attr.no_retry_on_failure,
                                          /* allocation_will_be_logged= */ true,
@@ -766,6 +774,17 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
           " more than once.  Try turning off the ScopedAllocator optimizer.");
     }
   }
+  if (params_->output_retval_indices != nullptr &&
+      params_->output_retval_indices[index] >= 0 && attr.scope_id <= 0 &&
+      params_->call_frame != nullptr) {
+    Tensor buffer;
+    if (params_->call_frame->GetRetvalBuffer(
+            params_->output_retval_indices[index], type, shape, &buffer)) {
+      outputs_[index] = TensorValue(new Tensor(std::move(buffer)));
+      *output = outputs_[index].tensor;
+      return Status::OK();
+    }
+  }
   auto output_tensor = MakeUnique<Tensor>();
   Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
   if (s.ok()) {
@@ -795,8 +814,15 @@ Status OpKernelContext::allocate_temp(
             << ".  Switch to allocate_output to avoid performance penalty.";
     allocator_attr.scope_id = -1;
   }
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Status s;
+  if (params_->temp_allocator != nullptr && allocator_attr.value == 0 &&
+      allocation_attr.freed_by_func == nullptr && !track_allocations()) {
+    s = allocate_tensor(params_->temp_allocator, type, shape, out_temp,
+                        allocation_attr);
+  } else {
+    s = allocate_tensor(type, shape, out_temp, allocator_attr,
+                        allocation_attr);
+  }
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
     Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
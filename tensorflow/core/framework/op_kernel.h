@@ -660,9 +660,20 @@ class OpKernelContext {
     bool log_memory = false;
     bool record_tensor_accesses = false;
 
+    // If non-null, allocate_temp serves requests with default allocator
+    // attributes from this allocator instead of the device allocator.  It
+    // must cope with temporaries that outlive the kernel invocation.
+    Allocator* temp_allocator = nullptr;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If non-null, array indexed by output number for this node of the index
+    // of the call frame return value that the output is fetched as, or -1.
+    // allocate_output writes such outputs into the buffer the caller bound
+    // to the return value, if any (see CallFrameInterface::GetRetvalBuffer).
+    const int* output_retval_indices = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -1296,6 +1307,9 @@ class OpKernelContext {
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
 
   // Initialize the allocated_scope_ids_ set the first time this method is
   // called.
@@ -75,11 +75,15 @@ class Rendezvous : public core::RefCounted {
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
 
+    // Hash of FullKey(), computed once by ParseKey().
+    uint64 KeyHash() const { return key_hash_; }
+
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     string buf_;
+    uint64 key_hash_ = 0;
   };
   static Status ParseKey(StringPiece key, ParsedKey* out);
 
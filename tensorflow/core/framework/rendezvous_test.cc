@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -410,6 +411,29 @@ class DummyDeviceContext : public DeviceContext {
   const int stream_id_;
 };
 
+TEST_F(LocalRendezvousTest, AbortManyKeys) {
+  // Pending receives on many keys, spread over the table shards, are all
+  // aborted, as are later sends and receives on any key.
+  static const int N = 64;
+  BlockingCounter counter(N);
+  for (int i = 0; i < N; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat("pending_", i)), Rendezvous::Args(),
+        [&counter](const Status& status, const Rendezvous::Args&,
+                   const Rendezvous::Args&, const Tensor&, const bool) {
+          EXPECT_TRUE(errors::IsAborted(status));
+          counter.DecrementCount();
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  counter.Wait();
+  for (int i = 0; i < N; ++i) {
+    EXPECT_TRUE(errors::IsAborted(
+        rendez_->Send(MakeKey(strings::StrCat("later_", i)),
+                      Rendezvous::Args(), V("hello"), false)));
+  }
+}
+
 TEST_F(LocalRendezvousTest, TransferDummyDeviceContext) {
   Rendezvous::Args args;
   args.device_context = new DummyDeviceContext(123);
@@ -486,5 +510,41 @@ void BM_PingPong(int iters) {
 }
 BENCHMARK(BM_PingPong);
 
+// Sends and receives on `num_threads` threads, each with its own keys, as the
+// independent send/recv pairs of a partitioned step do.
+void BM_SendRecvManyKeys(int iters, int num_threads) {
+  testing::StopTiming();
+  Rendezvous* rendez = NewLocalRendezvous();
+  std::vector<std::vector<Rendezvous::ParsedKey>> keys(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    for (int i = 0; i < 64; ++i) {
+      keys[t].push_back(MakeKey(strings::StrCat("edge_", t, "_", i)));
+    }
+  }
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  BlockingCounter counter(num_threads);
+  testing::StartTiming();
+  for (int t = 0; t < num_threads; ++t) {
+    pool->Schedule([rendez, iters, &keys, &counter, t]() {
+      Tensor orig = V("val");
+      Tensor val(DT_STRING, TensorShape({}));
+      bool is_dead = false;
+      Rendezvous::Args args;
+      for (int i = 0; i < iters; ++i) {
+        const Rendezvous::ParsedKey& key = keys[t][i % keys[t].size()];
+        TF_CHECK_OK(rendez->Send(key, args, orig, is_dead));
+        TF_CHECK_OK(rendez->Recv(key, args, &val, &is_dead));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+  delete pool;
+  rendez->Unref();
+}
+BENCHMARK(BM_SendRecvManyKeys)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
@@ -24,6 +24,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
@@ -38,6 +39,13 @@ namespace tensorflow {
 namespace {
 static constexpr int32 kMaxConcurrentHandlers = 128;
 
+auto* queueing_delay_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/run_handler/queueing_delay_usecs",
+     "The time closures scheduled by a request wait in the run handler "
+     "queues, in microseconds.",
+     "priority"},
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 // TODO(azaks): Refactor with thread:ThreadPool
 class RunHandlerEnvironment {
   typedef Thread EnvThread;
@@ -45,6 +53,10 @@ class RunHandlerEnvironment {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    // If set, receives the time between the creation and the execution of
+    // the task.
+    monitoring::SamplerCell* queueing_delay;
+    uint64 create_time_us;
   };
   Env* const env_;
   const ThreadOptions thread_options_;
@@ -72,7 +84,8 @@ class RunHandlerEnvironment {
     });
   }
 
-  Task CreateTask(std::function<void()> f) {
+  Task CreateTask(std::function<void()> f,
+                  monitoring::SamplerCell* queueing_delay) {
     uint64 id = 0;
     if (tracing::EventCollector::IsEnabled()) {
       id = tracing::GetUniqueArg();
@@ -83,11 +96,16 @@ class RunHandlerEnvironment {
             std::move(f),
             Context(ContextKind::kThread),
             id,
+            queueing_delay,
+            queueing_delay != nullptr ? env_->NowMicros() : 0,
         }),
     };
   }
 
   void ExecuteTask(const Task& t) {
+    if (t.f->queueing_delay != nullptr) {
+      t.f->queueing_delay->Add(env_->NowMicros() - t.f->create_time_us);
+    }
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
@@ -430,8 +448,9 @@ class RunHandlerThreadPool {
   }
 
   void AddWorkToQueue(ThreadWorkSource* tws, bool is_blocking,
-                      std::function<void()> fn) {
-    Task t = env_.CreateTask(std::move(fn));
+                      std::function<void()> fn,
+                      monitoring::SamplerCell* queueing_delay) {
+    Task t = env_.CreateTask(std::move(fn), queueing_delay);
     t = tws->EnqueueTask(std::move(t), is_blocking);
     if (t.f) {
       VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
@@ -795,11 +814,25 @@ class RunHandler::Impl {
   // Stores now time (in microseconds) since unix epoch when the handler is
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
+  // The time by which the request should finish, or kuint64max if it has no
+  // deadline.
+  uint64 deadline_us() const { return deadline_us_; }
+  int64 priority() const { return priority_; }
   int64 step_id() const { return step_id_; }
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
 
-  void Reset(int64 step_id);
+  void Reset(int64 step_id, int64 timeout_in_ms,
+             const RunOptions::Experimental::RunHandlerPoolOptions& options);
+
+  // Returns whether the work of this handler runs before that of `other`.
+  bool ComesBefore(const Impl& other) const {
+    if (priority_ != other.priority_) return priority_ > other.priority_;
+    if (deadline_us_ != other.deadline_us_) {
+      return deadline_us_ < other.deadline_us_;
+    }
+    return start_time_us_ < other.start_time_us_;
+  }
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
@@ -821,7 +854,10 @@ class RunHandler::Impl {
 
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  uint64 deadline_us_;
+  int64 priority_;
   int64 step_id_;
+  monitoring::SamplerCell* queueing_delay_ = nullptr;
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   ThreadWorkSource tws_;
 };
@@ -879,7 +915,10 @@ class RunHandlerPool::Impl {
     return run_handler_thread_pool_.get();
   }
 
-  std::unique_ptr<RunHandler> Get(int64 step_id) LOCKS_EXCLUDED(mu_) {
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id, int64 timeout_in_ms,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options)
+      LOCKS_EXCLUDED(mu_) {
     std::unique_ptr<Eigen::MaxSizeVector<ThreadWorkSource*>>
         thread_work_sources;
     uint64 version;
@@ -890,13 +929,20 @@ class RunHandlerPool::Impl {
       while (free_handlers_.empty()) {
         one_handler_free_.wait(l);
       }
-      // Remove the last entry from free_handlers_ and add to the end of
-      // sorted_active_handlers_.
+      // Remove the last entry from free_handlers_ and insert it into
+      // sorted_active_handlers_ after the handlers whose work comes first.
       handler_impl = free_handlers_.back();
-      handler_impl->Reset(step_id);
-      // Sortedness isn't violated if we simply add at the end of the list,
-      // since handlers are expected to be obtained in increasing order of time.
-      sorted_active_handlers_.push_back(handler_impl);
+      handler_impl->Reset(step_id, timeout_in_ms, options);
+      // Handlers are usually obtained in increasing order of time, so a new
+      // handler of the same priority without a deadline goes at the end.
+      sorted_active_handlers_.insert(
+          std::upper_bound(sorted_active_handlers_.begin(),
+                           sorted_active_handlers_.end(), handler_impl,
+                           [](const RunHandler::Impl* a,
+                              const RunHandler::Impl* b) {
+                             return a->ComesBefore(*b);
+                           }),
+          handler_impl);
       DCHECK_LE(sorted_active_handlers_.size(), max_handlers_);
       free_handlers_.pop_back();
 
@@ -1005,8 +1051,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by priority, then deadline, then start time.
   std::vector<RunHandler::Impl*> sorted_active_handlers_ GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ GUARDED_BY(mu_);
   std::vector<std::unique_ptr<RunHandler::Impl>> handlers_ GUARDED_BY(mu_);
@@ -1092,23 +1137,32 @@ void RunHandler::Impl::ThreadPoolInterfaceWrapper::Schedule(
 RunHandler::Impl::Impl(RunHandlerPool::Impl* pool_impl)
     : pool_impl_(pool_impl) {
   thread_pool_interface_.reset(new ThreadPoolInterfaceWrapper(this));
-  Reset(0);
+  Reset(0, 0, RunOptions::Experimental::RunHandlerPoolOptions());
 }
 
 void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
   VLOG(3) << "Scheduling inter work for  " << tws()->GetTracemeId();
-  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(tws(), true,
-                                                        std::move(fn));
+  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(
+      tws(), true, std::move(fn), queueing_delay_);
 }
 
 void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
   VLOG(3) << "Scheduling intra work for " << tws()->GetTracemeId();
-  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(tws(), false,
-                                                        std::move(fn));
+  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(
+      tws(), false, std::move(fn), queueing_delay_);
 }
 
-void RunHandler::Impl::Reset(int64 step_id) {
+void RunHandler::Impl::Reset(
+    int64 step_id, int64 timeout_in_ms,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = timeout_in_ms > 0 ? start_time_us_ + timeout_in_ms * 1000
+                                   : kuint64max;
+  if (queueing_delay_ == nullptr || priority_ != options.priority()) {
+    queueing_delay_ =
+        queueing_delay_usecs->GetCell(strings::StrCat(options.priority()));
+  }
+  priority_ = options.priority();
   step_id_ = step_id;
   tws_.SetTracemeId(step_id);
 }
@@ -1122,8 +1176,10 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads,
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 step_id) {
-  return impl_->Get(step_id);
+std::unique_ptr<RunHandler> RunHandlerPool::Get(
+    int64 step_id, int64 timeout_in_ms,
+    const RunOptions::Experimental::RunHandlerPoolOptions& options) {
+  return impl_->Get(step_id, timeout_in_ms, options);
 }
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
@@ -62,7 +62,14 @@ class RunHandlerPool {
   // unique_ptr is destroyed.
   //
   // Will block unless there is an inactive handler.
-  std::unique_ptr<RunHandler> Get(int64 step_id = 0);
+  //
+  // The work of active handlers is run in order of their priority in
+  // `options`, then of their deadline, `timeout_in_ms` after the call (none if
+  // not positive), then of the time of the call.
+  std::unique_ptr<RunHandler> Get(
+      int64 step_id = 0, int64 timeout_in_ms = 0,
+      const RunOptions::Experimental::RunHandlerPoolOptions& options =
+          RunOptions::Experimental::RunHandlerPoolOptions());
 
  private:
   class Impl;
@@ -74,7 +81,9 @@ class RunHandlerPool {
 // RunHandler can be used to schedule inter/intra-op closures to run on a global
 // pool shared across all Session::Run(s). The closures are enqueued to a
 // handler specific queue, from which the work is stolen in a priority order
-// (time of the Get() call).
+// (request priority, then deadline, then time of the Get() call). The time
+// closures wait in the queues is recorded per request priority in the
+// /tensorflow/core/run_handler/queueing_delay_usecs metric.
 //
 // It can only be created via RunHandlerPool::Get().
 //
@@ -78,6 +78,41 @@ TEST(RunHandlerUtilTest, TestBasicScheduling) {
   counter.Wait();
 }
 
+TEST(RunHandlerUtilTest, TestPriorityAndDeadlineScheduling) {
+  int num_threads = 2;
+  int num_handlers = 10;
+
+  std::unique_ptr<RunHandlerPool> pool(
+      new RunHandlerPool(num_threads, num_threads));
+
+  BlockingCounter counter(2 * num_handlers * num_threads);
+
+  thread::ThreadPool test_pool(Env::Default(), "test", num_handlers);
+  for (int i = 0; i < num_handlers; ++i) {
+    test_pool.Schedule([&counter, &pool, i, num_threads]() {
+      RunOptions::Experimental::RunHandlerPoolOptions options;
+      options.set_priority(i % 3);
+      auto handler =
+          pool->Get(i, /*timeout_in_ms=*/i % 2 == 0 ? 1000 * i : 0, options);
+      BlockingCounter local_counter(2 * num_threads);
+      auto intra_thread_pool = handler->AsIntraThreadPoolInterface();
+
+      for (int j = 0; j < num_threads; ++j) {
+        handler->ScheduleInterOpClosure([&local_counter, &counter]() {
+          counter.DecrementCount();
+          local_counter.DecrementCount();
+        });
+        intra_thread_pool->Schedule([&local_counter, &counter]() {
+          counter.DecrementCount();
+          local_counter.DecrementCount();
+        });
+      }
+      local_counter.Wait();
+    });
+  }
+  counter.Wait();
+}
+
 SessionOptions DefaultSessionOptions() {
   SessionOptions options;
   (*options.config.mutable_device_count())["CPU"] = 2;
@@ -156,6 +191,9 @@ TEST_F(RunHandlerTest, UseRunHandlerPoolEnableSubPool) {
   // Prepares RunOptions and RunMetadata
   RunOptions run_options;
   run_options.mutable_experimental()->set_use_run_handler_pool(true);
+  run_options.mutable_experimental()
+      ->mutable_run_handler_pool_options()
+      ->set_priority(1);
 
   Status s = session->Run(run_options, inputs, output_names, target_nodes,
                           &outputs, nullptr);
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -148,6 +149,48 @@ DeviceProperties GetLocalGPUInfo(PlatformGpuId platform_gpu_id) {
   return device;
 }
 
+DeviceProperties GetIpuInfo() {
+  DeviceProperties device;
+  device.set_type("IPU");
+  device.set_vendor("Graphcore");
+  device.set_model("GC2");
+
+  // Each tile has its own memory and processor.
+  constexpr int64 kNumTiles = 1216;
+  constexpr int64 kFrequencyMHz = 1600;
+  constexpr int64 kBytesPerTile = 256 * 1024;
+  // Per tile and cycle.
+  constexpr int64 kMemoryBytesPerCycle = 16;
+  constexpr int64 kExchangeBytesPerCycle = 4;
+  // Over all the IPU-Links of an IPU.
+  constexpr int64 kLinkBandwidthKBps = 320 * 1024 * 1024;
+
+  device.set_frequency(kFrequencyMHz);
+  device.set_num_cores(kNumTiles);
+  device.set_memory_size(kNumTiles * kBytesPerTile);
+  // Bandwidths are stored in KB/s.
+  const int64 tile_bandwidth_kbps = kFrequencyMHz * 1000 * 1000 / 1024;
+  device.set_bandwidth(kNumTiles * kMemoryBytesPerCycle * tile_bandwidth_kbps);
+
+  auto& environment = *device.mutable_environment();
+  environment["exchange_bandwidth"] = strings::StrCat(
+      kNumTiles * kExchangeBytesPerCycle * tile_bandwidth_kbps);
+  environment["link_bandwidth"] = strings::StrCat(kLinkBandwidthKBps);
+
+  string calibration;
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_IPU_CYCLE_CALIBRATION", "1.0",
+                                   &calibration));
+  double calibration_value;
+  if (!strings::safe_strtod(calibration, &calibration_value) ||
+      calibration_value <= 0) {
+    LOG(ERROR) << "Ignoring invalid TF_IPU_CYCLE_CALIBRATION: " << calibration;
+    calibration = "1.0";
+  }
+  environment["cycle_calibration"] = calibration;
+
+  return device;
+}
+
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
   DeviceProperties unknown;
   unknown.set_type("UNKNOWN");
@@ -167,6 +210,8 @@ DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device) {
     } else {
       return GetLocalGPUInfo(PlatformGpuId(0));
     }
+  } else if (device.type == "IPU") {
+    return GetIpuInfo();
   }
   return unknown;
 }
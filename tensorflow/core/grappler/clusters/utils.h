@@ -30,6 +30,15 @@ DeviceProperties GetLocalCPUInfo();
 // which grappler is running.
 DeviceProperties GetLocalGPUInfo(PlatformGpuId platform_gpu_id);
 
+// Returns the DeviceProperties of a Graphcore IPU. The memory and bandwidths
+// are those of a GC2 IPU, and the environment holds the bandwidths of the
+// exchange between the tiles and of the IPU-Links between IPUs in KB/s. The
+// estimated cycles are scaled by the "cycle_calibration" entry, which is read
+// from the TF_IPU_CYCLE_CALIBRATION environment variable and can be set to
+// the ratio between the cycles recorded with the `log_cycle_count` flag and
+// the cycles estimated for the same graph.
+DeviceProperties GetIpuInfo();
+
 // Returns the DeviceProperties of the specified device
 DeviceProperties GetDeviceInfo(const DeviceNameUtils::ParsedName& device);
 
@@ -116,6 +116,19 @@ TEST(UtilsTest, GetDeviceInfo) {
 #endif
 }
 
+TEST(UtilsTest, GetIpuInfo) {
+  DeviceNameUtils::ParsedName device;
+  device.type = "IPU";
+  DeviceProperties properties = GetDeviceInfo(device);
+  EXPECT_EQ("IPU", properties.type());
+  EXPECT_EQ(1216, properties.num_cores());
+  EXPECT_LT(0, properties.memory_size());
+  EXPECT_LT(0, properties.bandwidth());
+  EXPECT_EQ(1, properties.environment().count("exchange_bandwidth"));
+  EXPECT_EQ(1, properties.environment().count("link_bandwidth"));
+  EXPECT_EQ("1.0", properties.environment().at("cycle_calibration"));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
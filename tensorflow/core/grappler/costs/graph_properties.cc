@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 
 #include "absl/types/optional.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -35,6 +36,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 
 namespace tensorflow {
@@ -547,13 +550,19 @@ bool IsWhiteListedOpTypeForEvaluateNode(const string& op_type) {
 // unknown shape/dimension of a given node.
 class SymbolicShapeRefiner {
  public:
+  using CachedShapesMap =
+      std::unordered_map<const NodeDef*,
+                         std::shared_ptr<const GraphPropertiesCache::NodeShapes>>;
+
   explicit SymbolicShapeRefiner(
       const GraphView& graph,
       const std::unordered_map<string, std::unordered_set<int>>& fed_ports,
-      const bool aggressive_shape_inference)
+      const bool aggressive_shape_inference,
+      const CachedShapesMap& cached_shapes = CachedShapesMap())
       : graph_(graph),
         function_library_(OpRegistry::Global(), graph.graph()->library()),
         fed_ports_(fed_ports),
+        cached_shapes_(cached_shapes),
         aggressive_shape_inference_(aggressive_shape_inference) {
     graph_def_version_ = graph.graph()->versions().producer();
     node_to_context_.reserve(graph.graph()->node_size());
@@ -1688,6 +1697,14 @@ class SymbolicShapeRefiner {
   }
 
   Status InferShapes(const NodeDef& node, NodeContext* c) {
+    // Reuse the output shapes found by an earlier inference if the node did
+    // not change since.
+    auto cached = cached_shapes_.find(&node);
+    if (cached != cached_shapes_.end() &&
+        SetCachedShapes(*cached->second, c).ok()) {
+      return Status::OK();
+    }
+
     // Infer the shapes of output tensors.
     if (!c->op_data || c->op_data->shape_inference_fn == nullptr ||
         !c->inference_context->Run(c->op_data->shape_inference_fn).ok()) {
@@ -1716,6 +1733,35 @@ class SymbolicShapeRefiner {
   }
 
  private:
+  // Sets the outputs of a node from the shapes cached for it.
+  Status SetCachedShapes(const GraphPropertiesCache::NodeShapes& shapes,
+                         NodeContext* c) {
+    InferenceContext* ic = c->inference_context.get();
+    if (shapes.output_shapes.size() != ic->num_outputs()) {
+      return errors::Internal("Expected ", ic->num_outputs(),
+                              " cached output shapes, got ",
+                              shapes.output_shapes.size());
+    }
+    c->output_tensor_protos.assign(ic->num_outputs(), nullptr);
+    c->output_tensors_as_shapes.assign(ic->num_outputs(), ShapeHandle());
+    for (int i = 0; i < ic->num_outputs(); ++i) {
+      ShapeHandle shape;
+      TF_RETURN_IF_ERROR(
+          ic->MakeShapeFromShapeProto(shapes.output_shapes[i], &shape));
+      ic->set_output(i, shape);
+      if (shapes.output_values[i]) {
+        const_tensors_to_propagate_.push_back(*shapes.output_values[i]);
+        c->output_tensor_protos[i] = &const_tensors_to_propagate_.back();
+      }
+      if (shapes.output_tensors_as_shapes[i]) {
+        TF_RETURN_IF_ERROR(ic->MakeShapeFromShapeProto(
+            *shapes.output_tensors_as_shapes[i],
+            &c->output_tensors_as_shapes[i]));
+      }
+    }
+    return Status::OK();
+  }
+
   bool IsIntegerVector(const Tensor& tensor) {
     if (tensor.dims() == 1 &&
         (tensor.dtype() == DT_INT32 || tensor.dtype() == DT_INT64)) {
@@ -1813,6 +1859,8 @@ class SymbolicShapeRefiner {
       fun_to_grappler_function_item_;
   FunctionLibraryDefinition function_library_;
   const std::unordered_map<string, std::unordered_set<int>>& fed_ports_;
+  // Output shapes found by an earlier inference of unchanged nodes.
+  const CachedShapesMap& cached_shapes_;
   // Store TensorProtos for tensor value propagation. Note that we use list, not
   // vector, as we use pointers to the TensorProtos in this container. Vector
   // may resize and copy the objects into a new buffer, then the existing
@@ -2153,6 +2201,140 @@ Status GraphProperties::UpdateEnqueue(
   return Status::OK();
 }
 
+std::shared_ptr<const GraphPropertiesCache::NodeShapes>
+GraphPropertiesCache::Lookup(uint64 fingerprint) const {
+  mutex_lock l(mu_);
+  auto it = nodes_.find(fingerprint);
+  return it == nodes_.end() ? nullptr : it->second;
+}
+
+void GraphPropertiesCache::Insert(
+    std::vector<std::pair<uint64, std::shared_ptr<const NodeShapes>>> shapes,
+    int num_nodes) {
+  mutex_lock l(mu_);
+  if (nodes_.size() + shapes.size() > 2 * static_cast<size_t>(num_nodes)) {
+    nodes_.clear();
+  }
+  for (auto& node_shapes : shapes) {
+    nodes_[node_shapes.first] = std::move(node_shapes.second);
+  }
+}
+
+int64 GraphPropertiesCache::size() const {
+  mutex_lock l(mu_);
+  return nodes_.size();
+}
+
+namespace {
+
+// Cached output values are copied for every inference, so only small ones,
+// such as the values of shapes, are cached.
+constexpr int64 kMaxCachedValueBytes = 1024;
+
+// Returns a fingerprint of the options which affect the inferred shapes of
+// all the nodes of the graph.
+uint64 CacheSeed(const GraphDef& graph, bool aggressive_shape_inference) {
+  string library;
+  SerializeToStringDeterministic(graph.library(), &library);
+  return Hash64Combine(
+      Hash64(library),
+      Hash64Combine(graph.versions().producer(), aggressive_shape_inference));
+}
+
+// Returns the fingerprints of the nodes whose shapes can be cached. The
+// fingerprint of a node covers its op, its attributes and the fingerprints of
+// its regular fanins, so it changes whenever anything that the shape
+// inference of the node depends on changes.
+std::unordered_map<const NodeDef*, uint64> ComputeCacheFingerprints(
+    const std::vector<const NodeDef*>& topo_order, const GraphView& graph_view,
+    const std::unordered_map<string, std::unordered_set<int>>& fed_ports,
+    const FunctionLibraryDefinition& function_library, uint64 seed) {
+  std::unordered_map<const NodeDef*, uint64> fingerprints;
+  fingerprints.reserve(topo_order.size());
+  for (const NodeDef* node : topo_order) {
+    // The shapes of these nodes depend on more than their fanin.
+    if (fed_ports.find(node->name()) != fed_ports.end() || IsMerge(*node) ||
+        IsEnter(*node) || IsExit(*node) || IsNextIteration(*node) ||
+        IsQueue(*node) || IsEnqueue(*node) || IsDequeue(*node) ||
+        function_library.Find(node->op()) != nullptr) {
+      continue;
+    }
+    // Combine the attributes in an order independent way, since the order of
+    // a proto map is unspecified.
+    uint64 attrs = 0;
+    for (const auto& attr : node->attr()) {
+      attrs += Hash64Combine(Hash64(attr.first), AttrValueHash(attr.second));
+    }
+    uint64 fingerprint =
+        Hash64Combine(Hash64Combine(seed, Hash64(node->op())), attrs);
+    bool cacheable = true;
+    for (const string& input : node->input()) {
+      const TensorId tensor_id = ParseTensorName(input);
+      if (tensor_id.index() < 0) {
+        // Control inputs come last and do not affect the shapes.
+        break;
+      }
+      const NodeDef* fanin = graph_view.GetNode(tensor_id.node());
+      auto it = fanin == nullptr ? fingerprints.end() : fingerprints.find(fanin);
+      if (it == fingerprints.end()) {
+        cacheable = false;
+        break;
+      }
+      fingerprint = Hash64Combine(
+          fingerprint, Hash64Combine(it->second, tensor_id.index()));
+    }
+    if (cacheable) {
+      fingerprints[node] = fingerprint;
+    }
+  }
+  return fingerprints;
+}
+
+// Returns the shapes to cache for a node, or nullptr if some of its outputs
+// are not fully known.
+std::shared_ptr<const GraphPropertiesCache::NodeShapes> MakeCachedShapes(
+    const NodeDef& node, const SymbolicShapeRefiner::NodeContext& ctx) {
+  // Constants are cheap to infer and can be large.
+  if (IsConstant(node) || ctx.shape_incompatible) {
+    return nullptr;
+  }
+  InferenceContext* ic = ctx.inference_context.get();
+  auto shapes = std::make_shared<GraphPropertiesCache::NodeShapes>();
+  shapes->output_shapes.resize(ic->num_outputs());
+  shapes->output_values.resize(ic->num_outputs());
+  shapes->output_tensors_as_shapes.resize(ic->num_outputs());
+  for (int i = 0; i < ic->num_outputs(); ++i) {
+    // The handle shapes of resources and variants are not cached.
+    if (ctx.output_types[i] == DT_RESOURCE ||
+        ctx.output_types[i] == DT_VARIANT ||
+        !ic->FullyDefined(ic->output(i))) {
+      return nullptr;
+    }
+    ic->ShapeHandleToProto(ic->output(i), &shapes->output_shapes[i]);
+    if (ctx.output_tensor_protos.size() > i &&
+        ctx.output_tensor_protos[i] != nullptr) {
+      if (ctx.output_tensor_protos[i]->ByteSizeLong() > kMaxCachedValueBytes) {
+        return nullptr;
+      }
+      shapes->output_values[i] = *ctx.output_tensor_protos[i];
+    }
+    if (ctx.output_tensors_as_shapes.size() > i) {
+      const ShapeHandle& as_shape = ctx.output_tensors_as_shapes[i];
+      if (ic->FullyDefined(as_shape)) {
+        TensorShapeProto as_shape_proto;
+        ic->ShapeHandleToProto(as_shape, &as_shape_proto);
+        shapes->output_tensors_as_shapes[i] = std::move(as_shape_proto);
+      } else if (ic->RankKnown(as_shape)) {
+        // Partially known values would be lost.
+        return nullptr;
+      }
+    }
+  }
+  return shapes;
+}
+
+}  // namespace
+
 Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
@@ -2241,10 +2423,28 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
     }
   }
 
+  // Look up the nodes which did not change since an earlier inference.
+  GraphPropertiesCache* cache = item_.graph_properties_cache.get();
+  std::unordered_map<const NodeDef*, uint64> fingerprints;
+  SymbolicShapeRefiner::CachedShapesMap cached_shapes;
+  if (cache != nullptr) {
+    fingerprints = ComputeCacheFingerprints(
+        topo_order, graph_view, fed_ports, function_library,
+        CacheSeed(item_.graph, aggressive_shape_inference));
+    for (const auto& fingerprint : fingerprints) {
+      auto shapes = cache->Lookup(fingerprint.second);
+      if (shapes != nullptr) {
+        cached_shapes.emplace(fingerprint.first, std::move(shapes));
+      }
+    }
+    VLOG(1) << "Reusing the cached shapes of " << cached_shapes.size() << "/"
+            << item_.graph.node_size() << " nodes";
+  }
+
   // Heap-allocate SymbolicShapeRefiner in order to not consume a large amount
   // of stack space.
   auto refiner = absl::make_unique<SymbolicShapeRefiner>(
-      graph_view, fed_ports, aggressive_shape_inference);
+      graph_view, fed_ports, aggressive_shape_inference, cached_shapes);
 
   TopoQueue new_shapes(topo_order);
   // Also seed the propagation of shapes in the fanout of primary inputs.
@@ -2375,6 +2575,26 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
       incompatible_shape_nodes_.insert(node.name());
   }
 
+  if (cache != nullptr) {
+    std::vector<std::pair<
+        uint64, std::shared_ptr<const GraphPropertiesCache::NodeShapes>>>
+        new_shapes;
+    for (const auto& fingerprint : fingerprints) {
+      if (cached_shapes.find(fingerprint.first) != cached_shapes.end()) {
+        continue;
+      }
+      auto* ctx = refiner->GetNodeContext(fingerprint.first);
+      if (ctx == nullptr || !ctx->inference_context) {
+        continue;
+      }
+      auto shapes = MakeCachedShapes(*fingerprint.first, *ctx);
+      if (shapes != nullptr) {
+        new_shapes.emplace_back(fingerprint.second, std::move(shapes));
+      }
+    }
+    cache->Insert(std::move(new_shapes), item_.graph.node_size());
+  }
+
   if (aggressive_shape_inference && !incompatible_shape_nodes_.empty())
     LOG(WARNING) << incompatible_shape_nodes_.size()
                  << " nodes have incompatible output shapes.";
@@ -16,14 +16,21 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_GRAPH_PROPERTIES_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_GRAPH_PROPERTIES_H_
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -71,6 +78,50 @@ ABSL_CONST_INIT const char kOutputShapes[] = "_output_shape_vector";
 class SymbolicShapeRefiner;
 class TopoQueue;
 
+// Caches the output shapes found by GraphProperties::InferStatically, so that
+// inferring the shapes of a modified version of a graph only runs the shape
+// functions of the nodes which changed and of their fanout.
+//
+// The entries are keyed by a fingerprint of the node and of its transitive
+// fanin, so a cache can be shared by all the items derived from a graph (see
+// GrapplerItem::graph_properties_cache). Only outputs with fully defined
+// shapes are cached: they carry no symbolic dimensions, so reusing them gives
+// the same properties as inferring them again. Nodes in loops, fed nodes,
+// queues and function calls are always inferred.
+class GraphPropertiesCache {
+ public:
+  // The cached outputs of a node.
+  struct NodeShapes {
+    std::vector<TensorShapeProto> output_shapes;
+    // The values of the outputs, when they are known.
+    std::vector<absl::optional<TensorProto>> output_values;
+    // The values of integer outputs used as shapes, when they are known.
+    std::vector<absl::optional<TensorShapeProto>> output_tensors_as_shapes;
+  };
+
+  GraphPropertiesCache() = default;
+  GraphPropertiesCache(const GraphPropertiesCache&) = delete;
+  GraphPropertiesCache& operator=(const GraphPropertiesCache&) = delete;
+
+  // Returns the shapes of the node with the given fingerprint, or nullptr.
+  std::shared_ptr<const NodeShapes> Lookup(uint64 fingerprint) const;
+
+  // Adds the shapes of the nodes of a graph with `num_nodes` nodes. Entries of
+  // other graphs are dropped when the cache grows beyond twice the size of
+  // the graph.
+  void Insert(
+      std::vector<std::pair<uint64, std::shared_ptr<const NodeShapes>>> shapes,
+      int num_nodes);
+
+  // Returns the number of cached nodes.
+  int64 size() const;
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<uint64, std::shared_ptr<const NodeShapes>> nodes_
+      GUARDED_BY(mu_);
+};
+
 // Infer OpInfo::TensorProperties for graph nodes inputs/outputs.
 //
 // Typical use case, is to infer tensor properties from a graph, before doing
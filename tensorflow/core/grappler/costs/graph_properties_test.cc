@@ -2064,6 +2064,66 @@ TEST_F(GraphPropertiesTest, ShapeAnnotatedFunctionOp) {
     EXPECT_EQ("float: [1,2,3,4]", PropToString(out_prop0));
   }
 }
+
+TEST_F(GraphPropertiesTest, IncrementalShapeInference) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2, 3});
+  Output b = ops::Square(s.WithOpName("b"), a);
+  Output c = ops::Const(s.WithOpName("c"), 1.0f, {2, 3});
+  Output d = ops::Add(s.WithOpName("d"), b, c);
+  Output e = ops::Shape(s.WithOpName("e"), d);
+  Output f = ops::Reshape(s.WithOpName("f"), c, e);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.graph_properties_cache = std::make_shared<GraphPropertiesCache>();
+  {
+    GraphProperties properties(item);
+    TF_CHECK_OK(properties.InferStatically(false));
+    EXPECT_EQ("float: [2,3]",
+              PropToString(properties.GetOutputProperties("f")[0]));
+  }
+  EXPECT_GT(item.graph_properties_cache->size(), 0);
+
+  // Nothing changed, so the shapes are reused.
+  {
+    GraphProperties properties(item);
+    TF_CHECK_OK(properties.InferStatically(false));
+    EXPECT_EQ("float: [2,3]",
+              PropToString(properties.GetOutputProperties("d")[0]));
+    EXPECT_EQ("float: [2,3]",
+              PropToString(properties.GetOutputProperties("f")[0]));
+  }
+
+  // Broadcast d over a larger input, the fanout of a must be inferred again.
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "a") {
+      Tensor value(DT_FLOAT, TensorShape({4, 2, 3}));
+      value.flat<float>().setConstant(1.0f);
+      value.AsProtoTensorContent(
+          (*node.mutable_attr())["value"].mutable_tensor());
+    }
+  }
+  GraphProperties properties(item);
+  TF_CHECK_OK(properties.InferStatically(false));
+  GrapplerItem uncached_item = item;
+  uncached_item.graph_properties_cache = nullptr;
+  GraphProperties uncached_properties(uncached_item);
+  TF_CHECK_OK(uncached_properties.InferStatically(false));
+  for (const NodeDef& node : item.graph.node()) {
+    const auto props = properties.GetOutputProperties(node.name());
+    const auto uncached_props =
+        uncached_properties.GetOutputProperties(node.name());
+    ASSERT_EQ(uncached_props.size(), props.size());
+    for (int i = 0; i < props.size(); ++i) {
+      EXPECT_EQ(PropToString(uncached_props[i]), PropToString(props[i]));
+    }
+  }
+  EXPECT_EQ("float: [4,2,3]",
+            PropToString(properties.GetOutputProperties("d")[0]));
+  EXPECT_EQ("int32: [3]", PropToString(properties.GetOutputProperties("e")[0]));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
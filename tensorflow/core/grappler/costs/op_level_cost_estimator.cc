@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -94,6 +95,15 @@ constexpr char kReadVariablesOp[] = "_ReadVariablesOp";
 
 static const Costs::Duration kMinComputeTime(1);
 
+// The floating point operations per cycle of an IPU tile. Matmuls and
+// convolutions run on the accumulating matrix product units, all the other ops
+// on the vector units.
+constexpr double kIpuMatMulFlopsPerCycle = 64.0;
+constexpr double kIpuVectorFlopsPerCycle = 4.0;
+// The cycles spent synchronising the tiles between the compute and the
+// exchange phases of an op.
+constexpr double kIpuSyncCyclesPerOp = 200.0;
+
 namespace {
 
 string GetDataFormat(const OpInfo& op_info) {
@@ -120,6 +130,38 @@ Padding GetPadding(const OpInfo& op_info) {
   return Padding::SAME;  // Default padding.
 }
 
+bool IsIpuMatMulOp(const string& op) {
+  static const std::set<string>* ops = new std::set<string>{
+      kConv2d,
+      kConv2dBackpropFilter,
+      kConv2dBackpropInput,
+      kFusedConv2dBiasActivation,
+      kDepthwiseConv2dNative,
+      kDepthwiseConv2dNativeBackpropFilter,
+      kDepthwiseConv2dNativeBackpropInput,
+      kMatMul,
+      kSparseMatMul,
+      kBatchMatMul,
+      kQuantizedMatMul,
+      kQuantizedMatMulV2,
+      kXlaEinsum,
+  };
+  return ops->count(op) > 0;
+}
+
+// Returns the value of a numeric entry of the device environment, or
+// `default_value` if it is missing or invalid.
+double GetEnvironmentValue(const DeviceProperties& device, const string& key,
+                           double default_value) {
+  auto it = device.environment().find(key);
+  double value;
+  if (it == device.environment().end() ||
+      !strings::safe_strtod(it->second, &value) || value <= 0) {
+    return default_value;
+  }
+  return value;
+}
+
 bool IsTraining(const OpInfo& op_info) {
   if (op_info.attr().find("is_training") != op_info.attr().end() &&
       op_info.attr().at("is_training").b()) {
@@ -465,26 +507,64 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
   const auto& op_info = op_context.op_info;
+  Costs costs;
   auto it = device_cost_impl_.find(op_info.op());
   if (it != device_cost_impl_.end()) {
     std::function<Costs(const OpContext&)> estimator = it->second;
-    Costs costs = estimator(op_context);
-    VLOG(1) << "Operation " << op_info.op() << " takes "
-            << costs.execution_time.count() << " ns.";
-    return costs;
+    costs = estimator(op_context);
+  } else if (persistent_ops_.find(op_info.op()) != persistent_ops_.end()) {
+    costs = PredictVariable(op_context);
+  } else if (elementwise_ops_.find(op_info.op()) != elementwise_ops_.end()) {
+    costs = PredictCwiseOp(op_context);
+  } else {
+    VLOG(1) << "Missing accurate estimator for op: " << op_info.op();
+    costs = PredictCostOfAnUnknownOp(op_context);
   }
 
-  if (persistent_ops_.find(op_info.op()) != persistent_ops_.end()) {
-    return PredictVariable(op_context);
+  if (op_info.device().type() == "IPU") {
+    AdjustCostsForIpu(op_context, &costs);
   }
+  VLOG(1) << "Operation " << op_info.op() << " takes "
+          << costs.execution_time.count() << " ns.";
+  return costs;
+}
 
-  if (elementwise_ops_.find(op_info.op()) != elementwise_ops_.end()) {
-    return PredictCwiseOp(op_context);
+void OpLevelCostEstimator::AdjustCostsForIpu(const OpContext& op_context,
+                                             Costs* costs) const {
+  // Metadata, identity and variable ops do not run on the tiles.
+  if (costs->execution_time <= kMinComputeTime) {
+    return;
   }
+  const auto& op_info = op_context.op_info;
+  const DeviceProperties& device = op_info.device();
 
-  VLOG(1) << "Missing accurate estimator for op: " << op_info.op();
+  // The device info counts the operations of the vector units.
+  double compute_ns = costs->compute_time.count();
+  if (IsIpuMatMulOp(op_info.op())) {
+    compute_ns *= kIpuVectorFlopsPerCycle / kIpuMatMulFlopsPerCycle;
+  }
 
-  return PredictCostOfAnUnknownOp(op_context);
+  // Each op is a compute phase followed by a sync and an exchange of its
+  // inputs to the tiles which use them.
+  bool found_unknown_shapes = false;
+  const double input_bytes = CalculateInputSize(op_info, &found_unknown_shapes);
+  const double exchange_gb_per_sec =
+      GetEnvironmentValue(device, "exchange_bandwidth", 7.6e9) / 1e6;
+  const double sync_ns =
+      kIpuSyncCyclesPerOp * 1e3 / std::max<int64>(device.frequency(), 1);
+  const double exchange_ns = sync_ns + input_bytes / exchange_gb_per_sec;
+  VLOG(1) << "Op:" << op_info.op() << " IPU Exchange Time (ns):" << exchange_ns;
+
+  // Scale the estimates to match the recorded cycle counts.
+  const double calibration =
+      GetEnvironmentValue(device, "cycle_calibration", 1.0);
+  costs->compute_time =
+      Costs::Duration(std::ceil(calibration * (compute_ns + exchange_ns)));
+  costs->memory_time =
+      Costs::Duration(std::ceil(calibration * costs->memory_time.count()));
+  costs->intermediate_memory_time = Costs::Duration(
+      std::ceil(calibration * costs->intermediate_memory_time.count()));
+  CombineCostsAndUpdateExecutionTime(costs);
 }
 
 DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
@@ -504,6 +584,16 @@ DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
         gb_per_sec = 32;
       }
     }
+  } else if (device.type() == "IPU") {
+    // The rate of the vector units of all the tiles. Matmuls and convolutions
+    // are adjusted by AdjustCostsForIpu.
+    gflops = device.num_cores() * device.frequency() * 1e-3 *
+             kIpuVectorFlopsPerCycle;
+    if (device.bandwidth() > 0) {
+      gb_per_sec = device.bandwidth() / 1e6;
+    } else {
+      gb_per_sec = 30000;
+    }
   } else if (device.type() == "GPU") {
     const string architecture = device.environment().at("architecture");
     int cores_per_multiprocessor;
@@ -193,6 +193,11 @@ class OpLevelCostEstimator {
   static OpInfo::TensorProperties DescribeTensor(
       DataType type, const std::vector<int64>& dims);
 
+  // Adjusts the costs of an op placed on an IPU for the faster matmul units,
+  // the exchange of the inputs between the tiles and the calibration of the
+  // device (see GetIpuInfo).
+  void AdjustCostsForIpu(const OpContext& op_context, Costs* costs) const;
+
   // This method calculates the execution time depending on whether IO can
   // overlap with computation. It assumes the memory and the compute times have
   // already been calculated.
@@ -75,6 +75,18 @@ void SetCpuDevice(OpInfo* op_info) {
   device->set_frequency(1000);      // 1000 Mhz = 1 GHz
 }
 
+void SetIpuDevice(OpInfo* op_info, const string& calibration) {
+  auto device = op_info->mutable_device();
+  device->Clear();
+  device->set_type("IPU");
+  device->set_num_cores(10);
+  device->set_bandwidth(10000000);  // 10000000 KB/s = 10 GB/s
+  device->set_frequency(1000);      // 1000 Mhz = 1 GHz
+  (*device->mutable_environment())["exchange_bandwidth"] =
+      "1000000";  // 1000000 KB/s = 1 GB/s
+  (*device->mutable_environment())["cycle_calibration"] = calibration;
+}
+
 // Returns an OpInfo for MatMul with the minimum set of fields set up.
 OpContext DescribeMatMul(int m, int n, int l, int k) {
   OpContext op_context;
@@ -873,6 +885,42 @@ TEST_F(OpLevelCostEstimatorTest, CastExecutionTime) {
   EXPECT_EQ(0, cost.num_ops_with_unknown_shapes);
 }
 
+TEST_F(OpLevelCostEstimatorTest, IpuExecutionTime) {
+  OpContext op_context = DescribeUnaryOp("Relu", 1000);
+  SetIpuDevice(&op_context.op_info, "1.0");
+  auto cost = PredictCosts(op_context);
+  // The 4000 input bytes are exchanged at 1 GB/s after a sync of 200 cycles at
+  // 1 GHz, on top of the compute phase.
+  EXPECT_LT(Costs::Duration(4200), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(800), cost.memory_time);
+  EXPECT_EQ(cost.compute_time + cost.memory_time, cost.execution_time);
+
+  // The calibration scales all the times.
+  SetIpuDevice(&op_context.op_info, "2.0");
+  auto calibrated_cost = PredictCosts(op_context);
+  EXPECT_NEAR(2 * cost.execution_time.count(),
+              calibrated_cost.execution_time.count(), 2);
+
+  // Metadata ops do not run on the tiles.
+  OpContext shape_context = DescribeUnaryOp("Shape", 1000);
+  SetIpuDevice(&shape_context.op_info, "1.0");
+  EXPECT_EQ(Costs::Duration(1), PredictCosts(shape_context).execution_time);
+}
+
+TEST_F(OpLevelCostEstimatorTest, IpuMatMulExecutionTime) {
+  OpContext op_context = DescribeMatMul(1000, 1000, 1000, 1000);
+  SetIpuDevice(&op_context.op_info, "1.0");
+  auto cost = PredictCosts(op_context);
+  bool found_unknown_shapes = false;
+  const double ops =
+      CountMatMulOperations(op_context.op_info, &found_unknown_shapes);
+  // 10 tiles at 1 GHz with 64 flops per cycle, plus the exchange of the 8MB of
+  // inputs at 1 GB/s after a sync of 200 cycles.
+  EXPECT_EQ(Costs::Duration(std::ceil(ops / 640 + 8000000 + 200)),
+            cost.compute_time);
+  EXPECT_FALSE(cost.inaccurate);
+}
+
 TEST_F(OpLevelCostEstimatorTest, UnknownOrPartialShape) {
   {
     auto cost = PredictCosts(DescribeMatMul(2, 4, 7, 7));
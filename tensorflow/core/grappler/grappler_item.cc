@@ -43,6 +43,7 @@ GrapplerItem GrapplerItem::WithGraph(GraphDef&& graph_def) const {
   item.restore_op = restore_op;
   item.save_restore_loc_tensor = save_restore_loc_tensor;
   item.queue_runners = queue_runners;
+  item.graph_properties_cache = graph_properties_cache;
   item.devices_ = devices_;
   item.optimization_options_ = optimization_options_;
   item.graph.Swap(&graph_def);
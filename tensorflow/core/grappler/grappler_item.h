@@ -31,6 +31,8 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
+class GraphPropertiesCache;
+
 // A TensorFlow model to optimize.
 // Models are represented by the combination of a graph, one of more fetch
 // nodes, and potentially a set of nodes to feed.
@@ -70,6 +72,11 @@ struct GrapplerItem {
   // ensure that the optimized metagraph can still be loaded.
   std::vector<string> keep_ops;
 
+  // If set, GraphProperties caches the shapes it infers for this item here,
+  // and reuses the shapes of the nodes which did not change since an earlier
+  // inference. The cache is shared by the copies of the item.
+  std::shared_ptr<GraphPropertiesCache> graph_properties_cache;
+
   // Return the set of node evaluated during a regular train/inference step.
   std::vector<const NodeDef*> MainOpsFanin() const;
   // Return the set of node run to populate the queues (if any).
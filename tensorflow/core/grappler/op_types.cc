@@ -237,6 +237,8 @@ bool IsEnter(const NodeDef& node) {
 
 bool IsEqual(const NodeDef& node) { return node.op() == "Equal"; }
 
+bool IsErf(const NodeDef& node) { return node.op() == "Erf"; }
+
 bool IsExit(const NodeDef& node) {
   const auto& op = node.op();
   return op == "Exit" || op == "RefExit";
@@ -547,6 +549,8 @@ bool IsSymbolicGradient(const NodeDef& node) {
   return node.op() == "SymbolicGradient";
 }
 
+bool IsTanh(const NodeDef& node) { return node.op() == "Tanh"; }
+
 bool IsTanhGrad(const NodeDef& node) { return node.op() == "TanhGrad"; }
 
 bool IsTensorArray(const NodeDef& node) {
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -46,6 +47,13 @@ namespace {
 
 const std::pair<int, int> kMinGPUArch = {7, 0};
 
+// The type of the Graphcore IPU devices, which are registered by the IPU
+// plugin.
+const char kIpuDeviceType[] = "IPU";
+
+// The class of devices which the graph is optimized for.
+enum class AutoMixedPrecisionMode { CUDA, IPU };
+
 const char kSuffix[] = "AutoMixedPrecision";
 const char kCastToFp16[] = "CastToFp16";
 const char kCastToFp32[] = "CastToFp32";
@@ -934,14 +942,16 @@ class AutoMixedPrecisionImpl {
  public:
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
-                         GraphDef* graph, string id)
+                         GraphDef* graph, string id,
+                         AutoMixedPrecisionMode mode)
       : virtual_placer_(cluster->GetDevices()),
         nodes_to_preserve_(nodes_to_preserve),
         graph_(graph),
         id_(id),
         graph_view_(graph),
         cuda_version_(GetCudaVersion(*cluster)),
-        cudnn_version_(GetCudnnVersion(*cluster)) {}
+        cudnn_version_(GetCudnnVersion(*cluster)),
+        mode_(mode) {}
 
   Status Optimize();
 
@@ -956,8 +966,9 @@ class AutoMixedPrecisionImpl {
   Status PrintDebugLogs(bool preop, size_t timestamp);
   void LogSkippedNode(const NodeDef& node) const;
   bool MustPreserve(const NodeDef& node) const;
-  bool IsOnGPU(const NodeDef& node) const;
-  bool IsOnSuitableGPUArch(const NodeDef& node) const;
+  std::unique_ptr<AutoMixedPrecisionLists> GetMixedPrecisionLists() const;
+  bool IsOnDevice(const NodeDef& node) const;
+  bool IsOnSuitableDevice(const NodeDef& node) const;
   bool ShouldProcess(const NodeDef& node) const;
   bool NodeHasFP16KernelForTypeAttr(const NodeDef& node, TypeAttrId taid) const;
   bool NodeImplicitlyReadsNonResourceVariable(const NodeDef& node) const;
@@ -996,6 +1007,7 @@ class AutoMixedPrecisionImpl {
   MutableGraphView graph_view_;
   int cuda_version_;
   int cudnn_version_;
+  AutoMixedPrecisionMode mode_;
   NodeTypeAttrMap node_type_map_;
   GraphTypeTopologyView graph_type_view_;
   bool force_all_fp16_;
@@ -1049,21 +1061,21 @@ Status AutoMixedPrecisionImpl::PrintDebugLogs(bool preop, size_t timestamp) {
     fname = io::JoinPath(prepend_path,
                          strings::StrCat("paintbuckets", suffix, ".txt"));
     f.open(fname.c_str(), std::fstream::out);
+    std::unique_ptr<AutoMixedPrecisionLists> lists = GetMixedPrecisionLists();
     f << "WhiteList:\n";
-    for (auto x :
-         AutoMixedPrecisionLists::WhiteList(cuda_version_, cudnn_version_)) {
+    for (auto x : lists->WhiteList()) {
       f << x << "\n";
     }
     f << "\nBlackList:\n";
-    for (auto x : AutoMixedPrecisionLists::BlackList()) {
+    for (auto x : lists->BlackList()) {
       f << x << "\n";
     }
     f << "\nGrayList:\n";
-    for (auto x : AutoMixedPrecisionLists::GrayList()) {
+    for (auto x : lists->GrayList()) {
       f << x << "\n";
     }
     f << "\nClearList:\n";
-    for (auto x : AutoMixedPrecisionLists::ClearList()) {
+    for (auto x : lists->ClearList()) {
       f << x << "\n";
     }
     f.close();
@@ -1077,14 +1089,29 @@ void AutoMixedPrecisionImpl::LogSkippedNode(const NodeDef& node) const {
           << " because it "
           << (MustPreserve(node)
                   ? "must be preserved"
-                  : "is not on the GPU, or the GPU arch is not suitable");
+                  : mode_ == AutoMixedPrecisionMode::IPU
+                        ? "is not on the IPU"
+                        : "is not on the GPU, or the GPU arch is not "
+                          "suitable");
 }
 
 bool AutoMixedPrecisionImpl::MustPreserve(const NodeDef& node) const {
   return nodes_to_preserve_.count(node.name());
 }
 
-bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
+std::unique_ptr<AutoMixedPrecisionLists>
+AutoMixedPrecisionImpl::GetMixedPrecisionLists() const {
+  switch (mode_) {
+    case AutoMixedPrecisionMode::IPU:
+      return absl::make_unique<AutoMixedPrecisionListsIpu>();
+    case AutoMixedPrecisionMode::CUDA:
+    default:
+      return absl::make_unique<AutoMixedPrecisionListsCuda>(cuda_version_,
+                                                            cudnn_version_);
+  }
+}
+
+bool AutoMixedPrecisionImpl::IsOnDevice(const NodeDef& node) const {
   string device_name;
   if (node.device().empty()) {
     device_name = virtual_placer_.get_canonical_device_name(node);
@@ -1093,9 +1120,11 @@ bool AutoMixedPrecisionImpl::IsOnGPU(const NodeDef& node) const {
   }
   string device;
   string not_used;
+  const char* device_type =
+      mode_ == AutoMixedPrecisionMode::IPU ? kIpuDeviceType : DEVICE_GPU;
   if (DeviceNameUtils::SplitDeviceName(device_name, &not_used, &device) &&
       absl::StrContains(absl::AsciiStrToLower(device),
-                        absl::AsciiStrToLower(DEVICE_GPU))) {
+                        absl::AsciiStrToLower(device_type))) {
     return true;
   }
   return false;
@@ -1127,7 +1156,11 @@ std::pair<int, int> GetDeviceGPUArch(
   }
 }
 
-bool AutoMixedPrecisionImpl::IsOnSuitableGPUArch(const NodeDef& node) const {
+bool AutoMixedPrecisionImpl::IsOnSuitableDevice(const NodeDef& node) const {
+  // All IPUs run fp16 at twice the fp32 throughput.
+  if (mode_ == AutoMixedPrecisionMode::IPU) {
+    return true;
+  }
   return GetDeviceGPUArch(virtual_placer_.get_device(node)) >= kMinGPUArch;
 }
 
@@ -1196,11 +1229,11 @@ Status AutoMixedPrecisionImpl::Optimize() {
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
 
-  fp16_whitelist_ =
-      AutoMixedPrecisionLists::WhiteList(cuda_version_, cudnn_version_);
-  fp16_blacklist_ = AutoMixedPrecisionLists::BlackList();
-  fp16_graylist_ = AutoMixedPrecisionLists::GrayList();
-  fp16_clearlist_ = AutoMixedPrecisionLists::ClearList();
+  std::unique_ptr<AutoMixedPrecisionLists> lists = GetMixedPrecisionLists();
+  fp16_whitelist_ = lists->WhiteList();
+  fp16_blacklist_ = lists->BlackList();
+  fp16_graylist_ = lists->GrayList();
+  fp16_clearlist_ = lists->ClearList();
   TF_RETURN_IF_ERROR(ValidateLists(fp16_whitelist_, fp16_blacklist_,
                                    fp16_graylist_, fp16_clearlist_));
 
@@ -1209,8 +1242,8 @@ Status AutoMixedPrecisionImpl::Optimize() {
 
   VLOG(2) << "Identifying nodes that should be processed";
   for (const NodeDef& node : graph_->node()) {
-    if (!MustPreserve(node) && IsOnGPU(node) &&
-        (ShouldIgnorePerformance() || IsOnSuitableGPUArch(node))) {
+    if (!MustPreserve(node) && IsOnDevice(node) &&
+        (ShouldIgnorePerformance() || IsOnSuitableDevice(node))) {
       should_process_nodes_.insert(&node);
     } else {
       LogSkippedNode(node);
@@ -1874,6 +1907,16 @@ int GetNumGPUs(const Cluster& cluster,
   return num_gpus;
 }
 
+int GetNumIPUs(const Cluster& cluster) {
+  int num_ipus = 0;
+  for (const auto& device : cluster.GetDevices()) {
+    if (absl::StrContains(device.second.type(), kIpuDeviceType)) {
+      num_ipus++;
+    }
+  }
+  return num_ipus;
+}
+
 }  // end namespace
 
 Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
@@ -1885,18 +1928,24 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
   // Start by copying input graph to output.
   *output = item.graph;
 
+  // AutoMixedPrecision is currently only tuned for GPUs and IPUs. GPUs take
+  // precedence when both are present.
+  AutoMixedPrecisionMode mode;
   int num_gpus = ShouldIgnorePerformance() ? GetNumGPUs(*cluster)
                                            : GetNumGPUs(*cluster, kMinGPUArch);
-  if (num_gpus < 1) {
-    // AutoMixedPrecision is currently only tuned for GPU.
-    LOG(WARNING) << "No (suitable) GPUs detected, skipping " << name()
+  if (num_gpus >= 1) {
+    mode = AutoMixedPrecisionMode::CUDA;
+  } else if (GetNumIPUs(*cluster) >= 1) {
+    mode = AutoMixedPrecisionMode::IPU;
+  } else {
+    LOG(WARNING) << "No (suitable) GPUs or IPUs detected, skipping " << name()
                  << " graph optimizer";
     return Status::OK();
   }
 
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id);
+                                   item.id, mode);
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
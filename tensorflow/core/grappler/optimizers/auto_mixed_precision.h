@@ -23,7 +23,7 @@ namespace tensorflow {
 namespace grappler {
 
 // Convert data types to float16 where appropriate to improve performance on
-// GPUs.
+// GPUs and IPUs.
 class AutoMixedPrecision : public GraphOptimizer {
  public:
   explicit AutoMixedPrecision(
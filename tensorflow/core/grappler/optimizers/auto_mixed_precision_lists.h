@@ -23,83 +23,21 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
+// The lists of ops which the auto mixed precision optimizer converts to fp16,
+// for one class of devices. The gray, black and clear lists describe the
+// numerical properties of the ops and are shared, while the white list
+// depends on which ops are fast in fp16 on the device.
 class AutoMixedPrecisionLists {
- private:
-  static void UpdateList(gtl::FlatSet<string>* list, const string& to_add,
-                         const string& to_remove) {
-    for (auto x : str_util::Split(to_add, ",")) {
-      list->insert(x);
-    }
-    for (auto x : str_util::Split(to_remove, ",")) {
-      list->erase(x);
-    }
-  }
-
-  static bool IsPseudoFastMath() {
-    string optimization_level;
-    TF_CHECK_OK(
-        ReadStringFromEnvVar("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "",
-                             &optimization_level));
-    optimization_level = str_util::Uppercase(optimization_level);
-    return optimization_level == "TENSOR_CORES_ONLY";
-  }
-
  public:
+  virtual ~AutoMixedPrecisionLists() {}
+
   // Returns the set of ops that are considered numerically-safe (for execution
   // in fp16) and performance-critical. These ops are always converted to fp16.
-  static gtl::FlatSet<string> WhiteList(int cuda_version, int cudnn_version) {
-    string to_add, to_remove;
-    TF_CHECK_OK(ReadStringFromEnvVar(
-        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_WHITELIST_ADD", "", &to_add));
-    TF_CHECK_OK(ReadStringFromEnvVar(
-        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_WHITELIST_REMOVE", "",
-        &to_remove));
-
-    auto list = gtl::FlatSet<string>{
-        "BlockLSTM",
-        "BlockLSTMV2",
-        "BlockLSTMGrad",
-        "BlockLSTMGradV2",
-        "Conv2D",
-        "Conv2DBackpropFilter",
-        "Conv2DBackpropInput",
-        "CudnnRNN",
-        "CudnnRNNBackprop",
-        "CudnnRNNBackpropV2",
-        "CudnnRNNBackpropV3",
-        "CudnnRNNV2",
-        "CudnnRNNV3",
-        "GRUBlockCell",
-        "GRUBlockCellGrad",
-        "LSTMBlockCell",
-        "LSTMBlockCellGrad",
-        // TODO(benbarsdell): Enable these when fast and safe fp16 kernels are
-        // available for depthwise convolutions.
-        // "DepthwiseConv2dNative",
-        // "DepthwiseConv2dNativeBackpropFilter",
-        // "DepthwiseConv2dNativeBackpropInput",
-        "MatMul",
-    };
-    if (cuda_version >= 9010) {
-      // Fp16 BatchMatMul is slow before CUDA 9.1.
-      list.insert("BatchMatMul");
-      list.insert("BatchMatMulV2");
-    }
-    if (cudnn_version >= 7602) {
-      // Fp16 3D conv is slow before CUDNN 7.6.2.
-      list.insert("Conv3D");
-      list.insert("Conv3DBackpropFilter");
-      list.insert("Conv3DBackpropFilterV2");
-      list.insert("Conv3DBackpropInput");
-      list.insert("Conv3DBackpropInputV2");
-    }
-    UpdateList(&list, to_add, to_remove);
-    return list;
-  }
+  virtual gtl::FlatSet<string> WhiteList() = 0;
 
   // Returns the set of ops that are considered numerically-safe (for execution
   // in fp16), but which may be made unsafe by an upstream blacklist op.
-  static gtl::FlatSet<string> GrayList() {
+  virtual gtl::FlatSet<string> GrayList() {
     if (IsPseudoFastMath()) {
       return gtl::FlatSet<string>{};
     }
@@ -162,7 +100,7 @@ class AutoMixedPrecisionLists {
   // Returns the set of ops that are considered numerically-dangerous (i.e.,
   // unsafe for execution in fp16) and whose effects may also be observed in
   // downstream nodes (e.g., in Exp -> Add, the Add is unsafe due to the Exp).
-  static gtl::FlatSet<string> BlackList() {
+  virtual gtl::FlatSet<string> BlackList() {
     if (IsPseudoFastMath()) {
       return gtl::FlatSet<string>{};
     }
@@ -190,7 +128,7 @@ class AutoMixedPrecisionLists {
 
   // Returns the set of ops that do not have numerically-significant effects
   // (i.e., they are always considered safe for execution in fp16 precision).
-  static gtl::FlatSet<string> ClearList() {
+  virtual gtl::FlatSet<string> ClearList() {
     if (IsPseudoFastMath()) {
       return gtl::FlatSet<string>{};
     }
@@ -316,6 +254,124 @@ class AutoMixedPrecisionLists {
     UpdateList(&list, to_add, to_remove);
     return list;
   }
+
+ protected:
+  static void UpdateList(gtl::FlatSet<string>* list, const string& to_add,
+                         const string& to_remove) {
+    for (auto x : str_util::Split(to_add, ",")) {
+      list->insert(x);
+    }
+    for (auto x : str_util::Split(to_remove, ",")) {
+      list->erase(x);
+    }
+  }
+
+  static bool IsPseudoFastMath() {
+    string optimization_level;
+    TF_CHECK_OK(
+        ReadStringFromEnvVar("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "",
+                             &optimization_level));
+    optimization_level = str_util::Uppercase(optimization_level);
+    return optimization_level == "TENSOR_CORES_ONLY";
+  }
+
+  // Updates the white list from the environment.
+  static void UpdateWhiteList(gtl::FlatSet<string>* list) {
+    string to_add, to_remove;
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_WHITELIST_ADD", "", &to_add));
+    TF_CHECK_OK(ReadStringFromEnvVar(
+        "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_WHITELIST_REMOVE", "",
+        &to_remove));
+    UpdateList(list, to_add, to_remove);
+  }
+};
+
+// The lists for NVIDIA GPUs, which depend on the versions of CUDA and cuDNN.
+class AutoMixedPrecisionListsCuda : public AutoMixedPrecisionLists {
+ public:
+  AutoMixedPrecisionListsCuda(int cuda_version, int cudnn_version)
+      : cuda_version_(cuda_version), cudnn_version_(cudnn_version) {}
+
+  gtl::FlatSet<string> WhiteList() override {
+    auto list = gtl::FlatSet<string>{
+        "BlockLSTM",
+        "BlockLSTMV2",
+        "BlockLSTMGrad",
+        "BlockLSTMGradV2",
+        "Conv2D",
+        "Conv2DBackpropFilter",
+        "Conv2DBackpropInput",
+        "CudnnRNN",
+        "CudnnRNNBackprop",
+        "CudnnRNNBackpropV2",
+        "CudnnRNNBackpropV3",
+        "CudnnRNNV2",
+        "CudnnRNNV3",
+        "GRUBlockCell",
+        "GRUBlockCellGrad",
+        "LSTMBlockCell",
+        "LSTMBlockCellGrad",
+        // TODO(benbarsdell): Enable these when fast and safe fp16 kernels are
+        // available for depthwise convolutions.
+        // "DepthwiseConv2dNative",
+        // "DepthwiseConv2dNativeBackpropFilter",
+        // "DepthwiseConv2dNativeBackpropInput",
+        "MatMul",
+    };
+    if (cuda_version_ >= 9010) {
+      // Fp16 BatchMatMul is slow before CUDA 9.1.
+      list.insert("BatchMatMul");
+      list.insert("BatchMatMulV2");
+    }
+    if (cudnn_version_ >= 7602) {
+      // Fp16 3D conv is slow before CUDNN 7.6.2.
+      list.insert("Conv3D");
+      list.insert("Conv3DBackpropFilter");
+      list.insert("Conv3DBackpropFilterV2");
+      list.insert("Conv3DBackpropInput");
+      list.insert("Conv3DBackpropInputV2");
+    }
+    UpdateWhiteList(&list);
+    return list;
+  }
+
+ private:
+  int cuda_version_;
+  int cudnn_version_;
+};
+
+// The lists for Graphcore IPUs. Matrix multiplications, convolutions and the
+// recurrent layers are twice as fast in fp16 and accumulate in fp32 on the
+// IPU. Reductions stay on the black list, and the batch normalizations on the
+// gray list compute their statistics in fp32, so that both keep accumulating
+// in fp32.
+class AutoMixedPrecisionListsIpu : public AutoMixedPrecisionLists {
+ public:
+  gtl::FlatSet<string> WhiteList() override {
+    auto list = gtl::FlatSet<string>{
+        "BatchMatMul",
+        "BatchMatMulV2",
+        "Conv2D",
+        "Conv2DBackpropFilter",
+        "Conv2DBackpropInput",
+        "Conv3D",
+        "Conv3DBackpropFilter",
+        "Conv3DBackpropFilterV2",
+        "Conv3DBackpropInput",
+        "Conv3DBackpropInputV2",
+        "DepthwiseConv2dNative",
+        "DepthwiseConv2dNativeBackpropFilter",
+        "DepthwiseConv2dNativeBackpropInput",
+        "MatMul",
+        "PopnnGRULayer",
+        "PopnnGRULayerBackprop",
+        "PopnnLstmLayer",
+        "PopnnLstmLayerBackprop",
+    };
+    UpdateWhiteList(&list);
+    return list;
+  }
 };
 
 }  // end namespace grappler
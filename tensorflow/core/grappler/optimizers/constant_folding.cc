@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -53,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/bcast.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 
 namespace tensorflow {
@@ -188,7 +190,24 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
 
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device)
-    : opt_level_(opt_level), cpu_device_(cpu_device) {
+    : ConstantFolding(opt_level, cpu_device, /*num_threads=*/1,
+                      /*max_pending_bytes=*/0) {
+  int64 num_threads;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_CONSTANT_FOLDING_NUM_THREADS",
+                                  std::min(port::MaxParallelism(), 8),
+                                  &num_threads));
+  num_threads_ = std::max<int64>(num_threads, 1);
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_CONSTANT_FOLDING_MAX_PENDING_BYTES",
+                                  16 * kMaxConstantSize, &max_pending_bytes_));
+}
+
+ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
+                                 DeviceBase* cpu_device, int num_threads,
+                                 int64 max_pending_bytes)
+    : opt_level_(opt_level),
+      cpu_device_(cpu_device),
+      num_threads_(std::max(num_threads, 1)),
+      max_pending_bytes_(max_pending_bytes) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -1418,16 +1437,74 @@ Status ConstantFolding::FoldMergeNode(NodeDef* node, GraphDef* output_graph) {
   return Status::OK();
 }
 
-Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
-                                 bool* result_too_large) {
-  *result_too_large = false;
+void ConstantFolding::EvaluateFoldables(
+    const std::vector<NodeDef*>& nodes, std::vector<EvaluatedNode>* evaluated) {
+  evaluated->clear();
+  evaluated->resize(nodes.size());
+  std::vector<int> to_evaluate;
+  for (int i = 0; i < nodes.size(); ++i) {
+    if (!IsMerge(*nodes[i])) {
+      to_evaluate.push_back(i);
+    }
+  }
+  const auto evaluate = [this, &nodes, evaluated](int i) {
+    EvaluatedNode* result = &(*evaluated)[i];
+    result->status = EvaluateOneFoldable(*nodes[i], &result->const_nodes,
+                                         &result->result_too_large);
+  };
+  if (num_threads_ <= 1 || to_evaluate.size() <= 1) {
+    for (int i : to_evaluate) {
+      evaluate(i);
+    }
+    return;
+  }
+
+  if (thread_pool_ == nullptr) {
+    thread_pool_.reset(new thread::ThreadPool(
+        Env::Default(), "constant_folding", num_threads_));
+  }
+  // The evaluation only reads the graph, which is not modified until all the
+  // nodes have been evaluated.
+  BlockingCounter counter(to_evaluate.size());
+  for (int i : to_evaluate) {
+    thread_pool_->Schedule([&evaluate, &counter, i]() {
+      // The floating point environment is per thread, match the one Optimize
+      // sets up.
+      port::ScopedFlushDenormal flush;
+      port::ScopedSetRound round(FE_TONEAREST);
+      evaluate(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+int64 ConstantFolding::EstimateFoldedSize(
+    const NodeDef& node, const GraphProperties& properties) const {
+  if (!properties.HasOutputProperties(node.name())) {
+    return kMaxConstantSize;
+  }
+  int64 size = 0;
+  for (const auto& output : properties.GetOutputProperties(node.name())) {
+    const PartialTensorShape shape(output.shape());
+    const int64 num_elements = shape.num_elements();
+    const int64 element_size = DataTypeSize(output.dtype());
+    if (num_elements < 0 || element_size == 0) {
+      return kMaxConstantSize;
+    }
+    size += std::min(num_elements * element_size, kMaxConstantSize);
+  }
+  return size;
+}
+
+Status ConstantFolding::FoldNode(NodeDef* node, EvaluatedNode* evaluated,
+                                 GraphDef* output_graph) {
   if (IsMerge(*node)) {
     return FoldMergeNode(node, output_graph);
   }
 
-  std::vector<NodeDef> const_nodes;
-  TF_RETURN_IF_ERROR(
-      EvaluateOneFoldable(*node, &const_nodes, result_too_large));
+  TF_RETURN_IF_ERROR(evaluated->status);
+  std::vector<NodeDef>& const_nodes = evaluated->const_nodes;
   VLOG(2) << "Folded node: " << SummarizeNodeDef(*node);
 
   NodeDef* constant_output = nullptr;
@@ -1555,34 +1632,62 @@ Status ConstantFolding::FoldGraph(
       queue.push_back(graph_->mutable_node(i));
     }
   }
+  std::vector<NodeDef*> batch;
+  std::vector<EvaluatedNode> evaluated;
   while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
-    }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    const std::set<NodeDef*>& outputs = node_map_->GetOutputs(node->name());
-    std::vector<NodeDef*> fanout(outputs.begin(), outputs.end());
-    std::sort(fanout.begin(), fanout.end(),
-              [](const NodeDef* n1, const NodeDef* n2) {
-                return n1->name() < n2->name();
-              });
-
-    bool result_too_large = false;
-    Status s = FoldNode(node, output, &result_too_large);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
-      if (result_too_large) {
-        nodes_to_not_simplify->emplace(node->name());
+    // The inputs of the queued nodes are all constants, so the nodes at the
+    // front of the queue can be evaluated together. Their sizes are capped to
+    // bound the memory held by the folded constants until they are added to
+    // the graph.
+    batch.clear();
+    std::unordered_set<string> batched_nodes;
+    int64 batch_size = 0;
+    while (!queue.empty()) {
+      NodeDef* node = queue.front();
+      if (processed_nodes.count(node->name()) ||
+          batched_nodes.count(node->name())) {
+        queue.pop_front();
+        continue;
       }
-    } else {
-      for (auto& output : fanout) {
-        if (IsFoldable(*output, &properties)) {
-          queue.push_back(output);
+      const int64 size = EstimateFoldedSize(*node, properties);
+      if (!batch.empty() && batch_size + size > max_pending_bytes_) {
+        break;
+      }
+      queue.pop_front();
+      batch.push_back(node);
+      batched_nodes.insert(node->name());
+      batch_size += size;
+    }
+    EvaluateFoldables(batch, &evaluated);
+
+    // Apply the results in queue order, so that the graph does not depend on
+    // the number of threads.
+    for (int i = 0; i < batch.size(); ++i) {
+      NodeDef* node = batch[i];
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted deterministically.
+      const std::set<NodeDef*>& outputs = node_map_->GetOutputs(node->name());
+      std::vector<NodeDef*> fanout(outputs.begin(), outputs.end());
+      std::sort(fanout.begin(), fanout.end(),
+                [](const NodeDef* n1, const NodeDef* n2) {
+                  return n1->name() < n2->name();
+                });
+
+      Status s = FoldNode(node, &evaluated[i], output);
+      processed_nodes.insert(node->name());
+      // Release the folded constants as soon as they are in the graph.
+      evaluated[i].const_nodes.clear();
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+        if (evaluated[i].result_too_large) {
+          nodes_to_not_simplify->emplace(node->name());
+        }
+      } else {
+        for (auto& output : fanout) {
+          if (IsFoldable(*output, &properties)) {
+            queue.push_back(output);
+          }
         }
       }
     }
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
 namespace tensorflow {
@@ -45,7 +46,17 @@ class ConstantFolding : public GraphOptimizer {
                                      NodeMap* node_map);
 
   explicit ConstantFolding(DeviceBase* cpu_device);
+  // Evaluates the foldable nodes on TF_CONSTANT_FOLDING_NUM_THREADS threads,
+  // holding at most TF_CONSTANT_FOLDING_MAX_PENDING_BYTES bytes of folded
+  // constants at a time.
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device);
+  // Independent foldable nodes are evaluated concurrently on `num_threads`
+  // threads, in batches whose estimated outputs add up to at most
+  // `max_pending_bytes`. The results are applied to the graph in the same
+  // order as with a single thread, so the output does not depend on
+  // `num_threads`.
+  ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
+                  int num_threads, int64 max_pending_bytes);
 
   ~ConstantFolding() override {}
 
@@ -89,9 +100,24 @@ class ConstantFolding : public GraphOptimizer {
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
                              bool* result_too_large);
 
+  // The outcome of evaluating a foldable node.
+  struct EvaluatedNode {
+    Status status;
+    bool result_too_large = false;
+    std::vector<NodeDef> const_nodes;
+  };
+  // Evaluates the non-Merge `nodes`, concurrently if there are enough threads.
+  // All the inputs of the nodes must already be constants.
+  void EvaluateFoldables(const std::vector<NodeDef*>& nodes,
+                         std::vector<EvaluatedNode>* evaluated);
+  // Returns an upper bound of the size of the constants `node` folds into.
+  int64 EstimateFoldedSize(const NodeDef& node,
+                           const GraphProperties& properties) const;
+
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
-  Status FoldNode(NodeDef* node, GraphDef* output_graph,
-                  bool* result_too_large);
+  // Replaces `node` by its `evaluated` outputs.
+  Status FoldNode(NodeDef* node, EvaluatedNode* evaluated,
+                  GraphDef* output_graph);
 
   bool IsOnes(const NodeDef& node) const;
   bool IsZeros(const NodeDef& node) const;
@@ -305,6 +331,10 @@ class ConstantFolding : public GraphOptimizer {
   std::unique_ptr<DeviceBase> owned_device_;
 
   std::unique_ptr<ResourceMgr> resource_mgr_;
+  int num_threads_;
+  int64 max_pending_bytes_;
+  // Created on the first batch of nodes which can be evaluated concurrently.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
   GraphDef* graph_;
   std::unique_ptr<NodeMap> node_map_;
   std::unordered_set<string> nodes_to_preserve_;
@@ -253,6 +253,53 @@ TEST_F(ConstantFoldingTest, SimpleFolding) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, ParallelFolding) {
+  // Build a wide graph with many independent foldable nodes, and chains of
+  // nodes which only become foldable once their inputs are folded.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {16});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {16});
+  std::vector<Output> sums;
+  for (int i = 0; i < 16; ++i) {
+    Output x = ops::Mul(s.WithOpName(strings::StrCat("x", i)), a,
+                        ops::Const(s, static_cast<float>(i), {16}));
+    Output y = ops::Add(s.WithOpName(strings::StrCat("y", i)), x, b);
+    sums.push_back(ops::Sqrt(s.WithOpName(strings::StrCat("z", i)), y));
+  }
+  Output out = ops::AddN(s.WithOpName("out"), sums);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ConstantFolding serial_optimizer(RewriterConfig::ON, /*cpu_device=*/nullptr,
+                                   /*num_threads=*/1,
+                                   /*max_pending_bytes=*/kMaxConstantSize);
+  GraphDef serial_output;
+  TF_EXPECT_OK(serial_optimizer.Optimize(/*cluster=*/nullptr, item,
+                                         &serial_output));
+
+  // Evaluate the nodes on 4 threads, in batches of at most 4 nodes.
+  ConstantFolding parallel_optimizer(RewriterConfig::ON,
+                                     /*cpu_device=*/nullptr,
+                                     /*num_threads=*/4,
+                                     /*max_pending_bytes=*/4 * 16 * 4);
+  GraphDef parallel_output;
+  TF_EXPECT_OK(parallel_optimizer.Optimize(/*cluster=*/nullptr, item,
+                                           &parallel_output));
+
+  CompareGraphs(serial_output, parallel_output);
+  ASSERT_EQ(1, parallel_output.node_size());
+  EXPECT_EQ("out", parallel_output.node(0).name());
+  EXPECT_EQ("Const", parallel_output.node(0).op());
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(parallel_output, item.fetch);
+  ASSERT_EQ(1, tensors_expected.size());
+  ASSERT_EQ(1, tensors.size());
+  test::ExpectTensorNear<float>(tensors_expected[0], tensors[0], 1e-6);
+}
+
 TEST_F(ConstantFoldingTest, AddTree) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
@@ -36,7 +36,7 @@ using ConfigMap =
     std::map<string, tensorflow::RewriterConfig_CustomGraphOptimizer>;
 
 // tf.data optimizations, in the order we want to perform them.
-constexpr std::array<const char*, 16> kTFDataOptimizations = {
+constexpr std::array<const char*, 17> kTFDataOptimizations = {
     "make_stateless",
     "noop_elimination",
     "shuffle_and_repeat_fusion",
@@ -50,6 +50,7 @@ constexpr std::array<const char*, 16> kTFDataOptimizations = {
     "map_vectorization",
     "latency_all_edges",
     "make_sloppy",
+    "reorder_window",
     "parallel_batch",
     "slack",
     "inject_prefetch"};
@@ -0,0 +1,52 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/reorder_window.h"
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+Status ReorderWindow::OptimizeAndCollectStats(Cluster* cluster,
+                                              const GrapplerItem& item,
+                                              GraphDef* output,
+                                              OptimizationStats* stats) {
+  if (window_size_ < 0) {
+    return errors::InvalidArgument(
+        "ReorderWindow optimizer requires a `window_size` parameter.");
+  }
+  *output = item.graph;
+
+  for (NodeDef& node : *output->mutable_node()) {
+    if (node.op() != "ParallelInterleaveDatasetV2") continue;
+    auto sloppy = node.attr().find("sloppy");
+    if (sloppy != node.attr().end() && sloppy->second.b()) {
+      // Sloppy interleave already returns results as they are produced.
+      continue;
+    }
+    (*node.mutable_attr())["reorder_window"].set_i(window_size_);
+    stats->num_changes++;
+  }
+  return Status::OK();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(ReorderWindow, "reorder_window");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,65 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_REORDER_WINDOW_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_REORDER_WINDOW_H_
+
+#include "absl/strings/numbers.h"
+#include "tensorflow/core/grappler/optimizers/data/optimizer_base.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// This optimization sets the reorder_window attr of the deterministic
+// ParallelInterleaveDatasetV2 nodes in an input pipeline, which lets the
+// elements of a cycle buffer results ahead while another element lags.
+class ReorderWindow : public TFDataOptimizerBase {
+ public:
+  ReorderWindow() = default;
+  ~ReorderWindow() override = default;
+
+  string name() const override { return "reorder_window"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    if (!config) return errors::InvalidArgument("Config parameter required.");
+
+    const string& window_size_param =
+        config->parameter_map().at("window_size").s();
+    if (!absl::SimpleAtoi(window_size_param, &window_size_) ||
+        window_size_ < 0) {
+      return errors::InvalidArgument("Invalid `window_size` parameter: ",
+                                     window_size_param);
+    }
+    return Status::OK();
+  }
+
+  Status OptimizeAndCollectStats(Cluster* cluster, const GrapplerItem& item,
+                                 GraphDef* output,
+                                 OptimizationStats* stats) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimize_output, double result) override {}
+
+ private:
+  int64 window_size_ = -1;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_REORDER_WINDOW_H_
@@ -0,0 +1,106 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/reorder_window.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+void SetupGrapplerItem(bool sloppy, GrapplerItem* item) {
+  using test::function::NDef;
+  item->graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"}, {}),
+       NDef("cycle_length", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("block_length", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("num_parallel_calls", "Const", {},
+            {{"value", 1}, {"dtype", DT_INT32}}),
+       graph_tests_utils::MakeParallelInterleaveV2Node(
+           "interleave", "range", "cycle_length", "block_length",
+           "num_parallel_calls", "XTimesTwo", sloppy)},
+      // FunctionLib
+      {
+          test::function::XTimesTwo(),
+      });
+}
+
+TEST(ReorderWindowTest, Deterministic) {
+  GrapplerItem item;
+  SetupGrapplerItem(/*sloppy=*/false, &item);
+
+  ReorderWindow optimizer;
+  tensorflow::RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["window_size"].set_s("16");
+  TF_ASSERT_OK(optimizer.Init(&config));
+
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  int index = graph_utils::FindGraphNodeWithName("interleave", output);
+  ASSERT_GE(index, 0);
+  EXPECT_EQ(output.node(index).attr().at("reorder_window").i(), 16);
+}
+
+TEST(ReorderWindowTest, Sloppy) {
+  GrapplerItem item;
+  SetupGrapplerItem(/*sloppy=*/true, &item);
+
+  ReorderWindow optimizer;
+  tensorflow::RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["window_size"].set_s("16");
+  TF_ASSERT_OK(optimizer.Init(&config));
+
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  int index = graph_utils::FindGraphNodeWithName("interleave", output);
+  ASSERT_GE(index, 0);
+  EXPECT_EQ(output.node(index).attr().count("reorder_window"), 0);
+}
+
+TEST(ReorderWindowTest, TestFailWithoutInit) {
+  GrapplerItem item;
+  ReorderWindow optimizer;
+  GraphDef output;
+  Status result = optimizer.Optimize(nullptr, item, &output);
+
+  EXPECT_FALSE(result.ok());
+  EXPECT_TRUE(errors::IsInvalidArgument(result));
+}
+
+TEST(ReorderWindowTest, TestFailWithInvalidWindowSizeParam) {
+  ReorderWindow optimizer;
+  tensorflow::RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["window_size"].set_s("-1");
+  Status result = optimizer.Init(&config);
+
+  EXPECT_FALSE(result.ok());
+  EXPECT_TRUE(errors::IsInvalidArgument(result));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 
+#include <numeric>
 #include <vector>
 
 #include "absl/algorithm/container.h"
@@ -50,6 +51,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -1391,6 +1393,119 @@ void RestoreTensorMapping(const FunctionOptimizerContext& ctx,
   }
 }
 
+// Points the function references in `attr` to the functions they are renamed
+// to in `renamed`.
+void RenameFunctionsInAttr(
+    const absl::flat_hash_map<string, string>& renamed, AttrValue* attr) {
+  const auto rename = [&renamed](NameAttrList* func) {
+    auto it = renamed.find(func->name());
+    if (it != renamed.end()) func->set_name(it->second);
+    for (auto& func_attr : *func->mutable_attr()) {
+      RenameFunctionsInAttr(renamed, &func_attr.second);
+    }
+  };
+  if (attr->has_func()) {
+    rename(attr->mutable_func());
+  } else if (attr->has_list()) {
+    for (NameAttrList& func : *attr->mutable_list()->mutable_func()) {
+      rename(&func);
+    }
+  }
+}
+
+// Points the direct and indirect function calls of `node` to the functions
+// they are renamed to in `renamed`.
+void RenameFunctionsInNode(const absl::flat_hash_map<string, string>& renamed,
+                           NodeDef* node) {
+  auto it = renamed.find(node->op());
+  if (it != renamed.end()) node->set_op(it->second);
+  for (auto& attr : *node->mutable_attr()) {
+    RenameFunctionsInAttr(renamed, &attr.second);
+  }
+}
+
+// Returns true if the argument attributes of `f1` and `f2` are equal, these
+// are not compared by FunctionDefsEqual.
+bool ArgAttrsEqual(const FunctionDef& f1, const FunctionDef& f2) {
+  FunctionDef args1;
+  *args1.mutable_arg_attr() = f1.arg_attr();
+  FunctionDef args2;
+  *args2.mutable_arg_attr() = f2.arg_attr();
+  string serialized1;
+  string serialized2;
+  return SerializeToStringDeterministic(args1, &serialized1) &&
+         SerializeToStringDeterministic(args2, &serialized2) &&
+         serialized1 == serialized2;
+}
+
+// Models built from repeated layers instantiate many copies of the same
+// function body under different names. Replaces all the structurally
+// identical functions with equal attributes by the one with the smallest name,
+// so that they are optimized and compiled once. Renaming the calls
+// in function bodies can make these bodies identical too, so this is repeated
+// until no more functions are deduplicated. Functions which have, or are, a
+// registered gradient are kept as they are.
+void DeduplicateFunctions(GraphDef* graph) {
+  FunctionDefLibrary* library = graph->mutable_library();
+  absl::flat_hash_set<string> gradient_functions;
+  for (const GradientDef& gradient : library->gradient()) {
+    gradient_functions.insert(gradient.function_name());
+    gradient_functions.insert(gradient.gradient_func());
+  }
+
+  while (true) {
+    // Maps the hash of a nameless function to the indices of the distinct
+    // functions with this hash.
+    absl::flat_hash_map<uint64, std::vector<int>> canonical_functions;
+    std::vector<FunctionDef> nameless_functions(library->function_size());
+    absl::flat_hash_map<string, string> renamed;
+    std::vector<int> order(library->function_size());
+    std::iota(order.begin(), order.end(), 0);
+    absl::c_sort(order, [library](int i, int j) {
+      return library->function(i).signature().name() <
+             library->function(j).signature().name();
+    });
+    for (int i : order) {
+      const FunctionDef& func = library->function(i);
+      if (gradient_functions.contains(func.signature().name())) continue;
+      FunctionDef& nameless = nameless_functions[i];
+      nameless = func;
+      nameless.mutable_signature()->clear_name();
+
+      std::vector<int>& candidates =
+          canonical_functions[FunctionDefHash(nameless)];
+      auto canonical = absl::c_find_if(candidates, [&](int j) {
+        return FunctionDefsEqual(nameless, nameless_functions[j]) &&
+               ArgAttrsEqual(func, library->function(j));
+      });
+      if (canonical == candidates.end()) {
+        candidates.push_back(i);
+      } else {
+        const string& canonical_name =
+            library->function(*canonical).signature().name();
+        VLOG(2) << "Deduplicate function " << func.signature().name()
+                << " as " << canonical_name;
+        renamed.emplace(func.signature().name(), canonical_name);
+      }
+    }
+    if (renamed.empty()) return;
+
+    FunctionDefLibrary deduplicated;
+    *deduplicated.mutable_gradient() = library->gradient();
+    for (FunctionDef& func : *library->mutable_function()) {
+      if (renamed.contains(func.signature().name())) continue;
+      for (NodeDef& node : *func.mutable_node_def()) {
+        RenameFunctionsInNode(renamed, &node);
+      }
+      *deduplicated.add_function() = std::move(func);
+    }
+    library->Swap(&deduplicated);
+    for (NodeDef& node : *graph->mutable_node()) {
+      RenameFunctionsInNode(renamed, &node);
+    }
+  }
+}
+
 }  // namespace
 
 Status FunctionOptimizer::RunFunctionOptimizerPass(
@@ -1462,6 +1577,7 @@ Status FunctionOptimizer::RunFunctionOptimizerPass(
   // Prune unreachable function from the library.
   *optimized_graph->mutable_library() =
       PruneFunctionLibrary(ctx.function_library(), *optimized_graph);
+  DeduplicateFunctions(optimized_graph);
 
   return Status::OK();
 }
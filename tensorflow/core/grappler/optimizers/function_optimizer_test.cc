@@ -2019,5 +2019,65 @@ TEST_F(FunctionOptimizerTest, PruningUselessLibraryFunctions) {
             "XTimesTwo_specialized_for_y_at_test_graph");
 }
 
+TEST_F(FunctionOptimizerTest, DeduplicateIdenticalFunctions) {
+  using test::function::NDef;
+  FunctionOptimizer optimizer(RewriterConfig::DEFAULT, true);
+
+  // Two copies of XTimesTwo under different names, and a function with the
+  // same body and different attributes.
+  FunctionDef x_times_two = test::function::XTimesTwo();
+  (*x_times_two.mutable_attr())["_noinline"].set_b(true);
+  FunctionDef x_times_two_copy = x_times_two;
+  x_times_two_copy.mutable_signature()->set_name("XTimesTwoCopy");
+  FunctionDef x_times_two_other = x_times_two;
+  x_times_two_other.mutable_signature()->set_name("XTimesTwoOther");
+  (*x_times_two_other.mutable_attr())["_other"].set_b(true);
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("y1", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("y2", "XTimesTwoCopy", {"x"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("y3", "XTimesTwoOther", {"x"}, {{"T", DT_FLOAT}}, kDevice),
+       NDef("z", "AddN", {"y1", "y2", "y3"}, {{"T", DT_FLOAT}, {"N", 3}},
+            kDevice)},
+      {x_times_two, x_times_two_copy, x_times_two_other});
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The specializations of XTimesTwo and XTimesTwoCopy are identical, the one
+  // with the smallest name is kept.
+  std::vector<string> functions;
+  for (const FunctionDef& func : output.library().function()) {
+    functions.push_back(func.signature().name());
+  }
+  EXPECT_THAT(functions, ::testing::UnorderedElementsAre(
+                             "XTimesTwoCopy_specialized_for_y2_at_tf_graph",
+                             "XTimesTwoOther_specialized_for_y3_at_tf_graph"));
+
+  int count = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "y1" && ++count) {
+      EXPECT_EQ("XTimesTwoCopy_specialized_for_y2_at_tf_graph", node.op());
+    } else if (node.name() == "y2" && ++count) {
+      EXPECT_EQ("XTimesTwoCopy_specialized_for_y2_at_tf_graph", node.op());
+    } else if (node.name() == "y3" && ++count) {
+      EXPECT_EQ("XTimesTwoOther_specialized_for_y3_at_tf_graph", node.op());
+    }
+  }
+  EXPECT_EQ(3, count);
+
+  Tensor pi = test::AsScalar<float>(3.14f);
+  item.fetch = {"z"};
+  item.feed.emplace_back("x", pi);
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -15,20 +15,33 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 
+#include <cstring>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/measuring_cost_estimator.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer_factory.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -379,6 +392,27 @@ Status EraseCancellableNodesAroundPad(TransposeContext* context) {
   return mutation->Apply();
 }
 
+// Converts the layout of the nodes of `context` placed on `target_device` from
+// `src_format` to `dst_format`.
+Status ConvertLayout(absl::string_view target_device,
+                     absl::string_view src_format, absl::string_view dst_format,
+                     bool is_aggressive, TransposeContext* context) {
+  context->AssignDeviceAndDataFormats(target_device, src_format, dst_format);
+
+  TransposerFactory transposer_factory;
+  TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(context, &transposer_factory));
+  if (context->graph.node_size() > context->num_nodes || is_aggressive) {
+    TF_RETURN_IF_ERROR(ExpandLayoutAgnosticOp(context, &transposer_factory));
+    TF_RETURN_IF_ERROR(EraseCancellableNodes(context));
+    TF_RETURN_IF_ERROR(EraseCancellableNodesAroundPad(context));
+    // TODO(lyandy): Remove sorting once other optimizers are migrated to using
+    // `utils::GraphView`.
+    TF_RETURN_IF_ERROR(
+        context->graph_view->SortTopologically(/*ignore_cycles=*/false, {}));
+  }
+  return Status::OK();
+}
+
 Status EraseOutputShapeAttrs(TransposeContext* context) {
   utils::MutableGraphView* graph_view = context->graph_view.get();
   utils::Mutation* mutation = graph_view->GetMutationBuilder();
@@ -390,8 +424,341 @@ Status EraseOutputShapeAttrs(TransposeContext* context) {
   return Status::OK();
 }
 
+// Measures the time of small benchmark graphs on a cluster. The measurements
+// are kept in memory and, if `cache_dir` is not empty, on disk, keyed by a
+// fingerprint of the graph and of the properties of its device.
+class LayoutCostMeasurer {
+ public:
+  LayoutCostMeasurer(Cluster* cluster, const string& cache_dir)
+      : cluster_(cluster), cache_dir_(cache_dir) {}
+
+  // Returns the time in nanoseconds to run the fetch of `item` on `device`, or
+  // -1 if it cannot be measured.
+  int64 Measure(const GrapplerItem& item, const string& device) {
+    DeviceProperties properties;
+    const auto& devices = cluster_->GetDevices();
+    auto device_it = devices.find(device);
+    if (device_it != devices.end()) {
+      properties = device_it->second;
+    }
+    string serialized_graph;
+    string serialized_properties;
+    SerializeToStringDeterministic(item.graph, &serialized_graph);
+    SerializeToStringDeterministic(properties, &serialized_properties);
+    const uint64 key =
+        Hash64Combine(Hash64(serialized_graph), Hash64(serialized_properties));
+    auto it = measurements_.find(key);
+    if (it != measurements_.end()) {
+      return it->second;
+    }
+
+    string path;
+    if (!cache_dir_.empty()) {
+      path = io::JoinPath(
+          cache_dir_,
+          strings::StrCat(strings::Hex(key, strings::kZeroPad16), ".txt"));
+    }
+    int64 time = -1;
+    string cached;
+    if (!path.empty() && ReadFileToString(Env::Default(), path, &cached).ok() &&
+        strings::safe_strto64(cached, &time)) {
+      VLOG(2) << "Read the layout measurement " << path;
+    } else {
+      time = MeasureOnCluster(item);
+      if (time >= 0 && !path.empty()) {
+        StoreMeasurement(path, time);
+      }
+    }
+    measurements_[key] = time;
+    return time;
+  }
+
+ private:
+  int64 MeasureOnCluster(const GrapplerItem& item) {
+    MeasuringCostEstimator estimator(cluster_, kLayoutMeasurementSteps,
+                                     /*measurement_threads=*/0);
+    Costs costs;
+    Status status = estimator.Initialize(item);
+    if (status.ok()) {
+      status = estimator.PredictCosts(item.graph, nullptr, &costs);
+    }
+    if (!status.ok()) {
+      VLOG(1) << "Failed to measure " << item.id << ": " << status;
+      return -1;
+    }
+    return costs.execution_time.count();
+  }
+
+  static void StoreMeasurement(const string& path, int64 time) {
+    // Write to a temporary file first, so that other processes never read a
+    // partial measurement.
+    Env* env = Env::Default();
+    const string tmp_path = absl::StrCat(path, ".tmp", random::New64());
+    Status status = env->RecursivelyCreateDir(string(io::Dirname(path)));
+    if (status.ok()) {
+      status = WriteStringToFile(env, tmp_path, absl::StrCat(time));
+    }
+    if (status.ok()) {
+      status = env->RenameFile(tmp_path, path);
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to cache the layout measurement " << path << ": "
+                   << status;
+      env->DeleteFile(tmp_path).IgnoreError();
+    }
+  }
+
+  static constexpr int kLayoutMeasurementSteps = 10;
+
+  Cluster* cluster_;
+  const string cache_dir_;
+  absl::flat_hash_map<uint64, int64> measurements_;
+};
+
+// Returns the permutation which takes dimensions from `src_format` to
+// `dst_format`.
+std::vector<int> FormatPermutation(absl::string_view src_format,
+                                   absl::string_view dst_format) {
+  std::vector<int> permutation;
+  for (char dim : dst_format) {
+    permutation.push_back(src_format.find(dim));
+  }
+  return permutation;
+}
+
+// Adds a Placeholder named `name` fed with zeros of the given type and shape
+// to `item`. Returns false if the shape is not fully defined.
+bool AddBenchmarkInput(const string& name, DataType dtype,
+                       const TensorShapeProto& shape, const string& device,
+                       GrapplerItem* item) {
+  if (!TensorShape::IsValid(shape) ||
+      !PartialTensorShape(shape).IsFullyDefined() ||
+      !DataTypeCanUseMemcpy(dtype)) {
+    return false;
+  }
+  NodeDef* input = item->graph.add_node();
+  input->set_name(name);
+  input->set_op("Placeholder");
+  input->set_device(device);
+  (*input->mutable_attr())["dtype"].set_type(dtype);
+  *(*input->mutable_attr())["shape"].mutable_shape() = shape;
+
+  Tensor value(dtype, TensorShape(shape));
+  std::memset(const_cast<char*>(value.tensor_data().data()), 0,
+              value.TotalBytes());
+  item->feed.emplace_back(name, value);
+  return true;
+}
+
+// Builds a graph which runs the Conv2D `node` in `data_format`. Returns false
+// if the shapes of its inputs are not fully defined.
+bool MakeConv2DBenchmark(const NodeDef& node,
+                         const std::vector<OpInfo::TensorProperties>& inputs,
+                         const string& device, absl::string_view data_format,
+                         GrapplerItem* item) {
+  const auto* padding = gtl::FindOrNull(node.attr(), "padding");
+  if (inputs.size() != 2 ||
+      (padding != nullptr && padding->s() == "EXPLICIT")) {
+    return false;
+  }
+  const auto* src_format_attr = gtl::FindOrNull(node.attr(), "data_format");
+  const string src_format =
+      src_format_attr == nullptr ? kNHWC : src_format_attr->s();
+  const std::vector<int> permutation =
+      FormatPermutation(src_format, data_format);
+  if (inputs[0].shape().dim_size() != 4 || permutation.size() != 4) {
+    return false;
+  }
+
+  // Convert the input and the attributes to `data_format`.
+  TensorShapeProto input_shape;
+  for (int dim : permutation) {
+    *input_shape.add_dim() = inputs[0].shape().dim(dim);
+  }
+  NodeDef conv = node;
+  conv.set_name("conv");
+  conv.set_device(device);
+  conv.clear_input();
+  conv.add_input("input");
+  conv.add_input("filter");
+  (*conv.mutable_attr())["data_format"].set_s(string(data_format));
+  for (const char* attr_name : {"strides", "dilations"}) {
+    auto* attr = gtl::FindOrNull(*conv.mutable_attr(), attr_name);
+    if (attr == nullptr || attr->list().i_size() != 4) {
+      continue;
+    }
+    const AttrValue src_attr = *attr;
+    for (int i = 0; i < 4; ++i) {
+      attr->mutable_list()->set_i(i, src_attr.list().i(permutation[i]));
+    }
+  }
+
+  item->id = absl::StrCat("Conv2D benchmark of ", node.name());
+  if (!AddBenchmarkInput("input", inputs[0].dtype(), input_shape, device,
+                         item) ||
+      !AddBenchmarkInput("filter", inputs[1].dtype(), inputs[1].shape(),
+                         device, item)) {
+    return false;
+  }
+  *item->graph.add_node() = conv;
+  item->fetch.push_back(conv.name());
+  return true;
+}
+
+// Builds a graph which runs the Transpose `node` added by the layout
+// conversion. Returns false if its output shape is unknown.
+bool MakeTransposeBenchmark(const NodeDef& node, const NodeDef& permutation,
+                            GrapplerItem* item) {
+  const auto* output_shapes = gtl::FindOrNull(node.attr(), kAttrOutputShape);
+  const auto* value = gtl::FindOrNull(permutation.attr(), "value");
+  const auto* dtype = gtl::FindOrNull(node.attr(), "T");
+  Tensor perm;
+  if (output_shapes == nullptr || output_shapes->list().shape_size() != 1 ||
+      value == nullptr || dtype == nullptr ||
+      !perm.FromProto(value->tensor()) || perm.dtype() != DT_INT32 ||
+      perm.NumElements() != output_shapes->list().shape(0).dim_size()) {
+    return false;
+  }
+  const TensorShapeProto& output_shape = output_shapes->list().shape(0);
+  TensorShapeProto input_shape = output_shape;
+  const auto perm_values = perm.flat<int32>();
+  for (int i = 0; i < perm.NumElements(); ++i) {
+    if (perm_values(i) < 0 || perm_values(i) >= output_shape.dim_size()) {
+      return false;
+    }
+    *input_shape.mutable_dim(perm_values(i)) = output_shape.dim(i);
+  }
+
+  item->id = absl::StrCat("Transpose benchmark of ", node.name());
+  if (!AddBenchmarkInput("input", dtype->type(), input_shape, node.device(),
+                         item)) {
+    return false;
+  }
+  NodeDef* perm_node = item->graph.add_node();
+  *perm_node = permutation;
+  perm_node->set_name("perm");
+  perm_node->clear_input();
+  NodeDef* transpose = item->graph.add_node();
+  *transpose = node;
+  transpose->set_name("transpose");
+  transpose->clear_input();
+  transpose->add_input("input");
+  transpose->add_input("perm");
+  transpose->mutable_attr()->erase(kAttrOutputShape);
+  item->fetch.push_back(transpose->name());
+  return true;
+}
+
+// Returns the measured time of the convolutions and of the transposes added by
+// the layout conversion in the graph of `context`, or -1 if some could not be
+// measured.
+int64 MeasureLayoutCost(const TransposeContext& context,
+                        const GrapplerItem& item,
+                        LayoutCostMeasurer* measurer) {
+  absl::flat_hash_map<string, const NodeDef*> original_nodes;
+  for (const NodeDef& node : item.graph.node()) {
+    original_nodes[node.name()] = &node;
+  }
+  absl::flat_hash_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : context.graph.node()) {
+    nodes[node.name()] = &node;
+  }
+
+  int64 total_time = 0;
+  for (const NodeDef& node : context.graph.node()) {
+    GrapplerItem benchmark;
+    auto original_it = original_nodes.find(node.name());
+    const string device = GetDeviceName(context.virtual_placer.get(), node);
+    if (IsConv2D(node) && original_it != original_nodes.end()) {
+      const auto* data_format = gtl::FindOrNull(node.attr(), "data_format");
+      if (!MakeConv2DBenchmark(
+              *original_it->second,
+              context.graph_properties->GetInputProperties(node.name()),
+              device, data_format == nullptr ? kNHWC : data_format->s(),
+              &benchmark)) {
+        return -1;
+      }
+    } else if (IsTranspose(node) && original_it == original_nodes.end()) {
+      auto perm_it = node.input_size() == 2
+                         ? nodes.find(ParseTensorName(node.input(1)).node())
+                         : nodes.end();
+      if (perm_it == nodes.end() ||
+          !MakeTransposeBenchmark(node, *perm_it->second, &benchmark)) {
+        return -1;
+      }
+    } else {
+      continue;
+    }
+    const int64 time = measurer->Measure(benchmark, device);
+    if (time < 0) {
+      return -1;
+    }
+    VLOG(2) << "Measured " << benchmark.id << ": " << time << "ns";
+    total_time += time;
+  }
+  return total_time;
+}
+
 }  // namespace
 
+GenericLayoutOptimizer::GenericLayoutOptimizer(
+    RewriterConfig::Toggle opt_level)
+    : opt_level_(opt_level) {
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_LAYOUT_OPTIMIZER_MEASURE_LAYOUTS",
+                                 /*default_val=*/false, &measure_layouts_));
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_LAYOUT_OPTIMIZER_MEASUREMENT_CACHE_DIR",
+                                   /*default_val=*/"",
+                                   &measurement_cache_dir_));
+}
+
+Status GenericLayoutOptimizer::OptimizeWithMeasuredLayouts(
+    Cluster* cluster, const GrapplerItem& item, GraphDef* output) {
+  const bool is_aggressive = opt_level_ == RewriterConfig::AGGRESSIVE;
+  const char* target_device = GetNumGPUs(*cluster).first > 0 ? kGPU : "CPU";
+  LayoutCostMeasurer measurer(cluster, measurement_cache_dir_);
+
+  // The graph as it is.
+  auto best_context = absl::make_unique<TransposeContext>();
+  TF_RETURN_IF_ERROR(TransposeContext::InitializeTransposeContext(
+      item, cluster, best_context.get()));
+  int64 best_time = MeasureLayoutCost(*best_context, item, &measurer);
+  if (best_time < 0) {
+    return errors::Aborted(
+        "Failed to measure the convolutions in their current layout.");
+  }
+  bool changed = false;
+
+  for (const auto& formats :
+       {std::make_pair(kNHWC, kNCHW), std::make_pair(kNCHW, kNHWC)}) {
+    auto context = absl::make_unique<TransposeContext>();
+    TF_RETURN_IF_ERROR(TransposeContext::InitializeTransposeContext(
+        item, cluster, context.get()));
+    TF_RETURN_IF_ERROR(ConvertLayout(target_device, formats.first,
+                                     formats.second, is_aggressive,
+                                     context.get()));
+    if (context->graph.node_size() == context->num_nodes) {
+      // No node was converted.
+      continue;
+    }
+    const int64 time = MeasureLayoutCost(*context, item, &measurer);
+    VLOG(1) << "Measured layout " << formats.first << "->" << formats.second
+            << " on " << target_device << ": " << time << "ns, best "
+            << best_time << "ns";
+    if (time >= 0 && time < best_time) {
+      best_time = time;
+      best_context = std::move(context);
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return errors::Aborted("The measured layouts are already the fastest.");
+  }
+
+  TF_RETURN_IF_ERROR(EraseOutputShapeAttrs(best_context.get()));
+  *output = best_context->graph;
+  return Status::OK();
+}
+
 Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
                                         const GrapplerItem& item,
                                         GraphDef* output) {
@@ -400,6 +767,10 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
         << "generic layout optimizer was called with cluster == nullptr";
     return errors::Aborted("cluster == nullptr.");
   }
+  if (measure_layouts_) {
+    return OptimizeWithMeasuredLayouts(cluster, item, output);
+  }
+
   const auto num_gpus_and_num_volta = GetNumGPUs(*cluster);
   const int num_gpus = num_gpus_and_num_volta.first;
   if (num_gpus < 1) {
@@ -416,20 +787,9 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
 
   const auto src_dst_formats =
       GetSrcAndDstDataFormats(context, num_gpus, num_gpus_and_num_volta.second);
-  context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
-                                     src_dst_formats.second);
-
-  TransposerFactory transposer_factory;
-  TF_RETURN_IF_ERROR(ExpandLayoutSensitiveOp(&context, &transposer_factory));
-  if (context.graph.node_size() > context.num_nodes || is_aggressive) {
-    TF_RETURN_IF_ERROR(ExpandLayoutAgnosticOp(&context, &transposer_factory));
-    TF_RETURN_IF_ERROR(EraseCancellableNodes(&context));
-    TF_RETURN_IF_ERROR(EraseCancellableNodesAroundPad(&context));
-    // TODO(lyandy): Remove sorting once other optimizers are migrated to using
-    // `utils::GraphView`.
-    TF_RETURN_IF_ERROR(
-        context.graph_view->SortTopologically(/*ignore_cycles=*/false, {}));
-  }
+  TF_RETURN_IF_ERROR(ConvertLayout(kGPU, src_dst_formats.first,
+                                   src_dst_formats.second, is_aggressive,
+                                   &context));
   TF_RETURN_IF_ERROR(EraseOutputShapeAttrs(&context));
 
   *output = context.graph;
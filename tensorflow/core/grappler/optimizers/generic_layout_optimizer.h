@@ -26,8 +26,21 @@ namespace grappler {
 class GenericLayoutOptimizer : public GraphOptimizer {
  public:
   GenericLayoutOptimizer() : GenericLayoutOptimizer(RewriterConfig::DEFAULT) {}
-  explicit GenericLayoutOptimizer(RewriterConfig::Toggle opt_level)
-      : opt_level_(opt_level) {}
+  // Measures the layouts if the TF_LAYOUT_OPTIMIZER_MEASURE_LAYOUTS
+  // environment variable is set, caching the measurements in
+  // TF_LAYOUT_OPTIMIZER_MEASUREMENT_CACHE_DIR.
+  explicit GenericLayoutOptimizer(RewriterConfig::Toggle opt_level);
+  // If `measure_layouts` is true, the data format of the convolutions is
+  // chosen by running each convolution and the transposes the conversion
+  // inserts in both formats on the cluster, instead of by the GPU heuristics.
+  // This also converts the layout of graphs without GPUs. The measurements are
+  // cached on disk in `measurement_cache_dir`, if it is not empty.
+  GenericLayoutOptimizer(RewriterConfig::Toggle opt_level,
+                         bool measure_layouts,
+                         const string& measurement_cache_dir)
+      : opt_level_(opt_level),
+        measure_layouts_(measure_layouts),
+        measurement_cache_dir_(measurement_cache_dir) {}
   ~GenericLayoutOptimizer() override = default;
 
   string name() const override { return "layout"; };
@@ -41,7 +54,14 @@ class GenericLayoutOptimizer : public GraphOptimizer {
                 const GraphDef& optimize_output, double result) override;
 
  private:
+  // Converts the layout of the graph to the data format whose measured time,
+  // including the inserted transposes, is the lowest.
+  Status OptimizeWithMeasuredLayouts(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* output);
+
   RewriterConfig::Toggle opt_level_;
+  bool measure_layouts_;
+  string measurement_cache_dir_;
 };
 
 }  // namespace grappler
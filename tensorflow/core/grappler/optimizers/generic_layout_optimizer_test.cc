@@ -32,6 +32,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/graph_view.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -244,6 +246,39 @@ TEST_F(GenericLayoutOptimizerTest, PreserveFetch) {
   VerifyDataFormatAttributeMatch(conv_node, "NHWC");
 }
 
+TEST_F(GenericLayoutOptimizerTest, MeasuredLayouts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 4, 2, "VALID", "");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  item.fetch.push_back("Fetch");
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "generic_layout_optimizer_measurements");
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   /*measure_layouts=*/true, cache_dir);
+  GraphDef output;
+  Status status = optimizer.Optimize(virtual_cluster_.get(), item, &output);
+  ASSERT_TRUE(status.ok() || errors::IsAborted(status)) << status;
+
+  // The measurements are cached on disk.
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(cache_dir, &children));
+  EXPECT_FALSE(children.empty());
+
+  // A new optimizer reuses them and picks the same layout.
+  GenericLayoutOptimizer cached_optimizer(RewriterConfig::DEFAULT,
+                                          /*measure_layouts=*/true, cache_dir);
+  GraphDef cached_output;
+  Status cached_status =
+      cached_optimizer.Optimize(virtual_cluster_.get(), item, &cached_output);
+  EXPECT_EQ(status.code(), cached_status.code());
+  if (status.ok()) {
+    CompareGraphs(output, cached_output);
+  }
+}
+
 TEST_F(GenericLayoutOptimizerTest, EmptyDevice) {
 #if !GOOGLE_CUDA
   GTEST_SKIP() << "CUDA is not enabled";
@@ -792,6 +792,12 @@ Status BuildSwapPair(NodeDef* node, int input_to_swap,
   return Status::OK();
 }
 
+// Estimates the time to copy a tensor between the device and the host.
+Costs::NanoSeconds EstimateSwapTime(int64 bytes) {
+  // Let's assume we're going to swap over PCIe running at 16 GBps.
+  return Costs::NanoSeconds(bytes / 16);
+}
+
 struct SwapInfo {
   std::vector<int> inputs_to_swap;
   Costs::NanoSeconds time_to_swap = 0;
@@ -972,8 +978,13 @@ struct MemInfo {
   bool operator<(const MemInfo& other) const { return fitness < other.fitness; }
 };
 
+// Chooses tensors to swap out of the memory of each GPU around its peak memory
+// usage. If `swap_memory_limit` is positive, the peak memory usage is brought
+// under it, instead of under the memory size of the device, and only tensors
+// whose transfers can complete before the peak and start after it are swapped.
 static bool IdentifySwappingCandidates(
-    Cluster* cluster, GrapplerItem* item, std::unordered_set<string>* skip_list,
+    Cluster* cluster, GrapplerItem* item, int64 swap_memory_limit,
+    std::unordered_set<string>* skip_list,
     std::unordered_map<NodeDef*, SwapInfo>* nodes_to_swap) {
   GraphMemory memory(*item);
   const std::unordered_map<string, DeviceProperties>& devices =
@@ -991,16 +1002,21 @@ static bool IdentifySwappingCandidates(
     if (prop.type() != "GPU") {
       continue;
     }
-    if (prop.memory_size() <= 0) {
+    int64 memory_limit = prop.memory_size();
+    if (swap_memory_limit > 0 &&
+        (memory_limit <= 0 || swap_memory_limit < memory_limit)) {
+      memory_limit = swap_memory_limit;
+    }
+    if (memory_limit <= 0) {
       VLOG(1) << "Peak memory usage unknown for device " << name;
       continue;
     }
     const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
 
-    if (mem_usage.used_memory <= prop.memory_size()) {
+    if (mem_usage.used_memory <= memory_limit) {
       continue;
     }
-    int64 required_savings = mem_usage.used_memory - prop.memory_size();
+    int64 required_savings = mem_usage.used_memory - memory_limit;
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
     {
@@ -1043,8 +1059,17 @@ static bool IdentifySwappingCandidates(
         // Don't bother with small tensors.
         continue;
       }
-      if (live_tensor.deallocation_time - live_tensor.allocation_time <=
-          Costs::Duration(1e6)) {
+      const Costs::Duration swap_time =
+          EstimateSwapTime(live_tensor.memory_used);
+      if (swap_memory_limit > 0) {
+        // The tensor must be fully swapped out by the time of the peak.
+        if (peak_time - live_tensor.allocation_time < swap_time) {
+          VLOG(1) << "Not enough time to swap out: skipping "
+                  << live_tensor.node;
+          continue;
+        }
+      } else if (live_tensor.deallocation_time - live_tensor.allocation_time <=
+                 Costs::Duration(1e6)) {
         // Not enough time to swap.
         VLOG(1) << "Not enough time to swap: skipping " << live_tensor.node;
         continue;
@@ -1094,6 +1119,11 @@ static bool IdentifySwappingCandidates(
         mem_info.uses_left.emplace_back(input);
         earliest_use = std::min(earliest_use, it->second);
       }
+      if (swap_memory_limit > 0 && earliest_use - peak_time < swap_time) {
+        // The tensor would have to be swapped back in before the peak.
+        VLOG(1) << "Not enough time to swap in: skipping " << live_tensor.node;
+        valid = false;
+      }
       if (valid && !mem_info.uses_left.empty()) {
         // Compute the fitness: we need the tensor to be generated way away of
         // the time of peak memory usage (to ensure there is enough time to swap
@@ -1138,14 +1168,15 @@ static bool IdentifySwappingCandidates(
 }
 
 bool SwappingPass(RewriterConfig::MemOptType optimization_level,
-                  Cluster* cluster, GrapplerItem* item,
+                  int64 swap_memory_limit, Cluster* cluster, GrapplerItem* item,
                   std::unordered_set<string>* skip_list) {
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
       optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
       optimization_level == RewriterConfig::HEURISTICS) {
     // Use heuristics to figure out what needs to be swapped;
-    IdentifySwappingCandidates(cluster, item, skip_list, &nodes_to_swap);
+    IdentifySwappingCandidates(cluster, item, swap_memory_limit, skip_list,
+                               &nodes_to_swap);
   }
   // Look for manual annotatations in the graph.
   for (auto& node : *item->graph.mutable_node()) {
@@ -1186,8 +1217,7 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
       const OpInfo::TensorProperties& t = props[input_id];
       bytes_to_swap += CalculateTensorSize(t);
     }
-    // Let's assume we're going to swap over PCIe running at 16 GBps.
-    swap_info.time_to_swap = bytes_to_swap / 16;
+    swap_info.time_to_swap = EstimateSwapTime(bytes_to_swap);
   }
 
   std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
@@ -1413,8 +1443,9 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
            optimization_level_ == RewriterConfig::HEURISTICS ||
            optimization_level_ == RewriterConfig::MANUAL) &&
           cluster != nullptr) {
-        updated_graph |= SwappingPass(optimization_level_, cluster,
-                                      &optimized_item, &skip_list);
+        updated_graph |=
+            SwappingPass(optimization_level_, swap_memory_limit_, cluster,
+                         &optimized_item, &skip_list);
       }
     }
   }
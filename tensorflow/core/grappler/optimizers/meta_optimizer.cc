@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <list>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -25,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
@@ -50,7 +55,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
 
@@ -160,6 +169,113 @@ bool MemoryOptimizerEnabled(
   return mem_opt_type != RewriterConfig::NO_MEM_OPT;
 }
 
+// A process wide cache of optimized graphs, which evicts the least recently
+// used graph when it is full.
+class OptimizedGraphCache {
+ public:
+  static OptimizedGraphCache* Global() {
+    static OptimizedGraphCache* cache = new OptimizedGraphCache();
+    return cache;
+  }
+
+  // Copies the graph cached under `key` to `graph`. Returns false if there is
+  // none.
+  bool Lookup(const Fprint128& key, GraphDef* graph) {
+    std::shared_ptr<const GraphDef> cached;
+    {
+      mutex_lock lock(mu_);
+      auto it = index_.find(key);
+      if (it == index_.end()) return false;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      cached = it->second->second;
+    }
+    *graph = *cached;
+    return true;
+  }
+
+  // Caches `graph` under `key`, keeping at most `capacity` graphs.
+  void Insert(const Fprint128& key, const GraphDef& graph, int capacity) {
+    auto cached = std::make_shared<const GraphDef>(graph);
+    mutex_lock lock(mu_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+    entries_.emplace_front(key, std::move(cached));
+    index_[key] = entries_.begin();
+    while (static_cast<int>(entries_.size()) > capacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  using Entry = std::pair<Fprint128, std::shared_ptr<const GraphDef>>;
+
+  mutex mu_;
+  // Most recently used first.
+  std::list<Entry> entries_ GUARDED_BY(mu_);
+  absl::flat_hash_map<Fprint128, std::list<Entry>::iterator, Fprint128Hasher>
+      index_ GUARDED_BY(mu_);
+};
+
+// Computes the key of `item` in the optimized graph cache, which covers
+// everything the optimizers look at: the graph, the nodes to preserve, the
+// config and the devices. Returns false if the item can't be serialized.
+bool OptimizedGraphCacheKey(const GrapplerItem& item, const ConfigProto& cfg,
+                            const Cluster* cluster, Fprint128* key) {
+  string serialized;
+  if (!SerializeToStringDeterministic(item.graph, &serialized)) return false;
+  string buffer;
+  if (!SerializeToStringDeterministic(cfg, &buffer)) return false;
+  absl::StrAppend(&serialized, buffer);
+
+  absl::StrAppend(&serialized, ";id=", item.id, ";fetch=",
+                  absl::StrJoin(item.fetch, ","), ";init_ops=",
+                  absl::StrJoin(item.init_ops, ","), ";keep_ops=",
+                  absl::StrJoin(item.keep_ops, ","), ";save_op=", item.save_op,
+                  ";restore_op=", item.restore_op, ";save_restore_loc_tensor=",
+                  item.save_restore_loc_tensor);
+  for (const auto& feed : item.feed) {
+    absl::StrAppend(&serialized, ";feed=", feed.first, ":",
+                    DataTypeString(feed.second.dtype()),
+                    feed.second.shape().DebugString());
+  }
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    if (!SerializeToStringDeterministic(queue_runner, &buffer)) return false;
+    absl::StrAppend(&serialized, ";queue_runner=", buffer);
+  }
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  absl::StrAppend(&serialized, ";allow_non_differentiable_rewrites=",
+                  options.allow_non_differentiable_rewrites,
+                  ";allow_pruning_stateful_and_dataset_ops=",
+                  options.allow_pruning_stateful_and_dataset_ops,
+                  ";optimize_function_library=",
+                  options.optimize_function_library,
+                  ";is_eager_mode=", options.is_eager_mode);
+
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  std::sort(devices.begin(), devices.end());
+  absl::StrAppend(&serialized, ";devices=", absl::StrJoin(devices, ","));
+  if (cluster != nullptr) {
+    std::map<string, DeviceProperties> cluster_devices(
+        cluster->GetDevices().begin(), cluster->GetDevices().end());
+    for (const auto& device : cluster_devices) {
+      if (!SerializeToStringDeterministic(device.second, &buffer)) {
+        return false;
+      }
+      absl::StrAppend(&serialized, ";cluster_device=", device.first, "=",
+                      buffer);
+    }
+  }
+
+  *key = Fingerprint128(serialized);
+  return true;
+}
+
 }  // namespace
 
 #define MK_OPT(NAME, VALUE) \
@@ -264,11 +380,14 @@ Status MetaOptimizer::InitializeOptimizers(
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
       optimizers->push_back(
           // Use the default target node name prefix "gradients/"
-          MakeUnique<MemoryOptimizer>(cfg_.memory_optimization()));
+          MakeUnique<MemoryOptimizer>(
+              cfg_.memory_optimization(), "gradients/",
+              cfg_.memory_optimizer_swap_memory_limit_bytes()));
     } else {
       optimizers->push_back(MakeUnique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_swap_memory_limit_bytes()));
     }
   }
   if (cfg_.auto_parallel().enable()) {
@@ -419,6 +538,19 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
   GrapplerItem optimized_item = item;
   optimized_graph->Swap(&optimized_item.graph);
 
+  // Share the inferred shapes of the nodes which no optimizer changed between
+  // the optimizers and iterations.
+  if (optimized_item.graph_properties_cache == nullptr) {
+    bool incremental_shape_inference = false;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_GRAPPLER_INCREMENTAL_SHAPE_INFERENCE",
+                                   /*default_val=*/false,
+                                   &incremental_shape_inference));
+    if (incremental_shape_inference) {
+      optimized_item.graph_properties_cache =
+          std::make_shared<GraphPropertiesCache>();
+    }
+  }
+
   GraphOptimizationResult optimization_result(item.id);
   GraphOptimizer* sa_optimizer = nullptr;
 
@@ -445,8 +577,18 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
           *optimized_graph);
     }
 
-    for (const auto& optimizer : optimizers) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    for (auto it = optimizers.begin(); it != optimizers.end(); ++it) {
+      const auto& optimizer = *it;
+      if (DeadlineExceeded()) {
+        // Record which optimizers the timeout skips.
+        for (; it != optimizers.end(); ++it) {
+          RecordSkippedOptimizer((*it)->name(), iteration,
+                                 "meta optimizer deadline exceeded",
+                                 &optimization_result);
+        }
+        optimization_results_.push_back(optimization_result);
+        return errors::DeadlineExceeded(name(), " exceeded deadline.");
+      }
       // Some optimizers can run only once.
       if (iteration > 0 && IsRunOnceOptimizer(optimizer->name())) continue;
       // Some must run only on the last iteration.
@@ -454,9 +596,18 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
         if (sa_optimizer == nullptr) sa_optimizer = optimizer.get();
         continue;
       }
+      const int64 budget_us = OptimizerTimeBudgetUsec(optimizer->name());
+      if (budget_us >= 0 &&
+          optimization_result.optimizer_time_us[optimizer->name()] >=
+              budget_us) {
+        RecordSkippedOptimizer(optimizer->name(), iteration,
+                               "time budget exhausted", &optimization_result);
+        continue;
+      }
 
       TF_RETURN_IF_ERROR(RunOptimizer(optimizer.get(), cluster, &optimized_item,
-                                      optimized_graph, &optimization_result));
+                                      optimized_graph, iteration,
+                                      &optimization_result));
 
       if (iteration == 0 && optimizer->name() == "model_pruner") {
         CompressConstants(optimized_graph);
@@ -489,7 +640,8 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
   // ScopedAllocatorOptimizer must run last.
   if (sa_optimizer != nullptr) {
     TF_RETURN_IF_ERROR(RunOptimizer(sa_optimizer, cluster, &optimized_item,
-                                    optimized_graph, &optimization_result));
+                                    optimized_graph, NumIterations(cfg_) - 1,
+                                    &optimization_result));
     GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
   }
 
@@ -513,11 +665,46 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
   return Status::OK();
 }
 
+int64 MetaOptimizer::OptimizerTimeBudgetUsec(
+    const string& optimizer_name) const {
+  const auto& budgets = cfg_.optimizer_timeout_ms();
+  auto it = budgets.find(optimizer_name);
+  return it == budgets.end() || it->second < 0 ? -1 : it->second * 1000;
+}
+
+void MetaOptimizer::RecordSkippedOptimizer(
+    const string& optimizer_name, int iteration, const string& reason,
+    GraphOptimizationResult* optimization_result) {
+  VLOG(1) << optimizer_name << " skipped in iteration " << iteration << ": "
+          << reason;
+  OptimizerResult optimizer_result;
+  optimizer_result.optimizer_name = optimizer_name;
+  optimizer_result.message = strings::StrCat("skipped: ", reason);
+  optimizer_result.iteration = iteration;
+  optimizer_result.skip_reason = reason;
+  optimization_result->results.push_back(optimizer_result);
+}
+
 Status MetaOptimizer::RunOptimizer(
     GraphOptimizer* optimizer, Cluster* cluster, GrapplerItem* optimized_item,
-    GraphDef* optimized_graph, GraphOptimizationResult* optimization_result) {
+    GraphDef* optimized_graph, int iteration,
+    GraphOptimizationResult* optimization_result) {
   const uint64 start_us = Env::Default()->NowMicros();
 
+  // Stop the optimizer at the end of its time budget, if that comes before
+  // the deadline of the meta optimizer.
+  int64& time_us = optimization_result->optimizer_time_us[optimizer->name()];
+  const int64 budget_us = OptimizerTimeBudgetUsec(optimizer->name());
+  uint64 deadline_usec = this->deadline_usec();
+  bool has_budget_deadline = false;
+  if (budget_us >= 0) {
+    const uint64 budget_deadline_usec = start_us + budget_us - time_us;
+    if (deadline_usec == 0 || budget_deadline_usec < deadline_usec) {
+      deadline_usec = budget_deadline_usec;
+      has_budget_deadline = true;
+    }
+  }
+
   // If optimizer doesn't need a function library, we will replace it with a
   // stub before running optimization, and will put it back at the end.
   FunctionDefLibrary optimized_graph_function_library;
@@ -535,12 +722,18 @@ Status MetaOptimizer::RunOptimizer(
   // resets optimized_graph to an empty graph.
   optimized_graph->Swap(&optimized_item->graph);
   *optimized_graph = GraphDef();
-  optimizer->set_deadline_usec(this->deadline_usec());
+  optimizer->set_deadline_usec(deadline_usec);
   Status status =
       optimizer->Optimize(cluster, *optimized_item, optimized_graph);
   const uint64 end_us = Env::Default()->NowMicros();
   const float duration_ms = (end_us - start_us) / 1000.0f;
   metrics::UpdateGrapplerPassTime(optimizer->name(), end_us - start_us);
+  time_us += end_us - start_us;
+
+  OptimizerResult optimizer_result;
+  optimizer_result.optimizer_name = optimizer->name();
+  optimizer_result.iteration = iteration;
+  optimizer_result.duration_us = end_us - start_us;
 
   string message;
   if (!status.ok()) {
@@ -552,15 +745,30 @@ Status MetaOptimizer::RunOptimizer(
                                 " did nothing. time = ", duration_ms, "ms.");
       // Swallow the non-critical error.
       status = Status::OK();
+    } else if (errors::IsDeadlineExceeded(status) && has_budget_deadline) {
+      // Running out of its own budget only drops the changes of the
+      // optimizer.
+      optimizer_result.skip_reason = "time budget exceeded";
+      message = strings::StrCat(optimizer->name(),
+                                " exceeded its time budget of ", budget_us,
+                                "us, time = ", duration_ms, "ms.");
+      LOG(WARNING) << message;
+      status = Status::OK();
     } else if (errors::IsDeadlineExceeded(status)) {
+      optimizer_result.skip_reason = "meta optimizer deadline exceeded";
       message =
           strings::StrCat(status.ToString(), ", time = ", duration_ms, "ms.");
       LOG(WARNING) << optimizer->name() << " failed: " << message;
     } else {
+      optimizer_result.skip_reason = status.ToString();
       message = status.ToString();
       LOG(ERROR) << optimizer->name() << " failed: " << message;
     }
   } else {
+    optimizer_result.num_nodes_delta =
+        optimized_graph->node_size() - optimized_item->graph.node_size();
+    optimizer_result.num_edges_delta =
+        NumEdges(*optimized_graph) - NumEdges(optimized_item->graph);
     message = strings::StrCat(
         PrintSizesBeforeAfter(optimized_item->graph, *optimized_graph),
         ", time = ", duration_ms, "ms.");
@@ -572,7 +780,8 @@ Status MetaOptimizer::RunOptimizer(
     optimized_graph->mutable_library()->Swap(&optimized_graph_function_library);
   }
 
-  OptimizerResult optimizer_result{optimizer->name(), message, status};
+  optimizer_result.message = message;
+  optimizer_result.status = status;
   optimization_result->results.push_back(optimizer_result);
 
   if (!status.ok() && cfg_.fail_on_optimizer_errors()) return status;
@@ -582,6 +791,30 @@ Status MetaOptimizer::RunOptimizer(
 
 Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                GraphDef* optimized_graph) {
+  const int cache_size = cfg_.meta_optimizer_graph_cache_size();
+  Fprint128 cache_key;
+  const bool use_cache =
+      cache_size > 0 &&
+      OptimizedGraphCacheKey(item, config_proto_, cluster, &cache_key);
+  if (use_cache &&
+      OptimizedGraphCache::Global()->Lookup(cache_key, optimized_graph)) {
+    VLOG(1) << "Reusing the cached optimized graph for grappler item: "
+            << item.id;
+    optimization_results_.clear();
+    return Status::OK();
+  }
+
+  TF_RETURN_IF_ERROR(OptimizeMainGraphAndFunctions(cluster, item,
+                                                   optimized_graph));
+  if (use_cache) {
+    OptimizedGraphCache::Global()->Insert(cache_key, *optimized_graph,
+                                          cache_size);
+  }
+  return Status::OK();
+}
+
+Status MetaOptimizer::OptimizeMainGraphAndFunctions(
+    Cluster* cluster, const GrapplerItem& item, GraphDef* optimized_graph) {
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
   optimization_results_.clear();
 
@@ -818,6 +1051,22 @@ void MetaOptimizer::PrintResult() {
   }
 }
 
+string MetaOptimizer::GetResultTable() const {
+  string table = absl::StrFormat("%-20s %4s %-32s %10s %8s %8s  %s\n", "item",
+                                 "iter", "optimizer", "time (ms)", "nodes",
+                                 "edges", "skip reason");
+  for (const GraphOptimizationResult& graph_result : optimization_results_) {
+    for (const OptimizerResult& result : graph_result.results) {
+      absl::StrAppendFormat(
+          &table, "%-20s %4d %-32s %10.3f %+8d %+8d  %s\n", graph_result.id,
+          result.iteration, result.optimizer_name,
+          result.duration_us / 1000.0, result.num_nodes_delta,
+          result.num_edges_delta, result.skip_reason);
+    }
+  }
+  return table;
+}
+
 void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
                              const GraphDef& optimized_graph, double result) {
   // Nothing to do for MetaOptimizer.
@@ -853,7 +1102,16 @@ Status RunMetaOptimizer(const GrapplerItem& item, const ConfigProto& cfg,
   MetaOptimizer optimizer(cpu_device, cfg);
   optimizer.set_deadline_usec(
       DeadlineMicroSeconds(cfg.graph_options().rewrite_options()));
-  return optimizer.Optimize(cluster, item, optimized_graph);
+  Status status = optimizer.Optimize(cluster, item, optimized_graph);
+  if (errors::IsDeadlineExceeded(status)) {
+    // Show which optimizers used up the time.
+    LOG(WARNING) << "Grappler timed out optimizing " << item.id << ":\n"
+                 << optimizer.GetResultTable();
+  } else if (VLOG_IS_ON(1)) {
+    VLOG(1) << "Grappler results for " << item.id << ":\n"
+            << optimizer.GetResultTable();
+  }
+  return status;
 }
 
 Status OptimizeGraph(
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 
+#include <unordered_map>
+
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
@@ -46,6 +48,11 @@ class MetaOptimizer : public GraphOptimizer {
 
   void PrintResult();
 
+  // Returns the results of the last Optimize call as a table, with one row per
+  // optimizer run or skip: the wall time, the node and edge deltas, and the
+  // reason the optimizer was skipped or failed.
+  string GetResultTable() const;
+
   void Feedback(Cluster* cluster, const GrapplerItem& item,
                 const GraphDef& optimized_graph, double result) override;
 
@@ -75,6 +82,12 @@ class MetaOptimizer : public GraphOptimizer {
       std::vector<std::unique_ptr<GraphVerifier>>* post_optimization_verifiers)
       const;
 
+  // Optimizes the main graph of `item`, then the functions of its library.
+  // Optimize() calls this unless the result is in the optimized graph cache.
+  Status OptimizeMainGraphAndFunctions(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph);
+
   // Run optimization pass over a single GrapplerItem. Meta optimizer might run
   // multiple such passes: 1) for the main graph 2) for the function library
   Status OptimizeGraph(Cluster* cluster, const GrapplerItem& item,
@@ -88,18 +101,37 @@ class MetaOptimizer : public GraphOptimizer {
     string optimizer_name;
     string message;
     Status status;
+    int iteration = 0;
+    int64 duration_us = 0;
+    int64 num_nodes_delta = 0;
+    int64 num_edges_delta = 0;
+    // Why the optimizer did not run, or why its changes were dropped. Empty
+    // if it ran to completion.
+    string skip_reason;
   };
 
   struct GraphOptimizationResult {
     explicit GraphOptimizationResult(const string& id) : id(id) {}
     string id;
     std::vector<OptimizerResult> results;
+    // The time spent by each optimizer over all the iterations.
+    std::unordered_map<string, int64> optimizer_time_us;
   };
 
+  // Returns the time budget of an optimizer in microseconds, or -1 if it has
+  // none.
+  int64 OptimizerTimeBudgetUsec(const string& optimizer_name) const;
+
   Status RunOptimizer(GraphOptimizer* optimizer, Cluster* cluster,
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
+                      int iteration,
                       GraphOptimizationResult* optimization_result);
 
+  // Records that an optimizer was skipped in the given iteration.
+  static void RecordSkippedOptimizer(
+      const string& optimizer_name, int iteration, const string& reason,
+      GraphOptimizationResult* optimization_result);
+
   std::vector<GraphOptimizationResult> optimization_results_;
 };
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <cmath>
+
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 
@@ -46,6 +49,7 @@ namespace grappler {
 //
 // MatMul + ... -> _FusedMatMul:
 //   (1) MatMul + BiasAdd + <Activation>
+//   (2) MatMul + BiasAdd + Gelu, where Gelu is expressed in primitive ops
 //
 // FusedBatchNorm[$is_training] + ... -> _FusedBatchNormEx[$is_training]
 //   (1) FusedBatchNorm + <Activation>
@@ -160,6 +164,20 @@ struct ContractionWithBatchNormAndActivation {
   float epsilon = 0.0;
 };
 
+// Contraction node followed by a BiasAdd and a Gelu expressed in primitive
+// ops, either exactly with Erf or approximately with Tanh.
+struct ContractionWithBiasAddAndGelu {
+  ContractionWithBiasAddAndGelu() = default;
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  // The node computing the Gelu output, and all the other nodes of the Gelu
+  // except for constants.
+  int gelu = kMissingIndex;
+  std::vector<int> gelu_nodes;
+  bool approximate = false;
+};
+
 #ifdef INTEL_MKL
 // Contraction node followed by a BiasAdd and Add.
 struct ContractionWithBiasAddAndAdd {
@@ -315,6 +333,10 @@ bool IsGpuCompatible(const RemapperContext& ctx,
                      const ContractionWithSqueezeAndBiasAdd& matched) {
   return false;
 }
+bool IsGpuCompatible(const RemapperContext& ctx,
+                     const ContractionWithBiasAddAndGelu& matched) {
+  return false;
+}
 
 // Returns true if the given pattern is supported on the assigned device.
 template <typename Pattern>
@@ -422,6 +444,256 @@ bool FindContractionWithBiasAndActivation(
   return true;
 }
 
+// Returns true if `node` is a float constant with a single element equal to
+// `value`, up to the rounding of constants written with fewer digits.
+bool IsConstantWithValue(const NodeDef& node, float value) {
+  if (!IsConstant(node) || !HasDataType(&node, DT_FLOAT, "dtype")) return false;
+  const auto* value_attr = gtl::FindOrNull(node.attr(), "value");
+  Tensor tensor;
+  if (value_attr == nullptr || !tensor.FromProto(value_attr->tensor()) ||
+      tensor.NumElements() != 1)
+    return false;
+  return std::abs(tensor.flat<float>()(0) - value) <= 1e-4f * std::abs(value);
+}
+
+// Matches a Gelu written in primitive ops, as in Keras and BERT:
+//   exact:       0.5 * x * (1 + erf(x / sqrt(2)))
+//   approximate: 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+// Products may be nested in any order, and x^3 may be a Pow or a product.
+class GeluMatcher {
+ public:
+  explicit GeluMatcher(const RemapperContext& ctx) : ctx_(ctx) {}
+
+  // Matches a Gelu computed by `node_index`. On success `x` is the index of
+  // the Gelu input, and `nodes` holds the other nodes of the Gelu except for
+  // constants.
+  bool Match(int node_index, int* x, bool* approximate) {
+    std::vector<int> factors;
+    if (!MatchProduct(node_index, &factors) || factors.size() != 3) {
+      return false;
+    }
+    // One of the factors is 0.5 and one is 1 + erf(...) or 1 + tanh(...), so
+    // the third one is x.
+    int half = kMissingIndex;
+    int one_plus = kMissingIndex;
+    int inner = kMissingIndex;
+    for (int factor : factors) {
+      if (half == kMissingIndex && IsConstantWithValue(node(factor), 0.5f)) {
+        half = factor;
+      } else if (one_plus == kMissingIndex && MatchOnePlus(factor, &inner)) {
+        one_plus = factor;
+      } else {
+        x_ = factor;
+      }
+    }
+    if (half == kMissingIndex || one_plus == kMissingIndex ||
+        x_ == kMissingIndex || !AddNode(one_plus) || !AddNode(inner)) {
+      return false;
+    }
+
+    const NodeDef& inner_def = node(inner);
+    if (IsErf(inner_def)) {
+      *approximate = false;
+      if (!MatchErfArgument(RegularFanin(inner, 0))) return false;
+    } else if (IsTanh(inner_def)) {
+      *approximate = true;
+      if (!MatchTanhArgument(RegularFanin(inner, 0))) return false;
+    } else {
+      return false;
+    }
+
+    // The Gelu must be the only user of x and of its intermediate values.
+    absl::flat_hash_set<int> gelu_nodes(nodes_.begin(), nodes_.end());
+    gelu_nodes.insert(node_index);
+    for (int index : nodes_) {
+      if (!HasOnlyFanoutsIn(index, gelu_nodes)) return false;
+    }
+    if (!HasOnlyFanoutsIn(x_, gelu_nodes)) return false;
+
+    *x = x_;
+    return true;
+  }
+
+  const std::vector<int>& nodes() const { return nodes_; }
+
+ private:
+  const NodeDef& node(int index) const {
+    return *ctx_.graph_view.GetNode(index)->node();
+  }
+
+  int RegularFanin(int index, int port) const {
+    const auto* node_view = ctx_.graph_view.GetNode(index);
+    if (node_view->NumRegularFanins() <= port) return kMissingIndex;
+    return node_view->GetRegularFanin(port).node_view()->node_index();
+  }
+
+  bool HasOnlyFanoutsIn(int index,
+                        const absl::flat_hash_set<int>& nodes) const {
+    const auto* node_view = ctx_.graph_view.GetNode(index);
+    for (const auto& fanouts : node_view->GetRegularFanouts()) {
+      for (const auto& fanout : fanouts) {
+        if (!nodes.contains(fanout.node_view()->node_index())) return false;
+      }
+    }
+    return true;
+  }
+
+  // Records an intermediate node of the Gelu, which will be removed.
+  bool AddNode(int index) {
+    const auto* node_view = ctx_.graph_view.GetNode(index);
+    const NodeDef* node_def = node_view->node();
+    if (HasControlFaninOrFanout(*node_view) ||
+        IsInPreserveSet(ctx_, node_def) || !HasDataType(node_def, DT_FLOAT)) {
+      return false;
+    }
+    nodes_.push_back(index);
+    return true;
+  }
+
+  // Collects the factors of the product of nested Muls computed by
+  // `node_index`, recording the Muls.
+  bool MatchProduct(int node_index, std::vector<int>* factors) {
+    if (node_index == kMissingIndex || !IsMul(node(node_index))) return false;
+    for (int port = 0; port < 2; ++port) {
+      const int fanin = RegularFanin(node_index, port);
+      if (fanin == kMissingIndex) return false;
+      if (IsMul(node(fanin))) {
+        if (!AddNode(fanin) || !MatchProduct(fanin, factors)) return false;
+      } else {
+        factors->push_back(fanin);
+      }
+    }
+    return factors->size() <= 4;
+  }
+
+  // Matches 1 + y, and returns the index of y.
+  bool MatchOnePlus(int node_index, int* y) {
+    if (!IsAdd(node(node_index))) return false;
+    const int lhs = RegularFanin(node_index, 0);
+    const int rhs = RegularFanin(node_index, 1);
+    if (lhs == kMissingIndex || rhs == kMissingIndex) return false;
+    if (IsConstantWithValue(node(lhs), 1.0f)) {
+      *y = rhs;
+      return true;
+    }
+    if (IsConstantWithValue(node(rhs), 1.0f)) {
+      *y = lhs;
+      return true;
+    }
+    return false;
+  }
+
+  // Matches x * c, c * x or x / (1 / c), including nested products.
+  bool MatchScaledX(int node_index, float c) {
+    if (node_index == kMissingIndex) return false;
+    if (IsRealDiv(node(node_index))) {
+      return RegularFanin(node_index, 0) == x_ &&
+             IsConstantWithValue(node(RegularFanin(node_index, 1)), 1.0f / c) &&
+             AddNode(node_index);
+    }
+    std::vector<int> factors;
+    if (!AddNode(node_index) || !MatchProduct(node_index, &factors) ||
+        factors.size() != 2) {
+      return false;
+    }
+    return (factors[0] == x_ && IsConstantWithValue(node(factors[1]), c)) ||
+           (factors[1] == x_ && IsConstantWithValue(node(factors[0]), c));
+  }
+
+  // Matches x / sqrt(2).
+  bool MatchErfArgument(int node_index) {
+    return MatchScaledX(node_index, M_SQRT1_2);
+  }
+
+  // Matches sqrt(2 / pi) * (x + 0.044715 * x^3).
+  bool MatchTanhArgument(int node_index) {
+    std::vector<int> factors;
+    if (node_index == kMissingIndex || !AddNode(node_index) ||
+        !MatchProduct(node_index, &factors) || factors.size() != 2) {
+      return false;
+    }
+    int sum = factors[1];
+    if (!IsConstantWithValue(node(factors[0]), M_2_SQRTPI * M_SQRT1_2)) {
+      sum = factors[0];
+      if (!IsConstantWithValue(node(factors[1]), M_2_SQRTPI * M_SQRT1_2)) {
+        return false;
+      }
+    }
+    if (!IsAdd(node(sum)) || !AddNode(sum)) return false;
+
+    // x + 0.044715 * x^3.
+    const int lhs = RegularFanin(sum, 0);
+    const int rhs = RegularFanin(sum, 1);
+    const int cubic = lhs == x_ ? rhs : (rhs == x_ ? lhs : kMissingIndex);
+    std::vector<int> cubic_factors;
+    if (cubic == kMissingIndex || !AddNode(cubic) ||
+        !MatchProduct(cubic, &cubic_factors)) {
+      return false;
+    }
+    int num_x = 0;
+    int num_coefficients = 0;
+    for (int factor : cubic_factors) {
+      if (factor == x_) {
+        ++num_x;
+      } else if (IsConstantWithValue(node(factor), 0.044715f)) {
+        ++num_coefficients;
+      } else if (IsPow(node(factor)) && RegularFanin(factor, 0) == x_ &&
+                 IsConstantWithValue(node(RegularFanin(factor, 1)), 3.0f) &&
+                 AddNode(factor)) {
+        num_x += 3;
+      } else {
+        return false;
+      }
+    }
+    return num_x == 3 && num_coefficients == 1;
+  }
+
+  const RemapperContext& ctx_;
+  int x_ = kMissingIndex;
+  std::vector<int> nodes_;
+};
+
+bool FindMatMulWithBiasAndGelu(const RemapperContext& ctx, int node_index,
+                               ContractionWithBiasAddAndGelu* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // Root of the pattern must be the Mul computing the Gelu output.
+  // TODO(lyandy): Forward controls for patterns with control dependencies.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  const auto* node_def = node_view->node();
+  if (!IsMul(*node_def) || !HasDataType(node_def, DT_FLOAT)) return false;
+
+  GeluMatcher gelu_matcher(ctx);
+  int bias_add = kMissingIndex;
+  bool approximate = false;
+  if (!gelu_matcher.Match(node_index, &bias_add, &approximate)) return false;
+
+  // And input to the Gelu must match MatMul+BiasAdd pattern.
+  const auto* bias_add_node_view = ctx.graph_view.GetNode(bias_add);
+  const auto* bias_add_node_def = bias_add_node_view->node();
+  ContractionWithBiasAdd base;
+  if (!FindContractionWithBias(ctx, bias_add, &base,
+                               /*check_device_compatible=*/false) ||
+      !HaveSameDataType(node_def, bias_add_node_def) ||
+      IsInPreserveSet(ctx, bias_add_node_def))
+    return false;
+
+  const NodeDef& contraction_node_def =
+      ctx.graph_view.graph()->node(base.contraction);
+  if (!IsMatMul(contraction_node_def) ||
+      !IsCpuCompatibleMatMul(&contraction_node_def))
+    return false;
+
+  // We successfully found a MatMul+BiasAdd+Gelu pattern.
+  matched->contraction = base.contraction;
+  matched->bias_add = base.bias_add;
+  matched->gelu = node_index;
+  matched->gelu_nodes = gelu_matcher.nodes();
+  matched->approximate = approximate;
+
+  return true;
+}
+
 bool FindConv2DWithSqueezeAndBias(const RemapperContext& ctx, int node_index,
                                   ContractionWithSqueezeAndBiasAdd* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -988,6 +1260,48 @@ Status AddFusedContractionNode(
   return Status::OK();
 }
 
+Status AddFusedContractionNode(RemapperContext* ctx,
+                               const ContractionWithBiasAddAndGelu& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& gelu = graph->node(matched.gelu);
+  DCHECK(IsMatMul(contraction)) << "Only MatMul supported for now";
+  const char* gelu_op = matched.approximate ? "GeluApproximate" : "GeluExact";
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and " << gelu_op
+          << ":"
+          << " gelu=" << gelu.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(gelu.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
+
+  fused_op.set_op(kFusedMatMul);
+  CopyMatMulAttributes(contraction, &fused_op);
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", gelu_op});
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  for (int index : matched.gelu_nodes) {
+    (*nodes_to_delete)[index] = true;
+  }
+  (*invalidated_nodes)[matched.gelu] = true;
+
+  return Status::OK();
+}
+
 Status AddFusedConv2DNode(RemapperContext* ctx,
                           const ContractionWithSqueezeAndBiasAdd& matched,
                           std::vector<bool>* invalidated_nodes,
@@ -1580,6 +1894,18 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+#ifndef INTEL_MKL
+    // Remap MatMul+BiasAdd+Gelu into the _FusedMatMul.
+    ContractionWithBiasAddAndGelu contract_with_bias_and_gelu;
+    if (allow_non_differentiable_rewrites &&
+        FindMatMulWithBiasAndGelu(ctx, i, &contract_with_bias_and_gelu)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_gelu,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+#endif  // !INTEL_MKL
+
 // NOTE: We can only fuse BatchNorm into Conv2D nodes. In theory we can do
 // it for MatMul as well, but in practice this pattern does not appear in
 // real Tensorflow graphs.
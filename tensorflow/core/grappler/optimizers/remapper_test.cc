@@ -607,6 +607,133 @@ TEST_F(RemapperTest, FuseMatMulWithBiasAndActivation) {
   }
 }
 
+TEST_F(RemapperTest, FuseMatMulWithBiasAndGelu) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const bool approximate : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto lhs_shape = ops::Placeholder::Shape({8, 32});
+    auto rhs_shape = ops::Placeholder::Shape({32, 64});
+    auto bias_shape = ops::Placeholder::Shape({64});
+
+    auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+    auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+    auto x = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+    // The Gelu as written in Keras and in BERT.
+    Output inner;
+    if (approximate) {
+      auto cube = ops::Pow(s.WithOpName("cube"), x, 3.0f);
+      auto scaled_cube =
+          ops::Mul(s.WithOpName("scaled_cube"), 0.044715f, cube);
+      auto sum = ops::AddV2(s.WithOpName("sum"), x, scaled_cube);
+      auto scaled_sum = ops::Mul(s.WithOpName("scaled_sum"),
+                                 static_cast<float>(M_2_SQRTPI * M_SQRT1_2),
+                                 sum);
+      inner = ops::Tanh(s.WithOpName("tanh"), scaled_sum);
+    } else {
+      auto scaled = ops::RealDiv(s.WithOpName("scaled"), x,
+                                 static_cast<float>(M_SQRT2));
+      inner = ops::Erf(s.WithOpName("erf"), scaled);
+    }
+    auto one_plus = ops::AddV2(s.WithOpName("one_plus"), 1.0f, inner);
+    auto half_x = ops::Mul(s.WithOpName("half_x"), x, 0.5f);
+    auto gelu = ops::Mul(s.WithOpName("gelu"), half_x, one_plus);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+    auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+    auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "bias_add");
+      EXPECT_NE(node.name(), "one_plus");
+      if (node.name() == "gelu") {
+        EXPECT_EQ(node.op(), "_FusedMatMul");
+        ASSERT_GE(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), "lhs");
+        EXPECT_EQ(node.input(1), "rhs");
+
+        EXPECT_EQ(node.attr().at("num_args").i(), 1);
+        EXPECT_EQ(node.input(2), "bias");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), 2);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], approximate ? "GeluApproximate" : "GeluExact");
+        found++;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+  }
+}
+
+TEST_F(RemapperTest, DoNotFuseMatMulWithBiasAndGeluWithOtherUsers) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({8, 32}));
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({32, 64}));
+  auto bias =
+      Placeholder(s.WithOpName("bias"), DT_FLOAT, ops::Placeholder::Shape({64}));
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto x = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto scaled = ops::Mul(s.WithOpName("scaled"), x,
+                         static_cast<float>(M_SQRT1_2));
+  auto erf = ops::Erf(s.WithOpName("erf"), scaled);
+  auto one_plus = ops::AddV2(s.WithOpName("one_plus"), erf, 1.0f);
+  auto half_x = ops::Mul(s.WithOpName("half_x"), 0.5f, x);
+  auto gelu = ops::Mul(s.WithOpName("gelu"), half_x, one_plus);
+  // The erf is also used outside of the Gelu.
+  auto fetch0 = ops::Identity(s.WithOpName("fetch0"), gelu);
+  auto fetch1 = ops::Identity(s.WithOpName("fetch1"), erf);
+
+  GrapplerItem item;
+  item.fetch = {"fetch0", "fetch1"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "gelu") {
+      EXPECT_EQ(node.op(), "Mul");
+    }
+  }
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   using ops::Placeholder;
 
@@ -42,6 +42,8 @@ class ASBSBatch;
 
 template <typename TaskType>
 class ASBSQueue;
+
+class ASBSLatencySloController;
 }  // namespace internal
 
 // Shared batch scheduler designed to minimize latency. The scheduler keeps
@@ -69,6 +71,12 @@ class ASBSQueue;
 // CPU utilization - If the batch processing is cpu dominated, you can reap
 //   latency gains when underutilized by increasing the processing rate, but
 //   back the rate off when the load increases to avoid overload.
+//
+// A queue can also be given a latency SLO, in which case the size and timeout
+// of its batches are adjusted online, within its max_batch_size and
+// batch_timeout_micros, so that the 99th percentile of the latency of its
+// batches stays below the SLO. This lets several models with different
+// latency targets share the batch threads and the device they run on.
 
 template <typename TaskType>
 class AdaptiveSharedBatchScheduler
@@ -129,6 +137,15 @@ class AdaptiveSharedBatchScheduler
     // A non-zero value can improve performance by limiting the scheduling of
     // nearly empty batches.
     int64 batch_timeout_micros = 0;
+    // If positive, the target for the 99th percentile of the latency of the
+    // batches of the queue, from their creation to the end of their
+    // processing. The queue then shrinks its batches, below max_batch_size,
+    // when the target is missed, grows them back when there is headroom, and
+    // shortens their timeout, below batch_timeout_micros, to leave room for
+    // their processing.
+    int64 latency_slo_micros = 0;
+    // Number of batches of the queue between adjustments for the latency SLO.
+    int64 slo_batches_to_average_over = 100;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
@@ -257,8 +274,16 @@ class ASBSQueue : public BatchScheduler<TaskType> {
   size_t max_task_size() const override { return options_.max_batch_size; }
 
  private:
+  // The current limits on the size and timeout of the batches, which are
+  // adjusted for the latency SLO if there is one.
+  int batch_size_limit() const;
+  int64 batch_timeout_micros() const;
+
   std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler_;
   const QueueOptions options_;
+  // Null if the queue has no latency SLO. Shared with the batches, which
+  // report their latency to it.
+  const std::shared_ptr<ASBSLatencySloController> slo_controller_;
   // Owned by scheduler_.
   ASBSBatch<TaskType>* current_batch_ GUARDED_BY(mu_) = nullptr;
   int64 num_enqueued_batches_ GUARDED_BY(mu_) = 0;
@@ -272,10 +297,12 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64 creation_time_micros,
-            int64 batch_timeout_micros)
+            int64 batch_timeout_micros,
+            std::shared_ptr<ASBSLatencySloController> slo_controller)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
-        schedulable_time_micros_(creation_time_micros + batch_timeout_micros) {}
+        schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
+        slo_controller_(std::move(slo_controller)) {}
 
   ~ASBSBatch() override {}
 
@@ -285,12 +312,91 @@ class ASBSBatch : public Batch<TaskType> {
 
   int64 schedulable_time_micros() const { return schedulable_time_micros_; }
 
+  const std::shared_ptr<ASBSLatencySloController>& slo_controller() const {
+    return slo_controller_;
+  }
+
  private:
   ASBSQueue<TaskType>* queue_;
   const int64 creation_time_micros_;
   const int64 schedulable_time_micros_;
+  const std::shared_ptr<ASBSLatencySloController> slo_controller_;
   TF_DISALLOW_COPY_AND_ASSIGN(ASBSBatch);
 };
+
+// Adjusts the size and timeout of the batches of a queue so that the 99th
+// percentile of their latency stays below a target. The size limit decreases
+// multiplicatively when the target is missed and increases additively when
+// the latency is below kHeadroom of the target. The timeout moves by half
+// the slack between the latency and kHeadroom of the target.
+class ASBSLatencySloController {
+ public:
+  ASBSLatencySloController(int max_batch_size, int64 max_batch_timeout_micros,
+                           int64 latency_slo_micros,
+                           int64 batches_to_average_over)
+      : max_batch_size_(max_batch_size),
+        max_batch_timeout_micros_(max_batch_timeout_micros),
+        latency_slo_micros_(latency_slo_micros),
+        batches_to_average_over_(batches_to_average_over),
+        batch_size_limit_(max_batch_size),
+        batch_timeout_micros_(max_batch_timeout_micros) {}
+
+  int batch_size_limit() const {
+    mutex_lock l(mu_);
+    return batch_size_limit_;
+  }
+
+  int64 batch_timeout_micros() const {
+    mutex_lock l(mu_);
+    return batch_timeout_micros_;
+  }
+
+  // Records a batch which took `latency_micros` from its creation to the end
+  // of its processing.
+  void RecordBatch(int64 latency_micros, int64 processing_micros) {
+    mutex_lock l(mu_);
+    latencies_micros_.push_back(latency_micros);
+    if (latencies_micros_.size() < batches_to_average_over_) return;
+    // The 99th percentile.
+    auto p99 = latencies_micros_.begin() +
+               (latencies_micros_.size() * 99 + 99) / 100 - 1;
+    std::nth_element(latencies_micros_.begin(), p99, latencies_micros_.end());
+    const int64 p99_latency_micros = *p99;
+    latencies_micros_.clear();
+
+    const int64 target_micros = latency_slo_micros_ * kHeadroom;
+    if (p99_latency_micros > latency_slo_micros_) {
+      batch_size_limit_ = std::max(
+          1, static_cast<int>(batch_size_limit_ * kDecreaseMultiplier));
+    } else if (p99_latency_micros < target_micros) {
+      const int step = std::max(1, batch_size_limit_ / kIncreaseDivisor);
+      batch_size_limit_ = std::min(max_batch_size_, batch_size_limit_ + step);
+    }
+    batch_timeout_micros_ += (target_micros - p99_latency_micros) / 2;
+    batch_timeout_micros_ = std::min(batch_timeout_micros_,
+                                     max_batch_timeout_micros_);
+    batch_timeout_micros_ = std::max(batch_timeout_micros_, int64{0});
+  }
+
+ private:
+  // Fraction of the SLO below which the batches grow.
+  constexpr static double kHeadroom = 0.9;
+  constexpr static double kDecreaseMultiplier = 0.75;
+  constexpr static int kIncreaseDivisor = 8;
+
+  const int max_batch_size_;
+  const int64 max_batch_timeout_micros_;
+  const int64 latency_slo_micros_;
+  const size_t batches_to_average_over_;
+
+  mutable mutex mu_;
+  int batch_size_limit_ GUARDED_BY(mu_);
+  int64 batch_timeout_micros_ GUARDED_BY(mu_);
+  // Latencies of the batches since the last adjustment.
+  std::vector<int64> latencies_micros_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ASBSLatencySloController);
+};
 }  // namespace internal
 
 // ---------------- AdaptiveSharedBatchScheduler ----------------
@@ -373,6 +479,15 @@ Status AdaptiveSharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be positive; was ",
         options.max_enqueued_batches);
   }
+  if (options.latency_slo_micros < 0) {
+    return errors::InvalidArgument("latency_slo_micros can't be negative; was ",
+                                   options.latency_slo_micros);
+  }
+  if (options.slo_batches_to_average_over < 1) {
+    return errors::InvalidArgument(
+        "slo_batches_to_average_over must be positive; was ",
+        options.slo_batches_to_average_over);
+  }
   internal::ASBSQueue<TaskType>* asbs_queue_raw;
   queue->reset(asbs_queue_raw = new internal::ASBSQueue<TaskType>(
                    this->shared_from_this(), options));
@@ -467,9 +582,17 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
     AdaptiveSharedBatchScheduler<TaskType>::BatchProcessor callback,
     bool is_express) {
   int64 start_time = batch->creation_time_micros();
+  // The batch, and possibly its queue, are gone after the callback.
+  std::shared_ptr<internal::ASBSLatencySloController> slo_controller =
+      batch->slo_controller();
+  const int64 processing_start_time = GetEnv()->NowMicros();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64 end_time = GetEnv()->NowMicros();
+  if (slo_controller != nullptr) {
+    slo_controller->RecordBatch(end_time - start_time,
+                                end_time - processing_start_time);
+  }
   mutex_lock l(mu_);
   if (is_express) {
     in_flight_express_batches_--;
@@ -525,7 +648,15 @@ template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
     const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    : scheduler_(scheduler),
+      options_(options),
+      slo_controller_(options.latency_slo_micros > 0
+                          ? std::make_shared<ASBSLatencySloController>(
+                                options.max_batch_size,
+                                options.batch_timeout_micros,
+                                options.latency_slo_micros,
+                                options.slo_batches_to_average_over)
+                          : nullptr) {}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -557,7 +688,7 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
     mutex_lock l(mu_);
     // Current batch is full, create another if allowed.
     if (current_batch_ &&
-        current_batch_->size() + size > options_.max_batch_size) {
+        current_batch_->size() + size > batch_size_limit()) {
       if (num_enqueued_batches_ >= options_.max_enqueued_batches) {
         return errors::Unavailable("The batch scheduling queue is full");
       }
@@ -569,7 +700,7 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       num_enqueued_batches_++;
       current_batch_ = new_batch =
           new ASBSBatch<TaskType>(this, scheduler_->GetEnv()->NowMicros(),
-                                  options_.batch_timeout_micros);
+                                  batch_timeout_micros(), slo_controller_);
     }
     current_batch_->AddTask(std::move(*task));
     num_enqueued_tasks_++;
@@ -600,11 +731,27 @@ size_t ASBSQueue<TaskType>::NumEnqueuedTasks() const {
 template <typename TaskType>
 size_t ASBSQueue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
+  const int max_batch_size = batch_size_limit();
   const int current_batch_capacity =
-      current_batch_ ? options_.max_batch_size - current_batch_->size() : 0;
+      current_batch_
+          ? std::max(0, max_batch_size -
+                            static_cast<int>(current_batch_->size()))
+          : 0;
   const int spare_batches =
       options_.max_enqueued_batches - num_enqueued_batches_;
-  return spare_batches * options_.max_batch_size + current_batch_capacity;
+  return spare_batches * max_batch_size + current_batch_capacity;
+}
+
+template <typename TaskType>
+int ASBSQueue<TaskType>::batch_size_limit() const {
+  return slo_controller_ ? slo_controller_->batch_size_limit()
+                         : options_.max_batch_size;
+}
+
+template <typename TaskType>
+int64 ASBSQueue<TaskType>::batch_timeout_micros() const {
+  return slo_controller_ ? slo_controller_->batch_timeout_micros()
+                         : options_.batch_timeout_micros;
 }
 }  // namespace internal
 }  // namespace serving
@@ -381,6 +381,77 @@ TEST(AdaptiveSharedBatchSchedulerTest, QueueCapacityInfo) {
   EXPECT_EQ(queue->SchedulingCapacity(), 8 * 1000 + 300);
   finish_processing.Notify();
 }
+
+TEST(AdaptiveSharedBatchSchedulerTest, LatencySloController) {
+  internal::ASBSLatencySloController controller(
+      /*max_batch_size=*/64, /*max_batch_timeout_micros=*/1000,
+      /*latency_slo_micros=*/10000, /*batches_to_average_over=*/100);
+  EXPECT_EQ(controller.batch_size_limit(), 64);
+  EXPECT_EQ(controller.batch_timeout_micros(), 1000);
+
+  // A single slow batch in 100 does not miss the 99th percentile target.
+  for (int i = 0; i < 99; i++) {
+    controller.RecordBatch(5000, 4000);
+  }
+  controller.RecordBatch(50000, 49000);
+  EXPECT_EQ(controller.batch_size_limit(), 64);
+  EXPECT_EQ(controller.batch_timeout_micros(), 1000);
+
+  // Missing the target shrinks the batches and their timeout.
+  for (int i = 0; i < 100; i++) {
+    controller.RecordBatch(12000, 11000);
+  }
+  EXPECT_EQ(controller.batch_size_limit(), 48);
+  EXPECT_EQ(controller.batch_timeout_micros(), 0);
+
+  // Without headroom, the batch size is kept.
+  for (int i = 0; i < 100; i++) {
+    controller.RecordBatch(9500, 9000);
+  }
+  EXPECT_EQ(controller.batch_size_limit(), 48);
+  EXPECT_EQ(controller.batch_timeout_micros(), 0);
+
+  // With headroom, the batches grow back.
+  for (int i = 0; i < 100; i++) {
+    controller.RecordBatch(4000, 3000);
+  }
+  EXPECT_EQ(controller.batch_size_limit(), 54);
+  EXPECT_EQ(controller.batch_timeout_micros(), 1000);
+}
+
+TEST(AdaptiveSharedBatchSchedulerTest, LatencySlo) {
+  test_util::FakeClockEnv env(Env::Default());
+  AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+  options.env = &env;
+  options.initial_in_flight_batches_limit = 1;
+  std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(
+      AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  // Processing the batches takes longer than the SLO.
+  auto queue_callback = [&env](std::unique_ptr<Batch<FakeTask>> batch) {
+    env.AdvanceByMicroseconds(2000);
+  };
+  AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 100;
+  queue_options.latency_slo_micros = -1;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  EXPECT_FALSE(
+      scheduler->AddQueue(queue_options, queue_callback, &queue).ok());
+  queue_options.latency_slo_micros = 1000;
+  queue_options.slo_batches_to_average_over = 1;
+  TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+  EXPECT_EQ(queue->SchedulingCapacity(), 10 * 100);
+
+  TF_ASSERT_OK(ScheduleTask(10, queue.get()));
+  // Wait for the batch to be processed and the batch size limit to shrink.
+  while (queue->SchedulingCapacity() == 10 * 100 - 10 ||
+         queue->SchedulingCapacity() == 10 * 100) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  EXPECT_EQ(queue->SchedulingCapacity(), 10 * 75);
+  // Tasks larger than the current limit are still accepted.
+  EXPECT_EQ(queue->max_task_size(), 100);
+}
 }  // namespace anonymous
 }  // namespace serving
 }  // namespace tensorflow
@@ -326,13 +326,23 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         (*ctx->runner())([this, ctx, prefix, input, output, callback]() {
           thread::ThreadPool* device_threadpool =
               ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
+          // A single batch of serialized examples is parsed where it is,
+          // without copying every example into a vector first. The fixed
+          // length dense features are written straight into the batched
+          // outputs by FastParseExample.
           std::vector<tstring> slice_vec;
-          for (const Tensor& t : input) {
-            auto serialized_t = t.flat<tstring>();
-            gtl::ArraySlice<tstring> slice(serialized_t.data(),
-                                           serialized_t.size());
-            for (auto it = slice.begin(); it != slice.end(); it++)
-              slice_vec.push_back(*it);
+          gtl::ArraySlice<tstring> serialized;
+          if (input.size() == 1) {
+            auto serialized_t = input[0].flat<tstring>();
+            serialized = gtl::ArraySlice<tstring>(serialized_t.data(),
+                                                  serialized_t.size());
+          } else {
+            for (const Tensor& t : input) {
+              auto serialized_t = t.flat<tstring>();
+              slice_vec.insert(slice_vec.end(), serialized_t.data(),
+                               serialized_t.data() + serialized_t.size());
+            }
+            serialized = slice_vec;
           }
           example::FastParseExampleConfig config = dataset_->config_;
           // local copy of config_ for modification.
@@ -341,7 +351,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
             config.collect_feature_stats = true;
           }
           example::Result example_result;
-          Status s = FastParseExample(config, slice_vec, {}, device_threadpool,
+          Status s = FastParseExample(config, serialized, {}, device_threadpool,
                                       &example_result);
           if (s.ok()) {
             (*output).resize(dataset_->key_to_output_index_.size());
@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <map>
 #include <random>
 
 #include "absl/time/clock.h"
@@ -319,6 +321,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("shuffle_on_read", &shuffle_on_read_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("seed", &seed_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("seed2", &seed2_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("deterministic_read", &deterministic_read_));
 
     if (shard_size_bytes_ == -1) shard_size_bytes_ = kDefaultShardSizeBytes;
 
@@ -372,7 +376,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         reader_path_prefix_, writer_path_prefix_, compression_,
         shard_size_bytes_, pending_snapshot_expiry_seconds_,
         num_reader_threads_, reader_buffer_size_, num_writer_threads_,
-        writer_buffer_size_, shuffle_on_read_, seed_, seed2_);
+        writer_buffer_size_, shuffle_on_read_, seed_, seed2_,
+        deterministic_read_);
   }
 
  private:
@@ -385,7 +390,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             const uint64 pending_snapshot_expiry_seconds,
             const uint64 num_reader_threads, const uint64 reader_buffer_size,
             const uint64 num_writer_threads, const uint64 writer_buffer_size,
-            const bool shuffle_on_read, const uint64 seed, const uint64 seed2)
+            const bool shuffle_on_read, const uint64 seed, const uint64 seed2,
+            const bool deterministic_read)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           dir_(path),
@@ -401,7 +407,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           writer_buffer_size_(writer_buffer_size),
           shuffle_on_read_(shuffle_on_read),
           seed_(seed),
-          seed2_(seed2) {
+          seed2_(seed2),
+          deterministic_read_(deterministic_read) {
       input_->Ref();
     }
 
@@ -476,6 +483,9 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       AttrValue seed2_attr;
       b->BuildAttrValue<int64>(seed2_, &seed2_attr);
 
+      AttrValue deterministic_read_attr;
+      b->BuildAttrValue<bool>(deterministic_read_, &deterministic_read_attr);
+
       TF_RETURN_IF_ERROR(b->AddDataset(
           this,
           /*inputs=*/
@@ -495,7 +505,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
            {"writer_buffer_size", writer_buffer_size_attr},
            {"shuffle_on_read", shuffle_on_read_attr},
            {"seed", seed_attr},
-           {"seed2", seed2_attr}},
+           {"seed2", seed2_attr},
+           {"deterministic_read", deterministic_read_attr}},
           output));
       return Status::OK();
     }
@@ -587,6 +598,10 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           mutex_lock l(mu_);
           thread_pool_ = ctx->CreateThreadPool(kSnapshotReaderWorkerPool,
                                                dataset()->num_reader_threads_);
+          file_buffer_size_ = std::max<uint64>(
+              1, (dataset()->reader_buffer_size_ +
+                  dataset()->num_reader_threads_ - 1) /
+                     dataset()->num_reader_threads_);
           run_id_ = metadata_.run_id();
           run_dir_ = absl::StrCat(hash_dir_, "/", run_id_);
           // Get all the files in the run_dir.
@@ -624,9 +639,15 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             background_threads_started_ = true;
           }
 
-          // Wait till the buffer has something in it.
-          while (!cancelled_ && buffer_.empty() &&
-                 !background_threads_finished_) {
+          // Wait till one of the file buffers has something in it, or till all
+          // the reading threads have finished.
+          BufferElement elem;
+          bool has_element = false;
+          while (!cancelled_) {
+            has_element = TakeNextElement(&elem);
+            if (has_element || num_active_threads_ == 0) {
+              break;
+            }
             cond_var_.wait(l);
           }
 
@@ -635,60 +656,91 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                 "SnapshotDatasetOp::Dataset::SnapshotReaderIterator::GetNext");
           }
 
-          if (!buffer_.empty()) {
-            Status s = buffer_.front().status;
-            if (s.ok()) {
-              *end_of_sequence = false;
-              *out_tensors = std::move(buffer_.front().value);
-
-              {
-                profiler::TraceMe activity(
-                    absl::StrCat(prefix(), kSeparator, kBookkeeping),
-                    profiler::TraceMeLevel::kInfo);
-                // Printing some statistics along the way.
-                int64 num_bytes = 0;
-                for (int i = 0; i < out_tensors->size(); ++i) {
-                  num_bytes += (*out_tensors)[i].TotalBytes();
-                }
-                absl::Time end = absl::Now();
-                absl::Duration d = end - start;
-                time_spent_micros_ += absl::ToInt64Microseconds(d);
-                kbytes_read_ += static_cast<double>(num_bytes) / 1024.0;
-                elements_produced_++;
-                if (elements_produced_ % 10000 == 0) {
-                  LOG(INFO) << "Current read throughput (MBPS): "
-                            << ((kbytes_read_ / 1024.0) /
-                                (time_spent_micros_ / 1000000.0));
-                }
-              }
-            }
-            buffer_.pop_front();
-            cond_var_.notify_all();
-            return s;
-          }
-
-          if (background_threads_finished_) {
+          if (!has_element) {
             *end_of_sequence = true;
             return Status::OK();
           }
 
-          return errors::Internal("Unreachable point in SnapshotReader");
+          cond_var_.notify_all();
+          if (elem.status.ok()) {
+            *end_of_sequence = false;
+            *out_tensors = std::move(elem.value);
+
+            {
+              profiler::TraceMe activity(
+                  absl::StrCat(prefix(), kSeparator, kBookkeeping),
+                  profiler::TraceMeLevel::kInfo);
+              // Printing some statistics along the way.
+              int64 num_bytes = 0;
+              for (int i = 0; i < out_tensors->size(); ++i) {
+                num_bytes += (*out_tensors)[i].TotalBytes();
+              }
+              absl::Time end = absl::Now();
+              absl::Duration d = end - start;
+              time_spent_micros_ += absl::ToInt64Microseconds(d);
+              kbytes_read_ += static_cast<double>(num_bytes) / 1024.0;
+              elements_produced_++;
+              if (elements_produced_ % 10000 == 0) {
+                LOG(INFO) << "Current read throughput (MBPS): "
+                          << ((kbytes_read_ / 1024.0) /
+                              (time_spent_micros_ / 1000000.0));
+              }
+            }
+          }
+          return elem.status;
         }
 
        private:
-        // Reads one file end to end.
-        Status ReadFile(const string& filename) {
+        struct BufferElement {
+          Status status;
+          std::vector<Tensor> value;
+        };
+
+        // The elements read ahead from a file.
+        struct FileBuffer {
+          std::deque<BufferElement> elements;
+          // Whether the file has been read to the end, or has failed.
+          bool done = false;
+        };
+
+        // Takes the next element from the buffers of the files being read. In
+        // deterministic mode only the earliest of these files is used, so the
+        // elements come in the order of the files.
+        bool TakeNextElement(BufferElement* elem)
+            EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          auto it = file_buffers_.begin();
+          while (it != file_buffers_.end()) {
+            FileBuffer& file_buffer = it->second;
+            if (!file_buffer.elements.empty()) {
+              *elem = std::move(file_buffer.elements.front());
+              file_buffer.elements.pop_front();
+              return true;
+            }
+            if (file_buffer.done) {
+              it = file_buffers_.erase(it);
+              continue;
+            }
+            if (dataset()->deterministic_read_) {
+              return false;
+            }
+            ++it;
+          }
+          return false;
+        }
+
+        // Reads one file end to end into `file_buffer`.
+        Status ReadFile(const string& filename, FileBuffer* file_buffer) {
           std::unique_ptr<RandomAccessFile> file;
           TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
           std::unique_ptr<SnapshotReader> reader(
               new SnapshotReader(file.get(), dataset()->compression_));
 
           while (true) {
-            // Wait for a slot in the buffer.
+            // Wait for a slot in the buffer of this file.
             {
               mutex_lock l(mu_);
               while (!cancelled_ &&
-                     buffer_.size() >= dataset()->reader_buffer_size_) {
+                     file_buffer->elements.size() >= file_buffer_size_) {
                 cond_var_.wait(l);
               }
 
@@ -727,7 +779,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
               std::swap(elem.value, out_tensors);
               elem.status = Status::OK();
               mutex_lock l(mu_);
-              buffer_.push_back(std::move(elem));
+              file_buffer->elements.push_back(std::move(elem));
               cond_var_.notify_all();
             } else if (errors::IsOutOfRange(s)) {
               return Status::OK();
@@ -748,6 +800,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           });
           while (true) {
             string filename = "";
+            FileBuffer* file_buffer;
             {
               mutex_lock l(mu_);
               if (next_file_index_ >= filenames_.size()) {
@@ -756,39 +809,29 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
               filename = absl::StrCat(dataset()->reader_path_prefix_,
                                       filenames_[next_file_index_]);
               VLOG(2) << "Starting to read: " << filename;
+              file_buffer = &file_buffers_[next_file_index_];
               next_file_index_++;
             }
-            Status s = ReadFile(filename);
-            // If we get to the end of the file, it's a clean termination and
-            // we are at the end of the file. If all files have been processed,
-            // then we insert an end_of_sequence marker in the buffer and
-            // terminate the loop.
+            Status s = ReadFile(filename, file_buffer);
+            // An error is returned in place of the rest of the file, and stops
+            // this thread.
+            mutex_lock l(mu_);
             if (s.ok()) {
               VLOG(2) << "Finished reading: " << filename;
-              mutex_lock l(mu_);
-              num_files_done_++;
-              if (num_files_done_ >= filenames_.size()) {
-                background_threads_finished_ = true;
-                cond_var_.notify_all();
-                return;
-              }
             } else {
               LOG(ERROR) << "Encountered an error: " << s.ToString();
               BufferElement elem;
               elem.status = s;
-              mutex_lock l(mu_);
-              buffer_.push_back(std::move(elem));
-              cond_var_.notify_all();
+              file_buffer->elements.push_back(std::move(elem));
+            }
+            file_buffer->done = true;
+            cond_var_.notify_all();
+            if (!s.ok()) {
               return;
             }
           }
         }
 
-        struct BufferElement {
-          Status status;
-          std::vector<Tensor> value;
-        };
-
         mutex mu_;
         condition_variable cond_var_;
 
@@ -802,14 +845,17 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         int64 time_spent_micros_ GUARDED_BY(mu_) = 0;
         double kbytes_read_ GUARDED_BY(mu_) = 0;
         size_t next_file_index_ GUARDED_BY(mu_) = 0;
-        int64 num_files_done_ GUARDED_BY(mu_) = 0;
 
         std::unique_ptr<thread::ThreadPool> thread_pool_;
         int64 num_active_threads_ GUARDED_BY(mu_) = 0;
-        std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+        // The number of elements read ahead from each file, which shares the
+        // reader buffer between the files read in parallel.
+        size_t file_buffer_size_ GUARDED_BY(mu_) = 1;
+        // The buffers of the files which are being read or have not been fully
+        // consumed yet, by the index of the file.
+        std::map<size_t, FileBuffer> file_buffers_ GUARDED_BY(mu_);
         bool cancelled_ GUARDED_BY(mu_) = false;
         bool background_threads_started_ GUARDED_BY(mu_) = false;
-        bool background_threads_finished_ GUARDED_BY(mu_) = false;
       };
 
       class SnapshotWriterIterator : public DatasetIterator<Dataset> {
@@ -1185,6 +1231,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
     const uint64 seed_;
     const uint64 seed2_;
+    const bool deterministic_read_;
   };
 
   const int graph_def_version_;
@@ -1205,6 +1252,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
   int64 seed_;
   int64 seed2_;
+  bool deterministic_read_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
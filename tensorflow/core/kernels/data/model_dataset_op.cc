@@ -13,14 +13,20 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <map>
+
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -29,6 +35,9 @@ namespace {
 
 constexpr int64 kOptimizationPeriodThresholdMs = 60 * EnvTime::kSecondsToMillis;
 
+// The shortest period between two reports of the work of the input pipeline.
+constexpr int64 kReportPeriodMs = 10 * EnvTime::kSecondsToMillis;
+
 // Default share of available RAM that can be used by model's internal buffers.
 constexpr double kRamBudgetShare = 0.5;
 
@@ -43,19 +52,33 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     } else {
       algorithm_ = model::AutotuneAlgorithm::HILL_CLIMB;
     }
+    // A CPU budget of 0 means all the cores which are not reserved by other
+    // runtimes of the process, which is read again for each optimization.
     OP_REQUIRES_OK(ctx, ctx->GetAttr("cpu_budget", &cpu_budget_));
-    if (cpu_budget_ == 0) {
-      cpu_budget_ = port::NumSchedulableCPUs();
-    }
-    OP_REQUIRES(ctx, cpu_budget_ > 0,
-                errors::InvalidArgument("CPU budget must be positive but is ",
-                                        cpu_budget_, "."));
+    OP_REQUIRES(ctx, cpu_budget_ >= 0,
+                errors::InvalidArgument(
+                    "CPU budget must not be negative but is ", cpu_budget_,
+                    "."));
     ram_budget_ = kRamBudgetShare * port::AvailableRam();
+    float target_throughput = 0;
+    if (ctx->HasAttr("target_throughput")) {
+      OP_REQUIRES_OK(ctx,
+                     ctx->GetAttr("target_throughput", &target_throughput));
+    }
+    OP_REQUIRES(ctx, target_throughput >= 0,
+                errors::InvalidArgument(
+                    "Target throughput must not be negative but is ",
+                    target_throughput, "."));
+    // The model works with the time between output elements in nanoseconds.
+    target_output_time_ =
+        target_throughput > 0 ? EnvTime::kSecondsToNanos / target_throughput
+                              : 0;
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
-    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_);
+    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_,
+                          target_output_time_);
   }
 
  private:
@@ -63,12 +86,13 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input,
             model::AutotuneAlgorithm algorithm, int64 cpu_budget,
-            int64 ram_budget)
+            int64 ram_budget, double target_output_time)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           algorithm_(algorithm),
           cpu_budget_(cpu_budget),
-          ram_budget_(ram_budget) {
+          ram_budget_(ram_budget),
+          target_output_time_(target_output_time) {
       input_->Ref();
     }
 
@@ -181,6 +205,7 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
         int64 optimization_period_ms = 10;
         int64 current_time_ms =
             ctx->env()->NowMicros() / EnvTime::kMillisToMicros;
+        last_report_ms_ = current_time_ms;
         while (true) {
           {
             mutex_lock l(mu_);
@@ -196,8 +221,8 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
             }
             if (cancelled_) return;
           }
-          model_->Optimize(dataset()->algorithm_, dataset()->cpu_budget_,
-                           dataset()->ram_budget_);
+          model_->Optimize(dataset()->algorithm_, CpuBudget(), RamBudget(),
+                           dataset()->target_output_time_);
           // Exponentially increase the period of running the optimization
           // until a threshold is reached.
           if (optimization_period_ms != kOptimizationPeriodThresholdMs) {
@@ -206,7 +231,105 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
           }
           current_time_ms = ctx->env()->NowMicros() / EnvTime::kMillisToMicros;
           last_optimization_ms = current_time_ms;
+          if (current_time_ms >= last_report_ms_ + kReportPeriodMs) {
+            Report(ctx.get(), current_time_ms);
+          }
+        }
+      }
+
+      // Reports the work of each transformation of the input pipeline since
+      // the last report to the stats aggregator of the iterator, if there is
+      // one, and to the log, so that the bottleneck of the pipeline can be
+      // found without profiling it.
+      void Report(IteratorContext* ctx, int64 current_time_ms) {
+        std::shared_ptr<StatsAggregator> stats_aggregator =
+            ctx->stats_aggregator();
+        if (!stats_aggregator && !VLOG_IS_ON(1)) {
+          return;
+        }
+        const double period_s =
+            static_cast<double>(current_time_ms - last_report_ms_) /
+            EnvTime::kSecondsToMillis;
+        last_report_ms_ = current_time_ms;
+        std::vector<model::NodeReport> reports = model_->Report();
+        if (reports.empty()) {
+          return;
+        }
+        const int64 steps = reports.front().num_elements;
+        string text;
+        string bottleneck;
+        double bottleneck_utilization = 0;
+        std::map<string, model::NodeReport> last_reports;
+        for (auto& report : reports) {
+          const model::NodeReport& last = last_reports_[report.name];
+          const double throughput =
+              (report.num_elements - last.num_elements) / period_s;
+          // The share of the period in which the node was busy, counting each
+          // of its parallel calls as a separate core.
+          const double utilization =
+              (report.processing_time - last.processing_time) /
+              (period_s * EnvTime::kSecondsToNanos *
+               std::max(1.0, report.parallelism));
+          if (utilization > bottleneck_utilization) {
+            bottleneck = report.name;
+            bottleneck_utilization = utilization;
+          }
+          strings::StrAppend(
+              &text, "\n  ", report.name, ": throughput=", throughput,
+              "/s utilization=", utilization,
+              " element_time_ns(mean/p50/p90/p99)=", report.mean_element_time,
+              "/", report.p50_element_time, "/", report.p90_element_time, "/",
+              report.p99_element_time,
+              " buffered_elements=", report.buffered_elements);
+          if (report.buffer_size >= 0) {
+            strings::StrAppend(&text, " buffer_size=", report.buffer_size);
+          }
+          if (report.parallelism >= 0) {
+            strings::StrAppend(&text, " parallelism=", report.parallelism);
+          }
+          if (stats_aggregator) {
+            const string& prefix = report.name;
+            stats_aggregator->AddScalar(
+                strings::StrCat(prefix, "::throughput"), throughput, steps);
+            stats_aggregator->AddScalar(
+                strings::StrCat(prefix, "::utilization"), utilization, steps);
+            stats_aggregator->AddScalar(
+                strings::StrCat(prefix, "::element_time_p50"),
+                report.p50_element_time, steps);
+            stats_aggregator->AddScalar(
+                strings::StrCat(prefix, "::element_time_p99"),
+                report.p99_element_time, steps);
+            stats_aggregator->AddScalar(
+                strings::StrCat(prefix, "::buffered_elements"),
+                report.buffered_elements, steps);
+            if (report.parallelism >= 0) {
+              stats_aggregator->AddScalar(
+                  strings::StrCat(prefix, "::parallelism"), report.parallelism,
+                  steps);
+            }
+          }
+          last_reports[report.name] = std::move(report);
         }
+        last_reports_ = std::move(last_reports);
+        VLOG(1) << "Input pipeline report over the last " << period_s
+                << " s, the busiest transformation is " << bottleneck << ":"
+                << text;
+      }
+
+      // The budgets leave out the resources which other runtimes of the
+      // process have reserved since the last optimization.
+      int64 CpuBudget() const {
+        if (dataset()->cpu_budget_ != 0) {
+          return dataset()->cpu_budget_;
+        }
+        return std::max<int64>(1,
+                               port::NumSchedulableCPUs() -
+                                   model::ResourceReservation::ReservedCpus());
+      }
+
+      int64 RamBudget() const {
+        const int64 reserved_ram = model::ResourceReservation::ReservedRam();
+        return std::max<int64>(0, dataset()->ram_budget_ - reserved_ram);
       }
 
       mutex mu_;
@@ -215,17 +338,22 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
       std::unique_ptr<Thread> optimize_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
       std::unique_ptr<IteratorBase> input_impl_;
+      // Only used by the optimization thread.
+      int64 last_report_ms_ = 0;
+      std::map<string, model::NodeReport> last_reports_;
     };
 
     const DatasetBase* input_;
     const model::AutotuneAlgorithm algorithm_;
     const int64 cpu_budget_;
     const int64 ram_budget_;
+    const double target_output_time_;
   };
 
   model::AutotuneAlgorithm algorithm_;
   int64 cpu_budget_;
   int64 ram_budget_;
+  double target_output_time_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ModelDataset").Device(DEVICE_CPU),
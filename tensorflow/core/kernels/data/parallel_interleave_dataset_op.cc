@@ -66,6 +66,8 @@ namespace data {
 /* static */ constexpr const char* const
     ParallelInterleaveDatasetOp::kOutputShapes;
 /* static */ constexpr const char* const ParallelInterleaveDatasetOp::kSloppy;
+/* static */ constexpr const char* const
+    ParallelInterleaveDatasetOp::kReorderWindow;
 
 constexpr char kTfDataParallelInterleaveWorkerPool[] =
     "tf_data_parallel_interleave_worker_pool";
@@ -111,7 +113,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   Dataset(OpKernelContext* ctx, const DatasetBase* input,
           std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
           int64 block_length, int64 num_parallel_calls, bool sloppy,
-          const DataTypeVector& output_types,
+          int64 reorder_window, const DataTypeVector& output_types,
           const std::vector<PartialTensorShape>& output_shapes)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
@@ -120,6 +122,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         block_length_(block_length),
         num_parallel_calls_(num_parallel_calls),
         sloppy_(sloppy),
+        reorder_window_(reorder_window),
         output_types_(output_types),
         output_shapes_(output_shapes) {
     input_->Ref();
@@ -180,17 +183,22 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
     AttrValue sloppy_attr;
     b->BuildAttrValue(sloppy_, &sloppy_attr);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        {kFunc, f},
+        {kTarguments, other_arguments_types_attr},
+        {kSloppy, sloppy_attr}};
+    if (reorder_window_ > 0) {
+      AttrValue reorder_window_attr;
+      b->BuildAttrValue(reorder_window_, &reorder_window_attr);
+      attrs.emplace_back(kReorderWindow, reorder_window_attr);
+    }
 
     TF_RETURN_IF_ERROR(b->AddDataset(this,
                                      {{0, input_node},
                                       {2, cycle_length_node},
                                       {3, block_length_node},
                                       {4, num_parallel_calls_node}},
-                                     {{1, other_arguments}},
-                                     {{kFunc, f},
-                                      {kTarguments, other_arguments_types_attr},
-                                      {kSloppy, sloppy_attr}},
-                                     output));
+                                     {{1, other_arguments}}, attrs, output));
     return Status::OK();
   }
 
@@ -520,6 +528,18 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
             elements_to_process_.push_back(cycle_index_);
             current_workers_cond_var_.notify_one();
           }
+          if (UsesReorderWindow() &&
+              NumCurrentResults() == dataset()->reorder_window_ - 1) {
+            // The window was full and has room again, so the elements which
+            // stopped at it resume.
+            for (int64 i = 0; i <= last_valid_current_element_; ++i) {
+              const std::shared_ptr<Element>& e = current_elements_[i];
+              if (i != cycle_index_ && NeedsProcessing(e) && !e->active) {
+                elements_to_process_.push_back(i);
+                current_workers_cond_var_.notify_one();
+              }
+            }
+          }
           AdvancePosition();
           return true;
         }
@@ -789,7 +809,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
-        if (element->results.size() == per_iterator_prefetch_) {
+        if (!HasRoomForResult(*element)) {
           break;
         }
       }
@@ -890,8 +910,37 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       if (!element->initialized) {
         return true;
       }
-      return element->iterator &&
-             element->results.size() < per_iterator_prefetch_;
+      return element->iterator && HasRoomForResult(*element);
+    }
+
+    bool UsesReorderWindow() const {
+      return !sloppy_ && dataset()->reorder_window_ > 0;
+    }
+
+    // Returns the number of results buffered by the current cycle.
+    int64 NumCurrentResults() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 num_results = 0;
+      for (int64 i = 0; i <= last_valid_current_element_; ++i) {
+        if (current_elements_[i]) {
+          num_results += current_elements_[i]->results.size();
+        }
+      }
+      return num_results;
+    }
+
+    // Returns whether `element` may buffer another result. In deterministic
+    // mode with a reorder window, the elements of the current cycle may run
+    // ahead of their per-iterator prefetch while another element lags, as
+    // long as the cycle buffers fewer than `reorder_window_` results.
+    bool HasRoomForResult(const Element& element)
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (element.results.size() < per_iterator_prefetch_) {
+        return true;
+      }
+      if (!UsesReorderWindow() || element.cycle_index == -1) {
+        return false;
+      }
+      return NumCurrentResults() < dataset()->reorder_window_;
     }
 
     inline void IncrementCurrentWorkers() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1268,6 +1317,9 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   const int64 num_parallel_calls_;
   const int op_version_ = 2;
   const bool sloppy_;
+  // The number of results which the current cycle may buffer in total, beyond
+  // the per-iterator prefetch, in deterministic mode. 0 disables it.
+  const int64 reorder_window_;
   const DataTypeVector output_types_;
   const std::vector<PartialTensorShape> output_shapes_;
 };
@@ -1282,6 +1334,11 @@ ParallelInterleaveDatasetOp::ParallelInterleaveDatasetOp(
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kSloppy, &sloppy_));
+  if (ctx->HasAttr(kReorderWindow)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kReorderWindow, &reorder_window_));
+    OP_REQUIRES(ctx, reorder_window_ >= 0,
+                errors::InvalidArgument("`reorder_window` must be >= 0"));
+  }
 }
 
 void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
@@ -1322,7 +1379,7 @@ void ParallelInterleaveDatasetOp::MakeDataset(OpKernelContext* ctx,
 
   *output = new Dataset(ctx, input, std::move(captured_func), cycle_length,
                         block_length, num_parallel_calls, sloppy_,
-                        output_types_, output_shapes_);
+                        reorder_window_, output_types_, output_shapes_);
 }
 
 namespace {
@@ -35,6 +35,7 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadAheadRequests;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
@@ -42,7 +43,8 @@ constexpr char kOffset[] = "offset";
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   int64 read_ahead_requests)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
@@ -50,7 +52,10 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
             compression_type)) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
+      // Each read ahead request reads as much as the buffer would hold.
+      options_.read_ahead_chunk_size = buffer_size;
     }
+    options_.read_ahead_requests = read_ahead_requests;
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -86,8 +91,16 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+    // The attribute is only set when it is used, so that the graph can still
+    // be read by older binaries.
+    std::vector<std::pair<StringPiece, AttrValue>> attrs;
+    if (options_.read_ahead_requests > 0) {
+      AttrValue read_ahead_requests;
+      b->BuildAttrValue(options_.read_ahead_requests, &read_ahead_requests);
+      attrs.emplace_back(kReadAheadRequests, read_ahead_requests);
+    }
     TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+        this, {filenames, compression_type, buffer_size}, attrs, output));
     return Status::OK();
   }
 
@@ -213,7 +226,15 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kReadAheadRequests)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kReadAheadRequests, &read_ahead_requests_));
+  }
+  OP_REQUIRES(ctx, read_ahead_requests_ >= 0,
+              errors::InvalidArgument(
+                  "`read_ahead_requests` must be >= 0 (0 == no read ahead)"));
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -241,8 +262,8 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
               errors::InvalidArgument(
                   "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, read_ahead_requests_);
 }
 
 namespace {
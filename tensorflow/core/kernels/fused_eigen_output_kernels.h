@@ -22,6 +22,8 @@ limitations under the License.
 //   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
 //
 // Activation: Relu, Relu6, Elu, etc...
+//
+// GeluExact and GeluApproximate are only supported after a BiasAdd.
 
 #ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
 #define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -39,6 +41,8 @@ enum class FusedComputationType {
   kBiasAddWithRelu,
   kBiasAddWithRelu6,
   kBiasAddWithElu,
+  kBiasAddWithGeluExact,
+  kBiasAddWithGeluApproximate,
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
@@ -111,6 +115,34 @@ struct Elu {
   };
 };
 
+// Applies the exact `Gelu` to the passed input expression:
+//   0.5 * x * (1 + erf(x / sqrt(2)))
+struct GeluExact {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    return (expr * expr.constant(static_cast<Scalar>(0.5))) *
+           ((expr * expr.constant(static_cast<Scalar>(M_SQRT1_2))).erf() +
+            expr.constant(static_cast<Scalar>(1)));
+  };
+};
+
+// Applies the tanh approximation of `Gelu` to the passed input expression:
+//   0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrt2OverPi = static_cast<Scalar>(M_2_SQRTPI * M_SQRT1_2);
+    return (expr * expr.constant(static_cast<Scalar>(0.5))) *
+           ((expr * expr.constant(kSqrt2OverPi) *
+             (expr * expr * expr.constant(static_cast<Scalar>(0.044715)) +
+              expr.constant(static_cast<Scalar>(1))))
+                .tanh() +
+            expr.constant(static_cast<Scalar>(1)));
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -119,7 +151,9 @@ struct BiasAddArgs {
     return fusion == FusedComputationType::kBiasAdd ||
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
-           fusion == FusedComputationType::kBiasAddWithElu;
+           fusion == FusedComputationType::kBiasAddWithElu ||
+           fusion == FusedComputationType::kBiasAddWithGeluExact ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate;
   }
 };
 
@@ -258,6 +292,10 @@ using WithBiasAddAndRelu6 = BiasAddOutputKernel<T, Relu6>;
 template <typename T>
 using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
+using WithBiasAddAndGeluExact = BiasAddOutputKernel<T, GeluExact>;
+template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -20,19 +20,190 @@ limitations under the License.
 #include <type_traits>
 #include <utility>
 
+#include "tensorflow/core/common_runtime/metrics.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace lookup {
 
-// Lookup table that wraps an unordered_map, where the key and value data type
-// is specified. Each individual value must be a scalar. If vector values are
-// required, use MutableHashTableOfTensors.
+namespace {
+
+template <typename T>
+inline uint64 HashScalar(const T& key) {
+  return static_cast<uint64>(key);
+}
+
+inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
+
+// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
+TensorShape MaybeVectorizeShape(const TensorShape& shape) {
+  if (shape.dims() == 0) {
+    return TensorShape({1});
+  }
+  return shape;
+}
+
+}  // namespace
+
+// A key read once from a key tensor: integral keys are copied, since the
+// tensor may change concurrently, and the others are referenced.
+template <typename T, bool = std::is_integral<T>::value>
+class StableKey {
+ public:
+  explicit StableKey(const T& key) : key_(key) {}
+  const T& get() const { return key_; }
+
+ private:
+  T key_;
+};
+
+template <typename T>
+class StableKey<T, false> {
+ public:
+  explicit StableKey(const T& key) : key_(&key) {}
+  const T& get() const { return *key_; }
+
+ private:
+  const T* key_;
+};
+
+// An unordered_map split into shards that are locked independently, so that
+// the finds and inserts of concurrent steps rarely wait for each other. The
+// keys of a batch are grouped by shard, and large batches process their
+// shards in parallel on the CPU worker threads.
+template <class K, class V>
+class ShardedHashMap {
+ public:
+  typedef std::unordered_map<K, V> Map;
+
+  size_t size() const {
+    size_t size = 0;
+    for (const MapShard& shard : shards_) {
+      tf_shared_lock l(shard.mu);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // Calls `fn(i, key, map)` for each key `keys(i)`, with the map of its shard
+  // locked, exclusively if `exclusive`.
+  template <typename Fn>
+  void ForEachKey(OpKernelContext* ctx, typename TTypes<K>::ConstFlat keys,
+                  bool exclusive, const Fn& fn) {
+    const int64 n = keys.size();
+    // Groups the keys by shard with a counting sort.
+    std::vector<StableKey<K>> stable_keys;
+    stable_keys.reserve(n);
+    std::vector<uint8> shard_ids(n);
+    std::vector<int64> offsets(kNumShards + 1, 0);
+    for (int64 i = 0; i < n; ++i) {
+      stable_keys.emplace_back(keys(i));
+      shard_ids[i] = ShardId(stable_keys[i].get());
+      ++offsets[shard_ids[i] + 1];
+    }
+    for (int s = 0; s < kNumShards; ++s) {
+      offsets[s + 1] += offsets[s];
+    }
+    std::vector<int64> indices(n);
+    std::vector<int64> positions(offsets.begin(), offsets.end() - 1);
+    for (int64 i = 0; i < n; ++i) {
+      indices[positions[shard_ids[i]]++] = i;
+    }
+    auto process_shards = [this, &stable_keys, &offsets, &indices, exclusive,
+                           &fn](int64 start, int64 end) {
+      for (int64 s = start; s < end; ++s) {
+        if (offsets[s] == offsets[s + 1]) continue;
+        MapShard& shard = shards_[s];
+        Lock(&shard.mu, exclusive);
+        for (int64 j = offsets[s]; j < offsets[s + 1]; ++j) {
+          const int64 i = indices[j];
+          fn(i, stable_keys[i].get(), &shard.map);
+        }
+        if (exclusive) {
+          shard.mu.unlock();
+        } else {
+          shard.mu.unlock_shared();
+        }
+      }
+    };
+    if (n < kMinParallelBatchSize) {
+      process_shards(0, kNumShards);
+      return;
+    }
+    auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, kNumShards,
+          kCostPerKey * n / kNumShards, process_shards);
+  }
+
+  // Calls `fn(i, key, map)` for each key `keys(i)` after clearing the maps,
+  // with all of them locked, so that no find sees a partial state.
+  template <typename Fn>
+  void ClearAndForEachKey(typename TTypes<K>::ConstFlat keys, const Fn& fn) {
+    std::vector<mutex_lock> locks;
+    locks.reserve(kNumShards);
+    for (MapShard& shard : shards_) {
+      locks.emplace_back(shard.mu);
+      shard.map.clear();
+    }
+    for (int64 i = 0; i < keys.size(); ++i) {
+      const StableKey<K> key(keys(i));
+      fn(i, key.get(), &shards_[ShardId(key.get())].map);
+    }
+  }
+
+  // Returns `fn(maps)`, with all the maps locked for reading.
+  template <typename Fn>
+  Status ReadAll(const Fn& fn) const {
+    std::vector<tf_shared_lock> locks;
+    std::vector<const Map*> maps;
+    locks.reserve(kNumShards);
+    for (const MapShard& shard : shards_) {
+      locks.emplace_back(shard.mu);
+      maps.push_back(&shard.map);
+    }
+    return fn(maps);
+  }
+
+ private:
+  static constexpr int kNumShards = 16;
+  // Smaller batches are processed on the calling thread.
+  static constexpr int64 kMinParallelBatchSize = 4096;
+  static constexpr int64 kCostPerKey = 100;
+
+  struct MapShard {
+    mutable mutex mu;
+    Map map;
+  };
+
+  static int ShardId(const K& key) {
+    // The multiplicative hash spreads the sequential integral keys.
+    return (HashScalar(key) * 0x9E3779B97F4A7C15ULL) >> 60;
+  }
+
+  // Locks `mu`, recording whether it had to wait for another thread.
+  static void Lock(mutex* mu, bool exclusive) {
+    if (exclusive ? mu->try_lock() : mu->try_lock_shared()) return;
+    metrics::RecordMutableHashTableLockContention();
+    if (exclusive) {
+      mu->lock();
+    } else {
+      mu->lock_shared();
+    }
+  }
+
+  static_assert(kNumShards == 16, "ShardId uses the top 4 bits of the hash");
+  MapShard shards_[kNumShards];
+};
+
+// Lookup table that wraps a sharded unordered_map, where the key and value
+// data type is specified. Each individual value must be a scalar. If vector
+// values are required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
 //
@@ -49,80 +220,78 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
     const V default_val = default_value.flat<V>()(0);
-    const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
-    }
-
+    table_.ForEachKey(ctx, key.flat<K>(), /*exclusive=*/false,
+                      [&](int64 i, const K& key, Map* map) {
+                        value_values(i) =
+                            gtl::FindWithDefault(*map, key, default_val);
+                      });
     return Status::OK();
   }
 
-  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
-    const auto key_values = keys.flat<K>();
+  Status DoInsert(OpKernelContext* ctx, bool clear, const Tensor& keys,
+                  const Tensor& values) {
     const auto value_values = values.flat<V>();
-
-    mutex_lock l(mu_);
+    auto insert = [&value_values](int64 i, const K& key, Map* map) {
+      gtl::InsertOrUpdate(map, key, SubtleMustCopyIfIntegral(value_values(i)));
+    };
     if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
+      table_.ClearAndForEachKey(keys.flat<K>(), insert);
+    } else {
+      table_.ForEachKey(ctx, keys.flat<K>(), /*exclusive=*/true, insert);
     }
+    metrics::RecordMutableHashTableSize(table_.size());
     return Status::OK();
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& keys,
                 const Tensor& values) override {
-    return DoInsert(false, keys, values);
+    return DoInsert(ctx, false, keys, values);
   }
 
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
-    const auto key_values = keys.flat<K>();
-
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.ForEachKey(
+        ctx, keys.flat<K>(), /*exclusive=*/true,
+        [](int64 i, const K& key, Map* map) { map->erase(key); });
     return Status::OK();
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override {
-    return DoInsert(true, keys, values);
+    return DoInsert(ctx, true, keys, values);
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+    return table_.ReadAll([ctx](const std::vector<const Map*>& maps) {
+      int64 size = 0;
+      for (const Map* map : maps) {
+        size += map->size();
+      }
+
+      Tensor* keys;
+      Tensor* values;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("keys", TensorShape({size}), &keys));
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("values", TensorShape({size}), &values));
+
+      auto keys_data = keys->flat<K>();
+      auto values_data = values->flat<V>();
+      int64 i = 0;
+      for (const Map* map : maps) {
+        for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+          keys_data(i) = it->first;
+          values_data(i) = it->second;
+        }
+      }
+      return Status::OK();
+    });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -135,24 +304,30 @@ class MutableHashTableOfScalars final : public LookupInterface {
 
   int64 MemoryUsed() const override {
     int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
+    table_
+        .ReadAll([&ret](const std::vector<const Map*>& maps) {
+          for (const Map* map : maps) {
+            for (unsigned i = 0; i < map->bucket_count(); ++i) {
+              size_t bucket_size = map->bucket_size(i);
+              if (bucket_size == 0) {
+                ret++;
+              } else {
+                ret += bucket_size;
+              }
+            }
+          }
+          return Status::OK();
+        })
+        .IgnoreError();
     return sizeof(MutableHashTableOfScalars) + ret;
   }
 
  private:
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  typedef typename ShardedHashMap<K, V>::Map Map;
+  ShardedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a sharded unordered_map. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -166,101 +341,100 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
     const auto default_flat = default_value.flat<V>();
-    const auto key_values = key.flat<K>();
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    tf_shared_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = default_flat(j);
-        }
-      }
-    }
-
+    table_.ForEachKey(
+        ctx, key.flat<K>(), /*exclusive=*/false,
+        [&](int64 i, const K& key, Map* map) {
+          ValueArray* value_vec = gtl::FindOrNull(*map, key);
+          if (value_vec != nullptr) {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = value_vec->at(j);
+            }
+          } else {
+            for (int64 j = 0; j < value_dim; j++) {
+              value_values(i, j) = default_flat(j);
+            }
+          }
+        });
     return Status::OK();
   }
 
-  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
-    const auto key_values = keys.flat<K>();
+  Status DoInsert(OpKernelContext* ctx, bool clear, const Tensor& keys,
+                  const Tensor& values) {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
-
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
+    auto insert = [&value_values, value_dim](int64 i, const K& key, Map* map) {
       ValueArray value_vec;
       for (int64 j = 0; j < value_dim; j++) {
         V value = value_values(i, j);
         value_vec.push_back(value);
       }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          value_vec);
+      gtl::InsertOrUpdate(map, key, value_vec);
+    };
+    if (clear) {
+      table_.ClearAndForEachKey(keys.flat<K>(), insert);
+    } else {
+      table_.ForEachKey(ctx, keys.flat<K>(), /*exclusive=*/true, insert);
     }
+    metrics::RecordMutableHashTableSize(table_.size());
     return Status::OK();
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& keys,
                 const Tensor& values) override {
-    return DoInsert(false, keys, values);
+    return DoInsert(ctx, false, keys, values);
   }
 
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
-    const auto key_values = keys.flat<K>();
-
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.ForEachKey(
+        ctx, keys.flat<K>(), /*exclusive=*/true,
+        [](int64 i, const K& key, Map* map) { map->erase(key); });
     return Status::OK();
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override {
-    return DoInsert(true, keys, values);
+    return DoInsert(ctx, true, keys, values);
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64 size = table_.size();
     int64 value_dim = value_shape_.dim_size(0);
+    return table_.ReadAll([ctx, value_dim](
+                              const std::vector<const Map*>& maps) {
+      int64 size = 0;
+      for (const Map* map : maps) {
+        size += map->size();
+      }
 
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
+      Tensor* keys;
+      Tensor* values;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_output("keys", TensorShape({size}), &keys));
+      TF_RETURN_IF_ERROR(ctx->allocate_output(
+          "values", TensorShape({size, value_dim}), &values));
+
+      auto keys_data = keys->flat<K>();
+      auto values_data = values->matrix<V>();
+      int64 i = 0;
+      for (const Map* map : maps) {
+        for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+          K key = it->first;
+          ValueArray value = it->second;
+          keys_data(i) = key;
+          for (int64 j = 0; j < value_dim; j++) {
+            values_data(i, j) = value[j];
+          }
+        }
       }
-    }
-    return Status::OK();
+      return Status::OK();
+    });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -273,44 +447,31 @@ class MutableHashTableOfTensors final : public LookupInterface {
 
   int64 MemoryUsed() const override {
     int64 ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
+    table_
+        .ReadAll([&ret](const std::vector<const Map*>& maps) {
+          for (const Map* map : maps) {
+            for (unsigned i = 0; i < map->bucket_count(); ++i) {
+              size_t bucket_size = map->bucket_size(i);
+              if (bucket_size == 0) {
+                ret++;
+              } else {
+                ret += bucket_size;
+              }
+            }
+          }
+          return Status::OK();
+        })
+        .IgnoreError();
     return sizeof(MutableHashTableOfTensors) + ret;
   }
 
  private:
-  TensorShape value_shape_;
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
+  typedef typename ShardedHashMap<K, ValueArray>::Map Map;
+  TensorShape value_shape_;
+  ShardedHashMap<K, ValueArray> table_;
 };
 
-namespace {
-
-template <typename T>
-inline uint64 HashScalar(const T& key) {
-  return static_cast<uint64>(key);
-}
-
-inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
-
-// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
-TensorShape MaybeVectorizeShape(const TensorShape& shape) {
-  if (shape.dims() == 0) {
-    return TensorShape({1});
-  }
-  return shape;
-}
-
-}  // namespace
-
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
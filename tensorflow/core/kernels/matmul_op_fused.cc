@@ -92,6 +92,14 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
         out.device(d) =
             lhs.contract(rhs, dim_pair, WithBiasAddAndElu<T>(bias_add_args));
         break;
+      case FusedComputationType::kBiasAddWithGeluExact:
+        out.device(d) = lhs.contract(rhs, dim_pair,
+                                     WithBiasAddAndGeluExact<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithGeluApproximate:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndGeluApproximate<T>(bias_add_args));
+        break;
       case FusedComputationType::kUndefined:
         OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
         break;
@@ -116,7 +124,10 @@ class FusedMatMulOp : public OpKernel {
       patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
                   {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
-                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+                  {FCT::kBiasAddWithGeluExact, {"BiasAdd", "GeluExact"}},
+                  {FCT::kBiasAddWithGeluApproximate,
+                   {"BiasAdd", "GeluApproximate"}}};
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/platform/test.h"
@@ -135,6 +136,18 @@ class FusedMatMulOpTest : public OpsTestBase {
       ops::Relu6(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Elu") {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "GeluExact") {
+      auto erf = ops::Erf(root, ops::Mul(root, with_bias, T(M_SQRT1_2)));
+      ops::Mul(root.WithOpName("with_activation"),
+               ops::Mul(root, with_bias, T(0.5)), ops::AddV2(root, erf, T(1)));
+    } else if (activation_type == "GeluApproximate") {
+      auto cube = ops::Mul(root, ops::Square(root, with_bias), with_bias);
+      auto tanh = ops::Tanh(
+          root, ops::Mul(root, ops::AddV2(root, with_bias,
+                                          ops::Mul(root, cube, T(0.044715))),
+                         T(M_2_SQRTPI * M_SQRT1_2)));
+      ops::Mul(root.WithOpName("with_activation"),
+               ops::Mul(root, with_bias, T(0.5)), ops::AddV2(root, tanh, T(1)));
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -289,7 +302,8 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "GeluExact", "GeluApproximate"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, false, false,
                                             activation);
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, true, false,
@@ -302,21 +316,24 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "GeluExact", "GeluApproximate"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 256, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "GeluExact", "GeluApproximate"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 1, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu"}) {
+  for (const string& activation :
+       {"Relu", "Relu6", "Elu", "GeluExact", "GeluApproximate"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 1, false, false,
                                             activation);
   }
@@ -397,6 +414,83 @@ BM_Matmul(16, 1024, 1024, false, false);
 BM_Matmul(128, 1024, 1024, false, false);
 BM_Matmul(4096, 4096, 4096, false, false);
 
+// Transformer feed-forward layers, with and without the fused Gelu.
+template <typename T>
+static Graph* MatmulWithBiasAndGelu(int m, int k, int n, bool approximate,
+                                    bool fused, DataType type) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in0(type, TensorShape({m, k}));
+  in0.flat<T>().setRandom();
+  Tensor in1(type, TensorShape({k, n}));
+  in1.flat<T>().setRandom();
+  Tensor bias(type, TensorShape({n}));
+  bias.flat<T>().setRandom();
+  Node* lhs = test::graph::Constant(g, in0);
+  Node* rhs = test::graph::Constant(g, in1);
+  Node* bias_node = test::graph::Constant(g, bias);
+
+  if (fused) {
+    Node* fused_matmul;
+    TF_CHECK_OK(
+        NodeBuilder(g->NewName("fused_matmul"), "_FusedMatMul")
+            .Input(lhs)
+            .Input(rhs)
+            .Input(std::vector<NodeBuilder::NodeOut>({bias_node}))
+            .Attr("T", type)
+            .Attr("num_args", 1)
+            .Attr("fused_ops", std::vector<string>(
+                                   {"BiasAdd", approximate ? "GeluApproximate"
+                                                           : "GeluExact"}))
+            .Finalize(g, &fused_matmul));
+    return g;
+  }
+
+  auto scalar = [&](float value) {
+    Tensor t(type, TensorShape({}));
+    t.scalar<T>()() = static_cast<T>(value);
+    return test::graph::Constant(g, t);
+  };
+  Node* x = test::graph::BiasAdd(
+      g, test::graph::Matmul(g, lhs, rhs, false, false), bias_node);
+  Node* inner;
+  if (approximate) {
+    Node* cube = test::graph::Binary(
+        g, "Mul", test::graph::Unary(g, "Square", x), x);
+    Node* sum = test::graph::Binary(
+        g, "AddV2", x, test::graph::Binary(g, "Mul", cube, scalar(0.044715)));
+    inner = test::graph::Unary(
+        g, "Tanh",
+        test::graph::Binary(g, "Mul", sum, scalar(M_2_SQRTPI * M_SQRT1_2)));
+  } else {
+    inner = test::graph::Unary(
+        g, "Erf", test::graph::Binary(g, "Mul", x, scalar(M_SQRT1_2)));
+  }
+  test::graph::Binary(g, "Mul", test::graph::Binary(g, "Mul", x, scalar(0.5)),
+                      test::graph::Binary(g, "AddV2", inner, scalar(1)));
+  return g;
+}
+
+#define BM_MatmulWithBiasAndGelu(M, K, N, APPROX, FUSED)                       \
+  static void                                                                 \
+      BM_MatmulWithBiasAndGelu##_##M##_##K##_##N##_##APPROX##_##FUSED(        \
+          int iters) {                                                        \
+    testing::UseRealTime();                                                   \
+    testing::ItemsProcessed(static_cast<int64>(iters) * M * K * N * 2);       \
+    test::Benchmark("cpu", MatmulWithBiasAndGelu<float>(M, K, N, APPROX,      \
+                                                        FUSED, DT_FLOAT))     \
+        .Run(iters);                                                          \
+  }                                                                           \
+  BENCHMARK(BM_MatmulWithBiasAndGelu##_##M##_##K##_##N##_##APPROX##_##FUSED);
+
+BM_MatmulWithBiasAndGelu(128, 768, 3072, false, false);
+BM_MatmulWithBiasAndGelu(128, 768, 3072, false, true);
+BM_MatmulWithBiasAndGelu(128, 768, 3072, true, false);
+BM_MatmulWithBiasAndGelu(128, 768, 3072, true, true);
+BM_MatmulWithBiasAndGelu(8, 1024, 4096, false, false);
+BM_MatmulWithBiasAndGelu(8, 1024, 4096, false, true);
+BM_MatmulWithBiasAndGelu(8, 1024, 4096, true, false);
+BM_MatmulWithBiasAndGelu(8, 1024, 4096, true, true);
+
 // Backward for fully connected layers
 BM_Matmul(1, 1024, 1024, false, true);
 BM_Matmul(8, 1024, 1024, false, true);
@@ -318,7 +318,7 @@ struct RestoreOp {
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes) {
+                        gtl::ArraySlice<DataType> dtypes, bool memory_map) {
   const string& prefix_string = prefix.scalar<tstring>()();
 
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
@@ -358,9 +358,14 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  std::vector<size_t> mapped_idx;
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
+    if (memory_map && shape_and_slice.empty()) {
+      mapped_idx.push_back(i);
+      continue;
+    }
     auto op =
         new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
     if (op->should_run_in_pool(&default_reader)) {
@@ -393,6 +398,21 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     TF_RETURN_IF_ERROR(op->status);
   }
 
+  if (!mapped_idx.empty()) {
+    std::vector<string> keys;
+    keys.reserve(mapped_idx.size());
+    for (const size_t i : mapped_idx) keys.push_back(tensor_names_flat(i));
+    BundleReader::LookupOptions options;
+    options.memory_map = true;
+    options.verify_mapped_checksums = false;
+    std::vector<Tensor> restored_tensors;
+    TF_RETURN_IF_ERROR(
+        default_reader.LookupMany(keys, options, &restored_tensors));
+    for (size_t k = 0; k < mapped_idx.size(); ++k) {
+      context->set_output(mapped_idx[k], restored_tensors[k]);
+    }
+  }
+
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     if (dtypes[i] != context->mutable_output(i)->dtype()) {
@@ -63,10 +63,15 @@ void RestoreTensor(OpKernelContext* context,
 //   * "prefix" has 1 element, DT_STRING.
 //   * "tensor_names" and "shape_and_slices" shaped {N}, both DT_STRING.
 //   * "dtypes" has N elements, the datatypes of the to-restore tensors.
+//
+// If "memory_map" is true, the full tensors aligned in the data files point
+// into the memory-mapped files instead of being read, and their checksums are
+// not validated (see BundleReader::LookupOptions).
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes);
+                        gtl::ArraySlice<DataType> dtypes,
+                        bool memory_map = false);
 
 }  // namespace tensorflow
 
@@ -23,6 +23,7 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -37,7 +38,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -76,6 +79,17 @@ extern bool UnsortedSegmentReductionDoValidation(OpKernel* op_kernel,
                                                  const Tensor& data,
                                                  const Tensor& segment_ids,
                                                  const Tensor& num_segments);
+// Finds the segments of the sorted `segment_vec`: segment s has the id
+// (*segment_ids)[s] and the positions [(*starts)[s], (*starts)[s + 1]).
+extern Status SparseSegmentStarts(const TTypes<int32>::ConstVec& segment_vec,
+                                  int64 output_rows,
+                                  std::vector<int32>* segment_ids,
+                                  std::vector<int64>* starts);
+// Splits the segments found by SparseSegmentStarts into at most `num_blocks`
+// blocks of consecutive segments with about the same number of positions.
+// Block b holds the segments [result[b], result[b + 1]).
+extern std::vector<int64> SparseSegmentBlocks(const std::vector<int64>& starts,
+                                              int64 num_blocks);
 }  // namespace internal
 
 // This operator handles reducing segments along the first dimension.
@@ -324,6 +338,13 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     }
     const int64 N = segment_ids.dimension(0);
     const int64 num_segments = output.dimension(0);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads.num_threads > 1 &&
+        N * data.dimension(1) >= kMinParallelSize) {
+      ParallelReduce(ctx, segment_ids_shape, segment_ids, data, output);
+      return;
+    }
     ReductionF reduction;
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
@@ -337,6 +358,120 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
       reduction(data.template chip<0>(i), output.template chip<0>(j));
     }
   }
+
+ private:
+  // Below this many elements of `data`, the rows are reduced on one thread.
+  static constexpr int64 kMinParallelSize = 1 << 16;
+
+  // Groups the rows of `data` by segment id with a counting sort, and splits
+  // the grouped rows into one block of the same size per thread, so that
+  // skewed ids, where a few segments hold most of the rows, still keep the
+  // threads balanced. Each block reduces the rows of the segments it holds
+  // entirely straight into the output, and the rows of the segments it
+  // shares with its neighbours into rows of its own, which are merged into
+  // the output at the end.
+  static void ParallelReduce(OpKernelContext* ctx,
+                             const TensorShape& segment_ids_shape,
+                             typename TTypes<Index>::ConstFlat segment_ids,
+                             typename TTypes<T, 2>::ConstTensor data,
+                             typename TTypes<T, 2>::Tensor output) {
+    const int64 N = segment_ids.dimension(0);
+    const int64 num_segments = output.dimension(0);
+    std::vector<Index> ids(N);
+    // The rows of segment j are sorted_rows[offsets[j], offsets[j + 1]).
+    std::vector<int64> offsets(num_segments + 1, 0);
+    for (int64 i = 0; i < N; ++i) {
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      ids[i] = j;
+      if (j < 0) {
+        continue;
+      }
+      OP_REQUIRES(ctx, FastBoundsCheck(j, num_segments),
+                  errors::InvalidArgument(
+                      "segment_ids", SliceDebugString(segment_ids_shape, i),
+                      " = ", j, " is out of range [0, ", num_segments, ")"));
+      ++offsets[j + 1];
+    }
+    for (int64 j = 0; j < num_segments; ++j) {
+      offsets[j + 1] += offsets[j];
+    }
+    const int64 num_rows = offsets[num_segments];
+    if (num_rows == 0) {
+      return;
+    }
+    std::vector<int64> sorted_rows(num_rows);
+    {
+      std::vector<int64> next(offsets.begin(), offsets.end() - 1);
+      for (int64 i = 0; i < N; ++i) {
+        if (ids[i] >= 0) {
+          sorted_rows[next[ids[i]]++] = i;
+        }
+      }
+    }
+
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks =
+        std::min<int64>(num_rows, worker_threads.num_threads);
+    // Rows 2 * b and 2 * b + 1 hold the reductions of the first and last
+    // segments of block b when it shares them, whose ids are in
+    // `partial_ids` (or -1).
+    Tensor partial;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::value,
+                            TensorShape({2 * num_blocks, data.dimension(1)}),
+                            &partial));
+    typename TTypes<T, 2>::Tensor partial_rows = partial.tensor<T, 2>();
+    partial_rows.setConstant(InitialValueF()());
+    std::vector<int64> partial_ids(2 * num_blocks, -1);
+
+    auto reduce_blocks = [&](int64 first_block, int64 last_block) {
+      ReductionF reduction;
+      for (int64 b = first_block; b < last_block; ++b) {
+        const int64 begin = num_rows * b / num_blocks;
+        const int64 end = num_rows * (b + 1) / num_blocks;
+        // The last segment whose rows start at or before `begin`.
+        int64 j = std::upper_bound(offsets.begin(), offsets.end(), begin) -
+                  offsets.begin() - 1;
+        for (int64 pos = begin; pos < end; ++j) {
+          if (offsets[j + 1] <= pos) {
+            continue;
+          }
+          int64 partial_row = -1;
+          if (offsets[j] < begin) {
+            partial_row = 2 * b;
+          } else if (offsets[j + 1] > end) {
+            partial_row = 2 * b + 1;
+          }
+          const int64 segment_end = std::min(offsets[j + 1], end);
+          if (partial_row >= 0) {
+            partial_ids[partial_row] = j;
+            for (; pos < segment_end; ++pos) {
+              reduction(data.template chip<0>(sorted_rows[pos]),
+                        partial_rows.template chip<0>(partial_row));
+            }
+          } else {
+            for (; pos < segment_end; ++pos) {
+              reduction(data.template chip<0>(sorted_rows[pos]),
+                        output.template chip<0>(j));
+            }
+          }
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          num_rows / num_blocks * data.dimension(1), reduce_blocks);
+
+    ReductionF reduction;
+    const typename TTypes<T, 2>::ConstTensor partial_data =
+        const_cast<const Tensor&>(partial).tensor<T, 2>();
+    for (int64 r = 0; r < 2 * num_blocks; ++r) {
+      if (partial_ids[r] >= 0) {
+        reduction(partial_data.template chip<0>(r),
+                  output.template chip<0>(partial_ids[r]));
+      }
+    }
+  }
 };
 
 template <typename T>
@@ -502,6 +637,15 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads.num_threads > 1 &&
+        num_indices * num_col >= kMinParallelSize) {
+      ParallelCompute(context, input_flat, indices_vec, segment_vec,
+                      output_rows, output_flat);
+      return;
+    }
+
     int64 start = 0, end = 1;
     // Index from which the output is not initialized.
     OutputRow uninitialized_index = 0;
@@ -531,13 +675,7 @@ class SparseSegmentReductionOpBase : public OpKernel {
 
       // If there is a gap between two indices, we need to set that gap to the
       // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
-      }
+      SetToDefault(output_flat, uninitialized_index, out_index);
 
       auto out = output_flat.template chip<0>(out_index);
       const int bad_offset =
@@ -556,18 +694,77 @@ class SparseSegmentReductionOpBase : public OpKernel {
     }
 
     // Fill the gap at the end with the default value.
-    if (uninitialized_index < output_rows) {
-      Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-          output_rows - uninitialized_index, num_col);
-      Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-          gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-      gap_slice.setConstant(default_value_);
-    }
+    SetToDefault(output_flat, uninitialized_index, output_rows);
   }
 
  private:
   typedef int32 Index;
 
+  // Below this many gathered elements, the segments are reduced on one thread.
+  static constexpr int64 kMinParallelSize = 1 << 16;
+
+  // Reduces the segments on all threads, in blocks of consecutive segments
+  // with about the same number of indices rather than of segments, which
+  // keeps the threads balanced when a few segments hold most of the indices.
+  // A segment is never split across blocks, so that the mean and the square
+  // root reductions see all its rows at once.
+  void ParallelCompute(OpKernelContext* context,
+                       const typename TTypes<T>::ConstMatrix& input_flat,
+                       const typename TTypes<Index>::ConstVec& indices_vec,
+                       const typename TTypes<int32>::ConstVec& segment_vec,
+                       Index output_rows,
+                       typename TTypes<T>::Matrix output_flat) {
+    const int64 num_indices = indices_vec.dimension(0);
+    std::vector<int32> segment_ids;
+    std::vector<int64> starts;
+    OP_REQUIRES_OK(context,
+                   internal::SparseSegmentStarts(segment_vec, output_rows,
+                                                 &segment_ids, &starts));
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const std::vector<int64> block_starts =
+        internal::SparseSegmentBlocks(starts, worker_threads.num_threads);
+    const int64 num_blocks = block_starts.size() - 1;
+
+    mutex mu;
+    int64 bad_index = num_indices;
+    auto reduce_blocks = [&](int64 first_block, int64 last_block) {
+      for (int64 b = first_block; b < last_block; ++b) {
+        for (int64 s = block_starts[b]; s < block_starts[b + 1]; ++s) {
+          SetToDefault(output_flat, s == 0 ? 0 : segment_ids[s - 1] + 1,
+                       segment_ids[s]);
+          const int64 bad_offset =
+              Reduce(input_flat, indices_vec, starts[s],
+                     starts[s + 1] - starts[s],
+                     output_flat.template chip<0>(segment_ids[s]));
+          if (bad_offset >= 0) {
+            mutex_lock l(mu);
+            bad_index = std::min(bad_index, starts[s] + bad_offset);
+          }
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          num_indices / num_blocks * input_flat.dimension(1), reduce_blocks);
+    OP_REQUIRES(context, bad_index == num_indices,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_index, "] == ",
+                    indices_vec(bad_index), " out of range [0, ",
+                    input_flat.dimension(0), ")"));
+    SetToDefault(output_flat, segment_ids.back() + 1, output_rows);
+  }
+
+  // Sets the output rows [begin, end) to the default value.
+  void SetToDefault(typename TTypes<T>::Matrix output_flat, int64 begin,
+                    int64 end) const {
+    if (begin >= end) return;
+    Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+        end - begin, output_flat.dimension(1));
+    Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
+        gap_slice(&output_flat(begin, 0), gap_slice_shape);
+    gap_slice.setConstant(default_value_);
+  }
+
   int64 Reduce(const typename TTypes<T>::ConstMatrix& input_flat,
                const typename TTypes<Index>::ConstVec& indices_vec, int64 start,
                int64 num,
@@ -764,6 +961,110 @@ class SparseSegmentReductionSumWithNumSegmentsOp
             true /* has_num_segments */, T(0) /* default_value */) {}
 };
 
+// Same as SparseSegmentReductionOpBase, but scales each gathered row by its
+// weight, which fuses the Gather, Mul and SegmentSum ops of
+// embedding_lookup_sparse with weights. The rows are reduced straight into
+// the output, on all threads, without materializing the gathered rows.
+template <class T, class Index>
+class SparseSegmentWeightedReductionOp : public OpKernel {
+ public:
+  explicit SparseSegmentWeightedReductionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string combiner;
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner));
+    is_mean_ = combiner == "mean";
+    is_sqrtn_ = combiner == "sqrtn";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& weights = context->input(2);
+    const Tensor& segment_ids = context->input(3);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+                errors::InvalidArgument("weights should be a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+                errors::InvalidArgument("segment_ids should be a vector."));
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES(context,
+                num_indices == segment_ids.NumElements() &&
+                    num_indices == weights.NumElements(),
+                errors::InvalidArgument(
+                    "indices, weights and segment_ids should have same "
+                    "size."));
+
+    const auto input_flat = input.flat_outer_dims<T>();
+    const auto indices_vec = indices.vec<Index>();
+    const auto weights_vec = weights.vec<T>();
+    const auto segment_vec = segment_ids.vec<int32>();
+    const int32 output_rows =
+        num_indices > 0
+            ? internal::SubtleMustCopy(segment_vec(num_indices - 1)) + 1
+            : 0;
+    OP_REQUIRES(context, output_rows >= 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+    std::vector<int32> output_ids;
+    std::vector<int64> starts;
+    OP_REQUIRES_OK(context,
+                   internal::SparseSegmentStarts(segment_vec, output_rows,
+                                                 &output_ids, &starts));
+
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    auto output_flat = output->flat_outer_dims<T>();
+    output_flat.setZero();
+    if (num_indices == 0) return;
+
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const std::vector<int64> block_starts =
+        internal::SparseSegmentBlocks(starts, worker_threads.num_threads);
+    const int64 num_blocks = block_starts.size() - 1;
+    const int64 num_rows = input_flat.dimension(0);
+    mutex mu;
+    int64 bad_index = num_indices;
+    auto reduce_blocks = [&](int64 first_block, int64 last_block) {
+      for (int64 b = first_block; b < last_block; ++b) {
+        for (int64 s = block_starts[b]; s < block_starts[b + 1]; ++s) {
+          auto out = output_flat.template chip<0>(output_ids[s]);
+          T total_weight(0);
+          for (int64 i = starts[s]; i < starts[s + 1]; ++i) {
+            const Index index = internal::SubtleMustCopy(indices_vec(i));
+            if (!FastBoundsCheck(index, num_rows)) {
+              mutex_lock l(mu);
+              bad_index = std::min(bad_index, i);
+              break;
+            }
+            const T weight = weights_vec(i);
+            out += input_flat.template chip<0>(index) * weight;
+            total_weight += is_sqrtn_ ? weight * weight : weight;
+          }
+          if (is_mean_) {
+            out = out / total_weight;
+          } else if (is_sqrtn_) {
+            out = out / static_cast<T>(std::sqrt(total_weight));
+          }
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          num_indices / num_blocks * input_flat.dimension(1), reduce_blocks);
+    OP_REQUIRES(context, bad_index == num_indices,
+                errors::InvalidArgument("Bad: indices[", bad_index, "] == ",
+                                        indices_vec(bad_index),
+                                        " out of range [0, ", num_rows, ")"));
+  }
+
+ private:
+  bool is_mean_;
+  bool is_sqrtn_;
+};
+
 template <class T>
 class SparseSegmentGradOpBase : public OpKernel {
  public:
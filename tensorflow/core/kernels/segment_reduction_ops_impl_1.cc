@@ -64,6 +64,48 @@ bool UnsortedSegmentReductionDoValidation(OpKernel* op_kernel,
   return context->status().ok();
 }
 
+Status SparseSegmentStarts(const TTypes<int32>::ConstVec& segment_vec,
+                           int64 output_rows, std::vector<int32>* segment_ids,
+                           std::vector<int64>* starts) {
+  segment_ids->clear();
+  starts->clear();
+  for (int64 i = 0; i < segment_vec.dimension(0); ++i) {
+    const int32 id = internal::SubtleMustCopy(segment_vec(i));
+    if (!segment_ids->empty()) {
+      if (id == segment_ids->back()) continue;
+      if (segment_ids->back() > id) {
+        return errors::InvalidArgument("segment ids are not increasing");
+      }
+    }
+    if (!FastBoundsCheck(id, output_rows)) {
+      return errors::InvalidArgument(
+          "Segment id ", id, " out of range [0, ", output_rows,
+          "), possibly because 'segment_ids' input is not sorted.");
+    }
+    segment_ids->push_back(id);
+    starts->push_back(i);
+  }
+  starts->push_back(segment_vec.dimension(0));
+  return Status::OK();
+}
+
+std::vector<int64> SparseSegmentBlocks(const std::vector<int64>& starts,
+                                       int64 num_blocks) {
+  const int64 num_segments = starts.size() - 1;
+  const int64 num_positions = starts.back();
+  std::vector<int64> block_starts = {0};
+  for (int64 b = 1; b < num_blocks; ++b) {
+    const int64 s = std::lower_bound(starts.begin(), starts.end() - 1,
+                                     num_positions * b / num_blocks) -
+                    starts.begin();
+    if (s > block_starts.back() && s < num_segments) {
+      block_starts.push_back(s);
+    }
+  }
+  block_starts.push_back(num_segments);
+  return block_starts;
+}
+
 }  // namespace internal
 
 #define REGISTER_CPU_KERNEL_SEGMENT(name, functor, type, index_type, \
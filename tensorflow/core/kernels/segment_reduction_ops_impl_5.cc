@@ -65,6 +65,19 @@ REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type) \
+  REGISTER_KERNEL_BUILDER(                            \
+      Name("SparseSegmentWeightedReduction")          \
+          .Device(DEVICE_CPU)                         \
+          .TypeConstraint<type>("T")                  \
+          .TypeConstraint<index_type>("Tidx"),        \
+      SparseSegmentWeightedReductionOp<type, index_type>);
+REGISTER_CPU_SPARSE_KERNELS(float, int32);
+REGISTER_CPU_SPARSE_KERNELS(float, int64);
+REGISTER_CPU_SPARSE_KERNELS(double, int32);
+REGISTER_CPU_SPARSE_KERNELS(double, int64);
+#undef REGISTER_CPU_SPARSE_KERNELS
+
 #define REGISTER_CPU_SPARSE_KERNELS(type)                     \
   REGISTER_KERNEL_BUILDER(Name("SparseSegmentMeanGrad")       \
                               .Device(DEVICE_CPU)             \
@@ -13,7 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <random>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -166,4 +169,108 @@ static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
 
+// Draws `n` ids in [0, num_ids) from a Zipf distribution of exponent `s`: the
+// ids are uniform for s = 0, and a few small ids take most of the draws for
+// s > 1, like the feature ids of embedding lookups.
+static std::vector<int32> ZipfianIds(int n, int num_ids, double s) {
+  std::vector<double> weights(num_ids);
+  for (int i = 0; i < num_ids; ++i) {
+    weights[i] = 1.0 / std::pow(i + 1, s);
+  }
+  std::mt19937 rng(0);
+  std::discrete_distribution<int32> distribution(weights.begin(),
+                                                 weights.end());
+  std::vector<int32> ids(n);
+  for (int32& id : ids) {
+    id = distribution(rng);
+  }
+  return ids;
+}
+
+static Tensor IdsTensor(const std::vector<int32>& ids) {
+  Tensor t(DT_INT32, TensorShape({static_cast<int64>(ids.size())}));
+  std::copy(ids.begin(), ids.end(), t.flat<int32>().data());
+  return t;
+}
+
+constexpr int kEmbeddingDim = 64;
+
+// Sums `num_rows` gradient rows into num_rows / 16 segments.
+static void UnsortedSegmentSumHelper(int iters, int num_rows, double s) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int num_segments = num_rows / 16;
+  Tensor data(DT_FLOAT, TensorShape({num_rows, kEmbeddingDim}));
+  data.flat<float>().setRandom();
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+          .Input(test::graph::Constant(g, data))
+          .Input(test::graph::Constant(
+              g, IdsTensor(ZipfianIds(num_rows, num_segments, s))))
+          .Input(test::graph::Constant(g, num_segments_t))
+          .Attr("T", DT_FLOAT)
+          .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows *
+                          kEmbeddingDim * sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_UnsortedSegmentSum_Uniform(int iters, int num_rows) {
+  UnsortedSegmentSumHelper(iters, num_rows, 0.0);
+}
+
+static void BM_UnsortedSegmentSum_Zipfian(int iters, int num_rows) {
+  UnsortedSegmentSumHelper(iters, num_rows, 1.1);
+}
+
+BENCHMARK(BM_UnsortedSegmentSum_Uniform)->Arg(1024)->Arg(16384)->Arg(262144);
+BENCHMARK(BM_UnsortedSegmentSum_Zipfian)->Arg(1024)->Arg(16384)->Arg(262144);
+
+// Gathers `num_indices` rows of an embedding with Zipfian indices, and sums
+// them into num_indices / 16 segments of Zipfian sizes.
+static void SparseSegmentSumHelper(int iters, int num_indices, double s) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int num_rows = num_indices;
+  Tensor data(DT_FLOAT, TensorShape({num_rows, kEmbeddingDim}));
+  data.flat<float>().setRandom();
+  std::vector<int32> segment_ids =
+      ZipfianIds(num_indices, num_indices / 16, s);
+  std::sort(segment_ids.begin(), segment_ids.end());
+
+  Node* node;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+          .Input(test::graph::Constant(g, data))
+          .Input(test::graph::Constant(
+              g, IdsTensor(ZipfianIds(num_indices, num_rows, s))))
+          .Input(test::graph::Constant(g, IdsTensor(segment_ids)))
+          .Attr("T", DT_FLOAT)
+          .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_indices *
+                          kEmbeddingDim * sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_SparseSegmentSum_Uniform(int iters, int num_indices) {
+  SparseSegmentSumHelper(iters, num_indices, 0.0);
+}
+
+static void BM_SparseSegmentSum_Zipfian(int iters, int num_indices) {
+  SparseSegmentSumHelper(iters, num_indices, 1.1);
+}
+
+BENCHMARK(BM_SparseSegmentSum_Uniform)->Arg(1024)->Arg(16384)->Arg(262144);
+BENCHMARK(BM_SparseSegmentSum_Zipfian)->Arg(1024)->Arg(16384)->Arg(262144);
+
 }  // namespace tensorflow
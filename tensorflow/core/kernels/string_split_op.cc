@@ -15,6 +15,8 @@ limitations under the License.
 
 // See docs in ../ops/string_ops.cc.
 
+#include <cstring>
+#include <limits>
 #include <string>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
@@ -24,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 namespace {
@@ -157,6 +160,64 @@ std::vector<StringPiece> SplitV2(const tstring& str, StringPiece sep,
   return result;
 }
 
+// Returns the first occurrence of the non-empty `sep` in [begin, end), or
+// nullptr. The candidates are found with memchr, which the C library
+// vectorizes, so most of the input is scanned many bytes at a time.
+const char* FindSeparator(const char* begin, const char* end, StringPiece sep) {
+  while (end - begin >= static_cast<ptrdiff_t>(sep.size())) {
+    const char* candidate = static_cast<const char*>(
+        memchr(begin, sep[0], end - begin - sep.size() + 1));
+    if (candidate == nullptr) {
+      return nullptr;
+    }
+    if (memcmp(candidate + 1, sep.data() + 1, sep.size() - 1) == 0) {
+      return candidate;
+    }
+    begin = candidate + 1;
+  }
+  return nullptr;
+}
+
+// Calls `fn` with each of the tokens SplitV2 returns for `text`, without
+// collecting them.
+template <typename Fn>
+void ForEachSplitV2Token(StringPiece text, StringPiece sep, int maxsplit,
+                         Fn fn) {
+  if (maxsplit == 0) {
+    fn(text);
+    return;
+  }
+
+  int split = 0;
+  if (sep.empty()) {
+    StringPiece token;
+    str_util::RemoveLeadingWhitespace(&text);
+    while (str_util::ConsumeNonWhitespace(&text, &token)) {
+      fn(token);
+      str_util::RemoveLeadingWhitespace(&text);
+      ++split;
+      if (maxsplit > 0 && split == maxsplit) {
+        fn(text);
+        return;
+      }
+    }
+    return;
+  }
+
+  const char* start = text.data();
+  const char* const end = text.data() + text.size();
+  while (maxsplit < 0 || split < maxsplit) {
+    const char* found = FindSeparator(start, end, sep);
+    if (found == nullptr) {
+      break;
+    }
+    fn(StringPiece(start, found - start));
+    start = found + sep.size();
+    ++split;
+  }
+  fn(StringPiece(start, end - start));
+}
+
 }  // namespace
 
 class StringSplitOp : public OpKernel {
@@ -309,8 +370,86 @@ class StringSplitV2Op : public OpKernel {
   int maxsplit_;
 };
 
+// StringSplitV2 followed by StringToHashBucketFast, which hashes the tokens
+// where they are in the input rather than copying them into a string tensor.
+template <typename SPLITS_TYPE>
+class StringSplitToHashBucketFastOp : public OpKernel {
+ public:
+  explicit StringSplitToHashBucketFastOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("maxsplit", &maxsplit_));
+    OP_REQUIRES_OK(context, context->GetAttr("num_buckets", &num_buckets_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor* input_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("input", &input_tensor));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(input_tensor->shape()),
+                errors::InvalidArgument("input must be a vector, got shape: ",
+                                        input_tensor->shape().DebugString()));
+
+    const auto input_vec = input_tensor->vec<tstring>();
+    const int64 batch_size = input_vec.dimension(0);
+
+    const Tensor* sep_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("sep", &sep_tensor));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(sep_tensor->shape()),
+                errors::InvalidArgument("sep must be a scalar, got shape: ",
+                                        sep_tensor->shape().DebugString()));
+    const auto sep_vec = sep_tensor->flat<tstring>();
+    StringPiece sep(sep_vec(0));
+
+    Tensor* row_splits_t;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output("row_splits",
+                                             TensorShape({batch_size + 1}),
+                                             &row_splits_t));
+    auto row_splits = row_splits_t->vec<SPLITS_TYPE>();
+
+    std::vector<int64> buckets;
+    // Guess that we'll be unpacking a handful of tokens per example.
+    static constexpr int kReserveSize = 4;
+    buckets.reserve(batch_size * kReserveSize);
+    const uint64 num_buckets = num_buckets_;
+    row_splits(0) = 0;
+    for (int64 i = 0; i < batch_size; ++i) {
+      ForEachSplitV2Token(input_vec(i), sep, maxsplit_,
+                          [&buckets, num_buckets](StringPiece token) {
+                            // The number of buckets is always in the positive
+                            // range of int64 so is the bucket id.
+                            buckets.push_back(static_cast<int64>(
+                                Fingerprint64(token) % num_buckets));
+                          });
+      row_splits(i + 1) = static_cast<SPLITS_TYPE>(buckets.size());
+    }
+    OP_REQUIRES(ctx,
+                buckets.size() <= std::numeric_limits<SPLITS_TYPE>::max(),
+                errors::InvalidArgument(
+                    "The number of tokens ", buckets.size(),
+                    " does not fit in the type of the row_splits"));
+
+    Tensor* values_t;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            "values",
+                            TensorShape({static_cast<int64>(buckets.size())}),
+                            &values_t));
+    std::copy(buckets.begin(), buckets.end(), values_t->vec<int64>().data());
+  }
+
+ private:
+  int maxsplit_;
+  int64 num_buckets_;
+};
+
 REGISTER_KERNEL_BUILDER(Name("StringSplit").Device(DEVICE_CPU), StringSplitOp);
 REGISTER_KERNEL_BUILDER(Name("StringSplitV2").Device(DEVICE_CPU),
                         StringSplitV2Op);
+REGISTER_KERNEL_BUILDER(Name("StringSplitToHashBucketFast")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<int32>("Tsplits"),
+                        StringSplitToHashBucketFastOp<int32>);
+REGISTER_KERNEL_BUILDER(Name("StringSplitToHashBucketFast")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<int64>("Tsplits"),
+                        StringSplitToHashBucketFastOp<int64>);
 
 }  // namespace tensorflow
@@ -15,10 +15,21 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
 
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
 
+constexpr int SparseRowLocks::kShardBits;
+constexpr int SparseRowLocks::kNumShards;
+
+mutex* SparseRowLocks::Get(const void* var_data, int shard) {
+  static constexpr int kNumMutexes = 1024;
+  static mutex* mutexes = new mutex[kNumMutexes];
+  const uint64 var_hash = Hash64(reinterpret_cast<const char*>(&var_data),
+                                 sizeof(var_data));
+  return &mutexes[(var_hash * kNumShards + shard) % kNumMutexes];
+}
 
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output) {
@@ -127,30 +127,19 @@ mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input, bool sparse,
   return ctx->input_ref_mutex(input);
 }
 
-// MaybeLockVariableInputMutexesInOrder is a helper function to acquire mutexes
-// in address order to mitigate deadlock.  Returns a structure that, when
+// LockVariableInputMutexesInOrder acquires the mutexes of the variables
+// `input_ids` in address order to mitigate deadlock, exclusively if
+// `exclusive` is true and shared otherwise. Returns a structure that, when
 // deleted, will release the acquired mutexes. Safe to pass duplicates - will
 // only lock each distinct mutex once. If sparse is true will ensure the
 // variable gets switched to copy-on-read mode before trying to acquire the
-// locks. If do_lock is false, returns immediately for reference variables. For
-// resource variables in copy-on-read-mode it will grab a shared lock if do_lock
-// is false, exclusive lock otherwise.  Note that this silently doesn't lock
-// mutexes for invalid variable references; in all usages this is followed by
-// GetInputTensor which will signal a failure.
+// locks. Note that this silently doesn't lock mutexes for invalid variable
+// references; in all usages this is followed by GetInputTensor which will
+// signal a failure.
 template <typename Device, typename T>
-VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
-    OpKernelContext* ctx, bool do_lock, bool sparse,
+VariableInputLockHolder LockVariableInputMutexesInOrder(
+    OpKernelContext* ctx, bool exclusive, bool sparse,
     const std::vector<int>& input_ids) {
-  bool any_resource = false;
-  for (auto i : input_ids) {
-    if (ctx->input_dtype(i) == DT_RESOURCE) {
-      any_resource = true;
-      break;
-    }
-  }
-  if (!do_lock && !any_resource) {
-    return VariableInputLockHolder({}, {}, {});
-  }
   std::vector<Var*> vars;
   std::vector<mutex*> mutexes;
   std::vector<int> acquire_order;
@@ -177,7 +166,7 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
     mutex* mu = GetTrainingVariableMutex<Device, T>(ctx, input, sparse, &var);
     core::ScopedUnref scoped_unref(var);
     if (mu != nullptr) {
-      if (!sparse || do_lock) {
+      if (exclusive) {
         locks->emplace_back(*mu);
       } else {
         shared_locks->emplace_back(*mu);
@@ -188,6 +177,67 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
                                  std::move(shared_locks));
 }
 
+// MaybeLockVariableInputMutexesInOrder is a helper function to acquire mutexes
+// in address order to mitigate deadlock, see LockVariableInputMutexesInOrder.
+// If do_lock is false, returns immediately for reference variables. For
+// resource variables in copy-on-read-mode it will grab a shared lock if do_lock
+// is false, exclusive lock otherwise.
+template <typename Device, typename T>
+VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
+    OpKernelContext* ctx, bool do_lock, bool sparse,
+    const std::vector<int>& input_ids) {
+  bool any_resource = false;
+  for (auto i : input_ids) {
+    if (ctx->input_dtype(i) == DT_RESOURCE) {
+      any_resource = true;
+      break;
+    }
+  }
+  if (!do_lock && !any_resource) {
+    return VariableInputLockHolder({}, {}, {});
+  }
+  return LockVariableInputMutexesInOrder<Device, T>(
+      ctx, /*exclusive=*/!sparse || do_lock, sparse, input_ids);
+}
+
+// Locks the variables `input_ids` of a sparse update of their rows, see
+// SparseRowLocks. If lock_rows is true the variables are locked shared, so
+// that dense updates are excluded while the sparse updates only exclude each
+// other on the shards of rows they share. Otherwise it behaves like
+// MaybeLockVariableInputMutexesInOrder without do_lock.
+template <typename Device, typename T>
+VariableInputLockHolder LockVariableInputMutexesForRowsInOrder(
+    OpKernelContext* ctx, bool lock_rows, const std::vector<int>& input_ids) {
+  if (lock_rows) {
+    return LockVariableInputMutexesInOrder<Device, T>(
+        ctx, /*exclusive=*/false, /*sparse=*/true, input_ids);
+  }
+  return MaybeLockVariableInputMutexesInOrder<Device, T>(
+      ctx, /*do_lock=*/false, /*sparse=*/true, input_ids);
+}
+
+// Striped locks of the rows of the variables updated by the sparse training
+// ops with `use_locking`. The rows of a variable are split into kNumShards
+// shards, and each shard maps to one of a fixed pool of mutexes, so that
+// concurrent updates of disjoint shards of a large embedding table do not
+// wait for each other.
+class SparseRowLocks {
+ public:
+  static constexpr int kShardBits = 5;
+  static constexpr int kNumShards = 1 << kShardBits;
+
+  // Returns the shard of `row`, in [0, kNumShards).
+  static int Shard(int64 row) {
+    // Fibonacci hashing, so that neighbouring rows land in different shards.
+    const uint64 hash = static_cast<uint64>(row) * 0x9E3779B97F4A7C15ull;
+    return static_cast<int>(hash >> (64 - kShardBits));
+  }
+
+  // Returns the mutex of the shard `shard` of the variable whose buffer starts
+  // at `var_data`.
+  static mutex* Get(const void* var_data, int shard);
+};
+
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
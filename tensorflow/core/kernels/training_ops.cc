@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -47,6 +48,66 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// Calls `update(i, row)` for each update `i` of `row = indices(i)` of the
+// sparse training ops on the CPU. The updates are grouped by the shard of
+// their row (see SparseRowLocks) and the shards are spread over the CPU worker
+// threads, so that the updates of a row run on one thread in the order of the
+// indices, which keeps repeated indices deterministic. If `lock_rows` is true,
+// each shard is updated under its row lock of `var`. `cost_per_update` is the
+// cost in cycles of one call to `update`.
+template <typename Tindex, typename UpdateFn>
+Status ApplyByRowShard(OpKernelContext* ctx, const Tensor& var,
+                       typename TTypes<Tindex>::ConstVec indices,
+                       bool lock_rows, int64 cost_per_update, UpdateFn update) {
+  const Tindex N = indices.dimension(0);
+  const Tindex first_dim_size = var.dim_size(0);
+  std::vector<Tindex> rows(N);
+  std::vector<int64> shard_starts(SparseRowLocks::kNumShards + 1, 0);
+  for (Tindex i = 0; i < N; ++i) {
+    const Tindex index = internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(index, first_dim_size)) {
+      return errors::InvalidArgument(strings::StrCat(
+          "Index ", index, " at offset ", i, " in indices is out of range"));
+    }
+    rows[i] = index;
+    ++shard_starts[SparseRowLocks::Shard(index) + 1];
+  }
+  for (int s = 0; s < SparseRowLocks::kNumShards; ++s) {
+    shard_starts[s + 1] += shard_starts[s];
+  }
+  // The updates sorted by shard, stable so that each row keeps the order of
+  // its updates.
+  std::vector<Tindex> order(N);
+  std::vector<int64> next(shard_starts.begin(), shard_starts.end() - 1);
+  for (Tindex i = 0; i < N; ++i) {
+    order[next[SparseRowLocks::Shard(rows[i])]++] = i;
+  }
+
+  const void* var_data = var.tensor_data().data();
+  const auto update_shard = [&](int shard) {
+    for (int64 j = shard_starts[shard]; j < shard_starts[shard + 1]; ++j) {
+      const Tindex i = order[j];
+      update(i, rows[i]);
+    }
+  };
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        SparseRowLocks::kNumShards,
+        std::max<int64>(1, cost_per_update * N / SparseRowLocks::kNumShards),
+        [&](int64 begin, int64 end) {
+          for (int64 shard = begin; shard < end; ++shard) {
+            if (shard_starts[shard] == shard_starts[shard + 1]) continue;
+            if (lock_rows) {
+              mutex_lock l(*SparseRowLocks::Get(var_data, shard));
+              update_shard(shard);
+            } else {
+              update_shard(shard);
+            }
+          }
+        });
+  return Status::OK();
+}
 }  // namespace
 
 namespace functor {
@@ -1606,8 +1667,8 @@ class SparseApplyAdagradOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = LockVariableInputMutexesForRowsInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -1656,76 +1717,43 @@ class SparseApplyAdagradOp : public OpKernel {
                 errors::InvalidArgument(
                     "Inner dimension should be greater than zero."));
 
-    // This op is implemented only for CPU device.
-    const auto& d = ctx->eigen_cpu_device();
-
     if (N > 0) {
-      const int in_bytes = inner_dim * sizeof(T) * 3;
-      const int out_bytes = inner_dim * sizeof(T) * 2;
-      const int cycles = inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 2 +
-                                      Eigen::TensorOpCost::MulCost<T>() * 2);
-      const Eigen::TensorOpCost cost(in_bytes, out_bytes, cycles);
-
+      const int64 cost =
+          inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 2 +
+                       Eigen::TensorOpCost::MulCost<T>() * 2);
+      T lr_scalar = lr.scalar<T>()();
       if (inner_dim > 1) {
-        const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto grad_flat = grad.flat_outer_dims<T>();
-        T lr_scalar = lr.scalar<T>()();
-
-        for (Tindex i = 0; i < N; ++i) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-        }
-
-        const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-          for (Tindex i = start_idx; i < end_idx; ++i) {
-            const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-            auto a = accum_flat.template chip<0>(index);
-            auto g = grad_flat.template chip<0>(i);
-            auto v = var_flat.template chip<0>(index);
-            if (update_slots_) {
-              a += g.square();
-            }
-            v -= g.constant(lr_scalar) * g * a.rsqrt();
-          }
-        };
-
-        d.parallelFor(N, cost, shard);
-
+        OP_REQUIRES_OK(
+            ctx, ApplyByRowShard<Tindex>(
+                     ctx, var, indices.vec<Tindex>(), use_exclusive_lock_,
+                     cost, [&](Tindex i, Tindex index) {
+                       auto a = accum_flat.template chip<0>(index);
+                       auto g = grad_flat.template chip<0>(i);
+                       auto v = var_flat.template chip<0>(index);
+                       if (update_slots_) {
+                         a += g.square();
+                       }
+                       v -= g.constant(lr_scalar) * g * a.rsqrt();
+                     }));
       } else {
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto grad_flat = grad.flat<T>();
-        T lr_scalar = lr.scalar<T>()();
-        const Tindex first_dim_size = accum_flat.size();
-
-        for (Tindex i = 0; i < N; ++i) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-        }
-
-        const auto shard = [&](Tindex start_idx, Tindex end_idx) -> void {
-          for (Tindex i = start_idx; i < end_idx; ++i) {
-            const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-            T& a = accum_flat(index);
-            const T& g = grad_flat(i);
-            if (update_slots_) {
-              a += g * g;
-            }
-            var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-          }
-        };
-
-        d.parallelFor(N, cost, shard);
+        OP_REQUIRES_OK(
+            ctx, ApplyByRowShard<Tindex>(
+                     ctx, var, indices.vec<Tindex>(), use_exclusive_lock_,
+                     cost, [&](Tindex i, Tindex index) {
+                       T& a = accum_flat(index);
+                       const T& g = grad_flat(i);
+                       if (update_slots_) {
+                         a += g * g;
+                       }
+                       var_flat(index) -=
+                           lr_scalar * g / Eigen::numext::sqrt(a);
+                     }));
       }
     }
 
@@ -2613,8 +2641,8 @@ class SparseApplyFtrlOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+    auto locks = LockVariableInputMutexesForRowsInOrder<Device, T>(
+        ctx, use_exclusive_lock_, {0, 1, 2});
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
                             ctx, 0, use_exclusive_lock_, sparse, &var));
@@ -2713,9 +2741,12 @@ class SparseApplyFtrlOp : public OpKernel {
     }
 
     if (N > 0) {
+      // The FTRL update takes a few powers or square roots per element.
+      const int64 cost =
+          inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 8 +
+                       Eigen::TensorOpCost::MulCost<T>() * 8 +
+                       Eigen::TensorOpCost::DivCost<T>() * 3);
       if (inner_dim > 1) {
-        const Tindex first_dim_size = var.dim_size(0);
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat_outer_dims<T>();
         auto accum_flat = accum.flat_outer_dims<T>();
         auto linear_flat = linear.flat_outer_dims<T>();
@@ -2729,12 +2760,7 @@ class SparseApplyFtrlOp : public OpKernel {
         }
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        const auto update = [&](Tindex i, Tindex index) {
           auto accum = accum_flat.template chip<0>(index);
           auto linear = linear_flat.template chip<0>(index);
           auto grad = grad_flat.template chip<0>(i);
@@ -2772,8 +2798,12 @@ class SparseApplyFtrlOp : public OpKernel {
           } else {
             COMPUTE_FTRL(grad, grad);
           }
-        }
+        };
 #undef COMPUTE_FTRL
+        OP_REQUIRES_OK(ctx, ApplyByRowShard<Tindex>(ctx, var,
+                                                    indices.vec<Tindex>(),
+                                                    use_exclusive_lock_, cost,
+                                                    update));
       } else {
         T lr_scalar = lr.scalar<T>()();
         T l1_scalar = l1.scalar<T>()();
@@ -2784,19 +2814,12 @@ class SparseApplyFtrlOp : public OpKernel {
           l2_shrinkage_scalar = l2_shrinkage->scalar<T>()();
         }
 
-        auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
         auto accum_flat = accum.flat<T>();
         auto linear_flat = linear.flat<T>();
         auto grad_flat = grad.flat<T>();
-        const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        const auto update = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           T& l = linear_flat(index);
           T& v = var_flat(index);
@@ -2817,7 +2840,11 @@ class SparseApplyFtrlOp : public OpKernel {
                           lr_power_scalar);
           a = updated_a;
           l = updated_l;
-        }
+        };
+        OP_REQUIRES_OK(ctx, ApplyByRowShard<Tindex>(ctx, var,
+                                                    indices.vec<Tindex>(),
+                                                    use_exclusive_lock_, cost,
+                                                    update));
       }
     }
 
@@ -3010,8 +3037,8 @@ class SparseApplyMomentumOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
     const bool sparse = true;
-    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
-        ctx, use_exclusive_lock_, sparse, {0, 1});
+    auto locks = LockVariableInputMutexesForRowsInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, {0, 1});
 
     Tensor var;
     OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
@@ -3061,31 +3088,32 @@ class SparseApplyMomentumOp : public OpKernel {
                                         momentum.shape().DebugString()));
 
     if (N > 0) {
-      const Tindex first_dim_size = var.dim_size(0);
-      auto indices_vec = indices.vec<Tindex>();
+      const int64 inner_dim = grad.NumElements() / N;
+      const int64 cost =
+          inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 3 +
+                       Eigen::TensorOpCost::MulCost<T>() * 4);
       auto var_flat = var.flat_outer_dims<T>();
       auto accum_flat = accum.flat_outer_dims<T>();
       auto grad_flat = grad.flat_outer_dims<T>();
       T lr_scalar = lr.scalar<T>()();
       T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-        OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-        auto a = accum_flat.template chip<0>(index);
-        auto g = grad_flat.template chip<0>(i);
-        auto v = var_flat.template chip<0>(index);
-        a = a * a.constant(momentum_scalar) + g;
-        if (use_nesterov_) {
-          v -= g.constant(lr_scalar) * g +
-               a.constant(lr_scalar) * a.constant(momentum_scalar) * a;
-        } else {
-          v -= a.constant(lr_scalar) * a;
-        }
-      }
+      OP_REQUIRES_OK(
+          ctx,
+          ApplyByRowShard<Tindex>(
+              ctx, var, indices.vec<Tindex>(), use_exclusive_lock_, cost,
+              [&](Tindex i, Tindex index) {
+                auto a = accum_flat.template chip<0>(index);
+                auto g = grad_flat.template chip<0>(i);
+                auto v = var_flat.template chip<0>(index);
+                a = a * a.constant(momentum_scalar) + g;
+                if (use_nesterov_) {
+                  v -= g.constant(lr_scalar) * g +
+                       a.constant(lr_scalar) * a.constant(momentum_scalar) * a;
+                } else {
+                  v -= a.constant(lr_scalar) * a;
+                }
+              }));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -3676,6 +3704,162 @@ REGISTER_KERNELS(GPU, complex128);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Note, this op works on cpu only.
+template <typename T, typename Tindex>
+class SparseApplyAdamOp : public OpKernel {
+ public:
+  explicit SparseApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+  }
+
+  void Compute(OpKernelContext* ctx) override NO_THREAD_SAFETY_ANALYSIS {
+    const bool sparse = true;
+    auto locks = LockVariableInputMutexesForRowsInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, {0, 1, 2});
+
+    Tensor var;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor m;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &m));
+    Tensor v;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, sparse, &v));
+    OP_REQUIRES(
+        ctx, var.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(0)));
+    OP_REQUIRES(
+        ctx, m.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(1)));
+    OP_REQUIRES(
+        ctx, v.IsInitialized(),
+        errors::FailedPrecondition(
+            "Attempting to use uninitialized variables: ", requested_input(2)));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(m.shape()),
+                errors::InvalidArgument("var and m do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        m.shape().DebugString()));
+    OP_REQUIRES(ctx, var.shape().IsSameSize(v.shape()),
+                errors::InvalidArgument("var and v do not have the same shape",
+                                        var.shape().DebugString(), " ",
+                                        v.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(var.shape()),
+                errors::InvalidArgument("var must be at least 1 dimensional"));
+
+    const Tensor& beta1_power = ctx->input(3);
+    const Tensor& beta2_power = ctx->input(4);
+    const Tensor& lr = ctx->input(5);
+    const Tensor& beta1 = ctx->input(6);
+    const Tensor& beta2 = ctx->input(7);
+    const Tensor& epsilon = ctx->input(8);
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1_power.shape()),
+                errors::InvalidArgument("beta1_power is not a scalar: ",
+                                        beta1_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2_power.shape()),
+                errors::InvalidArgument("beta2_power is not a scalar: ",
+                                        beta2_power.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar : ",
+                                        lr.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta1.shape()),
+                errors::InvalidArgument("beta1 is not a scalar: ",
+                                        beta1.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(beta2.shape()),
+                errors::InvalidArgument("beta2 is not a scalar: ",
+                                        beta2.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(epsilon.shape()),
+                errors::InvalidArgument("epsilon is not a scalar: ",
+                                        epsilon.shape().DebugString()));
+
+    const Tensor& grad = ctx->input(9);
+    const Tensor& indices = ctx->input(10);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
+                errors::InvalidArgument("indices must be one-dimensional"));
+    OP_REQUIRES(ctx, var.dims() == grad.dims(),
+                errors::InvalidArgument("var and grad must have the same rank",
+                                        var.shape().DebugString(), " ",
+                                        grad.shape().DebugString()));
+    for (int d = 1; d < var.dims(); d++) {
+      OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
+                  errors::InvalidArgument(strings::StrCat(
+                      "var and grad must match in dimension ", d)));
+    }
+    const Tindex N = indices.dim_size(0);
+    OP_REQUIRES(
+        ctx, grad.dim_size(0) == N,
+        errors::InvalidArgument(
+            "grad must be the same size as indices in the first dimension."));
+
+    if (N > 0) {
+      const int64 inner_dim = grad.NumElements() / N;
+      const int64 cost =
+          inner_dim * (Eigen::TensorOpCost::AddCost<T>() * 5 +
+                       Eigen::TensorOpCost::MulCost<T>() * 5 +
+                       Eigen::TensorOpCost::DivCost<T>() * 2);
+      auto var_flat = var.flat_outer_dims<T>();
+      auto m_flat = m.flat_outer_dims<T>();
+      auto v_flat = v.flat_outer_dims<T>();
+      auto grad_flat = grad.flat_outer_dims<T>();
+      const T beta1_scalar = beta1.scalar<T>()();
+      const T beta2_scalar = beta2.scalar<T>()();
+      const T epsilon_scalar = epsilon.scalar<T>()();
+      const T alpha = lr.scalar<T>()() *
+                      Eigen::numext::sqrt(T(1) - beta2_power.scalar<T>()()) /
+                      (T(1) - beta1_power.scalar<T>()());
+
+      // Only the moments of the rows in indices are decayed, unlike the dense
+      // update.
+      OP_REQUIRES_OK(
+          ctx,
+          ApplyByRowShard<Tindex>(
+              ctx, var, indices.vec<Tindex>(), use_exclusive_lock_, cost,
+              [&](Tindex i, Tindex index) {
+                auto m_row = m_flat.template chip<0>(index);
+                auto v_row = v_flat.template chip<0>(index);
+                auto var_row = var_flat.template chip<0>(index);
+                auto g = grad_flat.template chip<0>(i);
+                m_row += (g - m_row) * m_row.constant(T(1) - beta1_scalar);
+                v_row +=
+                    (g.square() - v_row) * v_row.constant(T(1) - beta2_scalar);
+                var_row -= (m_row * m_row.constant(alpha)) /
+                           (v_row.sqrt() + v_row.constant(epsilon_scalar));
+              }));
+    }
+
+    MaybeForwardRefInputToRefOutput(ctx, 0, 0);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+};
+
+#define REGISTER_KERNELS(T, Tindices)                                \
+  REGISTER_KERNEL_BUILDER(Name("SparseApplyAdam")                    \
+                              .Device(DEVICE_CPU)                    \
+                              .TypeConstraint<T>("T")                \
+                              .TypeConstraint<Tindices>("Tindices"), \
+                          SparseApplyAdamOp<T, Tindices>);           \
+  REGISTER_KERNEL_BUILDER(Name("ResourceSparseApplyAdam")            \
+                              .Device(DEVICE_CPU)                    \
+                              .TypeConstraint<T>("T")                \
+                              .TypeConstraint<Tindices>("Tindices"), \
+                          SparseApplyAdamOp<T, Tindices>);
+#define REGISTER_CPU_KERNELS(T) \
+  REGISTER_KERNELS(T, int32);   \
+  REGISTER_KERNELS(T, int64);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_bfloat16(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyAdamWithAmsgradOp : public OpKernel {
  public:
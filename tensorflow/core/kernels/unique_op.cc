@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -24,11 +26,153 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// The smallest input that is partitioned across the CPU threads.
+constexpr int64 kParallelUniqueMinSize = 1 << 16;
+
+// The most partitions of a parallel unique.
+constexpr int kMaxUniquePartitions = 64;
+
+// Mixes the bits of a hash (the finalizer of MurmurHash3), so that both its top
+// bits, which pick the partition, and its low bits, which pick the slot, are
+// well distributed even for the identity hash of the integers.
+inline uint64 MixHash(uint64 h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+// An open-addressing hash set, with linear probing, of the positions of the
+// distinct values of `values`. It holds at most `max_size` positions.
+template <typename T>
+class FirstOccurrenceTable {
+ public:
+  FirstOccurrenceTable(const T* values, int64 max_size) : values_(values) {
+    int64 capacity = 16;
+    while (capacity < 2 * max_size) capacity *= 2;
+    mask_ = capacity - 1;
+    positions_.resize(capacity, -1);
+    hashes_.resize(capacity);
+  }
+
+  // Returns the position of the value equal to values[i] already in the
+  // table, or inserts and returns i if there is none.
+  int32 FindOrInsert(int32 i, uint64 hash) {
+    for (uint64 slot = hash & mask_;; slot = (slot + 1) & mask_) {
+      const int32 j = positions_[slot];
+      if (j < 0) {
+        positions_[slot] = i;
+        hashes_[slot] = hash;
+        return i;
+      }
+      if (hashes_[slot] == hash && values_[j] == values_[i]) return j;
+    }
+  }
+
+ private:
+  const T* values_;
+  uint64 mask_;
+  std::vector<int32> positions_;
+  std::vector<uint64> hashes_;
+};
+
+// Sets (*first)[i] to the position of the first value equal to values[i].
+//
+// Large inputs are partitioned by hash across the CPU threads. The values of
+// each partition keep their input order, so that every partition sees the
+// first occurrences of its values first, and the result does not depend on
+// the number of threads.
+template <typename T>
+void FindFirstOccurrences(OpKernelContext* context, const T* values, int32 n,
+                          std::vector<int32>* first) {
+  first->resize(n);
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  if (n < kParallelUniqueMinSize || worker_threads->num_threads <= 1) {
+    FirstOccurrenceTable<T> table(values, n);
+    for (int32 i = 0; i < n; ++i) {
+      (*first)[i] = table.FindOrInsert(i, MixHash(hash<T>{}(values[i])));
+    }
+    return;
+  }
+
+  int partition_bits = 0;
+  while ((1 << partition_bits) < worker_threads->num_threads &&
+         (1 << partition_bits) < kMaxUniquePartitions) {
+    ++partition_bits;
+  }
+  const int num_partitions = 1 << partition_bits;
+  const auto partition = [partition_bits](uint64 hash) {
+    return static_cast<int>(hash >> (64 - partition_bits));
+  };
+  // The input is split in as many blocks as there are partitions.
+  const int num_blocks = num_partitions;
+  const auto block_start = [n, num_blocks](int64 b) {
+    return static_cast<int32>(b * n / num_blocks);
+  };
+
+  // Hashes the values, and counts the values of each partition in each block.
+  std::vector<uint64> hashes(n);
+  std::vector<int64> offsets(num_blocks * num_partitions, 0);
+  Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+        50 * n / num_blocks, [&](int64 begin, int64 end) {
+          for (int64 b = begin; b < end; ++b) {
+            int64* counts = &offsets[b * num_partitions];
+            for (int32 i = block_start(b); i < block_start(b + 1); ++i) {
+              hashes[i] = MixHash(hash<T>{}(values[i]));
+              ++counts[partition(hashes[i])];
+            }
+          }
+        });
+
+  // The values of a partition are grouped together, block after block.
+  std::vector<int64> partition_starts(num_partitions + 1);
+  int64 offset = 0;
+  for (int p = 0; p < num_partitions; ++p) {
+    partition_starts[p] = offset;
+    for (int b = 0; b < num_blocks; ++b) {
+      const int64 count = offsets[b * num_partitions + p];
+      offsets[b * num_partitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_starts[num_partitions] = offset;
+  std::vector<int32> order(n);
+  Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+        5 * n / num_blocks, [&](int64 begin, int64 end) {
+          for (int64 b = begin; b < end; ++b) {
+            int64* next = &offsets[b * num_partitions];
+            for (int32 i = block_start(b); i < block_start(b + 1); ++i) {
+              order[next[partition(hashes[i])]++] = i;
+            }
+          }
+        });
+
+  Shard(worker_threads->num_threads, worker_threads->workers, num_partitions,
+        50 * n / num_partitions, [&](int64 begin, int64 end) {
+          for (int64 p = begin; p < end; ++p) {
+            FirstOccurrenceTable<T> table(
+                values, partition_starts[p + 1] - partition_starts[p]);
+            for (int64 j = partition_starts[p]; j < partition_starts[p + 1];
+                 ++j) {
+              const int32 i = order[j];
+              (*first)[i] = table.FindOrInsert(i, hashes[i]);
+            }
+          }
+        });
+}
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -101,22 +245,22 @@ class UniqueOp : public OpKernel {
     int64 uniq_size;
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
-      // elements. Here we put T directly into the map rather than ints pointing
-      // to them as in the general case.
+      // elements. Here we hash the elements directly in an open-addressing
+      // table, in parallel for large inputs.
       auto Tin = input.flat<T>();
-      const int64 N = static_cast<int64>(Tin.size());
+      const int32 N = static_cast<int32>(Tin.size());
 
-      std::unordered_map<T, TIndex> uniq;
-      uniq.reserve(2 * N);
-      for (Eigen::Index i = 0, j = 0; i < N; ++i) {
-        auto it = uniq.insert(std::make_pair(Tin(i), j));
-        idx_vec(i) = it.first->second;
-        if (it.second) {
-          ++j;
-        }
+      std::vector<int32> first;
+      FindFirstOccurrences(context, Tin.data(), N, &first);
+
+      // The unique elements are numbered in the order of their first
+      // occurrences.
+      TIndex j = 0;
+      for (int32 i = 0; i < N; ++i) {
+        idx_vec(i) = first[i] == i ? j++ : idx_vec(first[i]);
       }
 
-      uniq_size = static_cast<int64>(uniq.size());
+      uniq_size = static_cast<int64>(j);
       TensorShape output_shape(input.shape());
       output_shape.set_dim(axis, uniq_size);
       Tensor* output = nullptr;
@@ -124,8 +268,10 @@ class UniqueOp : public OpKernel {
                      context->allocate_output(0, output_shape, &output));
       auto Tout = output->flat<T>();
 
-      for (auto it : uniq) {
-        Tout(it.second) = it.first;
+      for (int32 i = 0; i < N; ++i) {
+        if (first[i] == i) {
+          Tout(idx_vec(i)) = Tin(i);
+        }
       }
     } else {
       // General implementation when unique is run over multiple elements.
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -102,6 +103,32 @@ static void BM_Unique_INT32_Repeat(int iters, int dim, int max_int) {
   test::Benchmark("cpu", g).Run(iters);
 }
 
+// Benchmarks the unique of `dim` int64 ids, of which about `dim / repeat` are
+// distinct, as in a batch of sparse feature ids.
+static void BM_Unique_INT64_Ids(int iters, int dim, int repeat) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_INT64, TensorShape({dim}));
+  auto input_vec = input.vec<int64>();
+  const int num_distinct = std::max(1, dim / repeat);
+  for (int i = 0; i < dim; ++i) {
+    // Spread the ids over the whole int64 range.
+    input_vec(i) = (std::rand() % num_distinct) * 0x9E3779B97F4A7C15ll;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Unique")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * dim * sizeof(int64));
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
 TensorProto GetRandomStringsTensorProto(int dim, int max_str_len) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_STRING);
@@ -180,6 +207,17 @@ BENCHMARK(BM_Unique_INT32_Repeat)
     ->ArgPair(64 * 1024, 64 * 1024 * 1024)
     ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
 
+BENCHMARK(BM_Unique_INT64_Ids)
+    ->ArgPair(16 * 1024, 1)
+    ->ArgPair(16 * 1024, 4)
+    ->ArgPair(16 * 1024, 64)
+    ->ArgPair(256 * 1024, 1)
+    ->ArgPair(256 * 1024, 4)
+    ->ArgPair(256 * 1024, 64)
+    ->ArgPair(4 * 1024 * 1024, 1)
+    ->ArgPair(4 * 1024 * 1024, 4)
+    ->ArgPair(4 * 1024 * 1024, 64);
+
 BENCHMARK(BM_Unique_STRING)
     ->Arg(32)
     ->Arg(256)
@@ -0,0 +1,180 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+string GenTestString(int size) {
+  string result;
+  for (int i = 0; result.size() < static_cast<size_t>(size); ++i) {
+    strings::StrAppend(&result, "record ", i, ", ");
+  }
+  result.resize(size);
+  return result;
+}
+
+class BlockZlibBuffersTest
+    : public ::testing::TestWithParam<std::tuple<int64, int>> {
+ protected:
+  // Writes `data` in pieces of `piece_bytes`, flushing after `flush_after`
+  // bytes if it is not negative.
+  void WriteFile(const string& data, size_t piece_bytes,
+                 int64 flush_after = -1) {
+    fname_ = testing::TmpDir() + "/block_zlib_buffers_test";
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(fname_, &file));
+    ZlibCompressionOptions options;
+    options.block_size = block_size();
+    BlockZlibOutputBuffer out(file.get(), options);
+    for (size_t i = 0; i < data.size(); i += piece_bytes) {
+      TF_ASSERT_OK(out.Append(StringPiece(data).substr(i, piece_bytes)));
+      if (flush_after >= 0 && i <= static_cast<size_t>(flush_after) &&
+          static_cast<size_t>(flush_after) < i + piece_bytes) {
+        TF_ASSERT_OK(out.Flush());
+      }
+    }
+    TF_ASSERT_OK(out.Close());
+    TF_ASSERT_OK(file->Close());
+    TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname_, &read_file_));
+  }
+
+  int64 block_size() const { return std::get<0>(GetParam()); }
+  int num_parallel_blocks() const { return std::get<1>(GetParam()); }
+
+  string fname_;
+  std::unique_ptr<RandomAccessFile> read_file_;
+};
+
+TEST_P(BlockZlibBuffersTest, ReadNBytes) {
+  const string data = GenTestString(10000);
+  WriteFile(data, 333);
+  BlockZlibInputStream in(read_file_.get(), num_parallel_blocks());
+  tstring read;
+  string result;
+  for (int bytes : {1, 0, 17, 1000, 4000}) {
+    TF_ASSERT_OK(in.ReadNBytes(bytes, &read));
+    EXPECT_EQ(bytes, read.size());
+    result.append(read.data(), read.size());
+    EXPECT_EQ(result.size(), in.Tell());
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(10000, &read)));
+  result.append(read.data(), read.size());
+  EXPECT_EQ(data, result);
+  EXPECT_EQ(data.size(), in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  EXPECT_EQ(read, "");
+}
+
+TEST_P(BlockZlibBuffersTest, FlushEndsBlock) {
+  const string data = GenTestString(5000);
+  WriteFile(data, 100, /*flush_after=*/250);
+  BlockZlibInputStream in(read_file_.get(), num_parallel_blocks());
+  tstring read;
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(6000, &read)));
+  EXPECT_EQ(data, read);
+}
+
+TEST_P(BlockZlibBuffersTest, SkipNBytes) {
+  const string data = GenTestString(10000);
+  WriteFile(data, 10000);
+  BlockZlibInputStream in(read_file_.get(), num_parallel_blocks());
+  tstring read;
+  TF_ASSERT_OK(in.SkipNBytes(0));
+  TF_ASSERT_OK(in.SkipNBytes(3));
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+  EXPECT_EQ(data.substr(3, 10), read);
+  TF_ASSERT_OK(in.SkipNBytes(5000));
+  EXPECT_EQ(5013, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(100, &read));
+  EXPECT_EQ(data.substr(5013, 100), read);
+  TF_ASSERT_OK(in.SkipNBytes(4887));
+  EXPECT_EQ(10000, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(1)));
+}
+
+TEST_P(BlockZlibBuffersTest, Reset) {
+  const string data = GenTestString(3000);
+  WriteFile(data, 1000);
+  BlockZlibInputStream in(read_file_.get(), num_parallel_blocks());
+  tstring read;
+  TF_ASSERT_OK(in.ReadNBytes(2500, &read));
+  TF_ASSERT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(3000, &read));
+  EXPECT_EQ(data, read);
+  TF_ASSERT_OK(in.Reset());
+  TF_ASSERT_OK(in.SkipNBytes(1500));
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+  EXPECT_EQ(data.substr(1500, 10), read);
+}
+
+TEST_P(BlockZlibBuffersTest, IndexFooter) {
+  const string data = GenTestString(4000);
+  WriteFile(data, 4000);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname_, &contents));
+  const size_t footer = contents.size() - BlockZlibOutputBuffer::kFooterSize;
+  const uint64 index_offset = core::DecodeFixed64(&contents[footer]);
+  const uint64 num_blocks = core::DecodeFixed64(&contents[footer + 8]);
+  EXPECT_EQ(BlockZlibOutputBuffer::kMagic,
+            core::DecodeFixed64(&contents[footer + 16]));
+  EXPECT_EQ((4000 + block_size() - 1) / block_size(), num_blocks);
+  EXPECT_EQ(footer, index_offset +
+                        num_blocks * BlockZlibOutputBuffer::kIndexEntrySize);
+
+  // Each entry points at the header of its block.
+  uint64 uncompressed_bytes = 0;
+  for (uint64 i = 0; i < num_blocks; ++i) {
+    const char* entry =
+        &contents[index_offset + i * BlockZlibOutputBuffer::kIndexEntrySize];
+    const uint64 offset = core::DecodeFixed64(entry);
+    const uint64 size = core::DecodeFixed64(entry + 8);
+    EXPECT_EQ(size, core::DecodeFixed64(&contents[offset + 8]));
+    uncompressed_bytes += size;
+  }
+  EXPECT_EQ(data.size(), uncompressed_bytes);
+}
+
+TEST_P(BlockZlibBuffersTest, CorruptBlock) {
+  const string data = GenTestString(1000);
+  WriteFile(data, 1000);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname_, &contents));
+  contents[BlockZlibOutputBuffer::kBlockHeaderSize + 2] ^= 0x55;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname_, contents));
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname_, &read_file_));
+  BlockZlibInputStream in(read_file_.get(), num_parallel_blocks());
+  tstring read;
+  EXPECT_TRUE(errors::IsDataLoss(in.ReadNBytes(1000, &read)));
+}
+
+INSTANTIATE_TEST_SUITE_P(BlockZlibBuffersTests, BlockZlibBuffersTest,
+                         ::testing::Combine(::testing::Values(64, 1000, 1 << 20),
+                                            ::testing::Values(0, 1, 3)));
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
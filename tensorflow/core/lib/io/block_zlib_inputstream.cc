@@ -0,0 +1,232 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+// Decompression is bound by the CPU, so the pool has a thread per core.
+thread::ThreadPool* BlockZlibThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "block_zlib", port::MaxParallelism());
+  return pool;
+}
+}  // namespace
+
+struct BlockZlibInputStream::Block {
+  Block(int64 offset, uint64 size) : offset(offset), size(size) {}
+
+  // The uncompressed offset and size of the block.
+  const int64 offset;
+  const uint64 size;
+  // Set by the thread pool, guarded by the `mu_` of the stream.
+  tstring data;
+  Status status;
+  bool done = false;
+};
+
+BlockZlibInputStream::BlockZlibInputStream(RandomAccessFile* file,
+                                           int num_parallel_blocks,
+                                           bool owns_file)
+    : file_(file),
+      num_parallel_blocks_(num_parallel_blocks > 0 ? num_parallel_blocks
+                                                   : port::MaxParallelism()),
+      owns_file_(owns_file) {}
+
+BlockZlibInputStream::~BlockZlibInputStream() {
+  {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      cond_var_.wait(l);
+    }
+  }
+  if (owns_file_) {
+    delete file_;
+  }
+}
+
+bool BlockZlibInputStream::ReadBlockHeader(uint64* compressed_size,
+                                           uint64* uncompressed_size) {
+  if (end_) {
+    return false;
+  }
+  char header[BlockZlibOutputBuffer::kBlockHeaderSize];
+  StringPiece result;
+  Status status = file_->Read(next_offset_, sizeof(header), &result, header);
+  if (!status.ok() && !errors::IsOutOfRange(status)) {
+    end_status_ = status;
+  } else if (result.empty()) {
+    // The file was not closed, so it ends after its last block.
+    end_status_ = errors::OutOfRange("reached end of file");
+  } else if (result.size() < sizeof(header)) {
+    end_status_ =
+        errors::DataLoss("truncated block header at ", next_offset_);
+  } else {
+    *compressed_size = core::DecodeFixed64(result.data());
+    *uncompressed_size = core::DecodeFixed64(result.data() + sizeof(uint64));
+    if (*compressed_size != 0) {
+      return true;
+    }
+    end_status_ = errors::OutOfRange("reached end of file");
+  }
+  end_ = true;
+  return false;
+}
+
+void BlockZlibInputStream::RequestBlock(uint64 compressed_size,
+                                        uint64 uncompressed_size) {
+  auto block =
+      std::make_shared<Block>(next_uncompressed_offset_, uncompressed_size);
+  const uint64 offset = next_offset_ + BlockZlibOutputBuffer::kBlockHeaderSize;
+  next_offset_ = offset + compressed_size;
+  next_uncompressed_offset_ += uncompressed_size;
+  blocks_.push_back(block);
+  {
+    mutex_lock l(mu_);
+    ++num_pending_;
+  }
+  BlockZlibThreadPool()->Schedule([this, block, offset, compressed_size]() {
+    tstring compressed;
+    compressed.resize(compressed_size);
+    StringPiece result;
+    Status status =
+        file_->Read(offset, compressed_size, &result, &compressed[0]);
+    tstring data;
+    if (status.ok() || errors::IsOutOfRange(status)) {
+      uLongf size = block->size;
+      data.resize(size);
+      int error = Z_DATA_ERROR;
+      if (result.size() == compressed_size) {
+        error = uncompress(reinterpret_cast<Bytef*>(&data[0]), &size,
+                           reinterpret_cast<const Bytef*>(result.data()),
+                           result.size());
+      }
+      if (error != Z_OK || size != block->size) {
+        status = errors::DataLoss("unable to decompress the block at ",
+                                  offset, ": uncompress() failed with error ",
+                                  error);
+      } else {
+        status = Status::OK();
+      }
+    }
+    mutex_lock l(mu_);
+    block->data = std::move(data);
+    block->status = status;
+    block->done = true;
+    --num_pending_;
+    cond_var_.notify_all();
+  });
+}
+
+void BlockZlibInputStream::IssueRequests() {
+  uint64 compressed_size, uncompressed_size;
+  while (blocks_.size() < static_cast<size_t>(num_parallel_blocks_) &&
+         ReadBlockHeader(&compressed_size, &uncompressed_size)) {
+    RequestBlock(compressed_size, uncompressed_size);
+  }
+}
+
+Status BlockZlibInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Cannot read negative number of bytes");
+  }
+  result->clear();
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    IssueRequests();
+    if (blocks_.empty()) {
+      return end_status_;
+    }
+    const Block& block = *blocks_.front();
+    {
+      mutex_lock l(mu_);
+      while (!block.done) {
+        cond_var_.wait(l);
+      }
+    }
+    TF_RETURN_IF_ERROR(block.status);
+    const size_t begin = pos_ - block.offset;
+    const size_t bytes =
+        std::min<size_t>(block.size - begin, bytes_to_read - result->size());
+    result->append(block.data.data() + begin, bytes);
+    pos_ += bytes;
+    if (begin + bytes == block.size) {
+      blocks_.pop_front();
+    }
+  }
+  return Status::OK();
+}
+
+Status BlockZlibInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes");
+  }
+  while (bytes_to_skip > 0) {
+    if (blocks_.empty()) {
+      uint64 compressed_size, uncompressed_size;
+      if (!ReadBlockHeader(&compressed_size, &uncompressed_size)) {
+        return end_status_;
+      }
+      if (uncompressed_size <= static_cast<uint64>(bytes_to_skip)) {
+        // The whole block is skipped, so it is never read.
+        next_offset_ += BlockZlibOutputBuffer::kBlockHeaderSize +
+                        compressed_size;
+        next_uncompressed_offset_ += uncompressed_size;
+        pos_ += uncompressed_size;
+        bytes_to_skip -= uncompressed_size;
+        continue;
+      }
+      RequestBlock(compressed_size, uncompressed_size);
+    }
+    const Block& block = *blocks_.front();
+    const int64 remaining = block.offset + block.size - pos_;
+    if (bytes_to_skip < remaining) {
+      pos_ += bytes_to_skip;
+      return Status::OK();
+    }
+    pos_ += remaining;
+    bytes_to_skip -= remaining;
+    blocks_.pop_front();
+  }
+  return Status::OK();
+}
+
+int64 BlockZlibInputStream::Tell() const { return pos_; }
+
+Status BlockZlibInputStream::Reset() {
+  // The blocks in flight are dropped here, and freed by the thread pool when
+  // they are decompressed.
+  blocks_.clear();
+  pos_ = 0;
+  next_offset_ = 0;
+  next_uncompressed_offset_ = 0;
+  end_ = false;
+  end_status_ = Status::OK();
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,97 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a file written by BlockZlibOutputBuffer. Up to `num_parallel_blocks`
+// blocks ahead of the current position are read and decompressed concurrently
+// on a shared background thread pool, so a single stream is decompressed by as
+// many cores. A `num_parallel_blocks` of 0 uses the number of cores.
+//
+// Skipped blocks are not decompressed unless they are already in flight. A
+// single instance of BlockZlibInputStream is NOT safe for concurrent use by
+// multiple threads.
+class BlockZlibInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file` unless `owns_file` is set to true.
+  // `file` must outlive *this then.
+  BlockZlibInputStream(RandomAccessFile* file, int num_parallel_blocks,
+                       bool owns_file = false);
+
+  // Waits for the blocks which are still in flight.
+  ~BlockZlibInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Block;
+
+  // Requests blocks until `num_parallel_blocks_` of them are decompressed or
+  // being decompressed, or the end of the blocks is reached. The headers of
+  // the blocks are read on the calling thread.
+  void IssueRequests();
+
+  // Reads the header of the next block. Returns false, and sets `end_`, if
+  // there is none.
+  bool ReadBlockHeader(uint64* compressed_size, uint64* uncompressed_size);
+
+  // Schedules the next block, whose header was read, to be decompressed.
+  void RequestBlock(uint64 compressed_size, uint64 uncompressed_size);
+
+  RandomAccessFile* const file_;
+  const int num_parallel_blocks_;
+  const bool owns_file_;
+
+  // The uncompressed position of the stream.
+  int64 pos_ = 0;
+  // The file offset and uncompressed offset of the next block to request.
+  uint64 next_offset_ = 0;
+  int64 next_uncompressed_offset_ = 0;
+  // Set once there are no more blocks to request, with OutOfRange at the end
+  // of the blocks or the error which ended them.
+  bool end_ = false;
+  Status end_status_;
+  // The blocks from the one holding `pos_` on, in the order of the file.
+  std::deque<std::shared_ptr<Block>> blocks_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int num_pending_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockZlibInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_INPUTSTREAM_H_
@@ -0,0 +1,139 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/block_zlib_outputbuffer.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace io {
+
+/* static */ constexpr uint64 BlockZlibOutputBuffer::kMagic;
+/* static */ constexpr size_t BlockZlibOutputBuffer::kBlockHeaderSize;
+/* static */ constexpr size_t BlockZlibOutputBuffer::kIndexEntrySize;
+/* static */ constexpr size_t BlockZlibOutputBuffer::kFooterSize;
+
+BlockZlibOutputBuffer::BlockZlibOutputBuffer(
+    WritableFile* file, const ZlibCompressionOptions& zlib_options)
+    : file_(file),
+      zlib_options_(zlib_options),
+      block_size_(std::max<int64>(zlib_options.block_size, 1)) {}
+
+BlockZlibOutputBuffer::~BlockZlibOutputBuffer() {
+  if (!closed_) {
+    LOG(WARNING)
+        << "BlockZlibOutputBuffer::Close() not called. Possible data loss";
+  }
+}
+
+Status BlockZlibOutputBuffer::Append(StringPiece data) {
+  if (closed_) {
+    return errors::FailedPrecondition("BlockZlibOutputBuffer is closed.");
+  }
+  while (!data.empty()) {
+    const size_t bytes = std::min(data.size(), block_size_ - block_.size());
+    block_.append(data.data(), bytes);
+    data.remove_prefix(bytes);
+    if (block_.size() == block_size_) {
+      TF_RETURN_IF_ERROR(WriteBlock());
+    }
+  }
+  return Status::OK();
+}
+
+#if defined(PLATFORM_GOOGLE)
+Status BlockZlibOutputBuffer::Append(const absl::Cord& cord) {
+  absl::CordReader reader(cord);
+  absl::string_view fragment;
+  while (reader.ReadFragment(&fragment)) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status BlockZlibOutputBuffer::WriteBlock() {
+  if (block_.empty()) {
+    return Status::OK();
+  }
+  uLongf compressed_size = compressBound(block_.size());
+  std::string block(kBlockHeaderSize + compressed_size, '\0');
+  const int error = compress2(
+      reinterpret_cast<Bytef*>(&block[kBlockHeaderSize]), &compressed_size,
+      reinterpret_cast<const Bytef*>(block_.data()), block_.size(),
+      zlib_options_.compression_level);
+  if (error != Z_OK) {
+    return errors::DataLoss("compress2() failed with error ", error);
+  }
+  block.resize(kBlockHeaderSize + compressed_size);
+  core::EncodeFixed64(&block[0], compressed_size);
+  core::EncodeFixed64(&block[sizeof(uint64)], block_.size());
+  TF_RETURN_IF_ERROR(file_->Append(block));
+
+  core::PutFixed64(&index_, offset_);
+  core::PutFixed64(&index_, block_.size());
+  ++num_blocks_;
+  offset_ += block.size();
+  block_.clear();
+  return Status::OK();
+}
+
+Status BlockZlibOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition("BlockZlibOutputBuffer is closed.");
+  }
+  TF_RETURN_IF_ERROR(WriteBlock());
+  return file_->Flush();
+}
+
+Status BlockZlibOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status BlockZlibOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status BlockZlibOutputBuffer::Tell(int64* position) {
+  *position = offset_;
+  return Status::OK();
+}
+
+Status BlockZlibOutputBuffer::Close() {
+  if (closed_) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(WriteBlock());
+  std::string tail(kBlockHeaderSize, '\0');
+  const uint64 index_offset = offset_ + tail.size();
+  tail.append(index_);
+  core::PutFixed64(&tail, index_offset);
+  core::PutFixed64(&tail, num_blocks_);
+  core::PutFixed64(&tail, kMagic);
+  TF_RETURN_IF_ERROR(file_->Append(tail));
+  offset_ += tail.size();
+  closed_ = true;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
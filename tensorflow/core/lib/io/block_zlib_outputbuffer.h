@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
+#define TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
+
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/zlib_compression_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Writes data compressed in independent zlib blocks, so that it can be
+// decompressed by many threads at once (see BlockZlibInputStream). A single
+// gzip or zlib stream can only be inflated from its start, one byte after the
+// other.
+//
+// Format of the output:
+//  block*:
+//    uint64    compressed size
+//    uint64    uncompressed size
+//    byte      zlib stream of the block[compressed size]
+//  end of blocks:
+//    uint64    0
+//    uint64    0
+//  index:
+//    per block, uint64 offset of its header and uint64 uncompressed size
+//  footer:
+//    uint64    offset of the index
+//    uint64    number of blocks
+//    uint64    kMagic
+//
+// Each block holds up to `zlib_options.block_size` uncompressed bytes, and is
+// compressed at `zlib_options.compression_level`. The headers let a reader
+// stream the blocks without knowing the length of the file. The index lets
+// those that do know it find every block without reading through the file.
+//
+// A given instance of an BlockZlibOutputBuffer is NOT safe for concurrent use
+// by multiple threads.
+class BlockZlibOutputBuffer : public WritableFile {
+ public:
+  static constexpr uint64 kMagic = 0x424c4f434b5a4c42ULL;
+  static constexpr size_t kBlockHeaderSize = 2 * sizeof(uint64);
+  static constexpr size_t kIndexEntrySize = 2 * sizeof(uint64);
+  static constexpr size_t kFooterSize = 3 * sizeof(uint64);
+
+  // Does not take ownership of `file`.
+  BlockZlibOutputBuffer(WritableFile* file,
+                        const ZlibCompressionOptions& zlib_options);
+
+  ~BlockZlibOutputBuffer() override;
+
+  // Adds `data` to the current block, which is compressed and written to file
+  // once it holds `zlib_options.block_size` bytes.
+  Status Append(StringPiece data) override;
+#if defined(PLATFORM_GOOGLE)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Ends the current block early and flushes the file.
+  Status Flush() override;
+
+  // Writes the last block, the index and the footer. This must be called
+  // before the destructor to avoid any data loss. Does *not* close the file.
+  //
+  // After calling this, any further calls to `Append()`, `Flush()` or
+  // `Sync()` will fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Ends the current block early and syncs the file.
+  Status Sync() override;
+
+  // Returns the number of bytes written to file. The position does not
+  // reflect the data of the current block.
+  Status Tell(int64* position) override;
+
+ private:
+  // Compresses `block_` and writes it to file.
+  Status WriteBlock();
+
+  WritableFile* file_;  // Not owned
+  const ZlibCompressionOptions zlib_options_;
+  const size_t block_size_;
+
+  // The uncompressed data of the current block.
+  std::string block_;
+  // The index entries of the blocks which were written.
+  std::string index_;
+  uint64 num_blocks_ = 0;
+  // The number of bytes written to file.
+  uint64 offset_ = 0;
+  bool closed_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BlockZlibOutputBuffer);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_BLOCK_ZLIB_OUTPUTBUFFER_H_
@@ -22,6 +22,7 @@ namespace compression {
 const char kNone[] = "";
 const char kGzip[] = "GZIP";
 const char kSnappy[] = "SNAPPY";
+const char kBlockZlib[] = "BLOCK_ZLIB";
 
 }  // namespace compression
 }  // namespace io
@@ -23,6 +23,7 @@ namespace compression {
 extern const char kNone[];
 extern const char kGzip[];
 extern const char kSnappy[];
+extern const char kBlockZlib[];
 
 }  // namespace compression
 }  // namespace io
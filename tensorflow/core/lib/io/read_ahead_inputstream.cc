@@ -0,0 +1,170 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+// The reads wait on the storage rather than on the CPU, so the pool has more
+// threads than there are cores.
+constexpr int kNumReadAheadThreads = 64;
+
+thread::ThreadPool* ReadAheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "read_ahead", kNumReadAheadThreads);
+  return pool;
+}
+}  // namespace
+
+struct ReadAheadInputStream::Chunk {
+  explicit Chunk(int64 offset) : offset(offset) {}
+
+  const int64 offset;
+  // Set by the thread pool, guarded by the `mu_` of the stream.
+  tstring data;
+  Status status;
+  bool done = false;
+};
+
+ReadAheadInputStream::ReadAheadInputStream(RandomAccessFile* file,
+                                           size_t chunk_bytes,
+                                           int num_requests, bool owns_file)
+    : file_(file),
+      chunk_bytes_(std::max<size_t>(chunk_bytes, 1)),
+      num_requests_(std::max(num_requests, 1)),
+      owns_file_(owns_file) {}
+
+ReadAheadInputStream::~ReadAheadInputStream() {
+  {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      cond_var_.wait(l);
+    }
+  }
+  if (owns_file_) {
+    delete file_;
+  }
+}
+
+void ReadAheadInputStream::IssueRequests() {
+  while (chunks_.size() < static_cast<size_t>(num_requests_)) {
+    auto chunk = std::make_shared<Chunk>(next_offset_);
+    next_offset_ += chunk_bytes_;
+    chunks_.push_back(chunk);
+    {
+      mutex_lock l(mu_);
+      ++num_pending_;
+    }
+    ReadAheadThreadPool()->Schedule([this, chunk]() {
+      tstring data;
+      data.resize(chunk_bytes_);
+      StringPiece result;
+      Status status =
+          file_->Read(chunk->offset, chunk_bytes_, &result, &data[0]);
+      if (result.data() != data.data()) {
+        memmove(&data[0], result.data(), result.size());
+      }
+      data.resize(result.size());
+      mutex_lock l(mu_);
+      chunk->data = std::move(data);
+      chunk->status = status;
+      chunk->done = true;
+      --num_pending_;
+      cond_var_.notify_all();
+    });
+  }
+}
+
+Status ReadAheadInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Cannot read negative number of bytes");
+  }
+  result->clear();
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    IssueRequests();
+    const Chunk& chunk = *chunks_.front();
+    {
+      mutex_lock l(mu_);
+      while (!chunk.done) {
+        cond_var_.wait(l);
+      }
+    }
+    if (!chunk.status.ok() && !errors::IsOutOfRange(chunk.status)) {
+      return chunk.status;
+    }
+    const size_t begin = pos_ - chunk.offset;
+    if (begin >= chunk.data.size()) {
+      // A chunk is only short at the end of the file. It is kept, so that
+      // later reads also stop there.
+      return errors::OutOfRange("reached end of file");
+    }
+    const size_t bytes = std::min(chunk.data.size() - begin,
+                                  bytes_to_read - result->size());
+    result->append(chunk.data.data() + begin, bytes);
+    pos_ += bytes;
+    if (begin + bytes == chunk_bytes_) {
+      chunks_.pop_front();
+    }
+  }
+  return Status::OK();
+}
+
+Status ReadAheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes");
+  }
+  if (bytes_to_skip == 0) {
+    return Status::OK();
+  }
+  // Reading the last skipped byte makes skipping past the end of the file
+  // fail, as it does for the other streams.
+  Seek(pos_ + bytes_to_skip - 1);
+  tstring last;
+  return ReadNBytes(1, &last);
+}
+
+int64 ReadAheadInputStream::Tell() const { return pos_; }
+
+Status ReadAheadInputStream::Reset() {
+  Seek(0);
+  return Status::OK();
+}
+
+void ReadAheadInputStream::Seek(int64 position) {
+  if (chunks_.empty() || position < chunks_.front()->offset ||
+      position >= next_offset_) {
+    // The chunks in flight are dropped here, and freed by the thread pool when
+    // their reads finish.
+    chunks_.clear();
+    next_offset_ = position;
+  } else {
+    while (position >= chunks_.front()->offset +
+                           static_cast<int64>(chunk_bytes_)) {
+      chunks_.pop_front();
+    }
+  }
+  pos_ = position;
+}
+
+}  // namespace io
+}  // namespace tensorflow
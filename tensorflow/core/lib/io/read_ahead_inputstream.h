@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a file from start to end, while up to `num_requests` reads of
+// `chunk_bytes` bytes each, ahead of the current position, run concurrently on
+// a shared background thread pool. Keeping many reads in flight lets storage
+// with deep request queues, such as NVMe drives, be read at its full bandwidth
+// by a single stream.
+//
+// Skipping beyond the chunks already requested, or seeking backwards, drops the
+// chunks which were read ahead. A single instance of ReadAheadInputStream is
+// NOT safe for concurrent use by multiple threads.
+class ReadAheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file` unless `owns_file` is set to true.
+  // `file` must outlive *this then.
+  ReadAheadInputStream(RandomAccessFile* file, size_t chunk_bytes,
+                       int num_requests, bool owns_file = false);
+
+  // Waits for the reads which are still in flight.
+  ~ReadAheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Chunk;
+
+  // Requests chunks until `num_requests_` of them are read or being read.
+  void IssueRequests();
+
+  // Moves to `position`, keeping the chunks which can still be used.
+  void Seek(int64 position);
+
+  RandomAccessFile* const file_;
+  const size_t chunk_bytes_;
+  const int num_requests_;
+  const bool owns_file_;
+
+  // The position of the stream in the file.
+  int64 pos_ = 0;
+  // The offset of the next chunk to request.
+  int64 next_offset_ = 0;
+  // The chunks from the one holding `pos_` on, in the order of the file.
+  std::deque<std::shared_ptr<Chunk>> chunks_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int num_pending_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadAheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
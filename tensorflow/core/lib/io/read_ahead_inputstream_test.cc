@@ -0,0 +1,110 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+class ReadAheadInputStreamTest
+    : public ::testing::TestWithParam<std::tuple<size_t, int>> {
+ protected:
+  void SetUp() override {
+    fname_ = testing::TmpDir() + "/read_ahead_inputstream_test";
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname_, "0123456789"));
+    TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname_, &file_));
+  }
+
+  size_t chunk_bytes() const { return std::get<0>(GetParam()); }
+  int num_requests() const { return std::get<1>(GetParam()); }
+
+  string fname_;
+  std::unique_ptr<RandomAccessFile> file_;
+};
+
+TEST_P(ReadAheadInputStreamTest, ReadNBytes) {
+  tstring read;
+  ReadAheadInputStream in(file_.get(), chunk_bytes(), num_requests());
+  TF_ASSERT_OK(in.ReadNBytes(3, &read));
+  EXPECT_EQ(read, "012");
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(0, &read));
+  EXPECT_EQ(read, "");
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(5, &read));
+  EXPECT_EQ(read, "34567");
+  EXPECT_EQ(8, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+  EXPECT_EQ(read, "89");
+  EXPECT_EQ(10, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  EXPECT_EQ(read, "");
+  TF_ASSERT_OK(in.ReadNBytes(0, &read));
+  EXPECT_EQ(10, in.Tell());
+}
+
+TEST_P(ReadAheadInputStreamTest, SkipNBytes) {
+  tstring read;
+  ReadAheadInputStream in(file_.get(), chunk_bytes(), num_requests());
+  TF_ASSERT_OK(in.SkipNBytes(3));
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.SkipNBytes(0));
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(2, &read));
+  EXPECT_EQ(read, "34");
+  TF_ASSERT_OK(in.SkipNBytes(4));
+  EXPECT_EQ(9, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(1, &read));
+  EXPECT_EQ(read, "9");
+  EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(5)));
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+}
+
+TEST_P(ReadAheadInputStreamTest, Reset) {
+  tstring read;
+  ReadAheadInputStream in(file_.get(), chunk_bytes(), num_requests());
+  TF_ASSERT_OK(in.ReadNBytes(7, &read));
+  EXPECT_EQ(read, "0123456");
+  TF_ASSERT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(11, &read)));
+  EXPECT_EQ(read, "0123456789");
+  TF_ASSERT_OK(in.Reset());
+  TF_ASSERT_OK(in.ReadNBytes(2, &read));
+  EXPECT_EQ(read, "01");
+}
+
+TEST_P(ReadAheadInputStreamTest, DestroyWithReadsInFlight) {
+  tstring read;
+  {
+    ReadAheadInputStream in(file_.get(), chunk_bytes(), num_requests());
+    TF_ASSERT_OK(in.ReadNBytes(1, &read));
+  }
+  EXPECT_EQ(read, "0");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ReadAheadInputStreamTests, ReadAheadInputStreamTest,
+    ::testing::Combine(::testing::Values(1, 3, 10, 64),
+                       ::testing::Values(1, 2, 16)));
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
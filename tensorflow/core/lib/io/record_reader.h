@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/block_zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
@@ -34,7 +35,15 @@ namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  // BLOCK_ZLIB_COMPRESSION reads files of independently compressed blocks and
+  // decompresses zlib_options.num_parallel_blocks of them in parallel. The
+  // file is then read directly, and buffer_size and read_ahead_requests are
+  // not used.
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    BLOCK_ZLIB_COMPRESSION = 2
+  };
   CompressionType compression_type = NONE;
 
   // If buffer_size is non-zero, then all reads must be sequential, and no
@@ -42,6 +51,13 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If read_ahead_requests is non-zero, up to this many reads of
+  // read_ahead_chunk_size bytes each are issued ahead of the current record
+  // and run concurrently in the background. As with buffering, all reads must
+  // then be sequential, and buffer_size is not used.
+  int64 read_ahead_requests = 0;
+  int64 read_ahead_chunk_size = 256 << 10;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -158,6 +158,35 @@ TEST(RecordReaderWriterTest, TestBasics) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadAhead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_ahead_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 100; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record", i)));
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (auto buf_size : BufferSizes()) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options;
+    options.read_ahead_requests = 4;
+    options.read_ahead_chunk_size = buf_size;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    tstring record;
+    for (int i = 0; i < 100; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(strings::StrCat("record", i), record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+  }
+}
+
 TEST(RecordReaderWriterTest, TestZlib) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_zlib_test";
@@ -196,6 +225,46 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestBlockZlib) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_block_zlib_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions("BLOCK_ZLIB");
+    options.zlib_options.block_size = 100;
+    io::RecordWriter writer(file.get(), options);
+    for (int i = 0; i < 100; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record", i)));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+
+  for (int num_parallel_blocks : {1, 4}) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("BLOCK_ZLIB");
+    options.zlib_options.num_parallel_blocks = num_parallel_blocks;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    uint64 offset_of_50 = 0;
+    tstring record;
+    for (int i = 0; i < 100; ++i) {
+      if (i == 50) offset_of_50 = offset;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(strings::StrCat("record", i), record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+    // Going back decompresses the file again from its start.
+    TF_CHECK_OK(reader.ReadRecord(&offset_of_50, &record));
+    EXPECT_EQ("record50", record);
+  }
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
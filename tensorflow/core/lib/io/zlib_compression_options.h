@@ -117,6 +117,14 @@ class ZlibCompressionOptions {
   //
   // This option is ignored for `ZlibOutputBuffer`.
   bool soft_fail_on_error = false;  // NOLINT
+
+  // The number of uncompressed bytes in each independently compressed block
+  // of the block format. Only used by `BlockZlibOutputBuffer`.
+  int64 block_size = 1 << 20;
+
+  // The number of blocks which `BlockZlibInputStream` decompresses at once,
+  // ahead of the current position. 0 means the number of cores.
+  int num_parallel_blocks = 0;
 };
 
 inline ZlibCompressionOptions ZlibCompressionOptions::DEFAULT() {
@@ -142,6 +142,29 @@ TEST(ImageOpsTest, DecodeAndCropJpeg_InvalidCropWindow) {
   INFER_OK(op, "[];[?]", "[?,?,?]");
 }
 
+TEST(ImageOpsTest, DecodeAndResizeJpeg_ShapeFn) {
+  const char* op_name = "DecodeAndResizeJpeg";
+  ShapeInferenceTestOp op(op_name);
+  op.input_tensors.resize(2);
+
+  // Rank and size checks.
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op, "[1];?");
+  INFER_ERROR("Shape must be rank 1 but is rank 2", op, "[];[1,2]");
+  INFER_ERROR("Dimension must be 2 but is 3", op, "[];[3]");
+
+  // The size is unknown until it is constant.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"size", 1, DT_INT32})
+                   .Attr("channels", 3)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[];[2]", "[?,?,3]");
+
+  Tensor size_tensor = test::AsTensor<int32>({20, 30});
+  op.input_tensors[1] = &size_tensor;
+  INFER_OK(op, "[];[2]", "[20,30,3]");
+}
+
 TEST(ImageOpsTest, EncodeImage_ShapeFn) {
   for (const char* op_name : {"EncodeJpeg", "EncodePng"}) {
     ShapeInferenceTestOp op(op_name);
@@ -1135,6 +1135,32 @@ Status SparseSegmentReductionShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status SparseSegmentWeightedReductionShapeFn(InferenceContext* c) {
+  ShapeHandle data_shape;
+  TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
+
+  ShapeHandle indices_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &indices_shape));
+
+  // indices, weights and segment_ids should merge cleanly.
+  ShapeHandle weights_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &weights_shape));
+  ShapeHandle segment_ids_shape;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &segment_ids_shape));
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->Merge(indices_shape, weights_shape, &unused));
+  TF_RETURN_IF_ERROR(c->Merge(indices_shape, segment_ids_shape, &unused));
+
+  ShapeHandle subshape;
+  TF_RETURN_IF_ERROR(c->Subshape(data_shape, 1, &subshape));
+
+  ShapeHandle out;
+  TF_RETURN_IF_ERROR(
+      c->Concatenate(c->Vector(InferenceContext::kUnknownDim), subshape, &out));
+  c->set_output(0, out);
+  return Status::OK();
+}
+
 Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
   ShapeHandle data_shape;
   TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
@@ -1363,6 +1389,17 @@ REGISTER_OP("SparseSegmentSqrtNWithNumSegments")
     .Attr("Tnumsegments: {int32,int64} = DT_INT32")
     .SetShapeFn(SparseSegmentReductionWithNumSegmentsShapeFn);
 
+REGISTER_OP("SparseSegmentWeightedReduction")
+    .Input("data: T")
+    .Input("indices: Tidx")
+    .Input("weights: T")
+    .Input("segment_ids: int32")
+    .Output("output: T")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'sum'")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT32")
+    .SetShapeFn(SparseSegmentWeightedReductionShapeFn);
+
 REGISTER_OP("SparseSegmentSqrtNGrad")
     .Input("grad: T")
     .Input("indices: Tidx")
@@ -216,6 +216,28 @@ REGISTER_OP("StringSplitV2")
       return Status::OK();
     });
 
+REGISTER_OP("StringSplitToHashBucketFast")
+    .Input("input: string")
+    .Input("sep: string")
+    .Output("row_splits: Tsplits")
+    .Output("values: int64")
+    .Attr("maxsplit: int = -1")
+    .Attr("num_buckets: int >= 1")
+    .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &input));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      // row_splits.shape == [input.size() + 1]
+      DimensionHandle num_row_splits;
+      TF_RETURN_IF_ERROR(c->Add(c->Dim(input, 0), 1, &num_row_splits));
+      c->set_output(0, c->Vector(num_row_splits));
+      c->set_output(1, c->Vector(InferenceContext::kUnknownDim));
+      return Status::OK();
+    });
+
 REGISTER_OP("StringLower")
     .Input("input: string")
     .Output("output: string")
@@ -289,6 +289,26 @@ TEST(TrainingOpsTest, ApplyAdam_ShapeFn) {
   INFER_ERROR(err, op, "?;?;?;?;?;?;?;?;[?];?");
 }
 
+TEST(TrainingOpsTest, SparseApplyAdam_ShapeFn) {
+  ShapeInferenceTestOp op("SparseApplyAdam");
+
+  // Output is a merge of inputs 0, 1, 2, and non-indices part of 9 (var, m,
+  // v, and grad).
+  INFER_OK(op, "[1,?,?,?];[?,2,?,?];[?,?,3,?];[];[];[];[];[];[];[?,?,?,4];?",
+           "[d0_0,d1_1,d2_2,d9_3]");
+  INFER_ERROR("Dimension 1 in both shapes must be equal, but are 1 and 2", op,
+              "[?,1];[?,2];[?,1];[];[];[];[];[];[];[?,1];?");
+  INFER_ERROR("Shapes must be equal rank, but are 2 and 3", op,
+              "[?,1];[?,1];[?,1];[];[];[];[];[];[];[?,?,2];?");
+
+  TestGradAndIndicesErrorHandling(op, "?;?;?;?;?;?;?;?");
+
+  // beta1_power, beta2_power, lr, beta1, beta2, and epsilon must be scalars.
+  const char err[] = "Shape must be rank 0 but is rank 1";
+  INFER_ERROR(err, op, "?;?;?;[?];?;?;?;?;?;?;?");
+  INFER_ERROR(err, op, "?;?;?;?;?;?;?;?;[?];?;?");
+}
+
 TEST(TrainingOpsTest, ApplyRMSProp_ShapeFn) {
   ShapeInferenceTestOp op("ApplyRMSProp");
 
@@ -28,6 +28,7 @@ limitations under the License.
 #include "absl/base/macros.h"
 #include "include/json/json.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -62,6 +63,8 @@ constexpr size_t kReadAppendableFileBufferSize = 1024 * 1024;  // In bytes.
 constexpr int kGetChildrenDefaultPageSize = 1000;
 // The HTTP response code "308 Resume Incomplete".
 constexpr uint64 HTTP_CODE_RESUME_INCOMPLETE = 308;
+// The maximum number of source objects of a GCS compose request.
+constexpr size_t kMaxComposeSources = 32;
 // The environment variable that overrides the size of the readahead buffer.
 ABSL_DEPRECATED("Use GCS_READ_CACHE_BLOCK_SIZE_MB instead.")
 constexpr char kReadaheadBufferSize[] = "GCS_READAHEAD_BUFFER_SIZE_BYTES";
@@ -107,6 +110,14 @@ constexpr char kReadRequestTimeout[] = "GCS_READ_REQUEST_TIMEOUT_SECS";
 // The environment variable to configure the overall request timeout for
 // upload requests.
 constexpr char kWriteRequestTimeout[] = "GCS_WRITE_REQUEST_TIMEOUT_SECS";
+// The environment variable that enables the parallel composite uploads of the
+// writable files, in parts of this size in MB, instead of staging them on local
+// disk.
+constexpr char kCompositeUploadPartSize[] = "GCS_COMPOSITE_UPLOAD_PART_SIZE_MB";
+// The environment variable that overrides the number of concurrent part
+// uploads of each file.
+constexpr char kCompositeUploadParallelism[] =
+    "GCS_COMPOSITE_UPLOAD_PARALLELISM";
 // The environment variable to configure an additional header to send with
 // all requests to GCS (format HEADERNAME:HEADERCONTENT)
 constexpr char kAdditionalRequestHeader[] = "GCS_ADDITIONAL_REQUEST_HEADER";
@@ -693,6 +704,295 @@ class GcsWritableFile : public WritableFile {
   RetryConfig retry_config_;
 };
 
+/// \brief GCS-based implementation of a writeable file that uploads its
+/// contents in parallel parts, which GCS composes into the object.
+///
+/// Unlike GcsWritableFile, the contents are not staged on local disk: they are
+/// buffered in memory up to `part_size` bytes, and each full part is uploaded
+/// to a temporary object "<object>.part-<index>" while the next one is
+/// appended, with up to `parallelism` concurrent uploads. Sync() uploads the
+/// rest of the contents as a last part, and composes the current object (if
+/// any) and the parts into the object. The parts are then deleted.
+///
+/// Concurrent writers of the same object are not supported.
+class GcsCompositeWritableFile : public WritableFile {
+ public:
+  /// If `object_exists`, the contents are appended to the `object_size` bytes
+  /// of the existing object.
+  GcsCompositeWritableFile(const string& bucket, const string& object,
+                           GcsFileSystem* filesystem,
+                           GcsFileSystem::TimeoutConfig* timeouts,
+                           std::function<void()> file_cache_erase,
+                           RetryConfig retry_config, size_t part_size,
+                           int parallelism, bool object_exists,
+                           uint64 object_size)
+      : bucket_(bucket),
+        object_(object),
+        filesystem_(filesystem),
+        timeouts_(timeouts),
+        file_cache_erase_(std::move(file_cache_erase)),
+        retry_config_(retry_config),
+        part_size_(part_size),
+        parallelism_(parallelism),
+        object_exists_(object_exists),
+        position_(object_size),
+        sync_needed_(!object_exists) {}
+
+  ~GcsCompositeWritableFile() override { Close().IgnoreError(); }
+
+  Status Append(StringPiece data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    sync_needed_ = true;
+    position_ += data.size();
+    while (!data.empty()) {
+      const size_t n = std::min(part_size_ - buffer_.size(), data.size());
+      buffer_.append(data.data(), n);
+      data.remove_prefix(n);
+      if (buffer_.size() == part_size_) {
+        TF_RETURN_IF_ERROR(StartPartUpload());
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    if (closed_) {
+      return Status::OK();
+    }
+    Status status = Sync();
+    closed_ = true;
+    // Deletes the parts left by a failed upload.
+    status.Update(WaitForUploads());
+    DeleteParts();
+    pool_.reset();
+    return status;
+  }
+
+  Status Flush() override { return Sync(); }
+
+  Status Name(StringPiece* result) const override {
+    return errors::Unimplemented("GCSWritableFile does not support Name()");
+  }
+
+  Status Sync() override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!sync_needed_) {
+      return Status::OK();
+    }
+    Status status = SyncImpl();
+    if (status.ok()) {
+      sync_needed_ = false;
+    }
+    return status;
+  }
+
+  Status Tell(int64* position) override {
+    *position = position_;
+    return Status::OK();
+  }
+
+ private:
+  Status SyncImpl() {
+    if (!object_exists_ && parts_.empty()) {
+      // The contents fit in one part, which is uploaded as the object.
+      TF_RETURN_IF_ERROR(RetryingUtils::CallWithRetries(
+          [this]() { return UploadObject(object_, buffer_); }, retry_config_));
+      buffer_.clear();
+    } else {
+      if (!buffer_.empty()) {
+        TF_RETURN_IF_ERROR(StartPartUpload());
+      }
+      TF_RETURN_IF_ERROR(WaitForUploads());
+      if (parts_.empty()) {
+        return Status::OK();
+      }
+      std::vector<string> sources;
+      if (object_exists_) {
+        sources.push_back(object_);
+      }
+      sources.insert(sources.end(), parts_.begin(), parts_.end());
+      TF_RETURN_IF_ERROR(ComposeObject(std::move(sources)));
+      DeleteParts();
+    }
+    object_exists_ = true;
+    // Erase the file from the file cache on every successful write.
+    file_cache_erase_();
+    return Status::OK();
+  }
+
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file is closed.");
+    }
+    return Status::OK();
+  }
+
+  /// Schedules the upload of the buffered contents as the next part, after
+  /// waiting for a free upload slot.
+  Status StartPartUpload() {
+    TF_RETURN_IF_ERROR(WaitForUploads(parallelism_ - 1));
+    const string part = NextPartName();
+    parts_.push_back(part);
+    auto contents = std::make_shared<string>();
+    contents->swap(buffer_);
+    Schedule([this, part, contents]() {
+      return RetryingUtils::CallWithRetries(
+          [this, &part, &contents]() { return UploadObject(part, *contents); },
+          retry_config_);
+    });
+    return Status::OK();
+  }
+
+  /// Runs `fn` on the upload threads. Its error is returned by the next
+  /// WaitForUploads().
+  void Schedule(std::function<Status()> fn) {
+    if (!pool_) {
+      pool_.reset(new thread::ThreadPool(Env::Default(), "gcs_upload",
+                                         parallelism_));
+    }
+    {
+      mutex_lock l(mu_);
+      ++pending_;
+    }
+    pool_->Schedule([this, fn]() {
+      const Status status = fn();
+      mutex_lock l(mu_);
+      status_.Update(status);
+      --pending_;
+      cond_var_.notify_all();
+    });
+  }
+
+  /// Waits until at most `max_pending` functions are running, and returns the
+  /// first error of the scheduled functions.
+  Status WaitForUploads(int max_pending = 0) {
+    mutex_lock l(mu_);
+    while (pending_ > max_pending) {
+      cond_var_.wait(l);
+    }
+    return status_;
+  }
+
+  /// Uploads `contents` to `object` with a single request.
+  Status UploadObject(const string& object, const string& contents) {
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+    request->SetUri(strings::StrCat(kGcsUploadUriBase, "b/", bucket_,
+                                    "/o?uploadType=media&name=",
+                                    request->EscapeString(object)));
+    request->SetPostFromBuffer(contents.data(), contents.size());
+    request->SetTimeouts(timeouts_->connect, timeouts_->idle, timeouts_->write);
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading gs://",
+                                    bucket_, "/", object);
+    return Status::OK();
+  }
+
+  /// Composes `sources` into the object, in groups of at most
+  /// kMaxComposeSources objects.
+  Status ComposeObject(std::vector<string> sources) {
+    while (sources.size() > kMaxComposeSources) {
+      std::vector<string> composed;
+      for (size_t i = 0; i < sources.size(); i += kMaxComposeSources) {
+        const size_t end = std::min(sources.size(), i + kMaxComposeSources);
+        if (end - i == 1) {
+          composed.push_back(sources[i]);
+          continue;
+        }
+        // The intermediate objects are deleted with the parts.
+        const string part = NextPartName();
+        parts_.push_back(part);
+        const std::vector<string> group(sources.begin() + i,
+                                        sources.begin() + end);
+        Schedule([this, group, part]() { return Compose(group, part); });
+        composed.push_back(part);
+      }
+      TF_RETURN_IF_ERROR(WaitForUploads());
+      sources.swap(composed);
+    }
+    return Compose(sources, object_);
+  }
+
+  /// Composes `sources` into `destination` with a single request.
+  Status Compose(const std::vector<string>& sources,
+                 const string& destination) {
+    Json::Value root;
+    for (const string& source : sources) {
+      Json::Value source_object;
+      source_object["name"] = source;
+      root["sourceObjects"].append(source_object);
+    }
+    const string body = Json::FastWriter().write(root);
+    return RetryingUtils::CallWithRetries(
+        [this, &body, &destination]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+          request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                          request->EscapeString(destination),
+                                          "/compose"));
+          request->AddHeader("Content-Type", "application/json");
+          request->SetPostFromBuffer(body.data(), body.size());
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->metadata);
+          std::vector<char> output_buffer;
+          request->SetResultBuffer(&output_buffer);
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(),
+                                          " when composing gs://", bucket_,
+                                          "/", destination);
+          return Status::OK();
+        },
+        retry_config_);
+  }
+
+  /// Deletes the parts in the background. Failures only leave garbage behind,
+  /// so they are logged.
+  void DeleteParts() {
+    for (const string& part : parts_) {
+      const string path = strings::StrCat("gs://", bucket_, "/", part);
+      Schedule([this, path]() {
+        Status status = RetryingUtils::DeleteWithRetries(
+            [this, &path]() { return filesystem_->DeleteFile(path); },
+            retry_config_);
+        if (!status.ok()) {
+          LOG(WARNING) << "Failed to delete the upload part " << path << ": "
+                       << status;
+        }
+        return Status::OK();
+      });
+    }
+    parts_.clear();
+    WaitForUploads().IgnoreError();
+  }
+
+  string NextPartName() {
+    return strings::StrCat(object_, ".part-", next_part_++);
+  }
+
+  string bucket_;
+  string object_;
+  GcsFileSystem* const filesystem_;  // Not owned.
+  GcsFileSystem::TimeoutConfig* timeouts_;
+  std::function<void()> file_cache_erase_;
+  RetryConfig retry_config_;
+  const size_t part_size_;
+  const int parallelism_;
+  // Whether the object holds the contents before the parts.
+  bool object_exists_;
+  int64 position_;
+  bool sync_needed_;  // whether there is buffered data that needs to be synced
+  bool closed_ = false;
+  // The contents appended after the last part.
+  string buffer_;
+  // The uploaded and uploading parts, in order.
+  std::vector<string> parts_;
+  int64 next_part_ = 0;
+  std::unique_ptr<thread::ThreadPool> pool_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  int pending_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+};
+
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
   GcsReadOnlyMemoryRegion(std::unique_ptr<char[]> data, uint64 length)
@@ -758,12 +1058,17 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+
+  if (GetEnvVar(kReadAheadBlocks, strings::safe_strtou64, &value)) {
+    read_ahead_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "read-ahead blocks = " << read_ahead_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -876,6 +1181,16 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
 
   GetEnvVar(kAllowedBucketLocations, SplitByCommaToLowercaseSet,
             &allowed_locations_);
+
+  if (GetEnvVar(kCompositeUploadPartSize, strings::safe_strtou64, &value)) {
+    composite_upload_part_size_ = value * 1024 * 1024;
+  }
+  int64 parallelism;
+  if (GetEnvVar(kCompositeUploadParallelism, strings::safe_strto64,
+                &parallelism) &&
+      parallelism > 0) {
+    composite_upload_parallelism_ = parallelism;
+  }
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -985,7 +1300,8 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      Env::Default(), read_ahead_blocks_));
   return file_block_cache;
 }
 
@@ -1055,6 +1371,14 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
                                       std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
+  if (composite_upload_part_size_ > 0) {
+    result->reset(new GcsCompositeWritableFile(
+        bucket, object, this, &timeouts_,
+        [this, fname]() { ClearFileCaches(fname); }, retry_config_,
+        composite_upload_part_size_, composite_upload_parallelism_,
+        /*object_exists=*/false, /*object_size=*/0));
+    return Status::OK();
+  }
   result->reset(new GcsWritableFile(bucket, object, this, &timeouts_,
                                     [this, fname]() { ClearFileCaches(fname); },
                                     retry_config_));
@@ -1065,6 +1389,19 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
 // which is then passed to GcsWritableFile.
 Status GcsFileSystem::NewAppendableFile(const string& fname,
                                         std::unique_ptr<WritableFile>* result) {
+  if (composite_upload_part_size_ > 0) {
+    // GCS composes the existing contents with the appended ones.
+    string bucket, object;
+    TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
+    FileStatistics stat;
+    TF_RETURN_IF_ERROR(Stat(fname, &stat));
+    result->reset(new GcsCompositeWritableFile(
+        bucket, object, this, &timeouts_,
+        [this, fname]() { ClearFileCaches(fname); }, retry_config_,
+        composite_upload_part_size_, composite_upload_parallelism_,
+        /*object_exists=*/true, stat.length));
+    return Status::OK();
+  }
   std::unique_ptr<RandomAccessFile> reader;
   TF_RETURN_IF_ERROR(NewRandomAccessFile(fname, &reader));
   std::unique_ptr<char[]> buffer(new char[kReadAppendableFileBufferSize]);
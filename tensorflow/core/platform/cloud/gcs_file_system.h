@@ -50,6 +50,10 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the number of blocks fetched from
+// GCS ahead of sequential reads, concurrently, when the block cache is enabled.
+constexpr char kReadAheadBlocks[] = "GCS_READ_CACHE_READ_AHEAD_BLOCKS";
+constexpr size_t kDefaultReadAheadBlocks = 0;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -180,6 +184,13 @@ class GcsFileSystem : public FileSystem {
     tf_shared_lock l(block_cache_lock_);
     return file_block_cache_->max_staleness();
   }
+  size_t read_ahead_blocks() const { return read_ahead_blocks_; }
+  size_t composite_upload_part_size() const {
+    return composite_upload_part_size_;
+  }
+  int composite_upload_parallelism() const {
+    return composite_upload_parallelism_;
+  }
   TimeoutConfig timeouts() const { return timeouts_; }
   std::unordered_set<string> allowed_locations() const {
     return allowed_locations_;
@@ -243,6 +254,16 @@ class GcsFileSystem : public FileSystem {
   /// The new auth provider will be used for all subsequent requests.
   void SetAuthProvider(std::unique_ptr<AuthProvider> auth_provider);
 
+  /// \brief Uploads the writable files in parts of `part_size` bytes, with
+  /// `parallelism` concurrent uploads per file, and composes them on GCS.
+  ///
+  /// A zero `part_size` stages the files on local disk and uploads them with a
+  /// single resumable upload instead, which is the default.
+  void SetCompositeUploadConfig(size_t part_size, int parallelism) {
+    composite_upload_part_size_ = part_size;
+    composite_upload_parallelism_ = parallelism;
+  }
+
   /// \brief Resets the block cache and re-instantiates it with the new values.
   ///
   /// This method can be used to clear the existing block cache and/or to
@@ -340,6 +361,14 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // The number of blocks the block cache fetches ahead of sequential reads.
+  size_t read_ahead_blocks_ = kDefaultReadAheadBlocks;
+
+  // The part size and the number of concurrent part uploads of the writable
+  // files, or a zero part size to stage them on local disk.
+  size_t composite_upload_part_size_ = 0;
+  int composite_upload_parallelism_ = 8;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
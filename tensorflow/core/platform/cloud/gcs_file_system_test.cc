@@ -1206,6 +1206,137 @@ TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
             fs.NewWritableFile("gs://bucket/", &file).code());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUpload) {
+  auto upload = [](const string& part, const string& contents) {
+    return new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/upload/storage/v1/b/"
+                        "bucket/o?uploadType=media&name=path%2Fwriteable",
+                        part,
+                        "\n"
+                        "Auth Token: fake_token\n"
+                        "Post body: ",
+                        contents,
+                        "\n"
+                        "Timeouts: 5 1 30\n"),
+        "");
+  };
+  auto remove = [](const string& part) {
+    return new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+                        "path%2Fwriteable",
+                        part,
+                        "\n"
+                        "Auth Token: fake_token\n"
+                        "Timeouts: 5 1 10\n"
+                        "Delete: yes\n"),
+        "");
+  };
+  std::vector<HttpRequest*> requests(
+      {// The parts are uploaded as they fill.
+       upload(".part-0", "cont"), upload(".part-1", "ent1"),
+       upload(".part-2", ",con"), upload(".part-3", "tent"),
+       // Flush uploads the last part and composes them.
+       upload(".part-4", "2"),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fwriteable/compose\n"
+           "Auth Token: fake_token\n"
+           "Header Content-Type: application/json\n"
+           "Post body: {\"sourceObjects\":["
+           "{\"name\":\"path/writeable.part-0\"},"
+           "{\"name\":\"path/writeable.part-1\"},"
+           "{\"name\":\"path/writeable.part-2\"},"
+           "{\"name\":\"path/writeable.part-3\"},"
+           "{\"name\":\"path/writeable.part-4\"}]}\n\n"
+           "Timeouts: 5 1 10\n",
+           ""),
+       remove(".part-0"), remove(".part-1"), remove(".part-2"),
+       remove(".part-3"), remove(".part-4"),
+       // A file that fits in a part is uploaded as the object.
+       upload("", "123")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   std::unique_ptr<ZoneProvider>(new FakeZoneProvider),
+                   0 /* block size */, 0 /* max bytes */, 0 /* max staleness */,
+                   0 /* stat cache max age */, 0 /* stat cache max entries */,
+                   0 /* matching paths cache max age */,
+                   0 /* matching paths cache max entries */, kTestRetryConfig,
+                   kTestTimeoutConfig, *kAllowedLocationsDefault,
+                   nullptr /* gcs additional header */);
+  // A single upload thread keeps the requests in order.
+  fs.SetCompositeUploadConfig(4 /* part size */, 1 /* parallelism */);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable", &wfile));
+  TF_EXPECT_OK(wfile->Append("content1,"));
+  int64 pos;
+  TF_EXPECT_OK(wfile->Tell(&pos));
+  EXPECT_EQ(9, pos);
+  TF_EXPECT_OK(wfile->Append("content2"));
+  TF_EXPECT_OK(wfile->Flush());
+  // The file is not dirty.
+  TF_EXPECT_OK(wfile->Close());
+
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable", &wfile));
+  TF_EXPECT_OK(wfile->Append("123"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
+TEST(GcsFileSystemTest, NewAppendableFile_CompositeUpload) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fappendable?fields=size%2Cgeneration%2Cupdated\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n",
+           strings::StrCat("{\"size\": \"9\",\"generation\": \"1\","
+                           "\"updated\": \"2016-04-29T23:15:24.896Z\"}")),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2Fappendable.part-0\n"
+           "Auth Token: fake_token\n"
+           "Post body: content2\n"
+           "Timeouts: 5 1 30\n",
+           ""),
+       // The existing contents are composed with the appended ones.
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fappendable/compose\n"
+           "Auth Token: fake_token\n"
+           "Header Content-Type: application/json\n"
+           "Post body: {\"sourceObjects\":["
+           "{\"name\":\"path/appendable\"},"
+           "{\"name\":\"path/appendable.part-0\"}]}\n\n"
+           "Timeouts: 5 1 10\n",
+           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/path%2Fappendable.part-0\n"
+                           "Auth Token: fake_token\n"
+                           "Timeouts: 5 1 10\n"
+                           "Delete: yes\n",
+                           "")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   std::unique_ptr<ZoneProvider>(new FakeZoneProvider),
+                   0 /* block size */, 0 /* max bytes */, 0 /* max staleness */,
+                   0 /* stat cache max age */, 0 /* stat cache max entries */,
+                   0 /* matching paths cache max age */,
+                   0 /* matching paths cache max entries */, kTestRetryConfig,
+                   kTestTimeoutConfig, *kAllowedLocationsDefault,
+                   nullptr /* gcs additional header */);
+  fs.SetCompositeUploadConfig(16 /* part size */, 1 /* parallelism */);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(fs.NewAppendableFile("gs://bucket/path/appendable", &wfile));
+  int64 pos;
+  TF_EXPECT_OK(wfile->Tell(&pos));
+  EXPECT_EQ(9, pos);
+  TF_EXPECT_OK(wfile->Append("content2"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
 TEST(GcsFileSystemTest, NewAppendableFile) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -3410,14 +3541,17 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   GcsFileSystem fs2;
   EXPECT_EQ(123456789L, fs2.block_size());
 
-  // Verify block size, max size, and max staleness overrides.
+  // Verify block size, max size, max staleness and read-ahead overrides.
   setenv("GCS_READ_CACHE_BLOCK_SIZE_MB", "1", 1);
   setenv("GCS_READ_CACHE_MAX_SIZE_MB", "16", 1);
   setenv("GCS_READ_CACHE_MAX_STALENESS", "60", 1);
+  setenv("GCS_READ_CACHE_READ_AHEAD_BLOCKS", "4", 1);
   GcsFileSystem fs3;
   EXPECT_EQ(1048576L, fs3.block_size());
   EXPECT_EQ(16 * 1024 * 1024, fs3.max_bytes());
   EXPECT_EQ(60, fs3.max_staleness());
+  EXPECT_EQ(4, fs3.read_ahead_blocks());
+  unsetenv("GCS_READ_CACHE_READ_AHEAD_BLOCKS");
 
   // Verify StatCache and MatchingPathsCache overrides.
   setenv("GCS_STAT_CACHE_MAX_AGE", "60", 1);
@@ -17,10 +17,28 @@ limitations under the License.
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* block_lookups_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/file_block_cache/lookups",
+    "The number of block lookups of the reads from the file block cache, by "
+    "whether the block was cached, being fetched (e.g. ahead of the read) or "
+    "missing.",
+    "result");
+
+auto* block_fetch_usecs_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/file_block_cache/fetch_usecs",
+     "The time in microseconds to fetch a block from the filesystem."},
+    {monitoring::Buckets::Exponential(1000, 2, 16)});
+
+}  // namespace
+
 bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
   mutex_lock l(block->mu);
   if (block->state != FetchState::FINISHED) {
@@ -42,7 +60,11 @@ std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
       RemoveFile_Locked(key.first);
     }
   }
+  return Insert_Locked(key);
+}
 
+std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Insert_Locked(
+    const Key& key) {
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
@@ -80,11 +102,16 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
   // in the cache, and our current block is not block size, this likely means
   // we have inconsistent state within the cache. Note: it's possible some
   // incomplete reads may still go undetected.
+  // Blocks fetched ahead of the reads may be past the end of the file, so only
+  // the later blocks with data count.
   if (block->data.size() < block_size_) {
-    Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
-    auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
-      return errors::Internal("Block cache contents are inconsistent.");
+    for (auto it = block_map_.upper_bound(key);
+         it != block_map_.end() && it->first.first == key.first; ++it) {
+      mutex_lock l(it->second->mu);
+      if (it->second->state == FetchState::FINISHED &&
+          !it->second->data.empty()) {
+        return errors::Internal("Block cache contents are inconsistent.");
+      }
     }
   }
 
@@ -129,8 +156,14 @@ Status RamFileBlockCache::MaybeFetch(const Key& key,
         block->data.clear();
         block->data.resize(block_size_, 0);
         size_t bytes_transferred;
-        status.Update(block_fetcher_(key.first, key.second, block_size_,
-                                     block->data.data(), &bytes_transferred));
+        {
+          const uint64 start_micros = env_->NowMicros();
+          status.Update(block_fetcher_(key.first, key.second, block_size_,
+                                       block->data.data(),
+                                       &bytes_transferred));
+          block_fetch_usecs_histogram->GetCell()->Add(env_->NowMicros() -
+                                                      start_micros);
+        }
         block->mu.lock();  // Reacquire the lock immediately afterwards
         if (status.ok()) {
           block->data.resize(bytes_transferred, 0);
@@ -176,6 +209,9 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (read_ahead_pool_) {
+    MaybeReadAhead(filename, offset, n, finish);
+  }
   size_t total_bytes_transferred = 0;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
@@ -184,6 +220,16 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     // LRU iterator for the key and block.
     std::shared_ptr<Block> block = Lookup(key);
     DCHECK(block) << "No block for key " << key.first << "@" << key.second;
+    {
+      mutex_lock l(block->mu);
+      const char* result = "miss";
+      if (block->state == FetchState::FINISHED) {
+        result = "hit";
+      } else if (block->state == FetchState::FETCHING) {
+        result = "pending";
+      }
+      block_lookups_counter->GetCell(result)->IncrementBy(1);
+    }
     TF_RETURN_IF_ERROR(MaybeFetch(key, block));
     TF_RETURN_IF_ERROR(UpdateLRU(key, block));
     // Copy the relevant portion of the block into the result buffer.
@@ -221,6 +267,52 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
   return Status::OK();
 }
 
+void RamFileBlockCache::MaybeReadAhead(const string& filename, size_t offset,
+                                       size_t n, size_t finish) {
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> blocks;
+  {
+    mutex_lock lock(mu_);
+    // The first read of a file is sequential if it starts at its beginning.
+    size_t& next_offset = next_read_offset_[filename];
+    const bool sequential = offset == next_offset;
+    next_offset = offset + n;
+    if (!sequential) return;
+    for (size_t i = 0; i < read_ahead_blocks_; ++i) {
+      // Blocks whose fetch is cached or already started are skipped.
+      Key key = std::make_pair(filename, finish + i * block_size_);
+      if (block_map_.find(key) != block_map_.end()) continue;
+      blocks.emplace_back(key, Insert_Locked(key));
+    }
+  }
+  for (const auto& entry : blocks) {
+    const Key key = entry.first;
+    const std::shared_ptr<Block> block = entry.second;
+    read_ahead_pool_->Schedule([this, key, block] { ReadAhead(key, block); });
+  }
+}
+
+void RamFileBlockCache::ReadAhead(const Key& key,
+                                 const std::shared_ptr<Block>& block) {
+  Status status = MaybeFetch(key, block);
+  if (!status.ok()) {
+    // The read of the block fetches it again.
+    VLOG(1) << "Failed to read ahead " << key.first << "@" << key.second
+            << ": " << status;
+    return;
+  }
+  mutex_lock lock(mu_);
+  if (block->timestamp == 0) return;
+  if (block->data.empty()) {
+    // The block is past the end of the file.
+    auto entry = block_map_.find(key);
+    if (entry != block_map_.end() && entry->second == block) {
+      RemoveBlock(entry);
+    }
+    return;
+  }
+  Trim();
+}
+
 bool RamFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
                                                        int64 file_signature) {
   mutex_lock lock(mu_);
@@ -265,6 +357,7 @@ void RamFileBlockCache::Flush() {
   block_map_.clear();
   lru_list_.clear();
   lra_list_.clear();
+  next_read_offset_.clear();
   cache_size_ = 0;
 }
 
@@ -274,6 +367,7 @@ void RamFileBlockCache::RemoveFile(const string& filename) {
 }
 
 void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+  next_read_offset_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
@@ -24,6 +24,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -49,22 +50,34 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// If `read_ahead_blocks` is positive, sequential reads of a file fetch up
+  /// to that many of the blocks following the read in the background, with as
+  /// many concurrent fetches.
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                    BlockFetcher block_fetcher, Env* env = Env::Default())
+                    BlockFetcher block_fetcher, Env* env = Env::Default(),
+                    size_t read_ahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        read_ahead_blocks_(read_ahead_blocks) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (read_ahead_blocks_ > 0 && IsCacheEnabled()) {
+      read_ahead_pool_.reset(new thread::ThreadPool(
+          env_, "TF_read_ahead_FBC", static_cast<int>(read_ahead_blocks_)));
+    }
     VLOG(1) << "GCS file block cache is "
-            << (IsCacheEnabled() ? "enabled" : "disabled");
+            << (IsCacheEnabled() ? "enabled" : "disabled")
+            << ", read-ahead blocks = " << read_ahead_blocks_;
   }
 
   ~RamFileBlockCache() override {
+    // Waits for the pending read-ahead fetches.
+    read_ahead_pool_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -108,6 +121,7 @@ class RamFileBlockCache : public FileBlockCache {
   size_t block_size() const override { return block_size_; }
   size_t max_bytes() const override { return max_bytes_; }
   uint64 max_staleness() const override { return max_staleness_; }
+  size_t read_ahead_blocks() const { return read_ahead_blocks_; }
 
   /// The current size (in bytes) of the cache.
   size_t CacheSize() const override LOCKS_EXCLUDED(mu_);
@@ -130,6 +144,8 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The number of blocks fetched ahead of sequential reads.
+  const size_t read_ahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -196,6 +212,20 @@ class RamFileBlockCache : public FileBlockCache {
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) LOCKS_EXCLUDED(mu_);
 
+  /// Insert a new empty block for `key`, which is not in the block map.
+  std::shared_ptr<Block> Insert_Locked(const Key& key)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Schedule the fetches of the blocks following [offset, offset + n) of
+  /// `filename`, where `finish` is the block-aligned end of the read, if the
+  /// read continues the previous read of the file.
+  void MaybeReadAhead(const string& filename, size_t offset, size_t n,
+                      size_t finish) LOCKS_EXCLUDED(mu_);
+
+  /// Fetch a block scheduled by MaybeReadAhead.
+  void ReadAhead(const Key& key, const std::shared_ptr<Block>& block)
+      LOCKS_EXCLUDED(mu_);
+
   Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
       LOCKS_EXCLUDED(mu_);
 
@@ -219,6 +249,9 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
+  /// The threads fetching the read-ahead blocks, or null without read-ahead.
+  std::unique_ptr<thread::ThreadPool> read_ahead_pool_;
+
   /// Guards access to the block map, LRU list, and cached byte count.
   mutable mutex mu_;
 
@@ -241,6 +274,10 @@ class RamFileBlockCache : public FileBlockCache {
 
   // A filename->file_signature map.
   std::map<string, int64> file_signature_map_ GUARDED_BY(mu_);
+
+  // A filename->offset map of the end of the last read of each file, which
+  // detects the sequential reads to fetch ahead of.
+  std::map<string, size_t> next_read_offset_ GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
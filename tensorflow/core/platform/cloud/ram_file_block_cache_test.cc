@@ -564,5 +564,54 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+TEST(RamFileBlockCacheTest, ReadAhead) {
+  // A file of 5 blocks and a half.
+  const size_t block_size = 8;
+  const string contents(5 * block_size + block_size / 2, 'x');
+  mutex mu;
+  std::map<string, std::map<size_t, int>> fetches;
+  auto fetcher = [&](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      fetches[filename][offset]++;
+    }
+    *bytes_transferred = 0;
+    if (offset < contents.size()) {
+      *bytes_transferred = std::min(n, contents.size() - offset);
+      memcpy(buffer, contents.data() + offset, *bytes_transferred);
+    }
+    return Status::OK();
+  };
+  RamFileBlockCache cache(block_size, 100 * block_size, 0, fetcher,
+                          Env::Default(), /*read_ahead_blocks=*/2);
+  EXPECT_EQ(cache.read_ahead_blocks(), 2);
+  std::vector<char> out;
+  size_t offset = 0;
+  Status status;
+  // Sequential reads of half blocks, up to the end of the file.
+  while (offset <= contents.size()) {
+    status = ReadCache(&cache, "a", offset, block_size / 2, &out);
+    if (!status.ok()) break;
+    EXPECT_EQ(out.size(), block_size / 2);
+    offset += out.size();
+  }
+  EXPECT_EQ(status.code(), error::OUT_OF_RANGE);
+  EXPECT_EQ(offset, contents.size());
+  {
+    mutex_lock l(mu);
+    // Each block of the file is fetched once.
+    for (size_t pos = 0; pos <= contents.size(); pos += block_size) {
+      EXPECT_EQ(fetches["a"][pos], 1) << pos;
+    }
+  }
+
+  // Random reads do not fetch ahead.
+  TF_EXPECT_OK(ReadCache(&cache, "b", block_size, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "b", 3 * block_size, block_size, &out));
+  mutex_lock l(mu);
+  EXPECT_EQ(fetches["b"].size(), 2);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,166 @@
+/* Copyright 2020 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This checker places the operation types on the roofline of their device,
+// to tell the memory-bound ones from the compute-bound ones.
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/profiler/internal/advisor/checker.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+// The peak performance of a device.
+struct DevicePeak {
+  double gflops;
+  double gb_per_sec;
+
+  // The arithmetic intensity, in flops per byte, above which an operation can
+  // be compute-bound.
+  double ridge_point() const { return gflops / gb_per_sec; }
+};
+
+// Uses the float_ops of the operations (from the op_log), and the bytes of
+// their inputs and outputs (from the run_meta) as their memory traffic.
+//
+// Options, which default to a V100 GPU and a 2-socket server CPU:
+//   accelerator_peak_gflops, accelerator_peak_gb_per_sec,
+//   cpu_peak_gflops, cpu_peak_gb_per_sec.
+class RooflineChecker : public Checker {
+ public:
+  string name() const override { return kCheckers[4]; }
+
+ private:
+  // The execution of the operations of one type on one kind of device.
+  struct OpTypeStats {
+    string op_type;
+    bool accelerator = false;
+    int64 float_ops = 0;
+    int64 bytes = 0;
+    int64 exec_micros = 0;
+  };
+
+  AdviceProto::Checker Check(const AdvisorOptionsProto::CheckerOption& options,
+                             const TFStats* stats) override {
+    if (!stats) {
+      fprintf(stderr, "Missing profiles (e.g. graph, run_meta). Skip %s\n",
+              name().c_str());
+      return reports_;
+    }
+    if (stats->steps().empty()) {
+      fprintf(stderr, "Missing RunMetadata info. Skip %s\n", name().c_str());
+      return reports_;
+    }
+    const DevicePeak accelerator_peak = {
+        GetOption(options, "accelerator_peak_gflops", 15700),
+        GetOption(options, "accelerator_peak_gb_per_sec", 900)};
+    const DevicePeak cpu_peak = {GetOption(options, "cpu_peak_gflops", 3000),
+                                 GetOption(options, "cpu_peak_gb_per_sec",
+                                           250)};
+
+    std::map<std::pair<string, bool>, OpTypeStats> op_types;
+    for (const auto& n : stats->nodes()) {
+      const TFGraphNode* node = n.second.get();
+      const bool accelerator = IsPlacedOnAccelerator(node->canonical_device());
+      // The averages across the steps.
+      const int64 exec_micros = accelerator ? node->accelerator_exec_micros(-1)
+                                            : node->cpu_exec_micros(-1);
+      const int64 bytes = node->input_bytes(-1) + node->output_bytes(-1);
+      if (exec_micros <= 0 || (node->float_ops(-1) <= 0 && bytes <= 0)) {
+        continue;
+      }
+      OpTypeStats& op_type = op_types[{node->op(), accelerator}];
+      op_type.op_type = node->op();
+      op_type.accelerator = accelerator;
+      op_type.float_ops += node->float_ops(-1);
+      op_type.bytes += bytes;
+      op_type.exec_micros += exec_micros;
+    }
+    if (op_types.empty()) {
+      fprintf(stderr, "Missing float_ops or memory info. Skip %s\n",
+              name().c_str());
+      return reports_;
+    }
+
+    std::vector<const OpTypeStats*> sorted;
+    for (const auto& op_type : op_types) sorted.push_back(&op_type.second);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const OpTypeStats* a, const OpTypeStats* b) {
+                return a->exec_micros > b->exec_micros;
+              });
+    int64 total_micros = 0;
+    int64 memory_bound_micros = 0;
+    std::vector<string> outputs;
+    for (const OpTypeStats* op_type : sorted) {
+      const DevicePeak& peak =
+          op_type->accelerator ? accelerator_peak : cpu_peak;
+      const double intensity =
+          op_type->float_ops / std::max<double>(op_type->bytes, 1);
+      // flops/us / 1e3 is GFLOP/s, and bytes/us / 1e3 is GB/s.
+      const double gflops = op_type->float_ops / 1e3 / op_type->exec_micros;
+      const double gb_per_sec = op_type->bytes / 1e3 / op_type->exec_micros;
+      const bool memory_bound = intensity < peak.ridge_point();
+      const double roofline_gflops =
+          std::min(peak.gflops, intensity * peak.gb_per_sec);
+      total_micros += op_type->exec_micros;
+      if (memory_bound) memory_bound_micros += op_type->exec_micros;
+      if (outputs.size() >= kMaxReportedOpTypes) continue;
+      outputs.push_back(strings::Printf(
+          "%s (%s): %s, %.2f flops/byte, %.1f GFLOP/s, %.1f GB/s, "
+          "%.0f%% of the %s roofline, %s",
+          op_type->op_type.c_str(),
+          op_type->accelerator ? "accelerator" : "cpu",
+          memory_bound ? "memory-bound" : "compute-bound", intensity, gflops,
+          gb_per_sec,
+          memory_bound
+              ? 100.0 * gb_per_sec / peak.gb_per_sec
+              : 100.0 * gflops / std::max(roofline_gflops, 1e-10),
+          memory_bound ? "bandwidth" : "compute",
+          FormatTime(op_type->exec_micros).c_str()));
+    }
+    reports_.add_reports(str_util::Join(outputs, "\n"));
+    reports_.add_reports(strings::Printf(
+        "Memory-bound operations take %.0f%% of the time of the profiled "
+        "operations. Fusing them or changing their layout reduces their memory "
+        "traffic, while compute-bound ones gain from faster kernels.",
+        100.0 * memory_bound_micros / std::max<int64>(total_micros, 1)));
+    return reports_;
+  }
+
+  static double GetOption(const AdvisorOptionsProto::CheckerOption& options,
+                          const string& key, double default_value) {
+    auto it = options.options().find(key);
+    double value;
+    if (it == options.options().end() ||
+        !strings::safe_strtod(it->second, &value) || value <= 0) {
+      return default_value;
+    }
+    return value;
+  }
+
+  static constexpr size_t kMaxReportedOpTypes = 10;
+
+  AdviceProto::Checker reports_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_ADVISOR_ROOFLINE_CHECKER_H_
@@ -40,7 +40,9 @@ class TFProfAdvisorTest : public ::testing::Test {
                                           const string& type,
                                           std::map<string, string> attrs,
                                           int64 step, int64 start_miros,
-                                          int64 end_rel_micros) {
+                                          int64 end_rel_micros,
+                                          int64 float_ops = 0,
+                                          int64 output_bytes = 0) {
     node_defs_.push_back(std::unique_ptr<NodeDef>(new NodeDef()));
     NodeDef* def = node_defs_.back().get();
 
@@ -50,10 +52,17 @@ class TFProfAdvisorTest : public ::testing::Test {
       (*def->mutable_attr())[attr.first].set_s(attr.second);
     }
     std::unique_ptr<TFGraphNode> node(new TFGraphNode(def, -1, nullptr));
+    node->AddFloatOps(float_ops);
 
     NodeExecStats node_stat;
     node_stat.set_all_start_micros(start_miros);
     node_stat.set_op_end_rel_micros(end_rel_micros);
+    if (output_bytes > 0) {
+      NodeOutput* output = node_stat.add_output();
+      output->mutable_tensor_description()
+          ->mutable_allocation_description()
+          ->set_requested_bytes(output_bytes);
+    }
     node->AddStepStat(step, "/job:localhost/replica:0/task:0/device:GPU:0",
                       node_stat);
     node->AddStepStat(step,
@@ -104,5 +113,38 @@ TEST_F(TFProfAdvisorTest, ExpensiveOperationChecker) {
                                 "top 1 operation type: Conv2D"));
 }
 
+TEST_F(TFProfAdvisorTest, RooflineChecker) {
+  stats_.reset(new TFStats(std::unique_ptr<GraphDef>(new GraphDef()), nullptr,
+                           nullptr, nullptr));
+  // 500 flops/byte at 2 TFLOP/s.
+  stats_->AddNodeForTest(0, CreateNode("matmul", "MatMul", {}, 0, 10, 1000,
+                                       /*float_ops=*/2000000000,
+                                       /*output_bytes=*/4000000));
+  // 0.25 flops/byte at 40 GB/s.
+  stats_->AddNodeForTest(0, CreateNode("add", "Add", {}, 0, 2000, 100,
+                                       /*float_ops=*/1000000,
+                                       /*output_bytes=*/4000000));
+  stats_->BuildAllViews();
+  advisor_.reset(new Advisor(stats_.get()));
+
+  AdvisorOptionsProto options;
+  auto& checker_options =
+      (*(*options.mutable_checkers())[kCheckers[4]].mutable_options());
+  checker_options["accelerator_peak_gflops"] = "10000";
+  checker_options["accelerator_peak_gb_per_sec"] = "400";
+  AdviceProto advice = advisor_->Advise(options);
+  const auto& reports = advice.checkers().at(kCheckers[4]).reports();
+  ASSERT_EQ(reports.size(), 2);
+  EXPECT_TRUE(absl::StrContains(
+      reports[0],
+      "MatMul (accelerator): compute-bound, 500.00 flops/byte, 2000.0 "
+      "GFLOP/s, 4.0 GB/s, 20% of the compute roofline"));
+  EXPECT_TRUE(absl::StrContains(
+      reports[0],
+      "Add (accelerator): memory-bound, 0.25 flops/byte, 10.0 GFLOP/s, 40.0 "
+      "GB/s, 10% of the bandwidth roofline"));
+  EXPECT_TRUE(absl::StrContains(reports[1], "take 9% of the time"));
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -12,13 +12,18 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/perf_counters.h"
 #include "tensorflow/core/profiler/internal/profiler_interface.h"
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -58,6 +63,9 @@ class HostTracer : public ProfilerInterface {
   // True if currently recording.
   bool recording_ = false;
 
+  // True if the hardware counters were started with the recording.
+  bool counting_ = false;
+
   // Container of all traced events.
   TraceMeRecorder::Events events_;
 };
@@ -71,8 +79,40 @@ Status HostTracer::Start() {
   if (recording_) {
     return Status(error::INTERNAL, "TraceMeRecorder already started");
   }
-  recording_ = TraceMeRecorder::Start(host_trace_level_);
+  // Bounds the memory used by long traces, for example on busy servers.
+  int64 max_events_per_thread;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_PROFILER_MAX_EVENTS_PER_THREAD",
+                                         0, &max_events_per_thread));
+  bool overwrite_oldest;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_PROFILER_OVERWRITE_OLDEST_EVENTS",
+                                        false, &overwrite_oldest));
+  TraceMeRecorder::Options options;
+  options.max_events_per_thread = std::max<int64>(0, max_events_per_thread);
+  options.overflow_policy =
+      overwrite_oldest ? TraceMeRecorder::OverflowPolicy::kOverwriteOldest
+                       : TraceMeRecorder::OverflowPolicy::kDropNew;
+  // Counts the hardware events of the threads whose name contains one of
+  // these comma-separated names, or of all threads for "*".
+  string perf_counter_threads;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar("TF_PROFILER_PERF_COUNTER_THREADS",
+                                          "", &perf_counter_threads));
+  if (!perf_counter_threads.empty()) {
+    std::vector<string> thread_names;
+    if (perf_counter_threads != "*") {
+      thread_names = absl::StrSplit(perf_counter_threads, ',',
+                                    absl::SkipEmpty());
+    }
+    Status s = PerfCounters::Start(thread_names);
+    if (s.ok()) {
+      counting_ = true;
+    } else {
+      LOG(WARNING) << "Hardware performance counters disabled: " << s;
+    }
+  }
+  recording_ = TraceMeRecorder::Start(host_trace_level_, options);
   if (!recording_) {
+    if (counting_) PerfCounters::Stop();
+    counting_ = false;
     return Status(error::INTERNAL, "Failed to start TraceMeRecorder");
   }
   return Status::OK();
@@ -82,6 +122,8 @@ Status HostTracer::Stop() {
   if (!recording_) {
     return Status(error::INTERNAL, "TraceMeRecorder not started");
   }
+  if (counting_) PerfCounters::Stop();
+  counting_ = false;
   events_ = TraceMeRecorder::Stop();
   recording_ = false;
   return Status::OK();
@@ -106,7 +148,9 @@ Status HostTracer::CollectData(RunMetadata* run_metadata) {
   StepStatsCollector step_stats_collector(run_metadata->mutable_step_stats());
 
   const string cpu_name = "/host:CPU";
+  uint64 num_dropped = 0;
   for (auto& thread : events_) {
+    num_dropped += thread.num_dropped;
     step_stats_collector.SaveThreadName(cpu_name, thread.thread.tid,
                                         thread.thread.name);
     for (auto& event : thread.events) {
@@ -133,6 +177,16 @@ Status HostTracer::CollectData(RunMetadata* run_metadata) {
         ns->set_all_end_rel_micros((event.end_time - event.start_time) /
                                    EnvTime::kMicrosToNanos);
         ns->set_thread_id(thread.thread.tid);
+        if (event.counters.thread != nullptr) {
+          // Appends the counts to the label, e.g. "instructions=1000".
+          string label = ns->timeline_label();
+          for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+            absl::StrAppend(&label, label.empty() ? "" : " ",
+                            PerfCounters::CounterName(i), "=",
+                            event.counters.counts[i]);
+          }
+          ns->set_timeline_label(std::move(label));
+        }
         // TODO(fishx): Add thread name to RunMetadata
         step_stats_collector.Save(cpu_name, ns);
       }
@@ -140,6 +194,11 @@ Status HostTracer::CollectData(RunMetadata* run_metadata) {
   }
   events_.clear();
   step_stats_collector.Finalize();
+  if (num_dropped > 0) {
+    LOG(WARNING) << "Dropped " << num_dropped
+                 << " host trace events, the per-thread limit is set by "
+                 << "TF_PROFILER_MAX_EVENTS_PER_THREAD.";
+  }
   return Status::OK();
 }
 }  // namespace
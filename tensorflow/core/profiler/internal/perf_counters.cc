@@ -0,0 +1,232 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/perf_counters.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <unordered_set>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#endif
+
+namespace tensorflow {
+namespace profiler {
+
+namespace internal {
+std::atomic<bool> g_perf_counters_active(false);
+}  // namespace internal
+
+const char* PerfCounters::CounterName(int counter) {
+  switch (counter) {
+    case kInstructions:
+      return "instructions";
+    case kCycles:
+      return "cycles";
+    case kLlcMisses:
+      return "llc_misses";
+    default:
+      return "unknown";
+  }
+}
+
+bool PerfCounters::Delta(const Values& start, const Values& end,
+                         Values* delta) {
+  if (start.thread == nullptr || start.thread != end.thread) return false;
+  delta->thread = start.thread;
+  for (int i = 0; i < kNumCounters; ++i) {
+    delta->counts[i] = end.counts[i] - start.counts[i];
+  }
+  return true;
+}
+
+#if defined(__linux__)
+namespace {
+
+class ThreadCounters;
+
+struct CounterState {
+  mutex mu;
+  // Incremented by Start and Stop, so that the threads update their counters.
+  std::atomic<int64> generation{0};
+  std::vector<string> thread_names GUARDED_BY(mu);
+  // The threads with open counters.
+  std::unordered_set<ThreadCounters*> threads GUARDED_BY(mu);
+};
+
+CounterState* GetCounterState() {
+  static CounterState* state = new CounterState;
+  return state;
+}
+
+// Opens the counters of the calling thread as one group, which the kernel
+// schedules together. Returns the file descriptor of the group leader, or -1.
+int OpenCounterGroup(int fds[PerfCounters::kNumCounters]) {
+  static constexpr uint64 kConfigs[PerfCounters::kNumCounters] = {
+      PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_CACHE_MISSES};
+  int group_fd = -1;
+  for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = kConfigs[i];
+    // The group is enabled at once through its leader.
+    attr.disabled = i == 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    fds[i] = syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                     group_fd, PERF_FLAG_FD_CLOEXEC);
+    if (fds[i] < 0) {
+      const int error = errno;
+      for (int j = 0; j < i; ++j) close(fds[j]);
+      errno = error;
+      return -1;
+    }
+    if (i == 0) group_fd = fds[0];
+  }
+  return group_fd;
+}
+
+class ThreadCounters {
+ public:
+  ~ThreadCounters() {
+    if (fds_[0] < 0) return;
+    CounterState* state = GetCounterState();
+    mutex_lock l(state->mu);
+    state->threads.erase(this);
+    for (int fd : fds_) close(fd);
+  }
+
+  bool Read(PerfCounters::Values* values) {
+    const int64 generation =
+        GetCounterState()->generation.load(std::memory_order_acquire);
+    if (TF_PREDICT_FALSE(generation != generation_)) Update();
+    if (!enabled_) return false;
+    struct {
+      uint64 nr;
+      uint64 counts[PerfCounters::kNumCounters];
+    } group;
+    if (read(fds_[0], &group, sizeof(group)) != sizeof(group) ||
+        group.nr != PerfCounters::kNumCounters) {
+      return false;
+    }
+    values->thread = this;
+    for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+      values->counts[i] = group.counts[i];
+    }
+    return true;
+  }
+
+  // Disables the counters, which keeps them open for the next Start().
+  void Disable() {
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+ private:
+  // Opens or enables the counters if the thread is selected, or disables them.
+  void Update() {
+    string name;
+    Env::Default()->GetCurrentThreadName(&name);
+    CounterState* state = GetCounterState();
+    mutex_lock l(state->mu);
+    generation_ = state->generation.load(std::memory_order_relaxed);
+    bool selected = false;
+    if (PerfCounters::Active()) {
+      selected = state->thread_names.empty();
+      for (const string& thread_name : state->thread_names) {
+        if (name.find(thread_name) != string::npos) selected = true;
+      }
+    }
+    if (!selected) {
+      if (enabled_) Disable();
+      enabled_ = false;
+      return;
+    }
+    if (fds_[0] < 0) {
+      if (OpenCounterGroup(fds_) < 0) {
+        VLOG(1) << "Failed to open the perf counters of thread " << name
+                << ": " << strerror(errno);
+        enabled_ = false;
+        return;
+      }
+      state->threads.insert(this);
+    }
+    enabled_ = ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0;
+  }
+
+  int64 generation_ = -1;
+  bool enabled_ = false;
+  int fds_[PerfCounters::kNumCounters] = {-1, -1, -1};
+};
+
+}  // namespace
+
+Status PerfCounters::Start(const std::vector<string>& thread_names) {
+  int fds[kNumCounters];
+  if (OpenCounterGroup(fds) < 0) {
+    return errors::Unavailable("Failed to open the hardware performance ",
+                               "counters: ", strerror(errno));
+  }
+  for (int fd : fds) close(fd);
+  CounterState* state = GetCounterState();
+  mutex_lock l(state->mu);
+  state->thread_names = thread_names;
+  internal::g_perf_counters_active.store(true, std::memory_order_release);
+  state->generation.fetch_add(1, std::memory_order_release);
+  return Status::OK();
+}
+
+void PerfCounters::Stop() {
+  CounterState* state = GetCounterState();
+  mutex_lock l(state->mu);
+  internal::g_perf_counters_active.store(false, std::memory_order_release);
+  state->generation.fetch_add(1, std::memory_order_release);
+  for (ThreadCounters* thread : state->threads) thread->Disable();
+}
+
+bool PerfCounters::Read(Values* values) {
+  static thread_local ThreadCounters counters;
+  return counters.Read(values);
+}
+
+#else  // !defined(__linux__)
+
+Status PerfCounters::Start(const std::vector<string>& thread_names) {
+  return errors::Unimplemented(
+      "Hardware performance counters are only supported on Linux");
+}
+
+void PerfCounters::Stop() {}
+
+bool PerfCounters::Read(Values* values) { return false; }
+
+#endif  // defined(__linux__)
+
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,85 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_PERF_COUNTERS_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_PERF_COUNTERS_H_
+
+#include <atomic>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+namespace internal {
+// Whether the counters are started. Static atomic so PerfCounters::Active can
+// be fast and non-blocking.
+extern std::atomic<bool> g_perf_counters_active;
+}  // namespace internal
+
+// Counts the hardware events of selected threads with Linux
+// perf_event_open(2), so that the TraceMe events of these threads carry the
+// number of instructions, cycles and last level cache misses they took.
+//
+// Each thread opens its own counters the first time it reads them after
+// Start(), and closes them when it exits. Only user space events are counted.
+class PerfCounters {
+ public:
+  enum Counter {
+    kInstructions = 0,
+    kCycles,
+    kLlcMisses,
+    kNumCounters,
+  };
+
+  struct Values {
+    // Identifies the counters of a thread, as a TraceMe may end on another
+    // thread than the one it started on.
+    const void* thread = nullptr;
+    uint64 counts[kNumCounters];
+  };
+
+  // Returns the name of a counter in the traces, e.g. "llc_misses".
+  static const char* CounterName(int counter);
+
+  // Starts counting the threads whose name contains one of `thread_names`, or
+  // all threads if `thread_names` is empty. Returns an error if the counters
+  // are not available, e.g. off Linux or if perf_event_paranoid forbids them.
+  static Status Start(const std::vector<string>& thread_names);
+
+  // Stops counting all threads.
+  static void Stop();
+
+  // Returns whether the counters are started. Racy, but cheap!
+  static inline bool Active() {
+    return ABSL_PREDICT_FALSE(
+        internal::g_perf_counters_active.load(std::memory_order_acquire));
+  }
+
+  // Reads the counters of the calling thread. Returns false if the thread is
+  // not counted.
+  static bool Read(Values* values);
+
+  // Returns the counts between `start` and `end`, or false if they were not
+  // read on the same thread.
+  static bool Delta(const Values& start, const Values& end, Values* delta);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_PERF_COUNTERS_H_
@@ -0,0 +1,113 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/perf_counters.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/traceme_recorder.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Keeps the thread busy, so that it runs some instructions.
+uint64 Work() {
+  volatile uint64 sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  return sum;
+}
+
+// Starts the counters, or returns false if the machine does not have them,
+// e.g. in a virtual machine.
+bool StartCounters(const std::vector<string>& thread_names) {
+  Status s = PerfCounters::Start(thread_names);
+  if (!s.ok()) {
+    LOG(INFO) << "Skipping the test: " << s;
+    return false;
+  }
+  return true;
+}
+
+TEST(PerfCountersTest, CountsTheCallingThread) {
+  if (!StartCounters({})) return;
+  EXPECT_TRUE(PerfCounters::Active());
+  PerfCounters::Values start, end, delta;
+  ASSERT_TRUE(PerfCounters::Read(&start));
+  Work();
+  ASSERT_TRUE(PerfCounters::Read(&end));
+  ASSERT_TRUE(PerfCounters::Delta(start, end, &delta));
+  EXPECT_GT(delta.counts[PerfCounters::kInstructions], 100000);
+  EXPECT_GT(delta.counts[PerfCounters::kCycles], 0);
+  PerfCounters::Stop();
+  EXPECT_FALSE(PerfCounters::Active());
+}
+
+TEST(PerfCountersTest, CountsSelectedThreadsOnly) {
+  if (!StartCounters({"counted"})) return;
+  PerfCounters::Values counted_values, other_values;
+  bool counted = false, other = false;
+  {
+    thread::ThreadPool counted_pool(Env::Default(), "counted", 1);
+    thread::ThreadPool other_pool(Env::Default(), "other", 1);
+    counted_pool.Schedule(
+        [&] { counted = PerfCounters::Read(&counted_values); });
+    other_pool.Schedule([&] { other = PerfCounters::Read(&other_values); });
+  }
+  PerfCounters::Stop();
+  EXPECT_TRUE(counted);
+  EXPECT_FALSE(other);
+
+  // The counts of different threads cannot be subtracted.
+  PerfCounters::Values values, delta;
+  ASSERT_TRUE(StartCounters({}));
+  ASSERT_TRUE(PerfCounters::Read(&values));
+  EXPECT_FALSE(PerfCounters::Delta(counted_values, values, &delta));
+  PerfCounters::Stop();
+}
+
+TEST(PerfCountersTest, TraceMeRecordsCounts) {
+  if (!StartCounters({})) return;
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+  {
+    TraceMe trace("counted");
+    Work();
+  }
+  PerfCounters::Stop();
+  {
+    TraceMe trace("not_counted");
+    Work();
+  }
+  TraceMeRecorder::Events events = TraceMeRecorder::Stop();
+  int num_events = 0;
+  for (const auto& thread : events) {
+    for (const auto& event : thread.events) {
+      ++num_events;
+      if (event.name == "counted") {
+        ASSERT_NE(event.counters.thread, nullptr);
+        EXPECT_GT(event.counters.counts[PerfCounters::kInstructions], 100000);
+      } else {
+        EXPECT_EQ(event.counters.thread, nullptr);
+      }
+    }
+  }
+  EXPECT_EQ(num_events, 2);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
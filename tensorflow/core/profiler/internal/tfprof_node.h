@@ -148,6 +148,17 @@ class ExecStep {
     }
     return output_bytes;
   }
+  // The bytes of the output at `slot`.
+  int64 output_bytes(int32 slot) const {
+    int64 output_bytes = 0;
+    for (const ExecMemory& exec : memory_execs_) {
+      auto it = exec.output_memory().find(slot);
+      if (it != exec.output_memory().end()) {
+        output_bytes += it->second.bytes();
+      }
+    }
+    return output_bytes;
+  }
   int64 accelerator_temp_bytes() const {
     int64 accelerator_temp_bytes = 0;
     for (const ExecMemory& exec : memory_execs_) {
@@ -572,6 +583,36 @@ class TFGraphNode {
   int64 peak_bytes(int64 step) const { GRAPH_NODE_BYTES(peak); }
   int64 residual_bytes(int64 step) const { GRAPH_NODE_BYTES(residual); }
   int64 output_bytes(int64 step) const { GRAPH_NODE_BYTES(output); }
+  // The bytes of the output at `slot`. When step < 0, the average across all
+  // steps.
+  int64 output_bytes(int64 step, int32 slot) const {
+    if (execs_.empty()) {
+      return 0;
+    }
+    if (step >= 0) {
+      auto exec = execs_.find(step);
+      if (exec == execs_.end()) return 0;
+      return exec->second.output_bytes(slot);
+    }
+    int64 bytes = 0;
+    for (const auto& exec : execs_) {
+      bytes += exec.second.output_bytes(slot);
+    }
+    return bytes / execs_.size();
+  }
+  // The bytes of the outputs of the input nodes which this node reads.
+  int64 input_bytes(int64 step) const {
+    int64 input_bytes = 0;
+    if (!nodes_map_) return 0;
+    for (const auto& inp : inputs_) {
+      auto input_it = nodes_map_->find(inp.second);
+      if (input_it == nodes_map_->end() || !input_it->second) continue;
+      auto output_it = src_output_idx_.find(inp.second);
+      if (output_it == src_output_idx_.end()) continue;
+      input_bytes += input_it->second->output_bytes(step, output_it->second);
+    }
+    return input_bytes;
+  }
 
   int64 all_start_micros(int64 step) const {
     auto exec = execs_.find(step);
@@ -15,6 +15,9 @@ limitations under the License.
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 
 #include <cstddef>
+#include <deque>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 
 #include "tensorflow/core/platform/env.h"
 
@@ -33,155 +36,145 @@ static_assert(ATOMIC_INT_LOCK_FREE == 2, "Assumed atomic<int> was lock free");
 
 namespace {
 
-// A single-producer single-consumer queue of Events.
-//
-// Implemented as a linked-list of blocks containing numbered slots, with start
-// and end pointers:
-//
-//  [ events........ | next-]--> [ events......... | next ]
-//  ^start_block_ ^start_         ^end_block_ ^end_
-//
-// start_ is the first occupied slot, end_ is the first unoccupied slot.
-//
-// Push writes at end_, and then advances it, allocating a block if needed.
-// PopAll takes ownership of events in the range [start_, end_).
-// The end_ pointer is atomic so Push and PopAll can be concurrent.
+// The buffering options of the current recording, set by StartRecording.
+std::atomic<size_t> g_max_events_per_thread{0};
+std::atomic<bool> g_overwrite_oldest{false};
+
+}  // namespace
+
+// To avoid unnecessary synchronization between threads, each thread has a
+// ThreadLocalRecorder that independently records its events.
 //
-// Push and PopAll are lock free and each might be called from at most one
-// thread. Push is only called by the owner thread. PopAll is called by the
-// owner thread when it shuts down, or by the tracing control thread.
+// The recorders form a lock-free list which only grows: when a thread exits,
+// its recorder is released and reused by a later thread, once its events have
+// been collected.
 //
-// Thus, PopAll might race with Push, so PopAll only removes events that were
-// in the queue when it was invoked. If Push is called while PopAll is active,
-// the new event remains in the queue. Thus, the tracing control thread should
-// call PopAll when tracing stops to remove events created during tracing, but
-// also when tracing starts again to clear any remaining events.
-class EventQueue {
+// Record is only called by the owner thread, and Clear by the control thread,
+// which holds the TraceMeRecorder mutex. They synchronize with a pair of flags
+// instead of a lock: the owner thread raises `writing_` and the control thread
+// raises `draining_`, and each checks the flag of the other after raising its
+// own. The control thread waits for a Record in progress, which is short, but
+// Record never waits: it drops the event if the control thread is draining
+// the buffer, which only takes a swap.
+class TraceMeRecorder::ThreadLocalRecorder {
  public:
-  EventQueue()
-      : start_block_(new Block{/*start=*/0, /*next=*/nullptr}),
-        start_(start_block_->start),
-        end_block_(start_block_),
-        end_(start_) {}
-
-  // REQUIRES: PopAll() was called since the last Push().
-  // Memory should be deallocated and trace events destroyed on destruction.
-  // This doesn't require global lock as this discards all the stored trace
-  // events and we assume of destruction of this instance only after the last
-  // Push() has been called.
-  ~EventQueue() {
-    DCHECK(Empty()) << "EventQueue destroyed without PopAll()";
-    delete end_block_;
-  }
+  enum State {
+    kFree,       // Not used by any thread, and empty.
+    kAcquiring,  // Being acquired by a thread.
+    kActive,     // Used by a thread.
+    kReleased,   // Its thread exited, with events left to collect.
+  };
 
-  // Add a new event to the back of the queue. Fast and lock-free.
-  void Push(TraceMeRecorder::Event&& event) {
-    size_t end = end_.load(std::memory_order_relaxed);
-    new (&end_block_->events[end++ - end_block_->start].event)
-        TraceMeRecorder::Event(std::move(event));
-    if (ABSL_PREDICT_FALSE(end - end_block_->start == Block::kNumSlots)) {
-      auto* new_block = new Block{end, nullptr};
-      end_block_->next = new_block;
-      end_block_ = new_block;
-    }
-    end_.store(end, std::memory_order_release);  // Write index after contents.
-  }
+  ThreadLocalRecorder() = default;
 
-  // Retrieve and remove all events in the queue at the time of invocation.
-  // If Push is called while PopAll is active, the new event will not be
-  // removed from the queue.
-  std::vector<TraceMeRecorder::Event> PopAll() {
-    // Read index before contents.
-    size_t end = end_.load(std::memory_order_acquire);
-    std::vector<TraceMeRecorder::Event> result;
-    result.reserve(end - start_);
-    while (start_ != end) {
-      result.emplace_back(Pop());
+  // Tries to acquire the recorder for the calling thread.
+  bool TryAcquire() {
+    int expected = kFree;
+    if (!state_.compare_exchange_strong(expected, kAcquiring,
+                                        std::memory_order_acquire)) {
+      return false;
     }
-    return result;
+    auto* env = Env::Default();
+    ThreadInfo info;
+    info.tid = env->GetCurrentThreadId();
+    env->GetCurrentThreadName(&info.name);
+    StartWriting();
+    info_ = std::move(info);
+    state_.store(kActive, std::memory_order_release);
+    writing_.store(false, std::memory_order_release);
+    return true;
   }
 
- private:
-  // Returns true if the queue is empty at the time of invocation.
-  bool Empty() const {
-    return (start_ == end_.load(std::memory_order_acquire));
+  // Called by the owner thread when it shuts down. The recorder is freed
+  // right away if it is empty, otherwise when its events are collected.
+  void Release() {
+    StartWriting();
+    if (events_.empty()) {
+      num_dropped_ = 0;
+      state_.store(kFree, std::memory_order_release);
+    } else {
+      state_.store(kReleased, std::memory_order_release);
+    }
+    writing_.store(false, std::memory_order_release);
   }
 
-  // Remove one event off the front of the queue and return it.
-  // REQUIRES: The queue must not be empty.
-  TraceMeRecorder::Event Pop() {
-    DCHECK(!Empty());
-    // Move the next event into the output.
-    auto& event = start_block_->events[start_++ - start_block_->start].event;
-    TraceMeRecorder::Event out = std::move(event);
-    event.~Event();  // Events must be individually destroyed.
-    // If we reach the end of a block, we own it and should delete it.
-    // The next block is present: end always points to something.
-    if (ABSL_PREDICT_FALSE(start_ - start_block_->start == Block::kNumSlots)) {
-      auto* next_block = start_block_->next;
-      delete start_block_;
-      start_block_ = next_block;
-      DCHECK_EQ(start_, start_block_->start);
+  // Record is only called from the owner thread. Lock-free.
+  void Record(TraceMeRecorder::Event&& event) {
+    writing_.store(true, std::memory_order_seq_cst);
+    if (ABSL_PREDICT_FALSE(draining_.load(std::memory_order_seq_cst))) {
+      writing_.store(false, std::memory_order_release);
+      num_dropped_during_drain_.fetch_add(1, std::memory_order_relaxed);
+      return;
     }
-    return out;
+    const size_t max_events =
+        g_max_events_per_thread.load(std::memory_order_relaxed);
+    if (ABSL_PREDICT_FALSE(max_events != 0 && events_.size() >= max_events)) {
+      ++num_dropped_;
+      if (g_overwrite_oldest.load(std::memory_order_relaxed)) {
+        events_.pop_front();
+        events_.push_back(std::move(event));
+      }
+    } else {
+      events_.push_back(std::move(event));
+    }
+    writing_.store(false, std::memory_order_release);
   }
 
-  struct Block {
-    // The number of slots in a block is chosen so the block fits in 64 KiB.
-    static constexpr size_t kSize = 1 << 16;
-    static constexpr size_t kNumSlots =
-        (kSize - (sizeof(size_t) + sizeof(Block*))) /
-        sizeof(TraceMeRecorder::Event);
-
-    size_t start;  // The number of the first slot.
-    Block* next;
-    // Defer construction of Event until the data is available.
-    // Must also destroy manually, as the block may not fill entirely.
-    union MaybeEvent {
-      MaybeEvent() {}
-      ~MaybeEvent() {}
-      TraceMeRecorder::Event event;
-    } events[kNumSlots];
-  };
-
-  static_assert(sizeof(Block) <= Block::kSize, "");
-
-  // Head of list for reading. Only accessed by consumer thread.
-  Block* start_block_;
-  size_t start_;
-  // Tail of list for writing. Accessed by producer thread.
-  Block* end_block_;
-  std::atomic<size_t> end_;  // Atomic: also read by consumer thread.
-};
-
-}  // namespace
+  // Clear is called from the control thread when tracing starts/stops, or
+  // when the events are dumped. Returns false if the recorder has no thread
+  // and no events.
+  bool Clear(TraceMeRecorder::ThreadEvents* result) {
+    draining_.store(true, std::memory_order_seq_cst);
+    while (writing_.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+    const int state = state_.load(std::memory_order_acquire);
+    if (state != kActive && state != kReleased) {
+      draining_.store(false, std::memory_order_release);
+      return false;
+    }
+    std::deque<TraceMeRecorder::Event> events;
+    std::swap(events, events_);
+    result->thread = info_;
+    result->num_dropped = num_dropped_;
+    num_dropped_ = 0;
+    if (state == kReleased) {
+      // The thread exited before the events were collected, so the recorder
+      // can be reused now.
+      state_.store(kFree, std::memory_order_release);
+    }
+    draining_.store(false, std::memory_order_release);
 
-// To avoid unnecessary synchronization between threads, each thread has a
-// ThreadLocalRecorder that independently records its events.
-class TraceMeRecorder::ThreadLocalRecorder {
- public:
-  // The recorder is created the first time TraceMeRecorder::Record() is called
-  // on a thread.
-  ThreadLocalRecorder() {
-    auto* env = Env::Default();
-    info_.tid = env->GetCurrentThreadId();
-    env->GetCurrentThreadName(&info_.name);
-    TraceMeRecorder::Get()->RegisterThread(info_.tid, this);
+    result->num_dropped +=
+        num_dropped_during_drain_.exchange(0, std::memory_order_relaxed);
+    result->events.assign(std::make_move_iterator(events.begin()),
+                          std::make_move_iterator(events.end()));
+    return true;
   }
 
-  // The destructor is called when the thread shuts down early.
-  ~ThreadLocalRecorder() { TraceMeRecorder::Get()->UnregisterThread(Clear()); }
+  // The next recorder of the list, set before the recorder is published.
+  ThreadLocalRecorder* next = nullptr;
 
-  // Record is only called from the owner thread.
-  void Record(TraceMeRecorder::Event&& event) { queue_.Push(std::move(event)); }
+ private:
+  // Raises `writing_` once the control thread is not draining the buffer.
+  void StartWriting() {
+    while (true) {
+      writing_.store(true, std::memory_order_seq_cst);
+      if (!draining_.load(std::memory_order_seq_cst)) return;
+      writing_.store(false, std::memory_order_release);
+      std::this_thread::yield();
+    }
+  }
 
-  // Clear is called from the control thread when tracing starts/stops, or from
-  // the owner thread when it shuts down (see destructor).
-  TraceMeRecorder::ThreadEvents Clear() { return {info_, queue_.PopAll()}; }
+  std::atomic<int> state_{kFree};
+  std::atomic<bool> writing_{false};
+  std::atomic<bool> draining_{false};
+  std::atomic<uint64> num_dropped_during_drain_{0};
 
- private:
+  // Only accessed by the thread which raised its flag.
   TraceMeRecorder::ThreadInfo info_;
-  EventQueue queue_;
+  std::deque<TraceMeRecorder::Event> events_;
+  uint64 num_dropped_ = 0;
 };
 
 /*static*/ TraceMeRecorder* TraceMeRecorder::Get() {
@@ -189,34 +182,49 @@ class TraceMeRecorder::ThreadLocalRecorder {
   return singleton;
 }
 
-void TraceMeRecorder::RegisterThread(int32 tid, ThreadLocalRecorder* thread) {
-  mutex_lock lock(mutex_);
-  threads_.emplace(tid, thread);
-}
-
-void TraceMeRecorder::UnregisterThread(TraceMeRecorder::ThreadEvents&& events) {
-  mutex_lock lock(mutex_);
-  threads_.erase(events.thread.tid);
-  orphaned_events_.push_back(std::move(events));
+TraceMeRecorder::ThreadLocalRecorder* TraceMeRecorder::AcquireThreadRecorder() {
+  for (ThreadLocalRecorder* recorder = threads_.load(std::memory_order_acquire);
+       recorder != nullptr; recorder = recorder->next) {
+    if (recorder->TryAcquire()) return recorder;
+  }
+  auto* recorder = new ThreadLocalRecorder;
+  recorder->TryAcquire();
+  ThreadLocalRecorder* head = threads_.load(std::memory_order_relaxed);
+  do {
+    recorder->next = head;
+  } while (!threads_.compare_exchange_weak(head, recorder,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  return recorder;
 }
 
 // This method is performance critical and should be kept fast. It is called
-// when tracing starts/stops. The mutex is held, so no threads can be
-// registered/unregistered. This prevents calling ThreadLocalRecorder::Clear
-// from two different threads.
+// when tracing starts/stops. The mutex is held, which prevents calling
+// ThreadLocalRecorder::Clear from two different threads.
 TraceMeRecorder::Events TraceMeRecorder::Clear() {
   TraceMeRecorder::Events result;
-  std::swap(orphaned_events_, result);
-  for (const auto& entry : threads_) {
-    auto* recorder = entry.second;
-    result.push_back(recorder->Clear());
+  for (ThreadLocalRecorder* recorder = threads_.load(std::memory_order_acquire);
+       recorder != nullptr; recorder = recorder->next) {
+    TraceMeRecorder::ThreadEvents events;
+    if (recorder->Clear(&events)) {
+      result.push_back(std::move(events));
+    }
   }
   return result;
 }
 
-bool TraceMeRecorder::StartRecording(int level) {
+bool TraceMeRecorder::StartRecording(int level, const Options& options) {
   level = std::max(0, level);
   mutex_lock lock(mutex_);
+  if (internal::g_trace_level.load(std::memory_order_acquire) !=
+      kTracingDisabled) {
+    return false;
+  }
+  g_max_events_per_thread.store(options.max_events_per_thread,
+                                std::memory_order_relaxed);
+  g_overwrite_oldest.store(
+      options.overflow_policy == OverflowPolicy::kOverwriteOldest,
+      std::memory_order_relaxed);
   // Change trace_level_ while holding mutex_.
   int expected = kTracingDisabled;
   bool started = internal::g_trace_level.compare_exchange_strong(
@@ -229,8 +237,14 @@ bool TraceMeRecorder::StartRecording(int level) {
 }
 
 void TraceMeRecorder::Record(Event event) {
-  static thread_local ThreadLocalRecorder thread_local_recorder;
-  thread_local_recorder.Record(std::move(event));
+  // Holds the recorder of the thread, from its first Record until it exits.
+  struct ThreadRecorder {
+    ThreadRecorder() : recorder(Get()->AcquireThreadRecorder()) {}
+    ~ThreadRecorder() { recorder->Release(); }
+    ThreadLocalRecorder* const recorder;
+  };
+  static thread_local ThreadRecorder thread_recorder;
+  thread_recorder.recorder->Record(std::move(event));
 }
 
 TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
@@ -244,5 +258,15 @@ TraceMeRecorder::Events TraceMeRecorder::StopRecording() {
   return events;
 }
 
+TraceMeRecorder::Events TraceMeRecorder::DumpRecording() {
+  TraceMeRecorder::Events events;
+  mutex_lock lock(mutex_);
+  if (internal::g_trace_level.load(std::memory_order_acquire) !=
+      kTracingDisabled) {
+    events = Clear();
+  }
+  return events;
+}
+
 }  // namespace profiler
 }  // namespace tensorflow
@@ -18,11 +18,11 @@ limitations under the License.
 #include <atomic>
 #include <cstddef>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "absl/base/optimization.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/profiler/internal/perf_counters.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -46,6 +46,12 @@ extern std::atomic<int> g_trace_level;
 // events, and the destructor records end events.
 // The profiler then stops the recorder and finds start/end pairs. (Unpaired
 // start/end events are discarded at that point).
+//
+// Each thread buffers its events on its own, and registers its buffer without
+// taking a lock, so recording never blocks. The buffers can be bounded, which
+// also allows a continuous "flight recorder" mode: record with
+// kOverwriteOldest and call Dump() after an interesting event, such as a
+// latency spike, to get the most recent events of each thread.
 class TraceMeRecorder {
  public:
   // An Event is either the start of a TraceMe, the end of a TraceMe, or both.
@@ -55,6 +61,9 @@ class TraceMeRecorder {
     string name;
     uint64 start_time;  // 0 = missing
     uint64 end_time;    // 0 = missing
+    // Hardware counts of the thread during a complete event, see
+    // PerfCounters. counters.thread is null if the thread is not counted.
+    PerfCounters::Values counters;
   };
   struct ThreadInfo {
     int32 tid;
@@ -63,18 +72,39 @@ class TraceMeRecorder {
   struct ThreadEvents {
     ThreadInfo thread;
     std::vector<Event> events;
+    // Number of events of the thread which were dropped or overwritten.
+    uint64 num_dropped = 0;
   };
   using Events = std::vector<ThreadEvents>;
 
+  // What a thread does with a new event when its buffer is full.
+  enum class OverflowPolicy {
+    kDropNew,
+    kOverwriteOldest,
+  };
+
+  struct Options {
+    // Maximum number of events buffered by each thread, 0 for no limit.
+    size_t max_events_per_thread = 0;
+    OverflowPolicy overflow_policy = OverflowPolicy::kDropNew;
+  };
+
   // Starts recording of TraceMe().
   // Only traces <= level will be recorded.
   // Level must be >= 0. If level is 0, no traces will be recorded.
-  static bool Start(int level) { return Get()->StartRecording(level); }
+  static bool Start(int level) { return Get()->StartRecording(level, {}); }
+  static bool Start(int level, const Options& options) {
+    return Get()->StartRecording(level, options);
+  }
 
   // Stops recording and returns events recorded since Start().
   // Events passed to Record after Stop has started will be dropped.
   static Events Stop() { return Get()->StopRecording(); }
 
+  // Returns the events recorded since Start() or the previous Dump(), and
+  // keeps recording. Returns no events if the recorder is not started.
+  static Events Dump() { return Get()->DumpRecording(); }
+
   // Returns whether we're currently recording. Racy, but cheap!
   static inline bool Active(int level = 1) {
     return ABSL_PREDICT_FALSE(
@@ -99,21 +129,22 @@ class TraceMeRecorder {
   TraceMeRecorder(const TraceMeRecorder&) = delete;
   TraceMeRecorder& operator=(const TraceMeRecorder&) = delete;
 
-  void RegisterThread(int32 tid, ThreadLocalRecorder* thread);
-  void UnregisterThread(ThreadEvents&& events);
+  // Returns a recorder for the calling thread, reusing the recorder of a
+  // thread which has exited if possible. Lock-free.
+  ThreadLocalRecorder* AcquireThreadRecorder();
 
-  bool StartRecording(int level);
+  bool StartRecording(int level, const Options& options);
   Events StopRecording();
+  Events DumpRecording();
 
-  // Gathers events from all active threads, and clears their buffers.
+  // Gathers events from all threads, and clears their buffers.
   Events Clear() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Serializes the control operations: Start, Stop and Dump.
   mutex mutex_;
-  // Map of the static container instances (thread_local storage) for each
-  // thread. While active, a ThreadLocalRecorder stores trace events.
-  std::unordered_map<int32, ThreadLocalRecorder*> threads_ GUARDED_BY(mutex_);
-  // Events from threads that died during recording.
-  TraceMeRecorder::Events orphaned_events_ GUARDED_BY(mutex_);
+  // Lock-free list of the recorders, which are never deleted. While active, a
+  // ThreadLocalRecorder stores the trace events of one thread.
+  std::atomic<ThreadLocalRecorder*> threads_{nullptr};
 };
 
 }  // namespace profiler
@@ -46,6 +46,87 @@ TEST(RecorderTest, SingleThreaded) {
               ::testing::ElementsAre(Named("during1"), Named("during2")));
 }
 
+TEST(RecorderTest, DropsNewEventsWhenFull) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  TraceMeRecorder::Options options;
+  options.max_events_per_thread = 2;
+  options.overflow_policy = TraceMeRecorder::OverflowPolicy::kDropNew;
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1, options));
+  EXPECT_FALSE(TraceMeRecorder::Start(/*level=*/1, options));
+  TraceMeRecorder::Record({1, "first", start_time, end_time});
+  TraceMeRecorder::Record({2, "second", start_time, end_time});
+  TraceMeRecorder::Record({3, "third", start_time, end_time});
+  auto results = TraceMeRecorder::Stop();
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events,
+              ::testing::ElementsAre(Named("first"), Named("second")));
+  EXPECT_EQ(results[0].num_dropped, 1);
+}
+
+TEST(RecorderTest, FlightRecorder) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  EXPECT_TRUE(TraceMeRecorder::Dump().empty());
+  TraceMeRecorder::Options options;
+  options.max_events_per_thread = 2;
+  options.overflow_policy = TraceMeRecorder::OverflowPolicy::kOverwriteOldest;
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1, options));
+  TraceMeRecorder::Record({1, "first", start_time, end_time});
+  TraceMeRecorder::Record({2, "second", start_time, end_time});
+  TraceMeRecorder::Record({3, "third", start_time, end_time});
+  auto dumped = TraceMeRecorder::Dump();
+  ASSERT_EQ(dumped.size(), 1);
+  EXPECT_THAT(dumped[0].events,
+              ::testing::ElementsAre(Named("second"), Named("third")));
+  EXPECT_EQ(dumped[0].num_dropped, 1);
+
+  // Recording goes on after a dump.
+  EXPECT_TRUE(TraceMeRecorder::Active());
+  TraceMeRecorder::Record({4, "fourth", start_time, end_time});
+  auto results = TraceMeRecorder::Stop();
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_THAT(results[0].events, ::testing::ElementsAre(Named("fourth")));
+  EXPECT_EQ(results[0].num_dropped, 0);
+}
+
+TEST(RecorderTest, CollectsEventsOfExitedThreads) {
+  uint64 start_time = Env::Default()->NowNanos();
+  uint64 end_time = start_time + kNanosInSec;
+
+  ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+  {
+    thread::ThreadPool pool(Env::Default(), "testpool", 1);
+    pool.Schedule([start_time, end_time] {
+      TraceMeRecorder::Record({1, "exited", start_time, end_time});
+    });
+  }
+  auto results = TraceMeRecorder::Stop();
+  int num_exited = 0;
+  for (const auto& thread : results) {
+    for (const auto& event : thread.events) {
+      if (event.name == "exited") ++num_exited;
+    }
+  }
+  EXPECT_EQ(num_exited, 1);
+
+  // The recorder of the exited thread is reused by the next thread, so the
+  // number of threads does not grow.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(TraceMeRecorder::Start(/*level=*/1));
+    {
+      thread::ThreadPool pool(Env::Default(), "testpool", 1);
+      pool.Schedule([start_time, end_time] {
+        TraceMeRecorder::Record({1, "exited", start_time, end_time});
+      });
+    }
+    EXPECT_EQ(TraceMeRecorder::Stop().size(), results.size());
+  }
+}
+
 void SpinNanos(int nanos) {
   uint64 deadline = Env::Default()->NowNanos() + nanos;
   while (Env::Default()->NowNanos() < deadline) {
@@ -42,5 +42,11 @@ uint64 NewActivityId() {
                            /*end_time=*/EnvTime::Default()->NowNanos()});
 }
 
+/* static */ void TraceMe::EndCounters(const PerfCounters::Values& start,
+                                       PerfCounters::Values* delta) {
+  PerfCounters::Values end;
+  if (PerfCounters::Read(&end)) PerfCounters::Delta(start, end, delta);
+}
+
 }  // namespace profiler
 }  // namespace tensorflow
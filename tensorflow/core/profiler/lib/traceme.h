@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/perf_counters.h"
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 
 namespace tensorflow {
@@ -68,6 +69,8 @@ enum TraceMeLevel {
 //          auto id = ActivityStart("step");
 //          ... do some work ...
 //          ActivityEnd(id);
+//       Unlike the scoped objects, these do not record the hardware counters
+//       of the thread (see PerfCounters).
 class TraceMe {
  public:
   // Constructor that traces a user-defined activity labeled with activity_name
@@ -82,6 +85,7 @@ class TraceMe {
     if (TraceMeRecorder::Active(level)) {
       new (&no_init_.name) string(activity_name);
       start_time_ = EnvTime::Default()->NowNanos();
+      if (PerfCounters::Active()) PerfCounters::Read(&start_counters_);
     } else {
       start_time_ = kUntracedActivity;
     }
@@ -97,6 +101,7 @@ class TraceMe {
     if (TraceMeRecorder::Active(level)) {
       new (&no_init_.name) string(std::move(activity_name));
       start_time_ = EnvTime::Default()->NowNanos();
+      if (PerfCounters::Active()) PerfCounters::Read(&start_counters_);
     } else {
       start_time_ = kUntracedActivity;
     }
@@ -127,6 +132,7 @@ class TraceMe {
     if (TraceMeRecorder::Active(level)) {
       new (&no_init_.name) string(name_generator());
       start_time_ = EnvTime::Default()->NowNanos();
+      if (PerfCounters::Active()) PerfCounters::Read(&start_counters_);
     } else {
       start_time_ = kUntracedActivity;
     }
@@ -146,8 +152,13 @@ class TraceMe {
     //   start/stop session timestamp.
     if (start_time_ != kUntracedActivity) {
       if (TraceMeRecorder::Active()) {
-        TraceMeRecorder::Record({kCompleteActivity, std::move(no_init_.name),
-                                 start_time_, EnvTime::Default()->NowNanos()});
+        TraceMeRecorder::Event event{kCompleteActivity,
+                                     std::move(no_init_.name), start_time_,
+                                     EnvTime::Default()->NowNanos()};
+        if (start_counters_.thread != nullptr) {
+          EndCounters(start_counters_, &event.counters);
+        }
+        TraceMeRecorder::Record(std::move(event));
       }
       no_init_.name.~string();
       start_time_ = kUntracedActivity;
@@ -187,6 +198,10 @@ class TraceMe {
 
   static uint64 ActivityStartImpl(absl::string_view activity_name);
   static void ActivityEndImpl(uint64 activity_id);
+  // Sets `delta` to the hardware counts since `start`, if the TraceMe ends on
+  // the thread it started on.
+  static void EndCounters(const PerfCounters::Values& start,
+                          PerfCounters::Values* delta);
 
   // Wrap the name into a union so that we can avoid the cost of string
   // initialization when tracing is disabled.
@@ -197,6 +212,8 @@ class TraceMe {
   } no_init_;
 
   uint64 start_time_;
+  // Hardware counters of the thread when the TraceMe started, if counted.
+  PerfCounters::Values start_counters_;
 };
 
 }  // namespace profiler
@@ -259,6 +259,26 @@ class Session {
         "RunCallable with threadpool is not supported for this session.");
   }
 
+  /// \brief Binds caller-owned tensors to the subgraph named by `handle`.
+  ///
+  /// Later calls to `RunCallable()` with an empty `feed_tensors` feed the
+  /// tensors bound here, whose contents the caller may update in place
+  /// between runs. When a fetched value is produced on the host by a kernel
+  /// output with the dtype and shape of the matching tensor in
+  /// `fetch_tensors`, the kernel writes the value directly into that tensor,
+  /// and `RunCallable()` returns a tensor sharing its buffer. Other fetched
+  /// values are returned as usual. An empty list, or an uninitialized tensor
+  /// in `fetch_tensors`, leaves the corresponding inputs or outputs unbound.
+  /// Binding replaces any previous binding. Runs of a subgraph with bound
+  /// fetches must not overlap.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status BindCallable(CallableHandle handle,
+                              const std::vector<Tensor>& feed_tensors,
+                              const std::vector<Tensor>& fetch_tensors) {
+    return errors::Unimplemented(
+        "BindCallable is not supported for this session.");
+  }
+
   /// \brief Releases resources associated with the given `handle` in this
   /// session.
   /// NOTE: This API is still experimental and may change.
@@ -21,9 +21,12 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
@@ -32,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/bfloat16/bfloat16.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -394,6 +398,134 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
   return status;
 }
 
+// Appends the data bytes of "val" to "out", which holds "*size" bytes, and pads
+// them to "data_alignment".  Fills in the offset, size and checksum of "entry".
+Status AppendTensor(const Tensor& val, int data_alignment,
+                    FileOutputBuffer* out, int64* size,
+                    BundleEntryProto* entry) {
+  entry->set_offset(*size);
+  size_t data_bytes_written = 0;
+  uint32 crc32c = 0;
+  out->clear_crc32c();
+  if (val.dtype() == DT_STRING) {
+    TF_RETURN_IF_ERROR(
+        WriteStringTensor(val, out, &data_bytes_written, &crc32c));
+  } else if (val.dtype() == DT_VARIANT) {
+    TF_RETURN_IF_ERROR(
+        WriteVariantTensor(val, out, &data_bytes_written, &crc32c));
+  } else {
+    TF_RETURN_IF_ERROR(WriteTensor(val, out, &data_bytes_written));
+    crc32c = out->crc32c();
+  }
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(crc32c));
+  *size += data_bytes_written;
+  return PadAlignment(out, data_alignment, size);
+}
+
+// Records "slice_spec" in the entry of its full tensor, and returns the key of
+// the entry of the slice itself.
+//
+// In the case of a sharded save, MergeBundles() is responsible for merging
+// the "slices" field of multiple metadata entries corresponding to the same
+// full tensor.
+string AddSliceToFullEntry(StringPiece full_tensor_key,
+                           const TensorShape& full_tensor_shape,
+                           const TensorSlice& slice_spec, DataType dtype,
+                           std::map<string, BundleEntryProto>* entries) {
+  const string full_tensor_key_string(full_tensor_key);
+  BundleEntryProto* full_entry = &(*entries)[full_tensor_key_string];
+  if (full_entry->dtype() != DT_INVALID) {
+    CHECK_EQ(full_entry->dtype(), dtype);
+  }
+  if (full_entry->has_shape()) {
+    CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
+  }
+
+  // Populates dtype, shape, and slices.  Intentionally leaving out shard_id and
+  // offset, which do not make sense for this full tensor entry.
+  full_entry->set_dtype(dtype);
+  full_tensor_shape.AsProto(full_entry->mutable_shape());
+  TensorSliceProto* slice_proto = full_entry->add_slices();
+  slice_spec.AsProto(slice_proto);
+
+  return checkpoint::EncodeTensorNameSlice(full_tensor_key_string, slice_spec);
+}
+
+// Writes the metadata table of a bundle with "num_shards" data files to
+// "tmp_metadata_path", and renames it into place on success.
+Status WriteMetadataTable(Env* env, StringPiece prefix,
+                          const string& tmp_metadata_path, int num_shards,
+                          const std::map<string, BundleEntryProto>& entries) {
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_metadata_path, &file));
+  Status status;
+  {
+    // N.B.: the default use of Snappy compression may not be supported on all
+    // platforms (e.g. Android).  The metadata file is small, so this is fine.
+    table::Options options;
+    options.compression = table::kNoCompression;
+    table::TableBuilder builder(options, file.get());
+    // Header entry.
+    BundleHeaderProto header;
+    header.set_num_shards(num_shards);
+    header.set_endianness(BundleHeaderProto::LITTLE);
+    if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
+    VersionDef* version = header.mutable_version();
+    version->set_producer(kTensorBundleVersion);
+    version->set_min_consumer(kTensorBundleMinConsumer);
+
+    builder.Add(kHeaderEntryKey, header.SerializeAsString());
+
+    // All others.
+    for (const auto& p : entries) {
+      builder.Add(p.first, p.second.SerializeAsString());
+    }
+    status = builder.Finish();
+  }
+  status.Update(file->Close());
+  if (!status.ok()) {
+    env->DeleteFile(tmp_metadata_path).IgnoreError();
+    return status;
+  }
+  return env->RenameFile(tmp_metadata_path, MetaFilename(prefix));
+}
+
+Status CheckChecksum(const BundleEntryProto& entry, uint32 actual_crc32c) {
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  return Status::OK();
+}
+
+// The buffer of a tensor restored without a copy, which points into a data
+// file mapped into memory and keeps it mapped.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     uint64 offset, size_t size)
+      : TensorBuffer(const_cast<char*>(
+            static_cast<const char*>(region->data()) + offset)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("BundleReader");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
@@ -433,27 +565,10 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
   entry->set_shard_id(0);
-  entry->set_offset(size_);
 
   // Updates the data file.
-  size_t data_bytes_written = 0;
-  uint32 crc32c = 0;
-  out_->clear_crc32c();
-  if (val.dtype() == DT_STRING) {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
-  } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
-  } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32c();
-  }
-
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
-    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
-  }
+  status_ =
+      AppendTensor(val, options_.data_alignment, out_.get(), &size_, entry);
   return status_;
 }
 
@@ -470,30 +585,12 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   }
 
   // Inserts/updates the full tensor's metadata entry.
-  //
-  // In the case of a sharded save, MergeBundles() is responsible for merging
-  // the "slices" field of multiple metadata entries corresponding to the same
-  // full tensor.
-  const string full_tensor_key_string(full_tensor_key);
-  BundleEntryProto* full_entry = &entries_[full_tensor_key_string];
-  if (full_entry->dtype() != DT_INVALID) {
-    CHECK_EQ(full_entry->dtype(), slice_tensor.dtype());
-  }
-  if (full_entry->has_shape()) {
-    CHECK(TensorShape(full_entry->shape()) == full_tensor_shape);
-  }
-
-  // Populates dtype, shape, and slices.  Intentionally leaving out shard_id and
-  // offset, which do not make sense for this full tensor entry.
-  full_entry->set_dtype(slice_tensor.dtype());
-  full_tensor_shape.AsProto(full_entry->mutable_shape());
-  TensorSliceProto* slice_proto = full_entry->add_slices();
-  slice_spec.AsProto(slice_proto);
+  const string slice_name =
+      AddSliceToFullEntry(full_tensor_key, full_tensor_shape, slice_spec,
+                          slice_tensor.dtype(), &entries_);
 
   // The slice itself is handled by a regular Add(), which includes adding its
   // own metadata entry, and writing out the slice's values.
-  const string slice_name =
-      checkpoint::EncodeTensorNameSlice(full_tensor_key_string, slice_spec);
   status_ = Add(slice_name, slice_tensor);
   return status_;
 }
@@ -513,45 +610,177 @@ Status BundleWriter::Finish() {
   }
   if (!status_.ok()) return status_;
   // Build key -> BundleEntryProto table.
-  std::unique_ptr<WritableFile> file;
-  status_ = env_->NewWritableFile(tmp_metadata_path_, &file);
+  status_ = WriteMetadataTable(env_, prefix_, tmp_metadata_path_,
+                               /*num_shards=*/1, entries_);
   if (!status_.ok()) return status_;
-  {
-    // N.B.: the default use of Snappy compression may not be supported on all
-    // platforms (e.g. Android).  The metadata file is small, so this is fine.
-    table::Options options;
-    options.compression = table::kNoCompression;
-    table::TableBuilder builder(options, file.get());
-    // Header entry.
-    BundleHeaderProto header;
-    header.set_num_shards(1);
-    header.set_endianness(BundleHeaderProto::LITTLE);
-    if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
-    VersionDef* version = header.mutable_version();
-    version->set_producer(kTensorBundleVersion);
-    version->set_min_consumer(kTensorBundleMinConsumer);
+  status_ = errors::Internal("BundleWriter is closed");
+  return Status::OK();
+}
 
-    builder.Add(kHeaderEntryKey, header.SerializeAsString());
+// Interface for writing a tensor bundle in the background.
 
-    // All others.
-    for (const auto& p : entries_) {
-      builder.Add(p.first, p.second.SerializeAsString());
-    }
-    status_ = builder.Finish();
+AsyncBundleWriter::AsyncBundleWriter(Env* env, StringPiece prefix,
+                                     thread::ThreadPool* pool,
+                                     const Options& options)
+    : env_(env), pool_(pool), options_(options), prefix_(prefix) {
+  CHECK_GE(options_.num_shards, 1);
+  status_ = env_->CreateDir(string(io::Dirname(prefix_)));
+  if (errors::IsAlreadyExists(status_)) status_ = Status::OK();
+}
+
+AsyncBundleWriter::~AsyncBundleWriter() {
+  mutex_lock l(mu_);
+  while (!finished_) {
+    cv_.wait(l);
   }
-  status_.Update(file->Close());
-  if (!status_.ok()) {
-    Env::Default()->DeleteFile(tmp_metadata_path_).IgnoreError();
+}
+
+Status AsyncBundleWriter::Add(StringPiece key, const Tensor& val) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  const string key_string(key);
+  if (entries_.find(key_string) != entries_.end()) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
     return status_;
-  } else {
-    status_ =
-        Env::Default()->RenameFile(tmp_metadata_path_, MetaFilename(prefix_));
-    if (!status_.ok()) return status_;
   }
-  status_ = errors::Internal("BundleWriter is closed");
+
+  BundleEntryProto* entry = &entries_[key_string];
+  entry->set_dtype(val.dtype());
+  val.shape().AsProto(entry->mutable_shape());
+  tensors_[key_string] = options_.copy_tensors ? tensor::DeepCopy(val) : val;
   return Status::OK();
 }
 
+Status AsyncBundleWriter::AddSlice(StringPiece full_tensor_key,
+                                   const TensorShape& full_tensor_shape,
+                                   const TensorSlice& slice_spec,
+                                   const Tensor& slice_tensor) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(full_tensor_key, kHeaderEntryKey);
+
+  // If just a singleton full slice, use the regular Add() to be more efficient.
+  if (IsFullSlice(slice_spec, full_tensor_shape)) {
+    return Add(full_tensor_key, slice_tensor);
+  }
+  const string slice_name =
+      AddSliceToFullEntry(full_tensor_key, full_tensor_shape, slice_spec,
+                          slice_tensor.dtype(), &entries_);
+  return Add(slice_name, slice_tensor);
+}
+
+void AsyncBundleWriter::FinishAsync(StatusCallback done) {
+  if (!status_.ok()) {
+    done(status_);
+    return;
+  }
+  status_ = errors::Internal("AsyncBundleWriter is closed");
+
+  // Balances the bytes of the shards by assigning the largest tensors first,
+  // each to the smallest shard.
+  std::vector<std::pair<int64, const string*>> tensor_sizes;
+  tensor_sizes.reserve(tensors_.size());
+  for (const auto& p : tensors_) {
+    tensor_sizes.emplace_back(p.second.TotalBytes(), &p.first);
+  }
+  std::sort(tensor_sizes.begin(), tensor_sizes.end(),
+            [](const std::pair<int64, const string*>& a,
+               const std::pair<int64, const string*>& b) {
+              if (a.first != b.first) return a.first > b.first;
+              return *a.second < *b.second;
+            });
+  const int num_shards = std::max<int>(
+      1, std::min<int>(options_.num_shards, tensor_sizes.size()));
+  shards_.resize(num_shards);
+  for (int i = 0; i < num_shards; ++i) {
+    shards_[i].id = i;
+    shards_[i].tmp_data_path =
+        strings::StrCat(DataFilename(prefix_, i, num_shards), ".tempstate",
+                        random::New64());
+  }
+  for (const auto& tensor_size : tensor_sizes) {
+    Shard* shard = &*std::min_element(
+        shards_.begin(), shards_.end(),
+        [](const Shard& a, const Shard& b) { return a.size < b.size; });
+    shard->keys.push_back(tensor_size.second);
+    shard->size += tensor_size.first;
+  }
+  // Like BundleWriter, writes the tensors of each shard in key order.
+  for (Shard& shard : shards_) {
+    std::sort(shard.keys.begin(), shard.keys.end(),
+              [](const string* a, const string* b) { return *a < *b; });
+  }
+
+  done_ = std::move(done);
+  {
+    mutex_lock l(mu_);
+    num_pending_shards_ = num_shards;
+    finished_ = false;
+  }
+  for (Shard& shard : shards_) {
+    pool_->Schedule([this, &shard]() { WriteShard(&shard); });
+  }
+}
+
+void AsyncBundleWriter::WriteShard(Shard* shard) {
+  std::unique_ptr<WritableFile> file;
+  Status s = env_->NewWritableFile(shard->tmp_data_path, &file);
+  if (s.ok()) {
+    VLOG(1) << "Writing to file " << shard->tmp_data_path;
+    FileOutputBuffer out(file.release(), 8 << 20 /* 8MB write buffer */);
+    int64 size = 0;
+    for (const string* key : shard->keys) {
+      // Other shards concurrently update other entries.
+      BundleEntryProto* entry = &entries_.find(*key)->second;
+      Tensor* val = &tensors_.find(*key)->second;
+      entry->set_shard_id(shard->id);
+      s = AppendTensor(*val, options_.data_alignment, &out, &size, entry);
+      if (!s.ok()) break;
+      // Releases the snapshot as soon as it is written.
+      *val = Tensor();
+    }
+    s.Update(out.Close());
+  }
+  ShardDone(s);
+}
+
+void AsyncBundleWriter::ShardDone(const Status& s) {
+  Status status;
+  {
+    mutex_lock l(mu_);
+    write_status_.Update(s);
+    if (--num_pending_shards_ > 0) return;
+    status = write_status_;
+  }
+
+  // The last shard to finish moves the data files into place and writes the
+  // metadata.
+  for (const Shard& shard : shards_) {
+    if (status.ok()) {
+      status = env_->RenameFile(
+          shard.tmp_data_path,
+          DataFilename(prefix_, shard.id, shards_.size()));
+    } else {
+      env_->DeleteFile(shard.tmp_data_path).IgnoreError();
+    }
+  }
+  if (status.ok()) {
+    status = WriteMetadataTable(
+        env_, prefix_,
+        strings::StrCat(MetaFilename(prefix_), ".tempstate", random::New64()),
+        shards_.size(), entries_);
+  }
+  tensors_.clear();
+
+  StatusCallback done = std::move(done_);
+  {
+    mutex_lock l(mu_);
+    finished_ = true;
+    cv_.notify_all();
+  }
+  // The writer may be deleted from here on.
+  done(status);
+}
+
 // Merging tensor bundles.
 
 // Accumulator of metadata states during a merge.
@@ -809,19 +1038,14 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
-Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
-  Tensor* ret = val;
-  const TensorShape stored_shape(TensorShape(entry.shape()));
-  if (val->NumElements() == 0) {
-    ret = new Tensor(entry.dtype(), stored_shape);
-  }
-
-  // Validates the "size" field.
+Status BundleReader::CheckEntrySize(StringPiece key,
+                                    const BundleEntryProto& entry,
+                                    const Tensor& val) {
   if (entry.dtype() != DT_STRING && entry.dtype() != DT_VARIANT) {
-    if (entry.size() != ret->TotalBytes()) {
-      return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+    if (entry.size() != val.TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", key,
                               "; stored size ", entry.size(),
-                              "; expected size ", ret->TotalBytes());
+                              "; expected size ", val.TotalBytes());
     }
   } else if (entry.dtype() == DT_STRING) {
     // Relaxes the check for string tensors as follows:
@@ -829,32 +1053,74 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     //                >= NumElems + bytes(data), since size bytes(varint) >= 1.
     //   TotalBytes() == sizeof(tstring) * NumElems + bytes(data)
     // Since we don't know bytes(varint lengths), we just check an inequality.
-    const size_t lower_bound = ret->NumElements() + ret->TotalBytes() -
-                               sizeof(tstring) * ret->NumElements();
+    const size_t lower_bound = val.NumElements() + val.TotalBytes() -
+                               sizeof(tstring) * val.NumElements();
     if (entry.size() < lower_bound) {
-      return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+      return errors::DataLoss("Invalid size in bundle entry: key ", key,
                               "; stored size ", entry.size(),
                               "; expected size is at least ", lower_bound);
     }
   }
+  return Status::OK();
+}
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  io::InputBuffer*& cached = data_[shard_id];
+  if (cached == nullptr) {
     std::unique_ptr<RandomAccessFile> file = nullptr;
     TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    cached = new io::InputBuffer(file.release(), kBufferSize);
     // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
   }
-  CHECK(buffered_file != nullptr);
+  *buffered_file = cached;
+  return Status::OK();
+}
+
+Status BundleReader::GetMappedDataFile(
+    int32 shard_id, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &mapped);
+    if (errors::IsUnimplemented(s)) {
+      VLOG(1) << "Reading " << filename << " as it cannot be mapped: " << s;
+    } else {
+      TF_RETURN_IF_ERROR(s);
+    }
+    it = mapped_data_.emplace(shard_id, std::move(mapped)).first;
+  }
+  *region = it->second;
+  return Status::OK();
+}
+
+Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  Tensor* ret = val;
+  const TensorShape stored_shape(TensorShape(entry.shape()));
+  if (val->NumElements() == 0) {
+    ret = new Tensor(entry.dtype(), stored_shape);
+  }
+
+  TF_RETURN_IF_ERROR(CheckEntrySize(key(), entry, *ret));
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+  TF_RETURN_IF_ERROR(ReadValue(entry, buffered_file, ret));
+
+  *val = *ret;
+  if (ret != val) delete ret;
+  return Status::OK();
+}
 
+Status BundleReader::ReadValue(const BundleEntryProto& entry,
+                               io::InputBuffer* buffered_file,
+                               Tensor* val) const {
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
 
   if (DataTypeCanUseMemcpy(entry.dtype())) {
-    char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
+    char* backing_buffer = const_cast<char*>((val->tensor_data().data()));
     size_t unused_bytes_read;
     if (entry.size() > kBufferSize) {
       StringPiece sp;
@@ -871,7 +1137,7 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     // should be on the bytes in the order they appear in the file.
     actual_crc32c = crc32c::Value(backing_buffer, entry.size());
     if (need_to_swap_bytes_) {
-      TF_RETURN_IF_ERROR(ByteSwapTensor(ret));
+      TF_RETURN_IF_ERROR(ByteSwapTensor(val));
     }
   } else if (entry.dtype() == DT_VARIANT) {
     if (need_to_swap_bytes_) {
@@ -883,25 +1149,16 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
     // Relies on io::InputBuffer's buffering, because we issue many neighboring
     // reads for a single string tensor.
-    TF_RETURN_IF_ERROR(ReadVariantTensor(buffered_file, ret, entry.offset(),
+    TF_RETURN_IF_ERROR(ReadVariantTensor(buffered_file, val, entry.offset(),
                                          entry.size(), &actual_crc32c));
   } else {
     // Relies on io::InputBuffer's buffering, because we issue many neighboring
     // reads for a single string tensor.
     TF_RETURN_IF_ERROR(ReadStringTensor(
-        buffered_file, ret->NumElements(), entry.offset(), entry.size(),
-        GetStringBackingBuffer(*ret), &actual_crc32c, need_to_swap_bytes_));
+        buffered_file, val->NumElements(), entry.offset(), entry.size(),
+        GetStringBackingBuffer(*val), &actual_crc32c, need_to_swap_bytes_));
   }
-  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
-    return errors::DataLoss(
-        "Checksum does not match: stored ",
-        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
-        " vs. calculated on the restored bytes ", actual_crc32c);
-  }
-
-  *val = *ret;
-  if (ret != val) delete ret;
-  return Status::OK();
+  return CheckChecksum(entry, actual_crc32c);
 }
 
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
@@ -956,6 +1213,101 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
+Status BundleReader::LookupMany(gtl::ArraySlice<string> keys,
+                                const LookupOptions& options,
+                                std::vector<Tensor>* vals) {
+  vals->clear();
+  vals->resize(keys.size());
+  std::vector<Status> statuses(keys.size());
+
+  // Looks up the entries and opens the data files on the calling thread, as
+  // they use the table iterator and the file caches.
+  struct PendingRead {
+    size_t index;
+    BundleEntryProto entry;
+    RandomAccessFile* file;  // Null if the tensor is memory-mapped.
+  };
+  std::vector<PendingRead> reads;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BundleEntryProto entry;
+    statuses[i] = GetBundleEntryProto(keys[i], &entry);
+    if (!statuses[i].ok()) continue;
+    const TensorShape shape(entry.shape());
+    Tensor* val = &(*vals)[i];
+    if (!entry.slices().empty()) {
+      *val = Tensor(entry.dtype(), shape);
+      statuses[i] = GetSliceValue(keys[i], entry,
+                                  /* a full slice */ TensorSlice(shape.dims()),
+                                  val);
+      continue;
+    }
+
+    if (options.memory_map && DataTypeCanUseMemcpy(entry.dtype()) &&
+        !need_to_swap_bytes_ && entry.size() > 0 &&
+        entry.size() == shape.num_elements() * DataTypeSize(entry.dtype())) {
+      std::shared_ptr<ReadOnlyMemoryRegion> region;
+      statuses[i] = GetMappedDataFile(entry.shard_id(), &region);
+      if (!statuses[i].ok()) continue;
+      const uintptr_t address =
+          region == nullptr
+              ? 0
+              : reinterpret_cast<uintptr_t>(region->data()) + entry.offset();
+      if (region != nullptr &&
+          entry.offset() + entry.size() <= region->length() &&
+          address % Allocator::kAllocatorAlignment == 0) {
+        MappedTensorBuffer* buf =
+            new MappedTensorBuffer(region, entry.offset(), entry.size());
+        *val = Tensor(entry.dtype(), shape, buf);
+        buf->Unref();
+        if (options.verify_mapped_checksums) {
+          reads.push_back({i, std::move(entry), nullptr});
+        }
+        continue;
+      }
+    }
+
+    io::InputBuffer* buffered_file;
+    statuses[i] = GetDataFile(entry.shard_id(), &buffered_file);
+    if (!statuses[i].ok()) continue;
+    reads.push_back({i, std::move(entry), buffered_file->file()});
+  }
+
+  // Reads the tensors and validates their checksums, each through its own
+  // InputBuffer so that they can run concurrently.
+  auto read = [this, &keys, vals, &statuses](const PendingRead& r) {
+    Tensor* val = &(*vals)[r.index];
+    if (r.file == nullptr) {
+      statuses[r.index] = CheckChecksum(
+          r.entry, crc32c::Value(val->tensor_data().data(), r.entry.size()));
+      return;
+    }
+    *val = Tensor(r.entry.dtype(), TensorShape(r.entry.shape()));
+    Status s = CheckEntrySize(keys[r.index], r.entry, *val);
+    if (s.ok()) {
+      // Larger memcpy tensors are read directly into their buffer.
+      const int64 buffer_size = std::min<int64>(r.entry.size(), kBufferSize);
+      io::InputBuffer buffered_file(r.file, std::max<int64>(buffer_size, 1));
+      s = ReadValue(r.entry, &buffered_file, val);
+    }
+    statuses[r.index] = s;
+  };
+  if (options.pool == nullptr || reads.size() <= 1) {
+    for (const PendingRead& r : reads) read(r);
+  } else {
+    BlockingCounter counter(reads.size());
+    for (const PendingRead& r : reads) {
+      options.pool->Schedule([&read, &r, &counter]() {
+        read(r);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+
+  for (const Status& s : statuses) TF_RETURN_IF_ERROR(s);
+  return Status::OK();
+}
+
 Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
                                    const BundleEntryProto& full_tensor_entry,
                                    const TensorSlice& slice_spec, Tensor* val) {
@@ -64,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -71,12 +72,15 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/table.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_slice_set.h"
@@ -159,6 +163,85 @@ class BundleWriter {
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
 
+// Like BundleWriter, but writes the bundle in the background so that the
+// caller only waits for the tensors to be snapshotted.  The tensors are spread
+// across up to "num_shards" data files, which are written and checksummed
+// concurrently on a thread pool.  Usage:
+//
+//   AsyncBundleWriter writer(env, "/fs/model/train/ckpt-step/ckpt", pool);
+//   TF_RETURN_IF_ERROR(writer.Add("name", tensor));
+//   writer.FinishAsync([](const Status& s) { ... });
+//
+// All threads accessing the same AsyncBundleWriter must synchronize.
+class AsyncBundleWriter {
+ public:
+  struct Options {
+    Options() {}
+    // Alignment, in bytes, for tensor data.  See BundleWriter::Options.
+    int data_alignment{1};
+    // Maximum number of data files, which are written concurrently.
+    int num_shards{1};
+    // Whether Add() deep copies the tensors.  Otherwise their buffers are
+    // shared, which snapshots them as long as they are not updated in place
+    // while they are written: resource variables copy their shared buffers
+    // before updating them, but reference variables do not.
+    bool copy_tensors{false};
+  };
+  // Writes the data files on "pool", which must outlive the writer.
+  AsyncBundleWriter(Env* env, StringPiece prefix, thread::ThreadPool* pool,
+                    const Options& options = Options());
+  // Waits for the bundle to be written, if FinishAsync() was called.
+  ~AsyncBundleWriter();
+
+  // Snapshots the tensor "val" under key "key".
+  // Across calls "key" must be unique but can be added in any order.
+  Status Add(StringPiece key, const Tensor& val);
+
+  // Snapshots a slice of a partitioned tensor.  See BundleWriter::AddSlice().
+  Status AddSlice(StringPiece full_tensor_key,
+                  const TensorShape& full_tensor_shape,
+                  const TensorSlice& slice_spec, const Tensor& slice_tensor);
+
+  // Starts writing the bundle, and calls "done" once its files are in place
+  // or on the first error.  No other method may be called afterwards.
+  void FinishAsync(StatusCallback done);
+
+  Status status() const { return status_; }
+
+ private:
+  // The tensors written to one data file.
+  struct Shard {
+    int32 id;
+    string tmp_data_path;
+    std::vector<const string*> keys;  // Into "entries_".
+    int64 size = 0;  // Number of bytes of the tensors.
+  };
+
+  // Writes the data file of "shard" on the pool.
+  void WriteShard(Shard* shard);
+  // Writes the metadata once all the shards are written, and calls "done_".
+  void ShardDone(const Status& s);
+
+  Env* const env_;  // Not owned.
+  thread::ThreadPool* const pool_;  // Not owned.
+  const Options options_;
+  const string prefix_;
+  std::map<string, BundleEntryProto> entries_;
+  // The snapshots of the tensors, keyed like their entries.
+  std::unordered_map<string, Tensor> tensors_;
+  std::vector<Shard> shards_;
+  StatusCallback done_;
+  Status status_;
+
+  mutex mu_;
+  condition_variable cv_;
+  int num_pending_shards_ GUARDED_BY(mu_) = 0;
+  Status write_status_ GUARDED_BY(mu_);
+  bool finished_ GUARDED_BY(mu_) = true;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncBundleWriter);
+};
+
 // Merges a set of bundles (given their prefixes) into a single bundle with the
 // given "merged_prefix".  The merged metadata is guaranteed to be consistent.
 //
@@ -243,6 +326,33 @@ class BundleReader {
   Status LookupSlice(StringPiece full_tensor_key, const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
 
+  struct LookupOptions {
+    // If not null, the tensors are read and their checksums validated
+    // concurrently on this pool.  Not owned.
+    thread::ThreadPool* pool = nullptr;
+    // Maps the data files into memory, and returns the tensors that can use
+    // memcpy and whose contents are aligned to Allocator::kAllocatorAlignment
+    // (see BundleWriter::Options::data_alignment) without copying them.  Such
+    // tensors are read-only, and keep their data file mapped while they live.
+    // The other tensors are read as without this option.
+    bool memory_map = false;
+    // Whether to validate the checksums of the memory-mapped tensors, which
+    // reads them.  Otherwise their pages are only read on first access.
+    bool verify_mapped_checksums = true;
+  };
+
+  // Looks up the tensors keyed by "keys" into "vals", which are allocated with
+  // the stored dtypes and shapes.  Partitioned tensors are looked up as by
+  // "Lookup()", on the calling thread.
+  //
+  // Returns the error of the first key in "keys" that fails, in which case
+  // "vals" may contain nonsense data.
+  //
+  // Validates the stored crc32c checksums against the restored bytes.
+  // REQUIRES: status().ok()
+  Status LookupMany(gtl::ArraySlice<string> keys, const LookupOptions& options,
+                    std::vector<Tensor>* vals) TF_MUST_USE_RESULT;
+
   // Seeks to the first position in the bundle whose key is no less than "key".
   // REQUIRES: status().ok()
   void Seek(StringPiece key) { return iter_->Seek(key); }
@@ -274,6 +384,27 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Validates the "size" field of "entry", keyed by "key", against "val".
+  static Status CheckEntrySize(StringPiece key, const BundleEntryProto& entry,
+                               const Tensor& val) TF_MUST_USE_RESULT;
+
+  // Opens the data file of shard "shard_id" if it has not been opened.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
+  // Maps the data file of shard "shard_id" into memory if it has not been
+  // mapped.  Sets "region" to null if the file system cannot map it.
+  Status GetMappedDataFile(int32 shard_id,
+                           std::shared_ptr<ReadOnlyMemoryRegion>* region)
+      TF_MUST_USE_RESULT;
+
+  // Reads the tensor value described by "entry" from "buffered_file" into
+  // "val", which has the right shape and dtype, and validates its checksum.
+  // Different threads may read concurrently through different InputBuffers.
+  Status ReadValue(const BundleEntryProto& entry,
+                   io::InputBuffer* buffered_file,
+                   Tensor* val) const TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -291,6 +422,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The data files mapped by "LookupMany()", shared with the tensors that
+  // point into them.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -18,13 +18,16 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -886,6 +889,68 @@ TEST(TensorBundleTest, DirectoryStructure) {
                           "merged.data-00001-of-00002"});
 }
 
+// Finishes "writer" and waits for the bundle to be written.
+Status FinishAndWait(AsyncBundleWriter* writer) {
+  Status status;
+  Notification done;
+  writer->FinishAsync([&status, &done](const Status& s) {
+    status = s;
+    done.Notify();
+  });
+  done.WaitForNotification();
+  return status;
+}
+
+TEST(TensorBundleTest, AsyncWriter) {
+  Env* env = Env::Default();
+  thread::ThreadPool pool(env, "async_writer", 3);
+  AsyncBundleWriter::Options opts;
+  opts.num_shards = 3;
+  opts.copy_tensors = true;
+  {
+    AsyncBundleWriter writer(env, Prefix("async"), &pool, opts);
+    Tensor updated = Constant_2x3(1.f);
+    TF_EXPECT_OK(writer.Add("float", updated));
+    // The snapshot is taken by Add().
+    updated.flat<float>().setConstant(2.f);
+    TF_EXPECT_OK(writer.Add("int", Constant(5, TensorShape({100, 100}))));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("0,2"),
+                                 test::AsTensor<int64>({0, 1})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("2,2"),
+                                 test::AsTensor<int64>({2, 3})));
+    TF_ASSERT_OK(FinishAndWait(&writer));
+  }
+  StringPiece dir = io::Dirname(Prefix("async"));
+  for (const char* file : {"async.index", "async.data-00000-of-00003",
+                           "async.data-00001-of-00003",
+                           "async.data-00002-of-00003"}) {
+    TF_EXPECT_OK(env->FileExists(io::JoinPath(dir, file)));
+  }
+
+  BundleReader reader(env, Prefix("async"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "float", Constant_2x3(1.f));
+  Expect<int>(&reader, "int", Constant(5, TensorShape({100, 100})));
+  Expect<tstring>(&reader, "strings",
+                  test::AsTensor<tstring>({"hello", "world"}));
+  Expect<int64>(&reader, "part", test::AsTensor<int64>({0, 1, 2, 3}));
+}
+
+TEST(TensorBundleTest, AsyncWriterError) {
+  thread::ThreadPool pool(Env::Default(), "async_writer", 2);
+  AsyncBundleWriter writer(Env::Default(), Prefix("async_dup"), &pool);
+  TF_EXPECT_OK(writer.Add("foo", Constant_2x3(1.f)));
+  EXPECT_FALSE(writer.Add("foo", Constant_2x3(2.f)).ok());
+  Status status = FinishAndWait(&writer);
+  EXPECT_TRUE(absl::StrContains(status.ToString(), "duplicate key"));
+  EXPECT_TRUE(errors::IsNotFound(
+      Env::Default()->FileExists(MetaFilename(Prefix("async_dup")))));
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
@@ -973,6 +1038,111 @@ TEST(TensorBundleTest, Checksum) {
   }
 }
 
+// Returns whether "val" points into a memory-mapped data file.
+bool IsMemoryMapped(const Tensor& val) {
+  TensorDescription description;
+  val.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         "BundleReader";
+}
+
+TEST(TensorBundleTest, LookupMany) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("many"));
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("int", Constant(5, TensorShape({100, 100}))));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("0,2"),
+                                 test::AsTensor<int64>({0, 1})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4}),
+                                 TensorSlice::ParseOrDie("2,2"),
+                                 test::AsTensor<int64>({2, 3})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  thread::ThreadPool pool(Env::Default(), "lookup_many", 4);
+  BundleReader::LookupOptions options;
+  for (thread::ThreadPool* p : {static_cast<thread::ThreadPool*>(nullptr),
+                                &pool}) {
+    options.pool = p;
+    BundleReader reader(Env::Default(), Prefix("many"));
+    TF_ASSERT_OK(reader.status());
+    std::vector<Tensor> vals;
+    TF_ASSERT_OK(reader.LookupMany({"strings", "float", "part", "int"},
+                                   options, &vals));
+    ASSERT_EQ(4, vals.size());
+    test::ExpectTensorEqual<tstring>(
+        vals[0], test::AsTensor<tstring>({"hello", "world"}));
+    test::ExpectTensorEqual<float>(vals[1], Constant_2x3(1.f));
+    test::ExpectTensorEqual<int64>(vals[2],
+                                   test::AsTensor<int64>({0, 1, 2, 3}));
+    test::ExpectTensorEqual<int>(vals[3],
+                                 Constant(5, TensorShape({100, 100})));
+
+    Status status = reader.LookupMany({"float", "missing"}, options, &vals);
+    EXPECT_TRUE(errors::IsNotFound(status));
+    EXPECT_TRUE(absl::StrContains(status.ToString(), "missing"));
+  }
+}
+
+TEST(TensorBundleTest, LookupManyMemoryMapped) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), Prefix("mapped"), opts);
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("int", Constant(5, TensorShape({100, 100}))));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  thread::ThreadPool pool(Env::Default(), "lookup_many", 4);
+  BundleReader::LookupOptions options;
+  options.pool = &pool;
+  options.memory_map = true;
+  std::vector<Tensor> vals;
+  {
+    BundleReader reader(Env::Default(), Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(
+        reader.LookupMany({"float", "int", "strings"}, options, &vals));
+  }
+  // The mapped tensors outlive the reader.
+  ASSERT_EQ(3, vals.size());
+  EXPECT_TRUE(IsMemoryMapped(vals[0]));
+  EXPECT_TRUE(IsMemoryMapped(vals[1]));
+  EXPECT_FALSE(IsMemoryMapped(vals[2]));
+  test::ExpectTensorEqual<float>(vals[0], Constant_2x3(1.f));
+  test::ExpectTensorEqual<int>(vals[1], Constant(5, TensorShape({100, 100})));
+  test::ExpectTensorEqual<tstring>(
+      vals[2], test::AsTensor<tstring>({"hello", "world"}));
+
+  // Corrupts the int tensor, whose mapped contents are still checksummed.
+  const string datafile = DataFilename(Prefix("mapped"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), datafile, &data));
+  const int int_offset = Allocator::kAllocatorAlignment;
+  data[int_offset] = ~data[int_offset];
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), datafile, data));
+  for (bool memory_map : {false, true}) {
+    options.memory_map = memory_map;
+    BundleReader reader(Env::Default(), Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    Status status = reader.LookupMany({"float", "int"}, options, &vals);
+    EXPECT_TRUE(errors::IsDataLoss(status));
+    EXPECT_TRUE(
+        absl::StrContains(status.ToString(), "Checksum does not match"));
+  }
+
+  // Unless the checksums of the mapped tensors are not validated.
+  options.verify_mapped_checksums = false;
+  BundleReader reader(Env::Default(), Prefix("mapped"));
+  TF_ASSERT_OK(reader.status());
+  TF_ASSERT_OK(reader.LookupMany({"float", "int"}, options, &vals));
+  EXPECT_TRUE(IsMemoryMapped(vals[1]));
+}
+
 TEST(TensorBundleTest, TruncatedTensorContents) {
   Env* env = Env::Default();
   BundleWriter writer(env, Prefix("end"));
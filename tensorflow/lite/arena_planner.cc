@@ -14,10 +14,36 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/arena_planner.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <utility>
 
+#include "tensorflow/lite/minimal_logging.h"
+
 namespace tflite {
+namespace {
+
+// The version of the format written by EncodeArenaPlan().
+constexpr int32_t kArenaPlanVersion = 1;
+// Version, subgraph index and number of tensors.
+constexpr size_t kArenaPlanHeaderWords = 3;
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+// The lifetime of a tensor, in allocation events.
+struct Lifetime {
+  int tensor;
+  size_t bytes;
+  int first;
+  int last;
+};
+
+}  // namespace
 
 struct AllocationInfo {
   // The node index requesting this allocation.
@@ -52,6 +78,35 @@ std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
   return 0;
 }
 
+void ArenaPlanner::SetOfflinePlan(std::vector<ArenaAlloc> plan) {
+  offline_plan_ = std::move(plan);
+}
+
+std::vector<ArenaAlloc> ArenaPlanner::GetArenaPlan() const {
+  std::vector<ArenaAlloc> plan(allocs_.size());
+  for (size_t i = 0; i < allocs_.size(); ++i) {
+    if (graph_info_->tensor(i)->allocation_type == kTfLiteArenaRw) {
+      plan[i] = allocs_[i];
+    }
+  }
+  return plan;
+}
+
+bool ArenaPlanner::OfflinePlanMatches() const {
+  if (offline_plan_.empty() ||
+      graph_info_->num_tensors() > offline_plan_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < graph_info_->num_tensors(); ++i) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    if (tensor.allocation_type == kTfLiteArenaRw &&
+        tensor.bytes != offline_plan_[i].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TfLiteStatus ArenaPlanner::ResetAllocations() {
   TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
   TF_LITE_ENSURE_STATUS(persistent_arena_.ClearPlan());
@@ -192,6 +247,15 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   TF_LITE_ENSURE(context_, graph_info_->num_tensors() >= allocs_.size());
   allocs_.resize(graph_info_->num_tensors());
 
+  plan_ = nullptr;
+  if (OfflinePlanMatches()) {
+    plan_ = &offline_plan_;
+  } else if (strategy_ == ArenaPlanningStrategy::kDecreasingSizeBestFit &&
+             first_node == 0 &&
+             last_node >= static_cast<int>(graph_info_->num_nodes()) - 1) {
+    TF_LITE_ENSURE_STATUS(CalculateDecreasingSizePlan(&decreasing_size_plan_));
+    if (!decreasing_size_plan_.empty()) plan_ = &decreasing_size_plan_;
+  }
   TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
   TF_LITE_ENSURE_STATUS(Commit());
 
@@ -235,10 +299,29 @@ TfLiteStatus ArenaPlanner::AcquireNonPersistentMemory() {
 TfLiteStatus ArenaPlanner::Commit() {
   TF_LITE_ENSURE_STATUS(arena_.Commit(context_));
   TF_LITE_ENSURE_STATUS(persistent_arena_.Commit(context_));
+  arena_size_report_.arena_bytes = arena_.high_water_mark();
+  arena_size_report_.persistent_arena_bytes =
+      persistent_arena_.high_water_mark();
   return kTfLiteOk;
 }
 
-TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
+template <typename Visitor>
+TfLiteStatus ArenaPlanner::VisitAllocations(int first_node, int last_node,
+                                            const Visitor& visit) {
+  // Visits the temporaries of a node.
+  auto visit_internal_tensors = [this, &visit](int node_index,
+                                               bool alloc) -> TfLiteStatus {
+    if (node_index < static_cast<int>(graph_info_->num_nodes())) {
+      const TfLiteNode& node =
+          graph_info_->node(static_cast<size_t>(node_index));
+      TfLiteIntArray* node_temporaries = node.temporaries;
+      for (int i = 0; i < node_temporaries->size; ++i) {
+        TF_LITE_ENSURE_STATUS(visit(node_temporaries->data[i], alloc));
+      }
+    }
+    return kTfLiteOk;
+  };
+
   int active_node = first_node;
   // When dynamic tensors are present this method is called multiple times.
   // The items in the alloc_queue_ referring to nodes before first_node were
@@ -252,17 +335,15 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
       // time to deallocate the previous temporaries and allocate new ones.
       if (active_node != first_node) {
         TF_LITE_ENSURE_STATUS(
-            CalculateDeallocationOfInternalTensors(active_node - 1));
+            visit_internal_tensors(active_node - 1, /*alloc=*/false));
       }
-      TF_LITE_ENSURE_STATUS(CalculateAllocationOfInternalTensors(active_node));
+      TF_LITE_ENSURE_STATUS(
+          visit_internal_tensors(active_node, /*alloc=*/true));
       ++active_node;
     }
     // Handle the current item.
-    if (alloc_info.type == AllocationInfo::ALLOC) {
-      TF_LITE_ENSURE_STATUS(CalculateTensorAllocation(alloc_info.tensor));
-    } else {
-      TF_LITE_ENSURE_STATUS(CalculateTensorDeallocation(alloc_info.tensor));
-    }
+    TF_LITE_ENSURE_STATUS(
+        visit(alloc_info.tensor, alloc_info.type == AllocationInfo::ALLOC));
   }
 
   // For the case if the graph is empty the node index can be negative since we
@@ -271,9 +352,113 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   if (active_node > 0) {
     // Don't forget to deallocate temporaries of last node.
     TF_LITE_ENSURE_STATUS(
-        CalculateDeallocationOfInternalTensors(active_node - 1));
+        visit_internal_tensors(active_node - 1, /*alloc=*/false));
+  }
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
+  return VisitAllocations(
+      first_node, last_node, [this](int tensor_index, bool alloc) {
+        return alloc ? CalculateTensorAllocation(tensor_index)
+                     : CalculateTensorDeallocation(tensor_index);
+      });
+}
+
+TfLiteStatus ArenaPlanner::CalculateDecreasingSizePlan(
+    std::vector<ArenaAlloc>* plan) {
+  plan->clear();
+  const int last_node = static_cast<int>(graph_info_->num_nodes()) - 1;
+
+  // Derive the lifetimes of the tensors from the order of the allocations,
+  // and plan the same allocations in order to compare the arena sizes.
+  std::vector<Lifetime> lifetimes;
+  std::vector<int> lifetime_index(graph_info_->num_tensors(), -1);
+  SimpleMemoryArena in_order_arena(kDefaultArenaAlignment);
+  std::vector<ArenaAlloc> in_order_allocs(graph_info_->num_tensors());
+  size_t in_order_bytes = 0;
+  int event = 0;
+  TF_LITE_ENSURE_STATUS(VisitAllocations(
+      0, last_node, [&](int tensor_index, bool alloc) -> TfLiteStatus {
+        const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+        if (tensor.allocation_type != kTfLiteArenaRw) return kTfLiteOk;
+        ArenaAlloc& in_order_alloc = in_order_allocs[tensor_index];
+        if (!alloc) {
+          lifetimes[lifetime_index[tensor_index]].last = event++;
+          return in_order_arena.Deallocate(context_, in_order_alloc);
+        }
+        TF_LITE_ENSURE_STATUS(in_order_arena.Allocate(
+            context_, tensor_alignment_, tensor.bytes, &in_order_alloc));
+        in_order_bytes = std::max(in_order_bytes,
+                                  in_order_alloc.offset + in_order_alloc.size);
+        // A temporary of several nodes gets one lifetime spanning them.
+        if (lifetime_index[tensor_index] < 0) {
+          lifetime_index[tensor_index] = lifetimes.size();
+          lifetimes.push_back({tensor_index, tensor.bytes, event,
+                               std::numeric_limits<int>::max()});
+        } else {
+          lifetimes[lifetime_index[tensor_index]].last =
+              std::numeric_limits<int>::max();
+        }
+        ++event;
+        return kTfLiteOk;
+      }));
+
+  std::stable_sort(lifetimes.begin(), lifetimes.end(),
+                   [](const Lifetime& a, const Lifetime& b) {
+                     return a.bytes > b.bytes;
+                   });
+
+  // Place the largest tensors first. Each tensor goes in the smallest gap
+  // between the placed tensors alive at the same time, or after them.
+  std::vector<ArenaAlloc> allocs(graph_info_->num_tensors());
+  std::vector<const Lifetime*> placed;
+  std::vector<const ArenaAlloc*> overlapping;
+  size_t decreasing_size_bytes = 0;
+  for (const Lifetime& lifetime : lifetimes) {
+    if (lifetime.bytes == 0) continue;
+    overlapping.clear();
+    for (const Lifetime* other : placed) {
+      if (other->first <= lifetime.last && lifetime.first <= other->last) {
+        overlapping.push_back(&allocs[other->tensor]);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(),
+              [](const ArenaAlloc* a, const ArenaAlloc* b) {
+                return a->offset < b->offset;
+              });
+    size_t current_offset = 0;
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_offset_fit = std::numeric_limits<size_t>::max();
+    for (const ArenaAlloc* other : overlapping) {
+      const size_t aligned_offset = AlignTo(tensor_alignment_, current_offset);
+      if (aligned_offset + lifetime.bytes <= other->offset &&
+          other->offset - current_offset < best_offset_fit) {
+        best_offset = aligned_offset;
+        best_offset_fit = other->offset - current_offset;
+      }
+      current_offset = std::max(current_offset, other->offset + other->size);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = AlignTo(tensor_alignment_, current_offset);
+    }
+    ArenaAlloc& alloc = allocs[lifetime.tensor];
+    alloc.offset = best_offset;
+    alloc.size = lifetime.bytes;
+    decreasing_size_bytes =
+        std::max(decreasing_size_bytes, alloc.offset + alloc.size);
+    placed.push_back(&lifetime);
   }
 
+  arena_size_report_.in_order_bytes = in_order_bytes;
+  arena_size_report_.decreasing_size_bytes = decreasing_size_bytes;
+  TFLITE_LOG(TFLITE_LOG_INFO,
+             "Arena plan: %zu bytes in order, %zu bytes by decreasing size.",
+             in_order_bytes, decreasing_size_bytes);
+  if (decreasing_size_bytes < in_order_bytes) {
+    *plan = std::move(allocs);
+  }
   return kTfLiteOk;
 }
 
@@ -297,6 +482,13 @@ TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
 TfLiteStatus ArenaPlanner::CalculateTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
+    // Fall back to searching the arena if the planned bytes are taken, e.g.
+    // because delegates changed the lifetimes of the tensors.
+    if (plan_ != nullptr &&
+        arena_.TryAllocateAt(tensor_alignment_, (*plan_)[tensor_index].offset,
+                             tensor.bytes, &allocs_[tensor_index])) {
+      return kTfLiteOk;
+    }
     TF_LITE_ENSURE_STATUS(arena_.Allocate(
         context_, tensor_alignment_, tensor.bytes, &allocs_[tensor_index]));
   }
@@ -315,30 +507,48 @@ TfLiteStatus ArenaPlanner::CalculateTensorDeallocation(int tensor_index) {
   return kTfLiteOk;
 }
 
-TfLiteStatus ArenaPlanner::CalculateAllocationOfInternalTensors(
-    int node_index) {
-  if (node_index < static_cast<int>(graph_info_->num_nodes())) {
-    const TfLiteNode& node = graph_info_->node(static_cast<size_t>(node_index));
-    TfLiteIntArray* node_temporaries = node.temporaries;
-    for (int i = 0; i < node_temporaries->size; ++i) {
-      int tensor_index = node_temporaries->data[i];
-      TF_LITE_ENSURE_STATUS(CalculateTensorAllocation(tensor_index));
-    }
+bool EncodeArenaPlan(int subgraph_index, const std::vector<ArenaAlloc>& plan,
+                     std::string* data) {
+  const size_t kMax = std::numeric_limits<int32_t>::max();
+  std::vector<int32_t> words;
+  words.reserve(kArenaPlanHeaderWords + 2 * plan.size());
+  words.push_back(kArenaPlanVersion);
+  words.push_back(subgraph_index);
+  words.push_back(static_cast<int32_t>(plan.size()));
+  for (const ArenaAlloc& alloc : plan) {
+    if (alloc.offset > kMax || alloc.size > kMax) return false;
+    words.push_back(static_cast<int32_t>(alloc.offset));
+    words.push_back(static_cast<int32_t>(alloc.size));
   }
-  return kTfLiteOk;
+  data->assign(reinterpret_cast<const char*>(words.data()),
+               words.size() * sizeof(int32_t));
+  return true;
 }
 
-TfLiteStatus ArenaPlanner::CalculateDeallocationOfInternalTensors(
-    int node_index) {
-  if (node_index < static_cast<int>(graph_info_->num_nodes())) {
-    const TfLiteNode& node = graph_info_->node(static_cast<size_t>(node_index));
-    TfLiteIntArray* node_temporaries = node.temporaries;
-    for (int i = 0; i < node_temporaries->size; ++i) {
-      int tensor_index = node_temporaries->data[i];
-      TF_LITE_ENSURE_STATUS(CalculateTensorDeallocation(tensor_index));
-    }
+bool DecodeArenaPlan(const uint8_t* data, size_t size, int* subgraph_index,
+                     std::vector<ArenaAlloc>* plan) {
+  if (size % sizeof(int32_t) != 0 ||
+      size < kArenaPlanHeaderWords * sizeof(int32_t)) {
+    return false;
   }
-  return kTfLiteOk;
+  std::vector<int32_t> words(size / sizeof(int32_t));
+  memcpy(words.data(), data, size);
+  const int32_t num_tensors = words[2];
+  if (words[0] != kArenaPlanVersion || words[1] < 0 || num_tensors < 0 ||
+      words.size() !=
+          kArenaPlanHeaderWords + 2 * static_cast<size_t>(num_tensors)) {
+    return false;
+  }
+  *subgraph_index = words[1];
+  plan->assign(num_tensors, ArenaAlloc());
+  for (int32_t i = 0; i < num_tensors; ++i) {
+    const int32_t offset = words[kArenaPlanHeaderWords + 2 * i];
+    const int32_t alloc_size = words[kArenaPlanHeaderWords + 2 * i + 1];
+    if (offset < 0 || alloc_size < 0) return false;
+    (*plan)[i].offset = offset;
+    (*plan)[i].size = alloc_size;
+  }
+  return true;
 }
 
 }  // namespace tflite
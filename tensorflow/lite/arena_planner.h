@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -30,6 +31,35 @@ namespace tflite {
 constexpr const int kDefaultArenaAlignment = 64;
 constexpr const int kDefaultTensorAlignment = 64;
 
+// The name of the model metadata holding the arena plans computed ahead of
+// time, one metadata per subgraph. See EncodeArenaPlan().
+constexpr const char kArenaPlanMetadataName[] = "arena_plan";
+
+// How ArenaPlanner assigns offsets in the kTfLiteArenaRw arena.
+enum class ArenaPlanningStrategy {
+  // Places each tensor when it is allocated, in the best fitting gap between
+  // the tensors which are alive at that point.
+  kInOrderBestFit,
+  // Computes the lifetimes of all tensors first, then places them from the
+  // largest to the smallest, each in the best fitting gap between the placed
+  // tensors whose lifetimes overlap its own. This usually leaves less
+  // fragmentation, but needs the sizes of all tensors, so graphs with dynamic
+  // tensors keep planning in order. The smaller of both plans is used.
+  kDecreasingSizeBestFit,
+};
+
+// The sizes of the arenas.
+struct ArenaSizeReport {
+  // The sizes of the kTfLiteArenaRw arena planned with each strategy, for the
+  // last whole graph planned with kDecreasingSizeBestFit.
+  size_t in_order_bytes = 0;
+  size_t decreasing_size_bytes = 0;
+  // The high-water marks of the kTfLiteArenaRw and kTfLiteArenaRwPersistent
+  // arenas when they were last committed.
+  size_t arena_bytes = 0;
+  size_t persistent_arena_bytes = 0;
+};
+
 struct AllocationInfo;
 
 // A memory planner that makes all the allocations using arenas.
@@ -72,7 +102,31 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Sets an arena plan computed ahead of time for the same graph, e.g. by
+  // GetArenaPlan(). As long as the kTfLiteArenaRw tensors have the sizes in
+  // the plan, ExecuteAllocations() places them at their planned offsets
+  // instead of searching the arena for the best fitting gap. Otherwise, e.g.
+  // after an input was resized, the planner ignores the plan.
+  void SetOfflinePlan(std::vector<ArenaAlloc> plan);
+
+  // Returns the allocations of all tensors in the kTfLiteArenaRw arena, and
+  // empty allocations for the other tensors. Only complete once all nodes
+  // were passed to ExecuteAllocations().
+  std::vector<ArenaAlloc> GetArenaPlan() const;
+
+  // Takes effect at the next ExecuteAllocations() of the whole graph.
+  void SetPlanningStrategy(ArenaPlanningStrategy strategy) {
+    strategy_ = strategy;
+  }
+
+  const ArenaSizeReport& arena_size_report() const {
+    return arena_size_report_;
+  }
+
  private:
+  // Whether the kTfLiteArenaRw tensors have the sizes in the offline plan.
+  bool OfflinePlanMatches() const;
+
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
   TfLiteStatus Commit();
@@ -81,6 +135,18 @@ class ArenaPlanner : public MemoryPlanner {
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Calls `visit` for each allocation (with `alloc` true) and deallocation of
+  // the tensors affected by ops in the interval [first_node, last_node],
+  // including their temporaries, in order.
+  template <typename Visitor>
+  TfLiteStatus VisitAllocations(int first_node, int last_node,
+                                const Visitor& visit);
+
+  // Plans the kTfLiteArenaRw tensors of the whole graph with
+  // kDecreasingSizeBestFit into `plan`. Leaves `plan` empty if the plan is
+  // not smaller than the one made in order.
+  TfLiteStatus CalculateDecreasingSizePlan(std::vector<ArenaAlloc>* plan);
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -91,20 +157,23 @@ class ArenaPlanner : public MemoryPlanner {
   // Register a deallocation for the given tensor.
   TfLiteStatus CalculateTensorDeallocation(int tensor_index);
 
-  // Register an allocation for all internal (temporary) tensors of
-  // 'node_index'.
-  TfLiteStatus CalculateAllocationOfInternalTensors(int node_index);
-
-  // Register a deallocation for all internal (temporary) tensors of
-  // 'node_index'.
-  TfLiteStatus CalculateDeallocationOfInternalTensors(int node_index);
-
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
   // Stores allocation data for all tensors.
   std::vector<ArenaAlloc> allocs_;
 
+  // The allocations of the kTfLiteArenaRw tensors planned ahead of time.
+  std::vector<ArenaAlloc> offline_plan_;
+
+  ArenaPlanningStrategy strategy_ = ArenaPlanningStrategy::kInOrderBestFit;
+  // The plan computed with kDecreasingSizeBestFit, if any.
+  std::vector<ArenaAlloc> decreasing_size_plan_;
+  ArenaSizeReport arena_size_report_;
+
+  // The plan followed by the current ExecuteAllocations(), if any.
+  const std::vector<ArenaAlloc>* plan_ = nullptr;
+
   // A chronological list of instructions to allocate and deallocate tensors,
   // reflecting the way they are used in the graph.
   std::vector<AllocationInfo> alloc_queue_;
@@ -130,6 +199,18 @@ class ArenaPlanner : public MemoryPlanner {
   int tensor_alignment_;
 };
 
+// Serializes the arena plan of subgraph `subgraph_index` for the model
+// metadata named kArenaPlanMetadataName. The plan is stored as int32 words:
+// version, subgraph index, number of tensors, then the offset and size of
+// each tensor. Returns false if an offset or size does not fit in an int32.
+bool EncodeArenaPlan(int subgraph_index, const std::vector<ArenaAlloc>& plan,
+                     std::string* data);
+
+// Parses an arena plan serialized by EncodeArenaPlan(). Returns false if
+// `data` is not a valid plan.
+bool DecodeArenaPlan(const uint8_t* data, size_t size, int* subgraph_index,
+                     std::vector<ArenaAlloc>* plan);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_ARENA_PLANNER_H_
@@ -602,6 +602,183 @@ TEST_F(ArenaPlannerTest, ModifiedGraph_DeallocateNonPersistentArena) {
   EXPECT_EQ(GetOffset(3), GetOffsetAfter(1));
 }
 
+// Returns a plan which places the tensors of `graph` at `offsets`.
+std::vector<ArenaAlloc> MakePlan(TestGraph* graph,
+                                 const std::vector<size_t>& offsets) {
+  std::vector<ArenaAlloc> plan(offsets.size());
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    plan[i].offset = offsets[i];
+    plan[i].size = (*graph->tensors())[i].bytes;
+  }
+  return plan;
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlan) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  // Unlike the greedy plan, keep #3 apart from the others.
+  planner_->SetOfflinePlan(MakePlan(&graph, {0, 4, 12, 256, 24, 40}));
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), 4);
+  EXPECT_EQ(GetOffset(2), 12);
+  EXPECT_EQ(GetOffset(3), 256);
+  EXPECT_EQ(GetOffset(4), 24);
+  EXPECT_EQ(GetOffset(5), 40);
+
+  const std::vector<ArenaAlloc> plan = planner_->GetArenaPlan();
+  ASSERT_EQ(plan.size(), 6);
+  EXPECT_EQ(plan[3].offset, 256);
+  EXPECT_EQ(plan[3].size, 12);
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlanIgnoredAfterResize) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  planner_->SetOfflinePlan(MakePlan(&graph, {0, 4, 12, 256, 24, 40}));
+  (*graph.tensors())[1].bytes = 40;
+  Execute(0, 10);
+
+  // The greedy plan.
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(1));
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlanWithOverlap) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},  // First op
+                  },
+                  {2});
+  SetGraph(&graph);
+  // #1 would overlap #0, so it is placed by the arena instead.
+  planner_->SetOfflinePlan(MakePlan(&graph, {0, 0, 16}));
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(2), 16);
+  EXPECT_GE(GetOffset(1), GetOffsetAfter(0));
+  EXPECT_TRUE(GetOffset(1) >= GetOffsetAfter(2) ||
+              GetOffsetAfter(1) <= GetOffset(2));
+}
+
+TEST_F(ArenaPlannerTest, DecreasingSizeBestFit) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},  // First op
+                      {{1}, {2}, {}},  // Second op
+                  },
+                  {2});
+  (*graph.tensors())[0].bytes = 8;
+  (*graph.tensors())[1].bytes = 8;
+  (*graph.tensors())[2].bytes = 16;
+  SetGraph(&graph);
+  planner_->SetPlanningStrategy(ArenaPlanningStrategy::kDecreasingSizeBestFit);
+  Execute(0, 10);
+
+  // Alloc(+) and dealloc(-) order: +0 +1 -0 +2 -1
+  // In order, #2 does not fit where #0 was, and goes after #1.
+  EXPECT_EQ(planner_->arena_size_report().in_order_bytes, 32);
+  EXPECT_EQ(planner_->arena_size_report().decreasing_size_bytes, 24);
+  EXPECT_EQ(planner_->arena_size_report().arena_bytes, 24);
+  EXPECT_EQ(planner_->arena_size_report().persistent_arena_bytes, 0);
+  EXPECT_EQ(GetOffset(2), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(2));
+  EXPECT_EQ(GetOffset(0), 0);
+}
+
+TEST_F(ArenaPlannerTest, DecreasingSizeBestFitNotSmaller) {
+  TestGraph graph({0, 1}, {/* in, out, tmp */ {{0, 1}, {2}, {}}}, {2});
+  SetGraph(&graph);
+  planner_->SetPlanningStrategy(ArenaPlanningStrategy::kDecreasingSizeBestFit);
+  Execute(0, 10);
+
+  // All tensors are alive together, and placing #2 first leaves padding
+  // before #0. Falls back to the plan made in order.
+  EXPECT_EQ(planner_->arena_size_report().in_order_bytes, 21);
+  EXPECT_EQ(planner_->arena_size_report().decreasing_size_bytes, 23);
+  EXPECT_EQ(GetOffset(0), 0);
+  EXPECT_EQ(GetOffset(1), GetOffsetAfter(0));
+  EXPECT_EQ(GetOffset(2), GetOffsetAfter(1));
+}
+
+TEST_F(ArenaPlannerTest, DecreasingSizeBestFitWithTemporaries) {
+  TestGraph graph({0, -1, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},   // First op
+                      {{2, 0}, {4}, {5}},  // Second op, with temporary
+                      {{4, -1}, {3}, {}}   // Third op, with optional
+                  },
+                  {3});
+  (*graph.tensors())[1].bytes = 40;
+  (*graph.tensors())[5].bytes = 64;
+  SetGraph(&graph);
+  planner_->SetPlanningStrategy(ArenaPlanningStrategy::kDecreasingSizeBestFit);
+  Execute(0, 10);
+
+  // Tensors alive at the same time do not overlap.
+  const std::vector<std::vector<int>> alive_together = {
+      {0, 1, 2}, {0, 2, 4, 5}, {3, 4}};
+  for (const auto& tensors : alive_together) {
+    for (int a : tensors) {
+      for (int b : tensors) {
+        if (a == b) continue;
+        EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(b) ||
+                    GetOffsetAfter(b) <= GetOffset(a))
+            << a << " overlaps " << b;
+      }
+    }
+  }
+  EXPECT_LE(planner_->arena_size_report().decreasing_size_bytes,
+            planner_->arena_size_report().in_order_bytes);
+}
+
+TEST(ArenaPlanTest, EncodeDecode) {
+  std::vector<ArenaAlloc> plan(3);
+  plan[0].offset = 64;
+  plan[0].size = 12;
+  plan[2].offset = 128;
+  plan[2].size = 1000;
+  std::string data;
+  ASSERT_TRUE(EncodeArenaPlan(2, plan, &data));
+
+  int subgraph_index;
+  std::vector<ArenaAlloc> decoded;
+  ASSERT_TRUE(DecodeArenaPlan(reinterpret_cast<const uint8_t*>(data.data()),
+                              data.size(), &subgraph_index, &decoded));
+  EXPECT_EQ(subgraph_index, 2);
+  ASSERT_EQ(decoded.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(decoded[i].offset, plan[i].offset);
+    EXPECT_EQ(decoded[i].size, plan[i].size);
+  }
+
+  EXPECT_FALSE(DecodeArenaPlan(reinterpret_cast<const uint8_t*>(data.data()),
+                               data.size() - 4, &subgraph_index, &decoded));
+  data[0] = 7;  // Unknown version.
+  EXPECT_FALSE(DecodeArenaPlan(reinterpret_cast<const uint8_t*>(data.data()),
+                               data.size(), &subgraph_index, &decoded));
+}
+
 }  // namespace
 }  // namespace tflite
 
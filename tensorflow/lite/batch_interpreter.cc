@@ -0,0 +1,155 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batch_interpreter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace tflite {
+namespace {
+
+// Returns the bytes of one row of `tensor` in a bucket of `batch_size`, or 0
+// if the tensor is not batched along its first dimension.
+size_t RowBytes(const TfLiteTensor& tensor, int batch_size) {
+  if (tensor.dims == nullptr || tensor.dims->size < 1 ||
+      tensor.dims->data[0] != batch_size ||
+      tensor.allocation_type == kTfLiteDynamic ||
+      tensor.type == kTfLiteString || tensor.bytes % batch_size != 0) {
+    return 0;
+  }
+  return tensor.bytes / batch_size;
+}
+
+// Checks that the rows of `tensors` in a bucket of `batch_size` have the same
+// size as in the other buckets, recording the sizes for the first bucket.
+bool CheckRowBytes(const Interpreter& interpreter,
+                   const std::vector<int>& tensors, int batch_size,
+                   std::vector<size_t>* row_bytes) {
+  const bool first_bucket = row_bytes->empty();
+  for (int i = 0; i < tensors.size(); ++i) {
+    const size_t bytes = RowBytes(*interpreter.tensor(tensors[i]), batch_size);
+    if (bytes == 0) return false;
+    if (first_bucket) {
+      row_bytes->push_back(bytes);
+    } else if ((*row_bytes)[i] != bytes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::unique_ptr<BatchInterpreter> BatchInterpreter::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    std::vector<int> bucket_sizes, int num_threads) {
+  ErrorReporter* error_reporter = model.error_reporter();
+  std::sort(bucket_sizes.begin(), bucket_sizes.end());
+  bucket_sizes.erase(std::unique(bucket_sizes.begin(), bucket_sizes.end()),
+                     bucket_sizes.end());
+  if (bucket_sizes.empty() || bucket_sizes.front() < 1) {
+    error_reporter->Report("Batch sizes of buckets must be positive.");
+    return nullptr;
+  }
+
+  std::unique_ptr<BatchInterpreter> batch_interpreter(
+      new BatchInterpreter(error_reporter));
+  for (int batch_size : bucket_sizes) {
+    std::unique_ptr<Interpreter> interpreter;
+    if (InterpreterBuilder(model, op_resolver)(&interpreter, num_threads) !=
+        kTfLiteOk) {
+      return nullptr;
+    }
+    for (int input : interpreter->inputs()) {
+      const TfLiteIntArray* dims = interpreter->tensor(input)->dims;
+      if (dims == nullptr || dims->size < 1) {
+        error_reporter->Report("Input %d has no batch dimension.", input);
+        return nullptr;
+      }
+      std::vector<int> batch_dims(dims->data, dims->data + dims->size);
+      batch_dims[0] = batch_size;
+      if (interpreter->ResizeInputTensor(input, batch_dims) != kTfLiteOk) {
+        return nullptr;
+      }
+    }
+    if (interpreter->AllocateTensors() != kTfLiteOk) return nullptr;
+    if (!CheckRowBytes(*interpreter, interpreter->inputs(), batch_size,
+                       &batch_interpreter->input_row_bytes_) ||
+        !CheckRowBytes(*interpreter, interpreter->outputs(), batch_size,
+                       &batch_interpreter->output_row_bytes_)) {
+      error_reporter->Report(
+          "Model cannot be batched: every input and output needs a static "
+          "shape whose first dimension is the batch size %d.",
+          batch_size);
+      return nullptr;
+    }
+    batch_interpreter->buckets_.push_back({batch_size, std::move(interpreter)});
+  }
+  return batch_interpreter;
+}
+
+TfLiteStatus BatchInterpreter::Invoke(const std::vector<Request>& requests) {
+  for (const Request& request : requests) {
+    if (request.inputs.size() != input_row_bytes_.size() ||
+        request.outputs.size() != output_row_bytes_.size()) {
+      error_reporter_->Report(
+          "Request has %d inputs and %d outputs, the model has %d and %d.",
+          static_cast<int>(request.inputs.size()),
+          static_cast<int>(request.outputs.size()),
+          static_cast<int>(input_row_bytes_.size()),
+          static_cast<int>(output_row_bytes_.size()));
+      return kTfLiteError;
+    }
+  }
+  const int num_requests = requests.size();
+  for (int first = 0; first < num_requests; first += max_batch_size()) {
+    const int count = std::min(max_batch_size(), num_requests - first);
+    TF_LITE_ENSURE_STATUS(InvokeBucket(requests.data() + first, count));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus BatchInterpreter::InvokeBucket(const Request* first, int count) {
+  // The smallest bucket which holds `count` requests.
+  const Bucket& bucket = *std::find_if(
+      buckets_.begin(), buckets_.end(),
+      [count](const Bucket& bucket) { return bucket.batch_size >= count; });
+  Interpreter* interpreter = bucket.interpreter.get();
+
+  for (int i = 0; i < input_row_bytes_.size(); ++i) {
+    const size_t row_bytes = input_row_bytes_[i];
+    char* data = interpreter->tensor(interpreter->inputs()[i])->data.raw;
+    for (int r = 0; r < count; ++r) {
+      std::memcpy(data + r * row_bytes, first[r].inputs[i], row_bytes);
+    }
+    std::memset(data + count * row_bytes, 0,
+                (bucket.batch_size - count) * row_bytes);
+  }
+
+  TF_LITE_ENSURE_STATUS(interpreter->Invoke());
+
+  for (int i = 0; i < output_row_bytes_.size(); ++i) {
+    const size_t row_bytes = output_row_bytes_[i];
+    const char* data =
+        interpreter->tensor(interpreter->outputs()[i])->data.raw;
+    for (int r = 0; r < count; ++r) {
+      std::memcpy(first[r].outputs[i], data + r * row_bytes, row_bytes);
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
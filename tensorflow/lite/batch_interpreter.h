@@ -0,0 +1,100 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_BATCH_INTERPRETER_H_
+#define TENSORFLOW_LITE_BATCH_INTERPRETER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/c/c_api_internal.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+
+/// Runs many small independent requests through a model whose inputs and
+/// outputs have the batch as their first dimension.
+///
+/// One interpreter is built and allocated per batch size ("bucket") when the
+/// BatchInterpreter is created, so serving a batch never calls
+/// ResizeInputTensor or AllocateTensors. A batch of requests runs in the
+/// smallest bucket that holds it: the rows of the requests are copied into
+/// the inputs of the bucket, the unused rows are zeroed, and the output rows
+/// are copied back to the requests. Batches larger than the largest bucket
+/// are split.
+///
+/// Usage:
+///
+/// <pre><code>
+/// auto batch_interpreter =
+///     tflite::BatchInterpreter::Create(*model, resolver, {1, 4, 16});
+/// std::vector<tflite::BatchInterpreter::Request> requests(n);
+/// for (auto& request : requests) {
+///   request.inputs = {...};   // input_row_bytes(i) bytes per input
+///   request.outputs = {...};  // output_row_bytes(i) bytes per output
+/// }
+/// batch_interpreter->Invoke(requests);
+/// </code></pre>
+///
+/// A BatchInterpreter is not thread-safe, like an Interpreter.
+class BatchInterpreter {
+ public:
+  /// One row of each input and output of the model.
+  struct Request {
+    std::vector<const void*> inputs;
+    std::vector<void*> outputs;
+  };
+
+  /// Builds the interpreters of `bucket_sizes`. Returns nullptr and reports
+  /// to the error reporter of `model` if the model cannot be batched, e.g.
+  /// because an output does not follow the batch size of the inputs or has
+  /// a dynamic shape.
+  static std::unique_ptr<BatchInterpreter> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      std::vector<int> bucket_sizes, int num_threads = -1);
+
+  /// Runs `requests`, in as few invocations as the buckets allow.
+  TfLiteStatus Invoke(const std::vector<Request>& requests);
+
+  /// The number of bytes of one row of the input or output `i`.
+  size_t input_row_bytes(int i) const { return input_row_bytes_[i]; }
+  size_t output_row_bytes(int i) const { return output_row_bytes_[i]; }
+
+  int max_batch_size() const { return buckets_.back().batch_size; }
+
+ private:
+  struct Bucket {
+    int batch_size;
+    std::unique_ptr<Interpreter> interpreter;
+  };
+
+  explicit BatchInterpreter(ErrorReporter* error_reporter)
+      : error_reporter_(error_reporter) {}
+
+  // Runs up to max_batch_size() requests starting at `first`.
+  TfLiteStatus InvokeBucket(const Request* first, int count);
+
+  ErrorReporter* error_reporter_;
+  // Sorted by increasing batch size.
+  std::vector<Bucket> buckets_;
+  std::vector<size_t> input_row_bytes_;
+  std::vector<size_t> output_row_bytes_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_BATCH_INTERPRETER_H_
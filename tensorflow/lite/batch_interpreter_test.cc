@@ -0,0 +1,100 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batch_interpreter.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+// The model computes 3 * input, for an input of shape [1, 8, 8, 3].
+constexpr char kAddModel[] = "tensorflow/lite/testdata/add.bin";
+constexpr int kRowSize = 8 * 8 * 3;
+
+class BatchInterpreterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(kAddModel);
+    ASSERT_NE(model_, nullptr);
+  }
+
+  // Runs `num_requests` requests whose input rows are filled with their
+  // index, and checks their outputs.
+  void RunRequests(BatchInterpreter* batch_interpreter, int num_requests) {
+    std::vector<std::vector<float>> inputs(num_requests);
+    std::vector<std::vector<float>> outputs(num_requests);
+    std::vector<BatchInterpreter::Request> requests(num_requests);
+    for (int r = 0; r < num_requests; ++r) {
+      inputs[r].assign(kRowSize, r);
+      outputs[r].assign(kRowSize, -1);
+      requests[r].inputs = {inputs[r].data()};
+      requests[r].outputs = {outputs[r].data()};
+    }
+    ASSERT_EQ(batch_interpreter->Invoke(requests), kTfLiteOk);
+    for (int r = 0; r < num_requests; ++r) {
+      for (float value : outputs[r]) {
+        ASSERT_EQ(value, 3 * r);
+      }
+    }
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+};
+
+TEST_F(BatchInterpreterTest, RunsRequestsInBuckets) {
+  std::unique_ptr<BatchInterpreter> batch_interpreter =
+      BatchInterpreter::Create(*model_, resolver_, {4, 1, 2});
+  ASSERT_NE(batch_interpreter, nullptr);
+  EXPECT_EQ(batch_interpreter->max_batch_size(), 4);
+  EXPECT_EQ(batch_interpreter->input_row_bytes(0), kRowSize * sizeof(float));
+  EXPECT_EQ(batch_interpreter->output_row_bytes(0), kRowSize * sizeof(float));
+
+  RunRequests(batch_interpreter.get(), 1);
+  // Padded to a bucket of 4.
+  RunRequests(batch_interpreter.get(), 3);
+  // Split into buckets of 4 and 2.
+  RunRequests(batch_interpreter.get(), 6);
+  RunRequests(batch_interpreter.get(), 0);
+}
+
+TEST_F(BatchInterpreterTest, RejectsMismatchedRequests) {
+  std::unique_ptr<BatchInterpreter> batch_interpreter =
+      BatchInterpreter::Create(*model_, resolver_, {2});
+  ASSERT_NE(batch_interpreter, nullptr);
+  std::vector<float> input(kRowSize);
+  BatchInterpreter::Request request;
+  request.inputs = {input.data()};
+  EXPECT_EQ(batch_interpreter->Invoke({request}), kTfLiteError);
+}
+
+TEST_F(BatchInterpreterTest, RejectsInvalidBuckets) {
+  EXPECT_EQ(BatchInterpreter::Create(*model_, resolver_, {}), nullptr);
+  EXPECT_EQ(BatchInterpreter::Create(*model_, resolver_, {0, 2}), nullptr);
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
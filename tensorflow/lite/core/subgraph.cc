@@ -18,11 +18,14 @@ limitations under the License.
 #include <algorithm>
 
 #include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/context_util.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
 #include "tensorflow/lite/minimal_logging.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/util.h"
@@ -496,6 +499,19 @@ TfLiteStatus Subgraph::AllocateTensors() {
     return kTfLiteOk;
   }
 
+  // The values of the variable tensors which were allocated before, to
+  // restore once the tensors are allocated again, possibly elsewhere.
+  std::vector<std::pair<int, std::vector<char>>> variable_values;
+  if (preserve_variable_tensors_) {
+    for (int i = 0; i < tensors_.size(); ++i) {
+      const TfLiteTensor& tensor = tensors_[i];
+      if (!tensor.is_variable || tensor.data.raw == nullptr) continue;
+      variable_values.emplace_back(
+          i, std::vector<char>(tensor.data.raw,
+                               tensor.data.raw + tensor.bytes));
+    }
+  }
+
   next_execution_plan_index_to_prepare_ = 0;
   next_execution_plan_index_to_plan_allocation_ = 0;
   if (memory_planner_) {
@@ -512,6 +528,14 @@ TfLiteStatus Subgraph::AllocateTensors() {
   // instead.
   ResetVariableTensors();
 
+  // A variable tensor resized by a kernel starts over.
+  for (const auto& variable_value : variable_values) {
+    TfLiteTensor& tensor = tensors_[variable_value.first];
+    if (tensor.bytes == variable_value.second.size()) {
+      memcpy(tensor.data.raw, variable_value.second.data(), tensor.bytes);
+    }
+  }
+
   return kTfLiteOk;
 }
 
@@ -683,10 +707,13 @@ TfLiteStatus Subgraph::PrepareOpsStartingAt(
 }
 
 TfLiteStatus Subgraph::PrepareOpsAndTensors() {
+  parallel_waves_valid_ = false;
   if (!memory_planner_) {
     memory_planner_.reset(new ArenaPlanner(
         &context_, std::unique_ptr<GraphInfo>(new InterpreterInfo(this)),
         /*preserve_inputs=*/true, /*preserve_intermediates*/ false));
+    memory_planner_->SetOfflinePlan(offline_arena_plan_);
+    memory_planner_->SetPlanningStrategy(arena_planning_strategy_);
     memory_planner_->PlanAllocations();
   }
 
@@ -705,6 +732,234 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+namespace {
+
+// The builtin ops which can run at the same time as other nodes: they don't
+// use the CPU backend context, and only touch the memory of their tensors.
+bool IsInterOpParallelBuiltin(int32_t builtin_code) {
+  switch (builtin_code) {
+    case kTfLiteBuiltinAbs:
+    case kTfLiteBuiltinAdd:
+    case kTfLiteBuiltinAddN:
+    case kTfLiteBuiltinArgMax:
+    case kTfLiteBuiltinArgMin:
+    case kTfLiteBuiltinAveragePool2d:
+    case kTfLiteBuiltinCast:
+    case kTfLiteBuiltinConcatenation:
+    case kTfLiteBuiltinDequantize:
+    case kTfLiteBuiltinDiv:
+    case kTfLiteBuiltinExp:
+    case kTfLiteBuiltinExpandDims:
+    case kTfLiteBuiltinGather:
+    case kTfLiteBuiltinL2Pool2d:
+    case kTfLiteBuiltinLogistic:
+    case kTfLiteBuiltinMaxPool2d:
+    case kTfLiteBuiltinMaximum:
+    case kTfLiteBuiltinMinimum:
+    case kTfLiteBuiltinMul:
+    case kTfLiteBuiltinNeg:
+    case kTfLiteBuiltinPack:
+    case kTfLiteBuiltinPad:
+    case kTfLiteBuiltinPadv2:
+    case kTfLiteBuiltinQuantize:
+    case kTfLiteBuiltinRelu:
+    case kTfLiteBuiltinRelu6:
+    case kTfLiteBuiltinReluN1To1:
+    case kTfLiteBuiltinReshape:
+    case kTfLiteBuiltinResizeBilinear:
+    case kTfLiteBuiltinResizeNearestNeighbor:
+    case kTfLiteBuiltinRsqrt:
+    case kTfLiteBuiltinSlice:
+    case kTfLiteBuiltinSplit:
+    case kTfLiteBuiltinSplitV:
+    case kTfLiteBuiltinSqrt:
+    case kTfLiteBuiltinSquaredDifference:
+    case kTfLiteBuiltinSqueeze:
+    case kTfLiteBuiltinStridedSlice:
+    case kTfLiteBuiltinSub:
+    case kTfLiteBuiltinTanh:
+    case kTfLiteBuiltinTile:
+    case kTfLiteBuiltinTranspose:
+    case kTfLiteBuiltinUnpack:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The memory used by a node, as ranges of bytes.
+struct NodeMemory {
+  typedef std::pair<const char*, const char*> Range;
+  std::vector<Range> reads;
+  std::vector<Range> writes;
+
+  static bool Overlap(const std::vector<Range>& a,
+                      const std::vector<Range>& b) {
+    for (const Range& x : a) {
+      for (const Range& y : b) {
+        if (x.first < y.second && y.first < x.second) return true;
+      }
+    }
+    return false;
+  }
+
+  bool ConflictsWith(const NodeMemory& other) const {
+    return Overlap(writes, other.reads) || Overlap(writes, other.writes) ||
+           Overlap(reads, other.writes);
+  }
+};
+
+void AddRanges(const TfLiteIntArray* tensor_indices,
+               const std::vector<TfLiteTensor>& tensors,
+               std::vector<NodeMemory::Range>* ranges) {
+  if (tensor_indices == nullptr) return;
+  for (int i = 0; i < tensor_indices->size; ++i) {
+    const int tensor_index = tensor_indices->data[i];
+    if (tensor_index == kOptionalTensor) continue;
+    const TfLiteTensor& tensor = tensors[tensor_index];
+    if (tensor.data.raw == nullptr || tensor.bytes == 0) continue;
+    ranges->emplace_back(tensor.data.raw, tensor.data.raw + tensor.bytes);
+  }
+}
+
+// Invokes one node of a wave on a thread of the CPU backend context.
+class NodeTask : public cpu_backend_threadpool::Task {
+ public:
+  NodeTask(TfLiteContext* context, TfLiteNode* node,
+           const TfLiteRegistration* registration)
+      : context_(context), node_(node), registration_(registration) {}
+
+  void Run() override {
+    status_ = registration_->invoke == nullptr
+                  ? kTfLiteError
+                  : registration_->invoke(context_, node_);
+  }
+
+  TfLiteStatus status() const { return status_; }
+
+ private:
+  TfLiteContext* context_;
+  TfLiteNode* node_;
+  const TfLiteRegistration* registration_;
+  TfLiteStatus status_ = kTfLiteOk;
+};
+
+}  // namespace
+
+TfLiteStatus Subgraph::EnsureNodeInputsAreReadable(const TfLiteNode& node) {
+  // TODO(ycling): This is an extra loop through inputs to check if the data
+  // need to be copied from Delegate buffer to raw memory, which is often not
+  // needed. We may want to cache this in prepare to know if this needs to be
+  // done for a node or not.
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+  }
+  return kTfLiteOk;
+}
+
+void Subgraph::PlanParallelExecution() {
+  parallel_waves_.clear();
+  std::vector<NodeMemory> memory(execution_plan_.size());
+  std::vector<int> wave_of(execution_plan_.size());
+  // Nodes never join a wave before the last node which runs alone.
+  int first_open_wave = 0;
+  for (int i = 0; i < static_cast<int>(execution_plan_.size()); ++i) {
+    const auto& node_and_reg = nodes_and_registration_[execution_plan_[i]];
+    const TfLiteNode& node = node_and_reg.first;
+    AddRanges(node.inputs, tensors_, &memory[i].reads);
+    AddRanges(node.outputs, tensors_, &memory[i].writes);
+    AddRanges(node.intermediates, tensors_, &memory[i].writes);
+    AddRanges(node.temporaries, tensors_, &memory[i].writes);
+
+    // Registrations resolved by an op resolver have a version, unlike the
+    // zero-initialized registrations given directly to AddNodeWithParameters.
+    const TfLiteRegistration& registration = node_and_reg.second;
+    const bool runs_alone =
+        node.delegate != nullptr || registration.version < 1 ||
+        !IsInterOpParallelBuiltin(registration.builtin_code);
+    int wave = first_open_wave;
+    if (runs_alone) {
+      wave = parallel_waves_.size();
+      first_open_wave = wave + 1;
+    } else {
+      for (int j = 0; j < i; ++j) {
+        if (wave_of[j] >= wave && memory[i].ConflictsWith(memory[j])) {
+          wave = wave_of[j] + 1;
+        }
+      }
+    }
+    if (wave == static_cast<int>(parallel_waves_.size())) {
+      parallel_waves_.emplace_back();
+    }
+    parallel_waves_[wave].push_back(i);
+    wave_of[i] = wave;
+  }
+  parallel_waves_valid_ = true;
+}
+
+TfLiteStatus Subgraph::InvokeInParallel() {
+  if (!parallel_waves_valid_) {
+    PlanParallelExecution();
+  }
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(&context_);
+  const int max_tasks = std::max(1, cpu_backend_context->max_num_threads());
+
+  std::vector<NodeTask> tasks;
+  tasks.reserve(max_tasks);
+  for (const std::vector<int>& wave : parallel_waves_) {
+    for (int execution_plan_index : wave) {
+      const TfLiteNode& node =
+          nodes_and_registration_[execution_plan_[execution_plan_index]].first;
+      TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node));
+    }
+
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    // Each batch of at most max_tasks nodes runs on the calling thread and
+    // the workers of the CPU backend context.
+    for (size_t begin = 0; begin < wave.size(); begin += max_tasks) {
+      const size_t end = std::min(wave.size(), begin + max_tasks);
+      tasks.clear();
+      for (size_t i = begin; i < end; ++i) {
+        const int node_index = execution_plan_[wave[i]];
+        auto& node_and_reg = nodes_and_registration_[node_index];
+        tasks.emplace_back(&context_, &node_and_reg.first,
+                           &node_and_reg.second);
+      }
+      if (tasks.size() == 1) {
+        tasks[0].Run();
+      } else {
+        cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                        cpu_backend_context);
+      }
+      for (size_t i = begin; i < end; ++i) {
+        if (tasks[i - begin].status() == kTfLiteError) {
+          const int node_index = execution_plan_[wave[i]];
+          const auto& node_and_reg = nodes_and_registration_[node_index];
+          return ReportOpError(&context_, node_and_reg.first,
+                               node_and_reg.second, node_index,
+                               "failed to invoke");
+        }
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::Invoke() {
   if (!consistent_) {
     ReportError("Invoke called on model that is not consistent.");
@@ -724,6 +979,12 @@ TfLiteStatus Subgraph::Invoke() {
     applied_nnapi_delegate_ = true;
   }
 
+  if (inter_op_parallelism_ && !has_dynamic_tensors_ && !profiler_ &&
+      next_execution_plan_index_to_prepare_ >=
+          static_cast<int>(execution_plan_.size())) {
+    return InvokeInParallel();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -741,21 +1002,7 @@ TfLiteStatus Subgraph::Invoke() {
         nodes_and_registration_[node_index].second;
     TFLITE_SCOPED_OPERATOR_PROFILE(profiler_.get(), node_index);
 
-    // TODO(ycling): This is an extra loop through inputs to check if the data
-    // need to be copied from Delegate buffer to raw memory, which is often not
-    // needed. We may want to cache this in prepare to know if this needs to be
-    // done for a node or not.
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node));
 
     if (check_cancelled_func_ != nullptr &&
         check_cancelled_func_(cancellation_data_)) {
@@ -1102,6 +1349,35 @@ TfLiteStatus Subgraph::RedoAllDelegates() {
   return kTfLiteOk;
 }
 
+void Subgraph::SetOfflineArenaPlan(std::vector<ArenaAlloc> plan) {
+  offline_arena_plan_ = std::move(plan);
+  if (memory_planner_) {
+    memory_planner_->SetOfflinePlan(offline_arena_plan_);
+  }
+}
+
+TfLiteStatus Subgraph::GetArenaPlan(std::vector<ArenaAlloc>* plan) {
+  if (state_ == kStateUninvokable || !memory_planner_ || has_dynamic_tensors_) {
+    ReportError(
+        "GetArenaPlan requires AllocateTensors to allocate all tensors.");
+    return kTfLiteError;
+  }
+  *plan = memory_planner_->GetArenaPlan();
+  return kTfLiteOk;
+}
+
+void Subgraph::SetArenaPlanningStrategy(ArenaPlanningStrategy strategy) {
+  arena_planning_strategy_ = strategy;
+  if (memory_planner_) {
+    memory_planner_->SetPlanningStrategy(strategy);
+  }
+}
+
+ArenaSizeReport Subgraph::GetArenaSizeReport() const {
+  return memory_planner_ ? memory_planner_->arena_size_report()
+                         : ArenaSizeReport();
+}
+
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
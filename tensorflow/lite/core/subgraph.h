@@ -21,11 +21,11 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/experimental/resource_variable/resource_variable.h"
-#include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/util.h"
 
 namespace tflite {
@@ -217,6 +217,27 @@ class Subgraph {
   // Returns status of success or failure.
   TfLiteStatus AllocateTensors();
 
+  // Sets the arena plan computed ahead of time for this subgraph, typically
+  // read from the model. See ArenaPlanner::SetOfflinePlan().
+  // WARNING: This is an experimental API and subject to change.
+  void SetOfflineArenaPlan(std::vector<ArenaAlloc> plan);
+
+  // Returns the arena plan of the tensors allocated by AllocateTensors(), to
+  // be stored in the model with EncodeArenaPlan().
+  // WARNING: This is an experimental API and subject to change.
+  TfLiteStatus GetArenaPlan(std::vector<ArenaAlloc>* plan);
+
+  // Sets how the arena of the tensors is planned. Takes effect at the next
+  // AllocateTensors().
+  // WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanningStrategy(ArenaPlanningStrategy strategy);
+
+  // Returns the high-water marks of the arenas, and the arena sizes planned
+  // with each strategy by the last AllocateTensors() with
+  // kDecreasingSizeBestFit.
+  // WARNING: This is an experimental API and subject to change.
+  ArenaSizeReport GetArenaSizeReport() const;
+
   // Invoke the subgraph (run the whole graph in dependency order).
   //
   // NOTE: It is possible that the interpreter is not in a ready state
@@ -251,6 +272,21 @@ class Subgraph {
   // WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  // Lets Invoke() run nodes which don't depend on each other at the same
+  // time, on the threads of the CPU backend context. Only applies to graphs
+  // without dynamic tensors and without a profiler. Nodes which may use the
+  // CPU backend context themselves, delegate nodes and custom ops still run
+  // alone.
+  // WARNING: This is an experimental API and subject to change.
+  void SetInterOpParallelism(bool enable) { inter_op_parallelism_ = enable; }
+
+  // Lets AllocateTensors() keep the values of the variable tensors whose
+  // shape did not change, instead of resetting all of them.
+  // WARNING: This is an experimental API and subject to change.
+  void SetPreserveVariableTensors(bool preserve) {
+    preserve_variable_tensors_ = preserve;
+  }
+
   // Ensure the data in `tensor.data` is readable. In case delegate is used,
   // it might require to copy the data from delegate buffer to raw memory.
   // WARNING: This is an experimental API and subject to change.
@@ -380,6 +416,19 @@ class Subgraph {
   // to wait until Invoke() to resolve the sizes of dynamic tensors.
   TfLiteStatus PrepareOpsAndTensors();
 
+  // Makes the data of the inputs of `node` readable, see
+  // EnsureTensorDataIsReadable().
+  TfLiteStatus EnsureNodeInputsAreReadable(const TfLiteNode& node);
+
+  // Groups the nodes of the execution plan into parallel_waves_, which run one
+  // after the other. The nodes of a wave don't write memory used by other
+  // nodes of the wave, so they can run at the same time. This covers both
+  // the data flow and the reuse of memory in the arena.
+  void PlanParallelExecution();
+
+  // Invokes the nodes wave by wave. Requires all nodes to be prepared.
+  TfLiteStatus InvokeInParallel();
+
   // Call OpPrepare() for all ops starting at 'first_node'. Stop when a
   // dynamic tensors is found or all ops have been prepared. Fill
   // 'last_node_prepared' with the id of the op containing dynamic tensors, or
@@ -602,7 +651,23 @@ class Subgraph {
   bool should_apply_nnapi_delegate_ = false;
   bool applied_nnapi_delegate_ = false;
 
-  std::unique_ptr<MemoryPlanner> memory_planner_;
+  // Whether Invoke() may run independent nodes at the same time.
+  bool inter_op_parallelism_ = false;
+  // Indices into execution_plan_ of the nodes run by each wave, valid until
+  // the tensors are allocated again.
+  std::vector<std::vector<int>> parallel_waves_;
+  bool parallel_waves_valid_ = false;
+
+  std::unique_ptr<ArenaPlanner> memory_planner_;
+
+  // The arena plan computed ahead of time, passed to memory_planner_.
+  std::vector<ArenaAlloc> offline_arena_plan_;
+
+  ArenaPlanningStrategy arena_planning_strategy_ =
+      ArenaPlanningStrategy::kInOrderBestFit;
+
+  // Whether AllocateTensors() keeps the values of the variable tensors.
+  bool preserve_variable_tensors_ = false;
 
   // Tracking bit for whether a tensor was resized in the course of an op
   // invocation. This is a useful hint to ensure that dynamic tensor outputs
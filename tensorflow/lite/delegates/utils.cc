@@ -16,11 +16,31 @@ limitations under the License.
 #include "tensorflow/lite/delegates/utils.h"
 
 #include <algorithm>
+#include <set>
+#include <utility>
 
 #include "tensorflow/lite/c/c_api_internal.h"
 
 namespace tflite {
 namespace delegates {
+namespace {
+
+// Splits the sorted `indices` into their continuous subsets.
+std::vector<std::vector<int>> ContinuousSubsets(
+    const std::vector<int>& indices) {
+  std::vector<std::vector<int>> continuous_subsets;
+  int last_index = indices.at(0) - 2;
+  for (const auto idx : indices) {
+    if (idx > last_index + 1) {
+      continuous_subsets.emplace_back();
+    }
+    continuous_subsets.back().push_back(idx);
+    last_index = idx;
+  }
+  return continuous_subsets;
+}
+
+}  // namespace
 
 TfLiteStatus PruneContinuousSubsets(TfLiteContext* context,
                                     const int max_subsets,
@@ -35,15 +55,8 @@ TfLiteStatus PruneContinuousSubsets(TfLiteContext* context,
   std::sort(indices->begin(), indices->end());
 
   // Build a vector of subsets.
-  std::vector<std::vector<int>> continuous_subsets;
-  int last_index = indices->at(0) - 2;
-  for (const auto idx : *indices) {
-    if (idx > last_index + 1) {
-      continuous_subsets.emplace_back();
-    }
-    continuous_subsets.back().push_back(idx);
-    last_index = idx;
-  }
+  std::vector<std::vector<int>> continuous_subsets =
+      ContinuousSubsets(*indices);
 
   // Nothing to be done if number of subsets is already less than max_subsets.
   if (continuous_subsets.size() <= max_subsets) return kTfLiteOk;
@@ -66,5 +79,89 @@ TfLiteStatus PruneContinuousSubsets(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus PruneSubsetsByCost(TfLiteContext* context,
+                                const SubsetCostModel& cost_model,
+                                std::vector<int>* indices) {
+  if (!indices) {
+    context->ReportError(context, "indices cannot be nullptr");
+    return kTfLiteError;
+  }
+  if (indices->empty()) return kTfLiteOk;
+
+  // Sort indices just in case.
+  std::sort(indices->begin(), indices->end());
+
+  // Find the nodes reading each tensor.
+  TfLiteIntArray* execution_plan;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &execution_plan));
+  std::vector<std::vector<int>> readers(context->tensors_size);
+  for (int i = 0; i < execution_plan->size; ++i) {
+    const int node_index = execution_plan->data[i];
+    TfLiteNode* node;
+    TfLiteRegistration* registration;
+    TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+        context, node_index, &node, &registration));
+    for (int j = 0; j < node->inputs->size; ++j) {
+      const int tensor_index = node->inputs->data[j];
+      if (tensor_index != kOptionalTensor) {
+        readers[tensor_index].push_back(node_index);
+      }
+    }
+  }
+
+  std::vector<int> selected;
+  for (const std::vector<int>& subset : ContinuousSubsets(*indices)) {
+    if (static_cast<int>(subset.size()) < cost_model.min_subset_size) continue;
+
+    float gain = 0;
+    size_t transfer_bytes = 0;
+    std::set<int> transferred_inputs;
+    std::set<int> outputs;
+    for (const int node_index : subset) {
+      TfLiteNode* node;
+      TfLiteRegistration* registration;
+      TF_LITE_ENSURE_STATUS(context->GetNodeAndRegistration(
+          context, node_index, &node, &registration));
+      gain += cost_model.node_gain ? cost_model.node_gain(*node, *registration)
+                                   : 1;
+      for (int j = 0; j < node->inputs->size; ++j) {
+        const int tensor_index = node->inputs->data[j];
+        if (tensor_index == kOptionalTensor || outputs.count(tensor_index)) {
+          continue;
+        }
+        const TfLiteTensor& tensor = context->tensors[tensor_index];
+        if (tensor.allocation_type != kTfLiteMmapRo &&
+            transferred_inputs.insert(tensor_index).second) {
+          transfer_bytes += tensor.bytes;
+        }
+      }
+      for (int j = 0; j < node->outputs->size; ++j) {
+        outputs.insert(node->outputs->data[j]);
+      }
+    }
+    for (const int tensor_index : outputs) {
+      const std::vector<int>& tensor_readers = readers[tensor_index];
+      const bool read_outside =
+          std::any_of(tensor_readers.begin(), tensor_readers.end(),
+                      [&subset](int reader) {
+                        return reader < subset.front() ||
+                               reader > subset.back();
+                      });
+      if (tensor_readers.empty() || read_outside) {
+        transfer_bytes += context->tensors[tensor_index].bytes;
+      }
+    }
+
+    if (gain - cost_model.transfer_cost_per_byte * transfer_bytes <
+        cost_model.min_subset_gain) {
+      continue;
+    }
+    selected.insert(selected.end(), subset.begin(), subset.end());
+  }
+  *indices = std::move(selected);
+
+  return kTfLiteOk;
+}
+
 }  // namespace delegates
 }  // namespace tflite
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_DELEGATES_UTILS_H_
 #define TENSORFLOW_LITE_DELEGATES_UTILS_H_
 
+#include <functional>
 #include <vector>
 
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -33,6 +34,37 @@ TfLiteStatus PruneContinuousSubsets(TfLiteContext* context,
                                     const int max_subsets,
                                     std::vector<int>* indices);
 
+// Estimates with which PruneSubsetsByCost() decides whether delegating a
+// continuous subset of nodes pays off.
+struct SubsetCostModel {
+  // Returns the time saved by running the node in the delegate instead of on
+  // the CPU, in arbitrary units. If not set, every node saves one unit.
+  std::function<float(const TfLiteNode& node,
+                      const TfLiteRegistration& registration)>
+      node_gain;
+  // The time taken to move one byte of a tensor between the CPU and the
+  // delegate, in the units of `node_gain`.
+  float transfer_cost_per_byte = 0;
+  // Subsets of fewer nodes are rejected.
+  int min_subset_size = 1;
+  // Subsets whose gain, less the cost of transferring their inputs and
+  // outputs, is below this are rejected.
+  float min_subset_gain = 0;
+};
+
+// Given a list(vector<int>) of the indices of the nodes a delegate supports,
+// removes in-place the continuous subsets which are not worth delegating
+// according to `cost_model`. The inputs of a subset which are not constant,
+// and its outputs which are read outside of it or by no node at all, are
+// transferred between the CPU and the delegate.
+// Resulting vector contains sorted list of pruned indices.
+//
+// This util can be used by delegates to avoid creating many small partitions
+// whose transfers cost more than running them on the CPU.
+TfLiteStatus PruneSubsetsByCost(TfLiteContext* context,
+                                const SubsetCostModel& cost_model,
+                                std::vector<int>* indices);
+
 }  // namespace delegates
 }  // namespace tflite
 
@@ -101,6 +101,137 @@ TEST(UtilsTest, PruneContinuousSubsets_UnsortedIndices) {
   ASSERT_TRUE(indices.empty());
 }
 
+// A chain of `num_nodes` nodes, where node i reads tensor i and writes tensor
+// i + 1, and also reads constant tensor `num_nodes + 1`. Every tensor holds
+// `tensor_bytes` bytes.
+class ChainGraph {
+ public:
+  ChainGraph(int num_nodes, size_t tensor_bytes)
+      : nodes_(num_nodes), tensors_(num_nodes + 2) {
+    for (TfLiteTensor& tensor : tensors_) {
+      tensor.allocation_type = kTfLiteArenaRw;
+      tensor.bytes = tensor_bytes;
+    }
+    tensors_.back().allocation_type = kTfLiteMmapRo;
+    for (int i = 0; i < num_nodes; ++i) {
+      nodes_[i].inputs = TfLiteIntArrayCreate(2);
+      nodes_[i].inputs->data[0] = i;
+      nodes_[i].inputs->data[1] = num_nodes + 1;
+      nodes_[i].outputs = TfLiteIntArrayCreate(1);
+      nodes_[i].outputs->data[0] = i + 1;
+    }
+    execution_plan_ = TfLiteIntArrayCreate(num_nodes);
+    for (int i = 0; i < num_nodes; ++i) execution_plan_->data[i] = i;
+
+    context_.impl_ = this;
+    context_.tensors = tensors_.data();
+    context_.tensors_size = tensors_.size();
+    context_.ReportError = ReportError;
+    context_.GetExecutionPlan = GetExecutionPlan;
+    context_.GetNodeAndRegistration = GetNodeAndRegistration;
+  }
+
+  ~ChainGraph() {
+    for (TfLiteNode& node : nodes_) {
+      TfLiteIntArrayFree(node.inputs);
+      TfLiteIntArrayFree(node.outputs);
+    }
+    TfLiteIntArrayFree(execution_plan_);
+  }
+
+  TfLiteContext* context() { return &context_; }
+
+ private:
+  static TfLiteStatus GetExecutionPlan(TfLiteContext* context,
+                                       TfLiteIntArray** execution_plan) {
+    *execution_plan = static_cast<ChainGraph*>(context->impl_)->execution_plan_;
+    return kTfLiteOk;
+  }
+
+  static TfLiteStatus GetNodeAndRegistration(
+      TfLiteContext* context, int node_index, TfLiteNode** node,
+      TfLiteRegistration** registration) {
+    auto* graph = static_cast<ChainGraph*>(context->impl_);
+    *node = &graph->nodes_[node_index];
+    *registration = &graph->registration_;
+    return kTfLiteOk;
+  }
+
+  TfLiteContext context_ = {};
+  std::vector<TfLiteNode> nodes_;
+  std::vector<TfLiteTensor> tensors_;
+  TfLiteRegistration registration_ = {};
+  TfLiteIntArray* execution_plan_;
+};
+
+TEST(UtilsTest, PruneSubsetsByCost_NoSubsets) {
+  ChainGraph graph(4, 16);
+  SubsetCostModel cost_model;
+  std::vector<int> indices;
+
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, nullptr),
+            kTfLiteError);
+
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  ASSERT_TRUE(indices.empty());
+}
+
+TEST(UtilsTest, PruneSubsetsByCost_MinSubsetSize) {
+  ChainGraph graph(8, 16);
+  SubsetCostModel cost_model;
+  // 3 subsets: (0, 1, 2), (4), (6, 7).
+  std::vector<int> original_indices = {7, 0, 1, 2, 4, 6};
+
+  std::vector<int> indices = original_indices;
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  EXPECT_THAT(indices, ElementsAreArray({0, 1, 2, 4, 6, 7}));
+
+  cost_model.min_subset_size = 2;
+  indices = original_indices;
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  EXPECT_THAT(indices, ElementsAreArray({0, 1, 2, 6, 7}));
+}
+
+TEST(UtilsTest, PruneSubsetsByCost_TransferCost) {
+  ChainGraph graph(8, 16);
+  SubsetCostModel cost_model;
+  // Each subset transfers one input and one output of 16 bytes; the constant
+  // tensor is not transferred.
+  cost_model.transfer_cost_per_byte = 1.0f / 16;
+  // 3 subsets: (0, 1, 2), (4), (6, 7).
+  std::vector<int> original_indices = {0, 1, 2, 4, 6, 7};
+
+  std::vector<int> indices = original_indices;
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  EXPECT_THAT(indices, ElementsAreArray({0, 1, 2, 6, 7}));
+
+  cost_model.min_subset_gain = 0.5f;
+  indices = original_indices;
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  EXPECT_THAT(indices, ElementsAreArray({0, 1, 2}));
+}
+
+TEST(UtilsTest, PruneSubsetsByCost_NodeGain) {
+  ChainGraph graph(8, 16);
+  SubsetCostModel cost_model;
+  cost_model.transfer_cost_per_byte = 1.0f / 16;
+  // Only node 4 is worth running in the delegate.
+  cost_model.node_gain = [](const TfLiteNode& node,
+                            const TfLiteRegistration& registration) {
+    return node.outputs->data[0] == 5 ? 10.0f : 0.0f;
+  };
+  std::vector<int> indices = {0, 1, 2, 4, 6, 7};
+
+  ASSERT_EQ(PruneSubsetsByCost(graph.context(), cost_model, &indices),
+            kTfLiteOk);
+  EXPECT_THAT(indices, ElementsAreArray({4}));
+}
+
 }  // namespace
 }  // namespace delegates
 }  // namespace tflite
@@ -257,6 +257,24 @@ void Interpreter::SetAllowFp16PrecisionForFp32(bool allow) {
   }
 }
 
+void Interpreter::SetInterOpParallelism(bool enable) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetInterOpParallelism(enable);
+  }
+}
+
+void Interpreter::SetPreserveVariableTensors(bool preserve) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetPreserveVariableTensors(preserve);
+  }
+}
+
+void Interpreter::SetArenaPlanningStrategy(ArenaPlanningStrategy strategy) {
+  for (auto& subgraph : subgraphs_) {
+    subgraph->SetArenaPlanningStrategy(strategy);
+  }
+}
+
 // TODO(b/121264966): Subgraphs added after cancellation is set will not get the
 // cancellation function added to their context.
 void Interpreter::SetCancellationFunction(void* data,
@@ -24,6 +24,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/c_api_internal.h"  // IWYU pragma: export
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/profiler.h"
@@ -367,6 +368,39 @@ class Interpreter {
     return context_->allow_fp32_relax_to_fp16;
   }
 
+  /// Lets Invoke() run nodes which don't depend on each other at the same
+  /// time, on the threads set with SetNumThreads(). Helps graphs with
+  /// independent branches of small ops. Only applies to graphs without
+  /// dynamic tensors and without a profiler; nodes which may be
+  /// multi-threaded themselves, delegate nodes and custom ops still run alone.
+  /// default: disabled.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetInterOpParallelism(bool enable);
+
+  /// Lets AllocateTensors() keep the values of variable tensors, instead of
+  /// resetting them, as long as their size does not change. E.g. a streaming
+  /// model with an LSTM can then resize its input from a chunk of frames to a
+  /// single frame without losing the state of the LSTM. ResetVariableTensors()
+  /// still resets them.
+  /// default: disabled.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetPreserveVariableTensors(bool preserve);
+
+  /// Sets how the arena of the tensors is planned. kDecreasingSizeBestFit
+  /// usually needs a smaller arena, at the cost of planning the lifetimes of
+  /// all tensors first. Takes effect at the next AllocateTensors().
+  /// default: kInOrderBestFit.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetArenaPlanningStrategy(ArenaPlanningStrategy strategy);
+
+  /// Returns the high-water marks of the arenas of the primary subgraph, and
+  /// the arena sizes planned with each strategy by the last AllocateTensors()
+  /// with kDecreasingSizeBestFit.
+  /// WARNING: This is an experimental API and subject to change.
+  ArenaSizeReport GetArenaSizeReport() const {
+    return primary_subgraph().GetArenaSizeReport();
+  }
+
   /// Sets the cancellation function pointer in order to cancel a request in the
   /// middle of a call to Invoke(). The interpreter queries this function during
   /// inference, between op invocations; when it returns true, the interpreter
@@ -17,6 +17,10 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "third_party/eigen3/Eigen/Core"
@@ -131,6 +135,61 @@ TEST(BasicInterpreter, TestAllocateTensorsResetVariableTensorsInt8) {
   }
 }
 
+TEST(BasicInterpreter, TestAllocateTensorsPreserveVariableTensors) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(3), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({2}), kTfLiteOk);
+  TfLiteQuantizationParams quant;
+  interpreter.SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {2}, quant);
+  interpreter.SetTensorParametersReadWrite(1, kTfLiteFloat32, "", {1}, quant,
+                                           /*is_variable=*/true);
+  interpreter.SetTensorParametersReadWrite(2, kTfLiteFloat32, "", {1}, quant);
+  interpreter.SetVariables({1});
+
+  // Adds the sum of the input to the state, and outputs the state.
+  TfLiteRegistration reg = {nullptr, nullptr, nullptr, nullptr};
+  reg.prepare = [](TfLiteContext* context, TfLiteNode* node) {
+    TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+    return context->ResizeTensor(context, output,
+                                 TfLiteIntArrayCopy(context->tensors[1].dims));
+  };
+  reg.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+    TfLiteTensor* state = &context->tensors[node->inputs->data[1]];
+    for (int i = 0; i < NumElements(input); ++i) {
+      state->data.f[0] += input->data.f[i];
+    }
+    context->tensors[node->outputs->data[0]].data.f[0] = state->data.f[0];
+    return kTfLiteOk;
+  };
+  ASSERT_EQ(
+      interpreter.AddNodeWithParameters({0, 1}, {2}, nullptr, 0, nullptr, &reg),
+      kTfLiteOk);
+  interpreter.SetPreserveVariableTensors(true);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // A chunk of two frames, then a single frame.
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  interpreter.typed_tensor<float>(0)[1] = 2;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(2)[0], 3);
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {1}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  interpreter.typed_tensor<float>(0)[0] = 4;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(2)[0], 7);
+
+  // By default, the state is reset.
+  interpreter.SetPreserveVariableTensors(false);
+  ASSERT_EQ(interpreter.ResizeInputTensor(0, {2}), kTfLiteOk);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  interpreter.typed_tensor<float>(0)[1] = 1;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(2)[0], 2);
+}
+
 // Test size accessor functions.
 TEST(BasicInterpreter, TestSizeFunctions) {
   Interpreter interpreter;
@@ -754,6 +813,86 @@ TEST(BasicInterpreter, AllocateTwice) {
   ASSERT_EQ(old_tensor1_ptr, interpreter.tensor(1)->data.raw);
 }
 
+// The number of nodes running ParallelIncrementInvoke, and the most that ran
+// at the same time.
+std::atomic<int> num_running_increments(0);
+std::atomic<int> max_running_increments(0);
+
+// Adds one to the input. Waits up to half a second for another node to run at
+// the same time.
+TfLiteStatus ParallelIncrementInvoke(TfLiteContext* context,
+                                     TfLiteNode* node) {
+  const int running = ++num_running_increments;
+  int max_running = max_running_increments;
+  while (running > max_running &&
+         !max_running_increments.compare_exchange_weak(max_running, running)) {
+  }
+  for (int i = 0; i < 500 && max_running_increments < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const TfLiteTensor* input = &context->tensors[node->inputs->data[0]];
+  TfLiteTensor* output = &context->tensors[node->outputs->data[0]];
+  output->data.f[0] = input->data.f[0] + 1;
+  --num_running_increments;
+  return kTfLiteOk;
+}
+
+TEST(BasicInterpreter, InterOpParallelism) {
+  Interpreter interpreter;
+  ASSERT_EQ(interpreter.AddTensors(4), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetInputs({0}), kTfLiteOk);
+  ASSERT_EQ(interpreter.SetOutputs({3}), kTfLiteOk);
+  TfLiteQuantizationParams quantized;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "",
+                                                       {1}, quantized),
+              kTfLiteOk);
+  }
+
+  // Registered as a builtin op which can run at the same time as others.
+  TfLiteRegistration reg_increment = {nullptr, nullptr, nullptr,
+                                      ParallelIncrementInvoke};
+  reg_increment.builtin_code = kTfLiteBuiltinAdd;
+  reg_increment.version = 1;
+  TfLiteRegistration reg_add = {nullptr, nullptr, nullptr, nullptr};
+  reg_add.invoke = [](TfLiteContext* context, TfLiteNode* node) {
+    context->tensors[node->outputs->data[0]].data.f[0] =
+        context->tensors[node->inputs->data[0]].data.f[0] +
+        context->tensors[node->inputs->data[1]].data.f[0];
+    return kTfLiteOk;
+  };
+  reg_add.builtin_code = kTfLiteBuiltinAdd;
+  reg_add.version = 1;
+
+  // Two independent branches, joined by the last node.
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr,
+                                              &reg_increment),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({0}, {2}, nullptr, 0, nullptr,
+                                              &reg_increment),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter.AddNodeWithParameters({1, 2}, {3}, nullptr, 0, nullptr,
+                                              &reg_add),
+            kTfLiteOk);
+  interpreter.SetNumThreads(2);
+  interpreter.SetInterOpParallelism(true);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  max_running_increments = 0;
+  interpreter.typed_tensor<float>(0)[0] = 1;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 4);
+  EXPECT_EQ(max_running_increments, 2);
+
+  // Without inter-op parallelism, the nodes run one after the other.
+  interpreter.SetInterOpParallelism(false);
+  max_running_increments = 0;
+  interpreter.typed_tensor<float>(0)[0] = 2;
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  EXPECT_EQ(interpreter.typed_tensor<float>(3)[0], 6);
+  EXPECT_EQ(max_running_increments, 1);
+}
+
 TEST(BasicInterpreter, TestNullErrorReporter) {
   TestErrorReporter reporter;
   Interpreter interpreter;
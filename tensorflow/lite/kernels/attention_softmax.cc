@@ -0,0 +1,163 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cmath>
+
+#include "flatbuffers/flexbuffers.h"  // TF:flatbuffers
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/c_api_internal.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/attention_softmax.h"
+#include "tensorflow/lite/kernels/internal/tensor.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/op_macros.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace attention_softmax {
+
+// Computes the attention probabilities of Transformer models from int8
+// queries and keys in one op:
+//   output = softmax(scale * query . key^T)
+// with the query of shape [batch, query_len, depth], the key of shape
+// [batch, key_len, depth] and the output of shape [batch, query_len,
+// key_len], quantized as the output of int8 softmax.
+constexpr int kQueryTensor = 0;
+constexpr int kKeyTensor = 1;
+constexpr int kOutputTensor = 0;
+
+// The temporaries holding the sums of the key rows and the scores, and the
+// exponentials of the scores.
+constexpr int kScoresTemporary = 0;
+constexpr int kExpScoresTemporary = 1;
+
+struct OpData {
+  // The scale of the scores, 1 / sqrt(depth) if the op has none.
+  float scale;
+  AttentionSoftmaxParams params;
+  int scratch_tensor_index;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  auto* data = new OpData;
+  data->scale = 0;
+  if (buffer != nullptr) {
+    const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+    const flexbuffers::Map& m =
+        flexbuffers::GetRoot(buffer_t, length).AsMap();
+    if (!m["scale"].IsNull()) {
+      data->scale = m["scale"].AsFloat();
+    }
+  }
+  context->AddTensors(context, /*tensors_to_add=*/2,
+                      &data->scratch_tensor_index);
+  return data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  auto* data = reinterpret_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* query = GetInput(context, node, kQueryTensor);
+  const TfLiteTensor* key = GetInput(context, node, kKeyTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+
+  TF_LITE_ENSURE_EQ(context, query->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, key->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(query), 3);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(key), 3);
+  const int batches = SizeOfDimension(query, 0);
+  const int query_len = SizeOfDimension(query, 1);
+  const int key_len = SizeOfDimension(key, 1);
+  const int depth = SizeOfDimension(query, 2);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, 0), batches);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(key, 2), depth);
+  // Same output quantization as int8 softmax.
+  TF_LITE_ENSURE(context, output->params.scale == 1. / 256);
+  TF_LITE_ENSURE_EQ(context, output->params.zero_point, -128);
+
+  const float scale = data->scale != 0 ? data->scale : 1 / std::sqrt(depth);
+  data->params.query_offset = -query->params.zero_point;
+  data->params.score_scale =
+      query->params.scale * key->params.scale * scale;
+  data->params.output_offset = output->params.zero_point;
+  data->params.output_scale = output->params.scale;
+
+  TfLiteIntArrayFree(node->temporaries);
+  node->temporaries = TfLiteIntArrayCreate(2);
+  node->temporaries->data[kScoresTemporary] = data->scratch_tensor_index;
+  node->temporaries->data[kExpScoresTemporary] =
+      data->scratch_tensor_index + 1;
+
+  TfLiteTensor* scores = GetTemporary(context, node, kScoresTemporary);
+  scores->type = kTfLiteInt32;
+  scores->allocation_type = kTfLiteArenaRw;
+  TfLiteIntArray* scores_size = TfLiteIntArrayCreate(1);
+  scores_size->data[0] = 2 * key_len;
+  TF_LITE_ENSURE_OK(context,
+                    context->ResizeTensor(context, scores, scores_size));
+
+  TfLiteTensor* exp_scores = GetTemporary(context, node, kExpScoresTemporary);
+  exp_scores->type = kTfLiteFloat32;
+  exp_scores->allocation_type = kTfLiteArenaRw;
+  TfLiteIntArray* exp_scores_size = TfLiteIntArrayCreate(1);
+  exp_scores_size->data[0] = key_len;
+  TF_LITE_ENSURE_OK(context, context->ResizeTensor(context, exp_scores,
+                                                   exp_scores_size));
+
+  TfLiteIntArray* output_size = TfLiteIntArrayCreate(3);
+  output_size->data[0] = batches;
+  output_size->data[1] = query_len;
+  output_size->data[2] = key_len;
+  return context->ResizeTensor(context, output, output_size);
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  auto* data = reinterpret_cast<OpData*>(node->user_data);
+
+  const TfLiteTensor* query = GetInput(context, node, kQueryTensor);
+  const TfLiteTensor* key = GetInput(context, node, kKeyTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  TfLiteTensor* scores = GetTemporary(context, node, kScoresTemporary);
+  TfLiteTensor* exp_scores = GetTemporary(context, node, kExpScoresTemporary);
+
+  const int key_len = SizeOfDimension(key, 1);
+  int32_t* key_sums = GetTensorData<int32_t>(scores);
+  reference_integer_ops::AttentionSoftmax(
+      data->params, GetTensorShape(query), GetTensorData<int8_t>(query),
+      GetTensorShape(key), GetTensorData<int8_t>(key), GetTensorShape(output),
+      GetTensorData<int8_t>(output), key_sums, key_sums + key_len,
+      GetTensorData<float>(exp_scores));
+  return kTfLiteOk;
+}
+
+}  // namespace attention_softmax
+
+TfLiteRegistration* Register_ATTENTION_SOFTMAX() {
+  static TfLiteRegistration r = {
+      attention_softmax::Init, attention_softmax::Free,
+      attention_softmax::Prepare, attention_softmax::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
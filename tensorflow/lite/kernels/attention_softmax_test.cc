@@ -0,0 +1,109 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // TF:flatbuffers
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+
+TfLiteRegistration* Register_ATTENTION_SOFTMAX();
+
+namespace {
+
+using ::testing::ElementsAreArray;
+
+class AttentionSoftmaxOpModel : public SingleOpModel {
+ public:
+  // Uses the default scale of the scores if `scale` is 0.
+  AttentionSoftmaxOpModel(const TensorData& query, const TensorData& key,
+                          float scale) {
+    query_ = AddInput(query);
+    key_ = AddInput(key);
+    output_ = AddOutput({TensorType_INT8, {}, 0, 0, 1.0f / 256, -128});
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      if (scale != 0) fbb.Float("scale", scale);
+    });
+    fbb.Finish();
+    SetCustomOp("TFLite_AttentionSoftmax", fbb.GetBuffer(),
+                Register_ATTENTION_SOFTMAX);
+
+    BuildInterpreter({GetShape(query_), GetShape(key_)});
+  }
+
+  int query() const { return query_; }
+  int key() const { return key_; }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int query_;
+  int key_;
+  int output_;
+};
+
+TEST(AttentionSoftmaxOpTest, DefaultScale) {
+  AttentionSoftmaxOpModel m({TensorType_INT8, {1, 2, 4}, -2.5, 2.5},
+                            {TensorType_INT8, {1, 3, 4}, -2, 3},
+                            /*scale=*/0);
+  m.QuantizeAndPopulate<int8_t>(m.query(), {1, 0, 1, 0, 0, 2, 0, -1});
+  m.QuantizeAndPopulate<int8_t>(m.key(),
+                                {1, 1, 0, 0, 0, 0, 1, 1, 2, 0, 2, 0});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 2, 3}));
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {
+                      0.1543, 0.1543, 0.6914,  // query 1
+                      0.6285, 0.1402, 0.2312,  // query 2
+                  },
+                  0.01)));
+}
+
+TEST(AttentionSoftmaxOpTest, ScaleAndBatches) {
+  AttentionSoftmaxOpModel m({TensorType_INT8, {2, 1, 4}, -2.5, 2.5},
+                            {TensorType_INT8, {2, 3, 4}, -2, 3},
+                            /*scale=*/0.25);
+  m.QuantizeAndPopulate<int8_t>(m.query(), {1, 0, 1, 0, 0, 2, 0, -1});
+  m.QuantizeAndPopulate<int8_t>(m.key(), {
+                                             1, 1, 0, 0, 0, 0, 1, 1, 2, 0, 2, 0,
+                                             1, 1, 0, 0, 0, 0, 1, 1, 2, 0, 2, 0,
+                                         });
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({2, 1, 3}));
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {
+                      0.2429, 0.2429, 0.5142,  // batch 1
+                      0.481, 0.2272, 0.2918,   // batch 2
+                  },
+                  0.01)));
+}
+
+}  // namespace
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
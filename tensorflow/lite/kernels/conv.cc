@@ -22,6 +22,8 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_internal.h"
@@ -41,6 +43,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/kernels/prepacked_weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -95,6 +98,10 @@ struct OpData {
   int32_t input_offset_index;
   bool need_hwcn_weights;
   bool have_weights_been_transposed;
+  // Constant weights are transposed once in the process, and the transposed
+  // copy is shared by all the interpreters running the model.
+  bool share_hwcn_weights;
+  std::shared_ptr<const std::vector<float>> shared_hwcn_weights;
   bool need_im2col;
 
   bool supports_multithreaded_kernel;
@@ -129,11 +136,8 @@ void Free(TfLiteContext* context, void* buffer) {
 // Naive implementation of transpose for floats. Could be optimized to be more
 // cache friendly, but for now it's a one-time cost on first run, and we would
 // prefer to remove the need to do this at all eventually.
-void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
-  const int rows = output->dims->data[1];
-  const int cols = output->dims->data[0];
-  const float* input_data = GetTensorData<float>(input);
-  float* output_data = GetTensorData<float>(output);
+void TransposeFloatMatrix(const float* input_data, int rows, int cols,
+                          float* output_data) {
   for (int i = 0; i < rows; ++i) {
     for (int j = 0; j < cols; ++j) {
       const float in_value = input_data[i * cols + j];
@@ -142,6 +146,11 @@ void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
   }
 }
 
+void TransposeFloatTensor(TfLiteTensor* input, TfLiteTensor* output) {
+  TransposeFloatMatrix(GetTensorData<float>(input), output->dims->data[1],
+                       output->dims->data[0], GetTensorData<float>(output));
+}
+
 // Allocate temporary tensors (`im2col`, `hwcn_weights` if necessary).
 // Note: `context->AddTensors` might invalidate pointers to existing tensors.
 // Therefore the logic to add tensors are isolated into this function.
@@ -170,6 +179,8 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
   // we're running with that data type.
   data->need_hwcn_weights = (input->type == kTfLiteFloat32 &&
                              data->supports_multithreaded_kernel && !is_hybrid);
+  data->share_hwcn_weights =
+      data->need_hwcn_weights && IsConstantTensor(filter);
 
   // We don't always need to allocate im2col. It is only used in some versions
   // of the optimized Conv. This test just mimics something that happens inside
@@ -189,7 +200,7 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(TfLiteContext* context,
     }
     ++temporaries_count;
   }
-  if (data->need_hwcn_weights) {
+  if (data->need_hwcn_weights && !data->share_hwcn_weights) {
     data->hwcn_weights_index = temporaries_count;
     if (data->hwcn_weights_id == kTensorNotAllocated) {
       context->AddTensors(context, 1, &data->hwcn_weights_id);
@@ -379,7 +390,18 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     if (im2col_status != kTfLiteOk) return im2col_status;
   }
 
-  if (data->need_hwcn_weights) {
+  if (data->share_hwcn_weights) {
+    const int rows = SizeOfDimension(filter, 0);
+    const int cols = NumElements(filter) / rows;
+    auto transpose = [filter, rows, cols](std::vector<float>* hwcn) {
+      hwcn->resize(rows * cols);
+      TransposeFloatMatrix(GetTensorData<float>(filter), rows, cols,
+                           hwcn->data());
+    };
+    data->shared_hwcn_weights =
+        prepacked_weights_cache::GetOrPack<std::vector<float>>(
+            filter, "conv_hwcn", transpose);
+  } else if (data->need_hwcn_weights) {
     node->temporaries->data[data->hwcn_weights_index] = data->hwcn_weights_id;
     TfLiteIntArray* hwcn_weights_size = TfLiteIntArrayCreate(2);
 
@@ -628,7 +650,9 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
       TFLITE_DCHECK(false);
 #else
       const float* filter_data;
-      if (data->need_hwcn_weights) {
+      if (data->share_hwcn_weights) {
+        filter_data = data->shared_hwcn_weights->data();
+      } else if (data->need_hwcn_weights) {
         filter_data = GetTensorData<float>(hwcn_weights);
       } else {
         filter_data = GetTensorData<float>(filter);
@@ -789,12 +813,14 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       data->need_im2col
           ? &context->tensors[node->temporaries->data[data->im2col_index]]
           : nullptr;
+  const bool use_hwcn_temporary =
+      data->need_hwcn_weights && !data->share_hwcn_weights;
   TfLiteTensor* hwcn_weights =
-      data->need_hwcn_weights
+      use_hwcn_temporary
           ? &context->tensors[node->temporaries->data[data->hwcn_weights_index]]
           : nullptr;
 
-  if (data->need_hwcn_weights && !data->have_weights_been_transposed) {
+  if (use_hwcn_temporary && !data->have_weights_been_transposed) {
     TransposeFloatTensor(filter, hwcn_weights);
     data->have_weights_been_transposed = true;
   }
@@ -23,12 +23,14 @@ limitations under the License.
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/kernels/activation_functor.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/kernels/prepacked_weights_cache.h"
 
 namespace tflite {
 namespace ops {
@@ -60,8 +63,18 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int scratch_tensor_index;
+  // Whether constant float weights were checked for block sparsity.
+  bool sparsity_checked = false;
+  // The constant float weights in block-sparse form, if enough of their
+  // blocks are zeros for the sparse kernel to be faster. Shared by all the
+  // interpreters running the model.
+  std::shared_ptr<const optimized_ops::BlockSparseMatrix> sparse_weights;
 };
 
+// The fraction of zero blocks from which the optimized kernel multiplies
+// constant float weights in block-sparse form.
+constexpr float kMinBlockSparsity = 0.7f;
+
 constexpr int kInputTensor = 0;
 constexpr int kWeightsTensor = 1;
 constexpr int kBiasTensor = 2;
@@ -211,6 +224,25 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
+  // Constant weights do not change, so their sparsity is checked only once.
+  if (!data->sparsity_checked && filter->type == kTfLiteFloat32 &&
+      IsConstantTensor(filter)) {
+    data->sparsity_checked = true;
+    const int rows = SizeOfDimension(filter, 0);
+    const int cols = SizeOfDimension(filter, 1);
+    const float* weights = GetTensorData<float>(filter);
+    if (optimized_ops::BlockSparsity(weights, rows, cols) >=
+        kMinBlockSparsity) {
+      auto to_block_sparse = [weights, rows,
+                              cols](optimized_ops::BlockSparseMatrix* sparse) {
+        optimized_ops::ToBlockSparse(weights, rows, cols, sparse);
+      };
+      data->sparse_weights =
+          prepacked_weights_cache::GetOrPack<optimized_ops::BlockSparseMatrix>(
+              filter, "fully_connected_block_sparse", to_block_sparse);
+    }
+  }
+
   // Resize output.
   TfLiteIntArray* output_size_array = nullptr;
   if (params->keep_num_dims) {
@@ -505,6 +537,15 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
         GetTensorShape(output), GetTensorData<float>(output));
   } else if (kernel_type == kLegacyPie) {
     return EvalPie(context, node, params, data, input, filter, bias, output);
+  } else if (data->sparse_weights) {
+    FullyConnectedParams op_params;
+    op_params.float_activation_min = output_activation_min;
+    op_params.float_activation_max = output_activation_max;
+    optimized_ops::FullyConnectedBlockSparse(
+        op_params, GetTensorShape(input), GetTensorData<float>(input),
+        *data->sparse_weights, GetTensorShape(bias),
+        GetTensorData<float>(bias), GetTensorShape(output),
+        GetTensorData<float>(output));
   } else {
     FullyConnectedParams op_params;
     op_params.float_activation_min = output_activation_min;
@@ -211,6 +211,36 @@ class FloatFullyConnectedOpModel : public BaseFullyConnectedOpModel {
   std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
 };
 
+// A float model whose weights are constant, as in converted models.
+class ConstWeightsFloatFullyConnectedOpModel : public SingleOpModel {
+ public:
+  ConstWeightsFloatFullyConnectedOpModel(TfLiteRegistration* registration,
+                                         int units, int input_size,
+                                         int batches,
+                                         std::initializer_list<float> weights) {
+    input_ = AddInput({TensorType_FLOAT32, {batches, input_size}});
+    AddConstInput({TensorType_FLOAT32, {units, input_size}}, weights);
+    bias_ = AddInput({TensorType_FLOAT32, {units}});
+    output_ = AddOutput({TensorType_FLOAT32});
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_RELU)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), {}, GetShape(bias_)});
+  }
+
+  void SetBias(const std::vector<float>& f) { PopulateTensor(bias_, f); }
+  void SetInput(const std::vector<float>& f) { PopulateTensor(input_, f); }
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int bias_;
+  int output_;
+};
+
 class QuantizedFullyConnectedOpModel : public BaseFullyConnectedOpModel {
  public:
   using BaseFullyConnectedOpModel::BaseFullyConnectedOpModel;
@@ -408,6 +438,27 @@ TEST_P(FloatFullyConnectedOpTest, SimpleTest2) {
   EXPECT_THAT(m.GetOutput(), ElementsAre(11, 9));
 }
 
+TEST_P(FloatFullyConnectedOpTest, BlockSparseConstWeights) {
+  // Five of the six blocks of 1x4 weights are zeros, which the optimized
+  // kernel skips.
+  ConstWeightsFloatFullyConnectedOpModel m(GetRegistration(), /*units=*/3,
+                                           /*input_size=*/8, /*batches=*/2,
+                                           {
+                                               0, 0, 0, 0, 1, 2, 3, 4,  // u = 0
+                                               0, 0, 0, 0, 0, 0, 0, 0,  // u = 1
+                                               0, 0, 0, 0, 0, 0, 0, 0,  // u = 2
+                                           });
+  m.SetBias({1, 2, 3});
+  m.SetInput({
+      1, 2, 3, 4, 5, 6, 7, 8,      // b = 0
+      1, 1, 1, 1, -1, -1, -1, -1,  // b = 1
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(), ElementsAre(71, 2, 3, 0, 2, 3));
+}
+
 TEST(FloatFullyConnectedOpTest, SimpleTestNoBias) {
   // The optimized kernel assumes that the bias is specified.
   FloatFullyConnectedOpModel m(ops::builtin::Register_FULLY_CONNECTED_PIE(),
@@ -0,0 +1,183 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+#ifdef BLOCK_SPARSE_BENCHMARKS
+#include "testing/base/public/benchmark.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#endif  // BLOCK_SPARSE_BENCHMARKS
+
+namespace tflite {
+namespace {
+
+// Returns random weights in which each block of 1x4 is zero with probability
+// `sparsity`.
+std::vector<float> RandomBlockSparseWeights(int rows, int cols,
+                                            float sparsity) {
+  std::mt19937 random_engine(rows * cols);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  std::bernoulli_distribution zero_block(sparsity);
+  std::vector<float> weights(rows * cols);
+  for (int i = 0; i < rows * cols;
+       i += optimized_ops::BlockSparseMatrix::kBlockCols) {
+    const bool zero = zero_block(random_engine);
+    for (int j = 0; j < optimized_ops::BlockSparseMatrix::kBlockCols; ++j) {
+      weights[i + j] = zero ? 0.0f : value(random_engine);
+    }
+  }
+  return weights;
+}
+
+std::vector<float> RandomValues(int size) {
+  std::mt19937 random_engine(size);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  std::vector<float> values(size);
+  for (float& v : values) v = value(random_engine);
+  return values;
+}
+
+TEST(BlockSparseTest, BlockSparsity) {
+  const std::vector<float> weights = {
+      0, 0, 0, 0, 0, 0, 0, 1,  // Row 0.
+      0, 0, 0, 0, 0, 0, 0, 0,  // Row 1.
+  };
+  EXPECT_EQ(optimized_ops::BlockSparsity(weights.data(), 2, 8), 0.75f);
+  // The columns are not a multiple of the blocks.
+  EXPECT_EQ(optimized_ops::BlockSparsity(weights.data(), 2, 6), 0.0f);
+
+  optimized_ops::BlockSparseMatrix matrix;
+  optimized_ops::ToBlockSparse(weights.data(), 2, 8, &matrix);
+  EXPECT_EQ(matrix.row_begin, std::vector<int>({0, 1, 1}));
+  EXPECT_EQ(matrix.block_col, std::vector<int>({4}));
+  EXPECT_EQ(matrix.values, std::vector<float>({0, 0, 0, 1}));
+}
+
+TEST(BlockSparseTest, MatchesReferenceFullyConnected) {
+  const int kRows = 24;
+  const int kCols = 32;
+  for (float sparsity : {0.0f, 0.5f, 0.8f, 0.9f, 1.0f}) {
+    for (int batches : {1, 3}) {
+      const std::vector<float> weights =
+          RandomBlockSparseWeights(kRows, kCols, sparsity);
+      const std::vector<float> input = RandomValues(batches * kCols);
+      const std::vector<float> bias = RandomValues(kRows);
+      const RuntimeShape input_shape({batches, kCols});
+      const RuntimeShape weights_shape({kRows, kCols});
+      const RuntimeShape bias_shape({kRows});
+      const RuntimeShape output_shape({batches, kRows});
+      FullyConnectedParams params;
+      params.float_activation_min = -0.5f;
+      params.float_activation_max = 0.5f;
+
+      std::vector<float> expected(batches * kRows);
+      reference_ops::FullyConnected(params, input_shape, input.data(),
+                                    weights_shape, weights.data(), bias_shape,
+                                    bias.data(), output_shape,
+                                    expected.data());
+      optimized_ops::BlockSparseMatrix matrix;
+      optimized_ops::ToBlockSparse(weights.data(), kRows, kCols, &matrix);
+      std::vector<float> output(batches * kRows);
+      optimized_ops::FullyConnectedBlockSparse(
+          params, input_shape, input.data(), matrix, bias_shape, bias.data(),
+          output_shape, output.data());
+      for (int i = 0; i < output.size(); ++i) {
+        EXPECT_NEAR(output[i], expected[i], 1e-5f)
+            << "sparsity " << sparsity << ", batches " << batches;
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tflite
+
+#ifdef BLOCK_SPARSE_BENCHMARKS
+
+// Compile with --copt="-DGOOGLE_COMMANDLINEFLAGS_FULL_API=1" and
+// --copt="-DBLOCK_SPARSE_BENCHMARKS"
+// Run with --benchmarks=all
+//
+// The arguments are rows, cols, batches, and the percentage of zero blocks.
+void BM_DenseFullyConnected(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batches = state.range(2);
+  const std::vector<float> weights =
+      tflite::RandomBlockSparseWeights(rows, cols, state.range(3) / 100.0f);
+  const std::vector<float> input = tflite::RandomValues(batches * cols);
+  const std::vector<float> bias = tflite::RandomValues(rows);
+  std::vector<float> output(batches * rows);
+  tflite::FullyConnectedParams params;
+  params.float_activation_min = std::numeric_limits<float>::lowest();
+  params.float_activation_max = std::numeric_limits<float>::max();
+  tflite::CpuBackendContext cpu_backend_context;
+  for (auto _ : state) {
+    tflite::optimized_ops::FullyConnected(
+        params, tflite::RuntimeShape({batches, cols}), input.data(),
+        tflite::RuntimeShape({rows, cols}), weights.data(),
+        tflite::RuntimeShape({rows}), bias.data(),
+        tflite::RuntimeShape({batches, rows}), output.data(),
+        &cpu_backend_context);
+    testing::DoNotOptimize(output[0]);
+  }
+}
+
+void BM_BlockSparseFullyConnected(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  const int batches = state.range(2);
+  const std::vector<float> weights =
+      tflite::RandomBlockSparseWeights(rows, cols, state.range(3) / 100.0f);
+  const std::vector<float> input = tflite::RandomValues(batches * cols);
+  const std::vector<float> bias = tflite::RandomValues(rows);
+  std::vector<float> output(batches * rows);
+  tflite::FullyConnectedParams params;
+  params.float_activation_min = std::numeric_limits<float>::lowest();
+  params.float_activation_max = std::numeric_limits<float>::max();
+  tflite::optimized_ops::BlockSparseMatrix matrix;
+  tflite::optimized_ops::ToBlockSparse(weights.data(), rows, cols, &matrix);
+  for (auto _ : state) {
+    tflite::optimized_ops::FullyConnectedBlockSparse(
+        params, tflite::RuntimeShape({batches, cols}), input.data(), matrix,
+        tflite::RuntimeShape({rows}), bias.data(),
+        tflite::RuntimeShape({batches, rows}), output.data());
+    testing::DoNotOptimize(output[0]);
+  }
+}
+
+#define BLOCK_SPARSE_BENCHMARK_ARGS  \
+  ->Args({1024, 1024, 1, 0})         \
+      ->Args({1024, 1024, 1, 50})    \
+      ->Args({1024, 1024, 1, 80})    \
+      ->Args({1024, 1024, 1, 90})    \
+      ->Args({1024, 1024, 4, 0})     \
+      ->Args({1024, 1024, 4, 80})    \
+      ->Args({1024, 1024, 4, 90})    \
+      ->Args({2048, 512, 1, 90})
+BENCHMARK(BM_DenseFullyConnected) BLOCK_SPARSE_BENCHMARK_ARGS;
+BENCHMARK(BM_BlockSparseFullyConnected) BLOCK_SPARSE_BENCHMARK_ARGS;
+#undef BLOCK_SPARSE_BENCHMARK_ARGS
+
+#endif  // BLOCK_SPARSE_BENCHMARKS
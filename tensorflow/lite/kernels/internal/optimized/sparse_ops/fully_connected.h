@@ -0,0 +1,127 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
+
+#include <vector>
+
+#include "profiling/instrumentation.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_ops {
+
+// A row-major matrix stored in blocks of 1 row and kBlockCols columns, where
+// the blocks of zeros are left out.
+struct BlockSparseMatrix {
+  static constexpr int kBlockCols = 4;
+
+  int rows = 0;
+  int cols = 0;
+  // The blocks of row `r` are [row_begin[r], row_begin[r + 1]).
+  std::vector<int> row_begin;
+  // The first column of each block.
+  std::vector<int> block_col;
+  // kBlockCols values per block.
+  std::vector<float> values;
+};
+
+// Returns the fraction of the blocks of `data` which are all zeros, or 0 if
+// `cols` is not a multiple of BlockSparseMatrix::kBlockCols.
+inline float BlockSparsity(const float* data, int rows, int cols) {
+  constexpr int kBlockCols = BlockSparseMatrix::kBlockCols;
+  if (rows == 0 || cols == 0 || cols % kBlockCols != 0) return 0;
+  int zero_blocks = 0;
+  for (int i = 0; i < rows * cols; i += kBlockCols) {
+    bool zero = true;
+    for (int j = 0; j < kBlockCols; ++j) {
+      zero = zero && data[i + j] == 0.0f;
+    }
+    zero_blocks += zero;
+  }
+  return static_cast<float>(zero_blocks) / (rows * cols / kBlockCols);
+}
+
+// Converts the row-major matrix `data`. `cols` must be a multiple of
+// BlockSparseMatrix::kBlockCols.
+inline void ToBlockSparse(const float* data, int rows, int cols,
+                          BlockSparseMatrix* matrix) {
+  constexpr int kBlockCols = BlockSparseMatrix::kBlockCols;
+  TFLITE_DCHECK_EQ(cols % kBlockCols, 0);
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->row_begin.assign(1, 0);
+  matrix->block_col.clear();
+  matrix->values.clear();
+  for (int r = 0; r < rows; ++r) {
+    const float* row = data + r * cols;
+    for (int c = 0; c < cols; c += kBlockCols) {
+      bool zero = true;
+      for (int j = 0; j < kBlockCols; ++j) {
+        zero = zero && row[c + j] == 0.0f;
+      }
+      if (zero) continue;
+      matrix->block_col.push_back(c);
+      matrix->values.insert(matrix->values.end(), row + c,
+                            row + c + kBlockCols);
+    }
+    matrix->row_begin.push_back(matrix->block_col.size());
+  }
+}
+
+// Same as FullyConnected with float weights, for weights converted by
+// ToBlockSparse. Only the blocks which are not zero are multiplied.
+inline void FullyConnectedBlockSparse(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const float* input_data, const BlockSparseMatrix& weights,
+    const RuntimeShape& bias_shape, const float* bias_data,
+    const RuntimeShape& output_shape, float* output_data) {
+  gemmlowp::ScopedProfilingLabel label("FullyConnectedBlockSparse");
+  constexpr int kBlockCols = BlockSparseMatrix::kBlockCols;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth = output_shape.Dims(output_dims_count - 1);
+  TFLITE_DCHECK_EQ(output_depth, weights.rows);
+  TFLITE_DCHECK_EQ(input_shape.FlatSize(), batches * weights.cols);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+  const int* block_col = weights.block_col.data();
+  const float* values = weights.values.data();
+  for (int b = 0; b < batches; ++b) {
+    const float* input = input_data + b * weights.cols;
+    float* output = output_data + b * output_depth;
+    for (int r = 0; r < output_depth; ++r) {
+      float total = 0.0f;
+      for (int k = weights.row_begin[r]; k < weights.row_begin[r + 1]; ++k) {
+        const float* x = input + block_col[k];
+        const float* w = values + k * kBlockCols;
+        total += w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3];
+      }
+      if (bias_data) total += bias_data[r];
+      output[r] = ActivationFunctionWithMinMax(total, output_activation_min,
+                                               output_activation_max);
+    }
+  }
+}
+
+}  // namespace optimized_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
@@ -0,0 +1,103 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_ATTENTION_SOFTMAX_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_ATTENTION_SOFTMAX_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace reference_integer_ops {
+
+// Computes the attention probabilities softmax(query . key^T) of each query
+// row against the key rows of its batch, with the query and key of shapes
+// [batch, query_len, depth] and [batch, key_len, depth] and the output of
+// shape [batch, query_len, key_len].
+//
+// The scores are int32 dot products which are never requantized: only their
+// differences to the row maximum are scaled, exponentiated and normalized.
+// The zero point terms which are the same for the whole row cancel out in the
+// softmax, so that only the query offset times the sum of each key row,
+// computed once per batch, is added to the raw int8 products.
+// `key_sums` and `scores` are scratch buffers of key_len int32 and
+// `exp_scores` of key_len floats.
+inline void AttentionSoftmax(const AttentionSoftmaxParams& params,
+                             const RuntimeShape& query_shape,
+                             const int8* query_data,
+                             const RuntimeShape& key_shape,
+                             const int8* key_data,
+                             const RuntimeShape& output_shape,
+                             int8* output_data, int32* key_sums,
+                             int32* scores, float* exp_scores) {
+  TFLITE_DCHECK_EQ(query_shape.DimensionsCount(), 3);
+  TFLITE_DCHECK_EQ(key_shape.DimensionsCount(), 3);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 3);
+  const int batches =
+      MatchingDim(query_shape, 0, key_shape, 0, output_shape, 0);
+  const int query_len = MatchingDim(query_shape, 1, output_shape, 1);
+  const int key_len = MatchingDim(key_shape, 1, output_shape, 2);
+  const int depth = MatchingDim(query_shape, 2, key_shape, 2);
+  const int32 clamp_min = std::numeric_limits<int8>::min();
+  const int32 clamp_max = std::numeric_limits<int8>::max();
+
+  for (int b = 0; b < batches; ++b) {
+    const int8* key_batch = key_data + b * key_len * depth;
+    for (int j = 0; j < key_len; ++j) {
+      int32 sum = 0;
+      for (int d = 0; d < depth; ++d) {
+        sum += key_batch[j * depth + d];
+      }
+      key_sums[j] = sum;
+    }
+
+    for (int i = 0; i < query_len; ++i) {
+      const int8* query_row = query_data + (b * query_len + i) * depth;
+      int32 max_score = std::numeric_limits<int32>::min();
+      for (int j = 0; j < key_len; ++j) {
+        const int8* key_row = key_batch + j * depth;
+        int32 dot = 0;
+        for (int d = 0; d < depth; ++d) {
+          dot += static_cast<int32>(query_row[d]) * key_row[d];
+        }
+        scores[j] = dot + params.query_offset * key_sums[j];
+        max_score = std::max(max_score, scores[j]);
+      }
+
+      float sum_exp = 0.0f;
+      for (int j = 0; j < key_len; ++j) {
+        exp_scores[j] = std::exp(params.score_scale * (scores[j] - max_score));
+        sum_exp += exp_scores[j];
+      }
+
+      const float inv_sum_exp = 1.0f / (sum_exp * params.output_scale);
+      int8* output_row = output_data + (b * query_len + i) * key_len;
+      for (int j = 0; j < key_len; ++j) {
+        int32 output = static_cast<int32>(std::round(exp_scores[j] *
+                                                     inv_sum_exp)) +
+                       params.output_offset;
+        output = std::max(std::min(output, clamp_max), clamp_min);
+        output_row[j] = static_cast<int8>(output);
+      }
+    }
+  }
+}
+
+}  // namespace reference_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_ATTENTION_SOFTMAX_H_
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_LAYER_NORM_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_LAYER_NORM_H_
+
+#include <cmath>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+
+namespace tflite {
+namespace reference_integer_ops {
+
+// The number of fractional bits of the normalized inputs.
+constexpr int kLayerNormFractionalBits = 11;
+
+// Normalizes each row of the last dimension of `input_data` to zero mean and
+// unit variance, then multiplies it by the per-channel quantized `gamma_data`
+// and adds `beta_data`.
+//
+// The normalized values do not depend on the input scale and zero point, and
+// are computed in fixed point with kLayerNormFractionalBits fractional bits.
+// `beta_data` is in the scale of the products of the normalized values with
+// gamma, i.e. gamma_scale[c] * 2^-kLayerNormFractionalBits, and
+// `output_multiplier`/`output_shift` rescale the sums to the output per
+// channel.
+inline void LayerNormPerChannel(
+    const LayerNormParams& params, const int32* output_multiplier,
+    const int32* output_shift, const RuntimeShape& input_shape,
+    const int8* input_data, const int8* gamma_data, const int32* beta_data,
+    const RuntimeShape& output_shape, int8* output_data) {
+  const int trailing_dim = input_shape.DimensionsCount() - 1;
+  const int outer_size =
+      MatchingFlatSizeSkipDim(input_shape, trailing_dim, output_shape);
+  const int depth =
+      MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
+
+  for (int i = 0; i < outer_size; ++i) {
+    const int8* input_row = input_data + i * depth;
+    int8* output_row = output_data + i * depth;
+
+    // sum^2 and depth * sum of squares fit in int64 for any depth the
+    // int32 sums allow.
+    int32 sum = 0;
+    int64_t sum_of_squares = 0;
+    for (int c = 0; c < depth; ++c) {
+      const int32 input = input_row[c];
+      sum += input;
+      sum_of_squares += input * input;
+    }
+    // depth^2 times the variance.
+    const int64_t scaled_variance =
+        depth * sum_of_squares - static_cast<int64_t>(sum) * sum;
+
+    // (input * depth - sum) * inv_std_multiplier is the normalized input,
+    // with kLayerNormFractionalBits fractional bits. A constant row
+    // normalizes to zeros.
+    int32 inv_std_multiplier = 0;
+    int inv_std_shift = 0;
+    if (scaled_variance > 0) {
+      const double inv_std =
+          (1 << kLayerNormFractionalBits) /
+          std::sqrt(static_cast<double>(scaled_variance) +
+                    static_cast<double>(params.variance_epsilon) * depth *
+                        depth);
+      QuantizeMultiplier(inv_std, &inv_std_multiplier, &inv_std_shift);
+    }
+
+    for (int c = 0; c < depth; ++c) {
+      const int32 normalized = MultiplyByQuantizedMultiplier(
+          input_row[c] * depth - sum, inv_std_multiplier, inv_std_shift);
+      int32 acc = normalized * gamma_data[c] + beta_data[c];
+      acc = MultiplyByQuantizedMultiplier(acc, output_multiplier[c],
+                                          output_shift[c]);
+      acc += params.output_offset;
+      acc = std::max(acc, params.quantized_activation_min);
+      acc = std::min(acc, params.quantized_activation_max);
+      output_row[c] = static_cast<int8>(acc);
+    }
+  }
+}
+
+}  // namespace reference_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_REFERENCE_INTEGER_OPS_LAYER_NORM_H_
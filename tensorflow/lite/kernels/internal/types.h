@@ -749,6 +749,16 @@ enum class ResizingCategory : uint8 {
   kGenericResize,
 };
 
+struct AttentionSoftmaxParams {
+  // int8 inference params. The key offset cancels out in the softmax.
+  int32 query_offset;
+  // The real value of a unit of the query-key dot products, including the
+  // scale of the scores.
+  float score_scale;
+  int32 output_offset;
+  float output_scale;
+};
+
 // For Add, Sub, Mul ops.
 struct ArithmeticParams {
   // Shape dependent / common to data / op types.
@@ -892,6 +902,15 @@ struct L2NormalizationParams {
   int32 input_zero_point;
 };
 
+struct LayerNormParams {
+  // int8 inference params. The epsilon is in units of the squared input
+  // scale.
+  float variance_epsilon;
+  int32 output_offset;
+  int32 quantized_activation_min;
+  int32 quantized_activation_max;
+};
+
 struct LocalResponseNormalizationParams {
   int32 range;
   double bias;
@@ -0,0 +1,181 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "flatbuffers/flexbuffers.h"  // TF:flatbuffers
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/c_api_internal.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/layer_norm.h"
+#include "tensorflow/lite/kernels/internal/tensor.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/op_macros.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+namespace layer_norm {
+
+// Normalizes the last dimension of an int8 input, as in Transformer models:
+//   output = (input - mean) / sqrt(variance + epsilon) * gamma + beta
+// gamma is int8 and beta int32, both constant and quantized per tensor or per
+// channel.
+constexpr int kInputTensor = 0;
+constexpr int kGammaTensor = 1;
+constexpr int kBetaTensor = 2;
+constexpr int kOutputTensor = 0;
+
+// The variance epsilon of BERT models, used when the op has none.
+constexpr float kDefaultEpsilon = 1e-12f;
+
+struct OpData {
+  float epsilon;
+  LayerNormParams params;
+  // Per channel multiplier and shift from the products of the normalized
+  // inputs with gamma to the output.
+  std::vector<int32_t> output_multiplier;
+  std::vector<int32_t> output_shift;
+  // beta in the scale of the products of the normalized inputs with gamma.
+  std::vector<int32_t> beta;
+};
+
+// Returns the scale of channel `c` of `tensor`, quantized per tensor or per
+// channel.
+float ChannelScale(const TfLiteTensor* tensor, int c) {
+  const auto* affine_quantization =
+      reinterpret_cast<const TfLiteAffineQuantization*>(
+          tensor->quantization.params);
+  if (affine_quantization == nullptr ||
+      affine_quantization->scale->size == 1) {
+    return tensor->params.scale;
+  }
+  return affine_quantization->scale->data[c];
+}
+
+TfLiteStatus CheckChannelQuantization(TfLiteContext* context,
+                                      const TfLiteTensor* tensor, int depth) {
+  TF_LITE_ENSURE_EQ(context, tensor->quantization.type,
+                    kTfLiteAffineQuantization);
+  const auto* affine_quantization =
+      reinterpret_cast<const TfLiteAffineQuantization*>(
+          tensor->quantization.params);
+  TF_LITE_ENSURE(context, affine_quantization);
+  TF_LITE_ENSURE(context, affine_quantization->scale->size == 1 ||
+                              affine_quantization->scale->size == depth);
+  return kTfLiteOk;
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  auto* data = new OpData;
+  data->epsilon = kDefaultEpsilon;
+  if (buffer != nullptr) {
+    const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+    const flexbuffers::Map& m =
+        flexbuffers::GetRoot(buffer_t, length).AsMap();
+    if (!m["epsilon"].IsNull()) {
+      data->epsilon = m["epsilon"].AsFloat();
+    }
+  }
+  return data;
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  auto* data = reinterpret_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 3);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* gamma = GetInput(context, node, kGammaTensor);
+  const TfLiteTensor* beta = GetInput(context, node, kBetaTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+
+  TF_LITE_ENSURE_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, gamma->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, beta->type, kTfLiteInt32);
+  TF_LITE_ENSURE_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE(context, NumDimensions(input) >= 1);
+  TF_LITE_ENSURE(context, data->epsilon >= 0);
+
+  const int depth = SizeOfDimension(input, NumDimensions(input) - 1);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(gamma), 1);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(beta), 1);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(gamma, 0), depth);
+  TF_LITE_ENSURE_EQ(context, SizeOfDimension(beta, 0), depth);
+  // gamma and beta are requantized once, here.
+  TF_LITE_ENSURE(context, IsConstantTensor(gamma));
+  TF_LITE_ENSURE(context, IsConstantTensor(beta));
+  TF_LITE_ENSURE_OK(context, CheckChannelQuantization(context, gamma, depth));
+  TF_LITE_ENSURE_OK(context, CheckChannelQuantization(context, beta, depth));
+
+  data->params.variance_epsilon =
+      data->epsilon / (input->params.scale * input->params.scale);
+  data->params.output_offset = output->params.zero_point;
+  data->params.quantized_activation_min = std::numeric_limits<int8_t>::min();
+  data->params.quantized_activation_max = std::numeric_limits<int8_t>::max();
+
+  data->output_multiplier.resize(depth);
+  data->output_shift.resize(depth);
+  data->beta.resize(depth);
+  const int32_t* beta_data = GetTensorData<int32_t>(beta);
+  for (int c = 0; c < depth; ++c) {
+    const double product_scale =
+        static_cast<double>(ChannelScale(gamma, c)) /
+        (1 << reference_integer_ops::kLayerNormFractionalBits);
+    int shift;
+    QuantizeMultiplier(product_scale / output->params.scale,
+                       &data->output_multiplier[c], &shift);
+    data->output_shift[c] = shift;
+    data->beta[c] = static_cast<int32_t>(std::round(
+        beta_data[c] * static_cast<double>(ChannelScale(beta, c)) /
+        product_scale));
+  }
+
+  return context->ResizeTensor(context, output,
+                               TfLiteIntArrayCopy(input->dims));
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  auto* data = reinterpret_cast<OpData*>(node->user_data);
+
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* gamma = GetInput(context, node, kGammaTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+
+  reference_integer_ops::LayerNormPerChannel(
+      data->params, data->output_multiplier.data(), data->output_shift.data(),
+      GetTensorShape(input), GetTensorData<int8_t>(input),
+      GetTensorData<int8_t>(gamma), data->beta.data(), GetTensorShape(output),
+      GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+}  // namespace layer_norm
+
+TfLiteRegistration* Register_LAYER_NORM() {
+  static TfLiteRegistration r = {layer_norm::Init, layer_norm::Free,
+                                 layer_norm::Prepare, layer_norm::Eval};
+  return &r;
+}
+
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,98 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flexbuffers.h"  // TF:flatbuffers
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+namespace ops {
+namespace custom {
+
+TfLiteRegistration* Register_LAYER_NORM();
+
+namespace {
+
+using ::testing::ElementsAreArray;
+
+class LayerNormOpModel : public SingleOpModel {
+ public:
+  // gamma is quantized with a scale of 1/16 and beta with a scale of 1/1000.
+  LayerNormOpModel(const TensorData& input, std::initializer_list<int8_t> gamma,
+                   std::initializer_list<int32_t> beta,
+                   const TensorData& output) {
+    const int depth = gamma.size();
+    input_ = AddInput(input);
+    AddConstInput(TensorData{TensorType_INT8, {depth}, 0, 0, 1.0f / 16}, gamma);
+    AddConstInput(TensorData{TensorType_INT32, {depth}, 0, 0, 1.0f / 1000},
+                  beta);
+    output_ = AddOutput(output);
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() { fbb.Float("epsilon", 1e-12f); });
+    fbb.Finish();
+    SetCustomOp("TFLite_LayerNorm", fbb.GetBuffer(), Register_LAYER_NORM);
+
+    BuildInterpreter({GetShape(input_)});
+  }
+
+  int input() const { return input_; }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ private:
+  int input_;
+  int output_;
+};
+
+TEST(LayerNormOpTest, Int8) {
+  LayerNormOpModel m({TensorType_INT8, {2, 4}, -8, 8},
+                     /*gamma=*/{16, 32, 8, 16},
+                     /*beta=*/{100, -200, 0, 300},
+                     {TensorType_INT8, {}, -4, 4});
+  m.QuantizeAndPopulate<int8_t>(m.input(), {1, 2, 3, 4, -1, 0, 1, 6});
+  m.Invoke();
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({2, 4}));
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear(
+                  {
+                      -1.2416, -1.0944, 0.2236, 1.6416,  // row 1
+                      -0.8285, -1.3142, -0.0928, 1.9713,  // row 2
+                  },
+                  0.06)));
+}
+
+TEST(LayerNormOpTest, Int8ConstantRow) {
+  LayerNormOpModel m({TensorType_INT8, {1, 4}, -8, 8},
+                     /*gamma=*/{16, 16, 16, 16},
+                     /*beta=*/{100, -200, 0, 300},
+                     {TensorType_INT8, {}, -4, 4});
+  m.QuantizeAndPopulate<int8_t>(m.input(), {3, 3, 3, 3});
+  m.Invoke();
+  EXPECT_THAT(m.GetDequantizedOutput(),
+              ElementsAreArray(ArrayFloatNear({0.1, -0.2, 0, 0.3}, 0.03)));
+}
+
+}  // namespace
+}  // namespace custom
+}  // namespace ops
+}  // namespace tflite
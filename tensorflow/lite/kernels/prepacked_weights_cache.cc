@@ -0,0 +1,84 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/prepacked_weights_cache.h"
+
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace tflite {
+namespace prepacked_weights_cache {
+namespace {
+
+typedef std::tuple<const void*, size_t, std::vector<int>, std::string> Key;
+
+struct Cache {
+  std::mutex mutex;
+  std::map<Key, std::weak_ptr<const void>> entries;
+};
+
+Cache* GetCache() {
+  static Cache* cache = new Cache;
+  return cache;
+}
+
+// Forgets the entries whose packed weights were freed.
+void RemoveExpired(Cache* cache) {
+  for (auto it = cache->entries.begin(); it != cache->entries.end();) {
+    if (it->second.expired()) {
+      it = cache->entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<const void> GetOrPackRaw(
+    const TfLiteTensor* weights, const char* packing,
+    const std::function<std::shared_ptr<const void>()>& pack) {
+  std::vector<int> shape;
+  if (weights->dims != nullptr) {
+    shape.assign(weights->dims->data,
+                 weights->dims->data + weights->dims->size);
+  }
+  Key key(weights->data.raw_const, weights->bytes, std::move(shape), packing);
+
+  Cache* cache = GetCache();
+  // Packing under the lock keeps interpreters preparing the same model
+  // concurrently from packing the same weights more than once.
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  std::weak_ptr<const void>& entry = cache->entries[key];
+  std::shared_ptr<const void> packed = entry.lock();
+  if (packed == nullptr) {
+    packed = pack();
+    entry = packed;
+    RemoveExpired(cache);
+  }
+  return packed;
+}
+
+int NumEntries() {
+  Cache* cache = GetCache();
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  RemoveExpired(cache);
+  return cache->entries.size();
+}
+
+}  // namespace prepacked_weights_cache
+}  // namespace tflite
@@ -0,0 +1,62 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_PREPACKED_WEIGHTS_CACHE_H_
+#define TENSORFLOW_LITE_KERNELS_PREPACKED_WEIGHTS_CACHE_H_
+
+#include <functional>
+#include <memory>
+
+#include "tensorflow/lite/c/c_api_internal.h"
+
+namespace tflite {
+namespace prepacked_weights_cache {
+
+// Kernels which repack constant weights into another layout keep the packed
+// copy in the process-wide cache below instead of in each interpreter, so that
+// N interpreters running the same model hold the packed weights once.
+//
+// An entry is keyed by the address, size and shape of the constant weights in
+// the model buffer, plus a `packing` name chosen by the kernel, and is freed
+// when the last kernel holding it releases it. Since the interpreters never
+// outlive their model, the weights at an address do not change while an entry
+// for them is alive.
+
+// Type-erased version of GetOrPack() below.
+std::shared_ptr<const void> GetOrPackRaw(
+    const TfLiteTensor* weights, const char* packing,
+    const std::function<std::shared_ptr<const void>()>& pack);
+
+// Returns the `packing` of the constant `weights`, which `pack` makes on the
+// first call and which is shared with the other callers until all of them
+// release it. All the callers with the same `packing` must use the same `T`.
+template <typename T>
+std::shared_ptr<const T> GetOrPack(const TfLiteTensor* weights,
+                                   const char* packing,
+                                   const std::function<void(T*)>& pack) {
+  return std::static_pointer_cast<const T>(
+      GetOrPackRaw(weights, packing, [&pack]() {
+        std::shared_ptr<T> packed(new T);
+        pack(packed.get());
+        return std::shared_ptr<const void>(std::move(packed));
+      }));
+}
+
+// Returns the number of packed weights alive in the process.
+int NumEntries();
+
+}  // namespace prepacked_weights_cache
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_PREPACKED_WEIGHTS_CACHE_H_
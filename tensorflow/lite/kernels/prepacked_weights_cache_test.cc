@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/kernels/prepacked_weights_cache.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace prepacked_weights_cache {
+namespace {
+
+// A constant float tensor over `data` with the given shape.
+class ConstTensor {
+ public:
+  ConstTensor(const std::vector<float>& data, const std::vector<int>& shape)
+      : dims_(TfLiteIntArrayCreate(shape.size())) {
+    for (int i = 0; i < shape.size(); ++i) dims_->data[i] = shape[i];
+    tensor_.type = kTfLiteFloat32;
+    tensor_.allocation_type = kTfLiteMmapRo;
+    tensor_.data.raw_const = reinterpret_cast<const char*>(data.data());
+    tensor_.bytes = data.size() * sizeof(float);
+    tensor_.dims = dims_;
+  }
+  ~ConstTensor() { TfLiteIntArrayFree(dims_); }
+
+  const TfLiteTensor* get() const { return &tensor_; }
+
+ private:
+  TfLiteIntArray* dims_;
+  TfLiteTensor tensor_ = {};
+};
+
+// Packs the weights by doubling them, and counts the calls.
+std::shared_ptr<const std::vector<float>> Double(const TfLiteTensor* weights,
+                                                 int* num_packs,
+                                                 const char* packing = "x2") {
+  return GetOrPack<std::vector<float>>(
+      weights, packing, [weights, num_packs](std::vector<float>* packed) {
+        ++*num_packs;
+        const int size = weights->bytes / sizeof(float);
+        for (int i = 0; i < size; ++i) {
+          packed->push_back(2 * weights->data.f[i]);
+        }
+      });
+}
+
+TEST(PrepackedWeightsCacheTest, SharesPackedWeights) {
+  const std::vector<float> data = {1, 2, 3, 4};
+  ConstTensor weights(data, {2, 2});
+  // Another tensor of a second interpreter over the same model buffer.
+  ConstTensor same_weights(data, {2, 2});
+  int num_packs = 0;
+
+  auto packed = Double(weights.get(), &num_packs);
+  EXPECT_EQ(*packed, std::vector<float>({2, 4, 6, 8}));
+  auto shared = Double(same_weights.get(), &num_packs);
+  EXPECT_EQ(shared.get(), packed.get());
+  EXPECT_EQ(num_packs, 1);
+  EXPECT_EQ(NumEntries(), 1);
+}
+
+TEST(PrepackedWeightsCacheTest, FreesUnusedPackedWeights) {
+  const std::vector<float> data = {1, 2, 3, 4};
+  ConstTensor weights(data, {4});
+  int num_packs = 0;
+
+  auto packed = Double(weights.get(), &num_packs);
+  auto shared = Double(weights.get(), &num_packs);
+  packed.reset();
+  EXPECT_EQ(NumEntries(), 1);
+  shared.reset();
+  EXPECT_EQ(NumEntries(), 0);
+
+  Double(weights.get(), &num_packs);
+  EXPECT_EQ(num_packs, 2);
+}
+
+TEST(PrepackedWeightsCacheTest, DistinguishesWeightsAndPackings) {
+  const std::vector<float> data = {1, 2, 3, 4};
+  const std::vector<float> other_data = {1, 2, 3, 4};
+  ConstTensor weights(data, {2, 2});
+  ConstTensor reshaped(data, {4, 1});
+  ConstTensor other(other_data, {2, 2});
+  int num_packs = 0;
+
+  auto packed = Double(weights.get(), &num_packs);
+  auto packed_reshaped = Double(reshaped.get(), &num_packs);
+  auto packed_other = Double(other.get(), &num_packs);
+  auto packed_differently = Double(weights.get(), &num_packs, "other");
+  EXPECT_EQ(num_packs, 4);
+  EXPECT_EQ(NumEntries(), 4);
+}
+
+}  // namespace
+}  // namespace prepacked_weights_cache
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
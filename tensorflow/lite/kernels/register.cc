@@ -24,6 +24,8 @@ namespace custom {
 TfLiteRegistration* Register_AUDIO_SPECTROGRAM();
 TfLiteRegistration* Register_MFCC();
 TfLiteRegistration* Register_DETECTION_POSTPROCESS();
+TfLiteRegistration* Register_LAYER_NORM();
+TfLiteRegistration* Register_ATTENTION_SOFTMAX();
 
 }  // namespace custom
 
@@ -282,6 +284,9 @@ BuiltinOpResolver::BuiltinOpResolver() {
             tflite::ops::custom::Register_AUDIO_SPECTROGRAM());
   AddCustom("TFLite_Detection_PostProcess",
             tflite::ops::custom::Register_DETECTION_POSTPROCESS());
+  AddCustom("TFLite_LayerNorm", tflite::ops::custom::Register_LAYER_NORM());
+  AddCustom("TFLite_AttentionSoftmax",
+            tflite::ops::custom::Register_ATTENTION_SOFTMAX());
 }
 
 }  // namespace builtin
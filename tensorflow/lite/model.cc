@@ -22,6 +22,7 @@ limitations under the License.
 #include <sys/types.h>
 
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/arena_planner.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_internal.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
@@ -505,6 +506,33 @@ TfLiteStatus InterpreterBuilder::ParseTensors(
   return status;
 }
 
+TfLiteStatus InterpreterBuilder::ParseArenaPlans(Interpreter* interpreter) {
+  if (!model_->metadata()) return kTfLiteOk;
+
+  auto* buffers = model_->buffers();
+  for (int i = 0; i < model_->metadata()->size(); ++i) {
+    auto* metadata = model_->metadata()->Get(i);
+    if (!metadata->name() ||
+        metadata->name()->str() != kArenaPlanMetadataName) {
+      continue;
+    }
+    const flatbuffers::Vector<uint8_t>* data = nullptr;
+    if (metadata->buffer() < buffers->size()) {
+      data = (*buffers)[metadata->buffer()]->data();
+    }
+    int subgraph_index;
+    std::vector<ArenaAlloc> plan;
+    if (!data ||
+        !DecodeArenaPlan(data->data(), data->size(), &subgraph_index, &plan) ||
+        interpreter->subgraph(subgraph_index) == nullptr) {
+      error_reporter_->Report("Invalid arena plan in metadata %d.\n", i);
+      return kTfLiteError;
+    }
+    interpreter->subgraph(subgraph_index)->SetOfflineArenaPlan(std::move(plan));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus InterpreterBuilder::ApplyDelegates(Interpreter* interpreter) {
   // Apply Flex delegate if applicable.
   if (!has_flex_op_ || AcquireFlexDelegate == nullptr) {
@@ -612,6 +640,9 @@ TfLiteStatus InterpreterBuilder::operator()(
     modified_subgraph->SetVariables(std::move(variables));
   }
 
+  if (ParseArenaPlans(interpreter->get()) != kTfLiteOk)
+    return cleanup_and_error();
+
   if (ApplyDelegates(interpreter->get()) != kTfLiteOk)
     return cleanup_and_error();
 
@@ -0,0 +1,188 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/profiling/op_latency_summarizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+std::string GetOperatorName(const TfLiteRegistration& registration) {
+  if (registration.builtin_code == tflite::BuiltinOperator_CUSTOM) {
+    return registration.custom_name ? registration.custom_name
+                                    : "UnknownCustomOp";
+  }
+  return tflite::EnumNameBuiltinOperator(
+      static_cast<tflite::BuiltinOperator>(registration.builtin_code));
+}
+
+size_t GetArenaBytes(const tflite::Interpreter& interpreter,
+                     const TfLiteIntArray* tensor_indices) {
+  size_t bytes = 0;
+  for (int i = 0; i < tensor_indices->size; ++i) {
+    const TfLiteTensor* tensor = interpreter.tensor(tensor_indices->data[i]);
+    if (tensor != nullptr) bytes += tensor->bytes;
+  }
+  return bytes;
+}
+
+double Mean(const std::vector<int64_t>& values) {
+  if (values.empty()) return 0;
+  double sum = 0;
+  for (int64_t value : values) sum += value;
+  return sum / values.size();
+}
+
+std::string JsonString(const std::string& s) {
+  std::string escaped = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+}  // namespace
+
+void OpLatencySummarizer::ProcessProfiles(
+    const std::vector<const ProfileEvent*>& profile_events,
+    const tflite::Interpreter& interpreter, bool steady_state) {
+  for (const ProfileEvent* event : profile_events) {
+    // The operators run by a delegate kernel are accounted for by the
+    // delegate kernel itself.
+    if (event->event_type != Profiler::EventType::OPERATOR_INVOKE_EVENT ||
+        strcmp(event->tag, "DelegateOpInvoke") == 0 ||
+        event->end_timestamp_us < event->begin_timestamp_us) {
+      continue;
+    }
+    const auto key =
+        std::make_pair(event->event_subgraph_index, event->event_metadata);
+    const int64_t latency_us =
+        event->end_timestamp_us - event->begin_timestamp_us;
+    auto it = op_stats_.find(key);
+    if (it == op_stats_.end()) {
+      auto* subgraph = const_cast<tflite::Interpreter&>(interpreter).subgraph(
+          event->event_subgraph_index);
+      if (subgraph == nullptr) continue;
+      const auto* node_and_registration =
+          subgraph->node_and_registration(event->event_metadata);
+      if (node_and_registration == nullptr) continue;
+      OpStats stats;
+      stats.subgraph_index = key.first;
+      stats.node_index = key.second;
+      stats.name = GetOperatorName(node_and_registration->second);
+      const TfLiteNode& node = node_and_registration->first;
+      stats.footprint_bytes = GetArenaBytes(interpreter, node.outputs);
+      if (node.temporaries != nullptr) {
+        stats.footprint_bytes += GetArenaBytes(interpreter, node.temporaries);
+      }
+      stats.first_us = latency_us;
+      op_stats_.emplace(key, std::move(stats));
+    } else if (steady_state) {
+      it->second.steady_state_us.push_back(latency_us);
+    }
+  }
+}
+
+int64_t OpLatencySummarizer::Percentile(std::vector<int64_t> values,
+                                        double percentile) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  const int64_t rank =
+      static_cast<int64_t>(std::ceil(percentile / 100 * values.size()));
+  const int64_t index =
+      std::min<int64_t>(std::max<int64_t>(rank, 1), values.size()) - 1;
+  return values[index];
+}
+
+std::string OpLatencySummarizer::GetOutputString() const {
+  std::stringstream stream;
+  stream << "============== Operator latency (us) ==============\n"
+         << std::setw(24) << std::left << "[node type]" << std::right
+         << std::setw(10) << "[node]" << std::setw(10) << "[first]"
+         << std::setw(10) << "[count]" << std::setw(10) << "[avg]"
+         << std::setw(10) << "[p50]" << std::setw(10) << "[p90]"
+         << std::setw(10) << "[p99]" << std::setw(14) << "[bytes]" << "\n";
+  for (const auto& entry : op_stats_) {
+    const OpStats& stats = entry.second;
+    stream << std::setw(24) << std::left << stats.name << std::right
+           << std::setw(10)
+           << (std::to_string(stats.subgraph_index) + ":" +
+               std::to_string(stats.node_index))
+           << std::setw(10) << stats.first_us << std::setw(10)
+           << stats.steady_state_us.size() << std::setw(10) << std::fixed
+           << std::setprecision(1) << Mean(stats.steady_state_us)
+           << std::setw(10) << Percentile(stats.steady_state_us, 50)
+           << std::setw(10) << Percentile(stats.steady_state_us, 90)
+           << std::setw(10) << Percentile(stats.steady_state_us, 99)
+           << std::setw(14) << stats.footprint_bytes << "\n";
+  }
+  return stream.str();
+}
+
+std::string OpLatencySummarizer::GetCsv() const {
+  std::stringstream stream;
+  stream << "subgraph,node,op,footprint_bytes,first_us,count,avg_us,p50_us,"
+            "p90_us,p99_us\n";
+  for (const auto& entry : op_stats_) {
+    const OpStats& stats = entry.second;
+    stream << stats.subgraph_index << "," << stats.node_index << ","
+           << stats.name << "," << stats.footprint_bytes << ","
+           << stats.first_us << "," << stats.steady_state_us.size() << ","
+           << Mean(stats.steady_state_us) << ","
+           << Percentile(stats.steady_state_us, 50) << ","
+           << Percentile(stats.steady_state_us, 90) << ","
+           << Percentile(stats.steady_state_us, 99) << "\n";
+  }
+  return stream.str();
+}
+
+std::string OpLatencySummarizer::GetJson(
+    const ArenaSizeReport& arena_sizes) const {
+  std::stringstream stream;
+  stream << "{\"arena_bytes\": " << arena_sizes.arena_bytes
+         << ", \"persistent_arena_bytes\": "
+         << arena_sizes.persistent_arena_bytes << ", \"ops\": [";
+  bool first = true;
+  for (const auto& entry : op_stats_) {
+    const OpStats& stats = entry.second;
+    if (!first) stream << ", ";
+    first = false;
+    stream << "{\"subgraph\": " << stats.subgraph_index
+           << ", \"node\": " << stats.node_index
+           << ", \"op\": " << JsonString(stats.name)
+           << ", \"footprint_bytes\": " << stats.footprint_bytes
+           << ", \"first_us\": " << stats.first_us
+           << ", \"count\": " << stats.steady_state_us.size()
+           << ", \"avg_us\": " << Mean(stats.steady_state_us)
+           << ", \"p50_us\": " << Percentile(stats.steady_state_us, 50)
+           << ", \"p90_us\": " << Percentile(stats.steady_state_us, 90)
+           << ", \"p99_us\": " << Percentile(stats.steady_state_us, 99)
+           << "}";
+  }
+  stream << "]}\n";
+  return stream.str();
+}
+
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_PROFILING_OP_LATENCY_SUMMARIZER_H_
+#define TENSORFLOW_LITE_PROFILING_OP_LATENCY_SUMMARIZER_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/profiling/profile_buffer.h"
+
+namespace tflite {
+namespace profiling {
+
+// Keeps the latency of every invocation of every operator, to report per
+// operator the latency of its first (cold) invocation apart from the
+// percentiles of its steady-state invocations, for tracking regressions
+// across builds.
+class OpLatencySummarizer {
+ public:
+  struct OpStats {
+    uint32_t subgraph_index = 0;
+    uint32_t node_index = 0;
+    std::string name;
+    // The bytes of the outputs and temporaries of the operator.
+    size_t footprint_bytes = 0;
+    // The latency of the first invocation, or -1 if there was none.
+    int64_t first_us = -1;
+    std::vector<int64_t> steady_state_us;
+  };
+
+  // Records the operator invocations of one run. The first invocation of
+  // each operator is recorded as cold, whatever `steady_state` is; the others
+  // only if `steady_state` is true.
+  void ProcessProfiles(const std::vector<const ProfileEvent*>& profile_events,
+                       const tflite::Interpreter& interpreter,
+                       bool steady_state);
+
+  bool HasProfiles() const { return !op_stats_.empty(); }
+
+  // Keyed by subgraph and node index.
+  const std::map<std::pair<uint32_t, uint32_t>, OpStats>& op_stats() const {
+    return op_stats_;
+  }
+
+  // Returns the smallest value such that `percentile` percent of `values`
+  // are lower or equal, or 0 for no values.
+  static int64_t Percentile(std::vector<int64_t> values, double percentile);
+
+  // Returns a table of the operators, for logging.
+  std::string GetOutputString() const;
+
+  // Returns one line per operator, after a header line.
+  std::string GetCsv() const;
+
+  // Returns the operators along with the arena sizes.
+  std::string GetJson(const ArenaSizeReport& arena_sizes) const;
+
+ private:
+  std::map<std::pair<uint32_t, uint32_t>, OpStats> op_stats_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_OP_LATENCY_SUMMARIZER_H_
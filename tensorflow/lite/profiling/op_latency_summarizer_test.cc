@@ -0,0 +1,120 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/profiling/op_latency_summarizer.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+const char* kOpName = "SimpleOpEval";
+
+TfLiteStatus SimpleOpEval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteTensor* input1 = tflite::GetInput(context, node, /*index=*/0);
+  const TfLiteTensor* input2 = tflite::GetInput(context, node, /*index=*/1);
+  TfLiteTensor* output = GetOutput(context, node, /*index=*/0);
+  *output->data.i32 = *input1->data.i32 + *input2->data.i32;
+  return kTfLiteOk;
+}
+
+TfLiteRegistration* RegisterSimpleOp() {
+  static TfLiteRegistration registration = {
+      nullptr, nullptr, nullptr, SimpleOpEval, nullptr,
+      tflite::BuiltinOperator_CUSTOM, kOpName, 1};
+  return &registration;
+}
+
+class SimpleOpModel : public SingleOpModel {
+ public:
+  SimpleOpModel() {
+    int input1 = AddInput({TensorType_INT32, {1}});
+    int input2 = AddInput({TensorType_INT32, {1}});
+    AddOutput({TensorType_INT32, {}});
+    SetCustomOp(kOpName, {}, RegisterSimpleOp);
+    BuildInterpreter({GetShape(input1), GetShape(input2)});
+  }
+  tflite::Interpreter* GetInterpreter() { return interpreter_.get(); }
+};
+
+TEST(OpLatencySummarizerTest, Percentile) {
+  std::vector<int64_t> values;
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 50), 0);
+  for (int i = 100; i >= 1; --i) values.push_back(i);
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 0), 1);
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 50), 50);
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 90), 90);
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 99), 99);
+  EXPECT_EQ(OpLatencySummarizer::Percentile(values, 100), 100);
+  EXPECT_EQ(OpLatencySummarizer::Percentile({7}, 99), 7);
+}
+
+TEST(OpLatencySummarizerTest, SeparatesFirstRun) {
+  BufferedProfiler profiler(1024);
+  SimpleOpModel m;
+  auto interpreter = m.GetInterpreter();
+  interpreter->SetProfiler(&profiler);
+  OpLatencySummarizer summarizer;
+  EXPECT_FALSE(summarizer.HasProfiles());
+  for (int run = 0; run < 4; ++run) {
+    profiler.Reset();
+    profiler.StartProfiling();
+    m.Invoke();
+    profiler.StopProfiling();
+    summarizer.ProcessProfiles(profiler.GetProfileEvents(), *interpreter,
+                               /*steady_state=*/run > 1);
+  }
+
+  ASSERT_TRUE(summarizer.HasProfiles());
+  ASSERT_EQ(summarizer.op_stats().size(), 1);
+  const OpLatencySummarizer::OpStats& stats =
+      summarizer.op_stats().begin()->second;
+  EXPECT_EQ(stats.subgraph_index, 0);
+  EXPECT_EQ(stats.node_index, 0);
+  EXPECT_EQ(stats.name, kOpName);
+  EXPECT_EQ(stats.footprint_bytes, sizeof(int32_t));
+  EXPECT_GE(stats.first_us, 0);
+  // The second run is neither cold nor steady-state.
+  EXPECT_EQ(stats.steady_state_us.size(), 2);
+
+  EXPECT_NE(summarizer.GetOutputString().find(kOpName), std::string::npos);
+  const std::string csv = summarizer.GetCsv();
+  EXPECT_EQ(csv.find("subgraph,node,op,"), 0) << csv;
+  EXPECT_NE(csv.find("\n0,0,SimpleOpEval,4,"), std::string::npos) << csv;
+  ArenaSizeReport arena_sizes;
+  arena_sizes.arena_bytes = 64;
+  const std::string json = summarizer.GetJson(arena_sizes);
+  EXPECT_EQ(json.find("{\"arena_bytes\": 64, "), 0) << json;
+  EXPECT_NE(json.find("\"op\": \"SimpleOpEval\""), std::string::npos) << json;
+  EXPECT_NE(json.find("\"count\": 2"), std::string::npos) << json;
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  ::tflite::LogToStderr();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -80,6 +80,37 @@ TfLiteStatus SimpleMemoryArena::Allocate(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+bool SimpleMemoryArena::TryAllocateAt(size_t alignment, size_t offset,
+                                      size_t size, ArenaAlloc* new_alloc) {
+  if (alignment > arena_alignment_ || offset % alignment != 0) {
+    return false;
+  }
+
+  if (size == 0) {
+    new_alloc->offset = 0;
+    new_alloc->size = 0;
+    return true;
+  }
+
+  // Find the first alloc after `offset`, and check the gap before it.
+  size_t current_offset = 0;
+  auto it = allocs_.begin();
+  for (; it != allocs_.end() && it->offset < offset; ++it) {
+    current_offset = it->offset + it->size;
+  }
+  if (current_offset > offset ||
+      (it != allocs_.end() && offset + size > it->offset)) {
+    return false;
+  }
+
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+
+  new_alloc->offset = offset;
+  new_alloc->size = size;
+  allocs_.insert(it, *new_alloc);
+  return true;
+}
+
 TfLiteStatus SimpleMemoryArena::Deallocate(TfLiteContext* context,
                                            const ArenaAlloc& alloc) {
   if (alloc.size == 0) {
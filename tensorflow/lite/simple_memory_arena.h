@@ -55,8 +55,17 @@ class SimpleMemoryArena {
   TfLiteStatus Allocate(TfLiteContext* context, size_t alignment, size_t size,
                         ArenaAlloc* new_alloc);
 
+  // Allocates `size` bytes at `offset`, e.g. to follow an allocation plan
+  // computed ahead of time. Returns false, and leaves the arena unchanged, if
+  // `offset` is not aligned or the bytes overlap a live allocation.
+  bool TryAllocateAt(size_t alignment, size_t offset, size_t size,
+                     ArenaAlloc* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context, const ArenaAlloc& alloc);
 
+  // The number of bytes used by the allocations, at their peak.
+  size_t high_water_mark() const { return high_water_mark_; }
+
   inline size_t RequiredBufferSize() {
     // Add in a small amount of padding to reduce the chance of resize events
     // for small allocations.
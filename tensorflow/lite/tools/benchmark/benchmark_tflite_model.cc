@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdarg>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/op_latency_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
@@ -66,11 +68,17 @@ constexpr int kOpProfilingEnabledDefault = true;
 constexpr int kOpProfilingEnabledDefault = false;
 #endif
 
-// Dumps profiling events if profiling is enabled.
+// Dumps profiling events if profiling is enabled, and the latency of each
+// operator in the first run apart from its percentiles in the regular runs.
+// Writes the latter to `op_latency_file` if not empty, as JSON if the file
+// name ends with ".json" and as CSV otherwise.
 class ProfilingListener : public BenchmarkListener {
  public:
-  ProfilingListener(Interpreter* interpreter, uint32_t max_num_entries)
-      : interpreter_(interpreter), profiler_(max_num_entries) {
+  ProfilingListener(Interpreter* interpreter, uint32_t max_num_entries,
+                    const std::string& op_latency_file)
+      : interpreter_(interpreter),
+        profiler_(max_num_entries),
+        op_latency_file_(op_latency_file) {
     TFLITE_BENCHMARK_CHECK(interpreter);
     interpreter_->SetProfiler(&profiler_);
     profiler_.Reset();
@@ -84,9 +92,19 @@ class ProfilingListener : public BenchmarkListener {
   void OnBenchmarkEnd(const BenchmarkResults& results) override;
 
  private:
+  void WriteOpLatencyFile();
+
   Interpreter* interpreter_;
   profiling::BufferedProfiler profiler_;
   profiling::ProfileSummarizer summarizer_;
+  profiling::OpLatencySummarizer op_latency_summarizer_;
+  const std::string op_latency_file_;
+  // The events recorded since the listener was created, i.e. while
+  // allocating the tensors, were processed.
+  bool init_processed_ = false;
+  // The first run, which is a warmup run, was processed.
+  bool first_run_processed_ = false;
+  RunType run_type_ = WARMUP;
 };
 
 // Dumps gemmlowp profiling events if gemmlowp profiling is enabled.
@@ -99,12 +117,17 @@ class GemmlowpProfilingListener : public BenchmarkListener {
 
 void ProfilingListener::OnSingleRunStart(RunType run_type) {
   // Note: we have started profiling when this listener is created. In order
-  // not to count events during the WARMUP phase, we need to stop profiling and
-  // process already-recorded profile events when the WARMUP run starts and
-  // restart profiling at the REGULAR run.
-  if (run_type == WARMUP) {
-    OnSingleRunEnd();
-  } else if (run_type == REGULAR) {
+  // not to count events during the WARMUP phase in the summary, we need to
+  // stop profiling and process already-recorded profile events when the first
+  // run starts. Of the WARMUP runs, only the first one is profiled, for the
+  // latency of the operators on a cold start.
+  if (!init_processed_) {
+    profiler_.StopProfiling();
+    summarizer_.ProcessProfiles(profiler_.GetProfileEvents(), *interpreter_);
+    init_processed_ = true;
+  }
+  run_type_ = run_type;
+  if (run_type == REGULAR || !first_run_processed_) {
     profiler_.Reset();
     profiler_.StartProfiling();
   }
@@ -114,12 +137,46 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
   if (summarizer_.HasProfiles()) {
     TFLITE_LOG(INFO) << summarizer_.GetOutputString();
   }
+  if (op_latency_summarizer_.HasProfiles()) {
+    TFLITE_LOG(INFO) << op_latency_summarizer_.GetOutputString();
+    const ArenaSizeReport arena_sizes = interpreter_->GetArenaSizeReport();
+    TFLITE_LOG(INFO) << "Arena high-water mark (bytes): "
+                     << arena_sizes.arena_bytes << " (persistent: "
+                     << arena_sizes.persistent_arena_bytes << ")";
+    WriteOpLatencyFile();
+  }
 }
 
 void ProfilingListener::OnSingleRunEnd() {
-  profiler_.StopProfiling();
-  auto profile_events = profiler_.GetProfileEvents();
-  summarizer_.ProcessProfiles(profile_events, *interpreter_);
+  if (run_type_ == REGULAR) {
+    profiler_.StopProfiling();
+    auto profile_events = profiler_.GetProfileEvents();
+    summarizer_.ProcessProfiles(profile_events, *interpreter_);
+    op_latency_summarizer_.ProcessProfiles(profile_events, *interpreter_,
+                                           /*steady_state=*/true);
+  } else if (!first_run_processed_) {
+    profiler_.StopProfiling();
+    op_latency_summarizer_.ProcessProfiles(profiler_.GetProfileEvents(),
+                                           *interpreter_,
+                                           /*steady_state=*/false);
+    first_run_processed_ = true;
+  }
+}
+
+void ProfilingListener::WriteOpLatencyFile() {
+  if (op_latency_file_.empty()) return;
+  const std::string json_suffix = ".json";
+  const bool json =
+      op_latency_file_.size() >= json_suffix.size() &&
+      op_latency_file_.compare(op_latency_file_.size() - json_suffix.size(),
+                               json_suffix.size(), json_suffix) == 0;
+  std::ofstream file(op_latency_file_);
+  file << (json ? op_latency_summarizer_.GetJson(
+                      interpreter_->GetArenaSizeReport())
+                : op_latency_summarizer_.GetCsv());
+  if (!file) {
+    TFLITE_LOG(ERROR) << "Failed to write " << op_latency_file_;
+  }
 }
 
 void GemmlowpProfilingListener::OnBenchmarkStart(
@@ -276,6 +333,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
   default_params.AddParam("max_profiling_buffer_entries",
                           BenchmarkParam::Create<int32_t>(1024));
+  default_params.AddParam("op_latency_output_file",
+                          BenchmarkParam::Create<std::string>(""));
   return default_params;
 }
 
@@ -324,7 +383,11 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
                      "require delegate to run the entire graph"),
     CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
     CreateFlag<int32_t>("max_profiling_buffer_entries", &params_,
-                        "max profiling buffer entries")
+                        "max profiling buffer entries"),
+    CreateFlag<std::string>(
+        "op_latency_output_file", &params_,
+        "with op profiling, the file to write the latency percentiles of "
+        "each op to, as JSON if its name ends with .json and as CSV otherwise")
   };
 
   flags.insert(flags.end(), specific_flags.begin(), specific_flags.end());
@@ -376,6 +439,9 @@ void BenchmarkTfLiteModel::LogParams() {
   TFLITE_LOG(INFO) << "Max profiling buffer entries: ["
                    << params_.Get<int32_t>("max_profiling_buffer_entries")
                    << "]";
+  TFLITE_LOG(INFO) << "Op latency output file: ["
+                   << params_.Get<std::string>("op_latency_output_file")
+                   << "]";
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
@@ -614,7 +680,8 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   if (params_.Get<bool>("enable_op_profiling")) {
     profiling_listener_.reset(new ProfilingListener(
         interpreter_.get(),
-        params_.Get<int32_t>("max_profiling_buffer_entries")));
+        params_.Get<int32_t>("max_profiling_buffer_entries"),
+        params_.Get<std::string>("op_latency_output_file")));
     AddListener(profiling_listener_.get());
   }
 
@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/embed_arena_plan.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+
+namespace tflite {
+namespace optimize {
+
+TfLiteStatus EmbedArenaPlan(flatbuffers::FlatBufferBuilder* builder,
+                            const Model* input_model,
+                            const OpResolver& op_resolver,
+                            ErrorReporter* error_reporter) {
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(input_model, op_resolver, error_reporter)(
+          &interpreter) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
+    error_reporter->Report("Failed to allocate the tensors of the model.");
+    return kTfLiteError;
+  }
+
+  std::unique_ptr<ModelT> model;
+  model.reset(input_model->UnPack());
+
+  // Drop the plans of a previous run. Their buffers are left empty.
+  auto& metadata = model->metadata;
+  for (auto it = metadata.begin(); it != metadata.end();) {
+    if ((*it)->name == kArenaPlanMetadataName) {
+      model->buffers[(*it)->buffer]->data.clear();
+      it = metadata.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // The other subgraphs are allocated by control flow ops when they are
+  // prepared, and keep planning their arenas at runtime.
+  std::vector<ArenaAlloc> plan;
+  if (interpreter->primary_subgraph().GetArenaPlan(&plan) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  std::string data;
+  if (!EncodeArenaPlan(/*subgraph_index=*/0, plan, &data)) {
+    error_reporter->Report("The arena of the model is too large to plan.");
+    return kTfLiteError;
+  }
+  auto buffer = std::unique_ptr<BufferT>(new BufferT);
+  buffer->data.assign(data.begin(), data.end());
+  model->buffers.push_back(std::move(buffer));
+  auto entry = std::unique_ptr<MetadataT>(new MetadataT);
+  entry->name = kArenaPlanMetadataName;
+  entry->buffer = model->buffers.size() - 1;
+  metadata.push_back(std::move(entry));
+
+  flatbuffers::Offset<Model> output_model_location =
+      Model::Pack(*builder, model.get());
+  FinishModelBuffer(*builder, output_model_location);
+
+  return kTfLiteOk;
+}
+
+}  // namespace optimize
+}  // namespace tflite
@@ -0,0 +1,45 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_OPTIMIZE_EMBED_ARENA_PLAN_H_
+#define TENSORFLOW_LITE_TOOLS_OPTIMIZE_EMBED_ARENA_PLAN_H_
+
+#include "flatbuffers/flatbuffers.h"  // TF:flatbuffers
+#include "tensorflow/lite/context.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace optimize {
+
+// Allocates the tensors of input_model with the shapes in the model, and
+// populates the provided builder with the model and the resulting arena plan
+// of its primary subgraph, in the metadata named kArenaPlanMetadataName. The
+// interpreter then places the tensors at their planned offsets instead of
+// planning the arena again, as long as the shapes of the tensors do not
+// change. Fails for models with dynamic tensors.
+//
+// A tflite::Model can be obtained from the builder with:
+//   const uint8_t* buffer = builder->GetBufferPointer();
+//   tflite::Model* model = GetModel(buffer);
+TfLiteStatus EmbedArenaPlan(flatbuffers::FlatBufferBuilder* builder,
+                            const Model* input_model,
+                            const OpResolver& op_resolver,
+                            ErrorReporter* error_reporter);
+
+}  // namespace optimize
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_OPTIMIZE_EMBED_ARENA_PLAN_H_
@@ -0,0 +1,171 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/embed_arena_plan.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // TF:flatbuffers
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/lite/arena_planner.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/optimize/test_util.h"
+
+namespace {
+tensorflow::string* g_test_model_dir = nullptr;
+}  // namespace
+
+namespace tflite {
+namespace optimize {
+namespace {
+
+std::unique_ptr<FlatBufferModel> ReadTestModel() {
+  auto model_path = tensorflow::io::JoinPath(
+      *g_test_model_dir, internal::kConvModelWith0Plus10Weights);
+  return FlatBufferModel::BuildFromFile(model_path.c_str());
+}
+
+// Returns the arena plans in the metadata of `model`.
+std::vector<std::vector<ArenaAlloc>> GetArenaPlans(const Model* model) {
+  std::vector<std::vector<ArenaAlloc>> plans;
+  if (!model->metadata()) return plans;
+  for (const Metadata* metadata : *model->metadata()) {
+    if (metadata->name()->str() != kArenaPlanMetadataName) continue;
+    const auto* data = model->buffers()->Get(metadata->buffer())->data();
+    int subgraph_index;
+    std::vector<ArenaAlloc> plan;
+    EXPECT_TRUE(DecodeArenaPlan(data->data(), data->size(), &subgraph_index,
+                                &plan));
+    EXPECT_EQ(subgraph_index, 0);
+    plans.push_back(plan);
+  }
+  return plans;
+}
+
+std::vector<ArenaAlloc> AllocateAndGetArenaPlan(const Model* model) {
+  ops::builtin::BuiltinOpResolver resolver;
+  internal::FailOnErrorReporter error_reporter;
+  std::unique_ptr<Interpreter> interpreter;
+  EXPECT_EQ(InterpreterBuilder(model, resolver, &error_reporter)(&interpreter),
+            kTfLiteOk);
+  EXPECT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  std::vector<ArenaAlloc> plan;
+  EXPECT_EQ(interpreter->primary_subgraph().GetArenaPlan(&plan), kTfLiteOk);
+  return plan;
+}
+
+void ExpectSamePlan(const std::vector<ArenaAlloc>& a,
+                    const std::vector<ArenaAlloc>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].offset, b[i].offset) << "tensor " << i;
+    EXPECT_EQ(a[i].size, b[i].size) << "tensor " << i;
+  }
+}
+
+class EmbedArenaPlanTest : public testing::Test {
+ protected:
+  EmbedArenaPlanTest() {
+    input_model_ = ReadTestModel();
+    model_ = input_model_->GetModel();
+  }
+
+  // Embeds the plan of `model` and returns the output model.
+  const Model* Embed(const Model* model,
+                     flatbuffers::FlatBufferBuilder* builder) {
+    EXPECT_EQ(EmbedArenaPlan(builder, model, resolver_, &error_reporter_),
+              kTfLiteOk);
+    return GetModel(builder->GetBufferPointer());
+  }
+
+  std::unique_ptr<FlatBufferModel> input_model_;
+  const Model* model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+  internal::FailOnErrorReporter error_reporter_;
+};
+
+TEST_F(EmbedArenaPlanTest, EmbedsPlanOfPrimarySubgraph) {
+  flatbuffers::FlatBufferBuilder builder;
+  const Model* output_model = Embed(model_, &builder);
+
+  const std::vector<std::vector<ArenaAlloc>> plans =
+      GetArenaPlans(output_model);
+  ASSERT_EQ(plans.size(), 1);
+  const std::vector<ArenaAlloc> expected = AllocateAndGetArenaPlan(model_);
+  ExpectSamePlan(plans[0], expected);
+  // The interpreter of the output model follows the plan.
+  ExpectSamePlan(AllocateAndGetArenaPlan(output_model), expected);
+}
+
+TEST_F(EmbedArenaPlanTest, ReplacesPreviousPlan) {
+  flatbuffers::FlatBufferBuilder builder;
+  const Model* output_model = Embed(model_, &builder);
+  flatbuffers::FlatBufferBuilder second_builder;
+  const Model* second_output_model = Embed(output_model, &second_builder);
+
+  const std::vector<std::vector<ArenaAlloc>> plans =
+      GetArenaPlans(second_output_model);
+  ASSERT_EQ(plans.size(), 1);
+  ExpectSamePlan(plans[0], GetArenaPlans(output_model)[0]);
+}
+
+TEST_F(EmbedArenaPlanTest, IgnoresPlanAfterResize) {
+  flatbuffers::FlatBufferBuilder builder;
+  const Model* output_model = Embed(model_, &builder);
+
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(InterpreterBuilder(output_model, resolver_,
+                               &error_reporter_)(&interpreter),
+            kTfLiteOk);
+  const int input = interpreter->inputs()[0];
+  std::vector<int> dims(interpreter->tensor(input)->dims->data,
+                        interpreter->tensor(input)->dims->data +
+                            interpreter->tensor(input)->dims->size);
+  dims[0] *= 2;
+  ASSERT_EQ(interpreter->ResizeInputTensor(input, dims), kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  std::vector<ArenaAlloc> plan;
+  ASSERT_EQ(interpreter->primary_subgraph().GetArenaPlan(&plan), kTfLiteOk);
+  EXPECT_EQ(plan[input].size, 2 * GetArenaPlans(output_model)[0][input].size);
+}
+
+}  // namespace
+}  // namespace optimize
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  tensorflow::string model_file;
+  const std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("test_model_file", &model_file,
+                       "Path to test tflite model file."),
+  };
+
+  const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result) {
+    std::cerr << "Required test_model_file\n";
+    std::abort();
+  }
+  g_test_model_dir =
+      new tensorflow::string(tensorflow::io::Dirname(model_file));
+  ::tensorflow::port::InitMain(argv[0], &argc, &argv);
+  return RUN_ALL_TESTS();
+}
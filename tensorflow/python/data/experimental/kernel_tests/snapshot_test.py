@@ -258,6 +258,44 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase,
             reader_buffer_size=10))
     self.assertDatasetProduces(dataset2, expected, assert_items_equal=True)
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(compression=[
+              snapshot.COMPRESSION_NONE, snapshot.COMPRESSION_GZIP
+          ])))
+  def testReadSnapshotParallelDeterministicAfterWrite(self, compression):
+    self.setUpTFRecord(10, 1000)
+    filenames = self.test_filenames
+
+    expected = [
+        b"Record %d of file %d" % (r, f)  # pylint:disable=g-complex-comprehension
+        for f in range(0, 10)
+        for r in range(0, 1000)
+    ]
+
+    tmpdir = self.makeSnapshotDirectory()
+    dataset = core_readers._TFRecordDataset(filenames)
+    dataset = dataset.apply(
+        snapshot.snapshot(
+            tmpdir, compression=compression, shard_size_bytes=16 * 1024))
+    self.assertDatasetProduces(dataset, expected)
+
+    # remove the original files and try to read the data back only from
+    # snapshot in the order it was written.
+    self.removeTFRecords()
+
+    dataset2 = core_readers._TFRecordDataset(filenames)
+    dataset2 = dataset2.apply(
+        snapshot.snapshot(
+            tmpdir,
+            compression=compression,
+            shard_size_bytes=16 * 1024,
+            num_reader_threads=4,
+            reader_buffer_size=16,
+            deterministic_read=True))
+    self.assertDatasetProduces(dataset2, expected)
+
   @combinations.generate(
       combinations.times(
           test_base.default_test_combinations(),
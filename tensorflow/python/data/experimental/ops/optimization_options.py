@@ -108,7 +108,18 @@ class OptimizationOptions(options.OptionsBase):
       "When autotuning is enabled (through `autotune`), determines the CPU "
       "budget to use. Values greater than the number of schedulable CPU cores "
       "are allowed but may result in CPU contention. If None, defaults to the "
-      "number of schedulable CPU cores.")
+      "number of schedulable CPU cores, less the cores reserved by other "
+      "runtimes of the process.")
+
+  autotune_target_throughput = options.create_option(
+      name="autotune_target_throughput",
+      ty=float,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines the number "
+      "of elements per second which the input pipeline should produce. The "
+      "autotuning stops giving the pipeline more resources once the model "
+      "predicts that it meets the target. If None, the pipeline is tuned to "
+      "be as fast as possible.")
 
   filter_fusion = options.create_option(
       name="filter_fusion",
@@ -114,6 +114,12 @@ def parse_example_dataset(features, num_parallel_calls=1):
   `FixedLenFeature` is mapped to a `Tensor`. See `tf.io.parse_example` for more
   details about feature dictionaries.
 
+  Applied after `tf.data.Dataset.batch`, this parses each batch of serialized
+  protos in place, on ranges of examples in parallel, and writes the
+  `FixedLenFeature` values straight into the batched output tensors. This
+  avoids the copy of every parsed feature made by batching the output of
+  `tf.io.parse_single_example`.
+
   Args:
    features: A `dict` mapping feature keys to `FixedLenFeature`,
      `VarLenFeature`, `RaggedFeature`, and `SparseFeature` values.
@@ -45,7 +45,8 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
                num_writer_threads=None,
                writer_buffer_size=None,
                shuffle_on_read=None,
-               seed=None):
+               seed=None,
+               deterministic_read=None):
 
     self._compression = compression if compression is not None else ""
     self._reader_path_prefix = (
@@ -67,6 +68,8 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
         writer_buffer_size if writer_buffer_size is not None else -1)
     self._shuffle_on_read = (
         shuffle_on_read if shuffle_on_read is not None else False)
+    self._deterministic_read = (
+        deterministic_read if deterministic_read is not None else False)
 
     self._seed, self._seed2 = random_seed.get_seed(seed)
 
@@ -88,6 +91,7 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
         shuffle_on_read=self._shuffle_on_read,
         seed=self._seed,
         seed2=self._seed2,
+        deterministic_read=self._deterministic_read,
         **self._flat_structure)
     super(_SnapshotDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -103,7 +107,8 @@ def snapshot(path,
              num_writer_threads=None,
              writer_buffer_size=None,
              shuffle_on_read=None,
-             seed=None):
+             seed=None,
+             deterministic_read=None):
   """Writes to/reads from a snapshot of a dataset.
 
   This function attempts to determine whether a valid snapshot exists at the
@@ -128,10 +133,12 @@ def snapshot(path,
       Especially useful if compression is turned on since the decompression
       operation tends to be intensive. Defaults to 1. If > 1, then this might
       introduce non-determinism i.e. the order in which the elements are
-      read from the snapshot are different from the order they're written.
+      read from the snapshot are different from the order they're written,
+      unless `deterministic_read` is True.
     reader_buffer_size: Maximum number of elements we can prefetch reading from
-      the snapshot. Defaults to 1. Increasing this might improve performance
-      but will increase memory consumption.
+      the snapshot. The buffer is shared between the files read in parallel,
+      with at least one element for each file. Defaults to 1. Increasing this
+      might improve performance but will increase memory consumption.
     num_writer_threads: Number of threads to parallelize writing from snapshot.
       We'll open up `num_writer_threads` files and write to them in parallel.
       Especially useful if compression is turned on since the compression
@@ -145,6 +152,10 @@ def snapshot(path,
       produced when reading from a snapshot will be random. Defaults to False.
     seed: If seed is set, the random number generator is seeded by the given
       seed. Otherwise, it is seeded by a random seed.
+    deterministic_read: If this is True, then the files read in parallel by
+      `num_reader_threads` threads are consumed in order, so the elements are
+      produced in the same order as with a single reader thread. Defaults to
+      False, which produces the elements of whichever file is ready first.
   Returns:
     A `Dataset` transformation function, which can be passed to
     `tf.data.Dataset.apply`.
@@ -155,6 +166,7 @@ def snapshot(path,
                             writer_path_prefix, shard_size_bytes,
                             pending_snapshot_expiry_seconds, num_reader_threads,
                             reader_buffer_size, num_writer_threads,
-                            writer_buffer_size, shuffle_on_read, seed)
+                            writer_buffer_size, shuffle_on_read, seed,
+                            deterministic_read)
 
   return _apply_fn
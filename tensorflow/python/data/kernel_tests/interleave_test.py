@@ -284,6 +284,32 @@ class InterleaveTest(test_base.DatasetTestBase, parameterized.TestCase):
       actual_output.append(self.evaluate(get_next()))
     self.assertAllEqual(expected_output.sort(), actual_output.sort())
 
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(
+              input_values=[np.int64([4, 5, 6, 7])],
+              cycle_length=[2, 4],
+              block_length=[1, 3],
+              num_parallel_calls=[2, 4],
+              reorder_window=[1, 8, 100])))
+  def testReorderWindowInterleaveDataset(self, input_values, cycle_length,
+                                         block_length, num_parallel_calls,
+                                         reorder_window):
+    count = 2
+    dataset = dataset_ops.Dataset.from_tensor_slices(input_values).repeat(
+        count).interleave(
+            lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x),
+            cycle_length, block_length, num_parallel_calls)
+    options = dataset_ops.Options()
+    options.experimental_reorder_window = reorder_window
+    dataset = dataset.with_options(options)
+    expected_output = [
+        element for element in _interleave(
+            _repeat(input_values, count), cycle_length, block_length)
+    ]
+    self.assertDatasetProduces(dataset, expected_output)
+
   @combinations.generate(test_base.default_test_combinations())
   def testInterleaveMap(self):
     dataset = dataset_ops.Dataset.range(100)
@@ -383,6 +383,7 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
     autotune = True
     algorithm = AutotuneAlgorithm.HILL_CLIMB
     cpu_budget = 0  # Indicates that all CPU cores should be used.
+    target_throughput = 0  # Indicates that there is no target throughput.
     if options.experimental_optimization is not None:
       if options.experimental_optimization.autotune is False:  # pylint: disable=g-bool-id-comparison
         autotune = False
@@ -390,9 +391,14 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
         algorithm = options.experimental_optimization.autotune_algorithm
       if options.experimental_optimization.autotune_cpu_budget is not None:
         cpu_budget = options.experimental_optimization.autotune_cpu_budget
+      if (options.experimental_optimization.autotune_target_throughput
+          is not None):
+        target_throughput = (
+            options.experimental_optimization.autotune_target_throughput)
 
     if autotune:
-      dataset = _ModelDataset(dataset, algorithm, cpu_budget)
+      dataset = _ModelDataset(dataset, algorithm, cpu_budget,
+                              target_throughput)
 
     if options.experimental_stats and options.experimental_stats.aggregator:  # pylint: disable=line-too-long
       dataset = _SetStatsAggregatorDataset(  # pylint: disable=protected-access
@@ -2617,6 +2623,16 @@ class Options(options_lib.OptionsBase):
       "`tf.data.experimental.OptimizationOptions` for more details.",
       default_factory=optimization_options.OptimizationOptions)
 
+  experimental_reorder_window = options_lib.create_option(
+      name="experimental_reorder_window",
+      ty=int,
+      docstring="The number of results which a deterministic parallel "
+      "`interleave` may buffer across its cycle while one of its inputs lags "
+      "behind the others. The results are still returned in deterministic "
+      "order, but a slow input no longer stalls the other inputs once their "
+      "own prefetch buffers are full. If None, defaults to 0, which disables "
+      "it. Has no effect when `experimental_deterministic` is False.")
+
   experimental_slack = options_lib.create_option(
       name="experimental_slack",
       ty=bool,
@@ -2663,6 +2679,8 @@ class Options(options_lib.OptionsBase):
 
     if self.experimental_deterministic is False:
       result.append("make_sloppy")
+    elif self.experimental_reorder_window:
+      result.append("reorder_window")
     if self.experimental_stats and self.experimental_stats.latency_all_edges:
       result.append("latency_all_edges")
     if self.experimental_slack:
@@ -2684,6 +2702,10 @@ class Options(options_lib.OptionsBase):
       if num_devices is None:
         num_devices = 1
       result.append("slack:slack_period:%d" % num_devices)
+    if (self.experimental_deterministic is not False and
+        self.experimental_reorder_window):
+      result.append(
+          "reorder_window:window_size:%d" % self.experimental_reorder_window)
     return result
 
   def merge(self, options):
@@ -4155,22 +4177,23 @@ class _OptionsDataset(UnaryUnchangedStructureDataset):
 class _ModelDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, and models performance."""
 
-  def __init__(self, input_dataset, algorithm, cpu_budget):
+  def __init__(self, input_dataset, algorithm, cpu_budget,
+               target_throughput=0):
     self._input_dataset = input_dataset
     # TODO(jsimsa): This check is introduced for forward compatibility and can
     # be removed after 7/24/2019. At that point, all servers are expected to
     # recognize the `algorithm` attribute.
+    # The `target_throughput` attribute is only passed when it is set, for the
+    # same reason.
+    kwargs = {}
     if algorithm != AutotuneAlgorithm.HILL_CLIMB:
-      variant_tensor = gen_dataset_ops.model_dataset(
-          input_dataset._variant_tensor,  # pylint: disable=protected-access
-          algorithm=algorithm,
-          cpu_budget=cpu_budget,
-          **self._flat_structure)
-    else:
-      variant_tensor = gen_dataset_ops.model_dataset(
-          input_dataset._variant_tensor,  # pylint: disable=protected-access
-          cpu_budget=cpu_budget,
-          **self._flat_structure)
+      kwargs["algorithm"] = algorithm
+    if target_throughput:
+      kwargs["target_throughput"] = target_throughput
+    variant_tensor = gen_dataset_ops.model_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        cpu_budget=cpu_budget,
+        **dict(kwargs, **self._flat_structure))
     super(_ModelDataset, self).__init__(input_dataset, variant_tensor)
 
 
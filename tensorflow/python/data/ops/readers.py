@@ -202,15 +202,22 @@ class TextLineDatasetV1(dataset_ops.DatasetV1Adapter):
 class _TFRecordDataset(dataset_ops.DatasetSource):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               buffer_size=None,
+               read_ahead_requests=None):
     """Creates a `TFRecordDataset`.
 
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: (Optional.) A `tf.string` scalar evaluating to one of
-        `""` (no compression), `"ZLIB"`, or `"GZIP"`.
+        `""` (no compression), `"ZLIB"`, `"GZIP"`, or `"BLOCK_ZLIB"` (blocks
+        which are decompressed in parallel).
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      read_ahead_requests: (Optional.) A Python integer representing the number
+        of reads to issue ahead of the current record. 0 means no read ahead.
     """
     self._filenames = filenames
     self._compression_type = convert.optional_param_to_tensor(
@@ -222,9 +229,14 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         "buffer_size",
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
+    # The attribute is only passed when it is set, for forward compatibility.
+    kwargs = {}
+    if read_ahead_requests:
+      kwargs["read_ahead_requests"] = read_ahead_requests
     variant_tensor = gen_dataset_ops.tf_record_dataset(self._filenames,
                                                        self._compression_type,
-                                                       self._buffer_size)
+                                                       self._buffer_size,
+                                                       **kwargs)
     super(_TFRecordDataset, self).__init__(variant_tensor)
 
   @property
@@ -290,14 +302,16 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               read_ahead_requests=None):
     """Creates a `TFRecordDataset` to read one or more TFRecord files.
 
     Args:
       filenames: A `tf.string` tensor or `tf.data.Dataset` containing one or
         more filenames.
       compression_type: (Optional.) A `tf.string` scalar evaluating to one of
-        `""` (no compression), `"ZLIB"`, or `"GZIP"`.
+        `""` (no compression), `"ZLIB"`, `"GZIP"`, or `"BLOCK_ZLIB"` (blocks
+        which are decompressed in parallel).
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. If your input pipeline is I/O bottlenecked,
         consider setting this parameter to a value 1-100 MBs. If `None`, a
@@ -308,6 +322,12 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
         input pipeline is I/O bottlenecked, consider setting this parameter to a
         value greater than one to parallelize the I/O. If `None`, files will be
         read sequentially.
+      read_ahead_requests: (Optional.) A Python integer representing the number
+        of reads of `buffer_size` bytes each which are issued ahead of the
+        current record of each file, and run concurrently in the background.
+        Storage with deep request queues, such as NVMe drives, needs many reads
+        in flight to reach its full bandwidth. If `None`, each file is read
+        one buffer at a time.
 
     Raises:
       TypeError: If any argument does not have the expected type.
@@ -319,9 +339,11 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
     self._compression_type = compression_type
     self._buffer_size = buffer_size
     self._num_parallel_reads = num_parallel_reads
+    self._read_ahead_requests = read_ahead_requests
 
     def creator_fn(filename):
-      return _TFRecordDataset(filename, compression_type, buffer_size)
+      return _TFRecordDataset(filename, compression_type, buffer_size,
+                              read_ahead_requests)
 
     self._impl = _create_dataset_reader(creator_fn, filenames,
                                         num_parallel_reads)
@@ -332,11 +354,13 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             read_ahead_requests=None):
     return TFRecordDatasetV2(filenames or self._filenames, compression_type or
                              self._compression_type, buffer_size or
                              self._buffer_size, num_parallel_reads or
-                             self._num_parallel_reads)
+                             self._num_parallel_reads, read_ahead_requests or
+                             self._read_ahead_requests)
 
   def _inputs(self):
     return self._impl._inputs()  # pylint: disable=protected-access
@@ -354,9 +378,10 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               read_ahead_requests=None):
     wrapped = TFRecordDatasetV2(filenames, compression_type, buffer_size,
-                                num_parallel_reads)
+                                num_parallel_reads, read_ahead_requests)
     super(TFRecordDatasetV1, self).__init__(wrapped)
 
   __init__.__doc__ = TFRecordDatasetV2.__init__.__doc__
@@ -365,13 +390,15 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             read_ahead_requests=None):
     # pylint: disable=protected-access
     return TFRecordDatasetV1(
         filenames or self._dataset._filenames, compression_type or
         self._dataset._compression_type, buffer_size or
         self._dataset._buffer_size, num_parallel_reads or
-        self._dataset._num_parallel_reads)
+        self._dataset._num_parallel_reads, read_ahead_requests or
+        self._dataset._read_ahead_requests)
 
   @property
   def _filenames(self):
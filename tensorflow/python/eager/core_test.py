@@ -42,6 +42,7 @@ from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_resource_variable_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import nn_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import script_ops
@@ -587,6 +588,20 @@ class TFETest(test_util.TensorFlowTestCase):
       self.assertAllEqual(test_fn(test_var), 3.0)
     async_executor.wait()
 
+  def testPerDeviceExecutor(self):
+    per_device_executor = executor.new_executor(
+        enable_async=True, per_device_streams=True)
+    self.assertTrue(per_device_executor.is_async())
+    with context.executor_scope(per_device_executor):
+      with ops.device('cpu:0'):
+        x = constant_op.constant([[1., 2.], [3., 4.]])
+        y = math_ops.matmul(x, x)
+      # Consumes `y` on the stream of the GPU if there is one.
+      with ops.device(test_util.gpu_device_name() or 'cpu:0'):
+        z = math_ops.matmul(y, x)
+      self.assertAllEqual(z, [[37., 54.], [81., 118.]])
+    per_device_executor.wait()
+
   @test_util.run_gpu_only
   def testNumpyForceCPU(self):
     cpu = constant_op.constant([[1., 2.], [3., 4.]])
@@ -71,6 +71,21 @@ class Executor(object):
     pywrap_tensorflow.TFE_ExecutorClearError(self._handle)
 
 
-def new_executor(enable_async):
-  handle = pywrap_tensorflow.TFE_NewExecutor(enable_async)
+def new_executor(enable_async, per_device_streams=False):
+  """Creates a new `Executor`.
+
+  Args:
+    enable_async: Whether the ops are executed asynchronously.
+    per_device_streams: If True, the executor is asynchronous and executes the
+      ops of each device in sequence on a thread of its own, so that ops on
+      different devices (e.g. host preprocessing and copies to an accelerator)
+      execute in parallel. An op waits for its inputs produced on other devices.
+
+  Returns:
+    An `Executor`.
+  """
+  if per_device_streams:
+    handle = pywrap_tensorflow.TFE_NewPerDeviceExecutor()
+  else:
+    handle = pywrap_tensorflow.TFE_NewExecutor(enable_async)
   return Executor(handle)
@@ -67,8 +67,10 @@ from tensorflow.python.ipu import vertex_edsl
 from tensorflow.python.ipu.keras import layers
 
 from tensorflow.python.ipu.optimizers import cross_replica_optimizer
+from tensorflow.python.ipu.optimizers import dynamic_loss_scale_optimizer
 from tensorflow.python.ipu.optimizers import map_gradient_optimizer
 from tensorflow.python.ipu.optimizers import sharded_optimizer
+from tensorflow.python.ipu.optimizers import stochastic_rounding_optimizer
 from tensorflow.python.ipu.optimizers import gradient_accumulation_optimizer
 
 # Expose functional_ops.function as ipu.function
@@ -17,10 +17,22 @@ Dataset wrappers
 ~~~~~~~~~~~~~~~~
 """
 
+import multiprocessing
+import os
+import uuid
+import weakref
+
 from tensorflow.compiler.plugin.poplar.ops import gen_dataset_ops
+from tensorflow.python.client import session
+from tensorflow.python.data.experimental.ops import map_defun
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.eager import function
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import random_seed
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.util import nest
 
 
 class BufferDataset(dataset_ops.UnaryUnchangedStructureDataset):
@@ -43,3 +55,332 @@ class BufferDataset(dataset_ops.UnaryUnchangedStructureDataset):
         buffer_size=self._buffer_size,
         **self._flat_structure)
     super(BufferDataset, self).__init__(input_dataset, variant_tensor)
+
+
+class MappedCacheDataset(dataset_ops.UnaryUnchangedStructureDataset):
+  """A `Dataset` which caches the elements of its input in memory mapped files.
+
+  The first iteration writes each component of the elements into its own file
+  with a fixed stride, while passing the elements through. Later iterations,
+  including those of other processes on the same host, map these files and
+  return tensors which point straight into them, so the elements are not
+  deserialized or copied. The files can be read in any order, so the cache can
+  be read in a new random order in each epoch.
+
+  The elements must only contain numeric or boolean tensors with static shapes.
+  The cache is only used once it has been written completely, and it is not
+  invalidated when the input changes."""
+  def __init__(self, input_dataset, filename, shuffle=False, seed=None):
+    """A `Dataset` which caches the elements of its input in memory mapped
+    files.
+
+    Args:
+      input_dataset: The input dataset.
+      filename: The prefix of the files of the cache.
+      shuffle: Whether to read the cache in a new random order in each epoch.
+      seed: The seed of the random orders. Otherwise each order is random.
+    """
+    for spec in nest.flatten(input_dataset.element_spec):
+      if (not isinstance(spec, tensor_spec.TensorSpec)
+          or not spec.shape.is_fully_defined() or spec.dtype
+          in (dtypes.string, dtypes.variant, dtypes.resource)):
+        raise TypeError(
+            "MappedCacheDataset only supports elements of numeric or boolean "
+            "tensors with static shapes, but the dataset has an element of "
+            "{}.".format(spec))
+
+    self._input_dataset = input_dataset
+    self._filename = ops.convert_to_tensor(filename,
+                                           dtype=dtypes.string,
+                                           name="filename")
+    seed, seed2 = random_seed.get_seed(seed)
+    variant_tensor = gen_dataset_ops.ipu_mapped_cache_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        filename=self._filename,
+        shuffle=shuffle,
+        seed=seed or 0,
+        seed2=seed2 or 0,
+        **self._flat_structure)
+    super(MappedCacheDataset, self).__init__(input_dataset, variant_tensor)
+
+
+class SequencePackingDataset(dataset_ops.UnaryDataset):
+  """A `Dataset` which packs variable length sequences into samples of
+  `max_sequence_length`.
+
+  Each element of the input is a tuple of tensors which all have the length of
+  the sequence as their outer dimension. Each element of the output has the
+  packed and zero padded components of the input, followed by the `tf.int32`
+  segment ids (one for the first sequence of a pack, two for the second and so
+  on, zero for the padding) and the `tf.int32` position ids of each sequence."""
+  def __init__(self,
+               input_dataset,
+               max_sequence_length,
+               max_sequences_per_pack=None,
+               window_size=1024):
+    """A `Dataset` which packs variable length sequences into samples of
+      `max_sequence_length`.
+
+    Args:
+      input_dataset: The input dataset of sequences.
+      max_sequence_length: The length of the packed samples.
+      max_sequences_per_pack: The maximum number of sequences in each sample.
+        Defaults to `max_sequence_length`.
+      window_size: The number of sequences which are read from the input and
+        packed together. The sequences are packed in decreasing length order
+        into the first sample they fit in, so a larger window packs the
+        sequences more densely.
+    """
+    if max_sequences_per_pack is None:
+      max_sequences_per_pack = max_sequence_length
+    self._input_dataset = input_dataset
+    self._max_sequence_length = ops.convert_to_tensor(
+        max_sequence_length, dtype=dtypes.int64, name="max_sequence_length")
+    self._max_sequences_per_pack = ops.convert_to_tensor(
+        max_sequences_per_pack,
+        dtype=dtypes.int64,
+        name="max_sequences_per_pack")
+    self._window_size = ops.convert_to_tensor(window_size,
+                                              dtype=dtypes.int64,
+                                              name="window_size")
+
+    input_specs = input_dataset.element_spec
+    if isinstance(input_specs, tensor_spec.TensorSpec):
+      input_specs = (input_specs,)
+    packed_specs = tuple(
+        tensor_spec.TensorSpec([max_sequence_length] + spec.shape[1:],
+                               spec.dtype) for spec in input_specs)
+    ids_spec = tensor_spec.TensorSpec([max_sequence_length], dtypes.int32)
+    self._structure = packed_specs + (ids_spec, ids_spec)
+
+    variant_tensor = gen_dataset_ops.ipu_sequence_packing_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        max_sequence_length=self._max_sequence_length,
+        max_sequences_per_pack=self._max_sequences_per_pack,
+        window_size=self._window_size,
+        **self._flat_structure)
+    super(SequencePackingDataset, self).__init__(input_dataset,
+                                                 variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
+class RequestBatchDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of the batches of serving requests which are packed by a C++
+  `RequestBatcher`.
+
+  The batcher has to be registered under `batcher_name` by the serving front
+  end before the dataset is iterated. Each element is a tuple with a tensor per
+  input of the requests, with the batch size as the outer dimension. The
+  dataset ends when the batcher is closed."""
+  def __init__(self, batcher_name, output_types, output_shapes):
+    """A `Dataset` of the batches of serving requests.
+
+    Args:
+      batcher_name: The name the `RequestBatcher` was registered with.
+      output_types: A list of the types of the inputs of the requests, followed
+        by `tf.int32` when the batcher has allowed batch sizes.
+      output_shapes: A list of the shapes of the batches of each input,
+        including the batch size, followed by `[]` when the batcher has allowed
+        batch sizes.
+    """
+    self._structure = tuple(
+        tensor_spec.TensorSpec(tensor_shape.as_shape(shape), dtype)
+        for dtype, shape in zip(output_types, output_shapes))
+    variant_tensor = gen_dataset_ops.ipu_request_batch_dataset(
+        batcher_name=batcher_name, **self._flat_structure)
+    super(RequestBatchDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
+def _write_shared_memory_dataset(dataset_fn, num_workers, worker_index,
+                                 ring_buffer_name, num_slots, slot_size,
+                                 consumer_pid):
+  """Runs in a worker process: writes the shard `worker_index` of the dataset
+  returned by `dataset_fn` into the ring buffer `ring_buffer_name`."""
+  with ops.Graph().as_default():
+    dataset = dataset_fn().shard(num_workers, worker_index)
+    write_op = gen_dataset_ops.ipu_shared_memory_dataset_writer(
+        dataset._variant_tensor,  # pylint: disable=protected-access
+        ring_buffer_name=ring_buffer_name,
+        num_slots=num_slots,
+        slot_size=slot_size,
+        consumer_pid=consumer_pid)
+    with session.Session() as sess:
+      sess.run(write_op)
+
+
+def _stop_shared_memory_dataset_workers(workers, ring_buffer_names):
+  for worker in workers:
+    if worker.is_alive():
+      worker.terminate()
+    worker.join()
+  # A ring buffer is unlinked when it is opened, so only the ones which were
+  # never read are left behind.
+  for name in ring_buffer_names:
+    path = os.path.join("/dev/shm", name.lstrip("/"))
+    if os.path.exists(path):
+      os.remove(path)
+
+
+class SharedMemoryDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of the elements of a pipeline which is run by several worker
+  processes.
+
+  Each worker process runs the shard of the dataset returned by `dataset_fn`
+  with its own index, and writes the elements into a ring buffer in shared
+  memory. The elements are read from the workers in turn, so they come in the
+  same order as the elements of the unsharded dataset. Reading an element does
+  not copy it; its slot of the ring buffer is reused once the tensors of the
+  element have been released.
+
+  This moves the CPU cost of decoding and augmenting the data out of the
+  training process, which is useful when a single process can not feed the
+  IPUs fast enough. `dataset_fn` must be picklable, so it should be a function
+  defined at the top level of a module. The elements can only contain tensors
+  of numeric or boolean types, and the dataset can only be iterated once."""
+  def __init__(self,
+               dataset_fn,
+               num_workers,
+               num_slots=16,
+               slot_size=16 * 1024 * 1024,
+               startup_timeout_seconds=600.0):
+    """A `Dataset` of the elements of a pipeline which is run by several worker
+    processes.
+
+    Args:
+      dataset_fn: A function which takes no arguments and returns the
+        `tf.data.Dataset` to run in the workers.
+      num_workers: The number of worker processes.
+      num_slots: The number of elements which each worker can write ahead of
+        the training process.
+      slot_size: The size in bytes of a slot, which must hold the tensors of an
+        element, each aligned to 64 bytes.
+      startup_timeout_seconds: How long to wait for a worker to start writing
+        its elements.
+    """
+    if num_workers < 1:
+      raise ValueError("num_workers must be at least 1.")
+
+    # Build the dataset once to find the structure of its elements.
+    with ops.Graph().as_default():
+      self._structure = dataset_fn().element_spec
+    for spec in nest.flatten(self._structure):
+      if not isinstance(spec, tensor_spec.TensorSpec) or spec.dtype in (
+          dtypes.string, dtypes.variant, dtypes.resource):
+        raise TypeError(
+            "SharedMemoryDataset only supports elements of numeric or boolean "
+            "tensors, but the dataset has an element of {}.".format(spec))
+
+    prefix = "/ipu_shared_memory_dataset_{}_{}".format(os.getpid(),
+                                                       uuid.uuid4().hex)
+    ring_buffer_names = [
+        "{}_{}".format(prefix, i) for i in range(num_workers)
+    ]
+
+    # The workers are spawned rather than forked, as the TensorFlow runtime of
+    # this process can not be used in a forked child.
+    context = multiprocessing.get_context("spawn")
+    self._workers = []
+    for i, name in enumerate(ring_buffer_names):
+      worker = context.Process(target=_write_shared_memory_dataset,
+                               args=(dataset_fn, num_workers, i, name,
+                                     num_slots, slot_size, os.getpid()),
+                               daemon=True)
+      worker.start()
+      self._workers.append(worker)
+    weakref.finalize(self, _stop_shared_memory_dataset_workers,
+                     self._workers, ring_buffer_names)
+
+    variant_tensor = gen_dataset_ops.ipu_shared_memory_dataset(
+        ring_buffer_names=ring_buffer_names,
+        startup_timeout_seconds=startup_timeout_seconds,
+        **self._flat_structure)
+    super(SharedMemoryDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
+def vectorized_map(map_func,
+                   batch_size,
+                   num_parallel_calls=None,
+                   vectorizable=False):
+  """A transformation which maps `map_func` over batches of `batch_size`
+  elements instead of over each element.
+
+  Calling a small preprocessing function once per element costs more than the
+  work it does. This transformation batches the input, calls the function once
+  per batch and unbatches the result, so the elements and their order are the
+  same as those of `dataset.map(map_func)`.
+
+  When `vectorizable` is `True`, `map_func` is called with the batched tensors
+  directly, so it must treat the outer dimension as independent elements. When
+  it is `False`, `map_func` is run on each element of the batch inside a single
+  `MapDefun` op, which saves the cost of the dataset machinery for each element
+  but not the cost of the function call itself.
+
+  Args:
+    map_func: A function mapping an element of the input to an element of the
+      output, which can only contain dense tensors.
+    batch_size: The number of elements which are mapped together.
+    num_parallel_calls: The number of batches to map in parallel, as for
+      `tf.data.Dataset.map`.
+    vectorizable: Whether `map_func` can be called with batched tensors.
+
+  Returns:
+    A function which can be passed to `tf.data.Dataset.apply`.
+  """
+  def _apply_fn(dataset):
+    for spec in nest.flatten(dataset.element_spec):
+      if not isinstance(spec, tensor_spec.TensorSpec):
+        raise TypeError("vectorized_map only supports elements of dense "
+                        "tensors, but the dataset has an element of "
+                        "{}.".format(spec))
+
+    if vectorizable:
+      batched_func = map_func
+    else:
+      batched_func = _map_defun_func(map_func, dataset)
+
+    dataset = dataset.batch(batch_size)
+    dataset = dataset.map(batched_func, num_parallel_calls=num_parallel_calls)
+    return dataset.unbatch()
+
+  return _apply_fn
+
+
+def _map_defun_func(map_func, dataset):
+  """Wraps `map_func` into a function of a batch of elements of `dataset`,
+  which calls `map_func` on each element with a `MapDefun` op."""
+  input_structure = dataset.element_spec
+  output_structure = dataset_ops.StructuredFunctionWrapper(
+      map_func, "vectorized_map", dataset=dataset,
+      add_to_graph=False).output_structure
+  output_specs = nest.flatten(output_structure)
+  for spec in output_specs:
+    if not isinstance(spec, tensor_spec.TensorSpec):
+      raise TypeError("vectorized_map only supports functions which return "
+                      "dense tensors, but map_func returns {}.".format(spec))
+
+  @function.defun(input_signature=nest.flatten(input_structure))
+  def element_func(*flat_element):
+    element = nest.pack_sequence_as(input_structure, flat_element)
+    if type(element) is tuple:  # pylint: disable=unidiomatic-typecheck
+      return nest.flatten(map_func(*element))
+    return nest.flatten(map_func(element))
+
+  def batched_func(*batch):
+    flat_batch = nest.flatten(batch)
+    flat_outputs = map_defun.map_defun(
+        element_func, flat_batch, [spec.dtype for spec in output_specs],
+        [spec.shape for spec in output_specs])
+    return nest.pack_sequence_as(output_structure, flat_outputs)
+
+  return batched_func
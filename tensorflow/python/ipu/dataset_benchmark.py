@@ -18,8 +18,13 @@ Dataset benchmarking
 """
 
 from tensorflow.compiler.plugin.poplar.ops import gen_dataset_benchmark
+from tensorflow.python.ipu import ipu_compiler
 from tensorflow.python.ipu import ipu_infeed_queue
+from tensorflow.python.ipu import loops
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.util import nest
 
 
 def dataset_benchmark(dataset,
@@ -124,3 +129,78 @@ def infeed_benchmark(infeed_queue,
       elements_per_epochs,
       print_stats=print_stats,
       apply_options=apply_options)
+
+
+def infeed_device_benchmark(infeed_queue, elements_per_run):
+  """Allows the user to benchmark performance of an
+    `ipu.ipu_infeed_queue.IPUInfeedQueue` when it is consumed by an IPU.
+
+    Unlike :py:func:`infeed_benchmark`, this runs a minimal program on the IPU
+    which dequeues `elements_per_run` elements from the infeed queue, so that
+    the dataset iterator, the infeed queues, the stream callbacks and the host
+    to device transfers are all exercised. The statistics show which of these
+    stages limits the throughput of the infeed.
+
+    The `initializer` of the infeed queue must be run before the returned
+    tensor. The statistics accumulate over all the elements dequeued since the
+    infeed queue was initialized.
+
+    Args:
+      infeed_queue: An instance of `ipu.ipu_infeed_queue.IPUInfeedQueue` which
+        will be benchmarked.
+      elements_per_run: The number of elements dequeued by the IPU each time
+        the returned tensor is evaluated.
+
+    Returns:
+      A scalar string tensor which, when evaluated, runs the program and
+      returns a JSON string with performance statistics. It records the
+      following metrics for each stage:
+        * `producer` - the number of elements produced by the dataset, the
+          time spent in the dataset iterator, and the elements produced per
+          second both within the iterator and over the whole run.
+        * `queue` - a histogram of the number of elements in the infeed queues
+          each time a stream callback ran. Each bucket holds the number of
+          samples with at least `min_elements` elements, and fewer than the
+          `min_elements` of the next bucket. It also has the counters of the
+          queues, summed over all the tensors and replicas: the number of
+          elements pushed and popped, the time (in microseconds) the host
+          waited because the queues were full, the time the callbacks waited
+          because they were empty, and the largest number of elements in any
+          of the queues.
+        * `callbacks` - the number and average and maximum latency (in
+          microseconds) of the prefetch and fetch callbacks, and the number of
+          prefetches for which no element was available. Fetches block until
+          an element is available.
+        * `transfer` - the number of bytes copied for the device, the time
+          between the first and the last copy, and the bandwidth achieved,
+          measured in GB/s.
+
+    The JSON string returned can be parsed into a native Python JSON library
+    (see https://docs.python.org/3/library/json.html).
+
+    Raises:
+      TypeError: if `infeed_queue` is not an instance of
+        `ipu.ipu_infeed_queue.IPUInfeedQueue`.
+      ValueError: if `elements_per_run` is less than 1.
+    """
+  if not isinstance(infeed_queue, ipu_infeed_queue.IPUInfeedQueue):
+    raise TypeError("Expected `infeed_queue` argument to be of type "
+                    "`ipu.ipu_infeed_queue.IPUInfeedQueue`, but got %s "
+                    "instead." % (str(infeed_queue)))
+  if elements_per_run < 1:
+    raise ValueError("Expected `elements_per_run` to be at least 1.")
+
+  def body(total, *args, **kwargs):
+    # Use every dequeued tensor so that none of the transfers are removed.
+    for tensor in nest.flatten([args, kwargs]):
+      total += math_ops.reduce_sum(math_ops.cast(tensor, total.dtype))
+    return total
+
+  def benchmark_program():
+    return loops.repeat(elements_per_run, body, [0.0], infeed_queue)
+
+  with ops.device("/device:IPU:%d" % infeed_queue._device_ordinal):  # pylint: disable=protected-access
+    run = ipu_compiler.compile(benchmark_program, [])
+
+  with ops.control_dependencies(run):
+    return infeed_queue.statistics
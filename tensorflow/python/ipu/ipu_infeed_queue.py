@@ -17,12 +17,63 @@ Infeed queue
 ~~~~~~~~~~~~
 """
 
+import numpy as np
+
 from tensorflow.compiler.plugin.poplar.ops import gen_pop_datastream_ops
 from tensorflow.python.eager import context
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
 from tensorflow.python.data.util import structure
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.ipu import loops
+from tensorflow.python.ops import math_ops
+
+
+class InfeedNormalization:
+  """Describes how an integer element of an infeed is normalized on the IPU.
+
+  Image datasets are usually cast to floating point and normalized on the host,
+  which transfers 2 to 4 times as many bytes to the device as the raw pixels.
+  Instead, the dataset can provide the raw `uint8` pixels, which the IPU
+  converts with `(cast(x, dtype) - mean) * scale` when they are dequeued. The
+  conversion is a single element-wise expression on the device.
+
+  For example, to normalize the channels of images:
+
+  .. code-block:: python
+
+    normalization = ipu.ipu_infeed_queue.InfeedNormalization(
+        mean=[123.68, 116.78, 103.94], scale=1. / 255.)
+    infeed_queue = ipu.ipu_infeed_queue.IPUInfeedQueue(
+        dataset, feed_name="images", normalization=(normalization, None))
+  """
+  def __init__(self, mean=0., scale=1., dtype=dtypes.float16):
+    """Creates an InfeedNormalization object.
+
+    Args:
+      mean: the value subtracted from the element after the cast, either a
+        scalar or an array which is broadcast against the element, e.g. the
+        per-channel means of images in NHWC format.
+      scale: the value the difference is multiplied by, with the same
+        broadcasting as `mean`.
+      dtype: the floating point type the element is cast to.
+    """
+    self._dtype = dtypes.as_dtype(dtype)
+    if not self._dtype.is_floating:
+      raise ValueError(
+          "InfeedNormalization dtype must be a floating point type, but it "
+          "is {}".format(self._dtype.name))
+    self._mean = np.asarray(mean, dtype=self._dtype.as_numpy_dtype)
+    self._scale = np.asarray(scale, dtype=self._dtype.as_numpy_dtype)
+
+  @property
+  def dtype(self):
+    return self._dtype
+
+  def __call__(self, x):
+    x = math_ops.cast(x, self._dtype)
+    return (x - self._mean) * self._scale
 
 
 class IPUInfeedQueue:
@@ -93,7 +144,9 @@ class IPUInfeedQueue:
                device_ordinal=0,
                replication_factor=1,
                data_to_prefetch=1,
-               prefetch_depth=None):
+               prefetch_depth=None,
+               max_prefetch_depth=None,
+               normalization=None):
     """Creates an IPUInfeedQueue object.
 
     Args:
@@ -128,6 +181,19 @@ class IPUInfeedQueue:
           allows for prefetching of multiple entries, increasing the probability
           there will be a valid entry in the buffer for the device to read
           before falling back to synchronously fetching the next entry.
+          The depth of the queues which buffer the elements on the host is
+          chosen from the `prefetch_depth` and the `data_to_prefetch`.
+        max_prefetch_depth: When set, the `prefetch_depth` is autotuned during
+          the first executions of the graph, up to this value. It is doubled
+          while the device spends a significant part of the executions waiting
+          for the infeed. As the prefetch depth is compiled into the graph, the
+          tuned value is used when a graph with the infeed is compiled again.
+          See `ipu.utils.set_feed_autotuning_options`.
+        normalization: an `InfeedNormalization`, or a nested structure
+          matching the elements of the dataset with an `InfeedNormalization`
+          for each element to normalize on the IPU and `None` for the others.
+          The elements to normalize must have an integer type, and are
+          transferred in that type, e.g. `uint8` for image pixels.
 
     Raises:
       ValueError: if all dimensions of shapes of dataset.output_shapes are not
@@ -152,14 +218,30 @@ tf.Dataset.batch, set `drop_remainder=True`.""".format(output_shape))
       raise ValueError(
           "prefetch_depth must be less than 256, but it is {}".format(
               prefetch_depth))
+    if max_prefetch_depth is not None and (max_prefetch_depth < prefetch_depth
+                                           or max_prefetch_depth > 255):
+      raise ValueError(
+          "max_prefetch_depth must be at least prefetch_depth and less than "
+          "256, but it is {}".format(max_prefetch_depth))
 
     with ops.device('/device:CPU:0'):
       self._replication_factor = replication_factor
       self._dataset = dataset
       self._structure = dataset_ops.get_structure(self._dataset)
+      self._normalization = None
+      if normalization is not None:
+        self._normalization = nest.flatten_up_to(self._structure,
+                                                 normalization)
+        for spec, n in zip(nest.flatten(self._structure),
+                           self._normalization):
+          if n is not None and not spec.dtype.is_integer:
+            raise ValueError(
+                "Only integer elements of an infeed can be normalized, but "
+                "the element {} has type {}.".format(spec, spec.dtype.name))
       self._flat_structure = dataset._flat_structure
       self._device_ordinal = device_ordinal
       self._prefetch_depth = prefetch_depth
+      self._max_prefetch_depth = max_prefetch_depth or 0
 
       # We use max to clamp 0/1 to the same value.
       self._io_batch_size = max(1, data_to_prefetch)
@@ -196,6 +278,8 @@ tf.Dataset.batch, set `drop_remainder=True`.""".format(output_shape))
               input_dataset=ds_variant,
               feed_id=self._id,
               replication_factor=self._replication_factor,
+              io_batch_size=self._io_batch_size,
+              prefetch_depth=self._prefetch_depth,
               device_ordinal=self._device_ordinal,
               **self._dataset._flat_structure)  # pylint: disable=protected-access
 
@@ -220,9 +304,16 @@ tf.Dataset.batch, set `drop_remainder=True`.""".format(output_shape))
         replication_factor=self._replication_factor,
         io_batch_size=self._io_batch_size,
         prefetch_depth=self._prefetch_depth,
+        max_prefetch_depth=self._max_prefetch_depth,
         **self._flat_structure)
     self._dequeued = True
-    return structure.from_tensor_list(self._structure, flat_ret)
+    ret = structure.from_tensor_list(self._structure, flat_ret)
+    if self._normalization:
+      ret = nest.pack_sequence_as(ret, [
+          n(t) if n is not None else t
+          for t, n in zip(nest.flatten(ret), self._normalization)
+      ])
+    return ret
 
   @property
   def dequeued(self):
@@ -260,6 +351,8 @@ tf.Dataset.batch, set `drop_remainder=True`.""".format(output_shape))
             input_dataset=ds_variant,
             feed_id=self._id,
             replication_factor=self._replication_factor,
+            io_batch_size=self._io_batch_size,
+            prefetch_depth=self._prefetch_depth,
             device_ordinal=self._device_ordinal,
             **self._dataset._flat_structure)  # pylint: disable=protected-access
 
@@ -285,6 +378,19 @@ tf.Dataset.batch, set `drop_remainder=True`.""".format(output_shape))
 
     return self._deleter
 
+  @property
+  def statistics(self):
+    """A `tf.Tensor` with the statistics of each stage of this IPUInfeedQueue
+    as a JSON string. See
+    :py:func:`tensorflow.python.ipu.dataset_benchmark.infeed_device_benchmark`
+    for a description of the statistics.
+
+    Returns:
+      A scalar string `tf.Tensor`.
+    """
+    return gen_pop_datastream_ops.ipu_infeed_statistics(
+        feed_id=self._id, device_ordinal=self._device_ordinal)
+
   def get_next(self):
     """Obsolete function."""
     raise ValueError("""`get_next()` is now obsolete as the IPUInfeedQueue is \
@@ -42,6 +42,42 @@ class IPUOutfeedMode(Enum):
   LAST = "get_last"
 
 
+class IPUOutfeedReduction(Enum):
+  """Types used to control how the elements of an IPUOutfeedQueue batch are
+  reduced on the device.
+
+  Contains the following values:
+
+  * `NONE` - All the elements of a batch are sent to the host.
+  * `SUM` - The sum of the elements of a batch is sent to the host.
+  * `MEAN` - The mean of the elements of a batch is sent to the host. Only
+    floating point tensors are supported.
+  * `MAX` - The maximum of the elements of a batch is sent to the host.
+
+  """
+  NONE = "none"
+  SUM = "sum"
+  MEAN = "mean"
+  MAX = "max"
+
+
+class IPUOutfeedFileFormat(Enum):
+  """Types used to control the format of the files an IPUOutfeedQueue writes
+  its elements to.
+
+  Contains the following values:
+
+  * `TFRECORD` - TFRecord files with one record per tensor of each element,
+    containing the serialized `TensorProto` of the tensor. The records can be
+    read with a `tf.data.TFRecordDataset` and parsed with `tf.io.parse_tensor`.
+  * `RAW` - Files with the bytes of the tensors of each element concatenated,
+    which can be read with `numpy.fromfile`.
+
+  """
+  TFRECORD = "tfrecord"
+  RAW = "raw"
+
+
 class IPUOutfeedQueue:
   """Generates and adds outfeed enqueue/dequeue operations to the graph.
 
@@ -56,6 +92,11 @@ class IPUOutfeedQueue:
 
   In outfeed last mode only the last enqueued element is stored. The dequeue
   operation will in this case return a single element.
+
+  In outfeed all mode the elements can instead be written to files on the
+  host by a background thread, without being dequeued in Python, by setting a
+  `file_sink_prefix`. This is useful when the elements are produced faster
+  than Python can write them, for instance when running predictions.
   """
   @deprecation.deprecated_args(None, "Use outfeed_mode instead.",
                                "outfeed_all")
@@ -65,7 +106,13 @@ class IPUOutfeedQueue:
                outfeed_all=None,
                device_ordinal=0,
                replication_factor=1,
-               io_batch_size=1):
+               io_batch_size=1,
+               reduction=None,
+               transfer_as_fp16=False,
+               max_io_batch_size=None,
+               file_sink_prefix=None,
+               file_sink_format=None,
+               file_sink_elements_per_file=0):
     """Creates an IPUOutfeedQueue object.
 
     Args:
@@ -85,6 +132,35 @@ class IPUOutfeedQueue:
           device->host communication at the expense of needing to store the
           tensors on the device, and the extra computation required to operate
           the batching.
+        reduction: `ipu_outfeed_queue.IPUOutfeedReduction` type used to reduce
+          the `io_batch_size` elements of each batch on the device, so that a
+          single element is sent to the host for each batch. This is useful
+          for scalar metrics which would otherwise be averaged on the host. If
+          not specified then all the elements are sent to the host.
+        transfer_as_fp16: When set to true, float32 tensors are sent to the
+          host as float16 tensors, halving the amount of device->host
+          communication at the expense of precision. They are converted back
+          to float32 on the host.
+        max_io_batch_size: When set, the `io_batch_size` is autotuned during
+          the first executions of the graph, up to this value. It is doubled
+          while the device spends a significant part of the executions waiting
+          for the host to read the outfeed. As the io batch size is compiled into
+          the graph, the tuned value is used when a graph with the outfeed is
+          compiled again. The number of elements enqueued by each execution
+          should be a multiple of `max_io_batch_size`. It can not be used with
+          a `reduction`. See
+          `ipu.utils.set_feed_autotuning_options`.
+        file_sink_prefix: When set, the elements are written to files on the
+          host named `<file_sink_prefix>-<index>.tfrecord`, or `.bin` for raw
+          files, and the outfeed can not be dequeued. Each element is
+          written as one record per tensor, in the order of the enqueued
+          tuple or dictionary. The files are complete once the
+          execution of the graph has finished. Only supported when all the
+          elements are outfed.
+        file_sink_format: `ipu_outfeed_queue.IPUOutfeedFileFormat` type used to
+          choose the format of the files. Defaults to TFRecord files.
+        file_sink_elements_per_file: The number of elements in each file. When
+          zero, all the elements are written to a single file.
 
     Raises:
       ValueError: if the types or values are incorrect
@@ -108,6 +184,39 @@ class IPUOutfeedQueue:
                        "`ipu_outfeed_queue.IPUOutfeedMode` type, but is %s." %
                        (str(type(outfeed_mode))))
 
+    self._reduction = reduction or IPUOutfeedReduction.NONE
+
+    if not isinstance(self._reduction, IPUOutfeedReduction):
+      raise ValueError("Expected `reduction` value to be of "
+                       "`ipu_outfeed_queue.IPUOutfeedReduction` type, but is "
+                       "%s." % (str(type(reduction))))
+
+    if not isinstance(transfer_as_fp16, bool):
+      raise ValueError("Expected value True or False for transfer_as_fp16")
+
+    if max_io_batch_size is not None and max_io_batch_size < max(
+        1, io_batch_size):
+      raise ValueError("max_io_batch_size must be at least io_batch_size, but "
+                       "it is {}".format(max_io_batch_size))
+
+    if max_io_batch_size and self._reduction != IPUOutfeedReduction.NONE:
+      raise ValueError("max_io_batch_size can not be used with a reduction, "
+                       "as the io_batch_size changes the reduced values")
+
+    self._file_sink_format = file_sink_format or IPUOutfeedFileFormat.TFRECORD
+
+    if not isinstance(self._file_sink_format, IPUOutfeedFileFormat):
+      raise ValueError("Expected `file_sink_format` value to be of "
+                       "`ipu_outfeed_queue.IPUOutfeedFileFormat` type, but is "
+                       "%s." % (str(type(file_sink_format))))
+
+    if file_sink_prefix and self._outfeed_mode != IPUOutfeedMode.ALL:
+      raise ValueError("file_sink_prefix can only be used when all the "
+                       "elements are outfed")
+
+    if file_sink_elements_per_file < 0:
+      raise ValueError("file_sink_elements_per_file must be >= 0")
+
     if not isinstance(device_ordinal, int):
       raise ValueError('Device ordinal must be an integer')
 
@@ -121,6 +230,10 @@ class IPUOutfeedQueue:
     self._device_ordinal = device_ordinal
     self._replication_factor = replication_factor
     self._io_batch_size = max(1, io_batch_size)
+    self._transfer_as_fp16 = transfer_as_fp16
+    self._max_io_batch_size = max_io_batch_size or 0
+    self._file_sink_prefix = file_sink_prefix or ""
+    self._file_sink_elements_per_file = file_sink_elements_per_file
     self._feed_name = str(feed_name)
 
     self._operations = []
@@ -213,7 +326,13 @@ class IPUOutfeedQueue:
           outfeed_mode=self._outfeed_mode.value,
           feed_id=self._feed_name,
           replication_factor=self._replication_factor,
-          io_batch_size=self._io_batch_size)
+          io_batch_size=self._io_batch_size,
+          reduction=self._reduction.value,
+          transfer_as_fp16=self._transfer_as_fp16,
+          max_io_batch_size=self._max_io_batch_size,
+          file_sink_prefix=self._file_sink_prefix,
+          file_sink_format=self._file_sink_format.value,
+          file_sink_elements_per_file=self._file_sink_elements_per_file)
 
     self._operations.append(outfeed_op)
     return outfeed_op
@@ -375,6 +494,9 @@ class IPUOutfeedQueue:
     if not self.enqueued:
       raise ValueError(
           "Trying to dequeue an outfeed which has not been enqueued.")
+    if self._file_sink_prefix:
+      raise ValueError("Trying to dequeue an outfeed whose elements are "
+                       "written to files.")
     with ops.device('cpu'):
       outfeed_dequeue = \
         gen_pop_datastream_ops.pop_datastream_outfeed_dequeue(
@@ -400,6 +522,25 @@ class IPUOutfeedQueue:
     return gen_pop_datastream_ops.ipu_delete_outfeed(
         feed_id=self._feed_name, device_ordinal=self._device_ordinal)
 
+  @property
+  def statistics(self):
+    """A `tf.Tensor` with the counters of the queues of this IPUOutfeedQueue
+    as a JSON string. The counters are summed over the queues of all the
+    tensors and replicas, since the outfeed was created:
+      * `push_count` and `pop_count` - the number of elements pushed by the
+        device callbacks and popped by the host.
+      * `push_blocked_us` - the time the device callbacks waited for space
+        because the host was not dequeuing the elements fast enough.
+      * `pop_blocked_us` - the time the host waited for an element.
+      * `high_water_mark` - the largest number of elements in any of the
+        queues.
+
+    Returns:
+      A scalar string `tf.Tensor`.
+    """
+    return gen_pop_datastream_ops.ipu_outfeed_statistics(
+        feed_id=self._feed_name, device_ordinal=self._device_ordinal)
+
 
 class _OutfeedStructure:
   """ An internal class used for storing the structure of the IPUOutfeedQueue.
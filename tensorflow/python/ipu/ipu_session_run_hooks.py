@@ -16,13 +16,26 @@
 Session run hooks
 ~~~~~~~~~~~~~~~~~
 """
+import os
+import threading
+
 import numpy as np
+from six.moves import queue
 
+from tensorflow.core.protobuf import saver_pb2
 from tensorflow.python import ops
+from tensorflow.python.client import session as session_lib
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import tensor_util
 from tensorflow.python.ipu import ipu_outfeed_queue
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_io_ops
+from tensorflow.python.ops import variables
 from tensorflow.python.platform import tf_logging as logging
+from tensorflow.python.training import checkpoint_management
 from tensorflow.python.training import session_run_hook
+from tensorflow.python.training import training_util
+from tensorflow.python.training.saving import saveable_object_util
 from tensorflow.python.training.basic_session_run_hooks import NeverTriggerTimer
 from tensorflow.python.training.basic_session_run_hooks import SecondOrStepTimer
 
@@ -171,3 +184,159 @@ class IPULoggingTensorHook(session_run_hook.SessionRunHook):
       self._log_values(values)
 
     self._iter_count += 1
+
+
+class IPUAsyncCheckpointSaverHook(session_run_hook.SessionRunHook):
+  """Saves checkpoints every N steps or every N seconds, writing them to disk
+  on a background thread.
+
+  This is a version of `tf.estimator.CheckpointSaverHook` which only stalls
+  the training loop while the variables are copied from the IPU to the host.
+  The variables stay on the device, so the next step does not have to copy
+  them back. The snapshot is then written to disk by a background thread while
+  training continues. At most one snapshot is waiting to be written at any
+  time, so if the disk cannot keep up, taking the next snapshot waits for the
+  previous one to be written.
+
+  The checkpoints are in the V2 format and can be restored with a
+  `tf.train.Saver`. Meta graph files are not written.
+  """
+  def __init__(self,
+               checkpoint_dir,
+               save_secs=None,
+               save_steps=None,
+               var_list=None,
+               checkpoint_basename="model.ckpt",
+               max_to_keep=5):
+    """Initializes the hook.
+
+    Args:
+      checkpoint_dir: `str`, the directory to save the checkpoints in.
+      save_secs: `int` or `float`, save a checkpoint every N seconds.
+      save_steps: `int`, save a checkpoint every N steps. Exactly one of
+        `save_secs` and `save_steps` should be provided.
+      var_list: the variables to save, as accepted by `tf.train.Saver`. If
+        None, all the saveable objects are saved.
+      checkpoint_basename: `str`, the base name of the checkpoint files.
+      max_to_keep: `int`, the maximum number of recent checkpoints to keep.
+        If None or 0, all the checkpoints are kept.
+    """
+    if (save_steps is None) == (save_secs is None):
+      raise ValueError("Exactly one of save_steps and save_secs should be "
+                       "provided")
+
+    self._checkpoint_dir = checkpoint_dir
+    self._save_path = os.path.join(checkpoint_dir, checkpoint_basename)
+    self._timer = SecondOrStepTimer(every_secs=save_secs,
+                                    every_steps=save_steps)
+    self._var_list = var_list
+    self._max_to_keep = max_to_keep
+
+    self._specs = None
+    self._snapshot = None
+    self._global_step = None
+    self._writer_session = None
+    self._writer_thread = None
+    self._queue = None
+    self._error = None
+    self._checkpoints = []
+    self._iter_count = 0
+
+  def begin(self):
+    var_list = self._var_list
+    if var_list is None:
+      var_list = variables._all_saveable_objects()  # pylint: disable=protected-access
+    saveables = saveable_object_util.validate_and_slice_inputs(
+        saveable_object_util.op_list_to_dict(var_list))
+    self._specs = [spec for saveable in saveables for spec in saveable.specs]
+    self._snapshot = [spec.tensor for spec in self._specs]
+    self._global_step = training_util.get_global_step()
+
+    # The checkpoints are written by a separate host only session, so that
+    # writing them never waits for the training session.
+    writer_graph = ops.Graph()
+    with writer_graph.as_default(), ops.device("cpu"):
+      self._prefix_placeholder = array_ops.placeholder(dtypes.string, [])
+      self._value_placeholders = [
+          array_ops.placeholder(spec.dtype) for spec in self._specs
+      ]
+      self._save_op = gen_io_ops.save_v2(
+          self._prefix_placeholder, [spec.name for spec in self._specs],
+          [spec.slice_spec for spec in self._specs], self._value_placeholders)
+    self._writer_session = session_lib.Session(graph=writer_graph)
+
+    self._queue = queue.Queue(maxsize=1)
+    self._error = None
+    self._writer_thread = threading.Thread(target=self._write_checkpoints)
+    self._writer_thread.daemon = True
+    self._writer_thread.start()
+    self._iter_count = 0
+
+  def _write_checkpoints(self):
+    while True:
+      item = self._queue.get()
+      if item is None:
+        return
+      if self._error is not None:
+        continue
+      step, values = item
+      try:
+        self._write_checkpoint(step, values)
+      except Exception as e:  # pylint: disable=broad-except
+        self._error = e
+
+  def _write_checkpoint(self, step, values):
+    prefix = "{}-{}".format(self._save_path, step)
+    feed_dict = dict(zip(self._value_placeholders, values))
+    feed_dict[self._prefix_placeholder] = prefix
+    self._writer_session.run(self._save_op, feed_dict=feed_dict)
+
+    if prefix in self._checkpoints:
+      self._checkpoints.remove(prefix)
+    self._checkpoints.append(prefix)
+    if self._max_to_keep:
+      while len(self._checkpoints) > self._max_to_keep:
+        checkpoint_management.remove_checkpoint(self._checkpoints.pop(0),
+                                                saver_pb2.SaverDef.V2)
+
+    checkpoint_management.update_checkpoint_state_internal(
+        self._checkpoint_dir,
+        prefix,
+        all_model_checkpoint_paths=self._checkpoints,
+        save_relative_paths=True)
+    logging.info("Saved checkpoint for step %d into %s.", step, prefix)
+
+  def _raise_writer_error(self):
+    if self._error is not None:
+      error = self._error
+      self._error = None
+      raise error
+
+  def _save(self, session):
+    self._raise_writer_error()
+    fetches = [self._snapshot]
+    if self._global_step is not None:
+      fetches.append(self._global_step)
+    results = session.run(fetches)
+    step = results[1] if self._global_step is not None else self._iter_count
+    self._timer.update_last_triggered_step(self._iter_count)
+    # This blocks while the previous snapshot is still waiting to be written.
+    self._queue.put((int(step), results[0]))
+
+  def after_run(self, run_context, run_values):
+    del run_values
+
+    self._iter_count += 1
+    if self._timer.should_trigger_for_step(self._iter_count):
+      self._save(run_context.session)
+
+  def end(self, session):
+    if self._timer.last_triggered_step() != self._iter_count:
+      self._save(session)
+
+    self._queue.put(None)
+    self._writer_thread.join()
+    self._writer_session.close()
+    self._writer_session = None
+    self._timer.reset()
+    self._raise_writer_error()
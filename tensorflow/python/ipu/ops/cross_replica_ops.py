@@ -32,3 +32,43 @@ def cross_replica_sum(x, name=None):
   """
 
   return gen_popops_ops.ipu_cross_replica_sum(x, name=name)
+
+
+def compressed_cross_replica_sum(x, residual, compression="fp16", name=None):
+  """Sum the input tensor across replicas, communicating it in a compressed
+  form to reduce the number of bytes exchanged between the replicas.
+
+  With "fp16" compression a float32 tensor is cast to float16, halving the
+  number of bytes exchanged. With "int8" compression the tensor is scaled by
+  a factor shared by all the replicas and truncated to int8, quartering the
+  number of bytes exchanged for a float32 tensor.
+
+  The compression error is kept in `residual` and added to the input of the
+  next call, so that the error of the sum does not accumulate over the steps
+  ("error feedback"). `residual` must be a resource variable with the same
+  shape and type as `x`, initialised with zeros, and it should be used by a
+  single call to this function.
+
+  .. code-block:: python
+
+      residual = tf.get_variable("residual", shape=grad.shape,
+                                 dtype=grad.dtype, trainable=False,
+                                 initializer=tf.zeros_initializer(),
+                                 use_resource=True)
+      grad = cross_replica_ops.compressed_cross_replica_sum(grad, residual)
+
+  Args:
+    x: The local tensor to the sum, either float16 or float32.
+    residual: The resource variable which holds the compression error.
+    compression: Either "fp16" or "int8".
+    name: Optional op name.
+
+  Returns:
+    A `Tensor` which is summed across replicas.
+  """
+  if compression not in ["fp16", "int8"]:
+    raise ValueError("Unknown compression '%s', expected 'fp16' or 'int8'." %
+                     compression)
+
+  return gen_popops_ops.ipu_compressed_cross_replica_sum(
+      residual.handle, x, compression=compression, name=name)
@@ -19,6 +19,9 @@ Popops embedding operators
 
 from functools import reduce
 from operator import mul
+import struct
+
+import numpy as np
 
 from tensorflow.compiler.plugin.poplar.ops import gen_popops_ops
 from tensorflow.python.ipu.ops import functional_ops
@@ -29,7 +32,9 @@ from tensorflow.python.ops import clip_ops
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.ops import variables
 from tensorflow.python.util import deprecation
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
 from tensorflow.python.framework import tensor_util
 from tensorflow.python.eager import context
 
@@ -164,7 +169,9 @@ class HostEmbeddingOptimizerSpec:
       and host is opaque to TensorFlow. For these reasons we need to describe
       the optimizer parameters separately.
 
-      Currently only supports SGD.
+      This class describes SGD. See `HostEmbeddingAdagradOptimizerSpec`,
+      `HostEmbeddingMomentumOptimizerSpec` and `HostEmbeddingAdamOptimizerSpec`
+      for optimizers which keep additional state on the host.
 
   """
   def __init__(self, learning_rate, optimizer_name=None):
@@ -190,6 +197,16 @@ class HostEmbeddingOptimizerSpec:
     """
     return self._learning_rate
 
+  def get_optimizer_name(self):
+    """
+    Get the name of the optimiser used by the host.
+
+    Returns:
+      The optimizer name.
+
+    """
+    return self._optimizer_name
+
   def create_lookup_instruction(self, embedding_tensor, indices, slot_vars,
                                 partition_strategy, name):
     """
@@ -288,6 +305,153 @@ class HostEmbeddingSGDGAOptimizerSpec(HostEmbeddingOptimizerSpec):
     return self._accumulation_factor
 
 
+class _HostEmbeddingSlotOptimizerSpec(HostEmbeddingOptimizerSpec):
+  """ Base class for the host embedding optimizers which keep per row state.
+
+      The state is stored in CPU slot variables with the same shape as the
+      embedding. The device sends the raw gradients to the host and the
+      optimizer is applied there, only to the rows which were looked up.
+
+  """
+  def __init__(self, learning_rate, optimizer_name, slot_names, slot_dtype,
+               slot_initial_value):
+    super().__init__(learning_rate, optimizer_name)
+    self._slot_names = slot_names
+    self._slot_dtype = slot_dtype
+    self._slot_initial_value = slot_initial_value
+
+  def get_register_attributes(self):
+    """
+    Get the optimizer specific attributes of the register instruction.
+
+    Returns:
+      A dictionary of attributes.
+
+    """
+    return {}
+
+  def create_register_instruction(self, embedding_tensor, slot_vars, name):
+    return gen_pop_datastream_ops.ipu_host_embedding_register_with_slots(
+        embedding_tensor,
+        slot_vars,
+        name,
+        optimizer=self._optimizer_name,
+        learning_rate=self.get_learning_rate(),
+        **self.get_register_attributes())
+
+  def create_slot_variables(self, embedding_tensor, name):
+    dtype = self._slot_dtype
+    if dtype is None:
+      dtype = embedding_tensor.dtype
+
+    slots = []
+    with ops.device('cpu'):
+      for slot_name in self._slot_names:
+        initial_value = array_ops.fill(
+            embedding_tensor.shape,
+            math_ops.cast(self._slot_initial_value, dtype))
+        slots.append(
+            variables.RefVariable(initial_value=initial_value,
+                                  name=name + "/" + slot_name,
+                                  trainable=False))
+    return slots
+
+
+class HostEmbeddingAdagradOptimizerSpec(_HostEmbeddingSlotOptimizerSpec):
+  """ Description of the Adagrad Host Embedding optimizer.
+
+  """
+  def __init__(self,
+               learning_rate,
+               initial_accumulator_value=0.1,
+               slot_dtype=None):
+    """
+    Create a HostEmbeddingAdagradOptimizerSpec.
+
+    Args:
+        learning_rate: The learning rate.
+        initial_accumulator_value: The starting value for the accumulators,
+          must be positive.
+        slot_dtype: The dtype of the accumulator slot. When `None`, the dtype
+          of the embedding is used. Use `np.float16` to halve the host memory
+          used by the slot.
+
+    """
+    if initial_accumulator_value <= 0.0:
+      raise ValueError("initial_accumulator_value must be positive: %s" %
+                       initial_accumulator_value)
+    super().__init__(learning_rate, "Adagrad", ["accumulator"], slot_dtype,
+                     initial_accumulator_value)
+
+
+class HostEmbeddingMomentumOptimizerSpec(_HostEmbeddingSlotOptimizerSpec):
+  """ Description of the Momentum Host Embedding optimizer.
+
+  """
+  def __init__(self,
+               learning_rate,
+               momentum,
+               use_nesterov=False,
+               slot_dtype=None):
+    """
+    Create a HostEmbeddingMomentumOptimizerSpec.
+
+    Args:
+        learning_rate: The learning rate.
+        momentum: The momentum.
+        use_nesterov: Whether to use Nesterov momentum.
+        slot_dtype: The dtype of the momentum slot. When `None`, the dtype of
+          the embedding is used. Use `np.float16` to halve the host memory
+          used by the slot.
+
+    """
+    super().__init__(learning_rate, "Momentum", ["momentum"], slot_dtype, 0.0)
+    self._momentum = momentum
+    self._use_nesterov = use_nesterov
+
+  def get_register_attributes(self):
+    return {"momentum": self._momentum, "use_nesterov": self._use_nesterov}
+
+
+class HostEmbeddingAdamOptimizerSpec(_HostEmbeddingSlotOptimizerSpec):
+  """ Description of the Adam Host Embedding optimizer.
+
+      The moments of a row are only updated when the row is looked up, as in
+      `LazyAdamOptimizer`.
+
+  """
+  def __init__(self,
+               learning_rate,
+               beta1=0.9,
+               beta2=0.999,
+               epsilon=1e-8,
+               slot_dtype=None):
+    """
+    Create a HostEmbeddingAdamOptimizerSpec.
+
+    Args:
+        learning_rate: The learning rate.
+        beta1: The exponential decay rate for the 1st moment estimates.
+        beta2: The exponential decay rate for the 2nd moment estimates.
+        epsilon: A small constant for numerical stability.
+        slot_dtype: The dtype of the moment slots. When `None`, the dtype of
+          the embedding is used. Use `np.float16` to halve the host memory
+          used by the slots.
+
+    """
+    super().__init__(learning_rate, "Adam", ["m", "v"], slot_dtype, 0.0)
+    self._beta1 = beta1
+    self._beta2 = beta2
+    self._epsilon = epsilon
+
+  def get_register_attributes(self):
+    return {
+        "beta1": self._beta1,
+        "beta2": self._beta2,
+        "epsilon": self._epsilon
+    }
+
+
 class HostEmbedding:
   """ Host Embedding wrapper.
 
@@ -373,14 +537,10 @@ class HostEmbedding:
         self._session = session
 
       def _register(self):
-        return self._parent._optimizer_spec.create_register_instruction(
-            self._parent._embedding_tensor, self._parent._slot_vars,
-            self._parent._name)
+        return self._parent._create_register_instruction()
 
       def _deregister(self):
-        return self._parent._optimizer_spec.create_deregister_instruction(
-            self._parent._embedding_tensor, self._parent._slot_vars,
-            self._parent._name)
+        return self._parent._create_deregister_instruction()
 
       def __enter__(self):
         if self._session is not None:
@@ -397,6 +557,14 @@ class HostEmbedding:
 
     return HostEmbeddingScope(self, session)
 
+  def _create_register_instruction(self):
+    return self._optimizer_spec.create_register_instruction(
+        self._embedding_tensor, self._slot_vars, self._name)
+
+  def _create_deregister_instruction(self):
+    return self._optimizer_spec.create_deregister_instruction(
+        self._embedding_tensor, self._slot_vars, self._name)
+
   def __call__(self, *args, **kwargs):
     # Keeping the old function just so an exception can be used to inform
     # users of the API change.
@@ -441,6 +609,117 @@ class HostEmbedding:
         list(indices_shape) + [self._embedding_tensor.shape[1]])
 
 
+class MappedHostEmbedding(HostEmbedding):
+  """ Host Embedding stored in a memory mapped table file.
+
+      The table file is mapped into the host memory when the embedding is
+      registered instead of being held in a TensorFlow variable. This means
+      that registration does not copy the table, only the parts of the table
+      which are looked up are read from the file, and processes on the same
+      host using the same file share the memory used by the table.
+
+      The table file is never modified. When the embedding is trained, the
+      updated rows are kept in the memory of the process and appended to an
+      update log file, which is applied the next time the table is mapped.
+
+      Table files can be created with `write_host_embedding_table`.
+
+      Only the `HostEmbeddingOptimizerSpec` and
+      `HostEmbeddingSGDGAOptimizerSpec` optimizers are supported.
+
+  """
+  # pylint: disable=super-init-not-called
+  def __init__(self,
+               name,
+               path,
+               shape,
+               dtype,
+               partition_strategy="TOKEN",
+               optimizer_spec=None,
+               update_log_path=None):
+    """
+    Create a MappedHostEmbedding.
+
+    Args:
+        name: The name which uniquely identifies the embedding.
+        path: The path of the table file.
+        shape: The shape of the table in the file.
+        dtype: The dtype of the table in the file.
+        partition_strategy: See `create_host_embedding`.
+        optimizer_spec: A description of how the embedding will be optimized.
+            When `None`, the embedding is assumed to not be trainable.
+        update_log_path: The path of the file the updated rows are logged to.
+            Defaults to the table path with a ".log" suffix. When it is an
+            empty string the updates are not logged and are lost when the
+            embedding is deregistered. Processes which train the same table
+            must use different logs.
+    """
+    if not isinstance(optimizer_spec,
+                      (type(None), HostEmbeddingOptimizerSpec)):
+      raise ValueError(
+          "HostEmbedding optimizer_spec is not a HostEmbeddingOptimizerSpec" +
+          " or None")
+
+    if isinstance(optimizer_spec, _HostEmbeddingSlotOptimizerSpec):
+      raise ValueError(
+          "MappedHostEmbedding does not support optimizers with slots")
+
+    if optimizer_spec is None:
+      optimizer_spec = HostEmbeddingOptimizerSpec(0)
+
+    if partition_strategy not in ["TOKEN", "ENCODING"]:
+      raise ValueError("Unknown partition strategy " + str(partition_strategy))
+
+    if update_log_path is None:
+      update_log_path = path + ".log"
+
+    self._name = name
+    self._path = path
+    self._update_log_path = update_log_path
+    # Only the shape and dtype of the embedding are needed for the lookups.
+    self._embedding_tensor = tensor_spec.TensorSpec(shape, dtype)
+    self._partition_strategy = partition_strategy
+    self._optimizer_spec = optimizer_spec
+    self._has_lookup = False
+    self._slot_vars = []
+
+  def get_embedding_tensor(self):
+    raise ValueError("A MappedHostEmbedding does not have a tensor.")
+
+  def _create_register_instruction(self):
+    return gen_pop_datastream_ops.ipu_host_embedding_register_mapped(
+        embedding_id=self._name,
+        optimizer=self._optimizer_spec.get_optimizer_name(),
+        path=self._path,
+        update_log_path=self._update_log_path,
+        embedding_shape=self._embedding_tensor.shape,
+        T=self._embedding_tensor.dtype)
+
+  def _create_deregister_instruction(self):
+    return gen_pop_datastream_ops.ipu_host_embedding_deregister_mapped(
+        embedding_id=self._name)
+
+
+def write_host_embedding_table(path, table):
+  """ Write a table file which can be used by a `MappedHostEmbedding`.
+
+      Args:
+        path: The path of the file to write.
+        table: A rank two numpy array containing the embedding.
+  """
+  table = np.ascontiguousarray(table)
+  if table.ndim != 2:
+    raise ValueError("Host embedding tables must be rank two")
+
+  # See MappedEmbeddingTable::Header.
+  header = struct.pack("<8sIIqq", b"IPUEMBED", 1,
+                       dtypes.as_dtype(table.dtype).as_datatype_enum,
+                       table.shape[0], table.shape[1])
+  with open(path, "wb") as f:
+    f.write(header.ljust(64, b"\0"))
+    f.write(table.tobytes())
+
+
 def create_host_embedding(name,
                           shape,
                           dtype,
@@ -453,11 +732,10 @@ def create_host_embedding(name,
         name: The name which uniquely identifies the embedding.
         shape: The shape for the tensor which will hold the embedding.
         dtype: The dtype for the tensor which will hold the embedding.
-        partition_strategy: When
-          `enable_experimental_remote_buffer_embedding` is `True` and using
-          replication, the embedding must be distributed across the replicas.
-          This option decides on which axis the embedding will be split. Options
-          are "TOKEN" or "ENCODING".
+        partition_strategy: When `enable_remote_buffer_embedding` is `True`
+          and using replication, the embedding must be distributed across the
+          replicas. This option decides on which axis the embedding will be
+          split. Options are "TOKEN" or "ENCODING".
         optimizer_spec: A description of how the embedding will be optimized.
           When `None`, the embedding is assumed to not be trainable.
         initializer: The initializer to use when creating the embedding tensor.
@@ -35,9 +35,14 @@ def _ipu_multi_update(op, grads):
 @ops.RegisterGradient("IpuDeviceEmbeddingLookupTrainable")
 def _ipu_host_embedding_lookup_grad(op, grads):
   """Gradients for the IpuDeviceEmbeddingLookupTrainable op."""
+  # Optimizers other than SGD are applied on the host, which needs the raw
+  # gradients.
+  if op.get_attr("optimizer") in ('SGD', 'SGD+GA'):
+    grads = -grads * op.get_attr("learning_rate")
+
   update_op = gen_pop_datastream_ops.ipu_device_embedding_update_add(
       op.outputs[0],
-      -grads * op.get_attr("learning_rate"),
+      grads,
       indices=op.inputs[1],
       embedding_id=op.get_attr("embedding_id"),
       embedding_shape=op.get_attr("embedding_shape"),
@@ -25,7 +25,10 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import func_graph as func_graph_module
 from tensorflow.python.framework import ops
 from tensorflow.python.ipu import scopes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
 from tensorflow.python.ops import control_flow_util_v2 as util
+from tensorflow.python.util import nest
 
 
 def function(func, name=None):
@@ -83,6 +86,69 @@ def function(func, name=None):
   return func_wrapper
 
 
+def batch_size_variants(func,
+                        inputs,
+                        variant_index,
+                        allowed_batch_sizes,
+                        name=None):
+  """
+  Computes a function on the first examples of a batch only, by compiling a
+  variant of it for each of the allowed batch sizes into the same program.
+  The variants share the variables of the function, and the one to execute is
+  chosen at run time.
+
+  This can be used with the batches of a `RequestBatcher` which was created
+  with the same `allowed_batch_sizes`, which are followed by the index of the
+  smallest variant which holds all of their examples, so that a batch which is
+  mostly padding does not have to be computed at the largest batch size.
+
+  Args:
+    func: A python function which takes the inputs, sliced to a batch size,
+      and returns one or more tensors with the batch size as their outer
+      dimension.
+    inputs: A list of tensors with the largest allowed batch size as their
+      outer dimension.
+    variant_index: A scalar int32 tensor with the index of the batch size to
+      compute in `allowed_batch_sizes`.
+    allowed_batch_sizes: A list of increasing batch sizes, the last of which is
+      the batch size of the inputs.
+    name: The name of the operation.
+
+  Returns:
+    The outputs of `func`, padded with zeros up to the largest allowed batch
+    size.
+  """
+  name = name if name else "batch_size_variants"
+  inputs = _convert_to_list(inputs)
+  if not allowed_batch_sizes or sorted(set(allowed_batch_sizes)) != list(
+      allowed_batch_sizes):
+    raise ValueError("allowed_batch_sizes must be a list of increasing batch "
+                     "sizes, got %s." % str(allowed_batch_sizes))
+  max_batch_size = allowed_batch_sizes[-1]
+  for x in inputs:
+    if x.shape[0] != max_batch_size:
+      raise ValueError(
+          "The inputs must have the largest allowed batch size %d as their "
+          "outer dimension, got %s." % (max_batch_size, str(x.shape)))
+
+  def variant(batch_size):
+    def compute():
+      outputs = func(*[x[:batch_size] for x in inputs])
+
+      def pad(output):
+        paddings = [[0, max_batch_size - batch_size]]
+        paddings += [[0, 0]] * (output.shape.ndims - 1)
+        return array_ops.pad(output, paddings)
+
+      return nest.map_structure(pad, outputs)
+
+    return compute
+
+  with ops.name_scope(name):
+    return control_flow_ops.switch_case(
+        variant_index, [variant(n) for n in allowed_batch_sizes])
+
+
 class _InvalidCaptureException(Exception):
   pass
 
@@ -17,7 +17,10 @@ IPU specific maths operations
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 """
 
+import numpy as np
+
 from tensorflow.compiler.plugin.poplar.driver import backend_config_pb2
+from tensorflow.python.framework import ops
 from tensorflow.python.ipu.ops import functional_ops
 from tensorflow.python.ipu.ops import op_util
 from tensorflow.python.ops import array_ops
@@ -368,3 +371,86 @@ def serialized_matmul(a,
     return fwd_fn(lhs, rhs, transpose_a, transpose_b, name), grad_fn
 
   return _matmul(a, b)
+
+
+def quantize_weights(weights, dtype=np.int8, axis=-1):
+  """Quantizes a weight matrix on the host into 8 bit integers with a
+  symmetric, per-channel scale.
+
+  The scale for each channel along `axis` is calibrated from the largest
+  absolute weight value in that channel, so that the dequantized weights are
+  given by `quantized * scale`. The returned values can be used to initialize
+  8 bit variables which take a quarter of the memory and of the remote buffer
+  bandwidth of the corresponding float32 variables.
+
+  Args:
+    weights: A `numpy.ndarray` of floating point weights.
+    dtype: The integer type to quantize into, either `numpy.int8` or
+      `numpy.uint8`. For `numpy.uint8` the values are offset by 128 and
+      `quantized_matmul` has to be passed `zero_point=128`.
+    axis: The channel dimension which gets its own scale. Defaults to the last
+      dimension, which is the output channel dimension of a matmul weight.
+
+  Returns:
+    A tuple of the quantized `numpy.ndarray` and the float32 `numpy.ndarray`
+    of scales, which has the size of `weights` along `axis`.
+  """
+  dtype = np.dtype(dtype)
+  if dtype not in (np.int8, np.uint8):
+    raise ValueError(
+        "Weights can only be quantized into int8 or uint8, not {}.".format(
+            dtype))
+
+  weights = np.asarray(weights, dtype=np.float32)
+  axis = axis % weights.ndim
+  reduction_axes = tuple(d for d in range(weights.ndim) if d != axis)
+  max_abs = np.amax(np.abs(weights), axis=reduction_axes, keepdims=True)
+  scale = np.where(max_abs > 0, max_abs / 127.0, 1.0).astype(np.float32)
+
+  quantized = np.clip(np.round(weights / scale), -127, 127)
+  if dtype == np.uint8:
+    quantized += 128
+  return quantized.astype(dtype), np.squeeze(scale, axis=reduction_axes)
+
+
+def quantized_matmul(a,
+                     b,
+                     scale,
+                     zero_point=0,
+                     transpose_a=False,
+                     transpose_b=False,
+                     name=None):
+  """Multiplies matrix a by the quantized matrix b, dequantizing b on the fly.
+
+  The matrix `b` is kept in its 8 bit integer type, for example in an int8
+  variable created from the output of `quantize_weights`, and is only cast to
+  the type of `a` when it is used. The multiplication is done in the type of
+  `a`, which is usually float16, and the per-channel scale is applied to the
+  output of the multiplication rather than to `b`, which means that the full
+  precision weights are never materialized.
+
+  Args:
+    a: `tf.Tensor` of type float16 or float32 and rank >= 2.
+    b: `tf.Tensor` of type int8 or uint8 with the same rank as a.
+    scale: A scalar or a vector with one element for each column of b (after
+      the transposition), of the same type as a or convertible to it.
+    zero_point: The value which represents zero in b. Must be 128 when b was
+      quantized into uint8 by `quantize_weights`.
+    transpose_a: If True, a is transposed before multiplication.
+    transpose_b: If True, b is transposed before multiplication.
+    name: Name for the operation (optional).
+
+  Returns:
+    A `tf.Tensor` of the same type as a, which is equal to the product of a and
+    the dequantized b.
+  """
+  name = name or "quantized_matmul"
+  with ops.name_scope(name):
+    b = math_ops.cast(b, a.dtype)
+    if zero_point:
+      b = b - math_ops.cast(zero_point, a.dtype)
+    output = math_ops.matmul(a,
+                             b,
+                             transpose_a=transpose_a,
+                             transpose_b=transpose_b)
+    return output * math_ops.cast(scale, a.dtype)
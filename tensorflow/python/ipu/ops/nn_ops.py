@@ -17,6 +17,8 @@ Popnn primitive neural network operators
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 """
 
+import numpy as np
+
 from google.protobuf import json_format
 
 from tensorflow.compiler.plugin.poplar.driver import backend_config_pb2
@@ -49,6 +51,109 @@ def gelu(x, name=None):
   return gen_popnn_ops.ipu_gelu(x, name=name)
 
 
+def multi_head_attention(query, key, value, causal=False, name=None):
+  """Scaled dot product attention, fused into a single operation optimised
+  for execution on the IPU.
+
+  The output is ``softmax(query * key^T / sqrt(head_size)) * value`` for each
+  head. The gradient recomputes the attention probabilities rather than
+  keeping the ``[query_length, key_length]`` matrix of every head live
+  between the forward and backward passes.
+
+  Args:
+    query: A tensor of shape ``[batch_size, num_heads, query_length,
+      head_size]``.
+    key: A tensor of shape ``[batch_size, num_heads, key_length, head_size]``.
+    value: A tensor of shape ``[batch_size, num_heads, key_length,
+      value_size]``.
+    causal: If True, each query only attends to the keys up to its own
+      position.
+    name: Optional op name.
+
+  Returns:
+    A `Tensor` of shape ``[batch_size, num_heads, query_length, value_size]``.
+  """
+
+  return gen_popnn_ops.ipu_multi_head_attention(query,
+                                                key,
+                                                value,
+                                                causal=causal,
+                                                name=name)
+
+
+def _get_block_size(block_size):
+  if isinstance(block_size, int):
+    return [block_size] * 3
+  block_size = list(block_size)
+  if len(block_size) != 3:
+    raise ValueError("The block size must be an integer or a list of the "
+                     "[block_m, block_k, block_n] block dimensions, got %s." %
+                     block_size)
+  return block_size
+
+
+def block_sparse_blocks(matrix, sparsity_mask, block_size):
+  """Extracts the non-zero blocks of a dense matrix, in the layout expected by
+  :py:func:`block_sparse_matmul`.
+
+  Args:
+    matrix: A numpy array of shape ``[K, N]``.
+    sparsity_mask: A 2D array of shape ``[K / block_k, N / block_n]``, which is
+      non-zero for the non-zero blocks of the matrix.
+    block_size: An integer or a list of the ``[block_m, block_k, block_n]``
+      block dimensions.
+
+  Returns:
+    A numpy array of shape ``[num_non_zero_blocks, block_k * block_n]`` with
+    the non-zero blocks in row major order, each of them in row major order.
+  """
+  _, block_k, block_n = _get_block_size(block_size)
+  matrix = np.asarray(matrix)
+  mask = np.asarray(sparsity_mask)
+  blocks = [
+      matrix[i * block_k:(i + 1) * block_k,
+             j * block_n:(j + 1) * block_n].reshape(-1)
+      for i, j in zip(*np.nonzero(mask))
+  ]
+  return np.stack(blocks)
+
+
+def block_sparse_matmul(a, b_blocks, sparsity_mask, block_size, name=None):
+  """Multiplies a dense matrix by a block-sparse matrix with a static sparsity
+  pattern, using the PopLibs Popsparse block-sparse matmul.
+
+  Only the non-zero blocks of the block-sparse matrix are stored and
+  multiplied, and the compiler plans the multiplication once for the sparsity
+  pattern. The gradient of `b_blocks` is only computed for the non-zero blocks.
+
+  Args:
+    a: A dense tensor of shape ``[M, K]``.
+    b_blocks: The non-zero blocks of the ``[K, N]`` block-sparse matrix, shaped
+      ``[num_non_zero_blocks, block_k * block_n]``. See
+      :py:func:`block_sparse_blocks`.
+    sparsity_mask: A 2D array of shape ``[K / block_k, N / block_n]``, which is
+      non-zero for the non-zero blocks of the block-sparse matrix.
+    block_size: An integer or a list of the ``[block_m, block_k, block_n]``
+      block dimensions. `M` must be a multiple of ``block_m``.
+    name: Optional op name.
+
+  Returns:
+    A `Tensor` of shape ``[M, N]``.
+  """
+  block_size = _get_block_size(block_size)
+  mask = np.asarray(sparsity_mask)
+  if mask.ndim != 2:
+    raise ValueError("The sparsity mask must have rank 2, got shape %s." %
+                     (mask.shape,))
+  return gen_popnn_ops.ipu_block_sparse_matmul(
+      a,
+      b_blocks,
+      block_size=block_size,
+      sparsity_shape=list(mask.shape),
+      sparsity=[int(x != 0) for x in mask.flatten()],
+      name=name)
+
+
 def multi_conv(func=None, options=None):
   """A function decorator for generating multi-convolution operations.
   Multi-convolutions allow for a set of data-independent convolutions to be
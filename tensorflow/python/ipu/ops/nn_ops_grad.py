@@ -29,6 +29,27 @@ def _ipu_gelu_grad(op, grad):
   return [gen_popnn_ops.ipu_gelu_grad(grad, x)]
 
 
+@ops.RegisterGradient("IpuMultiHeadAttention")
+def _ipu_multi_head_attention_grad(op, grad):
+  """Gradients for the IpuMultiHeadAttention op."""
+  query, key, value = op.inputs
+  return gen_popnn_ops.ipu_multi_head_attention_grad(
+      query, key, value, grad, causal=op.get_attr("causal"))
+
+
+@ops.RegisterGradient("IpuBlockSparseMatMul")
+def _ipu_block_sparse_matmul_grad(op, grad):
+  """Gradients for the IpuBlockSparseMatMul op."""
+  lhs, rhs = op.inputs
+  return gen_popnn_ops.ipu_block_sparse_matmul_grad(
+      lhs,
+      rhs,
+      grad,
+      block_size=op.get_attr("block_size"),
+      sparsity_shape=op.get_attr("sparsity_shape"),
+      sparsity=op.get_attr("sparsity"))
+
+
 @ops.RegisterGradient("MultiConv")
 def _multi_conv_grad(op, *grads):
   """The gradient of a MultiConv op."""
@@ -58,11 +58,15 @@ class PipelineSchedule(IntEnum):
       other.
 
     Interleaved: This schedules the backward passes whenever the forward
-      passes have just generated some activations.  Consequently fewer
-      activations are required to be stored between the forward and backward
-      pipeline stages, so less memory is required.  However, since forward
-      and backward stages tend to be very different in terms of execution
-      cycles, the overall performance of the pipeline tends to be slower.
+      passes have just generated some activations (a one forward, one
+      backward schedule).  Consequently fewer activations are required to be
+      stored between the forward and backward pipeline stages: the number of
+      activations stored for a stage is bounded by the number of stages after
+      it, which is half of what the Grouped schedule stores, and it does not
+      depend on the gradient accumulation count.  This allows a larger batch
+      size on each IPU.  However, since forward and backward stages tend to be
+      very different in terms of execution cycles, the overall performance of
+      the pipeline tends to be slower.
 
     Sequential: This is a debug mode, where the pipeline is scheduled in
       the same way as if it were a sharded model.
@@ -23,7 +23,9 @@ from tensorflow.python.framework import ops
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.layers import base as base_layer
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
 from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import rnn_cell
 from tensorflow.python.ops import variable_scope as vs
 from tensorflow.python.platform import tf_logging as logging
@@ -169,6 +171,73 @@ class _PopnnRNN(base_layer.Layer):
   def call(self, inputs, initial_state=None, training=True):
     raise ValueError("This method needs to be overridden.")
 
+  def _forward_sequences(self, inputs, seq_len, time_step_buckets, forward):
+    """Runs `forward` on the fewest time steps which cover all the sequences.
+
+    The number of time steps is the smallest of `time_step_buckets` which is
+    not less than the longest sequence of the batch, and a conditional selects
+    the layer compiled for it. The outputs are padded back to the time length
+    of the inputs, and the outputs past the end of each sequence are zeroed.
+
+    Args:
+      inputs: 3-D tensor with shape [time_len, batch_size, input_size].
+      seq_len: 1-D tensor with the length of each sequence of the batch.
+      time_step_buckets: list of the numbers of time steps to compile the
+        layer for. The time length of the inputs is always one of them.
+      forward: function which runs the layer on its inputs and returns the
+        outputs and a list of the output states.
+
+    Returns:
+      tuple of the masked outputs, the output states of the last computed
+      time step and the outputs at the last time step of each sequence.
+
+    Raises:
+      ValueError: if the time length of the inputs is not known or a bucket is
+        not valid.
+    """
+    max_time = tensor_shape.dimension_value(inputs.shape[0])
+    if max_time is None:
+      raise ValueError("The time length of the inputs must be known when "
+                       "`seq_len` is provided.")
+    buckets = sorted(set(time_step_buckets or []) | set([max_time]))
+    if buckets[0] < 1 or buckets[-1] > max_time:
+      raise ValueError("The time step buckets must be between 1 and the "
+                       "time length of the inputs %d, got %s." %
+                       (max_time, buckets))
+
+    seq_len = math_ops.cast(seq_len, dtypes.int32)
+    longest = math_ops.reduce_max(seq_len)
+
+    def branch(time_steps):
+      def fn():
+        outputs, states = forward(inputs[:time_steps])
+        outputs = array_ops.pad(outputs,
+                                [[0, max_time - time_steps], [0, 0], [0, 0]])
+        return [outputs] + list(states)
+
+      return fn
+
+    if len(buckets) == 1:
+      results = branch(max_time)()
+    else:
+      # The index of the smallest bucket which covers the longest sequence.
+      index = math_ops.reduce_sum(
+          math_ops.cast(math_ops.less(buckets, longest), dtypes.int32))
+      results = control_flow_ops.switch_case(index,
+                                             [branch(b) for b in buckets])
+    outputs, states = results[0], results[1:]
+
+    # Zero the outputs past the end of each sequence.
+    mask = array_ops.sequence_mask(seq_len, max_time, dtype=outputs.dtype)
+    outputs = outputs * array_ops.expand_dims(array_ops.transpose(mask), -1)
+
+    batch_size = array_ops.shape(inputs)[1]
+    last_steps = array_ops.stack(
+        [math_ops.maximum(seq_len - 1, 0),
+         math_ops.range(batch_size)], axis=1)
+    last_outputs = array_ops.gather_nd(outputs, last_steps)
+    return outputs, states, last_outputs
+
   def state_shape(self, batch_size):
     raise ValueError("This method needs to be overridden.")
 
@@ -268,7 +337,12 @@ class PopnnLSTM(_PopnnRNN):
     """
     self._build(input_shape)
 
-  def call(self, inputs, initial_state=None, training=True):
+  def call(self,
+           inputs,
+           initial_state=None,
+           training=True,
+           seq_len=None,
+           time_step_buckets=None):
     """Runs the forward step for the LSTM model.
 
     Args:
@@ -279,6 +353,16 @@ class PopnnLSTM(_PopnnRNN):
         DEPRECATED a tuple of tensor (input_h_state, input_c_state)
         each of shape [batch_size, num_units].
       training: whether this operation will be used in training or inference.
+      seq_len: optional 1-D int32 tensor of shape [batch_size] with the length
+        of each sequence of the batch. When provided, the outputs past the end
+        of each sequence are zeroed and the output h state is the output at
+        the last time step of each sequence. The output c state is the one of
+        the last time step computed for the batch.
+      time_step_buckets: optional list of the numbers of time steps to compile
+        the layer for when `seq_len` is provided. Each batch only runs the
+        smallest number of time steps which covers its longest sequence, so
+        that padded time steps are skipped. Each bucket adds a copy of the
+        layer to the program.
 
     Returns:
       tuple of output and output states:
@@ -321,8 +405,22 @@ class PopnnLSTM(_PopnnRNN):
     c, h = initial_state
     h = ops.convert_to_tensor(h, dtype=dtype)
     c = ops.convert_to_tensor(c, dtype=dtype)
-    outputs, state = self._forward(inputs, h, c, self.kernel, self.biases,
-                                   training)
+    if seq_len is None:
+      outputs, state = self._forward(inputs, h, c, self.kernel, self.biases,
+                                     training)
+    else:
+
+      def forward(x):
+        outputs, state = self._forward(x, h, c, self.kernel, self.biases,
+                                       training)
+        return outputs, [state.c]
+
+      seq_len = ops.convert_to_tensor(seq_len, dtype=dtypes.int32)
+      outputs, states, last_outputs = self._forward_sequences(
+          inputs, seq_len, time_step_buckets, forward)
+      # Empty sequences keep their initial state.
+      output_h = array_ops.where(math_ops.greater(seq_len, 0), last_outputs, h)
+      state = rnn_cell.LSTMStateTuple(states[0], output_h)
     if uses_old_api:
       state = (state.h, state.c)
     return outputs, state
@@ -426,7 +524,12 @@ class PopnnGRU(_PopnnRNN):
     """
     self._build(input_shape)
 
-  def call(self, inputs, initial_state=None, training=True):
+  def call(self,
+           inputs,
+           initial_state=None,
+           training=True,
+           seq_len=None,
+           time_step_buckets=None):
     """Runs the forward step for the GRU model.
 
     Args:
@@ -434,6 +537,15 @@ class PopnnGRU(_PopnnRNN):
       initial_state: Initial state tensor, shaped `[batch_size, num_units]`. If
         not provided, the state is initialized to zeros.
       training: whether this operation will be used in training or inference.
+      seq_len: optional 1-D int32 tensor of shape [batch_size] with the length
+        of each sequence of the batch. When provided, the outputs past the end
+        of each sequence are zeroed and the output state is the output at the
+        last time step of each sequence.
+      time_step_buckets: optional list of the numbers of time steps to compile
+        the layer for when `seq_len` is provided. Each batch only runs the
+        smallest number of time steps which covers its longest sequence, so
+        that padded time steps are skipped. Each bucket adds a copy of the
+        layer to the program.
 
     Returns:
       output: a tensor of shape [time_len, batch_size, num_units].
@@ -454,8 +566,23 @@ class PopnnGRU(_PopnnRNN):
       initial_state = self._zero_state(batch_size)
 
     initial_state = ops.convert_to_tensor(initial_state, dtype=dtype)
-    return self._forward(inputs, initial_state, self.kernel, self.biases,
-                         training)
+    if seq_len is None:
+      return self._forward(inputs, initial_state, self.kernel, self.biases,
+                           training)
+
+    def forward(x):
+      outputs, _ = self._forward(x, initial_state, self.kernel, self.biases,
+                                 training)
+      return outputs, []
+
+    seq_len = ops.convert_to_tensor(seq_len, dtype=dtypes.int32)
+    outputs, _, last_outputs = self._forward_sequences(inputs, seq_len,
+                                                       time_step_buckets,
+                                                       forward)
+    # Empty sequences keep their initial state.
+    output_state = array_ops.where(math_ops.greater(seq_len, 0), last_outputs,
+                                   initial_state)
+    return outputs, output_state
 
   def state_shape(self, batch_size):
     """Shape of Popnn GRU state.
@@ -17,25 +17,44 @@ Optimizer wrapper for replicated graphs
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 """
 
+from tensorflow.compiler.plugin.poplar.driver import backend_config_pb2
+from tensorflow.compiler.plugin.poplar.ops import gen_functional_ops
 from tensorflow.compiler.plugin.poplar.ops import gen_poputil_ops
 from tensorflow.python.framework import ops
 from tensorflow.python.ipu.ops import cross_replica_ops
+from tensorflow.python.ipu.ops import functional_ops
+from tensorflow.python.ops import control_flow_util_v2 as util
 from tensorflow.python.training import optimizer
 
 
 class CrossReplicaOptimizer(optimizer.Optimizer):
   """An optimizer that averages gradients across IPU replicas."""
-  def __init__(self, opt, name="CrossReplicaOptimizer"):
+  def __init__(self,
+               opt,
+               replicated_optimizer_state_sharding=False,
+               name="CrossReplicaOptimizer"):
     """Construct a new cross-replica optimizer.
 
     Args:
       opt: An existing `Optimizer` to encapsulate.
+      replicated_optimizer_state_sharding: If True, any `tf.Variable` which is
+        only used by the weight update (for example the slots of the
+        `tf.train.AdamOptimizer`) will be stored in the remote memory and
+        partitioned across the replicas. The weight update is then performed
+        on the shard of each replica after a reduce-scatter of the gradients,
+        and the updated weights are all-gathered. This reduces the memory used
+        by the optimizer state of each replica by the number of replicas.
+        Requires the machine to be configured with support for
+        `Poplar remote buffers`, and the optimizer to be used inside of a
+        training loop.
       name: Optional name prefix for the operations created when applying
         gradients. Defaults to "CrossReplicaOptimizer".
     """
 
     super(CrossReplicaOptimizer, self).__init__(False, name)
     self._opt = opt
+    self._replicated_optimizer_state_sharding = \
+      replicated_optimizer_state_sharding
 
   def compute_gradients(self, loss, var_list=None, **kwargs):
     """Compute gradients of "loss" for the variables in "var_list".
@@ -80,16 +99,46 @@ class CrossReplicaOptimizer(optimizer.Optimizer):
     Raises:
       ValueError: If the grads_and_vars is malformed.
     """
-    summed_grads_and_vars = []
-    for (grad, var) in grads_and_vars:
-      if grad is None:
-        summed_grads_and_vars.append((grad, var))
-      else:
-        with ops.colocate_with(grad):
-          summed_grads_and_vars.append(
-              (gen_poputil_ops.ipu_replication_normalise(
-                  cross_replica_ops.cross_replica_sum(grad)), var))
-    return self._opt.apply_gradients(summed_grads_and_vars, global_step, name)
+    def apply_summed_gradients():
+      summed_grads_and_vars = []
+      for (grad, var) in grads_and_vars:
+        if grad is None:
+          summed_grads_and_vars.append((grad, var))
+        else:
+          with ops.colocate_with(grad):
+            summed_grads_and_vars.append(
+                (gen_poputil_ops.ipu_replication_normalise(
+                    cross_replica_ops.cross_replica_sum(grad)), var))
+      return self._opt.apply_gradients(summed_grads_and_vars, global_step,
+                                       name)
+
+    if not self._replicated_optimizer_state_sharding:
+      return apply_summed_gradients()
+
+    # Sum the gradients and apply them inside of a resource update which is
+    # executed every iteration, so that the optimizer state can be offloaded
+    # and partitioned across the replicas.
+    apply_grad_ops = []
+
+    def resource_update_():
+      apply_grad_ops.append(apply_summed_gradients())
+
+    with ops.name_scope(self._opt.get_name() + "/WU") as scope:
+      func_graph, captured_args = functional_ops._compile_function(  # pylint: disable=protected-access
+          resource_update_, [], scope, apply_grad_ops, True)
+
+    on = backend_config_pb2.ThreeState.Name(backend_config_pb2.THREESTATE_ON)
+    with ops.control_dependencies(list(func_graph.control_captures)):
+      outputs = gen_functional_ops.resource_update(
+          captured_args,
+          to_apply=util.create_new_tf_function(func_graph),
+          Tout=func_graph.output_types,
+          output_shapes=func_graph.output_shapes,
+          offload_weight_update_variables=on,
+          replicated_optimizer_state_sharding=on,
+          num_batches_to_accumulate=1)
+
+    return outputs
 
   def get_slot(self, *args, **kwargs):
     """Return a slot named "name" created for "var" by the Optimizer.
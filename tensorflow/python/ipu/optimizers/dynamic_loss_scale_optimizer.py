@@ -0,0 +1,251 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+"""
+Optimizer wrapper for dynamic loss scaling on the device
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+"""
+
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import state_ops
+from tensorflow.python.ops import variable_scope
+from tensorflow.python.training import optimizer
+
+
+class DynamicLossScaleOptimizer(optimizer.Optimizer):
+  """An optimizer that scales the loss to keep float16 gradients in range.
+
+  The loss is multiplied by a loss scale before the gradients are computed,
+  and the gradients are divided by it before they are applied. The loss scale
+  and the number of steps since it last changed are stored in variables on the
+  device, and are updated by the weight update:
+
+  * If any gradient contains an infinity or a NaN, the weight update is
+    skipped and the loss scale is divided by `multiplier`.
+  * After `increase_period` steps without an overflow, the loss scale is
+    multiplied by `multiplier`.
+
+  The overflow check and the update of the loss scale do not read anything
+  back to the host, so the optimizer can be used inside of
+  `tensorflow.python.ipu.loops.repeat`, a pipeline or a gradient accumulation
+  optimizer.
+
+  Overflows are only detected if they produce infinities or NaNs rather than
+  exceptions, so the floating point behaviour of the IPU must be configured
+  with `inv`, `div0` and `oflo` disabled, see
+  :py:func:`tensorflow.python.ipu.utils.set_floating_point_behaviour_options`.
+  """
+  def __init__(self,
+               opt,
+               initial_loss_scale=2.**15,
+               increase_period=2000,
+               multiplier=2.,
+               min_loss_scale=1.,
+               max_loss_scale=2.**24,
+               name="DynamicLossScaleOptimizer"):
+    """Construct a new dynamic loss scale optimizer.
+
+    Args:
+      opt: An existing `Optimizer` to encapsulate.
+      initial_loss_scale: The loss scale of the first step.
+      increase_period: The number of steps without an overflow after which the
+        loss scale is increased.
+      multiplier: The factor by which the loss scale is increased or decreased.
+      min_loss_scale: The smallest loss scale.
+      max_loss_scale: The largest loss scale.
+      name: Optional name prefix for the operations created when applying
+        gradients. Defaults to "DynamicLossScaleOptimizer".
+
+    Raises:
+      ValueError: If the loss scale parameters are not valid.
+    """
+    if increase_period < 1:
+      raise ValueError("increase_period must be positive, but was %d." %
+                       increase_period)
+    if multiplier <= 1.:
+      raise ValueError("multiplier must be greater than 1, but was %s." %
+                       multiplier)
+    if not min_loss_scale <= initial_loss_scale <= max_loss_scale:
+      raise ValueError(
+          "initial_loss_scale must be between min_loss_scale and "
+          "max_loss_scale, but was %s." % initial_loss_scale)
+
+    super(DynamicLossScaleOptimizer, self).__init__(False, name)
+    self._opt = opt
+    self._initial_loss_scale = float(initial_loss_scale)
+    self._increase_period = increase_period
+    self._multiplier = float(multiplier)
+    self._min_loss_scale = float(min_loss_scale)
+    self._max_loss_scale = float(max_loss_scale)
+    self._loss_scale = None
+    self._good_steps = None
+
+  def _create_loss_scale_variables(self):
+    if self._loss_scale is not None:
+      return
+    with ops.init_scope(), variable_scope.variable_scope(self._name):
+      self._loss_scale = variable_scope.variable(
+          self._initial_loss_scale,
+          name="loss_scale",
+          dtype=dtypes.float32,
+          trainable=False,
+          use_resource=True)
+      self._good_steps = variable_scope.variable(0,
+                                                 name="good_steps",
+                                                 dtype=dtypes.int32,
+                                                 trainable=False,
+                                                 use_resource=True)
+
+  @property
+  def loss_scale(self):
+    """The variable which holds the current loss scale, or None if no
+    gradients have been computed yet."""
+    return self._loss_scale
+
+  def compute_gradients(self, loss, var_list=None, **kwargs):
+    """Compute gradients of "loss" for the variables in "var_list".
+
+    The gradients of the scaled loss are computed with the compute_gradients()
+    from the real optimizer, and are then unscaled.
+
+    Args:
+      loss: A Tensor containing the value to minimize.
+      var_list: Optional list or tuple of `tf.Variable` to update to minimize
+        `loss`.  Defaults to the list of variables collected in the graph
+        under the key `GraphKey.TRAINABLE_VARIABLES`.
+      **kwargs: Keyword arguments for compute_gradients().
+
+    Returns:
+      A list of (gradient, variable) pairs.
+    """
+    self._create_loss_scale_variables()
+    loss_scale = self._loss_scale.read_value()
+    # Scale in float32, as the largest loss scales are not representable in
+    # float16.
+    scaled_loss = math_ops.cast(loss, dtypes.float32) * loss_scale
+    grads_and_vars = self._opt.compute_gradients(scaled_loss,
+                                                 var_list=var_list,
+                                                 **kwargs)
+
+    def unscale(grad):
+      unscaled = math_ops.cast(grad, dtypes.float32) / loss_scale
+      return math_ops.cast(unscaled, grad.dtype)
+
+    unscaled_grads_and_vars = []
+    for grad, var in grads_and_vars:
+      if grad is None:
+        unscaled_grads_and_vars.append((grad, var))
+      elif isinstance(grad, ops.IndexedSlices):
+        unscaled_grads_and_vars.append((ops.IndexedSlices(
+            unscale(grad.values), grad.indices, grad.dense_shape), var))
+      else:
+        unscaled_grads_and_vars.append((unscale(grad), var))
+    return unscaled_grads_and_vars
+
+  def apply_gradients(self, grads_and_vars, global_step=None, name=None):
+    """Apply gradients to variables.
+
+    The gradients are applied with the real optimizer only if they are all
+    finite, and the loss scale is then updated.
+
+    Args:
+      grads_and_vars: List of (gradient, variable) pairs as returned by
+        compute_gradients().
+      global_step: Optional Variable to increment by one after the
+        variables have been updated.
+      name: Optional name for the returned operation.  Default to the
+        name passed to the Optimizer constructor.
+
+    Returns:
+      An `Operation` that applies the gradients. If `global_step` was not None,
+      that operation also increments `global_step`.
+
+    Raises:
+      ValueError: If the grads_and_vars is malformed.
+    """
+    grads_and_vars = list(grads_and_vars)
+    self._create_loss_scale_variables()
+
+    with ops.name_scope(name, self._name):
+      is_finite = [
+          math_ops.reduce_all(
+              math_ops.is_finite(
+                  grad.values if isinstance(grad, ops.IndexedSlices) else grad))
+          for grad, _ in grads_and_vars if grad is not None
+      ]
+      is_finite = math_ops.reduce_all(array_ops.stack(is_finite))
+
+      apply_op = control_flow_ops.cond(
+          is_finite,
+          lambda: self._opt.apply_gradients(grads_and_vars, global_step),
+          control_flow_ops.no_op)
+
+      with ops.control_dependencies([apply_op]):
+        loss_scale = self._loss_scale.read_value()
+        good_steps = self._good_steps.read_value() + 1
+        increase = math_ops.logical_and(
+            is_finite, good_steps >= self._increase_period)
+        new_loss_scale = array_ops.where(
+            is_finite,
+            array_ops.where(
+                increase,
+                math_ops.minimum(loss_scale * self._multiplier,
+                                 self._max_loss_scale), loss_scale),
+            math_ops.maximum(loss_scale / self._multiplier,
+                             self._min_loss_scale))
+        new_good_steps = array_ops.where(
+            math_ops.logical_and(is_finite, math_ops.logical_not(increase)),
+            good_steps, array_ops.zeros_like(good_steps))
+        return control_flow_ops.group(
+            state_ops.assign(self._loss_scale, new_loss_scale),
+            state_ops.assign(self._good_steps, new_good_steps))
+
+  def get_slot(self, *args, **kwargs):
+    """Return a slot named "name" created for "var" by the Optimizer.
+
+    This simply wraps the get_slot() from the actual optimizer.
+
+    Args:
+      *args: Arguments for get_slot().
+      **kwargs: Keyword arguments for get_slot().
+
+    Returns:
+      The `Variable` for the slot if it was created, `None` otherwise.
+    """
+    return self._opt.get_slot(*args, **kwargs)
+
+  def get_slot_names(self, *args, **kwargs):
+    """Return a list of the names of slots created by the `Optimizer`.
+
+    This simply wraps the get_slot_names() from the actual optimizer.
+
+    Args:
+      *args: Arguments for get_slot().
+      **kwargs: Keyword arguments for get_slot().
+
+    Returns:
+      A list of strings.
+    """
+    return self._opt.get_slot_names(*args, **kwargs)
+
+  def variables(self):
+    """The variables of the underlying optimizer and the loss scale state."""
+    loss_scale_variables = []
+    if self._loss_scale is not None:
+      loss_scale_variables = [self._loss_scale, self._good_steps]
+    return self._opt.variables() + loss_scale_variables
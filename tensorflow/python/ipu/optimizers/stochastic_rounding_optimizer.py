@@ -0,0 +1,203 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+"""
+Optimizers with float16 state written with stochastic rounding
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+"""
+
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ipu import scopes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import state_ops
+from tensorflow.python.training import adam
+
+
+class AdamStochasticRoundingOptimizer(adam.AdamOptimizer):
+  """An Adam optimizer which keeps its moments in float16.
+
+  The update of each variable is computed in float32 from the float16 moments,
+  variable and gradient. Only the writes of the new moments and of the new
+  value of the variable are rounded stochastically to their types, so that the
+  small updates of float16 variables and moments do not always round to
+  nothing. This halves the memory of the optimizer state compared to float32
+  moments, and allows the variables themselves to be float16.
+
+  The update of each variable is a single element-wise computation, which the
+  IPU performs in one pass over the variable and its moments.
+
+  Stochastic rounding is enabled for the state writes only, with
+  `ipu.scopes.stochastic_rounding`, whatever the global
+  `FloatingPointBehaviour` is.
+  """
+  def __init__(self,
+               learning_rate=0.001,
+               beta1=0.9,
+               beta2=0.999,
+               epsilon=1e-8,
+               state_dtype=dtypes.float16,
+               use_locking=False,
+               name="AdamStochasticRounding"):
+    """Construct an AdamStochasticRoundingOptimizer.
+
+    Args:
+      learning_rate: A Tensor or a floating point value. The learning rate.
+      beta1: A float value or a constant float tensor. The exponential decay
+        rate for the 1st moment estimates.
+      beta2: A float value or a constant float tensor. The exponential decay
+        rate for the 2nd moment estimates.
+      epsilon: A small constant for numerical stability.
+      state_dtype: The type of the moments, float16 or float32.
+      use_locking: If True use locks for update operations.
+      name: Optional name for the operations created when applying gradients.
+    """
+    super(AdamStochasticRoundingOptimizer,
+          self).__init__(learning_rate, beta1, beta2, epsilon, use_locking,
+                         name)
+    self._state_dtype = dtypes.as_dtype(state_dtype)
+    if self._state_dtype not in (dtypes.float16, dtypes.float32):
+      raise ValueError(
+          "state_dtype must be float16 or float32, but it is {}".format(
+              self._state_dtype.name))
+
+  def _create_slots(self, var_list):
+    # The beta accumulators are created as in AdamOptimizer, but the moments
+    # are created with the state type.
+    first_var = min(var_list, key=lambda x: x.name)
+    self._create_non_slot_variable(initial_value=self._beta1,
+                                   name="beta1_power",
+                                   colocate_with=first_var)
+    self._create_non_slot_variable(initial_value=self._beta2,
+                                   name="beta2_power",
+                                   colocate_with=first_var)
+
+    for v in var_list:
+      for slot_name in ["m", "v"]:
+        self._get_or_make_slot_with_initializer(v, init_ops.zeros_initializer(),
+                                                v.get_shape(),
+                                                self._state_dtype, slot_name,
+                                                self._name)
+
+  def _compute_update(self, var, m, v):  # pylint: disable=unused-argument
+    """Returns the float32 update which is subtracted from the float32 `var`,
+    given the new float32 moments `m` and `v`."""
+    beta1_power, beta2_power = self._get_beta_accumulators()
+    lr = math_ops.cast(self._lr_t, dtypes.float32)
+    epsilon = math_ops.cast(self._epsilon_t, dtypes.float32)
+    lr = lr * math_ops.sqrt(1 - math_ops.cast(beta2_power, dtypes.float32)) / (
+        1 - math_ops.cast(beta1_power, dtypes.float32))
+    return lr * m / (math_ops.sqrt(v) + epsilon)
+
+  def _apply_dense_shared(self, grad, var):
+    m = self.get_slot(var, "m")
+    v = self.get_slot(var, "v")
+    beta1 = math_ops.cast(self._beta1_t, dtypes.float32)
+    beta2 = math_ops.cast(self._beta2_t, dtypes.float32)
+
+    grad = math_ops.cast(grad, dtypes.float32)
+    m_t = beta1 * math_ops.cast(m, dtypes.float32) + (1 - beta1) * grad
+    v_t = beta2 * math_ops.cast(v, dtypes.float32) + (1 - beta2) * grad * grad
+    var_t = math_ops.cast(var, dtypes.float32)
+    var_t -= self._compute_update(var_t, m_t, v_t)
+
+    with scopes.stochastic_rounding(True):
+      m_update = state_ops.assign(m,
+                                  math_ops.cast(m_t, m.dtype.base_dtype),
+                                  use_locking=self._use_locking)
+      v_update = state_ops.assign(v,
+                                  math_ops.cast(v_t, v.dtype.base_dtype),
+                                  use_locking=self._use_locking)
+      var_update = state_ops.assign(var,
+                                    math_ops.cast(var_t, var.dtype.base_dtype),
+                                    use_locking=self._use_locking)
+    return control_flow_ops.group(var_update, m_update, v_update)
+
+  def _apply_dense(self, grad, var):
+    return self._apply_dense_shared(grad, var)
+
+  def _resource_apply_dense(self, grad, var):
+    return self._apply_dense_shared(grad, var)
+
+  def _apply_sparse(self, grad, var):
+    return self._apply_dense_shared(
+        math_ops.unsorted_segment_sum(grad.values, grad.indices,
+                                      var.get_shape()[0]), var)
+
+  def _resource_apply_sparse(self, grad, var, indices):
+    return self._apply_dense_shared(
+        math_ops.unsorted_segment_sum(grad, indices, var.get_shape()[0]), var)
+
+
+class LAMBStochasticRoundingOptimizer(AdamStochasticRoundingOptimizer):
+  """A LAMB optimizer which keeps its moments in float16.
+
+  LAMB scales the Adam update of each variable, including a weight decay, by
+  the ratio of the norm of the variable to the norm of the update, which
+  allows large batch sizes. See https://arxiv.org/abs/1904.00962.
+
+  As with `AdamStochasticRoundingOptimizer`, the update is computed in
+  float32, and the writes of the new moments and variable values are rounded
+  stochastically to their types.
+  """
+  def __init__(self,
+               learning_rate=0.001,
+               beta1=0.9,
+               beta2=0.999,
+               epsilon=1e-6,
+               weight_decay_rate=0.0,
+               state_dtype=dtypes.float16,
+               use_locking=False,
+               name="LAMBStochasticRounding"):
+    """Construct a LAMBStochasticRoundingOptimizer.
+
+    Args:
+      learning_rate: A Tensor or a floating point value. The learning rate.
+      beta1: A float value or a constant float tensor. The exponential decay
+        rate for the 1st moment estimates.
+      beta2: A float value or a constant float tensor. The exponential decay
+        rate for the 2nd moment estimates.
+      epsilon: A small constant for numerical stability.
+      weight_decay_rate: The weight decay rate, which is added to the Adam
+        update before it is scaled by the trust ratio.
+      state_dtype: The type of the moments, float16 or float32.
+      use_locking: If True use locks for update operations.
+      name: Optional name for the operations created when applying gradients.
+    """
+    super(LAMBStochasticRoundingOptimizer,
+          self).__init__(learning_rate, beta1, beta2, epsilon, state_dtype,
+                         use_locking, name)
+    self._weight_decay_rate = weight_decay_rate
+
+  def _compute_update(self, var, m, v):
+    beta1_power, beta2_power = self._get_beta_accumulators()
+    lr = math_ops.cast(self._lr_t, dtypes.float32)
+    epsilon = math_ops.cast(self._epsilon_t, dtypes.float32)
+    m_hat = m / (1 - math_ops.cast(beta1_power, dtypes.float32))
+    v_hat = v / (1 - math_ops.cast(beta2_power, dtypes.float32))
+
+    update = m_hat / (math_ops.sqrt(v_hat) + epsilon)
+    if self._weight_decay_rate:
+      update += self._weight_decay_rate * var
+
+    # The trust ratio is 1 when either norm is 0, e.g. for variables
+    # initialised to zero.
+    var_norm = math_ops.sqrt(math_ops.reduce_sum(var * var))
+    update_norm = math_ops.sqrt(math_ops.reduce_sum(update * update))
+    trust_ratio = array_ops.where(
+        math_ops.logical_and(var_norm > 0, update_norm > 0),
+        math_ops.div_no_nan(var_norm, update_norm), 1.0)
+    return lr * trust_ratio * update
@@ -0,0 +1,106 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+import numpy as np
+
+from tensorflow.python.client import session as se
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python import ipu
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gradients_impl
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import googletest
+
+block_size = [8, 8, 8]
+m = 16
+sparsity_mask = np.array([[1, 0, 0, 1], [0, 1, 0, 0], [1, 1, 0, 1]])
+k = sparsity_mask.shape[0] * block_size[1]
+n = sparsity_mask.shape[1] * block_size[2]
+
+
+def _dense_mask():
+  return np.kron(sparsity_mask, np.ones(block_size[1:]))
+
+
+class BlockSparseMatMulTest(test_util.TensorFlowTestCase):
+  def _run(self, dtype, tolerance):
+    np.random.seed(42)
+    a_value = np.random.rand(m, k).astype(dtype)
+    b_value = (np.random.rand(k, n) * _dense_mask()).astype(dtype)
+    grad_value = np.random.rand(m, n).astype(dtype)
+    blocks_value = ipu.ops.nn_ops.block_sparse_blocks(b_value, sparsity_mask,
+                                                      block_size)
+    self.assertEqual(blocks_value.shape, (np.count_nonzero(sparsity_mask),
+                                          block_size[1] * block_size[2]))
+
+    def model(a, blocks, grad):
+      output = ipu.ops.nn_ops.block_sparse_matmul(a, blocks, sparsity_mask,
+                                                  block_size)
+      return [output] + gradients_impl.gradients(
+          math_ops.reduce_sum(output * grad), [a, blocks])
+
+    with ops.device('cpu'):
+      a = array_ops.placeholder(dtype, shape=a_value.shape)
+      blocks = array_ops.placeholder(dtype, shape=blocks_value.shape)
+      grad = array_ops.placeholder(dtype, shape=grad_value.shape)
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(model, inputs=[a, blocks, grad])
+
+    with se.Session() as sess:
+      output, grad_a, grad_blocks = sess.run(r, {
+          a: a_value,
+          blocks: blocks_value,
+          grad: grad_value
+      })
+
+    # The block-sparse matmul is the dense matmul of the masked matrix, and the
+    # gradient of the blocks is the masked gradient of the dense matrix.
+    self.assertAllClose(output,
+                        np.matmul(a_value, b_value),
+                        rtol=tolerance,
+                        atol=tolerance)
+    self.assertAllClose(grad_a,
+                        np.matmul(grad_value, b_value.T),
+                        rtol=tolerance,
+                        atol=tolerance)
+    self.assertAllClose(grad_blocks,
+                        ipu.ops.nn_ops.block_sparse_blocks(
+                            np.matmul(a_value.T, grad_value), sparsity_mask,
+                            block_size),
+                        rtol=tolerance,
+                        atol=tolerance)
+
+  @test_util.deprecated_graph_mode_only
+  def testBlockSparseMatMul(self):
+    self._run(np.float32, 1e-5)
+
+  @test_util.deprecated_graph_mode_only
+  def testBlockSparseMatMulHalf(self):
+    self._run(np.float16, 5e-2)
+
+  @test_util.deprecated_graph_mode_only
+  def testInvalidShapes(self):
+    with ops.device('cpu'):
+      a = array_ops.placeholder(np.float32, shape=[m, k + 1])
+      blocks = array_ops.placeholder(np.float32, shape=[6, 64])
+    with self.assertRaisesRegex(ValueError, "sparsity mask must have rank 2"):
+      ipu.ops.nn_ops.block_sparse_matmul(a, blocks, [1, 0], block_size)
+    with self.assertRaisesRegex(ValueError, "block size"):
+      ipu.ops.nn_ops.block_sparse_matmul(a, blocks, sparsity_mask, [8, 8])
+
+
+if __name__ == "__main__":
+  googletest.main()
@@ -60,6 +60,35 @@ class DatasetBenchmarkTest(test_util.TensorFlowTestCase):
         for field in x:
           self.assertAllGreater(x[field], 0.0)
 
+  @test_util.deprecated_graph_mode_only
+  def testWithInfeedOnDevice(self):
+    dataset = tu.create_single_increasing_dataset(10, shape=[4, 4])
+    infeed_queue = ipu.ipu_infeed_queue.IPUInfeedQueue(dataset, next_feed_id())
+    benchmark_op = ipu.dataset_benchmark.infeed_device_benchmark(
+        infeed_queue, 100)
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.auto_select_ipus(cfg, 1)
+    ipu.utils.configure_ipu_system(cfg)
+
+    with self.session() as sess:
+      sess.run(infeed_queue.initializer)
+      j = json.loads(sess.run(benchmark_op))
+      self.assertAllEqual(set(j.keys()),
+                          {"producer", "queue", "callbacks", "transfer"})
+      self.assertAllGreaterEqual(j["producer"]["elements_produced"], 100)
+      # Poplar can prefetch elements beyond the last one which is dequeued.
+      copies = (j["callbacks"]["prefetch_count"] -
+                j["callbacks"]["prefetch_not_available_count"] +
+                j["callbacks"]["fetch_count"])
+      self.assertAllGreaterEqual(copies, 100)
+      self.assertAllEqual(j["transfer"]["bytes_transferred"],
+                          copies * 4 * 4 * 4)
+      samples = sum(b["samples"] for b in j["queue"]["occupancy_histogram"])
+      self.assertAllEqual(
+          samples,
+          j["callbacks"]["prefetch_count"] + j["callbacks"]["fetch_count"])
+
 
 if __name__ == "__main__":
   googletest.main()
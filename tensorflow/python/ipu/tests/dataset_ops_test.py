@@ -12,16 +12,25 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 # =============================================================================
+import os
+
 import numpy as np
 
 from tensorflow.compiler.plugin.poplar.tests import test_utils as tu
 from tensorflow.python import ipu
+from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import googletest
 from tensorflow.compat.v1 import data as compat_v1_data
 
 
+def _range_dataset():
+  # Defined at the top level so that it can be passed to the workers.
+  return dataset_ops.Dataset.range(10).map(lambda x: (x, x * x))
+
+
 class DatasetOpsTest(test_util.TensorFlowTestCase):
   @test_util.deprecated_graph_mode_only
   def testBufferDataset(self):
@@ -37,6 +46,119 @@ class DatasetOpsTest(test_util.TensorFlowTestCase):
       with self.assertRaises(errors.OutOfRangeError):
         self.evaluate(sess.run(next_data))
 
+  @test_util.deprecated_graph_mode_only
+  def testMappedCacheDataset(self):
+    filename = os.path.join(self.get_temp_dir(), "cache")
+
+    def make_dataset(shuffle=False):
+      dataset = dataset_ops.Dataset.range(10).map(
+          lambda x: (x, array_ops.fill([3], x)))
+      return ipu.data.ops.dataset_ops.MappedCacheDataset(dataset,
+                                                         filename,
+                                                         shuffle=shuffle,
+                                                         seed=1)
+
+    # The first iteration writes the cache and the second one reads it.
+    for _ in range(2):
+      itr = compat_v1_data.make_one_shot_iterator(make_dataset())
+      next_data = itr.get_next()
+      with self.session() as sess:
+        for i in range(10):
+          index, values = sess.run(next_data)
+          self.assertEqual(index, i)
+          self.assertAllEqual(values, [i, i, i])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(next_data)
+    self.assertTrue(os.path.exists(filename + ".index"))
+
+    # A shuffled read has all the elements, in a different order.
+    itr = compat_v1_data.make_one_shot_iterator(make_dataset(shuffle=True))
+    next_data = itr.get_next()
+    with self.session() as sess:
+      indices = [sess.run(next_data)[0] for _ in range(10)]
+      self.assertNotEqual(indices, list(range(10)))
+      self.assertAllEqual(sorted(indices), list(range(10)))
+
+  def testMappedCacheDatasetDynamicShape(self):
+    dataset = dataset_ops.Dataset.range(10).batch(3)
+    with self.assertRaisesRegex(TypeError, "static shapes"):
+      ipu.data.ops.dataset_ops.MappedCacheDataset(dataset, "cache")
+
+  @test_util.deprecated_graph_mode_only
+  def testSequencePackingDataset(self):
+    def gen():
+      for length in [3, 5, 2, 4]:
+        yield np.arange(1, length + 1, dtype=np.int32)
+
+    dataset = dataset_ops.Dataset.from_generator(gen, np.int32, [None])
+    dataset = ipu.data.ops.dataset_ops.SequencePackingDataset(dataset, 8)
+    itr = compat_v1_data.make_one_shot_iterator(dataset)
+
+    next_data = itr.get_next()
+    with self.session() as sess:
+      # The 5 and 3 long sequences fill the first pack.
+      tokens, segments, positions = sess.run(next_data)
+      self.assertAllEqual(tokens, [1, 2, 3, 1, 2, 3, 4, 5])
+      self.assertAllEqual(segments, [1, 1, 1, 2, 2, 2, 2, 2])
+      self.assertAllEqual(positions, [0, 1, 2, 0, 1, 2, 3, 4])
+      # The 4 and 2 long sequences are padded.
+      tokens, segments, positions = sess.run(next_data)
+      self.assertAllEqual(tokens, [1, 2, 1, 2, 3, 4, 0, 0])
+      self.assertAllEqual(segments, [1, 1, 2, 2, 2, 2, 0, 0])
+      self.assertAllEqual(positions, [0, 1, 0, 1, 2, 3, 0, 0])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_data)
+
+  @test_util.deprecated_graph_mode_only
+  def testSharedMemoryDataset(self):
+    dataset = ipu.data.ops.dataset_ops.SharedMemoryDataset(_range_dataset,
+                                                           num_workers=3,
+                                                           num_slots=2,
+                                                           slot_size=1024)
+    itr = compat_v1_data.make_one_shot_iterator(dataset)
+
+    next_data = itr.get_next()
+    with self.session() as sess:
+      # The elements of the shards come in the order of the whole dataset.
+      for i in range(10):
+        self.assertAllEqual(sess.run(next_data), (i, i * i))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_data)
+
+  def testSharedMemoryDatasetStrings(self):
+    def strings_dataset():
+      return dataset_ops.Dataset.from_tensors("a")
+
+    with self.assertRaisesRegex(TypeError, "numeric or boolean"):
+      ipu.data.ops.dataset_ops.SharedMemoryDataset(strings_dataset, 2)
+
+  @test_util.deprecated_graph_mode_only
+  def testVectorizedMap(self):
+    def map_func(x):
+      return x * 2, array_ops.fill([2], x)
+
+    def batched_map_func(x):
+      return x * 2, array_ops.tile(x[:, None], [1, 2])
+
+    for func, vectorizable in [(map_func, False), (batched_map_func, True)]:
+      dataset = dataset_ops.Dataset.range(10)
+      dataset = dataset.apply(
+          ipu.data.ops.dataset_ops.vectorized_map(func,
+                                                  4,
+                                                  num_parallel_calls=2,
+                                                  vectorizable=vectorizable))
+      itr = compat_v1_data.make_one_shot_iterator(dataset)
+
+      next_data = itr.get_next()
+      with self.session() as sess:
+        # The last batch only has two elements.
+        for i in range(10):
+          doubled, filled = sess.run(next_data)
+          self.assertEqual(doubled, 2 * i)
+          self.assertAllEqual(filled, [i, i])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(next_data)
+
 
 if __name__ == "__main__":
   googletest.main()
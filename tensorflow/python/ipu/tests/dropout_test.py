@@ -22,6 +22,7 @@ from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
 from tensorflow.python import ipu
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import googletest
 from tensorflow.python.training import gradient_descent
@@ -193,6 +194,26 @@ class PopnnRandomDropoutTest(test_util.TensorFlowTestCase,
       self.assertAllEqual(np.count_nonzero(dropout_out),
                           np.count_nonzero(gradients))
 
+  @parameterized.named_parameters(*TEST_CASES)
+  @test_util.deprecated_graph_mode_only
+  def testDropoutBackwardPassRegeneratesMask(self, rate, seed, noise_shape):
+    def _run_dropout(w):
+      output = self._ipu_dropout(w, rate, seed, noise_shape)[0]
+      # A second dropout of the same shape shares the layout of its mask.
+      output = self._ipu_dropout(output, rate, seed, noise_shape)[0]
+      gradients = gradients_impl.gradients(math_ops.reduce_sum(output), w)
+      return [output, gradients]
+
+    r, input_data = self._setup_test(_run_dropout)
+
+    with sl.Session() as sess:
+      in_data = np.random.rand(*DIMS) + 1.0
+      result = sess.run(r, {input_data: in_data})
+
+      # The masks regenerated from the seeds are the masks of the forward
+      # pass, so the kept elements of both passes are the same.
+      self.assertAllEqual(result[0] != 0, result[1][0] != 0)
+
   @parameterized.named_parameters(*TEST_CASES)
   @test_util.deprecated_graph_mode_only
   def testScaling(self, rate, seed, noise_shape):
@@ -0,0 +1,106 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+import numpy as np
+
+from tensorflow.python import ipu
+from tensorflow.python.client import session as sl
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import variable_scope
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import googletest
+from tensorflow.python.training import gradient_descent as gd
+from tensorflow.python.ipu.optimizers import dynamic_loss_scale_optimizer
+
+
+class DynamicLossScaleOptimizerTest(test_util.TensorFlowTestCase):
+  def _run(self, num_iterations, factor, **kwargs):
+    """Runs `num_iterations` steps of gradient descent on `factor * w`, where
+    `w` is a float16 variable initialised to 1, and returns the value of `w`
+    and the loss scale."""
+    opt = dynamic_loss_scale_optimizer.DynamicLossScaleOptimizer(
+        gd.GradientDescentOptimizer(0.1), **kwargs)
+
+    def body():
+      with variable_scope.variable_scope("vs", use_resource=True):
+        w = variable_scope.get_variable("w",
+                                        initializer=np.float16(1.0),
+                                        dtype=np.float16)
+      loss = w * np.float16(factor)
+      return opt.minimize(loss)
+
+    def my_net():
+      return ipu.loops.repeat(num_iterations, body)
+
+    with ops.device("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(my_net)
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    cfg = ipu.utils.set_floating_point_behaviour_options(cfg,
+                                                         inv=False,
+                                                         div0=False,
+                                                         oflo=False)
+    ipu.utils.configure_ipu_system(cfg)
+    ipu.utils.move_variable_initialization_to_cpu()
+
+    with sl.Session() as sess:
+      sess.run(variables.global_variables_initializer())
+      sess.run(r)
+      with variable_scope.variable_scope("vs", reuse=True):
+        w = variable_scope.get_variable("w", dtype=np.float16)
+      return sess.run([w, opt.loss_scale])
+
+  @test_util.deprecated_graph_mode_only
+  def testGradientsAreUnscaled(self):
+    w, loss_scale = self._run(2, 1.0, initial_loss_scale=1024.)
+    self.assertAllClose(w, 0.8, rtol=1e-3)
+    self.assertEqual(loss_scale, 1024.)
+
+  @test_util.deprecated_graph_mode_only
+  def testOverflowSkipsTheUpdate(self):
+    # The scaled gradients overflow float16 until the loss scale has been
+    # halved twice, so only the last step updates the weight.
+    w, loss_scale = self._run(3, 4.0, initial_loss_scale=2.**15)
+    self.assertAllClose(w, 0.6, rtol=1e-3)
+    self.assertEqual(loss_scale, 2.**13)
+
+  @test_util.deprecated_graph_mode_only
+  def testLossScaleIncreases(self):
+    _, loss_scale = self._run(5,
+                              1.0,
+                              initial_loss_scale=16.,
+                              increase_period=2,
+                              max_loss_scale=32.)
+    # The loss scale is doubled after two steps, and is then clamped.
+    self.assertEqual(loss_scale, 32.)
+
+  def testInvalidParameters(self):
+    opt = gd.GradientDescentOptimizer(0.1)
+    with self.assertRaisesRegex(ValueError, "increase_period"):
+      dynamic_loss_scale_optimizer.DynamicLossScaleOptimizer(
+          opt, increase_period=0)
+    with self.assertRaisesRegex(ValueError, "multiplier"):
+      dynamic_loss_scale_optimizer.DynamicLossScaleOptimizer(opt,
+                                                             multiplier=1.)
+    with self.assertRaisesRegex(ValueError, "initial_loss_scale"):
+      dynamic_loss_scale_optimizer.DynamicLossScaleOptimizer(
+          opt, initial_loss_scale=0.5)
+
+
+if __name__ == "__main__":
+  googletest.main()
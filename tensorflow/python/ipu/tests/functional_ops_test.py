@@ -520,5 +520,44 @@ class FunctionalOpsTest(test_util.TensorFlowTestCase):
       self.assertAllClose(result[0], np.broadcast_to(0., [64, 64]))
 
 
+
+  @test_util.deprecated_graph_mode_only
+  def testBatchSizeVariants(self):
+    with tu.ipu_session() as sess:
+
+      def body(x, index):
+        def func(x):
+          with variable_scope.variable_scope("vs", use_resource=True):
+            w = variable_scope.get_variable(
+                "w",
+                shape=[4, 4],
+                dtype=np.float32,
+                initializer=init_ops.ones_initializer())
+          return math_ops.matmul(x, w)
+
+        return ipu.functional_ops.batch_size_variants(func, [x], index,
+                                                      [1, 4, 16])
+
+      with ops.device('cpu'):
+        x = array_ops.placeholder(np.float32, [16, 4])
+        index = array_ops.placeholder(np.int32, [])
+
+      with ipu.scopes.ipu_scope("/device:IPU:0"):
+        res = ipu.ipu_compiler.compile(body, inputs=[x, index])
+
+      tu.move_variable_initialization_to_cpu()
+      sess.run(variables.global_variables_initializer())
+
+      inputs = np.ones([16, 4], np.float32)
+      for i, batch_size in enumerate([1, 4, 16]):
+        result = sess.run(res, {x: inputs, index: i})
+        expected = np.zeros([16, 4], np.float32)
+        expected[:batch_size] = 4.0
+        self.assertAllClose(result[0], expected)
+
+    with self.assertRaisesRegex(ValueError, "increasing batch sizes"):
+      ipu.functional_ops.batch_size_variants(lambda x: x, [x], index, [4, 1])
+
+
 if __name__ == "__main__":
   googletest.main()
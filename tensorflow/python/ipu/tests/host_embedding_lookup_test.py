@@ -13,14 +13,18 @@
 # limitations under the License.
 # ==============================================================================
 
+import os
 import numpy as np
 
 from tensorflow.compiler.plugin.poplar.tests import test_utils as tu
 from tensorflow.python import ipu
 from tensorflow.python.client import session as sl
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import init_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.platform import googletest
@@ -30,6 +34,11 @@ from tensorflow.python.training import gradient_descent as gd
 from tensorflow.compiler.plugin.poplar.ops import gen_pop_datastream_ops
 
 
+def _deduplicate_indices(cfg):
+  return ipu.utils.set_experimental_host_embedding_cache_options(
+      cfg, 0, max_misses=128, deduplicate=True)
+
+
 class HostEmbeddingLookupTest(test_util.TensorFlowTestCase):
   @test_util.deprecated_graph_mode_only
   def testDIENShape(self):
@@ -139,6 +148,185 @@ class HostEmbeddingLookupTest(test_util.TensorFlowTestCase):
       report.parse_log()
       report.assert_max_tile_memory(5852, tolerance=0.3)
 
+  def _runRepeatedIndices(self, num_distinct=1000, set_opts_fn=None):
+    shape = [1000, 64]
+    lookup_count = 4096
+
+    def my_net(i):
+      # lookup
+      out = gen_pop_datastream_ops.ipu_device_embedding_lookup(
+          i,
+          embedding_id="host_embedding",
+          embedding_shape=shape,
+          dtype=np.float32)
+
+      # update
+      gen_pop_datastream_ops.ipu_device_embedding_update_add(
+          out, out, i, embedding_id="host_embedding", embedding_shape=shape)
+
+      return out
+
+    with ops.device('cpu'):
+      i = array_ops.placeholder(np.int32, [lookup_count])
+      w = variable_scope.get_variable("foo",
+                                      dtype=np.float32,
+                                      shape=shape,
+                                      use_resource=False)
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(my_net, inputs=[i])
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    if set_opts_fn:
+      cfg = set_opts_fn(cfg)
+    ipu.utils.configure_ipu_system(cfg)
+    with sl.Session() as sess:
+      # Every row is looked up a different number of times.
+      i_h = np.random.randint(0, num_distinct, size=[lookup_count])
+
+      sess.run(variables.global_variables_initializer())
+      w_h = sess.run(w)
+      sess.run(
+          gen_pop_datastream_ops.ipu_host_embedding_register(
+              w, "host_embedding"))
+      result = sess.run([r], {i: i_h})
+      v = sess.run(
+          gen_pop_datastream_ops.ipu_host_embedding_deregister(
+              w, "host_embedding"))
+
+      self.assertAllClose(result[0][0], np.take(w_h, i_h, axis=0))
+      # Each row receives its own value once for every time it was looked up.
+      counts = np.bincount(i_h, minlength=shape[0]).reshape([shape[0], 1])
+      self.assertAllClose(w_h * (1 + counts), v)
+
+  @test_util.deprecated_graph_mode_only
+  def testRepeatedIndices(self):
+    self._runRepeatedIndices()
+
+  @test_util.deprecated_graph_mode_only
+  def testDeduplicatedRepeatedIndices(self):
+    # Only the rows of the 100 distinct indices are transferred.
+    self._runRepeatedIndices(num_distinct=100,
+                             set_opts_fn=_deduplicate_indices)
+
+  @test_util.deprecated_graph_mode_only
+  def testDeduplicatedTooManyDistinctIndices(self):
+    # All the rows are transferred when there are more distinct indices than
+    # `max_misses`.
+    self._runRepeatedIndices(set_opts_fn=_deduplicate_indices)
+
+  def _runSlotOptimizer(self, optimizer, slot_dtype, slot_initial_value,
+                        **attrs):
+    shape = [1000, 64]
+    lookup_count = 512
+    learning_rate = 0.1
+
+    def my_net(i):
+      # lookup
+      out = gen_pop_datastream_ops.ipu_device_embedding_lookup(
+          i,
+          embedding_id="host_embedding",
+          embedding_shape=shape,
+          dtype=np.float32)
+
+      # update
+      gen_pop_datastream_ops.ipu_device_embedding_update_add(
+          out, out, i, embedding_id="host_embedding", embedding_shape=shape)
+
+      return out
+
+    num_slots = 2 if optimizer == "Adam" else 1
+    with ops.device('cpu'):
+      i = array_ops.placeholder(np.int32, [lookup_count])
+      w = variable_scope.get_variable("foo",
+                                      dtype=np.float32,
+                                      shape=shape,
+                                      use_resource=False)
+      slots = [
+          variable_scope.get_variable(
+              "slot" + str(n),
+              dtype=slot_dtype,
+              shape=shape,
+              initializer=init_ops.constant_initializer(slot_initial_value),
+              use_resource=False) for n in range(num_slots)
+      ]
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(my_net, inputs=[i])
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    ipu.utils.configure_ipu_system(cfg)
+    with sl.Session() as sess:
+      i_h = np.random.permutation(shape[0])[:lookup_count]
+
+      sess.run(variables.global_variables_initializer())
+      w_h = sess.run(w)
+      sess.run(
+          gen_pop_datastream_ops.ipu_host_embedding_register_with_slots(
+              w,
+              slots,
+              "host_embedding",
+              optimizer=optimizer,
+              learning_rate=learning_rate,
+              **attrs))
+      sess.run([r], {i: i_h})
+      v = sess.run(
+          gen_pop_datastream_ops.ipu_host_embedding_deregister(
+              w, "host_embedding"))
+      slots_h = sess.run(slots)
+
+      # Rows which were not looked up must not change.
+      untouched = np.setdiff1d(np.arange(shape[0]), i_h)
+      self.assertAllEqual(np.take(w_h, untouched, axis=0),
+                          np.take(v, untouched, axis=0))
+      for slot_h in slots_h:
+        self.assertAllEqual(
+            np.take(slot_h, untouched, axis=0),
+            np.full([len(untouched), shape[1]], slot_initial_value,
+                    slot_dtype))
+
+      return learning_rate, np.take(w_h, i_h, axis=0), np.take(
+          v, i_h, axis=0), [np.take(s, i_h, axis=0) for s in slots_h]
+
+  @test_util.deprecated_graph_mode_only
+  def testAdagradSlots(self):
+    lr, w, v, slots = self._runSlotOptimizer("Adagrad", np.float32, 0.1)
+    # The gradient is the looked up value.
+    accumulator = 0.1 + w * w
+    self.assertAllClose(slots[0], accumulator)
+    self.assertAllClose(v, w - lr * w / np.sqrt(accumulator))
+
+  @test_util.deprecated_graph_mode_only
+  def testMomentumSlots(self):
+    lr, w, v, slots = self._runSlotOptimizer("Momentum",
+                                             np.float32,
+                                             0.0,
+                                             momentum=0.9)
+    self.assertAllClose(slots[0], w)
+    self.assertAllClose(v, w - lr * w)
+
+  @test_util.deprecated_graph_mode_only
+  def testAdagradHalfSlots(self):
+    lr, w, v, slots = self._runSlotOptimizer("Adagrad", np.float16, 0.1)
+    accumulator = 0.1 + w * w
+    self.assertAllClose(slots[0], accumulator, rtol=1e-3, atol=1e-3)
+    self.assertAllClose(v,
+                        w - lr * w / np.sqrt(accumulator),
+                        rtol=1e-3,
+                        atol=1e-3)
+
+  @test_util.deprecated_graph_mode_only
+  def testAdamSlots(self):
+    lr, w, v, slots = self._runSlotOptimizer("Adam", np.float32, 0.0)
+    m = 0.1 * w
+    s = 0.001 * w * w
+    lr_t = lr * np.sqrt(1 - 0.999) / (1 - 0.9)
+    self.assertAllClose(slots[0], m)
+    self.assertAllClose(slots[1], s)
+    self.assertAllClose(v, w - lr_t * m / (np.sqrt(s) + 1e-8))
+
   @test_util.deprecated_graph_mode_only
   def testTrainNoExec(self):
     shape = [100000, 200]
@@ -217,6 +405,82 @@ class HostEmbeddingLookupTest(test_util.TensorFlowTestCase):
       # Check the indices are correct, but the real test is no timeout.
       self.assertAllClose(result[0][0], i_h)
 
+  @test_util.deprecated_graph_mode_only
+  def testMappedTable(self):
+    shape = [1000, 64]
+    lookup_count = 256
+    lr = 0.5
+
+    path = os.path.join(self.get_temp_dir(), "mapped_table.emb")
+    w_h = np.random.rand(*shape).astype(np.float32)
+    embedding_ops.write_host_embedding_table(path, w_h)
+
+    host_embedding = embedding_ops.MappedHostEmbedding(
+        "my_host_embedding",
+        path,
+        shape,
+        np.float32,
+        optimizer_spec=embedding_ops.HostEmbeddingOptimizerSpec(lr))
+
+    def my_net(i):
+      out = host_embedding.lookup(i)
+      loss = math_ops.reduce_sum(out)
+      train = gd.GradientDescentOptimizer(lr).minimize(loss)
+      return out, train
+
+    with ops.device('cpu'):
+      i = array_ops.placeholder(np.int32, [lookup_count])
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(my_net, inputs=[i])
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    ipu.utils.configure_ipu_system(cfg)
+    with sl.Session() as sess:
+      i_h = np.random.permutation(shape[0])[:lookup_count].astype(np.int32)
+
+      with host_embedding.register(sess):
+        result = sess.run(r, {i: i_h})
+      self.assertAllClose(result[0], np.take(w_h, i_h, axis=0))
+
+      # The updates are read back from the log when the table is mapped again
+      # and the table file is unchanged.
+      with host_embedding.register(sess):
+        result = sess.run(r, {i: i_h})
+      self.assertAllClose(result[0], np.take(w_h, i_h, axis=0) - lr)
+      self.assertTrue(os.path.exists(path + ".log"))
+
+      embedding_ops.write_host_embedding_table(path + ".copy", w_h)
+      with open(path, "rb") as f, open(path + ".copy", "rb") as g:
+        self.assertEqual(f.read(), g.read())
+
+  @test_util.deprecated_graph_mode_only
+  def testMappedTableWrongShape(self):
+    path = os.path.join(self.get_temp_dir(), "wrong_shape.emb")
+    embedding_ops.write_host_embedding_table(
+        path, np.zeros([10, 4], dtype=np.float32))
+
+    host_embedding = embedding_ops.MappedHostEmbedding(
+        "my_host_embedding", path, [10, 8], np.float32)
+
+    with self.assertRaisesRegex(ValueError, "does not support optimizers"):
+      embedding_ops.MappedHostEmbedding(
+          "my_host_embedding",
+          path, [10, 4],
+          np.float32,
+          optimizer_spec=embedding_ops.HostEmbeddingAdagradOptimizerSpec(0.1))
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    ipu.utils.configure_ipu_system(cfg)
+    with sl.Session() as sess:
+      with self.assertRaisesRegex(errors.InvalidArgumentError,
+                                  "table was expected"):
+        with host_embedding.register(sess):
+          pass
+
+
 
 if __name__ == "__main__":
   googletest.main()
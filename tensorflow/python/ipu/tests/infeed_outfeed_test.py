@@ -13,10 +13,13 @@
 # limitations under the License.
 # =============================================================================
 
+import json
+import os
 from threading import Thread
 import numpy as np
 
 from tensorflow.compiler.plugin.poplar.tests import test_utils as tu
+from tensorflow.core.framework import tensor_pb2
 from tensorflow.python import ipu
 from tensorflow.python.client import session as session_lib
 from tensorflow.python.data.ops import dataset_ops
@@ -24,8 +27,10 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import errors_impl
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_util
 from tensorflow.python.framework import test_util
 from tensorflow.python.keras import layers
+from tensorflow.python.lib.io import tf_record
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import init_ops
 from tensorflow.python.ops import lookup_ops
@@ -573,6 +578,111 @@ class InfeedOutfeedTest(test_util.TensorFlowTestCase):
       self.assertAllClose(outfed[-1], result[0])
       self.assertAllClose(outfed[5], np.broadcast_to(16, [4, 4]))
 
+  @test_util.deprecated_graph_mode_only
+  def testSingleInfeedOutfeedRepeatDoubleBuffered(self):
+    dataset = tu.create_single_increasing_dataset(10, shape=[4, 4])
+
+    infeed_queue = ipu.ipu_infeed_queue.IPUInfeedQueue(dataset, next_feed_id())
+    outfeed_queue = ipu.ipu_outfeed_queue.IPUOutfeedQueue(next_feed_id())
+
+    def body(v, x):
+      v = v + x
+      outfeed = outfeed_queue.enqueue(v)
+      return (v, outfeed)
+
+    def my_net(v):
+      r = ipu.loops.repeat(20, body, (v), infeed_queue)
+      return r
+
+    with ops.device('cpu'):
+      v = array_ops.placeholder(np.float32, [4, 4])
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      res = ipu.ipu_compiler.compile(my_net, inputs=[v])
+
+    cfg = ipu.utils.create_ipu_config(profiling=True,
+                                      double_buffer_repeat_loop_feeds=True)
+    cfg = ipu.utils.auto_select_ipus(cfg, 1)
+    ipu.utils.configure_ipu_system(cfg)
+
+    with session_lib.Session() as sess:
+      tu.ReportJSON(self, sess, configure_device=False)
+      sess.run(infeed_queue.initializer)
+
+      # The elements of the infeed are consumed in order and the outfeed
+      # receives an element for each iteration, also over several runs.
+      result = sess.run(res, {v: np.ones([4, 4], np.float32)})
+      self.assertAllClose(result[0], np.broadcast_to(91, [4, 4]))
+      outfed = sess.run(outfeed_queue.dequeue())
+      self.assertEqual(outfed.shape, (20, 4, 4))
+      self.assertAllClose(outfed[-1], result[0])
+      self.assertAllClose(outfed[5], np.broadcast_to(16, [4, 4]))
+
+      result = sess.run(res, {v: np.zeros([4, 4], np.float32)})
+      self.assertAllClose(result[0], np.broadcast_to(90, [4, 4]))
+      outfed = sess.run(outfeed_queue.dequeue())
+      self.assertEqual(outfed.shape, (20, 4, 4))
+      self.assertAllClose(outfed[0], np.broadcast_to(0, [4, 4]))
+      self.assertAllClose(outfed[-1], result[0])
+
+  @test_util.deprecated_graph_mode_only
+  def testFeedQueueStatistics(self):
+    dataset = tu.create_single_increasing_dataset(10, shape=[4, 4])
+
+    infeed_queue = ipu.ipu_infeed_queue.IPUInfeedQueue(dataset, next_feed_id())
+    outfeed_queue = ipu.ipu_outfeed_queue.IPUOutfeedQueue(next_feed_id())
+
+    def body(v, x):
+      v = v + x
+      outfeed = outfeed_queue.enqueue(v)
+      return (v, outfeed)
+
+    def my_net(v):
+      r = ipu.loops.repeat(20, body, (v), infeed_queue)
+      return r
+
+    with ops.device('cpu'):
+      v = array_ops.placeholder(np.float32, [4, 4])
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      res = ipu.ipu_compiler.compile(my_net, inputs=[v])
+
+    outfed = outfeed_queue.dequeue()
+    with ops.device('cpu'):
+      infeed_statistics = infeed_queue.statistics
+      outfeed_statistics = outfeed_queue.statistics
+
+    cfg = ipu.utils.create_ipu_config(profiling=True)
+    cfg = ipu.utils.auto_select_ipus(cfg, 1)
+    ipu.utils.configure_ipu_system(cfg)
+
+    with session_lib.Session() as sess:
+      report = tu.ReportJSON(self, sess, configure_device=False)
+      sess.run(infeed_queue.initializer)
+      report.reset()
+
+      sess.run(res, {v: np.ones([4, 4], np.float32)})
+      sess.run(outfed)
+
+      # The infeed queue is popped once per iteration, and the producer can be
+      # ahead of the device.
+      infeed_json = json.loads(sess.run(infeed_statistics))
+      self.assertEqual(infeed_json["queue"]["pop_count"], 20)
+      self.assertGreaterEqual(infeed_json["queue"]["push_count"], 20)
+      self.assertGreater(infeed_json["queue"]["high_water_mark"], 0)
+
+      outfeed_json = json.loads(sess.run(outfeed_statistics))
+      self.assertEqual(outfeed_json["push_count"], 20)
+      self.assertEqual(outfeed_json["pop_count"], 20)
+
+      # The counters of the execution are in its trace event.
+      stats = ipu.utils.extract_feed_queue_stats(report.get_event_trace())
+      self.assertEqual(len(stats), 1)
+      feeds = stats[0][1]
+      self.assertEqual(feeds["infeeds"][infeed_queue._id]["pop_count"], 20)  # pylint: disable=protected-access
+      self.assertEqual(
+          feeds["outfeeds"][outfeed_queue._feed_name]["push_count"], 20)  # pylint: disable=protected-access
+
   @test_util.deprecated_graph_mode_only
   def testSingleInfeedOutfeedRepeatTuple(self):
     dataset = tu.create_single_increasing_dataset(3, shape=[4, 4])
@@ -1122,6 +1232,105 @@ class InfeedOutfeedTest(test_util.TensorFlowTestCase):
 
       self.assertEqual(total_outfeeds, 8 // b_count)
 
+  @test_util.deprecated_graph_mode_only
+  def testSingleOutfeedWithBatchingReduction(self):
+
+    b_count = 4
+
+    # The outfeeds of 8 fibonacci numbers, reduced in batches of 4.
+    reductions = [
+        (ipu.ipu_outfeed_queue.IPUOutfeedReduction.SUM, [11., 76.]),
+        (ipu.ipu_outfeed_queue.IPUOutfeedReduction.MEAN, [2.75, 19.]),
+        (ipu.ipu_outfeed_queue.IPUOutfeedReduction.MAX, [5., 34.]),
+    ]
+    for reduction, expected in reductions:
+      with ops.Graph().as_default():
+        outfeed_queue = ipu.ipu_outfeed_queue.IPUOutfeedQueue(
+            next_feed_id(),
+            io_batch_size=b_count,
+            reduction=reduction,
+            transfer_as_fp16=True)
+
+        def body(a, b):
+          c = a + b
+          outfeed = outfeed_queue.enqueue(c)
+          return (c, a, outfeed)
+
+        def my_net(a, b):
+          r = ipu.loops.repeat(8, body, (a, b))
+          return r
+
+        with ops.device('cpu'):
+          a = array_ops.placeholder(np.float32, [4])
+          b = array_ops.placeholder(np.float32, [4])
+
+        with ipu.scopes.ipu_scope("/device:IPU:0"):
+          res = ipu.ipu_compiler.compile(my_net, inputs=[a, b])
+
+        outfeed = outfeed_queue.dequeue()
+        with session_lib.Session() as sess:
+          tu.ReportJSON(self, sess)
+
+          fd = {a: [1., 1., 1., 1.], b: [0., 0., 0., 0.]}
+          result = sess.run(res, fd)
+          self.assertAllClose(result[0], [34., 34., 34., 34.])
+
+          # A single element is received for each batch.
+          outfed = sess.run(outfeed)
+          self.assertEqual(outfed.dtype, np.float32)
+          self.assertAllClose(outfed, [[x] * 4 for x in expected])
+
+  @test_util.deprecated_graph_mode_only
+  def testOutfeedToFiles(self):
+    for file_format in ipu.ipu_outfeed_queue.IPUOutfeedFileFormat:
+      with ops.Graph().as_default():
+        prefix = os.path.join(self.get_temp_dir(), file_format.value)
+        outfeed_queue = ipu.ipu_outfeed_queue.IPUOutfeedQueue(
+            next_feed_id(),
+            io_batch_size=2,
+            file_sink_prefix=prefix,
+            file_sink_format=file_format,
+            file_sink_elements_per_file=3)
+
+        def body(v):
+          v = v + 1
+          outfeed = outfeed_queue.enqueue((v, math_ops.reduce_sum(v)))
+          return (v, outfeed)
+
+        def my_net(v):
+          r = ipu.loops.repeat(4, body, (v))
+          return r
+
+        with ops.device('cpu'):
+          v = array_ops.placeholder(np.float32, [2])
+
+        with ipu.scopes.ipu_scope("/device:IPU:0"):
+          res = ipu.ipu_compiler.compile(my_net, inputs=[v])
+
+        with self.assertRaisesRegex(ValueError, "written to files"):
+          outfeed_queue.dequeue()
+
+        with session_lib.Session() as sess:
+          tu.ReportJSON(self, sess)
+          sess.run(res, {v: [0., 1.]})
+
+        # The 4 elements are written to files of 3 and 1 elements, with the
+        # tensors of each element in the order of the tuple.
+        extension = "tfrecord" if file_format.value == "tfrecord" else "bin"
+        values = []
+        for index in range(2):
+          path = "%s-%05d.%s" % (prefix, index, extension)
+          if file_format == ipu.ipu_outfeed_queue.IPUOutfeedFileFormat.RAW:
+            values.append(np.fromfile(path, np.float32))
+          else:
+            for record in tf_record.tf_record_iterator(path):
+              values.append(
+                  tensor_util.MakeNdarray(
+                      tensor_pb2.TensorProto.FromString(record)).flatten())
+        self.assertAllClose(
+            np.concatenate(values),
+            [1., 2., 3., 2., 3., 5., 3., 4., 7., 4., 5., 9.])
+
   @test_util.deprecated_graph_mode_only
   def testSingleOutfeedWithBatchingFinalNonTuple(self):
 
@@ -1585,6 +1794,51 @@ class InfeedOutfeedTest(test_util.TensorFlowTestCase):
       out = sess.run(dequeued)
       self.assertAllEqual(np.logical_and(left, right), np.concatenate(out))
 
+  @test_util.deprecated_graph_mode_only
+  def testNormalizeOnDevice(self):
+    images = np.arange(2 * 2 * 2 * 3, dtype=np.uint8).reshape([2, 2, 2, 3])
+    labels = np.array([3, 4], np.int32)
+    dataset = dataset_ops.Dataset.from_tensor_slices((images, labels))
+    dataset = dataset.batch(2, drop_remainder=True)
+
+    mean = [1., 2., 3.]
+    scale = 0.5
+    infeed_queue = ipu.ipu_infeed_queue.IPUInfeedQueue(
+        dataset,
+        next_feed_id(),
+        normalization=(ipu.ipu_infeed_queue.InfeedNormalization(
+            mean, scale, np.float32), None))
+    outfeed_queue = ipu.ipu_outfeed_queue.IPUOutfeedQueue(next_feed_id())
+
+    def body(image, label):
+      self.assertEqual(image.dtype, np.float32)
+      self.assertEqual(label.dtype, np.int32)
+      return outfeed_queue.enqueue((image, label))
+
+    def my_net():
+      return ipu.loops.repeat(1, body, infeed_queue=infeed_queue)
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      res = ipu.ipu_compiler.compile(my_net, inputs=[])
+
+    dequeued = outfeed_queue.dequeue()
+    with session_lib.Session() as sess:
+      sess.run(infeed_queue.initializer)
+      sess.run(res)
+      out_images, out_labels = sess.run(dequeued)
+      self.assertAllClose((images - mean) * scale, out_images[0])
+      self.assertAllEqual(labels, out_labels[0])
+
+  @test_util.deprecated_graph_mode_only
+  def testCannotNormalizeFloats(self):
+    dataset = dataset_ops.Dataset.from_tensor_slices(np.ones([4], np.float32))
+    with self.assertRaisesRegex(ValueError,
+                                "Only integer elements of an infeed"):
+      ipu.ipu_infeed_queue.IPUInfeedQueue(
+          dataset,
+          next_feed_id(),
+          normalization=ipu.ipu_infeed_queue.InfeedNormalization(1., 2.))
+
   @test_util.deprecated_graph_mode_only
   def testHashTableInDataPipeline(self):
     keys = constant_op.constant(["brain", "salad", "surgery"])
@@ -12,17 +12,21 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 # =============================================================================
+import os
 import time
 
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import test_util
 from tensorflow.python.ipu import ipu_compiler
 from tensorflow.python.ipu import loops
+from tensorflow.python.ipu.ipu_session_run_hooks import IPUAsyncCheckpointSaverHook
 from tensorflow.python.ipu.ipu_session_run_hooks import IPULoggingTensorHook
 from tensorflow.python.ipu.scopes import ipu_scope
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 from tensorflow.python.platform import tf_logging
+from tensorflow.python.training import checkpoint_management
+from tensorflow.python.training import checkpoint_utils
 from tensorflow.python.training.monitored_session import MonitoredTrainingSession
 from tensorflow.python import ops
 
@@ -270,5 +274,48 @@ class IPULoggingTensorHookTest(test_util.TensorFlowTestCase):
         self.assertRegex(logged_messages[4], r"hook2 = \[2 3\]")
 
 
+@test_util.deprecated_graph_mode_only
+class IPUAsyncCheckpointSaverHookTest(test_util.TensorFlowTestCase):
+  def test_illegal_args(self):
+    with self.assertRaisesRegex(
+        ValueError, "Exactly one of save_steps and save_secs should be"):
+      IPUAsyncCheckpointSaverHook(self.get_temp_dir())
+
+    with self.assertRaisesRegex(
+        ValueError, "Exactly one of save_steps and save_secs should be"):
+      IPUAsyncCheckpointSaverHook(self.get_temp_dir(),
+                                  save_steps=1,
+                                  save_secs=1)
+
+  def test_save_every_n_steps(self):
+    checkpoint_dir = self.get_temp_dir()
+    hook = IPUAsyncCheckpointSaverHook(checkpoint_dir,
+                                       save_steps=2,
+                                       max_to_keep=2)
+
+    def model():
+      counter = variables.Variable(0, name="counter")
+      return counter.assign_add(1).value()
+
+    with ipu_scope("/device:IPU:0"):
+      compiled_model = ipu_compiler.compile(model)
+
+    with MonitoredTrainingSession(hooks=[hook]) as mon_sess:
+      for _ in range(4):
+        mon_sess.run(compiled_model)
+
+    # Checkpoints are taken after steps 1 and 3, and at the end.
+    latest = checkpoint_management.latest_checkpoint(checkpoint_dir)
+    self.assertEqual(latest, os.path.join(checkpoint_dir, "model.ckpt-4"))
+    self.assertEqual(checkpoint_utils.load_variable(latest, "counter"), 4)
+
+    previous = os.path.join(checkpoint_dir, "model.ckpt-3")
+    self.assertEqual(checkpoint_utils.load_variable(previous, "counter"), 3)
+
+    # Only the two most recent checkpoints are kept.
+    self.assertFalse(
+        os.path.exists(os.path.join(checkpoint_dir, "model.ckpt-1.index")))
+
+
 if __name__ == "__main__":
   test.main()
@@ -263,5 +263,43 @@ class SerializedMatmulTest(test_util.TensorFlowTestCase,
       self.assertAllClose([l], [serial_l], atol=1.e-05, rtol=1.e-05)
 
 
+class QuantizedMatmulTest(test_util.TensorFlowTestCase,
+                          parameterized.TestCase):
+  @parameterized.named_parameters(('int8', np.int8, 0),
+                                  ('uint8', np.uint8, 128))
+  @test_util.deprecated_graph_mode_only
+  def testQuantizedMatmul(self, dtype, zero_point):
+    np.random.seed(0xDEADBEEF)
+    a_val = np.random.normal(0.0, 1.0, [8, 16]).astype(np.float16)
+    w_val = np.random.normal(0.0, 1.0, [16, 5]).astype(np.float32)
+    q_val, scale = ipu.math_ops.quantize_weights(w_val, dtype=dtype)
+    self.assertEqual(q_val.dtype, dtype)
+    self.assertEqual(scale.shape, (5,))
+
+    a = array_ops.placeholder(np.float16, [8, 16])
+
+    def model(a):
+      with variable_scope.variable_scope("vs", use_resource=True):
+        w = variable_scope.get_variable("w", initializer=q_val)
+      return ipu.math_ops.quantized_matmul(a,
+                                           w,
+                                           scale,
+                                           zero_point=zero_point)
+
+    with ipu.scopes.ipu_scope('/device:IPU:0'):
+      output = ipu.ipu_compiler.compile(model, [a])
+    ipu.utils.move_variable_initialization_to_cpu()
+
+    with sl.Session() as sess:
+      sess.run(variables.global_variables_initializer())
+      result = sess.run(output, {a: a_val})
+
+    dequantized = (q_val.astype(np.float32) - zero_point) * scale
+    expected = np.matmul(a_val.astype(np.float32), dequantized)
+    self.assertAllClose(expected, result[0], atol=1.e-02, rtol=1.e-02)
+    # The quantized weights should be close to the original ones.
+    self.assertAllClose(w_val, dequantized, atol=np.amax(scale))
+
+
 if __name__ == "__main__":
   googletest.main()
@@ -0,0 +1,107 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# =============================================================================
+import numpy as np
+
+from tensorflow.python.client import session as se
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python import ipu
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gradients_impl
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import nn
+from tensorflow.python.platform import googletest
+
+batch_size = 2
+num_heads = 3
+query_length = 5
+key_length = 7
+head_size = 4
+value_size = 6
+
+
+def _reference_attention(query, key, value, causal):
+  scores = math_ops.matmul(query, key, transpose_b=True) / np.sqrt(head_size)
+  if causal:
+    mask = np.triu(np.full([query_length, key_length], -10000.0), k=1)
+    scores += mask.astype(scores.dtype.as_numpy_dtype)
+  return math_ops.matmul(nn.softmax(scores), value)
+
+
+def _attention_and_gradients(attention_fn, causal):
+  def fn(query, key, value, grad):
+    output = attention_fn(query, key, value, causal)
+    gradients = gradients_impl.gradients(math_ops.reduce_sum(output * grad),
+                                         [query, key, value])
+    return [output] + gradients
+
+  return fn
+
+
+def _ipu_attention(query, key, value, causal):
+  return ipu.ops.nn_ops.multi_head_attention(query, key, value, causal=causal)
+
+
+class MultiHeadAttentionTest(test_util.TensorFlowTestCase):
+  def _run(self, causal, dtype, tolerance):
+    np.random.seed(42)
+    query_shape = [batch_size, num_heads, query_length, head_size]
+    key_shape = [batch_size, num_heads, key_length, head_size]
+    value_shape = [batch_size, num_heads, key_length, value_size]
+    output_shape = [batch_size, num_heads, query_length, value_size]
+    feed_values = [
+        np.random.rand(*shape).astype(dtype)
+        for shape in [query_shape, key_shape, value_shape, output_shape]
+    ]
+
+    with ops.device('cpu'):
+      inputs = [
+          array_ops.placeholder(dtype, shape=shape)
+          for shape in [query_shape, key_shape, value_shape, output_shape]
+      ]
+      reference = _attention_and_gradients(_reference_attention,
+                                           causal)(*inputs)
+
+    with ipu.scopes.ipu_scope("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(
+          _attention_and_gradients(_ipu_attention, causal), inputs=inputs)
+
+    with se.Session() as sess:
+      feed_dict = dict(zip(inputs, feed_values))
+      ipu_results = sess.run(r, feed_dict)
+      reference_results = sess.run(reference, feed_dict)
+
+    self.assertEqual(len(ipu_results), 4)
+    for ipu_result, reference_result in zip(ipu_results, reference_results):
+      self.assertAllClose(ipu_result,
+                          reference_result,
+                          rtol=tolerance,
+                          atol=tolerance)
+
+  @test_util.deprecated_graph_mode_only
+  def testAttention(self):
+    self._run(False, np.float32, 1e-5)
+
+  @test_util.deprecated_graph_mode_only
+  def testCausalAttention(self):
+    self._run(True, np.float32, 1e-5)
+
+  @test_util.deprecated_graph_mode_only
+  def testCausalAttentionHalf(self):
+    self._run(True, np.float16, 1e-2)
+
+
+if __name__ == "__main__":
+  googletest.main()
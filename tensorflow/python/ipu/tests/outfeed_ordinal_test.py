@@ -13,13 +13,17 @@
 # limitations under the License.
 # ==============================================================================
 
+from threading import Thread
+
 import numpy as np
 
 from tensorflow.python import ipu
 from tensorflow.python.client import session as session_lib
+from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import googletest
 
 
@@ -65,6 +69,59 @@ class OutfeedOrdinalTest(test_util.TensorFlowTestCase):
       self.assertAllClose(results[0], np.broadcast_to(1, [1, 1, 3]))
       self.assertAllClose(results[1], np.broadcast_to(1, [1, 1, 4]))
 
+  @test_util.deprecated_graph_mode_only
+  def testTwoModelsRunConcurrentlyOnDifferentOrdinals(self):
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.auto_select_ipus(cfg, [1, 1])
+    ipu.utils.configure_ipu_system(cfg)
+
+    num_iterations = 10
+
+    def build_model(ordinal, fn):
+      dataset = dataset_ops.Dataset.range(num_iterations).repeat().map(
+          lambda x: math_ops.cast(array_ops.fill([4], x), np.float32))
+      infeed = ipu.ipu_infeed_queue.IPUInfeedQueue(
+          dataset, 'infeed%d' % ordinal, device_ordinal=ordinal)
+      outfeed = ipu.ipu_outfeed_queue.IPUOutfeedQueue('model_outfeed%d' %
+                                                      ordinal,
+                                                      device_ordinal=ordinal)
+
+      def body(x):
+        return outfeed.enqueue(fn(x))
+
+      def my_net():
+        return ipu.loops.repeat(num_iterations, body, infeed_queue=infeed)
+
+      with ipu.scopes.ipu_scope('/device:IPU:%d' % ordinal):
+        run = ipu.ipu_compiler.compile(my_net)
+      return infeed.initializer, run, outfeed.dequeue()
+
+    models = [
+        build_model(0, lambda x: x * 2.0),
+        build_model(1, lambda x: x + 1.0),
+    ]
+
+    with session_lib.Session() as sess:
+      sess.run([initializer for initializer, _, _ in models])
+
+      # Each model stays loaded on its own IPU, so the executions from the
+      # different threads don't reload the engines.
+      def run_model(run):
+        for _ in range(3):
+          sess.run(run)
+
+      threads = [Thread(target=run_model, args=(run,)) for _, run, _ in models]
+      for t in threads:
+        t.start()
+      for t in threads:
+        t.join()
+
+      results = sess.run([dequeue for _, _, dequeue in models])
+      expected = np.tile(
+          np.arange(num_iterations, dtype=np.float32).reshape([-1, 1]), [3, 4])
+      self.assertAllClose(results[0], expected * 2.0)
+      self.assertAllClose(results[1], expected + 1.0)
+
 
 if __name__ == "__main__":
   googletest.main()
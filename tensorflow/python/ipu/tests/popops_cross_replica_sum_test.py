@@ -13,12 +13,17 @@
 # limitations under the License.
 # ==============================================================================
 
+import numpy as np
+
 from tensorflow.python.client import session
 from tensorflow.python import ipu
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import init_ops
 from tensorflow.python.ops import random_ops
+from tensorflow.python.ops import variable_scope
+from tensorflow.python.ops import variables
 from tensorflow.python.platform import googletest
 
 
@@ -32,6 +37,29 @@ class ContribIpuOpsTest(test_util.TensorFlowTestCase):
         h1, h2 = s.run([t1, t2])
         self.assertEqual(list(h1), list(h2))
 
+  def testCompressedCrossReplicaSumOp(self):
+    for compression in ["fp16", "int8"]:
+      with ops.Graph().as_default():
+        with ops.device("/device:IPU:0"):
+          t1 = random_ops.random_uniform([1000], dtype=dtypes.float32)
+          residual = variable_scope.get_variable(
+              "residual",
+              shape=[1000],
+              dtype=dtypes.float32,
+              initializer=init_ops.zeros_initializer(),
+              use_resource=True)
+          t2 = ipu.ops.cross_replica_ops.compressed_cross_replica_sum(
+              t1, residual, compression)
+
+        with session.Session() as s:
+          s.run(variables.global_variables_initializer())
+          h1, h2 = s.run([t1, t2])
+          h3 = s.run(residual)
+          # With a single replica the sum is the input, apart from the
+          # compression error which is kept in the residual.
+          self.assertAllClose(h1, h2, atol=1e-2)
+          self.assertAllClose(h1, h2 + h3)
+
 
 if __name__ == "__main__":
   googletest.main()
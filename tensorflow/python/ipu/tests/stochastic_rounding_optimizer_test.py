@@ -0,0 +1,132 @@
+# Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+import numpy as np
+
+from tensorflow.python import ipu
+from tensorflow.python.client import session as sl
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import variable_scope
+from tensorflow.python.ops import variables
+from tensorflow.python.platform import googletest
+from tensorflow.python.ipu.optimizers import stochastic_rounding_optimizer
+
+INITIAL_W = [1.0, -2.0, 0.5, 3.0]
+TARGET = [0.0, 1.0, 2.0, -1.0]
+
+
+def numpy_adam(num_iterations, lr, beta1, beta2, epsilon):
+  w = np.array(INITIAL_W, np.float32)
+  m = np.zeros_like(w)
+  v = np.zeros_like(w)
+  for t in range(1, num_iterations + 1):
+    g = 2 * (w - TARGET)
+    m = beta1 * m + (1 - beta1) * g
+    v = beta2 * v + (1 - beta2) * g * g
+    lr_t = lr * np.sqrt(1 - beta2**t) / (1 - beta1**t)
+    w = w - lr_t * m / (np.sqrt(v) + epsilon)
+  return w
+
+
+def numpy_lamb(num_iterations, lr, beta1, beta2, epsilon, weight_decay_rate):
+  w = np.array(INITIAL_W, np.float32)
+  m = np.zeros_like(w)
+  v = np.zeros_like(w)
+  for t in range(1, num_iterations + 1):
+    g = 2 * (w - TARGET)
+    m = beta1 * m + (1 - beta1) * g
+    v = beta2 * v + (1 - beta2) * g * g
+    m_hat = m / (1 - beta1**t)
+    v_hat = v / (1 - beta2**t)
+    update = m_hat / (np.sqrt(v_hat) + epsilon) + weight_decay_rate * w
+    trust_ratio = np.linalg.norm(w) / np.linalg.norm(update)
+    w = w - lr * trust_ratio * update
+  return w
+
+
+class StochasticRoundingOptimizerTest(test_util.TensorFlowTestCase):
+  def _run(self, num_iterations, opt, dtype):
+    """Runs `num_iterations` steps of `opt` on the squared distance of a
+    variable of type `dtype` to `TARGET`, and returns the value of the
+    variable and the types of its slots."""
+    def body():
+      with variable_scope.variable_scope("vs", use_resource=True):
+        w = variable_scope.get_variable("w",
+                                        initializer=np.array(INITIAL_W, dtype),
+                                        dtype=dtype)
+      loss = math_ops.reduce_sum(math_ops.square(w - np.array(TARGET, dtype)))
+      return opt.minimize(loss)
+
+    def my_net():
+      return ipu.loops.repeat(num_iterations, body)
+
+    with ops.device("/device:IPU:0"):
+      r = ipu.ipu_compiler.compile(my_net)
+
+    cfg = ipu.utils.create_ipu_config()
+    cfg = ipu.utils.set_ipu_model_options(cfg, compile_ipu_code=False)
+    ipu.utils.configure_ipu_system(cfg)
+    ipu.utils.move_variable_initialization_to_cpu()
+
+    with sl.Session() as sess:
+      sess.run(variables.global_variables_initializer())
+      sess.run(r)
+      with variable_scope.variable_scope("vs", reuse=True):
+        w = variable_scope.get_variable("w", dtype=dtype)
+      slot_types = [
+          opt.get_slot(w, name).dtype for name in opt.get_slot_names()
+      ]
+      return sess.run(w), slot_types
+
+  @test_util.deprecated_graph_mode_only
+  def testAdamFloat32State(self):
+    opt = stochastic_rounding_optimizer.AdamStochasticRoundingOptimizer(
+        0.1, state_dtype=np.float32)
+    w, slot_types = self._run(10, opt, np.float32)
+    self.assertAllClose(w, numpy_adam(10, 0.1, 0.9, 0.999, 1e-8), rtol=1e-5)
+    self.assertEqual(slot_types, [np.float32, np.float32])
+
+  @test_util.deprecated_graph_mode_only
+  def testAdamFloat16State(self):
+    opt = stochastic_rounding_optimizer.AdamStochasticRoundingOptimizer(0.1)
+    w, slot_types = self._run(10, opt, np.float16)
+    self.assertEqual(w.dtype, np.float16)
+    self.assertAllClose(w,
+                        numpy_adam(10, 0.1, 0.9, 0.999, 1e-8),
+                        rtol=1e-2,
+                        atol=1e-2)
+    self.assertEqual(slot_types, [np.float16, np.float16])
+
+  @test_util.deprecated_graph_mode_only
+  def testLAMBFloat16State(self):
+    opt = stochastic_rounding_optimizer.LAMBStochasticRoundingOptimizer(
+        0.05, weight_decay_rate=0.01)
+    w, slot_types = self._run(10, opt, np.float16)
+    self.assertAllClose(w,
+                        numpy_lamb(10, 0.05, 0.9, 0.999, 1e-6, 0.01),
+                        rtol=1e-2,
+                        atol=1e-2)
+    self.assertEqual(slot_types, [np.float16, np.float16])
+
+  def testInvalidStateType(self):
+    with self.assertRaisesRegex(ValueError, "state_dtype must be float16"):
+      stochastic_rounding_optimizer.AdamStochasticRoundingOptimizer(
+          state_dtype=np.int32)
+
+
+if __name__ == "__main__":
+  googletest.main()
@@ -96,6 +96,11 @@ class ContribIpuOpsTest(test_util.TensorFlowTestCase):
         cfg, triangular_solve_expander_block_size=42)
     self.assertEqual(cfg.triangular_solve_expander_block_size, 42)
 
+    self.assertEqual(cfg.max_combined_convolutions_size, 0)
+    cfg = ipu.utils.set_optimization_options(
+        cfg, max_combined_convolutions_size=1024)
+    self.assertEqual(cfg.max_combined_convolutions_size, 1024)
+
     self.assertFalse(cfg.use_stable_norm_statistics)
     cfg = ipu.utils.set_norm_options(cfg, use_stable_statistics=True)
     self.assertTrue(cfg.use_stable_norm_statistics)
@@ -779,5 +784,54 @@ class ContribIpuOpsTest(test_util.TensorFlowTestCase):
     self.assertEqual(cfg.gcl_options[0].value, "128")
 
 
+  @test_util.deprecated_graph_mode_only
+  def testIOThreadOptions(self):
+    cfg = ipu.utils.create_ipu_config()
+    self.assertEqual(cfg.io_thread_options.wait_strategy,
+                     ipu.utils.IOThreadWaitStrategy.SPIN.value)
+
+    with self.assertRaisesRegex(TypeError,
+                                "`wait_strategy` must be an IOThreadWait"):
+      ipu.utils.set_io_thread_options(cfg, wait_strategy=1)
+
+    cfg = ipu.utils.set_io_thread_options(
+        cfg,
+        wait_strategy=ipu.utils.IOThreadWaitStrategy.SPIN_YIELD_PARK,
+        spin_count=100,
+        yield_count=10)
+
+    self.assertEqual(cfg.io_thread_options.wait_strategy,
+                     ipu.utils.IOThreadWaitStrategy.SPIN_YIELD_PARK.value)
+    self.assertEqual(cfg.io_thread_options.spin_count, 100)
+    self.assertEqual(cfg.io_thread_options.yield_count, 10)
+
+  @test_util.deprecated_graph_mode_only
+  def testHostEmbeddingCacheOptions(self):
+    cfg = ipu.utils.create_ipu_config()
+    self.assertEqual(cfg.host_embedding_cache_options.cache_rows, 0)
+
+    with self.assertRaisesRegex(TypeError,
+                                "`policy` must be a HostEmbeddingCachePolicy"):
+      ipu.utils.set_experimental_host_embedding_cache_options(cfg,
+                                                              100,
+                                                              policy=1)
+
+    with self.assertRaisesRegex(ValueError, "must be non-negative"):
+      ipu.utils.set_experimental_host_embedding_cache_options(cfg, -1)
+
+    cfg = ipu.utils.set_experimental_host_embedding_cache_options(
+        cfg,
+        100,
+        max_misses=8,
+        policy=ipu.utils.HostEmbeddingCachePolicy.LFU,
+        deduplicate=True)
+
+    self.assertEqual(cfg.host_embedding_cache_options.cache_rows, 100)
+    self.assertEqual(cfg.host_embedding_cache_options.max_misses, 8)
+    self.assertEqual(cfg.host_embedding_cache_options.policy,
+                     ipu.utils.HostEmbeddingCachePolicy.LFU.value)
+    self.assertTrue(cfg.host_embedding_cache_options.deduplicate)
+
+
 if __name__ == "__main__":
   googletest.main()
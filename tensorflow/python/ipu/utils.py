@@ -19,6 +19,7 @@ General utilities
 
 import collections
 from enum import Enum
+import json
 import os
 import time
 import numpy as np
@@ -176,10 +177,39 @@ class DeviceConnectionType(Enum):
     device.
   * `ON_DEMAND` will defer connection to when the IPU is needed.
   * `NEVER` will never try to attach to a device. Used when compiling offline.
+  * `ASYNCHRONOUS` will attach in the background when configuring the device,
+    so that attaching overlaps with the compilation of the graphs. The graphs
+    are compiled for the remote buffer support of the devices which can be
+    attached to.
   """
   ALWAYS = config_pb2.IpuDeviceConnectionType.Value("ALWAYS")
   ON_DEMAND = config_pb2.IpuDeviceConnectionType.Value("ON_DEMAND")
   NEVER = config_pb2.IpuDeviceConnectionType.Value("NEVER")
+  ASYNCHRONOUS = config_pb2.IpuDeviceConnectionType.Value("ASYNCHRONOUS")
+
+
+class IOThreadWaitStrategy(Enum):
+  """Enumeration to describe how the host threads which transfer data for the
+  infeeds and outfeeds wait when there is no work available.
+
+  * `SPIN` indicates that the threads busy wait. This gives the lowest latency
+    but uses a full host core per infeed/outfeed.
+  * `SPIN_YIELD_PARK` indicates that the threads spin for a while, then yield
+    and finally park until more work is available.
+  """
+  SPIN = config_pb2.IpuIOThreadWaitStrategy.Value("SPIN")
+  SPIN_YIELD_PARK = config_pb2.IpuIOThreadWaitStrategy.Value("SPIN_YIELD_PARK")
+
+
+class HostEmbeddingCachePolicy(Enum):
+  """Enumeration to describe which rows are evicted from the device cache of a
+  host embedding when there is no space for a new row.
+
+  * `LRU` evicts the least recently used row.
+  * `LFU` evicts the least frequently used row.
+  """
+  LRU = config_pb2.IpuHostEmbeddingCachePolicy.Value("LRU")
+  LFU = config_pb2.IpuHostEmbeddingCachePolicy.Value("LFU")
 
 
 def configure_ipu_system(config, device="cpu"):
@@ -275,6 +305,9 @@ def running_on_ipu_model():
 @deprecation.deprecated_args(None, "Use set_optimization_options() instead.",
                              "max_cross_replica_sum_buffer_size",
                              "max_inter_ipu_copies_buffer_size")
+@deprecation.deprecated_args(None,
+                             "Use enable_remote_buffer_embedding instead.",
+                             "enable_experimental_remote_buffer_embedding")
 def create_ipu_config(profiling=False,
                       enable_ipu_events=False,
                       use_poplar_text_report=False,
@@ -296,7 +329,9 @@ def create_ipu_config(profiling=False,
                       max_scheduler_search_space_size=64,
                       prefetch_data_streams=True,
                       selection_order=None,
-                      enable_experimental_remote_buffer_embedding=False):
+                      enable_experimental_remote_buffer_embedding=False,
+                      double_buffer_repeat_loop_feeds=False,
+                      enable_remote_buffer_embedding=False):
   """Create an empty IPU session configuration structure.
 
   Args:
@@ -345,6 +380,10 @@ def create_ipu_config(profiling=False,
       waiting before a cross replica sum op is scheduled.
     max_inter_ipu_copies_buffer_size: The maximum number of bytes that can be
       waiting before a inter IPU copy between IPUs is scheduled.
+    overlap_inter_ipu_copies: Schedule the inter IPU copies of a sharded model
+      as soon as the copied tensors are computed, so that the next IPU can
+      start computing while the current IPU computes the operations which do
+      not depend on the copy. This is not used by pipelines.
     max_scheduler_lookahead_depth: The maximum distance to look into the future
       when considering valid schedules.
     max_scheduler_search_space_size: The maximum number of nodes to consider
@@ -355,8 +394,18 @@ def create_ipu_config(profiling=False,
       IPU devices when using a multi-IPU devices (see `SelectionOrder`). When
       not specified, then automatic selection order is used, otherwise an
       instance of `SelectionOrder`.
-    enable_experimental_remote_buffer_embedding: When set to true,
-      `HostEmbedding` will make use of poplar remote buffers.
+    enable_experimental_remote_buffer_embedding: Deprecated, the same as
+      `enable_remote_buffer_embedding`.
+    double_buffer_repeat_loop_feeds: When set to true, the infeed of the next
+      iteration and the outfeed of the previous iteration of a loop are copied
+      while the current iteration is executing. This hides the latency of the
+      data streams when the iterations are short, for example in small batch
+      inference, at the expense of an extra buffer for each infeed and outfeed
+      tensor. When IO tiles are reserved with `set_gcl_options`, the buffers are
+      placed on them.
+    enable_remote_buffer_embedding: When set to true, `HostEmbedding` tables
+      are stored in the remote buffers of the IPUs, partitioned across the
+      replicas, and are looked up and updated by the IPUs without the host.
 
   Returns:
     An IpuOptions configuration protobuf, suitable for passing to
@@ -420,6 +469,7 @@ def create_ipu_config(profiling=False,
 
   opts.max_cross_replica_sum_buffer_size = max_cross_replica_sum_buffer_size
   opts.max_inter_ipu_copies_buffer_size = max_inter_ipu_copies_buffer_size
+  opts.overlap_inter_ipu_copies = overlap_inter_ipu_copies
   opts.minimum_remote_tensor_size = 128
 
   opts.max_scheduler_lookahead_depth = max_scheduler_lookahead_depth
@@ -431,8 +481,10 @@ def create_ipu_config(profiling=False,
   opts.verified_transfers.enabled = False
   opts = set_verification_options(opts, VerificationOptions())
 
-  opts.enable_experimental_remote_buffer_embedding = \
+  opts.enable_remote_buffer_embedding = \
+      enable_remote_buffer_embedding or \
       enable_experimental_remote_buffer_embedding
+  opts.double_buffer_repeat_loop_feeds = double_buffer_repeat_loop_feeds
 
   return opts
 
@@ -466,12 +518,18 @@ def set_optimization_options(opts,
                              combine_matmuls=False,
                              max_cross_replica_sum_buffer_size=0,
                              max_reduce_scatter_buffer_size=0,
+                             cross_replica_sum_bucket_size=0,
+                             reduce_scatter_bucket_size=0,
                              max_inter_ipu_copies_buffer_size=0,
+                             overlap_inter_ipu_copies=False,
                              max_send_recv_cluster_size=0,
                              minimum_remote_tensor_size=128,
+                             remote_parameter_prefetch_size=0,
                              gather_simplifier=False,
                              triangular_solve_expander_block_size=0,
-                             enable_fast_math=False):
+                             enable_fast_math=False,
+                             max_combined_convolutions_size=0,
+                             overlap_host_compute=False):
   """Set the IPU options related to performance / optimizations.
 
   .. code-block:: python
@@ -494,6 +552,14 @@ def set_optimization_options(opts,
       waiting before a cross replica sum op is scheduled.
     max_reduce_scatter_buffer_size: The maximum number of bytes that can be
       waiting before a reduce scatter op is scheduled.
+    cross_replica_sum_bucket_size: The maximum number of bytes reduced by a
+      single cross replica sum op. The cross replica sums of the gradients are
+      scheduled as soon as a bucket of this size is ready, instead of being
+      combined into one op at the end of the backward pass. It is also used
+      as `max_cross_replica_sum_buffer_size` when that is 0.
+    reduce_scatter_bucket_size: The maximum number of bytes reduced by a
+      single reduce scatter op, in the same way as
+      `cross_replica_sum_bucket_size`.
     max_inter_ipu_copies_buffer_size: The maximum number of bytes that can be
       waiting before a inter IPU copy between IPUs is scheduled.
     max_send_recv_cluster_size: The maximum number of bytes that can be waiting
@@ -501,6 +567,11 @@ def set_optimization_options(opts,
       These are lowered to stream copies that can be merged by Poplar.
     minimum_remote_tensor_size: The minimum size (in bytes) a tensor has to be
       in order to be consider for being stored in remote memory.
+    remote_parameter_prefetch_size: The maximum size (in bytes) of a variable
+      stored in remote memory which is loaded during the weight update of the
+      previous variable. This hides the latency of the remote memory at the
+      cost of keeping one more variable in the device memory. 0 disables the
+      prefetching.
     gather_simplifier: Will enable more aggressive optimisation for embedding
       lookups.
     triangular_solve_expander_block_size: Defines size for triangular solver
@@ -511,6 +582,15 @@ def set_optimization_options(opts,
       depend on an exact implementation of IEEE for math functions. It may,
       however, yield faster code for programs that do not require the guarantees
       of these specifications.
+    max_combined_convolutions_size: The maximum number of bytes of inputs and
+      outputs of independent convolutions which are combined into a single
+      multi-convolution, so that they are planned and executed together. This
+      can improve the tile utilisation of models with parallel branches of
+      convolutions. 0 disables the combining.
+    overlap_host_compute: Receive the results of the host computations
+      (outside compilation scopes) as late as possible, after all the
+      operations which do not depend on them. The IPU then keeps computing
+      while the host computations run, instead of waiting for their results.
 
   Returns:
     The IpuOptions configuration protobuf.
@@ -520,13 +600,18 @@ def set_optimization_options(opts,
   opts.enable_matmul_combiner = combine_matmuls
   opts.max_cross_replica_sum_buffer_size = max_cross_replica_sum_buffer_size
   opts.max_reduce_scatter_buffer_size = max_reduce_scatter_buffer_size
+  opts.cross_replica_sum_bucket_size = cross_replica_sum_bucket_size
+  opts.reduce_scatter_bucket_size = reduce_scatter_bucket_size
   opts.max_inter_ipu_copies_buffer_size = max_inter_ipu_copies_buffer_size
   opts.max_send_recv_cluster_size = max_send_recv_cluster_size
   opts.minimum_remote_tensor_size = minimum_remote_tensor_size
+  opts.remote_parameter_prefetch_size = remote_parameter_prefetch_size
   opts.enable_gather_simplifier = gather_simplifier
   opts.triangular_solve_expander_block_size = \
     triangular_solve_expander_block_size
   opts.enable_fast_math = enable_fast_math
+  opts.max_combined_convolutions_size = max_combined_convolutions_size
+  opts.overlap_host_compute = overlap_host_compute
 
   return opts
 
@@ -859,13 +944,19 @@ def set_report_options(opts,
   return opts
 
 
-def set_ipu_model_options(opts, compile_ipu_code=True, tiles_per_ipu=None):
+def set_ipu_model_options(opts,
+                          compile_ipu_code=True,
+                          tiles_per_ipu=None,
+                          multi_threaded_execution=True):
   """Set the IPU Model options.
 
   Args:
     compile_ipu_code: Whether or not to actually compile real IPU code for
       modelling.
     tiles_per_ipu: The number of tiles per IPU Model device.
+    multi_threaded_execution: Whether the tiles of the IPU Model are executed
+      by a pool of threads which uses all the host cores, or on a single
+      thread.
 
   Returns:
     The IpuOptions configuration protobuf, with IPU model options set.
@@ -873,6 +964,8 @@ def set_ipu_model_options(opts, compile_ipu_code=True, tiles_per_ipu=None):
   opts.ipu_model_config.compile_ipu_code = compile_ipu_code
   if tiles_per_ipu:
     opts.ipu_model_config.tiles_per_ipu = tiles_per_ipu
+  opts.ipu_model_config.single_threaded_execution = \
+      not multi_threaded_execution
 
   return opts
 
@@ -962,6 +1055,158 @@ def set_gcl_options(opts, num_io_tiles=0, gcl_options=None):
   return opts
 
 
+def set_io_thread_options(opts,
+                          wait_strategy=IOThreadWaitStrategy.SPIN,
+                          spin_count=0,
+                          yield_count=0):
+  """Set the IPU options for the host threads which transfer data for the
+  infeeds and outfeeds.
+
+  .. code-block:: python
+
+      # Create a device where the infeed/outfeed threads do not busy wait.
+      opts = create_ipu_config()
+      opts = set_io_thread_options(
+          opts, wait_strategy=IOThreadWaitStrategy.SPIN_YIELD_PARK)
+      ipu.utils.configure_ipu_system(opts)
+      with tf.Session() as s:
+        ...
+
+  Args:
+    wait_strategy: One of `IOThreadWaitStrategy`.
+    spin_count: When using `IOThreadWaitStrategy.SPIN_YIELD_PARK`, the number
+      of times the queues are polled before the thread yields.
+      0 - implementation defined default.
+    yield_count: When using `IOThreadWaitStrategy.SPIN_YIELD_PARK`, the number
+      of times the thread yields before it is parked. 0 - implementation defined
+      default.
+
+  Returns:
+    The IpuOptions configuration protobuf.
+  """
+  if not isinstance(wait_strategy, IOThreadWaitStrategy):
+    raise TypeError("`wait_strategy` must be an IOThreadWaitStrategy")
+
+  if spin_count < 0 or yield_count < 0:
+    raise ValueError("`spin_count` and `yield_count` must be non-negative")
+
+  opts.io_thread_options.wait_strategy = wait_strategy.value
+  opts.io_thread_options.spin_count = spin_count
+  opts.io_thread_options.yield_count = yield_count
+
+  return opts
+
+
+def set_feed_autotuning_options(opts,
+                                executions_per_trial=4,
+                                stall_threshold=0.05):
+  """Set the IPU options for autotuning the prefetch depth of the infeeds
+  created with a `max_prefetch_depth` and the io batch size of the outfeeds
+  created with a `max_io_batch_size`.
+
+  The stalls of the device on the host queues of each autotuned feed are
+  observed for `executions_per_trial` executions. While the device is stalled
+  for more than `stall_threshold` of the execution time the value is doubled,
+  up to the maximum of the feed. When a doubling does not reduce the stalls
+  the previous value is restored and the feed is not tuned any further.
+
+  Both values are compiled into the graph, so the tuned values are used when a
+  graph with the feed is compiled again. The state of the autotuning is
+  reported in the `autotuning` entry of `extract_feed_queue_stats`.
+
+  .. code-block:: python
+
+      # Adjust the autotuned feeds after every two executions.
+      opts = create_ipu_config()
+      opts = set_feed_autotuning_options(opts, executions_per_trial=2)
+      ipu.utils.configure_ipu_system(opts)
+      with tf.Session() as s:
+        ...
+
+  Args:
+    executions_per_trial: The number of executions observed before each
+      adjustment.
+    stall_threshold: The fraction of the execution time the device can wait for
+      a feed before the feed is tuned.
+
+  Returns:
+    The IpuOptions configuration protobuf.
+  """
+  if executions_per_trial < 1:
+    raise ValueError("`executions_per_trial` must be at least 1")
+
+  if stall_threshold <= 0.0 or stall_threshold >= 1.0:
+    raise ValueError("`stall_threshold` must be between 0 and 1")
+
+  opts.feed_autotuning_options.executions_per_trial = executions_per_trial
+  opts.feed_autotuning_options.stall_threshold = stall_threshold
+
+  return opts
+
+
+def set_experimental_host_embedding_cache_options(
+    opts,
+    cache_rows,
+    max_misses=0,
+    policy=HostEmbeddingCachePolicy.LRU,
+    deduplicate=False):
+  """Set the IPU options for caching the rows of host embeddings on the
+  device.
+
+  When enabled, each host embedding lookup keeps up to `cache_rows` rows of the
+  embedding in device memory and the host only sends the rows which are not in
+  the cache. The rows are removed from the cache when they are updated, so the
+  results are the same as without the cache.
+
+  When `deduplicate` is set, the rows of repeated indices are only transferred
+  once, with or without a cache: the host sends the rows of the distinct indices
+  of each lookup, and the device sums the gradients of repeated indices before
+  sending one gradient row per distinct index for each update.
+
+  The cache is not used with the experimental remote buffer embeddings or with
+  synthetic data.
+
+  .. code-block:: python
+
+      # Cache 1000 rows of each host embedding on the device.
+      opts = create_ipu_config()
+      opts = set_experimental_host_embedding_cache_options(opts, 1000)
+      ipu.utils.configure_ipu_system(opts)
+      with tf.Session() as s:
+        ...
+
+  Args:
+    cache_rows: The number of rows of each host embedding to cache on the
+      device. 0 disables the cache.
+    max_misses: The maximum number of distinct rows which are not in the cache
+      that the host sends for each lookup. When a lookup has more misses, all
+      the rows for that lookup are sent by the host. The amount of data sent
+      for each lookup is proportional to this rather than the number of
+      misses. 0 - half of the number of indices of the lookup. With
+      `deduplicate` this is also the maximum number of distinct indices of a
+      lookup or update whose rows are transferred once, above which the rows of
+      all the indices are transferred.
+    policy: One of `HostEmbeddingCachePolicy`.
+    deduplicate: Whether the rows of repeated indices are only transferred
+      once.
+
+  Returns:
+    The IpuOptions configuration protobuf.
+  """
+  if not isinstance(policy, HostEmbeddingCachePolicy):
+    raise TypeError("`policy` must be a HostEmbeddingCachePolicy")
+
+  if cache_rows < 0 or max_misses < 0:
+    raise ValueError("`cache_rows` and `max_misses` must be non-negative")
+
+  opts.host_embedding_cache_options.cache_rows = cache_rows
+  opts.host_embedding_cache_options.max_misses = max_misses
+  opts.host_embedding_cache_options.policy = policy.value
+  opts.host_embedding_cache_options.deduplicate = deduplicate
+
+  return opts
+
+
 def auto_select_ipus(opts, num_ipus):
   """Configure the IPUs to be used by the session.
 
@@ -1414,6 +1659,56 @@ def extract_compile_reports(events):
   return result
 
 
+def extract_instruction_compile_info(events):
+  """Get a list of the compile time and memory of the instructions and
+  TensorFlow ops of each compilation in the event list.
+
+  The `instructions` entry contains, for each HLO instruction:
+    * `op_type` and `op_name` - the TensorFlow op the instruction came from.
+    * `compile_nanos` - the time spent lowering the instruction to Poplar,
+      including the instructions of the computations it calls.
+    * `output_bytes` - the size of the output tensors of the instruction, which
+      may alias its inputs.
+    * `max_tile_output_bytes` - the largest number of bytes of an output tensor
+      on a single tile.
+    * `balanced_tile_output_bytes` - the number of bytes of the largest output
+      tensor on each tile, if it was spread evenly over the tiles of its IPUs.
+      An output for which this is much smaller than `max_tile_output_bytes` is
+      mapped onto a few tiles.
+
+  The `ops` entry contains the `compile_nanos` and `output_bytes` of the
+  instructions of each TensorFlow op, by op name.
+
+  The `tile_imbalance` entry contains the number of operands which were copied
+  to an even mapping because most of their elements were on a few tiles, in
+  `rebalanced_tensors`, and the bytes this saved on their busiest tiles, in
+  `max_tile_bytes_saved`. See the `tile_imbalance_rebalance_ratio` flag.
+
+  Args:
+    events: A list of trace event serialized protobufs.
+
+  Returns:
+    A list of tuples containing the module name and a dictionary with the
+    `instructions`, `ops` and `tile_imbalance` entries."""
+  result = []
+  for e in events:
+    evt = IpuTraceEvent.FromString(e)
+    if evt.type == IpuTraceEvent.COMPILE_END:
+      try:
+        module = evt.compile_end.module_name.decode('utf-8')
+        info = evt.compile_end.instruction_info.decode('utf-8')
+        if info:
+          info = json.loads(info)
+          result += [(module, {
+              'instructions': info.get('instructions', {}),
+              'ops': info.get('ops', {}),
+              'tile_imbalance': info.get('tile_imbalance', {})
+          })]
+      except UnicodeDecodeError:
+        pass
+  return result
+
+
 def extract_poplar_serialized_graphs(events):
   """Get a list of all poplar serialized graphs in the event list.
 
@@ -1459,6 +1754,100 @@ def extract_execute_reports(events):
   return result
 
 
+def extract_feed_queue_stats(events):
+  """Get a list of the infeed and outfeed queue counters of each execution in
+  the event list.
+
+  The counters of a feed are summed over the queues of all its tensors and
+  replicas:
+    * `push_count` and `pop_count` - the number of elements pushed and popped
+      during the execution.
+    * `push_blocked_us` - the time the producer waited for space because the
+      queue was full. For an infeed this is the host, for an outfeed it is the
+      device.
+    * `pop_blocked_us` - the time the consumer waited for an element because
+      the queue was empty. For an infeed this is the device, for an outfeed it
+      is the host.
+    * `high_water_mark` - the largest number of elements in any of the queues
+      since the feed was created.
+
+  Args:
+    events: A list of trace event serialized protobufs.
+
+  The `autotuning` entry contains the state of each autotuned feed, see
+  `set_feed_autotuning_options`.
+
+  Returns:
+    A list of tuples containing the module name and a dictionary with the
+    counters of each feed in its `infeeds` and `outfeeds` entries."""
+  result = []
+  for e in events:
+    evt = IpuTraceEvent.FromString(e)
+    if evt.type == IpuTraceEvent.EXECUTE:
+      try:
+        module = evt.execute.module_name.decode('utf-8')
+        stats = evt.execute.feed_queue_stats.decode('utf-8')
+        if stats:
+          result += [(module, json.loads(stats))]
+      except UnicodeDecodeError:
+        pass
+  return result
+
+
+def extract_instruction_cycle_counts(events):
+  """Get a list of the total cycles of each instruction in each execution in
+  the event list, when they are counted with the
+  `--log_instruction_cycle_count` flag of `TF_POPLAR_FLAGS`.
+
+  The cycles of an instruction are summed over all its executions, and include
+  the cycles of the computations it calls, for instance the body of a loop.
+
+  Args:
+    events: A list of trace event serialized protobufs.
+
+  Returns:
+    A list of tuples containing the module name and a dictionary of the cycles
+    of each instruction, by instruction name."""
+  result = []
+  for e in events:
+    evt = IpuTraceEvent.FromString(e)
+    if evt.type == IpuTraceEvent.EXECUTE:
+      try:
+        module = evt.execute.module_name.decode('utf-8')
+        counts = evt.execute.instruction_cycle_counts.decode('utf-8')
+        if counts:
+          result += [(module, json.loads(counts))]
+      except UnicodeDecodeError:
+        pass
+  return result
+
+
+def extract_execute_host_overheads(events):
+  """Get a list of the time spent on the host by each execution in the event
+  list, excluding the time the main program ran on the device.
+
+  This includes moving the arguments to and from the device, connecting the
+  streams and feeds, and loading the executable onto the device when it was
+  not the last one to be executed.
+
+  Args:
+    events: A list of trace event serialized protobufs.
+
+  Returns:
+    A list of tuples containing the module name and the host overhead of the
+    execution in nanoseconds."""
+  result = []
+  for e in events:
+    evt = IpuTraceEvent.FromString(e)
+    if evt.type == IpuTraceEvent.EXECUTE:
+      try:
+        module = evt.execute.module_name.decode('utf-8')
+        result += [(module, evt.execute.host_overhead_nanos)]
+      except UnicodeDecodeError:
+        pass
+  return result
+
+
 def move_variable_initialization_to_cpu(graph=None):
   """For all variables in the VARIABLES collection, move any initialization
   ops onto the CPU.
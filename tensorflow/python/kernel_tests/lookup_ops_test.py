@@ -2736,6 +2736,29 @@ class MutableHashTableOpTest(test.TestCase):
       self.assertAllEqual([b"brain", b"salad", b"surgery"], sorted_keys)
       self.assertAllEqual([0, 1, 2], sorted_values)
 
+  def testMutableHashTableLargeBatch(self):
+    # Large batches process the shards of the table in parallel.
+    with self.cached_session():
+      num_keys = 100000
+      keys = np.arange(num_keys, dtype=np.int64)
+      table = lookup_ops.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      self.evaluate(table.insert(keys, keys * 2))
+      self.assertAllEqual(num_keys, self.evaluate(table.size()))
+
+      self.assertAllEqual(
+          np.append(keys * 2, -1),
+          self.evaluate(table.lookup(np.append(keys, num_keys))))
+
+      self.evaluate(table.remove(keys[::2]))
+      self.assertAllEqual(num_keys // 2, self.evaluate(table.size()))
+      result = self.evaluate(table.lookup(keys))
+      self.assertAllEqual(-1, result[0::2])
+      self.assertAllEqual(keys[1::2] * 2, result[1::2])
+
+      exported_keys, exported_values = self.evaluate(table.export())
+      self.assertAllEqual(keys[1::2], np.sort(exported_keys))
+      self.assertAllEqual(keys[1::2] * 2, np.sort(exported_values))
+
   @test_util.run_v1_only("SaverV1")
   def testSaveRestore(self):
     save_dir = os.path.join(self.get_temp_dir(), "save_restore")
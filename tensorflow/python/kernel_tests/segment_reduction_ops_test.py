@@ -27,6 +27,7 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes as dtypes_lib
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import gradient_checker_v2
 from tensorflow.python.ops import math_ops
@@ -488,6 +489,28 @@ class UnsortedSegmentTest(SegmentReductionHelper):
         self.assertAllClose(np_ans, tf_ans)
         self.assertShapeEqual(np_ans, s)
 
+  def testLargeSkewedSegments(self):
+    # Large enough to be reduced on several threads, with a few segments
+    # holding most of the rows, negative ids and empty segments.
+    num_segments = 1000
+    segment_ids = np.minimum(np.random.zipf(1.5, size=20000) - 1,
+                             num_segments + 99) - 100
+    np_x = np.random.rand(segment_ids.size, 8).astype(np.float32)
+    with self.cached_session(use_gpu=False):
+      for np_op, tf_op, init_value in [
+          (np.add, math_ops.unsorted_segment_sum, 0),
+          (np.maximum, math_ops.unsorted_segment_max,
+           np.finfo(np.float32).min),
+          (np.minimum, math_ops.unsorted_segment_min,
+           np.finfo(np.float32).max)]:
+        np_ans = np.full((num_segments, 8), init_value, dtype=np.float32)
+        for i, segment_id in enumerate(segment_ids):
+          if segment_id >= 0:
+            np_ans[segment_id] = np_op(np_ans[segment_id], np_x[i])
+        tf_ans = self.evaluate(
+            tf_op(np_x, segment_ids, num_segments=num_segments))
+        self.assertAllClose(np_ans, tf_ans, rtol=1e-4)
+
 
 class SparseSegmentReductionHelper(SegmentReductionHelper):
 
@@ -562,6 +585,69 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
         tf_ans = self.evaluate(s)
         self.assertAllClose(np_ans, tf_ans)
 
+  def testLargeSkewedSegments(self):
+    # Large enough to be reduced on several threads, with a few segments
+    # holding most of the indices, and gaps between the segments.
+    num_indices = 20000
+    segment_ids = np.sort(np.minimum(
+        np.random.zipf(1.5, size=num_indices) * 2, 1000)).astype(np.int32)
+    indices = np.random.randint(0, 500, num_indices).astype(np.int32)
+    np_x = np.random.rand(500, 8).astype(np.float32)
+    with self.session(use_gpu=False):
+      for np_op1, np_op2, tf_op in [
+          (np.add, None, math_ops.sparse_segment_sum_with_num_segments),
+          (self._mean_cum_op, self._mean_reduce_op,
+           math_ops.sparse_segment_mean_with_num_segments)]:
+        np_ans = self._sparseSegmentReduce(
+            np_x, indices, segment_ids, np_op1, np_op2, num_segments=1010)
+        tf_ans = self.evaluate(tf_op(np_x, indices, segment_ids, 1010))
+        self.assertAllClose(np_ans, tf_ans, rtol=1e-4)
+
+      indices[12345] = 500
+      s = math_ops.sparse_segment_sum(np_x, indices, segment_ids)
+      with self.assertRaisesOpError(
+          r"indices\[12345\] == 500 out of range \[0, 500\)"):
+        self.evaluate(s)
+
+  def testWeightedReduction(self):
+    segment_ids = np.array([0, 0, 2, 2, 2, 3], dtype=np.int32)
+    indices = np.array([3, 1, 1, 0, 4, 3], dtype=np.int64)
+    np_weights = np.random.rand(6).astype(np.float32) + 0.5
+    np_x = np.random.rand(5, 3, 2).astype(np.float32)
+    weighted_x = np_x[indices] * np_weights[:, None, None]
+    with self.cached_session(use_gpu=False):
+      for combiner in ["sum", "mean", "sqrtn"]:
+        np_ans = np.zeros((4, 3, 2), dtype=np.float32)
+        for segment_id in [0, 2, 3]:
+          in_segment = segment_ids == segment_id
+          np_ans[segment_id] = np.sum(weighted_x[in_segment], axis=0)
+          if combiner == "mean":
+            np_ans[segment_id] /= np.sum(np_weights[in_segment])
+          elif combiner == "sqrtn":
+            np_ans[segment_id] /= np.sqrt(
+                np.sum(np.square(np_weights[in_segment])))
+        tf_ans = self.evaluate(
+            gen_math_ops.sparse_segment_weighted_reduction(
+                np_x, indices, np_weights, segment_ids, combiner=combiner))
+        self.assertAllClose(np_ans, tf_ans)
+
+  @test_util.run_in_graph_and_eager_modes
+  def testWeightedReductionGradient(self):
+    segment_ids = np.array([0, 0, 2, 2, 2, 3], dtype=np.int32)
+    indices = np.array([3, 1, 1, 0, 4, 3], dtype=np.int32)
+    np_weights = np.random.rand(6) + 0.5
+    np_x = np.random.rand(5, 3)
+    with test_util.force_cpu():
+      for combiner in ["sum", "mean", "sqrtn"]:
+        # pylint: disable=cell-var-from-loop
+        def f(x, weights):
+          return gen_math_ops.sparse_segment_weighted_reduction(
+              x, indices, weights, segment_ids, combiner=combiner)
+        # pylint: enable=cell-var-from-loop
+        jacob_t, jacob_n = gradient_checker_v2.compute_gradient(
+            f, [np_x, np_weights])
+        self.assertAllClose(jacob_n, jacob_t)
+
   def testWithNumSegments(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
     ops_list = [(np.add, None, math_ops.sparse_segment_sum_with_num_segments),
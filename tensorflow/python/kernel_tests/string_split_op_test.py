@@ -28,6 +28,7 @@ from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import string_ops
 from tensorflow.python.ops.ragged import ragged_factory_ops
+from tensorflow.python.ops.ragged import ragged_functional_ops
 from tensorflow.python.ops.ragged import ragged_string_ops
 from tensorflow.python.platform import test
 from tensorflow.python.util import compat
@@ -282,6 +283,15 @@ class StringSplitV2OpTest(test_util.TensorFlowTestCase, parameterized.TestCase):
     self.assertAllEqual(expected_ragged, actual_ragged_v2)
     self.assertAllEqual(expected_ragged, actual_ragged_v2_input_kwarg)
 
+    # Check that the fused version, which hashes the tokens, returns the
+    # buckets of the split tokens.
+    num_buckets = 1000
+    expected_buckets = ragged_functional_ops.map_flat_values(
+        string_ops.string_to_hash_bucket_fast, actual_ragged_v2, num_buckets)
+    actual_buckets = ragged_string_ops.string_split_to_hash_bucket_fast(
+        input, num_buckets, **kwargs)
+    self.assertAllEqual(expected_buckets, actual_buckets)
+
     # Check that the internal version (which returns a SparseTensor) works
     # correctly.  Note: the internal version oly supports vector inputs.
     if input.shape.ndims == 1:
@@ -48,6 +48,18 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]])
 
+  def testInt64Large(self):
+    # Large enough to be partitioned across the threads.
+    for high in [10, 10000, 1 << 40]:
+      x = np.random.randint(0, high=high, size=200000, dtype=np.int64)
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = self.evaluate([y, idx])
+
+      # The unique elements are in the order of their first occurrences.
+      _, first = np.unique(x, return_index=True)
+      self.assertAllEqual(x[np.sort(first)], tf_y)
+      self.assertAllEqual(x, tf_y[tf_idx])
+
   def testString(self):
     indx = np.random.randint(65, high=122, size=7000)
     x = [chr(i) for i in indx]
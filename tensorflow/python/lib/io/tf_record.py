@@ -35,6 +35,7 @@ class TFRecordCompressionType(object):
   NONE = 0
   ZLIB = 1
   GZIP = 2
+  BLOCK_ZLIB = 3
 
 
 @tf_export(
@@ -46,6 +47,7 @@ class TFRecordOptions(object):
   compression_type_map = {
       TFRecordCompressionType.ZLIB: "ZLIB",
       TFRecordCompressionType.GZIP: "GZIP",
+      TFRecordCompressionType.BLOCK_ZLIB: "BLOCK_ZLIB",
       TFRecordCompressionType.NONE: ""
   }
 
@@ -69,7 +71,9 @@ class TFRecordOptions(object):
     Leaving an option as `None` allows C++ to set a reasonable default.
 
     Args:
-      compression_type: `"GZIP"`, `"ZLIB"`, or `""` (no compression).
+      compression_type: `"GZIP"`, `"ZLIB"`, `"BLOCK_ZLIB"`, or `""` (no
+        compression). `"BLOCK_ZLIB"` compresses independent blocks, which are
+        decompressed in parallel when the file is read.
       flush_mode: flush mode or `None`, Default: Z_NO_FLUSH.
       input_buffer_size: int or `None`.
       output_buffer_size: int or `None`.
@@ -358,6 +358,15 @@ class TFRecordWriterZlibTest(TFCompressionTestCase):
     actual = list(tf_record.tf_record_iterator(gzfn, options=options))
     self.assertEqual(actual, original)
 
+  def testBlockZlibReadWriteLarge(self):
+    """Verify that records spanning many blocks are read back."""
+    original = [b"foo", _TEXT * 10240, b"bar", _TEXT * 2048]
+    options = tf_record.TFRecordOptions(TFRecordCompressionType.BLOCK_ZLIB)
+    fn = self._WriteRecordsToFile(original, "block_zlib_read_write.tfrecord",
+                                  options)
+    actual = list(tf_record.tf_record_iterator(fn, options=options))
+    self.assertEqual(actual, original)
+
 
 class TFRecordIteratorTest(TFCompressionTestCase):
   """TFRecordIterator test"""
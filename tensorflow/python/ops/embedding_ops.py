@@ -19,7 +19,9 @@ from __future__ import print_function
 
 from six.moves import xrange  # pylint: disable=redefined-builtin
 
+from tensorflow.python.eager import context
 from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import device as pydev
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
@@ -29,6 +31,9 @@ from tensorflow.python.ops import clip_ops
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_math_ops
+# Imports gradient definitions.
+from tensorflow.python.ops import math_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import sparse_ops
@@ -481,6 +486,18 @@ def embedding_lookup_sparse(params,
     if segment_ids.dtype != dtypes.int32:
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
 
+    if (not ignore_weights and len(params) == 1 and max_norm is None and
+        params[0].dtype.base_dtype in (dtypes.float32, dtypes.float64) and
+        _placed_on_cpu(params[0])):
+      # Gathers the weighted rows of params straight into their segments,
+      # without materializing them.
+      weights = sp_weights.values
+      if weights.dtype != params[0].dtype.base_dtype:
+        weights = math_ops.cast(weights, params[0].dtype.base_dtype)
+      return gen_math_ops.sparse_segment_weighted_reduction(
+          params[0], sp_ids.values, weights, segment_ids, combiner=combiner,
+          name=name)
+
     ids = sp_ids.values
     ids, idx = array_ops.unique(ids)
 
@@ -544,6 +561,15 @@ def embedding_lookup_sparse(params,
     return embeddings
 
 
+def _placed_on_cpu(params):
+  """Returns whether `params` and the current device scope are on a CPU."""
+  for device_name in (params.device, context.context().device_name):
+    if (device_name and pydev.DeviceSpec.from_string(device_name).device_type
+        not in (None, "CPU")):
+      return False
+  return True
+
+
 @tf_export("nn.embedding_lookup_sparse", v1=[])
 def embedding_lookup_sparse_v2(params,
                                sp_ids,
@@ -3857,6 +3857,45 @@ class JpegTest(test_util.TensorFlowTestCase):
             lambda e: "Invalid JPEG data or crop window" in str(e)):
           self.evaluate(result)
 
+  def testDecodeAndResizeJpeg(self):
+    with self.cached_session():
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+
+      # The image is 256x128, so that these sizes are decoded at ratio 1 and 4
+      # without a resize.
+      for size, ratio in ([256, 128], 1), ([64, 32], 4):
+        image1 = image_ops.decode_jpeg(jpeg0, ratio=ratio)
+        image2 = gen_image_ops.decode_and_resize_jpeg(jpeg0, size)
+        self.assertAllEqual([size[0], size[1], None],
+                            image2.get_shape().as_list())
+        image1, image2 = self.evaluate([image1, image2])
+        self.assertAllEqual(image1, image2)
+
+      # Decoded at ratio 2, then resized.
+      size = [100, 50]
+      image1 = gen_image_ops.resize_bilinear(
+          array_ops.expand_dims(image_ops.decode_jpeg(jpeg0, ratio=2), 0),
+          size,
+          half_pixel_centers=True)
+      image2 = gen_image_ops.decode_and_resize_jpeg(jpeg0, size, channels=3)
+      self.assertAllEqual([100, 50, 3], image2.get_shape().as_list())
+      image1, image2 = self.evaluate([image1[0], image2])
+      # The float resize is truncated by averageError.
+      self.assertLess(self.averageError(image1, image2), 1.0)
+
+  @test_util.run_deprecated_v1
+  def testDecodeAndResizeJpegWithInvalidSize(self):
+    with self.cached_session():
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+      for size in [0, 10], [10, -1]:
+        result = gen_image_ops.decode_and_resize_jpeg(jpeg0, size)
+        with self.assertRaisesWithPredicateMatch(
+            errors.InvalidArgumentError,
+            lambda e: "size must be positive" in str(e)):
+          self.evaluate(result)
+
   def testSynthetic(self):
     with self.cached_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
@@ -390,6 +390,55 @@ def _SparseSegmentSqrtNWithNumSegmentsGrad(op, grad):
                                               dim0), None, None, None)
 
 
+@ops.RegisterGradient("SparseSegmentWeightedReduction")
+def _SparseSegmentWeightedReductionGrad(op, grad):
+  """Gradient for SparseSegmentWeightedReduction.
+
+  The gradient of the data is returned as the IndexedSlices of the rows
+  selected by the indices, like the gradient of Gather, so that embedding
+  tables are updated sparsely.
+  """
+  data, indices, weights, segment_ids = op.inputs
+  combiner = op.get_attr("combiner")
+  # The gradient of the segment of each index.
+  grad_rows = array_ops.gather(grad, segment_ids)
+  if combiner == b"mean":
+    norms = math_ops.segment_sum(weights, segment_ids)
+  elif combiner == b"sqrtn":
+    norms = math_ops.sqrt(
+        math_ops.segment_sum(math_ops.square(weights), segment_ids))
+  else:
+    norms = None
+  if norms is not None:
+    norms = array_ops.gather(norms, segment_ids)
+  scales = weights if norms is None else weights / norms
+  # Broadcasts the scales over the rows.
+  rows_shape = array_ops.concat(
+      [array_ops.shape(scales),
+       array_ops.ones([array_ops.rank(grad) - 1], dtype=dtypes.int32)], 0)
+  data_grad = ops.IndexedSlices(
+      grad_rows * array_ops.reshape(scales, rows_shape), indices,
+      array_ops.shape(data))
+
+  skip_input_indices = getattr(op, "skip_input_indices", None)
+  if skip_input_indices is not None and 2 in skip_input_indices:
+    return data_grad, None, None, None
+  # The weights also change the norm of their segment: for segment s,
+  # d output[s] / d weights[i] is (data[indices[i]] - output[s]) / norm for
+  # the mean, and (data[indices[i]] - output[s] * weights[i] / norm) / norm
+  # for the sqrtn.
+  row_axes = math_ops.range(1, array_ops.rank(grad))
+  weights_grad = math_ops.reduce_sum(
+      grad_rows * array_ops.gather(data, indices), row_axes)
+  if norms is not None:
+    output_dots = math_ops.reduce_sum(
+        grad_rows * array_ops.gather(op.outputs[0], segment_ids), row_axes)
+    if combiner == b"sqrtn":
+      output_dots *= weights / norms
+    weights_grad = (weights_grad - output_dots) / norms
+  return data_grad, None, weights_grad, None
+
+
 def _SegmentMinOrMaxGrad(op, grad):
   """ Gradient for SegmentMin and SegmentMax. """
   zeros = array_ops.zeros_like(op.inputs[0], dtype=op.inputs[0].dtype)
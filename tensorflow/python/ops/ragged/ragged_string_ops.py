@@ -512,6 +512,60 @@ def string_split_v2(input, sep=None, maxsplit=-1, name=None):  # pylint: disable
           ragged_tensor.RaggedTensor.from_tensor(input), sep, maxsplit)
 
 
+@tf_export("strings.split_to_hash_bucket_fast")
+def string_split_to_hash_bucket_fast(input,  # pylint: disable=redefined-builtin
+                                     num_buckets,
+                                     sep=None,
+                                     maxsplit=-1,
+                                     name=None):
+  """Splits the elements of `input` and hashes the tokens into buckets.
+
+  Equivalent to `tf.strings.to_hash_bucket_fast` applied to the tokens of
+  `tf.strings.split(input, sep, maxsplit)`, but the tokens are hashed where
+  they are in the input, without creating a string tensor for them.
+
+  Example:
+
+  >>> buckets = tf.strings.split_to_hash_bucket_fast(['a b', 'c'], 3)
+  >>> buckets.row_lengths().numpy()
+  array([2, 1])
+
+  Args:
+    input: A string `Tensor` of rank `N`, the strings to split.  If
+      `rank(input)` is not known statically, then it is assumed to be `1`.
+    num_buckets: An `int` that is `>= 1`. The number of buckets.
+    sep: `0-D` string `Tensor`, the delimiter string.
+    maxsplit: An `int`. If `maxsplit > 0`, limit of the split of the result.
+    name: A name for the operation (optional).
+
+  Returns:
+    An int64 `RaggedTensor` of rank `N+1`, the buckets of the tokens.
+  """
+  with ops.name_scope(name, "StringSplitToHashBucketFast", [input]):
+    input = ragged_tensor.convert_to_tensor_or_ragged_tensor(
+        input, dtype=dtypes.string, name="input")
+    if isinstance(input, ragged_tensor.RaggedTensor):
+      return input.with_flat_values(
+          string_split_to_hash_bucket_fast(input.flat_values, num_buckets, sep,
+                                           maxsplit))
+
+    rank = input.shape.ndims
+    if rank == 0:
+      return string_split_to_hash_bucket_fast(
+          array_ops.stack([input]), num_buckets, sep, maxsplit)[0]
+    elif rank == 1 or rank is None:
+      if sep is None:
+        sep = ""
+      row_splits, values = gen_string_ops.string_split_to_hash_bucket_fast(
+          input, sep=sep, num_buckets=num_buckets, maxsplit=maxsplit)
+      return ragged_tensor.RaggedTensor.from_row_splits(
+          values, row_splits, validate=False)
+    else:
+      return string_split_to_hash_bucket_fast(
+          ragged_tensor.RaggedTensor.from_tensor(input), num_buckets, sep,
+          maxsplit)
+
+
 @tf_export(v1=["string_split"])
 @deprecation.deprecated_args(None,
                              "delimiter is deprecated, please use sep instead.",
@@ -54,6 +54,7 @@ limitations under the License.
 %rename("%s") TFE_ContextSetServerDef;
 %rename("%s") TFE_ContextUpdateServerDef;
 %rename("%s") TFE_NewExecutor;
+%rename("%s") TFE_NewPerDeviceExecutor;
 %rename("%s") TFE_DeleteExecutor;
 %rename("%s") TFE_ExecutorIsAsync;
 %rename("%s") TFE_ExecutorWaitForAllPendingNodes;
@@ -297,6 +297,64 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertShapeEqual(out, apply_adam)
       self.assertAllCloseAccordingToType(new_var, out)
 
+  @test_util.run_v1_only("b/120545219")
+  def testSparseApplyAdam(self):
+    for (dtype, index_type, use_locking) in itertools.product(
+        [np.float32, np.float64], [np.int32, np.int64], [False, True]):
+      var = np.array([np.arange(10), np.arange(10, 20),
+                      np.arange(20, 30)]).astype(dtype)
+      m = np.array([np.arange(1, 11), np.arange(11, 21),
+                    np.arange(21, 31)]).astype(dtype)
+      v = np.array([np.arange(31, 41), np.arange(41, 51),
+                    np.arange(51, 61)]).astype(dtype)
+      grad = np.array([np.arange(10), np.arange(10, 20),
+                       np.arange(20, 30)]).astype(dtype)
+      # Row 0 is updated twice, in order, and row 1 is left untouched.
+      indices = np.array([0, 2, 0]).astype(index_type)
+      self._testTypesForSparseAdam(var, m, v, grad, indices, use_locking)
+
+  def _testTypesForSparseAdam(self, var, m, v, grad, indices, use_locking):
+    self.setUp()
+    with self.session(use_gpu=False):
+      var_t = variables.VariableV1(var)
+      m_t = variables.VariableV1(m)
+      v_t = variables.VariableV1(v)
+
+      t = 1
+      beta1 = np.array(0.9, dtype=var.dtype)
+      beta2 = np.array(0.999, dtype=var.dtype)
+      lr = np.array(0.001, dtype=var.dtype)
+      epsilon = np.array(1e-8, dtype=var.dtype)
+      self.evaluate(variables.global_variables_initializer())
+
+      sparse_apply_adam = training_ops.sparse_apply_adam(
+          var_t,
+          m_t,
+          v_t,
+          beta1**t,
+          beta2**t,
+          lr,
+          beta1,
+          beta2,
+          epsilon,
+          grad,
+          constant_op.constant(indices, self._toType(indices.dtype)),
+          use_locking=use_locking)
+      out = self.evaluate(sparse_apply_adam)
+      self.assertShapeEqual(out, sparse_apply_adam)
+
+      new_var, new_m, new_v = var.copy(), m.copy(), v.copy()
+      for (i, index) in enumerate(indices):
+        new_var[index], new_m[index], new_v[index] = self._adamUpdateNumpy(
+            new_var[index], grad[i], t, new_m[index], new_v[index], lr, beta1,
+            beta2, epsilon)
+      self.assertAllCloseAccordingToType(new_var, self.evaluate(var_t))
+      self.assertAllCloseAccordingToType(new_m, self.evaluate(m_t))
+      self.assertAllCloseAccordingToType(new_v, self.evaluate(v_t))
+      # The moments of the untouched rows are not decayed.
+      self.assertAllEqual(m[1], self.evaluate(m_t)[1])
+      self.assertAllEqual(v[1], self.evaluate(v_t)[1])
+
   def _adamUpdateNumpy(self, param, g_t, t, m, v, alpha, beta1, beta2, epsilon):
     alpha_t = alpha * np.sqrt(1 - beta2**t) / (1 - beta1**t)
 